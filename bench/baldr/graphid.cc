@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "baldr/graphreader.h"
+#include "test.h"
+
+#include <robin_hood.h>
+
+using namespace valhalla;
+
+namespace {
+
+// The edge ids of the utrecht tiles in a random order, the ids of a tile only differ in their
+// highest bits which is what a hash of a GraphId has to cope with
+const std::vector<baldr::GraphId>& utrecht_edge_ids() {
+  static const std::vector<baldr::GraphId> ids = [] {
+    auto config =
+        test::make_config("test/data/utrecht_tiles", {},
+                          {{"additional_data", "mjolnir.traffic_extract", "mjolnir.tile_extract"}});
+    baldr::GraphReader reader(config.get_child("mjolnir"));
+    std::vector<baldr::GraphId> ids;
+    for (const auto& tile_id : reader.GetTileSet()) {
+      auto tile = reader.GetGraphTile(tile_id);
+      if (!tile) {
+        continue;
+      }
+      for (uint32_t i = 0; i < tile->header()->directededgecount(); ++i) {
+        ids.push_back(tile_id + i);
+      }
+    }
+    std::shuffle(ids.begin(), ids.end(), std::mt19937(42));
+    return ids;
+  }();
+  return ids;
+}
+
+// Inserts the first range(0) ids twice, like a search marking the edges it came across, then
+// looks all of the ids up so that half of the lookups miss
+template <typename set_t> void BM_GraphIdSet(benchmark::State& state) {
+  const auto& ids = utrecht_edge_ids();
+  if (ids.empty()) {
+    state.SkipWithError("No tiles found");
+    return;
+  }
+  const size_t count = std::min<size_t>(state.range(0), ids.size() / 2);
+  for (auto _ : state) {
+    set_t set;
+    for (int pass = 0; pass < 2; ++pass) {
+      for (size_t i = 0; i < count; ++i) {
+        set.insert(ids[i]);
+      }
+    }
+    size_t found = 0;
+    for (size_t i = 0; i < 2 * count; ++i) {
+      found += set.count(ids[i]);
+    }
+    benchmark::DoNotOptimize(found);
+  }
+  state.SetItemsProcessed(state.iterations() * count * 4);
+}
+
+using std_set_t = std::unordered_set<baldr::GraphId>;
+using flat_set_t = robin_hood::unordered_flat_set<baldr::GraphId, baldr::GraphIdHasher>;
+
+BENCHMARK_TEMPLATE(BM_GraphIdSet, std_set_t)->RangeMultiplier(8)->Range(64, 1 << 15);
+BENCHMARK_TEMPLATE(BM_GraphIdSet, flat_set_t)->RangeMultiplier(8)->Range(64, 1 << 15);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,44 @@
+#include <benchmark/benchmark.h>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "baldr/graphreader.h"
+#include "test.h"
+
+using namespace valhalla;
+
+namespace {
+
+// Every thread has its own reader but they all share the same global cache. After the first pass
+// every request is a cache hit so this measures how well concurrent hits scale for a given cache
+void BM_GetGraphTileThreaded(benchmark::State& state, size_t shards) {
+  auto config =
+      test::make_config("test/data/utrecht_tiles", {},
+                        {{"additional_data", "mjolnir.traffic_extract", "mjolnir.tile_extract"}});
+  config.put("mjolnir.global_synchronized_cache", true);
+  config.put("mjolnir.global_cache_shards", shards);
+  baldr::GraphReader reader(config.get_child("mjolnir"));
+
+  const auto tile_set = reader.GetTileSet();
+  const std::vector<baldr::GraphId> tiles(tile_set.begin(), tile_set.end());
+  if (tiles.empty()) {
+    state.SkipWithError("No tiles found");
+    return;
+  }
+
+  // dont let all the threads start on the same tile
+  size_t i = std::hash<std::thread::id>{}(std::this_thread::get_id());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(reader.GetGraphTile(tiles[i++ % tiles.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_GetGraphTileThreaded, single_lock, 0)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_CAPTURE(BM_GetGraphTileThreaded, sharded, 64)->ThreadRange(1, 32)->UseRealTime();
+
+} // namespace
+
+BENCHMARK_MAIN();
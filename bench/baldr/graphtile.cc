@@ -0,0 +1,229 @@
+#include <benchmark/benchmark.h>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "baldr/graphreader.h"
+#include "microtar.h"
+#include "test.h"
+
+using namespace valhalla;
+
+namespace {
+
+const std::string kTileDir = "test/data/utrecht_tiles";
+
+// Where the tiles are read from, the traffic variant also maps in live speeds for some edges
+enum class Source { kFlatFiles, kExtract, kTraffic };
+
+// Writes the utrecht tiles into a tar, named by their paths so the extract finds them without an
+// index, which is what the memory mapped reader opens
+std::string build_extract() {
+  const std::string tar_file = kTileDir + "/benchmark_tiles.tar";
+  auto config = test::make_config(kTileDir, {},
+                                  {{"additional_data", "mjolnir.traffic_extract",
+                                    "mjolnir.tile_extract"}});
+  baldr::GraphReader reader(config.get_child("mjolnir"));
+
+  mtar_t tar;
+  if (mtar_open(&tar, tar_file.c_str(), "w") != MTAR_ESUCCESS) {
+    return {};
+  }
+  for (const auto& tile_id : reader.GetTileSet()) {
+    const auto suffix = baldr::GraphTile::FileSuffix(tile_id);
+    std::ifstream file(kTileDir + "/" + suffix, std::ios::binary);
+    const std::string bytes{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    mtar_write_file_header(&tar, suffix.c_str(), bytes.size());
+    mtar_write_data(&tar, bytes.data(), bytes.size());
+  }
+  mtar_finalize(&tar);
+  mtar_close(&tar);
+  return tar_file;
+}
+
+std::shared_ptr<baldr::GraphReader> make_reader(Source source) {
+  auto config = test::make_config(kTileDir, {},
+                                  {{"additional_data", "mjolnir.traffic_extract",
+                                    "mjolnir.tile_extract"}});
+  if (source == Source::kExtract) {
+    static const std::string tar_file = build_extract();
+    config.put("mjolnir.tile_extract", tar_file);
+  } else if (source == Source::kTraffic) {
+    config.put("mjolnir.traffic_extract", kTileDir + "/benchmark_traffic.tar");
+    static bool built = false;
+    if (!built) {
+      test::build_live_traffic_data(config);
+      // a fifth of the edges get a live speed so the accessor takes both of its branches
+      std::mt19937 gen(0);
+      std::uniform_real_distribution<> dist(0., 1.);
+      test::customize_live_traffic_data(config, [&](baldr::GraphReader&, baldr::TrafficTile&, int,
+                                                    baldr::TrafficSpeed* current) {
+        if (dist(gen) < 0.2) {
+          current->breakpoint1 = 255;
+          current->overall_encoded_speed = dist(gen) * 100;
+        }
+      });
+      built = true;
+    }
+  }
+  return test::make_clean_graphreader(config.get_child("mjolnir"));
+}
+
+// Loads every tile up front so the benchmarks only measure the accessors
+std::vector<baldr::graph_tile_ptr> load_tiles(baldr::GraphReader& reader) {
+  std::vector<baldr::graph_tile_ptr> tiles;
+  for (const auto& tile_id : reader.GetTileSet()) {
+    if (auto tile = reader.GetGraphTile(tile_id)) {
+      tiles.push_back(tile);
+    }
+  }
+  return tiles;
+}
+
+void BM_NodeAccess(benchmark::State& state, Source source) {
+  auto reader = make_reader(source);
+  const auto tiles = load_tiles(*reader);
+  if (tiles.empty()) {
+    state.SkipWithError("No tiles found");
+    return;
+  }
+
+  size_t nodes = 0;
+  for (auto _ : state) {
+    for (const auto& tile : tiles) {
+      const size_t count = tile->header()->nodecount();
+      for (size_t i = 0; i < count; ++i) {
+        benchmark::DoNotOptimize(tile->node(i)->edge_count());
+      }
+      nodes += count;
+    }
+  }
+  state.SetItemsProcessed(nodes);
+}
+
+void BM_DirectedEdgeAccess(benchmark::State& state, Source source) {
+  auto reader = make_reader(source);
+  const auto tiles = load_tiles(*reader);
+  if (tiles.empty()) {
+    state.SkipWithError("No tiles found");
+    return;
+  }
+
+  size_t edges = 0;
+  for (auto _ : state) {
+    for (const auto& tile : tiles) {
+      const size_t count = tile->header()->directededgecount();
+      for (size_t i = 0; i < count; ++i) {
+        benchmark::DoNotOptimize(tile->directededge(i)->length());
+      }
+      edges += count;
+    }
+  }
+  state.SetItemsProcessed(edges);
+}
+
+void BM_EdgeInfoAccess(benchmark::State& state, Source source) {
+  auto reader = make_reader(source);
+  const auto tiles = load_tiles(*reader);
+  if (tiles.empty()) {
+    state.SkipWithError("No tiles found");
+    return;
+  }
+
+  size_t edges = 0;
+  for (auto _ : state) {
+    for (const auto& tile : tiles) {
+      const size_t count = tile->header()->directededgecount();
+      for (size_t i = 0; i < count; ++i) {
+        benchmark::DoNotOptimize(tile->edgeinfo(tile->directededge(i)).wayid());
+      }
+      edges += count;
+    }
+  }
+  state.SetItemsProcessed(edges);
+}
+
+// Speeds with every source of traffic allowed, which only differs from the flat files when there
+// is live traffic to look at
+void BM_GetSpeed(benchmark::State& state, Source source) {
+  auto reader = make_reader(source);
+  const auto tiles = load_tiles(*reader);
+  if (tiles.empty()) {
+    state.SkipWithError("No tiles found");
+    return;
+  }
+
+  size_t edges = 0;
+  for (auto _ : state) {
+    for (const auto& tile : tiles) {
+      const size_t count = tile->header()->directededgecount();
+      for (size_t i = 0; i < count; ++i) {
+        benchmark::DoNotOptimize(tile->GetSpeed(tile->directededge(i), baldr::kDefaultFlowMask));
+      }
+      edges += count;
+    }
+  }
+  state.SetItemsProcessed(edges);
+}
+
+void BM_GetBin(benchmark::State& state, Source source) {
+  auto reader = make_reader(source);
+  const auto tiles = load_tiles(*reader);
+  if (tiles.empty()) {
+    state.SkipWithError("No tiles found");
+    return;
+  }
+
+  size_t bins = 0;
+  for (auto _ : state) {
+    for (const auto& tile : tiles) {
+      for (size_t i = 0; i < baldr::kBinCount; ++i) {
+        for (const auto& edge_id : tile->GetBin(i)) {
+          benchmark::DoNotOptimize(edge_id);
+        }
+      }
+      bins += baldr::kBinCount;
+    }
+  }
+  state.SetItemsProcessed(bins);
+}
+
+// After the first pass every lookup is a hit in the cache of the reader
+void BM_GetGraphTileHit(benchmark::State& state, Source source) {
+  auto reader = make_reader(source);
+  const auto tile_set = reader->GetTileSet();
+  const std::vector<baldr::GraphId> tile_ids(tile_set.begin(), tile_set.end());
+  if (tile_ids.empty()) {
+    state.SkipWithError("No tiles found");
+    return;
+  }
+  for (const auto& tile_id : tile_ids) {
+    reader->GetGraphTile(tile_id);
+  }
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(reader->GetGraphTile(tile_ids[i++ % tile_ids.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_NodeAccess, flat_files, Source::kFlatFiles);
+BENCHMARK_CAPTURE(BM_NodeAccess, extract, Source::kExtract);
+BENCHMARK_CAPTURE(BM_DirectedEdgeAccess, flat_files, Source::kFlatFiles);
+BENCHMARK_CAPTURE(BM_DirectedEdgeAccess, extract, Source::kExtract);
+BENCHMARK_CAPTURE(BM_EdgeInfoAccess, flat_files, Source::kFlatFiles);
+BENCHMARK_CAPTURE(BM_EdgeInfoAccess, extract, Source::kExtract);
+BENCHMARK_CAPTURE(BM_GetSpeed, flat_files, Source::kFlatFiles);
+BENCHMARK_CAPTURE(BM_GetSpeed, extract, Source::kExtract);
+BENCHMARK_CAPTURE(BM_GetSpeed, live_traffic, Source::kTraffic);
+BENCHMARK_CAPTURE(BM_GetBin, flat_files, Source::kFlatFiles);
+BENCHMARK_CAPTURE(BM_GetBin, extract, Source::kExtract);
+BENCHMARK_CAPTURE(BM_GetGraphTileHit, flat_files, Source::kFlatFiles);
+BENCHMARK_CAPTURE(BM_GetGraphTileHit, extract, Source::kExtract);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -1,10 +1,12 @@
 #include <iostream>
+#include <random>
 #include <sstream>
 
 #include <benchmark/benchmark.h>
 #include <boost/property_tree/ptree.hpp>
 
 #include "baldr/rapidjson_utils.h"
+#include "midgard/distanceapproximator.h"
 #include "meili/map_matcher_factory.h"
 #include "meili/measurement.h"
 #include "sif/costconstants.h"
@@ -117,6 +119,132 @@ static void BM_ManyCases(benchmark::State& state) {
 
 BENCHMARK(BM_ManyCases)->DenseRange(0, kBenchmarkCases.size() - 1);
 
+// The shape of a fixture
+std::vector<PointLL> LoadShape(const std::string& filename) {
+  rapidjson::Document doc;
+  doc.Parse(LoadFile(filename).c_str());
+  std::vector<PointLL> shape;
+  for (const auto& point : doc["shape"].GetArray()) {
+    shape.emplace_back(point["lon"].GetDouble(), point["lat"].GetDouble());
+  }
+  return shape;
+}
+
+/**
+ * Drives along a shape and takes a measurement at every interval.
+ * @param shape     the shape to drive along
+ * @param speed     how fast in meters per second
+ * @param interval  the seconds between the measurements
+ * @param noise     the standard deviation in meters of the gps noise added to the measurements
+ * @param laps      how many times to drive the shape, it should be a loop if more than once
+ */
+std::vector<Measurement> BuildTrace(const std::vector<PointLL>& shape,
+                                    double speed,
+                                    double interval,
+                                    double noise,
+                                    size_t laps) {
+  // always the same noise so the runs are comparable
+  std::mt19937 generator(42);
+  std::normal_distribution<double> distribution(0, noise > 0 ? noise : 1);
+  auto measure = [&](const PointLL& point, double time) {
+    if (noise <= 0) {
+      return Measurement(point, kGpsAccuracyMeters, kSearchRadiusMeters, time);
+    }
+    const auto meters_per_lng = DistanceApproximator<PointLL>::MetersPerLngDegree(point.lat());
+    const PointLL noisy(point.lng() + distribution(generator) / meters_per_lng,
+                        point.lat() + distribution(generator) / kMetersPerDegreeLat);
+    return Measurement(noisy, kGpsAccuracyMeters, kSearchRadiusMeters, time);
+  };
+
+  const double step = speed * interval;
+  std::vector<Measurement> meas;
+  double time = 0, along = 0;
+  for (size_t lap = 0; lap < laps; ++lap) {
+    for (size_t i = 0; i + 1 < shape.size(); ++i) {
+      const auto length = shape[i].Distance(shape[i + 1]);
+      for (; along < length; along += step, time += interval) {
+        meas.push_back(measure(shape[i].PointAlongSegment(shape[i + 1], along / length), time));
+      }
+      along -= length;
+    }
+  }
+  meas.push_back(measure(shape.back(), time));
+  return meas;
+}
+
+std::unique_ptr<MapMatcher> CreateMatcher(MapMatcherFactory& factory) {
+  valhalla::Options options;
+  const rapidjson::Document doc;
+  valhalla::sif::ParseCostingOptions(doc, "/costing_options", options);
+  options.set_costing(valhalla::Costing::auto_);
+  return std::unique_ptr<MapMatcher>(factory.Create(options));
+}
+
+// Matches the trace over and over and reports how long each phase took per match
+void MatchTrace(benchmark::State& state, MapMatcher& matcher, const std::vector<Measurement>& meas) {
+  matcher.ResetTimings();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(matcher.OfflineMatch(meas));
+  }
+  const auto timings = matcher.timings();
+  state.counters["measurements"] = meas.size();
+  state.counters["candidate_search"] =
+      benchmark::Counter(timings.candidate_search, benchmark::Counter::kAvgIterations);
+  state.counters["routing"] = benchmark::Counter(timings.routing, benchmark::Counter::kAvgIterations);
+  state.counters["viterbi"] = benchmark::Counter(timings.viterbi, benchmark::Counter::kAvgIterations);
+  state.counters["results"] = benchmark::Counter(timings.results, benchmark::Counter::kAvgIterations);
+}
+
+// Matches the loop in Utrecht as a 10 Hz trace at 50 km/h with the adaptive interpolation distance
+// of the argument, 0 is off
+static void BM_DenseTrace(benchmark::State& state) {
+  logging::Configure({{"type", ""}});
+  boost::property_tree::ptree config;
+  rapidjson::read_json(VALHALLA_SOURCE_DIR "bench/meili/config.json", config);
+  config.put<float>("meili.default.adaptive_interpolation_distance", state.range(0));
+  MapMatcherFactory factory(config);
+  auto matcher = CreateMatcher(factory);
+  const auto meas = BuildTrace(LoadShape(kBenchmarkCases[3]), 50 / 3.6, .1, 0, 1);
+  MatchTrace(state, *matcher, meas);
+}
+
+BENCHMARK(BM_DenseTrace)->Arg(0)->Arg(50)->Arg(100);
+
+// Matches a trace driven along a fixture. The arguments are the fixture, the speed in km/h, the
+// interval between the measurements in tenths of a second, the gps noise in meters and the number
+// of laps. The tiles of the benchmarks only cover Utrecht so the rural and highway traces are the
+// same streets driven at the speeds of those roads.
+static void BM_Trace(benchmark::State& state) {
+  logging::Configure({{"type", ""}});
+  boost::property_tree::ptree config;
+  rapidjson::read_json(VALHALLA_SOURCE_DIR "bench/meili/config.json", config);
+  MapMatcherFactory factory(config);
+  auto matcher = CreateMatcher(factory);
+  const auto meas = BuildTrace(LoadShape(kBenchmarkCases[state.range(0)]), state.range(1) / 3.6,
+                               state.range(2) / 10., state.range(3), state.range(4));
+  MatchTrace(state, *matcher, meas);
+}
+
+void TraceArguments(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"fixture", "kmh", "interval_ds", "noise_m", "laps"});
+  // the loop at urban, rural and highway speeds, sampled every 1, 10 and 30 seconds
+  for (const int64_t kmh : {30, 80, 120}) {
+    for (const int64_t interval : {10, 100, 300}) {
+      for (const int64_t noise : {0, 15}) {
+        benchmark->Args({3, kmh, interval, noise, 1});
+      }
+    }
+  }
+  // the intersections, where most match errors happen
+  for (const int64_t fixture : {0, 1, 2}) {
+    benchmark->Args({fixture, 30, 10, 5, 1});
+  }
+  // a long trace, an hour of driving around the loop
+  benchmark->Args({3, 50, 10, 5, 20});
+}
+
+BENCHMARK(BM_Trace)->Apply(TraceArguments)->Unit(benchmark::kMillisecond);
+
 } // namespace
 
 BENCHMARK_MAIN();
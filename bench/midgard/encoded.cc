@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+#include "baldr/graphreader.h"
+#include "midgard/aabb2.h"
+#include "midgard/encoded.h"
+#include "midgard/logging.h"
+#include "midgard/pointll.h"
+#include "test.h"
+
+using namespace valhalla;
+using namespace valhalla::midgard;
+
+namespace {
+
+// The shapes of every edge in the utrecht tiles, varint encoded as they are in the tiles
+const std::vector<std::string>& encoded7_shapes() {
+  static const std::vector<std::string> shapes = []() {
+    logging::Configure({{"type", ""}});
+    auto config = test::make_config("test/data/utrecht_tiles");
+    baldr::GraphReader reader(config.get_child("mjolnir"));
+    std::vector<std::string> shapes;
+    for (const auto& tile_id : reader.GetTileSet()) {
+      auto tile = reader.GetGraphTile(tile_id);
+      for (uint32_t i = 0; tile && i < tile->header()->directededgecount(); ++i) {
+        shapes.push_back(tile->edgeinfo(tile->directededge(i)).encoded_shape());
+      }
+    }
+    return shapes;
+  }();
+  return shapes;
+}
+
+// The same shapes decoded and polyline encoded as they are in responses
+const std::vector<std::vector<PointLL>>& decoded_shapes() {
+  static const std::vector<std::vector<PointLL>> shapes = []() {
+    std::vector<std::vector<PointLL>> shapes;
+    for (const auto& shape : encoded7_shapes()) {
+      shapes.push_back(decode7<std::vector<PointLL>>(shape));
+    }
+    return shapes;
+  }();
+  return shapes;
+}
+
+const std::vector<std::string>& encoded5_shapes() {
+  static const std::vector<std::string> shapes = []() {
+    std::vector<std::string> shapes;
+    for (const auto& shape : decoded_shapes()) {
+      shapes.push_back(encode(shape));
+    }
+    return shapes;
+  }();
+  return shapes;
+}
+
+// Runs the function on every shape and counts the bytes of encoded shape it went through
+template <class shapes_t, class function_t>
+void run(benchmark::State& state, const shapes_t& shapes, const function_t& function) {
+  if (shapes.empty()) {
+    state.SkipWithError("No shapes found");
+    return;
+  }
+  size_t bytes = 0;
+  for (auto _ : state) {
+    for (const auto& shape : shapes) {
+      bytes += function(shape);
+    }
+  }
+  state.SetBytesProcessed(bytes);
+  state.SetItemsProcessed(state.iterations() * shapes.size());
+}
+
+void BM_Decode7(benchmark::State& state) {
+  run(state, encoded7_shapes(), [](const std::string& shape) {
+    auto points = decode7<std::vector<PointLL>>(shape);
+    benchmark::DoNotOptimize(points.data());
+    return shape.size();
+  });
+}
+
+void BM_Decode7Into(benchmark::State& state) {
+  std::vector<PointLL> points;
+  run(state, encoded7_shapes(), [&points](const std::string& shape) {
+    decode7_into(shape.data(), shape.size(), points);
+    benchmark::DoNotOptimize(points.data());
+    return shape.size();
+  });
+}
+
+void BM_Decode7BoundingBox(benchmark::State& state) {
+  run(state, encoded7_shapes(), [](const std::string& shape) {
+    auto box = decode7_bbox<AABB2<PointLL>>(shape.data(), shape.size());
+    benchmark::DoNotOptimize(box);
+    return shape.size();
+  });
+}
+
+void BM_Decode7Endpoints(benchmark::State& state) {
+  run(state, encoded7_shapes(), [](const std::string& shape) {
+    auto endpoints = decode7_endpoints<PointLL>(shape.data(), shape.size());
+    benchmark::DoNotOptimize(endpoints);
+    return shape.size();
+  });
+}
+
+void BM_Decode(benchmark::State& state) {
+  run(state, encoded5_shapes(), [](const std::string& shape) {
+    auto points = decode<std::vector<PointLL>>(shape);
+    benchmark::DoNotOptimize(points.data());
+    return shape.size();
+  });
+}
+
+void BM_Encode7(benchmark::State& state) {
+  run(state, decoded_shapes(), [](const std::vector<PointLL>& shape) {
+    auto encoded = encode7(shape);
+    benchmark::DoNotOptimize(encoded.data());
+    return encoded.size();
+  });
+}
+
+void BM_Encode(benchmark::State& state) {
+  run(state, decoded_shapes(), [](const std::vector<PointLL>& shape) {
+    auto encoded = encode(shape);
+    benchmark::DoNotOptimize(encoded.data());
+    return encoded.size();
+  });
+}
+
+// The shapes joined ten at a time like the legs of a route, by splicing their encodings
+void BM_SpliceEncoded(benchmark::State& state) {
+  const auto& shapes = encoded5_shapes();
+  std::vector<const std::string*> legs;
+  size_t bytes = 0;
+  for (auto _ : state) {
+    for (size_t i = 0; i < shapes.size(); i += 10) {
+      legs.clear();
+      for (size_t j = i; j < std::min(i + 10, shapes.size()); ++j) {
+        legs.push_back(&shapes[j]);
+        bytes += shapes[j].size();
+      }
+      auto spliced = splice_encoded(legs);
+      benchmark::DoNotOptimize(spliced.data());
+    }
+  }
+  state.SetBytesProcessed(bytes);
+}
+
+// The same but decoding the shapes, joining their points and encoding those
+void BM_DecodeJoinEncode(benchmark::State& state) {
+  const auto& shapes = encoded5_shapes();
+  size_t bytes = 0;
+  for (auto _ : state) {
+    for (size_t i = 0; i < shapes.size(); i += 10) {
+      std::vector<PointLL> joined;
+      for (size_t j = i; j < std::min(i + 10, shapes.size()); ++j) {
+        auto points = decode<std::vector<PointLL>>(shapes[j]);
+        joined.insert(joined.end(), joined.empty() ? points.begin() : points.begin() + 1,
+                      points.end());
+        bytes += shapes[j].size();
+      }
+      auto encoded = encode(joined);
+      benchmark::DoNotOptimize(encoded.data());
+    }
+  }
+  state.SetBytesProcessed(bytes);
+}
+
+BENCHMARK(BM_Decode7);
+BENCHMARK(BM_Decode7Into);
+BENCHMARK(BM_Decode7BoundingBox);
+BENCHMARK(BM_Decode7Endpoints);
+BENCHMARK(BM_Decode);
+BENCHMARK(BM_Encode7);
+BENCHMARK(BM_Encode);
+BENCHMARK(BM_SpliceEncoded);
+BENCHMARK(BM_DecodeJoinEncode);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,78 @@
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <list>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "midgard/constants.h"
+#include "midgard/pointll.h"
+#include "midgard/polyline2.h"
+
+using namespace valhalla::midgard;
+
+namespace {
+
+// A wiggly shape heading east like a long route, about 10m between its points
+std::vector<PointLL> make_shape(const size_t count) {
+  std::mt19937 gen(0);
+  std::normal_distribution<double> step(0, 0.0001);
+  std::vector<PointLL> shape{{5.1, 52.1}};
+  while (shape.size() < count) {
+    shape.emplace_back(shape.back().lng() + 0.0001 + step(gen), shape.back().lat() + step(gen));
+  }
+  return shape;
+}
+
+// A closed ring around a point like the contour of an isochrone
+std::vector<PointLL> make_ring(const size_t count) {
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<double> radius(0.009, 0.011);
+  std::vector<PointLL> ring;
+  for (size_t i = 0; i < count; ++i) {
+    const double angle = 2 * kPiD * i / count;
+    const double r = radius(gen);
+    ring.emplace_back(5.1 + r * std::cos(angle), 52.1 + r * std::sin(angle));
+  }
+  ring.push_back(ring.front());
+  return ring;
+}
+
+// The shape is copied outside of the timing since the generalization works in place
+template <class container_t>
+void run(benchmark::State& state,
+         const std::vector<PointLL>& shape,
+         const float epsilon,
+         const bool avoid_self_intersection) {
+  size_t points = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    container_t copy(shape.cbegin(), shape.cend());
+    state.ResumeTiming();
+    Polyline2<PointLL>::Generalize(copy, epsilon, {}, avoid_self_intersection);
+    points = copy.size();
+    benchmark::DoNotOptimize(copy);
+  }
+  state.counters["points"] = points;
+  state.SetItemsProcessed(state.iterations() * shape.size());
+}
+
+void BM_GeneralizeVector(benchmark::State& state) {
+  run<std::vector<PointLL>>(state, make_shape(state.range(0)), 10.f, false);
+}
+
+void BM_GeneralizeList(benchmark::State& state) {
+  run<std::list<PointLL>>(state, make_shape(state.range(0)), 10.f, false);
+}
+
+void BM_GeneralizeRingAvoidSelfIntersection(benchmark::State& state) {
+  run<std::vector<PointLL>>(state, make_ring(state.range(0)), 50.f, true);
+}
+
+BENCHMARK(BM_GeneralizeVector)->RangeMultiplier(10)->Range(1000, 100000);
+BENCHMARK(BM_GeneralizeList)->RangeMultiplier(10)->Range(1000, 100000);
+BENCHMARK(BM_GeneralizeRingAvoidSelfIntersection)->RangeMultiplier(10)->Range(1000, 100000);
+
+} // namespace
+
+BENCHMARK_MAIN();
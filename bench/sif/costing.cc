@@ -0,0 +1,187 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "baldr/graphreader.h"
+#include "sif/costfactory.h"
+#include "test.h"
+#include <valhalla/proto/options.pb.h>
+
+using namespace valhalla;
+
+namespace {
+
+const std::vector<Costing> kCostings = {Costing::auto_,       Costing::truck,
+                                        Costing::bicycle,     Costing::pedestrian,
+                                        Costing::motorcycle,  Costing::motor_scooter,
+                                        Costing::transit};
+
+// How the edges are costed, without a time, at a time of the week or at a time with live traffic
+enum Variant { kStatic = 0, kTimeDependent = 1, kLiveTraffic = 2 };
+
+// Tuesday morning rush hour, as seconds of the week and as an epoch time for the restrictions
+constexpr uint32_t kSecondOfWeek = 2 * midgard::kSecondsPerDay + 8 * midgard::kSecondsPerHour;
+constexpr uint64_t kEpochTime = 1617696000;
+
+// An edge leaving a node along with the edge a search would have come into that node on
+struct transition_t {
+  const baldr::DirectedEdge* edge;
+  baldr::GraphId edge_id;
+  const baldr::NodeInfo* node;
+  baldr::graph_tile_ptr tile;
+  sif::EdgeLabel pred;
+};
+
+std::shared_ptr<baldr::GraphReader> make_reader(bool live_traffic) {
+  auto config =
+      test::make_config("test/data/utrecht_tiles", {},
+                        {{"additional_data", "mjolnir.traffic_extract", "mjolnir.tile_extract"}});
+  if (live_traffic) {
+    config.put("mjolnir.traffic_extract", "test/data/utrecht_tiles/costing-traffic.tar");
+    test::build_live_traffic_data(config);
+    // a fifth of the edges get a live speed so the costings see both kinds of edges
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<> dist(0., 1.);
+    test::customize_live_traffic_data(config, [&](baldr::GraphReader&, baldr::TrafficTile&, int,
+                                                  baldr::TrafficSpeed* current) {
+      if (dist(gen) < 0.2) {
+        current->breakpoint1 = 255;
+        current->overall_encoded_speed = dist(gen) * 100;
+      }
+    });
+  }
+  return test::make_clean_graphreader(config.get_child("mjolnir"));
+}
+
+// Every edge of the tiles paired with an edge into its start node, the tiles stay alive in the
+// reader that made them
+std::vector<transition_t> make_transitions(baldr::GraphReader& reader) {
+  std::vector<transition_t> transitions;
+  for (const auto& tile_id : reader.GetTileSet()) {
+    auto tile = reader.GetGraphTile(tile_id);
+    if (!tile) {
+      continue;
+    }
+    for (uint32_t n = 0; n < tile->header()->nodecount(); ++n) {
+      const auto* node = tile->node(n);
+      if (node->edge_count() == 0) {
+        continue;
+      }
+      // the opposing edge of the first edge out of the node comes into it
+      const auto first_id = tile_id + node->edge_index();
+      const baldr::DirectedEdge* pred_edge = nullptr;
+      auto pred_tile = tile;
+      const auto pred_id = reader.GetOpposingEdgeId(first_id, pred_edge, pred_tile);
+      if (!pred_id.Is_Valid()) {
+        continue;
+      }
+      const sif::EdgeLabel pred(baldr::kInvalidLabel, pred_id, pred_edge, {}, 0, 0,
+                                sif::TravelMode::kDrive, 0, {}, baldr::kInvalidRestriction, false,
+                                false, sif::InternalTurn::kNoTurn);
+      for (uint32_t i = 0; i < node->edge_count(); ++i) {
+        const auto edge_id = first_id + i;
+        transitions.push_back({tile->directededge(edge_id), edge_id, node, tile, pred});
+      }
+    }
+  }
+  return transitions;
+}
+
+// The readers and their edges are made once and shared by every benchmark
+const std::vector<transition_t>& utrecht_transitions(bool live_traffic) {
+  static auto reader = make_reader(false);
+  static const auto transitions = make_transitions(*reader);
+  static auto traffic_reader = make_reader(true);
+  static const auto traffic_transitions = make_transitions(*traffic_reader);
+  return live_traffic ? traffic_transitions : transitions;
+}
+
+sif::cost_ptr_t make_costing(Costing costing) {
+  Options options;
+  options.set_costing(costing);
+  rapidjson::Document doc;
+  sif::ParseCostingOptions(doc, "/costing_options", options);
+  return sif::CostFactory().Create(options);
+}
+
+void set_label(benchmark::State& state, Variant variant) {
+  static const char* kVariants[] = {"static", "time_dependent", "live_traffic"};
+  state.SetLabel(Costing_Enum_Name(kCostings[state.range(0)]) + "/" + kVariants[variant]);
+}
+
+void BM_Allowed(benchmark::State& state) {
+  const auto costing = make_costing(kCostings[state.range(0)]);
+  const auto variant = static_cast<Variant>(state.range(1));
+  const auto& transitions = utrecht_transitions(variant == kLiveTraffic);
+  if (transitions.empty()) {
+    state.SkipWithError("No tiles found");
+    return;
+  }
+
+  const uint64_t time = variant == kStatic ? 0 : kEpochTime;
+  for (auto _ : state) {
+    for (const auto& t : transitions) {
+      uint8_t restriction_idx = baldr::kInvalidRestriction;
+      benchmark::DoNotOptimize(costing->Allowed(t.edge, false, t.pred, t.tile, t.edge_id, time,
+                                                t.node->timezone(), restriction_idx));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * transitions.size());
+  set_label(state, variant);
+}
+
+void BM_EdgeCost(benchmark::State& state) {
+  const auto costing = make_costing(kCostings[state.range(0)]);
+  const auto variant = static_cast<Variant>(state.range(1));
+  const auto& transitions = utrecht_transitions(variant == kLiveTraffic);
+  if (transitions.empty()) {
+    state.SkipWithError("No tiles found");
+    return;
+  }
+
+  const uint32_t seconds = variant == kStatic ? baldr::kInvalidSecondsOfWeek : kSecondOfWeek;
+  for (auto _ : state) {
+    for (const auto& t : transitions) {
+      uint8_t flow_sources;
+      benchmark::DoNotOptimize(costing->EdgeCost(t.edge, t.tile, seconds, flow_sources));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * transitions.size());
+  set_label(state, variant);
+}
+
+// Turns dont depend on the time or the traffic so there is only the static variant
+void BM_TransitionCost(benchmark::State& state) {
+  const auto costing = make_costing(kCostings[state.range(0)]);
+  const auto& transitions = utrecht_transitions(false);
+  if (transitions.empty()) {
+    state.SkipWithError("No tiles found");
+    return;
+  }
+
+  for (auto _ : state) {
+    for (const auto& t : transitions) {
+      benchmark::DoNotOptimize(costing->TransitionCost(t.edge, t.node, t.pred));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * transitions.size());
+  set_label(state, kStatic);
+}
+
+// the first argument is the index of the costing and the second the variant
+void costings_and_variants(benchmark::internal::Benchmark* benchmark) {
+  for (int costing = 0; costing < static_cast<int>(kCostings.size()); ++costing) {
+    for (int variant : {kStatic, kTimeDependent, kLiveTraffic}) {
+      benchmark->Args({costing, variant});
+    }
+  }
+}
+
+BENCHMARK(BM_Allowed)->Apply(costings_and_variants)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_EdgeCost)->Apply(costings_and_variants)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TransitionCost)->DenseRange(0, kCostings.size() - 1)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,57 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+#include "baldr/double_bucket_queue.h"
+
+using namespace valhalla;
+
+namespace {
+
+struct simple_label {
+  float c;
+  float sortcost() const {
+    return c;
+  }
+};
+
+// Simulates a long search where the costs quickly outgrow the initial range of the low-level
+// buckets. Every pop is followed by a few adds a little more expensive than the popped label
+void BM_DoubleBucketQueuePops(benchmark::State& state) {
+  const float range = 20000.f;
+  const uint32_t overflow_count = state.range(0);
+  const size_t pops = 1000000;
+
+  std::vector<simple_label> labels;
+  labels.reserve(pops * 3);
+  baldr::DoubleBucketQueue<simple_label> queue;
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> increment(1.f, 600000.f);
+
+  for (auto _ : state) {
+    labels.clear();
+    queue.clear();
+    queue.reuse(0.f, range, 1, &labels, overflow_count);
+    labels.push_back({0.f});
+    queue.add(0);
+    for (size_t i = 0; i < pops; ++i) {
+      const auto label = queue.pop();
+      if (label == baldr::kInvalidLabel) {
+        break;
+      }
+      const float cost = labels[label].c;
+      for (int j = 0; j < (i % 3 == 0 ? 3 : 1); ++j) {
+        labels.push_back({cost + increment(gen)});
+        queue.add(labels.size() - 1);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * pops);
+}
+
+// 0 is the single overflow bucket, anything larger splits the overflow into that many buckets
+BENCHMARK(BM_DoubleBucketQueuePops)->Arg(0)->Arg(4)->Arg(16)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
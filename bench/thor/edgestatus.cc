@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+#include "baldr/graphreader.h"
+#include "test.h"
+#include "thor/edgestatus.h"
+
+using namespace valhalla;
+
+namespace {
+
+// The edges of the utrecht tiles in a random order, which is closer to how a search comes across
+// them than walking each tile from start to end
+struct edges_t {
+  std::vector<baldr::graph_tile_ptr> tiles;
+  std::vector<std::pair<baldr::GraphId, size_t>> edges;
+};
+
+const edges_t& utrecht_edges() {
+  static const edges_t edges = [] {
+    auto config =
+        test::make_config("test/data/utrecht_tiles", {},
+                          {{"additional_data", "mjolnir.traffic_extract", "mjolnir.tile_extract"}});
+    baldr::GraphReader reader(config.get_child("mjolnir"));
+    edges_t edges;
+    for (const auto& tile_id : reader.GetTileSet()) {
+      auto tile = reader.GetGraphTile(tile_id);
+      if (!tile) {
+        continue;
+      }
+      for (uint32_t i = 0; i < tile->header()->directededgecount(); ++i) {
+        edges.edges.emplace_back(tile_id + i, edges.tiles.size());
+      }
+      edges.tiles.push_back(tile);
+    }
+    std::shuffle(edges.edges.begin(), edges.edges.end(), std::mt19937(42));
+    return edges;
+  }();
+  return edges;
+}
+
+// A search from start to end, every edge is set temporary, looked up, then made permanent. The
+// statuses are cleared between searches like the algorithms do so their arrays are reused
+void BM_EdgeStatusSearch(benchmark::State& state) {
+  const auto& utrecht = utrecht_edges();
+  if (utrecht.edges.empty()) {
+    state.SkipWithError("No tiles found");
+    return;
+  }
+
+  thor::EdgeStatus status;
+  for (auto _ : state) {
+    status.clear();
+    uint32_t index = 0;
+    for (const auto& edge : utrecht.edges) {
+      status.Set(edge.first, thor::EdgeSet::kTemporary, index++, utrecht.tiles[edge.second]);
+    }
+    for (const auto& edge : utrecht.edges) {
+      benchmark::DoNotOptimize(status.Get(edge.first));
+      status.Update(edge.first, thor::EdgeSet::kPermanent);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * utrecht.edges.size());
+}
+
+// Lookups alone, half of them for edges which were never set
+void BM_EdgeStatusGet(benchmark::State& state) {
+  const auto& utrecht = utrecht_edges();
+  if (utrecht.edges.empty()) {
+    state.SkipWithError("No tiles found");
+    return;
+  }
+
+  thor::EdgeStatus status;
+  for (size_t i = 0; i < utrecht.edges.size(); i += 2) {
+    const auto& edge = utrecht.edges[i];
+    status.Set(edge.first, thor::EdgeSet::kTemporary, i, utrecht.tiles[edge.second]);
+  }
+  for (auto _ : state) {
+    for (const auto& edge : utrecht.edges) {
+      benchmark::DoNotOptimize(status.Get(edge.first));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * utrecht.edges.size());
+}
+
+// The pointer the expansions take to walk the edges leaving a node, so one lookup per node
+void BM_EdgeStatusGetPtr(benchmark::State& state) {
+  const auto& utrecht = utrecht_edges();
+  if (utrecht.tiles.empty()) {
+    state.SkipWithError("No tiles found");
+    return;
+  }
+
+  thor::EdgeStatus status;
+  size_t edges = 0;
+  for (auto _ : state) {
+    status.clear();
+    for (const auto& tile : utrecht.tiles) {
+      const auto tile_id = tile->id();
+      for (uint32_t n = 0; n < tile->header()->nodecount(); ++n) {
+        const auto* node = tile->node(n);
+        if (node->edge_count() == 0) {
+          continue;
+        }
+        auto* es = status.GetPtr(tile_id + node->edge_index(), tile);
+        for (uint32_t i = 0; i < node->edge_count(); ++i, ++es) {
+          benchmark::DoNotOptimize(es->set());
+        }
+        edges += node->edge_count();
+      }
+    }
+  }
+  state.SetItemsProcessed(edges);
+}
+
+BENCHMARK(BM_EdgeStatusSearch)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_EdgeStatusGet)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_EdgeStatusGetPtr)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
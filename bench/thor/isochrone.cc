@@ -53,6 +53,39 @@ BENCHMARK(BM_IsochroneUtrecht)
     ->Range(1, kMaxDurationMinutes)
     ->Repetitions(10);
 
+// Test tracing the contours of large isochrones on threads
+void BM_IsochroneThreadsUtrecht(benchmark::State& state) {
+  const int threads = state.range(0);
+
+  const auto config =
+      test::make_config("test/data/utrecht_tiles",
+                        {{"thor.isochrone_threads", std::to_string(threads)}},
+                        {{"additional_data", "mjolnir.traffic_extract", "mjolnir.tile_extract"}});
+  valhalla::loki::loki_worker_t loki_worker(config);
+  valhalla::thor::thor_worker_t thor_worker(config);
+
+  // several contours of a long drive with a fine grid
+  const auto request_json =
+      R"({"locations":[{"lat":52.078937,"lon":5.115321}],"costing":"auto","contours":[)"
+      R"({"time":30},{"time":60},{"time":90},{"time":120}],"polygons":true,"denoise":0,)"
+      R"("generalize":20})";
+
+  valhalla::Api request;
+  valhalla::ParseApi(request_json, Options::isochrone, request);
+  loki_worker.isochrones(request);
+
+  for (auto _ : state) {
+    auto response_json = thor_worker.isochrones(request);
+  }
+}
+
+BENCHMARK(BM_IsochroneThreadsUtrecht)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Repetitions(10);
+
 } // namespace
 
 BENCHMARK_MAIN();
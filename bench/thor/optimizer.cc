@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "thor/optimizer.h"
+
+using namespace valhalla;
+
+namespace {
+
+// Travel times between random points in a 10km square, a bit slower one way than the other like
+// one ways and turn costs make them in a real matrix
+std::vector<float> RandomCosts(const uint32_t count) {
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> coordinate(0.f, 10000.f);
+  std::uniform_real_distribution<float> detour(1.f, 1.3f);
+  std::vector<float> x(count), y(count), costs(count * count, 0.f);
+  for (uint32_t i = 0; i < count; ++i) {
+    x[i] = coordinate(gen);
+    y[i] = coordinate(gen);
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    for (uint32_t j = 0; j < count; ++j) {
+      if (i != j) {
+        costs[i * count + j] = std::hypot(x[i] - x[j], y[i] - y[j]) / 10.f * detour(gen);
+      }
+    }
+  }
+  return costs;
+}
+
+float TourCost(const std::vector<float>& costs, const std::vector<uint32_t>& tour) {
+  float cost = 0.f;
+  for (size_t i = 1; i < tour.size(); ++i) {
+    cost += costs[tour[i - 1] * tour.size() + tour[i]];
+  }
+  return cost;
+}
+
+void BM_Annealing(benchmark::State& state) {
+  const uint32_t count = state.range(0);
+  const auto costs = RandomCosts(count);
+  float cost = 0.f;
+  for (auto _ : state) {
+    thor::Optimizer optimizer;
+    optimizer.Seed(111111);
+    auto tour = optimizer.Solve(count, costs);
+    cost = TourCost(costs, tour);
+    benchmark::DoNotOptimize(tour);
+  }
+  state.counters["cost"] = cost;
+}
+
+void BM_LocalSearch(benchmark::State& state) {
+  const uint32_t count = state.range(0);
+  const uint32_t restarts = state.range(1);
+  const auto costs = RandomCosts(count);
+  float cost = 0.f;
+  for (auto _ : state) {
+    thor::Optimizer optimizer;
+    auto tour = optimizer.SolveLocalSearch(count, costs, restarts);
+    cost = TourCost(costs, tour);
+    benchmark::DoNotOptimize(tour);
+  }
+  state.counters["cost"] = cost;
+}
+
+BENCHMARK(BM_Annealing)->Unit(benchmark::kMillisecond)->Arg(10)->Arg(25)->Arg(50);
+BENCHMARK(BM_LocalSearch)
+    ->Unit(benchmark::kMillisecond)
+    ->Args({10, 1})
+    ->Args({25, 1})
+    ->Args({25, 8})
+    ->Args({50, 1})
+    ->Args({50, 8});
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -180,6 +180,70 @@ static void BM_UtrechtBidirectionalAstar(benchmark::State& state) {
   state.counters["Routes"] = route_size;
 }
 
+// The same costing as auto but of another type, so the searches relax its edges through virtual
+// calls as they do for the costings which dont declare themselves in a header
+class VirtualAutoCost : public sif::AutoCost {
+public:
+  using sif::AutoCost::AutoCost;
+};
+
+// Exposes how many edges a search labelled
+class CountingBidirectionalAStar : public thor::BidirectionalAStar {
+public:
+  size_t labels() const {
+    return edgelabels_forward_.size() + edgelabels_reverse_.size();
+  }
+};
+
+/** Labels per second of bidirectional a* with the costing called virtually (0) or through the
+ * kernel of its type (1) */
+static void BM_UtrechtCostKernel(benchmark::State& state) {
+  const auto config = build_config("cost-kernel.tar");
+  test::build_live_traffic_data(config);
+  auto clean_reader = test::make_clean_graphreader(config.get_child("mjolnir"));
+
+  Options options;
+  create_costing_options(options);
+  sif::TravelMode mode;
+  auto costs = sif::CostFactory().CreateModeCosting(options, mode);
+  if (state.range(0) == 0) {
+    costs[static_cast<size_t>(mode)] =
+        std::make_shared<VirtualAutoCost>(options.costing_options(static_cast<int>(Costing::auto_)));
+  }
+  auto cost = costs[static_cast<size_t>(mode)];
+
+  std::vector<valhalla::baldr::Location> locations{
+      midgard::PointLL{5.115873, 52.099247}, midgard::PointLL{5.112481, 52.074073},
+      midgard::PointLL{5.135983, 52.110116}, midgard::PointLL{5.095273, 52.108956},
+      midgard::PointLL{5.110077, 52.062043}, midgard::PointLL{5.025595, 52.067372},
+  };
+  const auto projections = loki::Search(locations, *clean_reader, cost);
+  std::vector<valhalla::Location> pbf_locations;
+  for (const auto& location : locations) {
+    auto found = projections.find(location);
+    if (found == projections.cend()) {
+      throw std::runtime_error("Found no matching locations");
+    }
+    pbf_locations.emplace_back();
+    baldr::PathLocation::toPBF(found->second, &pbf_locations.back(), *clean_reader);
+  }
+
+  size_t labels = 0;
+  CountingBidirectionalAStar astar;
+  for (auto _ : state) {
+    for (size_t i = 0; i + 1 < pbf_locations.size(); ++i) {
+      auto origin = pbf_locations[i];
+      auto destination = pbf_locations[i + 1];
+      auto result = astar.GetBestPath(origin, destination, *clean_reader, costs, mode);
+      labels += astar.labels();
+      astar.Clear();
+    }
+  }
+  state.counters["Labels"] = benchmark::Counter(labels, benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_UtrechtCostKernel)->Unit(benchmark::kMillisecond)->Arg(0)->Arg(1);
+
 void customize_traffic(const boost::property_tree::ptree& config,
                        baldr::GraphId& target_edge_id,
                        const int target_speed) {
@@ -0,0 +1,104 @@
+#include <benchmark/benchmark.h>
+#include <sstream>
+#include <string>
+
+#include "baldr/json.h"
+#include "midgard/logging.h"
+#include "test.h"
+#include "tyr/actor.h"
+#include "tyr/serializers.h"
+
+using namespace valhalla;
+
+namespace {
+
+// A route across Utrecht with lots of maneuvers and intersections
+const std::string kRouteRequest =
+    R"({"locations":[{"lat":52.062043,"lon":5.110077},{"lat":52.110116,"lon":5.135983},
+        {"lat":52.067372,"lon":5.025595}],"costing":"auto","format":"%%","steps":true,
+        "banner_instructions":true,"voice_instructions":true})";
+
+// Routes once and then only measures turning the finished route into a response
+void BM_SerializeDirections(benchmark::State& state, const std::string& format) {
+  logging::Configure({{"type", ""}});
+  auto config = test::make_config("test/data/utrecht_tiles");
+  tyr::actor_t actor(config, true);
+  auto request = kRouteRequest;
+  request.replace(request.find("%%"), 2, format);
+  Api api;
+  actor.route(request, nullptr, &api);
+
+  size_t bytes = 0;
+  for (auto _ : state) {
+    auto response = tyr::serializeDirections(api);
+    bytes += response.size();
+    benchmark::DoNotOptimize(response);
+  }
+  state.SetBytesProcessed(bytes);
+}
+
+BENCHMARK_CAPTURE(BM_SerializeDirections, osrm, std::string("osrm"));
+BENCHMARK_CAPTURE(BM_SerializeDirections, valhalla, std::string("json"));
+
+// Something shaped like the steps of a long osrm route
+baldr::json::MapPtr make_steps(size_t count) {
+  using namespace baldr;
+  auto steps = json::array({});
+  for (size_t i = 0; i < count; ++i) {
+    auto intersections = json::array({});
+    for (size_t j = 0; j < 4; ++j) {
+      intersections->emplace_back(
+          json::map({{"location", json::array({json::fixed_t{5.110077 + i * 1e-5, 6},
+                                               json::fixed_t{52.062043 - j * 1e-5, 6}})},
+                     {"bearings", json::array({uint64_t(90), uint64_t(180), uint64_t(270)})},
+                     {"entry", json::array({true, false, true})},
+                     {"in", uint64_t(0)},
+                     {"out", uint64_t(2)}}));
+    }
+    steps->emplace_back(
+        json::map({{"intersections", intersections},
+                   {"maneuver", json::map({{"type", std::string("turn")},
+                                           {"modifier", std::string("left")},
+                                           {"bearing_before", uint64_t(12)},
+                                           {"bearing_after", uint64_t(282)}})},
+                   {"name", std::string("Croeselaan")},
+                   {"duration", json::fixed_t{12.345 + i, 3}},
+                   {"distance", json::fixed_t{123.4 + i, 3}},
+                   {"weight", json::float_t{12.5 + i}},
+                   {"geometry", std::string("gfo}Eto~cPeF}LwDqJ")}}));
+  }
+  return json::map({{"steps", steps}});
+}
+
+void BM_JsonStream(benchmark::State& state) {
+  auto json = make_steps(state.range(0));
+  for (auto _ : state) {
+    std::stringstream ss;
+    ss << *json;
+    benchmark::DoNotOptimize(ss.str());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_JsonSerialize(benchmark::State& state) {
+  auto json = make_steps(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(baldr::json::serialize(*json));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_JsonBuild(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(make_steps(state.range(0)));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_JsonStream)->Range(16, 4096);
+BENCHMARK(BM_JsonSerialize)->Range(16, 4096);
+BENCHMARK(BM_JsonBuild)->Range(16, 4096);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -186,23 +186,39 @@ Options:
     if(conversion_type MATCHES HEADER)
       bin2h(SOURCE_FILE ${source} HEADER_FILE ${target} ${options})
     elseif(conversion_type MATCHES LOCALES)
-      file(WRITE ${target} "#include <unordered_map>\n")
+      file(WRITE ${target} "#include <cstddef>\n#include <utility>\n\n")
       file(GLOB json_files LIST_DIRECTORIES FALSE "${source}/*.json")
       foreach(file ${json_files})
         get_filename_component(name "${file}" NAME)
         bin2h(SOURCE_FILE ${file} HEADER_FILE ${target} VARIABLE_NAME ${name} APPEND RAW)
       endforeach()
 
-      set(map "\nconst std::unordered_map<std::string, std::string> locales_json = {\n")
+      # the json stays where the compiler put it, in read only memory shared by every process
+      # using the library, until somebody asks for that language
+      set(map "struct locale_json_t {\n  const char* name;\n  const unsigned char* json;\n")
+      set(map "${map}  size_t size;\n};\n\nconst locale_json_t locales_json[] = {\n")
+      set(aliases "\n// so that languages can be looked up without parsing any json\n")
+      set(aliases "${aliases}const std::pair<const char*, const char*> locales_aliases[] = {\n")
       foreach(file ${json_files})
         get_filename_component(name "${file}" NAME)
         get_filename_component(locale "${file}" NAME_WE)
         string(MAKE_C_IDENTIFIER "${name}" name)
         string(TOLOWER "${name}" name)
-        set(map "${map}    {\"${locale}\", {${name}, ${name} + ${name}_len}},\n")
+        set(map "${map}    {\"${locale}\", ${name}, ${name}_len},\n")
+
+        file(READ ${file} json)
+        string(REGEX MATCH "\"aliases\"[ \t\r\n]*:[ \t\r\n]*\\[[^]]*\\]" alias_array "${json}")
+        string(REGEX MATCHALL "\"[^\"]+\"" alias_names "${alias_array}")
+        if(alias_names)
+          list(REMOVE_AT alias_names 0)
+        endif()
+        foreach(alias ${alias_names})
+          set(aliases "${aliases}    {${alias}, \"${locale}\"},\n")
+        endforeach()
       endforeach()
       set(map "${map}};\n")
-      file(APPEND ${target} "${map}")
+      set(aliases "${aliases}};\n")
+      file(APPEND ${target} "${map}${aliases}")
     endif()
   endif()
 endif()
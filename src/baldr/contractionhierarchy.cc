@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "baldr/contractionhierarchy.h"
+
+namespace {
+
+// bump the version whenever the layout of the file changes
+constexpr char kMagic[8] = {'V', 'A', 'L', 'H', 'A', 'L', 'C', 'H'};
+constexpr uint32_t kVersion = 1;
+
+struct header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t node_count;
+  uint64_t arc_count;
+  uint64_t up_count;
+  uint64_t down_count;
+};
+
+template <typename T> void write(std::ofstream& file, const std::vector<T>& values) {
+  file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T> void read(std::ifstream& file, std::vector<T>& values, const size_t count) {
+  values.resize(count);
+  file.read(reinterpret_cast<char*>(values.data()), count * sizeof(T));
+}
+
+// turns an arc per entry into a compressed list of arc indices per node
+template <typename node_of_t>
+void index(const size_t node_count,
+           const std::vector<uint32_t>& arcs,
+           const node_of_t& node_of,
+           std::vector<uint32_t>& offsets,
+           std::vector<uint32_t>& sorted) {
+  offsets.assign(node_count + 1, 0);
+  for (auto arc : arcs) {
+    ++offsets[node_of(arc) + 1];
+  }
+  for (size_t i = 1; i < offsets.size(); ++i) {
+    offsets[i] += offsets[i - 1];
+  }
+  sorted.resize(arcs.size());
+  auto next = offsets;
+  for (auto arc : arcs) {
+    sorted[next[node_of(arc)]++] = arc;
+  }
+}
+
+} // namespace
+
+namespace valhalla {
+namespace baldr {
+
+ContractionHierarchy::ContractionHierarchy(std::vector<GraphId>&& nodes,
+                                           std::vector<arc_t>&& arcs,
+                                           const std::vector<uint32_t>& rank)
+    : nodes_(std::move(nodes)), arcs_(std::move(arcs)) {
+  // the forward search goes up from the arc start, the backward search goes up from the arc end
+  std::vector<uint32_t> up, down;
+  for (uint32_t i = 0; i < arcs_.size(); ++i) {
+    const auto& arc = arcs_[i];
+    (rank[arc.from] < rank[arc.to] ? up : down).push_back(i);
+  }
+  auto from = [this](uint32_t arc) { return arcs_[arc].from; };
+  auto to = [this](uint32_t arc) { return arcs_[arc].to; };
+  index(nodes_.size(), up, from, up_index_, up_arcs_);
+  index(nodes_.size(), down, to, down_index_, down_arcs_);
+}
+
+ContractionHierarchy::ContractionHierarchy(const std::string& file) {
+  std::ifstream in(file, std::ios::binary);
+  header_t header{};
+  in.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!in || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion) {
+    throw std::runtime_error("Not a valid contraction hierarchy: " + file);
+  }
+
+  read(in, nodes_, header.node_count);
+  read(in, arcs_, header.arc_count);
+  read(in, up_index_, header.node_count + 1);
+  read(in, up_arcs_, header.up_count);
+  read(in, down_index_, header.node_count + 1);
+  read(in, down_arcs_, header.down_count);
+  if (!in) {
+    throw std::runtime_error("Truncated contraction hierarchy: " + file);
+  }
+}
+
+void ContractionHierarchy::Save(const std::string& file) const {
+  header_t header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.node_count = nodes_.size();
+  header.arc_count = arcs_.size();
+  header.up_count = up_arcs_.size();
+  header.down_count = down_arcs_.size();
+
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  write(out, nodes_);
+  write(out, arcs_);
+  write(out, up_index_);
+  write(out, up_arcs_);
+  write(out, down_index_);
+  write(out, down_arcs_);
+  if (!out) {
+    throw std::runtime_error("Failed to write contraction hierarchy: " + file);
+  }
+}
+
+uint32_t ContractionHierarchy::node_index(const GraphId& node) const {
+  auto found = std::lower_bound(nodes_.cbegin(), nodes_.cend(), node,
+                                [](const GraphId& a, const GraphId& b) { return a.value < b.value; });
+  return found != nodes_.cend() && *found == node ? found - nodes_.cbegin() : kInvalidNode;
+}
+
+void ContractionHierarchy::Unpack(const uint32_t index, std::vector<GraphId>& edges) const {
+  // depth first, pushing the second half of a shortcut first so the first half comes out first
+  std::vector<uint32_t> pending{index};
+  while (!pending.empty()) {
+    const auto& arc = arcs_[pending.back()];
+    pending.pop_back();
+    if (arc.is_shortcut()) {
+      pending.push_back(arc.second);
+      pending.push_back(arc.first);
+    } else if (arc.edgeid != kInvalidGraphId) {
+      edges.emplace_back(arc.edgeid);
+    }
+  }
+}
+
+} // namespace baldr
+} // namespace valhalla
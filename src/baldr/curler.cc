@@ -5,6 +5,7 @@
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 
 #ifdef CURL_STATICLIB
 
@@ -37,6 +38,11 @@ static std::shared_ptr<CURL> init_curl() {
 
 char ALL_ENCODINGS[] = "";
 
+// How many connections a batch opens to one host when the server cant multiplex them over http/2
+constexpr long kMaxHostConnections = 8;
+// How long to wait for any of the transfers of a batch before checking the interrupt again
+constexpr int kPollMilliseconds = 50;
+
 size_t write_callback(char* in, size_t block_size, size_t blocks, std::vector<char>* out) {
   if (!out) {
     return static_cast<size_t>(0);
@@ -80,6 +86,11 @@ struct curler_t::pimpl_t {
                 "Failed to disable peer verification ");
     assert_curl(curl_easy_setopt(connection.get(), CURLOPT_SSL_VERIFYHOST, 0L),
                 "Failed to disable host verification ");
+    // keep the connection around between tiles and speak http/2 to servers that can
+    assert_curl(curl_easy_setopt(connection.get(), CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS),
+                "Failed to set the http version ");
+    assert_curl(curl_easy_setopt(connection.get(), CURLOPT_TCP_KEEPALIVE, 1L),
+                "Failed to turn on keep alive ");
   }
 
   // TODO: retries?
@@ -123,6 +134,117 @@ struct curler_t::pimpl_t {
     return result;
   }
 
+  std::vector<std::vector<char>> fetch(const std::vector<std::string>& urls,
+                                       std::vector<long>& http_codes,
+                                       bool gzipped,
+                                       const curler_t::interrupt_t* interrupt) {
+    // the multi handle owns the connections so they outlive the batch
+    if (!multi) {
+      multi.reset(curl_multi_init(), [](CURLM* m) { curl_multi_cleanup(m); });
+      if (multi.get() == nullptr) {
+        LOG_ERROR("Failed to created CURL multi handle");
+        throw std::runtime_error("Failed to created CURL multi handle");
+      }
+      assert_multi(curl_multi_setopt(multi.get(), CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX),
+                   "Failed to turn on multiplexing ");
+      assert_multi(curl_multi_setopt(multi.get(), CURLMOPT_MAX_HOST_CONNECTIONS,
+                                     kMaxHostConnections),
+                   "Failed to limit the host connections ");
+    }
+
+    // one transfer per url, we keep them around for the next batch
+    while (transfers.size() < urls.size()) {
+      transfers.emplace_back(init_curl());
+      auto* transfer = transfers.back().get();
+      if (transfer == nullptr) {
+        LOG_ERROR("Failed to created CURL connection");
+        throw std::runtime_error("Failed to created CURL connection");
+      }
+      assert_curl(curl_easy_setopt(transfer, CURLOPT_FOLLOWLOCATION, 1L),
+                  "Failed to set redirect option ");
+      assert_curl(curl_easy_setopt(transfer, CURLOPT_WRITEFUNCTION, write_callback),
+                  "Failed to set writer ");
+      assert_curl(curl_easy_setopt(transfer, CURLOPT_SSL_VERIFYPEER, 0L),
+                  "Failed to disable peer verification ");
+      assert_curl(curl_easy_setopt(transfer, CURLOPT_SSL_VERIFYHOST, 0L),
+                  "Failed to disable host verification ");
+      assert_curl(curl_easy_setopt(transfer, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS),
+                  "Failed to set the http version ");
+      // wait for a connection that can be multiplexed rather than opening another one
+      assert_curl(curl_easy_setopt(transfer, CURLOPT_PIPEWAIT, 1L), "Failed to set pipe wait ");
+      assert_curl(curl_easy_setopt(transfer, CURLOPT_ACCEPT_ENCODING, "gzip"),
+                  "Failed to set content encoding header ");
+      if (!user_agent.empty())
+        assert_curl(curl_easy_setopt(transfer, CURLOPT_USERAGENT, user_agent.c_str()),
+                    "Failed to set User-Agent ");
+    }
+
+    // take the transfers back out of the multi handle however we leave
+    struct added_t {
+      CURLM* multi;
+      std::vector<CURL*> transfers;
+      ~added_t() {
+        for (auto* transfer : transfers) {
+          curl_multi_remove_handle(multi, transfer);
+        }
+      }
+    } added{multi.get(), {}};
+
+    // queue them all up, curl decides how many go at once on which connection
+    std::vector<std::vector<char>> results(urls.size());
+    std::unordered_map<CURL*, size_t> indices;
+    for (size_t i = 0; i < urls.size(); ++i) {
+      auto* transfer = transfers[i].get();
+      assert_curl(curl_easy_setopt(transfer, CURLOPT_HTTP_CONTENT_DECODING, gzipped ? 0L : 1L),
+                  "Failed to set decoding ");
+      assert_curl(curl_easy_setopt(transfer, CURLOPT_URL, urls[i].c_str()), "Failed to set URL ");
+      assert_curl(curl_easy_setopt(transfer, CURLOPT_WRITEDATA, &results[i]),
+                  "Failed to set write data ");
+      assert_multi(curl_multi_add_handle(multi.get(), transfer), "Failed to add transfer ");
+      added.transfers.push_back(transfer);
+      indices.emplace(transfer, i);
+    }
+
+    // run them until they are all done
+    int running = 0;
+    do {
+      if (interrupt) {
+        (*interrupt)();
+      }
+      assert_multi(curl_multi_perform(multi.get(), &running), "Failed to get URLs ");
+      if (running) {
+        assert_multi(curl_multi_poll(multi.get(), nullptr, 0, kPollMilliseconds, nullptr),
+                     "Failed to wait for URLs ");
+      }
+    } while (running);
+
+    // grab the return codes, a failed transfer just doesnt get one
+    http_codes.assign(urls.size(), 0);
+    int remaining = 0;
+    while (CURLMsg* message = curl_multi_info_read(multi.get(), &remaining)) {
+      if (message->msg != CURLMSG_DONE) {
+        continue;
+      }
+      auto i = indices.at(message->easy_handle);
+      if (message->data.result == CURLE_OK) {
+        curl_easy_getinfo(message->easy_handle, CURLINFO_RESPONSE_CODE, &http_codes[i]);
+      } else {
+        LOG_WARN("Failed to get URL " + urls[i] + ": " + curl_easy_strerror(message->data.result));
+        results[i].clear();
+      }
+    }
+    // hand over the results
+    return results;
+  }
+
+  void assert_multi(CURLMcode code, const std::string& msg) const {
+    if (code != CURLM_OK) {
+      std::string what = msg + curl_multi_strerror(code);
+      LOG_ERROR(what);
+      throw std::runtime_error(what);
+    }
+  }
+
   void assert_curl(CURLcode code, const std::string& msg) const {
     if (code != CURLE_OK) {
       std::string what = msg + error;
@@ -134,6 +256,9 @@ struct curler_t::pimpl_t {
   std::shared_ptr<CURL> connection;
   char error[CURL_ERROR_SIZE]{};
   std::string user_agent;
+  // for fetching many urls at once
+  std::shared_ptr<CURLM> multi;
+  std::vector<std::shared_ptr<CURL>> transfers;
 };
 
 curler_t::curler_t(const std::string& user_agent) : pimpl(new pimpl_t(user_agent)) {
@@ -146,6 +271,13 @@ std::vector<char> curler_t::operator()(const std::string& url,
   return pimpl->fetch(url, http_code, gzipped, interrupt);
 }
 
+std::vector<std::vector<char>> curler_t::operator()(const std::vector<std::string>& urls,
+                                                    std::vector<long>& http_codes,
+                                                    bool gzipped,
+                                                    const curler_t::interrupt_t* interrupt) const {
+  return pimpl->fetch(urls, http_codes, gzipped, interrupt);
+}
+
 // curler_pool_t
 
 curler_pool_t::curler_pool_t(const size_t pool_size, const std::string& user_agent)
@@ -190,6 +322,11 @@ operator()(const std::string&, long&, bool gzipped, const curler_t::interrupt_t*
   LOG_ERROR("This version of libvalhalla was not built with CURL support");
   throw std::runtime_error("This version of libvalhalla was not built with CURL support");
 }
+std::vector<std::vector<char>> curler_t::
+operator()(const std::vector<std::string>&, std::vector<long>&, bool, const interrupt_t*) const {
+  LOG_ERROR("This version of libvalhalla was not built with CURL support");
+  throw std::runtime_error("This version of libvalhalla was not built with CURL support");
+}
 
 curler_pool_t::curler_pool_t(const size_t pool_size, const std::string&) : size_(pool_size) {
 }
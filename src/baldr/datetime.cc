@@ -2,6 +2,7 @@
 #include <bitset>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 
 #include <boost/algorithm/string.hpp>
@@ -41,6 +42,110 @@ from_cache(const TP& tp,
   infos.emplace_back(tp.get_info());
   return infos.back();
 }
+
+// how far to either side of the time it is made for a table of offsets reaches
+constexpr std::chrono::hours kOffsetWindow(24 * 366);
+
+// the offsets from utc of a timezone over a window of time, in the order they took effect
+struct tz_offsets_t {
+  date::sys_seconds begin;
+  date::sys_seconds end;
+  std::vector<std::pair<date::sys_seconds, int>> changes;
+
+  tz_offsets_t(const date::time_zone* tz, const date::sys_seconds& around) {
+    auto info = tz->get_info(around - kOffsetWindow);
+    begin = info.begin;
+    changes.emplace_back(info.begin, static_cast<int>(info.offset.count()));
+    while (info.end < around + kOffsetWindow) {
+      info = tz->get_info(info.end);
+      changes.emplace_back(info.begin, static_cast<int>(info.offset.count()));
+    }
+    end = info.end;
+  }
+
+  bool covers(const date::sys_seconds& tp) const {
+    return begin <= tp && tp < end;
+  }
+
+  int offset(const date::sys_seconds& tp) const {
+    // the last change that happened at or before the time
+    auto change = std::upper_bound(changes.begin() + 1, changes.end(), tp,
+                                   [](const date::sys_seconds& tp, const auto& change) {
+                                     return tp < change.first;
+                                   });
+    return std::prev(change)->second;
+  }
+};
+
+// the tables of all the timezones, indexed like the zones of the tz database
+struct tz_tables_t {
+  std::mutex lock;
+  std::vector<std::shared_ptr<const tz_offsets_t>> tables;
+};
+
+int lookup_offset(const date::time_zone* tz, const date::sys_seconds& tp) {
+  const auto& zones = date::get_tzdb().zones;
+  std::less<const date::time_zone*> before;
+  if (before(tz, zones.data()) || !before(tz, zones.data() + zones.size())) {
+    return static_cast<int>(tz->get_info(tp).offset.count());
+  }
+  const size_t index = tz - zones.data();
+
+  // each thread keeps its own references to the tables so that finding one takes no lock
+  thread_local std::vector<std::shared_ptr<const tz_offsets_t>> local(zones.size());
+  auto& table = local[index];
+  if (!table || !table->covers(tp)) {
+    static tz_tables_t shared;
+    std::lock_guard<std::mutex> lock(shared.lock);
+    if (shared.tables.empty()) {
+      shared.tables.resize(zones.size());
+    }
+    // another thread may have already moved the window of this timezone to where we need it
+    auto& shared_table = shared.tables[index];
+    if (!shared_table || !shared_table->covers(tp)) {
+      shared_table = std::make_shared<const tz_offsets_t>(tz, tp);
+    }
+    table = shared_table;
+  }
+  return table->offset(tp);
+}
+
+// reads a number of digits at a position in the string
+bool parse_digits(const std::string& str, size_t pos, size_t count, unsigned& value) {
+  value = 0;
+  for (size_t i = pos; i < pos + count; ++i) {
+    if (str[i] < '0' || str[i] > '9') {
+      return false;
+    }
+    value = value * 10 + (str[i] - '0');
+  }
+  return true;
+}
+
+// parses exactly 2016-11-06T01:00 or 2016-11-06 without a stream, which is most of the cost of
+// parsing the date time of a location, anything else goes the slow way
+bool parse_iso_date(const std::string& str, date::local_seconds& tp) {
+  const bool has_time = str.size() == 16 && str[10] == 'T' && str[13] == ':';
+  if ((str.size() != 10 && !has_time) || str[4] != '-' || str[7] != '-') {
+    return false;
+  }
+  unsigned year, month, day, hours = 0, minutes = 0;
+  if (!parse_digits(str, 0, 4, year) || !parse_digits(str, 5, 2, month) ||
+      !parse_digits(str, 8, 2, day)) {
+    return false;
+  }
+  if (has_time && (!parse_digits(str, 11, 2, hours) || !parse_digits(str, 14, 2, minutes) ||
+                   hours > 23 || minutes > 59)) {
+    return false;
+  }
+  const date::year_month_day ymd{date::year(static_cast<int>(year)), date::month(month),
+                                 date::day(day)};
+  if (!ymd.ok()) {
+    return false;
+  }
+  tp = date::local_days(ymd) + std::chrono::hours(hours) + std::chrono::minutes(minutes);
+  return true;
+}
 } // namespace
 
 using namespace valhalla::baldr;
@@ -78,8 +183,13 @@ const tz_db_t& get_tz_db() {
 
 // get a formatted date.  date in the format of 2016-11-06T01:00 or 2016-11-06
 date::local_seconds get_formatted_date(const std::string& date, bool can_throw) {
-  std::istringstream in{date};
   date::local_seconds tp;
+  if (parse_iso_date(date, tp)) {
+    return tp;
+  }
+
+  // anything but the exact formats is left to the date library to make sense of
+  std::istringstream in{date};
 
   if (date.find('T') != std::string::npos)
     in >> date::parse("%FT%R", tp);
@@ -134,6 +244,14 @@ uint64_t seconds_since_epoch(const std::string& date_time, const date::time_zone
   return static_cast<uint64_t>(utc.time_since_epoch().count());
 }
 
+// Get the offset from utc of a timezone at the time (seconds from epoch)
+int utc_offset(const uint64_t seconds, const date::time_zone* time_zone) {
+  if (!time_zone) {
+    return 0;
+  }
+  return lookup_offset(time_zone, date::sys_seconds(std::chrono::seconds(seconds)));
+}
+
 // Get the difference between two timezones using the current time (seconds from epoch
 // so that DST can be take into account). Returns the difference in seconds.
 int timezone_diff(const uint64_t seconds,
@@ -144,14 +262,13 @@ int timezone_diff(const uint64_t seconds,
   if (!origin_tz || !dest_tz || origin_tz == dest_tz) {
     return 0;
   }
-  std::chrono::seconds dur(seconds);
-  std::chrono::time_point<std::chrono::system_clock> tp(dur);
-
-  const auto origin = date::make_zoned(origin_tz, tp);
-  const auto dest = date::make_zoned(dest_tz, tp);
 
   // if we have a cache use it
   if (cache) {
+    std::chrono::seconds dur(seconds);
+    std::chrono::time_point<std::chrono::system_clock> tp(dur);
+    const auto origin = date::make_zoned(origin_tz, tp);
+    const auto dest = date::make_zoned(dest_tz, tp);
     const auto& origin_info = from_cache(origin, origin_tz, *cache);
     const auto& dest_info = from_cache(dest, dest_tz, *cache);
     return static_cast<int>(
@@ -159,11 +276,7 @@ int timezone_diff(const uint64_t seconds,
             .count());
   }
 
-  const auto& origin_info = origin.get_info();
-  const auto& dest_info = dest.get_info();
-  return static_cast<int>(
-      std::chrono::duration_cast<std::chrono::seconds>(dest_info.offset - origin_info.offset)
-          .count());
+  return utc_offset(seconds, dest_tz) - utc_offset(seconds, origin_tz);
 }
 
 std::string
@@ -288,15 +401,15 @@ bool is_conditional_active(const bool type,
   std::chrono::minutes b_td = std::chrono::hours(0);
   std::chrono::minutes e_td = std::chrono::hours(23) + std::chrono::minutes(59);
 
-  std::chrono::seconds dur(current_time);
-  std::chrono::time_point<std::chrono::system_clock> tp(dur);
-
+  // shift the time into the timezone without asking the tz database
   uint32_t e_year = 0, b_year = 0;
-  const auto in_local_time = date::make_zoned(time_zone, tp);
-  auto date = date::floor<date::days>(in_local_time.get_local_time());
+  const int offset = utc_offset(current_time, time_zone);
+  const date::local_seconds local_time{std::chrono::seconds(static_cast<int64_t>(current_time) +
+                                                            offset)};
+  auto date = date::floor<date::days>(local_time);
   auto d = date::year_month_day(date);
-  auto t = date::make_time(in_local_time.get_local_time() - date); // Yields time_of_day type
-  std::chrono::minutes td = t.hours() + t.minutes();               // Yields time_of_day type
+  auto t = date::make_time(local_time - date);       // Yields time_of_day type
+  std::chrono::minutes td = t.hours() + t.minutes(); // Yields time_of_day type
 
   try {
     date::year_month_day begin_date, end_date;
@@ -517,9 +630,8 @@ bool is_conditional_active(const bool type,
 
 uint32_t second_of_week(uint32_t epoch_time, const date::time_zone* time_zone) {
   // get the date time in this timezone
-  std::chrono::seconds dur(epoch_time);
-  std::chrono::time_point<std::chrono::system_clock> utp(dur);
-  const auto tp = date::make_zoned(time_zone, utp).get_local_time();
+  const date::local_seconds tp{std::chrono::seconds(static_cast<int64_t>(epoch_time) +
+                                                   utc_offset(epoch_time, time_zone))};
   // floor to midnight of that day
   auto days = date::floor<date::days>(tp);
   // get the ordinal day of the week
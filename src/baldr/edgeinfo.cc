@@ -3,6 +3,8 @@
 
 #include "midgard/encoded.h"
 
+#include <cstring>
+
 using namespace valhalla::baldr;
 
 namespace {
@@ -24,13 +26,60 @@ json::ArrayPtr names_json(const std::vector<std::string>& names) {
   return a;
 }
 
+// What a cached shape costs besides its points, the map node, the control block of the pointer and
+// the vector itself
+constexpr size_t kCachedShapeOverhead = 64 + sizeof(std::vector<valhalla::midgard::PointLL>);
+
 } // namespace
 
 namespace valhalla {
 namespace baldr {
 
-EdgeInfo::EdgeInfo(char* ptr, const char* names_list, const size_t names_list_length)
-    : names_list_(names_list), names_list_length_(names_list_length) {
+EdgeShapeCache::EdgeShapeCache(const size_t max_size) : size_(0), max_size_(max_size) {
+}
+
+EdgeShapeCache::shape_ptr
+EdgeShapeCache::Get(const uint32_t offset, const char* encoded, const size_t size) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = shapes_.find(offset);
+    if (found != shapes_.end()) {
+      return found->second;
+    }
+  }
+
+  // Decode it without holding up the other threads, if two of them decode the same shape at once
+  // the first one to get back keeps it
+  shape_ptr shape = std::make_shared<const std::vector<midgard::PointLL>>(
+      midgard::decode7<std::vector<midgard::PointLL>>(encoded, size));
+  const size_t shape_size = kCachedShapeOverhead + shape->capacity() * sizeof(midgard::PointLL);
+  if (shape_size > max_size_) {
+    return shape;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (size_ + shape_size > max_size_) {
+    shapes_.clear();
+    size_ = 0;
+  }
+  auto inserted = shapes_.emplace(offset, shape);
+  if (inserted.second) {
+    size_ += shape_size;
+  }
+  return inserted.first->second;
+}
+
+size_t EdgeShapeCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_;
+}
+
+EdgeInfo::EdgeInfo(char* ptr,
+                   const char* names_list,
+                   const size_t names_list_length,
+                   EdgeShapeCache* shape_cache,
+                   const uint32_t offset)
+    : names_list_(names_list), names_list_length_(names_list_length), shape_cache_(shape_cache),
+      offset_(offset) {
 
   ei_ = *reinterpret_cast<EdgeInfoInner*>(ptr);
   ptr += sizeof(EdgeInfoInner);
@@ -43,16 +92,8 @@ EdgeInfo::EdgeInfo(char* ptr, const char* names_list, const size_t names_list_le
   encoded_shape_ = ptr;
   ptr += (encoded_shape_size() * sizeof(char));
 
-  // Optional second half of 64bit way id
-  extended_wayid2_ = extended_wayid3_ = 0;
-  if (ei_.extended_wayid_size_ > 0) {
-    extended_wayid2_ = static_cast<uint8_t>(*ptr);
-    ptr += sizeof(uint8_t);
-  }
-  if (ei_.extended_wayid_size_ > 1) {
-    extended_wayid3_ = static_cast<uint8_t>(*ptr);
-    ptr += sizeof(uint8_t);
-  }
+  // The optional second half of the 64bit way id and elevations are only read when asked for
+  extra_ = ptr;
 }
 
 EdgeInfo::~EdgeInfo() {
@@ -69,6 +110,33 @@ NameInfo EdgeInfo::GetNameInfo(uint8_t index) const {
   }
 }
 
+// Get the text at an offset in the text list, it ends at its null terminator or the list
+boost::string_view EdgeInfo::GetText(const uint32_t offset, const char* what) const {
+  if (offset >= names_list_length_) {
+    throw std::runtime_error(std::string(what) + ": offset exceeds size of text list");
+  }
+  const char* text = names_list_ + offset;
+  return boost::string_view(text, strnlen(text, names_list_length_ - offset));
+}
+
+// Get the name for the specified name index
+boost::string_view EdgeInfo::GetName(uint8_t index) const {
+  return GetText(GetNameInfo(index).name_offset_, "GetName");
+}
+
+// Get a list of names pointing into the text list
+std::vector<boost::string_view> EdgeInfo::GetNameViews(bool only_tagged_names) const {
+  std::vector<boost::string_view> names;
+  names.reserve(name_count());
+  const NameInfo* ni = name_info_list_;
+  for (uint32_t i = 0; i < name_count(); i++, ni++) {
+    if (static_cast<bool>(ni->tagged_) == only_tagged_names) {
+      names.push_back(GetText(ni->name_offset_, "GetNameViews"));
+    }
+  }
+  return names;
+}
+
 // Get a list of names
 std::vector<std::string> EdgeInfo::GetNames(bool only_tagged_names) const {
   // Get each name
@@ -76,13 +144,9 @@ std::vector<std::string> EdgeInfo::GetNames(bool only_tagged_names) const {
   names.reserve(name_count());
   const NameInfo* ni = name_info_list_;
   for (uint32_t i = 0; i < name_count(); i++, ni++) {
-    if ((only_tagged_names && !ni->tagged_) || (!only_tagged_names && ni->tagged_)) {
-      continue;
-    }
-    if (ni->name_offset_ < names_list_length_) {
-      names.push_back(names_list_ + ni->name_offset_);
-    } else {
-      throw std::runtime_error("GetNames: offset exceeds size of text list");
+    if (static_cast<bool>(ni->tagged_) == only_tagged_names) {
+      auto name = GetText(ni->name_offset_, "GetNames");
+      names.emplace_back(name.data(), name.size());
     }
   }
   return names;
@@ -100,22 +164,14 @@ EdgeInfo::GetNamesAndTypes(bool include_tagged_names) const {
     if (ni->tagged_ && !include_tagged_names) {
       continue;
     }
+    auto name = GetText(ni->name_offset_, "GetNamesAndTypes");
     if (ni->tagged_) {
-      if (ni->name_offset_ < names_list_length_) {
-        std::string name = names_list_ + ni->name_offset_;
-        if (name.size() > 1) {
-          try {
-            name_type_pairs.push_back({name.substr(1), false});
-          } catch (const std::invalid_argument& arg) {
-            LOG_DEBUG("invalid_argument thrown for name: " + name);
-          }
-        }
-      } else
-        throw std::runtime_error("GetNamesAndTypes: offset exceeds size of text list");
-    } else if (ni->name_offset_ < names_list_length_) {
-      name_type_pairs.push_back({names_list_ + ni->name_offset_, ni->is_route_num_});
+      // without the tag type in front
+      if (name.size() > 1) {
+        name_type_pairs.emplace_back(name.substr(1).to_string(), false);
+      }
     } else {
-      throw std::runtime_error("GetNamesAndTypes: offset exceeds size of text list");
+      name_type_pairs.emplace_back(name.to_string(), ni->is_route_num_);
     }
   }
   return name_type_pairs;
@@ -130,20 +186,14 @@ std::vector<std::pair<std::string, uint8_t>> EdgeInfo::GetTaggedNamesAndTypes()
   for (uint32_t i = 0; i < name_count(); i++, ni++) {
     // Skip any non tagged names
     if (ni->tagged_) {
-      if (ni->name_offset_ < names_list_length_) {
-        std::string name = names_list_ + ni->name_offset_;
-        if (name.size() > 1) {
-          uint8_t num = 0;
-          try {
-            num = std::stoi(name.substr(0, 1));
-            name_type_pairs.push_back({name.substr(1), num});
-
-          } catch (const std::invalid_argument& arg) {
-            LOG_DEBUG("invalid_argument thrown for name: " + name);
-          }
+      auto name = GetText(ni->name_offset_, "GetTaggedNamesAndTypes");
+      if (name.size() > 1) {
+        // the tag type is the single digit in front
+        if (name.front() >= '0' && name.front() <= '9') {
+          name_type_pairs.emplace_back(name.substr(1).to_string(), name.front() - '0');
+        } else {
+          LOG_DEBUG("invalid tag type for name: " + name.to_string());
         }
-      } else {
-        throw std::runtime_error("GetTaggedNamesAndTypes: offset exceeds size of text list");
       }
     }
   }
@@ -164,6 +214,14 @@ uint16_t EdgeInfo::GetTypes() const {
 // Returns shape as a vector of PointLL
 // TODO: use shared ptr here so that we dont have to worry about lifetime
 const std::vector<midgard::PointLL>& EdgeInfo::shape() const {
+  // the tile may have decoded it already
+  if (shape_cache_ != nullptr && encoded_shape_ != nullptr && shape_.empty()) {
+    if (!cached_shape_) {
+      cached_shape_ = shape_cache_->Get(offset_, encoded_shape_, ei_.encoded_shape_size_);
+    }
+    return *cached_shape_;
+  }
+
   // if we haven't yet decoded the shape, do so
   if (encoded_shape_ != nullptr && shape_.empty()) {
     shape_ = midgard::decode7<std::vector<midgard::PointLL>>(encoded_shape_, ei_.encoded_shape_size_);
@@ -171,12 +229,62 @@ const std::vector<midgard::PointLL>& EdgeInfo::shape() const {
   return shape_;
 }
 
+// Returns the bounding box of the shape, only the offsets are summed up if it isnt decoded yet
+midgard::AABB2<midgard::PointLL> EdgeInfo::shape_bounding_box() const {
+  if (encoded_shape_ == nullptr || !shape_.empty()) {
+    return midgard::AABB2<midgard::PointLL>(shape_);
+  }
+  return midgard::decode7_bbox<midgard::AABB2<midgard::PointLL>>(encoded_shape_,
+                                                                 ei_.encoded_shape_size_);
+}
+
 // Returns the encoded shape string
 std::string EdgeInfo::encoded_shape() const {
   return encoded_shape_ == nullptr ? midgard::encode7(shape_)
                                    : std::string(encoded_shape_, ei_.encoded_shape_size_);
 }
 
+// Returns the encoded elevations of the shape points, they follow the optional bytes of the way id
+boost::string_view EdgeInfo::GetEncodedElevation() const {
+  if (!ei_.has_elevation_) {
+    return {};
+  }
+  // the size in front of them isnt aligned
+  const char* ptr = extra_ + ei_.extended_wayid_size_;
+  uint16_t size;
+  std::memcpy(&size, ptr, sizeof(size));
+  return boost::string_view(ptr + sizeof(size), size);
+}
+
+// Returns the encoded elevations of the shape points
+std::string EdgeInfo::encoded_elevation() const {
+  return GetEncodedElevation().to_string();
+}
+
+// Returns the elevations of the shape points, each is an offset from the one before
+std::vector<float> EdgeInfo::elevation() const {
+  std::vector<float> elevation;
+  const auto encoded = GetEncodedElevation();
+  const auto* byte = reinterpret_cast<const uint8_t*>(encoded.data());
+  const auto* end = byte + encoded.size();
+  int32_t value = 0;
+  while (byte != end) {
+    uint32_t bits = 0;
+    int shift = 0;
+    do {
+      if (byte == end) {
+        throw std::runtime_error("Bad encoded elevation");
+      }
+      bits |= static_cast<uint32_t>(*byte & 0x7f) << shift;
+      shift += 7;
+    } while (*byte++ & 0x80);
+    // undo the bit flipping of negative offsets
+    value += static_cast<int32_t>(bits & 1 ? ~bits : bits) >> 1;
+    elevation.push_back(kMinElevation + value * kShapeElevationPrecision);
+  }
+  return elevation;
+}
+
 json::MapPtr EdgeInfo::json() const {
   json::MapPtr edge_info = json::map({
       {"way_id", static_cast<uint64_t>(wayid())},
@@ -0,0 +1,93 @@
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "baldr/edgereach.h"
+
+namespace {
+
+// bump the version whenever the layout of the file changes
+constexpr char kMagic[8] = {'V', 'A', 'L', 'H', 'A', 'L', 'R', 'E'};
+constexpr uint32_t kVersion = 1;
+
+struct header_t {
+  char magic[8];
+  uint32_t version;
+  uint8_t cap;
+  uint8_t costing_count;
+  uint16_t spare;
+  uint64_t tile_count;
+  uint64_t edge_count;
+};
+
+template <typename T> void write(std::ofstream& file, const std::vector<T>& values) {
+  file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T> void read(std::ifstream& file, std::vector<T>& values, const size_t count) {
+  values.resize(count);
+  file.read(reinterpret_cast<char*>(values.data()), count * sizeof(T));
+}
+
+} // namespace
+
+namespace valhalla {
+namespace baldr {
+
+EdgeReach::EdgeReach(uint8_t cap,
+                     std::vector<uint8_t>&& costings,
+                     std::vector<tile_t>&& tiles,
+                     std::vector<reach_t>&& reaches)
+    : cap_(cap), costings_(std::move(costings)), tiles_(std::move(tiles)),
+      reaches_(std::move(reaches)) {
+  IndexTiles();
+}
+
+EdgeReach::EdgeReach(const std::string& file) {
+  std::ifstream in(file, std::ios::binary);
+  header_t header{};
+  in.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!in || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion) {
+    throw std::runtime_error("Not a valid edge reach file: " + file);
+  }
+
+  cap_ = header.cap;
+  read(in, costings_, header.costing_count);
+  read(in, tiles_, header.tile_count);
+  read(in, reaches_, header.edge_count * header.costing_count);
+  if (!in) {
+    throw std::runtime_error("Truncated edge reach file: " + file);
+  }
+  IndexTiles();
+}
+
+void EdgeReach::Save(const std::string& file) const {
+  header_t header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.cap = cap_;
+  header.costing_count = costings_.size();
+  header.tile_count = tiles_.size();
+  header.edge_count = edge_count();
+
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  write(out, costings_);
+  write(out, tiles_);
+  write(out, reaches_);
+  if (!out) {
+    throw std::runtime_error("Failed to write edge reach file: " + file);
+  }
+}
+
+void EdgeReach::IndexTiles() {
+  tile_index_.clear();
+  tile_index_.reserve(tiles_.size());
+  for (uint32_t i = 0; i < tiles_.size(); ++i) {
+    tile_index_.emplace(tiles_[i].tile, i);
+  }
+}
+
+} // namespace baldr
+} // namespace valhalla
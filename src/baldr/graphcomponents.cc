@@ -0,0 +1,87 @@
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "baldr/graphcomponents.h"
+
+namespace {
+
+// bump the version whenever the layout of the file changes
+constexpr char kMagic[8] = {'V', 'A', 'L', 'H', 'A', 'L', 'G', 'C'};
+constexpr uint32_t kVersion = 1;
+
+struct header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t mode_count;
+  uint64_t tile_count;
+  uint64_t edge_count;
+};
+
+template <typename T> void write(std::ofstream& file, const std::vector<T>& values) {
+  file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T> void read(std::ifstream& file, std::vector<T>& values, const size_t count) {
+  values.resize(count);
+  file.read(reinterpret_cast<char*>(values.data()), count * sizeof(T));
+}
+
+} // namespace
+
+namespace valhalla {
+namespace baldr {
+
+GraphComponents::GraphComponents(std::vector<uint16_t>&& modes,
+                                 std::vector<tile_t>&& tiles,
+                                 std::vector<uint32_t>&& components)
+    : modes_(std::move(modes)), tiles_(std::move(tiles)), components_(std::move(components)) {
+  IndexTiles();
+}
+
+GraphComponents::GraphComponents(const std::string& file) {
+  std::ifstream in(file, std::ios::binary);
+  header_t header{};
+  in.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!in || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion) {
+    throw std::runtime_error("Not a valid graph components file: " + file);
+  }
+
+  read(in, modes_, header.mode_count);
+  read(in, tiles_, header.tile_count);
+  read(in, components_, header.edge_count * header.mode_count);
+  if (!in) {
+    throw std::runtime_error("Truncated graph components file: " + file);
+  }
+  IndexTiles();
+}
+
+void GraphComponents::Save(const std::string& file) const {
+  header_t header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.mode_count = modes_.size();
+  header.tile_count = tiles_.size();
+  header.edge_count = edge_count();
+
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  write(out, modes_);
+  write(out, tiles_);
+  write(out, components_);
+  if (!out) {
+    throw std::runtime_error("Failed to write graph components file: " + file);
+  }
+}
+
+void GraphComponents::IndexTiles() {
+  tile_index_.clear();
+  tile_index_.reserve(tiles_.size());
+  for (uint32_t i = 0; i < tiles_.size(); ++i) {
+    tile_index_.emplace(tiles_[i].tile, i);
+  }
+}
+
+} // namespace baldr
+} // namespace valhalla
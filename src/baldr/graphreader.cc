@@ -1,7 +1,17 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <string>
 #include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+#include <thread>
 #include <utility>
 
 #include "baldr/connectivity_map.h"
@@ -11,6 +21,7 @@
 #include "incident_singleton.h"
 #include "midgard/encoded.h"
 #include "midgard/logging.h"
+#include "midgard/tracing.h"
 #include "shortcut_recovery.h"
 
 using namespace valhalla::midgard;
@@ -19,7 +30,9 @@ namespace {
 
 constexpr size_t DEFAULT_MAX_CACHE_SIZE = 1073741824; // 1 gig
 constexpr size_t AVERAGE_TILE_SIZE = 2097152;         // 2 megs
-constexpr size_t AVERAGE_MM_TILE_SIZE = 1024;         // 1k
+constexpr size_t MAX_PREFETCHED_TILES = 256;          // loaded but not yet cached tiles
+constexpr size_t MAX_LOADED_TOGETHER = 16;            // tiles a thread loads in one go
+constexpr size_t MAX_NOT_FOUND_TILES = 65536;         // tiles remembered as not at the tile url
 
 } // namespace
 
@@ -35,25 +48,86 @@ tile_gone_error_t::tile_gone_error_t(std::string prefix, baldr::GraphId edgeid)
                          std::to_string(edgeid.Tile_Base())) {
 }
 
+constexpr char GraphReader::tile_extract_t::kIndexFileName[];
+constexpr size_t tile_stats_t::kLatencyBins;
+
+GraphReader::tile_extract_t::tile_index_t::tile_index_t(midgard::tar& archive) {
+  // use the index if the archive has one
+  auto index = archive.contents.find(kIndexFileName);
+  if (index != archive.contents.cend() && index->second.second % sizeof(index_entry_t) == 0) {
+    const auto* entry = reinterpret_cast<const index_entry_t*>(index->second.first);
+    const auto* end = entry + index->second.second / sizeof(index_entry_t);
+    entries_.reserve(end - entry);
+    uint64_t members_end = index->second.first - archive.mm.get() + index->second.second;
+    for (; entry < end; ++entry) {
+      // an index that points outside of the archive is stale so we cant trust any of it
+      if (entry->offset + entry->size > archive.mm.size()) {
+        break;
+      }
+      entries_.emplace_back(entry->tile_id,
+                            location_t{const_cast<char*>(archive.mm.get() + entry->offset),
+                                       entry->size});
+      members_end = std::max(members_end, entry->offset + entry->size);
+    }
+    // if something was appended to the archive after the index was written its also stale. past
+    // the last member there should only be the padding of its data, the end of archive blocks and
+    // the padding to a full record, all of which are zeros while the header of any member isnt
+    const auto* trailing = archive.mm.get() + std::min<uint64_t>(members_end, archive.mm.size());
+    const bool only_padding = std::all_of(trailing, archive.mm.get() + archive.mm.size(),
+                                          [](const char c) { return c == 0; });
+    if (entry == end && only_padding) {
+      finalize();
+      return;
+    }
+    LOG_WARN("Tile extract index is stale, falling back to parsing file names");
+    entries_.clear();
+  }
+
+  // we need to know about every file in the archive
+  archive.traverse();
+
+  // map files to graph ids
+  for (const auto& c : archive.contents) {
+    try {
+      auto id = GraphTile::GetTileId(c.first);
+      entries_.emplace_back(id, location_t{const_cast<char*>(c.second.first), c.second.second});
+    } catch (...) {
+      // It's possible to put non-tile files inside the tarfile.  As we're only
+      // parsing the file *name* as a GraphId here, we will just silently skip
+      // any file paths that can't be parsed by GraphId::GetTileId()
+      // If we end up with *no* recognizable tile files in the tarball at all,
+      // checks lower down will warn on that.
+    }
+  }
+  finalize();
+}
+
+void GraphReader::tile_extract_t::tile_index_t::finalize() {
+  // stable so that of any duplicates the one added last is the one that we keep
+  std::stable_sort(entries_.begin(), entries_.end(),
+                   [](const value_type& a, const value_type& b) { return a.first < b.first; });
+  auto last = std::unique(entries_.rbegin(), entries_.rend(),
+                          [](const value_type& a, const value_type& b) { return a.first == b.first; });
+  entries_.erase(entries_.begin(), last.base());
+  entries_.shrink_to_fit();
+}
+
 GraphReader::tile_extract_t::tile_extract_t(const boost::property_tree::ptree& pt) {
   // if you really meant to load it
   if (pt.get_optional<std::string>("tile_extract")) {
     try {
       // load the tar
-      archive.reset(new midgard::tar(pt.get<std::string>("tile_extract")));
-      // map files to graph ids
-      for (auto& c : archive->contents) {
-        try {
-          auto id = GraphTile::GetTileId(c.first);
-          tiles[id] = std::make_pair(const_cast<char*>(c.second.first), c.second.second);
-        } catch (...) {
-          // It's possible to put non-tile files inside the tarfile.  As we're only
-          // parsing the file *name* as a GraphId here, we will just silently skip
-          // any file paths that can't be parsed by GraphId::GetTileId()
-          // If we end up with *no* recognizable tile files in the tarball at all,
-          // checks lower down will warn on that.
-        }
+      int map_flags = 0;
+#ifdef MAP_POPULATE
+      // fault the whole archive in up front rather than one tile at a time during requests
+      if (pt.get<bool>("tile_extract_populate", false)) {
+        map_flags |= MAP_POPULATE;
       }
+#endif
+      archive.reset(new midgard::tar(pt.get<std::string>("tile_extract"), true, kIndexFileName,
+                                     map_flags));
+      // map files to graph ids
+      tiles = tile_index_t(*archive);
       // couldn't load it
       if (tiles.empty()) {
         LOG_WARN("Tile extract contained no usuable tiles");
@@ -63,6 +137,7 @@ GraphReader::tile_extract_t::tile_extract_t(const boost::property_tree::ptree& p
         if (archive->corrupt_blocks) {
           LOG_WARN("Tile extract had " + std::to_string(archive->corrupt_blocks) + " corrupt blocks");
         }
+        tune_mapping(pt);
       }
     } catch (const std::exception& e) {
       LOG_ERROR(e.what());
@@ -73,20 +148,10 @@ GraphReader::tile_extract_t::tile_extract_t(const boost::property_tree::ptree& p
   if (pt.get_optional<std::string>("traffic_extract")) {
     try {
       // load the tar
-      traffic_archive.reset(new midgard::tar(pt.get<std::string>("traffic_extract")));
+      traffic_archive.reset(
+          new midgard::tar(pt.get<std::string>("traffic_extract"), true, kIndexFileName));
       // map files to graph ids
-      for (auto& c : traffic_archive->contents) {
-        try {
-          auto id = GraphTile::GetTileId(c.first);
-          traffic_tiles[id] = std::make_pair(const_cast<char*>(c.second.first), c.second.second);
-        } catch (...) {
-          // It's possible to put non-tile files inside the tarfile.  As we're only
-          // parsing the file *name* as a GraphId here, we will just silently skip
-          // any file paths that can't be parsed by GraphId::GetTileId()
-          // If we end up with *no* recognizable tile files in the tarball at all,
-          // checks lower down will warn on that.
-        }
-      }
+      traffic_tiles = tile_index_t(*traffic_archive);
       // couldn't load it
       if (traffic_tiles.empty()) {
         LOG_WARN("Traffic tile extract contained no usuable tiles");
@@ -104,6 +169,111 @@ GraphReader::tile_extract_t::tile_extract_t(const boost::property_tree::ptree& p
       LOG_WARN("Traffic tile extract could not be loaded");
     }
   }
+
+  if (pt.get_optional<std::string>("predicted_speeds_extract")) {
+    try {
+      // load the tar
+      predicted_archive.reset(
+          new midgard::tar(pt.get<std::string>("predicted_speeds_extract"), true, kIndexFileName));
+      // map files to graph ids
+      predicted_tiles = tile_index_t(*predicted_archive);
+      // couldn't load it
+      if (predicted_tiles.empty()) {
+        LOG_WARN("Predicted speeds extract contained no usuable tiles");
+      } // loaded ok but with possibly bad blocks
+      else {
+        LOG_INFO("Predicted speeds extract successfully loaded with tile count: " +
+                 std::to_string(predicted_tiles.size()));
+        if (predicted_archive->corrupt_blocks) {
+          LOG_WARN("Predicted speeds extract had " +
+                   std::to_string(predicted_archive->corrupt_blocks) + " corrupt blocks");
+        }
+      }
+    } catch (const std::exception& e) {
+      LOG_WARN(e.what());
+      LOG_WARN("Predicted speeds extract could not be loaded");
+    }
+  }
+}
+
+void GraphReader::tile_extract_t::tune_mapping(const boost::property_tree::ptree& pt) {
+  // find the range of the archive the tiles of each level span
+  const auto* base = archive->mm.get();
+  for (const auto& entry : tiles) {
+    const auto level = GraphId(entry.first).level();
+    if (level >= level_spans.size()) {
+      level_spans.resize(level + 1, {archive->mm.size(), 0});
+    }
+    auto& span = level_spans[level];
+    const uint64_t offset = entry.second.first - base;
+    span.first = std::min(span.first, offset);
+    span.second = std::max(span.second, offset + entry.second.second);
+  }
+  for (auto& span : level_spans) {
+    if (span.first > span.second) {
+      span = {0, 0};
+    }
+  }
+
+#ifndef _WIN32
+  // advise the kernel how the tiles will be read
+  const auto advice = pt.get<std::string>("tile_extract_advice", "normal");
+  int madvice = MADV_NORMAL;
+  if (advice == "random") {
+    madvice = MADV_RANDOM;
+  } else if (advice == "sequential") {
+    madvice = MADV_SEQUENTIAL;
+  } else if (advice == "willneed") {
+    madvice = MADV_WILLNEED;
+  } else if (advice != "normal") {
+    LOG_WARN("Unknown tile extract advice " + advice + ", using normal");
+  }
+  const bool hugepages = pt.get<bool>("tile_extract_hugepages", false);
+  for (const auto& span : level_spans) {
+    const auto length = span.second - span.first;
+    if (length == 0) {
+      continue;
+    }
+    if (madvice != MADV_NORMAL && !archive->mm.advise(span.first, length, madvice)) {
+      LOG_WARN("Tile extract advice " + advice + " failed: " + strerror(errno));
+    }
+#ifdef MADV_HUGEPAGE
+    // file backed mappings only get huge pages where the kernel supports it for the filesystem
+    if (hugepages && !archive->mm.advise(span.first, length, MADV_HUGEPAGE)) {
+      LOG_WARN("Tile extract huge pages failed: " + std::string(strerror(errno)));
+    }
+#endif
+  }
+#endif
+
+  // keep the levels every route touches resident so they are never faulted in during a request
+  const auto lock_levels = pt.get_child_optional("tile_extract_lock_levels");
+  for (const auto& level : lock_levels ? *lock_levels : boost::property_tree::ptree{}) {
+    const auto l = level.second.get_value<size_t>();
+    if (l >= level_spans.size() || level_spans[l].second == level_spans[l].first) {
+      continue;
+    }
+    const auto& span = level_spans[l];
+    if (!archive->mm.lock(span.first, span.second - span.first)) {
+      LOG_WARN("Tile extract could not lock level " + std::to_string(l) + ": " + strerror(errno));
+    }
+  }
+
+  for (size_t l = 0; l < level_spans.size(); ++l) {
+    if (level_spans[l].second > level_spans[l].first) {
+      LOG_INFO("Tile extract level " + std::to_string(l) + " spans " +
+               std::to_string(level_spans[l].second - level_spans[l].first) + " bytes of which " +
+               std::to_string(resident_bytes(l)) + " are resident");
+    }
+  }
+}
+
+size_t GraphReader::tile_extract_t::resident_bytes(uint8_t level) const {
+  if (level >= level_spans.size() || !archive) {
+    return 0;
+  }
+  const auto& span = level_spans[level];
+  return archive->mm.resident(span.first, span.second - span.first);
 }
 
 std::shared_ptr<const GraphReader::tile_extract_t>
@@ -118,7 +288,8 @@ GraphReader::get_extract_instance(const boost::property_tree::ptree& pt) {
 // ----------------------------------------------------------------------------
 
 // Constructor.
-FlatTileCache::FlatTileCache(size_t max_size) : cache_size_(0), max_cache_size_(max_size) {
+FlatTileCache::FlatTileCache(size_t max_size)
+    : cache_size_(0), max_cache_size_(max_size), evictions_(0) {
   index_offsets_[0] = 0;
   index_offsets_[1] = index_offsets_[0] + TileHierarchy::levels()[0].tiles.TileCount();
   index_offsets_[2] = index_offsets_[1] + TileHierarchy::levels()[1].tiles.TileCount();
@@ -143,6 +314,7 @@ bool FlatTileCache::OverCommitted() const {
 
 // Clears the cache.
 void FlatTileCache::Clear() {
+  evictions_ += cache_.size();
   cache_size_ = 0;
   cache_.clear();
   // TODO: this could be optimized by using the remaining bits in tileid. we need to track a 7bit
@@ -179,7 +351,8 @@ void FlatTileCache::Trim() {
 // ----------------------------------------------------------------------------
 
 // Constructor.
-SimpleTileCache::SimpleTileCache(size_t max_size) : cache_size_(0), max_cache_size_(max_size) {
+SimpleTileCache::SimpleTileCache(size_t max_size)
+    : cache_size_(0), max_cache_size_(max_size), evictions_(0) {
 }
 
 // Reserves enough cache to hold (max_cache_size / tile_size) items.
@@ -199,6 +372,7 @@ bool SimpleTileCache::OverCommitted() const {
 
 // Clears the cache.
 void SimpleTileCache::Clear() {
+  evictions_ += cache_.size();
   cache_size_ = 0;
   cache_.clear();
 }
@@ -228,7 +402,7 @@ void SimpleTileCache::Trim() {
 
 // Constructor.
 TileCacheLRU::TileCacheLRU(size_t max_size, MemoryLimitControl mem_control)
-    : mem_control_(mem_control), cache_size_(0), max_cache_size_(max_size) {
+    : mem_control_(mem_control), cache_size_(0), max_cache_size_(max_size), evictions_(0) {
 }
 
 void TileCacheLRU::Reserve(size_t tile_size) {
@@ -247,6 +421,7 @@ bool TileCacheLRU::OverCommitted() const {
 }
 
 void TileCacheLRU::Clear() {
+  evictions_ += cache_.size();
   cache_size_ = 0;
   cache_.clear();
   key_val_lru_list_.clear();
@@ -273,11 +448,12 @@ size_t TileCacheLRU::TrimToFit(const size_t required_size) {
   while ((OverCommitted() || (max_cache_size_ - cache_size_) < required_size) &&
          !key_val_lru_list_.empty()) {
     const KeyValue& entry_to_evict = key_val_lru_list_.back();
-    const auto tile_size = entry_to_evict.tile->header()->end_offset();
+    const auto tile_size = entry_to_evict.size;
     cache_size_ -= tile_size;
     freed_space += tile_size;
     cache_.erase(entry_to_evict.id);
     key_val_lru_list_.pop_back();
+    ++evictions_;
   }
   return freed_space;
 }
@@ -296,7 +472,7 @@ graph_tile_ptr TileCacheLRU::Put(const GraphId& graphid, graph_tile_ptr tile, si
     if (mem_control_ == MemoryLimitControl::HARD) {
       TrimToFit(new_tile_size);
     }
-    key_val_lru_list_.emplace_front(KeyValue{graphid, std::move(tile)});
+    key_val_lru_list_.emplace_front(KeyValue{graphid, std::move(tile), new_tile_size});
     cache_.emplace(graphid, key_val_lru_list_.begin());
   } else {
     // Value update; the new size may be different form the previous
@@ -305,7 +481,7 @@ graph_tile_ptr TileCacheLRU::Put(const GraphId& graphid, graph_tile_ptr tile, si
     //  do we need to take it into account here? (can dramatically simplify the code)
     // note: SimpleTileCache does not handle the overwrite at the moment
     auto& entry_iter = cached->second;
-    const auto old_tile_size = entry_iter->tile->header()->end_offset();
+    const auto old_tile_size = entry_iter->size;
 
     // do it before TrimToFit avoid its eviction to free space
     MoveToLruHead(entry_iter);
@@ -320,6 +496,7 @@ graph_tile_ptr TileCacheLRU::Put(const GraphId& graphid, graph_tile_ptr tile, si
     }
 
     entry_iter->tile = std::move(tile);
+    entry_iter->size = new_tile_size;
     cache_size_ -= old_tile_size;
   }
   cache_size_ += new_tile_size;
@@ -365,6 +542,11 @@ void SynchronizedTileCache::Trim() {
   cache_.Trim();
 }
 
+size_t SynchronizedTileCache::Evictions() const {
+  std::lock_guard<std::mutex> lock(mutex_ref_);
+  return cache_.Evictions();
+}
+
 // Get a pointer to a graph tile object given a GraphId.
 graph_tile_ptr SynchronizedTileCache::Get(const GraphId& graphid) const {
   std::lock_guard<std::mutex> lock(mutex_ref_);
@@ -377,8 +559,200 @@ graph_tile_ptr SynchronizedTileCache::Put(const GraphId& graphid, graph_tile_ptr
   return cache_.Put(graphid, std::move(tile), size);
 }
 
-// Constructs tile cache.
-TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree& pt) {
+// ----------------------------------------------------------------------------
+// ShardedTileCache implementation
+// ----------------------------------------------------------------------------
+
+// Constructor.
+ShardedTileCache::ShardedTileCache(size_t max_size,
+                                   size_t shard_count,
+                                   bool lru,
+                                   TileCacheLRU::MemoryLimitControl mem_control)
+    : shards_(std::make_shared<std::vector<std::unique_ptr<shard_t>>>()) {
+  shard_count = std::max(shard_count, size_t(1));
+  shards_->reserve(shard_count);
+  for (size_t i = 0; i < shard_count; ++i) {
+    shards_->emplace_back(new shard_t{});
+    auto& cache = shards_->back()->cache;
+    if (lru) {
+      cache.reset(new TileCacheLRU(max_size / shard_count, mem_control));
+    } else {
+      cache.reset(new SimpleTileCache(max_size / shard_count));
+    }
+  }
+}
+
+// Reserves enough cache to hold (max_cache_size / tile_size) items.
+void ShardedTileCache::Reserve(size_t tile_size) {
+  for (auto& s : *shards_) {
+    std::lock_guard<std::mutex> lock(s->mutex);
+    s->cache->Reserve(tile_size);
+  }
+}
+
+// Checks if tile exists in the cache.
+bool ShardedTileCache::Contains(const GraphId& graphid) const {
+  auto& s = shard(graphid);
+  std::lock_guard<std::mutex> lock(s.mutex);
+  return s.cache->Contains(graphid);
+}
+
+// Lets you know if the cache is too large.
+bool ShardedTileCache::OverCommitted() const {
+  for (const auto& s : *shards_) {
+    std::lock_guard<std::mutex> lock(s->mutex);
+    if (s->cache->OverCommitted())
+      return true;
+  }
+  return false;
+}
+
+// Clears the cache.
+void ShardedTileCache::Clear() {
+  for (auto& s : *shards_) {
+    std::lock_guard<std::mutex> lock(s->mutex);
+    s->cache->Clear();
+  }
+}
+
+void ShardedTileCache::Trim() {
+  for (auto& s : *shards_) {
+    std::lock_guard<std::mutex> lock(s->mutex);
+    if (s->cache->OverCommitted())
+      s->cache->Trim();
+  }
+}
+
+size_t ShardedTileCache::Evictions() const {
+  size_t evictions = 0;
+  for (const auto& s : *shards_) {
+    std::lock_guard<std::mutex> lock(s->mutex);
+    evictions += s->cache->Evictions();
+  }
+  return evictions;
+}
+
+// Get a pointer to a graph tile object given a GraphId.
+graph_tile_ptr ShardedTileCache::Get(const GraphId& graphid) const {
+  auto& s = shard(graphid);
+  std::lock_guard<std::mutex> lock(s.mutex);
+  return s.cache->Get(graphid);
+}
+
+// Puts a copy of a tile of into the cache.
+graph_tile_ptr ShardedTileCache::Put(const GraphId& graphid, graph_tile_ptr tile, size_t size) {
+  auto& s = shard(graphid);
+  std::lock_guard<std::mutex> lock(s.mutex);
+  return s.cache->Put(graphid, std::move(tile), size);
+}
+
+// ----------------------------------------------------------------------------
+// TieredTileCache implementation
+// ----------------------------------------------------------------------------
+
+// Constructor.
+TieredTileCache::TieredTileCache(std::unique_ptr<TileCache>&& rest,
+                                 const std::vector<uint32_t>& levels,
+                                 size_t max_size,
+                                 bool synchronized)
+    : pinned_(std::make_shared<pinned_t>()), rest_(std::move(rest)) {
+  for (auto level : levels) {
+    if (level < 32) {
+      pinned_->levels |= 1u << level;
+    }
+  }
+  pinned_->max_size = max_size;
+  pinned_->synchronized = synchronized;
+}
+
+// Constructor sharing the pinned tier of another cache.
+TieredTileCache::TieredTileCache(const TieredTileCache& other, std::unique_ptr<TileCache>&& rest)
+    : pinned_(other.pinned_), rest_(std::move(rest)) {
+}
+
+// Reserves enough cache to hold (max_cache_size / tile_size) items.
+void TieredTileCache::Reserve(size_t tile_size) {
+  {
+    auto guard = lock();
+    pinned_->tiles.reserve(pinned_->max_size / tile_size);
+  }
+  rest_->Reserve(tile_size);
+}
+
+// Checks if tile exists in the cache.
+bool TieredTileCache::Contains(const GraphId& graphid) const {
+  if (pinned(graphid)) {
+    auto guard = lock();
+    if (pinned_->tiles.find(graphid) != pinned_->tiles.end()) {
+      return true;
+    }
+  }
+  return rest_->Contains(graphid);
+}
+
+// Lets you know if the cache is too large.
+bool TieredTileCache::OverCommitted() const {
+  return rest_->OverCommitted();
+}
+
+// Clears the cache.
+void TieredTileCache::Clear() {
+  {
+    auto guard = lock();
+    pinned_->evictions += pinned_->tiles.size();
+    pinned_->size = 0;
+    pinned_->tiles.clear();
+  }
+  rest_->Clear();
+}
+
+void TieredTileCache::Trim() {
+  rest_->Trim();
+}
+
+size_t TieredTileCache::Evictions() const {
+  auto guard = lock();
+  return pinned_->evictions + rest_->Evictions();
+}
+
+size_t TieredTileCache::PinnedSize() const {
+  auto guard = lock();
+  return pinned_->size;
+}
+
+// Get a pointer to a graph tile object given a GraphId.
+graph_tile_ptr TieredTileCache::Get(const GraphId& graphid) const {
+  if (pinned(graphid)) {
+    auto guard = lock();
+    auto cached = pinned_->tiles.find(graphid);
+    if (cached != pinned_->tiles.end()) {
+      return cached->second;
+    }
+  }
+  return rest_->Get(graphid);
+}
+
+// Puts a copy of a tile of into the cache.
+graph_tile_ptr TieredTileCache::Put(const GraphId& graphid, graph_tile_ptr tile, size_t size) {
+  // the tiles of the pinned levels which dont fit anymore are cached like the others
+  if (pinned(graphid)) {
+    auto guard = lock();
+    auto cached = pinned_->tiles.find(graphid);
+    if (cached != pinned_->tiles.end()) {
+      return cached->second;
+    }
+    if (pinned_->size + size <= pinned_->max_size) {
+      pinned_->size += size;
+      return pinned_->tiles.emplace(graphid, std::move(tile)).first->second;
+    }
+  }
+  return rest_->Put(graphid, std::move(tile), size);
+}
+
+namespace {
+
+// makes the cache of the tiles which arent pinned
+TileCache* createUnpinnedTileCache(const boost::property_tree::ptree& pt) {
   size_t max_cache_size = pt.get<size_t>("max_cache_size", DEFAULT_MAX_CACHE_SIZE);
 
   bool use_lru_cache = pt.get<bool>("use_lru_mem_cache", false);
@@ -388,6 +762,30 @@ TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree&
 
   bool use_simple_cache = pt.get<bool>("use_simple_mem_cache", false);
 
+  // a global cache whose shards are locked independently
+  size_t cache_shards = pt.get<size_t>("global_cache_shards", 0);
+
+  // a reader used by many threads at once needs a cache it can share, it gets shards of its own
+  // unless it is to use the global cache like the other readers
+  if (pt.get<bool>("thread_safe_reader", false) &&
+      !pt.get<bool>("global_synchronized_cache", false)) {
+    if (cache_shards < 2) {
+      cache_shards = std::max(2u, std::thread::hardware_concurrency());
+    }
+    return new ShardedTileCache(max_cache_size, cache_shards, use_lru_cache, lru_mem_control);
+  }
+  if (pt.get<bool>("global_synchronized_cache", false) && cache_shards > 1) {
+    static std::shared_ptr<ShardedTileCache> globalShardedCache_;
+    static std::mutex factoryMutex;
+    std::lock_guard<std::mutex> lock(factoryMutex);
+    if (!globalShardedCache_) {
+      globalShardedCache_.reset(
+          new ShardedTileCache(max_cache_size, cache_shards, use_lru_cache, lru_mem_control));
+    }
+    // copies share the same shards
+    return new ShardedTileCache(*globalShardedCache_);
+  }
+
   // wrap tile cache with thread-safe version
   if (pt.get<bool>("global_synchronized_cache", false)) {
     // Handle synchronization of cache
@@ -421,13 +819,185 @@ TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree&
   return new FlatTileCache(max_cache_size);
 }
 
+} // namespace
+
+// Constructs tile cache.
+TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree& pt) {
+  std::unique_ptr<TileCache> cache(createUnpinnedTileCache(pt));
+
+  // the tiles of the pinned levels get a tier of the cache which never evicts them
+  std::vector<uint32_t> levels;
+  const auto pinned_levels = pt.get_child_optional("pinned_cache_levels");
+  for (const auto& level : pinned_levels ? *pinned_levels : boost::property_tree::ptree{}) {
+    levels.push_back(level.second.get_value<uint32_t>());
+  }
+  if (levels.empty()) {
+    return cache.release();
+  }
+  const size_t pinned_size =
+      pt.get<size_t>("pinned_cache_size",
+                     pt.get<size_t>("max_cache_size", DEFAULT_MAX_CACHE_SIZE) / 4);
+
+  // the readers sharing the global cache share its pinned tier too
+  if (pt.get<bool>("global_synchronized_cache", false)) {
+    static std::unique_ptr<TieredTileCache> globalTieredCache_;
+    static std::mutex factoryMutex;
+    std::lock_guard<std::mutex> lock(factoryMutex);
+    if (!globalTieredCache_) {
+      globalTieredCache_.reset(new TieredTileCache(nullptr, levels, pinned_size, true));
+    }
+    return new TieredTileCache(*globalTieredCache_, std::move(cache));
+  }
+  return new TieredTileCache(std::move(cache), levels, pinned_size,
+                             pt.get<bool>("thread_safe_reader", false));
+}
+
+// Loads tiles on background threads. Only the thread using the reader requests and collects tiles
+// so the bookkeeping of what was requested needs no locking. The loaded tiles are handed over
+// through futures so that their reference counts are never touched by two threads at once. Each
+// thread takes a few of the queued tiles at a time so those from the tile url come in batches
+class GraphReader::tile_prefetcher_t {
+public:
+  tile_prefetcher_t(GraphReader& reader, size_t thread_count) : reader_(reader), done_(false) {
+    for (size_t i = 0; i < thread_count; ++i) {
+      threads_.emplace_back([this]() { work(); });
+    }
+  }
+
+  ~tile_prefetcher_t() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_ = true;
+    }
+    condition_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  // whether the tile was requested and has not been collected yet
+  bool Requested(const GraphId& base) const {
+    return requested_.find(base) != requested_.end();
+  }
+
+  // queue the tile to be loaded unless too many are already outstanding
+  void Request(const GraphId& base) {
+    if (requested_.size() >= MAX_PREFETCHED_TILES) {
+      return;
+    }
+    std::promise<graph_tile_ptr> promise;
+    requested_.emplace(base, promise.get_future());
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.emplace_back(base, std::move(promise));
+    }
+    condition_.notify_one();
+  }
+
+  // waits for a requested tile to finish loading, returns false if it was never requested
+  bool Collect(const GraphId& base, graph_tile_ptr& tile) {
+    auto found = requested_.find(base);
+    if (found == requested_.end()) {
+      return false;
+    }
+    auto future = std::move(found->second);
+    requested_.erase(found);
+    tile = future.get();
+    return true;
+  }
+
+  // hands every tile that has finished loading to the callback
+  template <typename callback_t> void CollectFinished(const callback_t& callback) {
+    for (auto itr = requested_.begin(); itr != requested_.end();) {
+      if (itr->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        ++itr;
+        continue;
+      }
+      // if loading it failed we just drop it, asking for the tile will load it again and throw
+      try {
+        if (auto tile = itr->second.get()) {
+          callback(itr->first, std::move(tile));
+        }
+      } catch (...) {}
+      itr = requested_.erase(itr);
+    }
+  }
+
+private:
+  void work() {
+    while (true) {
+      std::vector<GraphId> bases;
+      std::vector<std::promise<graph_tile_ptr>> promises;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]() { return done_ || !queue_.empty(); });
+        if (done_) {
+          return;
+        }
+        // leave some for the other threads
+        auto count = std::min(MAX_LOADED_TOGETHER,
+                              (queue_.size() + threads_.size() - 1) / threads_.size());
+        for (size_t i = 0; i < count; ++i) {
+          bases.push_back(queue_.front().first);
+          promises.emplace_back(std::move(queue_.front().second));
+          queue_.pop_front();
+        }
+      }
+      try {
+        auto tiles = reader_.LoadTiles(bases);
+        for (size_t i = 0; i < tiles.size(); ++i) {
+          promises[i].set_value(std::move(tiles[i]));
+        }
+      } catch (...) {
+        for (auto& promise : promises) {
+          promise.set_exception(std::current_exception());
+        }
+      }
+    }
+  }
+
+  GraphReader& reader_;
+  std::unordered_map<GraphId, std::future<graph_tile_ptr>> requested_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<std::pair<GraphId, std::promise<graph_tile_ptr>>> queue_;
+  bool done_;
+  std::vector<std::thread> threads_;
+};
+
+void tile_stats_t::loaded(source_t source,
+                          size_t bytes,
+                          std::chrono::steady_clock::duration elapsed) {
+  count(source);
+  bytes_loaded.fetch_add(bytes, std::memory_order_relaxed);
+  auto micros = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+  size_t bin = 0;
+  while (micros > 1 && bin < kLatencyBins - 1) {
+    micros >>= 1;
+    ++bin;
+  }
+  load_latency[bin].fetch_add(1, std::memory_order_relaxed);
+}
+
+const char* tile_stats_t::name(source_t source) {
+  static constexpr const char* names[] = {"cache", "extract", "shared", "disk", "url", "not_found"};
+  return source < kSourceCount ? names[source] : "unknown";
+}
+
 // Constructor using separate tile files
 GraphReader::GraphReader(const boost::property_tree::ptree& pt,
                          std::unique_ptr<tile_getter_t>&& tile_getter)
     : tile_extract_(get_extract_instance(pt)), tile_dir_(pt.get<std::string>("tile_dir", "")),
+      shared_tile_dir_(pt.get<std::string>("shared_tile_dir", "")),
       tile_getter_(std::move(tile_getter)),
       max_concurrent_users_(pt.get<size_t>("max_concurrent_reader_users", 1)),
-      tile_url_(pt.get<std::string>("tile_url", "")), cache_(TileCacheFactory::createTileCache(pt)) {
+      tile_url_(pt.get<std::string>("tile_url", "")),
+      not_found_ttl_(pt.get<size_t>("tile_url_not_found_ttl", 0)),
+      cache_(TileCacheFactory::createTileCache(pt)),
+      tile_shape_cache_size_(pt.get<size_t>("tile_shape_cache_size", 0)),
+      tile_usage_file_(pt.get<std::string>("tile_usage_file", "")), tile_usage_count_(0),
+      tile_usage_flushed_(std::chrono::steady_clock::now()),
+      thread_safe_(pt.get<bool>("thread_safe_reader", false)), id_(next_reader_id()) {
 
   // Make a tile fetcher if we havent passed one in from somewhere else
   if (!tile_getter_ && !tile_url_.empty()) {
@@ -440,9 +1010,8 @@ GraphReader::GraphReader(const boost::property_tree::ptree& pt,
   if (!tile_url_.empty() && tile_url_.find(GraphTile::kTilePathPattern) == std::string::npos)
     throw std::runtime_error("Not found tilePath pattern in tile url");
 
-  // Reserve cache (based on whether using individual tile files or shared,
-  // mmap'd file
-  cache_->Reserve(tile_extract_->tiles.empty() ? AVERAGE_TILE_SIZE : AVERAGE_MM_TILE_SIZE);
+  // Reserve cache, mmap'd tiles are accounted for at their full size just like tiles read from disk
+  cache_->Reserve(AVERAGE_TILE_SIZE);
 
   // Initialize the incident cache singleton if we have any kind of configuration to do so. if the
   // configuration is wrong or any kind of problem occurs this throws. the call below will spawn a
@@ -455,10 +1024,25 @@ GraphReader::GraphReader(const boost::property_tree::ptree& pt,
                                                            : GetTileSet());
   }
 
-  // Fill shortcut recovery cache if requested or by default in memmap mode
+  // Cache the recovered shortcuts of each tile the first time one of them is asked for if requested,
+  // the cache is shared by all the readers of the process
   if (pt.get<bool>("shortcut_caching", false)) {
     shortcut_recovery_t::get_instance(this);
   }
+
+  // Start up the threads that load tiles in the background, only one thread can collect them
+  auto prefetch_threads = pt.get<size_t>("tile_prefetch_threads", 0);
+  if (prefetch_threads > 0 && thread_safe_) {
+    LOG_WARN("Tiles are not prefetched by a thread safe graph reader");
+  } else if (prefetch_threads > 0) {
+    prefetcher_ = std::make_unique<tile_prefetcher_t>(*this, prefetch_threads);
+  }
+}
+
+GraphReader::~GraphReader() {
+  if (!tile_usage_file_.empty()) {
+    FlushTileUsage();
+  }
 }
 
 // Method to test if tile exists
@@ -468,7 +1052,7 @@ bool GraphReader::DoesTileExist(const GraphId& graphid) const {
   }
   // if you are using an extract only check that
   if (!tile_extract_->tiles.empty()) {
-    return tile_extract_->tiles.find(graphid) != tile_extract_->tiles.cend();
+    return tile_extract_->tiles.find(graphid) != nullptr;
   }
   // otherwise check memory or disk
   if (cache_->Contains(graphid)) {
@@ -478,9 +1062,13 @@ bool GraphReader::DoesTileExist(const GraphId& graphid) const {
     return false;
   std::string file_location =
       tile_dir_ + filesystem::path::preferred_separator + GraphTile::FileSuffix(graphid.Tile_Base());
+  std::string sectioned_location =
+      tile_dir_ + filesystem::path::preferred_separator +
+      GraphTile::FileSuffix(graphid.Tile_Base(), SUFFIX_SECTIONED);
   struct stat buffer;
   return stat(file_location.c_str(), &buffer) == 0 ||
-         stat((file_location + ".gz").c_str(), &buffer) == 0;
+         stat((file_location + ".gz").c_str(), &buffer) == 0 ||
+         stat(sectioned_location.c_str(), &buffer) == 0;
 }
 
 class TarballGraphMemory final : public GraphMemory {
@@ -495,6 +1083,62 @@ private:
   const std::shared_ptr<midgard::tar> archive_;
 };
 
+class MMapGraphMemory final : public GraphMemory {
+public:
+  MMapGraphMemory(const std::string& file_name, size_t file_size)
+      : mapped_(file_name, file_size, POSIX_MADV_NORMAL, true) {
+    data = mapped_.get();
+    size = file_size;
+  }
+
+private:
+  const midgard::mem_map<char> mapped_;
+};
+
+namespace {
+
+// Maps a decompressed tile from the shared tile dir, the pages are backed by the page cache (or
+// tmpfs when the dir lives in /dev/shm) so every process mapping the file shares one copy
+graph_tile_ptr MapSharedTile(const std::string& shared_tile_dir,
+                             const GraphId& base,
+                             std::unique_ptr<const GraphMemory>&& traffic_memory) {
+  auto file_location =
+      shared_tile_dir + filesystem::path::preferred_separator + GraphTile::FileSuffix(base);
+  struct stat s;
+  if (stat(file_location.c_str(), &s) != 0 || s.st_size == 0) {
+    return nullptr;
+  }
+  try {
+    return GraphTile::Create(base, std::make_unique<MMapGraphMemory>(file_location, s.st_size),
+                             std::move(traffic_memory));
+  } catch (const std::exception& e) {
+    LOG_WARN("Failed to map shared tile " + file_location + ": " + e.what());
+    return nullptr;
+  }
+}
+
+// Publishes a tile loaded into private memory to the shared tile dir and maps it back so that
+// this process also drops its private copy. Returns nullptr if the tile could not be shared
+graph_tile_ptr ShareTile(const std::string& shared_tile_dir,
+                         const GraphTile& tile,
+                         std::unique_ptr<const GraphMemory>&& traffic_memory) {
+  // the published tile is a plain one, the cold sections of a sectioned tile have to be in it
+  const auto base = tile.header()->graphid();
+  try {
+    tile.ReadColdSections();
+  } catch (const std::exception& e) {
+    LOG_WARN("Not sharing tile " + std::to_string(base.tileid()) + ": " + e.what());
+    return nullptr;
+  }
+  const auto* begin = reinterpret_cast<const char*>(tile.header());
+  GraphTile::SaveTileToFile(std::vector<char>(begin, begin + tile.header()->end_offset()),
+                            shared_tile_dir + filesystem::path::preferred_separator +
+                                GraphTile::FileSuffix(base));
+  return MapSharedTile(shared_tile_dir, base, std::move(traffic_memory));
+}
+
+} // namespace
+
 // Get a pointer to a graph tile object given a GraphId. Return nullptr
 // if the tile is not found/empty
 graph_tile_ptr GraphReader::GetGraphTile(const GraphId& graphid) {
@@ -505,80 +1149,389 @@ graph_tile_ptr GraphReader::GetGraphTile(const GraphId& graphid) {
     return nullptr;
   }
 
-  // Check if the level/tileid combination is in the cache
   auto base = graphid.Tile_Base();
+  if (!tile_usage_file_.empty()) {
+    CountTileUsage(base);
+  }
+  return FindTile(base);
+}
+
+graph_tile_ptr GraphReader::FindTile(const GraphId& base) {
+  // Check if the level/tileid combination is in the cache
   if (const auto& cached = cache_->Get(base)) {
-    // LOG_DEBUG("Memory cache hit " + GraphTile::FileSuffix(base));
+    stats().count(tile_stats_t::kCache);
     return cached;
   }
 
+  // only the loads are spanned, the cache hits would overwrite the rest of the spans in no time
+  VALHALLA_TRACE_SPAN("GraphReader::GetGraphTile");
+
   // Try getting it from the memmapped tar extract
   if (!tile_extract_->tiles.empty()) {
     // Do we have this tile
-    auto t = tile_extract_->tiles.find(base);
-    if (t == tile_extract_->tiles.cend()) {
-      // LOG_DEBUG("Memory map cache miss " + GraphTile::FileSuffix(base));
+    const auto start = std::chrono::steady_clock::now();
+    const auto* t = tile_extract_->tiles.find(base);
+    if (!t) {
+      stats().count(tile_stats_t::kNotFound);
       return nullptr;
     }
-    auto memory = std::make_unique<TarballGraphMemory>(tile_extract_->archive, t->second);
+    auto memory = std::make_unique<TarballGraphMemory>(tile_extract_->archive, *t);
 
-    auto traffic_ptr = tile_extract_->traffic_tiles.find(base);
-    auto traffic_memory = traffic_ptr != tile_extract_->traffic_tiles.end()
-                              ? std::make_unique<TarballGraphMemory>(tile_extract_->traffic_archive,
-                                                                     traffic_ptr->second)
-                              : nullptr;
+    std::unique_ptr<TarballGraphMemory> traffic_memory;
+    if (const auto* traffic = tile_extract_->traffic_tiles.find(base))
+      traffic_memory = std::make_unique<TarballGraphMemory>(tile_extract_->traffic_archive, *traffic);
 
     // This initializes the tile from mmap
     auto tile = GraphTile::Create(base, std::move(memory), std::move(traffic_memory));
     if (!tile) {
-      // LOG_DEBUG("Memory map cache miss " + GraphTile::FileSuffix(base));
+      stats().count(tile_stats_t::kNotFound);
       return nullptr;
     }
-    // LOG_DEBUG("Memory map cache hit " + GraphTile::FileSuffix(base));
 
-    // Keep a copy in the cache and return it
-    const size_t size = AVERAGE_MM_TILE_SIZE; // tile.end_offset();  // TODO what size??
-    return cache_->Put(base, std::move(tile), size);
+    // Keep a copy in the cache and return it, we charge the whole tile even though only the pages
+    // that have been touched are resident because any of them can be at any time
+    stats().loaded(tile_stats_t::kExtract, tile->GetMemoryFootprint(),
+                       std::chrono::steady_clock::now() - start);
+    return CacheTile(base, std::move(tile));
   } // Try getting it from flat file
   else {
-    auto traffic_ptr = tile_extract_->traffic_tiles.find(base);
-    auto traffic_memory = traffic_ptr != tile_extract_->traffic_tiles.end()
-                              ? std::make_unique<TarballGraphMemory>(tile_extract_->traffic_archive,
-                                                                     traffic_ptr->second)
-                              : nullptr;
+    // Maybe it was already being loaded in the background
+    graph_tile_ptr tile;
+    if (!prefetcher_ || !prefetcher_->Collect(base, tile)) {
+      tile = LoadTile(base);
+    }
+    if (!tile) {
+      return nullptr;
+    }
+
+    // Keep a copy in the cache and return it
+    return CacheTile(base, std::move(tile));
+  }
+}
+
+graph_tile_ptr GraphReader::CacheTile(const GraphId& base, graph_tile_ptr&& tile) {
+  // Nothing else has the tile yet so this is the time to give it somewhere to keep its shapes
+  if (tile_shape_cache_size_ > 0) {
+    tile->CacheShapes(tile_shape_cache_size_);
+  }
+  if (const auto* predicted = tile_extract_->predicted_tiles.find(base)) {
+    tile->BindPredictedSpeeds(
+        std::make_unique<TarballGraphMemory>(tile_extract_->predicted_archive, *predicted));
+  }
+  const size_t size = tile->GetMemoryFootprint();
+  return cache_->Put(base, std::move(tile), size);
+}
+
+graph_tile_ptr GraphReader::LoadTile(const GraphId& base) {
+  return std::move(LoadTiles({base}).front());
+}
+
+std::vector<graph_tile_ptr> GraphReader::LoadTiles(const std::vector<GraphId>& bases) {
+  // The traffic is mmapped from its archive so we can hand it to whichever copy of the tile we use
+  auto traffic_memory = [this](const GraphId& base) -> std::unique_ptr<const GraphMemory> {
+    if (const auto* traffic = tile_extract_->traffic_tiles.find(base))
+      return std::make_unique<TarballGraphMemory>(tile_extract_->traffic_archive, *traffic);
+    return nullptr;
+  };
+
+  // Count where they came from and how long it took
+  const auto start = std::chrono::steady_clock::now();
+  auto loaded = [this, &start](tile_stats_t::source_t source, const graph_tile_ptr& tile) {
+    stats().loaded(source, tile->GetMemoryFootprint(), std::chrono::steady_clock::now() - start);
+  };
+
+  std::vector<graph_tile_ptr> tiles(bases.size());
+  std::vector<bool> shared(bases.size(), false);
+  std::vector<GraphId> missing;
+  std::vector<size_t> missing_indices;
+  for (size_t i = 0; i < bases.size(); ++i) {
+    const auto& base = bases[i];
+    auto& tile = tiles[i];
+
+    // See if another process on this host has already loaded it
+    if (!shared_tile_dir_.empty()) {
+      tile = MapSharedTile(shared_tile_dir_, base, traffic_memory(base));
+      if (tile) {
+        loaded(tile_stats_t::kShared, tile);
+        shared[i] = true;
+        continue;
+      }
+    }
 
     // Try to get it from disk and if we cant..
-    graph_tile_ptr tile = GraphTile::Create(tile_dir_, base, std::move(traffic_memory));
-    if (!tile || !tile->header()) {
-      if (!tile_getter_) {
-        return nullptr;
+    tile = GraphTile::Create(tile_dir_, base, traffic_memory(base));
+    if (tile && tile->header()) {
+      loaded(tile_stats_t::kDisk, tile);
+      continue;
+    }
+    tile.reset();
+    if (!tile_getter_) {
+      stats().count(tile_stats_t::kNotFound);
+      continue;
+    }
+
+    if (NotFound(base)) {
+      stats().count(tile_stats_t::kNotFound);
+      continue;
+    }
+
+    // ..we'll get it from the url with the others
+    missing.push_back(base);
+    missing_indices.push_back(i);
+  }
+
+  // Get them from the url all at once and cache them to disk if you can
+  if (!missing.empty()) {
+    auto fetched = GraphTile::CacheTileURLs(tile_url_, missing, tile_getter_.get(), tile_dir_);
+    for (size_t j = 0; j < fetched.size(); ++j) {
+      if (!fetched[j]) {
+        RememberNotFound(missing[j]);
+        stats().count(tile_stats_t::kNotFound);
+        continue;
       }
+      loaded(tile_stats_t::kUrl, fetched[j]);
+      tiles[missing_indices[j]] = std::move(fetched[j]);
+    }
+  }
 
-      {
-        std::lock_guard<std::mutex> lock(_404s_lock);
-        if (_404s.find(base) != _404s.end()) {
-          // LOG_DEBUG("Url cache miss " + GraphTile::FileSuffix(base));
-          return nullptr;
-        }
+  // Publish what we loaded so the other processes on this host dont have to load it again
+  if (!shared_tile_dir_.empty()) {
+    for (size_t i = 0; i < tiles.size(); ++i) {
+      if (!tiles[i] || shared[i]) {
+        continue;
+      }
+      if (auto mapped = ShareTile(shared_tile_dir_, *tiles[i], traffic_memory(bases[i]))) {
+        tiles[i] = std::move(mapped);
       }
+    }
+  }
+  return tiles;
+}
+
+bool GraphReader::NotFound(const GraphId& base) {
+  std::lock_guard<std::mutex> lock(_404s_lock);
+  auto found = _404s.find(base);
+  if (found == _404s.end()) {
+    return false;
+  }
+  // its been long enough that the tile might be there now
+  if (not_found_ttl_.count() > 0 && found->second <= std::chrono::steady_clock::now()) {
+    _404s.erase(found);
+    return false;
+  }
+  return true;
+}
+
+void GraphReader::RememberNotFound(const GraphId& base) {
+  std::lock_guard<std::mutex> lock(_404s_lock);
+  auto until = std::chrono::steady_clock::now() + not_found_ttl_;
+  _404s[base] = until;
+  _404s_order.emplace_back(base, until);
+
+  // forget the oldest ones, unless they were learned of again since then
+  while (_404s_order.size() > MAX_NOT_FOUND_TILES) {
+    auto found = _404s.find(_404s_order.front().first);
+    if (found != _404s.end() && found->second == _404s_order.front().second) {
+      _404s.erase(found);
+    }
+    _404s_order.pop_front();
+  }
+}
+
+void GraphReader::PrefetchTile(const GraphId& graphid) {
+  auto base = graphid.Tile_Base();
+  if (!graphid.Is_Valid() || cache_->Contains(base) || prefetcher_->Requested(base)) {
+    return;
+  }
+
+  // Extracts are already mapped so we only need to ask the kernel to start reading the pages
+  if (!tile_extract_->tiles.empty()) {
+#ifndef _WIN32
+    if (const auto* t = tile_extract_->tiles.find(base)) {
+      static const uintptr_t page_mask = ~(static_cast<uintptr_t>(sysconf(_SC_PAGESIZE)) - 1);
+      auto* begin = reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(t->first) & page_mask);
+      posix_madvise(begin, t->second + (t->first - begin), POSIX_MADV_WILLNEED);
+    }
+#endif
+    return;
+  }
+
+  // Move whatever is done into the cache to make room for more and then queue this one
+  prefetcher_->CollectFinished(
+      [this](const GraphId& id, graph_tile_ptr&& tile) { CacheTile(id, std::move(tile)); });
+  prefetcher_->Request(base);
+}
 
-      // Get it from the url and cache it to disk if you can
-      tile = GraphTile::CacheTileURL(tile_url_, base, tile_getter_.get(), tile_dir_);
-      if (!tile) {
-        std::lock_guard<std::mutex> lock(_404s_lock);
-        _404s.insert(base);
-        // LOG_DEBUG("Url cache miss " + GraphTile::FileSuffix(base));
-        return nullptr;
+size_t GraphReader::Warm(const std::vector<GraphId>& graphids, size_t thread_count) {
+  // Extracts are already mapped so the threads only fault in their pages, tiles from anywhere else
+  // are loaded on the threads and added to the cache here so it is only ever touched by one thread.
+  // The threads take a few at a time so that tiles from the tile url come in batches
+  const bool extract = !tile_extract_->tiles.empty();
+  const size_t together = extract ? 1 : MAX_LOADED_TOGETHER;
+  std::vector<graph_tile_ptr> tiles(extract ? 0 : graphids.size());
+  std::atomic<size_t> next(0);
+  auto work = [&]() {
+    for (size_t begin = next.fetch_add(together); begin < graphids.size();
+         begin = next.fetch_add(together)) {
+      const size_t end = std::min(begin + together, graphids.size());
+      if (extract) {
+        if (const auto* t = tile_extract_->tiles.find(graphids[begin].Tile_Base())) {
+          // touch every page, pages are at least this big everywhere
+          volatile char sum = 0;
+          for (size_t offset = 0; offset < t->second; offset += 4096) {
+            sum += t->first[offset];
+          }
+        }
+        continue;
+      }
+      std::vector<GraphId> bases;
+      std::vector<size_t> indices;
+      for (size_t i = begin; i < end; ++i) {
+        const auto base = graphids[i].Tile_Base();
+        if (!cache_->Contains(base)) {
+          bases.push_back(base);
+          indices.push_back(i);
+        }
+      }
+      try {
+        auto loaded = LoadTiles(bases);
+        for (size_t j = 0; j < loaded.size(); ++j) {
+          tiles[indices[j]] = std::move(loaded[j]);
+        }
+      } catch (const std::exception& e) {
+        LOG_WARN("Failed to warm tiles " + GraphTile::FileSuffix(bases.front()) + " and " +
+                 std::to_string(bases.size() - 1) + " more: " + e.what());
       }
-      // LOG_DEBUG("Url cache hit " + GraphTile::FileSuffix(base));
-    } else {
-      // LOG_DEBUG("Disk cache hit " + GraphTile::FileSuffix(base));
     }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < thread_count; ++i) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto& thread : threads) {
+    thread.join();
+  }
 
-    // Keep a copy in the cache and return it
-    const size_t size = tile->header()->end_offset();
-    return cache_->Put(base, std::move(tile), size);
+  // Fill the cache with the most important tiles first
+  size_t warmed = 0;
+  for (size_t i = 0; i < graphids.size() && !cache_->OverCommitted(); ++i) {
+    const auto base = graphids[i].Tile_Base();
+    if (extract) {
+      // warming up is not a use of the tile, only the requests count towards the usage file
+      warmed += cache_->Contains(base) || FindTile(base) != nullptr;
+    } else if (tiles[i]) {
+      CacheTile(base, std::move(tiles[i]));
+      ++warmed;
+    }
+  }
+  LOG_INFO("Warmed " + std::to_string(warmed) + " of " + std::to_string(graphids.size()) +
+           " tiles");
+  return warmed;
+}
+
+uint64_t GraphReader::next_reader_id() {
+  static std::atomic<uint64_t> next_id{1};
+  return next_id++;
+}
+
+tile_stats_t& GraphReader::ThreadTileStats() const {
+  // the thread remembers the counters it last used, it only looks them up when it switches readers
+  thread_local uint64_t last_id = 0;
+  thread_local tile_stats_t* last_stats = nullptr;
+  if (last_id != id_) {
+    std::lock_guard<std::mutex> lock(shared_lock_);
+    auto& stats = thread_stats_[std::this_thread::get_id()];
+    if (!stats) {
+      stats.reset(new tile_stats_t());
+    }
+    last_id = id_;
+    last_stats = stats.get();
+  }
+  return *last_stats;
+}
+
+void GraphReader::ClearIncidentIndices() {
+  std::unique_lock<std::mutex> lock(shared_lock_, std::defer_lock);
+  if (thread_safe_) {
+    lock.lock();
+  }
+  incident_indices_.clear();
+}
+
+void GraphReader::CountTileUsage(const GraphId& base) {
+  std::unique_lock<std::mutex> lock(shared_lock_, std::defer_lock);
+  if (thread_safe_) {
+    lock.lock();
+  }
+  ++tile_usage_[base];
+  // only look at the clock every so often
+  if ((++tile_usage_count_ & 0xfff) == 0 &&
+      std::chrono::steady_clock::now() - tile_usage_flushed_ > std::chrono::minutes(1)) {
+    FlushTileUsage(std::move(lock));
+  }
+}
+
+void GraphReader::FlushTileUsage() {
+  std::unique_lock<std::mutex> lock(shared_lock_, std::defer_lock);
+  if (thread_safe_) {
+    lock.lock();
   }
+  FlushTileUsage(std::move(lock));
+}
+
+void GraphReader::FlushTileUsage(std::unique_lock<std::mutex> shared) {
+  tile_usage_flushed_ = std::chrono::steady_clock::now();
+  if (tile_usage_file_.empty() || tile_usage_.empty()) {
+    return;
+  }
+  std::string lines;
+  for (const auto& usage : tile_usage_) {
+    lines += std::to_string(usage.first.level()) + "/" + std::to_string(usage.first.tileid()) + " " +
+             std::to_string(usage.second) + "\n";
+  }
+  tile_usage_.clear();
+  if (shared.owns_lock()) {
+    shared.unlock();
+  }
+
+  // every reader in the process appends to the same file, the lines of one flush are kept together
+  static std::mutex usage_lock;
+  std::lock_guard<std::mutex> lock(usage_lock);
+  std::ofstream file(tile_usage_file_, std::ios::out | std::ios::app);
+  file.write(lines.data(), lines.size());
+  if (!file) {
+    LOG_WARN("Failed to write tile usage to " + tile_usage_file_);
+  }
+}
+
+std::vector<GraphId> GraphReader::ReadTileUsage(const std::string& file_name) {
+  std::ifstream file(file_name);
+  if (!file) {
+    LOG_WARN("Failed to read tile usage from " + file_name);
+    return {};
+  }
+  std::unordered_map<GraphId, uint64_t> usage;
+  std::string line;
+  while (std::getline(file, line)) {
+    uint32_t level, tileid;
+    unsigned long long count;
+    if (std::sscanf(line.c_str(), "%u/%u %llu", &level, &tileid, &count) == 3 &&
+        level <= TileHierarchy::GetTransitLevel().level && tileid <= kMaxGraphTileId) {
+      usage[GraphId(tileid, level, 0)] += count;
+    }
+  }
+
+  std::vector<std::pair<GraphId, uint64_t>> sorted(usage.begin(), usage.end());
+  std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+    return a.second > b.second || (a.second == b.second && a.first < b.first);
+  });
+  std::vector<GraphId> graphids;
+  graphids.reserve(sorted.size());
+  for (const auto& tile : sorted) {
+    graphids.push_back(tile.first);
+  }
+  return graphids;
 }
 
 // Convenience method to get an opposing directed edge graph Id.
@@ -602,8 +1555,7 @@ GraphId GraphReader::GetOpposingEdgeId(const GraphId& edgeid, graph_tile_ptr& op
   };
 
   // Get the opposing edge
-  id.set_id(opp_tile->node(id)->edge_index() + directededge->opp_index());
-  return id;
+  return tile->GetOpposingEdgeId(directededge, *opp_tile);
 }
 
 // Convenience method to determine if 2 directed edges are connected.
@@ -895,9 +1847,9 @@ AABB2<PointLL> GraphReader::GetMinimumBoundingBox(const AABB2<PointLL>& bb) {
         // Look at the shape of each edge leaving the node
         const auto* diredge = tile->directededge(node->edge_index());
         for (uint32_t i = 0; i < node->edge_count(); i++, diredge++) {
-          auto shape = tile->edgeinfo(diredge).lazy_shape();
-          while (!shape.empty()) {
-            min_bb.Expand(shape.pop());
+          auto edgeinfo = tile->edgeinfo(diredge);
+          if (edgeinfo.encoded_shape_size() > 0) {
+            min_bb.Expand(edgeinfo.shape_bounding_box());
           }
         }
       }
@@ -928,24 +1880,33 @@ IncidentResult GraphReader::GetIncidents(const GraphId& edge_id, graph_tile_ptr&
     return {};
   }
 
-  // get the range of incidents we care about and hand it back, equal_range has no lambda option
-  auto begin = std::partition_point(itile->locations().begin(), itile->locations().end(),
-                                    [&edge_id](const valhalla::IncidentsTile::Location& candidate) {
-                                      // first one that is >= the id we want
-                                      bool is_found = candidate.edge_index() < edge_id.id();
-                                      return is_found;
-                                    });
-  auto end = std::partition_point(begin, itile->locations().end(),
-                                  [&edge_id](const valhalla::IncidentsTile::Location& candidate) {
-                                    // first one that is > the id we want
-                                    bool is_found = candidate.edge_index() <= edge_id.id();
-                                    return is_found;
-                                  });
-
-  int begin_index = begin - itile->locations().begin();
-  int end_index = end - itile->locations().begin();
-
-  return {itile, begin_index, end_index};
+  // the first time we see this version of the tile we index the ranges of locations of each edge
+  std::unique_lock<std::mutex> lock(shared_lock_, std::defer_lock);
+  if (thread_safe_) {
+    lock.lock();
+  }
+  auto& index = incident_indices_[edge_id.Tile_Base()];
+  if (index.tile != itile) {
+    index.tile = itile;
+    index.edges.clear();
+    index.offsets.clear();
+    for (int i = 0; i < itile->locations_size(); ++i) {
+      auto edge_index = itile->locations(i).edge_index();
+      if (index.edges.empty() || index.edges.back() < edge_index) {
+        index.edges.push_back(edge_index);
+        index.offsets.push_back(i);
+      }
+    }
+    index.offsets.push_back(itile->locations_size());
+  }
+
+  // get the range of incidents we care about and hand it back
+  auto found = std::lower_bound(index.edges.begin(), index.edges.end(), edge_id.id());
+  if (found == index.edges.end() || *found != edge_id.id()) {
+    return {itile, 0, 0};
+  }
+  auto i = found - index.edges.begin();
+  return {itile, index.offsets[i], index.offsets[i + 1]};
 }
 
 const valhalla::IncidentsTile::Metadata&
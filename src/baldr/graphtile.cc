@@ -9,6 +9,7 @@
 #include "midgard/pointll.h"
 #include "midgard/tiles.h"
 
+#include <algorithm>
 #include <boost/algorithm/string.hpp>
 #include <chrono>
 #include <cmath>
@@ -16,11 +17,14 @@
 #include <cstring>
 #include <ctime>
 #include <fstream>
+#include <future>
 #include <iomanip>
 #include <iostream>
 #include <locale>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -38,6 +42,80 @@ std::string MakeSingleTileUrl(const std::string& tile_url, const valhalla::baldr
          tile_url.substr(id_pos + std::strlen(valhalla::baldr::GraphTile::kTilePathPattern));
 }
 
+// Gets the urls from the getter, one doesnt need the machinery for getting many at once
+std::vector<valhalla::baldr::tile_getter_t::response_t>
+fetch(valhalla::baldr::tile_getter_t* tile_getter, const std::vector<std::string>& uris) {
+  if (uris.size() != 1) {
+    return uris.empty() ? std::vector<valhalla::baldr::tile_getter_t::response_t>{}
+                        : tile_getter->get(uris);
+  }
+  std::vector<valhalla::baldr::tile_getter_t::response_t> responses;
+  responses.emplace_back(tile_getter->get(uris.front()));
+  return responses;
+}
+
+// The urls being fetched right now, shared by every reader in the process so that when a burst of
+// requests all miss the same tile only one of them downloads it and the others wait for its bytes.
+// A null response means the one fetching it gave up, eg was interrupted, so the others have to
+using shared_response_t = std::shared_ptr<const valhalla::baldr::tile_getter_t::response_t>;
+struct in_flight_t {
+  std::mutex lock;
+  std::unordered_map<std::string, std::shared_future<shared_response_t>> fetches;
+};
+in_flight_t& in_flight() {
+  static in_flight_t fetches;
+  return fetches;
+}
+
+// The start of a sectioned tile, the head, the cold sections and the tail of the tile follow as
+// zlib streams. The magic cant start a tile, as a graph id its level would be 6
+struct SectionedTileHeader {
+  char magic[8];
+  uint64_t tile_size;
+  uint64_t cold_offset;
+  uint64_t cold_end;
+  uint64_t head_size;
+  uint64_t cold_size;
+  uint64_t tail_size;
+};
+constexpr char kSectionedMagic[8] = {'V', 'A', 'L', 'H', 'S', 'E', 'C', '\0'};
+
+// Appends a zlib stream of a range of bytes
+void CompressSection(const char* src, size_t size, int level, std::vector<char>& dst) {
+  auto offset = dst.size();
+  uLongf compressed_size = compressBound(size);
+  dst.resize(offset + compressed_size);
+  if (compress2(reinterpret_cast<Bytef*>(dst.data() + offset), &compressed_size,
+                reinterpret_cast<const Bytef*>(src), size, level) != Z_OK) {
+    throw std::runtime_error("Failed to compress tile section");
+  }
+  dst.resize(offset + compressed_size);
+}
+
+// Inflates a zlib stream which has to fill the range of bytes exactly
+bool InflateSection(const char* src, size_t src_size, char* dst, size_t size) {
+  uLongf inflated_size = size;
+  return uncompress(reinterpret_cast<Bytef*>(dst), &inflated_size,
+                    reinterpret_cast<const Bytef*>(src), src_size) == Z_OK &&
+         inflated_size == size;
+}
+
+// Indexes the complex restrictions of a tile by the edge they are looked up with, see GraphTile
+void IndexRestrictions(const char* restrictions,
+                       const size_t size,
+                       const bool forward,
+                       std::vector<std::pair<uint64_t, uint32_t>>& index) {
+  index.clear();
+  size_t offset = 0;
+  while (offset < size) {
+    const auto* cr =
+        reinterpret_cast<const valhalla::baldr::ComplexRestriction*>(restrictions + offset);
+    index.emplace_back(forward ? cr->to_graphid().value : cr->from_graphid().value, offset);
+    offset += cr->SizeOf();
+  }
+  std::sort(index.begin(), index.end());
+}
+
 // the point of this function is to avoid race conditions for writing a tile between threads
 // so the easiest thing to do is just use the thread id to differentiate
 std::string GenerateTmpSuffix() {
@@ -100,6 +178,119 @@ graph_tile_ptr GraphTile::DecompressTile(const GraphId& graphid,
       new GraphTile(graphid, std::make_unique<const VectorGraphMemory>(std::move(data)))};
 }
 
+// The cold sections of a sectioned tile, still compressed
+struct GraphTile::ColdSections {
+  std::vector<char> compressed;
+  size_t offset;
+  size_t size;
+  std::once_flag inflated;
+};
+
+struct GraphTile::LazySections {
+  std::once_flag routing_edges;
+  std::once_flag forward_restrictions;
+  std::once_flag reverse_restrictions;
+};
+
+// The bytes of sectioned tiles are inflated into the memory after the tile was made from it
+class SectionedGraphMemory final : public GraphMemory {
+public:
+  SectionedGraphMemory(size_t tile_size) : memory_(tile_size) {
+    data = memory_.data();
+    size = memory_.size();
+  }
+
+private:
+  std::vector<char> memory_;
+};
+
+bool GraphTile::IsSectioned(const std::vector<char>& data) {
+  return data.size() >= sizeof(SectionedTileHeader) &&
+         std::equal(kSectionedMagic, kSectionedMagic + sizeof(kSectionedMagic), data.begin());
+}
+
+std::vector<char> GraphTile::CompressSections(const std::vector<char>& tile, int level) {
+  if (tile.size() < sizeof(GraphTileHeader)) {
+    throw std::runtime_error("Cannot section a tile smaller than its header");
+  }
+  const auto* header = reinterpret_cast<const GraphTileHeader*>(tile.data());
+  if (header->end_offset() != tile.size()) {
+    throw std::runtime_error("Cannot section a tile whose end offset doesnt match its size");
+  }
+
+  // the cold sections go from the edge info to the predicted speeds or the end of the tile
+  SectionedTileHeader sectioned{};
+  std::copy(kSectionedMagic, kSectionedMagic + sizeof(kSectionedMagic), sectioned.magic);
+  sectioned.tile_size = tile.size();
+  sectioned.cold_offset = header->edgeinfo_offset();
+  sectioned.cold_end =
+      header->predictedspeeds_count() > 0 ? header->predictedspeeds_offset() : header->end_offset();
+
+  std::vector<char> data(sizeof(SectionedTileHeader));
+  CompressSection(tile.data(), sectioned.cold_offset, level, data);
+  sectioned.head_size = data.size() - sizeof(SectionedTileHeader);
+  CompressSection(tile.data() + sectioned.cold_offset, sectioned.cold_end - sectioned.cold_offset,
+                  level, data);
+  sectioned.cold_size = data.size() - sizeof(SectionedTileHeader) - sectioned.head_size;
+  CompressSection(tile.data() + sectioned.cold_end, sectioned.tile_size - sectioned.cold_end, level,
+                  data);
+  sectioned.tail_size =
+      data.size() - sizeof(SectionedTileHeader) - sectioned.head_size - sectioned.cold_size;
+  std::memcpy(data.data(), &sectioned, sizeof(SectionedTileHeader));
+  return data;
+}
+
+graph_tile_ptr GraphTile::DecompressSections(const GraphId& graphid,
+                                             std::vector<char>&& sectioned,
+                                             std::unique_ptr<const GraphMemory>&& traffic_memory) {
+  SectionedTileHeader header;
+  std::memcpy(&header, sectioned.data(), sizeof(SectionedTileHeader));
+  if (header.cold_offset > header.cold_end || header.cold_end > header.tile_size ||
+      sizeof(SectionedTileHeader) + header.head_size + header.cold_size + header.tail_size !=
+          sectioned.size()) {
+    LOG_ERROR("Corrupt sections of " + GraphTile::FileSuffix(graphid, SUFFIX_SECTIONED));
+    return nullptr;
+  }
+
+  // inflate the sections everything reads right away
+  auto memory = std::make_unique<SectionedGraphMemory>(header.tile_size);
+  const char* head = sectioned.data() + sizeof(SectionedTileHeader);
+  const char* tail = head + header.head_size + header.cold_size;
+  if (!InflateSection(head, header.head_size, memory->data, header.cold_offset) ||
+      !InflateSection(tail, header.tail_size, memory->data + header.cold_end,
+                      header.tile_size - header.cold_end)) {
+    LOG_ERROR("Failed to inflate " + GraphTile::FileSuffix(graphid, SUFFIX_SECTIONED));
+    return nullptr;
+  }
+
+  // keep only the compressed cold sections around until they are read
+  auto cold = std::make_shared<ColdSections>();
+  cold->compressed.assign(head + header.head_size, tail);
+  cold->offset = header.cold_offset;
+  cold->size = header.cold_end - header.cold_offset;
+  sectioned = std::vector<char>();
+
+  // the cold sections have to be known before the tile is initialized, transit tiles read names
+  std::unique_ptr<GraphTile> tile(new GraphTile());
+  tile->memory_ = std::move(memory);
+  tile->traffic_tile = TrafficTile(std::move(traffic_memory));
+  tile->cold_sections_ = std::move(cold);
+  tile->Initialize(graphid);
+  return graph_tile_ptr{tile.release()};
+}
+
+void GraphTile::InflateColdSections() const {
+  std::call_once(cold_sections_->inflated, [this]() {
+    auto& cold = *cold_sections_;
+    if (!InflateSection(cold.compressed.data(), cold.compressed.size(), memory_->data + cold.offset,
+                        cold.size)) {
+      throw std::runtime_error("Failed to inflate the edge info and text list of tile " +
+                               std::to_string(header_->graphid().tileid()));
+    }
+    cold.compressed = std::vector<char>();
+  });
+}
+
 // Constructor given a filename. Reads the graph data into memory.
 graph_tile_ptr GraphTile::Create(const std::string& tile_dir,
                                  const GraphId& graphid,
@@ -139,11 +330,29 @@ graph_tile_ptr GraphTile::Create(const std::string& tile_dir,
     return DecompressTile(graphid, std::move(compressed));
   }
 
+  // Try to load a sectioned tile
+  std::ifstream sec_file(file_location + ".sec", std::ios::in | std::ios::binary | std::ios::ate);
+  if (sec_file.is_open()) {
+    size_t filesize = sec_file.tellg();
+    sec_file.seekg(0, std::ios::beg);
+    std::vector<char> sectioned(filesize);
+    sec_file.read(sectioned.data(), filesize);
+    sec_file.close();
+    if (!IsSectioned(sectioned)) {
+      LOG_ERROR("Not a sectioned tile " + file_location + ".sec");
+      return nullptr;
+    }
+    return DecompressSections(graphid, std::move(sectioned), std::move(traffic_memory));
+  }
+
   // Nothing to load anywhere
   return nullptr;
 }
 
 graph_tile_ptr GraphTile::Create(const GraphId& graphid, std::vector<char>&& memory) {
+  if (IsSectioned(memory)) {
+    return DecompressSections(graphid, std::move(memory), nullptr);
+  }
   return graph_tile_ptr{
       new GraphTile(graphid, std::make_unique<const VectorGraphMemory>(std::move(memory)))};
 }
@@ -209,32 +418,128 @@ graph_tile_ptr GraphTile::CacheTileURL(const std::string& tile_url,
                                        const GraphId& graphid,
                                        tile_getter_t* tile_getter,
                                        const std::string& cache_location) {
+  return std::move(CacheTileURLs(tile_url, {graphid}, tile_getter, cache_location).front());
+}
+
+std::vector<graph_tile_ptr> GraphTile::CacheTileURLs(const std::string& tile_url,
+                                                     const std::vector<GraphId>& graphids,
+                                                     tile_getter_t* tile_getter,
+                                                     const std::string& cache_location) {
   // Don't bother with invalid ids
-  if (!graphid.Is_Valid() || graphid.level() > TileHierarchy::get_max_level()) {
-    return nullptr;
+  std::vector<graph_tile_ptr> tiles(graphids.size());
+  std::vector<size_t> indices;
+  std::vector<std::string> uris;
+  for (size_t i = 0; i < graphids.size(); ++i) {
+    const auto& graphid = graphids[i];
+    if (graphid.Is_Valid() && graphid.level() <= TileHierarchy::get_max_level()) {
+      indices.push_back(i);
+      uris.push_back(MakeSingleTileUrl(tile_url, graphid));
+    }
+  }
+  if (uris.empty()) {
+    return tiles;
   }
 
-  auto uri = MakeSingleTileUrl(tile_url, graphid);
-  auto result = tile_getter->get(uri);
-  if (result.status_ != tile_getter_t::status_code_t::SUCCESS) {
-    return nullptr;
+  // Claim the urls nobody else is fetching and wait on the rest
+  auto& fetches = in_flight();
+  std::vector<size_t> claimed, waiting;
+  std::vector<std::string> claimed_uris;
+  std::vector<std::promise<shared_response_t>> promises;
+  std::vector<std::shared_future<shared_response_t>> futures;
+  {
+    std::lock_guard<std::mutex> lock(fetches.lock);
+    for (size_t j = 0; j < uris.size(); ++j) {
+      auto found = fetches.fetches.find(uris[j]);
+      if (found != fetches.fetches.end()) {
+        waiting.push_back(j);
+        futures.push_back(found->second);
+        continue;
+      }
+      claimed.push_back(j);
+      claimed_uris.push_back(uris[j]);
+      promises.emplace_back();
+      fetches.fetches.emplace(uris[j], promises.back().get_future().share());
+    }
   }
-  // try to cache it on disk so we dont have to keep fetching it from url
-  if (!cache_location.empty()) {
-    auto suffix = FileSuffix(graphid.Tile_Base(),
-                             (tile_getter->gzipped() ? valhalla::baldr::SUFFIX_COMPRESSED
-                                                     : valhalla::baldr::SUFFIX_NON_COMPRESSED));
-    auto disk_location = cache_location + filesystem::path::preferred_separator + suffix;
-    SaveTileToFile(result.bytes_, disk_location);
+
+  // Hand what we got to whoever is waiting on it, only the ones we fetched get saved to disk
+  std::vector<tile_getter_t::response_t> results(uris.size());
+  std::vector<bool> fetched(uris.size(), false);
+  auto publish = [&](std::vector<tile_getter_t::response_t>* responses) {
+    {
+      std::lock_guard<std::mutex> lock(fetches.lock);
+      for (const auto& uri : claimed_uris) {
+        fetches.fetches.erase(uri);
+      }
+    }
+    for (size_t k = 0; k < claimed.size(); ++k) {
+      if (!responses) {
+        promises[k].set_value(nullptr);
+        continue;
+      }
+      auto& result = results[claimed[k]];
+      result = std::move((*responses)[k]);
+      fetched[claimed[k]] = true;
+      promises[k].set_value(std::make_shared<const tile_getter_t::response_t>(result));
+    }
+  };
+  try {
+    auto responses = fetch(tile_getter, claimed_uris);
+    publish(&responses);
+  } catch (...) {
+    publish(nullptr);
+    throw;
   }
 
-  // turn the memory into a tile
-  if (tile_getter->gzipped()) {
-    return DecompressTile(graphid, result.bytes_);
+  // The ones someone else gave up on we just get ourselves
+  std::vector<size_t> retries;
+  std::vector<std::string> retry_uris;
+  for (size_t k = 0; k < waiting.size(); ++k) {
+    if (auto response = futures[k].get()) {
+      results[waiting[k]] = *response;
+    } else {
+      retries.push_back(waiting[k]);
+      retry_uris.push_back(uris[waiting[k]]);
+    }
+  }
+  auto retried = fetch(tile_getter, retry_uris);
+  for (size_t k = 0; k < retries.size(); ++k) {
+    results[retries[k]] = std::move(retried[k]);
+    fetched[retries[k]] = true;
   }
 
-  return graph_tile_ptr{
-      new GraphTile(graphid, std::make_unique<const VectorGraphMemory>(std::move(result.bytes_)))};
+  for (size_t j = 0; j < results.size(); ++j) {
+    auto& result = results[j];
+    if (result.status_ != tile_getter_t::status_code_t::SUCCESS) {
+      continue;
+    }
+    const auto& graphid = graphids[indices[j]];
+    auto& tile = tiles[indices[j]];
+    // servers can hand out sectioned tiles in place of plain ones
+    const bool sectioned = IsSectioned(result.bytes_);
+
+    // try to cache it on disk so we dont have to keep fetching it from url
+    if (fetched[j] && !cache_location.empty()) {
+      auto suffix = FileSuffix(graphid.Tile_Base(),
+                               sectioned ? valhalla::baldr::SUFFIX_SECTIONED
+                                         : (tile_getter->gzipped()
+                                                ? valhalla::baldr::SUFFIX_COMPRESSED
+                                                : valhalla::baldr::SUFFIX_NON_COMPRESSED));
+      auto disk_location = cache_location + filesystem::path::preferred_separator + suffix;
+      SaveTileToFile(result.bytes_, disk_location);
+    }
+
+    // turn the memory into a tile
+    if (sectioned) {
+      tile = DecompressSections(graphid, std::move(result.bytes_), nullptr);
+    } else if (tile_getter->gzipped()) {
+      tile = DecompressTile(graphid, result.bytes_);
+    } else {
+      auto memory = std::make_unique<const VectorGraphMemory>(std::move(result.bytes_));
+      tile = graph_tile_ptr{new GraphTile(graphid, std::move(memory))};
+    }
+  }
+  return tiles;
 }
 
 GraphTile::~GraphTile() = default;
@@ -275,6 +580,13 @@ void GraphTile::Initialize(const GraphId& graphid) {
   directededges_ = reinterpret_cast<DirectedEdge*>(ptr);
   ptr += header_->directededgecount() * sizeof(DirectedEdge);
 
+  // The routing attributes and the restriction indices are made when they are first used, a tile
+  // which is only looked at to find a few edges should not have to page in all of them
+  routing_edges_.clear();
+  complex_restriction_forward_index_.clear();
+  complex_restriction_reverse_index_.clear();
+  lazy_sections_ = std::make_shared<LazySections>();
+
   // Extended directed edge attribution (if available).
   if (header_->has_ext_directededge()) {
     ext_directededges_ = reinterpret_cast<DirectedEdgeExt*>(ptr);
@@ -289,6 +601,19 @@ void GraphTile::Initialize(const GraphId& graphid) {
   departures_ = reinterpret_cast<TransitDeparture*>(ptr);
   ptr += header_->departurecount() * sizeof(TransitDeparture);
 
+  // The departures are sorted by line so each line starts where the one before it ends
+  line_departures_.clear();
+  if (header_->departurecount() > 0) {
+    const uint32_t lines = departures_[header_->departurecount() - 1].lineid() + 1;
+    line_departures_.reserve(lines + 1);
+    for (uint32_t i = 0; i < header_->departurecount(); ++i) {
+      while (line_departures_.size() <= departures_[i].lineid()) {
+        line_departures_.push_back(i);
+      }
+    }
+    line_departures_.resize(lines + 1, header_->departurecount());
+  }
+
   // Set a pointer to the transit stop list
   transit_stops_ = reinterpret_cast<TransitStop*>(ptr);
   ptr += header_->stopcount() * sizeof(TransitStop);
@@ -320,6 +645,20 @@ void GraphTile::Initialize(const GraphId& graphid) {
   // Set a pointer to the edge bin list
   edge_bins_ = reinterpret_cast<GraphId*>(ptr);
 
+  // Set pointers to the cells of the dense bins if the tile has them
+  if (header_->bin_cells_offset()) {
+    bin_cell_depths_ = reinterpret_cast<const uint8_t*>(tile_ptr + header_->bin_cells_offset());
+    bin_cells_ = reinterpret_cast<const uint64_t*>(bin_cell_depths_ + kBinCellDepthsSize);
+    uint32_t cell_count = 0;
+    for (size_t i = 0; i < kBinCount; ++i) {
+      bin_cell_offsets_[i] = cell_count;
+      if (bin_cell_depths_[i]) {
+        auto offsets = header_->bin_offset(i);
+        cell_count += offsets.second - offsets.first;
+      }
+    }
+  }
+
   // Start of forward restriction information and its size
   complex_restriction_forward_ = tile_ptr + header_->complex_restriction_forward_offset();
   complex_restriction_forward_size_ =
@@ -367,6 +706,36 @@ void GraphTile::Initialize(const GraphId& graphid) {
   }
 }
 
+void GraphTile::BindRoutingEdges() const {
+  if (!lazy_sections_) {
+    return;
+  }
+  // The path algorithms walk the edges of a node through their compact routing attributes
+  std::call_once(lazy_sections_->routing_edges, [this]() {
+    routing_edges_.reserve(header_->directededgecount());
+    for (uint32_t i = 0; i < header_->directededgecount(); ++i) {
+      routing_edges_.emplace_back(directededges_[i]);
+    }
+  });
+}
+
+void GraphTile::BindRestrictions(const bool forward) const {
+  if (!lazy_sections_) {
+    return;
+  }
+  if (forward) {
+    std::call_once(lazy_sections_->forward_restrictions, [this]() {
+      IndexRestrictions(complex_restriction_forward_, complex_restriction_forward_size_, true,
+                        complex_restriction_forward_index_);
+    });
+  } else {
+    std::call_once(lazy_sections_->reverse_restrictions, [this]() {
+      IndexRestrictions(complex_restriction_reverse_, complex_restriction_reverse_size_, false,
+                        complex_restriction_reverse_index_);
+    });
+  }
+}
+
 // For transit tiles we need to save off the pair<tileid,lineid> lookup via
 // onestop_ids.  This will be used for including or excluding transit lines
 // for transit routes.  We save 2 maps because operators contain all of their
@@ -614,32 +983,69 @@ iterable_t<const DirectedEdge> GraphTile::GetDirectedEdges(const size_t idx) con
 }
 
 EdgeInfo GraphTile::edgeinfo(const DirectedEdge* edge) const {
-  return EdgeInfo(edgeinfo_ + edge->edgeinfo_offset(), textlist_, textlist_size_);
+  ReadColdSections();
+  return EdgeInfo(edgeinfo_ + edge->edgeinfo_offset(), textlist_, textlist_size_,
+                  shape_cache_.get(), edge->edgeinfo_offset());
+}
+
+// Keep the decoded shapes of the edge infos from now on
+void GraphTile::CacheShapes(const size_t max_size) const {
+  if (!shape_cache_) {
+    shape_cache_.reset(new EdgeShapeCache(max_size));
+  }
+}
+
+bool GraphTile::BindPredictedSpeeds(std::unique_ptr<const GraphMemory>&& memory) const {
+  if (!memory || memory->size < sizeof(PredictedSpeedTileHeader)) {
+    return false;
+  }
+
+  // it has to be for this version of this tile and hold all of the offsets and the profiles
+  const auto* sidecar = reinterpret_cast<const PredictedSpeedTileHeader*>(memory->data);
+  const size_t offsets_size = sidecar->directed_edge_count * sizeof(uint32_t);
+  const size_t size = sizeof(PredictedSpeedTileHeader) + offsets_size +
+                      size_t(sidecar->profile_count) * kCoefficientCount * sizeof(int16_t);
+  if (sidecar->version != kPredictedSpeedTileVersion ||
+      sidecar->tile_id != header_->graphid().value ||
+      sidecar->directed_edge_count != header_->directededgecount() || memory->size < size) {
+    LOG_WARN("Predicted speeds do not match tile " + std::to_string(header_->graphid()));
+    return false;
+  }
+
+  // every profile an edge points at has to be within the sidecar, the speeds are read unchecked
+  const char* offsets = memory->data + sizeof(PredictedSpeedTileHeader);
+  const auto* offset = reinterpret_cast<const uint32_t*>(offsets);
+  const uint64_t coefficient_count = uint64_t(sidecar->profile_count) * kCoefficientCount;
+  for (uint32_t i = 0; i < sidecar->directed_edge_count; ++i) {
+    if (offset[i] != kNoPredictedSpeed &&
+        offset[i] + uint64_t(kCoefficientCount) > coefficient_count) {
+      LOG_WARN("Predicted speeds of tile " + std::to_string(header_->graphid()) +
+               " point past their profiles");
+      return false;
+    }
+  }
+
+  predictedspeeds_.set_offset(offset);
+  predictedspeeds_.set_profiles(reinterpret_cast<const int16_t*>(offsets + offsets_size));
+  predicted_memory_ = std::move(memory);
+  return true;
 }
 
 // Get the complex restrictions in the forward or reverse order based on
 // the id and modes.
 std::vector<ComplexRestriction*>
 GraphTile::GetRestrictions(const bool forward, const GraphId id, const uint64_t modes) const {
-  size_t offset = 0;
+  // the index is sorted by offset for the same edge so these come in the order of the tile
+  BindRestrictions(forward);
+  const auto& index =
+      forward ? complex_restriction_forward_index_ : complex_restriction_reverse_index_;
+  char* restrictions = forward ? complex_restriction_forward_ : complex_restriction_reverse_;
   std::vector<ComplexRestriction*> cr_vector;
-  if (forward) {
-    while (offset < complex_restriction_forward_size_) {
-      ComplexRestriction* cr =
-          reinterpret_cast<ComplexRestriction*>(complex_restriction_forward_ + offset);
-      if (cr->to_graphid() == id && (cr->modes() & modes)) {
-        cr_vector.push_back(cr);
-      }
-      offset += cr->SizeOf();
-    }
-  } else {
-    while (offset < complex_restriction_reverse_size_) {
-      ComplexRestriction* cr =
-          reinterpret_cast<ComplexRestriction*>(complex_restriction_reverse_ + offset);
-      if (cr->from_graphid() == id && (cr->modes() & modes)) {
-        cr_vector.push_back(cr);
-      }
-      offset += cr->SizeOf();
+  for (auto entry = std::lower_bound(index.begin(), index.end(), std::make_pair(id.value, 0u));
+       entry != index.end() && entry->first == id.value; ++entry) {
+    auto* cr = reinterpret_cast<ComplexRestriction*>(restrictions + entry->second);
+    if (cr->modes() & modes) {
+      cr_vector.push_back(cr);
     }
   }
   return cr_vector;
@@ -665,6 +1071,7 @@ uint16_t GraphTile::GetTypes(const DirectedEdge* edge) const {
 // Get the admininfo at the specified index.
 AdminInfo GraphTile::admininfo(const size_t idx) const {
   if (idx < header_->admincount()) {
+    ReadColdSections();
     const Admin& admin = admins_[idx];
     return AdminInfo(textlist_ + admin.country_offset(), textlist_ + admin.state_offset(),
                      admin.country_iso(), admin.state_iso());
@@ -682,6 +1089,7 @@ const Admin* GraphTile::admin(const size_t idx) const {
 
 // Convenience method to get the text/name for a given offset to the textlist
 std::string GraphTile::GetName(const uint32_t textlist_offset) const {
+  ReadColdSections();
   if (textlist_offset < textlist_size_) {
     return textlist_ + textlist_offset;
   } else {
@@ -697,6 +1105,7 @@ std::vector<SignInfo> GraphTile::GetSigns(const uint32_t idx, bool signs_on_node
   if (count == 0) {
     return signs;
   }
+  ReadColdSections();
 
   // Signs are sorted by edge index.
   // Binary search to find a sign with matching edge index.
@@ -746,6 +1155,7 @@ std::vector<SignInfo> GraphTile::GetSigns(const uint32_t idx, bool signs_on_node
 
 // Get lane connections ending on this edge.
 std::vector<LaneConnectivity> GraphTile::GetLaneConnectivity(const uint32_t idx) const {
+  ReadColdSections();
   uint32_t count = lane_connectivity_size_ / sizeof(LaneConnectivity);
   std::vector<LaneConnectivity> lcs;
   if (count == 0) {
@@ -794,76 +1204,58 @@ const TransitDeparture* GraphTile::GetNextDeparture(const uint32_t lineid,
                                                     bool date_before_tile,
                                                     bool wheelchair,
                                                     bool bicycle) const {
-  uint32_t count = header_->departurecount();
-  if (count == 0) {
-    return nullptr;
-  }
+  auto valid = [&](const TransitDeparture& departure) {
+    return GetTransitSchedule(departure.schedule_index())->IsValid(day, dow, date_before_tile) &&
+           (!wheelchair || departure.wheelchair_accessible()) &&
+           (!bicycle || departure.bicycle_accessible());
+  };
 
-  // Departures are sorted by edge Id and then by departure time.
-  // Binary search to find a departure with matching line Id.
-  int32_t low = 0;
-  int32_t high = count - 1;
-  int32_t mid;
-  int32_t found = count;
-  while (low <= high) {
-    mid = (low + high) / 2;
-    const auto& dep = departures_[mid];
-    // matching lineid and a workable time
-    if (lineid == dep.lineid() &&
-        ((current_time <= dep.departure_time() && dep.type() == kFixedSchedule) ||
-         (current_time <= dep.end_time() && dep.type() == kFrequencySchedule))) {
-      found = mid;
-      high = mid - 1;
-    } // need a smaller lineid
-    else if (lineid < dep.lineid()) {
-      high = mid - 1;
-    } // either need a bigger lineid or a later time
-    else {
-      low = mid + 1;
-    }
+  // The fixed schedule departures of the line come first sorted by departure time, binary search
+  // for the first one at or after the current time which runs on the day
+  auto line = GetLineDepartures(lineid);
+  const auto* frequencies =
+      std::partition_point(line.begin(), line.end(), [](const TransitDeparture& departure) {
+        return departure.type() == kFixedSchedule;
+      });
+  const auto* next = std::lower_bound(line.begin(), frequencies, current_time,
+                                      [](const TransitDeparture& departure, const uint32_t time) {
+                                        return departure.departure_time() < time;
+                                      });
+  while (next != frequencies && !valid(*next)) {
+    ++next;
   }
-
-  // Iterate through departures until one is found with valid date, dow or
-  // calendar date, and does not have a calendar exception.
-  for (; found < count && departures_[found].lineid() == lineid; ++found) {
-    // Make sure valid departure time
-    if (departures_[found].type() == kFixedSchedule) {
-      if (departures_[found].departure_time() >= current_time &&
-          GetTransitSchedule(departures_[found].schedule_index())
-              ->IsValid(day, dow, date_before_tile) &&
-          (!wheelchair || departures_[found].wheelchair_accessible()) &&
-          (!bicycle || departures_[found].bicycle_accessible())) {
-        return &departures_[found];
-      }
-    } else {
-      uint32_t departure_time = departures_[found].departure_time();
-      uint32_t end_time = departures_[found].end_time();
-      uint32_t frequency = departures_[found].frequency();
-      while (departure_time < current_time && departure_time < end_time) {
-        departure_time += frequency;
-      }
-
-      if (departure_time >= current_time && departure_time < end_time &&
-          GetTransitSchedule(departures_[found].schedule_index())
-              ->IsValid(day, dow, date_before_tile) &&
-          (!wheelchair || departures_[found].wheelchair_accessible()) &&
-          (!bicycle || departures_[found].bicycle_accessible())) {
-
-        const auto& d = departures_[found];
-        const TransitDeparture* dep =
-            new TransitDeparture(d.lineid(), d.tripid(), d.routeid(), d.blockid(),
-                                 d.headsign_offset(), departure_time, d.end_time(), d.frequency(),
-                                 d.elapsed_time(), d.schedule_index(), d.wheelchair_accessible(),
-                                 d.bicycle_accessible());
-        return dep;
-      }
+  const TransitDeparture* found = next != frequencies ? next : nullptr;
+
+  // A frequency based departure which leaves sooner is made for the time it next leaves
+  const TransitDeparture* frequency_departure = nullptr;
+  uint32_t frequency_time = 0;
+  for (const auto* d = frequencies; d != line.end(); ++d) {
+    uint32_t departure_time = d->departure_time();
+    if (departure_time < current_time && d->frequency() > 0) {
+      departure_time += (current_time - departure_time + d->frequency() - 1) / d->frequency() *
+                        d->frequency();
     }
+    if (departure_time >= current_time && departure_time < d->end_time() &&
+        (!found || departure_time < found->departure_time()) &&
+        (!frequency_departure || departure_time < frequency_time) && valid(*d)) {
+      frequency_departure = d;
+      frequency_time = departure_time;
+    }
+  }
+  if (frequency_departure) {
+    const auto& d = *frequency_departure;
+    return new TransitDeparture(d.lineid(), d.tripid(), d.routeid(), d.blockid(),
+                                d.headsign_offset(), frequency_time, d.end_time(), d.frequency(),
+                                d.elapsed_time(), d.schedule_index(), d.wheelchair_accessible(),
+                                d.bicycle_accessible());
   }
 
   // TODO - maybe wrap around, try next day?
-  LOG_DEBUG("No more departures found for lineid = " + std::to_string(lineid) +
-            " current_time = " + std::to_string(current_time));
-  return nullptr;
+  if (!found) {
+    LOG_DEBUG("No more departures found for lineid = " + std::to_string(lineid) +
+              " current_time = " + std::to_string(current_time));
+  }
+  return found;
 }
 
 // Get the departure given the line Id and tripid
@@ -944,6 +1336,16 @@ std::unordered_map<uint32_t, TransitDeparture*> GraphTile::GetTransitDepartures(
   return deps;
 }
 
+// Departures are sorted by line Id and then by departure time so the ones of a line are together
+midgard::iterable_t<const TransitDeparture>
+GraphTile::GetLineDepartures(const uint32_t lineid) const {
+  if (lineid + 1 >= line_departures_.size()) {
+    return midgard::iterable_t<const TransitDeparture>{departures_, size_t(0)};
+  }
+  return midgard::iterable_t<const TransitDeparture>{departures_ + line_departures_[lineid],
+                                                     departures_ + line_departures_[lineid + 1]};
+}
+
 // Get the stop onestop Ids in this tile.
 const std::unordered_map<std::string, GraphId>& GraphTile::GetStopOneStops() const {
   return stop_one_stops;
@@ -959,6 +1361,48 @@ const std::unordered_map<std::string, std::list<GraphId>>& GraphTile::GetOperato
   return oper_one_stops;
 }
 
+// Get the approximate number of bytes this tile keeps in memory.
+size_t GraphTile::GetMemoryFootprint() const {
+  // the tile data itself, for memory mapped tiles this is the most that can become resident
+  size_t size = memory_ ? memory_->size : 0;
+
+  // the decoded shapes, they can take up all of this at any time
+  if (shape_cache_) {
+    size += shape_cache_->max_size();
+  }
+
+  // the routing attributes and the index of the complex restrictions, they are made on first use
+  // so this is the most they can take up, every restriction being at least one record long
+  if (header_) {
+    size += header_->directededgecount() * sizeof(RoutingEdge);
+    size += (complex_restriction_forward_size_ + complex_restriction_reverse_size_) /
+            sizeof(ComplexRestriction) * sizeof(std::pair<uint64_t, uint32_t>);
+  }
+
+  // predicted speeds that are bound from a sidecar rather than stored in the tile
+  if (predicted_memory_) {
+    size += predicted_memory_->size;
+  }
+
+  // live traffic for the tile
+  if (traffic_tile()) {
+    size += sizeof(TrafficTileHeader) + traffic_tile.header->directed_edge_count * sizeof(TrafficSpeed);
+  }
+
+  // the transit one stop maps, each entry has a node and the heap memory of its key and value
+  constexpr size_t kNodeOverhead = 2 * sizeof(void*);
+  for (const auto& stop : stop_one_stops) {
+    size += sizeof(stop) + kNodeOverhead + stop.first.capacity();
+  }
+  for (const auto* one_stops : {&route_one_stops, &oper_one_stops}) {
+    for (const auto& one_stop : *one_stops) {
+      size += sizeof(one_stop) + kNodeOverhead + one_stop.first.capacity() +
+              one_stop.second.size() * (sizeof(GraphId) + kNodeOverhead);
+    }
+  }
+  return size;
+}
+
 // Get the transit stop given its index within the tile.
 const TransitStop* GraphTile::GetTransitStop(const uint32_t idx) const {
   uint32_t count = header_->stopcount();
@@ -1051,6 +1495,59 @@ midgard::iterable_t<GraphId> GraphTile::GetBin(size_t index) const {
   return iterable_t<GraphId>{edge_bins_ + offsets.first, edge_bins_ + offsets.second};
 }
 
+// Get the cell masks of the edges of this bin
+midgard::iterable_t<const uint64_t> GraphTile::GetBinCells(size_t index) const {
+  if (!GetBinCellDepth(index)) {
+    return iterable_t<const uint64_t>{bin_cells_, bin_cells_};
+  }
+  auto offsets = header_->bin_offset(index);
+  const auto* begin = bin_cells_ + bin_cell_offsets_[index];
+  return iterable_t<const uint64_t>{begin, begin + (offsets.second - offsets.first)};
+}
+
+AABB2<PointLL> GraphTile::BinBoundingBox(size_t index) const {
+  auto box = BoundingBox();
+  auto width = box.Width() / kBinsDim;
+  auto height = box.Height() / kBinsDim;
+  auto minx = box.minx() + (index % kBinsDim) * width;
+  auto miny = box.miny() + (index / kBinsDim) * height;
+  return AABB2<PointLL>{minx, miny, minx + width, miny + height};
+}
+
+uint64_t GraphTile::BinCellMask(const AABB2<PointLL>& bin_box,
+                                uint32_t depth,
+                                const AABB2<PointLL>& box) {
+  if (!bin_box.Intersects(box)) {
+    return 0;
+  }
+  // the range of columns and rows of cells the box covers
+  const int n = 1 << depth;
+  auto cell = [n](double coord, double min, double size) {
+    return std::min(std::max(static_cast<int>((coord - min) / size * n), 0), n - 1);
+  };
+  auto col0 = cell(box.minx(), bin_box.minx(), bin_box.Width());
+  auto col1 = cell(box.maxx(), bin_box.minx(), bin_box.Width());
+  auto row0 = cell(box.miny(), bin_box.miny(), bin_box.Height());
+  auto row1 = cell(box.maxy(), bin_box.miny(), bin_box.Height());
+  uint64_t mask = 0;
+  for (auto row = row0; row <= row1; ++row) {
+    for (auto col = col0; col <= col1; ++col) {
+      mask |= uint64_t(1) << (row * n + col);
+    }
+  }
+  return mask;
+}
+
+AABB2<PointLL>
+GraphTile::BinCellBoundingBox(const AABB2<PointLL>& bin_box, uint32_t depth, uint32_t cell) {
+  const uint32_t n = 1 << depth;
+  auto width = bin_box.Width() / n;
+  auto height = bin_box.Height() / n;
+  auto minx = bin_box.minx() + (cell % n) * width;
+  auto miny = bin_box.miny() + (cell / n) * height;
+  return AABB2<PointLL>{minx, miny, minx + width, miny + height};
+}
+
 // Get turn lanes for this edge.
 uint32_t GraphTile::turnlanes_offset(const uint32_t idx) const {
   uint32_t count = header_->turnlane_count();
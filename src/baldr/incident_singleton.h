@@ -3,12 +3,21 @@
 #include "baldr/graphreader.h"
 #include "midgard/sequence.h"
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <ctime>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl_lite.h>
@@ -25,6 +34,131 @@ namespace {
 
 constexpr time_t DEFAULT_MAX_LOADING_LATENCY = 60;
 constexpr size_t DEFAULT_MAX_LATENT_COUNT = 5;
+constexpr size_t DEFAULT_LOADING_THREADS = 4;
+
+/**
+ * Waits for files to change under a directory using inotify on linux. Where that isnt available, or
+ * the watches could not be set up, it just sleeps for the whole wait and reports that nothing is
+ * known about what changed so that the caller falls back to looking at everything
+ */
+struct change_watcher_t {
+  enum result_t { kTimeout, kChanges, kUnknown };
+
+  /**
+   * Watches every directory under root and, if given, a file outside of it
+   * @param root  the directory to watch recursively
+   * @param file  a file to watch as well
+   */
+  explicit change_watcher_t(const filesystem::path& root, const filesystem::path& file = {}) {
+#ifdef __linux__
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd == -1) {
+      LOG_WARN("Incident watcher could not use inotify, falling back to polling");
+      return;
+    }
+    add(root.string());
+    if (!file.string().empty()) {
+      auto wd = inotify_add_watch(fd, file.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB);
+      if (wd != -1) {
+        watches[wd] = "";
+      }
+    }
+#endif
+  }
+
+  ~change_watcher_t() {
+#ifdef __linux__
+    if (fd != -1) {
+      close(fd);
+    }
+#endif
+  }
+
+  change_watcher_t(const change_watcher_t&) = delete;
+  change_watcher_t& operator=(const change_watcher_t&) = delete;
+
+  // whether or not we get told about changes
+  bool active() const {
+    return fd != -1;
+  }
+
+  /**
+   * Waits until something changes or the time is up and collects what changed
+   * @param seconds  the longest to wait
+   * @param changed  the paths of the files which were written, moved or removed
+   * @return kChanges if the files in changed are all that changed, kTimeout if nothing did or, if
+   *         nothing is known about what changed, kUnknown
+   */
+  result_t wait(time_t seconds, std::vector<std::string>& changed) {
+    changed.clear();
+#ifdef __linux__
+    if (fd != -1) {
+      struct pollfd pfd {
+        fd, POLLIN, 0
+      };
+      if (poll(&pfd, 1, static_cast<int>(seconds * 1000)) <= 0) {
+        return kTimeout;
+      }
+      return drain(changed);
+    }
+#endif
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    return kUnknown;
+  }
+
+protected:
+#ifdef __linux__
+  // watches a directory and all the directories under it
+  void add(const std::string& dir) {
+    constexpr uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE;
+    auto wd = inotify_add_watch(fd, dir.c_str(), mask | IN_ONLYDIR);
+    if (wd == -1) {
+      return;
+    }
+    watches[wd] = dir;
+    try {
+      for (filesystem::recursive_directory_iterator i(dir), end; i != end; ++i) {
+        if (i->is_directory() && (wd = inotify_add_watch(fd, i->path().c_str(), mask | IN_ONLYDIR)) != -1) {
+          watches[wd] = i->path().string();
+        }
+      }
+    } catch (...) {}
+  }
+
+  // reads all the events that are queued up
+  result_t drain(std::vector<std::string>& changed) {
+    alignas(struct inotify_event) char buffer[16 * 1024];
+    result_t result = kChanges;
+    ssize_t length;
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+      for (char* pos = buffer; pos < buffer + length;) {
+        const auto* event = reinterpret_cast<const struct inotify_event*>(pos);
+        pos += sizeof(struct inotify_event) + event->len;
+        // we missed some or a new directory showed up whose files we might have missed
+        if ((event->mask & IN_Q_OVERFLOW) || ((event->mask & IN_CREATE) && (event->mask & IN_ISDIR))) {
+          result = kUnknown;
+        }
+        auto watch = watches.find(event->wd);
+        if (watch == watches.cend()) {
+          continue;
+        }
+        if (event->mask & IN_IGNORED) {
+          watches.erase(watch);
+        } else if ((event->mask & IN_CREATE) && (event->mask & IN_ISDIR)) {
+          add(watch->second + filesystem::path::preferred_separator + event->name);
+        } else if (event->len > 0 && !(event->mask & (IN_CREATE | IN_ISDIR))) {
+          changed.push_back(watch->second + filesystem::path::preferred_separator + event->name);
+        }
+      }
+    }
+    return result;
+  }
+
+  // the directory of each watch, empty for the single file
+  std::unordered_map<int, std::string> watches;
+#endif
+  int fd = -1;
+};
 
 struct incident_singleton_t {
 protected:
@@ -118,10 +252,44 @@ protected:
       return {};
     }
 
+    // lookups expect all the locations of an edge to be next to each other in edge index order
+    std::stable_sort(tile->mutable_locations()->pointer_begin(),
+                     tile->mutable_locations()->pointer_end(),
+                     [](const valhalla::IncidentsTile::Location* a,
+                        const valhalla::IncidentsTile::Location* b) {
+                       return a->edge_index() < b->edge_index();
+                     });
+
     // hand back something that isnt modifyable
     return std::const_pointer_cast<const valhalla::IncidentsTile>(tile);
   }
 
+  /**
+   * Reads a number of incident tiles at the same time, parsing big tiles is what takes the time
+   * @param filenames  the names of the files to read
+   * @param threads    the most threads to read them with
+   * @return the tiles in the same order as their names, empty for those that could not be read
+   */
+  static std::vector<std::shared_ptr<const valhalla::IncidentsTile>>
+  read_tiles(const std::vector<std::string>& filenames, size_t threads) {
+    std::vector<std::shared_ptr<const valhalla::IncidentsTile>> tiles(filenames.size());
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+      for (size_t i = next++; i < filenames.size(); i = next++) {
+        tiles[i] = read_tile(filenames[i]);
+      }
+    };
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < std::min(threads, filenames.size()); ++i) {
+      pool.emplace_back(work);
+    }
+    work();
+    for (auto& thread : pool) {
+      thread.join();
+    }
+    return tiles;
+  }
+
   /**
    * Updates the tile in the states cache
    * @param state     the state to update
@@ -187,6 +355,14 @@ protected:
    * is older than a timestamp for a given file that file is replaced with whatever its contents are
    * on disk.
    *
+   * Change Events:
+   *
+   * Where the platform supports it (inotify on linux) the thread doesnt sleep between rounds but
+   * instead waits, at most incident_max_loading_latency seconds, to be told that files changed. In
+   * directory mode this means only the tiles whose files were written, moved or removed get loaded
+   * rather than scanning the whole directory. If events were missed or cannot be had the thread falls
+   * back to the full scan above. Changed tiles are parsed by up to incident_loading_threads threads.
+   *
    * @param config     lets the function know where to look for incidents and desired update frequency
    * @param tileset    if not empty, the static list of tiles to track (other tiles will be ignored).
                        if the tileset is static (mem map tar file) we can use lockfree mode
@@ -236,19 +412,41 @@ protected:
     time_t last_scan = 0;
     time_t max_loading_latency =
         config.get<time_t>("incident_max_loading_latency", DEFAULT_MAX_LOADING_LATENCY);
+    size_t loading_threads =
+        std::max(size_t(1), config.get<size_t>("incident_loading_threads", DEFAULT_LOADING_THREADS));
     std::unordered_set<uint64_t> seen;
     seen.reserve(tileset.size());
+    std::vector<valhalla::baldr::GraphId> tile_ids;
+    std::vector<std::string> tile_paths;
+
+    // start listening before the first pass so we dont miss anything that changes during it. in log
+    // mode the tiles live next to the log so we watch that directory as well as the log itself
+    change_watcher_t change_watcher(changelog ? inc_log_path.parent_path() : inc_dir,
+                                    changelog ? inc_log_path : filesystem::path{});
+    if (change_watcher.active()) {
+      LOG_INFO("Incident watcher listening for file system events");
+    }
+    auto changes = change_watcher_t::kUnknown;
+    std::vector<std::string> changed;
+    time_t wait = 0;
 
     // wait for someone to tell us to stop
     do {
+      // after the first pass we wait for something to change or until its time to check anyway
+      if (run_count > 0) {
+        changes = change_watcher.wait(wait, changed);
+      }
+
       // TODO: its possible that a tiles update time is newer than even this scans start time
       // this happens when the tile is updated during the loop. in that case its possible that
       // the current iteration will load the tile and that it will again be loaded in the next
       auto current_scan = time(nullptr);
       size_t update_count = 0;
       seen.clear();
+      tile_ids.clear();
+      tile_paths.clear();
 
-      // we are in memory map mode
+      // we are in memory map mode, the log is cheap to look at so we look at it every time
       if (changelog) {
         // reload the log if the tileset isnt static
         try {
@@ -263,21 +461,33 @@ protected:
         for (auto entry : *changelog) {
           // first 25 bits are the tile id
           valhalla::baldr::GraphId tile_id(((uint64_t(1) << 25) - 1) & entry);
-          seen.insert(tile_id);
           // spare last 39 bits are the timestamp, leaves us with something like 17k years
           int64_t timestamp = (entry >> 25) & ((uint64_t(1) << 39) - 1);
           // check the timestamp part of the tile id to see if its newer
-          if (last_scan <= timestamp) {
+          if (seen.insert(tile_id).second && last_scan <= timestamp) {
             // concoct a file name from the tile_id
             auto file_location = inc_log_path;
             file_location.replace_filename(
                 valhalla::baldr::GraphTile::FileSuffix(tile_id, ".pbf", true));
-            // update the tile
-            update_count += update_tile(state, tile_id, read_tile(file_location.string()));
+            tile_ids.push_back(tile_id);
+            tile_paths.push_back(file_location.string());
           }
         }
-      } // we are in directory scan mode
-      else if (!inc_dir.string().empty()) {
+      } // we know exactly which files changed so we only look at those
+      else if (changes == change_watcher_t::kChanges) {
+        for (const auto& path : changed) {
+          try {
+            // if this looks like a tile we reload it, if it was removed it will be read as empty
+            auto tile_id = valhalla::baldr::GraphTile::GetTileId(path);
+            if (tile_id.Is_Valid() && seen.insert(tile_id).second) {
+              tile_ids.push_back(tile_id);
+              tile_paths.push_back(path);
+            }
+          } // happens when there is a file in the directory that doesnt have a tile-looking name
+          catch (...) {}
+        }
+      } // we are in directory scan mode and dont know what changed so we look at everything
+      else if (changes == change_watcher_t::kUnknown) {
         // check all of the files
         for (filesystem::recursive_directory_iterator i(inc_dir), end; i != end; ++i) {
           try {
@@ -289,8 +499,8 @@ protected:
               seen.insert(tile_id);
               struct stat s;
               if (stat(i->path().c_str(), &s) == 0 && last_scan <= MTIME(s)) {
-                // update the tile
-                update_count += update_tile(state, tile_id, read_tile(i->path().string()));
+                tile_ids.push_back(tile_id);
+                tile_paths.push_back(i->path().string());
               }
             }
           } // happens when there is a file in the directory that doesnt have a tile-looking name
@@ -298,27 +508,39 @@ protected:
         }
       }
 
+      // parse all the tiles that changed and then update them in the cache
+      auto tiles = read_tiles(tile_paths, loading_threads);
+      for (size_t i = 0; i < tiles.size(); ++i) {
+        update_count += update_tile(state, tile_ids[i], std::move(tiles[i]));
+      }
+
       // for all the ones we didnt see, they have been removed from the filesystem or changelog
-      // no locking is needed because we don't realloc here we just null out some values
-      for (auto entry = state->cache.begin(); entry != state->cache.end(); ++entry) {
-        auto found = seen.find(entry->first);
-        if (found == seen.cend() && entry->second) {
-          update_count += update_tile(state, valhalla::baldr::GraphId(entry->first), nullptr, &entry);
+      // no locking is needed because we don't realloc here we just null out some values. when we
+      // only looked at what changed then removals were already handled above
+      if (changelog || changes == change_watcher_t::kUnknown) {
+        for (auto entry = state->cache.begin(); entry != state->cache.end(); ++entry) {
+          auto found = seen.find(entry->first);
+          if (found == seen.cend() && entry->second) {
+            update_count +=
+                update_tile(state, valhalla::baldr::GraphId(entry->first), nullptr, &entry);
+          }
         }
       }
 
       // if this round finished but was slower than we want
       last_scan = current_scan;
       auto latency = time(nullptr) - current_scan;
-      auto wait = 0;
+      wait = 0;
       if (latency > max_loading_latency) {
         LOG_WARN("Incident watcher is not meeting max loading latency requirement");
       } // this round finished fast enough wait the remainder of the time specified
       else {
         wait = max_loading_latency - latency;
       }
-      LOG_INFO("Incident watcher updated " + std::to_string(update_count) + " tiles in " +
-               std::to_string(latency) + " seconds");
+      if (update_count > 0 || run_count == 0 || changes != change_watcher_t::kTimeout) {
+        LOG_INFO("Incident watcher updated " + std::to_string(update_count) + " tiles in " +
+                 std::to_string(latency) + " seconds");
+      }
 
       // signal to the constructor that we completed our first batch
       if (run_count++ == 0) {
@@ -326,9 +548,6 @@ protected:
         state->initialized.store(true);
         state->signal.notify_one();
       }
-
-      // wait just a little before we check again
-      std::this_thread::sleep_for(std::chrono::seconds(wait));
     } while (!interrupt || !interrupt(run_count));
 
     LOG_INFO("Incident watcher has stopped");
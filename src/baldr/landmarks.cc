@@ -0,0 +1,87 @@
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "baldr/landmarks.h"
+
+namespace {
+
+// bump the version whenever the layout of the file changes
+constexpr char kMagic[8] = {'V', 'A', 'L', 'H', 'A', 'L', 'L', 'M'};
+constexpr uint32_t kVersion = 1;
+
+struct header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t landmark_count;
+  uint64_t tile_count;
+  uint64_t node_count;
+};
+
+template <typename T> void write(std::ofstream& file, const std::vector<T>& values) {
+  file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T> void read(std::ifstream& file, std::vector<T>& values, const size_t count) {
+  values.resize(count);
+  file.read(reinterpret_cast<char*>(values.data()), count * sizeof(T));
+}
+
+} // namespace
+
+namespace valhalla {
+namespace baldr {
+
+Landmarks::Landmarks(std::vector<tile_t>&& tiles,
+                     std::vector<GraphId>&& landmarks,
+                     std::vector<uint32_t>&& distances)
+    : tiles_(std::move(tiles)), landmarks_(std::move(landmarks)), distances_(std::move(distances)) {
+  IndexTiles();
+}
+
+Landmarks::Landmarks(const std::string& file) {
+  std::ifstream in(file, std::ios::binary);
+  header_t header{};
+  in.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!in || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion) {
+    throw std::runtime_error("Not a valid landmark file: " + file);
+  }
+
+  read(in, tiles_, header.tile_count);
+  read(in, landmarks_, header.landmark_count);
+  read(in, distances_, header.node_count * header.landmark_count);
+  if (!in) {
+    throw std::runtime_error("Truncated landmark file: " + file);
+  }
+  IndexTiles();
+}
+
+void Landmarks::Save(const std::string& file) const {
+  header_t header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.landmark_count = landmarks_.size();
+  header.tile_count = tiles_.size();
+  header.node_count = node_count();
+
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  write(out, tiles_);
+  write(out, landmarks_);
+  write(out, distances_);
+  if (!out) {
+    throw std::runtime_error("Failed to write landmark file: " + file);
+  }
+}
+
+void Landmarks::IndexTiles() {
+  tile_index_.clear();
+  tile_index_.reserve(tiles_.size());
+  for (uint32_t i = 0; i < tiles_.size(); ++i) {
+    tile_index_.emplace(tiles_[i].tile, i);
+  }
+}
+
+} // namespace baldr
+} // namespace valhalla
@@ -1,5 +1,8 @@
 #include "baldr/predictedspeeds.h"
 
+#include <stdexcept>
+#include <vector>
+
 namespace valhalla {
 namespace baldr {
 
@@ -11,6 +14,10 @@ constexpr float kSpeedNormalization = 0.031497039f; // sqrt(2.0f / 2016.0f);
 // Size of the cos table for the buckets
 constexpr uint32_t kCosBucketTableSize = kCoefficientCount * kBucketsPerWeek;
 
+// How many partial sums the decoding keeps, 8 floats fill an avx register
+constexpr uint32_t kDecodeLanes = 8;
+static_assert(kCoefficientCount % kDecodeLanes == 0, "Coefficients must fill the decode lanes");
+
 // Precompute a cos table for each bucket of the week as a singleton.
 class BucketCosTable final {
 public:
@@ -47,8 +54,8 @@ private:
   BucketCosTable(BucketCosTable&&) = delete;
   BucketCosTable& operator=(BucketCosTable&&) = delete;
 
-  // cos table (this uses about 1.6MB of memory)
-  float table_[kCosBucketTableSize];
+  // cos table (this uses about 1.6MB of memory), the rows of 200 floats stay aligned for simd loads
+  alignas(32) float table_[kCosBucketTableSize];
 };
 
 std::array<int16_t, kCoefficientCount> compress_speed_buckets(const float* speeds) {
@@ -76,12 +83,21 @@ float decompress_speed_bucket(const int16_t* coefficients, uint32_t bucket_idx)
   // Get a pointer to the precomputed cos values for this bucket
   const float* b = BucketCosTable::GetInstance().get(bucket_idx);
 
-  // DCT-III with speed normalization
-  float speed = *coefficients * k1OverSqrt2;
-  const auto* coef_end = coefficients + kCoefficientCount;
-  for (++b, ++coefficients; coefficients < coef_end; ++coefficients, ++b) {
-    speed += *coefficients * *b;
+  // DCT-III with speed normalization. The sum is split over independent lanes so that the compiler
+  // can keep them in simd registers, a single running sum would have to be added up in order
+  float sums[kDecodeLanes] = {};
+  for (uint32_t c = 0; c < kCoefficientCount; c += kDecodeLanes) {
+    for (uint32_t lane = 0; lane < kDecodeLanes; ++lane) {
+      sums[lane] += coefficients[c + lane] * b[c + lane];
+    }
   }
+  float speed = 0.f;
+  for (uint32_t lane = 0; lane < kDecodeLanes; ++lane) {
+    speed += sums[lane];
+  }
+
+  // The first cos value is 1 but the first coefficient is weighted by 1 / sqrt(2)
+  speed += *coefficients * (k1OverSqrt2 - 1.f);
   return speed * kSpeedNormalization;
 }
 
@@ -113,5 +129,38 @@ std::array<int16_t, kCoefficientCount> decode_compressed_speeds(const std::strin
   return coefficients;
 }
 
+std::string serialize_predicted_speed_tile(uint64_t tile_id,
+                                           uint32_t directed_edge_count,
+                                           const speed_profiles_t& profiles) {
+  PredictedSpeedTileHeader header{};
+  header.tile_id = tile_id;
+  header.version = kPredictedSpeedTileVersion;
+  header.directed_edge_count = directed_edge_count;
+  header.profile_count = profiles.size();
+
+  // every edge gets an offset, the ones with a profile point at it in edge order
+  std::vector<uint32_t> offsets(directed_edge_count, kNoPredictedSpeed);
+  std::vector<int16_t> coefficients;
+  coefficients.reserve(profiles.size() * kCoefficientCount);
+  for (const auto& profile : profiles) {
+    if (profile.first >= directed_edge_count) {
+      throw std::runtime_error("Predicted speeds for directed edge " +
+                               std::to_string(profile.first) + " but the tile only has " +
+                               std::to_string(directed_edge_count));
+    }
+    offsets[profile.first] = coefficients.size();
+    coefficients.insert(coefficients.end(), profile.second.begin(), profile.second.end());
+  }
+
+  std::string bytes;
+  bytes.reserve(sizeof(header) + offsets.size() * sizeof(uint32_t) +
+                coefficients.size() * sizeof(int16_t));
+  bytes.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  bytes.append(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint32_t));
+  bytes.append(reinterpret_cast<const char*>(coefficients.data()),
+               coefficients.size() * sizeof(int16_t));
+  return bytes;
+}
+
 } // namespace baldr
 } // namespace valhalla
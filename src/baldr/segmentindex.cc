@@ -0,0 +1,99 @@
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "baldr/segmentindex.h"
+
+namespace {
+
+// bump the version whenever the layout of the file changes
+constexpr char kMagic[8] = {'V', 'A', 'L', 'H', 'A', 'L', 'S', 'I'};
+constexpr uint32_t kVersion = 1;
+
+struct header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t precision;
+  uint64_t bin_count;
+  uint64_t node_count;
+  uint64_t edge_count;
+  uint64_t point_count;
+};
+
+template <typename T> void write(std::ofstream& file, const std::vector<T>& values) {
+  file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T> void read(std::ifstream& file, std::vector<T>& values, const size_t count) {
+  values.resize(count);
+  file.read(reinterpret_cast<char*>(values.data()), count * sizeof(T));
+}
+
+} // namespace
+
+namespace valhalla {
+namespace baldr {
+
+SegmentIndex::SegmentIndex(std::vector<bin_t>&& bins,
+                           std::vector<node_t>&& nodes,
+                           std::vector<edge_t>&& edges,
+                           std::vector<point_t>&& points)
+    : bins_(std::move(bins)), nodes_(std::move(nodes)), edges_(std::move(edges)),
+      points_(std::move(points)) {
+  IndexBins();
+}
+
+SegmentIndex::SegmentIndex(const std::string& file) {
+  std::ifstream in(file, std::ios::binary);
+  header_t header{};
+  in.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!in || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion) {
+    throw std::runtime_error("Not a valid segment index file: " + file);
+  }
+  // the points are only the points of the shapes if they were encoded the same way
+  if (header.precision != ENCODE_PRECISION) {
+    throw std::runtime_error("Segment index file of another shape precision: " + file);
+  }
+
+  read(in, bins_, header.bin_count);
+  read(in, nodes_, header.node_count);
+  read(in, edges_, header.edge_count);
+  read(in, points_, header.point_count);
+  if (!in) {
+    throw std::runtime_error("Truncated segment index file: " + file);
+  }
+  IndexBins();
+}
+
+void SegmentIndex::Save(const std::string& file) const {
+  header_t header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.precision = ENCODE_PRECISION;
+  header.bin_count = bins_.size();
+  header.node_count = nodes_.size();
+  header.edge_count = edges_.size();
+  header.point_count = points_.size();
+
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  write(out, bins_);
+  write(out, nodes_);
+  write(out, edges_);
+  write(out, points_);
+  if (!out) {
+    throw std::runtime_error("Failed to write segment index file: " + file);
+  }
+}
+
+void SegmentIndex::IndexBins() {
+  bin_index_.clear();
+  bin_index_.reserve(bins_.size());
+  for (uint32_t i = 0; i < bins_.size(); ++i) {
+    bin_index_.emplace(key(bins_[i].tile, bins_[i].bin), i);
+  }
+}
+
+} // namespace baldr
+} // namespace valhalla
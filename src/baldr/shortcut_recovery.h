@@ -5,88 +5,70 @@
 #include "midgard/logging.h"
 
 #include <cstdint>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace {
 // TODO: break this out into a private header
-// a static cache for shortcut recovery that we can optionally pre-fill
+// a static cache for shortcut recovery that fills itself as the shortcuts are asked for
 struct shortcut_recovery_t {
 protected:
   /**
-   * Constructs a shortcut cache from a graphreaders tileset by recovering all shortcuts. If the
-   * graphreader passed in is null nothing is cached and revoery will happen on the fly
+   * Constructs a shortcut cache which is filled a tile at a time as the shortcuts are asked for. If
+   * the graphreader passed in is null nothing is cached and recovery will happen on the fly
    * @param reader
    */
-  shortcut_recovery_t(valhalla::baldr::GraphReader* reader) {
-    // do nothing if the reader is no good
-    if (!reader) {
-      LOG_INFO("Shortcut recovery cache disabled");
-      return;
-    }
-    LOG_INFO("Shortcut recovery cache enabled");
+  shortcut_recovery_t(valhalla::baldr::GraphReader* reader) : enabled(reader != nullptr) {
+    LOG_INFO(enabled ? "Shortcut recovery cache enabled" : "Shortcut recovery cache disabled");
+  }
 
-    // completely skip the levels that dont have shortcuts
-    for (const auto& level : valhalla::baldr::TileHierarchy::levels()) {
-      // we dont get shortcuts on level 2 and up
-      if (level.level > 1)
+  /**
+   * Recovers all the shortcuts of the tile as well as their opposing edges
+   * @param reader   The graphreader for graph data access
+   * @param tile_id  The tile whose shortcuts to recover
+   * @return the edges superseded by each of the shortcuts
+   */
+  using recovered_t = std::pair<valhalla::baldr::GraphId, std::vector<valhalla::baldr::GraphId>>;
+  std::vector<recovered_t> recover_tile(valhalla::baldr::GraphReader& reader,
+                                        const valhalla::baldr::GraphId& tile_id) const {
+    std::vector<recovered_t> recovered;
+    auto tile = reader.GetGraphTile(tile_id);
+    if (!tile)
+      return recovered;
+    // for each edge in the tile
+    for (const auto& edge : tile->GetDirectedEdges()) {
+      // skip non-shortcuts
+      if (!edge.shortcut())
         continue;
-      // for each tile
-      for (auto tile_id : reader->GetTileSet(level.level)) {
-        // cull cache if we are over allocated
-        if (reader->OverCommitted())
-          reader->Trim();
-        // this shouldnt fail but garbled files could cause it
-        auto tile = reader->GetGraphTile(tile_id);
-        assert(tile);
-        // for each edge in the tile
-        for (const auto& edge : tile->GetDirectedEdges()) {
-          // skip non-shortcuts or the shortcut is one we wont use
-          if (!edge.shortcut())
-            continue;
-          auto shortcut_id = tile->header()->graphid();
-          shortcut_id.set_id(&edge - tile->directededge(0));
-          // skip already found opposing edges
-          if (shortcuts.find(shortcut_id) != shortcuts.end())
-            continue;
-          // recover the shortcut and make a copy for opposing direction
-          auto recovered = recover_shortcut(*reader, shortcut_id);
-          decltype(recovered) opp_recovered = recovered;
-          std::reverse_copy(recovered.cbegin(), recovered.cend(), opp_recovered.begin());
-          // save some stats
-          bool failed = recovered.front() == shortcut_id;
-          unrecovered += failed;
-          superseded += failed ? 0 : recovered.size();
-          // cache it even if it failed (no point in trying the same thing twice)
-          shortcuts.emplace(shortcut_id, std::move(recovered));
-
-          // its cheaper to get the opposing without crawling the graph
-          auto opp_tile = tile;
-          auto opp_id = reader->GetOpposingEdgeId(shortcut_id, opp_tile);
-          if (!opp_id.Is_Valid())
-            continue; // dont store edges which arent in our tileset
-
-          for (auto& id : opp_recovered) {
-            id = reader->GetOpposingEdgeId(id, opp_tile);
-            if (!id.Is_Valid()) {
-              opp_recovered = {opp_id};
-              break;
-            }
-          }
-          // stats
-          failed = opp_recovered.front() == opp_id;
-          unrecovered += failed;
-          superseded += failed ? 0 : opp_recovered.size();
-          // cache it even if it failed (no point in trying the same thing twice)
-          shortcuts.emplace(opp_id, std::move(opp_recovered));
+      auto shortcut_id = tile->header()->graphid();
+      shortcut_id.set_id(&edge - tile->directededge(0));
+      // recover the shortcut and make a copy for opposing direction, cache it even if it failed
+      // (no point in trying the same thing twice)
+      auto edges = recover_shortcut(reader, shortcut_id);
+      decltype(edges) opp_edges = edges;
+      std::reverse_copy(edges.cbegin(), edges.cend(), opp_edges.begin());
+      recovered.emplace_back(shortcut_id, std::move(edges));
+
+      // its cheaper to get the opposing without crawling the graph
+      auto opp_tile = tile;
+      auto opp_id = reader.GetOpposingEdgeId(shortcut_id, opp_tile);
+      if (!opp_id.Is_Valid())
+        continue; // dont store edges which arent in our tileset
+
+      for (auto& id : opp_edges) {
+        id = reader.GetOpposingEdgeId(id, opp_tile);
+        if (!id.Is_Valid()) {
+          opp_edges = {opp_id};
+          break;
         }
       }
+      recovered.emplace_back(opp_id, std::move(opp_edges));
     }
-
-    LOG_INFO(std::to_string(shortcuts.size()) + " shortcuts recovered as " +
-             std::to_string(superseded) + " superseded edges. " + std::to_string(unrecovered) +
-             " shortcuts could not be recovered.");
+    return recovered;
   }
 
   /**
@@ -194,19 +176,20 @@ protected:
     return edges;
   }
 
-  // a place to cache the recovered shortcuts
-  std::unordered_map<uint64_t, std::vector<valhalla::baldr::GraphId>> shortcuts;
-  // a place to keep some stats about the recovery
-  size_t unrecovered;
-  size_t superseded;
+  // whether to cache the recovered shortcuts at all
+  const bool enabled;
+  // a place to cache the recovered shortcuts and the tiles whose shortcuts are all in there
+  mutable std::mutex lock;
+  mutable std::unordered_map<uint64_t, std::vector<valhalla::baldr::GraphId>> shortcuts;
+  mutable std::unordered_set<uint32_t> tiles;
 
 public:
   /**
-   * returns a static instance of the cache after prefilling it. if on the first call,
-   * the reader is nullptr then the cache will not be filled and recovery will be on the fly
+   * returns a static instance of the cache. if on the first call the reader is nullptr then the
+   * cache will not be used and recovery will be on the fly
    *
-   * @param reader       the reader used to initialize the cache the first time
-   * @return a filled cache mapping shortcuts to superceeded edges
+   * @param reader       the reader that decides whether to cache the first time
+   * @return a cache mapping shortcuts to superceeded edges
    */
   static shortcut_recovery_t& get_instance(valhalla::baldr::GraphReader* reader = nullptr) {
     static shortcut_recovery_t cache{reader};
@@ -214,20 +197,42 @@ public:
   }
 
   /**
-   * returns the list of graphids of the edges superceded by the provided shortcut. saddly because we
-   * may have to recover the shortcut on the fly we cannot return const reference here
+   * returns the list of graphids of the edges superceded by the provided shortcut. the first time a
+   * shortcut of a tile is asked for all the shortcuts of the tile are recovered into the cache.
+   * saddly because we may have to recover the shortcut on the fly we cannot return const
+   * reference here
    *
    * @param shortcut_id   the shortcuts edge id
+   * @param reader        the reader to recover the shortcut with if its not in the cache
    * @return the list of superceded edges
    */
   std::vector<valhalla::baldr::GraphId> get(const valhalla::baldr::GraphId& shortcut_id,
                                             valhalla::baldr::GraphReader& reader) const {
-    // in the case that we didnt fill the cache we fallback to recovering on the fly
-    auto itr = shortcuts.find(shortcut_id);
-    if (itr == shortcuts.cend())
+    // in the case that we dont cache we always recover on the fly
+    if (!enabled)
       return recover_shortcut(reader, shortcut_id);
-    // it was in cache
-    return itr->second;
+
+    // it was in cache or it wont ever be
+    const auto tile_id = shortcut_id.Tile_Base();
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      auto itr = shortcuts.find(shortcut_id);
+      if (itr != shortcuts.cend())
+        return itr->second;
+      if (tiles.count(tile_id))
+        return recover_shortcut(reader, shortcut_id);
+    }
+
+    // recover the whole tile without holding anyone else up and keep it for next time
+    auto recovered = recover_tile(reader, tile_id);
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto& shortcut : recovered)
+      shortcuts.emplace(shortcut.first, std::move(shortcut.second));
+    tiles.insert(tile_id);
+    auto itr = shortcuts.find(shortcut_id);
+    if (itr != shortcuts.cend())
+      return itr->second;
+    return recover_shortcut(reader, shortcut_id);
   }
 };
 
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <typeinfo>
 
 #include "baldr/streetname.h"
 
@@ -6,13 +7,21 @@ namespace valhalla {
 namespace baldr {
 
 StreetName::StreetName(const std::string& value, const bool is_route_number)
-    : value_(value), is_route_number_(is_route_number) {
+    : value_(std::make_shared<const std::string>(value)), is_route_number_(is_route_number) {
+}
+
+StreetName::StreetName(std::shared_ptr<const std::string> value, const bool is_route_number)
+    : value_(std::move(value)), is_route_number_(is_route_number) {
 }
 
 StreetName::~StreetName() {
 }
 
 const std::string& StreetName::value() const {
+  return *value_;
+}
+
+const std::shared_ptr<const std::string>& StreetName::shared_value() const {
   return value_;
 }
 
@@ -21,17 +30,19 @@ bool StreetName::is_route_number() const {
 }
 
 bool StreetName::operator==(const StreetName& rhs) const {
-  return ((value_ == rhs.value_) && (is_route_number_ == rhs.is_route_number_));
+  // interned names are the same string only when they share it
+  return ((value_ == rhs.value_ || *value_ == *rhs.value_) &&
+          (is_route_number_ == rhs.is_route_number_));
 }
 
 bool StreetName::StartsWith(const std::string& prefix) const {
   size_t n = prefix.size();
-  return (value_.size() < n) ? false : prefix == value_.substr(0, n);
+  return (value_->size() < n) ? false : value_->compare(0, n, prefix) == 0;
 }
 
 bool StreetName::EndsWith(const std::string& suffix) const {
   size_t n = suffix.size();
-  return (value_.size() < n) ? false : suffix == value_.substr(value_.size() - n);
+  return (value_->size() < n) ? false : value_->compare(value_->size() - n, n, suffix) == 0;
 }
 
 std::string StreetName::GetPreDir() const {
@@ -50,12 +61,24 @@ std::string StreetName::GetBaseName() const {
   std::string pre_dir = GetPreDir();
   std::string post_dir = GetPostDir();
 
-  return value_.substr(pre_dir.size(), (value_.size() - pre_dir.size() - post_dir.size()));
+  return value_->substr(pre_dir.size(), (value_->size() - pre_dir.size() - post_dir.size()));
 }
 
 bool StreetName::HasSameBaseName(const StreetName& rhs) const {
+  // the same string of the same kind of street name has the same base name
+  if (value_ == rhs.value_ && typeid(*this) == typeid(rhs)) {
+    return true;
+  }
   return (GetBaseName() == rhs.GetBaseName());
 }
 
+std::shared_ptr<const std::string> StreetNameInterner::Intern(const std::string& value) {
+  auto found = values_.find(value);
+  if (found == values_.end()) {
+    found = values_.emplace(value, std::make_shared<const std::string>(value)).first;
+  }
+  return found->second;
+}
+
 } // namespace baldr
 } // namespace valhalla
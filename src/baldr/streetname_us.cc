@@ -1,4 +1,5 @@
 #include <iostream>
+#include <typeinfo>
 
 #include "baldr/streetname.h"
 #include "baldr/streetname_us.h"
@@ -19,6 +20,10 @@ StreetNameUs::StreetNameUs(const std::string& value, const bool is_route_number)
     : StreetName(value, is_route_number) {
 }
 
+StreetNameUs::StreetNameUs(std::shared_ptr<const std::string> value, const bool is_route_number)
+    : StreetName(std::move(value), is_route_number) {
+}
+
 std::string StreetNameUs::GetPreDir() const {
   for (const auto& pre_dir : StreetNameUs::pre_dirs_) {
     if (StartsWith(pre_dir)) {
@@ -50,10 +55,14 @@ std::string StreetNameUs::GetBaseName() const {
   std::string pre_dir = GetPreDir();
   std::string post_dir = GetPostDir();
 
-  return value_.substr(pre_dir.size(), (value_.size() - pre_dir.size() - post_dir.size()));
+  return value_->substr(pre_dir.size(), (value_->size() - pre_dir.size() - post_dir.size()));
 }
 
 bool StreetNameUs::HasSameBaseName(const StreetName& rhs) const {
+  // the same string of the same kind of street name has the same base name
+  if (value_ == rhs.shared_value() && typeid(*this) == typeid(rhs)) {
+    return true;
+  }
   return (GetBaseName() == rhs.GetBaseName());
 }
 
@@ -12,9 +12,14 @@ namespace baldr {
 StreetNames::StreetNames() : std::list<std::unique_ptr<StreetName>>() {
 }
 
-StreetNames::StreetNames(const std::vector<std::pair<std::string, bool>>& names) {
+StreetNames::StreetNames(const std::vector<std::pair<std::string, bool>>& names,
+                         StreetNameInterner* interner) {
   for (auto& name : names) {
-    this->emplace_back(std::make_unique<StreetName>(name.first, name.second));
+    if (interner) {
+      this->emplace_back(std::make_unique<StreetName>(interner->Intern(name.first), name.second));
+    } else {
+      this->emplace_back(std::make_unique<StreetName>(name.first, name.second));
+    }
   }
 }
 
@@ -71,7 +76,7 @@ std::unique_ptr<StreetNames> StreetNames::clone() const {
   std::unique_ptr<StreetNames> clone_street_names = std::make_unique<StreetNames>();
   for (const auto& street_name : *this) {
     clone_street_names->emplace_back(
-        std::make_unique<StreetName>(street_name->value(), street_name->is_route_number()));
+        std::make_unique<StreetName>(street_name->shared_value(), street_name->is_route_number()));
   }
 
   return clone_street_names;
@@ -84,7 +89,8 @@ StreetNames::FindCommonStreetNames(const StreetNames& other_street_names) const
     for (const auto& other_street_name : other_street_names) {
       if (*street_name == *other_street_name) {
         common_street_names->emplace_back(
-            std::make_unique<StreetName>(street_name->value(), street_name->is_route_number()));
+            std::make_unique<StreetName>(street_name->shared_value(),
+                                         street_name->is_route_number()));
         break;
       }
     }
@@ -103,15 +109,17 @@ StreetNames::FindCommonBaseNames(const StreetNames& other_street_names) const {
         // thus, 'US 30 West' will be used instead of 'US 30'
         if (!street_name->GetPostCardinalDir().empty()) {
           common_base_names->emplace_back(
-              std::make_unique<StreetName>(street_name->value(), street_name->is_route_number()));
+              std::make_unique<StreetName>(street_name->shared_value(),
+                                           street_name->is_route_number()));
         } else if (!other_street_name->GetPostCardinalDir().empty()) {
           common_base_names->emplace_back(
-              std::make_unique<StreetName>(other_street_name->value(),
+              std::make_unique<StreetName>(other_street_name->shared_value(),
                                            street_name->is_route_number()));
           // Use street_name by default
         } else {
           common_base_names->emplace_back(
-              std::make_unique<StreetName>(street_name->value(), street_name->is_route_number()));
+              std::make_unique<StreetName>(street_name->shared_value(),
+                                           street_name->is_route_number()));
         }
         break;
       }
@@ -126,7 +134,8 @@ std::unique_ptr<StreetNames> StreetNames::GetRouteNumbers() const {
   for (const auto& street_name : *this) {
     if (street_name->is_route_number()) {
       route_numbers->emplace_back(
-          std::make_unique<StreetName>(street_name->value(), street_name->is_route_number()));
+          std::make_unique<StreetName>(street_name->shared_value(),
+                                       street_name->is_route_number()));
     }
   }
 
@@ -138,7 +147,8 @@ std::unique_ptr<StreetNames> StreetNames::GetNonRouteNumbers() const {
   for (const auto& street_name : *this) {
     if (!street_name->is_route_number()) {
       non_route_numbers->emplace_back(
-          std::make_unique<StreetName>(street_name->value(), street_name->is_route_number()));
+          std::make_unique<StreetName>(street_name->shared_value(),
+                                       street_name->is_route_number()));
     }
   }
 
@@ -12,12 +12,13 @@ namespace baldr {
 
 std::unique_ptr<StreetNames>
 StreetNamesFactory::Create(const std::string& country_code,
-                           const std::vector<std::pair<std::string, bool>>& names) {
+                           const std::vector<std::pair<std::string, bool>>& names,
+                           StreetNameInterner* interner) {
   if (country_code == "US") {
-    return std::make_unique<StreetNamesUs>(names);
+    return std::make_unique<StreetNamesUs>(names, interner);
   }
 
-  return std::make_unique<StreetNames>(names);
+  return std::make_unique<StreetNames>(names, interner);
 }
 
 } // namespace baldr
@@ -10,9 +10,14 @@ namespace baldr {
 StreetNamesUs::StreetNamesUs() : StreetNames() {
 }
 
-StreetNamesUs::StreetNamesUs(const std::vector<std::pair<std::string, bool>>& names) {
+StreetNamesUs::StreetNamesUs(const std::vector<std::pair<std::string, bool>>& names,
+                             StreetNameInterner* interner) {
   for (auto& name : names) {
-    this->emplace_back(std::make_unique<StreetNameUs>(name.first, name.second));
+    if (interner) {
+      this->emplace_back(std::make_unique<StreetNameUs>(interner->Intern(name.first), name.second));
+    } else {
+      this->emplace_back(std::make_unique<StreetNameUs>(name.first, name.second));
+    }
   }
 }
 
@@ -23,7 +28,8 @@ std::unique_ptr<StreetNames> StreetNamesUs::clone() const {
   std::unique_ptr<StreetNames> clone_street_names = std::make_unique<StreetNamesUs>();
   for (const auto& street_name : *this) {
     clone_street_names->emplace_back(
-        std::make_unique<StreetNameUs>(street_name->value(), street_name->is_route_number()));
+        std::make_unique<StreetNameUs>(street_name->shared_value(),
+                                       street_name->is_route_number()));
   }
 
   return clone_street_names;
@@ -36,7 +42,8 @@ StreetNamesUs::FindCommonStreetNames(const StreetNames& other_street_names) cons
     for (const auto& other_street_name : other_street_names) {
       if (*street_name == *other_street_name) {
         common_street_names->emplace_back(
-            std::make_unique<StreetNameUs>(street_name->value(), street_name->is_route_number()));
+            std::make_unique<StreetNameUs>(street_name->shared_value(),
+                                           street_name->is_route_number()));
         break;
       }
     }
@@ -55,15 +62,17 @@ StreetNamesUs::FindCommonBaseNames(const StreetNames& other_street_names) const
         // thus, 'US 30 West' will be used instead of 'US 30'
         if (!street_name->GetPostCardinalDir().empty()) {
           common_base_names->emplace_back(
-              std::make_unique<StreetNameUs>(street_name->value(), street_name->is_route_number()));
+              std::make_unique<StreetNameUs>(street_name->shared_value(),
+                                             street_name->is_route_number()));
         } else if (!other_street_name->GetPostCardinalDir().empty()) {
           common_base_names->emplace_back(
-              std::make_unique<StreetNameUs>(other_street_name->value(),
+              std::make_unique<StreetNameUs>(other_street_name->shared_value(),
                                              street_name->is_route_number()));
           // Use street_name by default
         } else {
           common_base_names->emplace_back(
-              std::make_unique<StreetNameUs>(street_name->value(), street_name->is_route_number()));
+              std::make_unique<StreetNameUs>(street_name->shared_value(),
+                                             street_name->is_route_number()));
         }
         break;
       }
@@ -78,7 +87,8 @@ std::unique_ptr<StreetNames> StreetNamesUs::GetRouteNumbers() const {
   for (const auto& street_name : *this) {
     if (street_name->is_route_number()) {
       route_numbers->emplace_back(
-          std::make_unique<StreetNameUs>(street_name->value(), street_name->is_route_number()));
+          std::make_unique<StreetNameUs>(street_name->shared_value(),
+                                         street_name->is_route_number()));
     }
   }
 
@@ -90,7 +100,8 @@ std::unique_ptr<StreetNames> StreetNamesUs::GetNonRouteNumbers() const {
   for (const auto& street_name : *this) {
     if (!street_name->is_route_number()) {
       non_route_numbers->emplace_back(
-          std::make_unique<StreetNameUs>(street_name->value(), street_name->is_route_number()));
+          std::make_unique<StreetNameUs>(street_name->shared_value(),
+                                         street_name->is_route_number()));
     }
   }
 
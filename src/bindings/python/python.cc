@@ -1,27 +1,41 @@
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 #include "baldr/rapidjson_utils.h"
+#include <atomic>
 #include <boost/make_shared.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/optional.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/shared_ptr.hpp>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "baldr/graphreader.h"
 #include "baldr/rapidjson_utils.h"
 #include "midgard/logging.h"
 #include "midgard/util.h"
+#include "proto_conversions.h"
 #include "tyr/actor.h"
+#include "worker.h"
 
 namespace {
 
 // statically set the config file and configure logging, throw if you never configured
 // configuring multiple times is wasteful/ineffectual but not harmful
-// TODO: make this threadsafe just in case its abused
 const boost::property_tree::ptree&
 configure(const boost::optional<std::string>& config = boost::none) {
   static boost::optional<boost::property_tree::ptree> pt;
+  static std::mutex lock;
+  std::lock_guard<std::mutex> guard(lock);
   // if we haven't already loaded one
   if (config && !pt) {
     try {
@@ -51,77 +65,307 @@ configure(const boost::optional<std::string>& config = boost::none) {
 void py_configure(const std::string& config_file) {
   configure(config_file);
 }
+
+// answers a request of the given action with the actor, the action is named like the http paths
+std::string act(valhalla::tyr::actor_t& actor, const std::string& action, const std::string& request) {
+  valhalla::Options::Action a;
+  if (!valhalla::Options_Action_Enum_Parse(action, &a)) {
+    throw std::runtime_error("Unknown action: " + action);
+  }
+  switch (a) {
+    case valhalla::Options::route:
+      return actor.route(request);
+    case valhalla::Options::locate:
+      return actor.locate(request);
+    case valhalla::Options::sources_to_targets:
+      return actor.matrix(request);
+    case valhalla::Options::optimized_route:
+      return actor.optimized_route(request);
+    case valhalla::Options::isochrone:
+      return actor.isochrone(request);
+    case valhalla::Options::trace_route:
+      return actor.trace_route(request);
+    case valhalla::Options::trace_attributes:
+      return actor.trace_attributes(request);
+    case valhalla::Options::height:
+      return actor.height(request);
+    case valhalla::Options::transit_available:
+      return actor.transit_available(request);
+    case valhalla::Options::expansion:
+      return actor.expansion(request);
+    case valhalla::Options::centroid:
+      return actor.centroid(request);
+    case valhalla::Options::status:
+      return actor.status(request);
+    default:
+      throw std::runtime_error("Unknown action: " + action);
+  }
+}
+
 } // namespace
 
 namespace py = pybind11;
 
+namespace {
+
+// answers a matrix request with its times and distances as numpy arrays of sources by targets.
+// the request is answered in the pbf format whose packed repeated fields the arrays are views of,
+// the arrays keep the response alive so nothing is copied once it is parsed nor made into json
+py::dict matrix_arrays(const std::function<std::string(const std::string&)>& act,
+                       const std::string& request_str) {
+  rapidjson::Document request;
+  request.Parse(request_str.c_str());
+  if (request.HasParseError() || !request.IsObject()) {
+    throw std::runtime_error("Failed to parse the matrix request json");
+  }
+  request.RemoveMember("format");
+  request.AddMember("format", "pbf", request.GetAllocator());
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  request.Accept(writer);
+
+  auto response = std::make_unique<valhalla::Api>();
+  {
+    py::gil_scoped_release release;
+    if (!response->ParseFromString(act(buffer.GetString()))) {
+      throw std::runtime_error("Failed to parse the matrix response");
+    }
+  }
+
+  const auto& options = response->options();
+  const auto& matrix = response->matrix();
+  const std::vector<py::ssize_t> shape{options.sources_size(), options.targets_size()};
+  const std::vector<py::ssize_t> unreachable_shape{matrix.unreachable_size()};
+  auto* owner = response.release();
+  py::capsule free(owner, [](void* api) { delete static_cast<valhalla::Api*>(api); });
+
+  py::dict arrays;
+  arrays["times"] = py::array_t<uint32_t>(shape, matrix.times().data(), free);
+  arrays["distances"] = py::array_t<float>(shape, matrix.distances().data(), free);
+  arrays["unreachable"] =
+      py::array_t<uint32_t>(unreachable_shape, matrix.unreachable().data(), free);
+  arrays["algorithm"] = matrix.algorithm();
+  return arrays;
+}
+
+constexpr char kMatrixArraysDoc[] =
+    "Computes the time and distance between a set of locations and returns them as numpy arrays "
+    "of sources by targets under times and distances, with the flat indices of the pairs no route "
+    "was found for, whose time and distance are 0, under unreachable.";
+
+} // namespace
+
+// an actor only works on one request at a time so the calls to it wait for each other, though
+// without holding the gil so that the other actors can work in the meantime
 struct simplified_actor_t : public valhalla::tyr::actor_t {
   simplified_actor_t(const boost::property_tree::ptree& config)
       : valhalla::tyr::actor_t::actor_t(config, true) {
   }
 
+  std::string act(const std::string& action, const std::string& request_str) {
+    std::lock_guard<std::mutex> guard(lock);
+    return ::act(*this, action, request_str);
+  }
+
   std::string route(const std::string& request_str) {
-    return valhalla::tyr::actor_t::route(request_str, nullptr, nullptr);
+    return act("route", request_str);
   };
   std::string locate(const std::string& request_str) {
-    return valhalla::tyr::actor_t::locate(request_str, nullptr, nullptr);
+    return act("locate", request_str);
   };
   std::string optimized_route(const std::string& request_str) {
-    return valhalla::tyr::actor_t::optimized_route(request_str, nullptr, nullptr);
+    return act("optimized_route", request_str);
   };
   std::string matrix(const std::string& request_str) {
-    return valhalla::tyr::actor_t::matrix(request_str, nullptr, nullptr);
+    return act("sources_to_targets", request_str);
   };
   std::string isochrone(const std::string& request_str) {
-    return valhalla::tyr::actor_t::isochrone(request_str, nullptr, nullptr);
+    return act("isochrone", request_str);
   };
   std::string trace_route(const std::string& request_str) {
-    return valhalla::tyr::actor_t::trace_route(request_str, nullptr, nullptr);
+    return act("trace_route", request_str);
   };
   std::string trace_attributes(const std::string& request_str) {
-    return valhalla::tyr::actor_t::trace_attributes(request_str, nullptr, nullptr);
+    return act("trace_attributes", request_str);
   };
   std::string height(const std::string& request_str) {
-    return valhalla::tyr::actor_t::height(request_str, nullptr, nullptr);
+    return act("height", request_str);
   };
   std::string transit_available(const std::string& request_str) {
-    return valhalla::tyr::actor_t::transit_available(request_str, nullptr, nullptr);
+    return act("transit_available", request_str);
   };
   std::string expansion(const std::string& request_str) {
-    return valhalla::tyr::actor_t::expansion(request_str, nullptr, nullptr);
+    return act("expansion", request_str);
   };
   std::string centroid(const std::string& request_str) {
-    return valhalla::tyr::actor_t::centroid(request_str, nullptr, nullptr);
+    return act("centroid", request_str);
   };
+
+  std::mutex lock;
+};
+
+// a pool of actors which answers as many requests at once as it has actors. with
+// mjolnir.thread_safe_reader the actors share one graph reader, otherwise each has its own
+struct actor_pool_t {
+  actor_pool_t(const boost::property_tree::ptree& config, size_t size)
+      : reader(valhalla::shared_graph_reader(config)) {
+    size = size ? size : std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < size; ++i) {
+      actors.emplace_back(reader ? new valhalla::tyr::actor_t(config, *reader, true)
+                                 : new valhalla::tyr::actor_t(config, true));
+      idle.push_back(actors.back().get());
+    }
+  }
+
+  // waits for an idle actor to answer the request with
+  std::string act(const std::string& action, const std::string& request_str) {
+    valhalla::tyr::actor_t* actor;
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      freed.wait(guard, [this]() { return !idle.empty(); });
+      actor = idle.back();
+      idle.pop_back();
+    }
+    struct give_back_t {
+      actor_pool_t& pool;
+      valhalla::tyr::actor_t* actor;
+      ~give_back_t() {
+        {
+          std::lock_guard<std::mutex> guard(pool.lock);
+          pool.idle.push_back(actor);
+        }
+        pool.freed.notify_one();
+      }
+    } give_back{*this, actor};
+    return ::act(*actor, action, request_str);
+  }
+
+  // answers all of the requests with as many of the actors as there are requests, returning the
+  // results in the order of the requests. the first failure is rethrown once all are done
+  std::vector<std::string> batch(const std::string& action,
+                                 const std::vector<std::string>& requests) {
+    std::vector<std::string> results(requests.size());
+    std::atomic<size_t> next{0};
+    std::mutex error_lock;
+    std::exception_ptr error;
+    auto work = [&]() {
+      for (auto i = next++; i < requests.size(); i = next++) {
+        try {
+          results[i] = act(action, requests[i]);
+        } catch (...) {
+          std::lock_guard<std::mutex> guard(error_lock);
+          if (!error) {
+            error = std::current_exception();
+          }
+        }
+      }
+    };
+
+    // the calling thread is one of the threads doing the work
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min(actors.size(), requests.size()); ++i) {
+      threads.emplace_back(work);
+    }
+    work();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    return results;
+  }
+
+  std::shared_ptr<valhalla::baldr::GraphReader> reader;
+  std::vector<std::unique_ptr<valhalla::tyr::actor_t>> actors;
+  std::vector<valhalla::tyr::actor_t*> idle;
+  std::mutex lock;
+  std::condition_variable freed;
 };
 
 PYBIND11_MODULE(python_valhalla, m) {
   m.def("Configure", py_configure);
 
+  // the requests are answered without the gil so that other python threads can run meanwhile
+  using release_gil = py::call_guard<py::gil_scoped_release>;
+
   py::class_<simplified_actor_t, std::shared_ptr<simplified_actor_t>>(m, "Actor")
       .def(py::init<>([]() { return std::make_shared<simplified_actor_t>(configure()); }))
-      .def("Route", &simplified_actor_t::route, "Calculates a route.")
-      .def("Locate", &simplified_actor_t::locate, "Provides information about nodes and edges.")
+      .def("Route", &simplified_actor_t::route, "Calculates a route.", release_gil())
+      .def("Locate", &simplified_actor_t::locate, "Provides information about nodes and edges.",
+           release_gil())
       .def("OptimizedRoute", &simplified_actor_t::optimized_route,
-           "Optimizes the order of a set of waypoints by time.")
+           "Optimizes the order of a set of waypoints by time.", release_gil())
       .def(
           "Matrix", &simplified_actor_t::matrix,
-          "Computes the time and distance between a set of locations and returns them as a matrix table.")
-      .def("Isochrone", &simplified_actor_t::isochrone, "Calculates isochrones and isodistances.")
+          "Computes the time and distance between a set of locations and returns them as a matrix table.",
+          release_gil())
+      .def(
+          "MatrixArrays",
+          [](simplified_actor_t& actor, const std::string& request) {
+            return matrix_arrays([&actor](const std::string& r) { return actor.matrix(r); },
+                                 request);
+          },
+          kMatrixArraysDoc)
+      .def("Isochrone", &simplified_actor_t::isochrone, "Calculates isochrones and isodistances.",
+           release_gil())
       .def("TraceRoute", &simplified_actor_t::trace_route,
-           "Map-matching for a set of input locations, e.g. from a GPS.")
+           "Map-matching for a set of input locations, e.g. from a GPS.", release_gil())
       .def(
           "TraceAttributes", &simplified_actor_t::trace_attributes,
-          "Returns detailed attribution along each portion of a route calculated from a set of input locations, e.g. from a GPS trace.")
+          "Returns detailed attribution along each portion of a route calculated from a set of input locations, e.g. from a GPS trace.",
+          release_gil())
       .def("Height", &simplified_actor_t::height,
-           "Provides elevation data for a set of input geometries.")
+           "Provides elevation data for a set of input geometries.", release_gil())
       .def(
           "TransitAvailable", &simplified_actor_t::transit_available,
-          "Lookup if transit stops are available in a defined radius around a set of input locations.")
+          "Lookup if transit stops are available in a defined radius around a set of input locations.",
+          release_gil())
       .def(
           "Expansion", &simplified_actor_t::expansion,
-          "Returns all road segments which were touched by the routing algorithm during the graph traversal.")
+          "Returns all road segments which were touched by the routing algorithm during the graph traversal.",
+          release_gil())
       .def(
           "Centroid", &simplified_actor_t::centroid,
-          "Returns routes from all the input locations to the minimum cost meeting point of those paths.");
+          "Returns routes from all the input locations to the minimum cost meeting point of those paths.",
+          release_gil());
+
+  py::class_<actor_pool_t, std::shared_ptr<actor_pool_t>>(m, "ActorPool")
+      .def(py::init<>([](size_t size) { return std::make_shared<actor_pool_t>(configure(), size); }),
+           py::arg("size") = 0,
+           "Makes size actors, one per core if 0. With mjolnir.thread_safe_reader they share one "
+           "graph reader.")
+      .def("Act", &actor_pool_t::act, py::arg("action"), py::arg("request"),
+           "Answers the request of the action, named like its http path, on the next idle actor.",
+           release_gil())
+      .def("Batch", &actor_pool_t::batch, py::arg("action"), py::arg("requests"),
+           "Answers all the requests of the action, named like its http path, on as many actors as "
+           "there are and returns their results in order.",
+           release_gil())
+      .def(
+          "Route",
+          [](actor_pool_t& pool, const std::string& request) { return pool.act("route", request); },
+          "Calculates a route.", release_gil())
+      .def(
+          "Matrix",
+          [](actor_pool_t& pool, const std::string& request) {
+            return pool.act("sources_to_targets", request);
+          },
+          "Computes the time and distance between a set of locations and returns them as a matrix table.",
+          release_gil())
+      .def(
+          "MatrixArrays",
+          [](actor_pool_t& pool, const std::string& request) {
+            return matrix_arrays(
+                [&pool](const std::string& r) { return pool.act("sources_to_targets", r); },
+                request);
+          },
+          kMatrixArraysDoc)
+      .def(
+          "TraceAttributes",
+          [](actor_pool_t& pool, const std::string& request) {
+            return pool.act("trace_attributes", request);
+          },
+          "Returns detailed attribution along each portion of a route calculated from a set of input locations, e.g. from a GPS trace.",
+          release_gil());
 }
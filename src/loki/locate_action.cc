@@ -16,14 +16,21 @@ void loki_worker_t::init_locate(Api& request) {
   parse_costing(request, true);
 }
 
-std::string loki_worker_t::locate(Api& request) {
+std::string loki_worker_t::locate(Api& request,
+                                  const std::function<void(const std::string&)>* write) {
   // time this whole method and save that statistic
   auto _ = measure_scope_time(request, "loki_worker_t::locate");
 
   // correlate the various locations to the underlying graph
   init_locate(request);
   auto locations = PathLocation::fromPBF(request.options().locations());
-  auto projections = loki::Search(locations, *reader, costing);
+  auto projections = search(locations, request);
+  if (write) {
+    for (const auto& location : locations) {
+      (*write)(tyr::serializeLocation(request, location, projections, *reader) + "\n");
+    }
+    return "";
+  }
   return tyr::serializeLocate(request, locations, projections, *reader);
 }
 
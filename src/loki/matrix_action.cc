@@ -2,6 +2,7 @@
 #include "loki/worker.h"
 
 #include <unordered_map>
+#include <unordered_set>
 
 #include "baldr/datetime.h"
 #include "baldr/rapidjson_utils.h"
@@ -15,6 +16,31 @@ using namespace valhalla::baldr;
 using namespace valhalla::loki;
 
 namespace {
+// Whether any source shares a component of the graph with any target so that at least one cell
+// of the matrix can have a route. The locations whose components are not known might be
+// connected to anything.
+bool connected(const std::vector<std::vector<uint32_t>>& sources,
+               const std::vector<std::vector<uint32_t>>& targets) {
+  std::unordered_set<uint32_t> target_components;
+  for (const auto& target : targets) {
+    if (target.empty()) {
+      return true;
+    }
+    target_components.insert(target.cbegin(), target.cend());
+  }
+  for (const auto& source : sources) {
+    if (source.empty()) {
+      return true;
+    }
+    for (const auto component : source) {
+      if (target_components.count(component)) {
+        return true;
+      }
+    }
+  }
+  return sources.empty() || targets.empty();
+}
+
 midgard::PointLL to_ll(const valhalla::Location& l) {
   return midgard::PointLL{l.ll().lng(), l.ll().lat()};
 }
@@ -115,8 +141,9 @@ void loki_worker_t::matrix(Api& request) {
 
   // correlate the various locations to the underlying graph
   std::unordered_map<size_t, size_t> color_counts;
+  std::vector<std::vector<uint32_t>> source_components, target_components;
   try {
-    const auto searched = loki::Search(sources_targets, *reader, costing);
+    const auto searched = search(sources_targets, request);
     for (size_t i = 0; i < sources_targets.size(); ++i) {
       const auto& l = sources_targets[i];
       const auto& projection = searched.at(l);
@@ -126,6 +153,8 @@ void loki_worker_t::matrix(Api& request) {
                               : options.mutable_targets(i -
                                                         static_cast<size_t>(options.sources_size())),
                           *reader);
+      (i < static_cast<size_t>(options.sources_size()) ? source_components : target_components)
+          .push_back(components(projection));
       // TODO: get transit level for transit costing
       // TODO: if transit send a non zero radius
       if (!connectivity_map) {
@@ -143,6 +172,11 @@ void loki_worker_t::matrix(Api& request) {
     }
   } catch (const std::exception&) { throw valhalla_exception_t{171}; }
 
+  // no cell can have a route if the sources and targets are in different components of the graph
+  if (!connected(source_components, target_components)) {
+    throw valhalla_exception_t{170};
+  }
+
   // are all the locations in the same color regions
   if (!connectivity_map) {
     return;
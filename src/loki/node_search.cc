@@ -3,7 +3,9 @@
 #include "midgard/logging.h"
 #include "midgard/pointll.h"
 #include "midgard/tiles.h"
+#include <algorithm>
 #include <cmath>
+#include <tuple>
 
 namespace vm = valhalla::midgard;
 namespace vb = valhalla::baldr;
@@ -359,6 +361,87 @@ private:
   std::vector<vb::GraphId> m_backfill_nodes;
 };
 
+// a bin of the lowest level and a box of a bulk query which intersects it
+struct bin_box_t {
+  int32_t tile;
+  uint16_t bin;
+  uint32_t box;
+
+  bool operator<(const bin_box_t& other) const {
+    return std::tie(tile, bin, box) < std::tie(other.tile, other.bin, other.box);
+  }
+
+  bool same_bin(const bin_box_t& other) const {
+    return tile == other.tile && bin == other.bin;
+  }
+};
+
+// the global column and row of the bin containing the point, the same arithmetic as
+// Tiles::Intersect so a point in a box always falls into one of the bins of the box
+std::pair<int32_t, int32_t> bin_pixel(const vm::Tiles<vm::PointLL>& tiles, const vm::PointLL& pt) {
+  const auto& bounds = tiles.TileBounds();
+  const int32_t x_pixels = tiles.ncolumns() * tiles.nsubdivisions();
+  const int32_t y_pixels = tiles.nrows() * tiles.nsubdivisions();
+  int32_t x = std::floor(((pt.x() - bounds.minx()) * x_pixels) / bounds.Width());
+  int32_t y = std::floor(((pt.y() - bounds.miny()) * y_pixels) / bounds.Height());
+  return {std::min(std::max(x, 0), x_pixels - 1), std::min(std::max(y, 0), y_pixels - 1)};
+}
+
+bin_box_t to_bin(const vm::Tiles<vm::PointLL>& tiles, const int32_t x, const int32_t y) {
+  const int32_t nsubdivisions = tiles.nsubdivisions();
+  return {(y / nsubdivisions) * tiles.ncolumns() + (x / nsubdivisions),
+          static_cast<uint16_t>((y % nsubdivisions) * nsubdivisions + (x % nsubdivisions)), 0};
+}
+
+// all the bins which each box intersects, sorted by tile and bin so that the boxes which share a
+// bin are next to each other. these are the bins of Tiles::Intersect without its maps.
+std::vector<bin_box_t> bins_of_boxes(const std::vector<vm::AABB2<vm::PointLL>>& bboxes,
+                                     const vm::Tiles<vm::PointLL>& tiles) {
+  std::vector<bin_box_t> bins;
+  for (uint32_t i = 0; i < bboxes.size(); ++i) {
+    for (const auto& box : expand_bbox_across_boundaries(bboxes[i], tiles)) {
+      const auto min = bin_pixel(tiles, box.minpt());
+      const auto max = bin_pixel(tiles, box.maxpt());
+      for (auto y = min.second; y <= max.second; ++y) {
+        for (auto x = min.first; x <= max.first; ++x) {
+          bins.push_back(to_bin(tiles, x, y));
+          bins.back().box = i;
+        }
+      }
+    }
+  }
+  // boxes split at the anti-meridian may come back to the same bin
+  std::sort(bins.begin(), bins.end());
+  bins.erase(std::unique(bins.begin(), bins.end(),
+                         [](const bin_box_t& a, const bin_box_t& b) {
+                           return a.same_bin(b) && a.box == b.box;
+                         }),
+             bins.end());
+  return bins;
+}
+
+// sorts the ids of each box, drops the duplicates and flattens them
+valhalla::loki::bbox_results_t to_results(std::vector<std::pair<uint32_t, vb::GraphId>>& found,
+                                          const size_t box_count) {
+  static const sort_by_tile sort_tile;
+  std::sort(found.begin(), found.end(), [](const auto& a, const auto& b) {
+    return a.first < b.first || (a.first == b.first && sort_tile(a.second, b.second));
+  });
+  found.erase(std::unique(found.begin(), found.end()), found.end());
+
+  valhalla::loki::bbox_results_t results;
+  results.offsets.assign(box_count + 1, 0);
+  results.ids.reserve(found.size());
+  for (const auto& entry : found) {
+    ++results.offsets[entry.first + 1];
+    results.ids.push_back(entry.second);
+  }
+  for (size_t i = 1; i < results.offsets.size(); ++i) {
+    results.offsets[i] += results.offsets[i - 1];
+  }
+  return results;
+}
+
 } // anonymous namespace
 
 namespace valhalla {
@@ -474,5 +557,101 @@ std::vector<baldr::GraphId> edges_in_bbox(const vm::AABB2<vm::PointLL>& bbox,
   return edge_ids;
 }
 
+bbox_results_t nodes_in_bboxes(const std::vector<vm::AABB2<vm::PointLL>>& bboxes,
+                               baldr::GraphReader& reader) {
+  const auto& tiles = vb::TileHierarchy::levels().back().tiles;
+  const uint8_t bin_level = vb::TileHierarchy::levels().back().level;
+  const auto bins = bins_of_boxes(bboxes, tiles);
+
+  // collect the nodes of the edges of every bin once, the boxes filter them afterwards
+  std::vector<vb::GraphId> candidates;
+  tile_cache cache(reader);
+  filtered_nodes everywhere(vm::AABB2<vm::PointLL>(-181., -91., 181., 91.), candidates);
+  node_collector collector(cache, everywhere);
+  for (size_t i = 0; i < bins.size(); ++i) {
+    if (i > 0 && bins[i].same_bin(bins[i - 1])) {
+      continue;
+    }
+    auto& tile = cache(vb::GraphId(bins[i].tile, bin_level, 0));
+    if (!tile.exists()) {
+      continue;
+    }
+    for (auto edge_id : tile.tile()->GetBin(bins[i].bin)) {
+      collector.add_edge(edge_id);
+    }
+  }
+  collector.finish();
+  std::sort(candidates.begin(), candidates.end(), sort_by_tile());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+  // put the nodes into the bins they are in, a node inside of a box is in one of its bins
+  struct node_t {
+    bin_box_t bin;
+    vb::GraphId id;
+    vm::PointLL ll;
+  };
+  std::vector<node_t> nodes;
+  nodes.reserve(candidates.size());
+  for (const auto node_id : candidates) {
+    if (cache(node_id).exists()) {
+      const auto ll = cache.node_ll(node_id);
+      const auto pixel = bin_pixel(tiles, ll);
+      nodes.push_back({to_bin(tiles, pixel.first, pixel.second), node_id, ll});
+    }
+  }
+  std::sort(nodes.begin(), nodes.end(),
+            [](const node_t& a, const node_t& b) { return a.bin < b.bin; });
+
+  // walk the nodes and the boxes of the bins side by side
+  std::vector<std::pair<uint32_t, vb::GraphId>> found;
+  auto node = nodes.cbegin();
+  for (size_t i = 0; i < bins.size();) {
+    size_t j = i;
+    while (j < bins.size() && bins[j].same_bin(bins[i])) {
+      ++j;
+    }
+    while (node != nodes.cend() && node->bin < bins[i] && !node->bin.same_bin(bins[i])) {
+      ++node;
+    }
+    for (auto n = node; n != nodes.cend() && n->bin.same_bin(bins[i]); ++n) {
+      for (size_t k = i; k < j; ++k) {
+        if (bboxes[bins[k].box].Contains(n->ll)) {
+          found.emplace_back(bins[k].box, n->id);
+        }
+      }
+    }
+    i = j;
+  }
+  return to_results(found, bboxes.size());
+}
+
+bbox_results_t edges_in_bboxes(const std::vector<vm::AABB2<vm::PointLL>>& bboxes,
+                               baldr::GraphReader& reader) {
+  const auto& tiles = vb::TileHierarchy::levels().back().tiles;
+  const uint8_t bin_level = vb::TileHierarchy::levels().back().level;
+  const auto bins = bins_of_boxes(bboxes, tiles);
+
+  // the bins are sorted by tile so each tile is loaded once and each bin is read once for all of
+  // the boxes which intersect it
+  std::vector<std::pair<uint32_t, vb::GraphId>> found;
+  tile_cache cache(reader);
+  for (size_t i = 0; i < bins.size();) {
+    size_t j = i;
+    while (j < bins.size() && bins[j].same_bin(bins[i])) {
+      ++j;
+    }
+    auto& tile = cache(vb::GraphId(bins[i].tile, bin_level, 0));
+    if (tile.exists()) {
+      for (auto edge_id : tile.tile()->GetBin(bins[i].bin)) {
+        for (size_t k = i; k < j; ++k) {
+          found.emplace_back(bins[k].box, edge_id);
+        }
+      }
+    }
+    i = j;
+  }
+  return to_results(found, bboxes.size());
+}
+
 } // namespace loki
 } // namespace valhalla
@@ -9,6 +9,8 @@
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/worker.h>
 
+#include <robin_hood.h>
+
 namespace bg = boost::geometry;
 namespace vm = valhalla::midgard;
 namespace vb = valhalla::baldr;
@@ -21,6 +23,7 @@ namespace {
 // register a few boost.geometry types
 using line_bg_t = bg::model::linestring<vm::PointLL>;
 using ring_bg_t = std::vector<vm::PointLL>;
+using box_bg_t = bg::model::box<vm::PointLL>;
 using namespace vb::json;
 
 // map of tile for map of bin ids & their ring ids
@@ -28,6 +31,14 @@ using namespace vb::json;
 using bins_collector =
     std::unordered_map<uint32_t, std::unordered_map<unsigned short, std::vector<size_t>>>;
 
+// The bins and the boxes around the shapes are in lat,lng while the rings and shapes are geodesics
+// between their points. Their boxes are kept this much (in degrees) apart from each other so that a
+// geodesic bowing out of a box between its points can't make a box test disagree with the exact one
+constexpr double kBoxMargin = 1e-4;
+
+// How a bin relates to a ring, only the edges of boundary bins need the exact geometry
+enum class BinMask : uint8_t { kOutside, kInside, kBoundary };
+
 static const auto Haversine = [] {
   return bg::strategy::distance::haversine<float>(vm::kRadEarthMeters);
 };
@@ -42,9 +53,70 @@ ring_bg_t PBFToRing(const valhalla::Options::Ring& ring_pbf) {
   return new_ring;
 }
 
+// the box around the points of a shape, rings get the geodesic envelope
+box_bg_t shape_box(const std::vector<vm::PointLL>& shape) {
+  box_bg_t box{{180., 90.}, {-180., -90.}};
+  for (const auto& p : shape) {
+    box.min_corner() = {std::min(box.min_corner().lng(), p.lng()),
+                        std::min(box.min_corner().lat(), p.lat())};
+    box.max_corner() = {std::max(box.max_corner().lng(), p.lng()),
+                        std::max(box.max_corner().lat(), p.lat())};
+  }
+  return box;
+}
+
+// whether box a is inside of box b shrunk by the margin
+bool within(const box_bg_t& a, const box_bg_t& b) {
+  return a.min_corner().lng() >= b.min_corner().lng() + kBoxMargin &&
+         a.min_corner().lat() >= b.min_corner().lat() + kBoxMargin &&
+         a.max_corner().lng() <= b.max_corner().lng() - kBoxMargin &&
+         a.max_corner().lat() <= b.max_corner().lat() - kBoxMargin;
+}
+
+// whether the boxes are further apart than the margin
+bool disjoint(const box_bg_t& a, const box_bg_t& b) {
+  return a.max_corner().lng() + kBoxMargin < b.min_corner().lng() ||
+         b.max_corner().lng() + kBoxMargin < a.min_corner().lng() ||
+         a.max_corner().lat() + kBoxMargin < b.min_corner().lat() ||
+         b.max_corner().lat() + kBoxMargin < a.min_corner().lat();
+}
+
+// the box of a bin of a tile of the lowest level
+box_bg_t bin_box(const vm::Tiles<vm::PointLL>& tiles, const int32_t tile_id, const uint16_t bin) {
+  const auto base = tiles.Base(tile_id);
+  const auto size = tiles.SubdivisionSize();
+  const auto col = bin % tiles.nsubdivisions();
+  const auto row = bin / tiles.nsubdivisions();
+  vm::PointLL min{base.lng() + col * size, base.lat() + row * size};
+  return {min, {min.lng() + size, min.lat() + size}};
+}
+
+/**
+ * Classifies a bin against a ring, a bin which is completely inside or outside of the ring decides
+ * for all of the edges which stay inside of it without looking at their shapes.
+ */
+BinMask classify(const box_bg_t& bin, const ring_bg_t& ring, const box_bg_t& ring_box) {
+  if (disjoint(bin, ring_box)) {
+    return BinMask::kOutside;
+  }
+  ring_bg_t bin_ring{bin.min_corner(),
+                     {bin.min_corner().lng(), bin.max_corner().lat()},
+                     bin.max_corner(),
+                     {bin.max_corner().lng(), bin.min_corner().lat()},
+                     bin.min_corner()};
+  bg::correct(bin_ring);
+  if (bg::within(bin_ring, ring)) {
+    return BinMask::kInside;
+  }
+  if (bg::disjoint(bin_ring, ring)) {
+    return BinMask::kOutside;
+  }
+  return BinMask::kBoundary;
+}
+
 #ifdef LOGGING_LEVEL_TRACE
 // serializes an edge to geojson
-std::string to_geojson(const std::unordered_set<vb::GraphId>& edge_ids, vb::GraphReader& reader) {
+std::string to_geojson(const std::vector<vb::GraphId>& edge_ids, vb::GraphReader& reader) {
   auto features = array({});
   for (const auto& edge_id : edge_ids) {
     auto tile = reader.GetGraphTile(edge_id);
@@ -80,7 +152,7 @@ std::string to_geojson(const std::unordered_set<vb::GraphId>& edge_ids, vb::Grap
 namespace valhalla {
 namespace loki {
 
-std::unordered_set<vb::GraphId>
+std::vector<vb::GraphId>
 edges_in_rings(const google::protobuf::RepeatedPtrField<valhalla::Options_Ring>& rings_pbf,
                baldr::GraphReader& reader,
                const std::shared_ptr<sif::DynamicCost>& costing,
@@ -89,10 +161,13 @@ edges_in_rings(const google::protobuf::RepeatedPtrField<valhalla::Options_Ring>&
   // convert to bg object and check length restriction
   double rings_length = 0;
   std::vector<ring_bg_t> rings_bg;
+  std::vector<box_bg_t> ring_boxes;
   for (const auto& ring_pbf : rings_pbf) {
     rings_bg.push_back(PBFToRing(ring_pbf));
-    const ring_bg_t ring_bg = rings_bg.back();
+    const ring_bg_t& ring_bg = rings_bg.back();
     rings_length += bg::perimeter(ring_bg, Haversine());
+    ring_boxes.emplace_back();
+    bg::envelope(ring_bg, ring_boxes.back());
   }
   if (rings_length > max_length) {
     throw valhalla_exception_t(167, std::to_string(max_length));
@@ -104,7 +179,7 @@ edges_in_rings(const google::protobuf::RepeatedPtrField<valhalla::Options_Ring>&
 
   // keep track which tile's bins intersect which rings
   bins_collector bins_intersected;
-  std::unordered_set<vb::GraphId> avoid_edge_ids;
+  robin_hood::unordered_flat_set<vb::GraphId, vb::GraphIdHasher> avoid_edge_ids;
 
   // first pull out all *unique* bins which intersect the rings
   for (size_t ring_idx = 0; ring_idx < rings_bg.size(); ring_idx++) {
@@ -116,12 +191,22 @@ edges_in_rings(const google::protobuf::RepeatedPtrField<valhalla::Options_Ring>&
       }
     }
   }
+  std::vector<BinMask> masks;
+  line_bg_t line;
   for (const auto& intersection : bins_intersected) {
     auto tile = reader.GetGraphTile({intersection.first, bin_level, 0});
     if (!tile) {
       continue;
     }
     for (const auto& bin : intersection.second) {
+      // the bins crossed by a ring are mostly on its boundary but the ones which it just grazes
+      // can still be decided for most of their edges at once
+      const auto box = bin_box(tiles, intersection.first, bin.first);
+      masks.clear();
+      for (const auto& ring_loc : bin.second) {
+        masks.push_back(classify(box, rings_bg[ring_loc], ring_boxes[ring_loc]));
+      }
+
       // tile will be mutated most likely in the loop
       reader.GetGraphTile({intersection.first, bin_level, 0}, tile);
       for (const auto& edge_id : tile->GetBin(bin.first)) {
@@ -149,12 +234,20 @@ edges_in_rings(const google::protobuf::RepeatedPtrField<valhalla::Options_Ring>&
         // TODO: some logic to set percent_along for origin/destination edges
         // careful: polygon can intersect a single edge multiple times
         auto edge_info = tile->edgeinfo(edge);
+        const auto shape = edge_info.shape();
+        const auto edge_box = shape_box(shape);
+        const bool in_bin = within(edge_box, box);
         bool intersects = false;
-        for (const auto& ring_loc : bin.second) {
-          intersects = bg::intersects(rings_bg[ring_loc],
-                                      line_bg_t(edge_info.shape().begin(), edge_info.shape().end()));
-          if (intersects) {
-            break;
+        line.clear();
+        for (size_t i = 0; i < bin.second.size() && !intersects; ++i) {
+          const auto ring_loc = bin.second[i];
+          if (in_bin && masks[i] != BinMask::kBoundary) {
+            intersects = masks[i] == BinMask::kInside;
+          } else if (!disjoint(edge_box, ring_boxes[ring_loc])) {
+            if (line.empty()) {
+              line.assign(shape.begin(), shape.end());
+            }
+            intersects = bg::intersects(rings_bg[ring_loc], line);
           }
         }
         if (intersects) {
@@ -166,14 +259,18 @@ edges_in_rings(const google::protobuf::RepeatedPtrField<valhalla::Options_Ring>&
     }
   }
 
+  // in order so the same rings always put the same exclude_edges into the request
+  std::vector<vb::GraphId> sorted_edge_ids(avoid_edge_ids.begin(), avoid_edge_ids.end());
+  std::sort(sorted_edge_ids.begin(), sorted_edge_ids.end());
+
 // log the GeoJSON of avoided edges
 #ifdef LOGGING_LEVEL_TRACE
-  if (!avoid_edge_ids.empty()) {
-    LOG_TRACE("Avoided edges GeoJSON: \n" + to_geojson(avoid_edge_ids, reader));
+  if (!sorted_edge_ids.empty()) {
+    LOG_TRACE("Avoided edges GeoJSON: \n" + to_geojson(sorted_edge_ids, reader));
   }
 #endif
 
-  return avoid_edge_ids;
+  return sorted_edge_ids;
 }
 } // namespace loki
 } // namespace valhalla
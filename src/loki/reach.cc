@@ -51,6 +51,22 @@ directed_reach Reach::operator()(const DirectedEdge* edge,
   directed_reach reach{};
   if (max_reach == 0)
     return reach;
+
+  // the table may know the edge makes the limit, then only the other direction is left to expand
+  const auto* stored = precomputed_ ? precomputed_->reach(edge_id, precomputed_index_) : nullptr;
+  if (stored) {
+    uint8_t remaining = (direction & kOutbound && stored->outbound < max_reach ? kOutbound : 0) |
+                        (direction & kInbound && stored->inbound < max_reach ? kInbound : 0);
+    if (remaining != direction) {
+      if (remaining)
+        reach = (*this)(edge, edge_id, max_reach, reader, costing, remaining);
+      if (direction & kOutbound && !(remaining & kOutbound))
+        reach.outbound = max_reach;
+      if (direction & kInbound && !(remaining & kInbound))
+        reach.inbound = max_reach;
+      return reach;
+    }
+  }
   max_reach_ = max_reach;
 
   // these are used below to get conservative estimates of forward and reverse reach
@@ -184,14 +200,14 @@ directed_reach Reach::exact(const valhalla::baldr::DirectedEdge* edge,
   costings[static_cast<int>(costing->travel_mode())] = costing;
 
   // expand in the forward direction
-  if (direction | kOutbound) {
+  if (direction & kOutbound) {
     Clear();
     Compute<thor::ExpansionType::forward>(locations_, reader, costings, costing->travel_mode());
     reach.outbound = std::min(static_cast<uint32_t>(done_.size() - transitions_), max_reach);
   }
 
   // expand in the reverse direction
-  if (direction | kInbound) {
+  if (direction & kInbound) {
     Clear();
     Compute<thor::ExpansionType::reverse>(locations_, reader, costings, costing->travel_mode());
     reach.inbound = std::min(static_cast<uint32_t>(done_.size() - transitions_), max_reach);
@@ -11,6 +11,27 @@ using namespace valhalla;
 using namespace valhalla::baldr;
 
 namespace {
+// Whether each location shares a component of the graph with the one after it, which every leg
+// of a route needs. The locations whose components are not known might be connected to anything.
+bool connected(const std::vector<std::vector<uint32_t>>& components) {
+  for (size_t i = 1; i < components.size(); ++i) {
+    const auto& from = components[i - 1];
+    const auto& to = components[i];
+    if (from.empty() || to.empty()) {
+      continue;
+    }
+    bool shared = false;
+    for (auto a = from.cbegin(), b = to.cbegin(); !shared && a != from.cend() && b != to.cend();) {
+      shared = *a == *b;
+      *a < *b ? ++a : ++b;
+    }
+    if (!shared) {
+      return false;
+    }
+  }
+  return true;
+}
+
 midgard::PointLL to_ll(const valhalla::Location& l) {
   return midgard::PointLL{l.ll().lng(), l.ll().lat()};
 }
@@ -95,12 +116,14 @@ void loki_worker_t::route(Api& request) {
 
   // correlate the various locations to the underlying graph
   std::unordered_map<size_t, size_t> color_counts;
+  std::vector<std::vector<uint32_t>> location_components;
   try {
     auto locations = PathLocation::fromPBF(options.locations(), true);
-    const auto projections = loki::Search(locations, *reader, costing);
+    const auto projections = search(locations, request);
     for (size_t i = 0; i < locations.size(); ++i) {
       const auto& correlated = projections.at(locations[i]);
       PathLocation::toPBF(correlated, options.mutable_locations(i), *reader);
+      location_components.push_back(components(correlated));
       // TODO: get transit level for transit costing
       // TODO: if transit send a non zero radius
       if (!connectivity_map) {
@@ -118,6 +141,11 @@ void loki_worker_t::route(Api& request) {
     }
   } catch (const std::exception&) { throw valhalla_exception_t{171}; }
 
+  // no route can connect the locations which are in different components of the graph
+  if (!connected(location_components)) {
+    throw valhalla_exception_t{170};
+  }
+
   // are all the locations in the same color regions
   if (!connectivity_map) {
     return;
@@ -2,16 +2,23 @@
 #include "baldr/graphconstants.h"
 #include "baldr/tilehierarchy.h"
 #include "loki/reach.h"
+#include "loki/search_cache.h"
 #include "midgard/distanceapproximator.h"
 #include "midgard/linesegment2.h"
+#include "midgard/tracing.h"
 #include "midgard/util.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <exception>
 #include <iterator>
 #include <list>
+#include <thread>
 #include <unordered_set>
 
+#include <robin_hood.h>
+
 using namespace valhalla::midgard;
 using namespace valhalla::baldr;
 using namespace valhalla::sif;
@@ -213,9 +220,19 @@ struct projector_wrapper {
         break;
       }
 
+      // the bins of a tile which isnt there come up one at a time, after the first one of them we
+      // know better than to ask the reader again
+      if (std::find(missing_tiles.cbegin(), missing_tiles.cend(), tile_index) !=
+          missing_tiles.cend()) {
+        ++missing_bins;
+        cur_tile = nullptr;
+        continue;
+      }
+
       // grab the tile the lat, lon is in
       auto tile_id = GraphId(tile_index, TileHierarchy::levels().back().level, 0);
-      reader.GetGraphTile(tile_id, cur_tile);
+      if (!reader.GetGraphTile(tile_id, cur_tile))
+        missing_tiles.push_back(tile_index);
     } while (!cur_tile);
   }
 
@@ -227,6 +244,9 @@ struct projector_wrapper {
   std::vector<candidate_t> unreachable;
   std::vector<candidate_t> reachable;
   double closest_external_reachable = std::numeric_limits<double>::max();
+  // the tiles of the bins which we found are not there and how many of their bins we skipped
+  std::vector<int32_t> missing_tiles;
+  uint64_t missing_bins = 0;
 
   // critical data
   projector_t project;
@@ -238,8 +258,13 @@ struct bin_handler_t {
   std::shared_ptr<DynamicCost> costing;
   unsigned int max_reach_limit;
   std::vector<candidate_t> bin_candidates;
-  std::unordered_set<uint64_t> correlated_edges;
+  robin_hood::unordered_flat_set<uint64_t> correlated_edges;
   Reach reach_finder;
+  SearchCache* cache;
+  const SegmentIndex* segment_index;
+  // the shape of the edge being projected onto, kept around to not allocate it for every edge
+  std::vector<PointLL> shape;
+  SearchStats stats;
 
   // keep track of edges whose reachability we've already computed
   // TODO: dont use pointers as keys, its safe for now but fancy caching one day could be bad
@@ -247,12 +272,19 @@ struct bin_handler_t {
 
   bin_handler_t(const std::vector<valhalla::baldr::Location>& locations,
                 valhalla::baldr::GraphReader& reader,
-                const std::shared_ptr<DynamicCost>& costing)
-      : reader(reader), costing(costing) {
-    // get the unique set of input locations and the max reachability of them all
+                const std::shared_ptr<DynamicCost>& costing,
+                const EdgeReach* precomputed_reach,
+                size_t reach_index,
+                SearchCache* cache,
+                const SegmentIndex* segment_index,
+                unsigned int reach_limit)
+      : reader(reader), costing(costing), cache(cache), segment_index(segment_index) {
+    reach_finder.set_precomputed(precomputed_reach, reach_index);
+    // get the unique set of input locations and the max reachability of them all, the parts of a
+    // parallel search start from the max of the whole request so they find the same reaches
     std::unordered_set<Location> uniq_locations(locations.begin(), locations.end());
     pps.reserve(uniq_locations.size());
-    max_reach_limit = 0;
+    max_reach_limit = reach_limit;
     for (const auto& loc : uniq_locations) {
       pps.emplace_back(loc, reader);
       max_reach_limit = std::max(max_reach_limit, loc.min_outbound_reach_);
@@ -422,14 +454,31 @@ struct bin_handler_t {
     }
   }
 
+  // the reach of an edge from earlier requests if there is a cache, otherwise it is computed
+  directed_reach find_reach(const GraphId edge_id, const DirectedEdge* edge) {
+    directed_reach reach{};
+    if (cache && cache->find_reach(edge_id, max_reach_limit, reach))
+      return reach;
+
+    // notice we do both directions here because in the end we use this reach for all input locations
+    ++stats.reach_checks;
+    const auto start = std::chrono::steady_clock::now();
+    reach = reach_finder(edge, edge_id, max_reach_limit, reader, costing, kInbound | kOutbound);
+    stats.reach_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                                start)
+                          .count();
+    if (cache)
+      cache->insert_reach(edge_id, max_reach_limit, reach);
+    return reach;
+  }
+
   directed_reach get_reach(const GraphId edge_id, const DirectedEdge* edge) {
     // if its in cache return it
     auto itr = directed_reaches.find(edge);
     if (itr != directed_reaches.cend())
       return itr->second;
 
-    // notice we do both directions here because in the end we use this reach for all input locations
-    auto reach = reach_finder(edge, edge_id, max_reach_limit, reader, costing, kInbound | kOutbound);
+    auto reach = find_reach(edge_id, edge);
     directed_reaches[edge] = reach;
     return reach;
   }
@@ -462,8 +511,7 @@ struct bin_handler_t {
     if (!check)
       return {max_reach_limit, max_reach_limit};
 
-    // notice we do both directions here because in the end we use this reach for all input locations
-    auto reach = reach_finder(edge, edge_id, max_reach_limit, reader, costing, kInbound | kOutbound);
+    auto reach = find_reach(edge_id, edge);
     directed_reaches[edge] = reach;
 
     // if the inbound reach is not 0 and the outbound reach is not 0 and the opposing edge is not
@@ -477,164 +525,236 @@ struct bin_handler_t {
     return reach;
   }
 
-  // handle a bin for the range of candidates that share it
-  void handle_bin(std::vector<projector_wrapper>::iterator begin,
-                  std::vector<projector_wrapper>::iterator end) {
-    // iterate over the edges in the bin
-    auto tile = begin->cur_tile;
-    auto edges = tile->GetBin(begin->bin_index);
-    for (auto edge_id : edges) {
-      // get the tile and edge
-      if (!reader.GetGraphTile(edge_id, tile)) {
-        continue;
-      }
+  // project the locations onto an edge of the bin and keep it as a candidate if it makes sense
+  void handle_edge(std::vector<projector_wrapper>::iterator begin,
+                   std::vector<projector_wrapper>::iterator end,
+                   GraphId edge_id,
+                   graph_tile_ptr& tile,
+                   const SegmentIndex::edge_t* indexed) {
+    // get the tile and edge
+    if (!reader.GetGraphTile(edge_id, tile)) {
+      return;
+    }
 
-      // if this edge is filtered
-      const auto* edge = tile->directededge(edge_id);
-      if (!costing->Allowed(edge, tile, kDisallowShortcut)) {
-        // then we try its opposing edge
-        edge_id = reader.GetOpposingEdgeId(edge_id, edge, tile);
-        // but if we couldnt get it or its filtered too then we move on
-        if (!edge_id.Is_Valid() || !costing->Allowed(edge, tile, kDisallowShortcut))
-          continue;
-      }
+    // if this edge is filtered
+    const auto* edge = tile->directededge(edge_id);
+    if (!costing->Allowed(edge, tile, kDisallowShortcut)) {
+      // then we try its opposing edge
+      edge_id = reader.GetOpposingEdgeId(edge_id, edge, tile);
+      // but if we couldnt get it or its filtered too then we move on
+      if (!edge_id.Is_Valid() || !costing->Allowed(edge, tile, kDisallowShortcut))
+        return;
+    }
+
+    // initialize candidates vector:
+    // - reset sq_distance to max so we know the best point along the edge
+    // - apply prefilters based on user's SearchFilter request options
+    auto c_itr = bin_candidates.begin();
+    decltype(begin) p_itr;
+    bool all_prefiltered = true;
+    for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
+      c_itr->sq_distance = std::numeric_limits<double>::max();
+      c_itr->prefiltered =
+          is_search_filter_triggered(edge, *costing, tile, p_itr->location.search_filter_);
+      // set to false if even one candidate was not filtered
+      all_prefiltered = all_prefiltered && c_itr->prefiltered;
+    }
 
-      // initialize candidates vector:
-      // - reset sq_distance to max so we know the best point along the edge
-      // - apply prefilters based on user's SearchFilter request options
-      auto c_itr = bin_candidates.begin();
-      decltype(begin) p_itr;
-      bool all_prefiltered = true;
-      for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
-        c_itr->sq_distance = std::numeric_limits<double>::max();
-        c_itr->prefiltered =
-            is_search_filter_triggered(edge, *costing, tile, p_itr->location.search_filter_);
-        // set to false if even one candidate was not filtered
-        all_prefiltered = all_prefiltered && c_itr->prefiltered;
+    // short-circuit if all candidates were prefiltered
+    if (all_prefiltered) {
+      return;
+    }
+    ++stats.edges;
+
+    // TODO: can we speed this up? the majority of edges will be short and far away enough
+    // such that the closest point on the edge will be one of the edges end points, we can get
+    // these coordinates them from the nodes in the graph. we can then find whichever end is
+    // closest to the input point p, call it n. we can then define an half plane h intersecting n
+    // so that its orthogonal to the ray from p to n. using h, we only need to test segments
+    // of the shape which are on the same side of h that p is. to make this fast we would need a
+    // a trivial half plane test as maybe a single dot product and comparison?
+
+    // get the shape of the edge, the index has it already decoded so the edge info is only needed
+    // if the edge becomes a candidate
+    std::shared_ptr<const EdgeInfo> edge_info;
+    shape.clear();
+    if (indexed) {
+      const auto* points = segment_index->points(*indexed);
+      for (uint32_t i = 0; i < indexed->point_count; ++i) {
+        shape.push_back(points[i].ll());
+      }
+    } else {
+      edge_info = std::make_shared<const EdgeInfo>(tile->edgeinfo(edge));
+      auto lazy_shape = edge_info->lazy_shape();
+      while (!lazy_shape.empty()) {
+        shape.push_back(lazy_shape.pop());
       }
+    }
 
-      // short-circuit if all candidates were prefiltered
-      if (all_prefiltered) {
+    // project each of the input points onto all the segments of the edge at once
+    c_itr = bin_candidates.begin();
+    for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
+      // skip updating this candidate because it was prefiltered
+      if (c_itr->prefiltered) {
         continue;
       }
+      c_itr->index = p_itr->project.closest(shape.data(), shape.size(), c_itr->point,
+                                            c_itr->sq_distance);
+    }
 
-      // TODO: can we speed this up? the majority of edges will be short and far away enough
-      // such that the closest point on the edge will be one of the edges end points, we can get
-      // these coordinates them from the nodes in the graph. we can then find whichever end is
-      // closest to the input point p, call it n. we can then define an half plane h intersecting n
-      // so that its orthogonal to the ray from p to n. using h, we only need to test segments
-      // of the shape which are on the same side of h that p is. to make this fast we would need a
-      // a trivial half plane test as maybe a single dot product and comparison?
-
-      // get some shape of the edge
-      auto edge_info = std::make_shared<const EdgeInfo>(tile->edgeinfo(edge));
-      auto shape = edge_info->lazy_shape();
-      PointLL v;
-      if (!shape.empty()) {
-        v = shape.pop();
-      }
+    auto info_tile = tile;
+    const auto* info_edge = edge;
+    auto get_edge_info = [&]() {
+      if (!edge_info)
+        edge_info = std::make_shared<const EdgeInfo>(info_tile->edgeinfo(info_edge));
+      return edge_info;
+    };
 
-      // iterate along this edges segments projecting each of the points
-      for (size_t i = 0; !shape.empty(); ++i) {
-        auto u = v;
-        v = shape.pop();
-        // for each input point
-        c_itr = bin_candidates.begin();
-        for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
-          // skip updating this candidate because it was prefiltered
-          if (c_itr->prefiltered) {
-            continue;
-          }
-          // how close is the input to this segment
-          auto point = p_itr->project(u, v);
-          auto sq_distance = p_itr->project.approx.DistanceSquared(point);
-          // do we want to keep it
-          if (sq_distance < c_itr->sq_distance) {
-            c_itr->sq_distance = sq_distance;
-            c_itr->point = std::move(point);
-            c_itr->index = i;
-          }
+    // if we already have a better reachable candidate we can just assume this one is reachable
+    auto reach = check_reachability(begin, end, tile, edge, edge_id);
+
+    // keep the best point along this edge if it makes sense
+    c_itr = bin_candidates.begin();
+    for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
+      // skip updating this candidate because it was prefiltered
+      if (c_itr->prefiltered) {
+        continue;
+      }
+      // is this edge reachable in the right way
+      bool reachable = reach.outbound >= p_itr->location.min_outbound_reach_ &&
+                       reach.inbound >= p_itr->location.min_inbound_reach_;
+      const DirectedEdge* opp_edge = nullptr;
+      graph_tile_ptr opp_tile = tile;
+      GraphId opp_edgeid;
+      // it's possible that it isnt reachable but the opposing is, switch to that if so
+      if (!reachable && (opp_edgeid = reader.GetOpposingEdgeId(edge_id, opp_edge, opp_tile)) &&
+          costing->Allowed(opp_edge, opp_tile, kDisallowShortcut)) {
+        auto opp_reach = check_reachability(begin, end, opp_tile, opp_edge, opp_edgeid);
+        if (opp_reach.outbound >= p_itr->location.min_outbound_reach_ &&
+            opp_reach.inbound >= p_itr->location.min_inbound_reach_) {
+          tile = opp_tile;
+          edge = opp_edge;
+          edge_id = opp_edgeid;
+          reach = opp_reach;
+          reachable = true;
         }
       }
 
-      // if we already have a better reachable candidate we can just assume this one is reachable
-      auto reach = check_reachability(begin, end, tile, edge, edge_id);
+      // which batch of findings will this go into
+      auto* batch = reachable ? &p_itr->reachable : &p_itr->unreachable;
 
-      // keep the best point along this edge if it makes sense
-      c_itr = bin_candidates.begin();
-      for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
-        // skip updating this candidate because it was prefiltered
-        if (c_itr->prefiltered) {
-          continue;
-        }
-        // is this edge reachable in the right way
-        bool reachable = reach.outbound >= p_itr->location.min_outbound_reach_ &&
-                         reach.inbound >= p_itr->location.min_inbound_reach_;
-        const DirectedEdge* opp_edge = nullptr;
-        graph_tile_ptr opp_tile = tile;
-        GraphId opp_edgeid;
-        // it's possible that it isnt reachable but the opposing is, switch to that if so
-        if (!reachable && (opp_edgeid = reader.GetOpposingEdgeId(edge_id, opp_edge, opp_tile)) &&
-            costing->Allowed(opp_edge, opp_tile, kDisallowShortcut)) {
-          auto opp_reach = check_reachability(begin, end, opp_tile, opp_edge, opp_edgeid);
-          if (opp_reach.outbound >= p_itr->location.min_outbound_reach_ &&
-              opp_reach.inbound >= p_itr->location.min_inbound_reach_) {
-            tile = opp_tile;
-            edge = opp_edge;
-            edge_id = opp_edgeid;
-            reach = opp_reach;
-            reachable = true;
-          }
+      // if its empty append
+      if (batch->empty()) {
+        c_itr->edge = edge;
+        c_itr->edge_id = edge_id;
+        c_itr->edge_info = get_edge_info();
+        c_itr->tile = tile;
+        batch->emplace_back(std::move(*c_itr));
+        continue;
+      }
+
+      // get some info about possibilities
+      bool in_radius = c_itr->sq_distance < p_itr->sq_radius;
+      bool better = c_itr->sq_distance < batch->back().sq_distance;
+      bool last_in_radius = batch->back().sq_distance < p_itr->sq_radius;
+      // TODO: this is a bit blunt in that any reachable edges between the best or ones within
+      // the radius will make unreachable edges that are even the tiniest bit further away unviable
+      // it seems like we should have a slightly looser radius to allow for unreachable edges but
+      // its unclear what that should be as in most cases we are working around not actually knowing
+      // the accuracy or even input modality of the incoming location
+      bool closer_external_reachable =
+          reachable && c_itr->sq_distance < p_itr->closest_external_reachable;
+
+      // it has to either be better or in the radius to move on
+      if (in_radius || better) {
+        c_itr->edge = edge;
+        c_itr->edge_id = edge_id;
+        c_itr->edge_info = get_edge_info();
+        c_itr->tile = tile;
+        // the last one wasnt in the radius so replace it with this one because its better or is
+        // in the radius
+        if (!last_in_radius) {
+          if (closer_external_reachable)
+            p_itr->closest_external_reachable = batch->back().sq_distance;
+          batch->back() = std::move(*c_itr);
+          // last one is in the radius but this one is better so put it on the end
+        } else if (better) {
+          batch->emplace_back(std::move(*c_itr));
+          // last one and this one are both in the radius but this one is not as good
+        } else {
+          batch->emplace_back(std::move(*c_itr));
+          std::swap(*(batch->end() - 1), *(batch->end() - 2));
         }
+      } // not in radius or better and reachable and closer than closest one outside of radius
+      else if (closer_external_reachable)
+        p_itr->closest_external_reachable = c_itr->sq_distance;
+    }
+  }
 
-        // which batch of findings will this go into
-        auto* batch = reachable ? &p_itr->reachable : &p_itr->unreachable;
+  // whether nothing in the box can change the candidates of any of the locations, that is when it
+  // is outside of their radii, further than their best reachable and best unreachable candidates and
+  // further than their closest reachable candidate outside of the radius so finalize would drop it
+  // as an island anyway
+  bool out_of_range(std::vector<projector_wrapper>::iterator begin,
+                    std::vector<projector_wrapper>::iterator end,
+                    const SegmentIndex::box_t& box) const {
+    for (auto p_itr = begin; p_itr != end; ++p_itr) {
+      if (p_itr->reachable.empty())
+        return false;
+      auto sq_distance = p_itr->project.approx.DistanceSquared(box.closest(p_itr->location.latlng_));
+      if (sq_distance < p_itr->sq_radius || sq_distance < p_itr->reachable.back().sq_distance ||
+          sq_distance <= p_itr->closest_external_reachable ||
+          (!p_itr->unreachable.empty() && sq_distance < p_itr->unreachable.back().sq_distance))
+        return false;
+    }
+    return true;
+  }
 
-        // if its empty append
-        if (batch->empty()) {
-          c_itr->edge = edge;
-          c_itr->edge_id = edge_id;
-          c_itr->edge_info = edge_info;
-          c_itr->tile = tile;
-          batch->emplace_back(std::move(*c_itr));
+  // handle a bin for the range of candidates that share it
+  void handle_bin(std::vector<projector_wrapper>::iterator begin,
+                  std::vector<projector_wrapper>::iterator end) {
+    ++stats.bins;
+    auto tile = begin->cur_tile;
+    const auto* bin = segment_index ? segment_index->bin(tile->id(), begin->bin_index) : nullptr;
+    if (bin) {
+      // skip the nodes and then the edges of the index which are too far from all the locations
+      for (auto n = bin->node_offset; n < bin->node_offset + bin->node_count; ++n) {
+        const auto& node = segment_index->node(n);
+        if (out_of_range(begin, end, node.box))
           continue;
+        for (auto e = node.edge_offset; e < node.edge_offset + node.edge_count; ++e) {
+          const auto& indexed = segment_index->edge(e);
+          if (!out_of_range(begin, end, indexed.box))
+            handle_edge(begin, end, GraphId(indexed.edge_id), tile, &indexed);
         }
-
-        // get some info about possibilities
-        bool in_radius = c_itr->sq_distance < p_itr->sq_radius;
-        bool better = c_itr->sq_distance < batch->back().sq_distance;
-        bool last_in_radius = batch->back().sq_distance < p_itr->sq_radius;
-        // TODO: this is a bit blunt in that any reachable edges between the best or ones within
-        // the radius will make unreachable edges that are even the tiniest bit further away unviable
-        // it seems like we should have a slightly looser radius to allow for unreachable edges but
-        // its unclear what that should be as in most cases we are working around not actually knowing
-        // the accuracy or even input modality of the incoming location
-        bool closer_external_reachable =
-            reachable && c_itr->sq_distance < p_itr->closest_external_reachable;
-
-        // it has to either be better or in the radius to move on
-        if (in_radius || better) {
-          c_itr->edge = edge;
-          c_itr->edge_id = edge_id;
-          c_itr->edge_info = edge_info;
-          c_itr->tile = tile;
-          // the last one wasnt in the radius so replace it with this one because its better or is
-          // in the radius
-          if (!last_in_radius) {
-            if (closer_external_reachable)
-              p_itr->closest_external_reachable = batch->back().sq_distance;
-            batch->back() = std::move(*c_itr);
-            // last one is in the radius but this one is better so put it on the end
-          } else if (better) {
-            batch->emplace_back(std::move(*c_itr));
-            // last one and this one are both in the radius but this one is not as good
-          } else {
-            batch->emplace_back(std::move(*c_itr));
-            std::swap(*(batch->end() - 1), *(batch->end() - 2));
-          }
-        } // not in radius or better and reachable and closer than closest one outside of radius
-        else if (closer_external_reachable)
-          p_itr->closest_external_reachable = c_itr->sq_distance;
+      }
+    } else if (auto depth = tile->GetBinCellDepth(begin->bin_index)) {
+      // skip the edges of a dense bin which only touch cells of it which are too far from all the
+      // locations, rounding the cells outwards so they are never closer than they should be
+      auto bin_box = tile->BinBoundingBox(begin->bin_index);
+      auto down = [](double coord) {
+        return static_cast<int32_t>(std::floor(coord / DECODE_PRECISION));
+      };
+      auto up = [](double coord) {
+        return static_cast<int32_t>(std::ceil(coord / DECODE_PRECISION));
+      };
+      uint64_t in_range = 0;
+      for (uint32_t cell = 0; cell < (1u << (2 * depth)); ++cell) {
+        auto cell_box = GraphTile::BinCellBoundingBox(bin_box, depth, cell);
+        SegmentIndex::box_t box{{down(cell_box.minx()), down(cell_box.miny())},
+                                {up(cell_box.maxx()), up(cell_box.maxy())}};
+        if (!out_of_range(begin, end, box))
+          in_range |= uint64_t(1) << cell;
+      }
+      auto cells = tile->GetBinCells(begin->bin_index).begin();
+      for (auto edge_id : tile->GetBin(begin->bin_index)) {
+        if (*cells++ & in_range)
+          handle_edge(begin, end, edge_id, tile, nullptr);
+      }
+    } else {
+      // iterate over the edges in the bin
+      for (auto edge_id : tile->GetBin(begin->bin_index)) {
+        handle_edge(begin, end, edge_id, tile, nullptr);
       }
     }
 
@@ -776,6 +896,110 @@ struct bin_handler_t {
   }
 };
 
+// searches the locations which are not cached with one reader on the calling thread
+std::unordered_map<Location, PathLocation> search(const std::vector<Location>& locations,
+                                                  GraphReader& reader,
+                                                  const std::shared_ptr<DynamicCost>& costing,
+                                                  const EdgeReach* precomputed_reach,
+                                                  size_t reach_index,
+                                                  SearchCache* cache,
+                                                  const SegmentIndex* segment_index,
+                                                  unsigned int reach_limit,
+                                                  SearchStats* stats) {
+  // start loading the tiles of all the locations at once rather than one at a time as we search
+  std::vector<GraphId> tile_ids;
+  for (const auto& location : locations) {
+    for (const auto& level : TileHierarchy::levels()) {
+      for (auto tile_index : level.tiles.TileList(ExpandMeters(location.latlng_, location.radius_))) {
+        tile_ids.emplace_back(tile_index, level.level, 0);
+      }
+    }
+  }
+  reader.Prefetch(tile_ids);
+
+  // setup the unique list of locations
+  bin_handler_t handler(locations, reader, costing, precomputed_reach, reach_index, cache,
+                        segment_index, reach_limit);
+  // search over the bins doing multiple locations per bin
+  handler.search();
+  if (stats) {
+    for (const auto& pp : handler.pps) {
+      handler.stats.missing_bins += pp.missing_bins;
+    }
+    *stats += handler.stats;
+  }
+  // turn each locations candidate set into path locations
+  return handler.finalize();
+}
+
+// the locations correlated by earlier requests with the same costing are not searched again
+bool find_cached(const std::vector<Location>& locations,
+                 SearchCache* cache,
+                 std::unordered_map<Location, PathLocation>& cached,
+                 std::vector<Location>& uncached) {
+  if (!cache || !cache->location_capacity())
+    return false;
+  for (const auto& location : locations) {
+    PathLocation correlated(location);
+    if (cache->find_location(location, correlated)) {
+      cached.emplace(location, std::move(correlated));
+    } else {
+      uncached.push_back(location);
+    }
+  }
+  return true;
+}
+
+void insert_cached(SearchCache* cache,
+                   std::unordered_map<Location, PathLocation>& cached,
+                   std::unordered_map<Location, PathLocation>& results) {
+  if (cache && cache->location_capacity()) {
+    for (const auto& result : results) {
+      cache->insert_location(result.first, result.second);
+    }
+    results.insert(cached.begin(), cached.end());
+  }
+}
+
+unsigned int max_reach(const std::vector<Location>& locations) {
+  unsigned int reach = 0;
+  for (const auto& location : locations) {
+    reach = std::max(reach, std::max(location.min_outbound_reach_, location.min_inbound_reach_));
+  }
+  return reach;
+}
+
+/**
+ * Splits the locations into parts of about the same size, the locations in the same tile stay in
+ * the same part so that they still share the bins they search
+ */
+std::vector<std::vector<Location>> partition(const std::vector<Location>& locations,
+                                             const size_t count) {
+  const auto& tiles = TileHierarchy::levels().back().tiles;
+  std::unordered_map<int32_t, std::vector<Location>> by_tile;
+  for (const auto& location : std::unordered_set<Location>(locations.begin(), locations.end())) {
+    by_tile[tiles.TileId(location.latlng_)].push_back(location);
+  }
+  std::vector<std::vector<Location>*> groups;
+  for (auto& tile : by_tile) {
+    groups.push_back(&tile.second);
+  }
+  // the biggest tiles first, each to the part with the fewest locations so far
+  std::sort(groups.begin(), groups.end(),
+            [](const std::vector<Location>* a, const std::vector<Location>* b) {
+              return a->size() > b->size();
+            });
+  std::vector<std::vector<Location>> parts(std::min(count, groups.size()));
+  for (auto* group : groups) {
+    auto part = std::min_element(parts.begin(), parts.end(),
+                                 [](const std::vector<Location>& a, const std::vector<Location>& b) {
+                                   return a.size() < b.size();
+                                 });
+    part->insert(part->end(), group->begin(), group->end());
+  }
+  return parts;
+}
+
 } // namespace
 
 namespace valhalla {
@@ -784,7 +1008,14 @@ namespace loki {
 std::unordered_map<valhalla::baldr::Location, PathLocation>
 Search(const std::vector<valhalla::baldr::Location>& locations,
        GraphReader& reader,
-       const std::shared_ptr<DynamicCost>& costing) {
+       const std::shared_ptr<DynamicCost>& costing,
+       const EdgeReach* precomputed_reach,
+       size_t reach_index,
+       SearchCache* cache,
+       const SegmentIndex* segment_index,
+       SearchStats* stats) {
+  VALHALLA_TRACE_SPAN("loki::Search");
+
   // we cannot continue without costing
   if (!costing)
     throw std::runtime_error("No costing was provided for edge candidate search");
@@ -793,12 +1024,80 @@ Search(const std::vector<valhalla::baldr::Location>& locations,
   if (locations.empty())
     return std::unordered_map<valhalla::baldr::Location, PathLocation>{};
 
-  // setup the unique list of locations
-  bin_handler_t handler(locations, reader, costing);
-  // search over the bins doing multiple locations per bin
-  handler.search();
-  // turn each locations candidate set into path locations
-  return handler.finalize();
+  std::unordered_map<valhalla::baldr::Location, PathLocation> cached;
+  std::vector<valhalla::baldr::Location> uncached;
+  if (find_cached(locations, cache, cached, uncached) && uncached.empty())
+    return cached;
+  const auto& searched = cache && cache->location_capacity() ? uncached : locations;
+
+  auto results = search(searched, reader, costing, precomputed_reach, reach_index, cache,
+                        segment_index, max_reach(searched), stats);
+  insert_cached(cache, cached, results);
+  return results;
+}
+
+std::unordered_map<valhalla::baldr::Location, PathLocation>
+Search(const std::vector<valhalla::baldr::Location>& locations,
+       const std::vector<baldr::GraphReader*>& readers,
+       const std::shared_ptr<DynamicCost>& costing,
+       const EdgeReach* precomputed_reach,
+       size_t reach_index,
+       SearchCache* cache,
+       const SegmentIndex* segment_index,
+       SearchStats* stats) {
+  if (readers.size() < 2)
+    return Search(locations, *readers.front(), costing, precomputed_reach, reach_index, cache,
+                  segment_index, stats);
+  if (!costing)
+    throw std::runtime_error("No costing was provided for edge candidate search");
+  if (locations.empty())
+    return std::unordered_map<valhalla::baldr::Location, PathLocation>{};
+
+  std::unordered_map<valhalla::baldr::Location, PathLocation> cached;
+  std::vector<valhalla::baldr::Location> uncached;
+  if (find_cached(locations, cache, cached, uncached) && uncached.empty())
+    return cached;
+  const auto& searched = cache && cache->location_capacity() ? uncached : locations;
+
+  // the cache of reaches is not shared across threads so only the calling thread uses it
+  auto parts = partition(searched, readers.size());
+  auto reach_limit = max_reach(searched);
+  std::vector<std::unordered_map<valhalla::baldr::Location, PathLocation>> found(parts.size());
+  std::vector<std::exception_ptr> errors(parts.size());
+  std::vector<SearchStats> part_stats(parts.size());
+  auto search_part = [&](size_t i) {
+    try {
+      found[i] = search(parts[i], *readers[i], costing, precomputed_reach, reach_index,
+                        i == 0 ? cache : nullptr, segment_index, reach_limit,
+                        stats ? &part_stats[i] : nullptr);
+    } catch (...) {
+      errors[i] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < parts.size(); ++i) {
+    threads.emplace_back(search_part, i);
+  }
+  search_part(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& error : errors) {
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+  auto results = std::move(found.front());
+  for (size_t i = 1; i < found.size(); ++i) {
+    results.insert(found[i].begin(), found[i].end());
+  }
+  if (stats) {
+    for (const auto& part_stat : part_stats) {
+      *stats += part_stat;
+    }
+  }
+  insert_cached(cache, cached, results);
+  return results;
 }
 
 } // namespace loki
@@ -0,0 +1,69 @@
+#include "loki/search_cache.h"
+
+#include <cmath>
+
+using namespace valhalla::baldr;
+
+namespace {
+
+// the coordinates are rounded to a millionth of a degree, about ten centimeters
+constexpr double kCoordinatePrecision = 1e6;
+
+template <typename T> void append(std::string& key, const T& value) {
+  key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+} // namespace
+
+namespace valhalla {
+namespace loki {
+
+SearchCache::SearchCache(size_t reach_capacity, size_t location_capacity)
+    : reaches_(reach_capacity), locations_(location_capacity) {
+}
+
+bool SearchCache::find_location(const baldr::Location& location, PathLocation& correlated) {
+  if (!location_capacity() || !locations_.find(location_key(location), correlated)) {
+    return false;
+  }
+  static_cast<baldr::Location&>(correlated) = location;
+  return true;
+}
+
+void SearchCache::insert_location(const baldr::Location& location, const PathLocation& correlated) {
+  locations_.insert(location_key(location), correlated);
+}
+
+std::string SearchCache::location_key(const baldr::Location& location) const {
+  // everything the search looks at, the address and the time of the location do not matter
+  std::string key;
+  key.reserve(128);
+  append(key, costing_hash_);
+  append(key, static_cast<int32_t>(std::round(location.latlng_.lng() * kCoordinatePrecision)));
+  append(key, static_cast<int32_t>(std::round(location.latlng_.lat() * kCoordinatePrecision)));
+  append(key, location.heading_ ? *location.heading_ : -1.f);
+  append(key, location.way_id_ ? *location.way_id_ : 0);
+  append(key, location.min_outbound_reach_);
+  append(key, location.min_inbound_reach_);
+  append(key, location.radius_);
+  append(key, location.preferred_side_);
+  append(key, location.node_snap_tolerance_);
+  append(key, location.heading_tolerance_);
+  append(key, location.search_cutoff_);
+  append(key, location.street_side_tolerance_);
+  append(key, location.street_side_max_distance_);
+  append(key, location.search_filter_.min_road_class_);
+  append(key, location.search_filter_.max_road_class_);
+  append(key, location.search_filter_.exclude_tunnel_);
+  append(key, location.search_filter_.exclude_bridge_);
+  append(key, location.search_filter_.exclude_ramp_);
+  append(key, location.search_filter_.exclude_closures_);
+  if (location.display_latlng_) {
+    append(key, location.display_latlng_->lng());
+    append(key, location.display_latlng_->lat());
+  }
+  return key;
+}
+
+} // namespace loki
+} // namespace valhalla
@@ -1,8 +1,9 @@
+#include "baldr/tilehierarchy.h"
 #include "loki/worker.h"
 
 namespace valhalla {
 namespace loki {
-void loki_worker_t::status(Api&) const {
+void loki_worker_t::status(Api& request) const {
 #ifdef HAVE_HTTP
   // if we are in the process of shutting down we signal that here
   // should react by draining traffic (though they are likely doing this as they are usually the ones
@@ -11,6 +12,69 @@ void loki_worker_t::status(Api&) const {
     throw valhalla_exception_t{102};
   }
 #endif
+
+  // advertise the region this node serves if the cluster is split by region
+  if (region_router && !region_router->region().empty()) {
+    request.mutable_info()->set_region(region_router->region());
+  }
+
+  // report how the tiles were found so the cache size can be tuned
+  tile_statistics(*reader, "loki_worker_t::", request);
+
+  // report how busy each action keeps the workers so the admission limits can be tuned
+  if (admission) {
+    admission->statistics("loki_worker_t::", request);
+  }
+
+  // report how often earlier searches were reused so the cache sizes can be tuned
+  if (search_cache) {
+    auto add_cache = [&request](const std::string& name, const size_t hits, const size_t misses) {
+      auto* stat = request.mutable_info()->mutable_statistics()->Add();
+      stat->set_name("loki_worker_t::" + name + "_cache_hits");
+      stat->set_value(hits);
+      stat = request.mutable_info()->mutable_statistics()->Add();
+      stat->set_name("loki_worker_t::" + name + "_cache_hit_rate");
+      stat->set_value(hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.);
+    };
+    add_cache("reach", search_cache->reaches().hits(), search_cache->reaches().misses());
+    add_cache("location", search_cache->locations().hits(), search_cache->locations().misses());
+  }
+
+  // report how often the decompressed elevation tiles were reused so the cache size can be tuned
+  {
+    const auto hits = sample.cache_hits(), misses = sample.cache_misses();
+    auto* stat = request.mutable_info()->mutable_statistics()->Add();
+    stat->set_name("loki_worker_t::elevation_cache_hits");
+    stat->set_value(hits);
+    stat = request.mutable_info()->mutable_statistics()->Add();
+    stat->set_name("loki_worker_t::elevation_cache_hit_rate");
+    stat->set_value(hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.);
+    stat = request.mutable_info()->mutable_statistics()->Add();
+    stat->set_name("loki_worker_t::elevation_cache_tiles");
+    stat->set_value(sample.cache_size());
+  }
+
+  // report how much work the searches did so far so the far reaching ones can be spotted
+  auto add_search = [&request](const std::string& name, const double value) {
+    auto* stat = request.mutable_info()->mutable_statistics()->Add();
+    stat->set_name("loki_worker_t::search_" + name);
+    stat->set_value(value);
+  };
+  add_search("bins", search_stats.bins);
+  add_search("edges", search_stats.edges);
+  add_search("reach_checks", search_stats.reach_checks);
+  add_search("missing_bins", search_stats.missing_bins);
+  add_search("reach_ms", search_stats.reach_ms);
+
+  // report how much of each level of the tile extract is resident so the tuning can be checked,
+  // only when it is shown, finding out walks the pages of the whole extract
+  if (request.options().verbose()) {
+    for (const auto& level : baldr::TileHierarchy::levels()) {
+      auto* stat = request.mutable_info()->mutable_statistics()->Add();
+      stat->set_name("loki_worker_t::tile_extract_resident_level_" + std::to_string(level.level));
+      stat->set_value(reader->GetExtractResidentBytes(level.level));
+    }
+  }
 }
 } // namespace loki
 } // namespace valhalla
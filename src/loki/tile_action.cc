@@ -0,0 +1,333 @@
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <unordered_map>
+
+#include "baldr/compression_utils.h"
+#include "baldr/graphconstants.h"
+#include "baldr/tilehierarchy.h"
+#include "loki/worker.h"
+#include "midgard/constants.h"
+#include "proto/vector_tile.pb.h"
+
+using namespace valhalla;
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+
+namespace {
+
+// the resolution of the tile and how far past its edges we draw so lines meet up across tiles
+constexpr int32_t kExtent = 4096;
+constexpr int32_t kBuffer = 64;
+
+// the zoom from which on the edges of each hierarchy level are drawn, the transit level is not
+constexpr uint32_t kLevelZoom[] = {0, 11, 13};
+
+// web mercator stops short of the poles
+constexpr double kMaxLatitude = 85.0511287798;
+
+// the commands of the geometry of a feature
+constexpr uint32_t kMoveTo = 1;
+constexpr uint32_t kLineTo = 2;
+
+using point_t = std::pair<int32_t, int32_t>;
+
+uint32_t command(uint32_t id, uint32_t count) {
+  return (id & 0x7) | (count << 3);
+}
+
+uint32_t zigzag(int32_t value) {
+  return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+// Turns coordinates into the pixels of a tile
+class projection_t {
+public:
+  explicit projection_t(const Options::Tile& tile)
+      : tiles_(static_cast<double>(1u << tile.z())), x_(tile.x()), y_(tile.y()) {
+  }
+
+  point_t operator()(const PointLL& ll) const {
+    double x = ((ll.lng() + 180.) / 360. * tiles_ - x_) * kExtent;
+    double lat = std::max(-kMaxLatitude, std::min(kMaxLatitude, ll.lat())) * kRadPerDegD;
+    double y = ((1. - std::log(std::tan(lat) + 1. / std::cos(lat)) / kPiD) / 2. * tiles_ - y_) *
+               kExtent;
+    return {static_cast<int32_t>(std::round(x)), static_cast<int32_t>(std::round(y))};
+  }
+
+  // the inverse for the corners of the tile, the pixels are in units of whole tiles
+  PointLL unproject(double x, double y) const {
+    double lng = (x_ + x) / tiles_ * 360. - 180.;
+    double lat = std::atan(std::sinh(kPiD * (1. - 2. * (y_ + y) / tiles_))) * kDegPerRadD;
+    return {lng, lat};
+  }
+
+  // the coordinates the tile and its buffer cover
+  AABB2<PointLL> bounds() const {
+    const double buffer = static_cast<double>(kBuffer) / kExtent;
+    auto nw = unproject(-buffer, -buffer);
+    auto se = unproject(1. + buffer, 1. + buffer);
+    return {nw.lng(), se.lat(), se.lng(), nw.lat()};
+  }
+
+protected:
+  double tiles_;
+  double x_;
+  double y_;
+};
+
+bool in_buffer(const point_t& a, const point_t& b) {
+  return std::max(a.first, b.first) >= -kBuffer &&
+         std::min(a.first, b.first) <= kExtent + kBuffer &&
+         std::max(a.second, b.second) >= -kBuffer &&
+         std::min(a.second, b.second) <= kExtent + kBuffer;
+}
+
+// Builds up a layer of the tile, all of its features share the same lists of keys and values
+class layer_builder_t {
+public:
+  layer_builder_t(mvt::Tile& tile, const std::string& name) : layer_(tile.add_layers()) {
+    layer_->set_version(2);
+    layer_->set_name(name);
+    layer_->set_extent(kExtent);
+  }
+
+  mvt::Tile::Feature* add_feature(uint64_t id, mvt::Tile::GeomType type) {
+    auto* feature = layer_->add_features();
+    feature->set_id(id);
+    feature->set_type(type);
+    return feature;
+  }
+
+  void add_attribute(mvt::Tile::Feature* feature, const std::string& key, uint64_t value) {
+    tag(feature, key, "u" + std::to_string(value))->set_uint_value(value);
+  }
+
+  void add_attribute(mvt::Tile::Feature* feature, const std::string& key, bool value) {
+    tag(feature, key, value ? "b1" : "b0")->set_bool_value(value);
+  }
+
+  void
+  add_attribute(mvt::Tile::Feature* feature, const std::string& key, const std::string& value) {
+    tag(feature, key, "s" + value)->set_string_value(value);
+  }
+
+  // takes back the last feature when it turns out there is nothing of it to draw
+  void remove_last() {
+    layer_->mutable_features()->RemoveLast();
+  }
+
+protected:
+  // tags the feature with the key and value, only values not seen before need to be filled in
+  mvt::Tile::Value* tag(mvt::Tile::Feature* feature, const std::string& key, std::string&& value) {
+    auto k = keys_.emplace(key, layer_->keys_size());
+    if (k.second) {
+      layer_->add_keys(key);
+    }
+    feature->add_tags(k.first->second);
+    auto v = values_.emplace(std::move(value), layer_->values_size());
+    feature->add_tags(v.first->second);
+    return v.second ? layer_->add_values() : &scratch_;
+  }
+
+  mvt::Tile::Layer* layer_;
+  std::unordered_map<std::string, uint32_t> keys_;
+  // the values are keyed by their type and their text so that 1 and "1" stay apart
+  std::unordered_map<std::string, uint32_t> values_;
+  mvt::Tile::Value scratch_;
+};
+
+// Draws the runs of the line which are in the buffer of the tile, false if none of it is
+bool add_line(mvt::Tile::Feature* feature, const std::vector<point_t>& points) {
+  point_t cursor{0, 0};
+  size_t i = 0;
+  while (i + 1 < points.size()) {
+    // find the next run of segments touching the tile
+    if (!in_buffer(points[i], points[i + 1])) {
+      ++i;
+      continue;
+    }
+    size_t end = i + 1;
+    while (end + 1 < points.size() && in_buffer(points[end], points[end + 1])) {
+      ++end;
+    }
+
+    // move to its start and draw to the rest of it, skipping the points which round to the same
+    auto* geometry = feature->mutable_geometry();
+    const int start = geometry->size();
+    geometry->Add(command(kMoveTo, 1));
+    geometry->Add(zigzag(points[i].first - cursor.first));
+    geometry->Add(zigzag(points[i].second - cursor.second));
+    auto run_start = cursor;
+    cursor = points[i];
+    geometry->Add(0);
+    uint32_t count = 0;
+    for (size_t j = i + 1; j <= end; ++j) {
+      if (points[j] == cursor) {
+        continue;
+      }
+      geometry->Add(zigzag(points[j].first - cursor.first));
+      geometry->Add(zigzag(points[j].second - cursor.second));
+      cursor = points[j];
+      ++count;
+    }
+
+    // the whole run rounded to one pixel so take it back out again
+    if (count == 0) {
+      geometry->Truncate(start);
+      cursor = run_start;
+    } else {
+      geometry->Set(start + 3, command(kLineTo, count));
+    }
+    i = end;
+  }
+  return feature->geometry_size() > 0;
+}
+
+std::string gzip(const std::string& uncompressed) {
+  auto deflate_src = [&uncompressed](z_stream& s) {
+    s.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(uncompressed.data()));
+    s.avail_in = static_cast<unsigned int>(uncompressed.size());
+    return Z_FINISH;
+  };
+
+  std::string compressed;
+  auto deflate_dst = [&compressed](z_stream& s) {
+    // if the whole buffer wasn't used we are done
+    auto size = compressed.size();
+    if (s.total_out < size) {
+      compressed.resize(s.total_out);
+    } // otherwise double the space
+    else {
+      compressed.resize(std::max<size_t>(size * 2, 4096));
+      s.next_out = reinterpret_cast<Bytef*>(&compressed[size]);
+      s.avail_out = static_cast<unsigned int>(compressed.size() - size);
+    }
+  };
+
+  // tiles change often enough that speed beats the last few bytes
+  if (!valhalla::baldr::deflate(deflate_src, deflate_dst, Z_DEFAULT_COMPRESSION)) {
+    throw std::logic_error("Can't write gzipped tile");
+  }
+  return compressed;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace loki {
+
+std::string loki_worker_t::tile(Api& request) {
+  // time this whole method and save that statistic
+  auto _ = measure_scope_time(request, "loki_worker_t::tile");
+
+  const auto& xyz = request.options().tile_xyz();
+  if (xyz.z() < tile_min_zoom) {
+    throw valhalla_exception_t{168, " of " + std::to_string(tile_min_zoom)};
+  }
+
+  // the same tile asked for again not long after
+  std::shared_ptr<const std::string> bytes;
+  if (tile_cache && tile_cache->find(xyz, bytes)) {
+    return *bytes;
+  }
+
+  projection_t projection(xyz);
+  const auto bounds = projection.bounds();
+  mvt::Tile mvt;
+  layer_builder_t edges(mvt, "edges");
+  layer_builder_t nodes(mvt, "nodes");
+  std::vector<point_t> points;
+  for (const auto& level : TileHierarchy::levels()) {
+    if (level.level >= sizeof(kLevelZoom) / sizeof(kLevelZoom[0]) ||
+        xyz.z() < kLevelZoom[level.level]) {
+      continue;
+    }
+    for (auto id : level.tiles.TileList(bounds)) {
+      if (interrupt) {
+        (*interrupt)();
+      }
+      GraphId tile_id(id, level.level, 0);
+      auto tile = reader->GetGraphTile(tile_id);
+      if (!tile) {
+        continue;
+      }
+
+      // every directed edge so that each direction shows its own access and speed
+      for (uint32_t i = 0; i < tile->header()->directededgecount(); ++i) {
+        const auto* de = tile->directededge(i);
+        if (de->is_shortcut()) {
+          continue;
+        }
+        auto info = tile->edgeinfo(de);
+        const auto& shape = info.shape();
+        points.clear();
+        points.reserve(shape.size());
+        std::transform(shape.cbegin(), shape.cend(), std::back_inserter(points), projection);
+        if (!de->forward()) {
+          std::reverse(points.begin(), points.end());
+        }
+        auto edge_id = tile_id + static_cast<uint64_t>(i);
+        auto* feature = edges.add_feature(edge_id.value, mvt::Tile::LINESTRING);
+        if (!add_line(feature, points)) {
+          edges.remove_last();
+          continue;
+        }
+        edges.add_attribute(feature, "id", static_cast<uint64_t>(edge_id.value));
+        edges.add_attribute(feature, "road_class", to_string(de->classification()));
+        edges.add_attribute(feature, "use", to_string(de->use()));
+        edges.add_attribute(feature, "speed", static_cast<uint64_t>(de->speed()));
+        edges.add_attribute(feature, "length", static_cast<uint64_t>(de->length()));
+        edges.add_attribute(feature, "access", static_cast<uint64_t>(de->forwardaccess()));
+        edges.add_attribute(feature, "reverse_access", static_cast<uint64_t>(de->reverseaccess()));
+        auto volatile& traffic = tile->trafficspeed(de);
+        if (traffic.speed_valid()) {
+          edges.add_attribute(feature, "traffic_speed",
+                              static_cast<uint64_t>(traffic.get_overall_speed()));
+        }
+        if (traffic.closed()) {
+          edges.add_attribute(feature, "closed", true);
+        }
+        auto names = info.GetNameViews();
+        if (!names.empty()) {
+          edges.add_attribute(feature, "name", names.front().to_string());
+        }
+      }
+
+      // the nodes in the tile itself, the buffer is only there for the lines
+      for (uint32_t i = 0; i < tile->header()->nodecount(); ++i) {
+        const auto* node = tile->node(i);
+        auto point = projection(node->latlng(tile->header()->base_ll()));
+        if (point.first < 0 || point.first >= kExtent || point.second < 0 ||
+            point.second >= kExtent) {
+          continue;
+        }
+        auto node_id = tile_id + static_cast<uint64_t>(i);
+        auto* feature = nodes.add_feature(node_id.value, mvt::Tile::POINT);
+        feature->add_geometry(command(kMoveTo, 1));
+        feature->add_geometry(zigzag(point.first));
+        feature->add_geometry(zigzag(point.second));
+        nodes.add_attribute(feature, "id", static_cast<uint64_t>(node_id.value));
+        nodes.add_attribute(feature, "type", to_string(node->type()));
+        nodes.add_attribute(feature, "edge_count", static_cast<uint64_t>(node->edge_count()));
+        nodes.add_attribute(feature, "traffic_signal", node->traffic_signal());
+      }
+    }
+  }
+
+  // leave out the empty layers, clients are not supposed to get layers without features
+  for (int i = mvt.layers_size() - 1; i >= 0; --i) {
+    if (mvt.layers(i).features_size() == 0) {
+      mvt.mutable_layers()->DeleteSubrange(i, 1);
+    }
+  }
+
+  bytes = std::make_shared<const std::string>(gzip(mvt.SerializeAsString()));
+  if (tile_cache) {
+    tile_cache->insert(xyz, bytes);
+  }
+  return *bytes;
+}
+
+} // namespace loki
+} // namespace valhalla
@@ -1,6 +1,9 @@
+#include <algorithm>
 #include <boost/property_tree/ptree.hpp>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -28,6 +31,36 @@ using namespace valhalla::baldr;
 using namespace valhalla::sif;
 using namespace valhalla::loki;
 
+namespace {
+
+// reach does not depend on the time so the live and predicted speeds make no difference
+std::string serialize_reach_options(valhalla::CostingOptions options) {
+  options.set_flow_mask(kDefaultFlowMask);
+  return options.SerializeAsString();
+}
+
+// The overlays are read only so all of the workers in the process share the one loaded from a file
+template <typename overlay_t>
+std::shared_ptr<const overlay_t> load_overlay(const std::string& file, const std::string& name) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::weak_ptr<const overlay_t>> loaded;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& cached = loaded[file];
+  auto overlay = cached.lock();
+  if (!overlay) {
+    try {
+      overlay = std::make_shared<const overlay_t>(file);
+      cached = overlay;
+      LOG_INFO("Loaded the " + name + " of " + std::to_string(overlay->edge_count()) + " edges");
+    } catch (const std::exception& e) {
+      LOG_WARN("Searching without the " + name + ": " + std::string(e.what()));
+    }
+  }
+  return overlay;
+}
+
+} // namespace
+
 namespace valhalla {
 namespace loki {
 void loki_worker_t::parse_locations(google::protobuf::RepeatedPtrField<valhalla::Location>* locations,
@@ -84,6 +117,37 @@ void loki_worker_t::parse_costing(Api& api, bool allow_none) {
     }
   } catch (const std::runtime_error&) { throw valhalla_exception_t{125, "'" + costing_str + "'"}; }
 
+  // Requests which keep the default options of a costing of the precomputed reach can look it up
+  precomputed_reach = nullptr;
+  const auto reach_costing =
+      static_cast<int>(options.costing() == Costing::multimodal ? Costing::pedestrian
+                                                                : options.costing());
+  if (edge_reach && reach_costing < options.costing_options_size()) {
+    auto found =
+        edge_reach_defaults.find(serialize_reach_options(options.costing_options(reach_costing)));
+    if (found != edge_reach_defaults.cend()) {
+      precomputed_reach = edge_reach.get();
+      reach_index = found->second;
+    }
+  }
+
+  // The components only hold for costings of a single mode which keep to the access of the edges
+  component_index = -1;
+  if (graph_components && options.costing() != Costing::multimodal &&
+      options.costing() != Costing::bikeshare &&
+      (reach_costing >= options.costing_options_size() ||
+       !options.costing_options(reach_costing).ignore_access())) {
+    component_index = graph_components->mode_index(costing->access_mode());
+  }
+
+  // Earlier searches only apply to requests with the very same costing options
+  if (search_cache) {
+    search_cache->set_costing(std::hash<std::string>()(
+        reach_costing < options.costing_options_size()
+            ? options.costing_options(reach_costing).SerializeAsString()
+            : Costing_Enum_Name(static_cast<Costing>(reach_costing))));
+  }
+
   if (options.exclude_polygons_size()) {
     const auto edges =
         edges_in_rings(options.exclude_polygons(), *reader, costing, max_exclude_polygons_length);
@@ -104,7 +168,7 @@ void loki_worker_t::parse_costing(Api& api, bool allow_none) {
     }
     try {
       auto exclude_locations = PathLocation::fromPBF(options.exclude_locations());
-      auto results = loki::Search(exclude_locations, *reader, costing);
+      auto results = search(exclude_locations, api);
       std::unordered_set<uint64_t> avoids;
       auto* co = options.mutable_costing_options(options.costing());
       for (const auto& result : results) {
@@ -157,13 +221,94 @@ loki_worker_t::loki_worker_t(const boost::property_tree::ptree& config,
       max_contour_min(config.get<size_t>("service_limits.isochrone.max_time_contour")),
       max_contour_km(config.get<size_t>("service_limits.isochrone.max_distance_contour")),
       max_trace_shape(config.get<size_t>("service_limits.trace.max_shape")),
-      sample(config.get<std::string>("additional_data.elevation", "")),
+      sample(config.get<std::string>("additional_data.elevation", ""),
+             config.get<size_t>("additional_data.elevation_cache_size",
+                                skadi::kDefaultUnzippedCacheBytes)),
       max_elevation_shape(config.get<size_t>("service_limits.skadi.max_shape")),
-      min_resample(config.get<float>("service_limits.skadi.min_resample")) {
+      min_resample(config.get<float>("service_limits.skadi.min_resample")),
+      precomputed_reach(nullptr), reach_index(0), component_index(-1),
+      parallel_search_locations(0) {
   // If we weren't provided with a graph reader make our own
   if (!reader)
     reader.reset(new baldr::GraphReader(config.get_child("mjolnir")));
 
+  // Loki sees every request first so its the one to start the clock on them
+  request_timeout = config.get<uint32_t>("service_limits.request_timeout", 0);
+
+  // The actions can be limited in how many of them the loki workers run at once
+  admission = admission_t::shared(config, "loki");
+
+  // Loki answers the requests it has seen before with the responses the last stage cached
+  response_cache = response_cache_t::shared(config);
+
+  // Loki sends the requests outside of the region of this node to the nodes of theirs
+  region_router = region_router_t::make(config);
+
+  // Loki picks what the responses are compressed with since it is the one seeing the headers
+  response_compressor = response_compressor_t::make(config);
+
+  // Load the tiles that were used the most before taking any requests
+  auto warm_file = config.get<std::string>("mjolnir.tile_warm_file", "");
+  if (!warm_file.empty()) {
+    reader->Warm(baldr::GraphReader::ReadTileUsage(warm_file),
+                 config.get<size_t>("mjolnir.tile_warm_threads", 1));
+  }
+
+  // Look up the reach of the edges for default costings if the tiles came with it, a request
+  // without costing options and one with empty ones for the costing both keep the defaults
+  auto edge_reach_file = config.get_optional<std::string>("mjolnir.edge_reach");
+  if (edge_reach_file && (edge_reach = load_overlay<EdgeReach>(*edge_reach_file, "edge reach"))) {
+    for (size_t i = 0; i < edge_reach->costings().size(); ++i) {
+      const auto costing = static_cast<Costing>(edge_reach->costings()[i]);
+      const auto& costing_name = Costing_Enum_Name(costing);
+      for (const auto& json : {std::string("{}"),
+                               R"({"costing_options":{")" + costing_name + R"(":{}}})"}) {
+        rapidjson::Document doc;
+        doc.Parse(json.c_str());
+        CostingOptions options;
+        ParseCostingOptions(doc, "/costing_options/" + costing_name, &options, costing);
+        edge_reach_defaults.emplace(serialize_reach_options(options), i);
+      }
+    }
+  }
+
+  // Skip the edges of the bins which are too far from the locations if the tiles came with an index
+  auto segment_index_file = config.get_optional<std::string>("mjolnir.segment_index");
+  if (segment_index_file) {
+    segment_index = load_overlay<SegmentIndex>(*segment_index_file, "segment index");
+  }
+
+  // Reject the locations which no route can connect if the tiles came with their components
+  auto graph_components_file = config.get_optional<std::string>("mjolnir.graph_components");
+  if (graph_components_file) {
+    graph_components = load_overlay<GraphComponents>(*graph_components_file, "graph components");
+  }
+
+  // Remember the reach of edges and the correlated locations across requests if asked to
+  auto reach_cache_size = config.get<size_t>("loki.reach_cache_size", 0);
+  auto location_cache_size = config.get<size_t>("loki.location_cache_size", 0);
+  if (reach_cache_size || location_cache_size) {
+    search_cache = std::make_shared<SearchCache>(reach_cache_size, location_cache_size);
+  }
+
+  // Remember the vector tiles that were rendered for a while if asked to
+  auto tile_cache_size = config.get<size_t>("loki.tile_cache_size", 0);
+  if (tile_cache_size) {
+    auto tile_cache_ttl = config.get<uint32_t>("loki.tile_cache_ttl", 60);
+    tile_cache = std::make_shared<TileCache>(tile_cache_size, tile_cache_ttl);
+  }
+  tile_min_zoom = config.get<uint32_t>("loki.tile_min_zoom", 8);
+
+  // Correlate the locations of big requests on more threads, each of them needs its own reader
+  auto search_threads = config.get<size_t>("loki.search_threads", 1);
+  for (size_t i = 1; i < search_threads; ++i) {
+    search_readers.emplace_back(new baldr::GraphReader(config.get_child("mjolnir")));
+  }
+  parallel_search_locations = config.get<size_t>("loki.parallel_search_locations", 100);
+
+  // Requests with the same costing options get copies of the same costing
+  factory.set_cache_size(config.get<size_t>("loki.costing_cache_size", 0));
+
   // Keep a string noting which actions we support, throw if one isnt supported
   Options::Action action;
   for (const auto& kv : config.get_child("loki.actions")) {
@@ -184,7 +329,7 @@ loki_worker_t::loki_worker_t(const boost::property_tree::ptree& config,
     if (kv.first == "max_exclude_locations" || kv.first == "max_reachability" ||
         kv.first == "max_radius" || kv.first == "max_timedep_distance" ||
         kv.first == "max_alternates" || kv.first == "max_exclude_polygons_length" ||
-        kv.first == "skadi") {
+        kv.first == "skadi" || kv.first == "request_timeout" || kv.first == "admission") {
       continue;
     }
     if (kv.first != "trace") {
@@ -244,10 +389,74 @@ loki_worker_t::loki_worker_t(const boost::property_tree::ptree& config,
   max_alternates = config.get<unsigned int>("service_limits.max_alternates");
 }
 
+std::unordered_map<baldr::Location, baldr::PathLocation>
+loki_worker_t::search(const std::vector<baldr::Location>& locations, Api& request) {
+  // the work of this search is what the totals of the worker grow by
+  const auto before = search_stats;
+  auto _ = measure_scope_time(request, "loki_worker_t::search");
+  auto tiles = measure_scope_tiles(*reader, "loki_worker_t::search_", request);
+  auto searched = [&]() {
+    if (search_readers.empty() || locations.size() < parallel_search_locations) {
+      return loki::Search(locations, *reader, costing, precomputed_reach, reach_index,
+                          search_cache.get(), segment_index.get(), &search_stats);
+    }
+    std::vector<baldr::GraphReader*> readers{reader.get()};
+    for (const auto& search_reader : search_readers) {
+      readers.push_back(search_reader.get());
+    }
+    return loki::Search(locations, readers, costing, precomputed_reach, reach_index,
+                        search_cache.get(), segment_index.get(), &search_stats);
+  };
+  auto results = searched();
+
+  auto add = [&request](const std::string& name, const double value) {
+    auto* stat = request.mutable_info()->mutable_statistics()->Add();
+    stat->set_name("loki_worker_t::search_" + name);
+    stat->set_value(value);
+  };
+  add("bins", search_stats.bins - before.bins);
+  add("edges", search_stats.edges - before.edges);
+  add("reach_checks", search_stats.reach_checks - before.reach_checks);
+  add("reach_ms", search_stats.reach_ms - before.reach_ms);
+  return results;
+}
+
+std::vector<uint32_t> loki_worker_t::components(const baldr::PathLocation& location) const {
+  std::vector<uint32_t> found;
+  if (component_index < 0) {
+    return found;
+  }
+  // the filtered edges count as well since a route may still leave from them
+  for (const auto* edges : {&location.edges, &location.filtered_edges}) {
+    for (const auto& edge : *edges) {
+      const auto component = graph_components->component(edge.id, component_index);
+      if (component == GraphComponents::kNoComponent) {
+        return {};
+      }
+      found.push_back(component);
+    }
+  }
+  std::sort(found.begin(), found.end());
+  found.erase(std::unique(found.begin(), found.end()), found.end());
+  return found;
+}
+
 void loki_worker_t::cleanup() {
   if (reader->OverCommitted()) {
     reader->Trim();
   }
+  for (auto& search_reader : search_readers) {
+    if (search_reader->OverCommitted()) {
+      search_reader->Trim();
+    }
+  }
+}
+
+void loki_worker_t::check_action(const Api& request) const {
+  const auto& options = request.options();
+  if (!options.has_action() || actions.find(options.action()) == actions.cend()) {
+    throw valhalla_exception_t{106, action_str};
+  }
 }
 
 void loki_worker_t::set_interrupt(const std::function<void()>* interrupt_function) {
@@ -264,13 +473,17 @@ loki_worker_t::work(const std::list<zmq::message_t>& job,
   // grab the request info
   auto& info = *static_cast<prime_server::http_request_info_t*>(request_info);
   LOG_INFO("Got Loki Request " + std::to_string(info.id));
-  Api request;
+  // the previous request and everything hanging off of it is freed at once here
+  auto& request = arena_request();
   try {
     // request parsing
     auto http_request =
         prime_server::http_request_t::from_string(static_cast<const char*>(job.front().data()),
                                                   job.front().size());
     ParseApi(http_request, request);
+    if (response_compressor) {
+      response_compressor->negotiate(http_request, request);
+    }
     const auto& options = request.options();
 
     // check there is a valid action
@@ -278,8 +491,22 @@ loki_worker_t::work(const std::list<zmq::message_t>& job,
       return jsonify_error({106, action_str}, info, request);
     }
 
-    // Set the interrupt function
-    service_worker_t::set_interrupt(&interrupt_function);
+    // Requests outside of the region of this node are answered by the nodes of theirs
+    if (region_router) {
+      if (const auto* url = region_router->route(options)) {
+        return to_redirect(*url, http_request, info);
+      }
+    }
+
+    // Set the interrupt function, it also gives up on the request once its deadline has passed
+    set_deadline_interrupt(request, &interrupt_function);
+    // A request asked before doesnt need a slot to be answered from the cache
+    std::string cached;
+    if (response_cache && response_cache->find(request, *reader, cached)) {
+      return to_response(cached, info, request);
+    }
+    // Wait for a slot if the requests of the action are limited in how many run at once
+    auto admitted = admit(request, "loki_worker_t::");
 
     prime_server::worker_t::result_t result{
         true,
@@ -312,11 +539,16 @@ loki_worker_t::work(const std::list<zmq::message_t>& job,
         result.messages.emplace_back(request.SerializeAsString());
         break;
       case Options::height:
-        result = to_response(height(request), info, request);
+        result = to_response(height(request), info, request,
+                             request.options().format() == Options::binary ? worker::BINARY_MIME
+                                                                           : worker::JSON_MIME);
         break;
       case Options::transit_available:
         result = to_response(transit_available(request), info, request);
         break;
+      case Options::tile:
+        result = to_response(tile(request), info, request, worker::MVT_MIME, false, true);
+        break;
       case Options::status:
         status(request);
         result.messages.emplace_back(request.SerializeAsString());
@@ -350,13 +582,16 @@ void run_service(const boost::property_tree::ptree& config) {
 
   // listen for requests
   zmq::context_t context;
-  loki_worker_t loki_worker(config);
-  prime_server::worker_t worker(context, upstream_endpoint, downstream_endpoint, loopback_endpoint,
-                                interrupt_endpoint,
-                                std::bind(&loki_worker_t::work, std::ref(loki_worker),
-                                          std::placeholders::_1, std::placeholders::_2,
-                                          std::placeholders::_3),
-                                std::bind(&loki_worker_t::cleanup, std::ref(loki_worker)));
+  // a reloaded shared reader gets a new worker between requests
+  reloading_worker_t<loki_worker_t> loki_worker(
+      [&config]() { return new loki_worker_t(config, shared_graph_reader(config)); });
+  prime_server::worker_t worker(
+      context, upstream_endpoint, downstream_endpoint, loopback_endpoint, interrupt_endpoint,
+      [&loki_worker](const std::list<zmq::message_t>& job, void* request_info,
+                    const std::function<void()>& interrupt) {
+        return loki_worker.latest().work(job, request_info, interrupt);
+      },
+      [&loki_worker]() { loki_worker.current().cleanup(); });
   worker.work();
 
   // TODO: should we listen for SIGINT and terminate gracefully/exit(0)?
@@ -2,6 +2,8 @@
 #include "baldr/tilehierarchy.h"
 #include "meili/geometry_helpers.h"
 
+#include <robin_hood.h>
+
 using namespace valhalla::midgard;
 
 namespace valhalla {
@@ -34,9 +36,11 @@ CandidateCollector::WithinSquaredDistance(const midgard::PointLL& location,
                                           edgeid_iterator_t edgeid_end,
                                           const sif::cost_ptr_t& costing) const {
   std::vector<baldr::PathLocation> candidates;
-  std::unordered_set<baldr::GraphId> visited_nodes;
+  robin_hood::unordered_flat_set<baldr::GraphId, baldr::GraphIdHasher> visited_nodes;
   midgard::projector_t projector(location);
   graph_tile_ptr tile;
+  // the decoded shape of the edge, kept around to not allocate it for every edge
+  std::vector<midgard::PointLL> shape;
 
   for (auto it = edgeid_begin; it != edgeid_end; it++) {
     const auto& edgeid = *it;
@@ -59,11 +63,15 @@ CandidateCollector::WithinSquaredDistance(const midgard::PointLL& location,
     }
 
     // Get at the shape
-    auto shape = tile->edgeinfo(edge).lazy_shape();
-    if (shape.empty()) {
+    auto lazy_shape = tile->edgeinfo(edge).lazy_shape();
+    if (lazy_shape.empty()) {
       // Otherwise Project will fail
       continue;
     }
+    shape.clear();
+    while (!lazy_shape.empty()) {
+      shape.push_back(lazy_shape.pop());
+    }
 
     // Projection information
     midgard::PointLL point;
@@ -129,16 +137,24 @@ CandidateCollector::WithinSquaredDistance(const midgard::PointLL& location,
 }
 
 // Add each road linestring's line segments into grid. Only one side
-// of directed edges is added
+// of directed edges is added. When the bin is split into cells only the
+// edges touching the given ones are added
 void IndexBin(const graph_tile_ptr& tile,
               const int32_t bin_index,
+              const uint64_t cells,
               baldr::GraphReader& reader,
               CandidateGridQuery::grid_t& grid) {
   assert(tile);
 
-  // Get the edges within the specified bin.
+  // Get the edges within the specified bin and the cells they touch if the bin has them
   auto edge_ids = tile->GetBin(bin_index);
+  auto edge_cells = tile->GetBinCells(bin_index);
+  auto edge_cell = edge_cells.begin();
   for (const auto& edge_id : edge_ids) {
+    if (edge_cells.size() && !(*edge_cell++ & cells)) {
+      continue;
+    }
+
     // Get the right tile (edges in a bin can be in a different tile if they
     // pass through the tile but do not start or end in the tile). Skip if
     // tile is null.
@@ -164,31 +180,48 @@ void IndexBin(const graph_tile_ptr& tile,
 
 CandidateGridQuery::CandidateGridQuery(baldr::GraphReader& reader,
                                        float cell_width,
-                                       float cell_height)
-    : reader_(reader), cell_width_(cell_width), cell_height_(cell_height), grid_cache_() {
+                                       float cell_height,
+                                       size_t cache_size)
+    : reader_(reader), cell_width_(cell_width), cell_height_(cell_height),
+      grid_cache_(std::make_shared<grid_cache_t>(cache_size)) {
   bin_level_ = baldr::TileHierarchy::levels().back().level;
 }
 
 CandidateGridQuery::~CandidateGridQuery() = default;
 
-inline const CandidateGridQuery::grid_t*
-CandidateGridQuery::GetGrid(const int32_t bin_id,
-                            const Tiles<PointLL>& tiles,
-                            const Tiles<PointLL>& bins) const {
-  // Check if the bin is in the cache
-  const auto it = grid_cache_.find(bin_id);
-  if (it != grid_cache_.end()) {
-    return &(it->second);
+inline std::shared_ptr<const CandidateGridQuery::packed_grid_t>
+CandidateGridQuery::CachedGrid(const int64_t key) const {
+  std::shared_ptr<const packed_grid_t> grid;
+  std::lock_guard<std::mutex> lock(grid_cache_->lock);
+  grid_cache_->grids.find(key, grid);
+  return grid;
+}
+
+// the grid of a whole bin is cached under the bin id and the cells of a bin after it
+inline int64_t grid_key(const int32_t bin_id, const int32_t cell = -1) {
+  return (static_cast<int64_t>(bin_id) << 8) | (cell + 1);
+}
+
+inline void CandidateGridQuery::GetGrids(const int32_t bin_id,
+                                         const AABB2<PointLL>& range,
+                                         const Tiles<PointLL>& tiles,
+                                         const Tiles<PointLL>& bins) const {
+  // Check if the whole bin is in the cache
+  range_grids_.clear();
+  auto grid = CachedGrid(grid_key(bin_id));
+  if (grid) {
+    range_grids_.push_back(std::move(grid));
+    return;
   }
 
-  // Not in the cache. Get the tile and Index the bin within the tile.
+  // Not in the cache. Get the tile to see if the bin is split into cells.
   int32_t ndiv = tiles.nsubdivisions();
   auto rc = bins.GetRowColumn(bin_id);
   int32_t tile_id = tiles.TileId(rc.second / ndiv, rc.first / ndiv);
   baldr::GraphId tileid(tile_id, bin_level_, 0);
   auto tile = reader_.GetGraphTile(tileid);
   if (!tile) {
-    return nullptr;
+    return;
   }
 
   // Compute bin index within the tile (row-ordered)
@@ -196,14 +229,34 @@ CandidateGridQuery::GetGrid(const int32_t bin_id,
   int32_t bin_col = rc.second % ndiv;
   int32_t bin_index = (bin_row * ndiv) + bin_col;
 
-  // Insert the bin into the cache and index the bin
-  const auto inserted =
-      grid_cache_.emplace(bin_id, grid_t(tile->BoundingBox(), cell_width_, cell_height_));
-  IndexBin(tile, bin_index, reader_, inserted.first->second);
-  return &(inserted.first->second);
+  // Index the bin and pack it outside of the lock, if another query got there first in the mean
+  // time we replace its grid with the same one
+  auto index = [this, &tile, bin_index](const int64_t key, const uint64_t cells) {
+    grid_t unpacked(tile->BoundingBox(), cell_width_, cell_height_);
+    IndexBin(tile, bin_index, cells, reader_, unpacked);
+    auto grid = std::make_shared<const packed_grid_t>(unpacked);
+    std::lock_guard<std::mutex> lock(grid_cache_->lock);
+    grid_cache_->grids.insert(key, grid);
+    return grid;
+  };
+  auto depth = tile->GetBinCellDepth(bin_index);
+  if (!depth) {
+    range_grids_.push_back(index(grid_key(bin_id), ~uint64_t(0)));
+    return;
+  }
+
+  // A dense bin is indexed one cell at a time and only where the range touches it
+  auto cells = baldr::GraphTile::BinCellMask(tile->BinBoundingBox(bin_index), depth, range);
+  for (int32_t cell = 0; cells; ++cell, cells >>= 1) {
+    if (cells & 1) {
+      grid = CachedGrid(grid_key(bin_id, cell));
+      range_grids_.push_back(grid ? std::move(grid)
+                                  : index(grid_key(bin_id, cell), uint64_t(1) << cell));
+    }
+  }
 }
 
-std::unordered_set<baldr::GraphId>
+const std::vector<baldr::GraphId>&
 CandidateGridQuery::RangeQuery(const AABB2<midgard::PointLL>& range) const {
   // Get the tiles object from the tile hierarchy and create the bin tiles
   // (subdivisions within the tile)
@@ -212,18 +265,20 @@ CandidateGridQuery::RangeQuery(const AABB2<midgard::PointLL>& range) const {
 
   // Get a list of bins within the range. These are "tile Ids" that must
   // be resolved to a Graph Id (tile) / bin combination
-  auto bin_list = bins.TileList(range);
-
-  // Iterate through the bins and query grids to get results
-  std::unordered_set<baldr::GraphId> result;
-  for (auto bin_id : bin_list) {
-    auto grid = GetGrid(bin_id, tiles, bins);
-    if (grid) {
-      const auto set = grid->Query(range);
-      result.insert(set.begin(), set.end());
+  bins.TileList(range, bin_list_);
+
+  // Iterate through the bins and query grids to get results. An edge is in every square it passes
+  // through so we drop the duplicates afterwards rather than hashing every one of them
+  range_edges_.clear();
+  for (auto bin_id : bin_list_) {
+    GetGrids(bin_id, range, tiles, bins);
+    for (const auto& grid : range_grids_) {
+      grid->Visit(range, [this](const baldr::GraphId& edge_id) { range_edges_.push_back(edge_id); });
     }
   }
-  return result;
+  std::sort(range_edges_.begin(), range_edges_.end());
+  range_edges_.erase(std::unique(range_edges_.begin(), range_edges_.end()), range_edges_.end());
+  return range_edges_;
 }
 
 std::vector<baldr::PathLocation> CandidateGridQuery::Query(const midgard::PointLL& location,
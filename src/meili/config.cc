@@ -83,6 +83,11 @@ void Config::TransitionCost::Read(const boost::property_tree::ptree& params) {
   if (const auto node = params.get_child_optional("customizable")) {
     is_turn_penalty_factor_customizable = FindValue(*node, "turn_penalty_factor");
   }
+
+  ReadParamOptional(cache_size, params, "transition_cache.size");
+  ReadParamOptional(cache_percent_buckets, params, "transition_cache.percent_buckets");
+  CHECK_THROWS(cache_percent_buckets > 0,
+               POSITIVE_VALUE_MSG(cache_percent_buckets, "transition_cache.percent_buckets"));
 }
 
 void Config::EmissionCost::Read(const boost::property_tree::ptree& params) {
@@ -103,6 +108,25 @@ void Config::Routing::Read(const boost::property_tree::ptree& params) {
   CHECK_THROWS(interpolation_distance_meters > 0.f,
                POSITIVE_VALUE_MSG(interpolation_distance_meters, "interpolation_distance"));
 
+  ReadParamOptional(adaptive_interpolation_distance_meters, params,
+                    "default.adaptive_interpolation_distance");
+  CHECK_THROWS(adaptive_interpolation_distance_meters >= 0.f,
+               NONNEGATIVE_VALUE_MSG(adaptive_interpolation_distance_meters,
+                                     "adaptive_interpolation_distance"));
+
+  ReadParamOptional(adaptive_interpolation_seconds, params, "default.adaptive_interpolation_seconds");
+  CHECK_THROWS(adaptive_interpolation_seconds > 0.f,
+               POSITIVE_VALUE_MSG(adaptive_interpolation_seconds, "adaptive_interpolation_seconds"));
+
+  ReadParamOptional(adaptive_interpolation_heading_change, params,
+                    "default.adaptive_interpolation_heading_change");
+  CHECK_THROWS(adaptive_interpolation_heading_change >= 0.f,
+               NONNEGATIVE_VALUE_MSG(adaptive_interpolation_heading_change,
+                                     "adaptive_interpolation_heading_change"));
+
+  ReadParamOptional(adaptive_interpolation_max_candidates, params,
+                    "default.adaptive_interpolation_max_candidates");
+
   if (const auto node = params.get_child_optional("customizable")) {
     is_interpolation_distance_customizable = FindValue(*node, "interpolation_distance");
   }
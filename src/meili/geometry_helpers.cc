@@ -17,38 +17,33 @@ namespace helpers {
 // snapped point, squared distance, segment index, offset
 std::tuple<PointLL, double, typename std::vector<PointLL>::size_type, double>
 Project(const projector_t& p, Shape7Decoder<midgard::PointLL>& shape, double snap_distance) {
-  PointLL first_point(shape.pop());
+  std::vector<PointLL> points;
+  while (!shape.empty()) {
+    points.emplace_back(shape.pop());
+  }
+  return Project(p, points, snap_distance);
+}
+
+// snapped point, squared distance, segment index, offset
+std::tuple<PointLL, double, typename std::vector<PointLL>::size_type, double>
+Project(const projector_t& p, const std::vector<PointLL>& shape, double snap_distance) {
+  const auto& first_point = shape.front();
   auto closest_point = first_point;
-  auto closest_segment_point = first_point;
-  double closest_distance = std::numeric_limits<double>::max();
-  size_t closest_segment = 0;
+  double closest_distance;
+  size_t closest_segment = p.closest(shape.data(), shape.size(), closest_point, closest_distance);
+
+  // the length of the edge and of the part of it before the closest segment
   double closest_partial_length = 0.0;
   double total_length = 0.0;
-
-  // for each segment
-  auto u = first_point;
   size_t i = 0;
-  for (; !shape.empty(); ++i) {
-    // project a onto b where b is the origin vector representing this segment
-    // and a is the origin vector to the point we are projecting, (a.b/b.b)*b
-    auto v = shape.pop();
-
-    auto projection = p(u, v);
-
-    // check if this point is better
-    const auto distance = p.approx.DistanceSquared(projection);
-    if (distance < closest_distance) {
-      closest_point = std::move(projection);
-      closest_distance = distance;
-      closest_segment = i;
+  for (; i + 1 < shape.size(); ++i) {
+    if (i == closest_segment) {
       closest_partial_length = total_length;
-      closest_segment_point = u;
     }
-
-    // total edge length
-    total_length += u.Distance(v);
-    u = v;
+    total_length += shape[i].Distance(shape[i + 1]);
   }
+  const auto& closest_segment_point = shape[closest_segment];
+  const auto& u = shape.back();
 
   // percent_along is a double between 0 and 1 representing the location of
   // the closest point on LineString to the given Point, as a fraction
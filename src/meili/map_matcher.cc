@@ -9,6 +9,7 @@
 #include "worker.h"
 
 #include <array>
+#include <chrono>
 
 namespace {
 
@@ -17,6 +18,10 @@ using namespace valhalla::meili;
 
 constexpr float MAX_ACCUMULATED_COST = 99999999.f;
 
+inline double seconds_since(const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
 inline float GreatCircleDistanceSquared(const Measurement& left, const Measurement& right) {
   return left.lnglat().DistanceSquared(right.lnglat());
 }
@@ -259,7 +264,9 @@ MatchResult FindMatchResult(const MapMatcher& mapmatcher,
   // Because of node routing in meili we must loop back over the previous path. In most cases the loop
   // is a single iteration but in rare cases (node to node trivial routes) we need to explore states
   // that are older than the immediate previous state
-  for (StateId::Time t = time; t > 0 && !prev_edge.Is_Valid(); --t) {
+  // The states of the previous times may have been forgotten by an online match already
+  const auto earliest = mapmatcher.state_container().forgotten_time();
+  for (StateId::Time t = time; t > earliest && !prev_edge.Is_Valid(); --t) {
     // If there is no path from t - 1
     const auto& prev_state_id = stateids[t - 1];
     if (!prev_state_id.IsValid()) {
@@ -502,9 +509,11 @@ MapMatcher::MapMatcher(const Config& config,
                              container_,
                              mode_costing_,
                              travelmode_,
-                             config_.transition_cost) {
-  vs_.set_emission_cost_model(emission_cost_model_);
-  vs_.set_transition_cost_model(transition_cost_model_);
+                             config_.transition_cost),
+      online_emitted_(0), online_interpolated_epoch_time_(-1) {
+  // the search calls the models of the matcher so that what they cache is ours to clear
+  vs_.set_emission_cost_model(std::cref(emission_cost_model_));
+  vs_.set_transition_cost_model(std::cref(transition_cost_model_));
 }
 
 MapMatcher::~MapMatcher() {
@@ -513,10 +522,16 @@ MapMatcher::~MapMatcher() {
 void MapMatcher::Clear() {
   vs_.Clear();
   // reset cost models because they were possibly replaced by topk
-  vs_.set_emission_cost_model(emission_cost_model_);
-  vs_.set_transition_cost_model(transition_cost_model_);
+  vs_.set_emission_cost_model(std::cref(emission_cost_model_));
+  vs_.set_transition_cost_model(std::cref(transition_cost_model_));
   ts_.Clear();
   container_.Clear();
+  emission_cost_model_.Clear();
+  transition_cost_model_.Clear();
+  online_emitted_ = 0;
+  online_path_.clear();
+  online_interpolated_.clear();
+  online_interpolated_epoch_time_ = -1;
 }
 
 void MapMatcher::RemoveRedundancies(const std::vector<StateId>& result,
@@ -712,6 +727,11 @@ std::vector<MatchResults> MapMatcher::OfflineMatch(const std::vector<Measurement
     throw valhalla_exception_t{443};
   }
 
+  // Everything from here on but forming the results and routing is the search
+  const auto search_start = std::chrono::steady_clock::now();
+  const auto routing_before = transition_cost_model_.routing_seconds();
+  double results_seconds = 0;
+
   // For k paths
   std::vector<StateId> state_ids;
   state_ids.reserve(container_.size());
@@ -749,6 +769,7 @@ std::vector<MatchResults> MapMatcher::OfflineMatch(const std::vector<Measurement
     }
 
     // Get back the real state ids in order
+    const auto results_start = std::chrono::steady_clock::now();
     std::vector<StateId> original_state_ids;
     original_state_ids.reserve(state_ids.size());
     for (auto s_itr = state_ids.rbegin(); s_itr != state_ids.rend(); ++s_itr) {
@@ -789,6 +810,7 @@ std::vector<MatchResults> MapMatcher::OfflineMatch(const std::vector<Measurement
     // Construct a result
     auto segments = ConstructRoute(*this, best_path);
     MatchResults match_results(std::move(best_path), std::move(segments), accumulated_cost);
+    results_seconds += seconds_since(results_start);
 
     // We'll keep it if we don't have a duplicate already
     auto found_path = std::find(best_paths.rbegin(), best_paths.rend(), match_results);
@@ -811,6 +833,10 @@ std::vector<MatchResults> MapMatcher::OfflineMatch(const std::vector<Measurement
     }
   }
 
+  timings_.results += results_seconds;
+  timings_.viterbi += seconds_since(search_start) - results_seconds -
+                      (transition_cost_model_.routing_seconds() - routing_before);
+
   if (!(0 < best_paths.size() && best_paths.size() <= k)) {
     throw std::logic_error("got " + std::to_string(best_paths.size()) +
                            " paths but k = " + std::to_string(k));
@@ -820,12 +846,178 @@ std::vector<MatchResults> MapMatcher::OfflineMatch(const std::vector<Measurement
   return best_paths;
 }
 
+std::vector<MatchResult> MapMatcher::OnlineMatch(const std::vector<Measurement>& measurements,
+                                                 uint32_t max_lag) {
+  for (const auto& measurement : measurements) {
+    AppendOnlineMeasurement(measurement, false);
+  }
+  if (container_.size() == 0) {
+    return {};
+  }
+
+  // Continue the search to the latest measurement and see how much of its best path is settled
+  const auto search_start = std::chrono::steady_clock::now();
+  const auto routing_before = transition_cost_model_.routing_seconds();
+  const StateId::Time last = container_.size() - 1;
+  TraceOnlinePath(last);
+  const StateId::Time forced = last > max_lag ? last - max_lag : 0;
+  const auto end = std::max(OnlineFinalTime(last), forced);
+  timings_.viterbi +=
+      seconds_since(search_start) - (transition_cost_model_.routing_seconds() - routing_before);
+  return EmitOnlineResults(end);
+}
+
+std::vector<MatchResult> MapMatcher::FinishOnlineMatch() {
+  // Like the offline match we always match the last measurement
+  if (container_.size() != 0) {
+    auto it = online_interpolated_.find(container_.size() - 1);
+    if (it != online_interpolated_.end()) {
+      const auto measurement = it->second.back();
+      it->second.pop_back();
+      online_interpolated_epoch_time_ = it->second.empty() ? -1 : it->second.back().epoch_time();
+      if (it->second.empty()) {
+        online_interpolated_.erase(it);
+      }
+      AppendOnlineMeasurement(measurement, true);
+    }
+  }
+
+  std::vector<MatchResult> results;
+  if (container_.size() != 0) {
+    const auto search_start = std::chrono::steady_clock::now();
+    const auto routing_before = transition_cost_model_.routing_seconds();
+    const StateId::Time last = container_.size() - 1;
+    TraceOnlinePath(last);
+    timings_.viterbi +=
+        seconds_since(search_start) - (transition_cost_model_.routing_seconds() - routing_before);
+    results = EmitOnlineResults(last + 1);
+  }
+  Clear();
+  return results;
+}
+
+void MapMatcher::AppendOnlineMeasurement(const Measurement& measurement, bool always_match) {
+  const float sq_max_search_radius = config_.candidate_search.max_search_radius_meters *
+                                     config_.candidate_search.max_search_radius_meters;
+
+  // Always match the first measurement
+  if (container_.size() == 0) {
+    AppendMeasurement(measurement, sq_max_search_radius);
+    return;
+  }
+
+  // If its close to the last match we will just interpolate it
+  const StateId::Time time = container_.size() - 1;
+  const auto last = container_.measurement(time).lnglat();
+  if (!always_match && Interpolates(time, measurement)) {
+    online_interpolated_[time].push_back(measurement);
+    online_interpolated_epoch_time_ = measurement.epoch_time();
+    return;
+  }
+
+  // If the trace lingered around the last match use the time it left, see AppendMeasurements
+  if (online_interpolated_epoch_time_ != -1) {
+    auto p = online_interpolated_[time].back().lnglat().Project(last, measurement.lnglat());
+    if (p.Distance(last) / last.Distance(measurement.lnglat()) < .2f) {
+      container_.SetMeasurementLeaveTime(time, online_interpolated_epoch_time_);
+    }
+  }
+  AppendMeasurement(measurement, sq_max_search_radius);
+  online_interpolated_epoch_time_ = -1;
+}
+
+// Trace the best path to the latest measurement back to where the returned results end
+void MapMatcher::TraceOnlinePath(StateId::Time last) {
+  online_path_.resize(container_.size());
+  auto stateid = vs_.SearchWinner(last);
+  for (auto time = last + 1; time-- > online_emitted_;) {
+    online_path_[time] = stateid;
+    if (time == 0) {
+      break;
+    }
+    // Across a discontinuity the path goes on from the winner before it
+    const auto predecessor = vs_.Predecessor(stateid);
+    stateid = predecessor.IsValid() ? predecessor : vs_.SearchWinner(time - 1);
+  }
+}
+
+// Find the time before which the best path can no longer change. The states the search scanned
+// before the state at the latest time are the hypotheses which are still cheaper than the best
+// path, once their paths meet in one state there is only one way left to get there
+StateId::Time MapMatcher::OnlineFinalTime(StateId::Time last) const {
+  if (last <= online_emitted_) {
+    return online_emitted_;
+  }
+
+  std::vector<StateId> stateids;
+  for (const auto& state : container_.column(last - 1)) {
+    if (vs_.AccumulatedCost(state.stateid()) >= 0) {
+      stateids.push_back(state.stateid());
+    }
+  }
+
+  for (auto time = last - 1; time > online_emitted_; --time) {
+    if (stateids.size() <= 1) {
+      return time;
+    }
+    std::vector<StateId> predecessors;
+    for (const auto& stateid : stateids) {
+      const auto predecessor = vs_.Predecessor(stateid);
+      if (predecessor.IsValid() &&
+          std::find(predecessors.cbegin(), predecessors.cend(), predecessor) ==
+              predecessors.cend()) {
+        predecessors.push_back(predecessor);
+      }
+    }
+    // They all start at this time after a discontinuity so nothing before it can change
+    if (predecessors.empty()) {
+      return time;
+    }
+    stateids.swap(predecessors);
+  }
+  return online_emitted_;
+}
+
+// Get the match results of the path from where the returned results end until the given time
+std::vector<MatchResult> MapMatcher::EmitOnlineResults(StateId::Time end) {
+  const auto results_start = std::chrono::steady_clock::now();
+  std::vector<MatchResult> results;
+  for (auto time = online_emitted_; time < end; ++time) {
+    results.push_back(FindMatchResult(*this, online_path_, time, graphreader_));
+
+    // Interpolate the points between this and the next state
+    const auto it = online_interpolated_.find(time);
+    if (it == online_interpolated_.end()) {
+      continue;
+    }
+    const auto has_next = time + 1 < online_path_.size();
+    const auto& next_stateid = has_next ? online_path_[time + 1] : StateId();
+    const auto last_result =
+        has_next ? FindMatchResult(*this, online_path_, time + 1, graphreader_) : results.back();
+    const auto interpolated_results =
+        InterpolateMeasurements(*this, it->second, online_path_[time], next_stateid,
+                                results.back(), last_result);
+    results.insert(results.cend(), interpolated_results.cbegin(), interpolated_results.cend());
+    online_interpolated_.erase(it);
+  }
+  online_emitted_ = std::max(online_emitted_, end);
+  timings_.results += seconds_since(results_start);
+
+  // Everything before the results is final so there is no need to keep its states around, the
+  // state before the next result is still needed to find where its path comes from
+  if (online_emitted_ > 1) {
+    vs_.Forget(online_emitted_ - 1);
+    container_.Forget(online_emitted_ - 1);
+    emission_cost_model_.Forget(online_emitted_ - 1);
+    transition_cost_model_.Forget(online_emitted_ - 1);
+  }
+  return results;
+}
+
 std::unordered_map<StateId::Time, std::vector<Measurement>>
 MapMatcher::AppendMeasurements(const std::vector<Measurement>& measurements) {
   const float sq_max_search_radius = config_.candidate_search.max_search_radius_meters *
                                      config_.candidate_search.max_search_radius_meters;
-  const float sq_interpolation_distance =
-      config_.routing.interpolation_distance_meters * config_.routing.interpolation_distance_meters;
   std::unordered_map<StateId::Time, std::vector<Measurement>> interpolated;
 
   // Always match the first measurement
@@ -833,9 +1025,8 @@ MapMatcher::AppendMeasurements(const std::vector<Measurement>& measurements) {
   auto time = AppendMeasurement(*last, sq_max_search_radius);
   double interpolated_epoch_time = -1;
   for (auto m = std::next(last); m != measurements.end(); ++m) {
-    const auto sq_distance = GreatCircleDistanceSquared(*last, *m);
     // Always match the last measurement and if its far enough away
-    if (sq_interpolation_distance < sq_distance || std::next(m) == measurements.end()) {
+    if (!Interpolates(time, *m) || std::next(m) == measurements.end()) {
       // If there were interpolated points between these two points with time information
       if (interpolated_epoch_time != -1) {
         // Project the last interpolated point onto the line between the two match points
@@ -866,6 +1057,42 @@ MapMatcher::AppendMeasurements(const std::vector<Measurement>& measurements) {
   return interpolated;
 }
 
+bool MapMatcher::Interpolates(const StateId::Time time, const Measurement& measurement) const {
+  const auto& routing = config_.routing;
+  const auto& last = container_.measurement(time);
+  const auto sq_distance = GreatCircleDistanceSquared(last, measurement);
+  if (sq_distance <= routing.interpolation_distance_meters * routing.interpolation_distance_meters) {
+    return true;
+  }
+
+  // Past the interpolation distance we need to know where the trace was heading and the roads
+  // around the last match have to be sparse or we could skip over a turn
+  if (routing.adaptive_interpolation_distance_meters <= routing.interpolation_distance_meters ||
+      time == 0 || container_.column(time).size() > routing.adaptive_interpolation_max_candidates) {
+    return false;
+  }
+
+  // The trace has to keep going the way it came to the last match
+  const auto& before = container_.measurement(time - 1);
+  auto change = std::abs(before.lnglat().Heading(last.lnglat()) -
+                         last.lnglat().Heading(measurement.lnglat()));
+  change = std::min(change, 360. - change);
+  if (change > routing.adaptive_interpolation_heading_change) {
+    return false;
+  }
+
+  // The faster the trace goes the farther it may go, without times we allow all of it
+  auto distance = routing.adaptive_interpolation_distance_meters;
+  const auto elapsed = measurement.epoch_time() - last.epoch_time();
+  if (last.epoch_time() >= 0 && elapsed > 0) {
+    const auto speed = std::sqrt(sq_distance) / elapsed;
+    distance = std::min(distance, std::max(routing.interpolation_distance_meters,
+                                           static_cast<float>(speed) *
+                                               routing.adaptive_interpolation_seconds));
+  }
+  return sq_distance <= distance * distance;
+}
+
 StateId::Time MapMatcher::AppendMeasurement(const Measurement& measurement,
                                             const float sq_max_search_radius) {
   // Test interrupt
@@ -876,8 +1103,10 @@ StateId::Time MapMatcher::AppendMeasurement(const Measurement& measurement,
   auto sq_radius = std::min(sq_max_search_radius,
                             std::max(measurement.sq_search_radius(), measurement.sq_gps_accuracy()));
 
+  const auto search_start = std::chrono::steady_clock::now();
   const auto& candidates =
       candidatequery_.Query(measurement.lnglat(), measurement.stop_type(), sq_radius, costing());
+  timings_.candidate_search += seconds_since(search_start);
 
   const auto time = container_.AppendMeasurement(measurement);
 
@@ -2,6 +2,7 @@
 
 #include "baldr/graphreader.h"
 #include "baldr/tilehierarchy.h"
+#include "midgard/util.h"
 #include "sif/autocost.h"
 #include "sif/bicyclecost.h"
 #include "sif/costconstants.h"
@@ -32,7 +33,11 @@ MapMatcherFactory::MapMatcherFactory(const boost::property_tree::ptree& root,
     graphreader_.reset(new baldr::GraphReader(root.get_child("mjolnir")));
   candidatequery_.reset(
       new CandidateGridQuery(*graphreader_, local_tile_size() / config_.candidate_search.grid_size,
-                             local_tile_size() / config_.candidate_search.grid_size));
+                             local_tile_size() / config_.candidate_search.grid_size,
+                             config_.candidate_search.cache_size));
+  transition_cache_ =
+      std::make_shared<TransitionCache>(config_.transition_cost.cache_size,
+                                        config_.transition_cost.cache_percent_buckets);
 }
 
 MapMatcherFactory::~MapMatcherFactory() {
@@ -48,7 +53,19 @@ MapMatcher* MapMatcherFactory::Create(const Options& options) {
   mode_costing_[static_cast<uint32_t>(mode)] = cost;
 
   // TODO investigate exception safety
-  return new MapMatcher(config, *graphreader_, *candidatequery_, mode_costing_, mode);
+  auto* matcher = new MapMatcher(config, *graphreader_, *candidatequery_, mode_costing_, mode);
+
+  // The paths between candidates depend on the costing, its options and the turn costs
+  if (transition_cache_->capacity()) {
+    const auto costing_index = static_cast<int>(options.costing());
+    size_t costing_key = costing_index;
+    if (costing_index < options.costing_options_size()) {
+      midgard::hash_combine(costing_key, options.costing_options(costing_index).SerializeAsString());
+    }
+    midgard::hash_combine(costing_key, config.transition_cost.turn_penalty_factor);
+    matcher->set_transition_cache(transition_cache_, costing_key);
+  }
+  return matcher;
 }
 
 Config MapMatcherFactory::MergeConfig(const Options& options) const {
@@ -81,15 +98,13 @@ void MapMatcherFactory::ClearFullCache() {
   if (graphreader_->OverCommitted()) {
     graphreader_->Trim();
   }
-
-  if (candidatequery_->size() > config_.candidate_search.cache_size) {
-    candidatequery_->Clear();
-  }
+  // the candidate grids evict the least recently used ones on their own
 }
 
 void MapMatcherFactory::ClearCache() {
   graphreader_->Clear();
   candidatequery_->Clear();
+  transition_cache_->Clear();
 }
 
 } // namespace meili
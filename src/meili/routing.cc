@@ -1,5 +1,6 @@
+#include <algorithm>
+#include <array>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include "baldr/graphid.h"
@@ -172,6 +173,13 @@ inline bool IsEdgeAllowed(const baldr::DirectedEdge* edge,
   return valid_pred || !restricted;
 }
 
+// Add a destination to the ones at a node or along an edge unless its there already
+inline void add_dest(std::vector<uint16_t>& dests, uint16_t dest) {
+  if (std::find(dests.cbegin(), dests.cend(), dest) == dests.cend()) {
+    dests.push_back(dest);
+  }
+}
+
 /**
  * Set origin.
  */
@@ -227,32 +235,42 @@ void set_origin(baldr::GraphReader& reader,
  * itself, which we can then use to route directly to the (right + 1)th column effectively skipping
  * the right column as an outlier
  */
-void set_destinations(baldr::GraphReader& reader,
-                      const std::vector<baldr::PathLocation>& destinations,
-                      std::unordered_map<baldr::GraphId, std::unordered_set<uint16_t>>& node_dests,
-                      std::unordered_map<baldr::GraphId, std::unordered_set<uint16_t>>& edge_dests) {
+void set_destination(baldr::GraphReader& reader,
+                     const std::vector<baldr::PathLocation>& destinations,
+                     uint16_t dest,
+                     DestinationIndex& index) {
   graph_tile_ptr tile;
-  for (uint16_t dest = 0; dest < destinations.size(); dest++) {
-    for (const auto& edge : destinations[dest].edges) {
-      if (edge.begin_node()) {
-        auto edge_nodes = reader.GetDirectedEdgeNodes(edge.id, tile);
-        const auto nodeid = edge_nodes.first;
-        if (!nodeid.Is_Valid()) {
-          continue;
-        }
-        node_dests[nodeid].insert(dest);
-      } else if (edge.end_node()) {
-        auto edge_nodes = reader.GetDirectedEdgeNodes(edge.id, tile);
-        const auto nodeid = edge_nodes.second;
-        if (!nodeid.Is_Valid()) {
-          continue;
-        }
-        node_dests[nodeid].insert(dest);
-      } else {
-        edge_dests[edge.id].insert(dest);
+  bool along_edge = false;
+  for (const auto& edge : destinations[dest].edges) {
+    if (edge.begin_node()) {
+      auto edge_nodes = reader.GetDirectedEdgeNodes(edge.id, tile);
+      const auto nodeid = edge_nodes.first;
+      if (!nodeid.Is_Valid()) {
+        continue;
+      }
+      add_dest(index.node_dests[nodeid], dest);
+    } else if (edge.end_node()) {
+      auto edge_nodes = reader.GetDirectedEdgeNodes(edge.id, tile);
+      const auto nodeid = edge_nodes.second;
+      if (!nodeid.Is_Valid()) {
+        continue;
       }
+      add_dest(index.node_dests[nodeid], dest);
+    } else {
+      add_dest(index.edge_dests[edge.id], dest);
+      along_edge = true;
     }
   }
+  index.edge_dest_count += along_edge;
+}
+
+DestinationIndex::DestinationIndex(baldr::GraphReader& reader,
+                                   const std::vector<baldr::PathLocation>& destinations,
+                                   uint16_t first,
+                                   uint16_t last) {
+  for (uint16_t dest = first; dest < last; dest++) {
+    set_destination(reader, destinations, dest, *this);
+  }
 }
 
 /**
@@ -358,14 +376,57 @@ find_shortest_path(baldr::GraphReader& reader,
                    const float turn_cost_table[181],
                    const float max_dist,
                    const float max_time) {
+  DestinationIndex index;
+  for (uint16_t dest = 0; dest < destinations.size(); dest++) {
+    if (dest != origin_idx) {
+      set_destination(reader, destinations, dest, index);
+    }
+  }
+  return find_shortest_path(reader, destinations, origin_idx, index, labelset, approximator,
+                            search_radius, costing, edgelabel, turn_cost_table, max_dist, max_time);
+}
+
+std::unordered_map<uint16_t, uint32_t>
+find_shortest_path(baldr::GraphReader& reader,
+                   const std::vector<baldr::PathLocation>& destinations,
+                   uint16_t origin_idx,
+                   const DestinationIndex& index,
+                   labelset_ptr_t labelset,
+                   const midgard::DistanceApproximator<midgard::PointLL>& approximator,
+                   const float search_radius,
+                   sif::cost_ptr_t costing,
+                   const Label* edgelabel,
+                   const float turn_cost_table[181],
+                   const float max_dist,
+                   const float max_time) {
   Label label;
   const sif::TravelMode travelmode = costing->travel_mode();
 
-  // Destinations along edges
-  std::unordered_map<baldr::GraphId, std::unordered_set<uint16_t>> edge_dests;
-
-  // Destinations at nodes
-  std::unordered_map<baldr::GraphId, std::unordered_set<uint16_t>> node_dests;
+  // The origin is a destination too but its the only one which differs between the searches
+  DestinationIndex origin_index;
+  set_destination(reader, destinations, origin_idx, origin_index);
+  const std::array<const DestinationIndex*, 2> indexes{{&index, &origin_index}};
+
+  // Rather than erasing the destinations from the shared index we count what is left to find
+  std::vector<bool> found(destinations.size(), false);
+  size_t nodes_left = index.node_dests.size() + origin_index.node_dests.size();
+  size_t edge_dests_left = index.edge_dest_count + origin_index.edge_dest_count;
+
+  // Visit the destinations along an edge which are yet to be found
+  const auto for_each_edge_dest = [&indexes, &found](const baldr::GraphId& edgeid,
+                                                     const auto& visit) {
+    for (const auto* dest_index : indexes) {
+      const auto it = dest_index->edge_dests.find(edgeid);
+      if (it == dest_index->edge_dests.cend()) {
+        continue;
+      }
+      for (const auto dest : it->second) {
+        if (!found[dest]) {
+          visit(dest);
+        }
+      }
+    }
+  };
 
   // Lambda for heuristic
   float search_rad2 = search_radius * search_radius;
@@ -421,27 +482,24 @@ find_shortest_path(baldr::GraphReader& reader,
 
       // If destinations found along the edge, add segments to each
       // destination to the queue
-      const auto it = edge_dests.find(edgeid);
-      if (it != edge_dests.end()) {
-        for (const auto dest : it->second) {
-          for (const auto& edge : destinations[dest].edges) {
-            if (edge.id == edgeid) {
-              // Get cost - use EdgeCost to get time along the edge.
-              // Override cost portion to be distance. Heuristic cost from a
-              // destination to itself must be 0, so sortcost = cost
-              sif::Cost cost(label.cost().cost + directededge->length() * edge.percent_along,
-                             label.cost().secs +
-                                 costing->EdgeCost(directededge, tile).secs * edge.percent_along);
-              // We only add the labels if we are under the limits for
-              // distance and for time or time limit is 0
-              if (cost.cost < max_dist && (max_time < 0 || cost.secs < max_time)) {
-                labelset->put(dest, edgeid, 0.f, edge.percent_along, cost, turn_cost, cost.cost,
-                              label_idx, directededge, travelmode, restriction_idx);
-              }
+      for_each_edge_dest(edgeid, [&](const uint16_t dest) {
+        for (const auto& edge : destinations[dest].edges) {
+          if (edge.id == edgeid) {
+            // Get cost - use EdgeCost to get time along the edge.
+            // Override cost portion to be distance. Heuristic cost from a
+            // destination to itself must be 0, so sortcost = cost
+            sif::Cost cost(label.cost().cost + directededge->length() * edge.percent_along,
+                           label.cost().secs +
+                               costing->EdgeCost(directededge, tile).secs * edge.percent_along);
+            // We only add the labels if we are under the limits for
+            // distance and for time or time limit is 0
+            if (cost.cost < max_dist && (max_time < 0 || cost.secs < max_time)) {
+              labelset->put(dest, edgeid, 0.f, edge.percent_along, cost, turn_cost, cost.cost,
+                            label_idx, directededge, travelmode, restriction_idx);
             }
           }
         }
-      }
+      });
 
       // Get the end node tile and nodeinfo (to compute heuristic)
       graph_tile_ptr endtile =
@@ -473,9 +531,6 @@ find_shortest_path(baldr::GraphReader& reader,
   // Load origin to the queue of the labelset
   set_origin(reader, destinations, origin_idx, labelset, travelmode, costing, edgelabel);
 
-  // Load destinations
-  set_destinations(reader, destinations, node_dests, edge_dests);
-
   // TODO: use faster unordered_map impl like matrix PR does
   std::unordered_map<uint16_t, uint32_t> results;
   while (true) {
@@ -493,16 +548,18 @@ find_shortest_path(baldr::GraphReader& reader,
       // If this node is a destination, path to destinations at this
       // node is found: remember them and remove this node from the
       // destination list
-      const auto it = node_dests.find(label.nodeid());
-      if (it != node_dests.end()) {
-        for (const auto dest : it->second) {
-          results[dest] = label_idx;
+      for (const auto* dest_index : indexes) {
+        const auto it = dest_index->node_dests.find(label.nodeid());
+        if (it != dest_index->node_dests.cend()) {
+          for (const auto dest : it->second) {
+            results[dest] = label_idx;
+          }
+          --nodes_left;
         }
-        node_dests.erase(it);
       }
 
       // Congrats!
-      if (node_dests.empty() && edge_dests.empty()) {
+      if (nodes_left == 0 && edge_dests_left == 0) {
         LOG_TRACE("The last node destination was found");
         break;
       }
@@ -515,18 +572,13 @@ find_shortest_path(baldr::GraphReader& reader,
       // remove the destination from the destination list
       const auto destination_idx = label.dest();
       results[destination_idx] = label_idx;
-      for (const auto& edge : destinations[destination_idx].edges) {
-        const auto it = edge_dests.find(edge.id);
-        if (it != edge_dests.end()) {
-          it->second.erase(destination_idx);
-          if (it->second.empty()) {
-            edge_dests.erase(it);
-          }
-        }
+      if (!found[destination_idx]) {
+        found[destination_idx] = true;
+        --edge_dests_left;
       }
 
       // Congrats!
-      if (edge_dests.empty() && node_dests.empty()) {
+      if (edge_dests_left == 0 && nodes_left == 0) {
         LOG_TRACE("The last edge destination was found");
         break;
       }
@@ -566,7 +618,7 @@ find_shortest_path(baldr::GraphReader& reader,
 
         // All destinations on this origin edge
         float turn_cost = label.turn_cost();
-        for (const auto other_dest : edge_dests[origin_edge.id]) {
+        for_each_edge_dest(origin_edge.id, [&](const uint16_t other_dest) {
           // All edges of this destination
           for (const auto& destination_edge : destinations[other_dest].edges) {
             if (origin_edge.id == destination_edge.id &&
@@ -587,7 +639,7 @@ find_shortest_path(baldr::GraphReader& reader,
               }
             }
           }
-        }
+        });
 
         // Get cost - use EdgeCost to get time along the edge. Override
         // cost portion to be distance. The heuristic cost from a
@@ -0,0 +1,46 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "midgard/util.h"
+
+#include "meili/transition_cache.h"
+
+namespace valhalla {
+namespace meili {
+
+size_t TransitionCache::key_hasher_t::operator()(const key_t& key) const {
+  size_t seed = key.costing;
+  midgard::hash_combine(seed, key.predecessor.value);
+  midgard::hash_combine(seed, key.source);
+  midgard::hash_combine(seed, key.target);
+  return seed;
+}
+
+TransitionCache::TransitionCache(size_t capacity, uint32_t percent_buckets)
+    : percent_buckets_(percent_buckets), paths_(capacity) {
+  if (percent_buckets_ == 0) {
+    throw std::invalid_argument("Expect at least one percent bucket");
+  }
+}
+
+uint64_t TransitionCache::candidate_key(const baldr::PathLocation& candidate) const {
+  // whether the origin allows u-turns depends on the type of its stop
+  size_t seed = candidate.edges.size();
+  midgard::hash_combine(seed, static_cast<int>(candidate.stoptype_));
+  for (const auto& edge : candidate.edges) {
+    // the search starts or ends at the node of a candidate there rather than along its edge
+    uint32_t bucket = 0;
+    if (edge.end_node()) {
+      bucket = percent_buckets_ + 1;
+    } else if (!edge.begin_node()) {
+      bucket = 1 + std::min(static_cast<uint32_t>(edge.percent_along * percent_buckets_),
+                            percent_buckets_ - 1);
+    }
+    midgard::hash_combine(seed, edge.id.value);
+    midgard::hash_combine(seed, bucket);
+  }
+  return seed;
+}
+
+} // namespace meili
+} // namespace valhalla
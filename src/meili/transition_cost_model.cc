@@ -1,11 +1,25 @@
 #include "meili/transition_cost_model.h"
 #include "meili/routing.h"
 
+#include <algorithm>
+#include <chrono>
+
 namespace {
 inline float GreatCircleDistance(const valhalla::meili::Measurement& left,
                                  const valhalla::meili::Measurement& right) {
   return left.lnglat().Distance(right.lnglat());
 }
+
+// Where along one of its edges a candidate is, negative if the edge is not one of them
+inline float percent_along(const valhalla::baldr::PathLocation& candidate,
+                           const valhalla::baldr::GraphId& edgeid) {
+  for (const auto& edge : candidate.edges) {
+    if (edge.id == edgeid) {
+      return edge.percent_along;
+    }
+  }
+  return -1.f;
+}
 } // namespace
 
 namespace valhalla {
@@ -74,11 +88,15 @@ float TransitionCostModel::operator()(const StateId& lhs, const StateId& rhs) co
   const auto label = left.last_label(right);
   if (label) {
     // Get some basic info about difference between the two measurements
-    const auto& left_measurement = container_.measurement(lhs.time());
-    const auto& right_measurement = container_.measurement(rhs.time());
-    return CalculateTransitionCost(label->turn_cost(), label->cost().cost,
-                                   GreatCircleDistance(left_measurement, right_measurement),
-                                   label->cost().secs, ClockDistance(lhs.time(), rhs.time()));
+    const auto times = std::make_pair(lhs.time(), rhs.time());
+    if (times != distance_times_) {
+      great_circle_distance_ =
+          GreatCircleDistance(container_.measurement(lhs.time()), container_.measurement(rhs.time()));
+      clock_distance_ = ClockDistance(lhs.time(), rhs.time());
+      distance_times_ = times;
+    }
+    return CalculateTransitionCost(label->turn_cost(), label->cost().cost, great_circle_distance_,
+                                   label->cost().secs, clock_distance_);
   }
 
   // No path found
@@ -86,6 +104,7 @@ float TransitionCostModel::operator()(const StateId& lhs, const StateId& rhs) co
 }
 
 void TransitionCostModel::UpdateRoute(const StateId& lhs, const StateId& rhs) const {
+  const auto start = std::chrono::steady_clock::now();
   const auto& left = container_.state(lhs);
   const auto& right = container_.state(rhs);
 
@@ -109,26 +128,35 @@ void TransitionCostModel::UpdateRoute(const StateId& lhs, const StateId& rhs) co
     edgelabel = prev_state.last_label(left);
   }
 
-  // Prepare locations and stateids
+  // Prepare locations and stateids, the destinations are the same for all the states of the left
+  // column so we only look them up when we move on to the next column
   const auto& right_column = container_.column(right.stateid().time());
-  std::vector<baldr::PathLocation> locations;
-  locations.reserve(1 + right_column.size());
-  locations.push_back(left.candidate());
+  auto inserted = columns_.emplace(right.stateid().time(), column_t{});
+  auto& column = inserted.first->second;
+  if (inserted.second) {
+    column.locations.reserve(1 + right_column.size());
+    column.locations.emplace_back(left.candidate());
+    for (const auto& state : right_column) {
+      column.locations.push_back(state.candidate());
+    }
+    column.index = DestinationIndex(graphreader_, column.locations, 1, column.locations.size());
+    if (cache_) {
+      column.keys.reserve(right_column.size());
+      for (const auto& state : right_column) {
+        column.keys.push_back(cache_->candidate_key(state.candidate()));
+      }
+    }
+  } else {
+    column.locations.front() = left.candidate();
+  }
   LOG_TRACE("Routing from: " + std::to_string(left.stateid().time()) + "." +
             std::to_string(left.stateid().id()) + " [" +
-            std::to_string(locations.back().edges.front().projected.lng()) + "," +
-            std::to_string(locations.back().edges.front().projected.lat()) + "],");
+            std::to_string(column.locations.front().edges.front().projected.lng()) + "," +
+            std::to_string(column.locations.front().edges.front().projected.lat()) + "],");
   std::vector<StateId> unreached_stateids;
   unreached_stateids.reserve(right_column.size());
   for (const auto& state : right_column) {
-    // if (!vs_.Predecessor(state.stateid()).IsValid()) {
-    locations.push_back(state.candidate());
     unreached_stateids.push_back(state.stateid());
-    LOG_TRACE("Routing to: " + std::to_string(state.stateid().time()) + "." +
-              std::to_string(state.stateid().id()) + "   [" +
-              std::to_string(locations.back().edges.front().projected.lng()) + "," +
-              std::to_string(locations.back().edges.front().projected.lat()) + "],");
-    //}
   }
 
   const auto& left_measurement = container_.measurement(lhs.time());
@@ -149,13 +177,133 @@ void TransitionCostModel::UpdateRoute(const StateId& lhs, const StateId& rhs) co
     max_route_time = std::ceil(max_route_time);
   }
 
+  // Traces along the same roads route between the same candidates over and over
+  if (cache_ && RouteFromCache(left, column, unreached_stateids, edgelabel, max_route_distance,
+                               max_route_time)) {
+    routing_seconds_ +=
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return;
+  }
+
   labelset_ptr_t labelset = std::make_shared<LabelSet>(max_route_distance);
-  const auto& results = find_shortest_path(graphreader_, locations, 0, labelset, approximator,
-                                           right_measurement.search_radius(),
-                                           mode_costing_[static_cast<size_t>(travelmode_)], edgelabel,
-                                           turn_cost_table_, max_route_distance, max_route_time);
+  const auto& results =
+      find_shortest_path(graphreader_, column.locations, 0, column.index, labelset, approximator,
+                         right_measurement.search_radius(),
+                         mode_costing_[static_cast<size_t>(travelmode_)], edgelabel,
+                         turn_cost_table_, max_route_distance, max_route_time);
 
   left.SetRoute(unreached_stateids, results, labelset);
+  if (cache_) {
+    CacheRoutes(left, column, edgelabel, results, *labelset);
+  }
+  routing_seconds_ +=
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool TransitionCostModel::RouteFromCache(const State& left,
+                                         const column_t& column,
+                                         const std::vector<StateId>& stateids,
+                                         const Label* edgelabel,
+                                         float max_route_distance,
+                                         float max_route_time) const {
+  const auto& costing = mode_costing_[static_cast<size_t>(travelmode_)];
+  TransitionCache::key_t key{costing_key_, edgelabel ? edgelabel->edgeid() : baldr::GraphId{},
+                             cache_->candidate_key(left.candidate()), 0};
+
+  // The paths are only put together, the queue of the label set is never used
+  labelset_ptr_t labelset = std::make_shared<LabelSet>(1.f);
+  std::unordered_map<uint16_t, uint32_t> results;
+  TransitionCache::path_t path;
+  for (uint16_t dest = 1; dest < column.locations.size(); ++dest) {
+    key.target = column.keys[dest - 1];
+    if (!cache_->find(key, path)) {
+      return false;
+    }
+
+    // The path was found between candidates along the same edges within a bucket of these ones so
+    // we move its ends to them and change its cost by the cost of the difference
+    const auto& root = path->front();
+    float source = -1.f, target = -1.f;
+    sif::Cost shift, last_shift;
+    if (path->size() > 1 && root.dest() != kInvalidDestination) {
+      const auto& first = (*path)[1];
+      source = percent_along(left.candidate(), first.edgeid());
+      if (source < 0.f || !PartialCost(costing, first.edgeid(), first.source() - source, shift)) {
+        return false;
+      }
+    }
+    if (path->size() > 1 && path->back().dest() != kInvalidDestination) {
+      const auto& last = path->back();
+      target = percent_along(column.locations[dest], last.edgeid());
+      if (target < 0.f ||
+          !PartialCost(costing, last.edgeid(), target - last.target(), last_shift)) {
+        return false;
+      }
+    }
+
+    // The limits of this search may be tighter than those of the one which found the path
+    const auto cost = path->back().cost() + shift + last_shift;
+    if (!(cost.cost < max_route_distance && (max_route_time < 0 || cost.secs < max_route_time))) {
+      return false;
+    }
+
+    // The origin is the one the search would have started from
+    Label origin = edgelabel ? *edgelabel : Label();
+    origin.InitAsOrigin(travelmode_, root.dest(), root.nodeid());
+    uint32_t label_idx = labelset->append(origin);
+    for (size_t i = 1; i < path->size(); ++i) {
+      Label label = (*path)[i];
+      const bool first = i == 1, last = i + 1 == path->size();
+      const float label_source = first && source >= 0.f ? source : label.source();
+      const float label_target = last && target >= 0.f ? target : label.target();
+      if (label_source > label_target) {
+        return false;
+      }
+      label.Reuse(label_idx, label_source, label_target, last ? shift + last_shift : shift);
+      label_idx = labelset->append(label);
+    }
+    results.emplace(dest, label_idx);
+  }
+
+  left.SetRoute(stateids, results, labelset);
+  return true;
+}
+
+void TransitionCostModel::CacheRoutes(const State& left,
+                                      const column_t& column,
+                                      const Label* edgelabel,
+                                      const std::unordered_map<uint16_t, uint32_t>& results,
+                                      const LabelSet& labelset) const {
+  TransitionCache::key_t key{costing_key_, edgelabel ? edgelabel->edgeid() : baldr::GraphId{},
+                             cache_->candidate_key(left.candidate()), 0};
+  for (uint16_t dest = 1; dest < column.locations.size(); ++dest) {
+    const auto found = results.find(dest);
+    if (found == results.cend()) {
+      continue;
+    }
+    std::vector<Label> path;
+    for (auto label_idx = found->second; label_idx != baldr::kInvalidLabel;
+         label_idx = labelset.label(label_idx).predecessor()) {
+      path.push_back(labelset.label(label_idx));
+    }
+    std::reverse(path.begin(), path.end());
+    key.target = column.keys[dest - 1];
+    cache_->insert(key, std::make_shared<const std::vector<Label>>(std::move(path)));
+  }
+}
+
+bool TransitionCostModel::PartialCost(const sif::cost_ptr_t& costing,
+                                      const baldr::GraphId& edgeid,
+                                      float percent,
+                                      sif::Cost& cost) const {
+  graph_tile_ptr tile;
+  const auto* edge = graphreader_.directededge(edgeid, tile);
+  if (!edge) {
+    return false;
+  }
+  // the same way the search costs a part of an edge
+  cost = sif::Cost(edge->length() * percent, costing->EdgeCost(edge, tile).secs * percent);
+  return true;
 }
 
 } // namespace meili
@@ -121,6 +121,18 @@ IViterbiSearch::~IViterbiSearch() {
 
 void IViterbiSearch::Clear() {
   added_states_.clear();
+  forgotten_time_ = 0;
+}
+
+void IViterbiSearch::Forget(StateId::Time time) {
+  time = std::min(time, static_cast<StateId::Time>(states_by_time.size()));
+  for (StateId::Time t = forgotten_time_; t < time; ++t) {
+    for (const auto& stateid : states_by_time[t]) {
+      added_states_.erase(stateid);
+    }
+    std::vector<StateId>().swap(states_by_time[t]);
+  }
+  forgotten_time_ = std::max(forgotten_time_, time);
 }
 
 bool IViterbiSearch::AddStateId(const StateId& stateid) {
@@ -450,6 +462,23 @@ void ViterbiSearch::Clear() {
   ClearSearch();
 }
 
+void ViterbiSearch::Forget(StateId::Time time) {
+  const auto from = forgotten_time_;
+  IViterbiSearch::Forget(time);
+  time = std::min(time, static_cast<StateId::Time>(unreached_states_by_time.size()));
+  if (time <= from) {
+    return;
+  }
+  for (StateId::Time t = from; t < time; ++t) {
+    std::vector<StateId>().swap(unreached_states_by_time[t]);
+  }
+  for (auto it = scanned_labels_.begin(); it != scanned_labels_.end();) {
+    it = it->first.time() < time ? scanned_labels_.erase(it) : std::next(it);
+  }
+  // Labels still in the queue from before the time could only lead through the forgotten states
+  earliest_time_ = std::max(earliest_time_, time);
+}
+
 void ViterbiSearch::ClearSearch() {
   earliest_time_ = 0;
   queue_.clear();
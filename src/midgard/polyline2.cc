@@ -3,8 +3,12 @@
 #include "midgard/point2.h"
 #include "midgard/point_tile_index.h"
 #include "midgard/util.h"
+#include "midgard/vector2.h"
 
+#include <algorithm>
 #include <list>
+#include <utility>
+#include <vector>
 
 namespace valhalla {
 namespace midgard {
@@ -70,6 +74,34 @@ template <typename coord_t> std::vector<coord_t> Polyline2<coord_t>::GetSelfInte
   return intersections;
 }
 
+// The squared distance of points to a segment with the same math as LineSegment2::DistanceSquared,
+// the vector along the segment and its squared length are only computed once for all the points
+template <class coord_t> struct segment_distance_t {
+  using prec_t = typename coord_t::value_type;
+
+  segment_distance_t(const coord_t& a, const coord_t& b) : a(a), b(b), v(a, b), d(v.Dot(v)) {
+  }
+
+  prec_t operator()(const coord_t& p) const {
+    VectorXY<prec_t> w(a, p);
+    prec_t n = w.Dot(v);
+    coord_t closest;
+    if (n <= 0.0f) {
+      closest = a;
+    } else if (d <= n) {
+      closest = b;
+    } else {
+      closest = a + v * (n / d);
+    }
+    return closest.DistanceSquared(p);
+  }
+
+  const coord_t& a;
+  const coord_t& b;
+  VectorXY<prec_t> v;
+  prec_t d;
+};
+
 /**
  * A Douglas-Peucker line simplification algorithm that will not generate
  * self-intersections.
@@ -82,131 +114,136 @@ template <typename coord_t> std::vector<coord_t> Polyline2<coord_t>::GetSelfInte
 void peucker_avoid_self_intersections(PointTileIndex& point_tile_index,
                                       const double& epsilon_sq,
                                       const std::unordered_set<size_t>& exclusions,
-                                      size_t sidx,
-                                      size_t eidx) {
-
-  while ((exclusions.find(sidx) != exclusions.end()) && (sidx < eidx)) {
-    sidx++;
-  }
-  while ((exclusions.find(eidx) != exclusions.end()) && (eidx > sidx)) {
-    eidx--;
-  }
-  if (sidx >= eidx)
-    return;
+                                      const size_t first,
+                                      const size_t last) {
+  // the ranges left to simplify, the one on top is the next
+  std::vector<std::pair<size_t, size_t>> ranges{{first, last}};
+  while (!ranges.empty()) {
+    size_t sidx = ranges.back().first;
+    size_t eidx = ranges.back().second;
+    ranges.pop_back();
+
+    while ((exclusions.find(sidx) != exclusions.end()) && (sidx < eidx)) {
+      sidx++;
+    }
+    while ((exclusions.find(eidx) != exclusions.end()) && (eidx > sidx)) {
+      eidx--;
+    }
+    if (sidx >= eidx)
+      continue;
 
-  const PointLL& start = point_tile_index.points[sidx];
-  const PointLL& end = point_tile_index.points[eidx];
+    const PointLL& start = point_tile_index.points[sidx];
+    const PointLL& end = point_tile_index.points[eidx];
 
-  double dmax = std::numeric_limits<double>::lowest();
-  LineSegment2<PointLL> line_segment{start, end};
+    double dmax = std::numeric_limits<double>::lowest();
+    segment_distance_t<PointLL> distance(start, end);
 
-  // hfidx is the index of the highest freq detail (the dividing point)
-  size_t hfidx = sidx;
+    // hfidx is the index of the highest freq detail (the dividing point)
+    size_t hfidx = sidx;
 
-  // find the point furthest from the line-segment formed by {start, end}
-  PointLL tmp;
-  for (size_t idx = sidx + 1; idx < eidx; idx++) {
-    // special points we dont want to generalize no matter what take precedence
-    if (exclusions.find(idx) != exclusions.end()) {
-      dmax = epsilon_sq;
-      hfidx = idx;
-      break;
-    }
+    // find the point furthest from the line-segment formed by {start, end}
+    for (size_t idx = sidx + 1; idx < eidx; idx++) {
+      // special points we dont want to generalize no matter what take precedence
+      if (exclusions.find(idx) != exclusions.end()) {
+        dmax = epsilon_sq;
+        hfidx = idx;
+        break;
+      }
 
-    const PointLL& c = point_tile_index.points[idx];
+      const PointLL& c = point_tile_index.points[idx];
 
-    // test if this is the highest frequency detail so far
-    auto d = line_segment.DistanceSquared(c, tmp);
-    if (d > dmax) {
-      dmax = d;
-      hfidx = idx;
+      // test if this is the highest frequency detail so far
+      auto d = distance(c);
+      if (d > dmax) {
+        dmax = d;
+        hfidx = idx;
+      }
     }
-  }
 
-  // If (dmax < epsilon_sq) then we have a relatively straight line between (start,end).
-  // A standard Douglas-Peucker algorithm would immediately decimate all the points
-  // between (start,end). In this modified version, we use our tiled-point-space to
-  // determine if decimating the line would result in a self-intersection.
-  //
-  // We use our tiled space to determine the points along the "epsilon buffer zone" of
-  // the line (start,end). Because our tiled-point-space is coarse, our
-  // "get_points_near_segment" query will contain points both of interest and not.
-  // Consider this amazing ascii art example:
-  //
-  //                i             k
-  //                 \           /
-  //                  \         /
-  //                   \       /
-  //                    \     /
-  //   s - - - - - - - - - - - - - - - - - - - - - - - - - - - - e
-  //     `  .             \ /                             `
-  //            `  .       j                 .
-  //                  `  c        `
-  //
-  // s=start, e=end. c is a point along the polyline between s & e. We are considering
-  // getting rid of c because it is within epsilon of (a,b).
-  //
-  // All the points shown in this hypothetical example are returned from the call to
-  // "get_points_near_segment".
-  //
-  // As you can see, a completely separate portion of our polygon (i, j, k) would
-  // self-intersect if we simplified. To detect this, we perform a triangle
-  // containment test of point j using the triangle (s, c, e), see that its contained,
-  // and decide not to simplify. While this example only has one point c between
-  // (a,b), there is typically more than one. The logic below will create a triangle
-  // using every point c between start and end and perform containment tests for all
-  // "nearby" points for every (start,c,end) triangle. We can stop as soon as we find
-  // an unexpected point inside our triangle.
-  if (dmax < epsilon_sq) {
-    // This returns the points in the "epsilon buffer zone" along the line (start, end).
-    std::unordered_set<size_t> line_buffer_points =
-        point_tile_index.get_points_near_segment(LineSegment2<PointLL>(start, end));
-
-    // We only care about checking for triangle containment for points that are not
-    // along the polyline [start,end] - so we can remove those straightaway.
-    for (size_t i = sidx; i <= eidx; i++) {
-      line_buffer_points.erase(i);
-    }
+    // If (dmax < epsilon_sq) then we have a relatively straight line between (start,end).
+    // A standard Douglas-Peucker algorithm would immediately decimate all the points
+    // between (start,end). In this modified version, we use our tiled-point-space to
+    // determine if decimating the line would result in a self-intersection.
+    //
+    // We use our tiled space to determine the points along the "epsilon buffer zone" of
+    // the line (start,end). Because our tiled-point-space is coarse, our
+    // "get_points_near_segment" query will contain points both of interest and not.
+    // Consider this amazing ascii art example:
+    //
+    //                i             k
+    //                 \           /
+    //                  \         /
+    //                   \       /
+    //                    \     /
+    //   s - - - - - - - - - - - - - - - - - - - - - - - - - - - - e
+    //     `  .             \ /                             `
+    //            `  .       j                 .
+    //                  `  c        `
+    //
+    // s=start, e=end. c is a point along the polyline between s & e. We are considering
+    // getting rid of c because it is within epsilon of (a,b).
+    //
+    // All the points shown in this hypothetical example are returned from the call to
+    // "get_points_near_segment".
+    //
+    // As you can see, a completely separate portion of our polygon (i, j, k) would
+    // self-intersect if we simplified. To detect this, we perform a triangle
+    // containment test of point j using the triangle (s, c, e), see that its contained,
+    // and decide not to simplify. While this example only has one point c between
+    // (a,b), there is typically more than one. The logic below will create a triangle
+    // using every point c between start and end and perform containment tests for all
+    // "nearby" points for every (start,c,end) triangle. We can stop as soon as we find
+    // an unexpected point inside our triangle.
+    if (dmax < epsilon_sq) {
+      // This returns the points in the "epsilon buffer zone" along the line (start, end).
+      std::unordered_set<size_t> line_buffer_points =
+          point_tile_index.get_points_near_segment(LineSegment2<PointLL>(start, end));
+
+      // We only care about checking for triangle containment for points that are not
+      // along the polyline [start,end] - so we can remove those straightaway.
+      for (size_t i = sidx; i <= eidx; i++) {
+        line_buffer_points.erase(i);
+      }
 
-    bool can_simplify = true;
-    for (size_t cidx = sidx + 1; (cidx < eidx) && can_simplify; cidx++) {
-      const PointLL& c = point_tile_index.points[cidx];
-      for (size_t point_idx : line_buffer_points) {
-        const PointLL& p = point_tile_index.points[point_idx];
-        if (triangle_contains(start, c, end, p)) {
-          can_simplify = false;
+      bool can_simplify = true;
+      for (size_t cidx = sidx + 1; (cidx < eidx) && can_simplify; cidx++) {
+        const PointLL& c = point_tile_index.points[cidx];
+        for (size_t point_idx : line_buffer_points) {
+          const PointLL& p = point_tile_index.points[point_idx];
+          if (triangle_contains(start, c, end, p)) {
+            can_simplify = false;
+            break;
+          }
+        }
+
+        // the moment we realize we cannot simplify we can stop
+        if (!can_simplify) {
           break;
         }
       }
 
-      // the moment we realize we cannot simplify we can stop
-      if (!can_simplify) {
-        break;
+      if (can_simplify) {
+        // Simplify the polyline by removing all points between sidx and eidx
+        // from the point-tile-index (but don't remove sidx or eidx).
+        point_tile_index.remove_points(sidx + 1, eidx);
+      } else {
+        // Simplifying this polyline would result in a self-intersection, so
+        // we cannot. Force recursion around hfidx.
+        dmax = epsilon_sq;
       }
     }
 
-    if (can_simplify) {
-      // Simplify the polyline by removing all points between sidx and eidx
-      // from the point-tile-index (but don't remove sidx or eidx).
-      point_tile_index.remove_points(sidx + 1, eidx);
-    } else {
-      // Simplifying this polyline would result in a self-intersection, so
-      // we cannot. Force recursion around hfidx.
-      dmax = epsilon_sq;
+    // if (dmax >= epsilon_sq) there are some high frequency details between start
+    // and end so we need to look for flatter sections between them.
+    if (dmax >= epsilon_sq) {
+      // the right range goes first like it always has, the order matters since simplifying a range
+      // takes its points out of the index which the ranges after it look at
+      if (hfidx - sidx > 1)
+        ranges.emplace_back(sidx, hfidx);
+      if (eidx - hfidx > 1)
+        ranges.emplace_back(hfidx, eidx);
     }
   }
-
-  // if (dmax >= epsilon_sq) there are some high frequency details between start
-  // and end so we need to look for flatter sections between them.
-  if (dmax >= epsilon_sq) {
-    // we recurse from right to left for two reasons:
-    // 1. we want to preserve iterator validity in the vector version
-    // 2. its the only way to preserve the indices in the keep set
-    if (eidx - hfidx > 1)
-      peucker_avoid_self_intersections(point_tile_index, epsilon_sq, exclusions, hfidx, eidx);
-    if (hfidx - sidx > 1)
-      peucker_avoid_self_intersections(point_tile_index, epsilon_sq, exclusions, sidx, hfidx);
-  }
 }
 
 template <class coord_t, class container_t>
@@ -232,10 +269,71 @@ void DouglastPeuckerAvoidSelfIntersection(container_t& polyline,
   }
 }
 
-template <class coord_t, class container_t>
-void DouglasPeucker(container_t& polyline,
+// Vectors are simplified without recursion or erasing, the ranges left to look at are kept on a
+// stack and the points to keep are marked so the vector is compacted in place once at the end
+template <class coord_t>
+void DouglasPeucker(std::vector<coord_t>& polyline,
+                    typename coord_t::value_type epsilon,
+                    const std::unordered_set<size_t>& exclusions) {
+  // any epsilon this low will have no effect on the input nor will any super short input
+  if (epsilon <= 0 || polyline.size() < 3)
+    return;
+
+  epsilon *= epsilon;
+  std::vector<size_t> excluded(exclusions.cbegin(), exclusions.cend());
+  std::sort(excluded.begin(), excluded.end());
+  std::vector<bool> keep(polyline.size(), false);
+  keep.front() = keep.back() = true;
+  std::vector<std::pair<size_t, size_t>> ranges{{0, polyline.size() - 1}};
+  while (!ranges.empty()) {
+    const auto s = ranges.back().first;
+    const auto e = ranges.back().second;
+    ranges.pop_back();
+
+    // special points we dont want to generalize no matter what take precidence, the last one of
+    // them splits the range just like it would if it were the furthest from the line
+    size_t k = s;
+    auto excluded_itr = std::lower_bound(excluded.cbegin(), excluded.cend(), e);
+    if (excluded_itr != excluded.cbegin() && *std::prev(excluded_itr) > s) {
+      k = *std::prev(excluded_itr);
+    } // otherwise find the point furthest from the line, the one closest to the end on ties
+    else {
+      auto dmax = std::numeric_limits<typename coord_t::value_type>::lowest();
+      segment_distance_t<coord_t> distance(polyline[s], polyline[e]);
+      for (size_t i = e - 1; i > s; --i) {
+        auto d = distance(polyline[i]);
+        if (d > dmax) {
+          dmax = d;
+          k = i;
+        }
+      }
+      // nothing sticks out between start and end so simplify everything between away
+      if (dmax < epsilon)
+        continue;
+    }
+
+    // there are some high frequency details between start and end so we need to look for
+    // flatter sections between them
+    keep[k] = true;
+    if (k - s > 1)
+      ranges.emplace_back(s, k);
+    if (e - k > 1)
+      ranges.emplace_back(k, e);
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < polyline.size(); ++i) {
+    if (keep[i])
+      polyline[kept++] = polyline[i];
+  }
+  polyline.resize(kept);
+}
+
+template <class coord_t>
+void DouglasPeucker(std::list<coord_t>& polyline,
                     typename coord_t::value_type epsilon,
                     const std::unordered_set<size_t>& exclusions) {
+  using container_t = std::list<coord_t>;
   // any epsilon this low will have no effect on the input nor will any super short input
   if (epsilon <= 0 || polyline.size() < 3)
     return;
@@ -195,28 +195,39 @@ Tiles<coord_t>::Tiles(const coord_t& min_pt,
 // bounding box are both aligned to the axes we can simply find tiles by iterating over rows
 // and columns of tiles from the minimum to maximum.
 template <class coord_t> std::vector<int> Tiles<coord_t>::TileList(const AABB2<coord_t>& bbox) const {
+  std::vector<int32_t> tilelist;
+  TileList(bbox, tilelist);
+  return tilelist;
+}
+
+template <class coord_t>
+void Tiles<coord_t>::TileList(const AABB2<coord_t>& bbox, std::vector<int32_t>& tilelist) const {
   // Check if x range needs to be split
-  std::vector<AABB2<coord_t>> bboxes;
+  std::array<AABB2<coord_t>, 2> bboxes;
+  size_t count = 1;
   if (wrapx_) {
     if (bbox.minx() < tilebounds_.minx() && bbox.maxx() > tilebounds_.minx()) {
       // Create 2 bounding boxes
-      bboxes.emplace_back(tilebounds_.minx(), bbox.miny(), bbox.maxx(), bbox.maxy());
-      bboxes.emplace_back(bbox.minx() + tilebounds_.Width(), bbox.miny(), tilebounds_.maxx(),
-                          bbox.maxy());
+      bboxes[0] = AABB2<coord_t>(tilebounds_.minx(), bbox.miny(), bbox.maxx(), bbox.maxy());
+      bboxes[1] = AABB2<coord_t>(bbox.minx() + tilebounds_.Width(), bbox.miny(), tilebounds_.maxx(),
+                                  bbox.maxy());
+      count = 2;
     } else if (bbox.minx() < tilebounds_.maxx() && bbox.maxx() > tilebounds_.maxx()) {
       // Create 2 bounding boxes
-      bboxes.emplace_back(bbox.minx(), bbox.miny(), tilebounds_.maxx(), bbox.maxy());
-      bboxes.emplace_back(tilebounds_.minx(), bbox.miny(), bbox.maxx() - tilebounds_.Width(),
-                          bbox.maxy());
+      bboxes[0] = AABB2<coord_t>(bbox.minx(), bbox.miny(), tilebounds_.maxx(), bbox.maxy());
+      bboxes[1] = AABB2<coord_t>(tilebounds_.minx(), bbox.miny(), bbox.maxx() - tilebounds_.Width(),
+                                  bbox.maxy());
+      count = 2;
     } else {
-      bboxes.push_back(bbox.Intersection(tilebounds_));
+      bboxes[0] = bbox.Intersection(tilebounds_);
     }
   } else {
-    bboxes.push_back(bbox.Intersection(tilebounds_));
+    bboxes[0] = bbox.Intersection(tilebounds_);
   }
 
-  std::vector<int32_t> tilelist;
-  for (const auto& bb : bboxes) {
+  tilelist.clear();
+  for (size_t i = 0; i < count; ++i) {
+    const auto& bb = bboxes[i];
     int32_t minrow = std::max(Row(bb.miny()), 0);
     int32_t maxrow = std::max(Row(bb.maxy()), 0);
     int32_t mincol = std::max(Col(bb.minx()), 0);
@@ -228,7 +239,6 @@ template <class coord_t> std::vector<int> Tiles<coord_t>::TileList(const AABB2<c
       }
     }
   }
-  return tilelist;
 }
 
 // Get the list of tiles that lie within the specified bounding box. The method finds the tile
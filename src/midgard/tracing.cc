@@ -0,0 +1,114 @@
+#include "midgard/tracing.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct event_t {
+  const char* name;
+  uint64_t begin;
+  uint64_t end;
+};
+
+// the spans of one thread, the lock is only ever contended while a dump reads them
+struct ring_t {
+  std::mutex lock;
+  std::vector<event_t> events;
+  size_t recorded = 0;
+  uint32_t thread = 0;
+};
+
+// the rings of every thread that recorded a span, kept after the thread is gone so its spans can
+// still be dumped
+struct registry_t {
+  std::mutex lock;
+  std::vector<std::shared_ptr<ring_t>> rings;
+};
+
+registry_t& registry() {
+  static registry_t registry;
+  return registry;
+}
+
+ring_t& thread_ring() {
+  thread_local std::shared_ptr<ring_t> ring;
+  if (!ring) {
+    ring = std::make_shared<ring_t>();
+    ring->events.resize(valhalla::midgard::tracing::kRingSize);
+    auto& all = registry();
+    std::lock_guard<std::mutex> lock(all.lock);
+    ring->thread = all.rings.size() + 1;
+    all.rings.push_back(ring);
+  }
+  return *ring;
+}
+
+int process_id() {
+#ifdef _WIN32
+  return 1;
+#else
+  return static_cast<int>(getpid());
+#endif
+}
+
+} // namespace
+
+namespace valhalla {
+namespace midgard {
+namespace tracing {
+
+void record(const char* name, uint64_t begin, uint64_t end) {
+  auto& ring = thread_ring();
+  std::lock_guard<std::mutex> lock(ring.lock);
+  ring.events[ring.recorded++ % kRingSize] = {name, begin, end};
+}
+
+std::string dump() {
+  std::vector<std::shared_ptr<ring_t>> rings;
+  {
+    auto& all = registry();
+    std::lock_guard<std::mutex> lock(all.lock);
+    rings = all.rings;
+  }
+
+  const int pid = process_id();
+  std::ostringstream json;
+  json << std::fixed << std::setprecision(3) << '[';
+  bool first = true;
+  for (const auto& ring : rings) {
+    std::lock_guard<std::mutex> lock(ring->lock);
+    // the oldest span is right after the newest once the ring has wrapped around
+    const size_t count = std::min(ring->recorded, kRingSize);
+    for (size_t i = ring->recorded - count; i < ring->recorded; ++i) {
+      const auto& event = ring->events[i % kRingSize];
+      json << (first ? "" : ",") << R"({"name":")" << event.name << R"(","ph":"X","ts":)"
+           << event.begin / 1e3 << R"(,"dur":)" << (event.end - event.begin) / 1e3
+           << R"(,"pid":)" << pid << R"(,"tid":)" << ring->thread << '}';
+      first = false;
+    }
+  }
+  json << ']';
+  return json.str();
+}
+
+void clear() {
+  auto& all = registry();
+  std::lock_guard<std::mutex> lock(all.lock);
+  for (const auto& ring : all.rings) {
+    std::lock_guard<std::mutex> ring_lock(ring->lock);
+    ring->recorded = 0;
+  }
+}
+
+} // namespace tracing
+} // namespace midgard
+} // namespace valhalla
@@ -809,5 +809,62 @@ std::string decode64(const std::string& encoded) {
   return decoded;
 }
 
+uint64_t hilbert_index(uint32_t x, uint32_t y, const uint32_t side) {
+  uint64_t d = 0;
+  for (uint32_t s = side / 2; s > 0; s /= 2) {
+    const uint32_t rx = (x & s) > 0;
+    const uint32_t ry = (y & s) > 0;
+    d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+    // rotate the quadrant so the curve stays continuous
+    if (ry == 0) {
+      if (rx == 1) {
+        x = side - 1 - x;
+        y = side - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return d;
+}
+
+size_t projector_t::closest(const PointLL* points,
+                            size_t count,
+                            PointLL& point,
+                            double& sq_distance) const {
+  // small enough to stay in registers and on the stack, big enough to fill the vector units
+  constexpr size_t kBlockSize = 16;
+  double xs[kBlockSize], ys[kBlockSize], sq_distances[kBlockSize];
+
+  size_t segment = 0;
+  sq_distance = std::numeric_limits<double>::max();
+  for (size_t begin = 0; begin + 1 < count; begin += kBlockSize) {
+    const size_t size = std::min(kBlockSize, count - 1 - begin);
+    const auto* us = points + begin;
+    // the same math as projecting onto one segment but selecting instead of returning early, a
+    // zero length segment has no extent along it so it selects u just like the check for it does
+    for (size_t i = 0; i < size; ++i) {
+      const auto& u = us[i];
+      const auto& v = us[i + 1];
+      auto bx = v.first - u.first;
+      auto by = v.second - u.second;
+      auto bx2 = bx * lon_scale;
+      auto sq = bx2 * bx2 + by * by;
+      auto scale = (lng - u.lng()) * lon_scale * bx2 + (lat - u.lat()) * by;
+      auto ratio = scale / sq;
+      xs[i] = scale <= 0.0 ? u.first : (scale >= sq ? v.first : u.first + bx * ratio);
+      ys[i] = scale <= 0.0 ? u.second : (scale >= sq ? v.second : u.second + by * ratio);
+      sq_distances[i] = approx.DistanceSquared(PointLL(xs[i], ys[i]));
+    }
+    for (size_t i = 0; i < size; ++i) {
+      if (sq_distances[i] < sq_distance) {
+        sq_distance = sq_distances[i];
+        point = PointLL(xs[i], ys[i]);
+        segment = begin + i;
+      }
+    }
+  }
+  return segment;
+}
+
 } // namespace midgard
 } // namespace valhalla
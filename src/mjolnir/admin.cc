@@ -3,9 +3,11 @@
 #include "filesystem.h"
 #include "midgard/logging.h"
 #include "mjolnir/util.h"
+#include <algorithm>
 #include <spatialite.h>
 #include <sqlite3.h>
 #include <unordered_map>
+#include <utility>
 
 namespace valhalla {
 namespace mjolnir {
@@ -243,6 +245,167 @@ GetAdminInfo(sqlite3* db_handle,
   return polys;
 }
 
+// Adds a polygon (given as wkt) to the index, returns false if its empty
+bool PolygonIndex::Add(const std::string& wkt) {
+  multi_polygon_type multi_poly;
+  boost::geometry::read_wkt(wkt, multi_poly);
+  if (boost::geometry::is_empty(multi_poly)) {
+    return false;
+  }
+  valid_.push_back(boost::geometry::is_valid(multi_poly));
+  polygons_.emplace_back(std::move(multi_poly));
+  return true;
+}
+
+// Builds the rtree once all polygons are added
+void PolygonIndex::Finish() {
+  std::vector<std::pair<box_type, uint32_t>> boxes;
+  boxes.reserve(polygons_.size());
+  for (uint32_t i = 0; i < polygons_.size(); ++i) {
+    boxes.emplace_back(boost::geometry::return_envelope<box_type>(polygons_[i]), i);
+  }
+  // the packing constructor builds a better tree than inserting one at a time
+  decltype(rtree_)(boxes.begin(), boxes.end()).swap(rtree_);
+}
+
+// Get the polygons which intersect the bounding box of a tile, clipped to it
+std::vector<std::pair<uint32_t, multi_polygon_type>>
+PolygonIndex::Clip(const AABB2<PointLL>& aabb) const {
+  // a node on the edge of the tile could fall just outside of a polygon clipped to it exactly
+  constexpr double kMargin = 1e-5;
+  box_type tile(point_type(aabb.minx() - kMargin, aabb.miny() - kMargin),
+                point_type(aabb.maxx() + kMargin, aabb.maxy() + kMargin));
+
+  std::vector<std::pair<box_type, uint32_t>> candidates;
+  rtree_.query(boost::geometry::index::intersects(tile), std::back_inserter(candidates));
+  std::sort(candidates.begin(), candidates.end(),
+            [](const std::pair<box_type, uint32_t>& a, const std::pair<box_type, uint32_t>& b) {
+              return a.second < b.second;
+            });
+
+  std::vector<std::pair<uint32_t, multi_polygon_type>> clipped;
+  for (const auto& candidate : candidates) {
+    const auto& polygon = polygons_[candidate.second];
+    if (valid_[candidate.second]) {
+      multi_polygon_type inside;
+      boost::geometry::intersection(polygon, tile, inside);
+      if (!boost::geometry::is_empty(inside)) {
+        clipped.emplace_back(candidate.second, std::move(inside));
+      }
+    } else if (boost::geometry::intersects(polygon, tile)) {
+      clipped.emplace_back(candidate.second, polygon);
+    }
+  }
+  return clipped;
+}
+
+// Reads all of the admins from the db
+AdminIndex::AdminIndex(sqlite3* db_handle) {
+  if (!db_handle) {
+    return;
+  }
+
+  // the states and then the countries, like the queries in GetAdminInfo
+  const std::vector<std::string> queries = {
+      "SELECT country.name, state.name, country.iso_code, state.iso_code, state.drive_on_right, "
+      "state.allow_intersection_names, st_astext(state.geom) from admins state, admins country "
+      "where country.rowid = state.parent_admin and state.admin_level=4 order by state.rowid;",
+      "SELECT name, \"\", iso_code, \"\", drive_on_right, allow_intersection_names, "
+      "st_astext(geom) from admins where admin_level=2 order by rowid;"};
+
+  for (const auto& sql : queries) {
+    sqlite3_stmt* stmt = 0;
+    if (sqlite3_prepare_v2(db_handle, sql.c_str(), sql.length(), &stmt, 0) == SQLITE_OK) {
+      while (sqlite3_step(stmt) == SQLITE_ROW) {
+        admin_t admin{{}, {}, {}, {}, true, false};
+        auto text = [stmt](int column) {
+          return sqlite3_column_type(stmt, column) == SQLITE_TEXT
+                     ? std::string((char*)sqlite3_column_text(stmt, column))
+                     : std::string();
+        };
+        admin.country_name = text(0);
+        admin.state_name = text(1);
+        admin.country_iso = text(2);
+        admin.state_iso = text(3);
+        if (sqlite3_column_type(stmt, 4) == SQLITE_INTEGER) {
+          admin.drive_on_right = sqlite3_column_int(stmt, 4);
+        }
+        if (sqlite3_column_type(stmt, 5) == SQLITE_INTEGER) {
+          admin.allow_intersection_names = sqlite3_column_int(stmt, 5);
+        }
+        if (Add(text(6))) {
+          admins_.emplace_back(std::move(admin));
+        }
+      }
+    }
+    if (stmt) {
+      sqlite3_finalize(stmt);
+    }
+  }
+  Finish();
+  LOG_INFO("Indexed " + std::to_string(admins_.size()) + " admin polygons");
+}
+
+// Get the admin polys that intersect with the tile bounding box.
+std::unordered_multimap<uint32_t, multi_polygon_type>
+AdminIndex::GetAdminInfo(std::unordered_map<uint32_t, bool>& drive_on_right,
+                         std::unordered_map<uint32_t, bool>& allow_intersection_names,
+                         const AABB2<PointLL>& aabb,
+                         GraphTileBuilder& tilebuilder) const {
+  std::unordered_multimap<uint32_t, multi_polygon_type> polys;
+  for (auto& clipped : Clip(aabb)) {
+    const auto& admin = admins_[clipped.first];
+    uint32_t index = tilebuilder.AddAdmin(admin.country_name, admin.state_name, admin.country_iso,
+                                          admin.state_iso);
+    polys.emplace(index, std::move(clipped.second));
+    drive_on_right.emplace(index, admin.drive_on_right);
+    allow_intersection_names.emplace(index, admin.allow_intersection_names);
+  }
+  return polys;
+}
+
+// Reads all of the time zones from the db
+TimeZoneIndex::TimeZoneIndex(sqlite3* db_handle) {
+  if (!db_handle) {
+    return;
+  }
+
+  sqlite3_stmt* stmt = 0;
+  std::string sql = "select TZID, st_astext(geom) from tz_world order by rowid;";
+  if (sqlite3_prepare_v2(db_handle, sql.c_str(), sql.length(), &stmt, 0) == SQLITE_OK) {
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      std::string tz_id;
+      std::string geom;
+      if (sqlite3_column_type(stmt, 0) == SQLITE_TEXT) {
+        tz_id = (char*)sqlite3_column_text(stmt, 0);
+      }
+      if (sqlite3_column_type(stmt, 1) == SQLITE_TEXT) {
+        geom = (char*)sqlite3_column_text(stmt, 1);
+      }
+
+      uint32_t idx = DateTime::get_tz_db().to_index(tz_id);
+      if (idx != 0 && Add(geom)) {
+        timezones_.push_back(idx);
+      }
+    }
+  }
+  if (stmt) {
+    sqlite3_finalize(stmt);
+  }
+  Finish();
+  LOG_INFO("Indexed " + std::to_string(timezones_.size()) + " time zone polygons");
+}
+
+// Get the timezone polys that intersect with the tile bounding box.
+std::unordered_multimap<uint32_t, multi_polygon_type>
+TimeZoneIndex::GetTimeZones(const AABB2<PointLL>& aabb) const {
+  std::unordered_multimap<uint32_t, multi_polygon_type> polys;
+  for (auto& clipped : Clip(aabb)) {
+    polys.emplace(timezones_[clipped.first], std::move(clipped.second));
+  }
+  return polys;
+}
+
 // Get all the country access records from the db and save them to a map.
 std::unordered_map<std::string, std::vector<int>> GetCountryAccess(sqlite3* db_handle) {
 
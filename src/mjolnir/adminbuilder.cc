@@ -1,5 +1,9 @@
+#include <algorithm>
+#include <condition_variable>
 #include <cstdint>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "baldr/graphconstants.h"
@@ -219,6 +223,54 @@ std::vector<std::string> GetWkts(std::unique_ptr<Geometry>& mline) {
   return wkts;
 }
 
+// Assembles the polygons of an admin from the shapes of its member ways. Returns false if any of
+// them are missing, a relation may be included in an extract but its members may not.
+// Example:  PA extract can contain a NY relation.
+bool AssembleAdmin(const OSMAdmin& admin,
+                   const OSMAdminData& osm_admin_data,
+                   std::vector<std::string>& wkts) {
+#if GEOS_VERSION_MAJOR == 3 && GEOS_VERSION_MINOR >= 6
+  auto gf = GeometryFactory::create();
+#else
+  std::unique_ptr<GeometryFactory> gf(new GeometryFactory());
+#endif
+
+  std::unique_ptr<std::vector<Geometry*>> lines(new std::vector<Geometry*>);
+  for (const auto memberid : admin.ways()) {
+    auto itr = osm_admin_data.way_map.find(memberid);
+    if (itr == osm_admin_data.way_map.end()) {
+      for (auto* line : *lines) {
+        delete line;
+      }
+      return false;
+    }
+
+#if GEOS_VERSION_MAJOR == 3 && GEOS_VERSION_MINOR >= 8
+    auto coords = std::unique_ptr<CoordinateArraySequence>(new CoordinateArraySequence);
+#else
+    std::unique_ptr<CoordinateSequence> coords(
+        gf->getCoordinateSequenceFactory()->create((size_t)0, (size_t)2));
+#endif
+
+    for (const auto ref_id : itr->second) {
+      const PointLL ll = osm_admin_data.shape_map.at(ref_id);
+      Coordinate c;
+      c.x = ll.lng();
+      c.y = ll.lat();
+      coords->add(c, 0);
+    }
+
+    if (coords->getSize() > 1) {
+      std::unique_ptr<Geometry> geom(gf->createLineString(coords.release()));
+      lines->push_back(geom.release());
+    }
+  } // member loop
+
+  std::unique_ptr<Geometry> mline(gf->createMultiLineString(lines.release()));
+  wkts = GetWkts(mline);
+  return true;
+}
+
 } // anonymous namespace
 
 namespace valhalla {
@@ -381,114 +433,125 @@ void BuildAdminFromPBF(const boost::property_tree::ptree& pt,
     return;
   }
 
-  uint32_t count = 0;
-  bool has_data;
-#if GEOS_VERSION_MAJOR == 3 && GEOS_VERSION_MINOR >= 6
-  auto gf = GeometryFactory::create();
-#else
-  std::unique_ptr<GeometryFactory> gf(new GeometryFactory());
-#endif
-
-  try {
-
-    for (const auto& admin : osm_admin_data.admins_) {
-
-      std::unique_ptr<Geometry> geom;
-      std::unique_ptr<std::vector<Geometry*>> lines(new std::vector<Geometry*>);
-      has_data = true;
-
-      for (const auto memberid : admin.ways()) {
-
-        auto itr = osm_admin_data.way_map.find(memberid);
-
-        // A relation may be included in an extract but it's members may not.
-        // Example:  PA extract can contain a NY relation.
-        if (itr == osm_admin_data.way_map.end()) {
-          has_data = false;
-          break;
-        }
-
-#if GEOS_VERSION_MAJOR == 3 && GEOS_VERSION_MINOR >= 8
-        auto coords = std::unique_ptr<CoordinateArraySequence>(new CoordinateArraySequence);
-#else
-        std::unique_ptr<CoordinateSequence> coords(
-            gf->getCoordinateSequenceFactory()->create((size_t)0, (size_t)2));
-#endif
-
-        for (const auto ref_id : itr->second) {
-
-          const PointLL ll = osm_admin_data.shape_map.at(ref_id);
-
-          Coordinate c;
-          c.x = ll.lng();
-          c.y = ll.lat();
-          coords->add(c, 0);
+  // The polygons are assembled on all the threads, each taking the next admin, and inserted in
+  // the order of the admins on this one as they are done. The threads only get so far ahead of
+  // the inserts so that the polygons waiting to be inserted dont pile up on a planet
+  const auto& admins = osm_admin_data.admins_;
+  const auto concurrency =
+      std::max(1u, pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+  const size_t window = concurrency * 64;
+  struct assembled_t {
+    std::vector<std::string> wkts;
+    bool done = false;
+  };
+  std::vector<assembled_t> assembled(admins.size());
+  std::mutex lock;
+  std::condition_variable changed;
+  size_t next = 0, inserted = 0;
+
+  auto assemble = [&]() {
+    while (true) {
+      size_t i;
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [&]() { return next >= admins.size() || next < inserted + window; });
+        if (next >= admins.size()) {
+          return;
         }
+        i = next++;
+      }
 
-        if (coords->getSize() > 1) {
-          geom = std::unique_ptr<Geometry>(gf->createLineString(coords.release()));
-          lines->push_back(geom.release());
-        }
+      // an admin which cant be assembled is left out rather than all of the ones after it
+      std::vector<std::string> wkts;
+      try {
+        AssembleAdmin(admins[i], osm_admin_data, wkts);
+      } catch (std::exception& e) {
+        LOG_ERROR("Standard exception processing relation " +
+                  osm_admin_data.name_offset_map.name(admins[i].name_index()) + ": " +
+                  std::string(e.what()));
+        wkts.clear();
+      } catch (...) {
+        LOG_ERROR("Exception caught processing relation " +
+                  osm_admin_data.name_offset_map.name(admins[i].name_index()));
+        wkts.clear();
+      }
 
-      } // member loop
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        assembled[i].wkts = std::move(wkts);
+        assembled[i].done = true;
+      }
+      changed.notify_all();
+    }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < concurrency; ++i) {
+    threads.emplace_back(assemble);
+  }
 
-      if (has_data) {
+  uint32_t count = 0;
+  for (size_t i = 0; i < admins.size(); ++i) {
+    const auto& admin = admins[i];
+    std::vector<std::string> wkts;
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      changed.wait(guard, [&]() { return assembled[i].done; });
+      wkts = std::move(assembled[i].wkts);
+      inserted = i + 1;
+    }
+    changed.notify_all();
 
-        std::unique_ptr<Geometry> mline(gf->createMultiLineString(lines.release()));
-        std::vector<std::string> wkts = GetWkts(mline);
-        std::string name;
-        std::string name_en;
-        std::string iso;
+    std::string name;
+    std::string name_en;
+    std::string iso;
 
-        for (const auto& wkt : wkts) {
+    for (const auto& wkt : wkts) {
 
-          count++;
-          sqlite3_reset(stmt);
-          sqlite3_clear_bindings(stmt);
-          sqlite3_bind_int(stmt, 1, admin.admin_level());
+      count++;
+      sqlite3_reset(stmt);
+      sqlite3_clear_bindings(stmt);
+      sqlite3_bind_int(stmt, 1, admin.admin_level());
 
-          if (admin.iso_code_index()) {
-            iso = osm_admin_data.name_offset_map.name(admin.iso_code_index());
-            sqlite3_bind_text(stmt, 2, iso.c_str(), iso.length(), SQLITE_STATIC);
-          } else {
-            sqlite3_bind_null(stmt, 2);
-          }
+      if (admin.iso_code_index()) {
+        iso = osm_admin_data.name_offset_map.name(admin.iso_code_index());
+        sqlite3_bind_text(stmt, 2, iso.c_str(), iso.length(), SQLITE_STATIC);
+      } else {
+        sqlite3_bind_null(stmt, 2);
+      }
 
-          sqlite3_bind_null(stmt, 3);
+      sqlite3_bind_null(stmt, 3);
 
-          name = osm_admin_data.name_offset_map.name(admin.name_index());
-          sqlite3_bind_text(stmt, 4, name.c_str(), name.length(), SQLITE_STATIC);
+      name = osm_admin_data.name_offset_map.name(admin.name_index());
+      sqlite3_bind_text(stmt, 4, name.c_str(), name.length(), SQLITE_STATIC);
 
-          if (admin.name_en_index()) {
-            name_en = osm_admin_data.name_offset_map.name(admin.name_en_index());
-            sqlite3_bind_text(stmt, 5, name_en.c_str(), name_en.length(), SQLITE_STATIC);
-          } else {
-            sqlite3_bind_null(stmt, 5);
-          }
+      if (admin.name_en_index()) {
+        name_en = osm_admin_data.name_offset_map.name(admin.name_en_index());
+        sqlite3_bind_text(stmt, 5, name_en.c_str(), name_en.length(), SQLITE_STATIC);
+      } else {
+        sqlite3_bind_null(stmt, 5);
+      }
 
-          sqlite3_bind_int(stmt, 6, admin.drive_on_right());
-          sqlite3_bind_int(stmt, 7, admin.allow_intersection_names());
-          sqlite3_bind_text(stmt, 8, wkt.c_str(), wkt.length(), SQLITE_STATIC);
-          /* performing INSERT INTO */
-          ret = sqlite3_step(stmt);
-          if (ret == SQLITE_DONE || ret == SQLITE_ROW) {
-            continue;
-          }
-          LOG_ERROR("sqlite3_step() error: " + std::string(sqlite3_errmsg(db_handle)));
-          LOG_ERROR("sqlite3_step() Name: " +
-                    osm_admin_data.name_offset_map.name(admin.name_index()));
-          LOG_ERROR("sqlite3_step() Name:en: " +
-                    osm_admin_data.name_offset_map.name(admin.name_en_index()));
-          LOG_ERROR("sqlite3_step() Admin Level: " + std::to_string(admin.admin_level()));
-          LOG_ERROR("sqlite3_step() Drive on Right: " + std::to_string(admin.drive_on_right()));
-          LOG_ERROR("sqlite3_step() Allow Intersection Names: " +
-                    std::to_string(admin.allow_intersection_names()));
-        }
-      } // has data
-    }   // admins
-  } catch (std::exception& e) {
-    LOG_ERROR("Standard exception processing relation: " + std::string(e.what()));
-  } catch (...) { LOG_ERROR("Exception caught processing relations."); }
+      sqlite3_bind_int(stmt, 6, admin.drive_on_right());
+      sqlite3_bind_int(stmt, 7, admin.allow_intersection_names());
+      sqlite3_bind_text(stmt, 8, wkt.c_str(), wkt.length(), SQLITE_STATIC);
+      /* performing INSERT INTO */
+      ret = sqlite3_step(stmt);
+      if (ret == SQLITE_DONE || ret == SQLITE_ROW) {
+        continue;
+      }
+      LOG_ERROR("sqlite3_step() error: " + std::string(sqlite3_errmsg(db_handle)));
+      LOG_ERROR("sqlite3_step() Name: " + osm_admin_data.name_offset_map.name(admin.name_index()));
+      LOG_ERROR("sqlite3_step() Name:en: " +
+                osm_admin_data.name_offset_map.name(admin.name_en_index()));
+      LOG_ERROR("sqlite3_step() Admin Level: " + std::to_string(admin.admin_level()));
+      LOG_ERROR("sqlite3_step() Drive on Right: " + std::to_string(admin.drive_on_right()));
+      LOG_ERROR("sqlite3_step() Allow Intersection Names: " +
+                std::to_string(admin.allow_intersection_names()));
+    }
+  } // admins
+  for (auto& thread : threads) {
+    thread.join();
+  }
 
   sqlite3_finalize(stmt);
   ret = sqlite3_exec(db_handle, "COMMIT", NULL, NULL, &err_msg);
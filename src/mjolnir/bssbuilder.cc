@@ -21,6 +21,7 @@
 #include "midgard/sequence.h"
 #include "midgard/util.h"
 #include "mjolnir/osmnode.h"
+#include "mjolnir/util.h"
 
 using namespace valhalla::midgard;
 using namespace valhalla::baldr;
@@ -333,6 +334,7 @@ void project_and_add_bss_nodes(const boost::property_tree::ptree& pt,
                                bss_by_tile_t::const_iterator tile_start,
                                bss_by_tile_t::const_iterator tile_end,
                                std::vector<BSSConnection>& all) {
+  thread_busy_time_t busy_time;
 
   GraphReader reader_local_level(pt);
   for (; tile_start != tile_end; ++tile_start) {
@@ -480,6 +482,7 @@ void create_edges_from_way_node(
     std::mutex& lock,
     std::unordered_map<GraphId, std::vector<BSSConnection>>::const_iterator tile_start,
     std::unordered_map<GraphId, std::vector<BSSConnection>>::const_iterator tile_end) {
+  thread_busy_time_t busy_time;
 
   GraphReader reader_local_level(pt);
   for (; tile_start != tile_end; ++tile_start) {
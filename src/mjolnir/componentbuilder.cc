@@ -0,0 +1,195 @@
+#include "mjolnir/componentbuilder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "baldr/graphcomponents.h"
+#include "baldr/graphconstants.h"
+#include "baldr/graphreader.h"
+#include "baldr/tilehierarchy.h"
+#include "midgard/logging.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+using tile_t = GraphComponents::tile_t;
+
+// The access modes the table is built for, loki looks them up by the access mode of a costing
+const std::vector<uint16_t> kComponentModes = {kAutoAccess, kTruckAccess, kBicycleAccess,
+                                               kPedestrianAccess};
+
+// Where the nodes of a tile start within all of the nodes of the graph
+struct tile_nodes_t {
+  uint32_t offset;
+  uint32_t node_count;
+};
+
+// The sets of nodes of the graph which are connected so far
+class DisjointSets {
+public:
+  explicit DisjointSets(const uint32_t count) : parents_(count) {
+    std::iota(parents_.begin(), parents_.end(), 0);
+  }
+
+  uint32_t Find(uint32_t node) {
+    // halve the paths on the way up so the next finds are shorter
+    while (parents_[node] != node) {
+      parents_[node] = parents_[parents_[node]];
+      node = parents_[node];
+    }
+    return node;
+  }
+
+  void Union(const uint32_t a, const uint32_t b) {
+    const auto root_a = Find(a);
+    const auto root_b = Find(b);
+    // the smaller root wins so that the roots do not depend on the order of the unions
+    if (root_a < root_b) {
+      parents_[root_b] = root_a;
+    } else if (root_b < root_a) {
+      parents_[root_a] = root_b;
+    }
+  }
+
+protected:
+  std::vector<uint32_t> parents_;
+};
+
+/**
+ * Connects the nodes of all tiles which an edge the mode has access to or a transition between
+ * the levels connects. Edges which leave the tiles of the graph connect nothing.
+ */
+void connect(GraphReader& reader,
+             const std::vector<tile_t>& tiles,
+             const std::unordered_map<uint64_t, tile_nodes_t>& tile_nodes,
+             const uint16_t mode,
+             DisjointSets& sets) {
+  auto node_index = [&tile_nodes](const GraphId& node_id, uint32_t& index) {
+    auto found = tile_nodes.find(node_id.Tile_Base().value);
+    if (found == tile_nodes.cend() || node_id.id() >= found->second.node_count) {
+      return false;
+    }
+    index = found->second.offset + node_id.id();
+    return true;
+  };
+
+  for (const auto& tile_info : tiles) {
+    auto tile = reader.GetGraphTile(GraphId(tile_info.tile));
+    const auto first_node = tile_nodes.at(tile_info.tile).offset;
+    for (uint32_t n = 0; n < tile->header()->nodecount(); ++n) {
+      const auto* node = tile->node(n);
+      uint32_t end = 0;
+      for (const auto& transition : tile->GetNodeTransitions(node)) {
+        if (node_index(transition.endnode(), end)) {
+          sets.Union(first_node + n, end);
+        }
+      }
+      for (uint32_t i = 0; i < node->edge_count(); ++i) {
+        const auto* edge = tile->directededge(node->edge_index() + i);
+        if (((edge->forwardaccess() | edge->reverseaccess()) & mode) &&
+            node_index(edge->endnode(), end)) {
+          sets.Union(first_node + n, end);
+        }
+      }
+    }
+    if (reader.OverCommitted()) {
+      reader.Trim();
+    }
+  }
+}
+
+/**
+ * Writes the component of each edge of the tiles for the column of a mode, the components are
+ * numbered from 0 in the order their first edge comes in.
+ */
+void label(GraphReader& reader,
+           const std::vector<tile_t>& tiles,
+           const std::unordered_map<uint64_t, tile_nodes_t>& tile_nodes,
+           const uint16_t mode,
+           const size_t column,
+           DisjointSets& sets,
+           std::vector<uint32_t>& components) {
+  std::unordered_map<uint32_t, uint32_t> labels;
+  for (const auto& tile_info : tiles) {
+    auto tile = reader.GetGraphTile(GraphId(tile_info.tile));
+    const auto first_node = tile_nodes.at(tile_info.tile).offset;
+    for (uint32_t n = 0; n < tile->header()->nodecount(); ++n) {
+      const auto* node = tile->node(n);
+      for (uint32_t i = 0; i < node->edge_count(); ++i) {
+        const auto edge_index = node->edge_index() + i;
+        const auto* edge = tile->directededge(edge_index);
+        const size_t index = static_cast<size_t>(tile_info.offset) + edge_index;
+        auto& component = components[index * kComponentModes.size() + column];
+        if (!((edge->forwardaccess() | edge->reverseaccess()) & mode)) {
+          component = GraphComponents::kNoComponent;
+          continue;
+        }
+        component = labels.emplace(sets.Find(first_node + n), labels.size()).first->second;
+      }
+    }
+    if (reader.OverCommitted()) {
+      reader.Trim();
+    }
+  }
+  LOG_INFO("Found " + std::to_string(labels.size()) + " components for access mode " +
+           std::to_string(mode));
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+void ComponentBuilder::Build(const boost::property_tree::ptree& pt) {
+  const auto file = pt.get<std::string>("mjolnir.graph_components");
+  GraphReader reader(pt.get_child("mjolnir"));
+
+  // Only the road levels take part, the tiles are sorted by id and their edges numbered in order
+  std::vector<tile_t> tiles;
+  std::unordered_map<uint64_t, tile_nodes_t> tile_nodes;
+  for (const auto& level : TileHierarchy::levels()) {
+    for (const auto& tile_id : reader.GetTileSet(level.level)) {
+      auto tile = reader.GetGraphTile(tile_id);
+      tiles.push_back({tile_id.value, 0, tile->header()->directededgecount()});
+      tile_nodes.emplace(tile_id.value, tile_nodes_t{0, tile->header()->nodecount()});
+      if (reader.OverCommitted()) {
+        reader.Trim();
+      }
+    }
+  }
+  reader.Clear();
+  std::sort(tiles.begin(), tiles.end(),
+            [](const tile_t& a, const tile_t& b) { return a.tile < b.tile; });
+  uint32_t edge_count = 0;
+  uint32_t node_count = 0;
+  for (auto& tile : tiles) {
+    tile.offset = edge_count;
+    edge_count += tile.edge_count;
+    auto& nodes = tile_nodes[tile.tile];
+    nodes.offset = node_count;
+    node_count += nodes.node_count;
+  }
+
+  // One mode at a time so that only the sets of one of them are in memory
+  LOG_INFO("Computing the components of " + std::to_string(node_count) + " nodes and " +
+           std::to_string(edge_count) + " edges...");
+  std::vector<uint32_t> components(static_cast<size_t>(edge_count) * kComponentModes.size());
+  for (size_t column = 0; column < kComponentModes.size(); ++column) {
+    DisjointSets sets(node_count);
+    connect(reader, tiles, tile_nodes, kComponentModes[column], sets);
+    label(reader, tiles, tile_nodes, kComponentModes[column], column, sets, components);
+  }
+
+  auto modes = kComponentModes;
+  GraphComponents(std::move(modes), std::move(tiles), std::move(components)).Save(file);
+  LOG_INFO("Wrote graph components to " + file);
+}
+
+} // namespace mjolnir
+} // namespace valhalla
@@ -0,0 +1,294 @@
+#include "mjolnir/contractionbuilder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "baldr/contractionhierarchy.h"
+#include "baldr/graphconstants.h"
+#include "baldr/graphreader.h"
+#include "baldr/rapidjson_utils.h"
+#include "baldr/tilehierarchy.h"
+#include "midgard/logging.h"
+#include "sif/autocost.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+using arc_t = ContractionHierarchy::arc_t;
+
+constexpr uint32_t kUncontracted = std::numeric_limits<uint32_t>::max();
+constexpr float kInfinity = std::numeric_limits<float>::max();
+
+// Bounds the witness searches, a witness we miss only costs us a superfluous shortcut
+constexpr uint32_t kMaxWitnessSettled = 500;
+
+// The overlay is built for default auto costing without time dependence, which is what requests
+// without a date_time get too, so live and predicted speeds are not part of it
+valhalla::sif::cost_ptr_t DefaultAutoCost() {
+  rapidjson::Document doc;
+  doc.SetObject();
+  valhalla::CostingOptions options;
+  valhalla::sif::ParseAutoCostOptions(doc, "/costing_options/auto", &options);
+  options.set_flow_mask(static_cast<uint8_t>(options.flow_mask()) &
+                        ~(kPredictedFlowMask | kCurrentFlowMask));
+  return valhalla::sif::CreateAutoCost(options);
+}
+
+/**
+ * Contracts the nodes one by one in order of the edge difference, the shortcuts needed minus the
+ * arcs removed, plus the number of neighbours already contracted to keep the hierarchy balanced.
+ * Contracting a node adds a shortcut between a pair of its neighbours whenever a bounded witness
+ * search does not find a path between them at most as expensive as the one through the node.
+ */
+class Contractor {
+public:
+  Contractor(const size_t node_count, std::vector<arc_t>& arcs)
+      : arcs_(arcs), out_(node_count), in_(node_count), rank_(node_count, kUncontracted),
+        contracted_neighbours_(node_count, 0), cost_(node_count, kInfinity) {
+    for (uint32_t i = 0; i < arcs_.size(); ++i) {
+      out_[arcs_[i].from].push_back(i);
+      in_[arcs_[i].to].push_back(i);
+    }
+  }
+
+  /**
+   * Contracts all of the nodes and adds the shortcuts to the arcs.
+   * @return the rank of each node
+   */
+  std::vector<uint32_t> Contract() {
+    using entry_t = std::pair<float, uint32_t>;
+    std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> queue;
+    for (uint32_t node = 0; node < rank_.size(); ++node) {
+      queue.emplace(Priority(node), node);
+    }
+
+    uint32_t order = 0;
+    while (!queue.empty()) {
+      auto node = queue.top().second;
+      queue.pop();
+
+      // Contracting other nodes changes the priority so it is updated lazily
+      auto priority = Priority(node);
+      if (!queue.empty() && priority > queue.top().first) {
+        queue.emplace(priority, node);
+        continue;
+      }
+
+      Shortcuts(node, true);
+      rank_[node] = order++;
+      for (const auto& neighbour : ins_) {
+        ++contracted_neighbours_[neighbour.first];
+      }
+      for (const auto& neighbour : outs_) {
+        ++contracted_neighbours_[neighbour.first];
+      }
+      if (order % 1000000 == 0) {
+        LOG_INFO("Contracted " + std::to_string(order) + " nodes");
+      }
+    }
+    return std::move(rank_);
+  }
+
+protected:
+  std::vector<arc_t>& arcs_;
+  std::vector<std::vector<uint32_t>> out_;
+  std::vector<std::vector<uint32_t>> in_;
+  std::vector<uint32_t> rank_;
+  std::vector<uint32_t> contracted_neighbours_;
+
+  // the uncontracted neighbours of the current node and the cheapest arc to each of them
+  std::vector<std::pair<uint32_t, uint32_t>> ins_;
+  std::vector<std::pair<uint32_t, uint32_t>> outs_;
+
+  // witness search state, only the touched costs are reset between searches
+  std::vector<float> cost_;
+  std::vector<uint32_t> touched_;
+
+  float Priority(const uint32_t node) {
+    auto shortcuts = static_cast<float>(Shortcuts(node, false));
+    return shortcuts - ins_.size() - outs_.size() + contracted_neighbours_[node];
+  }
+
+  void Neighbours(const uint32_t node,
+                  const std::vector<uint32_t>& arcs,
+                  const bool outbound,
+                  std::vector<std::pair<uint32_t, uint32_t>>& neighbours) const {
+    neighbours.clear();
+    for (auto index : arcs) {
+      auto other = outbound ? arcs_[index].to : arcs_[index].from;
+      if (other == node || rank_[other] != kUncontracted) {
+        continue;
+      }
+      auto found = std::find_if(neighbours.begin(), neighbours.end(),
+                                [other](const auto& neighbour) { return neighbour.first == other; });
+      if (found == neighbours.end()) {
+        neighbours.emplace_back(other, index);
+      } else if (arcs_[index].cost < arcs_[found->second].cost) {
+        found->second = index;
+      }
+    }
+  }
+
+  // Returns how many shortcuts contracting the node takes and optionally adds them
+  uint32_t Shortcuts(const uint32_t node, const bool add) {
+    Neighbours(node, in_[node], false, ins_);
+    Neighbours(node, out_[node], true, outs_);
+
+    uint32_t count = 0;
+    for (const auto& in : ins_) {
+      const float in_cost = arcs_[in.second].cost;
+      float limit = -1.f;
+      for (const auto& out : outs_) {
+        if (out.first != in.first) {
+          limit = std::max(limit, in_cost + arcs_[out.second].cost);
+        }
+      }
+      if (limit < 0.f) {
+        continue;
+      }
+
+      Witness(in.first, node, limit);
+      for (const auto& out : outs_) {
+        const float cost = in_cost + arcs_[out.second].cost;
+        if (out.first == in.first || cost_[out.first] <= cost) {
+          continue;
+        }
+        ++count;
+        if (add) {
+          const auto index = static_cast<uint32_t>(arcs_.size());
+          arcs_.push_back({kInvalidGraphId, in.first, out.first, cost, in.second, out.second, 0});
+          out_[in.first].push_back(index);
+          in_[out.first].push_back(index);
+        }
+      }
+    }
+    return count;
+  }
+
+  // Finds the cheapest paths from the source that avoid the node being contracted
+  void Witness(const uint32_t source, const uint32_t avoid, const float limit) {
+    for (auto node : touched_) {
+      cost_[node] = kInfinity;
+    }
+    touched_.clear();
+
+    using entry_t = std::pair<float, uint32_t>;
+    std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> queue;
+    cost_[source] = 0.f;
+    touched_.push_back(source);
+    queue.emplace(0.f, source);
+    for (uint32_t settled = 0; !queue.empty() && settled < kMaxWitnessSettled; ++settled) {
+      auto current = queue.top();
+      queue.pop();
+      if (current.first > limit) {
+        break;
+      }
+      if (current.first > cost_[current.second]) {
+        continue;
+      }
+      for (auto index : out_[current.second]) {
+        const auto& arc = arcs_[index];
+        const float cost = current.first + arc.cost;
+        if (arc.to == avoid || rank_[arc.to] != kUncontracted || cost >= cost_[arc.to]) {
+          continue;
+        }
+        if (cost_[arc.to] == kInfinity) {
+          touched_.push_back(arc.to);
+        }
+        cost_[arc.to] = cost;
+        queue.emplace(cost, arc.to);
+      }
+    }
+  }
+};
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+void ContractionBuilder::Build(const boost::property_tree::ptree& pt) {
+  const auto file = pt.get<std::string>("mjolnir.contraction_hierarchy");
+  GraphReader reader(pt.get_child("mjolnir"));
+  auto costing = DefaultAutoCost();
+
+  // Every road level takes part, the levels are joined by the node transitions. The nodes are
+  // sorted by id so that they can be looked up
+  std::vector<GraphId> nodes;
+  for (const auto& level : TileHierarchy::levels()) {
+    for (const auto& tile_id : reader.GetTileSet(level.level)) {
+      auto tile = reader.GetGraphTile(tile_id);
+      for (uint32_t i = 0; i < tile->header()->nodecount(); ++i) {
+        nodes.emplace_back(tile_id.tileid(), tile_id.level(), i);
+      }
+      if (reader.OverCommitted()) {
+        reader.Trim();
+      }
+    }
+  }
+  auto by_id = [](const GraphId& a, const GraphId& b) { return a.value < b.value; };
+  std::sort(nodes.begin(), nodes.end(), by_id);
+  auto index_of = [&nodes, &by_id](const GraphId& node) {
+    auto found = std::lower_bound(nodes.cbegin(), nodes.cend(), node, by_id);
+    return found != nodes.cend() && *found == node ? static_cast<uint32_t>(found - nodes.cbegin())
+                                                   : ContractionHierarchy::kInvalidNode;
+  };
+
+  // The arcs are the edges and transitions the costing can use between nodes it can pass
+  std::vector<arc_t> arcs;
+  graph_tile_ptr tile;
+  for (uint32_t from = 0; from < nodes.size(); ++from) {
+    if (nodes[from].id() == 0 && reader.OverCommitted()) {
+      reader.Trim();
+    }
+    const auto* node = reader.nodeinfo(nodes[from], tile);
+    if (node == nullptr || !costing->Allowed(node)) {
+      continue;
+    }
+
+    GraphId edgeid(nodes[from].tileid(), nodes[from].level(), node->edge_index());
+    for (uint32_t i = 0; i < node->edge_count(); ++i, ++edgeid) {
+      const auto* edge = tile->directededge(edgeid);
+      if (edge->is_shortcut() || !costing->Allowed(edge, tile)) {
+        continue;
+      }
+      auto end_tile = tile;
+      const auto* end = reader.nodeinfo(edge->endnode(), end_tile);
+      auto to = index_of(edge->endnode());
+      if (end == nullptr || to == ContractionHierarchy::kInvalidNode || !costing->Allowed(end)) {
+        continue;
+      }
+      arcs.push_back({edgeid.value, from, to, costing->EdgeCost(edge, tile).cost,
+                      ContractionHierarchy::kInvalidArc, ContractionHierarchy::kInvalidArc, 0});
+    }
+
+    for (const auto& transition : tile->GetNodeTransitions(node)) {
+      auto to = index_of(transition.endnode());
+      if (to != ContractionHierarchy::kInvalidNode) {
+        arcs.push_back({kInvalidGraphId, from, to, 0.f, ContractionHierarchy::kInvalidArc,
+                        ContractionHierarchy::kInvalidArc, 0});
+      }
+    }
+  }
+
+  LOG_INFO("Contracting " + std::to_string(nodes.size()) + " nodes with " +
+           std::to_string(arcs.size()) + " arcs");
+  const auto original = arcs.size();
+  auto rank = Contractor(nodes.size(), arcs).Contract();
+  LOG_INFO("Finished with " + std::to_string(arcs.size() - original) + " shortcuts");
+
+  ContractionHierarchy(std::move(nodes), std::move(arcs), rank).Save(file);
+  LOG_INFO("Wrote contraction hierarchy to " + file);
+}
+
+} // namespace mjolnir
+} // namespace valhalla
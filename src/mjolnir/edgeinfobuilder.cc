@@ -1,5 +1,7 @@
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <ostream>
 
 #include "baldr/edgeinfo.h"
@@ -80,12 +82,46 @@ void EdgeInfoBuilder::set_encoded_shape(const std::string& encoded_shape) {
   std::copy(encoded_shape.begin(), encoded_shape.end(), back_inserter(encoded_shape_));
 }
 
+// Set the elevations of the shape points. The first is encoded relative to the lowest elevation
+// there can be and each one after it is an offset from the one before.
+template <class elevation_container_t>
+void EdgeInfoBuilder::set_elevation(const elevation_container_t& elevation) {
+  std::string encoded(elevation.size() * 5, '\0');
+  char* out = &encoded[0];
+  int32_t last = 0;
+  for (auto height : elevation) {
+    height = std::min(std::max(static_cast<float>(height), kMinElevation), kMaxElevation);
+    auto value =
+        static_cast<int32_t>(std::round((height - kMinElevation) / kShapeElevationPrecision));
+    out = midgard::detail::serialize7(value - last, out);
+    last = value;
+  }
+  encoded.resize(out - encoded.data());
+  set_encoded_elevation(encoded);
+}
+template void EdgeInfoBuilder::set_elevation<std::vector<float>>(const std::vector<float>&);
+template void EdgeInfoBuilder::set_elevation<std::vector<double>>(const std::vector<double>&);
+
+// Set the encoded elevations of the shape points.
+void EdgeInfoBuilder::set_encoded_elevation(const std::string& encoded_elevation) {
+  if (encoded_elevation.size() > std::numeric_limits<uint16_t>::max()) {
+    LOG_WARN("Exceeding max encoded elevation size: " + std::to_string(encoded_elevation.size()));
+    encoded_elevation_.clear();
+  } else {
+    encoded_elevation_ = encoded_elevation;
+  }
+  ei_.has_elevation_ = !encoded_elevation_.empty();
+}
+
 // Get the size of the edge info (including name offsets and shape string)
 std::size_t EdgeInfoBuilder::BaseSizeOf() const {
   std::size_t size = sizeof(EdgeInfo::EdgeInfoInner);
   size += (name_info_list_.size() * sizeof(NameInfo));
   size += (encoded_shape_.size() * sizeof(std::string::value_type));
   size += ei_.extended_wayid_size_;
+  if (ei_.has_elevation_) {
+    size += sizeof(uint16_t) + encoded_elevation_.size();
+  }
   return size;
 }
 
@@ -131,6 +167,11 @@ std::ostream& operator<<(std::ostream& os, const EdgeInfoBuilder& eib) {
   if (ei.extended_wayid_size_ > 1) {
     os.write(reinterpret_cast<const char*>(&eib.extended_wayid3_), sizeof(eib.extended_wayid3_));
   }
+  if (ei.has_elevation_) {
+    auto size = static_cast<uint16_t>(eib.encoded_elevation_.size());
+    os.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    os << eib.encoded_elevation_;
+  }
 
   // Pad to a 4 byte boundary
   std::size_t padding = (eib.BaseSizeOf() % 4);
@@ -1,6 +1,8 @@
 #include "mjolnir/util.h"
 
+#include <algorithm>
 #include <boost/format.hpp>
+#include <cmath>
 #include <future>
 #include <set>
 #include <thread>
@@ -9,6 +11,7 @@
 #include "baldr/graphconstants.h"
 #include "baldr/graphid.h"
 #include "baldr/graphreader.h"
+#include "baldr/tilehierarchy.h"
 #include "filesystem.h"
 #include "midgard/logging.h"
 #include "midgard/pointll.h"
@@ -34,6 +37,52 @@ constexpr double POSTING_INTERVAL = 60;
 // Do not compute grade for intervals less than 10 meters.
 constexpr double kMinimumInterval = 10.0f;
 
+/**
+ * The elevation tile which a graph tile starts in. Graph tiles of the same elevation tile are
+ * processed together so the elevation tile is inflated once for all of them.
+ */
+uint32_t elevation_tile(const GraphId& id) {
+  const auto& tiles = id.level() == TileHierarchy::GetTransitLevel().level
+                          ? TileHierarchy::GetTransitLevel().tiles
+                          : TileHierarchy::get_tiling(id.level());
+  // nudge it inside so a corner on a degree line counts for the tile it belongs to
+  auto corner = tiles.TileBounds(id.tileid()).minpt();
+  auto lon = static_cast<uint32_t>(std::floor(corner.lng() + 1e-6) + 180);
+  auto lat = static_cast<uint32_t>(std::floor(corner.lat() + 1e-6) + 90);
+  return lat * 360 + lon;
+}
+
+/**
+ * The elevation at each point of the shape of an edge. A bridge spans whatever is below it so its
+ * elevation is only sampled at the ends and goes evenly from one to the other in between.
+ * @return  Returns the elevations, empty if there is no elevation data for some of the shape.
+ */
+std::vector<double> shape_heights(const valhalla::skadi::sample& sample,
+                                  const std::vector<PointLL>& shape,
+                                  bool bridge) {
+  const auto no_data = valhalla::skadi::sample::get_no_data_value();
+  auto heights = sample.get_all(bridge ? std::vector<PointLL>{shape.front(), shape.back()} : shape);
+  if (std::find(heights.begin(), heights.end(), no_data) != heights.end()) {
+    return {};
+  }
+  if (!bridge) {
+    return heights;
+  }
+
+  // spread the difference between the ends over the length of the bridge
+  std::vector<double> along(1, 0.);
+  for (size_t i = 1; i < shape.size(); ++i) {
+    along.push_back(along.back() + shape[i - 1].Distance(shape[i]));
+  }
+  std::vector<double> spanned;
+  spanned.reserve(shape.size());
+  for (auto distance : along) {
+    double pct = along.back() > 0 ? distance / along.back() : 0.;
+    spanned.push_back(heights.front() + (heights.back() - heights.front()) * pct);
+  }
+  return spanned;
+}
+
 /**
  * Adds elevation to a set of tiles. Each thread pulls a tile of the queue
  */
@@ -42,6 +91,7 @@ void add_elevation(const boost::property_tree::ptree& pt,
                    std::mutex& lock,
                    const std::unique_ptr<const valhalla::skadi::sample>& sample,
                    std::promise<uint32_t>& /*result*/) {
+  thread_busy_time_t busy_time;
   // Local Graphreader
   GraphReader graphreader(pt.get_child("mjolnir"));
 
@@ -137,6 +187,14 @@ void add_elevation(const boost::property_tree::ptree& pt,
 
         // Set the mean elevation on EdgeInfo
         tilebuilder.set_mean_elevation(edge_info_offset, mean_elevation);
+
+        // Keep the elevation of every shape point so height profiles can be had from the tiles
+        if (!directededge.tunnel() && directededge.use() != Use::kFerry) {
+          auto heights = shape_heights(*sample, shape, directededge.bridge());
+          if (!heights.empty()) {
+            tilebuilder.set_elevation(edge_info_offset, heights);
+          }
+        }
       }
 
       // Edge elevation information. If the edge is forward (with respect to the shape)
@@ -174,31 +232,38 @@ void ElevationBuilder::Build(const boost::property_tree::ptree& pt) {
 
   // Crack open some elevation data if its there. Return if it is not.
   boost::optional<std::string> elevation = pt.get_optional<std::string>("additional_data.elevation");
-  std::unique_ptr<const skadi::sample> sample;
-  if (elevation && filesystem::exists(*elevation)) {
-    sample.reset(new skadi::sample(*elevation));
-  } else {
+  if (!elevation || !filesystem::exists(*elevation)) {
     LOG_INFO("ElevationBuilder: no elevation data, skipping");
     return;
   }
 
-  // Create a randomized queue of tiles (at all levels) to work from
-  std::deque<GraphId> tilequeue;
+  // Setup threads
+  uint32_t nthreads =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency()));
+
+  // All the threads share the decompressed tiles, keep a couple per thread since the edges of a
+  // graph tile reach into the neighbouring elevation tiles
+  auto cache_bytes = std::max<size_t>(pt.get<size_t>("additional_data.elevation_cache_size",
+                                                      skadi::kDefaultUnzippedCacheBytes),
+                                       2 * nthreads * skadi::kUnzippedTileBytes);
+  std::unique_ptr<const skadi::sample> sample(new skadi::sample(*elevation, cache_bytes));
+
+  // Create a queue of tiles (at all levels) to work from ordered by the elevation tile they are in
+  // so that the threads work on neighbouring graph tiles and find the elevation already inflated
+  std::vector<std::pair<uint32_t, GraphId>> tiles;
   GraphReader reader(pt.get_child("mjolnir"));
-  auto tileset = reader.GetTileSet();
-  for (const auto& id : tileset) {
-    tilequeue.emplace_back(id);
+  for (const auto& id : reader.GetTileSet()) {
+    tiles.emplace_back(elevation_tile(id), id);
+  }
+  std::sort(tiles.begin(), tiles.end());
+  std::deque<GraphId> tilequeue;
+  for (const auto& tile : tiles) {
+    tilequeue.emplace_back(tile.second);
   }
-  std::random_device rd;
-  std::shuffle(tilequeue.begin(), tilequeue.end(), std::mt19937(rd()));
 
   // An mutex we can use to do the synchronization
   std::mutex lock;
-
-  // Setup threads
-  uint32_t nthreads =
-      std::max(static_cast<unsigned int>(1),
-               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency()));
   std::vector<std::shared_ptr<std::thread>> threads(nthreads);
 
   // Setup promises. Hold the results for the threads
@@ -229,7 +294,8 @@ void ElevationBuilder::Build(const boost::property_tree::ptree& pt) {
       }
     }
   } **/
-  LOG_INFO("Finished");
+  LOG_INFO("Finished, the elevation was inflated " + std::to_string(sample->cache_misses()) +
+           " times and reused " + std::to_string(sample->cache_hits()) + " times");
 }
 
 } // namespace mjolnir
@@ -0,0 +1,228 @@
+#include "mjolnir/extractbuilder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "baldr/graphid.h"
+#include "baldr/graphtile.h"
+#include "baldr/tilehierarchy.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+#include "midgard/sequence.h"
+#include "mjolnir/util.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+using header_t = tar::header_t;
+
+// The index is a packed array, sorted by tile id, of these entries which must match
+// GraphReader::tile_extract_t::index_entry_t
+struct index_entry_t {
+  uint64_t offset;  // byte offset of the tile data from the beginning of the archive
+  uint32_t tile_id; // the level and tile id of the tile (ie graph id with no id)
+  uint32_t size;    // the size of the tile data in bytes
+};
+constexpr char kIndexFileName[] = "index.bin";
+
+// Every member of a tar is a header block followed by its data rounded up to whole blocks
+constexpr uint64_t kBlockSize = sizeof(header_t);
+// The data of every tile starts at a multiple of this so that it can be mapped on its own
+constexpr uint64_t kTileAlignment = 4096;
+// Like most tar writers we end the archive with 2 empty blocks padded out to whole records
+constexpr uint64_t kRecordSize = 20 * kBlockSize;
+
+// Name of the members which only exist to push the next tile onto a page boundary
+constexpr char kPaddingFileName[] = "padding";
+
+uint64_t blocks(uint64_t size) {
+  return (size + kBlockSize - 1) / kBlockSize * kBlockSize;
+}
+
+// A tile to copy into the extract
+struct tile_t {
+  GraphId id;
+  std::string file; // where it is on disk
+  std::string path; // relative to the tile dir with forward slashes as tar wants them
+  uint64_t size;
+  time_t mtime;
+  bool operator<(const tile_t& other) const {
+    return id < other.id;
+  }
+};
+
+// Writes the number as zero padded octal into the field leaving room for the trailing NUL
+template <size_t N> void octal(char (&field)[N], uint64_t value) {
+  snprintf(field, N, "%0*llo", static_cast<int>(N - 1), static_cast<unsigned long long>(value));
+}
+
+// A ustar header for a regular file, which is what python's tarfile and GNU tar both write
+header_t make_header(const std::string& name, uint64_t size, time_t mtime) {
+  if (name.size() >= sizeof(header_t::name)) {
+    throw std::runtime_error("Tile path " + name + " is too long for a tar header");
+  }
+  header_t header{};
+  std::copy(name.cbegin(), name.cend(), header.name);
+  octal(header.mode, 0644);
+  octal(header.uid, 0);
+  octal(header.gid, 0);
+  octal(header.size, size);
+  octal(header.mtime, mtime);
+  header.typeflag = '0';
+  std::memcpy(header.magic, "ustar", 6);
+  std::memcpy(header.version, "00", 2);
+
+  // the checksum is the sum of all the bytes with the checksum itself counted as spaces
+  std::memset(header.chksum, ' ', sizeof(header.chksum));
+  uint64_t sum = 0;
+  for (size_t i = 0; i < sizeof(header_t); ++i) {
+    sum += reinterpret_cast<const unsigned char*>(&header)[i];
+  }
+  snprintf(header.chksum, sizeof(header.chksum), "%06llo", static_cast<unsigned long long>(sum));
+  return header;
+}
+
+// Gap in front of a tile header at this offset so that the tiles data starts on a page. Its 0
+// or room for a padding member, ie a header and some whole blocks
+uint64_t padding(uint64_t offset) {
+  return (kTileAlignment - (offset + kBlockSize) % kTileAlignment) % kTileAlignment;
+}
+
+// Writes the header and the data of a member and fills the rest of its last block with zeros
+void write_member(std::ofstream& file,
+                  const std::string& name,
+                  const char* data,
+                  uint64_t size,
+                  time_t mtime) {
+  auto header = make_header(name, size, mtime);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(data, size);
+  std::vector<char> zeros(blocks(size) - size, 0);
+  file.write(zeros.data(), zeros.size());
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+void ExtractBuilder::Build(const boost::property_tree::ptree& pt) {
+  std::string tile_dir = pt.get<std::string>("mjolnir.tile_dir");
+  if (tile_dir.back() != filesystem::path::preferred_separator) {
+    tile_dir.push_back(filesystem::path::preferred_separator);
+  }
+  const auto tile_extract = pt.get<std::string>("mjolnir.tile_extract");
+  const bool remove_tiles = pt.get<bool>("mjolnir.tile_extract_remove_tiles", false);
+
+  // Find all the tiles and sort them by id so the index can be binary searched
+  std::vector<tile_t> tiles;
+  for (filesystem::recursive_directory_iterator i(tile_dir), end; i != end; ++i) {
+    auto path = i->path().string();
+    if (!i->is_regular_file() || path.size() <= SUFFIX_NON_COMPRESSED.size() ||
+        path.compare(path.size() - SUFFIX_NON_COMPRESSED.size(), SUFFIX_NON_COMPRESSED.size(),
+                     SUFFIX_NON_COMPRESSED) != 0) {
+      continue;
+    }
+    path = path.substr(tile_dir.size());
+    GraphId id;
+    try {
+      id = GraphTile::GetTileId(path);
+    } catch (...) {
+      // not a tile of ours
+      continue;
+    }
+    struct stat s;
+    if (stat(i->path().c_str(), &s) != 0) {
+      throw std::runtime_error("Could not stat " + i->path().string());
+    }
+    std::replace(path.begin(), path.end(), filesystem::path::preferred_separator, '/');
+    tiles.push_back({id, i->path().string(), path, static_cast<uint64_t>(s.st_size), s.st_mtime});
+  }
+  std::sort(tiles.begin(), tiles.end());
+  if (tiles.empty()) {
+    LOG_WARN("No tiles found in " + tile_dir + ", not writing a tile extract");
+    return;
+  }
+  LOG_INFO("Writing " + std::to_string(tiles.size()) + " tiles to " + tile_extract);
+
+  // The index goes first so we know exactly where every tile will land in the archive
+  std::vector<index_entry_t> index;
+  index.reserve(tiles.size());
+  uint64_t offset = kBlockSize + blocks(tiles.size() * sizeof(index_entry_t));
+  for (const auto& tile : tiles) {
+    offset += padding(offset);
+    index.push_back({offset + kBlockSize, static_cast<uint32_t>(tile.id.value), 0});
+    if (tile.size > std::numeric_limits<uint32_t>::max()) {
+      throw std::runtime_error("Tile " + tile.path + " is too large for the tile extract index");
+    }
+    index.back().size = static_cast<uint32_t>(tile.size);
+    offset += kBlockSize + blocks(tile.size);
+  }
+
+  // Stream it all into a temporary file so that readers never see a partial extract
+  const auto temp_extract = tile_extract + ".tmp";
+  std::ofstream file(temp_extract, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    throw std::runtime_error("Could not open " + temp_extract + " for writing");
+  }
+  write_member(file, kIndexFileName, reinterpret_cast<const char*>(index.data()),
+               index.size() * sizeof(index_entry_t), time(nullptr));
+  std::vector<char> buffer;
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    const auto& tile = tiles[i];
+
+    // Pad out to the page the tile has its data on
+    uint64_t gap = index[i].offset - kBlockSize - static_cast<uint64_t>(file.tellp());
+    if (gap != 0) {
+      buffer.assign(gap - kBlockSize, 0);
+      write_member(file, kPaddingFileName, buffer.data(), buffer.size(), tile.mtime);
+    }
+
+    // Copy the tile over and let go of it if asked to
+    std::ifstream tile_file(tile.file, std::ios::binary);
+    buffer.resize(tile.size);
+    if (!tile_file.read(buffer.data(), buffer.size())) {
+      throw std::runtime_error("Could not read " + tile.file);
+    }
+    write_member(file, tile.path, buffer.data(), buffer.size(), tile.mtime);
+    if (!file) {
+      throw std::runtime_error("Could not write to " + temp_extract);
+    }
+    if (remove_tiles) {
+      filesystem::remove(tile.file);
+    }
+  }
+
+  // End of archive and out to a whole record
+  uint64_t size = static_cast<uint64_t>(file.tellp()) + 2 * kBlockSize;
+  buffer.assign(2 * kBlockSize + (kRecordSize - size % kRecordSize) % kRecordSize, 0);
+  file.write(buffer.data(), buffer.size());
+  file.close();
+  if (!file || !filesystem::rename(temp_extract, tile_extract)) {
+    throw std::runtime_error("Could not write " + tile_extract);
+  }
+
+  // Get rid of the now empty tile directories
+  if (remove_tiles) {
+    for (const auto& level : TileHierarchy::levels()) {
+      filesystem::remove_all(tile_dir + std::to_string(level.level));
+    }
+    filesystem::remove_all(tile_dir + std::to_string(TileHierarchy::GetTransitLevel().level));
+  }
+  LOG_INFO("Finished writing the tile extract");
+}
+
+} // namespace mjolnir
+} // namespace valhalla
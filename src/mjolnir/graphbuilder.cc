@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <deque>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <thread>
 #include <utility>
@@ -40,12 +44,14 @@ namespace {
  * we also need to then update the edges that pointed to them
  *
  */
-std::map<GraphId, size_t> SortGraph(const std::string& nodes_file, const std::string& edges_file) {
+std::map<GraphId, size_t> SortGraph(const boost::property_tree::ptree& pt,
+                                    const std::string& nodes_file,
+                                    const std::string& edges_file) {
   LOG_INFO("Sorting graph...");
 
   // Sort nodes by graphid then by osmid, so its basically a set of tiles
   sequence<Node> nodes(nodes_file, false);
-  nodes.sort([](const Node& a, const Node& b) {
+  sort_sequence(pt, nodes, [](const Node& a, const Node& b) {
     if (a.graph_id == b.graph_id) {
       return a.node.osmid_ < b.node.osmid_;
     }
@@ -369,6 +375,13 @@ uint32_t AddAccessRestrictions(const uint32_t edgeid,
   return modes;
 }
 
+// A tile to build and where its nodes are
+struct tile_task_t {
+  GraphId tile;
+  size_t node_index;
+  size_t node_count;
+};
+
 void BuildTileSet(const std::string& ways_file,
                   const std::string& way_nodes_file,
                   const std::string& nodes_file,
@@ -377,11 +390,14 @@ void BuildTileSet(const std::string& ways_file,
                   const std::string& complex_restriction_to_file,
                   const std::string& tile_dir,
                   const OSMData& osmdata,
-                  std::map<GraphId, size_t>::const_iterator tile_start,
-                  std::map<GraphId, size_t>::const_iterator tile_end,
+                  std::deque<tile_task_t>& tilequeue,
+                  std::mutex& lock,
                   const uint32_t tile_creation_date,
+                  const AdminIndex* admins,
+                  const TimeZoneIndex* timezones,
                   const boost::property_tree::ptree& pt,
                   std::promise<DataQuality>& result) {
+  thread_busy_time_t busy_time;
 
   sequence<OSMWay> ways(ways_file, false);
   sequence<OSMWayNode> way_nodes(way_nodes_file, false);
@@ -390,29 +406,11 @@ void BuildTileSet(const std::string& ways_file,
   sequence<OSMRestriction> complex_restrictions_from(complex_restriction_from_file, false);
   sequence<OSMRestriction> complex_restrictions_to(complex_restriction_to_file, false);
 
-  auto database = pt.get_optional<std::string>("admin");
   bool infer_internal_intersections =
       pt.get<bool>("data_processing.infer_internal_intersections", true);
   bool use_urban_tag = pt.get<bool>("data_processing.use_urban_tag", false);
   bool use_admin_db = pt.get<bool>("data_processing.use_admin_db", true);
 
-  // Initialize the admin DB (if it exists)
-  sqlite3* admin_db_handle = (database && use_admin_db) ? GetDBHandle(*database) : nullptr;
-  if (!database && use_admin_db) {
-    LOG_WARN("Admin db not found.  Not saving admin information.");
-  } else if (!admin_db_handle && use_admin_db) {
-    LOG_WARN("Admin db " + *database + " not found.  Not saving admin information.");
-  }
-
-  database = pt.get_optional<std::string>("timezone");
-  // Initialize the tz DB (if it exists)
-  sqlite3* tz_db_handle = database ? GetDBHandle(*database) : nullptr;
-  if (!database) {
-    LOG_WARN("Time zone db not found.  Not saving time zone information.");
-  } else if (!tz_db_handle) {
-    LOG_WARN("Time zone db " + *database + " not found.  Not saving time zone information.");
-  }
-
   const auto& tiling = TileHierarchy::levels().back().tiles;
 
   // Method to get the shape for an edge - since LL is stored as a pair of
@@ -435,11 +433,20 @@ void BuildTileSet(const std::string& ways_file,
   std::unordered_map<uint32_t, std::pair<double, uint32_t>> geo_attribute_cache;
 
   ////////////////////////////////////////////////////////////////////////////
-  // Iterate over tiles
-  for (; tile_start != tile_end; ++tile_start) {
+  // Pull tiles off of the queue until there are no more
+  while (true) {
+    lock.lock();
+    if (tilequeue.empty()) {
+      lock.unlock();
+      break;
+    }
+    const auto task = tilequeue.front();
+    tilequeue.pop_front();
+    lock.unlock();
+
     try {
       // What actually writes the tile
-      GraphId tile_id = tile_start->first.Tile_Base();
+      GraphId tile_id = task.tile.Tile_Base();
       GraphTileBuilder graphtile(tile_dir, tile_id, false);
 
       // Information about tile creation
@@ -458,9 +465,9 @@ void BuildTileSet(const std::string& ways_file,
       std::unordered_map<uint32_t, bool> drive_on_right;
       std::unordered_map<uint32_t, bool> allow_intersection_names;
 
-      if (admin_db_handle) {
-        admin_polys = GetAdminInfo(admin_db_handle, drive_on_right, allow_intersection_names,
-                                   tiling.TileBounds(id), graphtile);
+      if (admins) {
+        admin_polys = admins->GetAdminInfo(drive_on_right, allow_intersection_names,
+                                           tiling.TileBounds(id), graphtile);
         if (admin_polys.size() == 1) {
           // TODO - check if tile bounding box is entirely inside the polygon...
           tile_within_one_admin = true;
@@ -469,8 +476,8 @@ void BuildTileSet(const std::string& ways_file,
 
       bool tile_within_one_tz = false;
       std::unordered_multimap<uint32_t, multi_polygon_type> tz_polys;
-      if (tz_db_handle) {
-        tz_polys = GetTimeZones(tz_db_handle, tiling.TileBounds(id));
+      if (timezones) {
+        tz_polys = timezones->GetTimeZones(tiling.TileBounds(id));
         if (tz_polys.size() == 1) {
           tile_within_one_tz = true;
         }
@@ -481,12 +488,10 @@ void BuildTileSet(const std::string& ways_file,
 
       ////////////////////////////////////////////////////////////////////////
       // Iterate over nodes in the tile
-      auto node_itr = nodes[tile_start->second];
+      auto node_itr = nodes[task.node_index];
       // to avoid realloc we guess how many edges there might be in a given tile
       geo_attribute_cache.clear();
-      geo_attribute_cache.reserve(5 * (std::next(tile_start) == tile_end
-                                           ? nodes.end() - node_itr
-                                           : std::next(tile_start)->second - tile_start->second));
+      geo_attribute_cache.reserve(5 * task.node_count);
 
       while (node_itr != nodes.end() && (*node_itr).graph_id.Tile_Base() == tile_id) {
         // amalgamate all the node duplicates into one and the edges that connect to it
@@ -1006,26 +1011,18 @@ void BuildTileSet(const std::string& ways_file,
       graphtile.StoreTileData();
 
       // Made a tile
-      LOG_DEBUG((boost::format("Wrote tile %1%: %2% bytes") % tile_start->first %
+      LOG_DEBUG((boost::format("Wrote tile %1%: %2% bytes") % task.tile %
                  graphtile.header_builder().end_offset())
                     .str());
     } // Whatever happens in Vegas..
     catch (std::exception& e) {
       // ..gets sent back to the main thread
       result.set_exception(std::current_exception());
-      LOG_ERROR((boost::format("Failed tile %1%: %2%") % tile_start->first % e.what()).str());
+      LOG_ERROR((boost::format("Failed tile %1%: %2%") % task.tile % e.what()).str());
       return;
     }
   }
 
-  if (admin_db_handle) {
-    sqlite3_close(admin_db_handle);
-  }
-
-  if (tz_db_handle) {
-    sqlite3_close(tz_db_handle);
-  }
-
   // Let the main thread see how this thread faired
   result.set_value(stats);
 }
@@ -1047,6 +1044,34 @@ void BuildLocalTiles(const unsigned int thread_count,
   uint32_t tile_creation_date =
       DateTime::days_from_pivot_date(DateTime::get_formatted_date(DateTime::iso_date_time(tz)));
 
+  // Read the admin and time zone polygons once for all of the threads
+  const auto& config = pt.get_child("mjolnir");
+  std::unique_ptr<AdminIndex> admins;
+  auto database = config.get_optional<std::string>("admin");
+  if (config.get<bool>("data_processing.use_admin_db", true)) {
+    sqlite3* admin_db_handle = database ? GetDBHandle(*database) : nullptr;
+    if (!database) {
+      LOG_WARN("Admin db not found.  Not saving admin information.");
+    } else if (!admin_db_handle) {
+      LOG_WARN("Admin db " + *database + " not found.  Not saving admin information.");
+    } else {
+      admins.reset(new AdminIndex(admin_db_handle));
+      sqlite3_close(admin_db_handle);
+    }
+  }
+
+  std::unique_ptr<TimeZoneIndex> timezones;
+  database = config.get_optional<std::string>("timezone");
+  sqlite3* tz_db_handle = database ? GetDBHandle(*database) : nullptr;
+  if (!database) {
+    LOG_WARN("Time zone db not found.  Not saving time zone information.");
+  } else if (!tz_db_handle) {
+    LOG_WARN("Time zone db " + *database + " not found.  Not saving time zone information.");
+  } else {
+    timezones.reset(new TimeZoneIndex(tz_db_handle));
+    sqlite3_close(tz_db_handle);
+  }
+
   LOG_INFO("Building " + std::to_string(tiles.size()) + " tiles with " +
            std::to_string(thread_count) + " threads...");
 
@@ -1056,26 +1081,30 @@ void BuildLocalTiles(const unsigned int thread_count,
   // Hold the results (DataQuality/stats) for the threads
   std::vector<std::promise<DataQuality>> results(threads.size());
 
-  // Divvy up the work
-  size_t floor = tiles.size() / threads.size();
-  size_t at_ceiling = tiles.size() - (threads.size() * floor);
-  std::map<GraphId, size_t>::const_iterator tile_start, tile_end = tiles.begin();
+  // Queue up the work with the tiles with the most nodes first. The threads pull from the queue
+  // so none of them waits on a slice of dense tiles and none draws a dense tile at the very end
+  std::deque<tile_task_t> tilequeue;
+  const size_t node_count = sequence<Node>(nodes_file, false).size();
+  for (auto tile = tiles.cbegin(); tile != tiles.cend(); ++tile) {
+    auto next = std::next(tile);
+    auto end = next == tiles.cend() ? node_count : next->second;
+    tilequeue.push_back({tile->first, tile->second, end - tile->second});
+  }
+  std::stable_sort(tilequeue.begin(), tilequeue.end(),
+                   [](const tile_task_t& a, const tile_task_t& b) {
+                     return a.node_count > b.node_count;
+                   });
+  std::mutex lock;
 
-  // Atomically pass around stats info
   for (size_t i = 0; i < threads.size(); ++i) {
-    // Figure out how many this thread will work on (either ceiling or floor)
-    size_t tile_count = (i < at_ceiling ? floor + 1 : floor);
-    // Where the range begins
-    tile_start = tile_end;
-    // Where the range ends
-    std::advance(tile_end, tile_count);
     // Make the thread
     threads[i].reset(new std::thread(BuildTileSet, std::cref(ways_file), std::cref(way_nodes_file),
                                      std::cref(nodes_file), std::cref(edges_file),
                                      std::cref(complex_from_restriction_file),
                                      std::cref(complex_to_restriction_file), std::cref(tile_dir),
-                                     std::cref(osmdata), tile_start, tile_end, tile_creation_date,
-                                     std::cref(pt.get_child("mjolnir")), std::ref(results[i])));
+                                     std::cref(osmdata), std::ref(tilequeue), std::ref(lock),
+                                     tile_creation_date, admins.get(), timezones.get(),
+                                     std::cref(config), std::ref(results[i])));
   }
 
   // Join all the threads to wait for them to finish up their work
@@ -1118,7 +1147,7 @@ std::map<GraphId, size_t> GraphBuilder::BuildEdges(const boost::property_tree::p
                  },
                  pt.get<bool>("mjolnir.data_processing.infer_turn_channels", true));
 
-  return SortGraph(nodes_file, edges_file);
+  return SortGraph(pt.get_child("mjolnir"), nodes_file, edges_file);
 }
 
 // Build the graph from the input
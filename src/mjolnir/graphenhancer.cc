@@ -5,6 +5,7 @@
 #include "mjolnir/util.h"
 #include "speed_assigner.h"
 
+#include <algorithm>
 #include <cinttypes>
 #include <future>
 #include <limits>
@@ -12,6 +13,7 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <random>
 #include <set>
 #include <stdexcept>
 #include <thread>
@@ -63,6 +65,9 @@ constexpr float kDensityRadius = 2.0f;
 constexpr float kDensityRadius2 = kDensityRadius * kDensityRadius;
 constexpr float kDensityLatDeg = (kDensityRadius * kMetersPerKm) / kMetersPerDegreeLat;
 
+// Number of cells along each side of a local tile in its density raster
+constexpr uint32_t kDensityCellsPerSide = 8;
+
 // A little struct to hold stats information during each threads work
 struct enhancer_stats {
   float max_density; //(km/km2)
@@ -718,25 +723,193 @@ bool IsIntersectionInternal(const graph_tile_ptr& start_tile,
   return true;
 }
 
+/**
+ * The road lengths at the nodes of a local tile binned into a raster of cells. Density
+ * lookups add up whole cells that lie within the search radius and only test the nodes
+ * of the cells which straddle it.
+ */
+struct density_tile_t {
+  struct cell_t {
+    AABB2<PointLL> bounds; // extent of the nodes in the cell
+    uint64_t length;       // total length of the road edges leaving the nodes in the cell
+    uint32_t begin;        // range of the nodes of the cell
+    uint32_t end;
+  };
+  std::vector<cell_t> cells;
+  std::vector<std::pair<PointLL, uint32_t>> nodes;
+
+  explicit density_tile_t(const graph_tile_ptr& tile) {
+    const double cell_size =
+        TileHierarchy::levels().back().tiles.TileSize() / kDensityCellsPerSide;
+    const PointLL base_ll = tile->header()->base_ll();
+
+    // Bin the total road length of every node (excluding parking, walkways, ferries, etc.)
+    std::vector<std::pair<uint32_t, std::pair<PointLL, uint32_t>>> binned;
+    const NodeInfo* node = tile->node(0);
+    for (uint32_t i = 0; i < tile->header()->nodecount(); ++i, ++node) {
+      uint32_t length = 0;
+      const DirectedEdge* directededge = tile->directededge(node->edge_index());
+      for (uint32_t j = 0; j < node->edge_count(); j++, directededge++) {
+        if (directededge->is_road() || directededge->use() == Use::kRamp ||
+            directededge->use() == Use::kTurnChannel || directededge->use() == Use::kAlley ||
+            directededge->use() == Use::kEmergencyAccess) {
+          length += directededge->length();
+        }
+      }
+      if (length == 0) {
+        continue;
+      }
+
+      PointLL ll = node->latlng(base_ll);
+      auto col = static_cast<uint32_t>(std::max(0.0, ll.lng() - base_ll.lng()) / cell_size);
+      auto row = static_cast<uint32_t>(std::max(0.0, ll.lat() - base_ll.lat()) / cell_size);
+      col = std::min(col, kDensityCellsPerSide - 1);
+      row = std::min(row, kDensityCellsPerSide - 1);
+      binned.emplace_back(row * kDensityCellsPerSide + col, std::make_pair(ll, length));
+    }
+    std::stable_sort(binned.begin(), binned.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    // Sum up the cells and remember the extent of their nodes
+    nodes.reserve(binned.size());
+    for (const auto& bin : binned) {
+      const PointLL& ll = bin.second.first;
+      if (cells.empty() || bin.first != cells.size() - 1) {
+        uint32_t index = nodes.size();
+        cells.resize(bin.first + 1, {{}, 0, index, index});
+        cells.back().bounds = AABB2<PointLL>(ll, ll);
+      }
+      auto& cell = cells.back();
+      cell.bounds = AABB2<PointLL>(std::min(cell.bounds.minx(), ll.lng()),
+                                   std::min(cell.bounds.miny(), ll.lat()),
+                                   std::max(cell.bounds.maxx(), ll.lng()),
+                                   std::max(cell.bounds.maxy(), ll.lat()));
+      cell.length += bin.second.second;
+      cell.end++;
+      nodes.emplace_back(bin.second);
+    }
+  }
+};
+
+/**
+ * Density rasters of the local tiles shared by all enhancer threads. Every raster is built
+ * once, by whichever thread needs it first, and is dropped as soon as the last tile whose
+ * nodes could search within it has been enhanced.
+ */
+class density_cache_t {
+public:
+  /**
+   * @param  tile_ids  the local tiles which will be enhanced
+   */
+  explicit density_cache_t(const std::unordered_set<GraphId>& tile_ids) {
+    for (const auto& tile_id : tile_ids) {
+      for (const auto& neighbor : Neighbors(tile_id)) {
+        entries_[neighbor].uses++;
+      }
+    }
+  }
+
+  /**
+   * Get the tiles whose rasters the density of the nodes within a tile could depend on
+   * @param  tile_id  the local tile
+   * @return the tile itself and the surrounding tiles within the density radius
+   */
+  static std::vector<GraphId> Neighbors(const GraphId& tile_id) {
+    const auto& level = TileHierarchy::levels().back();
+    auto bounds = level.tiles.TileBounds(tile_id.tileid());
+    float max_lat = std::min(std::max(std::abs(bounds.miny()), std::abs(bounds.maxy())), 89.0);
+    float lngdeg = (kDensityRadius * kMetersPerKm) /
+                   DistanceApproximator<PointLL>::MetersPerLngDegree(max_lat);
+    AABB2<PointLL> bbox(Point2(bounds.minx() - lngdeg, bounds.miny() - kDensityLatDeg),
+                        Point2(bounds.maxx() + lngdeg, bounds.maxy() + kDensityLatDeg));
+    std::vector<GraphId> neighbors;
+    for (auto t : level.tiles.TileList(bbox)) {
+      neighbors.emplace_back(t, level.level, 0);
+    }
+    return neighbors;
+  }
+
+  /**
+   * Get the raster of a tile, building it if no thread has done so yet
+   * @param  reader   graph reader of the calling thread
+   * @param  lock     mutex to hold while reading tiles
+   * @param  tile_id  the local tile
+   * @return the raster or nullptr if the tile is empty
+   */
+  std::shared_ptr<const density_tile_t>
+  Get(GraphReader& reader, std::mutex& lock, const GraphId& tile_id) {
+    std::promise<std::shared_ptr<const density_tile_t>> promise;
+    std::shared_future<std::shared_ptr<const density_tile_t>> raster;
+    bool build = false;
+    {
+      std::lock_guard<std::mutex> cache_lock(mutex_);
+      auto& entry = entries_[tile_id];
+      if (!entry.raster.valid()) {
+        entry.raster = promise.get_future().share();
+        build = true;
+      }
+      raster = entry.raster;
+    }
+
+    // We are the first ones here so we build it and let everyone else wait for it
+    if (build) {
+      try {
+        graph_tile_ptr tile;
+        {
+          std::lock_guard<std::mutex> reader_lock(lock);
+          tile = reader.GetGraphTile(tile_id);
+        }
+        promise.set_value(!tile || tile->header()->nodecount() == 0
+                              ? nullptr
+                              : std::make_shared<const density_tile_t>(tile));
+      } catch (...) {
+        promise.set_exception(std::current_exception());
+      }
+    }
+    return raster.get();
+  }
+
+  /**
+   * Let go of the rasters around a tile once it has been enhanced
+   * @param  tile_id  the local tile
+   */
+  void Release(const GraphId& tile_id) {
+    std::lock_guard<std::mutex> cache_lock(mutex_);
+    for (const auto& neighbor : Neighbors(tile_id)) {
+      auto entry = entries_.find(neighbor);
+      if (entry != entries_.end() && --entry->second.uses == 0) {
+        entries_.erase(entry);
+      }
+    }
+  }
+
+protected:
+  struct entry_t {
+    uint32_t uses = 0;
+    std::shared_future<std::shared_ptr<const density_tile_t>> raster;
+  };
+  std::mutex mutex_;
+  std::unordered_map<GraphId, entry_t> entries_;
+};
+
+// Density rasters by tile id
+using density_rasters_t = std::unordered_map<int32_t, std::shared_ptr<const density_tile_t>>;
+
 /**
  * Get the road density around the specified lat,lng position. This is a
  * value from 0-15 indicating a relative road density. This can be used
  * in costing methods to help avoid dense, urban areas.
- * @param  reader        Graph reader
- * @param  lock          Mutex for locking while tiles are retrieved
+ * @param  rasters       Density rasters of the tiles around the position
  * @param  ll            Lat,lng position
  * @param  maxdensity    (OUT) max density found
  * @param  tiles         Tiling (for getting list of required tiles)
- * @param  local_level   Level of the local tiles.
  * @return  Returns the relative road density (0-15) - higher values are
  *          more dense.
  */
-uint32_t GetDensity(GraphReader& reader,
-                    std::mutex& lock,
+uint32_t GetDensity(const density_rasters_t& rasters,
                     const PointLL& ll,
                     enhancer_stats& stats,
-                    const Tiles<PointLL>& tiles,
-                    uint8_t local_level) {
+                    const Tiles<PointLL>& tiles) {
   // Radius is in km - turn into meters
   float rm = kDensityRadius * kMetersPerKm;
   float mr2 = rm * rm;
@@ -750,33 +923,31 @@ uint32_t GetDensity(GraphReader& reader,
                       Point2(ll.lng() + lngdeg, ll.lat() + kDensityLatDeg));
   std::vector<int32_t> tilelist = tiles.TileList(bbox);
 
-  // For all tiles needed to find nodes within the radius...find nodes within
-  // the radius (squared) and add lengths of directed edges
-  float roadlengths = 0.0f;
+  // For all tiles needed to find nodes within the radius...add the road lengths of the
+  // cells entirely within the radius (squared) and of the nodes within it in the others
+  uint64_t roadlengths = 0;
   for (const auto t : tilelist) {
-    // Check all the nodes within the tile. Skip if tile has no nodes (can be
-    // an empty tile added for connectivity map logic).
-    lock.lock();
-    auto newtile = reader.GetGraphTile(GraphId(t, local_level, 0));
-    lock.unlock();
-    if (!newtile || newtile->header()->nodecount() == 0) {
+    // Skip if tile has no nodes (can be an empty tile added for connectivity map logic)
+    auto found = rasters.find(t);
+    if (found == rasters.end() || !found->second) {
       continue;
     }
-    PointLL base_ll = newtile->header()->base_ll();
-    const auto start_node = newtile->node(0);
-    const auto end_node = start_node + newtile->header()->nodecount();
-    for (auto node = start_node; node < end_node; ++node) {
-      // Check if within radius
-      if (approximator.DistanceSquared(node->latlng(base_ll)) < mr2) {
-        // Get all directed edges and add length
-        const DirectedEdge* directededge = newtile->directededge(node->edge_index());
-        for (uint32_t i = 0; i < node->edge_count(); i++, directededge++) {
-          // Exclude non-roads (parking, walkways, ferries, etc.)
-          if (directededge->is_road() || directededge->use() == Use::kRamp ||
-              directededge->use() == Use::kTurnChannel || directededge->use() == Use::kAlley ||
-              directededge->use() == Use::kEmergencyAccess) {
-            roadlengths += directededge->length();
-          }
+    const auto& raster = found->second;
+    for (const auto& cell : raster->cells) {
+      if (cell.begin == cell.end || !bbox.Intersects(cell.bounds)) {
+        continue;
+      }
+      // The extent of the cell is convex so its corners being inside means all of it is
+      if (approximator.DistanceSquared(cell.bounds.minpt()) < mr2 &&
+          approximator.DistanceSquared(cell.bounds.maxpt()) < mr2 &&
+          approximator.DistanceSquared(PointLL(cell.bounds.minx(), cell.bounds.maxy())) < mr2 &&
+          approximator.DistanceSquared(PointLL(cell.bounds.maxx(), cell.bounds.miny())) < mr2) {
+        roadlengths += cell.length;
+        continue;
+      }
+      for (uint32_t i = cell.begin; i < cell.end; ++i) {
+        if (approximator.DistanceSquared(raster->nodes[i].first) < mr2) {
+          roadlengths += raster->nodes[i].second;
         }
       }
     }
@@ -1228,7 +1399,9 @@ void enhance(const boost::property_tree::ptree& pt,
              const boost::property_tree::ptree& hierarchy_properties,
              std::queue<GraphId>& tilequeue,
              std::mutex& lock,
+             density_cache_t& densities,
              std::promise<enhancer_stats>& result) {
+  thread_busy_time_t busy_time;
 
   auto less_than = [](const OSMAccess& a, const OSMAccess& b) { return a.way_id() < b.way_id(); };
   sequence<OSMAccess> access_tags(access_file, false);
@@ -1282,6 +1455,7 @@ void enhance(const boost::property_tree::ptree& pt,
     graph_tile_ptr tile = reader.GetGraphTile(tile_id);
     if (!tile || tile->header()->nodecount() == 0) {
       lock.unlock();
+      densities.Release(tile_id);
       continue;
     }
 
@@ -1373,6 +1547,14 @@ void enhance(const boost::property_tree::ptree& pt,
       }
     }
 
+    // Get the density rasters of the surrounding tiles once for all of the nodes
+    density_rasters_t rasters;
+    if (!use_urban_tag) {
+      for (const auto& neighbor : density_cache_t::Neighbors(tile_id)) {
+        rasters.emplace(neighbor.tileid(), densities.Get(reader, lock, neighbor));
+      }
+    }
+
     // Second pass - add admin information and edge transition information.
     PointLL base_ll = tilebuilder->header()->base_ll();
     for (uint32_t i = 0; i < tilebuilder->header()->nodecount(); i++) {
@@ -1382,7 +1564,7 @@ void enhance(const boost::property_tree::ptree& pt,
       // Get relative road density and local density if the urban tag is not set
       uint32_t density = 0;
       if (!use_urban_tag) {
-        density = GetDensity(reader, lock, nodeinfo.latlng(base_ll), stats, tiles, local_level);
+        density = GetDensity(rasters, nodeinfo.latlng(base_ll), stats, tiles);
         nodeinfo.set_density(density);
       }
 
@@ -1637,6 +1819,9 @@ void enhance(const boost::property_tree::ptree& pt,
       reader.Trim();
     }
     lock.unlock();
+
+    // Nothing left needs the rasters of the tiles around this one
+    densities.Release(tile_id);
   }
 
   if (admin_db_handle) {
@@ -1666,7 +1851,8 @@ void GraphEnhancer::Enhance(const boost::property_tree::ptree& pt,
   // A place to hold the results of those threads, exceptions or otherwise
   std::list<std::promise<enhancer_stats>> results;
 
-  // Create a randomized queue of tiles to work from
+  // Create a queue of tiles to work from, the biggest first and the rest in a shuffled but
+  // repeatable order
   std::deque<GraphId> tempqueue;
   boost::property_tree::ptree hierarchy_properties = pt.get_child("mjolnir");
   auto local_level = TileHierarchy::levels().back().level;
@@ -1675,10 +1861,14 @@ void GraphEnhancer::Enhance(const boost::property_tree::ptree& pt,
   for (const auto& tile_id : local_tiles) {
     tempqueue.emplace_back(tile_id);
   }
-  std::random_device rd;
-  std::shuffle(tempqueue.begin(), tempqueue.end(), std::mt19937(rd()));
+  std::sort(tempqueue.begin(), tempqueue.end());
+  std::shuffle(tempqueue.begin(), tempqueue.end(), std::mt19937(3));
+  sort_by_tile_size(reader.tile_dir(), tempqueue);
   std::queue<GraphId> tilequeue(tempqueue);
 
+  // The density rasters of the tiles, shared by all the threads
+  density_cache_t densities(local_tiles);
+
   // An atomic object we can use to do the synchronization
   std::mutex lock;
 
@@ -1687,7 +1877,8 @@ void GraphEnhancer::Enhance(const boost::property_tree::ptree& pt,
     results.emplace_back();
     thread.reset(new std::thread(enhance, std::cref(hierarchy_properties), std::cref(osmdata),
                                  std::cref(access_file), std::ref(hierarchy_properties),
-                                 std::ref(tilequeue), std::ref(lock), std::ref(results.back())));
+                                 std::ref(tilequeue), std::ref(lock), std::ref(densities),
+                                 std::ref(results.back())));
   }
 
   // Wait for them to finish up their work
@@ -0,0 +1,186 @@
+#include "mjolnir/graphreorderer.h"
+#include "mjolnir/graphtilebuilder.h"
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "baldr/graphconstants.h"
+#include "baldr/graphid.h"
+#include "baldr/graphreader.h"
+#include "baldr/tilehierarchy.h"
+#include "midgard/logging.h"
+#include "midgard/pointll.h"
+#include "midgard/util.h"
+#include "mjolnir/util.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+// The hilbert curve covers a tile with a grid of this many cells on a side
+constexpr uint32_t kHilbertSide = 1 << 16;
+
+// The new index of every node at its old index, per tile
+using node_indexes_t = std::unordered_map<GraphId, std::vector<uint32_t>>;
+
+/**
+ * Reorders and rewrites tiles. Each thread pulls a tile of the queue, puts the nodes of it in
+ * their new order and points the end nodes of its edges and transitions at the new indexes.
+ */
+void reorder_tiles(const std::string& tile_dir,
+                   std::deque<GraphId>& tilequeue,
+                   std::mutex& lock,
+                   const node_indexes_t& node_indexes) {
+  thread_busy_time_t busy_time;
+  auto renumber = [&node_indexes](const GraphId& node) {
+    auto found = node_indexes.find(node.Tile_Base());
+    return found == node_indexes.cend() ? node
+                                        : GraphId(node.tileid(), node.level(),
+                                                  found->second[node.id()]);
+  };
+
+  while (true) {
+    lock.lock();
+    if (tilequeue.empty()) {
+      lock.unlock();
+      break;
+    }
+    auto tile_id = tilequeue.front();
+    tilequeue.pop_front();
+    lock.unlock();
+
+    GraphTileBuilder tilebuilder(tile_dir, tile_id, true);
+    auto indexes = node_indexes.find(tile_id);
+    if (indexes != node_indexes.cend()) {
+      std::vector<uint32_t> order(indexes->second.size());
+      for (uint32_t i = 0; i < indexes->second.size(); ++i) {
+        order[indexes->second[i]] = i;
+      }
+      tilebuilder.ReorderNodes(order);
+    }
+
+    for (auto& edge : tilebuilder.directededges()) {
+      edge.set_endnode(renumber(edge.endnode()));
+    }
+    for (auto& transition : tilebuilder.transitions()) {
+      transition = NodeTransition(renumber(transition.endnode()), transition.up());
+    }
+    tilebuilder.StoreTileData();
+  }
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+std::vector<uint32_t> GraphReorderer::NodeOrder(const graph_tile_ptr& tile,
+                                                const std::string& node_order) {
+  const auto count = tile->header()->nodecount();
+  std::vector<uint32_t> order(count);
+  std::iota(order.begin(), order.end(), 0);
+
+  if (node_order == "hilbert") {
+    // sort the nodes by where the hilbert curve over the tile passes them
+    const auto bounds =
+        TileHierarchy::levels()[tile->id().level()].tiles.TileBounds(tile->id().tileid());
+    auto cell = [](const double value, const double min, const double max) {
+      auto c = (value - min) / (max - min) * (kHilbertSide - 1);
+      return static_cast<uint32_t>(std::min(std::max(c, 0.), kHilbertSide - 1.));
+    };
+    std::vector<uint64_t> distances(count);
+    for (uint32_t i = 0; i < count; ++i) {
+      const auto ll = tile->node(i)->latlng(tile->header()->base_ll());
+      distances[i] = hilbert_index(cell(ll.lng(), bounds.minx(), bounds.maxx()),
+                                   cell(ll.lat(), bounds.miny(), bounds.maxy()), kHilbertSide);
+    }
+    std::stable_sort(order.begin(), order.end(), [&distances](const uint32_t a, const uint32_t b) {
+      return distances[a] < distances[b];
+    });
+  } else if (node_order == "bfs") {
+    // visit the nodes breadth first along the edges within the tile
+    std::vector<bool> visited(count, false);
+    std::vector<uint32_t> bfs;
+    bfs.reserve(count);
+    for (uint32_t seed = 0; seed < count; ++seed) {
+      if (visited[seed]) {
+        continue;
+      }
+      visited[seed] = true;
+      bfs.push_back(seed);
+      for (size_t next = bfs.size() - 1; next < bfs.size(); ++next) {
+        for (const auto& edge : tile->GetDirectedEdges(bfs[next])) {
+          const auto endnode = edge.endnode();
+          if (endnode.Tile_Base() == tile->id() && !visited[endnode.id()]) {
+            visited[endnode.id()] = true;
+            bfs.push_back(endnode.id());
+          }
+        }
+      }
+    }
+    order = std::move(bfs);
+  }
+  return order;
+}
+
+// Renumber the nodes within each tile so that neighbors in the graph are close in memory.
+void GraphReorderer::Reorder(const boost::property_tree::ptree& pt) {
+  const auto node_order = pt.get<std::string>("mjolnir.node_order", "none");
+  if (node_order != "hilbert" && node_order != "bfs") {
+    LOG_INFO("GraphReorderer - keeping the order the nodes were built in. Skipping...");
+    return;
+  }
+
+  // Get the new index of every node, transit tiles keep theirs
+  GraphReader reader(pt.get_child("mjolnir"));
+  const auto transit_level = TileHierarchy::GetTransitLevel().level;
+  node_indexes_t node_indexes;
+  std::deque<GraphId> tilequeue;
+  for (const auto& tile_id : reader.GetTileSet()) {
+    tilequeue.push_back(tile_id);
+    if (tile_id.level() == transit_level) {
+      continue;
+    }
+    auto tile = reader.GetGraphTile(tile_id);
+    if (!tile) {
+      continue;
+    }
+    auto order = NodeOrder(tile, node_order);
+    auto& indexes = node_indexes[tile_id];
+    indexes.resize(order.size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+      indexes[order[i]] = i;
+    }
+    if (reader.OverCommitted()) {
+      reader.Trim();
+    }
+  }
+  reader.Clear();
+
+  // Every tile is rewritten, the edges of tiles which keep their order can end in others
+  uint32_t nthreads =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency()));
+  LOG_INFO("Reordering the nodes of " + std::to_string(node_indexes.size()) + " tiles by " +
+           node_order + " with " + std::to_string(nthreads) + " threads...");
+  std::mutex lock;
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < nthreads; ++i) {
+    threads.emplace_back(reorder_tiles, reader.tile_dir(), std::ref(tilequeue), std::ref(lock),
+                         std::cref(node_indexes));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  LOG_INFO("Done GraphReorderer");
+}
+
+} // namespace mjolnir
+} // namespace valhalla
@@ -6,6 +6,8 @@
 #include "filesystem.h"
 #include "midgard/logging.h"
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <boost/format.hpp>
 #include <list>
 #include <set>
@@ -40,6 +42,29 @@ std::vector<ComplexRestrictionBuilder> DeserializeRestrictions(char* restriction
   return builders;
 };
 
+// Appends whatever is written to it to a string, so that a tile whose size is known up front is
+// put together in a single allocation and written out in one go
+class string_sink_t : public std::streambuf {
+public:
+  explicit string_sink_t(std::string& buffer) : buffer_(buffer) {
+  }
+
+protected:
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    buffer_.append(s, n);
+    return n;
+  }
+  int_type overflow(int_type c) override {
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      buffer_.push_back(traits_type::to_char_type(c));
+    }
+    return traits_type::not_eof(c);
+  }
+
+private:
+  std::string& buffer_;
+};
+
 } // namespace
 
 // Constructor given an existing tile. This is used to read in the tile
@@ -56,6 +81,7 @@ GraphTileBuilder::GraphTileBuilder(const std::string& tile_dir,
   // Copy tile header to a builder (if tile exists). Always set the tileid
   if (header_) {
     header_builder_ = *header_;
+    ReadColdSections();
   }
   header_builder_.set_graphid(graphid);
 
@@ -182,6 +208,7 @@ GraphTileBuilder::GraphTileBuilder(const std::string& tile_dir,
       eib.AddNameInfo(info);
     }
     eib.set_encoded_shape(ei.encoded_shape());
+    eib.set_encoded_elevation(ei.encoded_elevation());
     edge_info_offset_ += eib.SizeOf();
     edgeinfo_list_.emplace_back(std::move(eib));
 
@@ -221,10 +248,38 @@ GraphTileBuilder::GraphTileBuilder(const std::string& tile_dir,
 }
 
 // Output the tile to file. Stores as binary data.
-void GraphTileBuilder::StoreTileData() {
+void GraphTileBuilder::StoreTileData(const std::string& suffix) {
+  // Edge infos which changed size move the ones after them, point the edges at where they are now
+  if (!edgeinfo_resizes_.empty()) {
+    // sum up the growth so each offset is shifted by all of it that came before
+    std::vector<std::pair<uint32_t, int64_t>> shifts;
+    shifts.reserve(edgeinfo_resizes_.size());
+    int64_t shift = 0;
+    for (const auto& resize : edgeinfo_resizes_) {
+      shift += resize.second;
+      shifts.emplace_back(resize.first, shift);
+    }
+    auto moved = [&shifts](const uint32_t offset) -> uint32_t {
+      auto after = std::lower_bound(shifts.begin(), shifts.end(), offset,
+                                    [](const std::pair<uint32_t, int64_t>& s, const uint32_t o) {
+                                      return s.first < o;
+                                    });
+      return after == shifts.begin() ? offset : offset + std::prev(after)->second;
+    };
+    for (auto& directededge : directededges_builder_) {
+      directededge.set_edgeinfo_offset(moved(directededge.edgeinfo_offset()));
+    }
+    std::unordered_map<uint32_t, EdgeInfoBuilder*> edgeinfo_offset_map;
+    for (const auto& e : edgeinfo_offset_map_) {
+      edgeinfo_offset_map.emplace(moved(e.first), e.second);
+    }
+    edgeinfo_offset_map_.swap(edgeinfo_offset_map);
+    edgeinfo_resizes_.clear();
+  }
+
   // Get the name of the file
   filesystem::path filename(tile_dir_ + filesystem::path::preferred_separator +
-                            GraphTile::FileSuffix(header_builder_.graphid()));
+                            GraphTile::FileSuffix(header_builder_.graphid()) + suffix);
 
   // Make sure the directory exists on the system
   if (!filesystem::exists(filename.parent_path())) {
@@ -232,9 +287,38 @@ void GraphTileBuilder::StoreTileData() {
   }
 
   // Open file and truncate
-  std::stringstream in_mem;
   std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
   if (file.is_open()) {
+    // The sizes of the sections are known before serializing them, the edge info and the text
+    // having been counted as they were added, so the tile goes into one buffer of the right size
+    const size_t fixed_size =
+        (sizeof(GraphTileHeader)) + (nodes_builder_.size() * sizeof(NodeInfo)) +
+        (transitions_builder_.size() * sizeof(NodeTransition)) +
+        (directededges_builder_.size() * sizeof(DirectedEdge)) +
+        (directededges_ext_builder_.size() * sizeof(DirectedEdgeExt)) +
+        (access_restriction_builder_.size() * sizeof(AccessRestriction)) +
+        (departure_builder_.size() * sizeof(TransitDeparture)) +
+        (stop_builder_.size() * sizeof(TransitStop)) +
+        (route_builder_.size() * sizeof(TransitRoute)) +
+        (schedule_builder_.size() * sizeof(TransitSchedule)) +
+        // TODO - once transit transfers are added need to update here
+        (signs_builder_.size() * sizeof(Sign)) + (turnlanes_builder_.size() * sizeof(TurnLanes)) +
+        (admins_builder_.size() * sizeof(Admin));
+    size_t restrictions_size = 0;
+    for (const auto& complex_restriction : complex_restriction_forward_builder_) {
+      restrictions_size += complex_restriction.SizeOf();
+    }
+    for (const auto& complex_restriction : complex_restriction_reverse_builder_) {
+      restrictions_size += complex_restriction.SizeOf();
+    }
+    std::string buffer;
+    buffer.reserve(fixed_size + restrictions_size + edge_info_offset_ + text_list_offset_ + 8 +
+                   lane_connectivity_builder_.size() * sizeof(LaneConnectivity));
+    // The header goes in front once all of its offsets are set
+    buffer.resize(sizeof(GraphTileHeader));
+    string_sink_t sink(buffer);
+    std::ostream in_mem(&sink);
+
     // Write the nodes
     header_builder_.set_nodecount(nodes_builder_.size());
     in_mem.write(reinterpret_cast<const char*>(nodes_builder_.data()),
@@ -307,22 +391,11 @@ void GraphTileBuilder::StoreTileData() {
     in_mem.write(reinterpret_cast<const char*>(admins_builder_.data()),
                  admins_builder_.size() * sizeof(Admin));
 
-    // Edge bins can only be added after you've stored the tile
+    // Edge bins can only be added after you've stored the tile, so can their cells
+    header_builder_.set_bin_cells_offset(0);
 
     // Write the forward complex restriction data
-    header_builder_.set_complex_restriction_forward_offset(
-        (sizeof(GraphTileHeader)) + (nodes_builder_.size() * sizeof(NodeInfo)) +
-        (transitions_builder_.size() * sizeof(NodeTransition)) +
-        (directededges_builder_.size() * sizeof(DirectedEdge)) +
-        (directededges_ext_builder_.size() * sizeof(DirectedEdgeExt)) +
-        (access_restriction_builder_.size() * sizeof(AccessRestriction)) +
-        (departure_builder_.size() * sizeof(TransitDeparture)) +
-        (stop_builder_.size() * sizeof(TransitStop)) +
-        (route_builder_.size() * sizeof(TransitRoute)) +
-        (schedule_builder_.size() * sizeof(TransitSchedule)) +
-        // TODO - once transit transfers are added need to update here
-        (signs_builder_.size() * sizeof(Sign)) + (turnlanes_builder_.size() * sizeof(TurnLanes)) +
-        (admins_builder_.size() * sizeof(Admin)));
+    header_builder_.set_complex_restriction_forward_offset(fixed_size);
     uint32_t forward_restriction_size = 0;
     for (auto& complex_restriction : complex_restriction_forward_builder_) {
       in_mem << complex_restriction;
@@ -352,7 +425,7 @@ void GraphTileBuilder::StoreTileData() {
     }
 
     // Add padding (if needed) to align to 8-byte word.
-    int tmp = in_mem.tellp() % 8;
+    int tmp = (buffer.size() - sizeof(GraphTileHeader)) % 8;
     int padding = (tmp > 0) ? 8 - tmp : 0;
     if (padding > 0 && padding < 8) {
       in_mem.write("\0\0\0\0\0\0\0\0", padding);
@@ -370,11 +443,10 @@ void GraphTileBuilder::StoreTileData() {
                                    (lane_connectivity_builder_.size() * sizeof(LaneConnectivity)));
 
     // Sanity check for the end offset
-    uint32_t curr =
-        static_cast<uint32_t>(in_mem.tellp()) + static_cast<uint32_t>(sizeof(GraphTileHeader));
+    uint32_t curr = static_cast<uint32_t>(buffer.size());
     if (header_builder_.end_offset() != curr) {
       LOG_ERROR("Mismatch in end offset " + std::to_string(header_builder_.end_offset()) +
-                " vs in_mem stream " + std::to_string(curr) +
+                " vs in_mem buffer " + std::to_string(curr) +
                 " padding = " + std::to_string(padding));
     }
 
@@ -389,19 +461,90 @@ void GraphTileBuilder::StoreTileData() {
                route_builder_.size())
                   .str());
 
-    // Write the header then the rest of the tile from the in memory buffer
-    file.write(reinterpret_cast<const char*>(&header_builder_), sizeof(GraphTileHeader));
-    file << in_mem.rdbuf();
+    // Put the header in front of the rest of the tile and write it all at once
+    std::memcpy(&buffer[0], &header_builder_, sizeof(GraphTileHeader));
+    file.write(buffer.data(), buffer.size());
     file.close();
   } else {
     throw std::runtime_error("Failed to open file " + filename.string());
   }
 }
 
+// Renumber the nodes, the edges and transitions of each node move along with it.
+void GraphTileBuilder::ReorderNodes(const std::vector<uint32_t>& order) {
+  if (order.size() != nodes_builder_.size()) {
+    throw std::runtime_error("GraphTileBuilder::ReorderNodes - order does not cover every node");
+  }
+  if (!complex_restriction_forward_builder_.empty() ||
+      !complex_restriction_reverse_builder_.empty()) {
+    throw std::runtime_error("GraphTileBuilder::ReorderNodes - cannot reorder complex restrictions");
+  }
+
+  // Move the nodes and their runs of edges and transitions into the new order
+  std::vector<uint32_t> node_index(nodes_builder_.size());
+  std::vector<uint32_t> edge_index(directededges_builder_.size());
+  std::vector<NodeInfo> nodes;
+  std::vector<DirectedEdge> edges;
+  std::vector<DirectedEdgeExt> edges_ext;
+  std::vector<NodeTransition> transitions;
+  nodes.reserve(nodes_builder_.size());
+  edges.reserve(directededges_builder_.size());
+  transitions.reserve(transitions_builder_.size());
+  const bool has_ext = directededges_ext_builder_.size() == directededges_builder_.size();
+  for (const auto old_index : order) {
+    node_index[old_index] = nodes.size();
+    nodes.push_back(nodes_builder_[old_index]);
+    auto& node = nodes.back();
+
+    const auto first_edge = node.edge_index();
+    node.set_edge_index(edges.size());
+    for (uint32_t i = first_edge; i < first_edge + node.edge_count(); ++i) {
+      edge_index[i] = edges.size();
+      edges.push_back(directededges_builder_[i]);
+      if (has_ext) {
+        edges_ext.push_back(directededges_ext_builder_[i]);
+      }
+    }
+
+    const auto first_transition = node.transition_index();
+    if (node.transition_count() > 0) {
+      node.set_transition_index(transitions.size());
+    }
+    transitions.insert(transitions.end(), transitions_builder_.begin() + first_transition,
+                       transitions_builder_.begin() + first_transition + node.transition_count());
+  }
+  if (edges.size() != directededges_builder_.size()) {
+    throw std::runtime_error("GraphTileBuilder::ReorderNodes - edges not owned by exactly one node");
+  }
+  nodes_builder_ = std::move(nodes);
+  directededges_builder_ = std::move(edges);
+  transitions_builder_ = std::move(transitions);
+  if (has_ext) {
+    directededges_ext_builder_ = std::move(edges_ext);
+  }
+
+  // Everything keyed by an edge or node index has to follow it, they are sorted when stored
+  for (auto& restriction : access_restriction_builder_) {
+    restriction.set_edgeindex(edge_index[restriction.edgeindex()]);
+  }
+  for (auto& sign : signs_builder_) {
+    sign.set_index(sign.type() == Sign::Type::kJunctionName ? node_index[sign.index()]
+                                                            : edge_index[sign.index()]);
+  }
+  for (auto& turnlanes : turnlanes_builder_) {
+    turnlanes.set_edgeindex(edge_index[turnlanes.edgeindex()]);
+  }
+  std::sort(turnlanes_builder_.begin(), turnlanes_builder_.end());
+  for (auto& lc : lane_connectivity_builder_) {
+    lc.set_to(edge_index[lc.to()]);
+  }
+}
+
 // Update a graph tile with new nodes and directed edges. The rest of the
 // tile contents remains the same.
 void GraphTileBuilder::Update(const std::vector<NodeInfo>& nodes,
-                              const std::vector<DirectedEdge>& directededges) {
+                              const std::vector<DirectedEdge>& directededges,
+                              const std::vector<DirectedEdgeExt>& directededges_ext) {
   // Get the name of the file
   filesystem::path filename =
       tile_dir_ + filesystem::path::preferred_separator + GraphTile::FileSuffix(header_->graphid());
@@ -414,8 +557,33 @@ void GraphTileBuilder::Update(const std::vector<NodeInfo>& nodes,
   // Open file. Truncate so we replace the contents.
   std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
   if (file.is_open()) {
-    // Write the header
-    file.write(reinterpret_cast<const char*>(header_), sizeof(GraphTileHeader));
+    // Write the header, the data after the directed edges moves when their extended attributes
+    // are added or replaced
+    GraphTileHeader updated = *header_;
+    if (!directededges_ext.empty()) {
+      if (directededges_ext.size() != header_->directededgecount()) {
+        throw std::runtime_error(
+            "GraphTileBuilder::Update - extended directed edge count does not match");
+      }
+      int64_t shift =
+          header_->has_ext_directededge() ? 0 : directededges_ext.size() * sizeof(DirectedEdgeExt);
+      updated.set_has_ext_directededge(true);
+      updated.set_complex_restriction_forward_offset(
+          updated.complex_restriction_forward_offset() + shift);
+      updated.set_complex_restriction_reverse_offset(
+          updated.complex_restriction_reverse_offset() + shift);
+      updated.set_edgeinfo_offset(updated.edgeinfo_offset() + shift);
+      updated.set_textlist_offset(updated.textlist_offset() + shift);
+      updated.set_lane_connectivity_offset(updated.lane_connectivity_offset() + shift);
+      if (updated.predictedspeeds_offset()) {
+        updated.set_predictedspeeds_offset(updated.predictedspeeds_offset() + shift);
+      }
+      if (updated.bin_cells_offset()) {
+        updated.set_bin_cells_offset(updated.bin_cells_offset() + shift);
+      }
+      updated.set_end_offset(updated.end_offset() + shift);
+    }
+    file.write(reinterpret_cast<const char*>(&updated), sizeof(GraphTileHeader));
 
     // Write the updated nodes. Make sure node count matches.
     if (nodes.size() != header_->nodecount()) {
@@ -434,11 +602,15 @@ void GraphTileBuilder::Update(const std::vector<NodeInfo>& nodes,
     file.write(reinterpret_cast<const char*>(directededges.data()),
                directededges.size() * sizeof(DirectedEdge));
 
-    // If there are extended directed edge attributes they would need to be written out here
-    // (and likely added to the method)
+    // Write the new extended directed edge attributes in place of the old ones or keep the old
+    auto begin = reinterpret_cast<const char*>(directededges_ + header_->directededgecount());
+    if (!directededges_ext.empty()) {
+      file.write(reinterpret_cast<const char*>(directededges_ext.data()),
+                 directededges_ext.size() * sizeof(DirectedEdgeExt));
+      begin = reinterpret_cast<const char*>(&access_restrictions_[0]);
+    }
 
     // Write the rest of the tiles
-    auto begin = reinterpret_cast<const char*>(&access_restrictions_[0]);
     auto end = reinterpret_cast<const char*>(header()) + header()->end_offset();
     file.write(begin, end - begin);
     file.close();
@@ -760,6 +932,23 @@ void GraphTileBuilder::set_mean_elevation(const uint32_t offset, const float ele
   e->second->set_mean_elevation(elev);
 }
 
+// Set the elevations of the shape points to the EdgeInfo given the edge info offset
+void GraphTileBuilder::set_elevation(const uint32_t offset, const std::vector<double>& elevation) {
+  auto e = edgeinfo_offset_map_.find(offset);
+  if (e == edgeinfo_offset_map_.end()) {
+    LOG_ERROR("set_elevation - could not find the EdgeInfo index given the offset");
+    return;
+  }
+  // remember how much it grew so the edge infos after it can be moved along when storing
+  int64_t size = e->second->SizeOf();
+  e->second->set_elevation(elevation);
+  int64_t growth = static_cast<int64_t>(e->second->SizeOf()) - size;
+  if (growth != 0) {
+    edgeinfo_resizes_[offset] += growth;
+    edge_info_offset_ += growth;
+  }
+}
+
 // Add a name to the text list
 uint32_t GraphTileBuilder::AddName(const std::string& name) {
   if (name.empty()) {
@@ -992,13 +1181,46 @@ std::array<std::vector<GraphId>, kBinCount> GraphTileBuilder::BinEdges(const gra
   return bins;
 }
 
+// the cells of a bin each of its edges touch, the edges which leave the bin or are in another tile
+// than the bin's could be close to anything in it and are said to touch all of its cells
+void GraphTileBuilder::BinCells(const graph_tile_ptr& tile,
+                                size_t bin_index,
+                                uint32_t depth,
+                                const std::vector<GraphId>& bin,
+                                std::vector<uint64_t>& cells) {
+  const auto cell_count = 1u << (2 * depth);
+  const uint64_t all_cells = cell_count == 64 ? ~uint64_t(0) : (uint64_t(1) << cell_count) - 1;
+  const auto bin_box = tile->BinBoundingBox(bin_index);
+  for (const auto& edge_id : bin) {
+    if (edge_id.Tile_Base() != tile->id()) {
+      cells.push_back(all_cells);
+      continue;
+    }
+    auto shape = tile->edgeinfo(tile->directededge(edge_id)).shape();
+    if (shape.empty() || !bin_box.Contains(AABB2<PointLL>(shape))) {
+      cells.push_back(all_cells);
+      continue;
+    }
+    // a segment is in the cells its bounding box touches
+    uint64_t mask = GraphTile::BinCellMask(bin_box, depth, {shape.front(), shape.front()});
+    for (auto p = std::next(shape.cbegin()); p != shape.cend(); ++p) {
+      AABB2<PointLL> segment(std::min(p->lng(), std::prev(p)->lng()),
+                             std::min(p->lat(), std::prev(p)->lat()),
+                             std::max(p->lng(), std::prev(p)->lng()),
+                             std::max(p->lat(), std::prev(p)->lat()));
+      mask |= GraphTile::BinCellMask(bin_box, depth, segment);
+    }
+    cells.push_back(mask);
+  }
+}
+
 void GraphTileBuilder::AddBins(const std::string& tile_dir,
                                const graph_tile_ptr& tile,
                                const std::array<std::vector<GraphId>, kBinCount>& more_bins) {
   assert(tile);
   // read bins and append and keep track of how much is appended
   std::vector<GraphId> bins[kBinCount];
-  uint32_t shift = 0;
+  int64_t shift = 0;
   for (size_t i = 0; i < kBinCount; ++i) {
     auto bin = tile->GetBin(i % kBinsDim, i / kBinsDim);
     bins[i].assign(bin.begin(), bin.end());
@@ -1011,10 +1233,32 @@ void GraphTileBuilder::AddBins(const std::string& tile_dir,
   for (size_t i = 1; i < kBinCount; ++i) {
     offsets[i] = static_cast<uint32_t>(bins[i].size()) + offsets[i - 1];
   }
+  // split the dense bins into cells, the cells of the tile are redone from scratch each time
+  std::vector<uint8_t> depths(kBinCellDepthsSize, 0);
+  std::vector<uint64_t> cells;
+  for (size_t i = 0; i < kBinCount; ++i) {
+    for (auto size = bins[i].size(); size > kBinCellThreshold && depths[i] < kMaxBinCellDepth;
+         size /= 4) {
+      ++depths[i];
+    }
+    if (depths[i]) {
+      BinCells(tile, i, depths[i], bins[i], cells);
+    }
+  }
+  uint32_t old_cells_size = tile->header()->bin_cells_offset()
+                                ? tile->header()->complex_restriction_forward_offset() -
+                                      tile->header()->bin_cells_offset()
+                                : 0;
+  uint32_t cells_size = cells.empty() ? 0 : kBinCellDepthsSize + cells.size() * sizeof(uint64_t);
+  shift += static_cast<int64_t>(cells_size) - old_cells_size;
   // update header offsets
   // NOTE: if format changes to add more things here we need to make a change here as well
   GraphTileHeader header = *tile->header();
   header.set_edge_bin_offsets(offsets);
+  auto bins_offset = reinterpret_cast<const char*>(tile->GetBin(0, 0).begin()) -
+                     reinterpret_cast<const char*>(tile->header());
+  header.set_bin_cells_offset(
+      cells.empty() ? 0 : bins_offset + offsets[kBinCount - 1] * sizeof(GraphId));
   header.set_complex_restriction_forward_offset(header.complex_restriction_forward_offset() + shift);
   header.set_complex_restriction_reverse_offset(header.complex_restriction_reverse_offset() + shift);
   header.set_edgeinfo_offset(header.edgeinfo_offset() + shift);
@@ -1040,8 +1284,14 @@ void GraphTileBuilder::AddBins(const std::string& tile_dir,
     for (const auto& bin : bins) {
       file.write(reinterpret_cast<const char*>(bin.data()), bin.size() * sizeof(GraphId));
     }
-    // the rest of the stuff after bins
-    begin = reinterpret_cast<const char*>(tile->GetBin(kBinsDim - 1, kBinsDim - 1).end());
+    // the cells of the dense bins
+    if (!cells.empty()) {
+      file.write(reinterpret_cast<const char*>(depths.data()), depths.size());
+      file.write(reinterpret_cast<const char*>(cells.data()), cells.size() * sizeof(uint64_t));
+    }
+    // the rest of the stuff after bins and their old cells
+    begin = reinterpret_cast<const char*>(tile->GetBin(kBinsDim - 1, kBinsDim - 1).end()) +
+            old_cells_size;
     end = reinterpret_cast<const char*>(tile->header()) + tile->header()->end_offset();
     file.write(begin, end - begin);
   } // failed
@@ -1088,8 +1338,10 @@ void GraphTileBuilder::UpdatePredictedSpeeds(const std::vector<DirectedEdge>& di
   if (!filesystem::exists(filename.parent_path()))
     filesystem::create_directories(filename.parent_path());
 
-  // Open file and truncate
-  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  // Write to a temporary file which replaces the tile once its complete. The tile cant be updated
+  // twice so it must never be left half written if the process dies
+  filesystem::path tmp_filename = filename.string() + ".tmp";
+  std::ofstream file(tmp_filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
   if (file.is_open()) {
     // Write a new header - add the offset to predicted speed data and the profile count.
     // Update the end offset (shift by the amount of predicted speed data added).
@@ -1115,8 +1367,9 @@ void GraphTileBuilder::UpdatePredictedSpeeds(const std::vector<DirectedEdge>& di
     file.write(reinterpret_cast<const char*>(directededges.data()),
                directededges.size() * sizeof(DirectedEdge));
 
-    // Write out data from access restrictions to the end of lane connectivity data.
-    auto begin = reinterpret_cast<const char*>(&access_restrictions_[0]);
+    // Write out data from the extended directed edge attributes (or access restrictions) to the
+    // end of lane connectivity data.
+    auto begin = reinterpret_cast<const char*>(directededges_ + header_->directededgecount());
     auto end = reinterpret_cast<const char*>(header()) + offset;
     file.write(begin, end - begin);
 
@@ -1129,8 +1382,14 @@ void GraphTileBuilder::UpdatePredictedSpeeds(const std::vector<DirectedEdge>& di
     // Write the rest of the tiles. TBD (if anything is added after the speed profiles
     // then this will need to be updated)
 
-    // Close the file
+    // Close the file and move it over the old tile
     file.close();
+    if (file.fail() || std::rename(tmp_filename.c_str(), filename.c_str())) {
+      filesystem::remove(tmp_filename);
+      throw std::runtime_error("Failed to write file " + filename.string());
+    }
+  } else {
+    throw std::runtime_error("Failed to open file " + tmp_filename.string());
   }
 }
 
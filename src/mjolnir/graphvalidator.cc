@@ -251,6 +251,7 @@ void validate(
     std::mutex& lock,
     std::promise<std::tuple<std::vector<uint32_t>, std::vector<std::vector<float>>, tweeners_t>>&
         result) {
+  thread_busy_time_t busy_time;
   // Our local copy of edges binned to tiles that they pass through (dont start or end in)
   tweeners_t tweeners;
   // Local Graphreader
@@ -258,6 +259,9 @@ void validate(
   // Get some things we need throughout
   auto numLevels = TileHierarchy::levels().size() + 1; // To account for transit
   auto transit_level = TileHierarchy::GetTransitLevel().level;
+  // Whether to store the id of the opposing edge of each edge so the path algorithms dont have to
+  // look at the end node of an edge to get it
+  auto store_opp_edge_ids = pt.get<bool>("mjolnir.opposing_edge_ids", false);
 
   // vector to hold densities for each level
   std::vector<std::vector<float>> densities(numLevels);
@@ -293,6 +297,7 @@ void validate(
     // Update nodes and directed edges as needed
     std::vector<NodeInfo> nodes;
     std::vector<DirectedEdge> directededges;
+    std::vector<DirectedEdgeExt> directededges_ext;
 
     // Get this tile
     lock.lock();
@@ -389,6 +394,15 @@ void validate(
             GetOpposingEdgeIndex(node, directededge, wayid, tile, endnode_tile, problem_ways,
                                  dupcount, end_node_iso, transit_level);
         directededge.set_opp_index(opp_index);
+        if (store_opp_edge_ids && level != transit_level) {
+          const auto* end_node = endnode_tile->node(directededge.endnode());
+          DirectedEdgeExt ext;
+          if (opp_index < end_node->edge_count()) {
+            ext.set_opp_edge_id({directededge.endnode().tileid(), directededge.endnode().level(),
+                                 end_node->edge_index() + opp_index});
+          }
+          directededges_ext.push_back(ext);
+        }
         if (directededge.use() == Use::kTransitConnection ||
             directededge.use() == Use::kEgressConnection ||
             directededge.use() == Use::kPlatformConnection || directededge.bss_connection()) {
@@ -456,7 +470,7 @@ void validate(
 
     // Write the new tile
     lock.lock();
-    tilebuilder.Update(nodes, directededges);
+    tilebuilder.Update(nodes, directededges, directededges_ext);
 
     // Write the bins to it
     if (tile->header()->graphid().level() == TileHierarchy::levels().back().level) {
@@ -483,17 +497,24 @@ void validate(
   result.set_value(std::make_tuple(std::move(duplicates), std::move(densities), std::move(tweeners)));
 }
 
-// take tweeners from different tiles' perspectives and merge into a single tweener
-// per tile that needs to update its bins
-void merge(const tweeners_t& in, tweeners_t& out) {
-  for (const auto& t : in) {
-    // shove it in
-    auto inserted = out.insert(t);
-    // had this tile already
-    if (!inserted.second) {
-      // so have to merge
+// take tweeners from different tiles' perspectives and merge into a single tweener per tile of
+// the shard, the shards are disjoint so each worker moves bins out of the per thread tweeners
+// without any synchronization
+void merge(std::vector<tweeners_t>& in, size_t shard, size_t shard_count, tweeners_t& out) {
+  for (auto& tweeners : in) {
+    for (auto& t : tweeners) {
+      if (t.first.tileid() % shard_count != shard) {
+        continue;
+      }
+      // shove it in
+      auto found = out.find(t.first);
+      if (found == out.end()) {
+        out.emplace(t.first, std::move(t.second));
+        continue;
+      }
+      // had this tile already so have to merge
       for (size_t c = 0; c < kBinCount; ++c) {
-        auto& bin = inserted.first->second[c];
+        auto& bin = found->second[c];
         bin.insert(bin.end(), t.second[c].cbegin(), t.second[c].cend());
       }
     }
@@ -502,22 +523,17 @@ void merge(const tweeners_t& in, tweeners_t& out) {
 
 // crack open tiles and bin edges that pass through them but dont end or begin in them
 void bin_tweeners(const std::string& tile_dir,
-                  tweeners_t::iterator& start,
-                  const tweeners_t::iterator& end,
-                  uint64_t dataset_id,
-                  std::mutex& lock) {
-  // go while we have tiles to update
-  while (true) {
-    lock.lock();
-    if (start == end) {
-      lock.unlock();
-      break;
-    }
-    // grab this tile and its extra bin edges
-    const auto& tile_bin = *start;
-    ++start;
-    lock.unlock();
+                  std::vector<tweeners_t>& all_tweeners,
+                  size_t shard,
+                  size_t shard_count,
+                  uint64_t dataset_id) {
+  thread_busy_time_t busy_time;
+  // gather the extra bin edges of the tiles of this shard
+  tweeners_t tweeners;
+  merge(all_tweeners, shard, shard_count, tweeners);
 
+  // go while we have tiles to update
+  for (const auto& tile_bin : tweeners) {
     // some tiles are just there because edges' shapes passes through them (no edges/nodes, just bins)
     // if that's the case we need to make a tile to store the spatial index (binned edges) there
     auto tile = GraphTile::Create(tile_dir, tile_bin.first);
@@ -542,7 +558,7 @@ void GraphValidator::Validate(const boost::property_tree::ptree& pt) {
   auto hierarchy_properties = pt.get_child("mjolnir");
   std::string tile_dir = hierarchy_properties.get<std::string>("tile_dir");
 
-  // Create a randomized queue of tiles (at all levels) to work from
+  // Create a queue of tiles (at all levels) to work from, the biggest first
   std::deque<GraphId> tilequeue;
   GraphReader reader(pt.get_child("mjolnir"));
   auto tileset = reader.GetTileSet();
@@ -551,6 +567,7 @@ void GraphValidator::Validate(const boost::property_tree::ptree& pt) {
   }
   // fixed seed for reproducible tile build
   std::shuffle(tilequeue.begin(), tilequeue.end(), std::mt19937(3));
+  sort_by_tile_size(tile_dir, tilequeue);
 
   // Remember what the dataset id is in case we have to make some tiles
   graph_tile_ptr first_tile = GraphTile::Create(tile_dir, *tilequeue.begin());
@@ -584,7 +601,8 @@ void GraphValidator::Validate(const boost::property_tree::ptree& pt) {
   // Get the promise from the future
   std::vector<uint32_t> duplicates(TileHierarchy::levels().size(), 0);
   std::vector<std::vector<float>> densities(3);
-  tweeners_t tweeners;
+  std::vector<tweeners_t> tweeners;
+  tweeners.reserve(results.size());
   for (auto& result : results) {
     auto data = result.get_future().get();
     // Total up duplicates for each level
@@ -594,18 +612,17 @@ void GraphValidator::Validate(const boost::property_tree::ptree& pt) {
         densities[i].push_back(d);
       }
     }
-    // keep track of tweeners
-    merge(std::get<2>(data), tweeners);
+    // keep track of tweeners, they are merged by the threads which add them to the tiles
+    tweeners.emplace_back(std::move(std::get<2>(data)));
   }
   LOG_INFO("Finished");
 
-  // run a pass to add the edges that binned to tweener tiles
+  // run a pass to add the edges that binned to tweener tiles, each thread merges and writes the
+  // tiles of its own shard of them
   LOG_INFO("Binning inter-tile edges...");
-  auto start = tweeners.begin();
-  auto end = tweeners.end();
-  for (auto& thread : threads) {
-    thread.reset(new std::thread(bin_tweeners, std::cref(tile_dir), std::ref(start), std::cref(end),
-                                 dataset_id, std::ref(lock)));
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].reset(new std::thread(bin_tweeners, std::cref(tile_dir), std::ref(tweeners), i,
+                                     threads.size(), dataset_id));
   }
   for (auto& thread : threads) {
     thread->join();
@@ -4,11 +4,18 @@
 #include <boost/format.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <algorithm>
+#include <deque>
+#include <future>
 #include <iostream>
+#include <list>
 #include <map>
+#include <mutex>
 #include <ostream>
+#include <queue>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -21,6 +28,7 @@
 #include "midgard/logging.h"
 #include "midgard/pointll.h"
 #include "midgard/sequence.h"
+#include "mjolnir/util.h"
 
 using namespace valhalla::midgard;
 using namespace valhalla::baldr;
@@ -68,23 +76,26 @@ bool AddUpwardTransition(const GraphId& node, GraphTileBuilder* tilebuilder) {
   }
 }
 
-void SortSequences(const std::string& new_to_old_file, const std::string& old_to_new_file) {
+void SortSequences(const boost::property_tree::ptree& pt,
+                   const std::string& new_to_old_file,
+                   const std::string& old_to_new_file) {
   // Sort the new nodes. Sort so highway level is first
   sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
-  new_to_old.sort([](const std::pair<GraphId, GraphId>& a, const std::pair<GraphId, GraphId>& b) {
-    if (a.first.level() == b.first.level()) {
-      if (a.first.tileid() == b.first.tileid()) {
-        return a.first.id() < b.first.id();
-      }
-      return a.first.tileid() < b.first.tileid();
-    }
-    return a.first.level() < b.first.level();
-  });
+  sort_sequence(pt, new_to_old,
+                [](const std::pair<GraphId, GraphId>& a, const std::pair<GraphId, GraphId>& b) {
+                  if (a.first.level() == b.first.level()) {
+                    if (a.first.tileid() == b.first.tileid()) {
+                      return a.first.id() < b.first.id();
+                    }
+                    return a.first.tileid() < b.first.tileid();
+                  }
+                  return a.first.level() < b.first.level();
+                });
 
   // Sort old to new by node Id
   sequence<OldToNewNodes> old_to_new(old_to_new_file, false);
-  old_to_new.sort(
-      [](const OldToNewNodes& a, const OldToNewNodes& b) { return a.node_id < b.node_id; });
+  sort_sequence(pt, old_to_new,
+                [](const OldToNewNodes& a, const OldToNewNodes& b) { return a.node_id < b.node_id; });
 }
 
 // Convenience method to find the node association.
@@ -121,10 +132,24 @@ bool OpposingEdgeInfoMatches(const graph_tile_ptr& tile, const DirectedEdge* edg
   return false;
 }
 
-// Form tiles in the new level.
-void FormTilesInNewLevel(GraphReader& reader,
+// The new nodes of a tile in a new level, a range of the sorted new to old sequence
+struct NewTile {
+  GraphId tile_id;
+  size_t begin;
+  size_t end;
+};
+
+// Form tiles in the new level, taking them off of a shared queue.
+void FormTilesInNewLevel(const boost::property_tree::ptree& pt,
                          const std::string& new_to_old_file,
-                         const std::string& old_to_new_file) {
+                         const std::string& old_to_new_file,
+                         std::queue<NewTile>& tilequeue,
+                         std::mutex& lock,
+                         std::promise<void>& result) {
+  thread_busy_time_t busy_time;
+  // Each thread reads the tiles with its own reader
+  GraphReader reader(pt);
+
   // Use the sequence that associate new nodes to old nodes
   sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
 
@@ -158,219 +183,281 @@ void FormTilesInNewLevel(GraphReader& reader,
     }
   };
 
-  // Iterate through the new nodes. They have been sorted by level so that
-  // highway level is done first.
-  reader.Clear();
   bool added = false;
-  uint8_t current_level = std::numeric_limits<uint8_t>::max();
-  GraphId tile_id;
   std::hash<std::string> hasher;
-  PointLL base_ll;
-  GraphTileBuilder* tilebuilder = nullptr;
-  for (auto new_node = new_to_old.begin(); new_node != new_to_old.end(); new_node++) {
-    // Get the node - check if a new tile
-    GraphId nodea = (*new_node).first;
-    if (nodea.Tile_Base() != tile_id) {
-      // Store the prior tile
-      if (tilebuilder != nullptr) {
-        tilebuilder->StoreTileData();
-        delete tilebuilder;
+  try {
+    while (true) {
+      // Get the next tile off of the queue
+      lock.lock();
+      if (tilequeue.empty()) {
+        lock.unlock();
+        break;
       }
+      NewTile new_tile = tilequeue.front();
+      tilequeue.pop();
+      lock.unlock();
 
-      // New tilebuilder for the next tile. Update current level.
-      tile_id = nodea.Tile_Base();
-      tilebuilder = new GraphTileBuilder(reader.tile_dir(), tile_id, false);
-      current_level = nodea.level();
+      // New tilebuilder for the tile. Update current level.
+      GraphId tile_id = new_tile.tile_id;
+      GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
+      uint8_t current_level = tile_id.level();
 
       // Set the base ll for this tile
-      base_ll = TileHierarchy::get_tiling(current_level).Base(tile_id.tileid());
-      tilebuilder->header_builder().set_base_ll(base_ll);
+      PointLL base_ll = TileHierarchy::get_tiling(current_level).Base(tile_id.tileid());
+      tilebuilder.header_builder().set_base_ll(base_ll);
+
+      // Iterate through the new nodes of the tile
+      for (size_t n = new_tile.begin; n < new_tile.end; ++n) {
+        std::pair<GraphId, GraphId> new_node = *new_to_old.at(n);
+        GraphId nodea = new_node.first;
+
+        // Get the node in the base level
+        GraphId base_node = new_node.second;
+        graph_tile_ptr tile = reader.GetGraphTile(base_node);
+        if (tile == nullptr) {
+          LOG_ERROR("Base tile is null? ");
+          continue;
+        }
 
-      // Check if we need to clear the base/local tile cache
-      if (reader.OverCommitted()) {
-        reader.Trim();
-      }
-    }
+        // Copy the data version
+        tilebuilder.header_builder().set_dataset_id(tile->header()->dataset_id());
+
+        // Copy node information and set the node lat,lon offsets within the new tile
+        NodeInfo baseni = *(tile->node(base_node.id()));
+        tilebuilder.nodes().push_back(baseni);
+        const auto& admin = tile->admininfo(baseni.admin_index());
+        NodeInfo& node = tilebuilder.nodes().back();
+        node.set_latlng(base_ll, baseni.latlng(tile->header()->base_ll()));
+        node.set_edge_index(tilebuilder.directededges().size());
+        node.set_timezone(baseni.timezone());
+        node.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
+                                                  admin.country_iso(), admin.state_iso()));
+
+        // Update node LL based on tile base
+        // Density at this node
+        uint32_t density1 = baseni.density();
+
+        // Current edge count
+        size_t edge_count = tilebuilder.directededges().size();
+
+        // Iterate through directed edges of the base node to get remaining
+        // directed edges (based on classification/importance cutoff)
+        GraphId base_edge_id(base_node.tileid(), base_node.level(), baseni.edge_index());
+        for (uint32_t i = 0; i < baseni.edge_count(); i++, ++base_edge_id) {
+          // Check if the directed edge should exist on this level
+          const DirectedEdge* directededge = tile->directededge(base_edge_id);
+          if (!include_edge(directededge, base_node, current_level)) {
+            continue;
+          }
 
-    // Get the node in the base level
-    GraphId base_node = (*new_node).second;
-    graph_tile_ptr tile = reader.GetGraphTile(base_node);
-    if (tile == nullptr) {
-      LOG_ERROR("Base tile is null? ");
-      continue;
-    }
+          // Copy the directed edge information
+          DirectedEdge newedge = *directededge;
+
+          // Set the end node for this edge. Transit connection edges
+          // remain connected to the same node on the transit level.
+          // Need to set nodeb for use in AddEdgeInfo
+          uint32_t density2 = 32;
+          GraphId nodeb;
+          if (directededge->use() == Use::kTransitConnection ||
+              directededge->use() == Use::kEgressConnection ||
+              directededge->use() == Use::kPlatformConnection) {
+            nodeb = directededge->endnode();
+          } else {
+            auto new_nodes = find_nodes(old_to_new, directededge->endnode());
+            if (current_level == 0) {
+              nodeb = new_nodes.highway_node;
+            } else if (current_level == 1) {
+              nodeb = new_nodes.arterial_node;
+            } else {
+              nodeb = new_nodes.local_node;
+            }
+            density2 = new_nodes.density;
+          }
+          if (!nodeb.Is_Valid()) {
+            LOG_ERROR("Invalid end node - not found in old_to_new map");
+          }
+          newedge.set_endnode(nodeb);
+
+          // Set the edge density  to the average of the relative density at the
+          // end nodes.
+          uint32_t edge_density = (density2 == 32) ? density1 : (density1 + density2) / 2;
+          newedge.set_density(edge_density);
+
+          // Set opposing edge indexes to 0 (gets set in graph validator).
+          newedge.set_opp_index(0);
+
+          // Get signs from the base directed edge
+          if (directededge->sign()) {
+            std::vector<SignInfo> signs = tile->GetSigns(base_edge_id.id());
+            if (signs.size() == 0) {
+              LOG_ERROR("Base edge should have signs, but none found");
+            }
+            tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
+          }
 
-    // Copy the data version
-    tilebuilder->header_builder().set_dataset_id(tile->header()->dataset_id());
-
-    // Copy node information and set the node lat,lon offsets within the new tile
-    NodeInfo baseni = *(tile->node(base_node.id()));
-    tilebuilder->nodes().push_back(baseni);
-    const auto& admin = tile->admininfo(baseni.admin_index());
-    NodeInfo& node = tilebuilder->nodes().back();
-    node.set_latlng(base_ll, baseni.latlng(tile->header()->base_ll()));
-    node.set_edge_index(tilebuilder->directededges().size());
-    node.set_timezone(baseni.timezone());
-    node.set_admin_index(tilebuilder->AddAdmin(admin.country_text(), admin.state_text(),
-                                               admin.country_iso(), admin.state_iso()));
-
-    // Update node LL based on tile base
-    // Density at this node
-    uint32_t density1 = baseni.density();
-
-    // Current edge count
-    size_t edge_count = tilebuilder->directededges().size();
-
-    // Iterate through directed edges of the base node to get remaining
-    // directed edges (based on classification/importance cutoff)
-    GraphId base_edge_id(base_node.tileid(), base_node.level(), baseni.edge_index());
-    for (uint32_t i = 0; i < baseni.edge_count(); i++, ++base_edge_id) {
-      // Check if the directed edge should exist on this level
-      const DirectedEdge* directededge = tile->directededge(base_edge_id);
-      if (!include_edge(directededge, base_node, current_level)) {
-        continue;
-      }
+          // Get turn lanes from the base directed edge
+          if (directededge->turnlanes()) {
+            uint32_t offset = tile->turnlanes_offset(base_edge_id.id());
+            tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
+          }
+
+          // Get access restrictions from the base directed edge. Add these to
+          // the list of access restrictions in the new tile. Update the
+          // edge index in the restriction to be the current directed edge Id
+          if (directededge->access_restriction()) {
+            auto restrictions = tile->GetAccessRestrictions(base_edge_id.id(), kAllAccess);
+            for (const auto& res : restrictions) {
+              tilebuilder.AddAccessRestriction(
+                  AccessRestriction(tilebuilder.directededges().size(), res.type(), res.modes(),
+                                    res.value()));
+            }
+          }
+
+          // Copy lane connectivity
+          if (directededge->laneconnectivity()) {
+            auto laneconnectivity = tile->GetLaneConnectivity(base_edge_id.id());
+            if (laneconnectivity.size() == 0) {
+              LOG_ERROR("Base edge should have lane connectivity, but none found");
+            }
+            for (auto& lc : laneconnectivity) {
+              lc.set_to(tilebuilder.directededges().size());
+            }
+            tilebuilder.AddLaneConnectivity(laneconnectivity);
+          }
 
-      // Copy the directed edge information
-      DirectedEdge newedge = *directededge;
-
-      // Set the end node for this edge. Transit connection edges
-      // remain connected to the same node on the transit level.
-      // Need to set nodeb for use in AddEdgeInfo
-      uint32_t density2 = 32;
-      GraphId nodeb;
-      if (directededge->use() == Use::kTransitConnection ||
-          directededge->use() == Use::kEgressConnection ||
-          directededge->use() == Use::kPlatformConnection) {
-        nodeb = directededge->endnode();
-      } else {
-        auto new_nodes = find_nodes(old_to_new, directededge->endnode());
+          // Do we need to force adding edgeinfo (opposing edge could have diff names)?
+          // If end node is in the same tile and there is no opposing edge with matching
+          // edge_info_offset).
+          bool diff_names = directededge->endnode().tileid() == base_edge_id.tileid() &&
+                            !OpposingEdgeInfoMatches(tile, directededge);
+
+          // Get edge info, shape, and names from the old tile and add to the
+          // new. Cannot use edge info offset since edges in arterial and
+          // highway hierarchy can cross base tiles! Use a hash based on the
+          // encoded shape plus way Id.
+          auto edgeinfo = tile->edgeinfo(directededge);
+          std::string encoded_shape = edgeinfo.encoded_shape();
+          uint32_t w = hasher(encoded_shape + std::to_string(edgeinfo.wayid()));
+          uint32_t edge_info_offset =
+              tilebuilder.AddEdgeInfo(w, nodea, nodeb, edgeinfo.wayid(), edgeinfo.mean_elevation(),
+                                      edgeinfo.bike_network(), edgeinfo.speed_limit(),
+                                      encoded_shape, edgeinfo.GetNames(), edgeinfo.GetNames(true),
+                                      edgeinfo.GetTypes(), added, diff_names);
+          newedge.set_edgeinfo_offset(edge_info_offset);
+
+          // Add directed edge
+          tilebuilder.directededges().emplace_back(std::move(newedge));
+        }
+
+        // Add node transitions
+        uint32_t index = tilebuilder.transitions().size();
+        auto new_nodes = find_nodes(old_to_new, base_node);
         if (current_level == 0) {
-          nodeb = new_nodes.highway_node;
+          AddDownwardTransition(new_nodes.arterial_node, &tilebuilder);
+          AddDownwardTransition(new_nodes.local_node, &tilebuilder);
         } else if (current_level == 1) {
-          nodeb = new_nodes.arterial_node;
+          AddUpwardTransition(new_nodes.highway_node, &tilebuilder);
+          AddDownwardTransition(new_nodes.local_node, &tilebuilder);
+        } else if (current_level == 2) {
+          AddUpwardTransition(new_nodes.highway_node, &tilebuilder);
+          AddUpwardTransition(new_nodes.arterial_node, &tilebuilder);
         } else {
-          nodeb = new_nodes.local_node;
+          throw std::logic_error("current_level was never set");
         }
-        density2 = new_nodes.density;
-      }
-      if (!nodeb.Is_Valid()) {
-        LOG_ERROR("Invalid end node - not found in old_to_new map");
-      }
-      newedge.set_endnode(nodeb);
 
-      // Set the edge density  to the average of the relative density at the
-      // end nodes.
-      uint32_t edge_density = (density2 == 32) ? density1 : (density1 + density2) / 2;
-      newedge.set_density(edge_density);
+        // Set the node transition count and index
+        uint32_t count = tilebuilder.transitions().size() - index;
+        if (count > 0) {
+          node.set_transition_count(count);
+          node.set_transition_index(index);
+        }
 
-      // Set opposing edge indexes to 0 (gets set in graph validator).
-      newedge.set_opp_index(0);
+        // Set the edge count for the new node
+        node.set_edge_count(tilebuilder.directededges().size() - edge_count);
 
-      // Get signs from the base directed edge
-      if (directededge->sign()) {
-        std::vector<SignInfo> signs = tile->GetSigns(base_edge_id.id());
-        if (signs.size() == 0) {
-          LOG_ERROR("Base edge should have signs, but none found");
+        // Get named signs from the base node
+        if (baseni.named_intersection()) {
+          std::vector<SignInfo> signs = tile->GetSigns(base_node.id(), true);
+          if (signs.size() == 0) {
+            LOG_ERROR("Base node should have signs, but none found");
+          }
+          node.set_named_intersection(true);
+          tilebuilder.AddSigns(tilebuilder.nodes().size() - 1, signs);
         }
-        tilebuilder->AddSigns(tilebuilder->directededges().size(), signs);
       }
 
-      // Get turn lanes from the base directed edge
-      if (directededge->turnlanes()) {
-        uint32_t offset = tile->turnlanes_offset(base_edge_id.id());
-        tilebuilder->AddTurnLanes(tilebuilder->directededges().size(), tile->GetName(offset));
-      }
+      // Store the tile
+      tilebuilder.StoreTileData();
 
-      // Get access restrictions from the base directed edge. Add these to
-      // the list of access restrictions in the new tile. Update the
-      // edge index in the restriction to be the current directed edge Id
-      if (directededge->access_restriction()) {
-        auto restrictions = tile->GetAccessRestrictions(base_edge_id.id(), kAllAccess);
-        for (const auto& res : restrictions) {
-          tilebuilder->AddAccessRestriction(AccessRestriction(tilebuilder->directededges().size(),
-                                                              res.type(), res.modes(), res.value()));
-        }
+      // Check if we need to clear the base/local tile cache
+      if (reader.OverCommitted()) {
+        reader.Trim();
       }
+    }
+    result.set_value();
+  } catch (...) {
+    // Pass the exception on to the main thread
+    result.set_exception(std::current_exception());
+  }
+}
 
-      // Copy lane connectivity
-      if (directededge->laneconnectivity()) {
-        auto laneconnectivity = tile->GetLaneConnectivity(base_edge_id.id());
-        if (laneconnectivity.size() == 0) {
-          LOG_ERROR("Base edge should have lane connectivity, but none found");
-        }
-        for (auto& lc : laneconnectivity) {
-          lc.set_to(tilebuilder->directededges().size());
-        }
-        tilebuilder->AddLaneConnectivity(laneconnectivity);
+/**
+ * Form the tiles of the new levels on threads. The tiles of the highway and arterial levels are
+ * formed first since they read from all of the base tiles, which the new local tiles replace.
+ * Each new local tile only reads the base tile it replaces so those can then be formed at once.
+ * Node ids were already assigned so the tiles are the same however they are spread over threads.
+ */
+void FormTilesInNewLevels(const boost::property_tree::ptree& pt,
+                          const std::string& new_to_old_file,
+                          const std::string& old_to_new_file) {
+  // Find the range of new nodes of each new tile, split by whether they replace a base tile
+  std::deque<NewTile> upper_tiles, local_tiles;
+  {
+    uint8_t local_level = TileHierarchy::levels().back().level;
+    sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
+    std::deque<NewTile>* tiles = nullptr;
+    size_t n = 0;
+    for (auto new_node = new_to_old.begin(); new_node != new_to_old.end(); ++new_node, ++n) {
+      GraphId tile_id = (*new_node).first.Tile_Base();
+      if (!tiles || tiles->back().tile_id != tile_id) {
+        tiles = tile_id.level() == local_level ? &local_tiles : &upper_tiles;
+        tiles->push_back({tile_id, n, n});
       }
-
-      // Do we need to force adding edgeinfo (opposing edge could have diff names)?
-      // If end node is in the same tile and there is no opposing edge with matching
-      // edge_info_offset).
-      bool diff_names = directededge->endnode().tileid() == base_edge_id.tileid() &&
-                        !OpposingEdgeInfoMatches(tile, directededge);
-
-      // Get edge info, shape, and names from the old tile and add to the
-      // new. Cannot use edge info offset since edges in arterial and
-      // highway hierarchy can cross base tiles! Use a hash based on the
-      // encoded shape plus way Id.
-      auto edgeinfo = tile->edgeinfo(directededge);
-      std::string encoded_shape = edgeinfo.encoded_shape();
-      uint32_t w = hasher(encoded_shape + std::to_string(edgeinfo.wayid()));
-      uint32_t edge_info_offset =
-          tilebuilder->AddEdgeInfo(w, nodea, nodeb, edgeinfo.wayid(), edgeinfo.mean_elevation(),
-                                   edgeinfo.bike_network(), edgeinfo.speed_limit(), encoded_shape,
-                                   edgeinfo.GetNames(), edgeinfo.GetNames(true), edgeinfo.GetTypes(),
-                                   added, diff_names);
-      newedge.set_edgeinfo_offset(edge_info_offset);
-
-      // Add directed edge
-      tilebuilder->directededges().emplace_back(std::move(newedge));
+      tiles->back().end = n + 1;
     }
+  }
 
-    // Add node transitions
-    uint32_t index = tilebuilder->transitions().size();
-    auto new_nodes = find_nodes(old_to_new, base_node);
-    if (current_level == 0) {
-      AddDownwardTransition(new_nodes.arterial_node, tilebuilder);
-      AddDownwardTransition(new_nodes.local_node, tilebuilder);
-    } else if (current_level == 1) {
-      AddUpwardTransition(new_nodes.highway_node, tilebuilder);
-      AddDownwardTransition(new_nodes.local_node, tilebuilder);
-    } else if (current_level == 2) {
-      AddUpwardTransition(new_nodes.highway_node, tilebuilder);
-      AddUpwardTransition(new_nodes.arterial_node, tilebuilder);
-    } else {
-      throw std::logic_error("current_level was never set");
+  // A place to hold worker threads and their results, exceptions or otherwise
+  std::vector<std::shared_ptr<std::thread>> threads(
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency())));
+  std::list<std::promise<void>> results;
+  std::mutex lock;
+
+  for (auto* tiles : {&upper_tiles, &local_tiles}) {
+    // The tiles with the most nodes go first so the threads finish at about the same time
+    std::stable_sort(tiles->begin(), tiles->end(), [](const NewTile& a, const NewTile& b) {
+      return a.end - a.begin > b.end - b.begin;
+    });
+    std::queue<NewTile> tilequeue(*tiles);
+
+    // Start the threads and wait for them to finish up their work
+    results.clear();
+    for (auto& thread : threads) {
+      results.emplace_back();
+      thread.reset(new std::thread(FormTilesInNewLevel, std::cref(pt), std::cref(new_to_old_file),
+                                   std::cref(old_to_new_file), std::ref(tilequeue), std::ref(lock),
+                                   std::ref(results.back())));
     }
-
-    // Set the node transition count and index
-    uint32_t count = tilebuilder->transitions().size() - index;
-    if (count > 0) {
-      node.set_transition_count(count);
-      node.set_transition_index(index);
+    for (auto& thread : threads) {
+      thread->join();
     }
 
-    // Set the edge count for the new node
-    node.set_edge_count(tilebuilder->directededges().size() - edge_count);
-
-    // Get named signs from the base node
-    if (baseni.named_intersection()) {
-      std::vector<SignInfo> signs = tile->GetSigns(base_node.id(), true);
-      if (signs.size() == 0) {
-        LOG_ERROR("Base node should have signs, but none found");
-      }
-      node.set_named_intersection(true);
-      tilebuilder->AddSigns(tilebuilder->nodes().size() - 1, signs);
+    // If something bad went down this will rethrow it
+    for (auto& result : results) {
+      result.get_future().get();
     }
   }
-
-  // Delete the tile builder
-  if (tilebuilder != nullptr) {
-    tilebuilder->StoreTileData();
-    delete tilebuilder;
-  }
 }
 
 /**
@@ -579,9 +666,6 @@ void HierarchyBuilder::Build(const boost::property_tree::ptree& pt,
                              const std::string& new_to_old_file,
                              const std::string& old_to_new_file) {
 
-  // TODO: thread this. Might be more possible now that we don't create
-  // shortcuts in the HierarchyBuilder
-
   // Construct GraphReader
   LOG_INFO("HierarchyBuilder");
   GraphReader reader(pt.get_child("mjolnir"));
@@ -590,11 +674,12 @@ void HierarchyBuilder::Build(const boost::property_tree::ptree& pt,
   CreateNodeAssociations(reader, new_to_old_file, old_to_new_file);
 
   // Sort the sequences
-  SortSequences(new_to_old_file, old_to_new_file);
+  SortSequences(pt.get_child("mjolnir"), new_to_old_file, old_to_new_file);
 
   // Iterate through the hierarchy (from highway down to local) and build
   // new tiles
-  FormTilesInNewLevel(reader, new_to_old_file, old_to_new_file);
+  FormTilesInNewLevels(pt.get_child("mjolnir"), new_to_old_file, old_to_new_file);
+  reader.Clear();
 
   // Remove any base tiles that no longer have any data (nodes and edges
   // only exist on arterial and highway levels)
@@ -0,0 +1,212 @@
+#include "mjolnir/landmarkbuilder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "baldr/graphreader.h"
+#include "baldr/landmarks.h"
+#include "baldr/tilehierarchy.h"
+#include "midgard/logging.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+using tile_t = Landmarks::tile_t;
+
+constexpr uint32_t kDefaultLandmarkCount = 16;
+
+// The graph as a compressed list of arcs per node, an arc being the node it leads to and its length
+struct graph_t {
+  std::vector<uint64_t> offsets;
+  std::vector<std::pair<uint32_t, uint32_t>> arcs;
+
+  size_t node_count() const {
+    return offsets.size() - 1;
+  }
+};
+
+// Shortest path lengths from a node to all of the others
+void Distances(const graph_t& graph, const uint32_t from, std::vector<uint32_t>& distances) {
+  using entry_t = std::pair<uint32_t, uint32_t>;
+  std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> queue;
+  distances.assign(graph.node_count(), Landmarks::kUnreached);
+  distances[from] = 0;
+  queue.emplace(0, from);
+  while (!queue.empty()) {
+    const auto current = queue.top();
+    queue.pop();
+    if (current.first > distances[current.second]) {
+      continue;
+    }
+    for (auto arc = graph.offsets[current.second]; arc < graph.offsets[current.second + 1]; ++arc) {
+      const auto& to = graph.arcs[arc];
+      const uint32_t distance = current.first + to.second;
+      if (distance < distances[to.first]) {
+        distances[to.first] = distance;
+        queue.emplace(distance, to.first);
+      }
+    }
+  }
+}
+
+// A node of the largest connected part of the graph, the landmarks are picked from that part so
+// that they are not wasted on islands
+uint32_t LargestComponent(const graph_t& graph) {
+  std::vector<bool> visited(graph.node_count(), false);
+  std::vector<uint32_t> pending;
+  uint32_t best = 0;
+  size_t best_size = 0;
+  for (uint32_t start = 0; start < graph.node_count(); ++start) {
+    if (visited[start]) {
+      continue;
+    }
+    size_t size = 0;
+    visited[start] = true;
+    pending.push_back(start);
+    while (!pending.empty()) {
+      const auto node = pending.back();
+      pending.pop_back();
+      ++size;
+      for (auto arc = graph.offsets[node]; arc < graph.offsets[node + 1]; ++arc) {
+        const auto to = graph.arcs[arc].first;
+        if (!visited[to]) {
+          visited[to] = true;
+          pending.push_back(to);
+        }
+      }
+    }
+    if (size > best_size) {
+      best = start;
+      best_size = size;
+    }
+  }
+  return best;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+void LandmarkBuilder::Build(const boost::property_tree::ptree& pt) {
+  const auto file = pt.get<std::string>("mjolnir.landmarks");
+  const auto landmark_count = pt.get<uint32_t>("mjolnir.landmark_count", kDefaultLandmarkCount);
+  GraphReader reader(pt.get_child("mjolnir"));
+
+  // Every road level takes part, the levels are joined by the node transitions. The tiles are
+  // sorted by id and their nodes numbered in that order
+  std::vector<tile_t> tiles;
+  for (const auto& level : TileHierarchy::levels()) {
+    for (const auto& tile_id : reader.GetTileSet(level.level)) {
+      auto tile = reader.GetGraphTile(tile_id);
+      tiles.push_back({tile_id.value, 0, tile->header()->nodecount()});
+      if (reader.OverCommitted()) {
+        reader.Trim();
+      }
+    }
+  }
+  std::sort(tiles.begin(), tiles.end(),
+            [](const tile_t& a, const tile_t& b) { return a.tile < b.tile; });
+  std::unordered_map<uint64_t, uint32_t> offsets;
+  uint32_t node_count = 0;
+  for (auto& tile : tiles) {
+    tile.offset = node_count;
+    offsets.emplace(tile.tile, node_count);
+    node_count += tile.node_count;
+  }
+  auto index_of = [&offsets](const GraphId& node) {
+    auto found = offsets.find(node.Tile_Base().value);
+    return found == offsets.cend() ? Landmarks::kInvalidNode : found->second + node.id();
+  };
+
+  // Every edge is an arc whatever its access, their opposing edges make the graph undirected so
+  // the distances are lower bounds for any costing. Shortcuts would not change any distance
+  graph_t graph;
+  graph.offsets.reserve(node_count + 1);
+  graph.offsets.push_back(0);
+  for (const auto& tile_info : tiles) {
+    auto tile = reader.GetGraphTile(GraphId(tile_info.tile));
+    for (uint32_t i = 0; i < tile_info.node_count; ++i) {
+      const auto* node = tile->node(i);
+      for (const auto& edge : tile->GetDirectedEdges(node)) {
+        auto to = index_of(edge.endnode());
+        if (!edge.is_shortcut() && to != Landmarks::kInvalidNode) {
+          graph.arcs.emplace_back(to, edge.length());
+        }
+      }
+      for (const auto& transition : tile->GetNodeTransitions(node)) {
+        auto to = index_of(transition.endnode());
+        if (to != Landmarks::kInvalidNode) {
+          graph.arcs.emplace_back(to, 0);
+        }
+      }
+      graph.offsets.push_back(graph.arcs.size());
+    }
+    if (reader.OverCommitted()) {
+      reader.Trim();
+    }
+  }
+  LOG_INFO("Picking " + std::to_string(landmark_count) + " landmarks among " +
+           std::to_string(node_count) + " nodes with " + std::to_string(graph.arcs.size()) +
+           " arcs");
+
+  // Farthest point selection, each landmark is the node farthest from the ones picked so far,
+  // starting with the node farthest from some node of the largest part of the graph
+  std::vector<GraphId> landmarks;
+  std::vector<uint32_t> distances(static_cast<size_t>(node_count) * landmark_count);
+  std::vector<uint32_t> nearest, from_landmark;
+  if (node_count > 0) {
+    Distances(graph, LargestComponent(graph), nearest);
+  }
+  for (uint32_t k = 0; k < landmark_count && node_count > 0; ++k) {
+    uint32_t farthest = 0;
+    for (uint32_t i = 0; i < node_count; ++i) {
+      if (nearest[i] != Landmarks::kUnreached &&
+          (nearest[farthest] == Landmarks::kUnreached || nearest[i] > nearest[farthest])) {
+        farthest = i;
+      }
+    }
+    // Every node of the part is a landmark already
+    if (k > 0 && nearest[farthest] == 0) {
+      break;
+    }
+
+    Distances(graph, farthest, from_landmark);
+    for (uint32_t i = 0; i < node_count; ++i) {
+      distances[static_cast<size_t>(i) * landmark_count + k] = from_landmark[i];
+      nearest[i] = k == 0 ? from_landmark[i] : std::min(nearest[i], from_landmark[i]);
+    }
+    auto tile = std::upper_bound(tiles.cbegin(), tiles.cend(), farthest,
+                                 [](uint32_t node, const tile_t& t) { return node < t.offset; });
+    --tile;
+    landmarks.emplace_back(GraphId(tile->tile).tileid(), GraphId(tile->tile).level(),
+                           farthest - tile->offset);
+    LOG_INFO("Landmark " + std::to_string(k) + " is " + std::to_string(landmarks.back()));
+  }
+
+  // Fewer landmarks than asked for leave gaps in each row of distances
+  if (landmarks.size() < landmark_count) {
+    std::vector<uint32_t> packed;
+    packed.reserve(static_cast<size_t>(node_count) * landmarks.size());
+    for (uint32_t i = 0; i < node_count; ++i) {
+      auto row = distances.cbegin() + static_cast<size_t>(i) * landmark_count;
+      packed.insert(packed.end(), row, row + landmarks.size());
+    }
+    distances.swap(packed);
+  }
+
+  Landmarks(std::move(tiles), std::move(landmarks), std::move(distances)).Save(file);
+  LOG_INFO("Wrote landmarks to " + file);
+}
+
+} // namespace mjolnir
+} // namespace valhalla
@@ -2,6 +2,7 @@
 
 #include "midgard/logging.h"
 #include "mjolnir/osmdata.h"
+#include <algorithm>
 #include <boost/format.hpp>
 #include <stdexcept>
 
@@ -13,6 +14,9 @@ const std::string LUA_NODE_PROC = "nodes_proc";
 const std::string LUA_WAY_PROC = "ways_proc";
 const std::string LUA_REL_PROC = "rels_proc";
 
+// What the script sees in place of the value of a passthrough tag, followed by the key of the tag
+constexpr char kPlaceholder = '\x01';
+
 void CheckLuaFuncExists(lua_State* state, const std::string& func_name) {
 
   lua_getglobal(state, func_name.c_str());
@@ -36,7 +40,10 @@ std::string to_string(OSMType t) {
 
 } // namespace
 
-LuaTagTransform::LuaTagTransform(const std::string& lua) {
+LuaTagTransform::LuaTagTransform(const std::string& lua,
+                                 size_t cache_size,
+                                 const std::vector<std::string>& passthrough)
+    : cache_size_(cache_size), passthrough_(passthrough) {
   // create a new lua state
   state_ = luaL_newstate();
   luaL_openlibs(state_);
@@ -54,7 +61,85 @@ LuaTagTransform::~LuaTagTransform() {
   }
 }
 
+bool LuaTagTransform::IsPassthrough(const std::string& key) const {
+  return std::any_of(passthrough_.begin(), passthrough_.end(), [&key](const std::string& p) {
+    return p.back() == ':' ? key.compare(0, p.size(), p) == 0 : key == p;
+  });
+}
+
 Tags LuaTagTransform::Transform(OSMType type, uint64_t osmid, const Tags& maptags) {
+  if (cache_size_ == 0) {
+    return Call(type, osmid, maptags);
+  }
+
+  // the key is the type and the sorted tags without the values of the passthrough tags, any value
+  // which could be mistaken for a placeholder is not worth the trouble of caching
+  std::vector<const Tags::value_type*> sorted;
+  sorted.reserve(maptags.size());
+  for (const auto& tag : maptags) {
+    if (tag.second.find(kPlaceholder) != std::string::npos) {
+      return Call(type, osmid, maptags);
+    }
+    sorted.push_back(&tag);
+  }
+  std::sort(sorted.begin(), sorted.end(), [](const Tags::value_type* a, const Tags::value_type* b) {
+    return a->first < b->first;
+  });
+  std::string key(1, static_cast<char>(type));
+  bool placeholders = false;
+  for (const auto* tag : sorted) {
+    key.append(tag->first).push_back('\0');
+    if (IsPassthrough(tag->first)) {
+      key.push_back(kPlaceholder);
+      placeholders = true;
+    } else {
+      key.append(tag->second);
+    }
+    key.push_back('\0');
+  }
+
+  auto cached = cache_.find(key);
+  if (cached == cache_.end()) {
+    // the script sees placeholders naming the keys of the passthrough tags in place of their values
+    Tags canonical;
+    if (placeholders) {
+      for (const auto& tag : maptags) {
+        canonical.emplace(tag.first,
+                          IsPassthrough(tag.first) ? kPlaceholder + tag.first : tag.second);
+      }
+    }
+    auto results = Call(type, osmid, placeholders ? canonical : maptags);
+    // a placeholder which came back as something other than itself was looked into by the script
+    // after all, so its results only hold for this element
+    for (const auto& result : results) {
+      const auto found = result.second.find(kPlaceholder);
+      if (found == std::string::npos) {
+        continue;
+      }
+      const auto tag = canonical.find(result.second.substr(1));
+      if (found != 0 || tag == canonical.end() || tag->second != result.second) {
+        return Call(type, osmid, maptags);
+      }
+    }
+    if (cache_.size() >= cache_size_) {
+      cache_.clear();
+    }
+    cached = cache_.emplace(std::move(key), std::move(results)).first;
+  }
+
+  // the values of the passthrough tags of this element go back in place of the placeholders
+  Tags results = cached->second;
+  if (placeholders) {
+    for (auto& result : results) {
+      if (!result.second.empty() && result.second.front() == kPlaceholder) {
+        result.second = maptags.find(result.second.substr(1))->second;
+      }
+    }
+  }
+  return results;
+}
+
+Tags LuaTagTransform::Call(OSMType type, uint64_t osmid, const Tags& maptags) {
 
   // grab the proper function out of the lua code
   Tags result;
@@ -0,0 +1,139 @@
+#include "mjolnir/osmchange.h"
+
+#include <cctype>
+#include <fstream>
+#include <stdexcept>
+
+#include "baldr/tilehierarchy.h"
+#include "midgard/logging.h"
+#include "midgard/sequence.h"
+#include "mjolnir/osmdata.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+// the value of an attribute of an element or an empty string if it doesnt have it
+std::string attribute(const std::string& element, const std::string& name) {
+  for (auto pos = element.find(name); pos != std::string::npos; pos = element.find(name, pos + 1)) {
+    auto quote = pos + name.size() + 1;
+    if (pos == 0 || !std::isspace(static_cast<unsigned char>(element[pos - 1])) ||
+        quote >= element.size() || element[quote - 1] != '=' ||
+        (element[quote] != '"' && element[quote] != '\'')) {
+      continue;
+    }
+    auto end = element.find(element[quote], quote + 1);
+    return end == std::string::npos ? "" : element.substr(quote + 1, end - quote - 1);
+  }
+  return "";
+}
+
+// the osm id an attribute refers to
+uint64_t id_attribute(const std::string& element, const std::string& name) {
+  auto value = attribute(element, name);
+  try {
+    return std::stoull(value);
+  } catch (...) {
+    throw std::runtime_error("Invalid " + name + " '" + value + "' in osc element <" + element + ">");
+  }
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+OSMChange OSMChange::Read(const std::string& osc_file) {
+  std::ifstream file(osc_file);
+  if (!file.is_open()) {
+    throw std::runtime_error("Unable to open: " + osc_file);
+  }
+
+  // we only need the start of the elements so we dont bother with a real xml parser, anything in
+  // between them (tags with a > in their value) doesnt start with < and is skipped
+  OSMChange change;
+  bool deleting = false;
+  std::string piece;
+  while (std::getline(file, piece, '>')) {
+    auto start = piece.find('<');
+    if (start == std::string::npos) {
+      continue;
+    }
+    auto element = piece.substr(start + 1);
+    auto name = element.substr(0, element.find_first_of(" \t\r\n/", 1));
+
+    if (name == "delete") {
+      deleting = true;
+    } else if (name == "/delete") {
+      deleting = false;
+    } else if (name == "node") {
+      // deleted nodes may carry their last location as well but they arent anywhere now
+      auto id = id_attribute(element, "id");
+      change.node_ids.insert(id);
+      auto lat = attribute(element, "lat");
+      auto lon = attribute(element, "lon");
+      if (!deleting && !lat.empty() && !lon.empty()) {
+        change.nodes[id] = PointLL(std::stod(lon), std::stod(lat));
+      }
+    } else if (name == "way") {
+      change.way_ids.insert(id_attribute(element, "id"));
+    } else if (name == "nd") {
+      change.node_ids.insert(id_attribute(element, "ref"));
+    } else if (name == "member") {
+      // restrictions and the like change the ways and nodes they are made of
+      auto type = attribute(element, "type");
+      if (type == "way") {
+        change.way_ids.insert(id_attribute(element, "ref"));
+      } else if (type == "node") {
+        change.node_ids.insert(id_attribute(element, "ref"));
+      }
+    }
+  }
+
+  LOG_INFO("Read " + std::to_string(change.node_ids.size()) + " changed nodes and " +
+           std::to_string(change.way_ids.size()) + " changed ways from " + osc_file);
+  return change;
+}
+
+std::set<GraphId> OSMChange::AffectedTiles(const std::string& ways_file,
+                                           const std::string& way_nodes_file) const {
+  // the way nodes refer to their ways by index
+  std::unordered_set<uint32_t> way_indices;
+  {
+    sequence<OSMWay> ways(ways_file, false);
+    uint32_t index = 0;
+    ways.enumerate([this, &way_indices, &index](const OSMWay& way) {
+      if (way_ids.count(way.way_id())) {
+        way_indices.insert(index);
+      }
+      ++index;
+    });
+  }
+
+  // a changed local tile changes the tiles above it
+  std::set<GraphId> tiles;
+  auto add = [&tiles](const PointLL& ll) {
+    for (const auto& level : TileHierarchy::levels()) {
+      tiles.insert(TileHierarchy::GetGraphId(ll, level.level));
+    }
+  };
+
+  // where the changed nodes and the nodes of the changed ways were
+  sequence<OSMWayNode> way_nodes(way_nodes_file, false);
+  way_nodes.enumerate([this, &way_indices, &add](const OSMWayNode& way_node) {
+    if (way_indices.count(way_node.way_index) || node_ids.count(way_node.node.osmid_)) {
+      add(way_node.node.latlng());
+    }
+  });
+
+  // and where the changed nodes are now
+  for (const auto& node : nodes) {
+    add(node.second);
+  }
+  return tiles;
+}
+
+} // namespace mjolnir
+} // namespace valhalla
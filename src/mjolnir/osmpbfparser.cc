@@ -33,6 +33,12 @@
 #else
 #include <netinet/in.h>
 #endif
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 #include <zlib.h>
@@ -81,9 +87,8 @@ BlobHeader read_header(char* buffer, std::ifstream& file, bool& finished) {
   return result;
 }
 
-int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const BlobHeader& header) {
-  Blob blob;
-
+// read the bytes of the blob that goes with the header, they are decoded by unpack_blob
+int32_t read_blob(char* buffer, std::ifstream& file, const BlobHeader& header) {
   // is the size of the following blob sane
   int32_t sz = header.datasize();
   if (sz > MAX_UNCOMPRESSED_BLOB_SIZE) {
@@ -94,8 +99,12 @@ int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const
   if (!file.read(buffer, sz)) {
     throw std::runtime_error("unable to read blob from file");
   }
+  return sz;
+}
 
+int32_t unpack_blob(const char* buffer, int32_t sz, char* unpack_buffer) {
   // turn it into a protobuf object
+  Blob blob;
   if (!blob.ParseFromArray(buffer, sz)) {
     throw std::runtime_error("unable to parse blob");
   }
@@ -107,10 +116,13 @@ int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const
     if (sz != blob.raw_size()) {
       LOG_WARN("blob reports wrong raw_size: " + std::to_string(blob.raw_size()) + " bytes");
     }
-    memcpy(unpack_buffer, buffer, sz);
+    memcpy(unpack_buffer, blob.raw().data(), sz);
     return sz;
   } // if the blob was zlib compressed
   else if (blob.has_zlib_data()) {
+    if (blob.raw_size() > MAX_UNCOMPRESSED_BLOB_SIZE) {
+      throw std::runtime_error("uncompressed blob-size is bigger than allowed");
+    }
     sz = blob.zlib_data().size();
     z_stream z;
     z.next_in = (unsigned char*)blob.zlib_data().c_str();
@@ -151,16 +163,9 @@ template <class T> OSMPBF::Tags get_tags(const T& object, const OSMPBF::Primitiv
   return result;
 }
 
-void parse_primitive_block(char* unpack_buffer,
-                           int32_t sz,
+void parse_primitive_block(const PrimitiveBlock& primblock,
                            const Interest interest,
                            Callback& callback) {
-  // turn the blob bytes into a protobuf object
-  PrimitiveBlock primblock;
-  if (!primblock.ParseFromArray(unpack_buffer, sz)) {
-    throw std::runtime_error("unable to parse primitive block");
-  }
-
   // for each primitive group
   for (const auto& primitive_group : primblock.primitivegroup()) {
 
@@ -272,6 +277,74 @@ void parse_header_block(char* unpack_buffer, int32_t sz) {
   // TODO: do something with replication information?
 }
 
+// decodes a data blob on its own so that many of them can be decoded at the same time
+std::unique_ptr<PrimitiveBlock> decode_data_blob(const std::string& bytes) {
+  std::unique_ptr<char[]> unpack_buffer(new char[MAX_UNCOMPRESSED_BLOB_SIZE]);
+  int32_t sz = unpack_blob(bytes.data(), bytes.size(), unpack_buffer.get());
+  std::unique_ptr<PrimitiveBlock> primblock(new PrimitiveBlock);
+  if (!primblock->ParseFromArray(unpack_buffer.get(), sz)) {
+    throw std::runtime_error("unable to parse primitive block");
+  }
+  return primblock;
+}
+
+// a fixed set of threads decoding the data blobs in the order they were handed to it
+class blob_decoder {
+public:
+  explicit blob_decoder(const unsigned int threads) : done_(false) {
+    for (unsigned int i = 0; i < threads; ++i) {
+      threads_.emplace_back(&blob_decoder::work, this);
+    }
+  }
+
+  ~blob_decoder() {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      done_ = true;
+    }
+    condition_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  std::future<std::unique_ptr<PrimitiveBlock>> decode(std::string&& bytes) {
+    auto shared = std::make_shared<std::string>(std::move(bytes));
+    std::packaged_task<std::unique_ptr<PrimitiveBlock>()> task(
+        [shared]() { return decode_data_blob(*shared); });
+    auto future = task.get_future();
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      queue_.emplace_back(std::move(task));
+    }
+    condition_.notify_one();
+    return future;
+  }
+
+private:
+  void work() {
+    while (true) {
+      std::packaged_task<std::unique_ptr<PrimitiveBlock>()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]() { return done_ || !queue_.empty(); });
+        if (done_ && queue_.empty()) {
+          return;
+        }
+        task = std::move(queue_.front());
+        queue_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<std::packaged_task<std::unique_ptr<PrimitiveBlock>()>> queue_;
+  bool done_;
+  std::vector<std::thread> threads_;
+};
+
 } // namespace
 
 // extend the protobuf osmpbf namespace
@@ -285,9 +358,23 @@ Member::Member(Member&& other)
     : member_type(other.member_type), member_id(other.member_id), role(std::move(other.role)) {
 }
 
-void Parser::parse(std::ifstream& file, const Interest interest, Callback& callback) {
-  char* buffer = new char[MAX_UNCOMPRESSED_BLOB_SIZE];
-  char* unpack_buffer = new char[MAX_UNCOMPRESSED_BLOB_SIZE];
+void Parser::parse(std::ifstream& file,
+                   const Interest interest,
+                   Callback& callback,
+                   const unsigned int threads) {
+  std::unique_ptr<char[]> buffer(new char[MAX_UNCOMPRESSED_BLOB_SIZE]);
+  std::unique_ptr<char[]> unpack_buffer(new char[MAX_UNCOMPRESSED_BLOB_SIZE]);
+
+  // the data blobs are decoded by the other threads but the callbacks are only ever called from
+  // this one and in the order of the blobs in the file, we keep a few blobs ahead of the callbacks
+  std::unique_ptr<blob_decoder> decoder(threads > 1 ? new blob_decoder(threads) : nullptr);
+  std::deque<std::future<std::unique_ptr<PrimitiveBlock>>> decoding;
+  const size_t max_decoding = threads * 2;
+  auto next_block = [&]() {
+    auto primblock = decoding.front().get();
+    decoding.pop_front();
+    parse_primitive_block(*primblock, interest, callback);
+  };
 
   // start from the top
   file.clear();
@@ -297,26 +384,40 @@ void Parser::parse(std::ifstream& file, const Interest interest, Callback& callb
   while (!file.eof()) {
     // grab the blob header
     bool finished = false;
-    BlobHeader header = read_header(buffer, file, finished);
+    BlobHeader header = read_header(buffer.get(), file, finished);
     // if we didnt hit the end
     if (!finished) {
       // grab the blob that goes with the blob header
-      int32_t sz = read_blob(buffer, unpack_buffer, file, header);
+      int32_t sz = read_blob(buffer.get(), file, header);
       // if its data parse it
       if (header.type() == "OSMData") {
-        parse_primitive_block(unpack_buffer, sz, interest, callback);
+        if (decoder) {
+          decoding.emplace_back(decoder->decode(std::string(buffer.get(), sz)));
+          if (decoding.size() >= max_decoding) {
+            next_block();
+          }
+          continue;
+        }
+        sz = unpack_blob(buffer.get(), sz, unpack_buffer.get());
+        PrimitiveBlock primblock;
+        if (!primblock.ParseFromArray(unpack_buffer.get(), sz)) {
+          throw std::runtime_error("unable to parse primitive block");
+        }
+        parse_primitive_block(primblock, interest, callback);
         // if its something other than a header
       } else if (header.type() == "OSMHeader") {
-        parse_header_block(unpack_buffer, sz);
+        sz = unpack_blob(buffer.get(), sz, unpack_buffer.get());
+        parse_header_block(unpack_buffer.get(), sz);
       } else {
         LOG_WARN("Unknown blob type: " + header.type());
       }
     }
   }
 
-  // done with protobuf and buffers
-  delete[] buffer;
-  delete[] unpack_buffer;
+  // finish off the blobs that are still being decoded
+  while (!decoding.empty()) {
+    next_block();
+  }
 }
 
 void Parser::free() {
@@ -11,6 +11,7 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <thread>
 #include <utility>
 
 using namespace valhalla::midgard;
@@ -144,6 +145,8 @@ OSMAdminData PBFAdminParser::Parse(const boost::property_tree::ptree& pt,
   // methods can use it.
   OSMAdminData osmdata{};
   admin_callback callback(pt, osmdata);
+  const auto concurrency = pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency());
+  const auto threads = std::max(1u, pt.get<unsigned int>("parse_concurrency", concurrency));
 
   LOG_INFO("Parsing files: " + boost::algorithm::join(input_files, ", "));
 
@@ -163,7 +166,7 @@ OSMAdminData PBFAdminParser::Parse(const boost::property_tree::ptree& pt,
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::RELATIONS |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          callback, threads);
   }
   LOG_INFO("Finished with " + std::to_string(osmdata.admins_.size()) +
            " admin polygons comprised of " + std::to_string(osmdata.osm_way_count) + " ways");
@@ -174,7 +177,7 @@ OSMAdminData PBFAdminParser::Parse(const boost::property_tree::ptree& pt,
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::WAYS |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          callback, threads);
   }
   LOG_INFO("Finished with " + std::to_string(osmdata.way_map.size()) + " ways comprised of " +
            std::to_string(osmdata.node_count) + " nodes");
@@ -186,7 +189,7 @@ OSMAdminData PBFAdminParser::Parse(const boost::property_tree::ptree& pt,
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::NODES |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          callback, threads);
   }
   LOG_INFO("Finished with " + std::to_string(osmdata.osm_node_count) + " nodes");
 
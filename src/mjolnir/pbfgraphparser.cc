@@ -139,6 +139,15 @@ private:
   std::unordered_map<uint64_t, loop_meta> loops_meta_;
 };
 
+// The tags whose values the built in lua script only copies through or checks for, the names of
+// the ways and nodes mostly, so that elements which differ only in these share their lua results
+const std::vector<std::string> kGraphLuaPassthrough = {"name",         "name:",
+                                                      "alt_name",     "official_name",
+                                                      "ref",          "int_ref",
+                                                      "unsigned_ref", "destination",
+                                                      "destination:", "junction:ref",
+                                                      "tunnel:name",  "bridge:name"};
+
 // Construct PBFGraphParser based on properties file and input PBF extract
 struct graph_callback : public OSMPBF::Callback {
 public:
@@ -148,7 +157,12 @@ public:
   }
 
   graph_callback(const boost::property_tree::ptree& pt, OSMData& osmdata)
-      : lua_(get_lua(pt)), osmdata_(osmdata) {
+      : lua_(get_lua(pt),
+             pt.get<size_t>("lua_cache_size", 65536),
+             // a script of your own may look into any tag so only identical tags share results
+             pt.get_optional<std::string>("graph_lua_name") ? std::vector<std::string>{}
+                                                            : kGraphLuaPassthrough),
+        osmdata_(osmdata) {
     current_way_node_index_ = last_node_ = last_way_ = last_relation_ = 0;
 
     highway_cutoff_rc_ = RoadClass::kPrimary;
@@ -2119,6 +2133,12 @@ public:
   Tags empty_relation_results_;
 };
 
+// how many threads decompress and decode the blobs of the pbf files
+unsigned int parse_concurrency(const boost::property_tree::ptree& pt) {
+  const auto concurrency = pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency());
+  return std::max(1u, pt.get<unsigned int>("parse_concurrency", concurrency));
+}
+
 } // namespace
 
 namespace valhalla {
@@ -2129,12 +2149,8 @@ OSMData PBFGraphParser::ParseWays(const boost::property_tree::ptree& pt,
                                   const std::string& ways_file,
                                   const std::string& way_nodes_file,
                                   const std::string& access_file) {
-  // TODO: option 1: each one threads makes an osmdata and we splice them together at the end
-  // option 2: synchronize around adding things to a single osmdata. will have to test to see
-  // which is the least expensive (memory and speed). leaning towards option 2
-  //  unsigned int threads =
-  //      std::max(static_cast<unsigned int>(1),
-  //               pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+  // the blobs are decoded in parallel, the callbacks all add to the one osmdata in file order
+  const auto threads = parse_concurrency(pt);
 
   // Create OSM data. Set the member pointer so that the parsing callback methods can use it.
   OSMData osmdata{};
@@ -2164,7 +2180,7 @@ OSMData PBFGraphParser::ParseWays(const boost::property_tree::ptree& pt,
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::WAYS |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          callback, threads);
   }
 
   // Clarifies types of loop roads and saves fixed ways.
@@ -2173,12 +2189,14 @@ OSMData PBFGraphParser::ParseWays(const boost::property_tree::ptree& pt,
   LOG_INFO("Finished with " + std::to_string(osmdata.osm_way_count) + " routable ways containing " +
            std::to_string(osmdata.osm_way_node_count) + " nodes");
   callback.reset(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+  osmdata.sort();
 
   // we need to sort the access tags so that we can easily find them.
   LOG_INFO("Sorting osm access tags by way id...");
   {
     sequence<OSMAccess> access(access_file, false);
-    access.sort([](const OSMAccess& a, const OSMAccess& b) { return a.way_id() < b.way_id(); });
+    sort_sequence(pt, access,
+                  [](const OSMAccess& a, const OSMAccess& b) { return a.way_id() < b.way_id(); });
   }
 
   LOG_INFO("Finished");
@@ -2193,12 +2211,8 @@ void PBFGraphParser::ParseRelations(const boost::property_tree::ptree& pt,
                                     const std::string& complex_restriction_from_file,
                                     const std::string& complex_restriction_to_file,
                                     OSMData& osmdata) {
-  // TODO: option 1: each one threads makes an osmdata and we splice them together at the end
-  // option 2: synchronize around adding things to a single osmdata. will have to test to see
-  // which is the least expensive (memory and speed). leaning towards option 2
-  //  unsigned int threads =
-  //      std::max(static_cast<unsigned int>(1),
-  //               pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+  // the blobs are decoded in parallel, the callbacks all add to the one osmdata in file order
+  const auto threads = parse_concurrency(pt);
 
   // Create OSM data. Set the member pointer so that the parsing callback methods can use it.
   graph_callback callback(pt, osmdata);
@@ -2231,28 +2245,29 @@ void PBFGraphParser::ParseRelations(const boost::property_tree::ptree& pt,
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::RELATIONS |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          callback, threads);
   }
   LOG_INFO("Finished with " + std::to_string(osmdata.restrictions.size()) + " simple restrictions");
   LOG_INFO("Finished with " + std::to_string(osmdata.lane_connectivity_map.size()) +
            " lane connections");
 
   callback.reset(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+  osmdata.sort();
 
   // Sort complex restrictions. Keep this scoped so the file handles are closed when done sorting.
   LOG_INFO("Sorting complex restrictions by from id...");
   {
     sequence<OSMRestriction> complex_restrictions_from(complex_restriction_from_file, false);
-    complex_restrictions_from.sort(
-        [](const OSMRestriction& a, const OSMRestriction& b) { return a < b; });
+    sort_sequence(pt, complex_restrictions_from,
+                  [](const OSMRestriction& a, const OSMRestriction& b) { return a < b; });
   }
 
   // Sort complex restrictions. Keep this scoped so the file handles are closed when done sorting.
   LOG_INFO("Sorting complex restrictions by to id...");
   {
     sequence<OSMRestriction> complex_restrictions_to(complex_restriction_to_file, false);
-    complex_restrictions_to.sort(
-        [](const OSMRestriction& a, const OSMRestriction& b) { return a < b; });
+    sort_sequence(pt, complex_restrictions_to,
+                  [](const OSMRestriction& a, const OSMRestriction& b) { return a < b; });
   }
   LOG_INFO("Finished");
 }
@@ -2262,12 +2277,8 @@ void PBFGraphParser::ParseNodes(const boost::property_tree::ptree& pt,
                                 const std::string& way_nodes_file,
                                 const std::string& bss_nodes_file,
                                 OSMData& osmdata) {
-  // TODO: option 1: each one threads makes an osmdata and we splice them together at the end
-  // option 2: synchronize around adding things to a single osmdata. will have to test to see
-  // which is the least expensive (memory and speed). leaning towards option 2
-  //  unsigned int threads =
-  //      std::max(static_cast<unsigned int>(1),
-  //               pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+  // the blobs are decoded in parallel, the callbacks all add to the one osmdata in file order
+  const auto threads = parse_concurrency(pt);
 
   // Create OSM data. Set the member pointer so that the parsing callback methods can use it.
   graph_callback callback(pt, osmdata);
@@ -2297,7 +2308,7 @@ void PBFGraphParser::ParseNodes(const boost::property_tree::ptree& pt,
       callback.reset(nullptr, nullptr, nullptr, nullptr, nullptr,
                      new sequence<OSMNode>(bss_nodes_file, true));
       OSMPBF::Parser::parse(file_handle, static_cast<OSMPBF::Interest>(OSMPBF::Interest::NODES),
-                            callback);
+                            callback, threads);
     }
   }
   callback.reset(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
@@ -2308,8 +2319,9 @@ void PBFGraphParser::ParseNodes(const boost::property_tree::ptree& pt,
   LOG_INFO("Sorting osm way node references by node id...");
   {
     sequence<OSMWayNode> way_nodes(way_nodes_file, false);
-    way_nodes.sort(
-        [](const OSMWayNode& a, const OSMWayNode& b) { return a.node.osmid_ < b.node.osmid_; });
+    sort_sequence(pt, way_nodes, [](const OSMWayNode& a, const OSMWayNode& b) {
+      return a.node.osmid_ < b.node.osmid_;
+    });
   }
 
   // Parse node in all the input files. Skip any that are not marked from
@@ -2326,7 +2338,7 @@ void PBFGraphParser::ParseNodes(const boost::property_tree::ptree& pt,
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::NODES |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          callback, threads);
   }
   uint64_t max_osm_id = callback.last_node_;
   callback.reset(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
@@ -2338,7 +2350,7 @@ void PBFGraphParser::ParseNodes(const boost::property_tree::ptree& pt,
   LOG_INFO("Sorting osm way node references by way index and node shape index...");
   {
     sequence<OSMWayNode> way_nodes(way_nodes_file, false);
-    way_nodes.sort([](const OSMWayNode& a, const OSMWayNode& b) {
+    sort_sequence(pt, way_nodes, [](const OSMWayNode& a, const OSMWayNode& b) {
       if (a.way_index == b.way_index) {
         // TODO: if its equal we have screwed something up, should we check and throw here?
         return a.way_shape_node_index < b.way_shape_node_index;
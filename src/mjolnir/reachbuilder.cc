@@ -0,0 +1,250 @@
+#include "mjolnir/reachbuilder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "baldr/edgereach.h"
+#include "baldr/graphreader.h"
+#include "baldr/rapidjson_utils.h"
+#include "baldr/tilehierarchy.h"
+#include "midgard/logging.h"
+#include "mjolnir/util.h"
+#include "proto_conversions.h"
+#include "sif/costfactory.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+using tile_t = EdgeReach::tile_t;
+using reach_t = EdgeReach::reach_t;
+
+constexpr uint32_t kDefaultReachCap = 100;
+constexpr uint32_t kMaxReachCap = 255;
+
+// The costings the table is built for, loki looks them up when a request keeps their defaults
+const std::vector<valhalla::Costing> kReachCostings = {valhalla::Costing::auto_,
+                                                       valhalla::Costing::truck,
+                                                       valhalla::Costing::bicycle,
+                                                       valhalla::Costing::pedestrian};
+
+// the same conservative estimates loki::Reach starts with
+constexpr uint16_t kForwardDisallowMask = valhalla::sif::kDisallowEndRestriction |
+                                          valhalla::sif::kDisallowSimpleRestriction |
+                                          valhalla::sif::kDisallowClosure |
+                                          valhalla::sif::kDisallowShortcut;
+constexpr uint16_t kStartDisallowMask =
+    valhalla::sif::kDisallowSimpleRestriction | valhalla::sif::kDisallowShortcut;
+constexpr uint16_t kReverseDisallowMask = valhalla::sif::kDisallowStartRestriction |
+                                          valhalla::sif::kDisallowSimpleRestriction |
+                                          valhalla::sif::kDisallowClosure |
+                                          valhalla::sif::kDisallowShortcut;
+
+/**
+ * The conservative expansion of loki::Reach without its exact fallback, so that the reach in
+ * the table is never more than what loki would find for the edge itself. It counts the nodes it
+ * settles or queues up to the cap, a node and its doppelgängers on the other levels count once.
+ */
+class ReachCounter {
+public:
+  ReachCounter(GraphReader& reader, const uint32_t cap) : reader_(reader), cap_(cap) {
+    queue_.reserve(cap);
+    done_.reserve(cap);
+  }
+
+  reach_t operator()(const DirectedEdge* edge,
+                     const graph_tile_ptr& start_tile,
+                     const valhalla::sif::cost_ptr_t& costing) {
+    reach_t reach{};
+
+    Clear();
+    graph_tile_ptr tile = start_tile;
+    if (costing->Allowed(edge, tile, kStartDisallowMask))
+      Enqueue(edge->endnode(), costing, tile);
+    while (Count() < cap_ && !queue_.empty()) {
+      auto node_id = Pop();
+      if (!reader_.GetGraphTile(node_id, tile))
+        continue;
+      for (const auto& next : tile->GetDirectedEdges(node_id)) {
+        if (costing->Allowed(&next, tile, kForwardDisallowMask))
+          Enqueue(next.endnode(), costing, tile);
+      }
+    }
+    reach.outbound = std::min(Count(), cap_);
+
+    Clear();
+    tile = start_tile;
+    if (costing->Allowed(edge, tile, valhalla::sif::kDisallowShortcut))
+      Enqueue(reader_.GetBeginNodeId(edge, tile), costing, tile);
+    while (Count() < cap_ && !queue_.empty()) {
+      auto node_id = Pop();
+      if (!reader_.GetGraphTile(node_id, tile))
+        continue;
+      for (const auto& next : tile->GetDirectedEdges(node_id)) {
+        if (!reader_.GetGraphTile(next.endnode(), tile))
+          continue;
+        const auto* node = tile->node(next.endnode());
+        const auto* opp_edge = tile->directededge(node->edge_index() + next.opp_index());
+        if (costing->Allowed(opp_edge, tile, kReverseDisallowMask))
+          Enqueue(next.endnode(), costing, tile);
+      }
+    }
+    reach.inbound = std::min(Count(), cap_);
+    return reach;
+  }
+
+protected:
+  GraphReader& reader_;
+  uint32_t cap_;
+  std::unordered_set<uint64_t> queue_, done_;
+  size_t transitions_{};
+
+  uint32_t Count() const {
+    return queue_.size() + done_.size() - transitions_;
+  }
+
+  void Clear() {
+    queue_.clear();
+    done_.clear();
+    transitions_ = 0;
+  }
+
+  GraphId Pop() {
+    auto node_id = GraphId(*done_.insert(*queue_.begin()).first);
+    queue_.erase(queue_.begin());
+    return node_id;
+  }
+
+  void Enqueue(const GraphId& node_id,
+               const valhalla::sif::cost_ptr_t& costing,
+               graph_tile_ptr tile) {
+    if (!node_id.Is_Valid() || done_.find(node_id) != done_.cend())
+      return;
+    if (!reader_.GetGraphTile(node_id, tile))
+      return;
+    const auto* node = tile->node(node_id);
+    if (!costing->Allowed(node))
+      return;
+    queue_.insert(node_id);
+    for (const auto& transition : tile->GetNodeTransitions(node)) {
+      if (done_.find(transition.endnode()) != done_.cend())
+        continue;
+      queue_.insert(transition.endnode());
+      ++transitions_;
+    }
+  }
+};
+
+/**
+ * Computes the reaches of the edges of the tiles. Each thread pulls a tile of the queue and
+ * writes the reaches of its edges to their place in the table.
+ */
+void compute_reaches(const boost::property_tree::ptree& pt,
+                     const uint32_t cap,
+                     std::deque<tile_t>& tilequeue,
+                     std::mutex& lock,
+                     std::vector<reach_t>& reaches) {
+  thread_busy_time_t busy_time;
+  GraphReader reader(pt.get_child("mjolnir"));
+  valhalla::sif::CostFactory factory;
+  rapidjson::Document doc;
+  doc.SetObject();
+  std::vector<valhalla::sif::cost_ptr_t> costings;
+  for (const auto costing : kReachCostings) {
+    const auto key = "/costing_options/" + valhalla::Costing_Enum_Name(costing);
+    valhalla::CostingOptions options;
+    valhalla::sif::ParseCostingOptions(doc, key, &options, costing);
+    costings.push_back(factory.Create(options));
+  }
+  ReachCounter count_reach(reader, cap);
+
+  while (true) {
+    lock.lock();
+    if (tilequeue.empty()) {
+      lock.unlock();
+      break;
+    }
+    auto tile_info = tilequeue.front();
+    tilequeue.pop_front();
+    lock.unlock();
+
+    auto tile = reader.GetGraphTile(GraphId(tile_info.tile));
+    for (uint32_t i = 0; i < tile_info.edge_count; ++i) {
+      const auto* edge = tile->directededge(i);
+      auto* reach = reaches.data() + (static_cast<size_t>(tile_info.offset) + i) * costings.size();
+      for (const auto& costing : costings) {
+        *reach++ = count_reach(edge, tile, costing);
+      }
+    }
+    if (reader.OverCommitted()) {
+      reader.Trim();
+    }
+  }
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+void ReachBuilder::Build(const boost::property_tree::ptree& pt) {
+  const auto file = pt.get<std::string>("mjolnir.edge_reach");
+  const auto cap = std::min(pt.get<uint32_t>("mjolnir.edge_reach_cap", kDefaultReachCap),
+                            kMaxReachCap);
+  GraphReader reader(pt.get_child("mjolnir"));
+
+  // Only the road levels take part, the tiles are sorted by id and their edges numbered in order
+  std::vector<tile_t> tiles;
+  for (const auto& level : TileHierarchy::levels()) {
+    for (const auto& tile_id : reader.GetTileSet(level.level)) {
+      auto tile = reader.GetGraphTile(tile_id);
+      tiles.push_back({tile_id.value, 0, tile->header()->directededgecount()});
+      if (reader.OverCommitted()) {
+        reader.Trim();
+      }
+    }
+  }
+  reader.Clear();
+  std::sort(tiles.begin(), tiles.end(),
+            [](const tile_t& a, const tile_t& b) { return a.tile < b.tile; });
+  uint32_t edge_count = 0;
+  for (auto& tile : tiles) {
+    tile.offset = edge_count;
+    edge_count += tile.edge_count;
+  }
+
+  uint32_t nthreads =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency()));
+  LOG_INFO("Computing the reach of " + std::to_string(edge_count) + " edges up to " +
+           std::to_string(cap) + " nodes with " + std::to_string(nthreads) + " threads...");
+  std::vector<reach_t> reaches(static_cast<size_t>(edge_count) * kReachCostings.size());
+  std::deque<tile_t> tilequeue(tiles.cbegin(), tiles.cend());
+  std::mutex lock;
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < nthreads; ++i) {
+    threads.emplace_back(compute_reaches, std::cref(pt), cap, std::ref(tilequeue), std::ref(lock),
+                         std::ref(reaches));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::vector<uint8_t> costings;
+  for (const auto costing : kReachCostings) {
+    costings.push_back(static_cast<uint8_t>(costing));
+  }
+  EdgeReach(cap, std::move(costings), std::move(tiles), std::move(reaches)).Save(file);
+  LOG_INFO("Wrote edge reach to " + file);
+}
+
+} // namespace mjolnir
+} // namespace valhalla
@@ -3,6 +3,7 @@
 #include "mjolnir/dataquality.h"
 #include "mjolnir/graphtilebuilder.h"
 #include "mjolnir/osmrestriction.h"
+#include "mjolnir/util.h"
 
 #include <future>
 #include <queue>
@@ -325,6 +326,7 @@ void build(const std::string& complex_restriction_from_file,
            std::queue<GraphId>& tilequeue,
            std::mutex& lock,
            std::promise<Result>& result) {
+  thread_busy_time_t busy_time;
   sequence<OSMRestriction> complex_restrictions_from(complex_restriction_from_file, false);
   sequence<OSMRestriction> complex_restrictions_to(complex_restriction_to_file, false);
 
@@ -727,7 +729,7 @@ void RestrictionBuilder::Build(const boost::property_tree::ptree& pt,
   boost::property_tree::ptree hierarchy_properties = pt.get_child("mjolnir");
   GraphReader reader(hierarchy_properties);
   for (auto tl = TileHierarchy::levels().rbegin(); tl != TileHierarchy::levels().rend(); ++tl) {
-    // Create a randomized queue of tiles to work from
+    // Create a queue of tiles to work from, the biggest first and the rest in random order
     std::deque<GraphId> tempqueue;
     auto level_tiles = reader.GetTileSet(tl->level);
     for (const auto& tile_id : level_tiles) {
@@ -735,6 +737,7 @@ void RestrictionBuilder::Build(const boost::property_tree::ptree& pt,
     }
     std::random_device rd;
     std::shuffle(tempqueue.begin(), tempqueue.end(), std::mt19937(rd()));
+    sort_by_tile_size(reader.tile_dir(), tempqueue);
     std::queue<GraphId> tilequeue(tempqueue);
 
     // An atomic object we can use to do the synchronization
@@ -0,0 +1,232 @@
+#include "mjolnir/segmentindexbuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "baldr/graphreader.h"
+#include "baldr/segmentindex.h"
+#include "baldr/tilehierarchy.h"
+#include "midgard/logging.h"
+#include "midgard/util.h"
+#include "mjolnir/util.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+using bin_t = SegmentIndex::bin_t;
+using node_t = SegmentIndex::node_t;
+using edge_t = SegmentIndex::edge_t;
+using point_t = SegmentIndex::point_t;
+using box_t = SegmentIndex::box_t;
+
+// The hilbert curve covers a bin with a grid of this many cells on a side
+constexpr uint32_t kHilbertSide = 1 << 16;
+
+// The index of the bins of one tile, its offsets start at 0
+struct tile_index_t {
+  std::vector<bin_t> bins;
+  std::vector<node_t> nodes;
+  std::vector<edge_t> edges;
+  std::vector<point_t> points;
+};
+
+point_t to_point(const PointLL& ll) {
+  return {static_cast<int32_t>(std::round(ll.lng() * ENCODE_PRECISION)),
+          static_cast<int32_t>(std::round(ll.lat() * ENCODE_PRECISION))};
+}
+
+void expand(box_t& box, const point_t& point) {
+  box.min.lng = std::min(box.min.lng, point.lng);
+  box.min.lat = std::min(box.min.lat, point.lat);
+  box.max.lng = std::max(box.max.lng, point.lng);
+  box.max.lat = std::max(box.max.lat, point.lat);
+}
+
+void expand(box_t& box, const box_t& other) {
+  expand(box, other.min);
+  expand(box, other.max);
+}
+
+box_t empty_box() {
+  return {{INT32_MAX, INT32_MAX}, {INT32_MIN, INT32_MIN}};
+}
+
+/**
+ * Indexes the edges of a bin, they are sorted along a hilbert curve through the centers of their
+ * boxes and packed into nodes of SegmentIndex::kNodeSize edges.
+ */
+void index_bin(GraphReader& reader,
+               const graph_tile_ptr& bin_tile,
+               const uint32_t bin_index,
+               tile_index_t& index) {
+  std::vector<edge_t> edges;
+  std::vector<point_t> points;
+  box_t bin_box = empty_box();
+  graph_tile_ptr tile = bin_tile;
+  for (const auto edge_id : bin_tile->GetBin(bin_index)) {
+    if (!reader.GetGraphTile(edge_id, tile)) {
+      continue;
+    }
+    const auto shape = tile->edgeinfo(tile->directededge(edge_id)).shape();
+    edge_t edge{edge_id.value, empty_box(), static_cast<uint32_t>(points.size()),
+                static_cast<uint32_t>(shape.size())};
+    for (const auto& ll : shape) {
+      points.push_back(to_point(ll));
+      expand(edge.box, points.back());
+    }
+    // pad the box so a projection which rounds a hair outside of the shape is still inside of it
+    edge.box.min = {edge.box.min.lng - 1, edge.box.min.lat - 1};
+    edge.box.max = {edge.box.max.lng + 1, edge.box.max.lat + 1};
+    expand(bin_box, edge.box);
+    edges.push_back(edge);
+  }
+  if (edges.empty()) {
+    return;
+  }
+
+  // sort the edges along the curve through the centers of their boxes
+  auto cell = [](const double value, const int32_t min, const int32_t max) {
+    auto c = max > min ? (value - min) / (double(max) - min) * (kHilbertSide - 1) : 0.;
+    return static_cast<uint32_t>(std::min(std::max(c, 0.), kHilbertSide - 1.));
+  };
+  std::vector<uint64_t> distances;
+  distances.reserve(edges.size());
+  for (const auto& edge : edges) {
+    auto lng = (double(edge.box.min.lng) + edge.box.max.lng) / 2;
+    auto lat = (double(edge.box.min.lat) + edge.box.max.lat) / 2;
+    distances.push_back(hilbert_index(cell(lng, bin_box.min.lng, bin_box.max.lng),
+                                      cell(lat, bin_box.min.lat, bin_box.max.lat), kHilbertSide));
+  }
+  std::vector<uint32_t> order(edges.size());
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&distances](const uint32_t a, const uint32_t b) {
+    return distances[a] < distances[b];
+  });
+
+  // pack them up
+  bin_t bin{bin_tile->id().value, bin_index, static_cast<uint32_t>(index.nodes.size()), 0, 0};
+  for (size_t i = 0; i < order.size(); i += SegmentIndex::kNodeSize) {
+    node_t node{empty_box(), static_cast<uint32_t>(index.edges.size()), 0};
+    for (size_t j = i; j < std::min(i + SegmentIndex::kNodeSize, order.size()); ++j) {
+      auto edge = edges[order[j]];
+      const auto* shape = points.data() + edge.point_offset;
+      edge.point_offset = index.points.size();
+      index.points.insert(index.points.end(), shape, shape + edge.point_count);
+      expand(node.box, edge.box);
+      index.edges.push_back(edge);
+      ++node.edge_count;
+    }
+    index.nodes.push_back(node);
+    ++bin.node_count;
+  }
+  index.bins.push_back(bin);
+}
+
+/**
+ * Indexes the bins of the tiles. Each thread pulls a tile of the queue and writes the index of its
+ * bins to the place of the tile.
+ */
+void index_tiles(const boost::property_tree::ptree& pt,
+                 std::deque<size_t>& tilequeue,
+                 const std::vector<GraphId>& tiles,
+                 std::mutex& lock,
+                 std::vector<tile_index_t>& indexes) {
+  thread_busy_time_t busy_time;
+  GraphReader reader(pt.get_child("mjolnir"));
+  while (true) {
+    lock.lock();
+    if (tilequeue.empty()) {
+      lock.unlock();
+      break;
+    }
+    auto position = tilequeue.front();
+    tilequeue.pop_front();
+    lock.unlock();
+
+    auto tile = reader.GetGraphTile(tiles[position]);
+    for (uint32_t bin = 0; bin < kBinCount; ++bin) {
+      index_bin(reader, tile, bin, indexes[position]);
+    }
+    if (reader.OverCommitted()) {
+      reader.Trim();
+    }
+  }
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+void SegmentIndexBuilder::Build(const boost::property_tree::ptree& pt) {
+  const auto file = pt.get<std::string>("mjolnir.segment_index");
+
+  // The bins are only in the tiles of the most detailed level
+  std::vector<GraphId> tiles;
+  {
+    GraphReader reader(pt.get_child("mjolnir"));
+    auto tileset = reader.GetTileSet(TileHierarchy::levels().back().level);
+    tiles.assign(tileset.cbegin(), tileset.cend());
+  }
+  std::sort(tiles.begin(), tiles.end());
+
+  uint32_t nthreads =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency()));
+  LOG_INFO("Indexing the edge shapes of the bins of " + std::to_string(tiles.size()) +
+           " tiles with " + std::to_string(nthreads) + " threads...");
+  std::vector<tile_index_t> indexes(tiles.size());
+  std::deque<size_t> tilequeue;
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    tilequeue.push_back(i);
+  }
+  std::mutex lock;
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < nthreads; ++i) {
+    threads.emplace_back(index_tiles, std::cref(pt), std::ref(tilequeue), std::cref(tiles),
+                         std::ref(lock), std::ref(indexes));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // put the tiles one after the other
+  std::vector<bin_t> bins;
+  std::vector<node_t> nodes;
+  std::vector<edge_t> edges;
+  std::vector<point_t> points;
+  for (auto& index : indexes) {
+    for (auto bin : index.bins) {
+      bin.node_offset += nodes.size();
+      bins.push_back(bin);
+    }
+    for (auto node : index.nodes) {
+      node.edge_offset += edges.size();
+      nodes.push_back(node);
+    }
+    for (auto edge : index.edges) {
+      edge.point_offset += points.size();
+      edges.push_back(edge);
+    }
+    points.insert(points.end(), index.points.cbegin(), index.points.cend());
+    index = tile_index_t{};
+  }
+  LOG_INFO("Indexed " + std::to_string(edges.size()) + " edges in " + std::to_string(nodes.size()) +
+           " nodes");
+  SegmentIndex(std::move(bins), std::move(nodes), std::move(edges), std::move(points)).Save(file);
+  LOG_INFO("Wrote segment index to " + file);
+}
+
+} // namespace mjolnir
+} // namespace valhalla
@@ -3,12 +3,19 @@
 
 #include <boost/format.hpp>
 #include <boost/property_tree/ptree.hpp>
+#include <cstdio>
+#include <deque>
+#include <future>
 #include <iostream>
+#include <list>
 #include <map>
+#include <mutex>
 #include <ostream>
+#include <queue>
 #include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -17,6 +24,7 @@
 #include "baldr/graphreader.h"
 #include "baldr/graphtile.h"
 #include "baldr/tilehierarchy.h"
+#include "filesystem.h"
 #include "midgard/encoded.h"
 #include "midgard/logging.h"
 #include "midgard/pointll.h"
@@ -29,6 +37,9 @@ using namespace valhalla::mjolnir;
 
 namespace {
 
+// New tiles are written next to the tiles they replace with this appended to their names
+constexpr const char* kNewTileSuffix = ".shortcuts";
+
 // Simple structure to hold the 2 pair of directed edges at a node.
 // First edge in the pair is incoming and second is outgoing
 struct EdgePairs {
@@ -575,156 +586,176 @@ uint32_t AddShortcutEdges(GraphReader& reader,
   return shortcut_count;
 }
 
-// Form shortcuts for tiles in this level.
-uint32_t FormShortcuts(GraphReader& reader, const TileLevel& level) {
-  // Iterate through the tiles at this level (TODO - can we mark the tiles
-  // the tiles that shortcuts end within?)
-  reader.Clear();
+// Form shortcuts for the tiles of a level, taking them off of a shared queue. Shortcuts run across
+// tile boundaries so the new tiles are written next to the old ones rather than over them, that way
+// every thread only ever reads the tiles as they were before any shortcuts were added
+void FormShortcuts(const boost::property_tree::ptree& pt,
+                   std::queue<GraphId>& tilequeue,
+                   std::mutex& lock,
+                   std::promise<uint32_t>& result) {
+  thread_busy_time_t busy_time;
+  GraphReader reader(pt);
   bool added = false;
   uint32_t shortcut_count = 0;
-  uint32_t ntiles = level.tiles.TileCount();
-  uint32_t tile_level = (uint32_t)level.level;
   graph_tile_ptr tile;
-  for (uint32_t tileid = 0; tileid < ntiles; tileid++) {
-    // Get the graph tile. Skip if no tile exists (common case)
-    tile = reader.GetGraphTile(GraphId(tileid, tile_level, 0));
-    if (!tile) {
-      continue;
-    }
-
-    // Create GraphTileBuilder for the new tile
-    GraphId new_tile(tileid, tile_level, 0);
-    GraphTileBuilder tilebuilder(reader.tile_dir(), new_tile, false);
-
-    // Since the old tile is not serialized we must copy any data that is not
-    // dependent on edge Id into the new builders (e.g., node transitions)
-    if (tile->header()->transitioncount() > 0) {
-      for (uint32_t i = 0; i < tile->header()->transitioncount(); ++i) {
-        tilebuilder.transitions().emplace_back(std::move(*(tile->transition(i))));
+  try {
+    while (true) {
+      // Get the next tile off of the queue
+      lock.lock();
+      if (tilequeue.empty()) {
+        lock.unlock();
+        break;
       }
-    }
-
-    // Iterate through the nodes in the tile
-    GraphId node_id(tileid, tile_level, 0);
-    for (uint32_t n = 0; n < tile->header()->nodecount(); n++, ++node_id) {
-      // Get the node info, copy node index and count from old tile
-      NodeInfo nodeinfo = *(tile->node(node_id));
-      uint32_t old_edge_index = nodeinfo.edge_index();
-      uint32_t old_edge_count = nodeinfo.edge_count();
-
-      // Update node information
-      const auto& admin = tile->admininfo(nodeinfo.admin_index());
-      nodeinfo.set_edge_index(tilebuilder.directededges().size());
-      nodeinfo.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
-                                                    admin.country_iso(), admin.state_iso()));
-
-      // Current edge count
-      size_t edge_count = tilebuilder.directededges().size();
-
-      // Add shortcut edges first.
-      std::unordered_map<uint32_t, uint32_t> shortcuts;
-      shortcut_count += AddShortcutEdges(reader, tile, tilebuilder, node_id, old_edge_index,
-                                         old_edge_count, shortcuts);
-
-      // Copy the rest of the directed edges from this node
-      GraphId edgeid(tileid, tile_level, old_edge_index);
-      for (uint32_t i = 0; i < old_edge_count; i++, ++edgeid) {
-        // Copy the directed edge information and update end node,
-        // edge data offset, and opp_index
-        const DirectedEdge* directededge = tile->directededge(edgeid);
-        DirectedEdge newedge = *directededge;
-
-        // Get signs from the base directed edge
-        if (directededge->sign()) {
-          std::vector<SignInfo> signs = tile->GetSigns(edgeid.id());
-          if (signs.size() == 0) {
-            LOG_ERROR("Base edge should have signs, but none found");
-          }
-          tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
-        }
+      GraphId new_tile = tilequeue.front();
+      tilequeue.pop();
+      lock.unlock();
+
+      // Get the graph tile. Skip if no tile exists
+      tile = reader.GetGraphTile(new_tile);
+      if (!tile) {
+        continue;
+      }
+      uint32_t tileid = new_tile.tileid();
+      uint32_t tile_level = new_tile.level();
 
-        // Get turn lanes from the base directed edge
-        if (directededge->turnlanes()) {
-          uint32_t offset = tile->turnlanes_offset(edgeid.id());
-          tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
-        }
+        // Create GraphTileBuilder for the new tile
+        GraphTileBuilder tilebuilder(reader.tile_dir(), new_tile, false);
 
-        // Get access restrictions from the base directed edge. Add these to
-        // the list of access restrictions in the new tile. Update the
-        // edge index in the restriction to be the current directed edge Id
-        if (directededge->access_restriction()) {
-          auto restrictions = tile->GetAccessRestrictions(edgeid.id(), kAllAccess);
-          for (const auto& res : restrictions) {
-            tilebuilder.AddAccessRestriction(AccessRestriction(tilebuilder.directededges().size(),
-                                                               res.type(), res.modes(), res.value()));
+        // Since the old tile is not serialized we must copy any data that is not
+        // dependent on edge Id into the new builders (e.g., node transitions)
+        if (tile->header()->transitioncount() > 0) {
+          for (uint32_t i = 0; i < tile->header()->transitioncount(); ++i) {
+            tilebuilder.transitions().emplace_back(std::move(*(tile->transition(i))));
           }
         }
 
-        // Copy lane connectivity
-        if (directededge->laneconnectivity()) {
-          auto laneconnectivity = tile->GetLaneConnectivity(edgeid.id());
-          if (laneconnectivity.size() == 0) {
-            LOG_ERROR("Base edge should have lane connectivity, but none found");
+        // Iterate through the nodes in the tile
+        GraphId node_id(tileid, tile_level, 0);
+        for (uint32_t n = 0; n < tile->header()->nodecount(); n++, ++node_id) {
+          // Get the node info, copy node index and count from old tile
+          NodeInfo nodeinfo = *(tile->node(node_id));
+          uint32_t old_edge_index = nodeinfo.edge_index();
+          uint32_t old_edge_count = nodeinfo.edge_count();
+
+          // Update node information
+          const auto& admin = tile->admininfo(nodeinfo.admin_index());
+          nodeinfo.set_edge_index(tilebuilder.directededges().size());
+          nodeinfo.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
+                                                        admin.country_iso(), admin.state_iso()));
+
+          // Current edge count
+          size_t edge_count = tilebuilder.directededges().size();
+
+          // Add shortcut edges first.
+          std::unordered_map<uint32_t, uint32_t> shortcuts;
+          shortcut_count += AddShortcutEdges(reader, tile, tilebuilder, node_id, old_edge_index,
+                                             old_edge_count, shortcuts);
+
+          // Copy the rest of the directed edges from this node
+          GraphId edgeid(tileid, tile_level, old_edge_index);
+          for (uint32_t i = 0; i < old_edge_count; i++, ++edgeid) {
+            // Copy the directed edge information and update end node,
+            // edge data offset, and opp_index
+            const DirectedEdge* directededge = tile->directededge(edgeid);
+            DirectedEdge newedge = *directededge;
+
+            // Get signs from the base directed edge
+            if (directededge->sign()) {
+              std::vector<SignInfo> signs = tile->GetSigns(edgeid.id());
+              if (signs.size() == 0) {
+                LOG_ERROR("Base edge should have signs, but none found");
+              }
+              tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
+            }
+
+            // Get turn lanes from the base directed edge
+            if (directededge->turnlanes()) {
+              uint32_t offset = tile->turnlanes_offset(edgeid.id());
+              tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
+            }
+
+            // Get access restrictions from the base directed edge. Add these to
+            // the list of access restrictions in the new tile. Update the
+            // edge index in the restriction to be the current directed edge Id
+            if (directededge->access_restriction()) {
+              auto restrictions = tile->GetAccessRestrictions(edgeid.id(), kAllAccess);
+              for (const auto& res : restrictions) {
+                tilebuilder.AddAccessRestriction(
+                    AccessRestriction(tilebuilder.directededges().size(), res.type(), res.modes(),
+                                      res.value()));
+              }
+            }
+
+            // Copy lane connectivity
+            if (directededge->laneconnectivity()) {
+              auto laneconnectivity = tile->GetLaneConnectivity(edgeid.id());
+              if (laneconnectivity.size() == 0) {
+                LOG_ERROR("Base edge should have lane connectivity, but none found");
+              }
+              for (auto& lc : laneconnectivity) {
+                lc.set_to(tilebuilder.directededges().size());
+              }
+              tilebuilder.AddLaneConnectivity(laneconnectivity);
+            }
+
+            // Get edge info, shape, and names from the old tile and add
+            // to the new. Use prior edgeinfo offset as the key to make sure
+            // edges that have the same end nodes are differentiated (this
+            // should be a valid key since tile sizes aren't changed)
+            auto edgeinfo = tile->edgeinfo(directededge);
+            uint32_t edge_info_offset =
+                tilebuilder.AddEdgeInfo(directededge->edgeinfo_offset(), node_id,
+                                        directededge->endnode(), edgeinfo.wayid(),
+                                        edgeinfo.mean_elevation(), edgeinfo.bike_network(),
+                                        edgeinfo.speed_limit(), edgeinfo.encoded_shape(),
+                                        edgeinfo.GetNames(), edgeinfo.GetNames(true),
+                                        edgeinfo.GetTypes(), added);
+            newedge.set_edgeinfo_offset(edge_info_offset);
+
+            // Set the superseded mask - this is the shortcut mask that supersedes this edge
+            // (outbound from the node). Do not set (keep as 0) if maximum number of shortcuts
+            // from a node has been exceeded.
+            auto s = shortcuts.find(i);
+            uint32_t superseded_idx = (s != shortcuts.end()) ? s->second : 0;
+            if (superseded_idx <= kMaxShortcutsFromNode) {
+              newedge.set_superseded(superseded_idx);
+            }
+
+            // Add directed edge
+            tilebuilder.directededges().emplace_back(std::move(newedge));
           }
-          for (auto& lc : laneconnectivity) {
-            lc.set_to(tilebuilder.directededges().size());
-          }
-          tilebuilder.AddLaneConnectivity(laneconnectivity);
-        }
 
-        // Get edge info, shape, and names from the old tile and add
-        // to the new. Use prior edgeinfo offset as the key to make sure
-        // edges that have the same end nodes are differentiated (this
-        // should be a valid key since tile sizes aren't changed)
-        auto edgeinfo = tile->edgeinfo(directededge);
-        uint32_t edge_info_offset =
-            tilebuilder.AddEdgeInfo(directededge->edgeinfo_offset(), node_id, directededge->endnode(),
-                                    edgeinfo.wayid(), edgeinfo.mean_elevation(),
-                                    edgeinfo.bike_network(), edgeinfo.speed_limit(),
-                                    edgeinfo.encoded_shape(), edgeinfo.GetNames(),
-                                    edgeinfo.GetNames(true), edgeinfo.GetTypes(), added);
-        newedge.set_edgeinfo_offset(edge_info_offset);
-
-        // Set the superseded mask - this is the shortcut mask that supersedes this edge
-        // (outbound from the node). Do not set (keep as 0) if maximum number of shortcuts
-        // from a node has been exceeded.
-        auto s = shortcuts.find(i);
-        uint32_t superseded_idx = (s != shortcuts.end()) ? s->second : 0;
-        if (superseded_idx <= kMaxShortcutsFromNode) {
-          newedge.set_superseded(superseded_idx);
-        }
+          // Set the edge count for the new node
+          nodeinfo.set_edge_count(tilebuilder.directededges().size() - edge_count);
 
-        // Add directed edge
-        tilebuilder.directededges().emplace_back(std::move(newedge));
-      }
+          // Get named signs from the base node
+          if (nodeinfo.named_intersection()) {
 
-      // Set the edge count for the new node
-      nodeinfo.set_edge_count(tilebuilder.directededges().size() - edge_count);
+            std::vector<SignInfo> signs = tile->GetSigns(n, true);
+            if (signs.size() == 0) {
+              LOG_ERROR("Base node should have signs, but none found");
+            }
+            tilebuilder.AddSigns(tilebuilder.nodes().size(), signs);
+          }
+          tilebuilder.nodes().emplace_back(std::move(nodeinfo));
+        }
 
-      // Get named signs from the base node
-      if (nodeinfo.named_intersection()) {
+        // Store the new tile next to the old one, it replaces the old one once the level is done
+        tilebuilder.StoreTileData(kNewTileSuffix);
+        LOG_DEBUG((boost::format("ShortcutBuilder created tile %1%: %2% bytes") % tile %
+                   tilebuilder.header_builder().end_offset())
+                      .str());
 
-        std::vector<SignInfo> signs = tile->GetSigns(n, true);
-        if (signs.size() == 0) {
-          LOG_ERROR("Base node should have signs, but none found");
+        // Check if we need to clear the tile cache.
+        if (reader.OverCommitted()) {
+          reader.Trim();
         }
-        tilebuilder.AddSigns(tilebuilder.nodes().size(), signs);
       }
-      tilebuilder.nodes().emplace_back(std::move(nodeinfo));
-    }
-
-    // Store the new tile
-    tilebuilder.StoreTileData();
-    LOG_DEBUG((boost::format("ShortcutBuilder created tile %1%: %2% bytes") % tile %
-               tilebuilder.header_builder().end_offset())
-                  .str());
-
-    // Check if we need to clear the tile cache.
-    if (reader.OverCommitted()) {
-      reader.Trim();
-    }
+    result.set_value(shortcut_count);
+  } catch (...) {
+    // Pass the exception on to the main thread
+    result.set_exception(std::current_exception());
   }
-  return shortcut_count;
 }
 
 } // namespace
@@ -736,20 +767,58 @@ namespace mjolnir {
 // only connect to 2 edges on the hierarchy level, and have compatible
 // attributes. Shortcut edges are inserted before regular edges.
 void ShortcutBuilder::Build(const boost::property_tree::ptree& pt) {
-
-  // TODO: thread this. would need to make sure we dont make shortcuts
-  // across tile boundaries so that we are only messing with one tile
-  // in one thread at a time
-
   // Get GraphReader
-  GraphReader reader(pt.get_child("mjolnir"));
+  auto hierarchy_properties = pt.get_child("mjolnir");
+  GraphReader reader(hierarchy_properties);
+
+  // A place to hold worker threads and their results, exceptions or otherwise
+  std::vector<std::shared_ptr<std::thread>> threads(
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency())));
+  std::list<std::promise<uint32_t>> results;
+  std::mutex lock;
 
   auto tile_level = TileHierarchy::levels().rbegin();
   tile_level++;
   for (; tile_level != TileHierarchy::levels().rend(); ++tile_level) {
     // Create shortcuts on this level
     LOG_INFO("Creating shortcuts on level " + std::to_string(tile_level->level));
-    uint32_t count = FormShortcuts(reader, *tile_level);
+
+    // Create a queue of tiles to work from, the biggest first
+    std::deque<GraphId> tempqueue;
+    for (const auto& tile_id : reader.GetTileSet(tile_level->level)) {
+      tempqueue.emplace_back(tile_id);
+    }
+    sort_by_tile_size(reader.tile_dir(), tempqueue);
+    std::queue<GraphId> tilequeue(tempqueue);
+
+    // Start the threads and wait for them to finish up their work
+    results.clear();
+    for (auto& thread : threads) {
+      results.emplace_back();
+      thread.reset(new std::thread(FormShortcuts, std::cref(hierarchy_properties),
+                                   std::ref(tilequeue), std::ref(lock), std::ref(results.back())));
+    }
+    for (auto& thread : threads) {
+      thread->join();
+    }
+
+    // If something bad went down this will rethrow it
+    uint32_t count = 0;
+    for (auto& result : results) {
+      count += result.get_future().get();
+    }
+
+    // Now that nothing reads the old tiles anymore the new ones replace them
+    for (const auto& tile_id : tempqueue) {
+      std::string file_location = reader.tile_dir() + filesystem::path::preferred_separator +
+                                  GraphTile::FileSuffix(tile_id);
+      std::string new_file_location = file_location + kNewTileSuffix;
+      if (filesystem::exists(new_file_location) &&
+          std::rename(new_file_location.c_str(), file_location.c_str())) {
+        throw std::runtime_error("Failed to replace tile " + file_location);
+      }
+    }
     LOG_INFO("Finished with " + std::to_string(count) + " shortcuts");
   }
 }
@@ -7,6 +7,7 @@
 #include <boost/format.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <fstream>
+#include <iterator>
 #include <iostream>
 #include <map>
 #include <ostream>
@@ -30,29 +31,35 @@ using namespace valhalla::baldr;
 using namespace valhalla::mjolnir;
 
 namespace {
-// merges contents of sets and maps that do not have overlapping keys
-template <class T> T merge(T& a, T b) {
-  T tmp(a);
-  tmp.insert(b.begin(), b.end());
-  return tmp;
-}
-
-// accumulates counts into a new map for maps that have counts associated with its keys
-template <class T> T merge_counts(T& a, T b) {
-  T tmp(a);
-  for (auto it = b.begin(); it != b.end(); it++) {
-    tmp[it->first] += it->second;
+// moves the contents of sets and maps that do not have overlapping keys into the first one
+template <class T> void merge(T& a, T&& b) {
+  if (a.empty()) {
+    a = std::move(b);
+    return;
+  }
+  a.insert(std::make_move_iterator(b.begin()), std::make_move_iterator(b.end()));
+}
+
+// accumulates counts into the first map for maps that have counts associated with its keys
+template <class T> void merge_counts(T& a, const T& b) {
+  if (a.empty()) {
+    a = b;
+    return;
+  }
+  for (const auto& kv : b) {
+    a[kv.first] += kv.second;
   }
-  return tmp;
 }
 
 // merge two hashes by key and merge underlying hash buckets
-template <class T> T deep_merge_counts(T& a, T const& b) {
-  T tmp(a);
-  for (auto it = b.begin(); it != b.end(); it++) {
-    tmp[it->first] = merge_counts(tmp[it->first], it->second);
+template <class T> void deep_merge_counts(T& a, T&& b) {
+  if (a.empty()) {
+    a = std::move(b);
+    return;
+  }
+  for (auto& kv : b) {
+    merge_counts(a[kv.first], kv.second);
   }
-  return tmp;
 }
 
 } // namespace
@@ -393,56 +400,57 @@ const std::unordered_map<std::string, size_t>& statistics::get_ctry_exit_count()
   return ctry_exit_count;
 }
 
-void statistics::add(const statistics& stats) {
+void statistics::add(statistics&& stats) {
+  // the statistics of the threads are moved rather than copied into the first one merged
   // Combine ids and isos
-  tile_ids = merge(tile_ids, stats.get_ids());
-  iso_codes = merge(iso_codes, stats.get_isos());
+  merge(tile_ids, std::move(stats.tile_ids));
+  merge(iso_codes, std::move(stats.iso_codes));
 
   // Combine tile statistics
-  tile_areas = merge(tile_areas, stats.get_tile_areas());
-  tile_geometries = merge(tile_geometries, stats.get_tile_geometries());
-  tile_lengths = merge(tile_lengths, stats.get_tile_lengths());
-  tile_one_way = merge(tile_one_way, stats.get_tile_one_way());
-  tile_speed_info = merge(tile_speed_info, stats.get_tile_speed_info());
-  tile_int_edges = merge(tile_int_edges, stats.get_tile_int_edges());
-  tile_named = merge(tile_named, stats.get_tile_named());
-  tile_hazmat = merge(tile_hazmat, stats.get_tile_hazmat());
-  tile_truck_route = merge(tile_truck_route, stats.get_tile_truck_route());
-  tile_height = merge(tile_height, stats.get_tile_height());
-  tile_width = merge(tile_width, stats.get_tile_width());
-  tile_length = merge(tile_length, stats.get_tile_length());
-  tile_weight = merge(tile_weight, stats.get_tile_weight());
-  tile_axle_load = merge(tile_axle_load, stats.get_tile_axle_load());
+  merge(tile_areas, std::move(stats.tile_areas));
+  merge(tile_geometries, std::move(stats.tile_geometries));
+  merge(tile_lengths, std::move(stats.tile_lengths));
+  merge(tile_one_way, std::move(stats.tile_one_way));
+  merge(tile_speed_info, std::move(stats.tile_speed_info));
+  merge(tile_int_edges, std::move(stats.tile_int_edges));
+  merge(tile_named, std::move(stats.tile_named));
+  merge(tile_hazmat, std::move(stats.tile_hazmat));
+  merge(tile_truck_route, std::move(stats.tile_truck_route));
+  merge(tile_height, std::move(stats.tile_height));
+  merge(tile_width, std::move(stats.tile_width));
+  merge(tile_length, std::move(stats.tile_length));
+  merge(tile_weight, std::move(stats.tile_weight));
+  merge(tile_axle_load, std::move(stats.tile_axle_load));
 
   // Combine country statistics
-  country_lengths = deep_merge_counts(country_lengths, stats.get_country_lengths());
-  country_one_way = deep_merge_counts(country_one_way, stats.get_country_one_way());
-  country_speed_info = deep_merge_counts(country_speed_info, stats.get_country_speed_info());
-  country_int_edges = deep_merge_counts(country_int_edges, stats.get_country_int_edges());
-  country_named = deep_merge_counts(country_named, stats.get_country_named());
-  country_hazmat = deep_merge_counts(country_hazmat, stats.get_country_hazmat());
-  country_truck_route = deep_merge_counts(country_truck_route, stats.get_country_truck_route());
-  country_height = deep_merge_counts(country_height, stats.get_country_height());
-  country_width = deep_merge_counts(country_width, stats.get_country_width());
-  country_length = deep_merge_counts(country_length, stats.get_country_length());
-  country_weight = deep_merge_counts(country_weight, stats.get_country_weight());
-  country_axle_load = deep_merge_counts(country_axle_load, stats.get_country_axle_load());
+  deep_merge_counts(country_lengths, std::move(stats.country_lengths));
+  deep_merge_counts(country_one_way, std::move(stats.country_one_way));
+  deep_merge_counts(country_speed_info, std::move(stats.country_speed_info));
+  deep_merge_counts(country_int_edges, std::move(stats.country_int_edges));
+  deep_merge_counts(country_named, std::move(stats.country_named));
+  deep_merge_counts(country_hazmat, std::move(stats.country_hazmat));
+  deep_merge_counts(country_truck_route, std::move(stats.country_truck_route));
+  deep_merge_counts(country_height, std::move(stats.country_height));
+  deep_merge_counts(country_width, std::move(stats.country_width));
+  deep_merge_counts(country_length, std::move(stats.country_length));
+  deep_merge_counts(country_weight, std::move(stats.country_weight));
+  deep_merge_counts(country_axle_load, std::move(stats.country_axle_load));
 
   // Combine exit statistics
-  tile_exit_signs = merge_counts(tile_exit_signs, stats.get_tile_exit_info());
-  ctry_exit_signs = merge_counts(ctry_exit_signs, stats.get_ctry_exit_info());
+  merge_counts(tile_exit_signs, stats.tile_exit_signs);
+  merge_counts(ctry_exit_signs, stats.ctry_exit_signs);
 
-  tile_exit_count = merge_counts(tile_exit_count, stats.get_tile_exit_count());
-  ctry_exit_count = merge_counts(ctry_exit_count, stats.get_ctry_exit_count());
+  merge_counts(tile_exit_count, stats.tile_exit_count);
+  merge_counts(ctry_exit_count, stats.ctry_exit_count);
 
-  tile_fork_signs = merge_counts(tile_fork_signs, stats.get_tile_fork_info());
-  ctry_fork_signs = merge_counts(ctry_fork_signs, stats.get_ctry_fork_info());
+  merge_counts(tile_fork_signs, stats.tile_fork_signs);
+  merge_counts(ctry_fork_signs, stats.ctry_fork_signs);
 
-  tile_fork_count = merge_counts(tile_fork_count, stats.get_tile_fork_count());
-  ctry_fork_count = merge_counts(ctry_fork_count, stats.get_ctry_fork_count());
+  merge_counts(tile_fork_count, stats.tile_fork_count);
+  merge_counts(ctry_fork_count, stats.ctry_fork_count);
 
   // Combine roulette data
-  roulette_data.Add(stats.roulette_data);
+  roulette_data.Add(std::move(stats.roulette_data));
 }
 
 statistics::RouletteData::RouletteData() : shape_bb(), way_IDs(), way_shapes(), unroutable_nodes() {
@@ -462,11 +470,11 @@ void statistics::RouletteData::AddNode(const PointLL& p) {
   unroutable_nodes.insert(p);
 }
 
-void statistics::RouletteData::Add(const RouletteData& rd) {
-  way_IDs = merge(way_IDs, rd.way_IDs);
-  way_shapes = merge(way_shapes, rd.way_shapes);
-  shape_bb = merge(shape_bb, rd.shape_bb);
-  unroutable_nodes = merge(unroutable_nodes, rd.unroutable_nodes);
+void statistics::RouletteData::Add(RouletteData&& rd) {
+  merge(way_IDs, std::move(rd.way_IDs));
+  merge(way_shapes, std::move(rd.way_shapes));
+  merge(shape_bb, std::move(rd.shape_bb));
+  merge(unroutable_nodes, std::move(rd.unroutable_nodes));
 }
 
 void statistics::RouletteData::GenerateTasks(const boost::property_tree::ptree& /*pt*/) const {
@@ -118,7 +118,7 @@ public:
 
     void AddNode(const PointLL& p);
 
-    void Add(const RouletteData& rd);
+    void Add(RouletteData&& rd);
 
     void GenerateTasks(const boost::property_tree::ptree& pt) const;
   } roulette_data;
@@ -276,7 +276,7 @@ public:
 
   const std::unordered_map<uint64_t, AABB2<PointLL>>& get_tile_geometries() const;
 
-  void add(const statistics& stats);
+  void add(statistics&& stats);
 
   void build_db();
 
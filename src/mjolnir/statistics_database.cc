@@ -1,5 +1,7 @@
 #include "statistics.h"
+#include <algorithm>
 #include <cstdint>
+#include <vector>
 
 #include "filesystem.h"
 #include "midgard/logging.h"
@@ -52,6 +54,17 @@ void statistics::build_db() {
     return;
   }
 
+  // The database is written from scratch and written again if that fails halfway, so it goes
+  // without a journal and without waiting on the disk after every transaction
+  sql = "PRAGMA synchronous = OFF; PRAGMA journal_mode = OFF";
+  ret = sqlite3_exec(db_handle, sql.c_str(), NULL, NULL, &err_msg);
+  if (ret != SQLITE_OK) {
+    LOG_ERROR("Error: " + std::string(err_msg));
+    sqlite3_free(err_msg);
+    sqlite3_close(db_handle);
+    return;
+  }
+
   LOG_INFO("Creating tables");
 
   sqlite3_stmt* stmt = nullptr;
@@ -306,6 +319,10 @@ void statistics::insert_tile_data(sqlite3* db_handle, sqlite3_stmt* stmt) {
   char* err_msg = NULL;
   std::string sql;
 
+  // the rows go in by tile id so they are appended to the tables rather than put in between
+  std::vector<uint64_t> sorted_tile_ids(tile_ids.cbegin(), tile_ids.cend());
+  std::sort(sorted_tile_ids.begin(), sorted_tile_ids.end());
+
   // Begin the prepared statements for tiledata
   ret = sqlite3_exec(db_handle, "BEGIN", NULL, NULL, &err_msg);
   if (ret != SQLITE_OK) {
@@ -316,7 +333,7 @@ void statistics::insert_tile_data(sqlite3* db_handle, sqlite3_stmt* stmt) {
   }
   sql = "INSERT INTO tiledata (tileid, tilearea, totalroadlen, motorway, pmary, secondary, "
         "tertiary, trunk, residential, unclassified, serviceother, geom) ";
-  sql += "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, GeomFromText(?, 4326))";
+  sql += "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, BuildMbr(?, ?, ?, ?, 4326))";
   ret = sqlite3_prepare_v2(db_handle, sql.c_str(), strlen(sql.c_str()), &stmt, NULL);
   if (ret != SQLITE_OK) {
     LOG_ERROR("SQL error: " + sql);
@@ -326,7 +343,7 @@ void statistics::insert_tile_data(sqlite3* db_handle, sqlite3_stmt* stmt) {
   }
 
   // Fill DB with the tile statistics
-  for (auto tileid : tile_ids) {
+  for (auto tileid : sorted_tile_ids) {
     uint8_t index = 1;
     sqlite3_reset(stmt);
     sqlite3_clear_bindings(stmt);
@@ -345,20 +362,16 @@ void statistics::insert_tile_data(sqlite3* db_handle, sqlite3_stmt* stmt) {
     ++index;
     // Individual Road Class Lengths
     for (auto rclass : rclasses) {
-      const std::string& roadStr = roadClassToString.at(rclass);
       sqlite3_bind_double(stmt, index, tile_lengths[tileid][rclass]);
       ++index;
     }
     // Use tile bounding box corners to make a polygon
-    if (tile_geometries.find(tileid) != tile_geometries.end()) {
-      auto maxx = std::to_string(tile_geometries.at(tileid).maxx());
-      auto minx = std::to_string(tile_geometries.at(tileid).minx());
-      auto maxy = std::to_string(tile_geometries.at(tileid).maxy());
-      auto miny = std::to_string(tile_geometries.at(tileid).miny());
-      std::string polyWKT = "POLYGON ((" + minx + " " + miny + ", " + minx + " " + maxy + ", " +
-                            maxx + " " + maxy + ", " + maxx + " " + miny + ", " + minx + " " + miny +
-                            "))";
-      sqlite3_bind_text(stmt, index, polyWKT.c_str(), polyWKT.length(), SQLITE_STATIC);
+    auto geometry = tile_geometries.find(tileid);
+    if (geometry != tile_geometries.end()) {
+      sqlite3_bind_double(stmt, index++, geometry->second.minx());
+      sqlite3_bind_double(stmt, index++, geometry->second.miny());
+      sqlite3_bind_double(stmt, index++, geometry->second.maxx());
+      sqlite3_bind_double(stmt, index++, geometry->second.maxy());
     } else {
       LOG_ERROR("Geometry for tile " + std::to_string(tileid) + " not found.");
     }
@@ -397,7 +410,7 @@ void statistics::insert_tile_data(sqlite3* db_handle, sqlite3_stmt* stmt) {
   }
 
   // Fill the roadclass stats for tiles
-  for (auto tileid : tile_ids) {
+  for (auto tileid : sorted_tile_ids) {
     for (auto rclass : rclasses) {
       uint8_t index = 1;
       sqlite3_reset(stmt);
@@ -457,7 +470,7 @@ void statistics::insert_tile_data(sqlite3* db_handle, sqlite3_stmt* stmt) {
   }
 
   // Fill the truck roadclass stats for tiles
-  for (auto tileid : tile_ids) {
+  for (auto tileid : sorted_tile_ids) {
     for (auto rclass : rclasses) {
       uint8_t index = 1;
       sqlite3_reset(stmt);
@@ -0,0 +1,122 @@
+#include "mjolnir/trafficupdater.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "baldr/graphid.h"
+#include "midgard/logging.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+
+namespace valhalla {
+namespace mjolnir {
+
+TrafficUpdater::TrafficUpdater(const std::string& traffic_extract) {
+  // find the members read only and then map the same bytes again so we can write to them
+  tar archive(traffic_extract);
+  mm_.map(traffic_extract, archive.mm.size(), POSIX_MADV_NORMAL, false);
+
+  for (const auto& member : archive.contents) {
+    if (member.second.second < sizeof(TrafficTileHeader)) {
+      continue;
+    }
+    auto* header = reinterpret_cast<volatile TrafficTileHeader*>(
+        mm_.get() + (member.second.first - archive.mm.get()));
+    // we dont write into tiles we dont understand or whose speeds dont fit in the member
+    if (header->traffic_tile_version != TRAFFIC_TILE_VERSION ||
+        sizeof(TrafficTileHeader) + header->directed_edge_count * sizeof(TrafficSpeed) >
+            member.second.second) {
+      LOG_WARN("Skipping invalid traffic tile " + member.first + " in " + traffic_extract);
+      continue;
+    }
+    tiles_.emplace_back(GraphId(header->tile_id).Tile_Base().value, header);
+  }
+  std::sort(tiles_.begin(), tiles_.end(),
+            [](const decltype(tiles_)::value_type& a, const decltype(tiles_)::value_type& b) {
+              return a.first < b.first;
+            });
+
+  if (tiles_.empty()) {
+    LOG_WARN("No traffic tiles found in " + traffic_extract);
+  }
+}
+
+std::vector<TrafficRecord> TrafficUpdater::ReadFeed(const std::string& feed_file) {
+  std::ifstream file(feed_file, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    throw std::runtime_error("Unable to open: " + feed_file);
+  }
+  auto size = static_cast<size_t>(file.tellg());
+  if (size % sizeof(TrafficRecord) != 0) {
+    throw std::runtime_error("Traffic feed " + feed_file + " has a partial record");
+  }
+  std::vector<TrafficRecord> records(size / sizeof(TrafficRecord));
+  file.seekg(0);
+  if (!file.read(reinterpret_cast<char*>(records.data()), size)) {
+    throw std::runtime_error("Unable to read: " + feed_file);
+  }
+  return records;
+}
+
+volatile TrafficTileHeader* TrafficUpdater::find(uint64_t tile_id) const {
+  auto tile = std::lower_bound(tiles_.cbegin(), tiles_.cend(), tile_id,
+                               [](const decltype(tiles_)::value_type& t, uint64_t id) {
+                                 return t.first < id;
+                               });
+  return tile != tiles_.cend() && tile->first == tile_id ? tile->second : nullptr;
+}
+
+size_t TrafficUpdater::Update(std::vector<TrafficRecord>& records, uint64_t timestamp) {
+  // the tile is in the high bits of the id so this groups the records by tile as well
+  std::stable_sort(records.begin(), records.end(),
+                   [](const TrafficRecord& a, const TrafficRecord& b) {
+                     return a.edge_id < b.edge_id;
+                   });
+
+  size_t written = 0;
+  for (auto record = records.cbegin(); record != records.cend();) {
+    // all the records of this tile
+    auto tile_id = GraphId(record->edge_id).Tile_Base().value;
+    auto end = std::find_if(record, records.cend(), [tile_id](const TrafficRecord& r) {
+      return GraphId(r.edge_id).Tile_Base().value != tile_id;
+    });
+    auto* header = find(tile_id);
+    if (header == nullptr) {
+      record = end;
+      continue;
+    }
+
+    // let readers know the tile is changing before touching any of its speeds
+    uint32_t generation = header->generation;
+    header->generation = generation | 1;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto* speeds = reinterpret_cast<volatile uint64_t*>(header + 1);
+    for (; record != end; ++record) {
+      // of the records of an edge only the last one is written
+      auto next = record + 1;
+      auto index = GraphId(record->edge_id).id();
+      if ((next != end && next->edge_id == record->edge_id) ||
+          index >= header->directed_edge_count) {
+        continue;
+      }
+      uint64_t speed;
+      std::memcpy(&speed, &record->speed, sizeof(speed));
+      speeds[index] = speed;
+      ++written;
+    }
+
+    // and that its done once they all are
+    std::atomic_thread_fence(std::memory_order_release);
+    header->last_update = timestamp;
+    header->generation = (generation | 1) + 1;
+  }
+  return written;
+}
+
+} // namespace mjolnir
+} // namespace valhalla
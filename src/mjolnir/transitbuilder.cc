@@ -23,6 +23,7 @@
 #include "midgard/distanceapproximator.h"
 #include "midgard/logging.h"
 #include "midgard/util.h"
+#include "mjolnir/util.h"
 
 using namespace valhalla::midgard;
 using namespace valhalla::baldr;
@@ -571,6 +572,7 @@ void build(const boost::property_tree::ptree& pt,
            std::unordered_set<GraphId>::const_iterator tile_start,
            std::unordered_set<GraphId>::const_iterator tile_end,
            std::promise<builder_stats>& results) {
+  thread_busy_time_t busy_time;
   // GraphReader for local level and for transit level.
   GraphReader reader_local_level(pt);
   GraphReader reader_transit_level(pt);
@@ -1,21 +1,31 @@
 #include "mjolnir/util.h"
 
+#include "baldr/graphtile.h"
+#include "baldr/json.h"
 #include "baldr/tilehierarchy.h"
 #include "filesystem.h"
 #include "midgard/aabb2.h"
 #include "midgard/logging.h"
 #include "midgard/point2.h"
 #include "midgard/polyline2.h"
+#include "midgard/util.h"
 #include "mjolnir/bssbuilder.h"
+#include "mjolnir/componentbuilder.h"
+#include "mjolnir/contractionbuilder.h"
 #include "mjolnir/elevationbuilder.h"
 #include "mjolnir/graphbuilder.h"
 #include "mjolnir/graphenhancer.h"
 #include "mjolnir/graphfilter.h"
+#include "mjolnir/graphreorderer.h"
 #include "mjolnir/graphvalidator.h"
 #include "mjolnir/hierarchybuilder.h"
+#include "mjolnir/landmarkbuilder.h"
 #include "mjolnir/osmpbfparser.h"
 #include "mjolnir/pbfgraphparser.h"
+#include "mjolnir/reachbuilder.h"
 #include "mjolnir/restrictionbuilder.h"
+#include "mjolnir/extractbuilder.h"
+#include "mjolnir/segmentindexbuilder.h"
 #include "mjolnir/shortcutbuilder.h"
 #include "mjolnir/transitbuilder.h"
 
@@ -23,6 +33,16 @@
 #include <boost/algorithm/string/split.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
 using namespace valhalla::midgard;
 
 namespace {
@@ -42,11 +62,178 @@ const std::string old_to_new_file = "old_nodes_to_new_nodes.bin";
 const std::string intersections_file = "intersections.bin";
 const std::string shapes_file = "shapes.bin";
 
+namespace json = valhalla::baldr::json;
+
+// The cpu time, user and system, of the calling thread or of the whole process, 0 if its not known
+double cpu_seconds(bool thread) {
+#ifdef _WIN32
+  return 0;
+#else
+#ifdef RUSAGE_THREAD
+  int who = thread ? RUSAGE_THREAD : RUSAGE_SELF;
+#else
+  if (thread) {
+    return 0;
+  }
+  int who = RUSAGE_SELF;
+#endif
+  struct rusage usage {};
+  if (getrusage(who, &usage) != 0) {
+    return 0;
+  }
+  return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec +
+         usage.ru_stime.tv_usec / 1e6;
+#endif
+}
+
+// The busy times of the worker threads which finished during the stage that is running
+std::mutex busy_times_lock;
+std::vector<double> busy_times;
+
+// What the process used so far, the difference between two of these is what a stage used
+struct usage_t {
+  std::chrono::steady_clock::time_point when;
+  double cpu;
+  // bytes asked for by read/write calls whether or not they came from/went to the page cache
+  uint64_t bytes_read;
+  uint64_t bytes_written;
+  // bytes actually fetched from/sent to storage, includes the page faults of mapped files
+  uint64_t storage_bytes_read;
+  uint64_t storage_bytes_written;
+
+  static usage_t now() {
+    usage_t usage{std::chrono::steady_clock::now(), cpu_seconds(false), 0, 0, 0, 0};
+    std::ifstream io("/proc/self/io");
+    std::string name;
+    uint64_t value;
+    while (io >> name >> value) {
+      if (name == "rchar:") {
+        usage.bytes_read = value;
+      } else if (name == "wchar:") {
+        usage.bytes_written = value;
+      } else if (name == "read_bytes:") {
+        usage.storage_bytes_read = value;
+      } else if (name == "write_bytes:") {
+        usage.storage_bytes_written = value;
+      }
+    }
+    return usage;
+  }
+};
+
+// The most memory the process had resident since it started or since the peak was last reset
+uint64_t peak_memory_bytes() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) {
+      return std::stoull(line.substr(6)) * 1024;
+    }
+  }
+  return 0;
+}
+
+// Forgets the peak memory so the next stage measures its own rather than that of the whole build
+void reset_peak_memory() {
+#ifdef __linux__
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5";
+#endif
+}
+
+// Measures every stage of the build from the end of the stage before it to its own end, logs the
+// peak memory of each one and writes all of it as json once the build is done
+class build_profile_t {
+public:
+  build_profile_t() : start_(usage_t::now()), last_(start_), stages_(json::array({})) {
+    reset_peak_memory();
+    std::lock_guard<std::mutex> lock(busy_times_lock);
+    busy_times.clear();
+  }
+
+  /**
+   * Records what the stage used since the stage before it finished
+   * @param stage  the stage which just finished
+   */
+  void finish(valhalla::mjolnir::BuildStage stage) {
+    auto usage = usage_t::now();
+    auto peak = peak_memory_bytes();
+    if (peak > 0) {
+      LOG_INFO("Peak memory of " + valhalla::mjolnir::to_string(stage) + ": " +
+               std::to_string(peak / (1024 * 1024)) + "MB");
+    }
+    reset_peak_memory();
+
+    // the busy times of the threads of this stage, the busiest first
+    std::vector<double> threads;
+    {
+      std::lock_guard<std::mutex> lock(busy_times_lock);
+      threads.swap(busy_times);
+    }
+    std::sort(threads.begin(), threads.end(), std::greater<double>());
+    auto thread_busy_seconds = json::array({});
+    for (auto busy : threads) {
+      thread_busy_seconds->emplace_back(json::fixed_t{busy, 3});
+    }
+
+    double wall = std::chrono::duration<double>(usage.when - last_.when).count();
+    stages_->emplace_back(json::map({
+        {"stage", valhalla::mjolnir::to_string(stage)},
+        {"wall_seconds", json::fixed_t{wall, 3}},
+        {"cpu_seconds", json::fixed_t{usage.cpu - last_.cpu, 3}},
+        {"peak_memory_bytes", peak},
+        {"bytes_read", usage.bytes_read - last_.bytes_read},
+        {"bytes_written", usage.bytes_written - last_.bytes_written},
+        {"storage_bytes_read", usage.storage_bytes_read - last_.storage_bytes_read},
+        {"storage_bytes_written", usage.storage_bytes_written - last_.storage_bytes_written},
+        {"thread_busy_seconds", thread_busy_seconds},
+    }));
+    last_ = usage;
+  }
+
+  /**
+   * Writes the stages measured so far along with the totals of the whole build
+   * @param filename  where to write the json to
+   */
+  void write(const std::string& filename) const {
+    auto usage = usage_t::now();
+    double wall = std::chrono::duration<double>(usage.when - start_.when).count();
+    auto profile = json::map({
+        {"wall_seconds", json::fixed_t{wall, 3}},
+        {"cpu_seconds", json::fixed_t{usage.cpu - start_.cpu, 3}},
+        {"bytes_read", usage.bytes_read - start_.bytes_read},
+        {"bytes_written", usage.bytes_written - start_.bytes_written},
+        {"stages", stages_},
+    });
+    std::ofstream file(filename, std::ios::out | std::ios::trunc);
+    file << *profile << std::endl;
+    if (!file) {
+      LOG_WARN("Could not write build profile to " + filename);
+    } else {
+      LOG_INFO("Wrote build profile to " + filename);
+    }
+  }
+
+protected:
+  usage_t start_;
+  usage_t last_;
+  json::ArrayPtr stages_;
+};
+
 } // namespace
 
 namespace valhalla {
 namespace mjolnir {
 
+thread_busy_time_t::thread_busy_time_t() : start_(cpu_seconds(true)) {
+}
+
+thread_busy_time_t::~thread_busy_time_t() {
+  auto busy = cpu_seconds(true) - start_;
+  std::lock_guard<std::mutex> lock(busy_times_lock);
+  busy_times.push_back(busy);
+}
+
 /**
  * Splits a tag into a vector of strings.  Delim defaults to ;
  */
@@ -164,11 +351,30 @@ bool load_spatialite(sqlite3* db_handle) {
   return false;
 }
 
+void sort_by_tile_size(const std::string& tile_dir, std::deque<baldr::GraphId>& tiles) {
+  std::vector<std::pair<uint64_t, baldr::GraphId>> sizes;
+  sizes.reserve(tiles.size());
+  for (const auto& tile : tiles) {
+    auto file = tile_dir + filesystem::path::preferred_separator + baldr::GraphTile::FileSuffix(tile);
+    struct stat s;
+    sizes.emplace_back(stat(file.c_str(), &s) == 0 ? s.st_size : 0, tile);
+  }
+  std::stable_sort(sizes.begin(), sizes.end(),
+                   [](const std::pair<uint64_t, baldr::GraphId>& a,
+                      const std::pair<uint64_t, baldr::GraphId>& b) { return a.first > b.first; });
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    tiles[i] = sizes[i].second;
+  }
+}
+
 bool build_tile_set(const boost::property_tree::ptree& original_config,
                     const std::vector<std::string>& input_files,
                     const BuildStage start_stage,
                     const BuildStage end_stage,
                     const bool release_osmpbf_memory) {
+  // Measure each stage as it finishes
+  build_profile_t profile;
+
   auto remove_temp_file = [](const std::string& fname) {
     if (filesystem::exists(fname)) {
       filesystem::remove(fname);
@@ -180,6 +386,7 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
   config.get_child("mjolnir").erase("tile_extract");
   config.get_child("mjolnir").erase("tile_url");
   config.get_child("mjolnir").erase("traffic_extract");
+  config.get_child("mjolnir").erase("predicted_speeds_extract");
 
   // Get the tile directory (make sure it ends with the preferred separator
   std::string tile_dir = config.get<std::string>("mjolnir.tile_dir");
@@ -209,6 +416,7 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
 
     // Create the directory if it does not exist
     filesystem::create_directories(tile_dir);
+    profile.finish(BuildStage::kInitialize);
   }
 
   // Set up the temporary (*.bin) files used during processing
@@ -242,6 +450,7 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
     if (end_stage <= BuildStage::kEnhance) {
       osm_data.write_to_temp_files(tile_dir);
     }
+    profile.finish(BuildStage::kParseWays);
   }
 
   // Parse OSM data
@@ -261,6 +470,7 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
     if (end_stage <= BuildStage::kEnhance) {
       osm_data.write_to_temp_files(tile_dir);
     }
+    profile.finish(BuildStage::kParseRelations);
   }
 
   // Parse OSM data
@@ -279,6 +489,7 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
     if (end_stage <= BuildStage::kEnhance) {
       osm_data.write_to_temp_files(tile_dir);
     }
+    profile.finish(BuildStage::kParseNodes);
   }
 
   // Construct edges
@@ -293,6 +504,7 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
     // Output manifest
     TileManifest manifest{tiles};
     manifest.LogToFile(tile_manifest);
+    profile.finish(BuildStage::kConstructEdges);
   }
 
   // Build Valhalla routing tiles
@@ -313,6 +525,7 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
     // Build the graph using the OSMNodes and OSMWays from the parser
     GraphBuilder::Build(config, osm_data, ways_bin, way_nodes_bin, nodes_bin, edges_bin, cr_from_bin,
                         cr_to_bin, tiles);
+    profile.finish(BuildStage::kBuild);
   }
 
   // Enhance the local level of the graph. This adds information to the local
@@ -324,21 +537,25 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
       osm_data.read_from_unique_names_file(tile_dir);
     }
     GraphEnhancer::Enhance(config, osm_data, access_bin);
+    profile.finish(BuildStage::kEnhance);
   }
 
   // Perform optional edge filtering (remove edges and nodes for specific access modes)
   if (start_stage <= BuildStage::kFilter && BuildStage::kFilter <= end_stage) {
     GraphFilter::Filter(config);
+    profile.finish(BuildStage::kFilter);
   }
 
   // Add transit
   if (start_stage <= BuildStage::kTransit && BuildStage::kTransit <= end_stage) {
     TransitBuilder::Build(config);
+    profile.finish(BuildStage::kTransit);
   }
 
   // Build bike share stations
   if (start_stage <= BuildStage::kBss && BuildStage::kBss <= end_stage) {
     BssBuilder::Build(config, bss_nodes_bin);
+    profile.finish(BuildStage::kBss);
   }
 
   // Builds additional hierarchies if specified within config file. Connections
@@ -347,6 +564,7 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
   if (build_hierarchy) {
     if (start_stage <= BuildStage::kHierarchy && BuildStage::kHierarchy <= end_stage) {
       HierarchyBuilder::Build(config, new_to_old_bin, old_to_new_bin);
+      profile.finish(BuildStage::kHierarchy);
     }
 
     // Build shortcuts if specified in the config file. Shortcuts can only be
@@ -355,6 +573,7 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
     if (build_shortcuts) {
       if (start_stage <= BuildStage::kShortcuts && BuildStage::kShortcuts <= end_stage) {
         ShortcutBuilder::Build(config);
+        profile.finish(BuildStage::kShortcuts);
       }
     } else {
       LOG_INFO("Skipping shortcut builder");
@@ -363,9 +582,36 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
     LOG_INFO("Skipping hierarchy builder and shortcut builder");
   }
 
+  // Optionally renumber the nodes within each tile so that neighbors are close in memory
+  if (start_stage <= BuildStage::kReorder && BuildStage::kReorder <= end_stage) {
+    GraphReorderer::Reorder(config);
+    profile.finish(BuildStage::kReorder);
+  }
+
+  // Build the contraction hierarchy overlay for default auto costing if the config says where
+  if (start_stage <= BuildStage::kContraction && BuildStage::kContraction <= end_stage) {
+    if (config.get_optional<std::string>("mjolnir.contraction_hierarchy")) {
+      ContractionBuilder::Build(config);
+    } else {
+      LOG_INFO("Skipping contraction builder");
+    }
+    profile.finish(BuildStage::kContraction);
+  }
+
+  // Compute the landmark distances for the a* heuristic if the config says where
+  if (start_stage <= BuildStage::kLandmarks && BuildStage::kLandmarks <= end_stage) {
+    if (config.get_optional<std::string>("mjolnir.landmarks")) {
+      LandmarkBuilder::Build(config);
+    } else {
+      LOG_INFO("Skipping landmark builder");
+    }
+    profile.finish(BuildStage::kLandmarks);
+  }
+
   // Add elevation to the tiles
   if (start_stage <= BuildStage::kElevation && BuildStage::kElevation <= end_stage) {
     ElevationBuilder::Build(config);
+    profile.finish(BuildStage::kElevation);
   }
 
   // Build the Complex Restrictions
@@ -374,11 +620,55 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
   // within the tile. However, there is no serialization currently available for complex restrictions.
   if (start_stage <= BuildStage::kRestrictions && BuildStage::kRestrictions <= end_stage) {
     RestrictionBuilder::Build(config, cr_from_bin, cr_to_bin);
+    profile.finish(BuildStage::kRestrictions);
   }
 
   // Validate the graph and add information that cannot be added until full graph is formed.
   if (start_stage <= BuildStage::kValidate && BuildStage::kValidate <= end_stage) {
     GraphValidator::Validate(config);
+    profile.finish(BuildStage::kValidate);
+  }
+
+  // Compute the reach of every edge for loki if the config says where, this needs the opposing
+  // edges which are only final once the graph is validated
+  if (start_stage <= BuildStage::kReach && BuildStage::kReach <= end_stage) {
+    if (config.get_optional<std::string>("mjolnir.edge_reach")) {
+      ReachBuilder::Build(config);
+    } else {
+      LOG_INFO("Skipping reach builder");
+    }
+    profile.finish(BuildStage::kReach);
+  }
+
+  // Index the shapes of the edges of every bin for loki if the config says where
+  if (start_stage <= BuildStage::kSegmentIndex && BuildStage::kSegmentIndex <= end_stage) {
+    if (config.get_optional<std::string>("mjolnir.segment_index")) {
+      SegmentIndexBuilder::Build(config);
+    } else {
+      LOG_INFO("Skipping segment index builder");
+    }
+    profile.finish(BuildStage::kSegmentIndex);
+  }
+
+  // Find the connected components of the graph for loki if the config says where
+  if (start_stage <= BuildStage::kComponents && BuildStage::kComponents <= end_stage) {
+    if (config.get_optional<std::string>("mjolnir.graph_components")) {
+      ComponentBuilder::Build(config);
+    } else {
+      LOG_INFO("Skipping component builder");
+    }
+    profile.finish(BuildStage::kComponents);
+  }
+
+  // Stream the finished tiles into a tile extract if the config asks for one
+  if (start_stage <= BuildStage::kExtract && BuildStage::kExtract <= end_stage) {
+    if (original_config.get<bool>("mjolnir.build_tile_extract", false) &&
+        original_config.get_optional<std::string>("mjolnir.tile_extract")) {
+      ExtractBuilder::Build(original_config);
+    } else {
+      LOG_INFO("Skipping extract builder");
+    }
+    profile.finish(BuildStage::kExtract);
   }
 
   // Cleanup bin files
@@ -396,7 +686,11 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
     remove_temp_file(old_to_new_bin);
     remove_temp_file(tile_manifest);
     OSMData::cleanup_temp_files(tile_dir);
+    profile.finish(BuildStage::kCleanup);
   }
+
+  // Write out what each stage used
+  profile.write(config.get<std::string>("mjolnir.build_profile", tile_dir + "build_profile.json"));
   return true;
 }
 
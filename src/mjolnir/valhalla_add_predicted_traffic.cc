@@ -9,6 +9,7 @@
 
 #include <cmath>
 #include <cstdint>
+#include <fstream>
 
 #include <boost/archive/iterators/base64_from_binary.hpp>
 #include <boost/archive/iterators/binary_from_base64.hpp>
@@ -19,12 +20,15 @@
 #include <boost/tokenizer.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <deque>
 #include <future>
 #include <mutex>
 #include <queue>
+#include <stdexcept>
 #include <string>
 #include <thread>
+#include <unordered_set>
 
 #include "config.h"
 
@@ -44,6 +48,7 @@ struct stats {
   uint32_t compressed_count;
   uint32_t updated_count;
   uint32_t dup_count;
+  uint32_t failed_count;
 
   // Accumulate counts from all threads
   void operator()(const stats& other) {
@@ -52,6 +57,7 @@ struct stats {
     compressed_count += other.compressed_count;
     updated_count += other.updated_count;
     dup_count += other.dup_count;
+    failed_count += other.failed_count;
   }
 };
 
@@ -206,31 +212,136 @@ void update_tile(const std::string& tile_dir,
   tile_builder.UpdatePredictedSpeeds(directededges);
 }
 
+// Writes the predicted speeds of a tile to its sidecar tile in the speeds dir, the graph tile is
+// only read for its number of directed edges. The free and constrained flow speeds are part of the
+// directed edges so they can only be added by updating the graph tile
+void write_sidecar(const std::string& tile_dir,
+                   const std::string& speeds_dir,
+                   const GraphId& tile_id,
+                   const std::unordered_map<uint32_t, TrafficSpeeds>& speeds,
+                   stats& stat) {
+  auto tile = GraphTile::Create(tile_dir, tile_id);
+  if (!tile || !tile->header()) {
+    LOG_ERROR("No tile at " + tile_dir + filesystem::path::preferred_separator +
+              GraphTile::FileSuffix(tile_id));
+    return;
+  }
+
+  vb::speed_profiles_t profiles;
+  for (const auto& speed : speeds) {
+    if (speed.second.coefficients && speed.first < tile->header()->directededgecount()) {
+      profiles.emplace(speed.first, *speed.second.coefficients);
+      ++stat.updated_count;
+    }
+  }
+
+  auto sidecar_path =
+      speeds_dir + filesystem::path::preferred_separator + GraphTile::FileSuffix(tile_id);
+  auto dir = filesystem::path(sidecar_path).parent_path();
+  if (!filesystem::exists(dir) && !filesystem::create_directories(dir)) {
+    throw std::runtime_error("Could not create directory " + dir.string());
+  }
+  std::ofstream file(sidecar_path, std::ios::out | std::ios::binary | std::ios::trunc);
+  file << vb::serialize_predicted_speed_tile(tile_id, tile->header()->directededgecount(),
+                                             profiles);
+  if (!file) {
+    throw std::runtime_error("Could not write " + sidecar_path);
+  }
+}
+
+// The tiles which have been updated so far, a rerun after a failure skips them since the predicted
+// speeds of a tile can only be added once
+class checkpoint_t {
+public:
+  explicit checkpoint_t(const std::string& path) : path_(path) {
+    std::ifstream in(path_);
+    std::string line;
+    while (std::getline(in, line)) {
+      try {
+        done_.insert(GraphId(line));
+      } catch (...) {}
+    }
+    out_.open(path_, std::ios::out | std::ios::app);
+    if (!out_.is_open()) {
+      throw std::runtime_error("Could not open checkpoint file: " + path_);
+    }
+  }
+
+  bool done(const GraphId& tile_id) const {
+    return done_.find(tile_id) != done_.cend();
+  }
+
+  size_t size() const {
+    return done_.size();
+  }
+
+  // Records that a tile was updated, flushed right away so it survives the process dying
+  void add(const GraphId& tile_id) {
+    std::lock_guard<std::mutex> lock(lock_);
+    out_ << std::to_string(tile_id) << std::endl;
+  }
+
+  // Once everything is done the next run starts from scratch again
+  void remove() {
+    out_.close();
+    filesystem::remove(path_);
+  }
+
+protected:
+  std::string path_;
+  std::unordered_set<GraphId> done_;
+  std::ofstream out_;
+  std::mutex lock_;
+};
+
 /**
  * Read both the constrained and freeflow speed CSV files
  * We expect the files to be named as <quadtreeID>.constrained.csv and
  * <quadtreeID>.freeflow.csv. (e.g., 1202021.constrained.csv and 1202021.freeflow.csv)
+ * Each thread takes the next tile from the shared queue, parses its csvs and rewrites it, or
+ * writes its sidecar tile when there is a speeds dir.
  */
-void update_tiles(
-    const std::string& tile_dir,
-    std::vector<std::pair<GraphId, std::vector<std::string>>>::const_iterator tile_start,
-    std::vector<std::pair<GraphId, std::vector<std::string>>>::const_iterator tile_end,
-    std::promise<stats>& result) {
+void update_tiles(const std::string& tile_dir,
+                  const std::string& speeds_dir,
+                  std::deque<std::pair<GraphId, std::vector<std::string>>>& tile_queue,
+                  std::mutex& lock,
+                  checkpoint_t& checkpoint,
+                  const size_t total,
+                  std::atomic<size_t>& count,
+                  std::promise<stats>& result) {
 
   std::stringstream thread_name;
   thread_name << std::this_thread::get_id();
 
-  // Iterate through the tiles and parse them
-  size_t total = tile_end - tile_start;
-  double count = 0;
+  // Take tiles off of the queue until there are no more and parse them
   stats stat{};
-  for (; tile_start != tile_end; ++tile_start) {
-    LOG_INFO(thread_name.str() + " parsing traffic data for " + std::to_string(tile_start->first));
-    auto traffic = ParseTrafficFile(tile_start->second, stat);
-    LOG_INFO(thread_name.str() + " add traffic data to " + std::to_string(tile_start->first));
-    update_tile(tile_dir, tile_start->first, traffic, stat);
-    LOG_INFO(thread_name.str() + " finished " + std::to_string(tile_start->first) + "(" +
-             std::to_string(++count / total * 100.0) + ")");
+  while (true) {
+    std::unique_lock<std::mutex> queue_lock(lock);
+    if (tile_queue.empty()) {
+      break;
+    }
+    auto tile = std::move(tile_queue.front());
+    tile_queue.pop_front();
+    queue_lock.unlock();
+
+    // one bad tile shouldnt stop the others, its not checkpointed so a rerun tries it again
+    try {
+      LOG_INFO(thread_name.str() + " parsing traffic data for " + std::to_string(tile.first));
+      auto traffic = ParseTrafficFile(tile.second, stat);
+      LOG_INFO(thread_name.str() + " add traffic data to " + std::to_string(tile.first));
+      if (speeds_dir.empty()) {
+        update_tile(tile_dir, tile.first, traffic, stat);
+      } else {
+        write_sidecar(tile_dir, speeds_dir, tile.first, traffic, stat);
+      }
+      checkpoint.add(tile.first);
+    } catch (std::exception& e) {
+      LOG_ERROR(thread_name.str() + " failed to update " + std::to_string(tile.first) + ": " +
+                e.what());
+      ++stat.failed_count;
+    }
+    LOG_INFO(thread_name.str() + " finished " + std::to_string(tile.first) + "(" +
+             std::to_string(static_cast<double>(++count) / total * 100.0) + ")");
   }
 
   result.set_value(stat);
@@ -242,6 +353,8 @@ int main(int argc, char** argv) {
   std::string config, traffic_tile_dir;
   std::string inline_config;
   std::string config_file_path;
+  std::string checkpoint_path;
+  std::string speeds_dir;
   unsigned int num_threads = std::thread::hardware_concurrency();
   bool summary = false;
 
@@ -261,7 +374,16 @@ int main(int argc, char** argv) {
                                    "Path to the json configuration file.")(
       "inline-config,i", boost::program_options::value<std::string>(&inline_config),
       "Inline json config.")("summary,s", bpo::value<bool>(&summary),
-                             "Output summary information about traffic coverage for the tile set")
+                             "Output summary information about traffic coverage for the tile set")(
+      "checkpoint,k", bpo::value<std::string>(&checkpoint_path),
+      "File in which to record the tiles already updated so that a failed run can be resumed by "
+      "running it again. Defaults to .predicted_traffic_checkpoint in the tile dir, it is removed "
+      "once all tiles are updated.")(
+      "predicted-speeds-dir,p", bpo::value<std::string>(&speeds_dir),
+      "Write the predicted speeds to sidecar tiles in this directory instead of adding them to the "
+      "tiles. Build them into the extract at mjolnir.predicted_speeds_extract with "
+      "valhalla_build_extract. Free and constrained flow speeds can only be added to the tiles so "
+      "they are skipped.")
       // positional arguments
       ("traffic-tile-dir,t", bpo::value<std::string>(&traffic_tile_dir),
        "Location of traffic csv tiles.");
@@ -296,6 +418,7 @@ int main(int argc, char** argv) {
 
   // queue up all the work we'll be doing
   std::unordered_map<GraphId, std::vector<std::string>> files_per_tile;
+  std::unordered_map<GraphId, size_t> bytes_per_tile;
   for (filesystem::recursive_directory_iterator i(traffic_tile_dir), end; i != end; ++i) {
     if (i->is_regular_file()) {
       // remove any extension
@@ -306,13 +429,10 @@ int main(int argc, char** argv) {
         // parse it into a tile id and store the file path with it
         auto id = GraphTile::GetTileId(file_name);
         files_per_tile[id].push_back(i->path().string());
+        bytes_per_tile[id] += i->file_size();
       } catch (...) {}
     }
   }
-  std::vector<std::pair<GraphId, std::vector<std::string>>> traffic_tiles(files_per_tile.begin(),
-                                                                          files_per_tile.end());
-  std::random_device rd;
-  std::shuffle(traffic_tiles.begin(), traffic_tiles.end(), std::mt19937(rd()));
 
   // Read the config file
   boost::property_tree::ptree pt;
@@ -337,26 +457,49 @@ int main(int argc, char** argv) {
     valhalla::midgard::logging::Configure(logging_config);
   }
 
+  // skip the tiles a previous run already updated
+  auto tile_dir = pt.get<std::string>("mjolnir.tile_dir");
+  if (checkpoint_path.empty()) {
+    checkpoint_path = (speeds_dir.empty() ? tile_dir : speeds_dir) +
+                      filesystem::path::preferred_separator + ".predicted_traffic_checkpoint";
+  }
+  checkpoint_t checkpoint(checkpoint_path);
+  if (checkpoint.size()) {
+    LOG_INFO("Resuming, " + std::to_string(checkpoint.size()) + " tiles were already updated");
+  }
+
+  // queue up the tiles with the most csv data first so that no thread starts a big one at the end
+  std::vector<std::pair<size_t, std::pair<GraphId, std::vector<std::string>>>> sized_tiles;
+  for (auto& tile : files_per_tile) {
+    if (checkpoint.done(tile.first)) {
+      continue;
+    }
+    sized_tiles.emplace_back(bytes_per_tile[tile.first], std::move(tile));
+  }
+  std::stable_sort(sized_tiles.begin(), sized_tiles.end(),
+                   [](const decltype(sized_tiles)::value_type& a,
+                      const decltype(sized_tiles)::value_type& b) { return a.first > b.first; });
+  std::deque<std::pair<GraphId, std::vector<std::string>>> tile_queue;
+  for (auto& tile : sized_tiles) {
+    tile_queue.emplace_back(std::move(tile.second));
+  }
+
+  num_threads = std::max(1u, num_threads);
   LOG_INFO("Adding predicted traffic with " + std::to_string(num_threads) + " threads");
   std::vector<std::shared_ptr<std::thread>> threads(num_threads);
 
-  LOG_INFO("Parsing speeds from " + std::to_string(traffic_tiles.size()) + " tiles.");
-  size_t floor = traffic_tiles.size() / threads.size();
-  size_t at_ceiling = traffic_tiles.size() - (threads.size() * floor);
-  decltype(traffic_tiles)::const_iterator tile_start, tile_end = traffic_tiles.begin();
-  auto tile_dir = pt.get<std::string>("mjolnir.tile_dir");
+  LOG_INFO("Parsing speeds from " + std::to_string(tile_queue.size()) + " tiles.");
+  std::mutex lock;
+  std::atomic<size_t> count(0);
+  const size_t total = tile_queue.size();
   // A place to hold the results of those threads (exceptions, stats)
   std::list<std::promise<stats>> results;
-  // Atomically pass around stats info
   for (size_t i = 0; i < threads.size(); ++i) {
-    // Where the range begins
-    tile_start = tile_end;
-    // Where the range ends
-    tile_end += (i < at_ceiling ? floor + 1 : floor);
     // Make the thread
     results.emplace_back();
-    threads[i].reset(
-        new std::thread(update_tiles, tile_dir, tile_start, tile_end, std::ref(results.back())));
+    threads[i].reset(new std::thread(update_tiles, std::cref(tile_dir), std::cref(speeds_dir),
+                                     std::ref(tile_queue), std::ref(lock), std::ref(checkpoint),
+                                     total, std::ref(count), std::ref(results.back())));
   }
 
   // wait for it to finish
@@ -365,7 +508,7 @@ int main(int argc, char** argv) {
 
   // collect some stats
   uint32_t constrained_count = 0, free_flow_count = 0, compressed_count = 0, updated_count = 0,
-           duplicate_count = 0;
+           duplicate_count = 0, failed_count = 0;
   for (auto& result : results) {
     try {
       auto thread_stats = result.get_future().get();
@@ -374,6 +517,7 @@ int main(int argc, char** argv) {
       compressed_count += thread_stats.compressed_count;
       updated_count += thread_stats.updated_count;
       duplicate_count += thread_stats.dup_count;
+      failed_count += thread_stats.failed_count;
     } catch (std::exception& e) {
       // TODO: throw further up the chain?
     }
@@ -384,6 +528,14 @@ int main(int argc, char** argv) {
   LOG_INFO("Parsed " + std::to_string(compressed_count) + " compressed records.");
   LOG_INFO("Updated " + std::to_string(updated_count) + " directed edges.");
   LOG_INFO("Duplicate count " + std::to_string(duplicate_count) + ".");
+
+  // keep the checkpoint around so that running again only retries the tiles that failed
+  if (failed_count) {
+    LOG_ERROR("Failed to update " + std::to_string(failed_count) + " tiles, run again to retry " +
+              "them, the tiles in " + checkpoint_path + " are skipped");
+    return EXIT_FAILURE;
+  }
+  checkpoint.remove();
   LOG_INFO("Finished");
 
   if (!summary)
@@ -431,7 +583,7 @@ int main(int argc, char** argv) {
         }
 
         // Presence of predicted speeds
-        if (de->has_predicted_speed()) {
+        if (tile->HasPredictedSpeed(de)) {
           pred_road_class_edges[rc]++;
         }
 
@@ -440,7 +592,7 @@ int main(int argc, char** argv) {
           ff_road_class_edges[rc]++;
         }
 
-        if (de->has_predicted_speed() && de->free_flow_speed() == 0 &&
+        if (tile->HasPredictedSpeed(de) && de->free_flow_speed() == 0 &&
             de->constrained_flow_speed() == 0) {
           LOG_WARN("Edge has predicted speed but no ff or constrained speed");
         }
@@ -0,0 +1,101 @@
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "baldr/graphtile.h"
+#include "baldr/rapidjson_utils.h"
+#include "config.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+#include "mjolnir/osmchange.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::mjolnir;
+
+namespace bpo = boost::program_options;
+
+filesystem::path config_file_path;
+std::string osc_file;
+
+bool ParseArguments(int argc, char* argv[]) {
+
+  bpo::options_description options(
+      "valhalla_affected_tiles " VALHALLA_VERSION "\n"
+      "\n"
+      " Usage: valhalla_affected_tiles [options]\n"
+      "\n"
+      "valhalla_affected_tiles prints the tiles, of every level, which an osmChange file touches. "
+      "It needs the ways.bin and way_nodes.bin the previous build left in the tile directory of "
+      "the config, so that build has to stop before the cleanup stage. Only the printed tiles "
+      "have to be published or compared after rebuilding with the changes applied."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")("version,v",
+                                                              "Print the version of this software.")(
+      "config,c", boost::program_options::value<filesystem::path>(&config_file_path)->required(),
+      "Path to the json configuration file.")(
+      "osc,o", boost::program_options::value<std::string>(&osc_file)->required(),
+      "Path to the uncompressed osmChange file.");
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).run(), vm);
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return false;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return true;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "valhalla_affected_tiles " << VALHALLA_VERSION << "\n";
+    return true;
+  }
+
+  if (vm.count("config")) {
+    if (filesystem::is_regular_file(config_file_path)) {
+      return true;
+    } else {
+      std::cerr << "Configuration file is required\n\n" << options << "\n\n";
+    }
+  }
+
+  return false;
+}
+
+int main(int argc, char** argv) {
+  if (!ParseArguments(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(config_file_path.string(), pt);
+  auto tile_dir = pt.get<std::string>("mjolnir.tile_dir");
+  if (tile_dir.back() != filesystem::path::preferred_separator) {
+    tile_dir.push_back(filesystem::path::preferred_separator);
+  }
+  const auto ways_file = tile_dir + "ways.bin";
+  const auto way_nodes_file = tile_dir + "way_nodes.bin";
+  if (!filesystem::exists(ways_file) || !filesystem::exists(way_nodes_file)) {
+    LOG_ERROR("The previous build left no ways.bin and way_nodes.bin in " + tile_dir);
+    return EXIT_FAILURE;
+  }
+
+  auto change = OSMChange::Read(osc_file);
+  auto tiles = change.AffectedTiles(ways_file, way_nodes_file);
+  for (const auto& tile : tiles) {
+    std::cout << GraphTile::FileSuffix(tile) << std::endl;
+  }
+  LOG_INFO("The changes touch " + std::to_string(tiles.size()) + " tiles");
+  return EXIT_SUCCESS;
+}
@@ -120,6 +120,7 @@ int main(int argc, char** argv) {
   config.get_child("mjolnir").erase("tile_extract");
   config.get_child("mjolnir").erase("tile_url");
   config.get_child("mjolnir").erase("traffic_extract");
+  config.get_child("mjolnir").erase("predicted_speeds_extract");
   boost::optional<boost::property_tree::ptree&> logging_subtree =
       config.get_child_optional("mjolnir.logging");
   if (logging_subtree) {
@@ -556,9 +556,8 @@ void BuildStatistics(const boost::property_tree::ptree& pt) {
   // Get the promise from the future
   statistics stats;
   for (auto& result : results) {
-    auto r = result.get_future().get();
     // keep track of stats
-    stats.add(r);
+    stats.add(result.get_future().get());
   }
   LOG_INFO("Finished");
 
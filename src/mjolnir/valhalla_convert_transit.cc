@@ -1,3 +1,4 @@
+#include <atomic>
 #include <cmath>
 #include <cstdint>
 #include <fstream>
@@ -88,15 +89,13 @@ ProcessStopPairs(GraphTileBuilder& transit_tilebuilder,
       if ((ext == ".pbf" && fname == file) ||
           (file_name.substr(file_name.size() - 4) == ".pbf" && file_name == file)) {
 
-        Transit spp;
-        {
-          // already loaded
-          if (ext == ".pbf") {
-            spp = transit;
-          } else {
-            spp = read_pbf(fname, lock);
-          }
+        // The tile itself is already loaded, the files with the rest of its stop pairs are read
+        // one at a time and let go of before the next one
+        Transit more_stop_pairs;
+        if (ext != ".pbf") {
+          more_stop_pairs = read_pbf(fname, lock);
         }
+        const Transit& spp = ext == ".pbf" ? transit : more_stop_pairs;
 
         if (spp.stop_pairs_size() == 0) {
           if (transit.nodes_size() > 0) {
@@ -480,7 +479,7 @@ std::list<PointLL> GetShape(const PointLL& stop_ll,
 
 void AddToGraph(GraphTileBuilder& tilebuilder_transit,
                 const GraphId& tileid,
-                const std::string& tile,
+                const Transit& transit,
                 const std::string& transit_dir,
                 std::mutex& lock,
                 const std::unordered_set<GraphId>& all_tiles,
@@ -494,8 +493,9 @@ void AddToGraph(GraphTileBuilder& tilebuilder_transit,
                 uint32_t& no_dir_edge_count) {
   auto t1 = std::chrono::high_resolution_clock::now();
 
-  // Get Transit PBF data for this tile
-  Transit transit = read_pbf(tile, lock);
+  // The stops of other tiles the transit edges end at, only their stops are kept and each tile is
+  // read once rather than once per edge
+  std::unordered_map<GraphId, Transit> end_tiles;
 
   std::set<uint64_t> added_stations;
   std::set<uint64_t> added_egress;
@@ -869,15 +869,20 @@ void AddToGraph(GraphTileBuilder& tilebuilder_transit,
         dest_id = endplatform.onestop_id();
 
       } else {
-        // Get Transit PBF data for this tile
-        // Get transit pbf tile
-        std::string file_name = GraphTile::FileSuffix(
-            GraphId(end_platform_graphid.tileid(), end_platform_graphid.level(), 0));
-        boost::algorithm::trim_if(file_name, boost::is_any_of(".gph"));
-        file_name += ".pbf";
-        const std::string file = transit_dir + filesystem::path::preferred_separator + file_name;
-        Transit endtransit = read_pbf(file, lock);
-        const Transit_Node& endplatform = endtransit.nodes(end_platform_graphid.id());
+        // Get Transit PBF data for this tile the first time one of its stops is needed
+        auto end_tile = end_tiles.find(end_platform_graphid.Tile_Base());
+        if (end_tile == end_tiles.end()) {
+          std::string file_name = GraphTile::FileSuffix(
+              GraphId(end_platform_graphid.tileid(), end_platform_graphid.level(), 0));
+          boost::algorithm::trim_if(file_name, boost::is_any_of(".gph"));
+          file_name += ".pbf";
+          const std::string file = transit_dir + filesystem::path::preferred_separator + file_name;
+          Transit endtransit = read_pbf(file, lock);
+          Transit stops;
+          stops.mutable_nodes()->Swap(endtransit.mutable_nodes());
+          end_tile = end_tiles.emplace(end_platform_graphid.Tile_Base(), std::move(stops)).first;
+        }
+        const Transit_Node& endplatform = end_tile->second.nodes(end_platform_graphid.id());
         endstopname = endplatform.name();
         endll = {endplatform.lon(), endplatform.lat()};
         dest_id = endplatform.onestop_id();
@@ -963,8 +968,8 @@ void AddToGraph(GraphTileBuilder& tilebuilder_transit,
 void build_tiles(const boost::property_tree::ptree& pt,
                  std::mutex& lock,
                  const std::unordered_set<GraphId>& all_tiles,
-                 std::unordered_set<GraphId>::const_iterator tile_start,
-                 std::unordered_set<GraphId>::const_iterator tile_end,
+                 const std::vector<GraphId>& queue,
+                 std::atomic<size_t>& next_tile,
                  std::promise<builder_stats>& results) {
 
   builder_stats stats;
@@ -981,13 +986,14 @@ void build_tiles(const boost::property_tree::ptree& pt,
   }
 
   const auto& tiles = TileHierarchy::levels().back().tiles;
-  // Iterate through the tiles in the queue and find any that include stops
-  for (; tile_start != tile_end; ++tile_start) {
+  // Take tiles from the queue until it is empty, each thread only has one tile in memory at a time
+  // and the threads which get small tiles go on to the next ones rather than waiting on the others
+  for (size_t t = next_tile++; t < queue.size(); t = next_tile++) {
     // Get the next tile Id from the queue and get a tile builder
     if (reader_transit_level.OverCommitted()) {
       reader_transit_level.Trim();
     }
-    GraphId tile_id = tile_start->Tile_Base();
+    GraphId tile_id = queue[t].Tile_Base();
 
     // Get transit pbf tile
     const std::string transit_dir = pt.get<std::string>("transit_dir");
@@ -999,7 +1005,7 @@ void build_tiles(const boost::property_tree::ptree& pt,
     // Make sure it exists
     if (!filesystem::exists(file)) {
       LOG_ERROR("File not found.  " + file);
-      return;
+      continue;
     }
 
     Transit transit = read_pbf(file, lock);
@@ -1073,10 +1079,11 @@ void build_tiles(const boost::property_tree::ptree& pt,
 
     // Create a map of stop key to index in the stop vector
 
-    // Process schedule stop pairs (departures)
+    // Process schedule stop pairs (departures), they arent needed after that
     std::unordered_multimap<GraphId, Departure> departures =
         ProcessStopPairs(tilebuilder_transit, tile_creation_date, transit, stop_access, file, lock,
                          stats);
+    transit.clear_stop_pairs();
 
     // Form departures and egress/station/platform hierarchy
     for (uint32_t i = 0; i < transit.nodes_size(); i++) {
@@ -1154,7 +1161,7 @@ void build_tiles(const boost::property_tree::ptree& pt,
     }
 
     // Add nodes, directededges, and edgeinfo
-    AddToGraph(tilebuilder_transit, tile_id, file, transit_dir, lock, all_tiles, stop_edge_map,
+    AddToGraph(tilebuilder_transit, tile_id, transit, transit_dir, lock, all_tiles, stop_edge_map,
                stop_access, shapes, distances, route_types, tile_within_one_tz, tz_polys,
                stats.no_dir_edge_count);
 
@@ -1206,24 +1213,14 @@ void build(const ptree& pt,
   // A place to hold the results of those threads (exceptions, stats)
   std::list<std::promise<builder_stats>> results;
 
-  // Start the threads, divvy up the work
+  // Start the threads, they take the tiles from a shared queue
   LOG_INFO("Adding " + std::to_string(all_tiles.size()) + " transit tiles to the transit graph...");
-  size_t floor = all_tiles.size() / threads.size();
-  size_t at_ceiling = all_tiles.size() - (threads.size() * floor);
-  std::unordered_set<GraphId>::const_iterator tile_start, tile_end = all_tiles.begin();
-
-  // Atomically pass around stats info
+  std::vector<GraphId> queue(all_tiles.begin(), all_tiles.end());
+  std::atomic<size_t> next_tile(0);
   for (size_t i = 0; i < threads.size(); ++i) {
-    // Figure out how many this thread will work on (either ceiling or floor)
-    size_t tile_count = (i < at_ceiling ? floor + 1 : floor);
-    // Where the range begins
-    tile_start = tile_end;
-    // Where the range ends
-    std::advance(tile_end, tile_count);
-    // Make the thread
     results.emplace_back();
     threads[i].reset(new std::thread(build_tiles, std::cref(pt.get_child("mjolnir")), std::ref(lock),
-                                     std::cref(all_tiles), tile_start, tile_end,
+                                     std::cref(all_tiles), std::cref(queue), std::ref(next_tile),
                                      std::ref(results.back())));
   }
 
@@ -1317,7 +1314,9 @@ int main(int argc, char** argv) {
   }
 
   LOG_INFO("Building transit network.");
-  build(pt, all_tiles);
+  build(pt, all_tiles,
+        std::max(1u, pt.get<unsigned int>("mjolnir.concurrency",
+                                          std::thread::hardware_concurrency())));
   ValidateTransit::Validate(pt, all_tiles, onestoptests);
   return 0;
 }
@@ -0,0 +1,115 @@
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "baldr/graphtile.h"
+#include "baldr/rapidjson_utils.h"
+#include "config.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+
+using namespace valhalla::baldr;
+
+namespace bpo = boost::program_options;
+
+filesystem::path config_file_path;
+std::string output_dir;
+int level = 9;
+
+bool ParseArguments(int argc, char* argv[]) {
+
+  bpo::options_description options(
+      "valhalla_section_tiles " VALHALLA_VERSION "\n"
+      "\n"
+      " Usage: valhalla_section_tiles [options]\n"
+      "\n"
+      "valhalla_section_tiles writes every tile of the tile directory of the config as a sectioned "
+      "tile (.gph.sec) to the output directory. The edge info, names and lanes of sectioned tiles "
+      "are compressed apart from the rest and only inflated once they are read."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")("version,v",
+                                                              "Print the version of this software.")(
+      "config,c", boost::program_options::value<filesystem::path>(&config_file_path)->required(),
+      "Path to the json configuration file.")(
+      "output,o", boost::program_options::value<std::string>(&output_dir)->required(),
+      "Directory to write the sectioned tiles to.")(
+      "level,l", boost::program_options::value<int>(&level),
+      "zlib compression level of the sections, defaults to 9.");
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).run(), vm);
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return false;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return true;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "valhalla_section_tiles " << VALHALLA_VERSION << "\n";
+    return true;
+  }
+
+  if (vm.count("config")) {
+    if (filesystem::is_regular_file(config_file_path)) {
+      return true;
+    } else {
+      std::cerr << "Configuration file is required\n\n" << options << "\n\n";
+    }
+  }
+
+  return false;
+}
+
+int main(int argc, char** argv) {
+  if (!ParseArguments(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(config_file_path.string(), pt);
+  const auto tile_dir = pt.get<std::string>("mjolnir.tile_dir");
+  if (!filesystem::is_directory(tile_dir)) {
+    LOG_ERROR("Tile directory " + tile_dir + " does not exist");
+    return EXIT_FAILURE;
+  }
+
+  size_t count = 0, plain_bytes = 0, sectioned_bytes = 0;
+  for (filesystem::recursive_directory_iterator i(tile_dir), end; i != end; ++i) {
+    if (!i->is_regular_file() || i->path().extension().string() != SUFFIX_NON_COMPRESSED) {
+      continue;
+    }
+
+    std::ifstream file(i->path().string(), std::ios::in | std::ios::binary | std::ios::ate);
+    std::vector<char> tile(file.tellg());
+    file.seekg(0, std::ios::beg);
+    file.read(tile.data(), tile.size());
+    file.close();
+
+    auto graphid = GraphTile::GetTileId(i->path().string());
+    auto sectioned = GraphTile::CompressSections(tile, level);
+    GraphTile::SaveTileToFile(sectioned, output_dir + filesystem::path::preferred_separator +
+                                             GraphTile::FileSuffix(graphid, SUFFIX_SECTIONED));
+    ++count;
+    plain_bytes += tile.size();
+    sectioned_bytes += sectioned.size();
+  }
+
+  LOG_INFO("Sectioned " + std::to_string(count) + " tiles from " + std::to_string(plain_bytes) +
+           " to " + std::to_string(sectioned_bytes) + " bytes");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "baldr/rapidjson_utils.h"
+#include "config.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+#include "mjolnir/trafficupdater.h"
+
+using namespace valhalla::mjolnir;
+
+namespace bpo = boost::program_options;
+
+filesystem::path config_file_path;
+std::vector<std::string> feed_files;
+uint64_t timestamp = 0;
+unsigned int repeat = 1;
+
+bool ParseArguments(int argc, char* argv[]) {
+
+  bpo::options_description options(
+      "valhalla_update_traffic " VALHALLA_VERSION "\n"
+      "\n"
+      " Usage: valhalla_update_traffic [options] <feed_file> [<feed_file> ...]\n"
+      "\n"
+      "valhalla_update_traffic writes the live speeds of binary traffic feeds into the traffic "
+      "extract of the config, in place, while it is being used to route. A feed is a file of 16 "
+      "byte records, the graph id of a directed edge followed by its packed TrafficSpeed. The "
+      "feeds are applied in the order given and the throughput of each is logged."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")("version,v",
+                                                              "Print the version of this software.")(
+      "config,c", boost::program_options::value<filesystem::path>(&config_file_path)->required(),
+      "Path to the json configuration file.")(
+      "timestamp,t", boost::program_options::value<uint64_t>(&timestamp),
+      "Seconds since epoch to set as the last update of the changed tiles. Defaults to now.")(
+      "repeat,r", boost::program_options::value<unsigned int>(&repeat),
+      "Apply every feed this many times, to measure the throughput of the updates.")
+      // positional arguments
+      ("feed_files", boost::program_options::value<std::vector<std::string>>(&feed_files));
+
+  bpo::positional_options_description pos_options;
+  pos_options.add("feed_files", -1);
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).positional(pos_options).run(),
+               vm);
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return false;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    exit(EXIT_SUCCESS);
+  }
+
+  if (vm.count("version")) {
+    std::cout << "valhalla_update_traffic " << VALHALLA_VERSION << "\n";
+    exit(EXIT_SUCCESS);
+  }
+
+  if (feed_files.empty()) {
+    std::cerr << "At least one feed file is required\n\n" << options << "\n\n";
+    return false;
+  }
+
+  if (vm.count("config")) {
+    if (filesystem::is_regular_file(config_file_path)) {
+      return true;
+    } else {
+      std::cerr << "Configuration file is required\n\n" << options << "\n\n";
+    }
+  }
+
+  return false;
+}
+
+int main(int argc, char** argv) {
+  if (!ParseArguments(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(config_file_path.string(), pt);
+  auto traffic_extract = pt.get_optional<std::string>("mjolnir.traffic_extract");
+  if (!traffic_extract || !filesystem::is_regular_file(*traffic_extract)) {
+    LOG_ERROR("The config has no traffic extract to update");
+    return EXIT_FAILURE;
+  }
+
+  TrafficUpdater updater(*traffic_extract);
+  LOG_INFO("Found " + std::to_string(updater.tile_count()) + " traffic tiles in " +
+           *traffic_extract);
+
+  for (const auto& feed_file : feed_files) {
+    auto records = TrafficUpdater::ReadFeed(feed_file);
+    for (unsigned int i = 0; i < std::max(repeat, 1u); ++i) {
+      auto now = timestamp ? timestamp : static_cast<uint64_t>(std::time(nullptr));
+      auto start = std::chrono::steady_clock::now();
+      auto written = updater.Update(records, now);
+      std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+      auto per_second = static_cast<uint64_t>(records.size() / std::max(took.count(), 1e-9));
+      LOG_INFO("Wrote " + std::to_string(written) + " of " + std::to_string(records.size()) +
+               " speeds from " + feed_file + " in " + std::to_string(took.count()) + "s (" +
+               std::to_string(per_second) + " records/s)");
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -1,7 +1,13 @@
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <fstream>
+#include <memory>
+#include <queue>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -19,6 +25,7 @@
 #include "baldr/graphtile.h"
 #include "baldr/tilehierarchy.h"
 #include "filesystem.h"
+#include "midgard/logging.h"
 
 namespace bpo = boost::program_options;
 
@@ -27,16 +34,166 @@ using namespace valhalla::midgard;
 
 filesystem::path config_file_path;
 std::vector<std::string> input_files;
+unsigned int num_threads = 0;
 
-// Structure holding an edge Id and forward flag
-struct EdgeAndDirection {
-  bool forward;
-  GraphId edgeid;
+namespace {
 
-  EdgeAndDirection(const bool f, const GraphId& id) : forward(f), edgeid(id) {
+// An edge of a way, the direction is kept in the top bit since graph ids only use 46 bits
+struct way_edge_t {
+  uint64_t wayid;
+  uint64_t edge;
+
+  way_edge_t(const uint64_t way, const bool forward, const GraphId& id)
+      : wayid(way), edge(id.value | (static_cast<uint64_t>(forward) << 63)) {
+  }
+  way_edge_t() = default;
+
+  bool forward() const {
+    return edge >> 63;
+  }
+  uint64_t edgeid() const {
+    return edge & ~(static_cast<uint64_t>(1) << 63);
+  }
+  bool operator<(const way_edge_t& other) const {
+    return wayid < other.wayid || (wayid == other.wayid && edge < other.edge);
   }
 };
 
+// How many edges each thread collects before sorting them into a run on disk, 64MB worth
+constexpr size_t kRunSize = (64 << 20) / sizeof(way_edge_t);
+
+// Sorts the edges and writes them to a new run file, the runs are merged once all tiles are done
+void write_run(std::vector<way_edge_t>& edges,
+               const std::string& prefix,
+               std::vector<std::string>& runs) {
+  if (edges.empty()) {
+    return;
+  }
+  std::sort(edges.begin(), edges.end());
+  runs.push_back(prefix + std::to_string(runs.size()));
+  std::ofstream run(runs.back(), std::ios::binary | std::ios::trunc);
+  run.write(reinterpret_cast<const char*>(edges.data()), edges.size() * sizeof(way_edge_t));
+  if (!run) {
+    throw std::runtime_error("Could not write " + runs.back());
+  }
+  edges.clear();
+}
+
+// Each thread takes the next tile until there are none left and collects the edges of the
+// auto-driveable ways in sorted runs
+void collect_edges(const boost::property_tree::ptree& pt,
+                   const std::vector<GraphId>& tile_ids,
+                   std::atomic<size_t>& next_tile,
+                   const std::string& prefix,
+                   std::vector<std::string>& runs) {
+  GraphReader reader(pt.get_child("mjolnir"));
+  std::vector<way_edge_t> edges;
+  edges.reserve(kRunSize);
+  for (size_t t = next_tile++; t < tile_ids.size(); t = next_tile++) {
+    GraphId edge_id = tile_ids[t];
+    if (reader.OverCommitted()) {
+      reader.Trim();
+    }
+    graph_tile_ptr tile = reader.GetGraphTile(edge_id);
+    if (!tile) {
+      continue;
+    }
+    for (uint32_t n = 0; n < tile->header()->directededgecount(); n++, ++edge_id) {
+      const DirectedEdge* edge = tile->directededge(edge_id);
+      if (edge->IsTransitLine() || edge->use() == Use::kTransitConnection ||
+          edge->use() == Use::kEgressConnection || edge->use() == Use::kPlatformConnection ||
+          edge->is_shortcut()) {
+        continue;
+      }
+
+      // Skip if the edge does not allow auto use
+      if (!(edge->forwardaccess() & kAutoAccess)) {
+        continue;
+      }
+
+      // Get the way Id
+      edges.emplace_back(tile->edgeinfo(edge).wayid(), edge->forward(), edge_id);
+      if (edges.size() == kRunSize) {
+        write_run(edges, prefix, runs);
+      }
+    }
+  }
+  write_run(edges, prefix, runs);
+}
+
+// Reads a run back one buffer at a time
+class run_reader_t {
+public:
+  explicit run_reader_t(const std::string& path) : file_(path, std::ios::binary) {
+    buffer_.resize(kBufferSize);
+    fill();
+  }
+  bool done() const {
+    return pos_ == buffer_.size();
+  }
+  const way_edge_t& top() const {
+    return buffer_[pos_];
+  }
+  void pop() {
+    if (++pos_ == buffer_.size()) {
+      fill();
+    }
+  }
+
+protected:
+  static constexpr size_t kBufferSize = 1 << 16;
+  void fill() {
+    buffer_.resize(kBufferSize);
+    file_.read(reinterpret_cast<char*>(buffer_.data()), kBufferSize * sizeof(way_edge_t));
+    buffer_.resize(file_.gcount() / sizeof(way_edge_t));
+    pos_ = 0;
+  }
+  std::ifstream file_;
+  std::vector<way_edge_t> buffer_;
+  size_t pos_ = 0;
+};
+
+// Merges the sorted runs into one line per way with all of its edges
+void merge_runs(const std::vector<std::string>& runs, std::ostream& out) {
+  std::vector<std::unique_ptr<run_reader_t>> readers;
+  for (const auto& run : runs) {
+    readers.emplace_back(new run_reader_t(run));
+  }
+  auto later = [&readers](size_t a, size_t b) { return readers[b]->top() < readers[a]->top(); };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(later)> heads(later);
+  for (size_t i = 0; i < readers.size(); ++i) {
+    if (!readers[i]->done()) {
+      heads.push(i);
+    }
+  }
+
+  bool first = true;
+  uint64_t wayid = 0;
+  while (!heads.empty()) {
+    auto i = heads.top();
+    heads.pop();
+    const auto& edge = readers[i]->top();
+    if (first || edge.wayid != wayid) {
+      if (!first) {
+        out << "\n";
+      }
+      wayid = edge.wayid;
+      first = false;
+      out << wayid;
+    }
+    out << "," << (uint32_t)edge.forward() << "," << edge.edgeid();
+    readers[i]->pop();
+    if (!readers[i]->done()) {
+      heads.push(i);
+    }
+  }
+  if (!first) {
+    out << "\n";
+  }
+}
+
+} // namespace
+
 bool ParseArguments(int argc, char* argv[]) {
 
   bpo::options_description options(
@@ -51,7 +208,9 @@ bool ParseArguments(int argc, char* argv[]) {
   options.add_options()("help,h", "Print this help message.")("version,v",
                                                               "Print the version of this software.")(
       "config,c", boost::program_options::value<filesystem::path>(&config_file_path)->required(),
-      "Path to the json configuration file.")
+      "Path to the json configuration file.")(
+      "concurrency,j", bpo::value<unsigned int>(&num_threads),
+      "Number of threads to use. Defaults to mjolnir.concurrency or the number of cores.")
       // positional arguments
       ("input_files",
        boost::program_options::value<std::vector<std::string>>(&input_files)->multitoken());
@@ -104,49 +263,73 @@ int main(int argc, char** argv) {
   boost::property_tree::ptree pt;
   rapidjson::read_json(config_file_path.string(), pt);
 
-  // Create an unordered map of OSM ways Ids and their associated graph edges
-  std::unordered_map<uint64_t, std::vector<EdgeAndDirection>> ways_edges;
+  // Configure logging
+  if (auto logging_subtree = pt.get_child_optional("mjolnir.logging")) {
+    auto logging_config =
+        ToMap<const boost::property_tree::ptree&, std::unordered_map<std::string, std::string>>(
+            logging_subtree.get());
+    logging::Configure(logging_config);
+  }
 
-  GraphReader reader(pt.get_child("mjolnir"));
-  // Iterate through all tiles
-  for (auto edge_id : reader.GetTileSet()) {
-    // If tile exists add it to the queue
-    if (!reader.DoesTileExist(edge_id)) {
-      continue;
-    }
+  // Each thread sorts the edges of its tiles into runs on disk, bounding the memory to a run each
+  std::vector<GraphId> tile_ids;
+  {
+    GraphReader reader(pt.get_child("mjolnir"));
+    auto tile_set = reader.GetTileSet();
+    tile_ids.assign(tile_set.cbegin(), tile_set.cend());
+  }
+  if (num_threads == 0) {
+    num_threads = pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency());
+  }
+  num_threads = std::max(1u, num_threads);
+  LOG_INFO("Collecting the edges of the ways in " + std::to_string(tile_ids.size()) +
+           " tiles with " + std::to_string(num_threads) + " threads");
 
-    graph_tile_ptr tile = reader.GetGraphTile(edge_id);
-    for (uint32_t n = 0; n < tile->header()->directededgecount(); n++, ++edge_id) {
-      const DirectedEdge* edge = tile->directededge(edge_id);
-      if (edge->IsTransitLine() || edge->use() == Use::kTransitConnection ||
-          edge->use() == Use::kEgressConnection || edge->use() == Use::kPlatformConnection ||
-          edge->is_shortcut()) {
-        continue;
+  std::string tile_dir = pt.get<std::string>("mjolnir.tile_dir");
+  std::atomic<size_t> next_tile(0);
+  std::vector<std::vector<std::string>> runs(num_threads);
+  std::vector<std::thread> threads;
+  std::vector<std::exception_ptr> errors(num_threads);
+  for (unsigned int i = 0; i < num_threads; ++i) {
+    auto prefix = tile_dir + filesystem::path::preferred_separator + ".way_edges_" +
+                  std::to_string(i) + "_";
+    threads.emplace_back([&, i, prefix]() {
+      try {
+        collect_edges(pt, tile_ids, next_tile, prefix, runs[i]);
+      } catch (...) {
+        errors[i] = std::current_exception();
       }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
 
-      // Skip if the edge does not allow auto use
-      if (!(edge->forwardaccess() & kAutoAccess)) {
-        continue;
+  // Merge the runs by way id so all of the edges of a way end up on its line
+  std::vector<std::string> all_runs;
+  for (const auto& thread_runs : runs) {
+    all_runs.insert(all_runs.end(), thread_runs.cbegin(), thread_runs.cend());
+  }
+  int status = EXIT_SUCCESS;
+  try {
+    for (const auto& error : errors) {
+      if (error) {
+        std::rethrow_exception(error);
       }
-
-      // Get the way Id
-      uint64_t wayid = tile->edgeinfo(edge).wayid();
-      ways_edges[wayid].push_back({edge->forward(), edge_id});
     }
+    LOG_INFO("Merging " + std::to_string(all_runs.size()) + " runs of sorted edges");
+    std::ofstream ways_file;
+    std::string fname = tile_dir + filesystem::path::preferred_separator + "way_edges.txt";
+    ways_file.open(fname, std::ofstream::out | std::ofstream::trunc);
+    merge_runs(all_runs, ways_file);
+    ways_file.close();
+  } catch (const std::exception& e) {
+    LOG_ERROR(e.what());
+    status = EXIT_FAILURE;
   }
-
-  std::ofstream ways_file;
-  std::string fname = pt.get<std::string>("mjolnir.tile_dir") +
-                      filesystem::path::preferred_separator + "way_edges.txt";
-  ways_file.open(fname, std::ofstream::out | std::ofstream::trunc);
-  for (const auto& way : ways_edges) {
-    ways_file << way.first;
-    for (auto edge : way.second) {
-      ways_file << "," << (uint32_t)edge.forward << "," << (uint64_t)edge.edgeid;
-    }
-    ways_file << std::endl;
+  for (const auto& run : all_runs) {
+    filesystem::remove(run);
   }
-  ways_file.close();
 
-  return EXIT_SUCCESS;
+  return status;
 }
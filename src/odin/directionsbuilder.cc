@@ -1,5 +1,7 @@
 #include <iostream>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "midgard/logging.h"
 #include "odin/directionsbuilder.h"
@@ -65,42 +67,62 @@ const std::unordered_map<int, DirectionsLeg_TravelMode> translate_travel_mode{
 // NarrativeBuilder::Build to form the maneuver list. This method
 // calls PopulateDirectionsLeg to transform the maneuver list into the
 // trip directions.
-void DirectionsBuilder::Build(Api& api) {
-  const auto& options = api.options();
+void DirectionsBuilder::Build(Api& api, DirectionsWorkers* workers) {
+  // Make room for the directions of every leg up front so that each can be built on its own
+  std::vector<std::pair<TripLeg*, DirectionsLeg*>> legs;
   for (auto& trip_route : *api.mutable_trip()->mutable_routes()) {
     auto& directions_route = *api.mutable_directions()->mutable_routes()->Add();
     for (auto& trip_path : *trip_route.mutable_legs()) {
-      auto& trip_directions = *directions_route.mutable_legs()->Add();
-
-      // Validate trip path node list
-      if (trip_path.node_size() < 1) {
-        throw valhalla_exception_t{210};
-      }
-
-      // Create an enhanced trip path from the specified trip_path
-      EnhancedTripLeg etp(trip_path);
-
-      // Produce maneuvers if desired
-      std::list<Maneuver> maneuvers;
-      if (options.directions_type() != DirectionsType::none) {
-        // Update the heading of ~0 length edges
-        UpdateHeading(&etp);
+      legs.emplace_back(&trip_path, directions_route.mutable_legs()->Add());
+    }
+  }
 
-        ManeuversBuilder maneuversBuilder(options, &etp);
-        maneuvers = maneuversBuilder.Build();
+  // The legs of all the routes dont depend on each other so they can be built on the threads
+  const auto& options = api.options();
+  if (workers && legs.size() > 1) {
+    workers->Run(legs.size(), [&options, &legs](uint32_t i) {
+      BuildLeg(options, *legs[i].first, *legs[i].second);
+    });
+    return;
+  }
+  for (auto& leg : legs) {
+    BuildLeg(options, *leg.first, *leg.second);
+  }
+}
 
-        // Create the instructions if desired
-        if (options.directions_type() == DirectionsType::instructions) {
-          std::unique_ptr<NarrativeBuilder> narrative_builder =
-              NarrativeBuilderFactory::Create(options, &etp);
-          narrative_builder->Build(maneuvers);
-        }
-      }
+// Builds the directions of one leg of a route
+void DirectionsBuilder::BuildLeg(const Options& options,
+                                 TripLeg& trip_path,
+                                 DirectionsLeg& trip_directions) {
+  // Validate trip path node list
+  if (trip_path.node_size() < 1) {
+    throw valhalla_exception_t{210};
+  }
 
-      // Return trip directions
-      PopulateDirectionsLeg(options, &etp, maneuvers, trip_directions);
+  // Create an enhanced trip path from the specified trip_path
+  EnhancedTripLeg etp(trip_path);
+
+  // Produce maneuvers if desired
+  std::list<Maneuver> maneuvers;
+  if (options.directions_type() != DirectionsType::none) {
+    // Update the heading of ~0 length edges
+    UpdateHeading(&etp);
+
+    ManeuversBuilder maneuversBuilder(options, &etp);
+    maneuvers = maneuversBuilder.Build();
+
+    // Create the instructions if desired and they will be serialized. Gpx has no instructions
+    // and the osrm serializer only writes out the text ones
+    if (options.directions_type() == DirectionsType::instructions &&
+        options.format() != Options::gpx) {
+      std::unique_ptr<NarrativeBuilder> narrative_builder =
+          NarrativeBuilderFactory::Create(options, &etp);
+      narrative_builder->Build(maneuvers, options.format() != Options::osrm);
     }
   }
+
+  // Return trip directions
+  PopulateDirectionsLeg(options, &etp, maneuvers, trip_directions);
 }
 
 // Update the heading of ~0 length edges.
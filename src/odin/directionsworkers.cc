@@ -0,0 +1,82 @@
+#include "odin/directionsworkers.h"
+
+namespace valhalla {
+namespace odin {
+
+DirectionsWorkers::DirectionsWorkers(const uint32_t thread_count) {
+  for (uint32_t i = 0; i < thread_count; ++i) {
+    threads_.emplace_back([this]() { Work(); });
+  }
+}
+
+DirectionsWorkers::~DirectionsWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    ++generation_;
+  }
+  wake_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void DirectionsWorkers::Run(const uint32_t count, const step_t& step) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    step_ = &step;
+    count_ = count;
+    next_.store(0);
+    busy_ = threads_.size();
+    ++generation_;
+  }
+  wake_.notify_all();
+
+  // a leg takes milliseconds to narrate so the threads can sleep until every one of them is done
+  Take();
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this]() { return busy_ == 0; });
+  step_ = nullptr;
+  if (error_) {
+    auto error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void DirectionsWorkers::Take() {
+  for (auto i = next_.fetch_add(1); i < count_; i = next_.fetch_add(1)) {
+    try {
+      (*step_)(i);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!error_) {
+        error_ = std::current_exception();
+      }
+      // no point in building the rest of the legs
+      next_.store(count_);
+    }
+  }
+}
+
+void DirectionsWorkers::Work() {
+  uint64_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [this, seen]() { return generation_ != seen; });
+      seen = generation_;
+      if (stop_) {
+        return;
+      }
+    }
+    Take();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--busy_ == 0) {
+      done_.notify_one();
+    }
+  }
+}
+
+} // namespace odin
+} // namespace valhalla
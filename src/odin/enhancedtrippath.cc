@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
@@ -211,28 +212,45 @@ namespace odin {
 EnhancedTripLeg::EnhancedTripLeg(TripLeg& trip_path) : trip_path_(trip_path) {
 }
 
-std::unique_ptr<EnhancedTripLeg_Node> EnhancedTripLeg::GetEnhancedNode(const int node_index) {
-  return std::make_unique<EnhancedTripLeg_Node>(mutable_node(node_index));
+EnhancedTripLeg_Node* EnhancedTripLeg::GetEnhancedNode(const int node_index) {
+  if (static_cast<size_t>(node_index) >= nodes_.size()) {
+    nodes_.resize(std::max(node_index + 1, node_size()));
+  }
+  auto& node = nodes_[node_index];
+  if (!node) {
+    node = std::make_unique<EnhancedTripLeg_Node>(mutable_node(node_index));
+  }
+  return node.get();
+}
+
+EnhancedTripLeg_Edge* EnhancedTripLeg::GetEdge(int node_index) const {
+  if (static_cast<size_t>(node_index) >= edges_.size()) {
+    edges_.resize(node_size());
+  }
+  auto& edge = edges_[node_index];
+  if (!edge) {
+    edge = std::make_unique<EnhancedTripLeg_Edge>(mutable_node(node_index)->mutable_edge());
+  }
+  return edge.get();
 }
 
-std::unique_ptr<EnhancedTripLeg_Edge> EnhancedTripLeg::GetPrevEdge(const int node_index, int delta) {
+EnhancedTripLeg_Edge* EnhancedTripLeg::GetPrevEdge(const int node_index, int delta) {
   int index = node_index - delta;
   if (IsValidNodeIndex(index)) {
-    return std::make_unique<EnhancedTripLeg_Edge>(mutable_node(index)->mutable_edge());
+    return GetEdge(index);
   } else {
     return nullptr;
   }
 }
 
-std::unique_ptr<EnhancedTripLeg_Edge> EnhancedTripLeg::GetCurrEdge(const int node_index) const {
+EnhancedTripLeg_Edge* EnhancedTripLeg::GetCurrEdge(const int node_index) const {
   return GetNextEdge(node_index, 0);
 }
 
-std::unique_ptr<EnhancedTripLeg_Edge> EnhancedTripLeg::GetNextEdge(const int node_index,
-                                                                   int delta) const {
+EnhancedTripLeg_Edge* EnhancedTripLeg::GetNextEdge(const int node_index, int delta) const {
   int index = node_index + delta;
   if (IsValidNodeIndex(index) && !IsLastNodeIndex(index)) {
-    return std::make_unique<EnhancedTripLeg_Edge>(mutable_node(index)->mutable_edge());
+    return GetEdge(index);
   } else {
     return nullptr;
   }
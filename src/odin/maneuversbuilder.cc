@@ -87,6 +87,12 @@ ManeuversBuilder::ManeuversBuilder(const Options& options, EnhancedTripLeg* etp)
     : options_(options), trip_path_(etp) {
 }
 
+std::unique_ptr<StreetNames>
+ManeuversBuilder::GetStreetNames(uint32_t node_index, const EnhancedTripLeg_Edge& edge) const {
+  return StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), edge.GetNameList(),
+                                    &interned_street_names_);
+}
+
 std::list<Maneuver> ManeuversBuilder::Build() {
   // Create the maneuvers
   std::list<Maneuver> maneuvers = Produce();
@@ -1186,8 +1192,7 @@ void ManeuversBuilder::UpdateManeuver(Maneuver& maneuver, int node_index) {
   // or usable internal intersection name exists
   if ((maneuver.street_names().empty() && !maneuver.internal_intersection()) ||
       UsableInternalIntersectionName(maneuver, node_index)) {
-    maneuver.set_street_names(
-        StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), prev_edge->GetNameList()));
+    maneuver.set_street_names(GetStreetNames(node_index, *prev_edge));
   }
 
   // Update the internal turn count
@@ -1355,8 +1360,7 @@ void ManeuversBuilder::FinalizeManeuver(Maneuver& maneuver, int node_index) {
   // Set begin street names
   if (!curr_edge->IsHighway() && !curr_edge->internal_intersection() &&
       (curr_edge->name_size() > 1)) {
-    std::unique_ptr<StreetNames> curr_edge_names =
-        StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), curr_edge->GetNameList());
+    std::unique_ptr<StreetNames> curr_edge_names = GetStreetNames(node_index, *curr_edge);
     std::unique_ptr<StreetNames> common_base_names =
         curr_edge_names->FindCommonBaseNames(maneuver.street_names());
     if (curr_edge_names->size() > common_base_names->size()) {
@@ -1578,7 +1582,7 @@ void ManeuversBuilder::SetManeuverType(Maneuver& maneuver, bool none_type_allowe
     }
   }
   // Process merge
-  else if (IsMergeManeuverType(maneuver, prev_edge.get(), curr_edge.get())) {
+  else if (IsMergeManeuverType(maneuver, prev_edge, curr_edge)) {
     switch (maneuver.merge_to_relative_direction()) {
       case Maneuver::RelativeDirection::kKeepRight: {
         maneuver.set_type(DirectionsLeg_Maneuver_Type_kMergeRight);
@@ -1609,7 +1613,7 @@ void ManeuversBuilder::SetManeuverType(Maneuver& maneuver, bool none_type_allowe
   // Process simple direction
   else {
     LOG_TRACE("ManeuverType=SIMPLE");
-    SetSimpleDirectionalManeuverType(maneuver, prev_edge.get(), curr_edge.get());
+    SetSimpleDirectionalManeuverType(maneuver, prev_edge, curr_edge);
   }
 }
 
@@ -1989,8 +1993,8 @@ bool ManeuversBuilder::CanManeuverIncludePrevEdge(Maneuver& maneuver, int node_i
 
   /////////////////////////////////////////////////////////////////////////////
   // Process fork
-  if (IsFork(node_index, prev_edge.get(), curr_edge.get()) ||
-      IsPedestrianFork(node_index, prev_edge.get(), curr_edge.get())) {
+  if (IsFork(node_index, prev_edge, curr_edge) ||
+      IsPedestrianFork(node_index, prev_edge, curr_edge)) {
     maneuver.set_fork(true);
     return false;
   }
@@ -2079,12 +2083,12 @@ bool ManeuversBuilder::CanManeuverIncludePrevEdge(Maneuver& maneuver, int node_i
 
   /////////////////////////////////////////////////////////////////////////////
   // Process pencil point u-turns
-  if (IsLeftPencilPointUturn(node_index, prev_edge.get(), curr_edge.get())) {
+  if (IsLeftPencilPointUturn(node_index, prev_edge, curr_edge)) {
     maneuver.set_type(DirectionsLeg_Maneuver_Type_kUturnLeft);
     LOG_TRACE("ManeuverType=PENCIL_POINT_UTURN_LEFT");
     return false;
   }
-  if (IsRightPencilPointUturn(node_index, prev_edge.get(), curr_edge.get())) {
+  if (IsRightPencilPointUturn(node_index, prev_edge, curr_edge)) {
     maneuver.set_type(DirectionsLeg_Maneuver_Type_kUturnRight);
     LOG_TRACE("ManeuverType=PENCIL_POINT_UTURN_RIGHT");
     return false;
@@ -2092,7 +2096,7 @@ bool ManeuversBuilder::CanManeuverIncludePrevEdge(Maneuver& maneuver, int node_i
 
   /////////////////////////////////////////////////////////////////////////////
   // Intersecting forward edge
-  if (IsIntersectingForwardEdge(node_index, prev_edge.get(), curr_edge.get())) {
+  if (IsIntersectingForwardEdge(node_index, prev_edge, curr_edge)) {
     maneuver.set_intersecting_forward_edge(true);
     LOG_TRACE("IntersectingForwardEdge");
     return false;
@@ -2100,14 +2104,13 @@ bool ManeuversBuilder::CanManeuverIncludePrevEdge(Maneuver& maneuver, int node_i
 
   /////////////////////////////////////////////////////////////////////////////
   // Determine previous edge names and common base names
-  std::unique_ptr<StreetNames> prev_edge_names =
-      StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), prev_edge->GetNameList());
+  std::unique_ptr<StreetNames> prev_edge_names = GetStreetNames(node_index, *prev_edge);
   std::unique_ptr<StreetNames> common_base_names =
       prev_edge_names->FindCommonBaseNames(maneuver.street_names());
 
   /////////////////////////////////////////////////////////////////////////////
   // Process 'T' intersection
-  if (IsTee(node_index, prev_edge.get(), curr_edge.get(), !common_base_names->empty())) {
+  if (IsTee(node_index, prev_edge, curr_edge, !common_base_names->empty())) {
     maneuver.set_tee(true);
     LOG_TRACE("T intersection");
     return false;
@@ -2135,7 +2138,7 @@ bool ManeuversBuilder::CanManeuverIncludePrevEdge(Maneuver& maneuver, int node_i
   /////////////////////////////////////////////////////////////////////////////
   // Process unnamed edge
   if (!maneuver.HasStreetNames() && prev_edge->IsUnnamed() &&
-      IncludeUnnamedPrevEdge(node_index, prev_edge.get(), curr_edge.get())) {
+      IncludeUnnamedPrevEdge(node_index, prev_edge, curr_edge)) {
     return true;
   }
 
@@ -2194,7 +2197,7 @@ bool ManeuversBuilder::IsMergeManeuverType(Maneuver& maneuver,
         curr_edge->IsOneway() && curr_edge->IsForward(maneuver.turn_degree()) &&
         node->HasIntersectingEdgeCurrNameConsistency()))) {
     maneuver.set_merge_to_relative_direction(
-        DetermineMergeToRelativeDirection(node.get(), prev_edge));
+        DetermineMergeToRelativeDirection(node, prev_edge));
     return true;
   }
 
@@ -2440,11 +2443,9 @@ bool ManeuversBuilder::IsLeftPencilPointUturn(int node_index,
     node->CalculateRightLeftIntersectingEdgeCounts(prev_edge->end_heading(), prev_edge->travel_mode(),
                                                    xedge_counts);
 
-    std::unique_ptr<StreetNames> prev_edge_names =
-        StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), prev_edge->GetNameList());
+    std::unique_ptr<StreetNames> prev_edge_names = GetStreetNames(node_index, *prev_edge);
 
-    std::unique_ptr<StreetNames> curr_edge_names =
-        StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), curr_edge->GetNameList());
+    std::unique_ptr<StreetNames> curr_edge_names = GetStreetNames(node_index, *curr_edge);
 
     // Process common base names
     std::unique_ptr<StreetNames> common_base_names =
@@ -2479,11 +2480,9 @@ bool ManeuversBuilder::IsRightPencilPointUturn(int node_index,
     node->CalculateRightLeftIntersectingEdgeCounts(prev_edge->end_heading(), prev_edge->travel_mode(),
                                                    xedge_counts);
 
-    std::unique_ptr<StreetNames> prev_edge_names =
-        StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), prev_edge->GetNameList());
+    std::unique_ptr<StreetNames> prev_edge_names = GetStreetNames(node_index, *prev_edge);
 
-    std::unique_ptr<StreetNames> curr_edge_names =
-        StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), curr_edge->GetNameList());
+    std::unique_ptr<StreetNames> curr_edge_names = GetStreetNames(node_index, *curr_edge);
 
     // Process common base names
     std::unique_ptr<StreetNames> common_base_names =
@@ -3037,9 +3036,8 @@ void ManeuversBuilder::EnhanceSignlessInterchnages(std::list<Maneuver>& maneuver
   }
 }
 
-uint16_t
-ManeuversBuilder::GetExpectedTurnLaneDirection(std::unique_ptr<EnhancedTripLeg_Edge>& turn_lane_edge,
-                                               const Maneuver& maneuver) const {
+uint16_t ManeuversBuilder::GetExpectedTurnLaneDirection(EnhancedTripLeg_Edge* turn_lane_edge,
+                                                        const Maneuver& maneuver) const {
   if (turn_lane_edge) {
     switch (maneuver.type()) {
       case valhalla::DirectionsLeg_Maneuver_Type_kUturnLeft:
@@ -3458,7 +3456,7 @@ void ManeuversBuilder::UpdateManeuverPlacementForInternalIntersectionTurns(
               is_relative_straight(GetTurnDegree(prev_edge->end_heading(), edge->begin_heading()))) {
             // Add straight internal edge to previous maneuver
             MoveInternalEdgeToPreviousManeuver(*prev_maneuver, maneuver, new_node_index,
-                                               prev_edge.get(), edge.get());
+                                               prev_edge, edge);
           } else {
             // Exit form the edge loop
             break;
@@ -1,3 +1,4 @@
+#include <cstring>
 #include <stdexcept>
 
 #include <boost/property_tree/ptree.hpp>
@@ -316,10 +317,89 @@ void NarrativeDictionary::Load(const boost::property_tree::ptree& narrative_pt)
   Load(approach_verbal_alert_subset, narrative_pt.get_child(kApproachVerbalAlertKey));
 }
 
+NarrativeTemplate::NarrativeTemplate(const std::string& phrase) : phrase_(phrase), defined_(true) {
+  // Tags look like <UPPER_CASE> anything else is just text
+  const auto is_tag_char = [](char c) { return (c >= 'A' && c <= 'Z') || c == '_'; };
+  size_t text = 0;
+  for (size_t i = 0; i < phrase_.size(); ++i) {
+    if (phrase_[i] != '<') {
+      continue;
+    }
+    size_t end = i + 1;
+    while (end < phrase_.size() && is_tag_char(phrase_[end])) {
+      ++end;
+    }
+    if (end == i + 1 || end == phrase_.size() || phrase_[end] != '>') {
+      continue;
+    }
+    if (i > text) {
+      pieces_.push_back({static_cast<uint32_t>(text), static_cast<uint32_t>(i - text), false});
+    }
+    pieces_.push_back({static_cast<uint32_t>(i), static_cast<uint32_t>(end + 1 - i), true});
+    text = end + 1;
+    i = end;
+  }
+  if (text < phrase_.size()) {
+    pieces_.push_back(
+        {static_cast<uint32_t>(text), static_cast<uint32_t>(phrase_.size() - text), false});
+  }
+}
+
+std::string NarrativeTemplate::Format(std::initializer_list<TagValue> values) const {
+  size_t size = phrase_.size();
+  for (const auto& value : values) {
+    size += value.value.size();
+  }
+  std::string formatted;
+  formatted.reserve(size);
+
+  for (const auto& piece : pieces_) {
+    const char* text = phrase_.data() + piece.offset;
+    const std::string* value = nullptr;
+    if (piece.is_tag) {
+      for (const auto& tag_value : values) {
+        if (std::strlen(tag_value.tag) == piece.size &&
+            std::memcmp(tag_value.tag, text, piece.size) == 0) {
+          value = &tag_value.value;
+          break;
+        }
+      }
+    }
+    if (value) {
+      formatted.append(*value);
+    } else {
+      formatted.append(text, piece.size);
+    }
+  }
+  return formatted;
+}
+
+const NarrativeTemplate& PhraseSet::phrase(size_t id) const {
+  if (id >= templates.size() || !templates[id].defined()) {
+    throw std::out_of_range("No phrase " + std::to_string(id));
+  }
+  return templates[id];
+}
+
 void NarrativeDictionary::Load(PhraseSet& phrase_handle,
                                const boost::property_tree::ptree& phrase_pt) {
 
   phrase_handle.phrases = as_unordered_map<std::string, std::string>(phrase_pt, kPhrasesKey);
+
+  // Compile the phrases up front, they are all keyed by their index
+  phrase_handle.templates.clear();
+  for (const auto& phrase : phrase_handle.phrases) {
+    size_t id;
+    try {
+      id = std::stoul(phrase.first);
+    } catch (...) {
+      throw std::runtime_error("Phrase key " + phrase.first + " is not a number");
+    }
+    if (id >= phrase_handle.templates.size()) {
+      phrase_handle.templates.resize(id + 1);
+    }
+    phrase_handle.templates[id] = NarrativeTemplate(phrase.second);
+  }
 }
 
 void NarrativeDictionary::Load(StartSubset& start_handle,
@@ -47,7 +47,7 @@ NarrativeBuilder::NarrativeBuilder(const Options& options,
       articulated_preposition_enabled_(false) {
 }
 
-void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
+void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers, bool verbal) {
   Maneuver* prev_maneuver = nullptr;
   for (auto& maneuver : maneuvers) {
     switch (maneuver.type()) {
@@ -59,6 +59,10 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set instruction
         maneuver.set_instruction(FormStartInstruction(maneuver));
 
+        if (!verbal) {
+          break;
+        }
+
         // Set verbal succinct transition instruction
         maneuver.set_verbal_succinct_transition_instruction(
             FormVerbalSuccinctStartTransitionInstruction(maneuver));
@@ -77,6 +81,10 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set instruction
         maneuver.set_instruction(FormDestinationInstruction(maneuver));
 
+        if (!verbal) {
+          break;
+        }
+
         // Set verbal transition alert instruction
         maneuver.set_verbal_transition_alert_instruction(
             FormVerbalAlertDestinationInstruction(maneuver));
@@ -89,7 +97,13 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         if (prev_maneuver) {
           // Set instruction
           maneuver.set_instruction(FormBecomesInstruction(maneuver, prev_maneuver));
+        }
 
+        if (!verbal) {
+          break;
+        }
+
+        if (prev_maneuver) {
           // Set verbal pre transition instruction
           maneuver.set_verbal_pre_transition_instruction(
               FormVerbalBecomesInstruction(maneuver, prev_maneuver));
@@ -113,6 +127,10 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set instruction
         maneuver.set_instruction(FormTurnInstruction(maneuver));
 
+        if (!verbal) {
+          break;
+        }
+
         // Set verbal succinct transition instruction
         maneuver.set_verbal_succinct_transition_instruction(
             FormVerbalSuccinctTurnTransitionInstruction(maneuver));
@@ -133,6 +151,10 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set instruction
         maneuver.set_instruction(FormUturnInstruction(maneuver));
 
+        if (!verbal) {
+          break;
+        }
+
         // Set verbal succinct transition instruction
         maneuver.set_verbal_succinct_transition_instruction(
             FormVerbalSuccinctUturnTransitionInstruction(maneuver));
@@ -152,6 +174,10 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set instruction
         maneuver.set_instruction(FormRampStraightInstruction(maneuver));
 
+        if (!verbal) {
+          break;
+        }
+
         // Set verbal transition alert instruction
         maneuver.set_verbal_transition_alert_instruction(
             FormVerbalAlertRampStraightInstruction(maneuver));
@@ -175,6 +201,10 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set instruction
         maneuver.set_instruction(FormRampInstruction(maneuver));
 
+        if (!verbal) {
+          break;
+        }
+
         // Set verbal transition alert instruction
         maneuver.set_verbal_transition_alert_instruction(FormVerbalAlertRampInstruction(maneuver));
 
@@ -197,6 +227,10 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set instruction
         maneuver.set_instruction(FormExitInstruction(maneuver));
 
+        if (!verbal) {
+          break;
+        }
+
         // Set verbal transition alert instruction
         maneuver.set_verbal_transition_alert_instruction(FormVerbalAlertExitInstruction(maneuver));
 
@@ -221,6 +255,10 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
           // Set stay on instruction
           maneuver.set_instruction(FormKeepToStayOnInstruction(maneuver));
 
+          if (!verbal) {
+            break;
+          }
+
           // Set verbal transition alert instruction
           maneuver.set_verbal_transition_alert_instruction(
               FormVerbalAlertKeepToStayOnInstruction(maneuver));
@@ -244,6 +282,10 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
           // Set instruction
           maneuver.set_instruction(FormKeepInstruction(maneuver));
 
+          if (!verbal) {
+            break;
+          }
+
           // Set verbal transition alert instruction
           maneuver.set_verbal_transition_alert_instruction(FormVerbalAlertKeepInstruction(maneuver));
 
@@ -271,6 +313,10 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set instruction
         maneuver.set_instruction(FormMergeInstruction(maneuver));
 
+        if (!verbal) {
+          break;
+        }
+
         // Set verbal succinct transition instruction
         maneuver.set_verbal_succinct_transition_instruction(
             FormVerbalSuccinctMergeTransitionInstruction(maneuver));
@@ -294,6 +340,10 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set instruction
         maneuver.set_instruction(FormEnterRoundaboutInstruction(maneuver));
 
+        if (!verbal) {
+          break;
+        }
+
         // Set verbal succinct transition instruction
         maneuver.set_verbal_succinct_transition_instruction(
             FormVerbalSuccinctEnterRoundaboutTransitionInstruction(maneuver));
@@ -319,6 +369,10 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set instruction
         maneuver.set_instruction(FormExitRoundaboutInstruction(maneuver));
 
+        if (!verbal) {
+          break;
+        }
+
         // Set verbal succinct transition instruction
         maneuver.set_verbal_succinct_transition_instruction(
             FormVerbalSuccinctExitRoundaboutTransitionInstruction(maneuver));
@@ -335,6 +389,10 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set instruction
         maneuver.set_instruction(FormEnterFerryInstruction(maneuver));
 
+        if (!verbal) {
+          break;
+        }
+
         // Set verbal transition alert instruction
         maneuver.set_verbal_transition_alert_instruction(
             FormVerbalAlertEnterFerryInstruction(maneuver));
@@ -351,6 +409,10 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set instruction
         maneuver.set_instruction(FormTransitConnectionStartInstruction(maneuver));
 
+        if (!verbal) {
+          break;
+        }
+
         // Set verbal pre transition instruction
         maneuver.set_verbal_pre_transition_instruction(
             FormVerbalTransitConnectionStartInstruction(maneuver));
@@ -364,6 +426,10 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set instruction
         maneuver.set_instruction(FormTransitConnectionTransferInstruction(maneuver));
 
+        if (!verbal) {
+          break;
+        }
+
         // Set verbal pre transition instruction
         maneuver.set_verbal_pre_transition_instruction(
             FormVerbalTransitConnectionTransferInstruction(maneuver));
@@ -377,6 +443,10 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set instruction
         maneuver.set_instruction(FormTransitConnectionDestinationInstruction(maneuver));
 
+        if (!verbal) {
+          break;
+        }
+
         // Set verbal pre transition instruction
         maneuver.set_verbal_pre_transition_instruction(
             FormVerbalTransitConnectionDestinationInstruction(maneuver));
@@ -390,12 +460,19 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set depart instruction
         maneuver.set_depart_instruction(FormDepartInstruction(maneuver));
 
-        // Set verbal depart instruction
-        maneuver.set_verbal_depart_instruction(FormVerbalDepartInstruction(maneuver));
-
         // Set instruction
         maneuver.set_instruction(FormTransitInstruction(maneuver));
 
+        // Set arrive instruction
+        maneuver.set_arrive_instruction(FormArriveInstruction(maneuver));
+
+        if (!verbal) {
+          break;
+        }
+
+        // Set verbal depart instruction
+        maneuver.set_verbal_depart_instruction(FormVerbalDepartInstruction(maneuver));
+
         // Set verbal pre transition instruction
         maneuver.set_verbal_pre_transition_instruction(FormVerbalTransitInstruction(maneuver));
 
@@ -403,9 +480,6 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         maneuver.set_verbal_post_transition_instruction(
             FormVerbalPostTransitionTransitInstruction(maneuver));
 
-        // Set arrive instruction
-        maneuver.set_arrive_instruction(FormArriveInstruction(maneuver));
-
         // Set verbal arrive instruction
         maneuver.set_verbal_arrive_instruction(FormVerbalArriveInstruction(maneuver));
 
@@ -415,12 +489,19 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set depart instruction
         maneuver.set_depart_instruction(FormDepartInstruction(maneuver));
 
-        // Set verbal depart instruction
-        maneuver.set_verbal_depart_instruction(FormVerbalDepartInstruction(maneuver));
-
         // Set instruction
         maneuver.set_instruction(FormTransitRemainOnInstruction(maneuver));
 
+        // Set arrive instruction
+        maneuver.set_arrive_instruction(FormArriveInstruction(maneuver));
+
+        if (!verbal) {
+          break;
+        }
+
+        // Set verbal depart instruction
+        maneuver.set_verbal_depart_instruction(FormVerbalDepartInstruction(maneuver));
+
         // Set verbal pre transition instruction
         maneuver.set_verbal_pre_transition_instruction(
             FormVerbalTransitRemainOnInstruction(maneuver));
@@ -429,9 +510,6 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         maneuver.set_verbal_post_transition_instruction(
             FormVerbalPostTransitionTransitInstruction(maneuver));
 
-        // Set arrive instruction
-        maneuver.set_arrive_instruction(FormArriveInstruction(maneuver));
-
         // Set verbal arrive instruction
         maneuver.set_verbal_arrive_instruction(FormVerbalArriveInstruction(maneuver));
 
@@ -441,12 +519,19 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set depart instruction
         maneuver.set_depart_instruction(FormDepartInstruction(maneuver));
 
-        // Set verbal depart instruction
-        maneuver.set_verbal_depart_instruction(FormVerbalDepartInstruction(maneuver));
-
         // Set instruction
         maneuver.set_instruction(FormTransitTransferInstruction(maneuver));
 
+        // Set arrive instruction
+        maneuver.set_arrive_instruction(FormArriveInstruction(maneuver));
+
+        if (!verbal) {
+          break;
+        }
+
+        // Set verbal depart instruction
+        maneuver.set_verbal_depart_instruction(FormVerbalDepartInstruction(maneuver));
+
         // Set verbal pre transition instruction
         maneuver.set_verbal_pre_transition_instruction(
             FormVerbalTransitTransferInstruction(maneuver));
@@ -455,9 +540,6 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         maneuver.set_verbal_post_transition_instruction(
             FormVerbalPostTransitionTransitInstruction(maneuver));
 
-        // Set arrive instruction
-        maneuver.set_arrive_instruction(FormArriveInstruction(maneuver));
-
         // Set verbal arrive instruction
         maneuver.set_verbal_arrive_instruction(FormVerbalArriveInstruction(maneuver));
         break;
@@ -467,6 +549,10 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
         // Set instruction
         maneuver.set_instruction(FormContinueInstruction(maneuver));
 
+        if (!verbal) {
+          break;
+        }
+
         // Set verbal transition alert instruction
         maneuver.set_verbal_transition_alert_instruction(
             FormVerbalAlertContinueInstruction(maneuver));
@@ -488,7 +574,9 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
   }
 
   // Iterate over maneuvers to form verbal multi-cue instructions
-  FormVerbalMultiCue(maneuvers);
+  if (verbal) {
+    FormVerbalMultiCue(maneuvers);
+  }
 }
 
 std::string NarrativeBuilder::FormVerbalAlertApproachInstruction(float distance,
@@ -497,14 +585,12 @@ std::string NarrativeBuilder::FormVerbalAlertApproachInstruction(float distance,
   instruction.reserve(kInstructionInitialCapacity);
   uint8_t phrase_id = 0;
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.approach_verbal_alert_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(distance, dictionary_.approach_verbal_alert_subset.metric_lengths,
-                                dictionary_.approach_verbal_alert_subset.us_customary_lengths));
-  boost::replace_all(instruction, kCurrentVerbalCueTag, verbal_cue);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.approach_verbal_alert_subset.phrase(phrase_id).Format({
+      {kLengthTag, FormLength(distance, dictionary_.approach_verbal_alert_subset.metric_lengths,
+                              dictionary_.approach_verbal_alert_subset.us_customary_lengths)},
+      {kCurrentVerbalCueTag, verbal_cue},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -562,13 +648,12 @@ std::string NarrativeBuilder::FormStartInstruction(Maneuver& maneuver) {
     phrase_id += 16;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.start_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.start_subset.phrase(phrase_id).Format({
+      {kCardinalDirectionTag, cardinal_direction},
+      {kStreetNamesTag, street_names},
+      {kBeginStreetNamesTag, begin_street_names},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -649,16 +734,14 @@ std::string NarrativeBuilder::FormVerbalStartInstruction(Maneuver& maneuver,
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.start_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.start_verbal_subset.metric_lengths,
-                                dictionary_.start_verbal_subset.us_customary_lengths));
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.start_verbal_subset.phrase(phrase_id).Format({
+      {kCardinalDirectionTag, cardinal_direction},
+      {kStreetNamesTag, street_names},
+      {kBeginStreetNamesTag, begin_street_names},
+      {kLengthTag, FormLength(maneuver, dictionary_.start_verbal_subset.metric_lengths,
+                              dictionary_.start_verbal_subset.us_customary_lengths)},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -702,14 +785,11 @@ std::string NarrativeBuilder::FormDestinationInstruction(Maneuver& maneuver) {
     relative_direction = dictionary_.destination_subset.relative_directions.at(1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.destination_subset.phrases.at(std::to_string(phrase_id));
-
-  if (phrase_id > 0) {
-    // Replace phrase tags with values
-    boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-    boost::replace_all(instruction, kDestinationTag, destination);
-  }
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.destination_subset.phrase(phrase_id).Format({
+      {kRelativeDirectionTag, relative_direction},
+      {kDestinationTag, destination},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -758,14 +838,11 @@ std::string NarrativeBuilder::FormVerbalAlertDestinationInstruction(Maneuver& ma
     relative_direction = dictionary_.destination_subset.relative_directions.at(1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.destination_verbal_alert_subset.phrases.at(std::to_string(phrase_id));
-
-  if (phrase_id > 0) {
-    // Replace phrase tags with values
-    boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-    boost::replace_all(instruction, kDestinationTag, destination);
-  }
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.destination_verbal_alert_subset.phrase(phrase_id).Format({
+      {kRelativeDirectionTag, relative_direction},
+      {kDestinationTag, destination},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -814,14 +891,11 @@ std::string NarrativeBuilder::FormVerbalDestinationInstruction(Maneuver& maneuve
     relative_direction = dictionary_.destination_subset.relative_directions.at(1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.destination_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  if (phrase_id > 0) {
-    // Replace phrase tags with values
-    boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-    boost::replace_all(instruction, kDestinationTag, destination);
-  }
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.destination_verbal_subset.phrase(phrase_id).Format({
+      {kRelativeDirectionTag, relative_direction},
+      {kDestinationTag, destination},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -844,12 +918,11 @@ std::string NarrativeBuilder::FormBecomesInstruction(Maneuver& maneuver, Maneuve
   // Determine which phrase to use
   uint8_t phrase_id = 0;
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.becomes_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kPreviousStreetNamesTag, prev_street_names);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.becomes_subset.phrase(phrase_id).Format({
+      {kPreviousStreetNamesTag, prev_street_names},
+      {kStreetNamesTag, street_names},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -879,12 +952,11 @@ std::string NarrativeBuilder::FormVerbalBecomesInstruction(Maneuver& maneuver,
   // Determine which phrase to use
   uint8_t phrase_id = 0;
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.becomes_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kPreviousStreetNamesTag, prev_street_names);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.becomes_verbal_subset.phrase(phrase_id).Format({
+      {kPreviousStreetNamesTag, prev_street_names},
+      {kStreetNamesTag, street_names},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -930,13 +1002,12 @@ std::string NarrativeBuilder::FormContinueInstruction(Maneuver& maneuver,
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.continue_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.continue_subset.phrase(phrase_id).Format({
+      {kStreetNamesTag, street_names},
+      {kJunctionNameTag, junction_name},
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -986,13 +1057,12 @@ std::string NarrativeBuilder::FormVerbalAlertContinueInstruction(Maneuver& maneu
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.continue_verbal_alert_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.continue_verbal_alert_subset.phrase(phrase_id).Format({
+      {kStreetNamesTag, street_names},
+      {kJunctionNameTag, junction_name},
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1051,16 +1121,14 @@ std::string NarrativeBuilder::FormVerbalContinueInstruction(Maneuver& maneuver,
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.continue_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.continue_verbal_subset.metric_lengths,
-                                dictionary_.continue_verbal_subset.us_customary_lengths));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.continue_verbal_subset.phrase(phrase_id).Format({
+      {kLengthTag, FormLength(maneuver, dictionary_.continue_verbal_subset.metric_lengths,
+                              dictionary_.continue_verbal_subset.us_customary_lengths)},
+      {kStreetNamesTag, street_names},
+      {kJunctionNameTag, junction_name},
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1136,16 +1204,14 @@ std::string NarrativeBuilder::FormTurnInstruction(Maneuver& maneuver,
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = subset->phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = subset->phrase(phrase_id).Format({
+      {kRelativeDirectionTag, FormRelativeTwoDirection(maneuver.type(), subset->relative_directions)},
+      {kStreetNamesTag, street_names},
+      {kBeginStreetNamesTag, begin_street_names},
+      {kJunctionNameTag, junction_name},
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1244,16 +1310,14 @@ std::string NarrativeBuilder::FormVerbalTurnInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = subset->phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = subset->phrase(phrase_id).Format({
+      {kRelativeDirectionTag, FormRelativeTwoDirection(maneuver.type(), subset->relative_directions)},
+      {kStreetNamesTag, street_names},
+      {kBeginStreetNamesTag, begin_street_names},
+      {kJunctionNameTag, junction_name},
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1314,17 +1378,15 @@ std::string NarrativeBuilder::FormUturnInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.uturn_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.uturn_subset.relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kCrossStreetNamesTag, cross_street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.uturn_subset.phrase(phrase_id).Format({
+      {kRelativeDirectionTag, FormRelativeTwoDirection(maneuver.type(),
+                                                       dictionary_.uturn_subset.relative_directions)},
+      {kStreetNamesTag, street_names},
+      {kCrossStreetNamesTag, cross_street_names},
+      {kJunctionNameTag, junction_name},
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1469,15 +1531,14 @@ std::string NarrativeBuilder::FormVerbalUturnInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.uturn_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kCrossStreetNamesTag, cross_street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.uturn_verbal_subset.phrase(phrase_id).Format({
+      {kRelativeDirectionTag, relative_dir},
+      {kStreetNamesTag, street_names},
+      {kCrossStreetNamesTag, cross_street_names},
+      {kJunctionNameTag, junction_name},
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1523,13 +1584,12 @@ std::string NarrativeBuilder::FormRampStraightInstruction(Maneuver& maneuver,
         maneuver.signs().GetExitNameString(element_max_count, limit_by_consecutive_count);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_straight_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.ramp_straight_subset.phrase(phrase_id).Format({
+      {kBranchSignTag, exit_branch_sign},
+      {kTowardSignTag, exit_toward_sign},
+      {kNameSignTag, exit_name_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1626,13 +1686,12 @@ std::string NarrativeBuilder::FormVerbalRampStraightInstruction(uint8_t phrase_i
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_straight_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.ramp_straight_verbal_subset.phrase(phrase_id).Format({
+      {kBranchSignTag, exit_branch_sign},
+      {kTowardSignTag, exit_toward_sign},
+      {kNameSignTag, exit_name_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1700,16 +1759,14 @@ std::string NarrativeBuilder::FormRampInstruction(Maneuver& maneuver,
         maneuver.signs().GetExitNameString(element_max_count, limit_by_consecutive_count);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.ramp_subset.relative_directions));
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.ramp_subset.phrase(phrase_id).Format({
+      {kRelativeDirectionTag, FormRelativeTwoDirection(maneuver.type(),
+                                                       dictionary_.ramp_subset.relative_directions)},
+      {kBranchSignTag, exit_branch_sign},
+      {kTowardSignTag, exit_toward_sign},
+      {kNameSignTag, exit_name_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1858,14 +1915,13 @@ std::string NarrativeBuilder::FormVerbalRampInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.ramp_verbal_subset.phrase(phrase_id).Format({
+      {kRelativeDirectionTag, relative_dir},
+      {kBranchSignTag, exit_branch_sign},
+      {kTowardSignTag, exit_toward_sign},
+      {kNameSignTag, exit_name_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1943,17 +1999,15 @@ std::string NarrativeBuilder::FormExitInstruction(Maneuver& maneuver,
         maneuver.signs().GetExitNameString(element_max_count, limit_by_consecutive_count);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.exit_subset.relative_directions));
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.exit_subset.phrase(phrase_id).Format({
+      {kRelativeDirectionTag, FormRelativeTwoDirection(maneuver.type(),
+                                                       dictionary_.exit_subset.relative_directions)},
+      {kNumberSignTag, exit_number_sign},
+      {kBranchSignTag, exit_branch_sign},
+      {kTowardSignTag, exit_toward_sign},
+      {kNameSignTag, exit_name_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2110,15 +2164,14 @@ std::string NarrativeBuilder::FormVerbalExitInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.exit_verbal_subset.phrase(phrase_id).Format({
+      {kRelativeDirectionTag, relative_dir},
+      {kNumberSignTag, exit_number_sign},
+      {kBranchSignTag, exit_branch_sign},
+      {kTowardSignTag, exit_toward_sign},
+      {kNameSignTag, exit_name_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2199,16 +2252,14 @@ std::string NarrativeBuilder::FormKeepInstruction(Maneuver& maneuver,
     phrase_id += 4;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeThreeDirection(maneuver.type(),
-                                                dictionary_.keep_subset.relative_directions));
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, toward_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.keep_subset.phrase(phrase_id).Format({
+      {kRelativeDirectionTag,
+       FormRelativeThreeDirection(maneuver.type(), dictionary_.keep_subset.relative_directions)},
+      {kNumberSignTag, exit_number_sign},
+      {kStreetNamesTag, street_names},
+      {kTowardSignTag, toward_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2388,14 +2439,13 @@ std::string NarrativeBuilder::FormVerbalKeepInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, toward_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.keep_verbal_subset.phrase(phrase_id).Format({
+      {kRelativeDirectionTag, relative_dir},
+      {kNumberSignTag, exit_number_sign},
+      {kStreetNamesTag, street_names},
+      {kTowardSignTag, toward_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2447,16 +2497,15 @@ std::string NarrativeBuilder::FormKeepToStayOnInstruction(Maneuver& maneuver,
     phrase_id += 2;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_to_stay_on_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeThreeDirection(maneuver.type(), dictionary_.keep_to_stay_on_subset
-                                                                     .relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kTowardSignTag, toward_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.keep_to_stay_on_subset.phrase(phrase_id).Format({
+      {kRelativeDirectionTag,
+       FormRelativeThreeDirection(maneuver.type(),
+                                  dictionary_.keep_to_stay_on_subset.relative_directions)},
+      {kStreetNamesTag, street_names},
+      {kNumberSignTag, exit_number_sign},
+      {kTowardSignTag, toward_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2543,14 +2592,13 @@ std::string NarrativeBuilder::FormVerbalKeepToStayOnInstruction(uint8_t phrase_i
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_to_stay_on_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kTowardSignTag, toward_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.keep_to_stay_on_verbal_subset.phrase(phrase_id).Format({
+      {kRelativeDirectionTag, relative_dir},
+      {kStreetNamesTag, street_names},
+      {kNumberSignTag, exit_number_sign},
+      {kTowardSignTag, toward_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2601,13 +2649,12 @@ std::string NarrativeBuilder::FormMergeInstruction(Maneuver& maneuver,
         FormRelativeTwoDirection(maneuver.type(), dictionary_.merge_subset.relative_directions);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.merge_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.merge_subset.phrase(phrase_id).Format({
+      {kRelativeDirectionTag, relative_direction},
+      {kStreetNamesTag, street_names},
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2676,13 +2723,12 @@ std::string NarrativeBuilder::FormVerbalMergeInstruction(Maneuver& maneuver,
                                  dictionary_.merge_verbal_subset.relative_directions);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.merge_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.merge_verbal_subset.phrase(phrase_id).Format({
+      {kRelativeDirectionTag, relative_direction},
+      {kStreetNamesTag, street_names},
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2799,16 +2845,14 @@ std::string NarrativeBuilder::FormEnterRoundaboutInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_roundabout_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kOrdinalValueTag, ordinal_value);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
-  boost::replace_all(instruction, kRoundaboutExitStreetNamesTag, roundabout_exit_street_names);
-  boost::replace_all(instruction, kRoundaboutExitBeginStreetNamesTag,
-                     roundabout_exit_begin_street_names);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.enter_roundabout_subset.phrase(phrase_id).Format({
+      {kOrdinalValueTag, ordinal_value},
+      {kStreetNamesTag, street_names},
+      {kTowardSignTag, guide_sign},
+      {kRoundaboutExitStreetNamesTag, roundabout_exit_street_names},
+      {kRoundaboutExitBeginStreetNamesTag, roundabout_exit_begin_street_names},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2950,16 +2994,14 @@ std::string NarrativeBuilder::FormVerbalEnterRoundaboutInstruction(Maneuver& man
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kOrdinalValueTag, ordinal_value);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
-  boost::replace_all(instruction, kRoundaboutExitStreetNamesTag, roundabout_exit_street_names);
-  boost::replace_all(instruction, kRoundaboutExitBeginStreetNamesTag,
-                     roundabout_exit_begin_street_names);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.enter_roundabout_verbal_subset.phrase(phrase_id).Format({
+      {kOrdinalValueTag, ordinal_value},
+      {kStreetNamesTag, street_names},
+      {kTowardSignTag, guide_sign},
+      {kRoundaboutExitStreetNamesTag, roundabout_exit_street_names},
+      {kRoundaboutExitBeginStreetNamesTag, roundabout_exit_begin_street_names},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3013,13 +3055,12 @@ std::string NarrativeBuilder::FormExitRoundaboutInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_roundabout_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.exit_roundabout_subset.phrase(phrase_id).Format({
+      {kStreetNamesTag, street_names},
+      {kBeginStreetNamesTag, begin_street_names},
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3077,13 +3118,12 @@ std::string NarrativeBuilder::FormVerbalExitRoundaboutInstruction(Maneuver& mane
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.exit_roundabout_verbal_subset.phrase(phrase_id).Format({
+      {kStreetNamesTag, street_names},
+      {kBeginStreetNamesTag, begin_street_names},
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3127,13 +3167,12 @@ std::string NarrativeBuilder::FormEnterFerryInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_ferry_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kFerryLabelTag, ferry_label);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.enter_ferry_subset.phrase(phrase_id).Format({
+      {kStreetNamesTag, street_names},
+      {kFerryLabelTag, ferry_label},
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3194,13 +3233,12 @@ std::string NarrativeBuilder::FormVerbalEnterFerryInstruction(Maneuver& maneuver
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_ferry_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kFerryLabelTag, ferry_label);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.enter_ferry_verbal_subset.phrase(phrase_id).Format({
+      {kStreetNamesTag, street_names},
+      {kFerryLabelTag, ferry_label},
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3233,12 +3271,11 @@ std::string NarrativeBuilder::FormTransitConnectionStartInstruction(Maneuver& ma
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_connection_start_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.transit_connection_start_subset.phrase(phrase_id).Format({
+      {kTransitPlatformTag, transit_stop},
+      {kStationLabelTag, station_label},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3271,13 +3308,11 @@ std::string NarrativeBuilder::FormVerbalTransitConnectionStartInstruction(Maneuv
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.transit_connection_start_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.transit_connection_start_verbal_subset.phrase(phrase_id).Format({
+      {kTransitPlatformTag, transit_stop},
+      {kStationLabelTag, station_label},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3310,12 +3345,11 @@ std::string NarrativeBuilder::FormTransitConnectionTransferInstruction(Maneuver&
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_connection_transfer_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.transit_connection_transfer_subset.phrase(phrase_id).Format({
+      {kTransitPlatformTag, transit_stop},
+      {kStationLabelTag, station_label},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3348,13 +3382,11 @@ std::string NarrativeBuilder::FormVerbalTransitConnectionTransferInstruction(Man
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.transit_connection_transfer_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.transit_connection_transfer_verbal_subset.phrase(phrase_id).Format({
+      {kTransitPlatformTag, transit_stop},
+      {kStationLabelTag, station_label},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3387,13 +3419,11 @@ std::string NarrativeBuilder::FormTransitConnectionDestinationInstruction(Maneuv
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.transit_connection_destination_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.transit_connection_destination_subset.phrase(phrase_id).Format({
+      {kTransitPlatformTag, transit_stop},
+      {kStationLabelTag, station_label},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3426,13 +3456,11 @@ std::string NarrativeBuilder::FormVerbalTransitConnectionDestinationInstruction(
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.transit_connection_destination_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.transit_connection_destination_verbal_subset.phrase(phrase_id).Format({
+      {kTransitPlatformTag, transit_stop},
+      {kStationLabelTag, station_label},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3455,13 +3483,11 @@ std::string NarrativeBuilder::FormDepartInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.depart_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale()));
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.depart_subset.phrase(phrase_id).Format({
+      {kTransitPlatformTag, transit_stop_name},
+      {kTimeTag, get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale())},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3484,13 +3510,11 @@ std::string NarrativeBuilder::FormVerbalDepartInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.depart_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale()));
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.depart_verbal_subset.phrase(phrase_id).Format({
+      {kTransitPlatformTag, transit_stop_name},
+      {kTimeTag, get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale())},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3513,13 +3537,11 @@ std::string NarrativeBuilder::FormArriveInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.arrive_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale()));
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.arrive_subset.phrase(phrase_id).Format({
+      {kTransitPlatformTag, transit_stop_name},
+      {kTimeTag, get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale())},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3542,13 +3564,11 @@ std::string NarrativeBuilder::FormVerbalArriveInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.arrive_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale()));
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.arrive_verbal_subset.phrase(phrase_id).Format({
+      {kTransitPlatformTag, transit_stop_name},
+      {kTimeTag, get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale())},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3575,16 +3595,14 @@ std::string NarrativeBuilder::FormTransitInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver, dictionary_.transit_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.transit_subset.phrase(phrase_id).Format({
+      {kTransitNameTag,
+       FormTransitName(maneuver, dictionary_.transit_subset.empty_transit_name_labels)},
+      {kTransitHeadSignTag, transit_headsign},
+      {kTransitPlatformCountTag, std::to_string(stop_count)}, // TODO: locale specific numerals
+      {kTransitPlatformCountLabelTag, stop_count_label},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3607,14 +3625,12 @@ std::string NarrativeBuilder::FormVerbalTransitInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver,
-                                     dictionary_.transit_verbal_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.transit_verbal_subset.phrase(phrase_id).Format({
+      {kTransitNameTag, FormTransitName(maneuver,
+                                        dictionary_.transit_verbal_subset.empty_transit_name_labels)},
+      {kTransitHeadSignTag, transit_headsign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3642,17 +3658,14 @@ std::string NarrativeBuilder::FormTransitRemainOnInstruction(Maneuver& maneuver)
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_remain_on_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver,
-                                     dictionary_.transit_remain_on_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.transit_remain_on_subset.phrase(phrase_id).Format({
+      {kTransitNameTag,
+       FormTransitName(maneuver, dictionary_.transit_remain_on_subset.empty_transit_name_labels)},
+      {kTransitHeadSignTag, transit_headsign},
+      {kTransitPlatformCountTag, std::to_string(stop_count)}, // TODO: locale specific numerals
+      {kTransitPlatformCountLabelTag, stop_count_label},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3675,14 +3688,13 @@ std::string NarrativeBuilder::FormVerbalTransitRemainOnInstruction(Maneuver& man
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_remain_on_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver, dictionary_.transit_remain_on_verbal_subset
-                                                   .empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.transit_remain_on_verbal_subset.phrase(phrase_id).Format({
+      {kTransitNameTag,
+       FormTransitName(maneuver,
+                       dictionary_.transit_remain_on_verbal_subset.empty_transit_name_labels)},
+      {kTransitHeadSignTag, transit_headsign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3710,17 +3722,14 @@ std::string NarrativeBuilder::FormTransitTransferInstruction(Maneuver& maneuver)
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_transfer_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver,
-                                     dictionary_.transit_transfer_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.transit_transfer_subset.phrase(phrase_id).Format({
+      {kTransitNameTag,
+       FormTransitName(maneuver, dictionary_.transit_transfer_subset.empty_transit_name_labels)},
+      {kTransitHeadSignTag, transit_headsign},
+      {kTransitPlatformCountTag, std::to_string(stop_count)}, // TODO: locale specific numerals
+      {kTransitPlatformCountLabelTag, stop_count_label},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3743,14 +3752,13 @@ std::string NarrativeBuilder::FormVerbalTransitTransferInstruction(Maneuver& man
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_transfer_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver, dictionary_.transit_transfer_verbal_subset
-                                                   .empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.transit_transfer_verbal_subset.phrase(phrase_id).Format({
+      {kTransitNameTag,
+       FormTransitName(maneuver,
+                       dictionary_.transit_transfer_verbal_subset.empty_transit_name_labels)},
+      {kTransitHeadSignTag, transit_headsign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3791,14 +3799,12 @@ std::string NarrativeBuilder::FormVerbalPostTransitionInstruction(Maneuver& mane
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.post_transition_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.post_transition_verbal_subset.metric_lengths,
-                                dictionary_.post_transition_verbal_subset.us_customary_lengths));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.post_transition_verbal_subset.phrase(phrase_id).Format({
+      {kLengthTag, FormLength(maneuver, dictionary_.post_transition_verbal_subset.metric_lengths,
+                              dictionary_.post_transition_verbal_subset.us_customary_lengths)},
+      {kStreetNamesTag, street_names},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3819,14 +3825,11 @@ std::string NarrativeBuilder::FormVerbalPostTransitionTransitInstruction(Maneuve
       FormTransitPlatformCountLabel(stop_count, dictionary_.post_transition_transit_verbal_subset
                                                     .transit_stop_count_labels);
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.post_transition_transit_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.post_transition_transit_verbal_subset.phrase(phrase_id).Format({
+      {kTransitPlatformCountTag, std::to_string(stop_count)}, // TODO: locale specific numerals
+      {kTransitPlatformCountLabelTag, stop_count_label},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3870,14 +3873,12 @@ std::string NarrativeBuilder::FormVerbalSuccinctStartTransitionInstruction(Maneu
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.start_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.start_verbal_subset.metric_lengths,
-                                dictionary_.start_verbal_subset.us_customary_lengths));
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.start_verbal_subset.phrase(phrase_id).Format({
+      {kCardinalDirectionTag, cardinal_direction},
+      {kLengthTag, FormLength(maneuver, dictionary_.start_verbal_subset.metric_lengths,
+                              dictionary_.start_verbal_subset.us_customary_lengths)},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3936,14 +3937,12 @@ NarrativeBuilder::FormVerbalSuccinctTurnTransitionInstruction(Maneuver& maneuver
                                                maneuver.verbal_formatter());
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = subset->phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = subset->phrase(phrase_id).Format({
+      {kRelativeDirectionTag, FormRelativeTwoDirection(maneuver.type(), subset->relative_directions)},
+      {kJunctionNameTag, junction_name},
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3982,15 +3981,14 @@ NarrativeBuilder::FormVerbalSuccinctUturnTransitionInstruction(Maneuver& maneuve
         maneuver.signs().GetJunctionNameString(element_max_count, limit_by_consecutive_count, delim,
                                                maneuver.verbal_formatter());
   }
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.uturn_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.uturn_verbal_subset.relative_directions));
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.uturn_verbal_subset.phrase(phrase_id).Format({
+      {kRelativeDirectionTag,
+       FormRelativeTwoDirection(maneuver.type(),
+                                dictionary_.uturn_verbal_subset.relative_directions)},
+      {kJunctionNameTag, junction_name},
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4034,12 +4032,11 @@ NarrativeBuilder::FormVerbalSuccinctMergeTransitionInstruction(Maneuver& maneuve
                                  dictionary_.merge_verbal_subset.relative_directions);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.merge_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.merge_verbal_subset.phrase(phrase_id).Format({
+      {kRelativeDirectionTag, relative_direction},
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4081,12 +4078,11 @@ std::string NarrativeBuilder::FormVerbalSuccinctEnterRoundaboutTransitionInstruc
                                                         delim, maneuver.verbal_formatter());
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kOrdinalValueTag, ordinal_value);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.enter_roundabout_verbal_subset.phrase(phrase_id).Format({
+      {kOrdinalValueTag, ordinal_value},
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4117,10 +4113,10 @@ std::string NarrativeBuilder::FormVerbalSuccinctExitRoundaboutTransitionInstruct
                                                  maneuver.verbal_formatter());
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
-
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase with its tags replaced by values
+  instruction = dictionary_.exit_roundabout_verbal_subset.phrase(phrase_id).Format({
+      {kTowardSignTag, guide_sign},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4536,14 +4532,12 @@ std::string NarrativeBuilder::FormVerbalMultiCue(Maneuver* maneuver,
   if (maneuver->distant_verbal_multi_cue()) {
     phrase_id = 1;
   }
-  instruction = dictionary_.verbal_multi_cue_subset.phrases.at(std::to_string(phrase_id));
-
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kCurrentVerbalCueTag, current_verbal_cue);
-  boost::replace_all(instruction, kNextVerbalCueTag, next_verbal_cue);
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(*maneuver, dictionary_.post_transition_verbal_subset.metric_lengths,
-                                dictionary_.post_transition_verbal_subset.us_customary_lengths));
+  instruction = dictionary_.verbal_multi_cue_subset.phrase(phrase_id).Format({
+      {kCurrentVerbalCueTag, current_verbal_cue},
+      {kNextVerbalCueTag, next_verbal_cue},
+      {kLengthTag, FormLength(*maneuver, dictionary_.post_transition_verbal_subset.metric_lengths,
+                              dictionary_.post_transition_verbal_subset.us_customary_lengths)},
+  });
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
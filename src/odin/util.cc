@@ -5,6 +5,7 @@
 #include <boost/algorithm/string/replace.hpp>
 
 #include <chrono>
+#include <mutex>
 #include <sstream>
 
 #include <date/date.h>
@@ -24,30 +25,18 @@ valhalla::odin::locales_singleton_t load_narrative_locals() {
   valhalla::odin::locales_singleton_t locales;
   // for each locale
   for (const auto& json : locales_json) {
-    LOG_TRACE("LOCALES");
-    LOG_TRACE("-------");
-    LOG_TRACE("- " + json.first);
-    // load the json
-    boost::property_tree::ptree narrative_pt;
-    std::stringstream ss;
-    ss << json.second;
-    rapidjson::read_json(ss, narrative_pt);
-    LOG_TRACE("JSON read");
-    // parse it into an object and add it to the map
-    auto narrative_dictionary =
-        std::make_shared<valhalla::odin::NarrativeDictionary>(json.first, narrative_pt);
-    LOG_TRACE("NarrativeDictionary created");
-    locales.insert(std::make_pair(json.first, narrative_dictionary));
-    // insert all the aliases as this same object
-    auto aliases = narrative_pt.get_child("aliases");
-    for (const auto& alias : aliases) {
-      auto name = alias.second.get_value<std::string>();
-      auto inserted = locales.insert(std::make_pair(name, narrative_dictionary));
-      if (!inserted.second) {
-        throw std::logic_error("Alias '" + name + "' in json locale '" + json.first +
-                               "' has duplicate with posix_locale '" +
-                               inserted.first->second->GetLocale().name());
-      }
+    LOG_TRACE("- " + std::string(json.name));
+    const auto* data = reinterpret_cast<const char*>(json.json);
+    locales.emplace(json.name,
+                    valhalla::odin::lazy_narrative_dictionary_t(json.name, data, json.size));
+  }
+  // insert all the aliases as the same dictionary, which we know from the build
+  for (const auto& alias : locales_aliases) {
+    auto inserted = locales.emplace(alias.first, locales.at(alias.second));
+    if (!inserted.second) {
+      throw std::logic_error("Alias '" + std::string(alias.first) + "' in json locale '" +
+                             alias.second + "' has duplicate with locale '" +
+                             inserted.first->second.language_tag());
     }
   }
   return locales;
@@ -128,6 +117,37 @@ std::string get_localized_date(const std::string& date_time, const std::locale&
   return date::format(locale, "%x", local_tp);
 }
 
+struct lazy_narrative_dictionary_t::dictionary_t {
+  std::string language_tag;
+  const char* json;
+  size_t size;
+  std::once_flag parsed;
+  std::unique_ptr<NarrativeDictionary> dictionary;
+};
+
+lazy_narrative_dictionary_t::lazy_narrative_dictionary_t(const std::string& language_tag,
+                                                         const char* json,
+                                                         size_t size)
+    : dictionary_(new dictionary_t{language_tag, json, size, {}, nullptr}) {
+}
+
+const std::string& lazy_narrative_dictionary_t::language_tag() const {
+  return dictionary_->language_tag;
+}
+
+const NarrativeDictionary& lazy_narrative_dictionary_t::operator*() const {
+  // thread safe and if it throws the next caller gets to try again
+  std::call_once(dictionary_->parsed, [this]() {
+    LOG_TRACE("Parsing narrative dictionary " + dictionary_->language_tag);
+    boost::property_tree::ptree narrative_pt;
+    std::stringstream ss;
+    ss.write(dictionary_->json, dictionary_->size);
+    rapidjson::read_json(ss, narrative_pt);
+    dictionary_->dictionary.reset(new NarrativeDictionary(dictionary_->language_tag, narrative_pt));
+  });
+  return *dictionary_->dictionary;
+}
+
 const locales_singleton_t& get_locales() {
   // thread safe static initializer for singleton
   static locales_singleton_t locales(load_narrative_locals());
@@ -135,7 +155,15 @@ const locales_singleton_t& get_locales() {
 }
 
 const std::unordered_map<std::string, std::string>& get_locales_json() {
-  return locales_json;
+  // only made if somebody asks, the dictionaries read the embedded json directly
+  static const std::unordered_map<std::string, std::string> jsons = []() {
+    std::unordered_map<std::string, std::string> jsons;
+    for (const auto& json : locales_json) {
+      jsons.emplace(json.name, std::string(reinterpret_cast<const char*>(json.json), json.size));
+    }
+    return jsons;
+  }();
+  return jsons;
 }
 
 std::string turn_lane_direction(uint16_t turn_lane) {
@@ -11,6 +11,7 @@
 #include "baldr/json.h"
 #include "midgard/logging.h"
 
+#include "midgard/tracing.h"
 #include "midgard/util.h"
 #include "odin/directionsbuilder.h"
 #include "odin/util.h"
@@ -27,7 +28,15 @@ using namespace valhalla::baldr;
 namespace valhalla {
 namespace odin {
 
-odin_worker_t::odin_worker_t(const boost::property_tree::ptree&) {
+odin_worker_t::odin_worker_t(const boost::property_tree::ptree& config) {
+  // The calling thread is one of the narration threads so only the others have to be started
+  const auto thread_count = config.get<uint32_t>("odin.narration_threads", 1);
+  if (thread_count > 1) {
+    directions_workers.reset(new DirectionsWorkers(thread_count - 1));
+  }
+
+  // Odin makes the responses of routes so its the one to cache them
+  response_cache = response_cache_t::shared(config);
 }
 
 odin_worker_t::~odin_worker_t() {
@@ -39,10 +48,11 @@ void odin_worker_t::cleanup() {
 void odin_worker_t::narrate(Api& request) const {
   // time this whole method and save that statistic
   auto _ = measure_scope_time(request, "odin_worker_t::narrate");
+  VALHALLA_TRACE_SPAN("odin_worker_t::narrate");
 
   // get some annotated directions
   try {
-    odin::DirectionsBuilder().Build(request);
+    odin::DirectionsBuilder().Build(request, directions_workers.get());
   } catch (...) { throw valhalla_exception_t{202}; }
 }
 
@@ -64,11 +74,9 @@ odin_worker_t::work(const std::list<zmq::message_t>& job,
                     const std::function<void()>& interrupt_function) {
   auto& info = *static_cast<prime_server::http_request_info_t*>(request_info);
   LOG_INFO("Got Odin Request " + std::to_string(info.id));
-  Api request;
+  // the previous request and everything hanging off of it is freed at once here
+  auto& request = arena_request();
   try {
-    // Set the interrupt function
-    service_worker_t::set_interrupt(&interrupt_function);
-
     // crack open the in progress request
     bool success = request.ParseFromArray(job.front().data(), job.front().size());
     if (!success) {
@@ -77,6 +85,9 @@ odin_worker_t::work(const std::list<zmq::message_t>& job,
                                  boost::optional<std::string>("Failed parsing pbf in Odin::Worker")};
     }
 
+    // Set the interrupt function, it also gives up on the request once its deadline has passed
+    set_deadline_interrupt(request, &interrupt_function);
+
     // its either a simple status request or its a route to narrate
     switch (request.options().action()) {
       case Options::status: {
@@ -88,9 +99,14 @@ odin_worker_t::work(const std::list<zmq::message_t>& job,
         // narrate them and serialize them along
         narrate(request);
         auto response = tyr::serializeDirections(request);
+        if (response_cache) {
+          response_cache->insert(request, response);
+        }
         const bool as_gpx = request.options().format() == Options::gpx;
-        return to_response(response, info, request, as_gpx ? worker::GPX_MIME : worker::JSON_MIME,
-                           as_gpx);
+        const bool as_pbf = request.options().format() == Options::pbf;
+        const auto& mime =
+            as_gpx ? worker::GPX_MIME : (as_pbf ? worker::PBF_MIME : worker::JSON_MIME);
+        return to_response(response, info, request, mime, as_gpx);
       }
     }
   } catch (const std::exception& e) {
@@ -111,9 +127,10 @@ void run_service(const boost::property_tree::ptree& config) {
 
   // listen for requests
   zmq::context_t context;
+  odin_worker_t odin_worker(config);
   prime_server::worker_t worker(context, upstream_endpoint, "ipc:///dev/null", loopback_endpoint,
                                 interrupt_endpoint,
-                                std::bind(&odin_worker_t::work, odin_worker_t(config),
+                                std::bind(&odin_worker_t::work, std::ref(odin_worker),
                                           std::placeholders::_1, std::placeholders::_2,
                                           std::placeholders::_3));
   worker.work();
@@ -114,6 +114,7 @@ bool Options_Action_Enum_Parse(const std::string& action, Options::Action* a) {
       {"expansion", Options::expansion},
       {"centroid", Options::centroid},
       {"status", Options::status},
+      {"tile", Options::tile},
   };
   auto i = actions.find(action);
   if (i == actions.cend())
@@ -137,6 +138,7 @@ const std::string& Options_Action_Enum_Name(const Options::Action action) {
       {Options::expansion, "expansion"},
       {Options::centroid, "centroid"},
       {Options::status, "status"},
+      {Options::tile, "tile"},
   };
   auto i = actions.find(action);
   return i == actions.cend() ? empty : i->second;
@@ -256,6 +258,8 @@ bool Options_Format_Enum_Parse(const std::string& format, Options::Format* f) {
       {"json", Options::json},
       {"gpx", Options::gpx},
       {"osrm", Options::osrm},
+      {"binary", Options::binary},
+      {"pbf", Options::pbf},
   };
   auto i = formats.find(format);
   if (i == formats.cend())
@@ -270,6 +274,8 @@ const std::string& Options_Format_Enum_Name(const Options::Format match) {
       {Options::json, "json"},
       {Options::gpx, "gpx"},
       {Options::osrm, "osrm"},
+      {Options::binary, "binary"},
+      {Options::pbf, "pbf"},
   };
   auto i = formats.find(match);
   return i == formats.cend() ? empty : i->second;
@@ -80,27 +80,6 @@ constexpr ranged_default_t<float> kAutoWidthRange{0, kDefaultAutoWidth, 10.0f};
 // Maximum highway avoidance bias (modulates the highway factors based on road class)
 constexpr float kMaxHighwayBiasFactor = 8.0f;
 
-constexpr float kHighwayFactor[] = {
-    1.0f, // Motorway
-    0.5f, // Trunk
-    0.0f, // Primary
-    0.0f, // Secondary
-    0.0f, // Tertiary
-    0.0f, // Unclassified
-    0.0f, // Residential
-    0.0f  // Service, other
-};
-
-constexpr float kSurfaceFactor[] = {
-    0.0f, // kPavedSmooth
-    0.0f, // kPaved
-    0.0f, // kPaveRough
-    0.1f, // kCompacted
-    0.2f, // kDirt
-    0.5f, // kGravel
-    1.0f  // kPath
-};
-
 // The basic costing for an edge is a trade off between time and distance. We allow the user to
 // specify which one is more important to them and then we use a linear combination to combine the two
 // into a final metric. The problem is that time in seconds and length in meters have two wildly
@@ -122,202 +101,9 @@ const BaseCostingOptionsConfig kBaseCostOptsConfig = GetBaseCostOptsConfig();
 
 } // namespace
 
-/**
- * Derived class providing dynamic edge costing for "direct" auto routes. This
- * is a route that is generally shortest time but uses route hierarchies that
- * can result in slightly longer routes that avoid shortcuts on residential
- * roads.
- */
-class AutoCost : public DynamicCost {
-public:
-  /**
-   * Construct auto costing. Pass in cost type and costing_options using protocol buffer(pbf).
-   * @param  costing_options pbf with request costing_options.
-   */
-  AutoCost(const CostingOptions& costing_options, uint32_t access_mask = kAutoAccess);
-
-  virtual ~AutoCost() {
-  }
-
-  /**
-   * Does the costing method allow multiple passes (with relaxed hierarchy
-   * limits).
-   * @return  Returns true if the costing model allows multiple passes.
-   */
-  virtual bool AllowMultiPass() const override {
-    return true;
-  }
-
-  /**
-   * Checks if access is allowed for the provided directed edge.
-   * This is generally based on mode of travel and the access modes
-   * allowed on the edge. However, it can be extended to exclude access
-   * based on other parameters such as conditional restrictions and
-   * conditional access that can depend on time and travel mode.
-   * @param  edge           Pointer to a directed edge.
-   * @param  is_dest        Is a directed edge the destination?
-   * @param  pred           Predecessor edge information.
-   * @param  tile           Current tile.
-   * @param  edgeid         GraphId of the directed edge.
-   * @param  current_time   Current time (seconds since epoch). A value of 0
-   *                        indicates the route is not time dependent.
-   * @param  tz_index       timezone index for the node
-   * @return Returns true if access is allowed, false if not.
-   */
-  virtual bool Allowed(const baldr::DirectedEdge* edge,
-                       const bool is_dest,
-                       const EdgeLabel& pred,
-                       const graph_tile_ptr& tile,
-                       const baldr::GraphId& edgeid,
-                       const uint64_t current_time,
-                       const uint32_t tz_index,
-                       uint8_t& restriction_idx) const override;
-
-  /**
-   * Checks if access is allowed for an edge on the reverse path
-   * (from destination towards origin). Both opposing edges (current and
-   * predecessor) are provided. The access check is generally based on mode
-   * of travel and the access modes allowed on the edge. However, it can be
-   * extended to exclude access based on other parameters such as conditional
-   * restrictions and conditional access that can depend on time and travel
-   * mode.
-   * @param  edge           Pointer to a directed edge.
-   * @param  pred           Predecessor edge information.
-   * @param  opp_edge       Pointer to the opposing directed edge.
-   * @param  tile           Current tile.
-   * @param  edgeid         GraphId of the opposing edge.
-   * @param  current_time   Current time (seconds since epoch). A value of 0
-   *                        indicates the route is not time dependent.
-   * @param  tz_index       timezone index for the node
-   * @return  Returns true if access is allowed, false if not.
-   */
-  virtual bool AllowedReverse(const baldr::DirectedEdge* edge,
-                              const EdgeLabel& pred,
-                              const baldr::DirectedEdge* opp_edge,
-                              const graph_tile_ptr& tile,
-                              const baldr::GraphId& opp_edgeid,
-                              const uint64_t current_time,
-                              const uint32_t tz_index,
-                              uint8_t& restriction_idx) const override;
-
-  /**
-   * Callback for Allowed doing mode  specific restriction checks
-   */
-  virtual bool ModeSpecificAllowed(const baldr::AccessRestriction& restriction) const override;
-
-  /**
-   * Only transit costings are valid for this method call, hence we throw
-   * @param edge
-   * @param departure
-   * @param curr_time
-   * @return
-   */
-  virtual Cost EdgeCost(const baldr::DirectedEdge*,
-                        const baldr::TransitDeparture*,
-                        const uint32_t) const override {
-    throw std::runtime_error("AutoCost::EdgeCost does not support transit edges");
-  }
-
-  /**
-   * Get the cost to traverse the specified directed edge. Cost includes
-   * the time (seconds) to traverse the edge.
-   * @param   edge    Pointer to a directed edge.
-   * @param   tile    Graph tile.
-   * @param   seconds Time of week in seconds.
-   * @return  Returns the cost and time (seconds)
-   */
-  virtual Cost EdgeCost(const baldr::DirectedEdge* edge,
-                        const graph_tile_ptr& tile,
-                        const uint32_t seconds,
-                        uint8_t& flow_sources) const override;
-
-  /**
-   * Returns the cost to make the transition from the predecessor edge.
-   * Defaults to 0. Costing models that wish to include edge transition
-   * costs (i.e., intersection/turn costs) must override this method.
-   * @param  edge  Directed edge (the to edge)
-   * @param  node  Node (intersection) where transition occurs.
-   * @param  pred  Predecessor edge information.
-   * @return  Returns the cost and time (seconds)
-   */
-  virtual Cost TransitionCost(const baldr::DirectedEdge* edge,
-                              const baldr::NodeInfo* node,
-                              const EdgeLabel& pred) const override;
-
-  /**
-   * Returns the cost to make the transition from the predecessor edge
-   * when using a reverse search (from destination towards the origin).
-   * @param  idx   Directed edge local index
-   * @param  node  Node (intersection) where transition occurs.
-   * @param  pred  the opposing current edge in the reverse tree.
-   * @param  edge  the opposing predecessor in the reverse tree
-   * @param  has_measured_speed Do we have any of the measured speed types set?
-   * @param  internal_turn  Did we make an turn on a short internal edge.
-   * @return  Returns the cost and time (seconds)
-   */
-  virtual Cost TransitionCostReverse(const uint32_t idx,
-                                     const baldr::NodeInfo* node,
-                                     const baldr::DirectedEdge* pred,
-                                     const baldr::DirectedEdge* edge,
-                                     const bool has_measured_speed,
-                                     const InternalTurn internal_turn) const override;
-
-  /**
-   * Get the cost factor for A* heuristics. This factor is multiplied
-   * with the distance to the destination to produce an estimate of the
-   * minimum cost to the destination. The A* heuristic must underestimate the
-   * cost to the destination. So a time based estimate based on speed should
-   * assume the maximum speed is used to the destination such that the time
-   * estimate is less than the least possible time along roads.
-   */
-  virtual float AStarCostFactor() const override {
-    return speedfactor_[top_speed_];
-  }
-
-  /**
-   * Get the current travel type.
-   * @return  Returns the current travel type.
-   */
-  virtual uint8_t travel_type() const override {
-    return static_cast<uint8_t>(type_);
-  }
-
-  /**
-   * Function to be used in location searching which will
-   * exclude and allow ranking results from the search by looking at each
-   * edges attribution and suitability for use as a location by the travel
-   * mode used by the costing method. It's also used to filter
-   * edges not usable / inaccessible by automobile.
-   */
-  virtual bool Allowed(const baldr::DirectedEdge* edge,
-                       const graph_tile_ptr& tile,
-                       uint16_t disallow_mask = kDisallowNone) const override {
-    bool allow_closures = (!filter_closures_ && !(disallow_mask & kDisallowClosure)) ||
-                          !(flow_mask_ & kCurrentFlowMask);
-    return DynamicCost::Allowed(edge, tile, disallow_mask) && !edge->bss_connection() &&
-           (allow_closures || !tile->IsClosed(edge));
-  }
-
-  // Hidden in source file so we don't need it to be protected
-  // We expose it within the source file for testing purposes
-public:
-  VehicleType type_; // Vehicle type: car (default), motorcycle, etc
-  std::vector<float> speedfactor_;
-  float density_factor_[16];  // Density factor
-  float highway_factor_;      // Factor applied when road is a motorway or trunk
-  float alley_factor_;        // Avoid alleys factor.
-  float toll_factor_;         // Factor applied when road has a toll
-  float surface_factor_;      // How much the surface factors are applied.
-  float distance_factor_;     // How much distance factors in overall favorability
-  float inv_distance_factor_; // How much time factors in overall favorability
-
-  // Vehicle attributes (used for special restrictions and costing)
-  float height_; // Vehicle height in meters
-  float width_;  // Vehicle width in meters
-
-  // Density factor used in edge transition costing
-  std::vector<float> trans_density_factor_;
-};
+// The tables of the edge costs
+constexpr float AutoCost::kHighwayFactor[];
+constexpr float AutoCost::kSurfaceFactor[];
 
 // Constructor
 AutoCost::AutoCost(const CostingOptions& costing_options, uint32_t access_mask)
@@ -392,55 +178,6 @@ AutoCost::AutoCost(const CostingOptions& costing_options, uint32_t access_mask)
   }
 }
 
-// Check if access is allowed on the specified edge.
-bool AutoCost::Allowed(const baldr::DirectedEdge* edge,
-                       const bool is_dest,
-                       const EdgeLabel& pred,
-                       const graph_tile_ptr& tile,
-                       const baldr::GraphId& edgeid,
-                       const uint64_t current_time,
-                       const uint32_t tz_index,
-                       uint8_t& restriction_idx) const {
-  // Check access, U-turn, and simple turn restriction.
-  // Allow U-turns at dead-end nodes in case the origin is inside
-  // a not thru region and a heading selected an edge entering the
-  // region.
-  if (!IsAccessible(edge) || (!pred.deadend() && pred.opp_local_idx() == edge->localedgeidx()) ||
-      ((pred.restrictions() & (1 << edge->localedgeidx())) && !ignore_restrictions_) ||
-      edge->surface() == Surface::kImpassable || IsUserAvoidEdge(edgeid) ||
-      (!allow_destination_only_ && !pred.destonly() && edge->destonly()) ||
-      (pred.closure_pruning() && IsClosed(edge, tile))) {
-    return false;
-  }
-
-  return DynamicCost::EvaluateRestrictions(access_mask_, edge, is_dest, tile, edgeid, current_time,
-                                           tz_index, restriction_idx);
-}
-
-// Checks if access is allowed for an edge on the reverse path (from
-// destination towards origin). Both opposing edges are provided.
-bool AutoCost::AllowedReverse(const baldr::DirectedEdge* edge,
-                              const EdgeLabel& pred,
-                              const baldr::DirectedEdge* opp_edge,
-                              const graph_tile_ptr& tile,
-                              const baldr::GraphId& opp_edgeid,
-                              const uint64_t current_time,
-                              const uint32_t tz_index,
-                              uint8_t& restriction_idx) const {
-  // Check access, U-turn, and simple turn restriction.
-  // Allow U-turns at dead-end nodes.
-  if (!IsAccessible(opp_edge) || (!pred.deadend() && pred.opp_local_idx() == edge->localedgeidx()) ||
-      ((opp_edge->restrictions() & (1 << pred.opp_local_idx())) && !ignore_restrictions_) ||
-      opp_edge->surface() == Surface::kImpassable || IsUserAvoidEdge(opp_edgeid) ||
-      (!allow_destination_only_ && !pred.destonly() && opp_edge->destonly()) ||
-      (pred.closure_pruning() && IsClosed(opp_edge, tile))) {
-    return false;
-  }
-
-  return DynamicCost::EvaluateRestrictions(access_mask_, edge, false, tile, opp_edgeid, current_time,
-                                           tz_index, restriction_idx);
-}
-
 bool AutoCost::ModeSpecificAllowed(const baldr::AccessRestriction& restriction) const {
   switch (restriction.type()) {
     case AccessType::kMaxHeight:
@@ -455,66 +192,6 @@ bool AutoCost::ModeSpecificAllowed(const baldr::AccessRestriction& restriction)
   return true;
 }
 
-// Get the cost to traverse the edge in seconds
-Cost AutoCost::EdgeCost(const baldr::DirectedEdge* edge,
-                        const graph_tile_ptr& tile,
-                        const uint32_t seconds,
-                        uint8_t& flow_sources) const {
-  // either the computed edge speed or optional top_speed
-  auto edge_speed = tile->GetSpeed(edge, flow_mask_, seconds, false, &flow_sources);
-  auto final_speed = std::min(edge_speed, top_speed_);
-  float sec = edge->length() * speedfactor_[final_speed];
-
-  if (shortest_) {
-    return Cost(edge->length(), sec);
-  }
-
-  // base factor is either ferry, rail ferry or density based
-  float factor = 1;
-  switch (edge->use()) {
-    case Use::kFerry:
-      factor = ferry_factor_;
-      break;
-    case Use::kRailFerry:
-      factor = rail_ferry_factor_;
-      break;
-    default:
-      factor = density_factor_[edge->density()];
-      break;
-  }
-
-  // TODO: speed_penality hasn't been extensively tested, might alter this in future
-  float speed_penalty = (edge_speed > top_speed_) ? (edge_speed - top_speed_) * 0.05f : 0.0f;
-  factor += highway_factor_ * kHighwayFactor[static_cast<uint32_t>(edge->classification())] +
-            surface_factor_ * kSurfaceFactor[static_cast<uint32_t>(edge->surface())] + speed_penalty +
-            edge->toll() * toll_factor_;
-
-  switch (edge->use()) {
-    case Use::kAlley:
-      factor *= alley_factor_;
-      break;
-    case Use::kTrack:
-      factor *= track_factor_;
-      break;
-    case Use::kLivingStreet:
-      factor *= living_street_factor_;
-      break;
-    case Use::kServiceRoad:
-      factor *= service_factor_;
-      break;
-    default:
-      break;
-  }
-
-  if (IsClosed(edge, tile)) {
-    // Add a penalty for traversing a closed edge
-    factor *= closure_factor_;
-  }
-  // base cost before the factor is a linear combination of time vs distance, depending on which
-  // one the user thinks is more important to them
-  return Cost((sec * inv_distance_factor_ + edge->length() * distance_factor_) * factor, sec);
-}
-
 // Returns the time (in seconds) to make the transition from the predecessor
 Cost AutoCost::TransitionCost(const baldr::DirectedEdge* edge,
                               const baldr::NodeInfo* node,
@@ -729,6 +406,14 @@ public:
   virtual ~BusCost() {
   }
 
+  /**
+   * Copy of the costing as it was constructed.
+   * @return  Returns a costing of the same type.
+   */
+  virtual cost_ptr_t Clone() const override {
+    return std::make_shared<BusCost>(*this);
+  }
+
   /**
    * Checks if access is allowed for the provided directed edge.
    * This is generally based on mode of travel and the access modes
@@ -858,6 +543,14 @@ public:
   virtual ~HOVCost() {
   }
 
+  /**
+   * Copy of the costing as it was constructed.
+   * @return  Returns a costing of the same type.
+   */
+  virtual cost_ptr_t Clone() const override {
+    return std::make_shared<HOVCost>(*this);
+  }
+
   /**
    * Checks if access is allowed for the provided directed edge.
    * This is generally based on mode of travel and the access modes
@@ -1034,6 +727,14 @@ public:
   virtual ~TaxiCost() {
   }
 
+  /**
+   * Copy of the costing as it was constructed.
+   * @return  Returns a costing of the same type.
+   */
+  virtual cost_ptr_t Clone() const override {
+    return std::make_shared<TaxiCost>(*this);
+  }
+
   /**
    * Checks if access is allowed for the provided directed edge.
    * This is generally based on mode of travel and the access modes
@@ -221,6 +221,14 @@ public:
   virtual ~BicycleCost() {
   }
 
+  /**
+   * Copy of the costing as it was constructed.
+   * @return  Returns a costing of the same type.
+   */
+  virtual cost_ptr_t Clone() const override {
+    return std::make_shared<BicycleCost>(*this);
+  }
+
   /**
    * Checks if access is allowed for the provided directed edge.
    * This is generally based on mode of travel and the access modes
@@ -143,7 +143,7 @@ DynamicCost::DynamicCost(const CostingOptions& options,
       ignore_oneways_(options.ignore_oneways()), ignore_access_(options.ignore_access()),
       ignore_closures_(options.ignore_closures()), top_speed_(options.top_speed()),
       filter_closures_(ignore_closures_ ? false : options.filter_closures()),
-      penalize_uturns_(penalize_uturns) {
+      penalize_uturns_(penalize_uturns), options_key_(options.SerializeAsString()) {
   // Parse property tree to get hierarchy limits
   // TODO - get the number of levels
   uint32_t n_levels = sizeof(kDefaultMaxUpTransitions) / sizeof(kDefaultMaxUpTransitions[0]);
@@ -153,13 +153,18 @@ DynamicCost::DynamicCost(const CostingOptions& options,
 
   // Add avoid edges to internal set
   for (auto& edge : options.exclude_edges()) {
-    user_exclude_edges_.insert({GraphId(edge.id()), edge.percent_along()});
+    AddUserAvoidEdge(GraphId(edge.id()), edge.percent_along());
   }
 }
 
 DynamicCost::~DynamicCost() {
 }
 
+// Costings without a copy of their own are built afresh for every request
+std::shared_ptr<DynamicCost> DynamicCost::Clone() const {
+  return nullptr;
+}
+
 // Does the costing method allow multiple passes (with relaxed hierarchy
 // limits). Defaults to false. Costing methods that wish to allow multiple
 // passes with relaxed hierarchy transitions must override this method.
@@ -302,8 +307,27 @@ bool DynamicCost::IsExcluded(const graph_tile_ptr&, const baldr::NodeInfo*) {
 // Adds a list of edges (GraphIds) to the user specified avoid list.
 void DynamicCost::AddUserAvoidEdges(const std::vector<AvoidEdge>& exclude_edges) {
   for (auto edge : exclude_edges) {
-    user_exclude_edges_.insert({edge.id, edge.percent_along});
+    AddUserAvoidEdge(edge.id, edge.percent_along);
+  }
+}
+
+// Adds an edge to the user specified avoid list and its bit to the bitset of its tile.
+void DynamicCost::AddUserAvoidEdge(const baldr::GraphId& edgeid, const float percent_along) {
+  user_exclude_edges_.insert({edgeid, percent_along});
+
+  const auto tile_id = edgeid.Tile_Base().value;
+  auto tile = std::lower_bound(exclude_tiles_.begin(), exclude_tiles_.end(), tile_id);
+  auto index = tile - exclude_tiles_.begin();
+  if (tile == exclude_tiles_.end() || *tile != tile_id) {
+    exclude_tiles_.insert(tile, tile_id);
+    exclude_bits_.emplace(exclude_bits_.begin() + index);
+  }
+  auto& bits = exclude_bits_[index];
+  const uint64_t id = edgeid.id();
+  if ((id >> 6) >= bits.size()) {
+    bits.resize((id >> 6) + 1, 0);
   }
+  bits[id >> 6] |= uint64_t(1) << (id & 63);
 }
 
 Cost DynamicCost::BSSCost() const {
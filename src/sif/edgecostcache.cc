@@ -0,0 +1,56 @@
+#include "sif/edgecostcache.h"
+
+#include <algorithm>
+
+using namespace valhalla::baldr;
+
+namespace valhalla {
+namespace sif {
+
+namespace {
+// How many tiles of costs are kept at most, the cache starts over rather than growing past that
+constexpr size_t kMaxTiles = 1024;
+} // namespace
+
+void EdgeCostCache::Reset(const DynamicCost* costing, const uint32_t seconds, const uint64_t graph) {
+  // live traffic can come to a tile at any time, so costs that may have used it dont outlive a reset
+  const auto options_key = costing ? costing->options_key() : std::string{};
+  const bool same = costing_ && costing && !live_ && seconds == seconds_ && graph == graph_ &&
+                    options_key == options_key_;
+  costing_ = costing;
+  seconds_ = seconds;
+  live_ = costing && (costing->flow_mask() & kCurrentFlowMask);
+  options_key_ = options_key;
+  graph_ = graph;
+  if (tiles_.size() > kMaxTiles) {
+    // start over rather than grow with every tile the searches ever went through
+    tiles_.clear();
+    last_tile_ = kInvalidGraphId;
+    last_costs_ = nullptr;
+  } else if (!same) {
+    // keep the arrays of the tiles, the next search probably goes through them too
+    for (auto& tile : tiles_) {
+      std::fill(tile.second.secs.begin(), tile.second.secs.end(), -1.f);
+    }
+  }
+}
+
+void EdgeCostCache::Clear() {
+  costing_ = nullptr;
+  options_key_.clear();
+  graph_ = 0;
+  tiles_.clear();
+  last_tile_ = kInvalidGraphId;
+  last_costs_ = nullptr;
+}
+
+// Grows by at least half so that edges found in increasing order dont resize every time
+void EdgeCostCache::tile_costs_t::resize(const size_t count) {
+  const auto size = std::max(count, secs.size() + secs.size() / 2);
+  cost.resize(size);
+  secs.resize(size, -1.f);
+  flow_sources.resize(size);
+}
+
+} // namespace sif
+} // namespace valhalla
@@ -1,7 +1,67 @@
 #include "sif/hierarchylimits.h"
+#include "baldr/rapidjson_utils.h"
+#include "baldr/tilehierarchy.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <stdexcept>
 
 using namespace valhalla::sif;
 
 bool HierarchyLimits::StopExpanding(const float dist) const {
   return (up_transition_count > max_up_transitions && dist > expansion_within_dist);
 }
+
+HierarchyLimitsTable::HierarchyLimitsTable(const std::string& path) {
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(path, pt);
+  for (const auto& costing : pt) {
+    for (const auto& region : costing.second) {
+      const float factor = region.second.get_value<float>();
+      if (!(factor > 0)) {
+        throw std::runtime_error("Hierarchy limits factors have to be positive: " + path);
+      }
+      Set(costing.first, std::stoul(region.first), factor);
+    }
+  }
+}
+
+float HierarchyLimitsTable::Factor(const std::string& costing,
+                                   const valhalla::midgard::PointLL& a,
+                                   const valhalla::midgard::PointLL& b) const {
+  const auto regions = factors_.find(costing);
+  if (regions == factors_.cend()) {
+    return 1.f;
+  }
+  float factor = 0;
+  for (const auto region : {Region(a), Region(b)}) {
+    const auto found = regions->second.find(region);
+    factor = std::max(factor, found == regions->second.cend() ? 1.f : found->second);
+  }
+  return factor;
+}
+
+std::string HierarchyLimitsTable::ToJson() const {
+  // sorted so that the same table always makes the same file
+  std::map<std::string, std::map<uint32_t, float>> sorted;
+  for (const auto& costing : factors_) {
+    sorted[costing.first].insert(costing.second.cbegin(), costing.second.cend());
+  }
+  std::ostringstream json;
+  json << "{";
+  for (auto costing = sorted.cbegin(); costing != sorted.cend(); ++costing) {
+    json << (costing == sorted.cbegin() ? "" : ",") << "\"" << costing->first << "\":{";
+    for (auto region = costing->second.cbegin(); region != costing->second.cend(); ++region) {
+      json << (region == costing->second.cbegin() ? "" : ",") << "\"" << region->first
+           << "\":" << region->second;
+    }
+    json << "}";
+  }
+  json << "}";
+  return json.str();
+}
+
+uint32_t HierarchyLimitsTable::Region(const valhalla::midgard::PointLL& ll) {
+  return valhalla::baldr::TileHierarchy::levels().front().tiles.TileId(ll);
+}
@@ -109,6 +109,14 @@ public:
 
   virtual ~MotorcycleCost();
 
+  /**
+   * Copy of the costing as it was constructed.
+   * @return  Returns a costing of the same type.
+   */
+  virtual cost_ptr_t Clone() const override {
+    return std::make_shared<MotorcycleCost>(*this);
+  }
+
   /**
    * Does the costing method allow multiple passes (with relaxed hierarchy
    * limits).
@@ -159,6 +159,14 @@ public:
   virtual ~MotorScooterCost() {
   }
 
+  /**
+   * Copy of the costing as it was constructed.
+   * @return  Returns a costing of the same type.
+   */
+  virtual cost_ptr_t Clone() const override {
+    return std::make_shared<MotorScooterCost>(*this);
+  }
+
   /**
    * Does the costing method allow multiple passes (with relaxed hierarchy
    * limits).
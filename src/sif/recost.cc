@@ -1,92 +1,82 @@
 #include "sif/recost.h"
 #include "baldr/time_info.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 namespace valhalla {
 namespace sif {
 
-/**
- * Will take a sequence of edges and create the set of edge labels that would represent it
- * Allows for the caller to essentially re-compute the costing of a given path
- *
- * @param reader            used to get access to graph data. modifyable because its got a cache
- * @param costing           single costing object to be used for costing/access computations
- * @param edge_cb           the callback used to get each edge in the path
- * @param label_cb          the callback used to emit each label in the path
- * @param source_pct        the percent along the initial edge the source location is
- * @param target_pct        the percent along the final edge the target location is
- * @param time_info         the time tracking information representing the local time before
- *                          traversing the first edge
- * @param invariant         static date_time, dont offset the time as the path lengthens
- * @param ignore_access     ignore access restrictions for edges and nodes if it's true
- */
-void recost_forward(baldr::GraphReader& reader,
-                    const sif::DynamicCost& costing,
-                    const EdgeCallback& edge_cb,
-                    const LabelCallback& label_cb,
-                    float source_pct,
-                    float target_pct,
-                    const baldr::TimeInfo& time_info,
-                    const bool invariant,
-                    const bool ignore_access) {
-  // out of bounds edge scaling
-  if (source_pct < 0.f || source_pct > 1.f || target_pct < 0.f || target_pct > 1.f) {
-    throw std::logic_error("Source and target percentages must be between 0 and 1 inclusive");
-  }
-
-  // grab the first path edge
-  baldr::GraphId edge_id = edge_cb();
-  if (!edge_id.Is_Valid()) {
-    return;
-  }
+namespace {
 
-  // fetch the graph objects
+// an edge of the path along with the node it starts at
+struct path_edge_t {
+  baldr::GraphId id;
+  const baldr::DirectedEdge* edge;
+  // the end node of the previous edge, null for the first edge
+  const baldr::NodeInfo* node;
+  // the tile of the edge which is also the tile of the node
   graph_tile_ptr tile;
-  const baldr::DirectedEdge* edge = reader.directededge(edge_id, tile);
-
-  // first edge is bogus
-  if (!edge) {
-    throw std::runtime_error("Edge cannot be found");
+};
+
+// how much of the edge the path uses, trimmed if its the first or last edge
+float edge_percent(const bool first,
+                   const bool last,
+                   const float source_pct,
+                   const float target_pct) {
+  float edge_pct = 1.f;
+  if (first) {
+    edge_pct -= source_pct;
   }
-
-  // fail if the first edge is filtered
-  if (!ignore_access && costing.Allowed(edge, tile) == 0.f) {
-    throw std::runtime_error("This path requires different edge access than this costing allows");
+  if (last) {
+    edge_pct -= 1.f - target_pct;
+    // just to keep compatibility with the logic that handled trivial path in bidiastar
+    edge_pct = std::max(0.f, edge_pct);
   }
+  return edge_pct;
+}
 
-  edge = nullptr;
-  const baldr::NodeInfo* node = nullptr;
-
-  // keep grabbing edges while we get valid ids
-  EdgeLabel label;
-  uint32_t predecessor = baldr::kInvalidLabel;
-  Cost cost{};
-  double length = 0;
-
-  while (edge_id.Is_Valid()) {
-    // get the previous edges node
-    node = edge ? reader.nodeinfo(edge->endnode(), tile) : nullptr;
-    if (edge && !node) {
-      throw std::runtime_error("Node cannot be found");
-    }
+// keeps track of the labels of the path for one costing
+class recoster_t {
+public:
+  recoster_t(const sif::DynamicCost& costing,
+             const baldr::TimeInfo& time_info,
+             const bool invariant,
+             const bool ignore_access)
+      : costing_(costing), time_info_(time_info), invariant_(invariant),
+        ignore_access_(ignore_access), predecessor_(baldr::kInvalidLabel), cost_{}, length_(0) {
+  }
 
-    // grab the edge
-    edge = reader.directededge(edge_id, tile);
-    if (!edge) {
-      throw std::runtime_error("Edge cannot be found");
+  /**
+   * Cost the next edge of the path
+   * @param path_edge  the edge and the node where it starts
+   * @param last       is this the last edge of the path
+   * @param edge_pct   how much of the edge the path uses
+   * @return the label of the edge
+   * @throws std::runtime_error if the costing cannot traverse the edge or its node
+   */
+  const EdgeLabel& next(const path_edge_t& path_edge, const bool last, const float edge_pct) {
+    const auto* edge = path_edge.edge;
+    const auto* node = path_edge.node;
+
+    // fail if the first edge is filtered
+    if (predecessor_ == baldr::kInvalidLabel && !ignore_access_ &&
+        costing_.Allowed(edge, path_edge.tile) == 0.f) {
+      throw std::runtime_error("This path requires different edge access than this costing allows");
     }
 
     // re-derive uturns, would have been nice to return this but we dont know the next edge yet
-    label.set_deadend(label.opp_local_idx() == edge->localedgeidx());
+    label_.set_deadend(label_.opp_local_idx() == edge->localedgeidx());
 
     // this node is not allowed, unless we made a uturn at it
-    if (!ignore_access && node && !label.deadend() && !costing.Allowed(node)) {
+    if (!ignore_access_ && node && !label_.deadend() && !costing_.Allowed(node)) {
       throw std::runtime_error("This path requires different node access than this costing allows");
     }
 
     // Update the time information even if time is invariant to account for timezones
-    const auto seconds_offset = invariant ? 0.f : cost.secs;
+    const auto seconds_offset = invariant_ ? 0.f : cost_.secs;
     const auto offset_time =
-        node ? time_info.forward(seconds_offset, static_cast<int>(node->timezone())) : time_info;
+        node ? time_info_.forward(seconds_offset, static_cast<int>(node->timezone())) : time_info_;
 
     // TODO: if this edge begins a restriction, we need to start popping off edges into queue
     // so that we can find if we reach the end of the restriction. then we need to replay the
@@ -96,48 +86,165 @@ void recost_forward(baldr::GraphReader& reader,
     const uint64_t localtime = offset_time.valid ? offset_time.local_time : 0;
     // we should call 'Allowed' method even if 'ignore_access' flag is true in order to
     // evaluate time restrictions
-    const auto next_id = edge_cb();
-    if (predecessor != baldr::kInvalidLabel &&
-        (!costing.Allowed(edge, !next_id.Is_Valid(), label, tile, edge_id, localtime,
-                          offset_time.timezone_index, time_restrictions_TODO) &&
-         !ignore_access)) {
+    if (predecessor_ != baldr::kInvalidLabel &&
+        (!costing_.Allowed(edge, last, label_, path_edge.tile, path_edge.id, localtime,
+                           offset_time.timezone_index, time_restrictions_TODO) &&
+         !ignore_access_)) {
       throw std::runtime_error("This path requires different edge access than this costing allows");
     }
 
-    // how much of the edge will we use, trim if its the first or last edge
-    float edge_pct = 1.f;
-    if (source_pct != -1) {
-      edge_pct -= source_pct;
-      source_pct = -1;
-    }
-
-    if (!next_id.Is_Valid()) {
-      edge_pct -= 1.f - target_pct;
-      // just to keep compatibility with the logic that handled trivial path in bidiastar
-      edge_pct = std::max(0.f, edge_pct);
-    }
-
     // the cost for traversing this intersection
-    Cost transition_cost = node ? costing.TransitionCost(edge, node, label) : Cost{};
+    Cost transition_cost = node ? costing_.TransitionCost(edge, node, label_) : Cost{};
     // update the cost to the end of this edge
     uint8_t flow_sources;
-    cost += transition_cost +
-            costing.EdgeCost(edge, tile, offset_time.second_of_week, flow_sources) * edge_pct;
+    cost_ += transition_cost +
+             costing_.EdgeCost(edge, path_edge.tile, offset_time.second_of_week, flow_sources) *
+                 edge_pct;
     // update the length to the end of this edge
-    length += edge->length() * edge_pct;
+    length_ += edge->length() * edge_pct;
     // construct the label
 
     InternalTurn turn =
-        node ? costing.TurnType(label.opp_local_idx(), node, edge) : InternalTurn::kNoTurn;
-    label = EdgeLabel(predecessor++, edge_id, edge, cost, cost.cost, 0, costing.travel_mode(), length,
-                      transition_cost, time_restrictions_TODO, !ignore_access,
-                      static_cast<bool>(flow_sources & baldr::kDefaultFlowMask), turn);
+        node ? costing_.TurnType(label_.opp_local_idx(), node, edge) : InternalTurn::kNoTurn;
+    label_ = EdgeLabel(predecessor_++, path_edge.id, edge, cost_, cost_.cost, 0,
+                       costing_.travel_mode(), length_, transition_cost, time_restrictions_TODO,
+                       !ignore_access_, static_cast<bool>(flow_sources & baldr::kDefaultFlowMask),
+                       turn);
+    return label_;
+  }
+
+protected:
+  const sif::DynamicCost& costing_;
+  const baldr::TimeInfo& time_info_;
+  const bool invariant_;
+  const bool ignore_access_;
+  EdgeLabel label_;
+  uint32_t predecessor_;
+  Cost cost_;
+  double length_;
+};
+
+// out of bounds edge scaling
+void check_percents(const float source_pct, const float target_pct) {
+  if (source_pct < 0.f || source_pct > 1.f || target_pct < 0.f || target_pct > 1.f) {
+    throw std::logic_error("Source and target percentages must be between 0 and 1 inclusive");
+  }
+}
+
+// fetch the graph objects of the next edge, throws if they cannot be found
+path_edge_t fetch(baldr::GraphReader& reader,
+                  const baldr::GraphId& edge_id,
+                  const baldr::DirectedEdge* previous,
+                  graph_tile_ptr& tile) {
+  // get the previous edges node
+  const baldr::NodeInfo* node = previous ? reader.nodeinfo(previous->endnode(), tile) : nullptr;
+  if (previous && !node) {
+    throw std::runtime_error("Node cannot be found");
+  }
+
+  // grab the edge
+  const baldr::DirectedEdge* edge = reader.directededge(edge_id, tile);
+  if (!edge) {
+    throw std::runtime_error("Edge cannot be found");
+  }
+  return {edge_id, edge, node, tile};
+}
+
+} // namespace
+
+/**
+ * Will take a sequence of edges and create the set of edge labels that would represent it
+ * Allows for the caller to essentially re-compute the costing of a given path
+ *
+ * @param reader            used to get access to graph data. modifyable because its got a cache
+ * @param costing           single costing object to be used for costing/access computations
+ * @param edge_cb           the callback used to get each edge in the path
+ * @param label_cb          the callback used to emit each label in the path
+ * @param source_pct        the percent along the initial edge the source location is
+ * @param target_pct        the percent along the final edge the target location is
+ * @param time_info         the time tracking information representing the local time before
+ *                          traversing the first edge
+ * @param invariant         static date_time, dont offset the time as the path lengthens
+ * @param ignore_access     ignore access restrictions for edges and nodes if it's true
+ */
+void recost_forward(baldr::GraphReader& reader,
+                    const sif::DynamicCost& costing,
+                    const EdgeCallback& edge_cb,
+                    const LabelCallback& label_cb,
+                    float source_pct,
+                    float target_pct,
+                    const baldr::TimeInfo& time_info,
+                    const bool invariant,
+                    const bool ignore_access) {
+  check_percents(source_pct, target_pct);
+
+  // grab the first path edge
+  baldr::GraphId edge_id = edge_cb();
+  if (!edge_id.Is_Valid()) {
+    return;
+  }
+
+  // keep grabbing edges while we get valid ids
+  recoster_t recoster(costing, time_info, invariant, ignore_access);
+  graph_tile_ptr tile;
+  const baldr::DirectedEdge* edge = nullptr;
+  while (edge_id.Is_Valid()) {
+    auto path_edge = fetch(reader, edge_id, edge, tile);
+    const auto next_id = edge_cb();
+    const float edge_pct = edge_percent(!edge, !next_id.Is_Valid(), source_pct, target_pct);
     // hand back the label
-    label_cb(label);
+    label_cb(recoster.next(path_edge, !next_id.Is_Valid(), edge_pct));
     // next edge
+    edge = path_edge.edge;
     edge_id = next_id;
   }
 }
 
+std::vector<bool> recost_forward(baldr::GraphReader& reader,
+                                 const std::vector<const sif::DynamicCost*>& costings,
+                                 const EdgeCallback& edge_cb,
+                                 const CostingLabelCallback& label_cb,
+                                 float source_pct,
+                                 float target_pct,
+                                 const baldr::TimeInfo& time_info,
+                                 const bool invariant,
+                                 const bool ignore_access) {
+  check_percents(source_pct, target_pct);
+
+  // fetch everything about the path once up front for all of the costings
+  std::vector<path_edge_t> path;
+  graph_tile_ptr tile;
+  for (auto edge_id = edge_cb(); edge_id.Is_Valid(); edge_id = edge_cb()) {
+    path.emplace_back(fetch(reader, edge_id, path.empty() ? nullptr : path.back().edge, tile));
+  }
+
+  std::vector<recoster_t> recosters;
+  recosters.reserve(costings.size());
+  for (const auto* costing : costings) {
+    recosters.emplace_back(*costing, time_info, invariant, ignore_access);
+  }
+
+  // cost each edge with each of the costings which could get to it
+  std::vector<bool> recosted(costings.size(), true);
+  for (size_t i = 0; i < path.size(); ++i) {
+    const bool last = i + 1 == path.size();
+    const float edge_pct = edge_percent(i == 0, last, source_pct, target_pct);
+    for (size_t c = 0; c < recosters.size(); ++c) {
+      if (!recosted[c]) {
+        continue;
+      }
+      const EdgeLabel* label;
+      try {
+        label = &recosters[c].next(path[i], last, edge_pct);
+      } catch (const std::runtime_error&) {
+        recosted[c] = false;
+        continue;
+      }
+      label_cb(c, *label);
+    }
+  }
+  return recosted;
+}
+
 } // namespace sif
 } // namespace valhalla
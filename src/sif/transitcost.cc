@@ -67,6 +67,14 @@ public:
 
   virtual ~TransitCost();
 
+  /**
+   * Copy of the costing as it was constructed.
+   * @return  Returns a costing of the same type.
+   */
+  virtual cost_ptr_t Clone() const override {
+    return std::make_shared<TransitCost>(*this);
+  }
+
   /**
    * Get the wheelchair required flag.
    * @return  Returns true if wheelchair is required.
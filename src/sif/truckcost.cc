@@ -102,6 +102,14 @@ public:
 
   virtual ~TruckCost();
 
+  /**
+   * Copy of the costing as it was constructed.
+   * @return  Returns a costing of the same type.
+   */
+  virtual cost_ptr_t Clone() const override {
+    return std::make_shared<TruckCost>(*this);
+  }
+
   /**
    * Does the costing allow hierarchy transitions. Truck costing will allow
    * transitions by default.
@@ -1,7 +1,9 @@
 #include "skadi/sample.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <cstring>
 #include <fstream>
 #include <limits>
 #include <list>
@@ -30,6 +32,26 @@ constexpr int16_t NO_DATA_HIGH = 16384;
 constexpr int16_t NO_DATA_LOW = -16384;
 constexpr size_t TILE_COUNT = 180 * 360;
 
+// the blocked format keeps native endian pixels in square blocks which are compressed on their
+// own, the blocks on the right and bottom edges are padded with no data
+constexpr char BLOCKED_MAGIC[8] = {'V', 'A', 'L', 'H', 'S', 'K', 'B', 'K'};
+constexpr uint32_t BLOCKED_VERSION = 1;
+constexpr size_t BLOCK_DIM = 64;
+constexpr size_t BLOCKS_PER_SIDE = (HGT_DIM + BLOCK_DIM - 1) / BLOCK_DIM;
+constexpr size_t BLOCK_COUNT = BLOCKS_PER_SIDE * BLOCKS_PER_SIDE;
+constexpr size_t BLOCK_PIXELS = BLOCK_DIM * BLOCK_DIM;
+constexpr size_t BLOCK_BYTES = sizeof(int16_t) * BLOCK_PIXELS;
+
+// where each block is in the file, a block of BLOCK_BYTES is stored as it is and every block
+// starts at an even offset so those can be read in place
+struct blocked_header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t block_dim;
+  uint32_t offsets[BLOCK_COUNT];
+  uint32_t sizes[BLOCK_COUNT];
+};
+
 // macro is faster than inline function for this..
 #define out_of_range(v) v > NO_DATA_HIGH || v < NO_DATA_LOW
 
@@ -51,10 +73,10 @@ std::list<std::string> get_files(const std::string& root_dir) {
 
 template <typename fmt_t> uint16_t is_hgt(const std::string& name, fmt_t& fmt) {
   std::smatch m;
-  std::regex e(".*/([NS])([0-9]{2})([WE])([0-9]{3})\\.hgt(\\.gz)?$");
+  std::regex e(".*/([NS])([0-9]{2})([WE])([0-9]{3})\\.hgt(\\.gz|\\.blk)?$");
   if (std::regex_search(name, m, e)) {
-    // enum class format_t{ UNKNOWN = 0, GZIP = 1, RAW = 3 };
-    fmt = static_cast<fmt_t>(m[5].length() ? (m[5] == ".gz" ? 1 : 0) : 3);
+    // enum class format_t{ UNKNOWN = 0, GZIP = 1, RAW = 3, BLOCKED = 4 };
+    fmt = static_cast<fmt_t>(m[5].length() ? (m[5] == ".gz" ? 1 : (m[5] == ".blk" ? 4 : 0)) : 3);
     auto lon = std::stoi(m[4]) * (m[3] == "E" ? 1 : -1) + 180;
     auto lat = std::stoi(m[2]) * (m[1] == "N" ? 1 : -1) + 90;
     if (lon >= 0 && lon < 360 && lat >= 0 && lat < 180) {
@@ -68,6 +90,25 @@ int16_t flip(int16_t value) {
   return ((value & 0xFF) << 8) | ((value >> 8) & 0xFF);
 }
 
+// checks that the index of a blocked tile only points inside of the tile
+bool is_blocked(const char* data, uint64_t size) {
+  if (size < sizeof(blocked_header_t)) {
+    return false;
+  }
+  const auto* header = reinterpret_cast<const blocked_header_t*>(data);
+  if (std::memcmp(header->magic, BLOCKED_MAGIC, sizeof(BLOCKED_MAGIC)) != 0 ||
+      header->version != BLOCKED_VERSION || header->block_dim != BLOCK_DIM) {
+    return false;
+  }
+  for (size_t i = 0; i < BLOCK_COUNT; ++i) {
+    if (header->offsets[i] % 2 || header->sizes[i] == 0 ||
+        uint64_t(header->offsets[i]) + header->sizes[i] > size) {
+      return false;
+    }
+  }
+  return true;
+}
+
 uint64_t file_size(const std::string& file_name) {
   // TODO: detect gzip and actually validate the uncompressed size?
   struct stat s;
@@ -75,13 +116,107 @@ uint64_t file_size(const std::string& file_name) {
   return rc == 0 ? s.st_size : -1;
 }
 
+// bilinear interpolation of the pixels around a coordinate
+template <class coord_t, class pixels_t> double interpolate(const coord_t& coord, pixels_t& pixel) {
+  if (pixel.empty()) {
+    return NO_DATA_VALUE;
+  }
+  auto lon = std::floor(coord.first);
+  auto lat = std::floor(coord.second);
+
+  // figure out what row and column we need from the array of data
+  // NOTE: data is arranged from upper left to bottom right, so y is flipped
+
+  // fractional pixel
+  double u = (coord.first - lon) * (HGT_DIM - 1);
+  double v = (1.0 - (coord.second - lat)) * (HGT_DIM - 1);
+
+  // integer pixel
+  size_t x = std::floor(u);
+  size_t y = std::floor(v);
+
+  // coefficients
+  double u_ratio = u - x;
+  double v_ratio = v - y;
+  double u_inv = 1 - u_ratio;
+  double v_inv = 1 - v_ratio;
+  double a_coef = u_inv * v_inv;
+  double b_coef = u_ratio * v_inv;
+  double c_coef = u_inv * v_ratio;
+  double d_coef = u_ratio * v_ratio;
+
+  // values
+  double adjust = 0;
+  auto a = pixel(x, y);
+  auto b = pixel(x + 1, y);
+  // selects rather than branches so the compiler can use conditional moves
+  a_coef = out_of_range(a) ? 0 : a_coef;
+  b_coef = out_of_range(b) ? 0 : b_coef;
+
+  // first part of the bilinear interpolation
+  auto value = a * a_coef + b * b_coef;
+  adjust += a_coef + b_coef;
+  // LOG_INFO('{' + std::to_string(y * HGT_DIM + x) + ',' + std::to_string(a) + '}');
+  // LOG_INFO('{' + std::to_string(y * HGT_DIM + x + 1) + ',' + std::to_string(b) + '}');
+  // only need the second part if you aren't right on the row
+  // this also protects from a corner case where you sample past the end of the image
+  if (y < HGT_DIM - 1) {
+    auto c = pixel(x, y + 1);
+    auto d = pixel(x + 1, y + 1);
+    c_coef = out_of_range(c) ? 0 : c_coef;
+    d_coef = out_of_range(d) ? 0 : d_coef;
+    // LOG_INFO('{' + std::to_string((y + 1) * HGT_DIM + x) + ',' + std::to_string(c) + '}');
+    // LOG_INFO('{' + std::to_string((y + 1) * HGT_DIM + x + 1) + ',' + std::to_string(d) + '}');
+    value += c * c_coef + d * d_coef;
+    adjust += c_coef + d_coef;
+  }
+  // if we are missing everything then give up
+  if (adjust == 0) {
+    return NO_DATA_VALUE;
+  }
+  // if we were missing some we need to adjust by that
+  return value / adjust;
+}
+
 } // namespace
 
 namespace valhalla {
 namespace skadi {
 
-::valhalla::skadi::sample::sample(const std::string& data_source)
-    : unzipped_cache(-1, std::vector<int16_t>()), data_source(data_source) {
+struct sample::pixels_t {
+  pixels_t(const sample& s, uint16_t index) : s(s), index(index), block_index(BLOCK_COUNT) {
+    t = s.source(index, format);
+  }
+
+  // the native endian value of a pixel
+  int16_t operator()(size_t x, size_t y) {
+    if (format != format_t::BLOCKED) {
+      return flip(t.get()[y * HGT_DIM + x]);
+    }
+    // the neighbouring pixels are mostly in the same block
+    uint32_t b = (y / BLOCK_DIM) * BLOCKS_PER_SIDE + x / BLOCK_DIM;
+    if (b != block_index) {
+      block_index = b;
+      t = s.block(index, b);
+    }
+    return t ? t.get()[(y % BLOCK_DIM) * BLOCK_DIM + x % BLOCK_DIM] : NO_DATA_VALUE;
+  }
+
+  bool empty() const {
+    return format != format_t::BLOCKED && !t;
+  }
+
+  const sample& s;
+  uint16_t index;
+  format_t format;
+  uint32_t block_index;
+  tile_data_t t;
+};
+
+::valhalla::skadi::sample::sample(const std::string& data_source, size_t cache_bytes)
+    : unzipped_cache(new unzipped_t(std::max<size_t>(1, cache_bytes / HGT_BYTES),
+                                     std::max<size_t>(1, cache_bytes / BLOCK_BYTES))),
+      data_source(data_source) {
   // messy but needed
   while (this->data_source.size() &&
          this->data_source.back() == filesystem::path::preferred_separator) {
@@ -108,19 +243,31 @@ namespace skadi {
         continue;
       }
       mapped_cache[index].first = format;
+      if (format == format_t::BLOCKED) {
+        // only the blocks which are sampled are read
+        mapped_cache[index].second.map(f, size, POSIX_MADV_RANDOM);
+        if (!is_blocked(mapped_cache[index].second.get(), size)) {
+          LOG_WARN("Corrupt elevation data: " + f);
+          mapped_cache[index].first = format_t::UNKNOWN;
+          mapped_cache[index].second.unmap();
+        }
+        continue;
+      }
       mapped_cache[index].second.map(f, size, POSIX_MADV_SEQUENTIAL);
     }
   }
 }
 
-const int16_t* sample::source(uint16_t index) const {
+sample::tile_data_t sample::source(uint16_t index, format_t& format) const {
   // bail if its out of bounds
-  if (index >= TILE_COUNT) {
+  format = format_t::UNKNOWN;
+  if (index >= mapped_cache.size()) {
     return nullptr;
   }
 
   // if we dont have anything maybe its lazy loaded
   auto& mapped = mapped_cache[index];
+  std::unique_lock<std::mutex> lock(unzipped_cache->lock);
   if (mapped.second.get() == nullptr) {
     auto f = data_source + get_hgt_file_name(index);
     auto size = file_size(f);
@@ -130,17 +277,29 @@ const int16_t* sample::source(uint16_t index) const {
     mapped.first = format_t::RAW;
     mapped.second.map(f, size, POSIX_MADV_SEQUENTIAL);
   }
+  format = mapped.first;
+
+  // the blocks are read one by one
+  if (format == format_t::BLOCKED) {
+    return nullptr;
+  }
 
-  // we have it raw or we dont
+  // we have it raw or we dont, the mapping lives as long as we do so nothing owns it
   if (mapped.first == format_t::RAW) {
-    return static_cast<const int16_t*>(static_cast<const void*>(mapped.second.get()));
+    return tile_data_t(tile_data_t(), static_cast<const int16_t*>(
+                                          static_cast<const void*>(mapped.second.get())));
   }
 
   // if we have it already unzipped
-  if (unzipped_cache.first == index) {
-    return unzipped_cache.second.data();
+  std::shared_ptr<const std::vector<int16_t>> unzipped;
+  if (unzipped_cache->tiles.find(index, unzipped)) {
+    return tile_data_t(unzipped, unzipped->data());
   }
 
+  // unzip without holding up the other threads, the worst case is two threads unzipping the same
+  // tile at the same time
+  lock.unlock();
+
   // for setting where to read compressed data from
   auto src_func = [&mapped](z_stream& s) -> void {
     s.next_in = static_cast<Byte*>(static_cast<void*>(mapped.second.get()));
@@ -148,9 +307,9 @@ const int16_t* sample::source(uint16_t index) const {
   };
 
   // for setting where to write the uncompressed data to
-  auto dst_func = [this](z_stream& s) -> int {
-    unzipped_cache.second.resize(HGT_PIXELS);
-    s.next_out = static_cast<Byte*>(static_cast<void*>(unzipped_cache.second.data()));
+  auto data = std::make_shared<std::vector<int16_t>>(HGT_PIXELS);
+  auto dst_func = [&data](z_stream& s) -> int {
+    s.next_out = static_cast<Byte*>(static_cast<void*>(data->data()));
     s.avail_out = HGT_BYTES;
     return Z_FINISH; // we know the output will hold all the input
   };
@@ -158,94 +317,92 @@ const int16_t* sample::source(uint16_t index) const {
   // we have to unzip it
   if (!baldr::inflate(src_func, dst_func)) {
     LOG_WARN("Corrupt compressed elevation data");
-    unzipped_cache.first = -1;
     return nullptr;
   }
 
-  // update the simple cache
-  // TODO: LRU
-  unzipped_cache.first = index;
-  return unzipped_cache.second.data();
+  // update the cache, evicting the least recently used tile if its full
+  unzipped = std::move(data);
+  lock.lock();
+  unzipped_cache->tiles.insert(index, unzipped);
+  return tile_data_t(unzipped, unzipped->data());
 }
 
-template <class coord_t> double sample::get(const coord_t& coord) const {
-  // check the cache and load
-  auto lon = std::floor(coord.first);
-  auto lat = std::floor(coord.second);
-  auto index = static_cast<uint16_t>(lat + 90) * 360 + static_cast<uint16_t>(lon + 180);
+sample::tile_data_t sample::block(uint16_t index, uint32_t block) const {
+  // source() mapped the tile and it stays mapped as long as we do
+  const auto& mapped = mapped_cache[index].second;
+  const auto* header = reinterpret_cast<const blocked_header_t*>(mapped.get());
+  const char* data = mapped.get() + header->offsets[block];
+  const auto size = header->sizes[block];
 
-  // get the proper source of the data
-  const auto* t = source(index);
-  if (t == nullptr) {
-    return NO_DATA_VALUE;
+  // it didnt get any smaller so its stored as it is
+  if (size == BLOCK_BYTES) {
+    return tile_data_t(tile_data_t(), reinterpret_cast<const int16_t*>(data));
   }
 
-  // figure out what row and column we need from the array of data
-  // NOTE: data is arranged from upper left to bottom right, so y is flipped
-
-  // fractional pixel
-  double u = (coord.first - lon) * (HGT_DIM - 1);
-  double v = (1.0 - (coord.second - lat)) * (HGT_DIM - 1);
-
-  // integer pixel
-  size_t x = std::floor(u);
-  size_t y = std::floor(v);
-
-  // coefficients
-  double u_ratio = u - x;
-  double v_ratio = v - y;
-  double u_inv = 1 - u_ratio;
-  double v_inv = 1 - v_ratio;
-  double a_coef = u_inv * v_inv;
-  double b_coef = u_ratio * v_inv;
-  double c_coef = u_inv * v_ratio;
-  double d_coef = u_ratio * v_ratio;
-
-  // values
-  double adjust = 0;
-  auto a = flip(t[y * HGT_DIM + x]);
-  auto b = flip(t[y * HGT_DIM + x + 1]);
-  if (out_of_range(a)) {
-    a_coef = 0;
+  // if we have it already inflated
+  const uint32_t key = static_cast<uint32_t>(index) * BLOCK_COUNT + block;
+  std::shared_ptr<const std::vector<int16_t>> inflated;
+  std::unique_lock<std::mutex> lock(unzipped_cache->lock);
+  if (unzipped_cache->blocks.find(key, inflated)) {
+    return tile_data_t(inflated, inflated->data());
   }
-  if (out_of_range(b)) {
-    b_coef = 0;
+  lock.unlock();
+
+  // we have to inflate it
+  auto pixels = std::make_shared<std::vector<int16_t>>(BLOCK_PIXELS);
+  uLongf inflated_size = BLOCK_BYTES;
+  if (uncompress(reinterpret_cast<Bytef*>(pixels->data()), &inflated_size,
+                 reinterpret_cast<const Bytef*>(data), size) != Z_OK ||
+      inflated_size != BLOCK_BYTES) {
+    LOG_WARN("Corrupt compressed elevation block");
+    return nullptr;
   }
 
-  // first part of the bilinear interpolation
-  auto value = a * a_coef + b * b_coef;
-  adjust += a_coef + b_coef;
-  // LOG_INFO('{' + std::to_string(y * HGT_DIM + x) + ',' + std::to_string(a) + '}');
-  // LOG_INFO('{' + std::to_string(y * HGT_DIM + x + 1) + ',' + std::to_string(b) + '}');
-  // only need the second part if you aren't right on the row
-  // this also protects from a corner case where you sample past the end of the image
-  if (y < HGT_DIM - 1) {
-    auto c = flip(t[(y + 1) * HGT_DIM + x]);
-    auto d = flip(t[(y + 1) * HGT_DIM + x + 1]);
-    if (out_of_range(c)) {
-      c_coef = 0;
-    }
-    if (out_of_range(d)) {
-      d_coef = 0;
-    }
-    // LOG_INFO('{' + std::to_string((y + 1) * HGT_DIM + x) + ',' + std::to_string(c) + '}');
-    // LOG_INFO('{' + std::to_string((y + 1) * HGT_DIM + x + 1) + ',' + std::to_string(d) + '}');
-    value += c * c_coef + d * d_coef;
-    adjust += c_coef + d_coef;
-  }
-  // if we are missing everything then give up
-  if (adjust == 0) {
-    return NO_DATA_VALUE;
-  }
-  // if we were missing some we need to adjust by that
-  return value / adjust;
+  // update the cache, evicting the least recently used block if its full
+  inflated = std::move(pixels);
+  lock.lock();
+  unzipped_cache->blocks.insert(key, inflated);
+  return tile_data_t(inflated, inflated->data());
+}
+
+template <class coord_t> double sample::get(const coord_t& coord) const {
+  // get the proper source of the data
+  pixels_t pixels(*this, get_tile_index(coord));
+  return interpolate(coord, pixels);
 }
 
 template <class coords_t> std::vector<double> sample::get_all(const coords_t& coords) const {
-  std::vector<double> values;
-  values.reserve(coords.size());
+  // figure out which tile each posting is in
+  using coord_t = typename coords_t::value_type;
+  struct posting_t {
+    uint16_t index;
+    uint32_t position;
+    const coord_t* coord;
+    bool operator<(const posting_t& other) const {
+      return index < other.index || (index == other.index && position < other.position);
+    }
+  };
+  std::vector<posting_t> postings;
+  postings.reserve(coords.size());
   for (const auto& coord : coords) {
-    values.emplace_back(get(coord));
+    postings.push_back({get_tile_index(coord), static_cast<uint32_t>(postings.size()), &coord});
+  }
+
+  // group them by tile so that each tile is looked up once no matter how often a line crosses
+  // between tiles, most lines stay within a tile so they are already grouped
+  if (!std::is_sorted(postings.cbegin(), postings.cend())) {
+    std::sort(postings.begin(), postings.end());
+  }
+
+  // sample each group from its tile and put the values back in the order of the postings
+  std::vector<double> values(postings.size());
+  for (auto group = postings.cbegin(); group != postings.cend();) {
+    pixels_t pixels(*this, group->index);
+    auto end = group;
+    for (; end != postings.cend() && end->index == group->index; ++end) {
+      values[end->position] = interpolate(*end->coord, pixels);
+    }
+    group = end;
   }
   return values;
 }
@@ -254,6 +411,109 @@ double sample::get_no_data_value() {
   return NO_DATA_VALUE;
 }
 
+size_t sample::cache_capacity() const {
+  return unzipped_cache->tiles.capacity();
+}
+
+size_t sample::cache_size() const {
+  std::lock_guard<std::mutex> lock(unzipped_cache->lock);
+  return unzipped_cache->tiles.size();
+}
+
+size_t sample::cache_blocks() const {
+  std::lock_guard<std::mutex> lock(unzipped_cache->lock);
+  return unzipped_cache->blocks.size();
+}
+
+size_t sample::cache_hits() const {
+  std::lock_guard<std::mutex> lock(unzipped_cache->lock);
+  return unzipped_cache->tiles.hits() + unzipped_cache->blocks.hits();
+}
+
+size_t sample::cache_misses() const {
+  std::lock_guard<std::mutex> lock(unzipped_cache->lock);
+  return unzipped_cache->tiles.misses() + unzipped_cache->blocks.misses();
+}
+
+bool sample::convert(const std::string& hgt, const std::string& blocked, int level) {
+  std::ifstream in(hgt, std::ios::binary | std::ios::ate);
+  if (!in) {
+    return false;
+  }
+  std::vector<char> file(in.tellg());
+  in.seekg(0, std::ios::beg);
+  in.read(file.data(), file.size());
+  if (!in) {
+    return false;
+  }
+
+  // the big endian pixels of the tile whether its gzipped or not
+  std::vector<int16_t> tile;
+  if (hgt.size() > 3 && hgt.compare(hgt.size() - 3, 3, ".gz") == 0) {
+    auto src_func = [&file](z_stream& s) -> void {
+      s.next_in = static_cast<Byte*>(static_cast<void*>(file.data()));
+      s.avail_in = static_cast<unsigned int>(file.size());
+    };
+    auto dst_func = [&tile](z_stream& s) -> int {
+      tile.resize(HGT_PIXELS);
+      s.next_out = static_cast<Byte*>(static_cast<void*>(tile.data()));
+      s.avail_out = HGT_BYTES;
+      return Z_FINISH;
+    };
+    if (!baldr::inflate(src_func, dst_func)) {
+      return false;
+    }
+  } else if (file.size() == HGT_BYTES) {
+    tile.resize(HGT_PIXELS);
+    std::memcpy(tile.data(), file.data(), HGT_BYTES);
+  } else {
+    return false;
+  }
+
+  blocked_header_t header{};
+  std::memcpy(header.magic, BLOCKED_MAGIC, sizeof(BLOCKED_MAGIC));
+  header.version = BLOCKED_VERSION;
+  header.block_dim = BLOCK_DIM;
+  std::vector<char> data(sizeof(blocked_header_t));
+  std::vector<int16_t> block(BLOCK_PIXELS);
+  std::vector<char> compressed(compressBound(BLOCK_BYTES));
+  for (size_t by = 0; by < BLOCKS_PER_SIDE; ++by) {
+    for (size_t bx = 0; bx < BLOCKS_PER_SIDE; ++bx) {
+      // swap the bytes of the pixels of the block once and for all
+      std::fill(block.begin(), block.end(), NO_DATA_VALUE);
+      for (size_t y = 0; y < BLOCK_DIM && by * BLOCK_DIM + y < HGT_DIM; ++y) {
+        for (size_t x = 0; x < BLOCK_DIM && bx * BLOCK_DIM + x < HGT_DIM; ++x) {
+          block[y * BLOCK_DIM + x] = flip(tile[(by * BLOCK_DIM + y) * HGT_DIM + bx * BLOCK_DIM + x]);
+        }
+      }
+      uLongf size = compressed.size();
+      if (compress2(reinterpret_cast<Bytef*>(compressed.data()), &size,
+                    reinterpret_cast<const Bytef*>(block.data()), BLOCK_BYTES, level) != Z_OK) {
+        throw std::runtime_error("Failed to compress elevation block");
+      }
+
+      // keep the blocks on even offsets so the ones which are stored as they are can be read
+      // in place, a block which doesnt get any smaller is stored as it is
+      data.resize(data.size() + data.size() % 2);
+      auto i = by * BLOCKS_PER_SIDE + bx;
+      header.offsets[i] = data.size();
+      header.sizes[i] = size < BLOCK_BYTES ? size : BLOCK_BYTES;
+      const char* bytes = size < BLOCK_BYTES ? compressed.data()
+                                             : static_cast<const char*>(
+                                                   static_cast<const void*>(block.data()));
+      data.insert(data.end(), bytes, bytes + header.sizes[i]);
+    }
+  }
+  std::memcpy(data.data(), &header, sizeof(header));
+
+  std::ofstream out(blocked, std::ios::binary | std::ios::trunc);
+  out.write(data.data(), data.size());
+  if (!out) {
+    throw std::runtime_error("Failed to write elevation tile: " + blocked);
+  }
+  return true;
+}
+
 template <class coord_t> uint16_t sample::get_tile_index(const coord_t& coord) {
   auto lon = std::floor(coord.first);
   auto lat = std::floor(coord.second);
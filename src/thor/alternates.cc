@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
@@ -56,39 +57,39 @@ void filter_alternates_by_stretch(std::vector<CandidateConnection>& connections)
   connections.erase(new_end, connections.end());
 }
 
-// Limited Sharing. Compare duration of edge segments shared between optimal path and
-// candidate path. If they share more than kAtMostShared throw out this alternate.
+// Keep the edges of a chosen path sorted so that candidates are checked against it with binary
+// searches
+void add_shared_edges(std::vector<std::vector<uint64_t>>& shared_edgeids,
+                      const std::vector<GraphId>& path_edges) {
+  shared_edgeids.emplace_back();
+  auto& shared = shared_edgeids.back();
+  shared.reserve(path_edges.size());
+  for (const auto& edgeid : path_edges) {
+    shared.push_back(edgeid.value);
+  }
+  std::sort(shared.begin(), shared.end());
+  shared.erase(std::unique(shared.begin(), shared.end()), shared.end());
+}
+
+// Limited Sharing. Compare length of edge segments shared between optimal path and
+// candidate path. If they share more than at_most_shared throw out this alternate.
 // Note that you should recover all shortcuts before call this function.
-bool validate_alternate_by_sharing(std::vector<std::unordered_set<GraphId>>& shared_edgeids,
-                                   const std::vector<std::vector<PathInfo>>& paths,
-                                   const std::vector<PathInfo>& candidate_path,
+bool validate_alternate_by_sharing(const std::vector<std::vector<uint64_t>>& shared_edgeids,
+                                   const std::vector<GraphId>& candidate_edges,
+                                   const std::vector<float>& candidate_lengths,
                                    float at_most_shared) {
+  float total_length = 0.f;
+  for (auto length : candidate_lengths) {
+    total_length += length;
+  }
 
-  // we will calculate the overlap in edge duration between the candidate_path and paths (paths is a
-  // vector of the fastest path + any alternates already chosen)
-  if (paths.size() > shared_edgeids.size())
-    shared_edgeids.resize(paths.size());
-
-  // we check each accepted path against the candidate
-  for (size_t i = 0; i < paths.size(); ++i) {
-    // cache edge ids encountered on the current best path. Don't care about shortcuts because they
-    // have already been recovered.
-    auto& shared = shared_edgeids[i];
-    if (shared.empty()) {
-      for (const auto& pi : paths[i])
-        shared.insert(pi.edgeid);
-    }
-
-    // if an edge on the candidate_path is encountered that is also on one of the existing paths,
-    // we count it as a "shared" edge
-    float shared_length = 0.f, total_length = 0.f;
-    for (const auto& cpi : candidate_path) {
-      const auto length = &cpi == &candidate_path.front()
-                              ? cpi.path_distance
-                              : cpi.path_distance - (&cpi - 1)->path_distance;
-      total_length += length;
-      if (shared.find(cpi.edgeid) != shared.end()) {
-        shared_length += length;
+  // we check each accepted path (the fastest path + any alternates already chosen) against the
+  // candidate, an edge on the candidate that is also on one of them counts as "shared"
+  for (const auto& shared : shared_edgeids) {
+    float shared_length = 0.f;
+    for (size_t i = 0; i < candidate_edges.size(); ++i) {
+      if (std::binary_search(shared.cbegin(), shared.cend(), candidate_edges[i].value)) {
+        shared_length += candidate_lengths[i];
       }
     }
 
@@ -31,8 +31,8 @@ constexpr uint32_t kMaxIterationsWithoutConvergence = 200000;
 // Default constructor
 AStarBSSAlgorithm::AStarBSSAlgorithm(const boost::property_tree::ptree& config)
     : PathAlgorithm(), max_label_count_(std::numeric_limits<uint32_t>::max()),
-      mode_(TravelMode::kDrive), travel_type_(0),
-      max_reserved_labels_count_(
+      mode_(TravelMode::kDrive), travel_type_(0), station_distance_(0.0f),
+      bicycle_walk_factor_(0.0f), max_reserved_labels_count_(
           config.get<uint32_t>("max_reserved_labels_count", kInitialEdgeLabelCount)) {
 }
 
@@ -54,6 +54,7 @@ void AStarBSSAlgorithm::Clear() {
   adjacencylist_.clear();
   pedestrian_edgestatus_.clear();
   bicycle_edgestatus_.clear();
+  stations_.Clear();
 
   // Set the ferry flag to false
   has_ferry_ = false;
@@ -75,6 +76,14 @@ void AStarBSSAlgorithm::Init(const midgard::PointLL& origll, const midgard::Poin
   pedestrian_astarheuristic_.Init(destll, common_astar_cost);
   bicycle_astarheuristic_.Init(destll, common_astar_cost);
 
+  // Bicycle labels still have to return the bike and walk at least as far as the closest station
+  // is from the destination. Walking costs more per meter than the common factor so that part of
+  // their distance is estimated at the walking cost
+  bicycle_walk_factor_ = std::max(pedestrian_costing_->AStarCostFactor() *
+                                          pedestrian_costing_->GetModeFactor() -
+                                      common_astar_cost,
+                                  0.0f);
+
   // Get the initial cost based on A* heuristic from origin
   float mincost =
       std::min(bicycle_astarheuristic_.Get(origll), pedestrian_astarheuristic_.Get(origll));
@@ -217,6 +226,9 @@ void AStarBSSAlgorithm::ExpandForward(GraphReader& graphreader,
         continue;
       }
       sortcost += current_heuristic.Get(t2->get_node_ll(directededge->endnode()), dist);
+      if (mode == TravelMode::kBicycle) {
+        sortcost += bicycle_walk_factor_ * std::min(station_distance_, dist);
+      }
     }
 
     // Add to the adjacency list and edge labels.
@@ -266,6 +278,7 @@ AStarBSSAlgorithm::GetBestPath(valhalla::Location& origin,
   midgard::PointLL destination_new(destination.path_edges(0).ll().lng(),
                                    destination.path_edges(0).ll().lat());
   Init(origin_new, destination_new);
+  station_distance_ = stations_.Distance(graphreader, destination_new);
   float mindist = pedestrian_astarheuristic_.GetDistance(origin_new);
 
   // Initialize the origin and destination locations. Initialize the
@@ -136,6 +136,7 @@ const std::unordered_map<std::string, bool> AttributesController::kDefaultAttrib
     {kShapeAttributesSpeed, false},
     {kShapeAttributesSpeedLimit, false},
     {kShapeAttributesClosure, false},
+    {kShapeAttributesElevation, false},
 };
 
 AttributesController::AttributesController() {
@@ -148,6 +149,20 @@ void AttributesController::disable_all() {
   }
 }
 
+void AttributesController::disable_guidance() {
+  for (auto& pair : attributes) {
+    if (pair.first.compare(0, kEdgeSignCategory.size(), kEdgeSignCategory) == 0 ||
+        pair.first.compare(0, kNodeIntersectingEdgeCategory.size(),
+                           kNodeIntersectingEdgeCategory) == 0) {
+      pair.second = false;
+    }
+  }
+  for (const auto& key :
+       {kEdgeNames, kEdgeTaggedNames, kEdgeBeginHeading, kEdgeEndHeading, kEdgeLaneConnectivity}) {
+    attributes.at(key) = false;
+  }
+}
+
 // Used to check if any keys starting with the `category` string are enabled.
 bool AttributesController::category_attribute_enabled(const std::string& category) const {
   for (const auto& pair : attributes) {
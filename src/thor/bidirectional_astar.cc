@@ -4,6 +4,9 @@
 #include "baldr/graphid.h"
 #include "midgard/encoded.h"
 #include "midgard/logging.h"
+#include "midgard/tracing.h"
+#include "proto_conversions.h"
+#include "sif/autocost.h"
 #include "sif/edgelabel.h"
 #include "sif/recost.h"
 #include "thor/alternates.h"
@@ -39,6 +42,43 @@ inline float find_percent_along(const valhalla::Location& location, const GraphI
   throw std::logic_error("Could not find candidate edge for the location");
 }
 
+// Rough speeds (meters per second) along the straight line between the ends of a route, only used
+// to guess when a route with a time at just one end is at the other end
+float EstimatedSpeed(const TravelMode mode) {
+  switch (mode) {
+    case TravelMode::kPedestrian:
+      return 1.2f; // ~4 km/h
+    case TravelMode::kBicycle:
+      return 4.5f; // ~16 km/h
+    default:
+      return 16.7f; // ~60 km/h
+  }
+}
+
+// How much of each edge of a path it covers, which is all of them but the first and the last
+std::vector<float> CoveredLengths(GraphReader& graphreader,
+                                  const std::vector<GraphId>& path_edges,
+                                  const float source_pct,
+                                  const float target_pct) {
+  std::vector<float> lengths;
+  lengths.reserve(path_edges.size());
+  graph_tile_ptr tile;
+  for (const auto& edgeid : path_edges) {
+    const DirectedEdge* edge = graphreader.directededge(edgeid, tile);
+    if (edge == nullptr) {
+      throw tile_gone_error_t("BidirectionalAStar::FormPath failed", edgeid);
+    }
+    lengths.push_back(edge->length());
+  }
+  if (lengths.size() == 1) {
+    lengths.front() *= target_pct - source_pct;
+  } else {
+    lengths.front() *= 1.0f - source_pct;
+    lengths.back() *= target_pct;
+  }
+  return lengths;
+}
+
 } // namespace
 
 namespace valhalla {
@@ -48,7 +88,13 @@ namespace thor {
 BidirectionalAStar::BidirectionalAStar(const boost::property_tree::ptree& config)
     : PathAlgorithm(), max_reserved_labels_count_(config.get<uint32_t>("max_reserved_labels_count",
                                                                        kInitialEdgeLabelCountBD)),
+      overflow_bucket_count_(config.get<uint32_t>("overflow_bucket_count", 0)),
       extended_search_(config.get<bool>("extended_search", false)) {
+  const auto table = config.get<std::string>("hierarchy_limits_table", "");
+  if (!table.empty()) {
+    hierarchy_limits_table_ = std::make_shared<const HierarchyLimitsTable>(table);
+    LOG_INFO("Loaded the hierarchy limits table " + table);
+  }
   cost_threshold_ = 0;
   iterations_threshold_ = 0;
   desired_paths_count_ = 1;
@@ -58,6 +104,8 @@ BidirectionalAStar::BidirectionalAStar(const boost::property_tree::ptree& config
   cost_diff_ = 0.0f;
   pruning_disabled_at_origin_ = false;
   pruning_disabled_at_destination_ = false;
+  forward_time_estimated_ = false;
+  reverse_time_estimated_ = false;
 }
 
 // Destructor
@@ -111,9 +159,11 @@ void BidirectionalAStar::Init(const PointLL& origll, const PointLL& destll) {
   const float range = kBucketCount * bucketsize;
 
   const float mincostf = astarheuristic_forward_.Get(origll);
-  adjacencylist_forward_.reuse(mincostf, range, bucketsize, &edgelabels_forward_);
+  adjacencylist_forward_.reuse(mincostf, range, bucketsize, &edgelabels_forward_,
+                               overflow_bucket_count_);
   const float mincostr = astarheuristic_reverse_.Get(destll);
-  adjacencylist_reverse_.reuse(mincostr, range, bucketsize, &edgelabels_reverse_);
+  adjacencylist_reverse_.reuse(mincostr, range, bucketsize, &edgelabels_reverse_,
+                               overflow_bucket_count_);
 
   edgestatus_forward_.clear();
   edgestatus_reverse_.clear();
@@ -146,8 +196,9 @@ void BidirectionalAStar::Init(const PointLL& origll, const PointLL& destll) {
 // connect the forward and reverse paths. In that case we return false to allow uturns only if this
 // edge is a not-thru edge that will be pruned.
 //
-template <const ExpansionType expansion_direction>
+template <const ExpansionType expansion_direction, typename kernel_t>
 inline bool BidirectionalAStar::ExpandInner(baldr::GraphReader& graphreader,
+                                            const kernel_t& costing,
                                             const sif::BDEdgeLabel& pred,
                                             const baldr::DirectedEdge* opp_pred_edge,
                                             const baldr::NodeInfo* nodeinfo,
@@ -155,7 +206,8 @@ inline bool BidirectionalAStar::ExpandInner(baldr::GraphReader& graphreader,
                                             const EdgeMetadata& meta,
                                             uint32_t& shortcuts,
                                             const graph_tile_ptr& tile,
-                                            const baldr::TimeInfo& time_info) {
+                                            const baldr::TimeInfo& time_info,
+                                            const float end_node_dist) {
   constexpr bool FORWARD = expansion_direction == ExpansionType::forward;
   auto& hierarchy_limits = FORWARD ? hierarchy_limits_forward_ : hierarchy_limits_reverse_;
   // Skip shortcut edges until we have stopped expanding on the next level. Use regular
@@ -197,14 +249,15 @@ inline bool BidirectionalAStar::ExpandInner(baldr::GraphReader& graphreader,
       return false;
     }
 
-    opp_edge_id = t2->GetOpposingEdgeId(meta.edge);
+    opp_edge_id = tile->GetOpposingEdgeId(meta.edge, *t2);
     opp_edge = t2->directededge(opp_edge_id);
   }
 
   // Skip this edge if no access is allowed (based on costing method)
   // or if a complex restriction prevents transition onto this edge.
   // if its not time dependent set to 0 for Allowed and Restricted methods below
-  const uint64_t localtime = time_info.valid ? time_info.local_time : 0;
+  const bool estimated = FORWARD ? forward_time_estimated_ : reverse_time_estimated_;
+  const uint64_t localtime = time_info.valid && !estimated ? time_info.local_time : 0;
   uint8_t restriction_idx = -1;
   if (FORWARD) {
     // Why is is_dest false?
@@ -215,14 +268,14 @@ inline bool BidirectionalAStar::ExpandInner(baldr::GraphReader& graphreader,
     // We can set is_dest incorrectly in the second case, but it is the rare case.
     // The result path will be correct, because there are cosing.Allowed calls inside recost_forward
     // function in second time.
-    if (!costing_->Allowed(meta.edge, false, pred, tile, meta.edge_id, localtime,
+    if (!costing.Allowed(meta.edge, false, pred, tile, meta.edge_id, localtime,
                            time_info.timezone_index, restriction_idx) ||
         costing_->Restricted(meta.edge, pred, edgelabels_forward_, tile, meta.edge_id, true,
                              &edgestatus_forward_, localtime, time_info.timezone_index)) {
       return false;
     }
   } else {
-    if (!costing_->AllowedReverse(meta.edge, pred, opp_edge, t2, opp_edge_id, localtime,
+    if (!costing.AllowedReverse(meta.edge, pred, opp_edge, t2, opp_edge_id, localtime,
                                   time_info.timezone_index, restriction_idx) ||
         costing_->Restricted(meta.edge, pred, edgelabels_reverse_, tile, meta.edge_id, false,
                              &edgestatus_reverse_, localtime, time_info.timezone_index)) {
@@ -232,15 +285,15 @@ inline bool BidirectionalAStar::ExpandInner(baldr::GraphReader& graphreader,
 
   // Get cost. Separate out transition cost.
   sif::Cost transition_cost =
-      FORWARD ? costing_->TransitionCost(meta.edge, nodeinfo, pred)
-              : costing_->TransitionCostReverse(meta.edge->localedgeidx(), nodeinfo, opp_edge,
+      FORWARD ? costing.TransitionCost(meta.edge, nodeinfo, pred)
+              : costing.TransitionCostReverse(meta.edge->localedgeidx(), nodeinfo, opp_edge,
                                                 opp_pred_edge, pred.has_measured_speed(),
                                                 pred.internal_turn());
   uint8_t flow_sources;
   sif::Cost newcost =
       pred.cost() + transition_cost +
-      (FORWARD ? costing_->EdgeCost(meta.edge, tile, time_info.second_of_week, flow_sources)
-               : costing_->EdgeCost(opp_edge, t2, time_info.second_of_week, flow_sources));
+      (FORWARD ? costing.EdgeCost(meta.edge, tile, time_info.second_of_week, flow_sources)
+               : costing.EdgeCost(opp_edge, t2, time_info.second_of_week, flow_sources));
 
   // Check if edge is temporarily labeled and this path has less cost. If
   // less cost the predecessor is updated and the sort cost is decremented
@@ -267,16 +320,17 @@ inline bool BidirectionalAStar::ExpandInner(baldr::GraphReader& graphreader,
     if (t2 == nullptr) {
       return false;
     }
-    opp_edge_id = t2->GetOpposingEdgeId(meta.edge);
+    opp_edge_id = tile->GetOpposingEdgeId(meta.edge, *t2);
   }
 
   // Find the sort cost (with A* heuristic) using the lat,lng at the
-  // end node of the directed edge.
-  float dist = 0.0f;
-  float sortcost =
-      newcost.cost + (FORWARD
-                          ? astarheuristic_forward_.Get(t2->get_node_ll(meta.edge->endnode()), dist)
-                          : astarheuristic_reverse_.Get(t2->get_node_ll(meta.edge->endnode()), dist));
+  // end node of the directed edge, unless its distance was found with the others.
+  const auto& astarheuristic = FORWARD ? astarheuristic_forward_ : astarheuristic_reverse_;
+  float dist = end_node_dist;
+  if (dist == AStarHeuristic::kUnknownDistance) {
+    dist = astarheuristic.GetDistance(t2->get_node_ll(meta.edge->endnode()));
+  }
+  float sortcost = newcost.cost + astarheuristic.Get(dist);
 
   // not_thru_pruning_ is only set to false on the 2nd pass in route_action.
   bool thru = not_thru_pruning_ ? (pred.not_thru_pruning() || !meta.edge->not_thru()) : false;
@@ -292,7 +346,7 @@ inline bool BidirectionalAStar::ExpandInner(baldr::GraphReader& graphreader,
     }
     edgelabels_forward_.emplace_back(pred_idx, meta.edge_id, opp_edge_id, meta.edge, newcost,
                                      sortcost, dist, mode_, transition_cost, thru,
-                                     (pred.closure_pruning() || !costing_->IsClosed(meta.edge, tile)),
+                                     (pred.closure_pruning() || !costing.IsClosed(meta.edge, tile)),
                                      static_cast<bool>(flow_sources & kDefaultFlowMask),
                                      costing_->TurnType(pred.opp_local_idx(), nodeinfo, meta.edge),
                                      restriction_idx);
@@ -306,7 +360,7 @@ inline bool BidirectionalAStar::ExpandInner(baldr::GraphReader& graphreader,
     }
     edgelabels_reverse_.emplace_back(pred_idx, meta.edge_id, opp_edge_id, meta.edge, newcost,
                                      sortcost, dist, mode_, transition_cost, thru,
-                                     (pred.closure_pruning() || !costing_->IsClosed(meta.edge, tile)),
+                                     (pred.closure_pruning() || !costing.IsClosed(meta.edge, tile)),
                                      static_cast<bool>(flow_sources & kDefaultFlowMask),
                                      costing_->TurnType(meta.edge->localedgeidx(), nodeinfo, opp_edge,
                                                         opp_pred_edge),
@@ -327,7 +381,7 @@ inline bool BidirectionalAStar::ExpandInner(baldr::GraphReader& graphreader,
   return !(pred.not_thru_pruning() && meta.edge->not_thru());
 }
 
-template <const ExpansionType expansion_direction>
+template <const ExpansionType expansion_direction, typename kernel_t>
 bool BidirectionalAStar::Expand(baldr::GraphReader& graphreader,
                                 const baldr::GraphId& node,
                                 sif::BDEdgeLabel& pred,
@@ -354,9 +408,10 @@ bool BidirectionalAStar::Expand(baldr::GraphReader& graphreader,
                          : time_info.reverse(seconds_offset, static_cast<int>(nodeinfo->timezone()));
 
   auto& edgestatus = FORWARD ? edgestatus_forward_ : edgestatus_reverse_;
+  const kernel_t costing(*costing_);
 
   // If we encounter a node with an access restriction like a barrier we allow a uturn
-  if (!costing_->Allowed(nodeinfo)) {
+  if (!costing.Allowed(nodeinfo)) {
     const DirectedEdge* opp_edge = nullptr;
     const GraphId opp_edge_id = graphreader.GetOpposingEdgeId(pred.edgeid(), opp_edge, tile);
     // Mark the predecessor as a deadend to be consistent with how the
@@ -365,15 +420,23 @@ bool BidirectionalAStar::Expand(baldr::GraphReader& graphreader,
     pred.set_deadend(true);
     // Check if edge is null before using it (can happen with regional data sets)
     return opp_edge &&
-           ExpandInner<expansion_direction>(graphreader, pred, opp_pred_edge, nodeinfo, pred_idx,
+           ExpandInner<expansion_direction>(graphreader, costing, pred, opp_pred_edge, nodeinfo,
+                                            pred_idx,
                                             {opp_edge, opp_edge_id,
                                              edgestatus.GetPtr(opp_edge_id, tile)},
-                                            shortcuts, tile, offset_time);
+                                            shortcuts, tile, offset_time,
+                                            AStarHeuristic::kUnknownDistance);
   }
 
   bool disable_uturn = false;
   EdgeMetadata meta = EdgeMetadata::make(node, nodeinfo, tile, edgestatus);
   EdgeMetadata uturn_meta{};
+  float uturn_dist = AStarHeuristic::kUnknownDistance;
+
+  // The distances to the destination of the end nodes of all the edges at once
+  const auto& astarheuristic = FORWARD ? astarheuristic_forward_ : astarheuristic_reverse_;
+  float end_node_dists[kMaxEdgesPerNode];
+  astarheuristic.GetDistances(*tile, meta.edge, nodeinfo->edge_count(), end_node_dists);
 
   // Expand from end node in <expansion_direction> direction.
   for (uint32_t i = 0; i < nodeinfo->edge_count(); ++i, ++meta) {
@@ -383,12 +446,19 @@ bool BidirectionalAStar::Expand(baldr::GraphReader& graphreader,
     // this edge until last. If any other edges were emplaced, it means we should not
     // even try to evaluate a u-turn since u-turns should only happen for deadends
     uturn_meta = pred.opp_local_idx() == meta.edge->localedgeidx() ? meta : uturn_meta;
+    uturn_dist = pred.opp_local_idx() == meta.edge->localedgeidx() ? end_node_dists[i] : uturn_dist;
+
+    // Start loading the tiles at the frontier of the search before we get to them
+    if (meta.edge->leaves_tile()) {
+      graphreader.Prefetch(meta.edge->endnode());
+    }
 
     // Expand but only if this isnt the uturn, we'll try that later if nothing else works out
     disable_uturn =
         (pred.opp_local_idx() != meta.edge->localedgeidx() &&
-         ExpandInner<expansion_direction>(graphreader, pred, opp_pred_edge, nodeinfo, pred_idx, meta,
-                                          shortcuts, tile, offset_time)) ||
+         ExpandInner<expansion_direction>(graphreader, costing, pred, opp_pred_edge, nodeinfo,
+                                          pred_idx, meta, shortcuts, tile, offset_time,
+                                          end_node_dists[i])) ||
         disable_uturn;
   }
 
@@ -412,11 +482,14 @@ bool BidirectionalAStar::Expand(baldr::GraphReader& graphreader,
       EdgeMetadata trans_meta =
           EdgeMetadata::make(trans->endnode(), trans_node, trans_tile, edgestatus);
       uint32_t trans_shortcuts = 0;
+      astarheuristic.GetDistances(*trans_tile, trans_meta.edge, trans_node->edge_count(),
+                                  end_node_dists);
       // expand the edges from this node at this level
       for (uint32_t i = 0; i < trans_node->edge_count(); ++i, ++trans_meta) {
         disable_uturn =
-            ExpandInner<expansion_direction>(graphreader, pred, opp_pred_edge, trans_node, pred_idx,
-                                             trans_meta, trans_shortcuts, trans_tile, offset_time) ||
+            ExpandInner<expansion_direction>(graphreader, costing, pred, opp_pred_edge, trans_node,
+                                             pred_idx, trans_meta, trans_shortcuts, trans_tile,
+                                             offset_time, end_node_dists[i]) ||
             disable_uturn;
       }
     }
@@ -434,8 +507,9 @@ bool BidirectionalAStar::Expand(baldr::GraphReader& graphreader,
 
     // Expand the uturn possiblity
     disable_uturn =
-        ExpandInner<expansion_direction>(graphreader, pred, opp_pred_edge, nodeinfo, pred_idx,
-                                         uturn_meta, shortcuts, tile, offset_time) ||
+        ExpandInner<expansion_direction>(graphreader, costing, pred, opp_pred_edge, nodeinfo,
+                                         pred_idx, uturn_meta, shortcuts, tile, offset_time,
+                                         uturn_dist) ||
         disable_uturn;
   }
 
@@ -451,12 +525,23 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
                                 const sif::mode_costing_t& mode_costing,
                                 const sif::TravelMode mode,
                                 const Options& options) {
+  VALHALLA_TRACE_SPAN("BidirectionalAStar::GetBestPath");
+
   // Set the mode and costing
   mode_ = mode;
   costing_ = mode_costing[static_cast<uint32_t>(mode_)];
   travel_type_ = costing_->travel_type();
   access_mode_ = costing_->access_mode();
 
+  // Relax the edges without virtual calls into the costing when its exact type is known
+  if (CostKernel<AutoCost>::Matches(*costing_)) {
+    expand_forward_ = &BidirectionalAStar::Expand<ExpansionType::forward, CostKernel<AutoCost>>;
+    expand_reverse_ = &BidirectionalAStar::Expand<ExpansionType::reverse, CostKernel<AutoCost>>;
+  } else {
+    expand_forward_ = &BidirectionalAStar::Expand<ExpansionType::forward>;
+    expand_reverse_ = &BidirectionalAStar::Expand<ExpansionType::reverse>;
+  }
+
   desired_paths_count_ = 1;
   if (options.has_alternates() && options.alternates())
     desired_paths_count_ += options.alternates();
@@ -468,8 +553,8 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
 
   // Get time information for forward and backward searches
   bool invariant = options.has_date_time_type() && options.date_time_type() == Options::invariant;
-  auto forward_time_info = TimeInfo::make(origin, graphreader, &tz_cache_);
-  auto reverse_time_info = TimeInfo::make(destination, graphreader, &tz_cache_);
+  auto forward_time_info = TimeInfo::make(origin, graphreader);
+  auto reverse_time_info = TimeInfo::make(destination, graphreader);
 
   // When a timedependent route is too long in distance it gets sent to this algorithm. It used to be
   // the case that this algorithm called EdgeCost without a time component. This would result in
@@ -478,11 +563,25 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
   // you can uncomment the code below and get a time independent route in the fallback scenario.
   //  if (!invariant) {
   //    auto o = origin; o.mutable_date_time()->clear();
-  //    forward_time_info = TimeInfo::make(o, graphreader, &tz_cache_);
+  //    forward_time_info = TimeInfo::make(o, graphreader);
   //    auto d = destination; d.mutable_date_time()->clear();
-  //    reverse_time_info = TimeInfo::make(d, graphreader, &tz_cache_);
+  //    reverse_time_info = TimeInfo::make(d, graphreader);
   //  }
 
+  // The search from the end without a time guesses when the route gets there from the straight
+  // line distance so that it also costs its edges with the predicted speeds of about that time.
+  // For arrive_by routes the path is recosted from that guess too
+  forward_time_estimated_ = !invariant && !forward_time_info.valid && reverse_time_info.valid;
+  reverse_time_estimated_ = !invariant && forward_time_info.valid && !reverse_time_info.valid;
+  const float estimated_secs = origin_new.Distance(destination_new) / EstimatedSpeed(mode_);
+  if (forward_time_estimated_) {
+    forward_time_info =
+        reverse_time_info.reverse(estimated_secs, TimeInfo::timezone(origin, graphreader));
+  } else if (reverse_time_estimated_) {
+    reverse_time_info =
+        forward_time_info.forward(estimated_secs, TimeInfo::timezone(destination, graphreader));
+  }
+
   // Set origin and destination locations - seeds the adj. lists
   // Note: because we can correlate to more than one place for a given
   // PathLocation using edges.front here means we are only setting the
@@ -494,6 +593,20 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
   // Update hierarchy limits
   ModifyHierarchyLimits();
 
+  // Scale the limits by what was learned for where the route goes, the relaxed pass keeps the
+  // defaults to fall back on when the tuned limits were too tight
+  if (hierarchy_limits_table_ && costing_->pass() == 0) {
+    const float factor = hierarchy_limits_table_->Factor(Costing_Enum_Name(options.costing()),
+                                                         origin_new, destination_new);
+    if (factor != 1.f) {
+      for (auto* limits : {&hierarchy_limits_forward_, &hierarchy_limits_reverse_}) {
+        for (auto& limit : *limits) {
+          limit.Relax(factor, factor);
+        }
+      }
+    }
+  }
+
   // Find shortest path. Switch between a forward direction and a reverse
   // direction search based on the current costs. Alternating like this
   // prevents one tree from expanding much more quickly (if in a sparser
@@ -639,8 +752,8 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
       }
 
       // Expand from the end node in forward direction.
-      Expand<ExpansionType::forward>(graphreader, fwd_pred.endnode(), fwd_pred, forward_pred_idx,
-                                     nullptr, forward_time_info, invariant);
+      (this->*expand_forward_)(graphreader, fwd_pred.endnode(), fwd_pred, forward_pred_idx, nullptr,
+                               forward_time_info, invariant);
     } else {
       // Expand reverse - set to get next edge from reverse adj. list on the next pass
       expand_forward = false;
@@ -666,8 +779,8 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
       const DirectedEdge* opp_pred_edge = rev_pred_tile->directededge(rev_pred.opp_edgeid());
 
       // Expand from the end node in reverse direction.
-      Expand<ExpansionType::reverse>(graphreader, rev_pred.endnode(), rev_pred, reverse_pred_idx,
-                                     opp_pred_edge, reverse_time_info, invariant);
+      (this->*expand_reverse_)(graphreader, rev_pred.endnode(), rev_pred, reverse_pred_idx,
+                               opp_pred_edge, reverse_time_info, invariant);
     }
   }
   return {}; // If we are here the route failed
@@ -993,6 +1106,7 @@ std::vector<std::vector<PathInfo>> BidirectionalAStar::FormPath(GraphReader& gra
                                                                 const valhalla::Location& dest,
                                                                 const baldr::TimeInfo& time_info,
                                                                 const bool invariant) {
+  VALHALLA_TRACE_SPAN("BidirectionalAStar::FormPath");
   LOG_DEBUG("Found connections before stretch filter: " + std::to_string(best_connections_.size()));
 
   if (desired_paths_count_ > 1) {
@@ -1000,8 +1114,12 @@ std::vector<std::vector<PathInfo>> BidirectionalAStar::FormPath(GraphReader& gra
     // TODO: we should skip adding the connection at all if it's greater than stretch
     filter_alternates_by_stretch(best_connections_);
   }
-  // For looking up edge ids on previously chosen best paths
-  std::vector<std::unordered_set<GraphId>> shared_edgeids;
+  // For looking up edge ids on previously chosen best paths, one sorted list per path
+  std::vector<std::vector<uint64_t>> shared_edgeids;
+
+  // The forward labels of the plateaus of the connections formed so far, any other connection on
+  // one of them would only form the same path again
+  std::vector<bool> on_plateau(desired_paths_count_ > 1 ? edgelabels_forward_.size() : 0, false);
 
   // get maximum amount of sharing parameter based on origin->destination distance
   float max_sharing = desired_paths_count_ > 1 ? get_max_sharing(origin, dest) : 0.f;
@@ -1045,6 +1163,15 @@ std::vector<std::vector<PathInfo>> BidirectionalAStar::FormPath(GraphReader& gra
     uint32_t idx1 = edgestatus_forward_.Get(best_connection->edgeid).index();
     uint32_t idx2 = edgestatus_reverse_.Get(best_connection->opp_edgeid).index();
 
+    // Skip the connections whose path has been formed already
+    if (!on_plateau.empty()) {
+      if (on_plateau[idx1]) {
+        continue;
+      }
+      auto plateau = MarkPlateau(idx1, idx2, on_plateau);
+      LOG_DEBUG("plateau_edges::" + std::to_string(plateau));
+    }
+
     // Metrics (TODO - more accurate cost)
     uint32_t pathcost = edgelabels_forward_[idx1].cost().cost + edgelabels_reverse_[idx2].cost().cost;
     LOG_DEBUG("path_cost::" + std::to_string(pathcost));
@@ -1144,6 +1271,15 @@ std::vector<std::vector<PathInfo>> BidirectionalAStar::FormPath(GraphReader& gra
       throw std::logic_error("Could not find candidate edge used for destination label");
     }
 
+    // Check the sharing before recosting, only how much of each edge the path covers is needed
+    if (!paths.empty() &&
+        !validate_alternate_by_sharing(shared_edgeids, path_edges,
+                                       CoveredLengths(graphreader, path_edges, source_pct,
+                                                      target_pct),
+                                       max_sharing)) {
+      continue;
+    }
+
     // recost edges in final path; ignore access restrictions
     try {
       sif::recost_forward(graphreader, *costing_, edge_cb, label_cb, source_pct, target_pct,
@@ -1154,15 +1290,55 @@ std::vector<std::vector<PathInfo>> BidirectionalAStar::FormPath(GraphReader& gra
     }
 
     // For the first path just add it for subsequent paths only add if it passes viability tests
-    if (paths.empty() || (validate_alternate_by_sharing(shared_edgeids, paths, path, max_sharing) &&
-                          validate_alternate_by_local_optimality(path))) {
+    if (paths.empty() || validate_alternate_by_local_optimality(path)) {
       paths.emplace_back(std::move(path));
+      if (paths.size() < desired_paths_count_) {
+        add_shared_edges(shared_edgeids, path_edges);
+      }
     }
   }
   // give back the paths
   return paths;
 }
 
+// Mark the plateau of a connection, walking away from it on both trees for as long as the other
+// tree reaches the same edges through the same predecessors
+uint32_t BidirectionalAStar::MarkPlateau(const uint32_t fwd_idx,
+                                         const uint32_t rev_idx,
+                                         std::vector<bool>& on_plateau) const {
+  uint32_t count = 1;
+  on_plateau[fwd_idx] = true;
+
+  // Towards the origin the reverse label of each edge has to come from the one after it
+  uint32_t next_rev = rev_idx;
+  for (auto idx = edgelabels_forward_[fwd_idx].predecessor(); idx != kInvalidLabel;
+       idx = edgelabels_forward_[idx].predecessor(), ++count) {
+    const auto& opp_edgeid = edgelabels_forward_[idx].opp_edgeid();
+    auto status = opp_edgeid.Is_Valid() ? edgestatus_reverse_.Get(opp_edgeid) : EdgeStatusInfo{};
+    if (status.set() == EdgeSet::kUnreachedOrReset ||
+        edgelabels_reverse_[status.index()].predecessor() != next_rev) {
+      break;
+    }
+    on_plateau[idx] = true;
+    next_rev = status.index();
+  }
+
+  // Towards the destination the forward label of each edge has to come from the one before it
+  uint32_t prev_fwd = fwd_idx;
+  for (auto idx = edgelabels_reverse_[rev_idx].predecessor(); idx != kInvalidLabel;
+       idx = edgelabels_reverse_[idx].predecessor(), ++count) {
+    const auto& edgeid = edgelabels_reverse_[idx].opp_edgeid();
+    auto status = edgeid.Is_Valid() ? edgestatus_forward_.Get(edgeid) : EdgeStatusInfo{};
+    if (status.set() == EdgeSet::kUnreachedOrReset ||
+        edgelabels_forward_[status.index()].predecessor() != prev_fwd) {
+      break;
+    }
+    on_plateau[status.index()] = true;
+    prev_fwd = status.index();
+  }
+  return count;
+}
+
 void BidirectionalAStar::ModifyHierarchyLimits() {
   // Distance threshold optimized for unidirectional search. For bidirectional case
   // they can be lowered.
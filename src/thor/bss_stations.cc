@@ -0,0 +1,52 @@
+#include "thor/bss_stations.h"
+#include "baldr/tilehierarchy.h"
+#include "midgard/distanceapproximator.h"
+
+#include <algorithm>
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+
+namespace valhalla {
+namespace thor {
+
+float BssStations::Distance(GraphReader& graphreader, const PointLL& ll) {
+  // Only the local tiles within the maximum distance can have a closer station
+  const auto& tiles = TileHierarchy::levels().back().tiles;
+  double latdeg = max_distance_ / kMetersPerDegreeLat;
+  double lngdeg = max_distance_ / DistanceApproximator<PointLL>::MetersPerLngDegree(ll.lat());
+  AABB2<PointLL> bbox(PointLL(ll.lng() - lngdeg, ll.lat() - latdeg),
+                      PointLL(ll.lng() + lngdeg, ll.lat() + latdeg));
+
+  float distance = max_distance_;
+  for (auto tileid : tiles.TileList(bbox)) {
+    for (const auto& station : Stations(graphreader, tileid)) {
+      distance = std::min(distance, static_cast<float>(station.Distance(ll)));
+    }
+  }
+  return distance;
+}
+
+const std::vector<PointLL>& BssStations::Stations(GraphReader& graphreader,
+                                                   const uint32_t tileid) {
+  auto found = stations_.find(tileid);
+  if (found != stations_.end()) {
+    return found->second;
+  }
+
+  auto& stations = stations_[tileid];
+  GraphId tile_id(tileid, TileHierarchy::levels().back().level, 0);
+  graph_tile_ptr tile = graphreader.GetGraphTile(tile_id);
+  if (tile == nullptr) {
+    return stations;
+  }
+  for (const auto& node : tile->GetNodes()) {
+    if (node.type() == NodeType::kBikeShare) {
+      stations.push_back(node.latlng(tile->header()->base_ll()));
+    }
+  }
+  return stations;
+}
+
+} // namespace thor
+} // namespace valhalla
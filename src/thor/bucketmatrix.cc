@@ -0,0 +1,144 @@
+#include <algorithm>
+
+#include "thor/bucketmatrix.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+
+namespace valhalla {
+namespace thor {
+
+BucketMatrix::BucketMatrix(const boost::property_tree::ptree& config,
+                           const std::shared_ptr<MatrixWorkers>& workers)
+    : CostMatrix(config, workers) {
+}
+
+// Clear the temporary information generated during time + distance matrix
+// construction.
+void BucketMatrix::Clear() {
+  CostMatrix::Clear();
+  origin_edges_.clear();
+}
+
+// Form a time distance matrix from the set of source locations
+// to the set of target locations.
+std::vector<TimeDistance> BucketMatrix::SourceToTarget(
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+    GraphReader& graphreader,
+    const sif::mode_costing_t& mode_costing,
+    const TravelMode mode,
+    const float max_matrix_distance) {
+  // Set the mode and costing
+  mode_ = mode;
+  costing_ = mode_costing[static_cast<uint32_t>(mode_)];
+  access_mode_ = costing_->access_mode();
+
+  current_cost_threshold_ = GetCostThreshold(max_matrix_distance);
+
+  // Set the source and target locations
+  Clear();
+  SetSources(graphreader, source_location_list);
+  SetTargets(graphreader, target_location_list);
+  Initialize(source_location_list, target_location_list);
+
+  // The only labels the sources have so far are the ones on their origin edges
+  for (uint32_t i = 0; i < source_count_; i++) {
+    for (const auto& label : source_edgelabel_[i]) {
+      origin_edges_[label.opp_edgeid()].emplace_back(i, label.cost().cost);
+    }
+  }
+
+  // Fill the buckets with the backward searches first, the forward searches then only read them
+  RunSearches(target_count_, graphreader,
+              [this](uint32_t i, GraphReader& reader) { BackwardSearchToBound(i, reader); });
+  for (uint32_t i = 0; i < target_count_; i++) {
+    AddTargetEdges(i);
+  }
+  if (interrupt_) {
+    (*interrupt_)();
+  }
+  RunSearches(source_count_, graphreader,
+              [this](uint32_t i, GraphReader& reader) { ForwardSearchToBound(i, reader); });
+
+  return FormTimeDistanceMatrix();
+}
+
+// Run the backward search of a target to completion
+void BucketMatrix::BackwardSearchToBound(const uint32_t index, GraphReader& graphreader) {
+  // Reaching the origin edge of a source bounds the cost of the best connection to it. Once every
+  // source is bounded nothing the search reaches beyond the largest of them can be of any use
+  std::vector<float> bounds(source_count_, kMaxCost);
+  uint32_t unbounded = 0;
+  for (uint32_t source = 0; source < source_count_; source++) {
+    const auto& connection = best_connection_[source * target_count_ + index];
+    if (connection.found) {
+      bounds[source] = connection.cost.cost;
+    } else {
+      unbounded++;
+    }
+  }
+
+  size_t checked = 0;
+  auto& status = target_status_[index];
+  const auto& reached = target_reached_[index];
+  if (unbounded == 0) {
+    status.cost_bound = *std::max_element(bounds.cbegin(), bounds.cend());
+  }
+  while (status.threshold > 0) {
+    BackwardSearch(index, graphreader);
+    bool bounded = false;
+    for (; checked < reached.size(); ++checked) {
+      auto origins = origin_edges_.find(reached[checked]);
+      if (origins == origin_edges_.end()) {
+        continue;
+      }
+      const auto& label =
+          target_edgelabel_[index][target_edgestatus_[index].Get(reached[checked]).index()];
+      for (const auto& origin : origins->second) {
+        if (bounds[origin.first] == kMaxCost) {
+          unbounded--;
+        }
+        bounds[origin.first] = std::min(bounds[origin.first], label.cost().cost + origin.second);
+        bounded = true;
+      }
+    }
+    if (bounded && unbounded == 0) {
+      status.cost_bound = *std::max_element(bounds.cbegin(), bounds.cend());
+    }
+  }
+
+  // The status of the targets is only used by CostMatrix to know when to stop
+  target_updates_[index].clear();
+}
+
+// Run the forward search of a source to completion
+void BucketMatrix::ForwardSearchToBound(const uint32_t index, GraphReader& graphreader) {
+  // The connections in the buckets are final so the iteration count never marks them found,
+  // instead the search ends once it costs more than the worst of the best connections
+  auto& status = source_status_[index];
+  auto& updates = source_updates_[index];
+  const auto row = best_connection_.cbegin() + index * target_count_;
+  auto bound = [row, this]() {
+    float bound = 0.f;
+    for (auto connection = row; connection != row + target_count_; ++connection) {
+      if (!connection->found && connection->cost.cost == kMaxCost) {
+        return kMaxCost;
+      }
+      bound = std::max(bound, connection->cost.cost);
+    }
+    return bound;
+  };
+
+  status.cost_bound = bound();
+  while (status.threshold > 0) {
+    ForwardSearch(index, 0, graphreader);
+    if (!updates.empty()) {
+      updates.clear();
+      status.cost_bound = bound();
+    }
+  }
+}
+
+} // namespace thor
+} // namespace valhalla
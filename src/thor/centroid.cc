@@ -1,5 +1,10 @@
 #include "thor/centroid.h"
 
+#include <array>
+#include <atomic>
+#include <limits>
+#include <mutex>
+
 using namespace valhalla::baldr;
 using namespace valhalla::sif;
 
@@ -21,7 +26,7 @@ valhalla::Location make_centroid(const valhalla::baldr::GraphId& edge_id,
   const auto& shape = info.shape();
   auto length = midgard::length(shape);
   auto mid_point = midgard::resample_spherical_polyline(shape, length / 2.)[1];
-  auto names = info.GetNames();
+  auto names = info.GetNameViews();
 
   valhalla::Location location;
   location.Clear();
@@ -30,7 +35,9 @@ valhalla::Location make_centroid(const valhalla::baldr::GraphId& edge_id,
 
   auto* path_edge = location.mutable_path_edges()->Add();
   std::for_each(names.begin(), names.end(),
-                [path_edge](const std::string& n) { path_edge->mutable_names()->Add()->assign(n); });
+                [path_edge](boost::string_view n) {
+                  path_edge->mutable_names()->Add()->assign(n.data(), n.size());
+                });
   path_edge->set_begin_node(false);
   path_edge->set_end_node(false);
   path_edge->set_distance(0);
@@ -42,6 +49,84 @@ valhalla::Location make_centroid(const valhalla::baldr::GraphId& edge_id,
   return location;
 }
 
+/**
+ * Gets the opposing edge of the edge in the label
+ *
+ * @param reader  provides access to graph primitives
+ * @param label   the label of the edge
+ * @return the opposing edge or an invalid id if its tile isnt available
+ */
+valhalla::baldr::GraphId opposing_edge(valhalla::baldr::GraphReader& reader,
+                                       const valhalla::sif::EdgeLabel& label) {
+  valhalla::baldr::graph_tile_ptr tile;
+  valhalla::baldr::GraphId opp_id;
+  if (const auto* node = reader.nodeinfo(label.endnode(), tile)) {
+    opp_id = tile->header()->graphid();
+    opp_id.set_id(node->edge_index() + label.opp_index());
+  }
+  return opp_id;
+}
+
+/**
+ * Walks back the labels of one location to recover its path to the centroid
+ *
+ * @param expansion_type  the direction of the expansion
+ * @param labels          The edge labels used to recover the path
+ * @param edgestatus      the statuses of the edges the labels are on
+ * @param path_id         the id of the path of the location in the labels and statuses
+ * @param edge_id         the edge of the centroid
+ * @param opp_id          the opposing edge of the centroid
+ * @param reader          used for accessing graph primitives
+ * @param path            the path to fill out
+ */
+template <typename label_container_t>
+void form_path(const valhalla::thor::ExpansionType& expansion_type,
+               const label_container_t& labels,
+               const valhalla::thor::EdgeStatus& edgestatus,
+               const uint8_t path_id,
+               const valhalla::baldr::GraphId& edge_id,
+               const valhalla::baldr::GraphId& opp_id,
+               valhalla::baldr::GraphReader& reader,
+               std::vector<valhalla::thor::PathInfo>& path) {
+  using namespace valhalla::thor;
+  // grab the edge statuses for both potential paths to two edges at the centroid
+  auto status = edgestatus.Get(edge_id, path_id);
+  auto opp_status = edgestatus.Get(opp_id, path_id);
+
+  // check the edge status for both edges and find the label that was on the cheapest path
+  // if the first status either wasnt settled (or even reached) or it was but it wasnt cheapest
+  // then we switch to using the opposing label as its a better path
+  auto label_index = status.index();
+  if (status.set() != EdgeSet::kPermanent ||
+      (opp_status.set() == EdgeSet::kPermanent &&
+       labels[opp_status.index()].cost().cost < labels[status.index()].cost().cost)) {
+    label_index = opp_status.index();
+  }
+
+  // recover the path from the centroid back to the locations edge candidate
+  valhalla::baldr::graph_tile_ptr tile;
+  for (auto l = label_index; l != valhalla::baldr::kInvalidLabel; l = labels[l].predecessor()) {
+    const auto& label = labels[l];
+    auto path_edge_id = expansion_type == ExpansionType::reverse
+                            ? reader.GetOpposingEdgeId(label.edgeid(), tile)
+                            : label.edgeid();
+    path.emplace_back(label.mode(), label.cost(), path_edge_id, 0, label.path_distance(),
+                      label.restriction_idx(), label.transition_cost());
+  }
+
+  // reverse the path since we recovered it starting at the beginning
+  if (expansion_type != ExpansionType::reverse)
+    std::reverse(path.begin(), path.end());
+
+  // TODO: the final edge in each path could be a long one we should probably pick the optimal spot
+  // along it to make all paths to it the most happy. for now we'll take the mid point
+  auto edge_cost = path.back().elapsed_cost - path.back().transition_cost;
+  path.back().elapsed_cost -= edge_cost * .5;
+}
+
+// the intersection table is split up so the searches rarely wait on each other to update it
+constexpr size_t kIntersectionShards = 64;
+
 } // namespace
 
 namespace valhalla {
@@ -69,9 +154,9 @@ PathIntersection::PathIntersection(uint64_t edge_id, uint64_t opp_id, uint8_t lo
 bool PathIntersection::AddPath(uint8_t path_id) const {
   assert(path_id < 128);
   if (path_id < 64) {
-    lower_mask_ |= 1 << static_cast<uint64_t>(path_id);
+    lower_mask_ |= 1ull << static_cast<uint64_t>(path_id);
   } else {
-    upper_mask_ |= 1 << static_cast<uint64_t>(path_id - 64);
+    upper_mask_ |= 1ull << static_cast<uint64_t>(path_id - 64);
   }
   // this will only be true once all the bits are flipped to true
   return (lower_mask_ & upper_mask_) == 0xffffffffffffffff;
@@ -81,9 +166,9 @@ bool PathIntersection::AddPath(uint8_t path_id) const {
 bool PathIntersection::HasConverged(uint8_t path_id) const {
   assert(path_id < 128);
   if (path_id < 64) {
-    return lower_mask_ & (1 << static_cast<uint64_t>(path_id));
+    return lower_mask_ & (1ull << static_cast<uint64_t>(path_id));
   } else {
-    return upper_mask_ & (1 << static_cast<uint64_t>(path_id - 64));
+    return upper_mask_ & (1ull << static_cast<uint64_t>(path_id - 64));
   }
 }
 
@@ -92,6 +177,155 @@ bool PathIntersection::operator==(const PathIntersection& i) const {
   return edge_id_ == i.edge_id_;
 }
 
+/*
+ * The intersections of the searches running in parallel, one per location. Along with which paths
+ * have settled an edge it keeps the most any of them paid to get there. The cheapest of the edges
+ * every path has settled is the best centroid so far and no path needs to look beyond its cost.
+ */
+class ConvergenceTable {
+public:
+  explicit ConvergenceTable(uint8_t location_count)
+      : location_count_(location_count),
+        best_(baldr::kInvalidGraphId, baldr::kInvalidGraphId, location_count),
+        best_cost_(std::numeric_limits<float>::max()) {
+  }
+
+  /**
+   * Records that a path has settled an edge
+   * @param edge_id  the settled edge
+   * @param opp_id   its opposing edge
+   * @param path_id  the index of the path who has reached this edge
+   * @param cost     the cost of the path to this edge
+   */
+  void Add(const baldr::GraphId& edge_id,
+           const baldr::GraphId& opp_id,
+           const uint8_t path_id,
+           const float cost) {
+    PathIntersection intersection(edge_id, opp_id, location_count_);
+    auto& shard = shards_[intersection.edge_id_ % kIntersectionShards];
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    auto found = shard.intersections.find(intersection.edge_id_);
+    if (found == shard.intersections.end()) {
+      auto entry = std::make_pair(intersection, 0.f);
+      found = shard.intersections.emplace(intersection.edge_id_, entry).first;
+    }
+    found->second.second = std::max(found->second.second, cost);
+    if (!found->second.first.AddPath(path_id)) {
+      return;
+    }
+
+    // everyone has been here, is it cheaper than the best one so far
+    auto converged = found->second;
+    lock.unlock();
+    std::lock_guard<std::mutex> best_lock(best_mutex_);
+    if (converged.second < best_cost_.load(std::memory_order_relaxed)) {
+      best_ = converged.first;
+      best_cost_.store(converged.second, std::memory_order_relaxed);
+    }
+  }
+
+  // the cost of the best centroid so far
+  float best_cost() const {
+    return best_cost_.load(std::memory_order_relaxed);
+  }
+
+  // the best centroid, only to be called once the searches are done
+  const PathIntersection& best() const {
+    return best_;
+  }
+
+protected:
+  struct shard_t {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, std::pair<PathIntersection, float>> intersections;
+  };
+
+  uint8_t location_count_;
+  std::array<shard_t, kIntersectionShards> shards_;
+  std::mutex best_mutex_;
+  PathIntersection best_;
+  std::atomic<float> best_cost_;
+};
+
+/*
+ * The search of a single location when the locations are searched in parallel
+ */
+class CentroidSearch : public thor::Dijkstras {
+public:
+  /**
+   * Runs the search of the location
+   *
+   * @param expansion_type  forward or reverse
+   * @param api             holds the one location to search from
+   * @param reader          Graph reader of the thread the search runs on
+   * @param costings        Per mode costing objects
+   * @param mode            The mode specifying which costing to use
+   * @param path_id         the index of the location among all of them
+   * @param table           the edges the searches of all locations have settled
+   */
+  void Expand(const ExpansionType& expansion_type,
+              valhalla::Api& api,
+              baldr::GraphReader& reader,
+              const sif::mode_costing_t& costings,
+              const sif::TravelMode mode,
+              const uint8_t path_id,
+              ConvergenceTable& table) {
+    path_id_ = path_id;
+    table_ = &table;
+    Dijkstras::Expand(expansion_type, api, reader, costings, mode);
+    table_ = nullptr;
+  }
+
+  /**
+   * Recovers the path of the location to the centroid
+   */
+  std::vector<PathInfo> FormPath(const ExpansionType& expansion_type,
+                                 const baldr::GraphId& edge_id,
+                                 const baldr::GraphId& opp_id,
+                                 baldr::GraphReader& reader) const {
+    std::vector<PathInfo> path;
+    form_path(expansion_type, bdedgelabels_, edgestatus_, 0, edge_id, opp_id, reader, path);
+    return path;
+  }
+
+protected:
+  virtual void ExpandingNode(baldr::GraphReader&,
+                             graph_tile_ptr,
+                             const baldr::NodeInfo*,
+                             const sif::EdgeLabel&,
+                             const sif::EdgeLabel*) override {
+    // we dont care about reached edges
+  }
+
+  // record each settled edge until the path costs more than the best centroid so far
+  virtual thor::ExpansionRecommendation ShouldExpand(baldr::GraphReader& reader,
+                                                     const sif::EdgeLabel& label,
+                                                     const thor::ExpansionType) override {
+    if (label.cost().cost > table_->best_cost()) {
+      return thor::ExpansionRecommendation::stop_expansion;
+    }
+    table_->Add(label.edgeid(), opposing_edge(reader, label), path_id_, label.cost().cost);
+    return thor::ExpansionRecommendation::continue_expansion;
+  }
+
+  // each search only covers the area around one location
+  virtual void GetExpansionHints(uint32_t& bucket_count,
+                                 uint32_t& edge_label_reservation) const override {
+    bucket_count = 20000;
+    edge_label_reservation = 100000;
+  }
+
+  uint8_t path_id_ = 0;
+  ConvergenceTable* table_ = nullptr;
+};
+
+Centroid::Centroid(const std::shared_ptr<MatrixWorkers>& workers)
+    : location_count_(0), workers_(workers) {
+}
+
+Centroid::~Centroid() {
+}
+
 // main entry point to the functionality
 std::vector<std::vector<PathInfo>> Centroid::Expand(const ExpansionType& expansion_type,
                                                     valhalla::Api& api,
@@ -108,6 +342,11 @@ std::vector<std::vector<PathInfo>> Centroid::Expand(const ExpansionType& expansi
   best_intersection_ =
       PathIntersection{baldr::kInvalidGraphId, baldr::kInvalidGraphId, location_count_};
 
+  // with threads to spare each location gets its own search
+  if (workers_ && location_count_ > 1 && expansion_type != ExpansionType::multimodal) {
+    return ExpandInParallel(expansion_type, api, reader, costings, mode, centroid);
+  }
+
   // tell dijkstras we want to track the locations' paths separately/concurrently
   multipath_ = true;
 
@@ -118,6 +357,62 @@ std::vector<std::vector<PathInfo>> Centroid::Expand(const ExpansionType& expansi
   return FormPaths(expansion_type, api.options().locations(), bdedgelabels_, reader, centroid);
 }
 
+// run a search from each location at the same time
+std::vector<std::vector<PathInfo>>
+Centroid::ExpandInParallel(const ExpansionType& expansion_type,
+                           valhalla::Api& api,
+                           baldr::GraphReader& reader,
+                           const sif::mode_costing_t& costings,
+                           const sif::TravelMode mode,
+                           valhalla::Location& centroid) {
+  while (searches_.size() < location_count_) {
+    searches_.emplace_back(new CentroidSearch());
+  }
+
+  // the single search uses the time of the first location for all of them
+  auto& locations = *api.mutable_options()->mutable_locations();
+  SetTime(locations, reader);
+  std::vector<valhalla::Api> apis(location_count_);
+  for (uint8_t i = 0; i < location_count_; ++i) {
+    auto& options = *apis[i].mutable_options();
+    options = api.options();
+    options.clear_locations();
+    auto& location = *options.mutable_locations()->Add();
+    location = locations.Get(i);
+    if (locations.Get(0).has_date_time()) {
+      location.set_date_time(locations.Get(0).date_time());
+    } else {
+      location.clear_date_time();
+    }
+  }
+
+  // the interrupt is only checked by the searches on the calling thread
+  ConvergenceTable table(location_count_);
+  workers_->Run(location_count_, reader, [&](uint32_t i, uint32_t slot, GraphReader& slot_reader) {
+    auto& search = *searches_[i];
+    search.set_interrupt(slot == 0 ? interrupt_ : nullptr);
+    search.Expand(expansion_type, apis[i], slot_reader, costings, mode, i, table);
+  });
+  best_intersection_ = table.best();
+
+  // construct a centroid where all the paths meet
+  auto edge_id = baldr::GraphId(best_intersection_.edge_id_);
+  centroid = make_centroid(edge_id, reader);
+  graph_tile_ptr tile;
+  auto opp_id = reader.GetOpposingEdgeId(edge_id, tile);
+
+  // each search recovers its own path
+  std::vector<std::vector<PathInfo>> paths;
+  paths.reserve(location_count_);
+  for (uint8_t path_id = 0; path_id < location_count_; ++path_id) {
+    paths.emplace_back();
+    if (best_intersection_.HasConverged(path_id)) {
+      paths.back() = searches_[path_id]->FormPath(expansion_type, edge_id, opp_id, reader);
+    }
+  }
+  return paths;
+}
+
 // this is fired when the edge in the label has been settled (shortest path found) so we need to check
 // our intersections and add or update them
 thor::ExpansionRecommendation Centroid::ShouldExpand(baldr::GraphReader& reader,
@@ -127,16 +422,8 @@ thor::ExpansionRecommendation Centroid::ShouldExpand(baldr::GraphReader& reader,
 
   // TODO: refactor dijkstras a bit to get the tile and send it to us so we dont have to
 
-  // grab the opposing edge if you can
-  baldr::graph_tile_ptr tile;
-  baldr::GraphId opp_id;
-  if (const auto* node = reader.nodeinfo(label.endnode(), tile)) {
-    opp_id = tile->header()->graphid();
-    opp_id.set_id(node->edge_index() + label.opp_index());
-  }
-
   // see if we have seen this edge before
-  PathIntersection intersection(label.edgeid(), opp_id, location_count_);
+  PathIntersection intersection(label.edgeid(), opposing_edge(reader, label), location_count_);
   auto found = intersections_.find(intersection);
 
   // if not we create the record
@@ -171,6 +458,9 @@ void Centroid::GetExpansionHints(uint32_t& bucket_count, uint32_t& edge_label_re
 // deallocate and prepare for next request
 void Centroid::Clear() {
   intersections_.clear();
+  for (auto& search : searches_) {
+    search->Clear();
+  }
   Dijkstras::Clear();
 }
 
@@ -204,39 +494,7 @@ Centroid::FormPaths(const ExpansionType& expansion_type,
     if (!best_intersection_.HasConverged(path_id))
       continue;
     path.reserve(path_reservation);
-
-    // grab the edge statuses for both potential paths to two edges at the centroid
-    auto status = edgestatus_.Get(edge_id, path_id);
-    auto opp_status = edgestatus_.Get(opp_id, path_id);
-
-    // check the edge status for both edges and find the label that was on the cheapest path
-    // if the first status either wasnt settled (or even reached) or it was but it wasnt cheapest
-    // then we switch to using the opposing label as its a better path
-    auto label_index = status.index();
-    if (status.set() != EdgeSet::kPermanent ||
-        (opp_status.set() == EdgeSet::kPermanent &&
-         labels[opp_status.index()].cost().cost < labels[status.index()].cost().cost)) {
-      label_index = opp_status.index();
-    }
-
-    // recover the path from the centroid back to the locations edge candidate
-    for (auto l = label_index; l != baldr::kInvalidLabel; l = labels[l].predecessor()) {
-      const auto& label = labels[l];
-      auto path_edge_id = expansion_type == ExpansionType::reverse
-                              ? reader.GetOpposingEdgeId(label.edgeid(), tile)
-                              : label.edgeid();
-      path.emplace_back(label.mode(), label.cost(), path_edge_id, 0, label.path_distance(),
-                        label.restriction_idx(), label.transition_cost());
-    }
-
-    // reverse the path since we recovered it starting at the beginning
-    if (expansion_type != ExpansionType::reverse)
-      std::reverse(path.begin(), path.end());
-
-    // TODO: the final edge in each path could be a long one we should probably pick the optimal spot
-    // along it to make all paths to it the most happy. for now we'll take the mid point
-    auto edge_cost = path.back().elapsed_cost - path.back().transition_cost;
-    path.back().elapsed_cost -= edge_cost * .5;
+    form_path(expansion_type, labels, edgestatus_, path_id, edge_id, opp_id, reader, path);
   }
 
   return paths;
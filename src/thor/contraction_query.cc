@@ -0,0 +1,257 @@
+#include "thor/contraction_query.h"
+#include "baldr/rapidjson_utils.h"
+#include "midgard/logging.h"
+#include "sif/autocost.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+
+namespace {
+
+constexpr float kInfinity = std::numeric_limits<float>::max();
+
+// requests without a date_time never use live or predicted speeds so they dont tell us anything
+std::string serialize(valhalla::CostingOptions options, const uint32_t flow_mask) {
+  options.set_flow_mask(flow_mask);
+  return options.SerializeAsString();
+}
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+ContractionQuery::ContractionQuery(const boost::property_tree::ptree&)
+    : PathAlgorithm(), mode_(TravelMode::kDrive) {
+  // A request which doesnt customize auto costing has either of these options
+  for (const auto* json : {"{}", R"({"costing_options":{"auto":{}}})"}) {
+    rapidjson::Document doc;
+    doc.Parse(json);
+    CostingOptions options;
+    ParseAutoCostOptions(doc, "/costing_options/auto", &options);
+    default_options_.push_back(serialize(options, kDefaultFlowMask));
+  }
+}
+
+ContractionQuery::~ContractionQuery() {
+}
+
+void ContractionQuery::Clear() {
+  forward_.clear();
+  backward_.clear();
+  edges_.clear();
+  edgelabels_.clear();
+  has_ferry_ = false;
+}
+
+bool ContractionQuery::Supports(const std::string& costing,
+                                const valhalla::Location& origin,
+                                const valhalla::Location& dest,
+                                const Options& options) const {
+  if (!hierarchy_ || costing != "auto" || origin.has_date_time() || dest.has_date_time()) {
+    return false;
+  }
+  const auto& auto_options = options.costing_options(static_cast<int>(Costing::auto_));
+  return std::find(default_options_.cbegin(), default_options_.cend(),
+                   serialize(auto_options, kDefaultFlowMask)) != default_options_.cend();
+}
+
+void ContractionQuery::Seed(const valhalla::Location& location,
+                            GraphReader& graphreader,
+                            const bool forward,
+                            search_t& search) {
+  for (int i = 0; i < location.path_edges_size(); ++i) {
+    // The origin leaves its edge at the end node and the destination enters its edge at the
+    // start node so skip the edges where the location sits on the other node
+    const auto& edge = location.path_edges(i);
+    if ((forward && edge.end_node()) || (!forward && edge.begin_node())) {
+      continue;
+    }
+
+    GraphId edgeid(edge.graph_id());
+    graph_tile_ptr tile;
+    const auto* directededge = graphreader.directededge(edgeid, tile);
+    if (directededge == nullptr) {
+      continue;
+    }
+    const auto node_id = forward ? directededge->endnode() : graphreader.edge_startnode(edgeid, tile);
+    const auto node = hierarchy_->node_index(node_id);
+    if (node == ContractionHierarchy::kInvalidNode) {
+      continue;
+    }
+
+    const float fraction = forward ? 1.f - edge.percent_along() : edge.percent_along();
+    const float cost = costing_->EdgeCost(directededge, tile).cost * fraction + edge.distance();
+    auto inserted = search.labels.emplace(node, label_t{cost, ContractionHierarchy::kInvalidArc,
+                                                        static_cast<uint32_t>(i)});
+    if (!inserted.second && cost < inserted.first->second.cost) {
+      inserted.first->second = {cost, ContractionHierarchy::kInvalidArc, static_cast<uint32_t>(i)};
+    } else if (!inserted.second) {
+      continue;
+    }
+    search.queue.emplace(cost, node);
+  }
+}
+
+void ContractionQuery::Expand(const bool forward, float& best, uint32_t& meet) {
+  auto& search = forward ? forward_ : backward_;
+  const auto& other = forward ? backward_ : forward_;
+  const auto current = search.queue.top();
+  search.queue.pop();
+  if (current.first > search.labels[current.second].cost) {
+    return;
+  }
+
+  // Any node both directions reached is a candidate for the meeting point
+  auto found = other.labels.find(current.second);
+  if (found != other.labels.cend() && current.first + found->second.cost < best) {
+    best = current.first + found->second.cost;
+    meet = current.second;
+  }
+
+  // The forward search follows the arcs up from a node, the backward search the arcs down to it
+  const auto seed = search.labels[current.second].seed;
+  auto arcs = forward ? hierarchy_->upward(current.second) : hierarchy_->downward(current.second);
+  for (auto index : arcs) {
+    const auto& arc = hierarchy_->arc(index);
+    const auto next = forward ? arc.to : arc.from;
+    const float cost = current.first + arc.cost;
+    auto inserted = search.labels.emplace(next, label_t{cost, index, seed});
+    if (!inserted.second) {
+      if (cost >= inserted.first->second.cost) {
+        continue;
+      }
+      inserted.first->second = {cost, index, seed};
+    }
+    search.queue.emplace(cost, next);
+  }
+}
+
+std::vector<std::vector<PathInfo>>
+ContractionQuery::GetBestPath(valhalla::Location& origin,
+                              valhalla::Location& dest,
+                              GraphReader& graphreader,
+                              const sif::mode_costing_t& mode_costing,
+                              const sif::TravelMode mode,
+                              const Options& /*options*/) {
+  if (!hierarchy_) {
+    return {};
+  }
+  mode_ = mode;
+  costing_ = mode_costing[static_cast<uint32_t>(mode_)];
+
+  Seed(origin, graphreader, true, forward_);
+  Seed(dest, graphreader, false, backward_);
+
+  // Alternate by always settling the cheaper side, neither side can improve on the best meeting
+  // once both of their next nodes cost more than it
+  float best = kInfinity;
+  uint32_t meet = ContractionHierarchy::kInvalidNode;
+  for (size_t n = 0;; ++n) {
+    const float forward_cost = forward_.queue.empty() ? kInfinity : forward_.queue.top().first;
+    const float backward_cost = backward_.queue.empty() ? kInfinity : backward_.queue.top().first;
+    if (std::min(forward_cost, backward_cost) >= best ||
+        (forward_.queue.empty() && backward_.queue.empty())) {
+      break;
+    }
+    if (interrupt && (n % kInterruptIterationsInterval) == 0) {
+      (*interrupt)();
+    }
+    Expand(forward_cost <= backward_cost, best, meet);
+  }
+  if (meet == ContractionHierarchy::kInvalidNode) {
+    return {};
+  }
+
+  // Walk back down both searches from the meeting point and unpack the shortcuts on the way
+  std::vector<uint32_t> arcs;
+  auto label = forward_.labels[meet];
+  while (label.arc != ContractionHierarchy::kInvalidArc) {
+    arcs.push_back(label.arc);
+    label = forward_.labels[hierarchy_->arc(label.arc).from];
+  }
+  edges_.emplace_back(origin.path_edges(label.seed).graph_id());
+  std::for_each(arcs.rbegin(), arcs.rend(),
+                [this](uint32_t arc) { hierarchy_->Unpack(arc, edges_); });
+
+  label = backward_.labels[meet];
+  while (label.arc != ContractionHierarchy::kInvalidArc) {
+    hierarchy_->Unpack(label.arc, edges_);
+    label = backward_.labels[hierarchy_->arc(label.arc).to];
+  }
+  edges_.emplace_back(dest.path_edges(label.seed).graph_id());
+
+  auto path = FormPath(origin, dest, graphreader);
+  if (path.empty()) {
+    LOG_DEBUG("Contraction hierarchy path broke a restriction");
+    return {};
+  }
+  return {std::move(path)};
+}
+
+std::vector<PathInfo> ContractionQuery::FormPath(const valhalla::Location& origin,
+                                                 const valhalla::Location& dest,
+                                                 GraphReader& graphreader) {
+  auto percent_along = [](const valhalla::Location& location, const GraphId& edgeid) -> float {
+    for (const auto& edge : location.path_edges()) {
+      if (edge.graph_id() == edgeid) {
+        return edge.percent_along();
+      }
+    }
+    return 0.f;
+  };
+
+  std::vector<PathInfo> path;
+  path.reserve(edges_.size());
+  Cost elapsed;
+  float path_distance = 0.f;
+  for (size_t i = 0; i < edges_.size(); ++i) {
+    const auto& edgeid = edges_[i];
+    graph_tile_ptr tile;
+    const auto* edge = graphreader.directededge(edgeid, tile);
+    if (edge == nullptr) {
+      return {};
+    }
+
+    // The overlay knows nothing about turns so check them with the costing, the origin edge
+    // was already picked by loki
+    Cost transition_cost;
+    uint8_t restriction_idx = kInvalidRestriction;
+    if (i > 0) {
+      const auto& pred = edgelabels_.back();
+      const bool is_dest = i + 1 == edges_.size();
+      graph_tile_ptr node_tile = tile;
+      const auto* node =
+          graphreader.nodeinfo(graphreader.edge_startnode(edgeid, node_tile), node_tile);
+      if (node == nullptr ||
+          !costing_->Allowed(edge, is_dest, pred, tile, edgeid, 0, 0, restriction_idx) ||
+          costing_->Restricted(edge, pred, edgelabels_, tile, edgeid, true)) {
+        return {};
+      }
+      transition_cost = costing_->TransitionCost(edge, node, pred);
+    }
+
+    float fraction = 1.f;
+    if (i == 0) {
+      fraction -= percent_along(origin, edgeid);
+    } else if (i + 1 == edges_.size()) {
+      fraction = percent_along(dest, edgeid);
+    }
+    elapsed += costing_->EdgeCost(edge, tile) * fraction + transition_cost;
+    path_distance += edge->length() * fraction;
+    has_ferry_ = has_ferry_ || edge->use() == Use::kFerry;
+
+    path.emplace_back(mode_, elapsed, edgeid, 0, path_distance, restriction_idx, transition_cost);
+    const auto predecessor = edgelabels_.empty() ? kInvalidLabel : edgelabels_.size() - 1;
+    edgelabels_.emplace_back(predecessor, edgeid, edge, elapsed, elapsed.cost, 0.f, mode_,
+                             path_distance, transition_cost, restriction_idx, true, false,
+                             InternalTurn::kNoTurn);
+  }
+  return path;
+}
+
+} // namespace thor
+} // namespace valhalla
@@ -1,9 +1,16 @@
 #include <algorithm>
 #include <cmath>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "midgard/logging.h"
+#include "midgard/tracing.h"
+#include "sif/recost.h"
 #include "thor/costmatrix.h"
+#include "thor/matrix_common.h"
+#include "thor/pathalgorithm.h"
 #include "worker.h"
 
 #include <robin_hood.h>
@@ -26,6 +33,63 @@ bool equals(const valhalla::LatLng& a, const valhalla::LatLng& b) {
          (!a.has_lat() || a.lat() == b.lat()) && (!a.has_lng() || a.lng() == b.lng());
 }
 
+// The locations of the list with distinct correlations, which is all the searches of the matrix
+// look at, and for each location of the list the index of the one among them it is the same as
+google::protobuf::RepeatedPtrField<valhalla::Location>
+unique_locations(const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+                 std::vector<uint32_t>& indices) {
+  google::protobuf::RepeatedPtrField<valhalla::Location> unique;
+  std::unordered_map<std::string, uint32_t> seen;
+  indices.clear();
+  indices.reserve(locations.size());
+  for (const auto& location : locations) {
+    std::string key;
+    for (const auto& edge : location.path_edges()) {
+      const uint64_t graph_id = edge.graph_id();
+      const float percent_along = edge.percent_along(), distance = edge.distance();
+      const char nodes = edge.begin_node() | edge.end_node() << 1;
+      key.append(reinterpret_cast<const char*>(&graph_id), sizeof(graph_id));
+      key.append(reinterpret_cast<const char*>(&percent_along), sizeof(percent_along));
+      key.append(reinterpret_cast<const char*>(&distance), sizeof(distance));
+      key.push_back(nodes);
+    }
+    auto inserted = seen.emplace(std::move(key), unique.size());
+    if (inserted.second) {
+      *unique.Add() = location;
+    }
+    indices.push_back(inserted.first->second);
+  }
+  return unique;
+}
+
+constexpr uint32_t kMaxReservedLabelsCount = 1000000;
+constexpr uint32_t kMaxReservedLocationsCount = 25;
+
+// Clears the searches of a set of locations. The first max_locations of them keep their buffers,
+// up to max_labels edge labels each, so the next request can reuse them instead of reallocating
+template <typename adjacency_t, typename edgelabels_t, typename edgestatus_t>
+void clear_locations(adjacency_t& adjacency,
+                     edgelabels_t& edgelabels,
+                     edgestatus_t& edgestatus,
+                     const uint32_t max_locations,
+                     const uint32_t max_labels) {
+  const size_t count = std::min<size_t>(edgelabels.size(), max_locations);
+  adjacency.resize(count);
+  edgelabels.resize(count);
+  edgestatus.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    if (adjacency[i]) {
+      adjacency[i]->clear();
+    }
+    if (edgelabels[i].size() > max_labels) {
+      edgelabels[i].resize(max_labels);
+      edgelabels[i].shrink_to_fit();
+    }
+    edgelabels[i].clear();
+    edgestatus[i].clear();
+  }
+}
+
 } // namespace
 
 namespace valhalla {
@@ -34,9 +98,19 @@ namespace thor {
 class CostMatrix::TargetMap : public robin_hood::unordered_map<uint64_t, std::vector<uint32_t>> {};
 
 // Constructor with cost threshold.
-CostMatrix::CostMatrix()
-    : mode_(TravelMode::kDrive), access_mode_(kAutoAccess), source_count_(0), remaining_sources_(0),
-      target_count_(0), remaining_targets_(0), current_cost_threshold_(0), targets_{new TargetMap} {
+CostMatrix::CostMatrix(const boost::property_tree::ptree& config,
+                       const std::shared_ptr<MatrixWorkers>& workers)
+    : interrupt_(nullptr), mode_(TravelMode::kDrive), access_mode_(kAutoAccess),
+      max_reserved_locations_count_(
+          std::max(config.get<uint32_t>("max_reserved_locations_count", kMaxReservedLocationsCount),
+                   1u)),
+      max_reserved_labels_count_(
+          config.get<uint32_t>("max_reserved_labels_count", kMaxReservedLabelsCount) /
+          max_reserved_locations_count_),
+      max_active_locations_(config.get<uint32_t>("max_active_locations", 0)), source_count_(0),
+      remaining_sources_(0), target_count_(0), remaining_targets_(0),
+      current_cost_threshold_(0), cache_edge_costs_(config.get<bool>("cache_edge_costs", false)),
+      targets_{new TargetMap}, workers_(workers) {
 }
 
 CostMatrix::~CostMatrix() {
@@ -65,23 +139,83 @@ float CostMatrix::GetCostThreshold(const float max_matrix_distance) {
 // Clear the temporary information generated during time + distance matrix
 // construction.
 void CostMatrix::Clear() {
+  ClearSearches();
+  wave_stats_ = {};
+}
+
+// Clear the searches of the current wave of locations
+void CostMatrix::ClearSearches() {
   // Clear the target edge markings
   targets_->clear();
 
   // Clear all source adjacency lists, edge labels, and edge status
-  source_adjacency_.clear();
-  source_edgelabel_.clear();
-  source_edgestatus_.clear();
+  clear_locations(source_adjacency_, source_edgelabel_, source_edgestatus_,
+                  max_reserved_locations_count_, max_reserved_labels_count_);
 
   // Clear all target adjacency lists, edge labels, and edge status
-  target_adjacency_.clear();
-  target_edgelabel_.clear();
-  target_edgestatus_.clear();
+  clear_locations(target_adjacency_, target_edgelabel_, target_edgestatus_,
+                  max_reserved_locations_count_, max_reserved_labels_count_);
 
   source_hierarchy_limits_.clear();
   target_hierarchy_limits_.clear();
   source_status_.clear();
   target_status_.clear();
+  best_connection_.clear();
+  source_updates_.clear();
+  target_updates_.clear();
+  target_reached_.clear();
+}
+
+// Sums up the work of the waves done and of the searches of the current one
+SearchStats CostMatrix::Stats() const {
+  auto stats = wave_stats_;
+  stats += SearchesStats();
+  return stats;
+}
+
+// Sums up the work of the searches of the sources and of the targets
+SearchStats CostMatrix::SearchesStats() const {
+  SearchStats stats;
+  for (const auto* adjacency : {&source_adjacency_, &target_adjacency_}) {
+    for (const auto& queue : *adjacency) {
+      stats.queue_resorts += queue ? queue->resorts() : 0;
+    }
+  }
+  for (const auto* edgelabels : {&source_edgelabel_, &target_edgelabel_}) {
+    for (const auto& labels : *edgelabels) {
+      stats.labels += labels.size();
+    }
+  }
+  for (const auto* edgestatus : {&source_edgestatus_, &target_edgestatus_}) {
+    for (const auto& status : *edgestatus) {
+      stats.status_tiles += status.size();
+    }
+  }
+  for (const auto* hierarchy_limits : {&source_hierarchy_limits_, &target_hierarchy_limits_}) {
+    for (const auto& limits : *hierarchy_limits) {
+      stats.up_transitions += up_transitions(limits);
+    }
+  }
+  return stats;
+}
+
+// Runs a step of the search of each location
+void CostMatrix::RunSearches(
+    const uint32_t count,
+    GraphReader& graphreader,
+    const std::function<void(uint32_t, GraphReader&, EdgeCostCache*)>& step) {
+  auto edge_costs = [this](uint32_t slot) {
+    return cache_edge_costs_ ? &edge_costs_[slot] : nullptr;
+  };
+  if (workers_) {
+    workers_->Run(count, graphreader, [&](uint32_t i, uint32_t slot, GraphReader& reader) {
+      step(i, reader, edge_costs(slot));
+    });
+    return;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    step(i, graphreader, edge_costs(0));
+  }
 }
 
 // Form a time distance matrix from the set of source locations
@@ -93,6 +227,8 @@ std::vector<TimeDistance> CostMatrix::SourceToTarget(
     const sif::mode_costing_t& mode_costing,
     const TravelMode mode,
     const float max_matrix_distance) {
+  VALHALLA_TRACE_SPAN("CostMatrix::SourceToTarget");
+
   // Set the mode and costing
   mode_ = mode;
   costing_ = mode_costing[static_cast<uint32_t>(mode_)];
@@ -100,8 +236,86 @@ std::vector<TimeDistance> CostMatrix::SourceToTarget(
 
   current_cost_threshold_ = GetCostThreshold(max_matrix_distance);
 
-  // Set the source and target locations
+  // The edge costs are shared by all of the waves and kept for the next matrices as long as they
+  // are made with the same costing options on the same graph
   Clear();
+  if (cache_edge_costs_) {
+    edge_costs_.resize(workers_ ? workers_->size() : 1);
+    for (auto& edge_costs : edge_costs_) {
+      edge_costs.Reset(costing_.get(), kConstrainedFlowSecondOfDay, graphreader.id());
+    }
+  }
+
+  // Locations which snapped to the very same spots of the same edges, like the doors of a building,
+  // have the same searches so only one of each is searched for and its row or column handed out to
+  // the others. Those at the same coordinates as each other are still trivially 0 apart
+  const auto unique_sources = unique_locations(source_location_list, source_indices_);
+  const auto unique_targets = unique_locations(target_location_list, target_indices_);
+  if (unique_sources.size() == source_location_list.size() &&
+      unique_targets.size() == target_location_list.size()) {
+    return SearchWaves(source_location_list, target_location_list, graphreader);
+  }
+  const auto unique_td = SearchWaves(unique_sources, unique_targets, graphreader);
+  std::vector<TimeDistance> td;
+  td.reserve(source_location_list.size() * target_location_list.size());
+  for (int i = 0; i < source_location_list.size(); ++i) {
+    for (int j = 0; j < target_location_list.size(); ++j) {
+      if (equals(source_location_list.Get(i).ll(), target_location_list.Get(j).ll())) {
+        td.emplace_back(0, 0);
+      } else {
+        td.push_back(unique_td[source_indices_[i] * unique_targets.size() + target_indices_[j]]);
+      }
+    }
+  }
+  return td;
+}
+
+// Form the time distance matrix wave by wave
+std::vector<TimeDistance> CostMatrix::SearchWaves(
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+    GraphReader& graphreader) {
+  // Small enough matrices are searched from all of their locations at once
+  const uint32_t source_count = source_location_list.size();
+  const uint32_t target_count = target_location_list.size();
+  const uint32_t wave_size = max_active_locations_;
+  if (wave_size == 0 || (source_count <= wave_size && target_count <= wave_size)) {
+    return SearchWave(source_location_list, target_location_list, graphreader);
+  }
+
+  // Otherwise each block of the matrix comes from the searches of its own sources and targets,
+  // the searches of a wave are dropped before the next one so the memory is bound by the wave
+  std::vector<TimeDistance> td(source_count * target_count);
+  google::protobuf::RepeatedPtrField<valhalla::Location> sources, targets;
+  for (uint32_t source = 0; source < source_count; source += wave_size) {
+    sources.Clear();
+    for (uint32_t i = source; i < std::min(source + wave_size, source_count); ++i) {
+      *sources.Add() = source_location_list.Get(i);
+    }
+    for (uint32_t target = 0; target < target_count; target += wave_size) {
+      targets.Clear();
+      for (uint32_t j = target; j < std::min(target + wave_size, target_count); ++j) {
+        *targets.Add() = target_location_list.Get(j);
+      }
+      const auto wave = SearchWave(sources, targets, graphreader);
+      wave_stats_ += SearchesStats();
+      for (int i = 0; i < sources.size(); ++i) {
+        std::copy_n(wave.begin() + i * targets.size(), targets.size(),
+                    td.begin() + (source + i) * target_count + target);
+      }
+    }
+  }
+  ClearSearches();
+  return td;
+}
+
+// Form the time distance matrix of a wave of locations
+std::vector<TimeDistance> CostMatrix::SearchWave(
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+    GraphReader& graphreader) {
+  // Set the source and target locations
+  ClearSearches();
   SetSources(graphreader, source_location_list);
   SetTargets(graphreader, target_location_list);
 
@@ -112,33 +326,58 @@ std::vector<TimeDistance> CostMatrix::SourceToTarget(
 
   // Perform backward search from all target locations. Perform forward
   // search from all source locations. Connections between the 2 search
-  // spaces is checked during the forward search.
+  // spaces is checked during the forward search. The searches of one
+  // direction only touch their own location so they can run in parallel,
+  // anything they share is updated once all of them advanced.
+  // Every iteration expands each location once so check for an interrupt about as often as the
+  // other path algorithms do
+  const int interrupt_interval =
+      std::max<int>(1, kInterruptIterationsInterval / std::max(1u, source_count_ + target_count_));
   int n = 0;
   while (true) {
+    if (interrupt_ && (n % interrupt_interval) == 0) {
+      (*interrupt_)();
+    }
+
     // Iterate all target locations in a backwards search
+    RunSearches(target_count_, graphreader,
+                [this](uint32_t i, GraphReader& reader, EdgeCostCache* edge_costs) {
+                  if (target_status_[i].threshold > 0) {
+                    target_status_[i].threshold--;
+                    BackwardSearch(i, reader, edge_costs);
+                  }
+                });
     for (uint32_t i = 0; i < target_count_; i++) {
-      if (target_status_[i].threshold > 0) {
-        target_status_[i].threshold--;
-        BackwardSearch(i, graphreader);
-        if (target_status_[i].threshold == 0) {
-          target_status_[i].threshold = -1;
-          if (remaining_targets_ > 0) {
-            remaining_targets_--;
-          }
+      for (const auto& update : target_updates_[i]) {
+        UpdateStatus(update);
+      }
+      target_updates_[i].clear();
+      AddTargetEdges(i);
+      if (target_status_[i].threshold == 0) {
+        target_status_[i].threshold = -1;
+        if (remaining_targets_ > 0) {
+          remaining_targets_--;
         }
       }
     }
 
     // Iterate all source locations in a forward search
+    RunSearches(source_count_, graphreader,
+                [this, n](uint32_t i, GraphReader& reader, EdgeCostCache* edge_costs) {
+                  if (source_status_[i].threshold > 0) {
+                    source_status_[i].threshold--;
+                    ForwardSearch(i, n, reader, edge_costs);
+                  }
+                });
     for (uint32_t i = 0; i < source_count_; i++) {
-      if (source_status_[i].threshold > 0) {
-        source_status_[i].threshold--;
-        ForwardSearch(i, n, graphreader);
-        if (source_status_[i].threshold == 0) {
-          source_status_[i].threshold = -1;
-          if (remaining_sources_ > 0) {
-            remaining_sources_--;
-          }
+      for (const auto& update : source_updates_[i]) {
+        UpdateStatus(update);
+      }
+      source_updates_[i].clear();
+      if (source_status_[i].threshold == 0) {
+        source_status_[i].threshold = -1;
+        if (remaining_sources_ > 0) {
+          remaining_sources_--;
         }
       }
     }
@@ -158,15 +397,137 @@ std::vector<TimeDistance> CostMatrix::SourceToTarget(
   }
 
   // Form the time, distance matrix from the destinations list
-  uint32_t idx = 0;
+  return FormTimeDistanceMatrix();
+}
+
+// Form the time, distance matrix from the best connections
+std::vector<TimeDistance> CostMatrix::FormTimeDistanceMatrix() {
   std::vector<TimeDistance> td;
+  td.reserve(best_connection_.size());
   for (const auto& connection : best_connection_) {
     td.emplace_back(std::round(connection.cost.secs), std::round(connection.distance));
-    idx++;
   }
   return td;
 }
 
+// Form the path of a best connection from the labels of the forward and backward searches
+std::vector<PathInfo> CostMatrix::FormPath(GraphReader& graphreader,
+                                           const valhalla::Location& origin,
+                                           const valhalla::Location& destination,
+                                           const uint32_t source,
+                                           const uint32_t target) {
+  // The searches are dropped once the matrix is made in waves
+  if (best_connection_.empty() || source >= source_indices_.size() ||
+      target >= target_indices_.size()) {
+    return {};
+  }
+  const uint32_t s = source_indices_[source];
+  const uint32_t t = target_indices_[target];
+  const auto& connection = best_connection_[s * target_count_ + t];
+  if (!connection.edgeid.Is_Valid() || !connection.opp_edgeid.Is_Valid()) {
+    return {};
+  }
+
+  // Get the labels where the connection occurs
+  const auto& forward_labels = source_edgelabel_[s];
+  const auto& reverse_labels = target_edgelabel_[t];
+  const auto forward_status = source_edgestatus_[s].Get(connection.edgeid);
+  const auto reverse_status = target_edgestatus_[t].Get(connection.opp_edgeid);
+  if (forward_status.set() == EdgeSet::kUnreachedOrReset ||
+      reverse_status.set() == EdgeSet::kUnreachedOrReset) {
+    return {};
+  }
+  const uint32_t idx1 = forward_status.index();
+  const uint32_t idx2 = reverse_status.index();
+  if (forward_labels[idx1].predecessor() == kInvalidLabel &&
+      reverse_labels[idx2].predecessor() == kInvalidLabel) {
+    return {};
+  }
+
+  // Adds an edge of the path, recovering the edges of a shortcut in the order they are walked
+  std::vector<GraphId> path_edges;
+  std::unordered_set<GraphId> recovered_inner_edges;
+  graph_tile_ptr tile;
+  const auto add_edge = [&](const GraphId& edgeid, const bool backward) {
+    const DirectedEdge* edge = graphreader.directededge(edgeid, tile);
+    if (edge == nullptr) {
+      return false;
+    }
+    if (edge->is_shortcut()) {
+      auto superseded = graphreader.RecoverShortcut(edgeid);
+      recovered_inner_edges.insert(superseded.begin() + 1, superseded.end());
+      if (backward) {
+        path_edges.insert(path_edges.end(), superseded.rbegin(), superseded.rend());
+      } else {
+        path_edges.insert(path_edges.end(), superseded.begin(), superseded.end());
+      }
+    } else {
+      path_edges.push_back(edgeid);
+    }
+    return true;
+  };
+
+  // Work backwards on the forward path then append the reverse path using its opposing edges,
+  // the first edge on the reverse path is the same as the last on the forward path
+  for (auto index = idx1; index != kInvalidLabel; index = forward_labels[index].predecessor()) {
+    if (!add_edge(forward_labels[index].edgeid(), true)) {
+      return {};
+    }
+  }
+  std::reverse(path_edges.begin(), path_edges.end());
+  for (auto index = reverse_labels[idx2].predecessor(); index != kInvalidLabel;
+       index = reverse_labels[index].predecessor()) {
+    if (!add_edge(reverse_labels[index].opp_edgeid(), false)) {
+      return {};
+    }
+  }
+
+  // Find where on their edges the path starts and ends
+  const auto percent_along = [](const valhalla::Location& location,
+                                const GraphId& edgeid) -> float {
+    for (const auto& edge : location.path_edges()) {
+      if (edge.graph_id() == edgeid) {
+        return edge.percent_along();
+      }
+    }
+    return -1.f;
+  };
+  const float source_pct = percent_along(origin, path_edges.front());
+  const float target_pct = percent_along(destination, path_edges.back());
+  if (source_pct < 0 || target_pct < 0) {
+    return {};
+  }
+
+  // Recost the edges of the path the same way the path algorithms do; ignore access restrictions
+  std::vector<PathInfo> path;
+  path.reserve(path_edges.size());
+  auto edge_itr = path_edges.begin();
+  const auto edge_cb = [&edge_itr, &path_edges]() {
+    return (edge_itr == path_edges.end()) ? GraphId{} : (*edge_itr++);
+  };
+  const auto label_cb = [&path, &recovered_inner_edges](const EdgeLabel& label) {
+    path.emplace_back(label.mode(), label.cost(), label.edgeid(), 0, label.path_distance(),
+                      label.restriction_idx(), label.transition_cost(),
+                      recovered_inner_edges.count(label.edgeid()));
+  };
+  try {
+    sif::recost_forward(graphreader, *costing_, edge_cb, label_cb, source_pct, target_pct,
+                        TimeInfo::invalid(), false, true);
+  } catch (const std::exception& e) {
+    LOG_WARN(std::string("CostMatrix failed to recost a path: ") + e.what());
+    return {};
+  }
+  return path;
+}
+
+// Add the edges reached by the backward search of a target to the target map
+void CostMatrix::AddTargetEdges(const uint32_t target) {
+  for (const auto& edgeid : target_reached_[target]) {
+    (*targets_)[edgeid].push_back(target);
+  }
+  target_reached_[target].clear();
+}
+
 // Initialize all time distance to "not found". Any locations that
 // are the same get set to 0 time, distance and do not add to the
 // remaining locations set.
@@ -214,10 +575,18 @@ void CostMatrix::Initialize(
       remaining_targets_++;
     }
   }
+
+  // Nothing is pending for any of the locations yet
+  source_updates_.resize(source_count_);
+  target_updates_.resize(target_count_);
+  target_reached_.resize(target_count_);
 }
 
 // Iterate the forward search from the source/origin location.
-void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphReader& graphreader) {
+void CostMatrix::ForwardSearch(const uint32_t index,
+                               const uint32_t n,
+                               GraphReader& graphreader,
+                               EdgeCostCache* edge_costs) {
   // Get the next edge from the adjacency list for this source location
   auto& adj = source_adjacency_[index];
   auto& edgelabels = source_edgelabel_[index];
@@ -226,7 +595,7 @@ void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphRead
     // Forward search is exhausted - mark this and update so we don't
     // extend searches more than we need to
     for (uint32_t target = 0; target < target_count_; target++) {
-      UpdateStatus(index, target);
+      QueueStatus(source_updates_[index], index, target);
     }
     source_status_[index].threshold = 0;
     return;
@@ -234,7 +603,8 @@ void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphRead
 
   // Get edge label and check cost threshold
   BDEdgeLabel pred = edgelabels[pred_idx];
-  if (pred.cost().secs > current_cost_threshold_) {
+  if (pred.cost().secs > current_cost_threshold_ ||
+      pred.cost().cost > source_status_[index].cost_bound) {
     source_status_[index].threshold = 0;
     return;
   }
@@ -270,24 +640,27 @@ void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphRead
     GraphId edgeid = {node.tileid(), node.level(), nodeinfo->edge_index()};
     EdgeStatusInfo* es = edgestate.GetPtr(edgeid, tile);
     const DirectedEdge* directededge = tile->directededge(nodeinfo->edge_index());
-    for (uint32_t i = 0; i < nodeinfo->edge_count(); i++, directededge++, ++edgeid, ++es) {
+    const RoutingEdge* routing = tile->routing_edge(nodeinfo->edge_index());
+    const auto allowed = costing_->AllowedMask(routing, nodeinfo->edge_count(), true, true);
+    for (uint32_t i = 0; i < nodeinfo->edge_count();
+         i++, directededge++, routing++, ++edgeid, ++es) {
       // Skip shortcut edges until we have stopped expanding on the next level. Use regular
       // edges while still expanding on the next level since we can still transition down to
       // that level. If using a shortcut, set the shortcuts mask. Skip if this is a regular
       // edge superseded by a shortcut.
-      if (directededge->is_shortcut()) {
+      if (routing->is_shortcut()) {
         if (hierarchy_limits[edgeid.level() + 1].StopExpanding()) {
-          shortcuts |= directededge->shortcut();
+          shortcuts |= routing->shortcut();
         } else {
           continue;
         }
-      } else if (shortcuts & directededge->superseded()) {
+      } else if (shortcuts & routing->superseded()) {
         continue;
       }
 
       // Skip this edge if permanently labeled (best path already found to this
       // directed edge) or if no access for this mode.
-      if (es->set() == EdgeSet::kPermanent || !(directededge->forwardaccess() & access_mode_)) {
+      if (es->set() == EdgeSet::kPermanent || !allowed.test(i)) {
         continue;
       }
 
@@ -304,7 +677,9 @@ void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphRead
       uint8_t flow_sources;
       Cost newcost =
           pred.cost() + tc +
-          costing_->EdgeCost(directededge, tile, kConstrainedFlowSecondOfDay, flow_sources);
+          (edge_costs ? edge_costs->EdgeCost(edgeid, directededge, tile, flow_sources)
+                      : costing_->EdgeCost(directededge, tile, kConstrainedFlowSecondOfDay,
+                                           flow_sources));
 
       // Check if edge is temporarily labeled and this path has less cost. If
       // less cost the predecessor is updated along with new cost and distance.
@@ -320,7 +695,7 @@ void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphRead
 
       // Get end node tile (skip if tile is not found) and opposing edge Id
       graph_tile_ptr t2 =
-          directededge->leaves_tile() ? graphreader.GetGraphTile(directededge->endnode()) : tile;
+          routing->leaves_tile() ? graphreader.GetGraphTile(routing->endnode()) : tile;
       if (t2 == nullptr) {
         continue;
       }
@@ -434,7 +809,7 @@ void CostMatrix::CheckForwardConnections(const uint32_t source,
 
         // Update status and update threshold if this is the last location
         // to find for this source or target
-        UpdateStatus(source, target);
+        QueueStatus(source_updates_[source], source, target);
       } else {
         float oppcost = (predidx == kInvalidLabel) ? 0 : edgelabels[predidx].cost().cost;
         float c = pred.cost().cost + oppcost + opp_el.transition_cost().cost;
@@ -456,44 +831,54 @@ void CostMatrix::CheckForwardConnections(const uint32_t source,
 
           // Update status and update threshold if this is the last location
           // to find for this source or target
-          UpdateStatus(source, target);
+          QueueStatus(source_updates_[source], source, target);
         }
       }
     }
   }
 }
 
+// Queue a status update, the threshold is based on how far the searches got when the
+// connection was found
+void CostMatrix::QueueStatus(std::vector<StatusUpdate>& updates,
+                             const uint32_t source,
+                             const uint32_t target) {
+  updates.push_back({source, target,
+                     GetThreshold(mode_, source_edgelabel_[source].size() +
+                                             target_edgelabel_[target].size())});
+}
+
 // Update status when a connection is found.
-void CostMatrix::UpdateStatus(const uint32_t source, const uint32_t target) {
+void CostMatrix::UpdateStatus(const StatusUpdate& update) {
   // Remove the target from the source status
-  auto& s = source_status_[source].remaining_locations;
-  auto it = s.find(target);
+  auto& s = source_status_[update.source].remaining_locations;
+  auto it = s.find(update.target);
   if (it != s.end()) {
     s.erase(it);
-    if (s.empty() && source_status_[source].threshold > 0) {
+    if (s.empty() && source_status_[update.source].threshold > 0) {
       // At least 1 connection has been found to each target for this source.
       // Set a threshold to continue search for a limited number of times.
-      source_status_[source].threshold =
-          GetThreshold(mode_, source_edgelabel_[source].size() + target_edgelabel_[target].size());
+      source_status_[update.source].threshold = update.threshold;
     }
   }
 
   // Remove the source from the target status
-  auto& t = target_status_[target].remaining_locations;
-  it = t.find(source);
+  auto& t = target_status_[update.target].remaining_locations;
+  it = t.find(update.source);
   if (it != t.end()) {
     t.erase(it);
-    if (t.empty() && target_status_[target].threshold > 0) {
+    if (t.empty() && target_status_[update.target].threshold > 0) {
       // At least 1 connection has been found to each source for this target.
       // Set a threshold to continue search for a limited number of times.
-      target_status_[target].threshold =
-          GetThreshold(mode_, source_edgelabel_[source].size() + target_edgelabel_[target].size());
+      target_status_[update.target].threshold = update.threshold;
     }
   }
 }
 
 // Expand the backwards search trees.
-void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader) {
+void CostMatrix::BackwardSearch(const uint32_t index,
+                                GraphReader& graphreader,
+                                EdgeCostCache* edge_costs) {
   // Get the next edge from the adjacency list for this target location
   auto& adj = target_adjacency_[index];
   auto& edgelabels = target_edgelabel_[index];
@@ -502,7 +887,7 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
     // Backward search is exhausted - mark this and update so we don't
     // extend searches more than we need to
     for (uint32_t source = 0; source < source_count_; source++) {
-      UpdateStatus(source, index);
+      QueueStatus(target_updates_[index], source, index);
     }
     target_status_[index].threshold = 0;
     return;
@@ -510,7 +895,8 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
 
   // Copy predecessor, check cost threshold
   BDEdgeLabel pred = edgelabels[pred_idx];
-  if (pred.cost().secs > current_cost_threshold_) {
+  if (pred.cost().secs > current_cost_threshold_ ||
+      pred.cost().cost > target_status_[index].cost_bound) {
     target_status_[index].threshold = 0;
     return;
   }
@@ -544,31 +930,34 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
     GraphId edgeid(node.tileid(), node.level(), nodeinfo->edge_index());
     EdgeStatusInfo* es = edgestate.GetPtr(edgeid, tile);
     const DirectedEdge* directededge = tile->directededge(nodeinfo->edge_index());
-    for (uint32_t i = 0; i < nodeinfo->edge_count(); i++, directededge++, ++edgeid, ++es) {
+    const RoutingEdge* routing = tile->routing_edge(nodeinfo->edge_index());
+    const auto allowed = costing_->AllowedMask(routing, nodeinfo->edge_count(), false, true);
+    for (uint32_t i = 0; i < nodeinfo->edge_count();
+         i++, directededge++, routing++, ++edgeid, ++es) {
       // Skip shortcut edges until we have stopped expanding on the next level. Use regular
       // edges while still expanding on the next level since we can still transition down to
       // that level. If using a shortcut, set the shortcuts mask. Skip if this is a regular
       // edge superseded by a shortcut.
-      if (directededge->is_shortcut()) {
+      if (routing->is_shortcut()) {
         if (hierarchy_limits[edgeid.level() + 1].StopExpanding()) {
-          shortcuts |= directededge->shortcut();
+          shortcuts |= routing->shortcut();
         } else {
           continue;
         }
-      } else if (shortcuts & directededge->superseded()) {
+      } else if (shortcuts & routing->superseded()) {
         continue;
       }
 
       // Skip edges not allowed by the access mode. Do this here to avoid having
       // to get opposing edge. Also skip edges that are permanently labeled (
       // best path already found to this directed edge).
-      if (!(directededge->reverseaccess() & access_mode_) || es->set() == EdgeSet::kPermanent) {
+      if (!allowed.test(i) || es->set() == EdgeSet::kPermanent) {
         continue;
       }
 
       // Get opposing edge Id and end node tile
       graph_tile_ptr t2 =
-          directededge->leaves_tile() ? graphreader.GetGraphTile(directededge->endnode()) : tile;
+          routing->leaves_tile() ? graphreader.GetGraphTile(routing->endnode()) : tile;
       if (t2 == nullptr) {
         continue;
       }
@@ -590,8 +979,11 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
                                                 opp_pred_edge, pred.has_measured_speed(),
                                                 pred.internal_turn());
       uint8_t flow_sources;
-      Cost newcost = pred.cost() + tc +
-                     costing_->EdgeCost(opp_edge, tile, kConstrainedFlowSecondOfDay, flow_sources);
+      Cost newcost =
+          pred.cost() + tc +
+          (edge_costs
+               ? edge_costs->EdgeCost(oppedge, opp_edge, tile, flow_sources)
+               : costing_->EdgeCost(opp_edge, tile, kConstrainedFlowSecondOfDay, flow_sources));
 
       // Check if edge is temporarily labeled and this path has less cost. If
       // less cost the predecessor is updated along with new cost and distance.
@@ -619,7 +1011,7 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
       adj->add(idx);
 
       // Add to the list of targets that have reached this edge
-      (*targets_)[edgeid].push_back(index);
+      target_reached_[index].push_back(edgeid);
     }
 
     // Handle transitions - expand from the end node of the transition
@@ -680,9 +1072,14 @@ void CostMatrix::SetSources(GraphReader& graphreader,
   for (const auto& origin : sources) {
     // Allocate the adjacency list and hierarchy limits for this source.
     // Use the cost threshold to size the adjacency list.
-    source_adjacency_[index].reset(new DoubleBucketQueue<BDEdgeLabel>(0, current_cost_threshold_,
-                                                                      costing_->UnitSize(),
-                                                                      &source_edgelabel_[index]));
+    if (source_adjacency_[index]) {
+      source_adjacency_[index]->reuse(0, current_cost_threshold_, costing_->UnitSize(),
+                                      &source_edgelabel_[index]);
+    } else {
+      source_adjacency_[index].reset(new DoubleBucketQueue<BDEdgeLabel>(0, current_cost_threshold_,
+                                                                        costing_->UnitSize(),
+                                                                        &source_edgelabel_[index]));
+    }
     source_hierarchy_limits_[index] = costing_->GetHierarchyLimits();
 
     // Iterate through edges and add to adjacency list
@@ -756,9 +1153,14 @@ void CostMatrix::SetTargets(baldr::GraphReader& graphreader,
   for (const auto& dest : targets) {
     // Allocate the adjacency list and hierarchy limits for target location.
     // Use the cost threshold to size the adjacency list.
-    target_adjacency_[index].reset(new DoubleBucketQueue<BDEdgeLabel>(0, current_cost_threshold_,
-                                                                      costing_->UnitSize(),
-                                                                      &target_edgelabel_[index]));
+    if (target_adjacency_[index]) {
+      target_adjacency_[index]->reuse(0, current_cost_threshold_, costing_->UnitSize(),
+                                      &target_edgelabel_[index]);
+    } else {
+      target_adjacency_[index].reset(new DoubleBucketQueue<BDEdgeLabel>(0, current_cost_threshold_,
+                                                                        costing_->UnitSize(),
+                                                                        &target_edgelabel_[index]));
+    }
     target_hierarchy_limits_[index] = costing_->GetHierarchyLimits();
 
     // Iterate through edges and add to adjacency list
@@ -2,6 +2,8 @@
 #include "baldr/datetime.h"
 #include "midgard/distanceapproximator.h"
 #include "midgard/logging.h"
+#include "midgard/tracing.h"
+#include "sif/autocost.h"
 #include <algorithm>
 #include <map>
 
@@ -46,7 +48,7 @@ Dijkstras::Dijkstras(const boost::property_tree::ptree& config)
     : mode_(TravelMode::kDrive), access_mode_(kAutoAccess),
       max_reserved_labels_count_(
           config.get<uint32_t>("max_reserved_labels_count", kInitialEdgeLabelCount)),
-      multipath_(false) {
+      multipath_(false), track_origins_(false), expanding_origin_(0), interrupt_(nullptr) {
 }
 
 // Clear the temporary information generated during path construction.
@@ -64,10 +66,12 @@ void Dijkstras::Clear() {
     mmedgelabels_.shrink_to_fit();
   }
   mmedgelabels_.clear();
+  label_origins_.clear();
 
   adjacencylist_.clear();
   mmadjacencylist_.clear();
   edgestatus_.clear();
+  up_transitions_ = 0;
 }
 
 // Initialize - create adjacency list, edgestatus support, and reserve
@@ -81,6 +85,7 @@ void Dijkstras::Initialize(label_container_t& labels,
   uint32_t bucket_count;
   GetExpansionHints(bucket_count, edge_label_reservation);
   labels.reserve(std::min(max_reserved_labels_count_, edge_label_reservation));
+  label_origins_.clear();
 
   // Set up lambda to get sort costs
   float range = bucket_count * bucket_size;
@@ -99,17 +104,11 @@ Dijkstras::Initialize<decltype(Dijkstras::mmedgelabels_)>(decltype(Dijkstras::mm
 std::vector<TimeInfo>
 Dijkstras::SetTime(google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
                    GraphReader& reader) {
-  // loop over all locations setting the date time with timezone
-  std::vector<TimeInfo> infos;
-  for (auto& location : locations) {
-    infos.emplace_back(TimeInfo::make(location, reader, &tz_cache_));
-  }
-
-  // Hand back the time information
-  return infos;
+  // set the date time with timezone of all the locations, sharing it where they have the same one
+  return TimeInfo::make(locations, reader);
 }
 
-template <const ExpansionType expansion_direction>
+template <const ExpansionType expansion_direction, typename kernel_t>
 void Dijkstras::ExpandInner(baldr::GraphReader& graphreader,
                             const baldr::GraphId& node,
                             const typename decltype(Dijkstras::bdedgelabels_)::value_type& pred,
@@ -134,11 +133,15 @@ void Dijkstras::ExpandInner(baldr::GraphReader& graphreader,
     // Let implementing class know we are expanding from here
     EdgeLabel* prev_pred =
         pred.predecessor() == kInvalidLabel ? nullptr : &bdedgelabels_[pred.predecessor()];
+    if (track_origins_) {
+      expanding_origin_ = label_origins_[pred_idx];
+    }
     ExpandingNode(graphreader, tile, nodeinfo, pred, prev_pred);
   }
 
   // Bail if we cant expand from here
-  if (!costing_->Allowed(nodeinfo)) {
+  const kernel_t costing(*costing_);
+  if (!costing.Allowed(nodeinfo)) {
     return;
   }
 
@@ -153,13 +156,14 @@ void Dijkstras::ExpandInner(baldr::GraphReader& graphreader,
   GraphId edgeid = {node.tileid(), node.level(), nodeinfo->edge_index()};
   EdgeStatusInfo* es = edgestatus_.GetPtr(edgeid, tile, pred.path_id());
   const DirectedEdge* directededge = tile->directededge(edgeid);
+  const auto allowed =
+      costing_->AllowedMask(tile->routing_edge(edgeid.id()), nodeinfo->edge_count(), FORWARD);
   for (uint32_t i = 0; i < nodeinfo->edge_count(); ++i, ++directededge, ++edgeid, ++es) {
     // Skip this edge if permanently labeled (best path already found to this
     // directed edge). skip shortcuts or if no access is allowed to this edge
     // (based on the costing method) or if a complex restriction exists for
     // this path.
-    if (directededge->is_shortcut() || es->set() == EdgeSet::kPermanent ||
-        !((FORWARD ? directededge->forwardaccess() : directededge->reverseaccess()) & access_mode_)) {
+    if (!allowed.test(i) || es->set() == EdgeSet::kPermanent) {
       continue;
     }
 
@@ -187,9 +191,9 @@ void Dijkstras::ExpandInner(baldr::GraphReader& graphreader,
     if (offset_time.valid) {
       // With date time we check time dependent restrictions and access
       const bool allowed =
-          FORWARD ? costing_->Allowed(directededge, is_dest, pred, tile, edgeid,
+          FORWARD ? costing.Allowed(directededge, is_dest, pred, tile, edgeid,
                                       offset_time.local_time, nodeinfo->timezone(), restriction_idx)
-                  : costing_->AllowedReverse(directededge, pred, opp_edge, t2, oppedgeid,
+                  : costing.AllowedReverse(directededge, pred, opp_edge, t2, oppedgeid,
                                              offset_time.local_time, nodeinfo->timezone(),
                                              restriction_idx);
       if (!allowed || costing_->Restricted(directededge, pred, bdedgelabels_, tile, edgeid, true,
@@ -197,9 +201,9 @@ void Dijkstras::ExpandInner(baldr::GraphReader& graphreader,
         continue;
       }
     } else {
-      const bool allowed = FORWARD ? costing_->Allowed(directededge, is_dest, pred, tile, edgeid, 0,
+      const bool allowed = FORWARD ? costing.Allowed(directededge, is_dest, pred, tile, edgeid, 0,
                                                        0, restriction_idx)
-                                   : costing_->AllowedReverse(directededge, pred, opp_edge, t2,
+                                   : costing.AllowedReverse(directededge, pred, opp_edge, t2,
                                                               oppedgeid, 0, 0, restriction_idx);
 
       if (!allowed || costing_->Restricted(directededge, pred, bdedgelabels_, tile, edgeid, true)) {
@@ -212,17 +216,17 @@ void Dijkstras::ExpandInner(baldr::GraphReader& graphreader,
     uint8_t flow_sources;
 
     if (FORWARD) {
-      transition_cost = costing_->TransitionCost(directededge, nodeinfo, pred);
+      transition_cost = costing.TransitionCost(directededge, nodeinfo, pred);
       newcost = pred.cost() +
-                costing_->EdgeCost(directededge, tile, offset_time.second_of_week, flow_sources) +
+                costing.EdgeCost(directededge, tile, offset_time.second_of_week, flow_sources) +
                 transition_cost;
     } else {
       transition_cost =
-          costing_->TransitionCostReverse(directededge->localedgeidx(), nodeinfo, opp_edge,
+          costing.TransitionCostReverse(directededge->localedgeidx(), nodeinfo, opp_edge,
                                           opp_pred_edge, pred.has_measured_speed(),
                                           pred.internal_turn());
       newcost = pred.cost() +
-                costing_->EdgeCost(opp_edge, t2, offset_time.second_of_week, flow_sources) +
+                costing.EdgeCost(opp_edge, t2, offset_time.second_of_week, flow_sources) +
                 transition_cost;
     }
     uint32_t path_dist = pred.path_distance() + directededge->length();
@@ -236,6 +240,9 @@ void Dijkstras::ExpandInner(baldr::GraphReader& graphreader,
         float newsortcost = lab.sortcost() - (lab.cost().cost - newcost.cost);
         adjacencylist_.decrease(es->index(), newsortcost);
         lab.Update(pred_idx, newcost, newsortcost, transition_cost, path_dist, restriction_idx);
+        if (track_origins_) {
+          label_origins_[es->index()] = label_origins_[pred_idx];
+        }
       }
       continue;
     }
@@ -252,7 +259,7 @@ void Dijkstras::ExpandInner(baldr::GraphReader& graphreader,
     *es = {EdgeSet::kTemporary, idx};
     bdedgelabels_.emplace_back(pred_idx, edgeid, oppedgeid, directededge, newcost, mode_,
                                transition_cost, path_dist, false,
-                               (pred.closure_pruning() || !costing_->IsClosed(directededge, tile)),
+                               (pred.closure_pruning() || !costing.IsClosed(directededge, tile)),
                                static_cast<bool>(flow_sources & kDefaultFlowMask),
                                (expansion_direction == ExpansionType::forward)
                                    ? costing_->TurnType(pred.opp_local_idx(), nodeinfo, directededge)
@@ -260,14 +267,18 @@ void Dijkstras::ExpandInner(baldr::GraphReader& graphreader,
                                                         opp_edge, opp_pred_edge),
                                restriction_idx, pred.path_id());
     adjacencylist_.add(idx);
+    if (track_origins_) {
+      label_origins_.push_back(label_origins_[pred_idx]);
+    }
   }
 
   // Handle transitions - expand from the end node of each transition
   if (!from_transition && nodeinfo->transition_count() > 0) {
     const baldr::NodeTransition* trans = tile->transition(nodeinfo->transition_index());
     for (uint32_t i = 0; i < nodeinfo->transition_count(); ++i, ++trans) {
-      ExpandInner<expansion_direction>(graphreader, trans->endnode(), pred, pred_idx, opp_pred_edge,
-                                       true, offset_time);
+      up_transitions_ += trans->up();
+      ExpandInner<expansion_direction, kernel_t>(graphreader, trans->endnode(), pred, pred_idx,
+                                                 opp_pred_edge, true, offset_time);
     }
   }
 }
@@ -298,6 +309,8 @@ void Dijkstras::Expand(const ExpansionType expansion_type,
                        baldr::GraphReader& reader,
                        const sif::mode_costing_t& costings,
                        const sif::TravelMode mode) {
+  VALHALLA_TRACE_SPAN("Dijkstras::Expand");
+
   // compute the expansion
   switch (expansion_type) {
     case ExpansionType::forward:
@@ -338,9 +351,19 @@ void Dijkstras::Compute(google::protobuf::RepeatedPtrField<valhalla::Location>&
   // Get the time information for all the origin locations
   auto time_infos = SetTime(locations, graphreader);
 
+  // Relax the edges without virtual calls into the costing when its exact type is known
+  auto expand = CostKernel<AutoCost>::Matches(*costing_)
+                    ? &Dijkstras::ExpandInner<expansion_direction, CostKernel<AutoCost>>
+                    : &Dijkstras::ExpandInner<expansion_direction, CostKernel<DynamicCost>>;
+
   // Compute the isotile
+  size_t n = 0;
   auto cb_decision = ExpansionRecommendation::continue_expansion;
   while (cb_decision != ExpansionRecommendation::stop_expansion) {
+    if (interrupt_ && (++n % kInterruptIterationsInterval) == 0) {
+      (*interrupt_)();
+    }
+
     // Get next element from adjacency list. Check that it is valid. An
     // invalid label indicates there are no edges that can be expanded.
     uint32_t predindex = adjacencylist_.pop();
@@ -367,8 +390,8 @@ void Dijkstras::Compute(google::protobuf::RepeatedPtrField<valhalla::Location>&
     cb_decision = ShouldExpand(graphreader, pred, expansion_direction);
     if (cb_decision != ExpansionRecommendation::prune_expansion) {
       // Expand from the end node in forward direction.
-      ExpandInner<expansion_direction>(graphreader, pred.endnode(), pred, predindex, opp_pred_edge,
-                                       false, time_infos.front());
+      (this->*expand)(graphreader, pred.endnode(), pred, predindex, opp_pred_edge, false,
+                      time_infos.front());
     }
   }
 }
@@ -413,6 +436,9 @@ void Dijkstras::ExpandForwardMultiModal(GraphReader& graphreader,
     // Let implementing class we are expanding from here
     EdgeLabel* prev_pred =
         pred.predecessor() == kInvalidLabel ? nullptr : &mmedgelabels_[pred.predecessor()];
+    if (track_origins_) {
+      expanding_origin_ = label_origins_[pred_idx];
+    }
     ExpandingNode(graphreader, tile, nodeinfo, pred, prev_pred);
   }
 
@@ -655,6 +681,9 @@ void Dijkstras::ExpandForwardMultiModal(GraphReader& graphreader,
         mmadjacencylist_.decrease(es->index(), newsortcost);
         lab.Update(pred_idx, newcost, newsortcost, walking_distance, tripid, blockid, transition_cost,
                    restriction_idx);
+        if (track_origins_) {
+          label_origins_[es->index()] = label_origins_[pred_idx];
+        }
       }
       continue;
     }
@@ -664,12 +693,16 @@ void Dijkstras::ExpandForwardMultiModal(GraphReader& graphreader,
     *es = {EdgeSet::kTemporary, idx};
     mmedgelabels_.emplace_back(edge_label);
     mmadjacencylist_.add(idx);
+    if (track_origins_) {
+      label_origins_.push_back(label_origins_[pred_idx]);
+    }
   }
 
   // Handle transitions - expand from the end node of each transition
   if (!from_transition && nodeinfo->transition_count() > 0) {
     const NodeTransition* trans = tile->transition(nodeinfo->transition_index());
     for (uint32_t i = 0; i < nodeinfo->transition_count(); ++i, ++trans) {
+      up_transitions_ += trans->up();
       ExpandForwardMultiModal(graphreader, trans->endnode(), pred, pred_idx, true, pc, tc,
                               mode_costing, offset_time);
     }
@@ -721,8 +754,13 @@ void Dijkstras::ComputeMultiModal(
   processed_tiles_.clear();
 
   // Expand using adjacency list until we exceed threshold
+  size_t n = 0;
   auto cb_decision = ExpansionRecommendation::continue_expansion;
   while (cb_decision != ExpansionRecommendation::stop_expansion) {
+    if (interrupt_ && (++n % kInterruptIterationsInterval) == 0) {
+      (*interrupt_)();
+    }
+
     // Get next element from adjacency list. Check that it is valid. An
     // invalid label indicates there are no edges that can be expanded.
     const uint32_t predindex = adjacencylist_.pop();
@@ -754,8 +792,10 @@ void Dijkstras::SetOriginLocations(GraphReader& graphreader,
 
   // Add edges for each location to the adjacency list
   uint8_t path_id = -1;
+  uint32_t location_index = -1;
   for (auto& location : locations) {
     ++path_id;
+    ++location_index;
 
     // Only skip inbound edges if we have other options
     bool has_other_edges = false;
@@ -815,6 +855,9 @@ void Dijkstras::SetOriginLocations(GraphReader& graphreader,
                                  InternalTurn::kNoTurn, restriction_idx, multipath_ ? path_id : 0);
       // Set the origin flag
       bdedgelabels_.back().set_origin();
+      if (track_origins_) {
+        label_origins_.push_back(location_index);
+      }
 
       // Add EdgeLabel to the adjacency list
       adjacencylist_.add(idx);
@@ -834,8 +877,10 @@ void Dijkstras::SetDestinationLocations(
 
   // Add edges for each location to the adjacency list
   uint8_t path_id = -1;
+  uint32_t location_index = -1;
   for (auto& location : locations) {
     ++path_id;
+    ++location_index;
 
     // Only skip outbound edges if we have other options
     bool has_other_edges = false;
@@ -902,6 +947,9 @@ void Dijkstras::SetDestinationLocations(
                                  Cost{}, path_dist, false, !(costing_->IsClosed(directededge, tile)),
                                  static_cast<bool>(flow_sources & kDefaultFlowMask),
                                  InternalTurn::kNoTurn, restriction_idx, multipath_ ? path_id : 0);
+      if (track_origins_) {
+        label_origins_.push_back(location_index);
+      }
       adjacencylist_.add(idx);
       edgestatus_.Set(opp_edge_id, EdgeSet::kTemporary, idx, opp_tile, multipath_ ? path_id : 0);
     }
@@ -914,7 +962,9 @@ void Dijkstras::SetOriginLocationsMultiModal(
     google::protobuf::RepeatedPtrField<valhalla::Location>& origin_locations,
     const std::shared_ptr<DynamicCost>& costing) {
   // Add edges for each location to the adjacency list
+  uint32_t location_index = -1;
   for (auto& origin : origin_locations) {
+    ++location_index;
     // Only skip inbound edges if we have other options
     bool has_other_edges = false;
     std::for_each(origin.path_edges().begin(), origin.path_edges().end(),
@@ -976,6 +1026,9 @@ void Dijkstras::SetOriginLocationsMultiModal(
       // Add EdgeLabel to the adjacency list
       mmedgelabels_.push_back(edge_label);
       mmadjacencylist_.add(idx);
+      if (track_origins_) {
+        label_origins_.push_back(location_index);
+      }
     }
   }
 }
@@ -62,15 +62,31 @@ constexpr uint32_t kInitialEdgeLabelCount = 500000;
 
 // Default constructor
 Isochrone::Isochrone(const boost::property_tree::ptree& config)
-    : Dijkstras(config), shape_interval_(50.0f) {
+    : Dijkstras(config), shape_interval_(50.0f), origin_metric_(0),
+      cache_size_(config.get<size_t>("isochrone_cache_size", 0)) {
 }
 
-// Construct the isotile. Use a fixed grid size. Convert time in minutes to
-// a max distance in meters based on an estimate of max average speed for
-// the travel mode.
-void Isochrone::ConstructIsoTile(const bool multimodal,
-                                 const valhalla::Api& api,
-                                 const sif::TravelMode mode) {
+std::string Isochrone::CacheKey(const ExpansionType& expansion_type, const valhalla::Api& api) {
+  Options options = api.options();
+  options.clear_contours();
+  options.clear_polygons();
+  options.clear_denoise();
+  options.clear_generalize();
+  options.clear_show_locations();
+  options.clear_format();
+  options.clear_id();
+  options.clear_jsonp();
+  options.clear_units();
+  options.clear_language();
+  options.clear_do_not_track();
+  return std::to_string(static_cast<int>(expansion_type)) + options.SerializeAsString();
+}
+
+// Set the limits of the expansion and the resolution of the isotile. Convert time in minutes to
+// a max distance in meters based on an estimate of max average speed for the travel mode.
+void Isochrone::SetLimits(const bool multimodal,
+                          const valhalla::Api& api,
+                          const sif::TravelMode mode) {
 
   // Extend the times in the 2-D grid to be 10 minutes beyond the highest contour time.
   // Cost (including penalties) is used when adding to the adjacency list but the elapsed
@@ -93,6 +109,7 @@ void Isochrone::ConstructIsoTile(const bool multimodal,
   bool has_distance = max_dist_itr->has_distance();
   auto max_km = has_distance ? max_dist_itr->distance() + 10.0f : std::numeric_limits<float>::min();
 
+  max_values_ = {max_minutes, max_km};
   max_seconds_ = has_time ? max_minutes * kSecPerMinute : max_minutes;
   max_meters_ = has_distance ? max_km * kMetersPerKm : max_km;
   float max_distance;
@@ -107,8 +124,32 @@ void Isochrone::ConstructIsoTile(const bool multimodal,
     max_distance = max_seconds_ * 70.0f * kMPHtoMetersPerSec;
   }
   // Either the user-specified or estimated max distance
-  max_distance = std::max(max_distance, max_meters_);
+  max_distance_ = std::max(max_distance, max_meters_);
+
+  // Range of grid in latitude space
+  float dlat = max_distance_ / kMetersPerDegreeLat;
+
+  // Optimize for 600 cells in latitude (slightly larger for multimodal).
+  // Round off to nearest 0.001 degree. TODO - revisit min and max grid sizes
+  float grid_size = multimodal ? dlat / 500.0f : dlat / 300.0f;
+  if (grid_size < 0.001f) {
+    grid_size = 0.001f;
+  } else if (grid_size > 0.005f) {
+    grid_size = 0.005f;
+  } else {
+    // Round to nearest 0.001
+    int r = std::round(grid_size * 1000.0f);
+    grid_size = static_cast<float>(r) * 0.001f;
+  }
+
+  // Set the shape interval in meters
+  grid_size_ = grid_size;
+  shape_interval_ = grid_size * kMetersPerDegreeLat * 0.25f;
+}
 
+// Construct the isotile with the resolution and the extent SetLimits worked out, centered on the
+// location closest to the center of all of them.
+void Isochrone::ConstructIsoTile(const valhalla::Api& api) {
   // Form bounding box that's just big enough to surround all of the locations.
   // Convert to PointLL
   PointLL center_ll(api.options().locations(0).ll().lng(), api.options().locations(0).ll().lat());
@@ -131,32 +172,16 @@ void Isochrone::ConstructIsoTile(const bool multimodal,
   }
 
   // Range of grids in latitude space
-  float dlat = max_distance / kMetersPerDegreeLat;
+  float dlat = max_distance_ / kMetersPerDegreeLat;
   // Range of grids in longitude space
-  float dlon = max_distance / DistanceApproximator<PointLL>::MetersPerLngDegree(center_ll.lat());
-
-  // Optimize for 600 cells in latitude (slightly larger for multimodal).
-  // Round off to nearest 0.001 degree. TODO - revisit min and max grid sizes
-  float grid_size = multimodal ? dlat / 500.0f : dlat / 300.0f;
-  if (grid_size < 0.001f) {
-    grid_size = 0.001f;
-  } else if (grid_size > 0.005f) {
-    grid_size = 0.005f;
-  } else {
-    // Round to nearest 0.001
-    int r = std::round(grid_size * 1000.0f);
-    grid_size = static_cast<float>(r) * 0.001f;
-  }
-
-  // Set the shape interval in meters
-  shape_interval_ = grid_size * kMetersPerDegreeLat * 0.25f;
+  float dlon = max_distance_ / DistanceApproximator<PointLL>::MetersPerLngDegree(center_ll.lat());
 
   // Create expanded bounds from the bounded box around the locations.
   AABB2<PointLL> bounds(loc_bounds.minx() - dlon, loc_bounds.miny() - dlat, loc_bounds.maxx() + dlon,
                         loc_bounds.maxy() + dlat);
 
   // Create isotile (gridded data)
-  isotile_.reset(new GriddedData<2>(bounds, grid_size, {max_minutes, max_km}));
+  isotile_.reset(new GriddedData<2>(bounds, grid_size_, max_values_));
 
   // Find the center of the grid that the location lies within. Shift the
   // tilebounds so the location lies in the center of a tile.
@@ -173,10 +198,22 @@ void Isochrone::ConstructIsoTile(const bool multimodal,
              std::to_string(center_ll.lng() - grid_center.lng()));
   }
 
+  // without a contour in a metric its limit is the least float, the metric isnt expanded in
+  // with the partition each cell goes to the location reaching it first in the metric it has
+  const bool has_time = max_seconds_ != std::numeric_limits<float>::min();
+  const bool has_distance = max_meters_ != std::numeric_limits<float>::min();
+  track_origins_ = api.options().partition() && api.options().locations_size() > 1;
+  origin_metric_ = has_time ? 0 : 1;
+  cell_origins_ = track_origins_ ? std::make_shared<std::vector<uint32_t>>(
+                                       isotile_->TileCount(), std::numeric_limits<uint32_t>::max())
+                                 : nullptr;
+
   // initialize the time at these locations
-  for (const auto& location : api.options().locations()) {
+  for (int i = 0; i < api.options().locations_size(); ++i) {
+    const auto& location = api.options().locations(i);
     auto tile_id = isotile_->TileId({location.ll().lng(), location.ll().lat()});
-    isotile_->SetIfLessThan(tile_id, {has_time ? 0.0f : max_minutes, has_distance ? 0.0f : max_km});
+    expanding_origin_ = i;
+    SetIfLessThan(tile_id, {has_time ? 0.0f : max_values_[0], has_distance ? 0.0f : max_values_[1]});
   }
 }
 
@@ -186,13 +223,64 @@ std::shared_ptr<const GriddedData<2>> Isochrone::Expand(const ExpansionType& exp
                                                         GraphReader& reader,
                                                         const sif::mode_costing_t& mode_costing,
                                                         const TravelMode mode) {
-  // Initialize and create the isotile
-  ConstructIsoTile(expansion_type == ExpansionType::multimodal, api, mode);
-  // Compute the expansion
+  // Work out how far to expand and the resolution of the isotile
+  SetLimits(expansion_type == ExpansionType::multimodal, api, mode);
+  if (cache_size_ == 0) {
+    // Create the isotile and compute the expansion
+    ConstructIsoTile(api);
+    Dijkstras::Expand(expansion_type, api, reader, mode_costing, mode);
+    return isotile_;
+  }
+
+  // A grid of the same resolution whose expansion went at least as far has everything the
+  // contours of this request need, then there is no grid to make
+  auto key = CacheKey(expansion_type, api);
+  for (auto cached = cache_.begin(); cached != cache_.end(); ++cached) {
+    if (cached->key == key && cached->grid_size == grid_size_ &&
+        cached->max_seconds >= max_seconds_ && cached->max_meters >= max_meters_) {
+      cache_.splice(cache_.begin(), cache_, cached);
+      isotile_.reset();
+      cell_origins_ = cache_.front().cell_origins;
+      return cache_.front().isotile;
+    }
+  }
+
+  // Create the isotile and compute the expansion, it replaces any grid it covers
+  ConstructIsoTile(api);
   Dijkstras::Expand(expansion_type, api, reader, mode_costing, mode);
+  cache_.remove_if([this, &key](const cached_isotile_t& cached) {
+    return cached.key == key && cached.grid_size == grid_size_ &&
+           cached.max_seconds <= max_seconds_ && cached.max_meters <= max_meters_;
+  });
+  cache_.push_front(
+      {std::move(key), grid_size_, max_seconds_, max_meters_, isotile_, cell_origins_});
+  if (cache_.size() > cache_size_) {
+    cache_.pop_back();
+  }
   return isotile_;
 }
 
+GriddedData<2> Isochrone::Partition(const GriddedData<2>& grid,
+                                    const uint32_t location_index) const {
+  GriddedData<2> part(grid);
+  if (cell_origins_) {
+    for (size_t tile_id = 0; tile_id < cell_origins_->size(); ++tile_id) {
+      if ((*cell_origins_)[tile_id] != location_index) {
+        part.Unset(tile_id);
+      }
+    }
+  }
+  return part;
+}
+
+void Isochrone::SetIfLessThan(const int tile_id, const GriddedData<2>::value_type& value) {
+  if (cell_origins_ && tile_id >= 0 && tile_id < static_cast<int>(cell_origins_->size()) &&
+      value[origin_metric_] < isotile_->Value(tile_id)[origin_metric_]) {
+    (*cell_origins_)[tile_id] = expanding_origin_;
+  }
+  isotile_->SetIfLessThan(tile_id, value);
+}
+
 void Isochrone::UpdateIsoTileAlongSegment(const midgard::PointLL& from,
                                           const midgard::PointLL& to,
                                           float seconds,
@@ -204,17 +292,17 @@ void Isochrone::UpdateIsoTileAlongSegment(const midgard::PointLL& from,
   auto tile1 = isotile_->TileId(from);
   auto tile2 = isotile_->TileId(to);
   if (tile1 == tile2) {
-    isotile_->SetIfLessThan(tile1, {minutes, km});
+    SetIfLessThan(tile1, {minutes, km});
   } else if (isotile_->AreNeighbors(tile1, tile2)) {
     // If tile 2 is directly east, west, north, or south of tile 1 then the
     // segment will not intersect any other tiles other than tile1 and tile2.
-    isotile_->SetIfLessThan(tile1, {minutes, km});
-    isotile_->SetIfLessThan(tile2, {minutes, km});
+    SetIfLessThan(tile1, {minutes, km});
+    SetIfLessThan(tile2, {minutes, km});
   } else {
     // Find intersecting tiles (using a Bresenham method)
     auto tiles = isotile_->Intersect(std::list<PointLL>{from, to});
     for (const auto& t : tiles) {
-      isotile_->SetIfLessThan(t.first, {minutes, km});
+      SetIfLessThan(t.first, {minutes, km});
     }
   }
 }
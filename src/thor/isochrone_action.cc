@@ -2,6 +2,8 @@
 #include "thor/worker.h"
 #include "tyr/serializers.h"
 
+#include <iterator>
+
 using namespace valhalla::baldr;
 using namespace valhalla::midgard;
 
@@ -36,16 +38,34 @@ std::string thor_worker_t::isochrones(Api& request) {
   auto expansion_type = costing == "multimodal" || costing == "transit" ? ExpansionType::multimodal
                                                                         : ExpansionType::forward;
   auto grid = isochrone_gen.Expand(expansion_type, request, *reader, mode_costing, mode);
+  isochrone_gen.Stats().AddTo("thor_worker_t::isochrones_", request);
 
   // we have parallel vectors of contour properties and the actual geojson features
   // this method sorts the contour specifications by metric (time or distance) and then by value
   // with the largest values coming first. eg (60min, 30min, 10min, 40km, 10km)
-  auto isolines =
-      grid->GenerateContours(contours, options.polygons(), options.denoise(), options.generalize());
+  GriddedData<2>::contours_t isolines;
+  std::vector<uint32_t> location_indices;
+  if (!options.partition() || options.locations_size() < 2) {
+    isolines = grid->GenerateContours(contours, options.polygons(), options.denoise(),
+                                      options.generalize(), isochrone_threads);
+  } else {
+    // with the partition every location gets the contours of the part of the grid it got to
+    // first, they all come from the one expansion and only the contours are traced per location
+    auto intervals = contours;
+    contours.clear();
+    for (int i = 0; i < options.locations_size(); ++i) {
+      auto part = isochrone_gen.Partition(*grid, i);
+      auto part_isolines = part.GenerateContours(intervals, options.polygons(), options.denoise(),
+                                                 options.generalize(), isochrone_threads);
+      std::move(part_isolines.begin(), part_isolines.end(), std::back_inserter(isolines));
+      contours.insert(contours.end(), intervals.begin(), intervals.end());
+      location_indices.insert(location_indices.end(), intervals.size(), i);
+    }
+  }
 
   // make the final json
   std::string ret = tyr::serializeIsochrones(request, contours, isolines, options.polygons(),
-                                             options.show_locations());
+                                             options.show_locations(), location_indices);
 
   return ret;
 }
@@ -23,8 +23,7 @@ struct interpolation_t {
 valhalla::baldr::TimeInfo
 init_time_info(const std::vector<valhalla::meili::EdgeSegment>& edge_segments,
                valhalla::meili::MapMatcher* matcher,
-               valhalla::Options& options,
-               valhalla::baldr::DateTime::tz_sys_info_cache_t* tz_cache) {
+               valhalla::Options& options) {
   graph_tile_ptr tile = nullptr;
   const DirectedEdge* directededge = nullptr;
   const NodeInfo* nodeinfo = nullptr;
@@ -47,7 +46,7 @@ init_time_info(const std::vector<valhalla::meili::EdgeSegment>& edge_segments,
             DateTime::seconds_to_date(options.shape(0).time(), tz, false));
       }
       return valhalla::baldr::TimeInfo::make(*options.mutable_shape(0), matcher->graphreader(),
-                                             tz_cache, nodeinfo->timezone());
+                                             nullptr, nodeinfo->timezone());
     }
   }
   return valhalla::baldr::TimeInfo::invalid();
@@ -174,8 +173,7 @@ MapMatcher::FormPath(meili::MapMatcher* matcher,
 
   // We support either the epoch timestamp that came with the trace point or
   // a local date time which we convert to epoch by finding the first timezone
-  valhalla::baldr::DateTime::tz_sys_info_cache_t tz_cache;
-  auto time_info = init_time_info(edge_segments, matcher, options, &tz_cache);
+  auto time_info = init_time_info(edge_segments, matcher, options);
 
   // Interpolate match results if using timestamps for elapsed time
   std::vector<std::vector<interpolation_t>> interpolations;
@@ -2,6 +2,7 @@
 #include "sif/bicyclecost.h"
 #include "sif/pedestriancost.h"
 #include "thor/costmatrix.h"
+#include "thor/matrix_selector.h"
 #include "thor/timedistancebssmatrix.h"
 #include "thor/timedistancematrix.h"
 #include "thor/worker.h"
@@ -17,20 +18,28 @@ using namespace valhalla::thor;
 namespace {
 
 constexpr double kMilePerMeter = 0.000621371;
+
+// Keep the estimate next to the timing of the matrix so the cost model can be calibrated
+void add_estimate(Api& request, const MatrixEstimate& estimate) {
+  auto* stat = request.mutable_info()->mutable_statistics()->Add();
+  stat->set_name("thor_worker_t::matrix_estimate_" + to_string(estimate.algorithm));
+  stat->set_value(estimate.cost);
 }
+} // namespace
 
 namespace valhalla {
 namespace thor {
 
-constexpr uint32_t kCostMatrixThreshold = 5;
-
-std::string thor_worker_t::matrix(Api& request) {
+std::string thor_worker_t::matrix(Api& request,
+                                  const std::function<void(const std::string&)>* write) {
   // time this whole method and save that statistic
   auto _ = measure_scope_time(request, "thor_worker_t::matrix");
 
   parse_locations(request);
   auto costing = parse_costing(request);
   const auto& options = request.options();
+  // a cached matrix is only good for as long as the tiles of its locations stay the same
+  response_cache_t::tag(request, *reader);
 
   // Parse out units; if none specified, use kilometers
   double distance_scale = kKmPerMeter;
@@ -38,56 +47,99 @@ std::string thor_worker_t::matrix(Api& request) {
     distance_scale = kMilePerMeter;
   }
 
-  json::MapPtr json;
+  // The osrm format has separate arrays for the durations and distances and pbf is one message so
+  // only the valhalla format can be written out a row at a time
+  row_callback_t on_row;
+  if (write && options.format() != Options::osrm && options.format() != Options::pbf) {
+    on_row = [&request, write, distance_scale](uint32_t source, const TimeDistance* row) {
+      (*write)(tyr::serializeMatrixRow(request, row, source, distance_scale));
+    };
+  }
+  auto serialize = [&](const std::vector<TimeDistance>& time_distances,
+                       const MatrixEstimate& estimate) -> std::string {
+    if (!write) {
+      return tyr::serializeMatrix(request, time_distances, distance_scale, estimate);
+    } else if (!on_row) {
+      (*write)(tyr::serializeMatrix(request, time_distances, distance_scale, estimate));
+      return "";
+    }
+    // the algorithms which only know the rows once they are all done still save building the
+    // json of the whole matrix
+    for (int i = 0; !time_distances.empty() && i < options.sources_size(); ++i) {
+      on_row(i, time_distances.data() + i * options.targets_size());
+    }
+    (*write)(tyr::serializeMatrixTail(request, estimate));
+    return "";
+  };
+
   // do the real work
   std::vector<TimeDistance> time_distances;
+  const float max_distance = max_matrix_distance.find(costing)->second;
   auto costmatrix = [&]() {
-    thor::CostMatrix matrix;
-    return matrix.SourceToTarget(options.sources(), options.targets(), *reader, mode_costing, mode,
-                                 max_matrix_distance.find(costing)->second);
+    auto time_distances = cost_matrix.SourceToTarget(options.sources(), options.targets(), *reader,
+                                                     mode_costing, mode, max_distance);
+    cost_matrix.Stats().AddTo("thor_worker_t::matrix_", request);
+    return time_distances;
+  };
+  auto bucketmatrix = [&]() {
+    return bucket_matrix.SourceToTarget(options.sources(), options.targets(), *reader, mode_costing,
+                                        mode, max_distance);
   };
   auto timedistancematrix = [&]() {
-    thor::TimeDistanceMatrix matrix;
-    return matrix.SourceToTarget(options.sources(), options.targets(), *reader, mode_costing, mode,
-                                 max_matrix_distance.find(costing)->second);
+    return time_distance_matrix.SourceToTarget(options.sources(), options.targets(), *reader,
+                                               mode_costing, mode, max_distance, on_row);
   };
   if (costing == "bikeshare") {
-    thor::TimeDistanceBSSMatrix matrix;
+    const MatrixEstimate estimate{MatrixAlgorithm::kTimeDistanceBSSMatrix,
+                                  matrix_selector.Estimate(MatrixAlgorithm::kTimeDistanceBSSMatrix,
+                                                           options.sources(), options.targets(),
+                                                           mode, max_distance)};
+    add_estimate(request, estimate);
     time_distances =
-        matrix.SourceToTarget(options.sources(), options.targets(), *reader, mode_costing, mode,
-                              max_matrix_distance.find(costing)->second);
-    return tyr::serializeMatrix(request, time_distances, distance_scale);
+        time_distance_bss_matrix.SourceToTarget(options.sources(), options.targets(), *reader,
+                                                mode_costing, mode, max_distance);
+    if (on_row) {
+      (*write)(tyr::serializeMatrixHead(request));
+    }
+    return serialize(time_distances, estimate);
   }
+
+  // Unless the configuration forces an algorithm pick the one expected to be the fastest
+  MatrixEstimate estimate{MatrixAlgorithm::kCostMatrix, 0.f};
   switch (source_to_target_algorithm) {
     case SELECT_OPTIMAL:
-      // TODO - Do further performance testing to pick the best algorithm for the job
-      switch (mode) {
-        case TravelMode::kPedestrian:
-        case TravelMode::kBicycle:
-          // Use CostMatrix if number of sources and number of targets
-          // exceeds some threshold
-          if (options.sources().size() > kCostMatrixThreshold &&
-              options.targets().size() > kCostMatrixThreshold) {
-            time_distances = costmatrix();
-          } else {
-            time_distances = timedistancematrix();
-          }
-          break;
-        case TravelMode::kPublicTransit:
-          time_distances = timedistancematrix();
-          break;
-        default:
-          time_distances = costmatrix();
-      }
+      estimate = matrix_selector.Select(options.sources(), options.targets(), mode, max_distance);
       break;
     case COST_MATRIX:
-      time_distances = costmatrix();
+      estimate.algorithm = MatrixAlgorithm::kCostMatrix;
       break;
     case TIME_DISTANCE_MATRIX:
+      estimate.algorithm = MatrixAlgorithm::kTimeDistanceMatrix;
+      break;
+    case BUCKET_MATRIX:
+      estimate.algorithm = MatrixAlgorithm::kBucketMatrix;
+      break;
+  }
+  if (source_to_target_algorithm != SELECT_OPTIMAL) {
+    estimate.cost = matrix_selector.Estimate(estimate.algorithm, options.sources(),
+                                             options.targets(), mode, max_distance);
+  }
+  add_estimate(request, estimate);
+
+  if (on_row) {
+    (*write)(tyr::serializeMatrixHead(request));
+  }
+  switch (estimate.algorithm) {
+    case MatrixAlgorithm::kTimeDistanceMatrix:
       time_distances = timedistancematrix();
       break;
+    case MatrixAlgorithm::kBucketMatrix:
+      time_distances = bucketmatrix();
+      break;
+    default:
+      time_distances = costmatrix();
   }
-  return tyr::serializeMatrix(request, time_distances, distance_scale);
+  return serialize(time_distances, estimate);
 }
 } // namespace thor
 } // namespace valhalla
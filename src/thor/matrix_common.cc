@@ -0,0 +1,104 @@
+#include "thor/matrix_common.h"
+
+using namespace valhalla::baldr;
+
+namespace {
+
+// A step of every search is only a few microseconds of work so the threads spin for a while
+// waiting on the next step before they go to sleep
+constexpr uint32_t kWorkerSpinCount = 20000;
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+MatrixWorkers::MatrixWorkers(const uint32_t thread_count,
+                             const boost::property_tree::ptree& reader_config) {
+  for (uint32_t i = 0; i < thread_count; ++i) {
+    readers_.emplace_back(new GraphReader(reader_config));
+  }
+  for (uint32_t i = 0; i < thread_count; ++i) {
+    threads_.emplace_back([this, i]() { Work(i + 1, *readers_[i]); });
+  }
+}
+
+MatrixWorkers::~MatrixWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    ++generation_;
+  }
+  wake_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void MatrixWorkers::Run(const uint32_t count, GraphReader& graphreader, const step_t& step) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    step_ = &step;
+    count_ = count;
+    next_.store(0, std::memory_order_relaxed);
+    busy_.store(threads_.size(), std::memory_order_relaxed);
+    generation_.fetch_add(1, std::memory_order_release);
+  }
+  wake_.notify_all();
+
+  Take(0, graphreader);
+  while (busy_.load(std::memory_order_acquire) > 0) {
+    std::this_thread::yield();
+  }
+  step_ = nullptr;
+  if (error_) {
+    auto error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void MatrixWorkers::Trim() {
+  for (auto& reader : readers_) {
+    if (reader->OverCommitted()) {
+      reader->Trim();
+    }
+  }
+}
+
+void MatrixWorkers::Take(const uint32_t slot, GraphReader& graphreader) {
+  for (auto i = next_.fetch_add(1); i < count_; i = next_.fetch_add(1)) {
+    try {
+      (*step_)(i, slot, graphreader);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!error_) {
+        error_ = std::current_exception();
+      }
+    }
+  }
+}
+
+void MatrixWorkers::Work(const uint32_t slot, GraphReader& graphreader) {
+  uint64_t seen = 0;
+  while (true) {
+    // spin a bit for the next step before waiting on it
+    uint32_t spins = 0;
+    while (generation_.load(std::memory_order_acquire) == seen && spins++ < kWorkerSpinCount) {
+      std::this_thread::yield();
+    }
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [this, seen]() { return generation_.load() != seen; });
+      seen = generation_.load();
+      if (stop_) {
+        return;
+      }
+    }
+    Take(slot, graphreader);
+    busy_.fetch_sub(1, std::memory_order_release);
+  }
+}
+
+} // namespace thor
+} // namespace valhalla
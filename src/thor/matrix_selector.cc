@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <limits>
+
+#include "midgard/constants.h"
+#include "midgard/pointll.h"
+#include "thor/matrix_selector.h"
+
+using namespace valhalla::midgard;
+using namespace valhalla::sif;
+
+namespace {
+
+using valhalla::thor::MatrixAlgorithm;
+
+// Even locations on top of each other need their searches to get off of their edges
+constexpr float kMinReach = 500.0f; // meters
+
+// How many more edges than a drive search a search of each mode settles for the same area
+float mode_density(const TravelMode mode) {
+  switch (mode) {
+    case TravelMode::kPedestrian:
+      return 1.5f;
+    case TravelMode::kBicycle:
+      return 1.25f;
+    case TravelMode::kPublicTransit:
+      return 2.0f;
+    default:
+      return 1.0f;
+  }
+}
+
+// Distance across the bounding box of all of the locations
+float spread(const google::protobuf::RepeatedPtrField<valhalla::Location>& sources,
+             const google::protobuf::RepeatedPtrField<valhalla::Location>& targets) {
+  double minx = 180, miny = 90, maxx = -180, maxy = -90;
+  for (const auto* list : {&sources, &targets}) {
+    for (const auto& location : *list) {
+      minx = std::min(minx, location.ll().lng());
+      miny = std::min(miny, location.ll().lat());
+      maxx = std::max(maxx, location.ll().lng());
+      maxy = std::max(maxy, location.ll().lat());
+    }
+  }
+  return minx > maxx ? 0.0f : PointLL(minx, miny).Distance(PointLL(maxx, maxy));
+}
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+const std::string& to_string(const MatrixAlgorithm algorithm) {
+  static const std::unordered_map<uint8_t, std::string> names = {
+      {static_cast<uint8_t>(MatrixAlgorithm::kCostMatrix), "costmatrix"},
+      {static_cast<uint8_t>(MatrixAlgorithm::kTimeDistanceMatrix), "timedistancematrix"},
+      {static_cast<uint8_t>(MatrixAlgorithm::kBucketMatrix), "bucketmatrix"},
+      {static_cast<uint8_t>(MatrixAlgorithm::kTimeDistanceBSSMatrix), "timedistancebssmatrix"},
+  };
+  return names.find(static_cast<uint8_t>(algorithm))->second;
+}
+
+MatrixSelector::MatrixSelector(const boost::property_tree::ptree& config) {
+  const auto model = config.get_child("matrix_cost_model", {});
+  hierarchy_radius_ = model.get<float>("hierarchy_radius", 20000.0f);
+
+  auto read = [&model, this](const MatrixAlgorithm algorithm, const Coefficients& defaults) {
+    const auto coefficients = model.get_child_optional(to_string(algorithm));
+    Coefficients c = defaults;
+    if (coefficients) {
+      c = {coefficients->get<float>("search", defaults.search),
+           coefficients->get<float>("expansion", defaults.expansion),
+           coefficients->get<float>("pair", defaults.pair)};
+    }
+    coefficients_[static_cast<uint8_t>(algorithm)] = c;
+    return static_cast<bool>(coefficients);
+  };
+  read(MatrixAlgorithm::kTimeDistanceMatrix, {1.0f, 0.5f, 0.002f});
+  read(MatrixAlgorithm::kCostMatrix, {4.0f, 0.6f, 0.02f});
+  candidates_ = {MatrixAlgorithm::kTimeDistanceMatrix, MatrixAlgorithm::kCostMatrix};
+
+  // The experimental algorithms search like the ones they are built on
+  const auto costmatrix = coefficients_[static_cast<uint8_t>(MatrixAlgorithm::kCostMatrix)];
+  if (read(MatrixAlgorithm::kBucketMatrix, costmatrix)) {
+    candidates_.push_back(MatrixAlgorithm::kBucketMatrix);
+  }
+  const auto timedistance =
+      coefficients_[static_cast<uint8_t>(MatrixAlgorithm::kTimeDistanceMatrix)];
+  read(MatrixAlgorithm::kTimeDistanceBSSMatrix, timedistance);
+}
+
+float MatrixSelector::Estimate(const MatrixAlgorithm algorithm,
+                               const google::protobuf::RepeatedPtrField<valhalla::Location>& sources,
+                               const google::protobuf::RepeatedPtrField<valhalla::Location>& targets,
+                               const TravelMode mode,
+                               const float max_matrix_distance) const {
+  const auto& c = coefficients_.find(static_cast<uint8_t>(algorithm))->second;
+  const float reach = std::max(std::min(spread(sources, targets), max_matrix_distance), kMinReach);
+  const float pairs = static_cast<float>(sources.size()) * targets.size();
+
+  // One search per location of the smaller side which has to reach all of the other side
+  const bool unidirectional = algorithm == MatrixAlgorithm::kTimeDistanceMatrix ||
+                              algorithm == MatrixAlgorithm::kTimeDistanceBSSMatrix;
+  if (unidirectional) {
+    const float radius = reach * kKmPerMeter;
+    const float area = kPi * radius * radius * mode_density(mode);
+    const float searches = std::min(sources.size(), targets.size());
+    return searches * (c.search + c.expansion * area) + c.pair * pairs;
+  }
+
+  // One search per location which meets the others half way, past the hierarchy radius the
+  // drive searches only grow along the highways
+  const float radius = reach * 0.5f;
+  float area = kPi * radius * radius;
+  if (mode == TravelMode::kDrive && radius > hierarchy_radius_) {
+    area = kPi * hierarchy_radius_ * hierarchy_radius_ +
+           2.0f * kPi * hierarchy_radius_ * (radius - hierarchy_radius_);
+  }
+  area *= kKmPerMeter * kKmPerMeter * mode_density(mode);
+  const float searches = sources.size() + targets.size();
+  return searches * (c.search + c.expansion * area) + c.pair * pairs;
+}
+
+MatrixEstimate
+MatrixSelector::Select(const google::protobuf::RepeatedPtrField<valhalla::Location>& sources,
+                       const google::protobuf::RepeatedPtrField<valhalla::Location>& targets,
+                       const TravelMode mode,
+                       const float max_matrix_distance) const {
+  if (mode == TravelMode::kPublicTransit) {
+    return {MatrixAlgorithm::kTimeDistanceMatrix,
+            Estimate(MatrixAlgorithm::kTimeDistanceMatrix, sources, targets, mode,
+                     max_matrix_distance)};
+  }
+
+  MatrixEstimate best{candidates_.front(), std::numeric_limits<float>::max()};
+  for (const auto algorithm : candidates_) {
+    const float cost = Estimate(algorithm, sources, targets, mode, max_matrix_distance);
+    if (cost < best.cost) {
+      best = {algorithm, cost};
+    }
+  }
+  return best;
+}
+
+} // namespace thor
+} // namespace valhalla
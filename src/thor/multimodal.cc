@@ -90,6 +90,9 @@ void MultiModalPathAlgorithm::Clear() {
   // Clear the edge status flags
   edgestatus_.clear();
 
+  // Clear the departures of the lines
+  timetable_.Clear();
+
   // Set the ferry flag to false
   has_ferry_ = false;
 }
@@ -148,7 +151,7 @@ MultiModalPathAlgorithm::GetBestPath(valhalla::Location& origin,
   }
 
   // Get time information for forward search
-  auto forward_time_info = TimeInfo::make(origin, graphreader, &tz_cache_);
+  auto forward_time_info = TimeInfo::make(origin, graphreader);
 
   // Initialize the origin and destination locations. Initialize the
   // destination first in case the origin edge includes a destination edge.
@@ -165,6 +168,7 @@ MultiModalPathAlgorithm::GetBestPath(valhalla::Location& origin,
   // Clear operators and processed tiles
   operators_.clear();
   processed_tiles_.clear();
+  timetable_.Clear();
 
   // Find shortest path
   uint32_t nc = 0; // Count of iterations with no convergence
@@ -302,6 +306,7 @@ bool MultiModalPathAlgorithm::ExpandForward(GraphReader& graphreader,
         day_ = date_ - date_created;
       }
       date_set_ = true;
+      timetable_.Reset(day_, dow_, date_before_tile_, tc->wheelchair(), tc->bicycle());
     }
   }
 
@@ -364,8 +369,7 @@ bool MultiModalPathAlgorithm::ExpandForward(GraphReader& graphreader,
 
       // Look up the next departure along this edge
       const TransitDeparture* departure =
-          tile->GetNextDeparture(directededge->lineid(), offset_time.local_time, day_, dow_,
-                                 date_before_tile_, tc->wheelchair(), tc->bicycle());
+          timetable_.GetNextDeparture(tile, directededge->lineid(), offset_time.local_time);
 
       if (departure) {
         // Check if there has been a mode change
@@ -389,9 +393,8 @@ bool MultiModalPathAlgorithm::ExpandForward(GraphReader& graphreader,
             // departure.
             // TODO - is there a better way?
             if (offset_time.local_time + 30 > departure->departure_time()) {
-              departure =
-                  tile->GetNextDeparture(directededge->lineid(), offset_time.local_time + 30, day_,
-                                         dow_, date_before_tile_, tc->wheelchair(), tc->bicycle());
+              departure = timetable_.GetNextDeparture(tile, directededge->lineid(),
+                                                      offset_time.local_time + 30);
               if (!departure) {
                 continue;
               }
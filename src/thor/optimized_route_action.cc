@@ -14,9 +14,88 @@ using namespace valhalla::baldr;
 using namespace valhalla::sif;
 using namespace valhalla::thor;
 
+namespace {
+
+// Whether the paths of the matrix are the ones a route between the locations would take, which is
+// only so for time independent routes that dont have to continue through a location on the edge
+// they arrived on
+bool reuse_matrix_legs(const valhalla::Options& options) {
+  for (const auto& location : options.locations()) {
+    if ((location.has_date_time() && options.date_time_type() != valhalla::Options::invariant) ||
+        location.type() == valhalla::Location::kThrough ||
+        location.type() == valhalla::Location::kBreakThrough) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
 namespace valhalla {
 namespace thor {
 
+std::vector<TimeDistance> thor_worker_t::cached_matrix(
+    const Options& options,
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+    CostMatrix& costmatrix,
+    const float max_distance) {
+  // Look up every pair, a location with any pair which isnt cached gets its row and column computed
+  const uint32_t count = locations.size();
+  const auto context = optimizer_matrix_cache.context(options);
+  std::vector<std::string> keys;
+  keys.reserve(count);
+  for (const auto& location : locations) {
+    keys.push_back(MatrixCache::location(location));
+  }
+  std::vector<TimeDistance> td(count * count);
+  std::vector<bool> missing(count, false);
+  for (uint32_t i = 0; i < count; ++i) {
+    for (uint32_t j = 0; j < count; ++j) {
+      if (!optimizer_matrix_cache.find(context, keys[i], keys[j], td[i * count + j])) {
+        missing[i] = missing[j] = true;
+      }
+    }
+  }
+
+  // Split the locations into the ones to compute and the ones that are cached
+  google::protobuf::RepeatedPtrField<valhalla::Location> added, kept;
+  std::vector<uint32_t> added_index, kept_index;
+  for (uint32_t i = 0; i < count; ++i) {
+    (missing[i] ? added : kept).Add()->CopyFrom(locations.Get(i));
+    (missing[i] ? added_index : kept_index).push_back(i);
+  }
+  if (added.empty()) {
+    return td;
+  }
+
+  // The rows of the new locations to all of them and the columns of the rest to the new ones
+  auto rows =
+      costmatrix.SourceToTarget(added, locations, *reader, mode_costing, mode, max_distance);
+  for (uint32_t a = 0; a < added_index.size(); ++a) {
+    std::copy_n(rows.begin() + a * count, count, td.begin() + added_index[a] * count);
+  }
+  if (!kept.empty()) {
+    auto columns =
+        costmatrix.SourceToTarget(kept, added, *reader, mode_costing, mode, max_distance);
+    for (uint32_t k = 0; k < kept_index.size(); ++k) {
+      for (uint32_t a = 0; a < added_index.size(); ++a) {
+        td[kept_index[k] * count + added_index[a]] = columns[k * added_index.size() + a];
+      }
+    }
+  }
+
+  // Remember the pairs that were computed for the next re-optimization
+  for (uint32_t i = 0; i < count; ++i) {
+    for (uint32_t j = 0; j < count; ++j) {
+      if (missing[i] || missing[j]) {
+        optimizer_matrix_cache.insert(context, keys[i], keys[j], td[i * count + j]);
+      }
+    }
+  }
+  return td;
+}
+
 void thor_worker_t::optimized_route(Api& request) {
   // time this whole method and save that statistic
   auto _ = measure_scope_time(request, "thor_worker_t::optimized_route");
@@ -26,16 +105,24 @@ void thor_worker_t::optimized_route(Api& request) {
   auto costing = parse_costing(request);
   auto& options = *request.mutable_options();
 
-  // Use CostMatrix to find costs from each location to every other location
-  CostMatrix costmatrix;
-  std::vector<thor::TimeDistance> td =
-      costmatrix.SourceToTarget(options.sources(), options.targets(), *reader, mode_costing, mode,
-                                max_matrix_distance.find(costing)->second);
-
   // Return an error if any locations are totally unreachable
   const auto& correlated =
       (options.sources_size() > options.targets_size() ? options.sources() : options.targets());
 
+  // Use CostMatrix to find costs from each location to every other location
+  CostMatrix costmatrix;
+  costmatrix.set_interrupt(interrupt);
+  const auto max_distance = max_matrix_distance.find(costing)->second;
+  std::vector<thor::TimeDistance> td;
+  const bool searched = optimizer_matrix_cache.capacity() == 0;
+  if (searched) {
+    td = costmatrix.SourceToTarget(options.sources(), options.targets(), *reader, mode_costing,
+                                   mode, max_distance);
+    costmatrix.Stats().AddTo("thor_worker_t::optimized_route_matrix_", request);
+  } else {
+    td = cached_matrix(options, correlated, costmatrix, max_distance);
+  }
+
   // Set time costs to send to Optimizer.
   std::vector<float> time_costs;
   bool reachable = true;
@@ -54,15 +141,46 @@ void thor_worker_t::optimized_route(Api& request) {
 
   Optimizer optimizer;
   // returns the optimal order of the path_locations
-  auto optimal_order = optimizer.Solve(correlated.size(), time_costs);
+  std::vector<uint32_t> optimal_order;
+  if (optimizer_algorithm == OptimizerAlgorithm::kLocalSearch) {
+    // the restarts only read the costs so they can share the matrix threads
+    Optimizer::restart_runner_t run;
+    if (matrix_workers) {
+      run = [this](uint32_t count, const std::function<void(uint32_t)>& restart) {
+        matrix_workers->Run(count, *reader,
+                            [&restart](uint32_t i, uint32_t, GraphReader&) { restart(i); });
+      };
+    }
+    optimal_order =
+        optimizer.SolveLocalSearch(correlated.size(), time_costs, optimizer_restarts, run);
+  } else {
+    optimal_order = optimizer.Solve(correlated.size(), time_costs);
+  }
   // put the optimal order into the locations array
   options.mutable_locations()->Clear();
   for (size_t i = 0; i < optimal_order.size(); i++) {
     options.mutable_locations()->Add()->CopyFrom(correlated.Get(optimal_order[i]));
   }
 
+  // The legs in the optimal order are formed from the searches of the matrix rather than searched
+  // for again. The matrix knows nothing of times, through locations or alternates so those routes
+  // and any leg it cant form are searched for as usual
+  std::vector<found_leg_t> legs;
+  if (searched && options.sources_size() == options.targets_size() && options.alternates() == 0 &&
+      reuse_matrix_legs(options)) {
+    legs.resize(optimal_order.size() - 1);
+    for (size_t i = 0; i < legs.size(); ++i) {
+      auto path = costmatrix.FormPath(*reader, options.locations(i), options.locations(i + 1),
+                                      optimal_order[i], optimal_order[i + 1]);
+      if (!path.empty()) {
+        legs[i].paths.emplace_back(std::move(path));
+        legs[i].algorithm = "cost_matrix";
+      }
+    }
+  }
+
   // run the route
-  path_depart_at(request, costing);
+  path_depart_at(request, costing, std::move(legs));
 }
 
 } // namespace thor
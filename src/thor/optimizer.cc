@@ -1,9 +1,30 @@
 #include "thor/optimizer.h"
 #include "midgard/logging.h"
 
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+
+// Moves have to save at least this much of the tour cost, so rounding of the sums cant keep the
+// search going back and forth between tours that cost the same
+constexpr float kMinImprovement = 1e-5f;
+
+} // namespace
+
 namespace valhalla {
 namespace thor {
 
+OptimizerAlgorithm ParseOptimizerAlgorithm(const std::string& name) {
+  if (name == "annealing") {
+    return OptimizerAlgorithm::kAnnealing;
+  }
+  if (name == "local_search") {
+    return OptimizerAlgorithm::kLocalSearch;
+  }
+  throw std::runtime_error("Unknown optimizer algorithm " + name);
+}
+
 // Optimize the tour through a set of locations given the cost matrix
 // among all locations. The first location (origin) and last location
 // (destination) remain fixed in the tour.
@@ -52,6 +73,131 @@ std::vector<uint32_t> Optimizer::Solve(const uint32_t count, const std::vector<f
   return best_tour_;
 }
 
+// Optimize the tour with local search from several starting tours
+std::vector<uint32_t> Optimizer::SolveLocalSearch(const uint32_t count,
+                                                  const std::vector<float>& costs,
+                                                  const uint32_t restarts,
+                                                  const restart_runner_t& run) {
+  // The trivial cases are the same either way
+  if (count <= 4) {
+    return Solve(count, costs);
+  }
+  count_ = count;
+
+  // Every restart has its own tour to improve
+  std::vector<std::vector<uint32_t>> tours(std::max(restarts, 1u));
+  std::vector<float> tour_costs(tours.size());
+  auto restart = [this, &costs, &tours, &tour_costs](uint32_t r) {
+    auto& tour = tours[r];
+    tour.reserve(count_);
+    tour.push_back(0);
+    if (r == 0) {
+      // Go to the closest location not visited yet each time
+      std::vector<bool> visited(count_, false);
+      for (uint32_t i = 1; i < count_ - 1; i++) {
+        uint32_t next = 0;
+        for (uint32_t j = 1; j < count_ - 1; j++) {
+          if (!visited[j] &&
+              (next == 0 || Cost(costs, tour.back(), j) < Cost(costs, tour.back(), next))) {
+            next = j;
+          }
+        }
+        visited[next] = true;
+        tour.push_back(next);
+      }
+    } else {
+      tour.resize(count_ - 1);
+      std::iota(tour.begin() + 1, tour.end(), 1);
+      std::mt19937 generator(r);
+      std::shuffle(tour.begin() + 1, tour.end(), generator);
+    }
+    tour.push_back(count_ - 1);
+    LocalSearch(costs, tour);
+    tour_costs[r] = TourCost(costs, tour);
+  };
+  if (run) {
+    run(tours.size(), restart);
+  } else {
+    for (uint32_t r = 0; r < tours.size(); r++) {
+      restart(r);
+    }
+  }
+
+  // The first of the cheapest tours so that it doesnt matter which restart finished first
+  auto best = std::min_element(tour_costs.begin(), tour_costs.end()) - tour_costs.begin();
+  best_cost_ = tour_costs[best];
+  LOG_DEBUG("Best tour cost = " + std::to_string(best_cost_) +
+            " restarts = " + std::to_string(tours.size()));
+  return tours[best];
+}
+
+// Improve the tour with the best 2-opt or or-opt move until there is none
+void Optimizer::LocalSearch(const std::vector<float>& costs, std::vector<uint32_t>& tour) const {
+  const uint32_t n = count_;
+  std::vector<float> forward(n), backward(n);
+  while (true) {
+    // Cost of the tour up to each location, in the order of the tour and in the opposite one
+    forward[0] = backward[0] = 0.f;
+    for (uint32_t i = 1; i < n; i++) {
+      forward[i] = forward[i - 1] + Cost(costs, tour[i - 1], tour[i]);
+      backward[i] = backward[i - 1] + Cost(costs, tour[i], tour[i - 1]);
+    }
+
+    // 2-opt reverses the locations between i and j
+    float best = -std::max(kMinImprovement * forward[n - 1], kMinImprovement);
+    bool reverse = false;
+    uint32_t best_i = 0, best_j = 0, best_p = 0;
+    for (uint32_t i = 1; i < n - 2; i++) {
+      for (uint32_t j = i + 1; j < n - 1; j++) {
+        float delta = Cost(costs, tour[i - 1], tour[j]) + Cost(costs, tour[i], tour[j + 1]) +
+                      (backward[j] - backward[i]) - Cost(costs, tour[i - 1], tour[i]) -
+                      Cost(costs, tour[j], tour[j + 1]) - (forward[j] - forward[i]);
+        if (delta < best) {
+          best = delta;
+          reverse = true;
+          best_i = i;
+          best_j = j;
+        }
+      }
+    }
+
+    // Or-opt moves the locations between i and j to between p and the one after it
+    for (uint32_t i = 1; i < n - 1; i++) {
+      for (uint32_t j = i; j < std::min(i + kMaxOrOptSegment, n - 1); j++) {
+        float removed = Cost(costs, tour[i - 1], tour[j + 1]) - Cost(costs, tour[i - 1], tour[i]) -
+                        Cost(costs, tour[j], tour[j + 1]);
+        for (uint32_t p = 0; p < n - 1; p++) {
+          if (p + 1 == i) {
+            p = j;
+            continue;
+          }
+          float delta = removed + Cost(costs, tour[p], tour[i]) +
+                        Cost(costs, tour[j], tour[p + 1]) - Cost(costs, tour[p], tour[p + 1]);
+          if (delta < best) {
+            best = delta;
+            reverse = false;
+            best_i = i;
+            best_j = j;
+            best_p = p;
+          }
+        }
+      }
+    }
+
+    // Make the best move or stop if none of them helps
+    if (best_i == 0) {
+      break;
+    }
+    if (reverse) {
+      std::reverse(tour.begin() + best_i, tour.begin() + best_j + 1);
+    } else if (best_p < best_i) {
+      std::rotate(tour.begin() + best_p + 1, tour.begin() + best_i, tour.begin() + best_j + 1);
+    } else {
+      std::rotate(tour.begin() + best_i, tour.begin() + best_j + 1, tour.begin() + best_p + 1);
+    }
+  }
+}
+
 // Perform the annealing process.
 uint32_t Optimizer::Anneal(const std::vector<float>& costs, float temperature) {
   uint32_t success_count = 0;
@@ -1,4 +1,5 @@
 #include "thor/worker.h"
+#include <atomic>
 #include <cstdint>
 
 #include "baldr/json.h"
@@ -27,6 +28,22 @@ namespace {
 // A* can take excessive time for longer paths - so exclude them to protect the service.
 constexpr float kPedestrianMultipassThreshold = 50000.0f; // 50km
 
+// Whether any of the edges of the origin and the destination are the same or connected, which
+// bidirectional A* does not handle
+bool is_trivial(GraphReader& reader,
+                const valhalla::Location& origin,
+                const valhalla::Location& destination) {
+  for (auto& edge1 : origin.path_edges()) {
+    for (auto& edge2 : destination.path_edges()) {
+      if (edge1.graph_id() == edge2.graph_id() ||
+          reader.AreEdgesConnected(GraphId(edge1.graph_id()), GraphId(edge2.graph_id()))) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 /**
  * Check if the paths meet at opposing edges (but not at a node). If so, add a route discontinuity
  * so that the shape / distance along the path is adjusted at the location.
@@ -150,6 +167,11 @@ void remove_edges(const GraphId& edge_id, valhalla::Location& loc, GraphReader&
   }
 }*/
 
+// adds the work the search of a leg did to the statistics of the request
+void add_search_stats(Api& api, const PathAlgorithm& path_algorithm) {
+  path_algorithm.Stats().AddTo("thor_worker_t::search_", api);
+}
+
 } // namespace
 
 namespace valhalla {
@@ -218,6 +240,7 @@ std::string thor_worker_t::expansion(Api& request) {
            &timedep_reverse,
            &bidir_astar,
            &bss_astar,
+           &contraction_query,
        }) {
     alg->set_track_expansion(track_expansion);
   }
@@ -236,6 +259,7 @@ std::string thor_worker_t::expansion(Api& request) {
            &timedep_reverse,
            &bidir_astar,
            &bss_astar,
+           &contraction_query,
        }) {
     alg->set_track_expansion(nullptr);
   }
@@ -279,6 +303,7 @@ void thor_worker_t::centroid(Api& request) {
 void thor_worker_t::route(Api& request) {
   // time this whole method and save that statistic
   auto _ = measure_scope_time(request, "thor_worker_t::route");
+  auto tiles = measure_scope_tiles(*reader, "thor_worker_t::route_", request);
 
   parse_locations(request);
   parse_filter_attributes(request);
@@ -291,6 +316,8 @@ void thor_worker_t::route(Api& request) {
   } else {
     path_depart_at(request, costing);
   }
+  // a cached route is only good for as long as the tiles of its edges stay the same
+  response_cache_t::tag(request, *reader);
   // log admin areas
   if (!options.do_not_track()) {
     for (const auto& route : request.trip().routes()) {
@@ -312,6 +339,7 @@ thor::PathAlgorithm* thor_worker_t::get_path_algorithm(const std::string& routet
            &timedep_reverse,
            &bidir_astar,
            &bss_astar,
+           &contraction_query,
        }) {
     alg->set_interrupt(interrupt);
   }
@@ -326,60 +354,90 @@ thor::PathAlgorithm* thor_worker_t::get_path_algorithm(const std::string& routet
     return &bss_astar;
   }
 
-  // If the origin has date_time set use timedep_forward method if the distance
-  // between location is below some maximum distance (TBD).
-  if (origin.has_date_time() && options.date_time_type() != Options::invariant) {
+  // Time dependent routes use a unidirectional search if the distance between the locations is
+  // below some maximum distance (TBD). If bidirectional A* is used for them anyway, they are only
+  // needed for the trivial routes
+  auto unidirectional = [&]() {
+    if (bidirectional_timedep) {
+      return is_trivial(*reader, origin, destination);
+    }
     PointLL ll1(origin.ll().lng(), origin.ll().lat());
     PointLL ll2(destination.ll().lng(), destination.ll().lat());
-    if (ll1.Distance(ll2) < max_timedep_distance) {
-      return &timedep_forward;
-    }
+    return ll1.Distance(ll2) < max_timedep_distance;
+  };
+
+  // If the origin has date_time set use timedep_forward method
+  if (origin.has_date_time() && options.date_time_type() != Options::invariant &&
+      unidirectional()) {
+    return &timedep_forward;
   }
 
-  // If the destination has date_time set use timedep_reverse method if the distance
-  // between location is below some maximum distance (TBD).
-  if (destination.has_date_time() && options.date_time_type() != Options::invariant) {
-    PointLL ll1(origin.ll().lng(), origin.ll().lat());
-    PointLL ll2(destination.ll().lng(), destination.ll().lat());
-    if (ll1.Distance(ll2) < max_timedep_distance) {
-      return &timedep_reverse;
-    }
+  // If the destination has date_time set use timedep_reverse method
+  if (destination.has_date_time() && options.date_time_type() != Options::invariant &&
+      unidirectional()) {
+    return &timedep_reverse;
   }
 
+  // The remaining choices dont depend on time and are the same on every route thread
+  return get_time_invariant_path_algorithm({*reader, mode_costing, timedep_forward, bidir_astar,
+                                            contraction_query},
+                                           routetype, origin, destination, options);
+}
+
+thor::PathAlgorithm*
+thor_worker_t::get_time_invariant_path_algorithm(const leg_search_t& search,
+                                                 const std::string& routetype,
+                                                 const valhalla::Location& origin,
+                                                 const valhalla::Location& destination,
+                                                 const Options& options) {
   // Use A* if any origin and destination edges are the same or are connected - otherwise
   // use bidirectional A*. Bidirectional A* does not handle trivial cases with oneways and
   // has issues when cost of origin or destination edge is high (needs a high threshold to
   // find the proper connection).
-  for (auto& edge1 : origin.path_edges()) {
-    for (auto& edge2 : destination.path_edges()) {
-      bool same_graph_id = edge1.graph_id() == edge2.graph_id();
-      bool are_connected =
-          reader->AreEdgesConnected(GraphId(edge1.graph_id()), GraphId(edge2.graph_id()));
-      if (same_graph_id || are_connected) {
-        return &timedep_forward;
-      }
-    }
+  if (is_trivial(search.reader, origin, destination)) {
+    return &search.timedep_forward;
+  }
+
+  // Default auto costing without time dependence can use the contraction hierarchy
+  if (search.contraction_query.Supports(routetype, origin, destination, options)) {
+    return &search.contraction_query;
   }
 
   // No other special cases we land on bidirectional a*
-  return &bidir_astar;
+  return &search.bidir_astar;
 }
 
-std::vector<std::vector<thor::PathInfo>> thor_worker_t::get_path(PathAlgorithm* path_algorithm,
+std::vector<std::vector<thor::PathInfo>> thor_worker_t::get_path(const leg_search_t& search,
+                                                                 PathAlgorithm*& path_algorithm,
                                                                  valhalla::Location& origin,
                                                                  valhalla::Location& destination,
                                                                  const std::string& costing,
                                                                  const Options& options) {
   // Find the path.
-  valhalla::sif::cost_ptr_t cost = mode_costing[static_cast<uint32_t>(mode)];
+  valhalla::sif::cost_ptr_t cost = search.mode_costing[static_cast<uint32_t>(mode)];
+
+  // The contraction hierarchy doesnt know about turns, if its path breaks a restriction we fall
+  // back to bidirectional a*
+  if (path_algorithm == &search.contraction_query) {
+    cost->set_pass(0);
+    auto paths = search.contraction_query.GetBestPath(origin, destination, search.reader,
+                                                      search.mode_costing, mode, options);
+    if (!paths.empty()) {
+      return paths;
+    }
+    path_algorithm = &search.bidir_astar;
+    path_algorithm->Clear();
+    LOG_INFO(std::string("algorithm::") + path_algorithm->name());
+  }
 
   // If bidirectional A* disable use of destination-only edges on the
   // first pass. If there is a failure, we allow them on the second pass.
   // Other path algorithms can use destination-only edges on the first pass.
-  cost->set_allow_destination_only(path_algorithm == &bidir_astar ? false : true);
+  cost->set_allow_destination_only(path_algorithm == &search.bidir_astar ? false : true);
 
   cost->set_pass(0);
-  auto paths = path_algorithm->GetBestPath(origin, destination, *reader, mode_costing, mode, options);
+  auto paths = path_algorithm->GetBestPath(origin, destination, search.reader, search.mode_costing,
+                                           mode, options);
 
   // Check if we should run a second pass pedestrian route with different A*
   // (to look for better routes where a ferry is taken)
@@ -404,15 +462,15 @@ std::vector<std::vector<thor::PathInfo>> thor_worker_t::get_path(PathAlgorithm*
     path_algorithm->Clear();
     cost->set_pass(1);
     // since bidir does about half the expansion we can do half the relaxation here
-    float relax_factor = path_algorithm == &bidir_astar ? 8.f : 16.f;
-    float expansion_within_factor = path_algorithm == &bidir_astar ? 2.f : 4.f;
+    float relax_factor = path_algorithm == &search.bidir_astar ? 8.f : 16.f;
+    float expansion_within_factor = path_algorithm == &search.bidir_astar ? 2.f : 4.f;
     cost->RelaxHierarchyLimits(relax_factor, expansion_within_factor);
     cost->set_allow_destination_only(true);
     cost->set_allow_conditional_destination(true);
     path_algorithm->set_not_thru_pruning(false);
     // Get the best path. Return if not empty (else return the original path)
-    auto relaxed_paths =
-        path_algorithm->GetBestPath(origin, destination, *reader, mode_costing, mode, options);
+    auto relaxed_paths = path_algorithm->GetBestPath(origin, destination, search.reader,
+                                                     search.mode_costing, mode, options);
     if (!relaxed_paths.empty()) {
       return relaxed_paths;
     }
@@ -421,6 +479,94 @@ std::vector<std::vector<thor::PathInfo>> thor_worker_t::get_path(PathAlgorithm*
   return paths;
 }
 
+std::vector<thor_worker_t::found_leg_t>
+thor_worker_t::find_legs(google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+                         const std::string& costing,
+                         const Options& options) {
+  // Times carried from leg to leg, transit, bike share and tracking the expansion all have to go
+  // leg by leg on the calling thread
+  if (!route_workers || locations.size() < 3 || options.alternates() > 0 ||
+      options.action() == Options::expansion || costing == "multimodal" ||
+      costing == "transit" || costing == "bikeshare") {
+    return {};
+  }
+  for (const auto& location : locations) {
+    if (location.has_date_time() && options.date_time_type() != Options::invariant) {
+      return {};
+    }
+  }
+
+  // A run of legs goes on for as long as the legs start from through locations, which have to
+  // continue on the edge the leg before them ended on
+  std::vector<int> runs{0};
+  for (int i = 1; i < locations.size() - 1; ++i) {
+    if (!is_through_point(locations.Get(i))) {
+      runs.push_back(i);
+    }
+  }
+  if (runs.size() < 2) {
+    return {};
+  }
+  runs.push_back(locations.size() - 1);
+
+  // Every thread gets its own costing, the one of the worker is still used to build the legs
+  std::vector<mode_costing_t> costings;
+  for (uint32_t slot = 0; slot < route_workers->size(); ++slot) {
+    auto thread_mode = mode;
+    costings.emplace_back(factory.CreateModeCosting(options, thread_mode));
+  }
+  for (auto& algorithms : leg_algorithms) {
+    for (auto* alg : std::vector<PathAlgorithm*>{&algorithms->timedep_forward,
+                                                 &algorithms->bidir_astar,
+                                                 &algorithms->contraction_query}) {
+      alg->set_interrupt(interrupt);
+    }
+  }
+
+  // The runs work on copies of the locations so that nothing changes if any of them fails
+  std::vector<found_leg_t> found(locations.size() - 1);
+  auto changed = locations;
+  std::atomic<bool> failed{false};
+  route_workers->Run(runs.size() - 1, *reader, [&](uint32_t run, uint32_t slot, GraphReader& reader) {
+    leg_search_t search{reader, costings[slot],
+                        slot == 0 ? timedep_forward : leg_algorithms[slot - 1]->timedep_forward,
+                        slot == 0 ? bidir_astar : leg_algorithms[slot - 1]->bidir_astar,
+                        slot == 0 ? contraction_query
+                                  : leg_algorithms[slot - 1]->contraction_query};
+    auto cost = search.mode_costing[static_cast<uint32_t>(mode)];
+    GraphId last_edge;
+    for (int i = runs[run]; i < runs[run + 1] && !failed; ++i) {
+      auto& origin = *changed.Mutable(i);
+      auto destination = changed.Get(i + 1);
+      auto* path_algorithm =
+          get_time_invariant_path_algorithm(search, costing, origin, destination, options);
+      path_algorithm->Clear();
+      LOG_INFO(std::string("algorithm::") + path_algorithm->name());
+
+      if (is_through_point(origin) && last_edge.Is_Valid()) {
+        remove_path_edges(origin,
+                          [&last_edge](const auto& edge) { return edge.graph_id() != last_edge; });
+      }
+
+      // A second pass may add edges to the destination, which the next leg would start from
+      found[i].paths = get_path(search, path_algorithm, origin, destination, costing, options);
+      found[i].algorithm = path_algorithm->name();
+      if (found[i].paths.empty() || cost->pass() > 0) {
+        failed = true;
+        break;
+      }
+      last_edge = found[i].paths.back().back().edgeid;
+    }
+  });
+  if (failed) {
+    LOG_INFO("Finding the legs one after the other");
+    return {};
+  }
+
+  locations.Swap(&changed);
+  return found;
+}
+
 void thor_worker_t::path_arrive_by(Api& api, const std::string& costing) {
   // Things we'll need
   TripRoute* route = nullptr;
@@ -437,7 +583,6 @@ void thor_worker_t::path_arrive_by(Api& api, const std::string& costing) {
     thor::PathAlgorithm* path_algorithm =
         this->get_path_algorithm(costing, *origin, *destination, options);
     path_algorithm->Clear();
-    algorithms.push_back(path_algorithm->name());
     LOG_INFO(std::string("algorithm::") + path_algorithm->name());
 
     // If we are continuing through a location we need to make sure we
@@ -448,7 +593,15 @@ void thor_worker_t::path_arrive_by(Api& api, const std::string& costing) {
     }
 
     // Get best path and keep it
-    auto temp_paths = this->get_path(path_algorithm, *origin, *destination, costing, options);
+    std::vector<std::vector<thor::PathInfo>> temp_paths;
+    {
+      auto _ = measure_scope_time(api, "thor_worker_t::search");
+      temp_paths = this->get_path({*reader, mode_costing, timedep_forward, bidir_astar,
+                                   contraction_query},
+                                  path_algorithm, *origin, *destination, costing, options);
+    }
+    add_search_stats(api, *path_algorithm);
+    algorithms.push_back(path_algorithm->name());
     if (temp_paths.empty())
       return false;
 
@@ -504,6 +657,7 @@ void thor_worker_t::path_arrive_by(Api& api, const std::string& costing) {
           route->mutable_legs()->Reserve(options.locations_size());
         }
         auto& leg = *route->mutable_legs()->Add();
+        auto _ = measure_scope_time(api, "thor::TripLegBuilder");
         TripLegBuilder::Build(options, controller, *reader, mode_costing, path.begin(), path.end(),
                               *origin, *destination, throughs, leg, algorithms, interrupt, &vias);
         path.clear();
@@ -565,7 +719,9 @@ void thor_worker_t::path_arrive_by(Api& api, const std::string& costing) {
   *api.mutable_options()->mutable_locations() = std::move(correlated);
 }
 
-void thor_worker_t::path_depart_at(Api& api, const std::string& costing) {
+void thor_worker_t::path_depart_at(Api& api,
+                                   const std::string& costing,
+                                   std::vector<found_leg_t> found) {
   // Things we'll need
   TripRoute* route = nullptr;
   GraphId last_edge;
@@ -576,23 +732,43 @@ void thor_worker_t::path_depart_at(Api& api, const std::string& costing) {
   valhalla::Trip& trip = *api.mutable_trip();
   trip.mutable_routes()->Reserve(options.alternates() + 1);
 
+  auto correlated = options.locations();
+  if (found.empty()) {
+    auto _ = measure_scope_time(api, "thor_worker_t::search");
+    found = find_legs(correlated, costing, options);
+  }
+
   auto route_two_locations = [&, this](auto& origin, auto& destination) -> bool {
-    // Get the algorithm type for this location pair
-    thor::PathAlgorithm* path_algorithm =
-        this->get_path_algorithm(costing, *origin, *destination, options);
-    path_algorithm->Clear();
-    algorithms.push_back(path_algorithm->name());
-    LOG_INFO(std::string("algorithm::") + path_algorithm->name());
+    // The leg may have been found on the route threads or by the matrix already
+    std::vector<std::vector<thor::PathInfo>> temp_paths;
+    auto* leg = found.empty() ? nullptr : &found[std::distance(correlated.begin(), origin)];
+    if (leg && !leg->paths.empty()) {
+      temp_paths.swap(leg->paths);
+      algorithms.push_back(leg->algorithm);
+    } else {
+      // Get the algorithm type for this location pair
+      thor::PathAlgorithm* path_algorithm =
+          this->get_path_algorithm(costing, *origin, *destination, options);
+      path_algorithm->Clear();
+      LOG_INFO(std::string("algorithm::") + path_algorithm->name());
+
+      // If we are continuing through a location we need to make sure we
+      // only allow the edge that was used previously (avoid u-turns)
+      if (is_through_point(*origin) && last_edge.Is_Valid()) {
+        remove_path_edges(*origin,
+                          [&last_edge](const auto& edge) { return edge.graph_id() != last_edge; });
+      }
 
-    // If we are continuing through a location we need to make sure we
-    // only allow the edge that was used previously (avoid u-turns)
-    if (is_through_point(*origin) && last_edge.Is_Valid()) {
-      remove_path_edges(*origin,
-                        [&last_edge](const auto& edge) { return edge.graph_id() != last_edge; });
+      // Get best path and keep it
+      {
+        auto _ = measure_scope_time(api, "thor_worker_t::search");
+        temp_paths = this->get_path({*reader, mode_costing, timedep_forward, bidir_astar,
+                                     contraction_query},
+                                    path_algorithm, *origin, *destination, costing, options);
+      }
+      add_search_stats(api, *path_algorithm);
+      algorithms.push_back(path_algorithm->name());
     }
-
-    // Get best path and keep it
-    auto temp_paths = this->get_path(path_algorithm, *origin, *destination, costing, options);
     if (temp_paths.empty())
       return false;
 
@@ -643,6 +819,7 @@ void thor_worker_t::path_depart_at(Api& api, const std::string& costing) {
           route->mutable_legs()->Reserve(options.locations_size());
         }
         auto& leg = *route->mutable_legs()->Add();
+        auto _ = measure_scope_time(api, "thor::TripLegBuilder");
         thor::TripLegBuilder::Build(options, controller, *reader, mode_costing, path.begin(),
                                     path.end(), *origin, *destination, throughs, leg, algorithms,
                                     interrupt, &vias);
@@ -658,7 +835,6 @@ void thor_worker_t::path_depart_at(Api& api, const std::string& costing) {
     return true;
   };
 
-  auto correlated = options.locations();
   bool allow_retry = true;
 
   // For each pair of locations
@@ -54,6 +54,22 @@ float length_comparison(const float length, const bool exact_match) {
   return length + tolerance;
 }
 
+// The first shape index, from the given one on, at which an edge of the given length could end when
+// the shape is walked from the given accumulated distance. The shape before it is too short for the
+// edge and, since the accumulated distances only grow, it is skipped with a binary search rather
+// than walked point by point for every candidate edge
+size_t first_end_index(const std::vector<std::pair<float, float>>& distances,
+                       const size_t begin_index,
+                       const float begin_distance,
+                       const float edge_length) {
+  auto end = std::partition_point(distances.begin() + begin_index, distances.end(),
+                                  [begin_distance, edge_length](const std::pair<float, float>& d) {
+                                    return length_comparison(d.second - begin_distance, true) <=
+                                           edge_length;
+                                  });
+  return end - distances.begin();
+}
+
 // TODO: we need to stop relying on loki::Search to pre populate edge candidates for the first and
 // last locations. Instead we need to do that here where we already know the edges in question and can
 // make a single path edge for the edge we are interested in. Its the only way to get multi-leg
@@ -163,19 +179,18 @@ bool expand_from_node(const mode_costing_t& mode_costing,
     float de_length = length_comparison(de->length(), true);
 
     // Process current edge until shape matches end node or shape length is longer than
-    // the current edge. Increment to the next shape point after the correlated index.
-    size_t index = correlated_index + 1;
-    float length = 0.0f;
+    // the current edge. Start at the first shape point after the correlated index that is far
+    // enough along the shape for the edge to end there.
+    const float begin_distance = distances[correlated_index].second;
+    size_t index = first_end_index(distances, correlated_index + 1, begin_distance, de->length());
     while (index < shape.size()) {
       // Exclude edge if length along shape is longer than the edge length
-      length += distances.at(index).first;
-      if (length > de_length) {
+      if (distances[index].second - begin_distance > de_length) {
         break;
       }
 
       // Found a match if shape equals directed edge LL within tolerance
-      if (to_ll(shape.Get(index).ll()).ApproximatelyEqual(de_end_ll) &&
-          de->length() < length_comparison(length, true)) {
+      if (to_ll(shape.Get(index).ll()).ApproximatelyEqual(de_end_ll)) {
 
         // Figure out what time it is right now, the first iteration is a no-op
         auto offset_time_info = nodeinfo
@@ -256,8 +271,7 @@ bool expand_from_node(const mode_costing_t& mode_costing,
 }
 
 valhalla::baldr::TimeInfo init_time_info(valhalla::baldr::GraphReader& reader,
-                                         valhalla::Options& options,
-                                         valhalla::baldr::DateTime::tz_sys_info_cache_t* tz_cache) {
+                                         valhalla::Options& options) {
   graph_tile_ptr tile = nullptr;
   const DirectedEdge* directededge = nullptr;
   const NodeInfo* nodeinfo = nullptr;
@@ -281,7 +295,7 @@ valhalla::baldr::TimeInfo init_time_info(valhalla::baldr::GraphReader& reader,
         options.mutable_shape(0)->set_date_time(
             DateTime::seconds_to_date(options.shape(0).time(), tz, false));
       }
-      return TimeInfo::make(*options.mutable_shape(0), reader, tz_cache, nodeinfo->timezone());
+      return TimeInfo::make(*options.mutable_shape(0), reader, nullptr, nodeinfo->timezone());
     }
   }
   return TimeInfo::invalid();
@@ -332,8 +346,7 @@ bool RouteMatcher::FormPath(const sif::mode_costing_t& mode_costing,
 
   // We support either the epoch timestamp that came with the trace point or
   // a local date time which we convert to epoch by finding the first timezone
-  valhalla::baldr::DateTime::tz_sys_info_cache_t tz_cache;
-  auto time_info = init_time_info(reader, options, &tz_cache);
+  auto time_info = init_time_info(reader, options);
 
   // Perform the edge walk by starting with one of the candidate edges and walking from it
   // if that walk fails we fall back to another candidate edge until we exhaust the candidates
@@ -361,11 +374,10 @@ bool RouteMatcher::FormPath(const sif::mode_costing_t& mode_costing,
     }
     midgard::PointLL de_end_ll = end_node_tile->get_node_ll(de->endnode());
 
-    // Initialize indexes and shape
-    size_t index = 0;
-    float length = 0.0f;
+    // Initialize indexes and shape, skipping the shape that is too short to reach the end node
     float de_remaining_length = de->length() * (1 - edge.percent_along());
     float de_length = length_comparison(de_remaining_length, true);
+    size_t index = first_end_index(distances, 0, 0.0f, de_remaining_length);
     EdgeLabel prev_edge_label;
     Cost elapsed;
     // Cost accumulated_elapsed{}; // TODO: use this once we have more than one leg
@@ -375,14 +387,12 @@ bool RouteMatcher::FormPath(const sif::mode_costing_t& mode_costing,
     while (index < options.shape_size()) {
 
       // bail on this edge if the length of input we checked is already longer than the edge
-      length += distances.at(index).first;
-      if (length > de_length) {
+      if (distances[index].second > de_length) {
         break;
       }
 
       // Check if shape is within tolerance at the end node
-      if (to_ll(options.shape(index).ll()).ApproximatelyEqual(de_end_ll) &&
-          de_remaining_length < length_comparison(length, true)) {
+      if (to_ll(options.shape(index).ll()).ApproximatelyEqual(de_end_ll)) {
 
         // Figure out what time it is right now, the first iteration is a no-op
         auto offset_time_info = nodeinfo
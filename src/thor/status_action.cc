@@ -2,7 +2,7 @@
 
 namespace valhalla {
 namespace thor {
-void thor_worker_t::status(Api&) const {
+void thor_worker_t::status(Api& request) const {
 #ifdef HAVE_HTTP
   // if we are in the process of shutting down we signal that here
   // should react by draining traffic (though they are likely doing this as they are usually the ones
@@ -11,6 +11,42 @@ void thor_worker_t::status(Api&) const {
     throw valhalla_exception_t{402};
   }
 #endif
+
+  // report how the tiles were found so the cache size can be tuned
+  tile_statistics(*reader, "thor_worker_t::", request);
+
+  // report how busy each action keeps the workers so the admission limits can be tuned
+  if (admission) {
+    admission->statistics("thor_worker_t::", request);
+  }
+
+  // report how often the candidate grids of map matching were reused so their cache can be tuned
+  const auto& grids = matcher_factory.candidategridquery();
+  const auto hits = grids.hits(), misses = grids.misses();
+  auto* stat = request.mutable_info()->mutable_statistics()->Add();
+  stat->set_name("thor_worker_t::candidate_grid_cache_size");
+  stat->set_value(grids.size());
+  stat = request.mutable_info()->mutable_statistics()->Add();
+  stat->set_name("thor_worker_t::candidate_grid_cache_hits");
+  stat->set_value(hits);
+  stat = request.mutable_info()->mutable_statistics()->Add();
+  stat->set_name("thor_worker_t::candidate_grid_cache_hit_rate");
+  stat->set_value(hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.);
+
+  // and how often the paths between candidates were so the transition cache can be tuned too
+  const auto& transitions = matcher_factory.transitioncache();
+  const auto path_hits = transitions.hits(), path_misses = transitions.misses();
+  stat = request.mutable_info()->mutable_statistics()->Add();
+  stat->set_name("thor_worker_t::transition_cache_size");
+  stat->set_value(transitions.size());
+  stat = request.mutable_info()->mutable_statistics()->Add();
+  stat->set_name("thor_worker_t::transition_cache_hits");
+  stat->set_value(path_hits);
+  stat = request.mutable_info()->mutable_statistics()->Add();
+  stat->set_name("thor_worker_t::transition_cache_hit_rate");
+  stat->set_value(path_hits + path_misses
+                      ? static_cast<double>(path_hits) / (path_hits + path_misses)
+                      : 0.);
 }
 } // namespace thor
 } // namespace valhalla
@@ -36,7 +36,8 @@ namespace valhalla {
 namespace thor {
 
 // Constructor with cost threshold.
-TimeDistanceBSSMatrix::TimeDistanceBSSMatrix() : settled_count_(0), current_cost_threshold_(0) {
+TimeDistanceBSSMatrix::TimeDistanceBSSMatrix()
+    : settled_count_(0), current_cost_threshold_(0), station_walk_cost_(0) {
 }
 
 float TimeDistanceBSSMatrix::GetCostThreshold(const float max_matrix_distance) const {
@@ -45,6 +46,18 @@ float TimeDistanceBSSMatrix::GetCostThreshold(const float max_matrix_distance) c
   return max_matrix_distance / (2.0f * kMPHtoMetersPerSec);
 }
 
+float TimeDistanceBSSMatrix::GetStationWalkCost(
+    GraphReader& graphreader,
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& locations) {
+  // A bike has to be returned at a station before walking to any of the locations
+  float distance = kMaxStationAccess;
+  for (const auto& location : locations) {
+    distance = std::min(distance, stations_.Distance(graphreader, {location.ll().lng(),
+                                                                   location.ll().lat()}));
+  }
+  return distance * pedestrian_costing_->AStarCostFactor() * pedestrian_costing_->GetModeFactor();
+}
+
 // Clear the temporary information generated during time + distance matrix
 // construction.
 void TimeDistanceBSSMatrix::Clear() {
@@ -133,6 +146,12 @@ void TimeDistanceBSSMatrix::ExpandForward(GraphReader& graphreader,
       continue;
     }
 
+    // Skip bicycle labels which cannot return the bike and walk to a location within the threshold
+    if (mode == TravelMode::kBicycle &&
+        newcost.cost + station_walk_cost_ > current_cost_threshold_) {
+      continue;
+    }
+
     // Add to the adjacency list and edge labels.
     uint32_t idx = edgelabels_.size();
     edgelabels_.emplace_back(pred_idx, edgeid, directededge, newcost, newcost.cost, 0.0f, mode,
@@ -189,6 +208,7 @@ std::vector<TimeDistance> TimeDistanceBSSMatrix::OneToMany(
   settled_count_ = 0;
   SetOriginOneToMany(graphreader, origin);
   SetDestinationsOneToMany(graphreader, locations);
+  station_walk_cost_ = GetStationWalkCost(graphreader, locations);
 
   // Find shortest path
   const GraphTile* tile;
@@ -327,6 +347,12 @@ void TimeDistanceBSSMatrix::ExpandReverse(GraphReader& graphreader,
       continue;
     }
 
+    // Skip bicycle labels which cannot return the bike and walk to a location within the threshold
+    if (mode == TravelMode::kBicycle &&
+        newcost.cost + station_walk_cost_ > current_cost_threshold_) {
+      continue;
+    }
+
     // Add to the adjacency list and edge labels.
     uint32_t idx = edgelabels_.size();
     edgelabels_.emplace_back(pred_idx, edgeid, directededge, newcost, newcost.cost, 0.0f, mode,
@@ -383,6 +409,7 @@ std::vector<TimeDistance> TimeDistanceBSSMatrix::ManyToOne(
   settled_count_ = 0;
   SetOriginManyToOne(graphreader, dest);
   SetDestinationsManyToOne(graphreader, locations);
+  station_walk_cost_ = GetStationWalkCost(graphreader, locations);
 
   graph_tile_ptr tile;
   while (true) {
@@ -466,6 +493,7 @@ std::vector<TimeDistance> TimeDistanceBSSMatrix::SourceToTarget(
       Clear();
     }
   }
+  stations_.Clear();
   return many_to_many;
 }
 
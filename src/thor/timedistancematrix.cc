@@ -1,8 +1,11 @@
 #include "thor/timedistancematrix.h"
 #include "midgard/logging.h"
 #include <algorithm>
+#include <mutex>
 #include <vector>
 
+#include <robin_hood.h>
+
 using namespace valhalla::baldr;
 using namespace valhalla::sif;
 
@@ -26,9 +29,16 @@ static bool IsTrivial(const uint64_t& edgeid,
 namespace valhalla {
 namespace thor {
 
+class TimeDistanceMatrix::DestEdges
+    : public robin_hood::unordered_flat_map<uint64_t, std::vector<uint32_t>> {};
+
 // Constructor with cost threshold.
-TimeDistanceMatrix::TimeDistanceMatrix()
-    : mode_(TravelMode::kDrive), settled_count_(0), current_cost_threshold_(0) {
+TimeDistanceMatrix::TimeDistanceMatrix(const std::shared_ptr<MatrixWorkers>& workers)
+    : mode_(TravelMode::kDrive), settled_count_(0), current_cost_threshold_(0),
+      dest_edges_{new DestEdges}, workers_(workers) {
+}
+
+TimeDistanceMatrix::~TimeDistanceMatrix() {
 }
 
 // Compute a cost threshold in seconds based on average speed for the travel mode.
@@ -55,10 +65,21 @@ float TimeDistanceMatrix::GetCostThreshold(const float max_matrix_distance) cons
 // Clear the temporary information generated during time + distance matrix
 // construction.
 void TimeDistanceMatrix::Clear() {
-  // Clear the edge labels and destination list
-  edgelabels_.clear();
+  // Clear the destination list
   destinations_.clear();
-  dest_edges_.clear();
+  dest_edges_->clear();
+  ClearSearch();
+
+  // The searches of SourceToTarget keep their buffers, their destinations are set per request
+  for (auto& search : searches_) {
+    search->Clear();
+  }
+}
+
+// Clear the state of the last search
+void TimeDistanceMatrix::ClearSearch() {
+  // Clear the edge labels
+  edgelabels_.clear();
 
   // Clear elements from the adjacency list
   adjacencylist_.clear();
@@ -98,7 +119,7 @@ void TimeDistanceMatrix::ExpandForward(GraphReader& graphreader,
     // directed edge), if no access is allowed to this edge (based on costing
     // method), or if a complex restriction prevents this path.
     uint8_t restriction_idx = -1;
-    const bool is_dest = dest_edges_.find(edgeid) != dest_edges_.cend();
+    const bool is_dest = dest_edges_->find(edgeid) != dest_edges_->cend();
     if (es->set() == EdgeSet::kPermanent ||
         !costing_->Allowed(directededge, is_dest, pred, tile, edgeid, 0, 0, restriction_idx) ||
         costing_->Restricted(directededge, pred, edgelabels_, tile, edgeid, true)) {
@@ -160,6 +181,15 @@ TimeDistanceMatrix::OneToMany(const valhalla::Location& origin,
   costing_ = mode_costing[static_cast<uint32_t>(mode_)];
   current_cost_threshold_ = GetCostThreshold(max_matrix_distance);
 
+  SetDestinations(graphreader, locations);
+  return SearchOneToMany(origin, locations, graphreader);
+}
+
+// Run the search from one origin location to the destinations
+std::vector<TimeDistance> TimeDistanceMatrix::SearchOneToMany(
+    const valhalla::Location& origin,
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+    GraphReader& graphreader) {
   // Construct adjacency list, edge status, and done set. Set bucket size and
   // cost range based on DynamicCost. Initialize A* heuristic with 0 cost
   // factor (needed for setting the origin).
@@ -168,10 +198,9 @@ TimeDistanceMatrix::OneToMany(const valhalla::Location& origin,
   adjacencylist_.reuse(0.0f, current_cost_threshold_, bucketsize, &edgelabels_);
   edgestatus_.clear();
 
-  // Initialize the origin and destination locations
+  // Initialize the origin location
   settled_count_ = 0;
   SetOriginOneToMany(graphreader, origin);
-  SetDestinations(graphreader, locations);
 
   // Find shortest path
   graph_tile_ptr tile;
@@ -195,8 +224,8 @@ TimeDistanceMatrix::OneToMany(const valhalla::Location& origin,
     }
 
     // Identify any destinations on this edge
-    auto destedge = dest_edges_.find(pred.edgeid());
-    if (destedge != dest_edges_.end()) {
+    auto destedge = dest_edges_->find(pred.edgeid());
+    if (destedge != dest_edges_->end()) {
       // Update any destinations along this edge. Return if all destinations
       // have been settled.
       tile = graphreader.GetGraphTile(pred.edgeid());
@@ -328,6 +357,15 @@ TimeDistanceMatrix::ManyToOne(const valhalla::Location& dest,
   costing_ = mode_costing[static_cast<uint32_t>(mode_)];
   current_cost_threshold_ = GetCostThreshold(max_matrix_distance);
 
+  SetDestinationsManyToOne(graphreader, locations);
+  return SearchManyToOne(dest, locations, graphreader);
+}
+
+// Run the search from the destination location to the many locations
+std::vector<TimeDistance> TimeDistanceMatrix::SearchManyToOne(
+    const valhalla::Location& dest,
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+    GraphReader& graphreader) {
   // Construct adjacency list, edge status, and done set. Set bucket size and
   // cost range based on DynamicCost. Initialize A* heuristic with 0 cost
   // factor (needed for setting the origin).
@@ -336,10 +374,9 @@ TimeDistanceMatrix::ManyToOne(const valhalla::Location& dest,
   adjacencylist_.reuse(0.0f, current_cost_threshold_, bucketsize, &edgelabels_);
   edgestatus_.clear();
 
-  // Initialize the origin and destination locations
+  // Initialize the origin location
   settled_count_ = 0;
   SetOriginManyToOne(graphreader, dest);
-  SetDestinationsManyToOne(graphreader, locations);
 
   // Find shortest path
   graph_tile_ptr tile;
@@ -363,8 +400,8 @@ TimeDistanceMatrix::ManyToOne(const valhalla::Location& dest,
     }
 
     // Identify any destinations on this edge
-    auto destedge = dest_edges_.find(pred.edgeid());
-    if (destedge != dest_edges_.end()) {
+    auto destedge = dest_edges_->find(pred.edgeid());
+    if (destedge != dest_edges_->end()) {
       // Update any destinations along this edge. Return if all destinations
       // have been settled.
       tile = graphreader.GetGraphTile(pred.edgeid());
@@ -402,23 +439,76 @@ std::vector<TimeDistance> TimeDistanceMatrix::SourceToTarget(
     baldr::GraphReader& graphreader,
     const sif::mode_costing_t& mode_costing,
     const sif::TravelMode mode,
-    const float max_matrix_distance) {
-  // Run a series of one to many calls and concatenate the results.
-  std::vector<TimeDistance> many_to_many;
-  if (source_location_list.size() <= target_location_list.size()) {
-    for (const auto& origin : source_location_list) {
-      std::vector<TimeDistance> td = OneToMany(origin, target_location_list, graphreader,
-                                               mode_costing, mode, max_matrix_distance);
-      many_to_many.insert(many_to_many.end(), td.begin(), td.end());
-      Clear();
-    }
+    const float max_matrix_distance,
+    const row_callback_t& on_row) {
+  // Set the destinations up once, each search gets a copy of them
+  mode_ = mode;
+  costing_ = mode_costing[static_cast<uint32_t>(mode_)];
+  current_cost_threshold_ = GetCostThreshold(max_matrix_distance);
+  const bool one_to_many = source_location_list.size() <= target_location_list.size();
+  const auto& origins = one_to_many ? source_location_list : target_location_list;
+  const auto& locations = one_to_many ? target_location_list : source_location_list;
+  if (one_to_many) {
+    SetDestinations(graphreader, locations);
+  } else {
+    SetDestinationsManyToOne(graphreader, locations);
+  }
+
+  const uint32_t slots = workers_ ? workers_->size() : 1;
+  while (searches_.size() < slots) {
+    searches_.emplace_back(new TimeDistanceMatrix);
+  }
+  for (auto& search : searches_) {
+    search->mode_ = mode_;
+    search->costing_ = costing_;
+    *search->dest_edges_ = *dest_edges_;
+  }
+
+  // Run a series of one to many calls and concatenate the results. The rows of one to many
+  // searches can be handed over as soon as all of the ones before them are done
+  std::vector<std::vector<TimeDistance>> results(origins.size());
+  std::vector<bool> done(origins.size(), false);
+  uint32_t next_row = 0;
+  std::mutex row_mutex;
+  auto step = [&](uint32_t i, uint32_t slot, GraphReader& reader) {
+    auto& search = *searches_[slot];
+    search.destinations_ = destinations_;
+    search.current_cost_threshold_ = current_cost_threshold_;
+    results[i] = one_to_many ? search.SearchOneToMany(origins.Get(i), locations, reader)
+                             : search.SearchManyToOne(origins.Get(i), locations, reader);
+    search.ClearSearch();
+    if (!on_row || !one_to_many) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(row_mutex);
+    for (done[i] = true; next_row < done.size() && done[next_row]; ++next_row) {
+      on_row(next_row, results[next_row].data());
+      std::vector<TimeDistance>().swap(results[next_row]);
+    }
+  };
+  if (workers_) {
+    workers_->Run(origins.size(), graphreader, step);
   } else {
-    for (const auto& destination : target_location_list) {
-      std::vector<TimeDistance> td = ManyToOne(destination, source_location_list, graphreader,
-                                               mode_costing, mode, max_matrix_distance);
-      many_to_many.insert(many_to_many.end(), td.begin(), td.end());
-      Clear();
+    for (int i = 0; i < origins.size(); ++i) {
+      step(i, 0, graphreader);
+    }
+  }
+
+  Clear();
+  if (on_row && one_to_many) {
+    return {};
+  }
+
+  std::vector<TimeDistance> many_to_many;
+  many_to_many.reserve(source_location_list.size() * target_location_list.size());
+  for (const auto& td : results) {
+    many_to_many.insert(many_to_many.end(), td.begin(), td.end());
+  }
+  if (on_row) {
+    for (int i = 0; i < source_location_list.size(); ++i) {
+      on_row(i, many_to_many.data() + i * target_location_list.size());
     }
+    return {};
   }
   return many_to_many;
 }
@@ -578,7 +668,7 @@ void TimeDistanceMatrix::SetDestinations(
 
       // Mark the edge as having a destination on it and add the
       // destination index
-      dest_edges_[edge.graph_id()].push_back(idx);
+      (*dest_edges_)[edge.graph_id()].push_back(idx);
     }
     idx++;
   }
@@ -624,7 +714,7 @@ void TimeDistanceMatrix::SetDestinationsManyToOne(
 
       // Mark the edge as having a destination on it and add the
       // destination index
-      dest_edges_[opp_edge_id].push_back(idx);
+      (*dest_edges_)[opp_edge_id].push_back(idx);
     }
     idx++;
   }
@@ -225,8 +225,8 @@ thor_worker_t::map_match(Api& request) {
         auto* pe = options.mutable_shape(i)->mutable_path_edges()->Add();
         pe->mutable_ll()->set_lat(match.lnglat.lat());
         pe->mutable_ll()->set_lng(match.lnglat.lng());
-        for (const auto& n : reader->edgeinfo(match.edgeid).GetNames()) {
-          pe->mutable_names()->Add()->assign(n);
+        for (const auto& n : reader->edgeinfo(match.edgeid).GetNameViews()) {
+          pe->mutable_names()->Add()->assign(n.data(), n.size());
         }
 
         // signal how many edge candidates there were at this stateid by adding empty path edges
@@ -0,0 +1,72 @@
+#include "thor/transit_timetable.h"
+
+#include <algorithm>
+
+using namespace valhalla::baldr;
+
+namespace valhalla {
+namespace thor {
+
+void TransitTimetable::Reset(const uint32_t day,
+                             const uint32_t dow,
+                             const bool date_before_tile,
+                             const bool wheelchair,
+                             const bool bicycle) {
+  day_ = day;
+  dow_ = dow;
+  date_before_tile_ = date_before_tile;
+  wheelchair_ = wheelchair;
+  bicycle_ = bicycle;
+  lines_.clear();
+}
+
+const TransitDeparture* TransitTimetable::GetNextDeparture(const graph_tile_ptr& tile,
+                                                           const uint32_t lineid,
+                                                           const uint32_t current_time) {
+  const auto& departures = Line(tile, lineid);
+  auto next = std::lower_bound(departures.begin(), departures.end(), current_time,
+                               [](const TransitDeparture& departure, const uint32_t time) {
+                                 return departure.departure_time() < time;
+                               });
+  return next == departures.end() ? nullptr : &*next;
+}
+
+const std::vector<TransitDeparture>& TransitTimetable::Line(const graph_tile_ptr& tile,
+                                                            const uint32_t lineid) {
+  GraphId key(tile->id().tileid(), tile->id().level(), lineid);
+  auto found = lines_.find(key);
+  if (found != lines_.end()) {
+    return found->second;
+  }
+
+  // Keep the departures which run on the day and which the costing can take
+  std::vector<TransitDeparture> departures;
+  for (const auto& d : tile->GetLineDepartures(lineid)) {
+    if (!tile->GetTransitSchedule(d.schedule_index())->IsValid(day_, dow_, date_before_tile_) ||
+        (wheelchair_ && !d.wheelchair_accessible()) || (bicycle_ && !d.bicycle_accessible())) {
+      continue;
+    }
+    if (d.type() == kFixedSchedule) {
+      departures.push_back(d);
+      continue;
+    }
+    // A frequency based departure runs every so often until its end time
+    for (uint32_t time = d.departure_time(); time < d.end_time(); time += d.frequency()) {
+      departures.emplace_back(d.lineid(), d.tripid(), d.routeid(), d.blockid(), d.headsign_offset(),
+                              time, d.end_time(), d.frequency(), d.elapsed_time(),
+                              d.schedule_index(), d.wheelchair_accessible(),
+                              d.bicycle_accessible());
+      if (d.frequency() == 0) {
+        break;
+      }
+    }
+  }
+  std::stable_sort(departures.begin(), departures.end(),
+                   [](const TransitDeparture& a, const TransitDeparture& b) {
+                     return a.departure_time() < b.departure_time();
+                   });
+  return lines_.emplace(key, std::move(departures)).first->second;
+}
+
+} // namespace thor
+} // namespace valhalla
@@ -18,6 +18,7 @@
 #include "midgard/encoded.h"
 #include "midgard/logging.h"
 #include "midgard/pointll.h"
+#include "midgard/tracing.h"
 #include "midgard/util.h"
 #include "proto/tripcommon.pb.h"
 #include "sif/costconstants.h"
@@ -34,12 +35,25 @@ using namespace valhalla::thor;
 
 namespace {
 
+// The admins of a leg by the tile and the index of the admin within it, so that the admin info
+// with its strings is only made and hashed the first time a tile's admin is seen along the leg
+using AdminTileIndex = std::unordered_map<uint64_t, uint32_t>;
+
 uint32_t
-GetAdminIndex(const AdminInfo& admin_info,
+GetAdminIndex(const graph_tile_ptr& tile,
+              const uint32_t tile_admin_index,
+              AdminTileIndex& admin_tile_index,
               std::unordered_map<AdminInfo, uint32_t, AdminInfo::AdminInfoHasher>& admin_info_map,
               std::vector<AdminInfo>& admin_info_list) {
+  const uint64_t key =
+      (static_cast<uint64_t>(tile->header()->graphid().tile_value()) << 32) | tile_admin_index;
+  auto indexed = admin_tile_index.find(key);
+  if (indexed != admin_tile_index.end()) {
+    return indexed->second;
+  }
 
   uint32_t admin_index = 0;
+  const AdminInfo admin_info = tile->admininfo(tile_admin_index);
   auto existing_admin = admin_info_map.find(admin_info);
 
   // If admin was not processed yet
@@ -58,6 +72,7 @@ GetAdminIndex(const AdminInfo& admin_info,
   else {
     admin_index = existing_admin->second;
   }
+  admin_tile_index.emplace(key, admin_index);
   return admin_index;
 }
 
@@ -102,34 +117,43 @@ inline std::string country_code_from_edge(const graph_tile_ptr& tile,
   return tile->admininfo(tile->node(de.endnode())->admin_index()).country_iso();
 }
 
+// Where each incident of the leg is in its list of incidents by the id of the incident
+using IncidentIndex = std::unordered_map<uint64_t, int>;
+
 /**
- * Used to add or update incidents attached to the provided leg. We could do something more exotic to
- * avoid linear scan, like keeping a separate lookup outside of the pbf
+ * Used to add or update incidents attached to the provided leg. The incidents already on the leg
+ * are found by their id in the index rather than by scanning the leg for them
  * @param leg        the leg to update
  * @param incident   the incident that applies
  * @param index      what shape index of the leg the index apples to
+ * @param incident_index  where the incidents are in the leg by their id
  */
 void UpdateIncident(const std::shared_ptr<const valhalla::IncidentsTile>& incidents_tile,
                     TripLeg& leg,
                     const valhalla::IncidentsTile::Location* incident_location,
                     uint32_t index,
                     const graph_tile_ptr& tile,
-                    const valhalla::baldr::DirectedEdge& de) {
-  const uint64_t current_incident_id =
-      valhalla::baldr::getIncidentMetadata(incidents_tile, *incident_location).id();
-  auto found = std::find_if(leg.mutable_incidents()->begin(), leg.mutable_incidents()->end(),
-                            [current_incident_id](const TripLeg::Incident& candidate) {
-                              return current_incident_id == candidate.metadata().id();
-                            });
-  // Are we continuing an incident (this could be a hash look up)
-  if (found != leg.mutable_incidents()->end()) {
-    found->set_end_shape_index(index);
+                    const valhalla::baldr::DirectedEdge& de,
+                    IncidentIndex& incident_index) {
+  const auto& meta = valhalla::baldr::getIncidentMetadata(incidents_tile, *incident_location);
+  const uint64_t current_incident_id = meta.id();
+  // the leg may have come with incidents the index doesnt know about yet
+  if (incident_index.size() != static_cast<size_t>(leg.incidents_size())) {
+    incident_index.clear();
+    for (int i = 0; i < leg.incidents_size(); ++i) {
+      incident_index.emplace(leg.incidents(i).metadata().id(), i);
+    }
+  }
+  auto found = incident_index.find(current_incident_id);
+  // Are we continuing an incident
+  if (found != incident_index.end()) {
+    leg.mutable_incidents(found->second)->set_end_shape_index(index);
   } // We are starting a new incident
   else {
+    incident_index.emplace(current_incident_id, leg.incidents_size());
     auto* new_incident = leg.mutable_incidents()->Add();
 
     // Get the full incident metadata from the incident-tile
-    const auto& meta = valhalla::baldr::getIncidentMetadata(incidents_tile, *incident_location);
     *new_incident->mutable_metadata() = meta;
 
     // Set iso country code (2 & 3 char codes) on the new incident obj created for this leg
@@ -173,6 +197,7 @@ valhalla::TripLeg_Closure* fetch_or_create_closure_annotation(TripLeg& leg) {
  * @param edge_seconds
  * @param cut_for_traffic
  * @param incidents
+ * @param incident_index
  */
 void SetShapeAttributes(const AttributesController& controller,
                         const graph_tile_ptr& tile,
@@ -184,7 +209,8 @@ void SetShapeAttributes(const AttributesController& controller,
                         double tgt_pct,
                         double edge_seconds,
                         bool cut_for_traffic,
-                        const valhalla::baldr::IncidentResult& incidents) {
+                        const valhalla::baldr::IncidentResult& incidents,
+                        IncidentIndex& incident_index) {
   // TODO: if this is a transit edge then the costing will throw
 
   // bail if nothing to do
@@ -265,7 +291,7 @@ void SetShapeAttributes(const AttributesController& controller,
       // if this is clipped at the beginning of the edge then its not a new cut but we still need to
       // attach the incidents information to the leg
       if (offset == src_pct) {
-        UpdateIncident(incidents.tile, leg, &incident, shape_begin, tile, *edge);
+        UpdateIncident(incidents.tile, leg, &incident, shape_begin, tile, *edge, incident_index);
         continue;
       }
 
@@ -313,6 +339,38 @@ void SetShapeAttributes(const AttributesController& controller,
         leg.shape_attributes().speed_limit_size() + shape.size() + cuts.size());
   }
 
+  // The elevation of the shape points comes from the tile, they are kept in the order of the shape
+  // so we interpolate them by how far along the shape of the edge we are
+  std::vector<float> elevation;
+  std::vector<double> elevation_along;
+  if (controller.attributes.at(kShapeAttributesElevation)) {
+    leg.mutable_shape_attributes()->mutable_elevation()->Reserve(
+        leg.shape_attributes().elevation_size() + shape.size() + cuts.size());
+    elevation = edgeinfo.elevation();
+    const auto& edge_shape = edgeinfo.shape();
+    if (elevation.size() == edge_shape.size() && edge_shape.size() > 1) {
+      elevation_along.push_back(0);
+      for (size_t i = 1; i < edge_shape.size(); ++i) {
+        elevation_along.push_back(elevation_along.back() +
+                                  edge_shape[i - 1].Distance(edge_shape[i]));
+      }
+    } else {
+      elevation.clear();
+    }
+  }
+  auto elevation_at = [&elevation, &elevation_along, edge](double percent_along) -> float {
+    if (elevation.empty()) {
+      return kNoElevationData;
+    }
+    double along = (edge->forward() ? percent_along : 1 - percent_along) * elevation_along.back();
+    auto next = std::upper_bound(elevation_along.begin() + 1, elevation_along.end() - 1, along);
+    auto i = next - elevation_along.begin();
+    auto length = elevation_along[i] - elevation_along[i - 1];
+    double coef = length > 0 ? std::min(std::max((along - elevation_along[i - 1]) / length, 0.), 1.)
+                             : 0.;
+    return elevation[i - 1] + (elevation[i] - elevation[i - 1]) * coef;
+  };
+
   // Set the shape attributes
   for (auto i = shape_begin + 1; i < shape.size(); ++i) {
     // when speed changes we need to make a new shape point and continue from there
@@ -381,10 +439,15 @@ void SetShapeAttributes(const AttributesController& controller,
       leg.mutable_shape_attributes()->add_speed_limit(edgeinfo.speed_limit());
     }
 
+    // Set the elevation at the end of the segment if requested
+    if (controller.attributes.at(kShapeAttributesElevation)) {
+      leg.mutable_shape_attributes()->add_elevation(elevation_at(distance_total_pct));
+    }
+
     // Set the incidents if we just cut or we are at the end
     if ((shift || i == shape.size() - 1) && !cut_itr->incidents.empty()) {
       for (const auto* incident : cut_itr->incidents) {
-        UpdateIncident(incidents.tile, leg, incident, i, tile, *edge);
+        UpdateIncident(incidents.tile, leg, incident, i, tile, *edge, incident_index);
       }
     }
 
@@ -779,6 +842,7 @@ void AddIntersectingEdges(const AttributesController& controller,
  * @param  start_node_idx     The start node index
  * @param  has_junction_name  True if named junction exists, false otherwise
  * @param  start_tile         The start tile of the start node
+ * @param  add_signs          True if any of the sign attributes are enabled
  *
  */
 TripLeg_Edge* AddTripEdge(const AttributesController& controller,
@@ -796,7 +860,8 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
                           const uint32_t start_node_idx,
                           const bool has_junction_name,
                           const graph_tile_ptr& start_tile,
-                          const uint8_t restrictions_idx) {
+                          const uint8_t restrictions_idx,
+                          const bool add_signs) {
 
   // Index of the directed edge within the tile
   uint32_t idx = edge.id();
@@ -833,7 +898,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
 #endif
 
   // Set the signs (if the directed edge has sign information) and if requested
-  if (directededge->sign()) {
+  if (directededge->sign() && add_signs) {
     // Add the edge signs
     std::vector<SignInfo> edge_signs = graphtile->GetSigns(idx);
     if (!edge_signs.empty()) {
@@ -843,7 +908,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
   }
 
   // Process the named junctions at nodes
-  if (has_junction_name && start_tile) {
+  if (has_junction_name && start_tile && controller.attributes.at(kEdgeSignJunctionName)) {
     // Add the node signs
     std::vector<SignInfo> node_signs = start_tile->GetSigns(start_node_idx, true);
     if (!node_signs.empty()) {
@@ -1272,46 +1337,58 @@ void AccumulateRecostingInfoForward(const valhalla::Options& options,
     return edge_id;
   };
 
+  // get all of the costings
+  sif::CostFactory factory;
+  std::vector<sif::cost_ptr_t> costings;
+  std::vector<const sif::DynamicCost*> costing_ptrs;
+  for (const auto& recosting : options.recostings()) {
+    costings.emplace_back(factory.Create(recosting));
+    costing_ptrs.push_back(costings.back().get());
+  }
+
+  // every node gets an entry for each recosting, with no elapsed time yet at the start of the leg
+  for (auto& node : *leg.mutable_node()) {
+    for (size_t i = 0; i < costings.size(); ++i) {
+      node.mutable_recosts()->Add();
+    }
+  }
+  for (auto& recost : *leg.mutable_node(0)->mutable_recosts()) {
+    recost.mutable_elapsed_cost()->set_seconds(0);
+    recost.mutable_elapsed_cost()->set_cost(0);
+  }
+
   // setup a callback for the recosting to tell us about the new label each made
-  auto out_itr = leg.mutable_node()->begin();
-  sif::LabelCallback label_cb = [&out_itr](const sif::EdgeLabel& label) -> void {
+  std::vector<int> positions(costings.size(), 0);
+  sif::CostingLabelCallback label_cb = [&leg, &positions](size_t costing,
+                                                          const sif::EdgeLabel& label) -> void {
     // get the turn cost at this node
-    out_itr->mutable_recosts()->rbegin()->mutable_transition_cost()->set_seconds(
-        label.transition_cost().secs);
-    out_itr->mutable_recosts()->rbegin()->mutable_transition_cost()->set_cost(
-        label.transition_cost().cost);
+    auto& position = positions[costing];
+    auto* recost = leg.mutable_node(position)->mutable_recosts(costing);
+    recost->mutable_transition_cost()->set_seconds(label.transition_cost().secs);
+    recost->mutable_transition_cost()->set_cost(label.transition_cost().cost);
     // get the elapsed time at the end of this labels edge and hang it on the next node
-    ++out_itr;
-    out_itr->mutable_recosts()->Add()->mutable_elapsed_cost()->set_seconds(label.cost().secs);
-    out_itr->mutable_recosts()->rbegin()->mutable_elapsed_cost()->set_cost(label.cost().cost);
+    recost = leg.mutable_node(++position)->mutable_recosts(costing);
+    recost->mutable_elapsed_cost()->set_seconds(label.cost().secs);
+    recost->mutable_elapsed_cost()->set_cost(label.cost().cost);
   };
 
-  // do each recosting
-  sif::CostFactory factory;
-  for (const auto& recosting : options.recostings()) {
-    // get the costing
-    auto costing = factory.Create(recosting);
-    // reset to the beginning of the route
-    in_itr = leg.node().begin();
-    out_itr = leg.mutable_node()->begin();
-    // no elapsed time yet at the start of the leg
-    out_itr->mutable_recosts()->Add()->mutable_elapsed_cost()->set_seconds(0);
-    out_itr->mutable_recosts()->rbegin()->mutable_elapsed_cost()->set_cost(0);
-    // do the recosting for this costing
-    try {
-      sif::recost_forward(reader, *costing, edge_cb, label_cb, src_pct, tgt_pct, time_info,
-                          invariant);
-      // no turn cost at the end of the leg
-      out_itr->mutable_recosts()->rbegin()->mutable_transition_cost()->set_seconds(0);
-      out_itr->mutable_recosts()->rbegin()->mutable_transition_cost()->set_cost(0);
+  // do all the recostings in one walk along the path
+  std::vector<bool> recosted(costings.size(), false);
+  try {
+    recosted = sif::recost_forward(reader, costing_ptrs, edge_cb, label_cb, src_pct, tgt_pct,
+                                   time_info, invariant);
+  } catch (...) {}
+
+  for (size_t i = 0; i < costings.size(); ++i) {
+    // no turn cost at the end of the leg
+    if (recosted[i]) {
+      auto* recost = leg.mutable_node(positions[i])->mutable_recosts(i);
+      recost->mutable_transition_cost()->set_seconds(0);
+      recost->mutable_transition_cost()->set_cost(0);
     } // couldnt be recosted (difference in access for example) so we fill it with nulls to show this
-    catch (...) {
-      int should_have = leg.node(0).recosts_size();
+    else {
       for (auto& node : *leg.mutable_node()) {
-        if (node.recosts_size() == should_have) {
-          node.mutable_recosts()->RemoveLast();
-        }
-        node.mutable_recosts()->Add();
+        node.mutable_recosts(i)->Clear();
       }
     }
   }
@@ -1336,6 +1413,8 @@ void TripLegBuilder::Build(
     const std::vector<std::string>& algorithms,
     const std::function<void()>* interrupt_callback,
     std::unordered_map<size_t, std::pair<EdgeTrimmingInfo, EdgeTrimmingInfo>>* edge_trimming) {
+  VALHALLA_TRACE_SPAN("TripLegBuilder::Build");
+
   // Test interrupt prior to building trip path
   if (interrupt_callback) {
     (*interrupt_callback)();
@@ -1351,8 +1430,7 @@ void TripLegBuilder::Build(
   auto* tp_dest = trip_path.mutable_location(trip_path.location_size() - 1);
 
   // Keep track of the time
-  baldr::DateTime::tz_sys_info_cache_t tz_cache;
-  const auto forward_time_info = baldr::TimeInfo::make(origin, graphreader, &tz_cache);
+  const auto forward_time_info = baldr::TimeInfo::make(origin, graphreader);
 
   // check if we should use static time or offset time as the path lengthens
   const bool invariant =
@@ -1428,9 +1506,17 @@ void TripLegBuilder::Build(
     tp_dest->set_side_of_street(GetTripLegSideOfStreet(end_sos));
   }
 
+  // Skip the parts of the leg which none of the attributes ask for, intersecting edges mean looking
+  // at every edge of every node and the tiles of the nodes on the other levels
+  const bool add_signs = controller.category_attribute_enabled(kEdgeSignCategory);
+  const bool add_intersecting_edges =
+      controller.category_attribute_enabled(kNodeIntersectingEdgeCategory);
+
   // Structures to process admins
   std::unordered_map<AdminInfo, uint32_t, AdminInfo::AdminInfoHasher> admin_info_map;
   std::vector<AdminInfo> admin_info_list;
+  AdminTileIndex admin_tile_index;
+  IncidentIndex incident_index;
 
   // Iterate through path
   uint32_t prior_opp_local_index = -1;
@@ -1506,8 +1592,8 @@ void TripLegBuilder::Build(
 
     // Assign the admin index
     if (controller.attributes.at(kNodeAdminIndex)) {
-      trip_node->set_admin_index(
-          GetAdminIndex(start_tile->admininfo(node->admin_index()), admin_info_map, admin_info_list));
+      trip_node->set_admin_index(GetAdminIndex(start_tile, node->admin_index(), admin_tile_index,
+                                               admin_info_map, admin_info_list));
     }
 
     if (controller.attributes.at(kNodeTimeZone)) {
@@ -1532,7 +1618,7 @@ void TripLegBuilder::Build(
         AddTripEdge(controller, edge, edge_itr->trip_id, multimodal_builder.block_id, mode,
                     travel_type, costing, directededge, node->drive_on_right(), trip_node, graphtile,
                     time_info.second_of_week, startnode.id(), node->named_intersection(), start_tile,
-                    edge_itr->restriction_index);
+                    edge_itr->restriction_index, add_signs);
 
     // some information regarding shape/length trimming
     float trim_start_pct = is_first_edge ? start_pct : 0;
@@ -1647,7 +1733,7 @@ void TripLegBuilder::Build(
 
     SetShapeAttributes(controller, graphtile, directededge, trip_shape, begin_index, trip_path,
                        trim_start_pct, trim_end_pct, edge_seconds,
-                       costing->flow_mask() & kCurrentFlowMask, incidents);
+                       costing->flow_mask() & kCurrentFlowMask, incidents, incident_index);
 
     // Set begin shape index if requested
     if (controller.attributes.at(kEdgeBeginShapeIndex)) {
@@ -1665,7 +1751,7 @@ void TripLegBuilder::Build(
 
     // Add the intersecting edges at the node. Skip it if the node was an inner node (excluding start
     // node and end node) of a shortcut that was recovered.
-    if (startnode.Is_Valid() && !edge_itr->start_node_is_recovered) {
+    if (add_intersecting_edges && startnode.Is_Valid() && !edge_itr->start_node_is_recovered) {
       AddIntersectingEdges(controller, start_tile, node, directededge, prev_de, prior_opp_local_index,
                            graphreader, trip_node);
     }
@@ -1676,7 +1762,7 @@ void TripLegBuilder::Build(
     startnode = directededge->endnode();
 
     // Save the opposing edge as the previous DirectedEdge (for name consistency)
-    if (!directededge->IsTransitLine()) {
+    if (add_intersecting_edges && !directededge->IsTransitLine()) {
       graph_tile_ptr t2 =
           directededge->leaves_tile() ? graphreader.GetGraphTile(directededge->endnode()) : graphtile;
       if (t2 == nullptr) {
@@ -1697,9 +1783,8 @@ void TripLegBuilder::Build(
     if (last_tile == nullptr) {
       throw tile_gone_error_t("TripLegBuilder::Build failed", startnode);
     }
-    node->set_admin_index(
-        GetAdminIndex(last_tile->admininfo(last_tile->node(startnode)->admin_index()), admin_info_map,
-                      admin_info_list));
+    node->set_admin_index(GetAdminIndex(last_tile, last_tile->node(startnode)->admin_index(),
+                                        admin_tile_index, admin_info_map, admin_info_list));
   }
   if (controller.attributes.at(kNodeElapsedTime)) {
     node->mutable_cost()->mutable_elapsed_cost()->set_seconds(std::prev(path_end)->elapsed_cost.secs);
@@ -3,6 +3,7 @@
 #include "baldr/graphconstants.h"
 #include "midgard/constants.h"
 #include "midgard/logging.h"
+#include "midgard/tracing.h"
 #include <algorithm>
 
 using namespace valhalla::baldr;
@@ -23,7 +24,8 @@ UnidirectionalAStar<expansion_direction, FORWARD>::UnidirectionalAStar(
       mode_(TravelMode::kDrive), travel_type_(0),
       max_reserved_labels_count_(
           config.get<uint32_t>("max_reserved_labels_count", kInitialEdgeLabelCount)),
-      access_mode_{kAutoAccess} {
+      access_mode_{kAutoAccess},
+      overflow_bucket_count_(config.get<uint32_t>("overflow_bucket_count", 0)) {
 }
 
 // Default constructor
@@ -88,7 +90,8 @@ bool UnidirectionalAStar<expansion_direction, FORWARD>::Expand(GraphReader& grap
     pred.set_deadend(true);
     return opp_edge && ExpandInner(graphreader, pred, opp_pred_edge, nodeinfo, pred_idx,
                                    {opp_edge, opp_edge_id, edgestatus_.GetPtr(opp_edge_id, tile)},
-                                   tile, offset_time, destination, best_path);
+                                   tile, offset_time, destination, best_path,
+                                   AStarHeuristic::kUnknownDistance);
   }
 
   // Expand from <expansion_direction> node.
@@ -96,6 +99,11 @@ bool UnidirectionalAStar<expansion_direction, FORWARD>::Expand(GraphReader& grap
 
   bool disable_uturn = false;
   EdgeMetadata uturn_meta{};
+  float uturn_dist = AStarHeuristic::kUnknownDistance;
+
+  // The distances to the destination of the end nodes of all the edges at once
+  float end_node_dists[kMaxEdgesPerNode];
+  astarheuristic_.GetDistances(*tile, meta.edge, nodeinfo->edge_count(), end_node_dists);
 
   for (uint32_t i = 0; i < nodeinfo->edge_count(); ++i, ++meta) {
 
@@ -104,11 +112,12 @@ bool UnidirectionalAStar<expansion_direction, FORWARD>::Expand(GraphReader& grap
     // this edge until last. If any other edges were emplaced, it means we should not
     // even try to evaluate a u-turn since u-turns should only happen for deadends
     uturn_meta = pred.opp_local_idx() == meta.edge->localedgeidx() ? meta : uturn_meta;
+    uturn_dist = pred.opp_local_idx() == meta.edge->localedgeidx() ? end_node_dists[i] : uturn_dist;
 
     // Expand but only if this isnt the uturn, we'll try that later if nothing else works out
     disable_uturn = (pred.opp_local_idx() != meta.edge->localedgeidx() &&
                      ExpandInner(graphreader, pred, opp_pred_edge, nodeinfo, pred_idx, meta, tile,
-                                 offset_time, destination, best_path)) ||
+                                 offset_time, destination, best_path, end_node_dists[i])) ||
                     disable_uturn;
   }
 
@@ -129,10 +138,13 @@ bool UnidirectionalAStar<expansion_direction, FORWARD>::Expand(GraphReader& grap
       const auto* trans_node = trans_tile->node(trans->endnode());
       EdgeMetadata trans_meta =
           EdgeMetadata::make(trans->endnode(), trans_node, trans_tile, edgestatus_);
+      astarheuristic_.GetDistances(*trans_tile, trans_meta.edge, trans_node->edge_count(),
+                                   end_node_dists);
       // expand the edges from this node at this level
       for (uint32_t i = 0; i < trans_node->edge_count(); ++i, ++trans_meta) {
         disable_uturn = ExpandInner(graphreader, pred, opp_pred_edge, trans_node, pred_idx,
-                                    trans_meta, trans_tile, offset_time, destination, best_path) ||
+                                    trans_meta, trans_tile, offset_time, destination, best_path,
+                                    end_node_dists[i]) ||
                         disable_uturn;
       }
     }
@@ -150,7 +162,7 @@ bool UnidirectionalAStar<expansion_direction, FORWARD>::Expand(GraphReader& grap
 
     // We didn't add any shortcut of the uturn, therefore evaluate the regular uturn instead
     disable_uturn = ExpandInner(graphreader, pred, opp_pred_edge, nodeinfo, pred_idx, uturn_meta,
-                                tile, offset_time, destination, best_path) ||
+                                tile, offset_time, destination, best_path, uturn_dist) ||
                     disable_uturn;
   }
 
@@ -173,7 +185,8 @@ inline bool UnidirectionalAStar<expansion_direction, FORWARD>::ExpandInner(
     const graph_tile_ptr& tile,
     const TimeInfo& time_info,
     const valhalla::Location& destination,
-    std::pair<int32_t, float>& best_path) {
+    std::pair<int32_t, float>& best_path,
+    float end_node_dist) {
 
   // Skip shortcut edges for time dependent routes
   // TODO(danpat): why?
@@ -203,7 +216,7 @@ inline bool UnidirectionalAStar<expansion_direction, FORWARD>::ExpandInner(
     if (t2 == nullptr) {
       return false;
     }
-    opp_edge_id = t2->GetOpposingEdgeId(meta.edge);
+    opp_edge_id = tile->GetOpposingEdgeId(meta.edge, *t2);
     opp_edge = t2->directededge(opp_edge_id);
   }
 
@@ -289,12 +302,17 @@ inline bool UnidirectionalAStar<expansion_direction, FORWARD>::ExpandInner(
   float dist = 0.0f;
   float sortcost = newcost.cost;
   if (dest_edge == destinations_percent_along_.end()) {
-    graph_tile_ptr t2 =
-        meta.edge->leaves_tile() ? graphreader.GetGraphTile(meta.edge->endnode()) : tile;
-    if (t2 == nullptr) {
-      return false;
+    // The end node is in another tile so its distance was not found with the others
+    if (end_node_dist == AStarHeuristic::kUnknownDistance) {
+      graph_tile_ptr t2 =
+          meta.edge->leaves_tile() ? graphreader.GetGraphTile(meta.edge->endnode()) : tile;
+      if (t2 == nullptr) {
+        return false;
+      }
+      end_node_dist = astarheuristic_.GetDistance(t2->get_node_ll(meta.edge->endnode()));
     }
-    sortcost += astarheuristic_.Get(t2->get_node_ll(meta.edge->endnode()), dist);
+    dist = end_node_dist;
+    sortcost += astarheuristic_.Get(dist, meta.edge->endnode());
   }
 
   if (FORWARD) {
@@ -411,6 +429,8 @@ std::vector<std::vector<PathInfo>> UnidirectionalAStar<expansion_direction, FORW
     const sif::mode_costing_t& mode_costing,
     const TravelMode mode,
     const Options& /*options*/) {
+  VALHALLA_TRACE_SPAN("UnidirectionalAStar::GetBestPath");
+
   // Set the mode and costing
   mode_ = mode;
   costing_ = mode_costing[static_cast<uint32_t>(mode_)];
@@ -438,11 +458,12 @@ std::vector<std::vector<PathInfo>> UnidirectionalAStar<expansion_direction, FORW
   auto endpoint = FORWARD ? destination : origin;
 
   // Get time information for forward
-  auto time_info = TimeInfo::make(startpoint, graphreader, &tz_cache_);
+  auto time_info = TimeInfo::make(startpoint, graphreader);
 
   // Initialize the origin and destination locations. Initialize the
   // destination first in case the origin edge includes a destination edge.
   uint32_t density = SetDestination(graphreader, endpoint);
+  InitLandmarks(graphreader, endpoint);
   // Call SetOrigin with kFreeFlowSecondOfDay for now since we don't yet have
   // a timezone for converting a date_time of "current" to seconds_of_week
   SetOrigin(graphreader, startpoint, endpoint, time_info.second_of_week);
@@ -568,7 +589,7 @@ void UnidirectionalAStar<expansion_direction, FORWARD>::Init(const midgard::Poin
   // Set bucket size and cost range based on DynamicCost.
   uint32_t bucketsize = costing_->UnitSize();
   float range = kBucketCount * bucketsize;
-  adjacencylist_.reuse(mincost, range, bucketsize, &edgelabels_);
+  adjacencylist_.reuse(mincost, range, bucketsize, &edgelabels_, overflow_bucket_count_);
   edgestatus_.clear();
 
   // Get hierarchy limits from the costing. Get a copy since we increment
@@ -826,5 +847,26 @@ UnidirectionalAStar<expansion_direction, FORWARD>::SetDestination(GraphReader& g
   return density;
 }
 
+// Set the targets of the landmark lower bounds
+template <const ExpansionType expansion_direction, const bool FORWARD>
+void UnidirectionalAStar<expansion_direction, FORWARD>::InitLandmarks(
+    GraphReader& graphreader,
+    const valhalla::Location& dest) {
+  // Any path to a point along an edge passes through one of its ends, whichever way it goes
+  std::vector<GraphId> nodes;
+  for (const auto& edge : dest.path_edges()) {
+    GraphId edgeid(edge.graph_id());
+    graph_tile_ptr tile = graphreader.GetGraphTile(edgeid);
+    const DirectedEdge* opp_edge = graphreader.GetOpposingEdge(edgeid);
+    if (tile == nullptr || opp_edge == nullptr) {
+      nodes.clear();
+      break;
+    }
+    nodes.push_back(tile->directededge(edgeid)->endnode());
+    nodes.push_back(opp_edge->endnode());
+  }
+  astarheuristic_.InitLandmarks(nodes);
+}
+
 } // namespace thor
 } // namespace valhalla
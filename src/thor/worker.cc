@@ -1,11 +1,16 @@
+#include <algorithm>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "baldr/contractionhierarchy.h"
+#include "baldr/landmarks.h"
 #include "midgard/constants.h"
 #include "midgard/logging.h"
 #include "midgard/util.h"
@@ -48,6 +53,36 @@ const std::unordered_map<std::string, float> kMaxDistances = {
 // a scale factor to apply to the score so that we bias towards closer results more
 constexpr float kDistanceScale = 10.f;
 
+// The overlays are read only so all of the workers in the process share the one loaded from a file
+template <typename overlay_t>
+std::shared_ptr<const overlay_t> load_overlay(const std::string& file, const std::string& name) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::weak_ptr<const overlay_t>> loaded;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& cached = loaded[file];
+  auto overlay = cached.lock();
+  if (!overlay) {
+    try {
+      overlay = std::make_shared<const overlay_t>(file);
+      cached = overlay;
+      LOG_INFO("Loaded " + name + " with " + std::to_string(overlay->node_count()) + " nodes");
+    } catch (const std::exception& e) {
+      LOG_WARN("Routing without the " + name + ": " + e.what());
+    }
+  }
+  return overlay;
+}
+
+// The calling thread is one of the threads of a pool so only the others have to be started
+std::shared_ptr<MatrixWorkers> make_workers(const boost::property_tree::ptree& config,
+                                            const std::string& key) {
+  const auto thread_count = config.get<uint32_t>(key, 1);
+  if (thread_count < 2) {
+    return {};
+  }
+  return std::make_shared<MatrixWorkers>(thread_count - 1, config.get_child("mjolnir"));
+}
+
 #ifdef HAVE_HTTP
 std::string serialize_to_pbf(Api& request) {
   std::string buf;
@@ -70,12 +105,27 @@ thor_worker_t::thor_worker_t(const boost::property_tree::ptree& config,
     : mode(valhalla::sif::TravelMode::kPedestrian), bidir_astar(config.get_child("thor")),
       bss_astar(config.get_child("thor")), multi_modal_astar(config.get_child("thor")),
       timedep_forward(config.get_child("thor")), timedep_reverse(config.get_child("thor")),
-      isochrone_gen(config.get_child("thor")), matcher_factory(config, graph_reader),
-      reader(graph_reader), controller{} {
+      contraction_query(config.get_child("thor")),
+      route_workers(make_workers(config, "thor.route_threads")),
+      matrix_workers(make_workers(config, "thor.matrix_threads")),
+      cost_matrix(config.get_child("thor"), matrix_workers),
+      bucket_matrix(config.get_child("thor"), matrix_workers), time_distance_matrix(matrix_workers),
+      matrix_selector(config.get_child("thor")), isochrone_gen(config.get_child("thor")),
+      optimizer_matrix_cache(config.get<size_t>("thor.optimizer_matrix_cache_size", 0),
+                             config.get<uint32_t>("thor.optimizer_matrix_cache_minutes", 15)),
+      matcher_factory(config, graph_reader), reader(graph_reader), controller{},
+      centroid_gen(matrix_workers) {
   // If we weren't provided with a graph reader make our own
   if (!reader)
     reader = matcher_factory.graphreader();
 
+  // Load the tiles that were used the most before taking any requests
+  auto warm_file = config.get<std::string>("mjolnir.tile_warm_file", "");
+  if (!warm_file.empty()) {
+    reader->Warm(baldr::GraphReader::ReadTileUsage(warm_file),
+                 config.get<size_t>("mjolnir.tile_warm_threads", 1));
+  }
+
   // Select the matrix algorithm based on the conf file (defaults to
   // select_optimal if not present)
   auto conf_algorithm = config.get<std::string>("thor.source_to_target_algorithm", "select_optimal");
@@ -84,7 +134,7 @@ thor_worker_t::thor_worker_t(const boost::property_tree::ptree& config,
         kv.first == "max_radius" || kv.first == "max_timedep_distance" ||
         kv.first == "max_alternates" || kv.first == "max_exclude_polygons_length" ||
         kv.first == "skadi" || kv.first == "trace" || kv.first == "isochrone" ||
-        kv.first == "centroid") {
+        kv.first == "centroid" || kv.first == "request_timeout" || kv.first == "admission") {
       continue;
     }
 
@@ -96,12 +146,59 @@ thor_worker_t::thor_worker_t(const boost::property_tree::ptree& config,
     source_to_target_algorithm = TIME_DISTANCE_MATRIX;
   } else if (conf_algorithm == "costmatrix") {
     source_to_target_algorithm = COST_MATRIX;
+  } else if (conf_algorithm == "bucketmatrix") {
+    source_to_target_algorithm = BUCKET_MATRIX;
   } else {
     source_to_target_algorithm = SELECT_OPTIMAL;
   }
 
   max_timedep_distance =
       config.get<float>("service_limits.max_timedep_distance", kDefaultMaxTimeDependentDistance);
+  bidirectional_timedep = config.get<bool>("thor.bidirectional_timedep", false);
+
+  // Which solver orders the locations of optimized routes and how many tours the local search
+  // starts from
+  optimizer_algorithm =
+      ParseOptimizerAlgorithm(config.get<std::string>("thor.optimizer", "annealing"));
+  optimizer_restarts = std::max(config.get<uint32_t>("thor.optimizer_restarts", 8), 1u);
+
+  // The calling thread is one of the threads the contours are traced on
+  isochrone_threads = std::max(config.get<uint32_t>("thor.isochrone_threads", 1), 1u);
+
+  // Requests with the same costing options get copies of the same costing
+  factory.set_cache_size(config.get<size_t>("thor.costing_cache_size", 0));
+
+  // The heavy actions can be limited in how many of them the thor workers run at once
+  admission = admission_t::shared(config, "thor");
+
+  // Thor tags the requests to cache with the tiles they depend on and caches the matrices
+  response_cache = response_cache_t::shared(config);
+
+  // Route default auto requests over the contraction hierarchy if the tiles came with one and it is
+  // asked for. Its shortcuts only add up the costs of the edges, without turn costs, so its routes
+  // and times can be other than those of bidirectional a*
+  std::shared_ptr<const ContractionHierarchy> hierarchy;
+  auto contraction_hierarchy = config.get_optional<std::string>("mjolnir.contraction_hierarchy");
+  if (contraction_hierarchy && config.get<bool>("thor.contraction_hierarchy", false)) {
+    hierarchy = load_overlay<ContractionHierarchy>(*contraction_hierarchy, "contraction hierarchy");
+    contraction_query.set_hierarchy(hierarchy);
+  }
+
+  // Tighten the a* heuristic of the time dependent routes with landmarks if there are any
+  std::shared_ptr<const Landmarks> loaded;
+  auto landmarks = config.get_optional<std::string>("mjolnir.landmarks");
+  if (landmarks) {
+    loaded = load_overlay<Landmarks>(*landmarks, "landmarks");
+    timedep_forward.set_landmarks(loaded);
+    timedep_reverse.set_landmarks(loaded);
+  }
+
+  // Every route thread besides the calling one finds its legs with its own algorithms
+  for (uint32_t i = 1; route_workers && i < route_workers->size(); ++i) {
+    leg_algorithms.emplace_back(new leg_algorithms_t(config.get_child("thor")));
+    leg_algorithms.back()->contraction_query.set_hierarchy(hierarchy);
+    leg_algorithms.back()->timedep_forward.set_landmarks(loaded);
+  }
 }
 
 thor_worker_t::~thor_worker_t() {
@@ -116,7 +213,8 @@ thor_worker_t::work(const std::list<zmq::message_t>& job,
   // get request info
   auto& info = *static_cast<prime_server::http_request_info_t*>(request_info);
   LOG_INFO("Got Thor Request " + std::to_string(info.id));
-  Api request;
+  // the previous request and everything hanging off of it is freed at once here
+  auto& request = arena_request();
   try {
     // crack open the original request
     bool success = request.ParseFromArray(job.front().data(), job.front().size());
@@ -127,22 +225,33 @@ thor_worker_t::work(const std::list<zmq::message_t>& job,
     }
     const auto& options = request.options();
 
-    // Set the interrupt function
-    service_worker_t::set_interrupt(&interrupt_function);
+    // Set the interrupt function, it also gives up on the request once its deadline has passed
+    set_deadline_interrupt(request, &interrupt_function);
+    // Wait for a slot if the requests of the action are limited in how many run at once
+    auto admitted = admit(request, "thor_worker_t::");
 
     prime_server::worker_t::result_t result{true, {}, {}};
     // do request specific processing
     switch (options.action()) {
-      case Options::sources_to_targets:
-        result = to_response(matrix(request), info, request);
+      case Options::sources_to_targets: {
+        auto response = matrix(request);
+        if (response_cache) {
+          response_cache->insert(request, response);
+        }
+        result = to_response(response, info, request,
+                             options.format() == Options::pbf ? worker::PBF_MIME
+                                                              : worker::JSON_MIME);
         break;
+      }
       case Options::optimized_route: {
         optimized_route(request);
         result.messages.emplace_back(serialize_to_pbf(request));
         break;
       }
       case Options::isochrone:
-        result = to_response(isochrones(request), info, request);
+        result = to_response(isochrones(request), info, request,
+                             options.format() == Options::pbf ? worker::PBF_MIME
+                                                              : worker::JSON_MIME);
         break;
       case Options::route: {
         route(request);
@@ -199,13 +308,16 @@ void run_service(const boost::property_tree::ptree& config) {
 
   // listen for requests
   zmq::context_t context;
-  thor_worker_t thor_worker(config);
-  prime_server::worker_t worker(context, upstream_endpoint, downstream_endpoint, loopback_endpoint,
-                                interrupt_endpoint,
-                                std::bind(&thor_worker_t::work, std::ref(thor_worker),
-                                          std::placeholders::_1, std::placeholders::_2,
-                                          std::placeholders::_3),
-                                std::bind(&thor_worker_t::cleanup, std::ref(thor_worker)));
+  // a reloaded shared reader gets a new worker between requests
+  reloading_worker_t<thor_worker_t> thor_worker(
+      [&config]() { return new thor_worker_t(config, shared_graph_reader(config)); });
+  prime_server::worker_t worker(
+      context, upstream_endpoint, downstream_endpoint, loopback_endpoint, interrupt_endpoint,
+      [&thor_worker](const std::list<zmq::message_t>& job, void* request_info,
+                    const std::function<void()>& interrupt) {
+        return thor_worker.latest().work(job, request_info, interrupt);
+      },
+      [&thor_worker]() { thor_worker.current().cleanup(); });
   worker.work();
 
   // TODO: should we listen for SIGINT and terminate gracefully/exit(0)?
@@ -306,6 +418,12 @@ void thor_worker_t::parse_filter_attributes(const Api& request, bool is_strict_f
   controller = AttributesController();
   const auto& options = request.options();
 
+  // Without directions nothing makes maneuvers out of the trip, unless its handed back as is
+  if (options.directions_type() == DirectionsType::none && options.format() != Options::pbf &&
+      options.action() != Options::trace_attributes) {
+    controller.disable_guidance();
+  }
+
   if (options.has_filter_action()) {
     switch (options.filter_action()) {
       case (FilterAction::include): {
@@ -336,6 +454,22 @@ void thor_worker_t::cleanup() {
   timedep_reverse.Clear();
   multi_modal_astar.Clear();
   bss_astar.Clear();
+  contraction_query.Clear();
+  cost_matrix.Clear();
+  bucket_matrix.Clear();
+  time_distance_matrix.Clear();
+  time_distance_bss_matrix.Clear();
+  for (auto& algorithms : leg_algorithms) {
+    algorithms->timedep_forward.Clear();
+    algorithms->bidir_astar.Clear();
+    algorithms->contraction_query.Clear();
+  }
+  if (route_workers) {
+    route_workers->Trim();
+  }
+  if (matrix_workers) {
+    matrix_workers->Trim();
+  }
   trace.clear();
   isochrone_gen.Clear();
   centroid_gen.Clear();
@@ -348,6 +482,11 @@ void thor_worker_t::cleanup() {
 void thor_worker_t::set_interrupt(const std::function<void()>* interrupt_function) {
   interrupt = interrupt_function;
   reader->SetInterrupt(interrupt);
+  // the searches which arent made per request check it themselves
+  cost_matrix.set_interrupt(interrupt);
+  bucket_matrix.set_interrupt(interrupt);
+  isochrone_gen.set_interrupt(interrupt);
+  centroid_gen.set_interrupt(interrupt);
 }
 } // namespace thor
 } // namespace valhalla
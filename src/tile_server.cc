@@ -3,6 +3,7 @@
 #include "valhalla/filesystem.h"
 
 #include "baldr/compression_utils.h"
+#include "worker.h"
 
 #include <prime_server/http_protocol.hpp>
 #include <prime_server/http_util.hpp>
@@ -17,31 +18,11 @@
 using namespace prime_server;
 
 namespace {
-std::string gzip(std::string& uncompressed) {
-  auto deflate_src = [&uncompressed](z_stream& s) {
-    s.next_in = static_cast<Byte*>(static_cast<void*>(&uncompressed[0]));
-    s.avail_in = static_cast<unsigned int>(uncompressed.size() * sizeof(std::string::value_type));
-    return Z_FINISH;
-  };
-
+std::string gzip(const std::string& uncompressed) {
   std::string compressed;
-  auto deflate_dst = [&compressed](z_stream& s) {
-    // if the whole buffer wasn't used we are done
-    auto size = compressed.size();
-    if (s.total_out < size)
-      compressed.resize(s.total_out);
-    // we need more space
-    else {
-      // set the pointer to the next spot
-      compressed.resize(size + 16);
-      s.next_out = static_cast<Byte*>(static_cast<void*>(&compressed[0] + size));
-      s.avail_out = 16;
-    }
-  };
-
-  if (!valhalla::baldr::deflate(deflate_src, deflate_dst))
+  if (!valhalla::response_compressor_t::compress("gzip", Z_BEST_COMPRESSION, uncompressed,
+                                                 compressed))
     throw std::logic_error("Can't write gzipped string");
-
   return compressed;
 }
 
@@ -66,7 +47,8 @@ worker_t::result_t disk_work(const std::list<zmq::message_t>& job,
         http_request_t::from_string(static_cast<const char*>(job.front().data()), job.front().size());
 
     auto encoding_it = request.headers.find("Accept-Encoding");
-    auto gz = encoding_it != request.headers.end() && encoding_it->second == "gzip";
+    auto gz = encoding_it != request.headers.end() &&
+              encoding_it->second.find("gzip") != std::string::npos;
 
     auto path = extract_file_path_from_request(request.path);
     // load the file and gzip it if we have to
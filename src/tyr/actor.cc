@@ -1,10 +1,18 @@
 #include "tyr/actor.h"
 #include "baldr/rapidjson_utils.h"
 #include "loki/worker.h"
+#include "midgard/logging.h"
 #include "odin/worker.h"
 #include "thor/worker.h"
 #include "tyr/serializers.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 using namespace valhalla;
 using namespace valhalla::loki;
 using namespace valhalla::thor;
@@ -16,17 +24,44 @@ namespace tyr {
 struct actor_t::pimpl_t {
   pimpl_t(const boost::property_tree::ptree& config)
       : reader(new baldr::GraphReader(config.get_child("mjolnir"))), loki_worker(config, reader),
-        thor_worker(config, reader), odin_worker(config) {
+        thor_worker(config, reader), odin_worker(config),
+        locate_batch_size(
+            std::max<size_t>(1, config.get<size_t>("service_limits.locate.max_locations"))),
+        config(config),
+        trace_threads(std::max<size_t>(1, config.get<size_t>("thor.trace_threads", 1))),
+        batch_threads(config.get<size_t>("thor.batch_threads", 0)),
+        response_cache(response_cache_t::shared(config)),
+        region_router(region_router_t::make(config)),
+        response_compressor(response_compressor_t::make(config)) {
+    if (batch_threads == 0) {
+      batch_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
   }
   pimpl_t(const boost::property_tree::ptree& config, baldr::GraphReader& graph_reader)
       : reader(&graph_reader, [](baldr::GraphReader*) {}), loki_worker(config, reader),
-        thor_worker(config, reader), odin_worker(config) {
+        thor_worker(config, reader), odin_worker(config),
+        locate_batch_size(
+            std::max<size_t>(1, config.get<size_t>("service_limits.locate.max_locations"))),
+        config(config),
+        trace_threads(std::max<size_t>(1, config.get<size_t>("thor.trace_threads", 1))),
+        batch_threads(config.get<size_t>("thor.batch_threads", 0)),
+        response_cache(response_cache_t::shared(config)),
+        region_router(region_router_t::make(config)),
+        response_compressor(response_compressor_t::make(config)) {
+    if (batch_threads == 0) {
+      batch_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
   }
   void set_interrupts(const std::function<void()>* interrupt_function) {
     loki_worker.set_interrupt(interrupt_function);
     thor_worker.set_interrupt(interrupt_function);
     odin_worker.set_interrupt(interrupt_function);
   }
+  void set_interrupts(const std::function<void()>* interrupt_function, Api& request) {
+    loki_worker.set_deadline_interrupt(request, interrupt_function);
+    thor_worker.set_deadline_interrupt(request, interrupt_function);
+    odin_worker.set_deadline_interrupt(request, interrupt_function);
+  }
   void cleanup() {
     loki_worker.cleanup();
     thor_worker.cleanup();
@@ -36,6 +71,105 @@ struct actor_t::pimpl_t {
   loki::loki_worker_t loki_worker;
   thor::thor_worker_t thor_worker;
   odin_worker_t odin_worker;
+  size_t locate_batch_size;
+  boost::property_tree::ptree config;
+  size_t trace_threads;
+  size_t batch_threads;
+  // where the responses of routes and matrices are remembered, if anywhere
+  std::shared_ptr<response_cache_t> response_cache;
+  // which nodes answer the requests outside of the region of this one, if the cluster is split
+  std::shared_ptr<region_router_t> region_router;
+  // what the responses are compressed with for the clients accepting it, if anything
+  std::shared_ptr<response_compressor_t> response_compressor;
+  // the workers of the other threads of a batch, made the first time they are needed
+  std::vector<std::unique_ptr<pimpl_t>> batch_workers;
+
+  // answers count requests on thread_count threads, each taking the next request until there are
+  // none left. the calling thread uses our own workers and the other threads get their own, which
+  // share the candidate grids of the map matching and the graph reader if it is thread safe
+  void run(size_t count,
+           size_t thread_count,
+           bool auto_cleanup,
+           const std::function<void(pimpl_t&, size_t)>& answer) {
+    thread_count = std::min(thread_count, std::max<size_t>(1, count));
+    while (batch_workers.size() + 1 < thread_count) {
+      batch_workers.emplace_back(reader->ThreadSafe() ? new pimpl_t(config, *reader)
+                                                      : new pimpl_t(config));
+      batch_workers.back()->thor_worker.share_matcher_caches(thor_worker);
+    }
+    std::atomic<size_t> next{0};
+    auto work = [&](pimpl_t& workers) {
+      for (auto i = next++; i < count; i = next++) {
+        answer(workers, i);
+        // the workers of the other threads are not ours to clean up later so they always are
+        if (auto_cleanup || &workers != this) {
+          workers.cleanup();
+        }
+      }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i + 1 < thread_count; ++i) {
+      threads.emplace_back(work, std::ref(*batch_workers[i]));
+    }
+    work(*this);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  // runs every stage of a parsed request the same way the method of its action does
+  std::string act(Api& request) {
+    switch (request.options().action()) {
+      case Options::route:
+        loki_worker.route(request);
+        thor_worker.route(request);
+        odin_worker.narrate(request);
+        return tyr::serializeDirections(request);
+      case Options::locate:
+        return loki_worker.locate(request);
+      case Options::sources_to_targets:
+        loki_worker.matrix(request);
+        return thor_worker.matrix(request);
+      case Options::optimized_route:
+        loki_worker.matrix(request);
+        thor_worker.optimized_route(request);
+        odin_worker.narrate(request);
+        return tyr::serializeDirections(request);
+      case Options::isochrone:
+        loki_worker.isochrones(request);
+        return thor_worker.isochrones(request);
+      case Options::trace_route:
+        loki_worker.trace(request);
+        thor_worker.trace_route(request);
+        odin_worker.narrate(request);
+        return tyr::serializeDirections(request);
+      case Options::trace_attributes:
+        loki_worker.trace(request);
+        return thor_worker.trace_attributes(request);
+      case Options::height:
+        return loki_worker.height(request);
+      case Options::transit_available:
+        return loki_worker.transit_available(request);
+      case Options::tile:
+        return loki_worker.tile(request);
+      case Options::expansion:
+        loki_worker.route(request);
+        return thor_worker.expansion(request);
+      case Options::centroid:
+        loki_worker.route(request);
+        thor_worker.centroid(request);
+        odin_worker.narrate(request);
+        return tyr::serializeDirections(request);
+      case Options::status:
+        loki_worker.status(request);
+        thor_worker.status(request);
+        odin_worker.status(request);
+        return tyr::serializeStatus(request);
+      default:
+        loki_worker.check_action(request);
+        throw valhalla_exception_t{106};
+    }
+  }
 };
 
 actor_t::actor_t(const boost::property_tree::ptree& config, bool auto_cleanup)
@@ -53,11 +187,17 @@ void actor_t::cleanup() {
 
 std::string
 actor_t::route(const std::string& request_str, const std::function<void()>* interrupt, Api* api) {
-  // set the interrupts
-  pimpl->set_interrupts(interrupt);
   // parse the request
   Api request;
   ParseApi(request_str, Options::route, request);
+  // a route asked for before is cached unless the caller wants all of the request back
+  std::string bytes;
+  if (!api && pimpl->response_cache &&
+      pimpl->response_cache->find(request, *pimpl->reader, bytes)) {
+    return bytes;
+  }
+  // set the interrupts, they also give up on the request once its deadline has passed
+  pimpl->set_interrupts(interrupt, request);
   // check the request and locate the locations in the graph
   pimpl->loki_worker.route(request);
   // route between the locations in the graph to find the best path
@@ -65,7 +205,10 @@ actor_t::route(const std::string& request_str, const std::function<void()>* inte
   // get some directions back from them
   pimpl->odin_worker.narrate(request);
   // serialize them out to json string
-  auto bytes = tyr::serializeDirections(request);
+  bytes = tyr::serializeDirections(request);
+  if (pimpl->response_cache) {
+    pimpl->response_cache->insert(request, bytes);
+  }
   // if they want you do to do the cleanup automatically
   if (auto_cleanup) {
     cleanup();
@@ -79,11 +222,11 @@ actor_t::route(const std::string& request_str, const std::function<void()>* inte
 
 std::string
 actor_t::locate(const std::string& request_str, const std::function<void()>* interrupt, Api* api) {
-  // set the interrupts
-  pimpl->set_interrupts(interrupt);
   // parse the request
   Api request;
   ParseApi(request_str, Options::locate, request);
+  // set the interrupts, they also give up on the request once its deadline has passed
+  pimpl->set_interrupts(interrupt, request);
   // check the request and locate the locations in the graph
   auto json = pimpl->loki_worker.locate(request);
   // if they want you do to do the cleanup automatically
@@ -97,17 +240,85 @@ actor_t::locate(const std::string& request_str, const std::function<void()>* int
   return json;
 }
 
-std::string
-actor_t::matrix(const std::string& request_str, const std::function<void()>* interrupt, Api* api) {
+size_t actor_t::locate_batch(const std::string& request_str,
+                             std::istream& locations,
+                             const std::function<void(const std::string&)>& write,
+                             const std::function<void()>* interrupt) {
   // set the interrupts
   pimpl->set_interrupts(interrupt);
+  // the options every batch is parsed with
+  rapidjson::Document options;
+  options.Parse(request_str.empty() ? "{}" : request_str.c_str());
+  if (options.HasParseError() || !options.IsObject()) {
+    throw valhalla_exception_t{100};
+  }
+  options.RemoveMember("locations");
+
+  // each batch is a request of its own so only one of them is in memory at a time
+  size_t count = 0;
+  std::string line;
+  std::vector<std::string> batch;
+  auto locate_batch = [&]() {
+    rapidjson::Document doc;
+    doc.CopyFrom(options, doc.GetAllocator());
+    rapidjson::Value batch_locations(rapidjson::kArrayType);
+    for (const auto& location : batch) {
+      rapidjson::Document parsed;
+      parsed.Parse(location.c_str());
+      if (parsed.HasParseError() || !parsed.IsObject()) {
+        throw valhalla_exception_t{100};
+      }
+      batch_locations.PushBack(rapidjson::Value(parsed, doc.GetAllocator()), doc.GetAllocator());
+    }
+    doc.AddMember("locations", batch_locations, doc.GetAllocator());
+    Api request;
+    ParseApi(rapidjson::to_string(doc), Options::locate, request);
+    pimpl->loki_worker.locate(request, &write);
+    count += batch.size();
+    batch.clear();
+  };
+  while (std::getline(locations, line)) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+      continue;
+    }
+    batch.push_back(std::move(line));
+    if (batch.size() == pimpl->locate_batch_size) {
+      locate_batch();
+    }
+  }
+  if (!batch.empty()) {
+    locate_batch();
+  }
+  // if they want you do to do the cleanup automatically
+  if (auto_cleanup) {
+    cleanup();
+  }
+  return count;
+}
+
+std::string actor_t::matrix(const std::string& request_str,
+                            const std::function<void()>* interrupt,
+                            Api* api,
+                            const std::function<void(const std::string&)>* write) {
   // parse the request
   Api request;
   ParseApi(request_str, Options::sources_to_targets, request);
+  // a matrix asked for before is cached unless the caller wants all of the request back or to
+  // write it out as it goes
+  std::string json;
+  if (!api && !write && pimpl->response_cache &&
+      pimpl->response_cache->find(request, *pimpl->reader, json)) {
+    return json;
+  }
+  // set the interrupts, they also give up on the request once its deadline has passed
+  pimpl->set_interrupts(interrupt, request);
   // check the request and locate the locations in the graph
   pimpl->loki_worker.matrix(request);
   // compute the matrix
-  auto json = pimpl->thor_worker.matrix(request);
+  json = pimpl->thor_worker.matrix(request, write);
+  if (pimpl->response_cache) {
+    pimpl->response_cache->insert(request, json);
+  }
   // if they want you do to do the cleanup automatically
   if (auto_cleanup) {
     cleanup();
@@ -122,11 +333,11 @@ actor_t::matrix(const std::string& request_str, const std::function<void()>* int
 std::string actor_t::optimized_route(const std::string& request_str,
                                      const std::function<void()>* interrupt,
                                      Api* api) {
-  // set the interrupts
-  pimpl->set_interrupts(interrupt);
   // parse the request
   Api request;
   ParseApi(request_str, Options::optimized_route, request);
+  // set the interrupts, they also give up on the request once its deadline has passed
+  pimpl->set_interrupts(interrupt, request);
   // check the request and locate the locations in the graph
   pimpl->loki_worker.matrix(request);
   // compute compute all pairs and then the shortest path through them all
@@ -148,11 +359,11 @@ std::string actor_t::optimized_route(const std::string& request_str,
 
 std::string
 actor_t::isochrone(const std::string& request_str, const std::function<void()>* interrupt, Api* api) {
-  // set the interrupts
-  pimpl->set_interrupts(interrupt);
   // parse the request
   Api request;
   ParseApi(request_str, Options::isochrone, request);
+  // set the interrupts, they also give up on the request once its deadline has passed
+  pimpl->set_interrupts(interrupt, request);
   // check the request and locate the locations in the graph
   pimpl->loki_worker.isochrones(request);
   // compute the isochrones
@@ -171,11 +382,11 @@ actor_t::isochrone(const std::string& request_str, const std::function<void()>*
 std::string actor_t::trace_route(const std::string& request_str,
                                  const std::function<void()>* interrupt,
                                  Api* api) {
-  // set the interrupts
-  pimpl->set_interrupts(interrupt);
   // parse the request
   Api request;
   ParseApi(request_str, Options::trace_route, request);
+  // set the interrupts, they also give up on the request once its deadline has passed
+  pimpl->set_interrupts(interrupt, request);
   // check the request and locate the locations in the graph
   pimpl->loki_worker.trace(request);
   // route between the locations in the graph to find the best path
@@ -198,11 +409,11 @@ std::string actor_t::trace_route(const std::string& request_str,
 std::string actor_t::trace_attributes(const std::string& request_str,
                                       const std::function<void()>* interrupt,
                                       Api* api) {
-  // set the interrupts
-  pimpl->set_interrupts(interrupt);
   // parse the request
   Api request;
   ParseApi(request_str, Options::trace_attributes, request);
+  // set the interrupts, they also give up on the request once its deadline has passed
+  pimpl->set_interrupts(interrupt, request);
   // check the request and locate the locations in the graph
   pimpl->loki_worker.trace(request);
   // get the path and turn it into attribution along it
@@ -218,13 +429,84 @@ std::string actor_t::trace_attributes(const std::string& request_str,
   return json;
 }
 
+std::vector<std::string> actor_t::trace_batch(const std::vector<std::string>& requests,
+                                              const Options::Action action,
+                                              const std::function<void()>* interrupt) {
+  if (action != Options::trace_route && action != Options::trace_attributes) {
+    throw std::invalid_argument("Only trace_route and trace_attributes requests can be batched");
+  }
+
+  // each thread takes the next request until there are none left
+  std::vector<std::string> results(requests.size());
+  std::mutex error_lock;
+  std::exception_ptr error;
+  pimpl->run(requests.size(), pimpl->trace_threads, auto_cleanup,
+             [&](pimpl_t& workers, size_t i) {
+               try {
+                 Api request;
+                 ParseApi(requests[i], action, request);
+                 workers.set_interrupts(interrupt, request);
+                 results[i] = workers.act(request);
+               } catch (...) {
+                 std::lock_guard<std::mutex> lock(error_lock);
+                 if (!error) {
+                   error = std::current_exception();
+                 }
+               }
+             });
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return results;
+}
+
+std::vector<batch_result_t> actor_t::batch(const std::vector<std::string>& requests,
+                                           const Options::Action action,
+                                           const std::function<void()>* interrupt) {
+  std::vector<batch_result_t> results(requests.size());
+  pimpl->run(requests.size(), pimpl->batch_threads, auto_cleanup,
+             [&](pimpl_t& workers, size_t i) {
+               const auto start = std::chrono::steady_clock::now();
+               try {
+                 Api request;
+                 ParseApi(requests[i], action, request);
+                 workers.set_interrupts(interrupt, request);
+                 results[i].response = workers.act(request);
+               } catch (...) { results[i].error = std::current_exception(); }
+               results[i].milliseconds =
+                   std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                       .count();
+             });
+  return results;
+}
+
+std::vector<batch_result_t> actor_t::batch(std::vector<Api>& requests,
+                                           const std::function<void()>* interrupt) {
+  std::vector<batch_result_t> results(requests.size());
+  pimpl->run(requests.size(), pimpl->batch_threads, auto_cleanup,
+             [&](pimpl_t& workers, size_t i) {
+               const auto start = std::chrono::steady_clock::now();
+               try {
+                 auto& request = requests[i];
+                 ParseApi(request);
+                 workers.set_interrupts(interrupt, request);
+                 results[i].response = workers.act(request);
+               } catch (...) { results[i].error = std::current_exception(); }
+               results[i].milliseconds =
+                   std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                       .count();
+             });
+  return results;
+}
+
 std::string
 actor_t::height(const std::string& request_str, const std::function<void()>* interrupt, Api* api) {
-  // set the interrupts
-  pimpl->set_interrupts(interrupt);
   // parse the request
   Api request;
   ParseApi(request_str, Options::height, request);
+  // set the interrupts, they also give up on the request once its deadline has passed
+  pimpl->set_interrupts(interrupt, request);
   // get the height at each point
   auto json = pimpl->loki_worker.height(request);
   // if they want you do to do the cleanup automatically
@@ -238,14 +520,35 @@ actor_t::height(const std::string& request_str, const std::function<void()>* int
   return json;
 }
 
+std::string actor_t::tile(const std::string& request_str,
+                          const std::function<void()>* interrupt,
+                          Api* api) {
+  // parse the request
+  Api request;
+  ParseApi(request_str, Options::tile, request);
+  // set the interrupts, they also give up on the request once its deadline has passed
+  pimpl->set_interrupts(interrupt, request);
+  // render the tile or grab it from the cache
+  auto bytes = pimpl->loki_worker.tile(request);
+  // if they want you do to do the cleanup automatically
+  if (auto_cleanup) {
+    cleanup();
+  }
+  // give the caller a copy
+  if (api) {
+    api->Swap(&request);
+  }
+  return bytes;
+}
+
 std::string actor_t::transit_available(const std::string& request_str,
                                        const std::function<void()>* interrupt,
                                        Api* api) {
-  // set the interrupts
-  pimpl->set_interrupts(interrupt);
   // parse the request
   Api request;
   ParseApi(request_str, Options::transit_available, request);
+  // set the interrupts, they also give up on the request once its deadline has passed
+  pimpl->set_interrupts(interrupt, request);
   // check the request and locate the locations in the graph
   auto json = pimpl->loki_worker.transit_available(request);
   // if they want you do to do the cleanup automatically
@@ -261,11 +564,11 @@ std::string actor_t::transit_available(const std::string& request_str,
 
 std::string
 actor_t::expansion(const std::string& request_str, const std::function<void()>* interrupt, Api* api) {
-  // set the interrupts
-  pimpl->set_interrupts(interrupt);
   // parse the request
   Api request;
   ParseApi(request_str, Options::expansion, request);
+  // set the interrupts, they also give up on the request once its deadline has passed
+  pimpl->set_interrupts(interrupt, request);
   // check the request and locate the locations in the graph
   pimpl->loki_worker.route(request);
   // route between the locations in the graph to find the best path
@@ -283,11 +586,11 @@ actor_t::expansion(const std::string& request_str, const std::function<void()>*
 
 std::string
 actor_t::centroid(const std::string& request_str, const std::function<void()>* interrupt, Api* api) {
-  // set the interrupts
-  pimpl->set_interrupts(interrupt);
   // parse the request
   Api request;
   ParseApi(request_str, Options::centroid, request);
+  // set the interrupts, they also give up on the request once its deadline has passed
+  pimpl->set_interrupts(interrupt, request);
   // check the request and locate the locations in the graph
   pimpl->loki_worker.route(request);
   // route between the locations in the graph to find the best path
@@ -309,11 +612,11 @@ actor_t::centroid(const std::string& request_str, const std::function<void()>* i
 
 std::string
 actor_t::status(const std::string& request_str, const std::function<void()>* interrupt, Api* api) {
-  // set the interrupts
-  pimpl->set_interrupts(interrupt);
   // parse the request
   Api request;
   ParseApi(request_str, Options::centroid, request);
+  // set the interrupts, they also give up on the request once its deadline has passed
+  pimpl->set_interrupts(interrupt, request);
   // check lokis status
   pimpl->loki_worker.status(request);
   // check thors status
@@ -333,5 +636,178 @@ actor_t::status(const std::string& request_str, const std::function<void()>* int
   return json;
 }
 
+#ifdef HAVE_HTTP
+namespace {
+
+// An actor that takes its requests from the http server, the stages hand the request to each other
+// as it is rather than serializing it for the proxy of the next stage
+class service_actor_t : public actor_t {
+public:
+  service_actor_t(const boost::property_tree::ptree& config, baldr::GraphReader& reader)
+      : actor_t(config, reader) {
+  }
+
+  prime_server::worker_t::result_t work(const std::list<zmq::message_t>& job,
+                                        void* request_info,
+                                        const std::function<void()>& interrupt_function) {
+    auto& info = *static_cast<prime_server::http_request_info_t*>(request_info);
+    LOG_INFO("Got Request " + std::to_string(info.id));
+    Api request;
+    // the code of an unexpected failure is the one of the stage it happened in
+    unsigned error_code = 199;
+    try {
+      // request parsing
+      auto http_request =
+          prime_server::http_request_t::from_string(static_cast<const char*>(job.front().data()),
+                                                    job.front().size());
+      ParseApi(http_request, request);
+      if (pimpl->response_compressor) {
+        pimpl->response_compressor->negotiate(http_request, request);
+      }
+      pimpl->loki_worker.check_action(request);
+      // requests outside of the region of this node are answered by the nodes of theirs
+      if (pimpl->region_router) {
+        if (const auto* url = pimpl->region_router->route(request.options())) {
+          return to_redirect(*url, http_request, info);
+        }
+      }
+      pimpl->set_interrupts(&interrupt_function, request);
+      // a request asked before doesnt need a slot to be answered from the cache
+      std::string cached;
+      if (pimpl->response_cache && pimpl->response_cache->find(request, *pimpl->reader, cached)) {
+        return to_response(cached, info, request);
+      }
+      // the whole request runs here so it holds its slot with loki until it is answered
+      auto admitted = pimpl->loki_worker.admit(request, "loki_worker_t::");
+
+      // do request specific processing
+      const auto& options = request.options();
+      const auto& pbf_or_json = options.format() == Options::pbf ? worker::PBF_MIME
+                                                                 : worker::JSON_MIME;
+      switch (options.action()) {
+        case Options::route:
+          pimpl->loki_worker.route(request);
+          error_code = 499;
+          pimpl->thor_worker.route(request);
+          break;
+        case Options::centroid:
+          pimpl->loki_worker.route(request);
+          error_code = 499;
+          pimpl->thor_worker.centroid(request);
+          break;
+        case Options::optimized_route:
+          pimpl->loki_worker.matrix(request);
+          error_code = 499;
+          pimpl->thor_worker.optimized_route(request);
+          break;
+        case Options::trace_route:
+          pimpl->loki_worker.trace(request);
+          error_code = 499;
+          pimpl->thor_worker.trace_route(request);
+          break;
+        case Options::expansion:
+          pimpl->loki_worker.route(request);
+          error_code = 499;
+          return to_response(pimpl->thor_worker.expansion(request), info, request);
+        case Options::sources_to_targets: {
+          pimpl->loki_worker.matrix(request);
+          error_code = 499;
+          auto response = pimpl->thor_worker.matrix(request);
+          if (pimpl->response_cache) {
+            pimpl->response_cache->insert(request, response);
+          }
+          return to_response(response, info, request, pbf_or_json);
+        }
+        case Options::isochrone:
+          pimpl->loki_worker.isochrones(request);
+          error_code = 499;
+          return to_response(pimpl->thor_worker.isochrones(request), info, request, pbf_or_json);
+        case Options::trace_attributes:
+          pimpl->loki_worker.trace(request);
+          error_code = 499;
+          return to_response(pimpl->thor_worker.trace_attributes(request), info, request,
+                             pbf_or_json);
+        case Options::locate:
+          return to_response(pimpl->loki_worker.locate(request), info, request);
+        case Options::height:
+          return to_response(pimpl->loki_worker.height(request), info, request,
+                             options.format() == Options::binary ? worker::BINARY_MIME
+                                                                 : worker::JSON_MIME);
+        case Options::transit_available:
+          return to_response(pimpl->loki_worker.transit_available(request), info, request);
+        case Options::tile:
+          return to_response(pimpl->loki_worker.tile(request), info, request, worker::MVT_MIME,
+                             false, true);
+        case Options::status:
+          pimpl->loki_worker.status(request);
+          error_code = 499;
+          pimpl->thor_worker.status(request);
+          error_code = 299;
+          pimpl->odin_worker.status(request);
+          return to_response(tyr::serializeStatus(request), info, request);
+        default:
+          // apparently you wanted something that we figured we'd support but havent written yet
+          return jsonify_error({107}, info, request);
+      }
+
+      // the rest are routes to narrate
+      error_code = 299;
+      pimpl->odin_worker.narrate(request);
+      auto response = tyr::serializeDirections(request);
+      if (pimpl->response_cache) {
+        pimpl->response_cache->insert(request, response);
+      }
+      const bool as_gpx = options.format() == Options::gpx;
+      return to_response(response, info, request, as_gpx ? worker::GPX_MIME : pbf_or_json, as_gpx);
+    } catch (const valhalla_exception_t& e) {
+      LOG_WARN("400::" + std::string(e.what()) + " request_id=" + std::to_string(info.id));
+      return jsonify_error(e, info, request);
+    } catch (const std::exception& e) {
+      LOG_ERROR("400::" + std::string(e.what()) + " request_id=" + std::to_string(info.id));
+      return jsonify_error({error_code, std::string(e.what())}, info, request);
+    }
+  }
+};
+
+} // namespace
+
+void run_service(const boost::property_tree::ptree& config) {
+  // gracefully shutdown when asked via SIGTERM
+  prime_server::quiesce(config.get<unsigned int>("httpd.service.drain_seconds", 28),
+                        config.get<unsigned int>("httpd.service.shutting_seconds", 1));
+
+  // gets requests from the http server
+  auto upstream_endpoint = config.get<std::string>("loki.service.proxy") + "_out";
+  // and always answers them itself
+  auto loopback_endpoint = config.get<std::string>("httpd.service.loopback");
+  auto interrupt_endpoint = config.get<std::string>("httpd.service.interrupt");
+
+  // listen for requests
+  zmq::context_t context;
+  // a reloaded shared reader gets a new actor between requests, the actor only borrows the reader
+  // so they go together
+  struct reader_actor_t {
+    reader_actor_t(const boost::property_tree::ptree& config,
+                   const std::shared_ptr<baldr::GraphReader>& shared)
+        : reader(shared ? shared
+                        : std::make_shared<baldr::GraphReader>(config.get_child("mjolnir"))),
+          actor(config, *reader) {
+    }
+    std::shared_ptr<baldr::GraphReader> reader;
+    service_actor_t actor;
+  };
+  reloading_worker_t<reader_actor_t> actor(
+      [&config]() { return new reader_actor_t(config, shared_graph_reader(config)); });
+  prime_server::worker_t worker(
+      context, upstream_endpoint, "ipc:///dev/null", loopback_endpoint, interrupt_endpoint,
+      [&actor](const std::list<zmq::message_t>& job, void* request_info,
+               const std::function<void()>& interrupt) {
+        return actor.latest().actor.work(job, request_info, interrupt);
+      },
+      [&actor]() { actor.current().actor.cleanup(); });
+  worker.work();
+}
+#endif
+
 } // namespace tyr
 } // namespace valhalla
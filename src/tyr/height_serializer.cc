@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <sstream>
 
 #include "baldr/json.h"
@@ -10,51 +14,67 @@ using namespace valhalla::baldr;
 
 namespace {
 
-json::ArrayPtr serialize_range_height(const std::vector<double>& ranges,
-                                      const std::vector<double>& heights,
-                                      const uint32_t precision,
-                                      const double no_data_value) {
-  auto array = json::array({});
-  // for each posting
-  auto range = ranges.cbegin();
-
-  for (const auto height : heights) {
-    auto element = json::array({json::fixed_t{*range, 0}});
-    if (height == no_data_value) {
-      element->push_back(nullptr);
+// the heights can be very many so they are written straight out rather than into a json array
+void serialize_height(std::ostream& out,
+                      const std::vector<double>& heights,
+                      const std::vector<double>& ranges,
+                      const uint32_t precision,
+                      const double no_data_value) {
+  out << '[';
+  for (size_t i = 0; i < heights.size(); ++i) {
+    if (i) {
+      out << ',';
+    }
+    if (!ranges.empty()) {
+      out << '[' << json::fixed_t{ranges[i], 0} << ',';
+    }
+    if (heights[i] == no_data_value) {
+      out << "null";
     } else {
-      element->push_back({json::fixed_t{height, precision}});
+      out << json::fixed_t{heights[i], precision};
+    }
+    if (!ranges.empty()) {
+      out << ']';
     }
-    array->push_back(element);
-    ++range;
   }
-  return array;
+  out << ']';
 }
 
-json::ArrayPtr serialize_height(const std::vector<double>& heights,
-                                const uint32_t precision,
-                                const double no_data_value) {
-  auto array = json::array({});
-
-  for (const auto height : heights) {
-    // add all heights's to an array
-    if (height == no_data_value) {
-      array->push_back(nullptr);
-    } else {
-      array->push_back({json::fixed_t{height, precision}});
-    }
+void serialize_shape(std::ostream& out,
+                     const google::protobuf::RepeatedPtrField<valhalla::Location>& shape) {
+  out << '[';
+  for (int i = 0; i < shape.size(); ++i) {
+    out << (i ? "," : "") << "{\"lat\":" << json::fixed_t{shape.Get(i).ll().lat(), 6}
+        << ",\"lon\":" << json::fixed_t{shape.Get(i).ll().lng(), 6} << '}';
   }
+  out << ']';
+}
 
-  return array;
+template <typename T> void write_little_endian(std::string& out, const T value) {
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    out.push_back(static_cast<char>((static_cast<uint64_t>(value) >> (i * 8)) & 0xFF));
+  }
 }
 
-json::ArrayPtr serialize_shape(const google::protobuf::RepeatedPtrField<valhalla::Location>& shape) {
-  auto array = json::array({});
-  for (const auto& p : shape) {
-    array->emplace_back(json::map(
-        {{"lon", json::fixed_t{p.ll().lng(), 6}}, {"lat", json::fixed_t{p.ll().lat(), 6}}}));
+/*
+ * The heights as little endian int16s in whole meters, no data as -32768. With the ranges they
+ * follow the heights as little endian uint32s in whole meters.
+ */
+std::string serialize_binary(const std::vector<double>& heights,
+                             const std::vector<double>& ranges,
+                             const double no_data_value) {
+  std::string out;
+  out.reserve(heights.size() * sizeof(int16_t) + ranges.size() * sizeof(uint32_t));
+  for (const auto height : heights) {
+    auto h = height == no_data_value
+                 ? std::numeric_limits<int16_t>::min()
+                 : static_cast<int16_t>(std::min(std::max(std::round(height), -32767.), 32767.));
+    write_little_endian(out, static_cast<uint16_t>(h));
   }
-  return array;
+  for (const auto range : ranges) {
+    write_little_endian(out, static_cast<uint32_t>(std::round(range)));
+  }
+  return out;
 }
 
 } // namespace
@@ -71,33 +91,33 @@ namespace tyr {
 std::string serializeHeight(const Api& request,
                             const std::vector<double>& heights,
                             const std::vector<double>& ranges) {
-  auto json = json::map({});
+  // just the numbers
+  if (request.options().format() == Options::binary) {
+    return serialize_binary(heights, ranges, skadi::sample::get_no_data_value());
+  }
 
   // get the precision to use for returned heights
   uint32_t precision = request.options().height_precision();
 
-  // get the distances between the postings
-  if (ranges.size()) {
-    json = json::map({{"range_height", serialize_range_height(ranges, heights, precision,
-                                                              skadi::sample::get_no_data_value())}});
-  } // just the postings
-  else {
-    json = json::map(
-        {{"height", serialize_height(heights, precision, skadi::sample::get_no_data_value())}});
-  }
+  // get the distances between the postings or just the postings
+  std::stringstream heights_json;
+  serialize_height(heights_json, heights, ranges, precision, skadi::sample::get_no_data_value());
+  auto json = json::map({{ranges.size() ? "range_height" : "height",
+                          json::RawJSON{heights_json.str()}}});
+
   // send back the shape as well
   if (request.options().has_encoded_polyline()) {
     json->emplace("encoded_polyline", request.options().encoded_polyline());
   } else {
-    json->emplace("shape", serialize_shape(request.options().shape()));
+    std::stringstream shape_json;
+    serialize_shape(shape_json, request.options().shape());
+    json->emplace("shape", json::RawJSON{shape_json.str()});
   }
   if (request.options().has_id()) {
     json->emplace("id", request.options().id());
   }
 
-  std::stringstream ss;
-  ss << *json;
-  return ss.str();
+  return json::serialize(*json);
 }
 } // namespace tyr
 } // namespace valhalla
@@ -4,6 +4,7 @@
 #include "midgard/pointll.h"
 #include "tyr/serializers.h"
 
+#include <algorithm>
 #include <cmath>
 #include <sstream>
 #include <utility>
@@ -12,7 +13,73 @@ using namespace valhalla::baldr::json;
 
 namespace {
 using rgba_t = std::tuple<float, float, float>;
+
+// The hex color the contour was given or a shade of one from red to green by its position among
+// the contours of its location, every location has the same intervals with partition
+std::string
+contour_color(const std::vector<valhalla::midgard::GriddedData<2>::contour_interval_t>& intervals,
+              size_t contour_index,
+              size_t location_count) {
+  // color was supplied
+  const auto& interval = intervals[contour_index];
+  if (!std::get<3>(interval).empty()) {
+    return std::get<3>(interval);
+  }
+  // or we computed it..
+  std::stringstream hex;
+  const auto per_location = intervals.size() / std::max<size_t>(location_count, 1);
+  auto h = (contour_index % per_location) * (150.f / per_location);
+  auto c = .5f;
+  auto x = c * (1 - std::abs(std::fmod(h / 60.f, 2.f) - 1));
+  auto m = .25f;
+  rgba_t color = h < 60 ? rgba_t{m + c, m + x, m}
+                        : (h < 120 ? rgba_t{m + x, m + c, m} : rgba_t{m, m + c, m + x});
+  hex << std::hex << static_cast<int>(std::get<0>(color) * 255 + .5f) << std::hex
+      << static_cast<int>(std::get<1>(color) * 255 + .5f) << std::hex
+      << static_cast<int>(std::get<2>(color) * 255 + .5f);
+  return hex.str();
+}
+
+// The request with the contours added onto it as delta encoded integer coordinates
+std::string
+serialize_pbf(const valhalla::Api& request,
+              const std::vector<valhalla::midgard::GriddedData<2>::contour_interval_t>& intervals,
+              const valhalla::midgard::GriddedData<2>::contours_t& contours,
+              bool polygons,
+              const std::vector<uint32_t>& location_indices) {
+  const size_t location_count = location_indices.empty() ? 1 : request.options().locations_size();
+  valhalla::Api response(request);
+  auto* isochrone = response.mutable_isochrone();
+  isochrone->set_polygons(polygons);
+  for (size_t contour_index = 0; contour_index < intervals.size(); ++contour_index) {
+    const auto& interval = intervals[contour_index];
+    auto* contour = isochrone->add_contours();
+    contour->set_metric(std::get<2>(interval));
+    contour->set_value(std::get<1>(interval));
+    contour->set_color(contour_color(intervals, contour_index, location_count));
+    if (!location_indices.empty()) {
+      contour->set_location_index(location_indices[contour_index]);
+    }
+    for (const auto& feature : contours[contour_index]) {
+      auto* pbf_feature = contour->add_features();
+      for (const auto& ring : feature) {
+        auto* coords = pbf_feature->add_geometries()->mutable_coords();
+        coords->Reserve(ring.size() * 2);
+        int32_t last_lng = 0, last_lat = 0;
+        for (const auto& coord : ring) {
+          int32_t lng = static_cast<int32_t>(std::round(coord.first * 1e6));
+          int32_t lat = static_cast<int32_t>(std::round(coord.second * 1e6));
+          coords->Add(lng - last_lng);
+          coords->Add(lat - last_lat);
+          last_lng = lng;
+          last_lat = lat;
+        }
+      }
+    }
+  }
+  return response.SerializeAsString();
 }
+} // namespace
 
 namespace valhalla {
 namespace tyr {
@@ -21,32 +88,21 @@ std::string serializeIsochrones(const Api& request,
                                 std::vector<midgard::GriddedData<2>::contour_interval_t>& intervals,
                                 midgard::GriddedData<2>::contours_t& contours,
                                 bool polygons,
-                                bool show_locations) {
+                                bool show_locations,
+                                const std::vector<uint32_t>& location_indices) {
+  if (request.options().format() == Options::pbf) {
+    return serialize_pbf(request, intervals, contours, polygons, location_indices);
+  }
+  const size_t location_count = location_indices.empty() ? 1 : request.options().locations_size();
+
   // for each contour interval
-  int i = 0;
   auto features = array({});
   assert(intervals.size() == contours.size());
   for (size_t contour_index = 0; contour_index < intervals.size(); ++contour_index) {
     const auto& interval = intervals[contour_index];
     const auto& feature_collection = contours[contour_index];
 
-    // color was supplied
-    std::stringstream hex;
-    if (!std::get<3>(interval).empty()) {
-      hex << "#" << std::get<3>(interval);
-    } // or we computed it..
-    else {
-      auto h = i * (150.f / intervals.size());
-      auto c = .5f;
-      auto x = c * (1 - std::abs(std::fmod(h / 60.f, 2.f) - 1));
-      auto m = .25f;
-      rgba_t color = h < 60 ? rgba_t{m + c, m + x, m}
-                            : (h < 120 ? rgba_t{m + x, m + c, m} : rgba_t{m, m + c, m + x});
-      hex << "#" << std::hex << static_cast<int>(std::get<0>(color) * 255 + .5f) << std::hex
-          << static_cast<int>(std::get<1>(color) * 255 + .5f) << std::hex
-          << static_cast<int>(std::get<2>(color) * 255 + .5f);
-    }
-    ++i;
+    const auto hex = "#" + contour_color(intervals, contour_index, location_count);
 
     // for each feature on that interval
     for (const auto& feature : feature_collection) {
@@ -67,22 +123,27 @@ std::string serializeIsochrones(const Api& request,
         }
       }
       // add a feature
+      auto properties = map({
+          {"metric", std::get<2>(interval)},
+          {"contour", baldr::json::float_t{std::get<1>(interval)}},
+          {"color", hex},                     // lines
+          {"fill", hex},                      // geojson.io polys
+          {"fillColor", hex},                 // leaflet polys
+          {"opacity", fixed_t{.33f, 2}},      // lines
+          {"fill-opacity", fixed_t{.33f, 2}}, // geojson.io polys
+          {"fillOpacity", fixed_t{.33f, 2}},  // leaflet polys
+      });
+      if (!location_indices.empty()) {
+        properties->emplace("location_index",
+                            static_cast<uint64_t>(location_indices[contour_index]));
+      }
       features->emplace_back(map({
           {"type", std::string("Feature")},
           {"geometry", map({
                            {"type", std::string(polygons ? "Polygon" : "LineString")},
                            {"coordinates", geom},
                        })},
-          {"properties", map({
-                             {"metric", std::get<2>(interval)},
-                             {"contour", baldr::json::float_t{std::get<1>(interval)}},
-                             {"color", hex.str()},               // lines
-                             {"fill", hex.str()},                // geojson.io polys
-                             {"fillColor", hex.str()},           // leaflet polys
-                             {"opacity", fixed_t{.33f, 2}},      // lines
-                             {"fill-opacity", fixed_t{.33f, 2}}, // geojson.io polys
-                             {"fillOpacity", fixed_t{.33f, 2}},  // leaflet polys
-                         })},
+          {"properties", properties},
       }));
     }
   }
@@ -132,10 +193,7 @@ std::string serializeIsochrones(const Api& request,
     feature_collection->emplace("id", request.options().id());
   }
 
-  std::stringstream ss;
-  ss << *feature_collection;
-
-  return ss.str();
+  return baldr::json::serialize(*feature_collection);
 }
 } // namespace tyr
 } // namespace valhalla
@@ -73,7 +73,7 @@ json::ArrayPtr serialize_edges(const PathLocation& location, GraphReader& reader
 
         // historical traffic information
         auto predicted_speeds = json::array({});
-        if (directed_edge->has_predicted_speed()) {
+        if (tile->HasPredictedSpeed(directed_edge)) {
           for (auto sec = 0; sec < midgard::kSecondsPerWeek; sec += 5 * midgard::kSecPerMinute) {
             predicted_speeds->emplace_back(
                 static_cast<uint64_t>(tile->GetSpeed(directed_edge, kPredictedFlowMask, sec)));
@@ -175,6 +175,17 @@ json::MapPtr serialize(const midgard::PointLL& ll, const std::string& reason, bo
 
   return m;
 }
+
+json::MapPtr serialize(const Api& request,
+                       const baldr::Location& location,
+                       const std::unordered_map<baldr::Location, PathLocation>& projections,
+                       GraphReader& reader) {
+  try {
+    return serialize(projections.at(location), reader, request.options().verbose());
+  } catch (const std::exception& e) {
+    return serialize(location.latlng_, "No data found for location", request.options().verbose());
+  }
+}
 } // namespace
 
 namespace valhalla {
@@ -186,16 +197,19 @@ std::string serializeLocate(const Api& request,
                             GraphReader& reader) {
   auto json = json::array({});
   for (const auto& location : locations) {
-    try {
-      json->emplace_back(serialize(projections.at(location), reader, request.options().verbose()));
-    } catch (const std::exception& e) {
-      json->emplace_back(
-          serialize(location.latlng_, "No data found for location", request.options().verbose()));
-    }
+    json->emplace_back(serialize(request, location, projections, reader));
   }
 
+  return json::serialize(*json);
+}
+
+std::string
+serializeLocation(const Api& request,
+                  const baldr::Location& location,
+                  const std::unordered_map<baldr::Location, PathLocation>& projections,
+                  GraphReader& reader) {
   std::stringstream ss;
-  ss << *json;
+  ss << *serialize(request, location, projections, reader);
   return ss.str();
 }
 
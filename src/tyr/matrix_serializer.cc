@@ -3,6 +3,7 @@
 #include "baldr/json.h"
 #include "proto_conversions.h"
 #include "thor/costmatrix.h"
+#include "thor/matrix_selector.h"
 #include "tyr/serializers.h"
 
 using namespace valhalla;
@@ -88,7 +89,7 @@ json::ArrayPtr locations(const google::protobuf::RepeatedPtrField<valhalla::Loca
   return input_locs;
 }
 
-json::ArrayPtr serialize_row(const std::vector<TimeDistance>& tds,
+json::ArrayPtr serialize_row(const TimeDistance* tds,
                              size_t start_td,
                              const size_t td_count,
                              const size_t source_index,
@@ -113,44 +114,118 @@ json::ArrayPtr serialize_row(const std::vector<TimeDistance>& tds,
   return row;
 }
 
-json::MapPtr serialize(const Api& request,
-                       const std::vector<TimeDistance>& time_distances,
-                       double distance_scale) {
-  json::ArrayPtr matrix = json::array({});
+// Everything but the rows
+json::MapPtr summary(const Api& request, const MatrixEstimate& estimate) {
   const auto& options = request.options();
-  for (size_t source_index = 0; source_index < options.sources_size(); ++source_index) {
-    matrix->emplace_back(serialize_row(time_distances, source_index * options.targets_size(),
-                                       options.targets_size(), source_index, 0, distance_scale));
-  }
   auto json = json::map({
-      {"sources_to_targets", matrix},
       {"units", Options_Units_Enum_Name(options.units())},
   });
   json->emplace("targets", json::array({locations(options.targets())}));
   json->emplace("sources", json::array({locations(options.sources())}));
+  json->emplace("algorithm", to_string(estimate.algorithm));
+  json->emplace("estimated_cost", json::fixed_t{estimate.cost, 3});
+
+  // how long each stage took, for finding out where the time of slow requests goes
+  if (options.verbose()) {
+    json->emplace("statistics", valhalla::tyr::statistics(request));
+  }
 
   if (options.has_id()) {
     json->emplace("id", options.id());
   }
   return json;
 }
+
+json::MapPtr serialize(const Api& request,
+                       const std::vector<TimeDistance>& time_distances,
+                       double distance_scale,
+                       const MatrixEstimate& estimate) {
+  json::ArrayPtr matrix = json::array({});
+  const auto& options = request.options();
+  for (size_t source_index = 0; source_index < options.sources_size(); ++source_index) {
+    matrix->emplace_back(serialize_row(time_distances.data(),
+                                       source_index * options.targets_size(),
+                                       options.targets_size(), source_index, 0, distance_scale));
+  }
+  auto json = summary(request, estimate);
+  json->emplace("sources_to_targets", matrix);
+  return json;
+}
 } // namespace valhalla_serializers
 
+namespace pbf_serializers {
+
+// The request with the matrix, flat and row ordered, added onto it
+std::string serialize(const Api& request,
+                      const std::vector<TimeDistance>& time_distances,
+                      double distance_scale,
+                      const MatrixEstimate& estimate) {
+  Api response(request);
+  auto* matrix = response.mutable_matrix();
+  matrix->mutable_times()->Reserve(time_distances.size());
+  matrix->mutable_distances()->Reserve(time_distances.size());
+  for (size_t i = 0; i < time_distances.size(); ++i) {
+    const auto& td = time_distances[i];
+    if (td.time != kMaxCost) {
+      matrix->add_times(td.time);
+      matrix->add_distances(td.dist * distance_scale);
+    } else {
+      matrix->add_times(0);
+      matrix->add_distances(0);
+      matrix->add_unreachable(i);
+    }
+  }
+  matrix->set_algorithm(to_string(estimate.algorithm));
+  matrix->set_estimated_cost(estimate.cost);
+  return response.SerializeAsString();
+}
+
+} // namespace pbf_serializers
+
 namespace valhalla {
 namespace tyr {
 
 std::string serializeMatrix(const Api& request,
                             const std::vector<TimeDistance>& time_distances,
-                            double distance_scale) {
+                            double distance_scale,
+                            const MatrixEstimate& estimate) {
+  if (request.options().format() == Options::pbf) {
+    return pbf_serializers::serialize(request, time_distances, distance_scale, estimate);
+  }
 
   auto json = request.options().format() == Options::osrm
                   ? osrm_serializers::serialize(request, time_distances, distance_scale)
-                  : valhalla_serializers::serialize(request, time_distances, distance_scale);
+                  : valhalla_serializers::serialize(request, time_distances, distance_scale,
+                                                    estimate);
 
+  return json::serialize(*json);
+}
+
+std::string serializeMatrixHead(const Api& /*request*/) {
+  return R"({"sources_to_targets":[)";
+}
+
+std::string serializeMatrixRow(const Api& request,
+                               const TimeDistance* row,
+                               const uint32_t source_index,
+                               double distance_scale) {
   std::stringstream ss;
-  ss << *json;
+  if (source_index > 0) {
+    ss << ',';
+  }
+  ss << *valhalla_serializers::serialize_row(row, 0, request.options().targets_size(), source_index,
+                                             0, distance_scale);
   return ss.str();
 }
 
+std::string serializeMatrixTail(const Api& request, const MatrixEstimate& estimate) {
+  // the summary is the rest of the object the head opened
+  std::stringstream ss;
+  ss << *valhalla_serializers::summary(request, estimate);
+  auto tail = ss.str();
+  tail[0] = ',';
+  return "]" + tail;
+}
+
 } // namespace tyr
 } // namespace valhalla
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "midgard/encoded.h"
+#include "midgard/tracing.h"
 #include "midgard/util.h"
 #include "route_serializer_osrm.cc"
 #include "route_serializer_valhalla.cc"
@@ -78,6 +79,7 @@ namespace tyr {
 std::string serializeDirections(Api& request) {
   // time this whole method and save that statistic
   auto _ = measure_scope_time(request, "tyr::serializeDirections");
+  VALHALLA_TRACE_SPAN("tyr::serializeDirections");
 
   // serialize them
   switch (request.options().format()) {
@@ -87,6 +89,9 @@ std::string serializeDirections(Api& request) {
       return pathToGPX(request.trip().routes(0).legs());
     case Options_Format_json:
       return valhalla_serializers::serialize(request);
+    case Options_Format_pbf:
+      // the trip and the directions are already the answer, no need to write them out as text
+      return request.SerializeAsString();
     default:
       throw;
   }
@@ -260,37 +260,41 @@ json::MapPtr geojson_shape(const std::vector<PointLL> shape) {
   return geojson;
 }
 
-// Generate full shape of the route.
-std::vector<PointLL> full_shape(const valhalla::DirectionsRoute& directions,
-                                const valhalla::Options& options) {
-  // If just one leg and it we want polyline6 then we just return the encoded leg shape
-  if (directions.legs().size() == 1 && options.shape_format() == polyline6) {
-    return midgard::decode<std::vector<PointLL>>(directions.legs().begin()->shape());
-  }
-  // TODO: there is a tricky way to do this... since the end of each leg is the same as the
-  // beginning we essentially could just peel off the first encoded shape point of all the legs (but
-  // the first) this way we wouldn't really have to do any decoding (would be far faster). it might
-  // even be the case that the string length of the first number is a fixed length (which would be
-  // great!) have to have a look should make this a function in midgard probably so the logic is all
-  // in the same place
-  std::vector<PointLL> decoded;
+// The shape of each leg of the route, decoded once for everything that is serialized from it
+std::vector<std::vector<PointLL>> leg_shapes(const valhalla::DirectionsRoute& directions) {
+  std::vector<std::vector<PointLL>> shapes;
+  shapes.reserve(directions.legs_size());
   for (const auto& leg : directions.legs()) {
-    auto decoded_leg = midgard::decode<std::vector<PointLL>>(leg.shape());
-    decoded.insert(decoded.end(), decoded.size() ? decoded_leg.begin() + 1 : decoded_leg.begin(),
-                   decoded_leg.end());
+    shapes.emplace_back(midgard::decode<std::vector<PointLL>>(leg.shape()));
   }
-  return decoded;
+  return shapes;
+}
+
+// Generate full shape of the route.
+std::vector<PointLL> full_shape(const std::vector<std::vector<PointLL>>& leg_shapes) {
+  size_t size = 0;
+  for (const auto& leg_shape : leg_shapes) {
+    size += leg_shape.size();
+  }
+  std::vector<PointLL> shape;
+  shape.reserve(size);
+  for (const auto& leg_shape : leg_shapes) {
+    shape.insert(shape.end(), shape.size() ? leg_shape.begin() + 1 : leg_shape.begin(),
+                 leg_shape.end());
+  }
+  return shape;
 }
 
 // Generate simplified shape of the route.
-std::vector<PointLL> simplified_shape(const valhalla::DirectionsRoute& directions) {
+std::vector<PointLL> simplified_shape(const valhalla::DirectionsRoute& directions,
+                                      const std::vector<std::vector<PointLL>>& leg_shapes) {
   Coordinate south_west(std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
   Coordinate north_east(std::numeric_limits<int>::min(), std::numeric_limits<int>::min());
   std::vector<PointLL> simple_shape;
   std::unordered_set<size_t> indices;
+  auto decoded_leg = leg_shapes.cbegin();
   for (const auto& leg : directions.legs()) {
-    auto decoded_leg = midgard::decode<std::vector<PointLL>>(leg.shape());
-    for (const auto& coord : decoded_leg) {
+    for (const auto& coord : *decoded_leg) {
       south_west.lng = std::min(south_west.lng, toFixed(coord.lng()));
       south_west.lat = std::min(south_west.lat, toFixed(coord.lat()));
       north_east.lng = std::max(north_east.lng, toFixed(coord.lng()));
@@ -303,8 +307,9 @@ std::vector<PointLL> simplified_shape(const valhalla::DirectionsRoute& direction
     }
 
     simple_shape.insert(simple_shape.end(),
-                        simple_shape.size() ? decoded_leg.begin() + 1 : decoded_leg.begin(),
-                        decoded_leg.end());
+                        simple_shape.size() ? decoded_leg->begin() + 1 : decoded_leg->begin(),
+                        decoded_leg->end());
+    ++decoded_leg;
   }
 
   const auto zoom_level = std::min(MAX_ZOOM, getFittedZoom(south_west, north_east));
@@ -314,12 +319,25 @@ std::vector<PointLL> simplified_shape(const valhalla::DirectionsRoute& direction
 
 void route_geometry(json::MapPtr& route,
                     const valhalla::DirectionsRoute& directions,
+                    const std::vector<std::vector<PointLL>>& leg_shapes,
                     const valhalla::Options& options) {
+  const bool simplified = options.has_generalize() && options.generalize() == 0.0f;
+  const bool full = !options.has_generalize() || options.generalize() > 0.0f;
+  // the legs are polyline6 encoded already so the full shape is only their encodings spliced
+  if (full && options.shape_format() == polyline6) {
+    std::vector<const std::string*> encoded_legs;
+    for (const auto& leg : directions.legs()) {
+      encoded_legs.push_back(&leg.shape());
+    }
+    route->emplace("geometry", midgard::splice_encoded(encoded_legs));
+    return;
+  }
+
   std::vector<PointLL> shape;
-  if (options.has_generalize() && options.generalize() == 0.0f) {
-    shape = simplified_shape(directions);
-  } else if (!options.has_generalize() || (options.has_generalize() && options.generalize() > 0.0f)) {
-    shape = full_shape(directions, options);
+  if (simplified) {
+    shape = simplified_shape(directions, leg_shapes);
+  } else if (full) {
+    shape = full_shape(leg_shapes);
   }
   if (options.shape_format() == geojson) {
     route->emplace("geometry", geojson_shape(shape));
@@ -331,7 +349,7 @@ void route_geometry(json::MapPtr& route,
 
 json::MapPtr serialize_annotations(const valhalla::TripLeg& trip_leg) {
   auto attributes_map = json::map({});
-  attributes_map->reserve(4);
+  attributes_map->reserve(5);
 
   if (trip_leg.shape_attributes().time_size() > 0) {
     auto duration_array = json::array({});
@@ -382,6 +400,19 @@ json::MapPtr serialize_annotations(const valhalla::TripLeg& trip_leg) {
     attributes_map->emplace("maxspeed", speed_limits_array);
   }
 
+  if (trip_leg.shape_attributes().elevation_size() > 0) {
+    auto elevation_array = json::array({});
+    elevation_array->reserve(trip_leg.shape_attributes().elevation_size());
+    for (const auto& elevation : trip_leg.shape_attributes().elevation()) {
+      if (elevation == kNoElevationData) {
+        elevation_array->push_back(static_cast<std::nullptr_t>(nullptr));
+      } else {
+        elevation_array->push_back(json::fixed_t{elevation, 1});
+      }
+    }
+    attributes_map->emplace("elevation", elevation_array);
+  }
+
   return attributes_map;
 }
 
@@ -1275,6 +1306,7 @@ names_and_refs(const valhalla::DirectionsLeg::Maneuver& maneuver) {
 
 // Serialize each leg
 json::ArrayPtr serialize_legs(const google::protobuf::RepeatedPtrField<valhalla::DirectionsLeg>& legs,
+                              const std::vector<std::vector<PointLL>>& leg_shapes,
                               const std::vector<std::string>& leg_summaries,
                               google::protobuf::RepeatedPtrField<valhalla::TripLeg>& path_legs,
                               bool imperial,
@@ -1297,7 +1329,7 @@ json::ArrayPtr serialize_legs(const google::protobuf::RepeatedPtrField<valhalla:
 
     // Get the full shape for the leg. We want to use this for serializing
     // encoded shape for each step (maneuver) in OSRM output.
-    auto shape = midgard::decode<std::vector<PointLL>>(leg->shape());
+    const auto& shape = leg_shapes[leg_index];
 
     //#########################################################################
     // Iterate through maneuvers - convert to OSRM steps
@@ -1660,16 +1692,20 @@ std::string serialize(valhalla::Api& api) {
     // Add linear references, if applicable
     route_references(route, api.trip().routes(i), options);
 
+    // The legs are decoded once for the route geometry and the steps
+    const auto shapes = leg_shapes(api.directions().routes(i));
+
     // Concatenated route geometry
-    route_geometry(route, api.directions().routes(i), options);
+    route_geometry(route, api.directions().routes(i), shapes, options);
 
     // Other route summary information
     route_summary(route, api, imperial, i);
 
     // Serialize route legs
-    route->emplace("legs", serialize_legs(api.directions().routes(i).legs(), route_leg_summaries[i],
-                                          *api.mutable_trip()->mutable_routes(i)->mutable_legs(),
-                                          imperial, options));
+    route->emplace("legs",
+                   serialize_legs(api.directions().routes(i).legs(), shapes, route_leg_summaries[i],
+                                  *api.mutable_trip()->mutable_routes(i)->mutable_legs(), imperial,
+                                  options));
 
     routes->emplace_back(std::move(route));
   }
@@ -1678,9 +1714,7 @@ std::string serialize(valhalla::Api& api) {
   json->emplace(options.action() == valhalla::Options::trace_route ? "matchings" : "routes",
                 std::move(routes));
 
-  std::stringstream ss;
-  ss << *json;
-  return ss.str();
+  return json::serialize(*json);
 }
 
 } // namespace osrm_serializers
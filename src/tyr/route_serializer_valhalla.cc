@@ -576,6 +576,11 @@ std::string serialize(const Api& api) {
     writer.end_array(); // alternates
   }
 
+  // how long each stage took, for finding out where the time of slow requests goes
+  if (api.options().verbose()) {
+    valhalla::tyr::statistics(api, writer);
+  }
+
   if (api.options().has_id()) {
     writer("id", api.options().id());
   }
@@ -1,6 +1,7 @@
 #include <boost/property_tree/ptree.hpp>
 #include <cstdint>
 #include <functional>
+#include <map>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -16,6 +17,7 @@
 #include "midgard/encoded.h"
 #include "midgard/logging.h"
 #include "midgard/pointll.h"
+#include "midgard/tracing.h"
 #include "midgard/util.h"
 #include "odin/util.h"
 #include "proto_conversions.h"
@@ -80,13 +82,39 @@ std::vector<std::string> openlr_edges(const TripLeg& leg) {
   }
   return openlrs;
 }
+
+// the statistics by name, the ones of the same name summed up
+std::map<std::string, double> summed_statistics(const Api& api) {
+  std::map<std::string, double> stats;
+  for (const auto& statistic : api.info().statistics()) {
+    stats[statistic.name()] += statistic.value();
+  }
+  return stats;
+}
 } // namespace
 namespace valhalla {
 namespace tyr {
-std::string serializeStatus(const Api&) {
+std::string serializeStatus(const Api& request) {
   // TODO: once we decide on what's in the status message we'll fill out the proto message in
   // loki/thor/odin and we'll serialize it here
-  return "{}";
+  auto status = json::map({});
+
+  // the nodes of a cluster split by region say which one they serve
+  if (request.info().has_region()) {
+    status->emplace("region", request.info().region());
+  }
+
+  // verbose statuses carry the statistics the workers collected about themselves
+  if (request.options().verbose()) {
+    status->emplace("statistics", statistics(request));
+  }
+
+  // the spans of the workers make the response a Chrome trace which Perfetto can open as is
+  if (request.options().trace_events()) {
+    status->emplace("traceEvents", json::RawJSON{midgard::tracing::dump()});
+    status->emplace("displayTimeUnit", std::string("ms"));
+  }
+  return json::serialize(*status);
 }
 
 void route_references(json::MapPtr& route_json, const TripRoute& route, const Options& options) {
@@ -121,6 +149,23 @@ void openlr(const valhalla::Api& api, int route_index, rapidjson::writer_wrapper
   }
   writer.end_array();
 }
+
+json::MapPtr statistics(const valhalla::Api& api) {
+  auto stats = json::map({});
+  for (const auto& statistic : summed_statistics(api)) {
+    stats->emplace(statistic.first, json::fixed_t{statistic.second, 3});
+  }
+  return stats;
+}
+
+void statistics(const valhalla::Api& api, rapidjson::writer_wrapper_t& writer) {
+  writer.start_object("statistics");
+  writer.set_precision(3);
+  for (const auto& statistic : summed_statistics(api)) {
+    writer(statistic.first, statistic.second);
+  }
+  writer.end_object();
+}
 } // namespace tyr
 } // namespace valhalla
 
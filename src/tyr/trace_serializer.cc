@@ -2,6 +2,7 @@
 
 #include "baldr/graphconstants.h"
 #include "baldr/json.h"
+#include "baldr/rapidjson_utils.h"
 #include "odin/enhancedtrippath.h"
 #include "proto_conversions.h"
 #include "thor/attributes_controller.h"
@@ -500,6 +501,517 @@ void append_trace_info(
     json->emplace("shape_attributes", serialize_shape_attributes(controller, trip_path));
   }
 }
+
+// The columnar layout writes an array per attribute rather than an object per edge, straight from
+// the trip leg without building the json in memory first
+
+// Visit the edges of a leg along with the nodes they end at
+template <typename visit_t> void for_each_edge(const TripLeg& trip_path, const visit_t& visit) {
+  for (int i = 1; i < trip_path.node_size(); ++i) {
+    if (trip_path.node(i - 1).has_edge()) {
+      visit(trip_path.node(i - 1).edge(), trip_path.node(i));
+    }
+  }
+}
+
+// Write the array of an attribute of the edges, with a null for the edges which dont have it. The
+// attributes no edge has are left out like they are in the object of every edge.
+template <typename has_t, typename write_t>
+void write_edge_column(rapidjson::writer_wrapper_t& writer,
+                       const char* name,
+                       const TripLeg& trip_path,
+                       const has_t& has,
+                       const write_t& write) {
+  bool any = false;
+  for_each_edge(trip_path, [&any, &has](const TripLeg::Edge& edge, const TripLeg::Node& node) {
+    any = any || has(edge, node);
+  });
+  if (!any) {
+    return;
+  }
+  writer.start_array(name);
+  for_each_edge(trip_path, [&](const TripLeg::Edge& edge, const TripLeg::Node& node) {
+    if (has(edge, node)) {
+      write(edge, node);
+    } else {
+      writer(nullptr);
+    }
+  });
+  writer.end_array();
+}
+
+void write_edges_columnar(rapidjson::writer_wrapper_t& writer,
+                          const AttributesController& controller,
+                          const Options& options,
+                          const TripLeg& trip_path) {
+  // Length and speed default to kilometers
+  double scale = 1;
+  if (options.has_units() && options.units() == Options::miles) {
+    scale = kMilePerKm;
+  }
+
+  uint64_t count = 0;
+  for_each_edge(trip_path, [&count](const TripLeg::Edge&, const TripLeg::Node&) { ++count; });
+
+  using Edge = TripLeg::Edge;
+  using Node = TripLeg::Node;
+  // Most of the attributes are a single value, the edge has them if their field is set
+  auto column = [&writer, &trip_path](const char* name, const auto& has, const auto& value) {
+    write_edge_column(writer, name, trip_path, has,
+                      [&writer, &value](const Edge& e, const Node& n) { writer(value(e, n)); });
+  };
+
+  writer.start_object("edges");
+  writer("count", count);
+  column(
+      "truck_route", [](const Edge& e, const Node&) { return e.has_truck_route(); },
+      [](const Edge& e, const Node&) { return static_cast<bool>(e.truck_route()); });
+  column(
+      "truck_speed",
+      [](const Edge& e, const Node&) { return e.has_truck_speed() && e.truck_speed() > 0; },
+      [scale](const Edge& e, const Node&) {
+        return static_cast<uint64_t>(std::round(e.truck_speed() * scale));
+      });
+  write_edge_column(
+      writer, "speed_limit", trip_path,
+      [](const Edge& e, const Node&) { return e.has_speed_limit() && e.speed_limit() > 0; },
+      [&writer, scale](const Edge& e, const Node&) {
+        if (e.speed_limit() == kUnlimitedSpeedLimit) {
+          writer("unlimited");
+        } else {
+          writer(static_cast<uint64_t>(std::round(e.speed_limit() * scale)));
+        }
+      });
+  column(
+      "density", [](const Edge& e, const Node&) { return e.has_density(); },
+      [](const Edge& e, const Node&) { return static_cast<uint64_t>(e.density()); });
+  column(
+      "sac_scale", [](const Edge& e, const Node&) { return e.has_sac_scale(); },
+      [](const Edge& e, const Node&) { return static_cast<uint64_t>(e.sac_scale()); });
+  column(
+      "shoulder", [](const Edge& e, const Node&) { return e.has_shoulder(); },
+      [](const Edge& e, const Node&) { return static_cast<bool>(e.shoulder()); });
+  column(
+      "sidewalk", [](const Edge& e, const Node&) { return e.has_sidewalk(); },
+      [](const Edge& e, const Node&) { return to_string(e.sidewalk()); });
+  column(
+      "bicycle_network", [](const Edge& e, const Node&) { return e.has_bicycle_network(); },
+      [](const Edge& e, const Node&) { return static_cast<uint64_t>(e.bicycle_network()); });
+  column(
+      "cycle_lane", [](const Edge& e, const Node&) { return e.has_cycle_lane(); },
+      [](const Edge& e, const Node&) { return to_string(static_cast<CycleLane>(e.cycle_lane())); });
+  column(
+      "lane_count", [](const Edge& e, const Node&) { return e.has_lane_count(); },
+      [](const Edge& e, const Node&) { return static_cast<uint64_t>(e.lane_count()); });
+  write_edge_column(
+      writer, "lane_connectivity", trip_path,
+      [](const Edge& e, const Node&) { return e.lane_connectivity_size() > 0; },
+      [&writer](const Edge& e, const Node&) {
+        writer.start_array();
+        for (const auto& l : e.lane_connectivity()) {
+          writer.start_object();
+          writer("from", static_cast<uint64_t>(l.from_way_id()));
+          writer("to_lanes", l.to_lanes());
+          writer("from_lanes", l.from_lanes());
+          writer.end_object();
+        }
+        writer.end_array();
+      });
+  column(
+      "max_downward_grade", [](const Edge& e, const Node&) { return e.has_max_downward_grade(); },
+      [](const Edge& e, const Node&) { return static_cast<int64_t>(e.max_downward_grade()); });
+  column(
+      "max_upward_grade", [](const Edge& e, const Node&) { return e.has_max_upward_grade(); },
+      [](const Edge& e, const Node&) { return static_cast<int64_t>(e.max_upward_grade()); });
+  column(
+      "weighted_grade", [](const Edge& e, const Node&) { return e.has_weighted_grade(); },
+      [](const Edge& e, const Node&) { return static_cast<double>(e.weighted_grade()); });
+  column(
+      "mean_elevation", [](const Edge& e, const Node&) { return e.has_mean_elevation(); },
+      [&options](const Edge& e, const Node&) {
+        // Convert to feet if a valid elevation and units are miles
+        float mean = e.mean_elevation();
+        if (mean != kNoElevationData && options.has_units() && options.units() == Options::miles) {
+          mean *= kFeetPerMeter;
+        }
+        return static_cast<int64_t>(mean);
+      });
+  column(
+      "way_id", [](const Edge& e, const Node&) { return e.has_way_id(); },
+      [](const Edge& e, const Node&) { return static_cast<uint64_t>(e.way_id()); });
+  column(
+      "id", [](const Edge& e, const Node&) { return e.has_id(); },
+      [](const Edge& e, const Node&) { return static_cast<uint64_t>(e.id()); });
+  column(
+      "travel_mode", [](const Edge& e, const Node&) { return e.has_travel_mode(); },
+      [](const Edge& e, const Node&) { return to_string(e.travel_mode()); });
+  column(
+      "vehicle_type", [](const Edge& e, const Node&) { return e.has_vehicle_type(); },
+      [](const Edge& e, const Node&) { return to_string(e.vehicle_type()); });
+  column(
+      "pedestrian_type", [](const Edge& e, const Node&) { return e.has_pedestrian_type(); },
+      [](const Edge& e, const Node&) { return to_string(e.pedestrian_type()); });
+  column(
+      "bicycle_type", [](const Edge& e, const Node&) { return e.has_bicycle_type(); },
+      [](const Edge& e, const Node&) { return to_string(e.bicycle_type()); });
+  column(
+      "surface", [](const Edge& e, const Node&) { return e.has_surface(); },
+      [](const Edge& e, const Node&) {
+        return to_string(static_cast<baldr::Surface>(e.surface()));
+      });
+  column(
+      "drive_on_right", [](const Edge& e, const Node&) { return e.has_drive_on_right(); },
+      [](const Edge& e, const Node&) { return static_cast<bool>(e.drive_on_right()); });
+  column(
+      "internal_intersection",
+      [](const Edge& e, const Node&) { return e.has_internal_intersection(); },
+      [](const Edge& e, const Node&) { return static_cast<bool>(e.internal_intersection()); });
+  column(
+      "roundabout", [](const Edge& e, const Node&) { return e.has_roundabout(); },
+      [](const Edge& e, const Node&) { return static_cast<bool>(e.roundabout()); });
+  column(
+      "bridge", [](const Edge& e, const Node&) { return e.has_bridge(); },
+      [](const Edge& e, const Node&) { return static_cast<bool>(e.bridge()); });
+  column(
+      "tunnel", [](const Edge& e, const Node&) { return e.has_tunnel(); },
+      [](const Edge& e, const Node&) { return static_cast<bool>(e.tunnel()); });
+  column(
+      "unpaved", [](const Edge& e, const Node&) { return e.has_unpaved(); },
+      [](const Edge& e, const Node&) { return static_cast<bool>(e.unpaved()); });
+  column(
+      "toll", [](const Edge& e, const Node&) { return e.has_toll(); },
+      [](const Edge& e, const Node&) { return static_cast<bool>(e.toll()); });
+  column(
+      "use", [](const Edge& e, const Node&) { return e.has_use(); },
+      [](const Edge& e, const Node&) { return to_string(static_cast<baldr::Use>(e.use())); });
+  column(
+      "traversability", [](const Edge& e, const Node&) { return e.has_traversability(); },
+      [](const Edge& e, const Node&) { return to_string(e.traversability()); });
+  column(
+      "end_shape_index", [](const Edge& e, const Node&) { return e.has_end_shape_index(); },
+      [](const Edge& e, const Node&) { return static_cast<uint64_t>(e.end_shape_index()); });
+  column(
+      "begin_shape_index", [](const Edge& e, const Node&) { return e.has_begin_shape_index(); },
+      [](const Edge& e, const Node&) { return static_cast<uint64_t>(e.begin_shape_index()); });
+  column(
+      "end_heading", [](const Edge& e, const Node&) { return e.has_end_heading(); },
+      [](const Edge& e, const Node&) { return static_cast<uint64_t>(e.end_heading()); });
+  column(
+      "begin_heading", [](const Edge& e, const Node&) { return e.has_begin_heading(); },
+      [](const Edge& e, const Node&) { return static_cast<uint64_t>(e.begin_heading()); });
+  column(
+      "road_class", [](const Edge& e, const Node&) { return e.has_road_class(); },
+      [](const Edge& e, const Node&) {
+        return to_string(static_cast<baldr::RoadClass>(e.road_class()));
+      });
+  column(
+      "speed", [](const Edge& e, const Node&) { return e.has_speed(); },
+      [scale](const Edge& e, const Node&) {
+        return static_cast<uint64_t>(std::round(e.speed() * scale));
+      });
+  column(
+      "length", [](const Edge& e, const Node&) { return e.has_length_km(); },
+      [scale](const Edge& e, const Node&) { return e.length_km() * scale; });
+  write_edge_column(
+      writer, "names", trip_path, [](const Edge& e, const Node&) { return e.name_size() > 0; },
+      [&writer](const Edge& e, const Node&) {
+        writer.start_array();
+        for (const auto& name : e.name()) {
+          writer(name.value());
+        }
+        writer.end_array();
+      });
+  write_edge_column(
+      writer, "traffic_segments", trip_path,
+      [](const Edge& e, const Node&) { return e.traffic_segment_size() > 0; },
+      [&writer](const Edge& e, const Node&) {
+        writer.start_array();
+        for (const auto& segment : e.traffic_segment()) {
+          writer.start_object();
+          writer("segment_id", static_cast<uint64_t>(segment.segment_id()));
+          writer("begin_percent", static_cast<double>(segment.begin_percent()));
+          writer("end_percent", static_cast<double>(segment.end_percent()));
+          writer("starts_segment", static_cast<bool>(segment.starts_segment()));
+          writer("ends_segment", static_cast<bool>(segment.ends_segment()));
+          writer.end_object();
+        }
+        writer.end_array();
+      });
+  write_edge_column(
+      writer, "sign", trip_path, [](const Edge& e, const Node&) { return e.has_sign(); },
+      [&writer](const Edge& e, const Node&) {
+        const auto texts = [&writer](const char* name, const auto& elements) {
+          if (elements.size() > 0) {
+            writer.start_array(name);
+            for (const auto& element : elements) {
+              writer(element.text());
+            }
+            writer.end_array();
+          }
+        };
+        writer.start_object();
+        texts("exit_number", e.sign().exit_numbers());
+        texts("exit_branch", e.sign().exit_onto_streets());
+        texts("exit_toward", e.sign().exit_toward_locations());
+        texts("exit_name", e.sign().exit_names());
+        writer.end_object();
+      });
+
+  // The end nodes get arrays of their own, one entry per edge as well
+  if (controller.category_attribute_enabled(kNodeCategory)) {
+    writer.start_object("end_node");
+    write_edge_column(
+        writer, "intersecting_edges", trip_path,
+        [](const Edge&, const Node& n) { return n.intersecting_edge_size() > 0; },
+        [&writer](const Edge&, const Node& n) {
+          writer.start_array();
+          for (const auto& xedge : n.intersecting_edge()) {
+            writer.start_object();
+            if (xedge.has_walkability() && (xedge.walkability() != TripLeg_Traversability_kNone)) {
+              writer("walkability", to_string(xedge.walkability()));
+            }
+            if (xedge.has_cyclability() && (xedge.cyclability() != TripLeg_Traversability_kNone)) {
+              writer("cyclability", to_string(xedge.cyclability()));
+            }
+            if (xedge.has_driveability() &&
+                (xedge.driveability() != TripLeg_Traversability_kNone)) {
+              writer("driveability", to_string(xedge.driveability()));
+            }
+            writer("from_edge_name_consistency", static_cast<bool>(xedge.prev_name_consistency()));
+            writer("to_edge_name_consistency", static_cast<bool>(xedge.curr_name_consistency()));
+            writer("begin_heading", static_cast<uint64_t>(xedge.begin_heading()));
+            if (xedge.has_use()) {
+              writer("use", to_string(static_cast<baldr::Use>(xedge.use())));
+            }
+            if (xedge.has_road_class()) {
+              writer("road_class", to_string(static_cast<baldr::RoadClass>(xedge.road_class())));
+            }
+            writer.end_object();
+          }
+          writer.end_array();
+        });
+    column(
+        "elapsed_time",
+        [](const Edge&, const Node& n) {
+          return n.has_cost() && n.cost().has_elapsed_cost() &&
+                 n.cost().elapsed_cost().has_seconds();
+        },
+        [](const Edge&, const Node& n) { return n.cost().elapsed_cost().seconds(); });
+    column(
+        "admin_index", [](const Edge&, const Node& n) { return n.has_admin_index(); },
+        [](const Edge&, const Node& n) { return static_cast<uint64_t>(n.admin_index()); });
+    column(
+        "type", [](const Edge&, const Node& n) { return n.has_type(); },
+        [](const Edge&, const Node& n) {
+          return to_string(static_cast<baldr::NodeType>(n.type()));
+        });
+    column(
+        "fork", [](const Edge&, const Node& n) { return n.has_fork(); },
+        [](const Edge&, const Node& n) { return static_cast<bool>(n.fork()); });
+    column(
+        "time_zone", [](const Edge&, const Node& n) { return n.has_time_zone(); },
+        [](const Edge&, const Node& n) { return n.time_zone(); });
+    column(
+        "transition_time",
+        [](const Edge&, const Node& n) {
+          return n.has_cost() && n.cost().has_transition_cost() &&
+                 n.cost().transition_cost().has_seconds();
+        },
+        [](const Edge&, const Node& n) { return n.cost().transition_cost().seconds(); });
+    writer.end_object();
+  }
+  writer.end_object();
+}
+
+void write_matched_points_columnar(rapidjson::writer_wrapper_t& writer,
+                                   const AttributesController& controller,
+                                   const std::vector<meili::MatchResult>& match_results) {
+  // Write the array of an attribute of the matched points when it was asked for
+  auto column = [&](const std::string& key, const char* name, const auto& write) {
+    if (!controller.attributes.at(key)) {
+      return;
+    }
+    writer.start_array(name);
+    for (const auto& match_result : match_results) {
+      write(match_result);
+    }
+    writer.end_array();
+  };
+  const auto matched = [](const meili::MatchResult& match_result) {
+    return match_result.GetType() != meili::MatchResult::Type::kUnmatched;
+  };
+
+  writer.start_object("matched_points");
+  writer.set_precision(6);
+  column(kMatchedPoint, "lon",
+         [&writer](const meili::MatchResult& m) { writer(static_cast<double>(m.lnglat.first)); });
+  column(kMatchedPoint, "lat",
+         [&writer](const meili::MatchResult& m) { writer(static_cast<double>(m.lnglat.second)); });
+  writer.set_precision(3);
+  column(kMatchedType, "type", [&writer](const meili::MatchResult& m) {
+    switch (m.GetType()) {
+      case meili::MatchResult::Type::kMatched:
+        writer("matched");
+        break;
+      case meili::MatchResult::Type::kInterpolated:
+        writer("interpolated");
+        break;
+      default:
+        writer("unmatched");
+        break;
+    }
+  });
+  column(kMatchedEdgeIndex, "edge_index", [&writer](const meili::MatchResult& m) {
+    if (m.edgeid.Is_Valid()) {
+      writer(static_cast<uint64_t>(m.edge_index));
+    } else {
+      writer(nullptr);
+    }
+  });
+  column(kMatchedBeginRouteDiscontinuity, "begin_route_discontinuity",
+         [&writer](const meili::MatchResult& m) { writer(m.begins_discontinuity); });
+  column(kMatchedEndRouteDiscontinuity, "end_route_discontinuity",
+         [&writer](const meili::MatchResult& m) { writer(m.ends_discontinuity); });
+  column(kMatchedDistanceAlongEdge, "distance_along_edge",
+         [&writer, &matched](const meili::MatchResult& m) {
+           if (matched(m)) {
+             writer(m.distance_along);
+           } else {
+             writer(nullptr);
+           }
+         });
+  column(kMatchedDistanceFromTracePoint, "distance_from_trace_point",
+         [&writer, &matched](const meili::MatchResult& m) {
+           if (matched(m)) {
+             writer(m.distance_from);
+           } else {
+             writer(nullptr);
+           }
+         });
+  writer.end_object();
+}
+
+void write_trace_info_columnar(
+    rapidjson::writer_wrapper_t& writer,
+    const AttributesController& controller,
+    const Options& options,
+    const std::tuple<float, float, std::vector<meili::MatchResult>>& map_match_result,
+    const TripLeg& trip_path) {
+  const auto& match_results = std::get<kMatchResultsIndex>(map_match_result);
+
+  if (trip_path.has_osm_changeset()) {
+    writer("osm_changeset", static_cast<uint64_t>(trip_path.osm_changeset()));
+  }
+  if (trip_path.has_shape()) {
+    writer("shape", trip_path.shape());
+  }
+  if (controller.attributes.at(kConfidenceScore)) {
+    writer("confidence_score",
+           static_cast<double>(std::get<kConfidenceScoreIndex>(map_match_result)));
+  }
+  if (controller.attributes.at(kRawScore)) {
+    writer("raw_score", static_cast<double>(std::get<kRawScoreIndex>(map_match_result)));
+  }
+
+  // There are few admins so they stay an object each
+  if (trip_path.admin_size() > 0) {
+    writer.start_array("admins");
+    for (const auto& admin : trip_path.admin()) {
+      writer.start_object();
+      if (admin.has_country_code()) {
+        writer("country_code", admin.country_code());
+      }
+      if (admin.has_country_text()) {
+        writer("country_text", admin.country_text());
+      }
+      if (admin.has_state_code()) {
+        writer("state_code", admin.state_code());
+      }
+      if (admin.has_state_text()) {
+        writer("state_text", admin.state_text());
+      }
+      writer.end_object();
+    }
+    writer.end_array();
+  }
+
+  write_edges_columnar(writer, controller, options, trip_path);
+
+  if (controller.category_attribute_enabled(kMatchedCategory) && !match_results.empty()) {
+    write_matched_points_columnar(writer, controller, match_results);
+  }
+
+  // The shape attributes are arrays in either layout
+  if (controller.category_attribute_enabled(kShapeAttributesCategory)) {
+    writer.start_object("shape_attributes");
+    if (controller.attributes.at(kShapeAttributesTime)) {
+      writer.start_array("time");
+      for (const auto& time : trip_path.shape_attributes().time()) {
+        writer(time * kSecPerMillisecond);
+      }
+      writer.end_array();
+    }
+    if (controller.attributes.at(kShapeAttributesLength)) {
+      writer.start_array("length");
+      for (const auto& length : trip_path.shape_attributes().length()) {
+        writer(length * kKmPerDecimeter);
+      }
+      writer.end_array();
+    }
+    if (controller.attributes.at(kShapeAttributesSpeed)) {
+      writer.start_array("speed");
+      for (const auto& speed : trip_path.shape_attributes().speed()) {
+        writer(speed * kDecimeterPerSectoKPH);
+      }
+      writer.end_array();
+    }
+    writer.end_object();
+  }
+}
+
+std::string serialize_columnar(
+    const Api& request,
+    const AttributesController& controller,
+    const std::vector<std::tuple<float, float, std::vector<meili::MatchResult>>>&
+        map_match_results) {
+  rapidjson::writer_wrapper_t writer(4096);
+  writer.set_precision(3);
+  writer.start_object();
+
+  if (request.options().has_id()) {
+    writer("id", request.options().id());
+  }
+  if (request.options().has_units()) {
+    writer("units", valhalla::Options_Units_Enum_Name(request.options().units()));
+  }
+
+  // The best path is at the top and the alternates follow in an array
+  auto route = request.trip().routes().begin();
+  for (const auto& map_match_result : map_match_results) {
+    if (route == request.trip().routes().begin()) {
+      write_trace_info_columnar(writer, controller, request.options(), map_match_result,
+                                route->legs(0));
+      writer.start_array("alternate_paths");
+    } else {
+      writer.start_object();
+      write_trace_info_columnar(writer, controller, request.options(), map_match_result,
+                                route->legs(0));
+      writer.end_object();
+    }
+    ++route;
+  }
+  if (map_match_results.empty()) {
+    writer.start_array("alternate_paths");
+  }
+  writer.end_array();
+
+  // how long each stage took, for finding out where the time of slow requests goes
+  if (request.options().verbose()) {
+    statistics(request, writer);
+  }
+  writer.end_object();
+  return writer.get_buffer();
+}
 } // namespace
 
 namespace valhalla {
@@ -510,6 +1022,16 @@ std::string serializeTraceAttributes(
     const AttributesController& controller,
     std::vector<std::tuple<float, float, std::vector<meili::MatchResult>>>& map_match_results) {
 
+  // the trip legs already are the answer, the match results and scores only come with json
+  if (request.options().format() == Options::pbf) {
+    return request.SerializeAsString();
+  }
+
+  // an array per attribute is a lot smaller than an object per edge and is written as it goes
+  if (request.options().columnar()) {
+    return serialize_columnar(request, controller, map_match_results);
+  }
+
   // Create json map to return
   auto json = json::map({});
 
@@ -543,9 +1065,12 @@ std::string serializeTraceAttributes(
     }
     ++route;
   }
-  std::stringstream ss;
-  ss << *json;
-  return ss.str();
+
+  // how long each stage took, for finding out where the time of slow requests goes
+  if (request.options().verbose()) {
+    json->emplace("statistics", statistics(request));
+  }
+  return json::serialize(*json);
 }
 
 } // namespace tyr
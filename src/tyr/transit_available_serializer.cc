@@ -29,9 +29,7 @@ std::string serializeTransitAvailable(const Api& /* request */,
   for (const auto& location : locations) {
     json->emplace_back(serialize(location, found.find(location) != found.cend()));
   }
-  std::stringstream ss;
-  ss << *json;
-  return ss.str();
+  return json::serialize(*json);
 }
 
 } // namespace tyr
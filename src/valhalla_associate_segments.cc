@@ -19,6 +19,8 @@
 #include <boost/property_tree/ptree.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <deque>
 #include <future>
 #include <mutex>
@@ -151,8 +153,8 @@ using chunks_t = std::vector<std::pair<vb::GraphId, std::vector<vb::TrafficChunk
 struct edge_association {
   explicit edge_association(const bpt::ptree& pt);
 
-  // Associate a tile of OSMLR to Valhalla edges
-  void add_tile(const std::string& file_name);
+  // Associate a tile of OSMLR to Valhalla edges, returns how many segments it had
+  uint64_t add_tile(const std::string& file_name);
 
   // Get the "leftovers" - these are edge-segment associations where the
   // edges are not in the same tile as the OSMLR segment.
@@ -799,11 +801,11 @@ bool edge_association::match_segment(vb::GraphId segment_id,
   return true;
 }
 
-void edge_association::add_tile(const std::string& file_name) {
+uint64_t edge_association::add_tile(const std::string& file_name) {
   // Return if this tile does not exist in the Valhalla tile set
   auto base_id = vb::GraphTile::GetTileId(file_name);
   if (!m_reader.DoesTileExist(base_id)) {
-    return;
+    return 0;
   }
 
   // Read the OSMLR tile
@@ -824,11 +826,13 @@ void edge_association::add_tile(const std::string& file_name) {
   // Match the segments in this OSMLR tile
   std::cout.precision(16);
   uint64_t entry_id = 0;
+  uint64_t segment_count = 0;
   MatchType match_type = MatchType::kWalk;
   for (auto& entry : tile.entries()) {
     if (!entry.has_marker()) {
       assert(entry.has_segment());
       auto& segment = entry.segment();
+      ++segment_count;
       if (match_segment(base_id + entry_id, segment, match_type)) {
         success_count_[base_id.level()] += 1;
         if (match_type == MatchType::kWalk) {
@@ -846,14 +850,47 @@ void edge_association::add_tile(const std::string& file_name) {
   // Finish this tile
   m_tile_builder->UpdateTrafficSegments(false);
   m_reader.Clear();
+  return segment_count;
 }
 
+// Progress of the local associations across all the threads
+struct progress_t {
+  explicit progress_t(size_t total_tiles)
+      : total_tiles(total_tiles), start(std::chrono::steady_clock::now()) {
+  }
+
+  // Counts a finished tile and every so often logs how far along all the threads are
+  void finished(uint64_t segment_count) {
+    auto segments_done = segments += segment_count;
+    auto tiles_done = ++tiles;
+    if (tiles_done % kLogInterval != 0 && tiles_done != total_tiles) {
+      return;
+    }
+    LOG_INFO("Associated " + std::to_string(tiles_done) + " of " + std::to_string(total_tiles) +
+             " tiles, " + std::to_string(segments_done) + " segments at " +
+             std::to_string(static_cast<uint64_t>(rate(segments_done))) + " segments/s");
+  }
+
+  // Segments per second since the start
+  double rate(uint64_t segment_count) const {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() > 0 ? segment_count / elapsed.count() : 0;
+  }
+
+  static constexpr size_t kLogInterval = 100;
+  const size_t total_tiles;
+  const std::chrono::steady_clock::time_point start;
+  std::atomic<size_t> tiles{0};
+  std::atomic<uint64_t> segments{0};
+};
+
 // Add OSMLR segment associations to each tile in the list. Any "local"
 // associations where the edge is within the same tile as the OSMLR segment
 // are written to the tile.
 void add_local_associations(const bpt::ptree& pt,
                             std::deque<std::string>& osmlr_tiles,
                             std::mutex& lock,
+                            progress_t& progress,
                             std::promise<edge_association>& association) {
 
   // this holds the extra data before we serialize it to the extra section
@@ -874,7 +911,7 @@ void add_local_associations(const bpt::ptree& pt,
     }
 
     // get the local associations
-    e.add_tile(osmlr_filename);
+    progress.finished(e.add_tile(osmlr_filename));
   }
 
   // pass it back
@@ -1024,17 +1061,20 @@ int main(int argc, char** argv) {
   std::vector<std::shared_ptr<std::thread>> threads(num_threads);
   std::list<std::promise<edge_association>> results;
   std::mutex lock;
+  progress_t progress(osmlr_tiles.size());
   for (auto& thread : threads) {
     results.emplace_back();
     thread.reset(new std::thread(add_local_associations, std::cref(pt), std::ref(osmlr_tiles),
-                                 std::ref(lock), std::ref(results.back())));
+                                 std::ref(lock), std::ref(progress), std::ref(results.back())));
   }
 
   // wait for it to finish
   for (auto& thread : threads) {
     thread->join();
   }
-  LOG_INFO("Finished");
+  LOG_INFO("Finished " + std::to_string(progress.segments) + " segments at " +
+           std::to_string(static_cast<uint64_t>(progress.rate(progress.segments))) +
+           " segments/s");
 
   // Gather statistics, chunks, and leftovers (associations in a different tile)
   std::unordered_map<uint32_t, uint32_t> success_count;
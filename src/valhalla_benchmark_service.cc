@@ -0,0 +1,331 @@
+#include "config.h"
+
+#include "baldr/graphreader.h"
+#include "baldr/rapidjson_utils.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+#include "proto_conversions.h"
+#include "tyr/actor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace bpo = boost::program_options;
+using namespace valhalla;
+
+namespace {
+
+// a request of the log and the action it is for
+struct request_t {
+  Options::Action action;
+  std::string json;
+};
+
+// how one of the requests went
+struct sample_t {
+  Options::Action action;
+  double milliseconds;
+  bool failed;
+};
+
+// cpu time, user and system, and the peak resident memory of the process, 0s if they arent known
+struct usage_t {
+  double cpu_seconds;
+  double max_rss_mb;
+
+  static usage_t now() {
+#ifdef _WIN32
+    return {0, 0};
+#else
+    struct rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+      return {0, 0};
+    }
+    double rss = static_cast<double>(usage.ru_maxrss);
+#ifdef __APPLE__
+    // mac reports it in bytes rather than kilobytes
+    rss /= 1024.;
+#endif
+    return {usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec +
+                usage.ru_stime.tv_usec / 1e6,
+            rss / 1024.};
+#endif
+  }
+};
+
+/**
+ * Reads the requests of the log. Each line is either a request object of its own, which is for the
+ * default action, or an object with the action and the request like the one below.
+ *   {"action":"sources_to_targets","request":{"sources":[...],"targets":[...],"costing":"auto"}}
+ */
+std::vector<request_t> read_requests(const std::vector<std::string>& files,
+                                     const Options::Action default_action) {
+  std::vector<request_t> requests;
+  for (const auto& file : files) {
+    std::ifstream stream(file);
+    if (!stream) {
+      throw std::runtime_error("Could not open " + file);
+    }
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(stream, line)) {
+      ++line_number;
+      if (line.find_first_not_of(" \t\r") == std::string::npos) {
+        continue;
+      }
+      rapidjson::Document doc;
+      doc.Parse(line.c_str());
+      if (doc.HasParseError() || !doc.IsObject()) {
+        throw std::runtime_error(file + ":" + std::to_string(line_number) +
+                                 " is not a json object");
+      }
+      auto action = rapidjson::get_optional<std::string>(doc, "/action");
+      auto request = rapidjson::get_child_optional(doc, "/request");
+      if (!action || !request) {
+        requests.push_back({default_action, std::move(line)});
+        continue;
+      }
+      Options::Action parsed;
+      if (!Options_Action_Enum_Parse(*action, &parsed)) {
+        throw std::runtime_error(file + ":" + std::to_string(line_number) + " has unknown action " +
+                                 *action);
+      }
+      requests.push_back({parsed, rapidjson::to_string(*request)});
+    }
+  }
+  return requests;
+}
+
+// answers the request the same way the service would
+std::string act(tyr::actor_t& actor, const request_t& request) {
+  switch (request.action) {
+    case Options::route:
+      return actor.route(request.json);
+    case Options::locate:
+      return actor.locate(request.json);
+    case Options::sources_to_targets:
+      return actor.matrix(request.json);
+    case Options::optimized_route:
+      return actor.optimized_route(request.json);
+    case Options::isochrone:
+      return actor.isochrone(request.json);
+    case Options::trace_route:
+      return actor.trace_route(request.json);
+    case Options::trace_attributes:
+      return actor.trace_attributes(request.json);
+    case Options::height:
+      return actor.height(request.json);
+    case Options::transit_available:
+      return actor.transit_available(request.json);
+    case Options::expansion:
+      return actor.expansion(request.json);
+    case Options::centroid:
+      return actor.centroid(request.json);
+    case Options::status:
+      return actor.status(request.json);
+    case Options::tile:
+      return actor.tile(request.json);
+    default:
+      throw std::runtime_error("Unsupported action");
+  }
+}
+
+// the value below which the given fraction of the sorted values are
+double percentile(const std::vector<double>& sorted, const double fraction) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  auto index = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+  return sorted[std::min(std::max<size_t>(index, 1), sorted.size()) - 1];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  filesystem::path config_file_path;
+  size_t concurrency = std::max(std::thread::hardware_concurrency(), 1u);
+  double qps = 0;
+  size_t repeat = 1;
+  std::string action_str = "route";
+  std::vector<std::string> input_files;
+
+  bpo::options_description options(
+      "valhalla_benchmark_service " VALHALLA_VERSION "\n"
+      "\n"
+      " Usage: valhalla_benchmark_service [options] <request_log> ...\n"
+      "\n"
+      "valhalla_benchmark_service replays logs of requests through the same code which answers "
+      "them in the service, at a given concurrency and optionally at a given rate, and reports "
+      "the latency of each action along with the throughput, the cpu time and the peak memory of "
+      "the run. Each line of a log is a json request for the default action or an object like "
+      "{\"action\":\"isochrone\",\"request\":{...}}."
+      "\n"
+      "\n");
+
+  // clang-format off
+  options.add_options()
+    ("help,h", "Print this help message.")
+    ("version,v", "Print the version of this software.")
+    ("config,c", bpo::value<filesystem::path>(&config_file_path),
+     "Path to the json configuration file.")
+    ("concurrency,t", bpo::value<size_t>(&concurrency), "How many requests to answer at once.")
+    ("qps,q", bpo::value<double>(&qps),
+     "How many requests to start per second, 0 to start each as soon as a thread is free. The "
+     "latency of a paced request counts from when it was due so a backlog shows in it.")
+    ("repeat,r", bpo::value<size_t>(&repeat), "How many times to replay the logs.")
+    ("action,a", bpo::value<std::string>(&action_str),
+     "The action of the lines which are only a request, route by default.")
+    ("input_files", bpo::value<std::vector<std::string>>(&input_files)->multitoken());
+  // clang-format on
+
+  bpo::positional_options_description pos_options;
+  pos_options.add("input_files", -1);
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).positional(pos_options).run(),
+               vm);
+    bpo::notify(vm);
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "valhalla_benchmark_service " << VALHALLA_VERSION << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  for (const auto& arg : std::vector<std::string>{"config", "input_files"}) {
+    if (vm.count(arg) == 0) {
+      std::cerr << "The <" << arg << "> argument was not provided, but is mandatory\n\n";
+      std::cerr << options << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  Options::Action default_action;
+  if (!Options_Action_Enum_Parse(action_str, &default_action)) {
+    std::cerr << "Unknown action " << action_str << "\n";
+    return EXIT_FAILURE;
+  }
+  concurrency = std::max<size_t>(concurrency, 1);
+
+  // the responses go nowhere so only the failures are worth logging
+  midgard::logging::Configure({{"type", "std_err"}});
+  boost::property_tree::ptree config;
+  rapidjson::read_json(config_file_path.string(), config);
+  const auto requests = read_requests(input_files, default_action);
+  const size_t total = requests.size() * repeat;
+  if (total == 0) {
+    std::cerr << "There are no requests to replay\n";
+    return EXIT_FAILURE;
+  }
+
+  // the actors share the graph reader if its thread safe like the workers of a service do
+  auto reader = std::make_shared<baldr::GraphReader>(config.get_child("mjolnir"));
+  std::vector<std::unique_ptr<tyr::actor_t>> actors;
+  for (size_t i = 0; i < concurrency; ++i) {
+    actors.emplace_back(reader->ThreadSafe() || i == 0 ? new tyr::actor_t(config, *reader, true)
+                                                       : new tyr::actor_t(config, true));
+  }
+
+  // each thread takes the next request, waiting until its due if there is a rate
+  std::vector<sample_t> samples(total);
+  std::atomic<size_t> next(0);
+  const auto start = std::chrono::steady_clock::now();
+  const auto before = usage_t::now();
+  auto work = [&](tyr::actor_t& actor) {
+    for (auto i = next++; i < total; i = next++) {
+      const auto& request = requests[i % requests.size()];
+      auto begin = std::chrono::steady_clock::now();
+      if (qps > 0) {
+        auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double>(i / qps));
+        std::this_thread::sleep_until(due);
+        begin = due;
+      }
+      bool failed = false;
+      try {
+        act(actor, request);
+      } catch (const std::exception& e) {
+        LOG_WARN(Options_Action_Enum_Name(request.action) + " request " +
+                 std::to_string(i % requests.size()) + " failed: " + e.what());
+        failed = true;
+      }
+      auto end = std::chrono::steady_clock::now();
+      samples[i] = {request.action, std::chrono::duration<double, std::milli>(end - begin).count(),
+                    failed};
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < concurrency; ++i) {
+    threads.emplace_back(work, std::ref(*actors[i]));
+  }
+  work(*actors.front());
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const auto after = usage_t::now();
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // the latencies of each action
+  std::map<std::string, std::vector<double>> latencies;
+  std::map<std::string, size_t> failures;
+  for (const auto& sample : samples) {
+    const auto& name = Options_Action_Enum_Name(sample.action);
+    latencies[name].push_back(sample.milliseconds);
+    failures[name] += sample.failed;
+  }
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << std::left << std::setw(20) << "action" << std::right << std::setw(10) << "count"
+            << std::setw(10) << "failed" << std::setw(12) << "mean ms" << std::setw(12) << "p50 ms"
+            << std::setw(12) << "p90 ms" << std::setw(12) << "p99 ms" << std::setw(12) << "max ms"
+            << "\n";
+  for (auto& latency : latencies) {
+    auto& values = latency.second;
+    std::sort(values.begin(), values.end());
+    double sum = 0;
+    for (auto value : values) {
+      sum += value;
+    }
+    std::cout << std::left << std::setw(20) << latency.first << std::right << std::setw(10)
+              << values.size() << std::setw(10) << failures[latency.first] << std::setw(12)
+              << sum / values.size() << std::setw(12) << percentile(values, .5) << std::setw(12)
+              << percentile(values, .9) << std::setw(12) << percentile(values, .99)
+              << std::setw(12) << values.back() << "\n";
+  }
+
+  const double cpu = after.cpu_seconds - before.cpu_seconds;
+  std::cout << "\n"
+            << "requests:    " << total << " on " << concurrency << " threads\n"
+            << "wall time:   " << seconds << " s\n"
+            << "throughput:  " << total / seconds << " requests/s\n"
+            << "cpu time:    " << cpu << " s (" << 100 * cpu / seconds << "% of one core)\n"
+            << "peak rss:    " << after.max_rss_mb << " MB\n";
+
+  return EXIT_SUCCESS;
+}
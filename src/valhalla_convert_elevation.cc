@@ -0,0 +1,52 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "filesystem.h"
+#include "midgard/logging.h"
+#include "skadi/sample.h"
+
+// converts every raw or gzipped hgt tile under a directory into the blocked format
+int main(int argc, char** argv) {
+
+  // check args
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " input_dir output_dir [zlib_level]\n"
+              << "Writes each .hgt or .hgt.gz tile of the input directory as a .hgt.blk tile to "
+                 "the same place in the output directory"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  const filesystem::path input_dir(argv[1]);
+  const filesystem::path output_dir(argv[2]);
+  const int level = argc > 3 ? std::stoi(argv[3]) : 1;
+  if (!filesystem::is_directory(input_dir)) {
+    LOG_ERROR("Elevation directory " + input_dir.string() + " does not exist");
+    return EXIT_FAILURE;
+  }
+
+  size_t count = 0;
+  for (filesystem::recursive_directory_iterator i(input_dir), end; i != end; ++i) {
+    if (!i->is_regular_file()) {
+      continue;
+    }
+    auto name = i->path().string();
+    auto gz = name.size() > 7 && name.compare(name.size() - 7, 7, ".hgt.gz") == 0;
+    if (!gz && (name.size() < 4 || name.compare(name.size() - 4, 4, ".hgt") != 0)) {
+      continue;
+    }
+
+    // keep the NXX directories of the tiles
+    auto relative = name.substr(input_dir.string().size());
+    auto blocked = output_dir.string() + relative.substr(0, relative.size() - (gz ? 3 : 0)) + ".blk";
+    filesystem::create_directories(filesystem::path(blocked).parent_path());
+    if (!valhalla::skadi::sample::convert(name, blocked, level)) {
+      LOG_WARN("Could not read elevation tile " + name);
+      continue;
+    }
+    ++count;
+  }
+
+  LOG_INFO("Converted " + std::to_string(count) + " elevation tiles");
+  return EXIT_SUCCESS;
+}
@@ -10,7 +10,11 @@
 #include "midgard/logging.h"
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 
@@ -27,29 +31,38 @@ std::string row_separator = "\n";
 std::string config;
 bool ferries;
 bool unnamed;
+unsigned int num_threads = 0;
 
 namespace {
 
-// a place we can mark what edges we've seen, even for the planet we should need < 100mb
+// a place we can mark what edges we've seen, even for the planet we should need < 100mb. the bits
+// are atomic so that the threads can claim edges without locking
 struct bitset_t {
-  bitset_t(size_t size) {
-    bits.resize(std::ceil(size / 64.0));
+  bitset_t(size_t size)
+      : size(std::ceil(size / 64.0)), bits(new std::atomic<uint64_t>[this->size]) {
+    for (size_t i = 0; i < this->size; ++i) {
+      bits[i].store(0, std::memory_order_relaxed);
+    }
   }
-  void set(const uint64_t id) {
-    if (id >= bits.size() * 64) {
+  // returns true if the bit was not set before
+  bool set(const uint64_t id) {
+    if (id >= size * 64) {
       throw std::runtime_error("id out of bounds");
     }
-    bits[id / 64] |= static_cast<uint64_t>(1) << (id % static_cast<uint64_t>(64));
+    const auto mask = static_cast<uint64_t>(1) << (id % static_cast<uint64_t>(64));
+    return !(bits[id / 64].fetch_or(mask, std::memory_order_relaxed) & mask);
   }
   bool get(const uint64_t id) const {
-    if (id >= bits.size() * 64) {
+    if (id >= size * 64) {
       throw std::runtime_error("id out of bounds");
     }
-    return bits[id / 64] & (static_cast<uint64_t>(1) << (id % static_cast<uint64_t>(64)));
+    return bits[id / 64].load(std::memory_order_relaxed) &
+           (static_cast<uint64_t>(1) << (id % static_cast<uint64_t>(64)));
   }
 
 protected:
-  std::vector<uint64_t> bits;
+  size_t size;
+  std::unique_ptr<std::atomic<uint64_t>[]> bits;
 };
 
 // often we need both the edge id and the directed edge, so lets have something to represent that
@@ -76,12 +89,31 @@ edge_t opposing(GraphReader& reader, graph_tile_ptr tile, const GraphId& edge_id
   return {opp_id, opp_edge};
 }
 
+// Claims an edge and its opposing edge, returns false if another thread already has them. Both
+// threads meeting on a road contend for the lower of its two edges so exactly one of them gets it
+bool claim(const std::unordered_map<GraphId, uint64_t>& tile_set,
+           bitset_t& edge_set,
+           const edge_t& edge,
+           const edge_t& opposing_edge) {
+  const auto a = tile_set.find(edge.i.Tile_Base())->second + edge.i.id();
+  if (!opposing_edge) {
+    return edge_set.set(a);
+  }
+  const auto b = tile_set.find(opposing_edge.i.Tile_Base())->second + opposing_edge.i.id();
+  if (!edge_set.set(std::min(a, b))) {
+    return false;
+  }
+  edge_set.set(std::max(a, b));
+  return true;
+}
+
 edge_t next(const std::unordered_map<GraphId, uint64_t>& tile_set,
-            const bitset_t& edge_set,
+            bitset_t& edge_set,
             GraphReader& reader,
             graph_tile_ptr& tile,
             const edge_t& edge,
-            const std::vector<std::string>& names) {
+            const std::vector<std::string>& names,
+            edge_t& opposing_edge) {
   // get the right tile
   if (tile->id() != edge.e->endnode().Tile_Base()) {
     tile = reader.GetGraphTile(edge.e->endnode());
@@ -109,11 +141,15 @@ edge_t next(const std::unordered_map<GraphId, uint64_t>& tile_set,
     if (candidate.e->use() == Use::kTransitConnection || candidate.e->IsTransitLine()) {
       continue;
     }
-    // names have to match
-    auto candidate_names = tile->edgeinfo(candidate.e).GetNames();
+    // names have to match and no other thread can have taken it in the meantime, the candidate
+    // and its opposing edge are never used again
+    auto candidate_names = tile->edgeinfo(candidate.e).GetNameViews();
     if (names.size() == candidate_names.size() &&
         std::equal(names.cbegin(), names.cend(), candidate_names.cbegin())) {
-      return candidate;
+      opposing_edge = opposing(reader, tile, candidate);
+      if (claim(tile_set, edge_set, candidate, opposing_edge)) {
+        return candidate;
+      }
     }
   }
 
@@ -142,98 +178,24 @@ void extend(GraphReader& reader,
   shape.splice(shape.end(), more);
 }
 
-} // namespace
-
-// program entry point
-int main(int argc, char* argv[]) {
-  bpo::options_description options("valhalla_export_edges " VALHALLA_VERSION "\n"
-                                   "\n"
-                                   " Usage: valhalla_export_edges [options]\n"
-                                   "\n"
-                                   "valhalla_export_edges is a simple command line test tool which "
-                                   "dumps information about each graph edge. "
-                                   "\n"
-                                   "\n");
-
-  options.add_options()("help,h", "Print this help message.")("version,v",
-                                                              "Print the version of this software.")(
-      "column,c", bpo::value<std::string>(&column_separator),
-      "What separator to use between columns [default=\\0].")(
-      "row,r", bpo::value<std::string>(&column_separator),
-      "What separator to use between row [default=\\n].")("ferries,f",
-                                                          "Export ferries as well [default=false]")(
-      "unnamed,u", "Export unnamed edges as well [default=false]")
-      // positional arguments
-      ("config", bpo::value<std::string>(&config), "Valhalla configuration file [required]");
-
-  bpo::positional_options_description pos_options;
-  pos_options.add("config", 1);
-  bpo::variables_map vm;
-  try {
-    bpo::store(bpo::command_line_parser(argc, argv).options(options).positional(pos_options).run(),
-               vm);
-    bpo::notify(vm);
-  } catch (std::exception& e) {
-    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
-              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
-    return EXIT_FAILURE;
-  }
-
-  if (vm.count("help") || !vm.count("config")) {
-    std::cout << options << "\n";
-    return EXIT_SUCCESS;
-  }
-
-  if (vm.count("version")) {
-    std::cout << "valhalla_export_edges " << VALHALLA_VERSION << "\n";
-    return EXIT_SUCCESS;
-  }
-
-  bool ferries = vm.count("ferries");
-  bool unnamed = vm.count("unnamed");
-
-  // parse the config
-  boost::property_tree::ptree pt;
-  rapidjson::read_json(config.c_str(), pt);
-
-  // configure logging
-  valhalla::midgard::logging::Configure({{"type", "std_err"}, {"color", "true"}});
-
+// Each thread takes the next tile until there are none left and exports the roads starting in it,
+// they are written a tile at a time so the output never has to be kept around
+void export_tiles(const boost::property_tree::ptree& pt,
+                  const std::vector<std::pair<GraphId, uint64_t>>& tiles,
+                  std::atomic<size_t>& next_tile,
+                  const std::unordered_map<GraphId, uint64_t>& tile_set,
+                  bitset_t& edge_set,
+                  const uint64_t edge_count,
+                  std::atomic<uint64_t>& set,
+                  std::atomic<int>& progress,
+                  std::mutex& output_lock) {
   // get something we can use to fetch tiles
   valhalla::baldr::GraphReader reader(pt.get_child("mjolnir"));
-
-  // keep the global number of edges encountered at the point we encounter each tile
-  // this allows an edge to have a sequential global id and makes storing it very small
-  LOG_INFO("Enumerating edges...");
-  std::unordered_map<GraphId, uint64_t> tile_set(kMaxGraphTileId * TileHierarchy::levels().size());
-  uint64_t edge_count = 0;
-  for (const auto& level : TileHierarchy::levels()) {
-    for (uint32_t i = 0; i < level.tiles.TileCount(); ++i) {
-      GraphId tile_id{i, level.level, 0};
-      if (reader.DoesTileExist(tile_id)) {
-        // TODO: just read the header, parsing the whole thing isnt worth it at this point
-        tile_set.emplace(tile_id, edge_count);
-        auto tile = reader.GetGraphTile(tile_id);
-        assert(tile);
-        edge_count += tile->header()->directededgecount();
-        reader.Clear();
-      }
-    }
-  }
-
-  // this is how we know what i've touched and what we havent
-  bitset_t edge_set(edge_count);
-
-  // TODO: we could parallelize this and it might be quite a bit faster but if we really want to
-  // maximize continuous edges we need to avoid the lady and the tramp scenario where two threads
-  // are
-  // consuming the same stretch of road at the same time
+  std::string output;
 
   // for each tile
-  LOG_INFO("Exporting " + std::to_string(edge_count) + " edges");
-  int progress = -1;
-  uint64_t set = 0;
-  for (const auto& tile_count_pair : tile_set) {
+  for (size_t index = next_tile++; index < tiles.size(); index = next_tile++) {
+    const auto& tile_count_pair = tiles[index];
     // for each edge in the tile
     reader.Clear();
     auto tile = reader.GetGraphTile(tile_count_pair.first);
@@ -248,25 +210,26 @@ int main(int argc, char* argv[]) {
       // times maybe we should mark them though once every normal edge connected there has been
       // marked
 
-      // make sure we dont ever look at this again
       edge_t edge{tile_count_pair.first, tile->directededge(i)};
       edge.i.set_id(i);
-      edge_set.set(tile_count_pair.second + i);
-      ++set;
 
       // these wont have opposing edges that we care about
       if (edge.e->use() == Use::kTransitConnection ||
           edge.e->IsTransitLine()) { // these 2 should never happen
+        set += edge_set.set(tile_count_pair.second + i);
         continue;
       }
 
-      // get the opposing edge as well (ensure a valid edge is returned)
+      // get the opposing edge as well and make sure we dont ever look at either again, unless
+      // another thread got to them first
       edge_t opposing_edge = opposing(reader, tile, edge);
+      if (!claim(tile_set, edge_set, edge, opposing_edge)) {
+        continue;
+      }
+      set += opposing_edge.e ? 2 : 1;
       if (opposing_edge.e == nullptr) {
         continue;
       }
-      edge_set.set(tile_set.find(opposing_edge.i.Tile_Base())->second + opposing_edge.i.id());
-      ++set;
 
       // shortcuts arent real and maybe we dont want ferries
       if (edge.e->is_shortcut() || (!ferries && edge.e->use() == Use::kFerry)) {
@@ -288,37 +251,33 @@ int main(int argc, char* argv[]) {
       // can't be guaranteed in the overall graph, but we can create the subgraphs in such a way
       // that
       // they are DAGs. this can produce suboptimal results however and depends on the initial edge.
-      // so for now we'll just greedily export edges
+      // so for now we'll just greedily export edges. when two threads consume the same stretch of
+      // road at the same time it is exported in two parts
 
       // keep some state about this section of road
       std::list<edge_t> edges{edge};
 
       // go forward
       auto t = tile;
-      while ((edge = next(tile_set, edge_set, reader, t, edge, names))) {
-        // mark them to never be used again
-        edge_set.set(tile_set.find(edge.i.Tile_Base())->second + edge.i.id());
-        edge_t other = opposing(reader, t, edge);
+      edge_t other{};
+      while ((edge = next(tile_set, edge_set, reader, t, edge, names, other))) {
+        // the edges were marked to never be used again
+        set += other.e ? 2 : 1;
         if (other.e == nullptr) {
           continue;
         }
-        edge_set.set(tile_set.find(other.i.Tile_Base())->second + other.i.id());
-        set += 2;
         // keep this
         edges.push_back(edge);
       }
 
       // go backward
       edge = opposing_edge;
-      while ((edge = next(tile_set, edge_set, reader, t, edge, names))) {
-        // mark them to never be used again
-        edge_set.set(tile_set.find(edge.i.Tile_Base())->second + edge.i.id());
-        edge_t other = opposing(reader, t, edge);
+      while ((edge = next(tile_set, edge_set, reader, t, edge, names, other))) {
+        // the edges were marked to never be used again
+        set += other.e ? 2 : 1;
         if (other.e == nullptr) {
           continue;
         }
-        edge_set.set(tile_set.find(other.i.Tile_Base())->second + other.i.id());
-        set += 2;
         // keep this
         edges.push_front(other);
       }
@@ -330,21 +289,140 @@ int main(int argc, char* argv[]) {
       }
 
       // output it as: shape,name,name,...
-      auto encoded = encode(shape);
-      std::cout << encoded << column_separator;
+      output += encode(shape);
+      output += column_separator;
       for (const auto& name : names) {
-        std::cout << name << (&name == &names.back() ? "" : column_separator);
+        output += name;
+        output += &name == &names.back() ? "" : column_separator;
       }
-      std::cout << row_separator;
+      output += row_separator;
+    }
+
+    // write out the roads of the tile
+    if (!output.empty()) {
+      std::lock_guard<std::mutex> lock(output_lock);
+      std::cout << output;
       std::cout.flush();
+      output.clear();
     }
 
     // check progress
     int procent = (100.f * set) / edge_count;
-    if (procent > progress) {
-      LOG_INFO(std::to_string(progress = procent) + "%");
+    int reported = progress;
+    while (procent > reported && !progress.compare_exchange_weak(reported, procent)) {
+    }
+    if (procent > reported) {
+      LOG_INFO(std::to_string(procent) + "%");
+    }
+  }
+}
+
+} // namespace
+
+// program entry point
+int main(int argc, char* argv[]) {
+  bpo::options_description options("valhalla_export_edges " VALHALLA_VERSION "\n"
+                                   "\n"
+                                   " Usage: valhalla_export_edges [options]\n"
+                                   "\n"
+                                   "valhalla_export_edges is a simple command line test tool which "
+                                   "dumps information about each graph edge. "
+                                   "\n"
+                                   "\n");
+
+  options.add_options()("help,h", "Print this help message.")("version,v",
+                                                              "Print the version of this software.")(
+      "column,c", bpo::value<std::string>(&column_separator),
+      "What separator to use between columns [default=\\0].")(
+      "row,r", bpo::value<std::string>(&column_separator),
+      "What separator to use between row [default=\\n].")("ferries,f",
+                                                          "Export ferries as well [default=false]")(
+      "unnamed,u", "Export unnamed edges as well [default=false]")(
+      "concurrency,j", bpo::value<unsigned int>(&num_threads),
+      "Number of threads to use [default=number of cores].")
+      // positional arguments
+      ("config", bpo::value<std::string>(&config), "Valhalla configuration file [required]");
+
+  bpo::positional_options_description pos_options;
+  pos_options.add("config", 1);
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).positional(pos_options).run(),
+               vm);
+    bpo::notify(vm);
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help") || !vm.count("config")) {
+    std::cout << options << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "valhalla_export_edges " << VALHALLA_VERSION << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  ferries = vm.count("ferries");
+  unnamed = vm.count("unnamed");
+
+  // parse the config
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(config.c_str(), pt);
+
+  // configure logging
+  valhalla::midgard::logging::Configure({{"type", "std_err"}, {"color", "true"}});
+
+  // get something we can use to fetch tiles
+  valhalla::baldr::GraphReader reader(pt.get_child("mjolnir"));
+
+  // keep the global number of edges encountered at the point we encounter each tile
+  // this allows an edge to have a sequential global id and makes storing it very small
+  LOG_INFO("Enumerating edges...");
+  std::unordered_map<GraphId, uint64_t> tile_set(kMaxGraphTileId * TileHierarchy::levels().size());
+  uint64_t edge_count = 0;
+  for (const auto& level : TileHierarchy::levels()) {
+    for (uint32_t i = 0; i < level.tiles.TileCount(); ++i) {
+      GraphId tile_id{i, level.level, 0};
+      if (reader.DoesTileExist(tile_id)) {
+        // TODO: just read the header, parsing the whole thing isnt worth it at this point
+        tile_set.emplace(tile_id, edge_count);
+        auto tile = reader.GetGraphTile(tile_id);
+        assert(tile);
+        edge_count += tile->header()->directededgecount();
+        reader.Clear();
+      }
     }
   }
+
+  // this is how we know what i've touched and what we havent
+  bitset_t edge_set(edge_count);
+
+  // the threads claim every edge they follow so each one is exported once, they take the tiles one
+  // at a time
+  std::vector<std::pair<GraphId, uint64_t>> tiles(tile_set.cbegin(), tile_set.cend());
+  if (num_threads == 0) {
+    num_threads = std::thread::hardware_concurrency();
+  }
+  num_threads = std::max(1u, num_threads);
+  LOG_INFO("Exporting " + std::to_string(edge_count) + " edges with " +
+           std::to_string(num_threads) + " threads");
+  std::atomic<size_t> next_tile(0);
+  std::atomic<uint64_t> set(0);
+  std::atomic<int> progress(-1);
+  std::mutex output_lock;
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < num_threads; ++i) {
+    threads.emplace_back(export_tiles, std::cref(pt), std::cref(tiles), std::ref(next_tile),
+                         std::cref(tile_set), std::ref(edge_set), edge_count, std::ref(set),
+                         std::ref(progress), std::ref(output_lock));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
   LOG_INFO("Done");
 
   for (uint64_t i = 0; i < edge_count; ++i) {
@@ -1,11 +1,14 @@
 #include "baldr/rapidjson_utils.h"
+#include <algorithm>
 #include <boost/format.hpp>
 #include <boost/optional.hpp>
 #include <boost/program_options.hpp>
 #include <boost/property_tree/ptree.hpp>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -22,6 +25,7 @@
 #include "thor/costmatrix.h"
 #include "thor/optimizer.h"
 #include "thor/timedistancematrix.h"
+#include "tyr/actor.h"
 #include "worker.h"
 
 using namespace valhalla;
@@ -83,6 +87,92 @@ void LogResults(const bool optimize,
   }
 }
 
+// Answers the newline delimited json requests of the batch file, or of stdin for -, in one process
+// on thor.batch_threads threads which share the tiles. Each request gets a line in the output with
+// its line number, how long it took and its response or why it failed. The throughput and the
+// latencies are logged at the end so a batch doubles as a benchmark
+int RunBatch(const boost::property_tree::ptree& config,
+             const std::string& batch_file,
+             const std::string& output_file,
+             const valhalla::Options::Action action) {
+  std::ifstream batch_stream;
+  if (batch_file != "-") {
+    batch_stream.open(batch_file);
+    if (!batch_stream) {
+      std::cerr << "Could not open " << batch_file << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::istream& input = batch_file == "-" ? std::cin : batch_stream;
+  std::vector<std::string> requests;
+  std::vector<size_t> line_numbers;
+  std::string line;
+  for (size_t line_number = 1; std::getline(input, line); ++line_number) {
+    if (line.find_first_not_of(" \t\r") != std::string::npos) {
+      requests.emplace_back(std::move(line));
+      line_numbers.push_back(line_number);
+    }
+  }
+
+  std::ofstream output_stream;
+  if (!output_file.empty()) {
+    output_stream.open(output_file, std::ios::out | std::ios::trunc);
+    if (!output_stream) {
+      std::cerr << "Could not open " << output_file << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::ostream& output = output_file.empty() ? std::cout : output_stream;
+
+  auto t0 = std::chrono::steady_clock::now();
+  valhalla::tyr::actor_t actor(config, true);
+  auto results = actor.batch(requests, action);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  size_t failures = 0;
+  std::vector<double> latencies;
+  latencies.reserve(results.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto& result = results[i];
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.Key("line");
+    writer.Uint64(line_numbers[i]);
+    writer.Key("milliseconds");
+    writer.Double(result.milliseconds);
+    if (result.error) {
+      ++failures;
+      writer.Key("error");
+      try {
+        std::rethrow_exception(result.error);
+      } catch (const std::exception& e) { writer.String(e.what()); } catch (...) {
+        writer.String("unknown error");
+      }
+    } else {
+      writer.Key("response");
+      writer.RawValue(result.response.c_str(), result.response.size(), rapidjson::kObjectType);
+    }
+    writer.EndObject();
+    output << buffer.GetString() << "\n";
+    latencies.push_back(result.milliseconds);
+  }
+  output.flush();
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double fraction) {
+    return latencies.empty() ? 0. : latencies[std::min<size_t>(fraction * latencies.size(),
+                                                               latencies.size() - 1)];
+  };
+  LOG_INFO("Answered " + std::to_string(results.size()) + " requests with " +
+           std::to_string(failures) + " failures in " + std::to_string(seconds) + " s, " +
+           std::to_string(results.size() / std::max(seconds, 1e-9)) + " requests/s");
+  LOG_INFO("Latency (ms) p50= " + std::to_string(percentile(.5)) +
+           " p90= " + std::to_string(percentile(.9)) + " p99= " + std::to_string(percentile(.99)) +
+           " max= " + std::to_string(latencies.empty() ? 0. : latencies.back()));
+  return EXIT_SUCCESS;
+}
+
 // Main method for testing time and distance matrix methods
 int main(int argc, char* argv[]) {
   bpo::options_description poptions(
@@ -96,7 +186,8 @@ int main(int argc, char* argv[]) {
       "\n"
       "\n");
 
-  std::string json, config;
+  std::string json, config, batch_file, output_file;
+  size_t concurrency = 0;
   uint32_t iterations = 1;
   poptions.add_options()("help,h", "Print this help message.")("version,v",
                                                                "Print the version of this software.")(
@@ -111,7 +202,15 @@ int main(int argc, char* argv[]) {
       "York\",\"state\":\"NY\",\"postal_code\":\"10017-3507\",\"country\":\"US\"}],\"costing\":"
       "\"auto\",\"directions_options\":{\"units\":\"miles\"}}'")(
       "multi-run", bpo::value<uint32_t>(&iterations),
-      "Generate the route N additional times before exiting.")
+      "Generate the route N additional times before exiting.")(
+      "batch", bpo::value<std::string>(&batch_file),
+      "File of newline delimited json matrix requests, - for stdin, to answer in one process "
+      "instead of the single -j request. A json line with the line number, the milliseconds and "
+      "the response or error of each request is written to the output.")(
+      "output,o", bpo::value<std::string>(&output_file),
+      "File to write the results of the batch to, stdout by default.")(
+      "concurrency", bpo::value<size_t>(&concurrency),
+      "How many threads answer the batch, thor.batch_threads by default.")
       // positional arguments
       ("config", bpo::value<std::string>(&config), "Valhalla configuration file");
 
@@ -137,10 +236,6 @@ int main(int argc, char* argv[]) {
     return EXIT_SUCCESS;
   }
 
-  Api request;
-  ParseApi(json, valhalla::Options::sources_to_targets, request);
-  const auto& options = request.options();
-
   // parse the config
   boost::property_tree::ptree pt;
   rapidjson::read_json(config.c_str(), pt);
@@ -155,6 +250,18 @@ int main(int argc, char* argv[]) {
     valhalla::midgard::logging::Configure(logging_config);
   }
 
+  // many requests in one process rather than one request in detail
+  if (vm.count("batch")) {
+    if (concurrency) {
+      pt.put("thor.batch_threads", concurrency);
+    }
+    return RunBatch(pt, batch_file, output_file, valhalla::Options::sources_to_targets);
+  }
+
+  Api request;
+  ParseApi(json, valhalla::Options::sources_to_targets, request);
+  const auto& options = request.options();
+
   // Get something we can use to fetch tiles
   valhalla::baldr::GraphReader reader(pt.get_child("mjolnir"));
 
@@ -183,7 +290,8 @@ int main(int argc, char* argv[]) {
     // Skip over any service limits that are not for a costing method
     if (kv.first == "max_exclude_locations" || kv.first == "max_reachability" ||
         kv.first == "max_radius" || kv.first == "max_timedep_distance" || kv.first == "skadi" ||
-        kv.first == "trace" || kv.first == "isochrone") {
+        kv.first == "trace" || kv.first == "isochrone" || kv.first == "request_timeout" ||
+        kv.first == "admission") {
       continue;
     }
     max_matrix_distance.emplace(kv.first,
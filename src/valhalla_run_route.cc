@@ -1,7 +1,9 @@
+#include <algorithm>
 #include <boost/format.hpp>
 #include <boost/optional.hpp>
 #include <boost/program_options.hpp>
 #include <boost/property_tree/ptree.hpp>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
@@ -16,6 +18,7 @@
 #include "baldr/connectivity_map.h"
 #include "baldr/graphreader.h"
 #include "baldr/pathlocation.h"
+#include "baldr/rapidjson_utils.h"
 #include "baldr/tilehierarchy.h"
 #include "loki/search.h"
 #include "loki/worker.h"
@@ -32,6 +35,7 @@
 #include "thor/route_matcher.h"
 #include "thor/triplegbuilder.h"
 #include "thor/unidirectional_astar.h"
+#include "tyr/actor.h"
 #include "worker.h"
 
 #include "proto/api.pb.h"
@@ -525,6 +529,92 @@ valhalla::DirectionsLeg DirectionsTest(valhalla::Api& api,
   return trip_directions;
 }
 
+// Answers the newline delimited json requests of the batch file, or of stdin for -, in one process
+// on thor.batch_threads threads which share the tiles. Each request gets a line in the output with
+// its line number, how long it took and its response or why it failed. The throughput and the
+// latencies are logged at the end so a batch doubles as a benchmark
+int RunBatch(const boost::property_tree::ptree& config,
+             const std::string& batch_file,
+             const std::string& output_file,
+             const valhalla::Options::Action action) {
+  std::ifstream batch_stream;
+  if (batch_file != "-") {
+    batch_stream.open(batch_file);
+    if (!batch_stream) {
+      std::cerr << "Could not open " << batch_file << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::istream& input = batch_file == "-" ? std::cin : batch_stream;
+  std::vector<std::string> requests;
+  std::vector<size_t> line_numbers;
+  std::string line;
+  for (size_t line_number = 1; std::getline(input, line); ++line_number) {
+    if (line.find_first_not_of(" \t\r") != std::string::npos) {
+      requests.emplace_back(std::move(line));
+      line_numbers.push_back(line_number);
+    }
+  }
+
+  std::ofstream output_stream;
+  if (!output_file.empty()) {
+    output_stream.open(output_file, std::ios::out | std::ios::trunc);
+    if (!output_stream) {
+      std::cerr << "Could not open " << output_file << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::ostream& output = output_file.empty() ? std::cout : output_stream;
+
+  auto t0 = std::chrono::steady_clock::now();
+  valhalla::tyr::actor_t actor(config, true);
+  auto results = actor.batch(requests, action);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  size_t failures = 0;
+  std::vector<double> latencies;
+  latencies.reserve(results.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto& result = results[i];
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.Key("line");
+    writer.Uint64(line_numbers[i]);
+    writer.Key("milliseconds");
+    writer.Double(result.milliseconds);
+    if (result.error) {
+      ++failures;
+      writer.Key("error");
+      try {
+        std::rethrow_exception(result.error);
+      } catch (const std::exception& e) { writer.String(e.what()); } catch (...) {
+        writer.String("unknown error");
+      }
+    } else {
+      writer.Key("response");
+      writer.RawValue(result.response.c_str(), result.response.size(), rapidjson::kObjectType);
+    }
+    writer.EndObject();
+    output << buffer.GetString() << "\n";
+    latencies.push_back(result.milliseconds);
+  }
+  output.flush();
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double fraction) {
+    return latencies.empty() ? 0. : latencies[std::min<size_t>(fraction * latencies.size(),
+                                                               latencies.size() - 1)];
+  };
+  LOG_INFO("Answered " + std::to_string(results.size()) + " requests with " +
+           std::to_string(failures) + " failures in " + std::to_string(seconds) + " s, " +
+           std::to_string(results.size() / std::max(seconds, 1e-9)) + " requests/s");
+  LOG_INFO("Latency (ms) p50= " + std::to_string(percentile(.5)) +
+           " p90= " + std::to_string(percentile(.9)) + " p99= " + std::to_string(percentile(.99)) +
+           " max= " + std::to_string(latencies.empty() ? 0. : latencies.back()));
+  return EXIT_SUCCESS;
+}
+
 // Main method for testing a single path
 int main(int argc, char* argv[]) {
   bpo::options_description poptions(
@@ -538,7 +628,8 @@ int main(int argc, char* argv[]) {
       "\n"
       "\n");
 
-  std::string json, json_file, config;
+  std::string json, json_file, config, batch_file, output_file;
+  size_t concurrency = 0;
   bool multi_run = false;
   bool match_test = false;
   bool verbose_lanes = false;
@@ -560,7 +651,15 @@ int main(int argc, char* argv[]) {
       "multi-run", bpo::value<uint32_t>(&iterations),
       "Generate the route N additional times before exiting.")(
       "verbose-lanes", bpo::bool_switch(&verbose_lanes),
-      "Include verbose lanes output in DirectionsTest.")
+      "Include verbose lanes output in DirectionsTest.")(
+      "batch", bpo::value<std::string>(&batch_file),
+      "File of newline delimited json route requests, - for stdin, to answer in one process "
+      "instead of the single -j request. A json line with the line number, the milliseconds and "
+      "the response or error of each request is written to the output.")(
+      "output,o", bpo::value<std::string>(&output_file),
+      "File to write the results of the batch to, stdout by default.")(
+      "concurrency", bpo::value<size_t>(&concurrency),
+      "How many threads answer the batch, thor.batch_threads by default.")
       // positional arguments
       ("config", bpo::value<std::string>(&config), "Valhalla configuration file");
 
@@ -604,6 +703,28 @@ int main(int argc, char* argv[]) {
     json.assign((std::istreambuf_iterator<char>(ifs)), (std::istreambuf_iterator<char>()));
   }
 
+  // parse the config
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(config.c_str(), pt);
+
+  // configure logging
+  boost::optional<boost::property_tree::ptree&> logging_subtree =
+      pt.get_child_optional("thor.logging");
+  if (logging_subtree) {
+    auto logging_config =
+        valhalla::midgard::ToMap<const boost::property_tree::ptree&,
+                                 std::unordered_map<std::string, std::string>>(logging_subtree.get());
+    valhalla::midgard::logging::Configure(logging_config);
+  }
+
+  // many requests in one process rather than one request in detail
+  if (vm.count("batch")) {
+    if (concurrency) {
+      pt.put("thor.batch_threads", concurrency);
+    }
+    return RunBatch(pt, batch_file, output_file, valhalla::Options::route);
+  }
+
   // Grab the directions options, if they exist
   valhalla::Api request;
   valhalla::ParseApi(json, valhalla::Options::route, request);
@@ -618,20 +739,6 @@ int main(int argc, char* argv[]) {
   if (locations.size() < 2) {
     throw;
   }
-
-  // parse the config
-  boost::property_tree::ptree pt;
-  rapidjson::read_json(config.c_str(), pt);
-
-  // configure logging
-  boost::optional<boost::property_tree::ptree&> logging_subtree =
-      pt.get_child_optional("thor.logging");
-  if (logging_subtree) {
-    auto logging_config =
-        valhalla::midgard::ToMap<const boost::property_tree::ptree&,
-                                 std::unordered_map<std::string, std::string>>(logging_subtree.get());
-    valhalla::midgard::logging::Configure(logging_config);
-  }
   // Something to hold the statistics
   uint32_t n = locations.size() - 1;
   PathStatistics data({locations[0].latlng_.lat(), locations[0].latlng_.lng()},
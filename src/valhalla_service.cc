@@ -1,3 +1,5 @@
+#include <chrono>
+#include <csignal>
 #include <fstream>
 #include <functional>
 #include <iostream>
@@ -27,16 +29,27 @@ using namespace prime_server;
 #include "thor/worker.h"
 #include "tyr/actor.h"
 
+#ifdef HAVE_HTTP
+namespace {
+// set by SIGHUP to have the tiles reloaded
+volatile std::sig_atomic_t reload_requested = 0;
+} // namespace
+#endif
+
 int main(int argc, char** argv) {
 #ifdef HAVE_HTTP
-  if (argc < 2 || argc > 4) {
+  if (argc < 2 || argc > 5) {
     LOG_ERROR("Usage: " + std::string(argv[0]) + " config/file.json [concurrency]");
     LOG_ERROR("Usage: " + std::string(argv[0]) + " config/file.json action json_request");
+    LOG_ERROR("Usage: " + std::string(argv[0]) +
+              " config/file.json locate json_request locations.ndjson|-");
     return 1;
   }
 #else
-  if (argc < 4) {
+  if (argc < 4 || argc > 5) {
     LOG_ERROR("Usage: " + std::string(argv[0]) + " config/file.json action json_request");
+    LOG_ERROR("Usage: " + std::string(argv[0]) +
+              " config/file.json locate json_request locations.ndjson|-");
     return 1;
   }
 #endif
@@ -48,7 +61,7 @@ int main(int argc, char** argv) {
   rapidjson::read_json(config_file, config);
 
   // one shot direct request mode
-  if (argc == 4) {
+  if (argc >= 4) {
     // because we want the program output to go only to stdout we force any logging to be stderr
     valhalla::midgard::logging::Configure({{"type", "std_err"}});
 
@@ -83,6 +96,28 @@ int main(int argc, char** argv) {
     // do the right action
     valhalla::Api request;
     try {
+      // batch mode streams a line of output per line of newline delimited json locations
+      if (argc == 5) {
+        if (action != valhalla::Options::locate) {
+          std::cerr << "Only locate has a batch mode" << std::endl;
+          return 1;
+        }
+        std::function<void(const std::string&)> write = [](const std::string& piece) {
+          std::cout << piece;
+        };
+        std::ifstream locations_file;
+        if (std::string(argv[4]) != "-") {
+          locations_file.open(argv[4]);
+          if (!locations_file) {
+            std::cerr << "Could not open " << argv[4] << std::endl;
+            return 1;
+          }
+        }
+        actor.locate_batch(request_str, locations_file.is_open() ? locations_file : std::cin,
+                           write);
+        std::cout << std::flush;
+        return 0;
+      }
       switch (action) {
         case valhalla::Options::route:
           std::cout << actor.route(request_str, nullptr, &request) << std::endl;
@@ -171,12 +206,52 @@ int main(int argc, char** argv) {
     valhalla::midgard::logging::Configure(logging_config);
   }
 
+  // a SIGHUP reloads the tiles named in the config file without a restart, the workers sharing the
+  // reader keep answering requests with the old tiles until the new ones are warmed up
+  if (config.get<bool>("mjolnir.thread_safe_reader", false)) {
+    std::signal(SIGHUP, [](int) { reload_requested = 1; });
+    std::thread([config_file]() {
+      while (true) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        if (!reload_requested) {
+          continue;
+        }
+        reload_requested = 0;
+        try {
+          boost::property_tree::ptree reloaded;
+          rapidjson::read_json(config_file, reloaded);
+          valhalla::reload_shared_graph_reader(reloaded);
+        } catch (const std::exception& e) {
+          LOG_ERROR("Failed to reload the tiles, keeping the old ones: " + std::string(e.what()));
+        }
+      }
+    }).detach();
+  }
+
   // number of workers to use at each stage
   auto worker_concurrency = std::thread::hardware_concurrency();
   if (argc > 2) {
     worker_concurrency = std::stoul(argv[2]);
   }
 
+  // with numa_pinning the workers of each stage are spread over the NUMA nodes and pinned to the
+  // cpus of theirs, so their memory and the tiles of the shared reader of their node are local
+  size_t numa_node_count = 0;
+  if (config.get<bool>("httpd.service.numa_pinning", false)) {
+    numa_node_count = valhalla::numa_nodes().size();
+    LOG_INFO("Spreading the workers over " + std::to_string(numa_node_count) + " NUMA nodes");
+  }
+  auto start_worker = [&config, numa_node_count](std::list<std::thread>& threads, size_t i,
+                                                 void (*run)(const boost::property_tree::ptree&)) {
+    threads.emplace_back([config, numa_node_count, i, run]() {
+      if (numa_node_count > 1 && !valhalla::pin_to_numa_node(i % numa_node_count)) {
+        LOG_WARN("Failed to pin a worker to NUMA node " + std::to_string(i % numa_node_count));
+      }
+      run(config);
+    });
+    threads.back().detach();
+  };
+
   // setup the cluster within this process
   zmq::context_t context;
   std::thread server_thread =
@@ -187,10 +262,20 @@ int main(int argc, char** argv) {
   std::thread loki_proxy_thread(
       std::bind(&proxy_t::forward, proxy_t(context, loki_proxy + "_in", loki_proxy + "_out")));
   loki_proxy_thread.detach();
+
+  // every worker can answer a request on its own so there is no need for the other layers
+  if (config.get<bool>("httpd.service.single_stage", false)) {
+    std::list<std::thread> worker_threads;
+    for (size_t i = 0; i < worker_concurrency; ++i) {
+      start_worker(worker_threads, i, valhalla::tyr::run_service);
+    }
+    server_thread.join();
+    return 0;
+  }
+
   std::list<std::thread> loki_worker_threads;
   for (size_t i = 0; i < worker_concurrency; ++i) {
-    loki_worker_threads.emplace_back(valhalla::loki::run_service, config);
-    loki_worker_threads.back().detach();
+    start_worker(loki_worker_threads, i, valhalla::loki::run_service);
   }
 
   // thor layer
@@ -199,8 +284,7 @@ int main(int argc, char** argv) {
   thor_proxy_thread.detach();
   std::list<std::thread> thor_worker_threads;
   for (size_t i = 0; i < worker_concurrency; ++i) {
-    thor_worker_threads.emplace_back(valhalla::thor::run_service, config);
-    thor_worker_threads.back().detach();
+    start_worker(thor_worker_threads, i, valhalla::thor::run_service);
   }
 
   // odin layer
@@ -209,8 +293,7 @@ int main(int argc, char** argv) {
   odin_proxy_thread.detach();
   std::list<std::thread> odin_worker_threads;
   for (size_t i = 0; i < worker_concurrency; ++i) {
-    odin_worker_threads.emplace_back(valhalla::odin::run_service, config);
-    odin_worker_threads.back().detach();
+    start_worker(odin_worker_threads, i, valhalla::odin::run_service);
   }
 
   // TODO: add multipoint accumulator
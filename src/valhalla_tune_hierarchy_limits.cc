@@ -0,0 +1,283 @@
+#include "config.h"
+
+#include "baldr/graphreader.h"
+#include "baldr/rapidjson_utils.h"
+#include "filesystem.h"
+#include "loki/worker.h"
+#include "midgard/logging.h"
+#include "proto_conversions.h"
+#include "sif/costfactory.h"
+#include "sif/hierarchylimits.h"
+#include "thor/bidirectional_astar.h"
+#include "worker.h"
+
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace bpo = boost::program_options;
+using namespace valhalla;
+
+namespace {
+
+// how a leg of one of the requests went with each of the factors
+struct leg_t {
+  std::string costing;
+  uint32_t origin_region;
+  uint32_t destination_region;
+  // the labels made with each factor, 0 if the route was worse than with the default limits
+  std::vector<uint64_t> labels;
+};
+
+// the legs of the regions of each costing
+using regions_t = std::map<std::pair<std::string, uint32_t>, std::vector<size_t>>;
+
+/**
+ * Routes a leg with the first pass of bidirectional a* the way the service does, with the limits
+ * scaled by the factor in both of its regions.
+ * @return the cost of the route and the labels the search made, a negative cost if there is none
+ */
+std::pair<float, uint64_t> route(thor::BidirectionalAStar& astar,
+                                 baldr::GraphReader& reader,
+                                 const Options& options,
+                                 const sif::mode_costing_t& mode_costing,
+                                 const sif::TravelMode mode,
+                                 const valhalla::Location& origin,
+                                 const valhalla::Location& destination,
+                                 const uint32_t origin_region,
+                                 const uint32_t destination_region,
+                                 const float factor) {
+  const auto costing = Costing_Enum_Name(options.costing());
+  auto table = std::make_shared<sif::HierarchyLimitsTable>();
+  table->Set(costing, origin_region, factor);
+  table->Set(costing, destination_region, factor);
+  astar.set_hierarchy_limits_table(table);
+  astar.Clear();
+
+  auto cost = mode_costing[static_cast<uint32_t>(mode)];
+  cost->set_pass(0);
+  cost->set_allow_destination_only(false);
+  auto o = origin;
+  auto d = destination;
+  auto paths = astar.GetBestPath(o, d, reader, mode_costing, mode, options);
+  const auto labels = astar.Stats().labels;
+  if (paths.empty() || paths.front().empty()) {
+    return {-1.f, labels};
+  }
+  return {paths.front().back().elapsed_cost.cost, labels};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  filesystem::path config_file_path;
+  std::string factors_str = "1,0.75,0.5,0.35,0.25";
+  std::string output_file;
+  float tolerance = 0.001f;
+  size_t min_legs = 10;
+  std::vector<std::string> input_files;
+
+  bpo::options_description options(
+      "valhalla_tune_hierarchy_limits " VALHALLA_VERSION "\n"
+      "\n"
+      " Usage: valhalla_tune_hierarchy_limits [options] <request_log> ...\n"
+      "\n"
+      "valhalla_tune_hierarchy_limits learns how far the hierarchy limits of the first pass of "
+      "bidirectional a* can be scaled down in each region without making the routes worse. Each "
+      "line of a log is a json route request. Every leg is routed with each of the factors in the "
+      "regions it starts and ends in. A region of a costing keeps the smallest factor whose routes "
+      "all cost no more than with the default limits. The table it writes is what "
+      "thor.hierarchy_limits_table loads."
+      "\n"
+      "\n");
+
+  // clang-format off
+  options.add_options()
+    ("help,h", "Print this help message.")
+    ("version,v", "Print the version of this software.")
+    ("config,c", bpo::value<filesystem::path>(&config_file_path),
+     "Path to the json configuration file.")
+    ("output,o", bpo::value<std::string>(&output_file),
+     "File to write the table to, stdout by default.")
+    ("factors,f", bpo::value<std::string>(&factors_str),
+     "Comma separated factors to try, 1 is the default limits and always tried.")
+    ("tolerance,t", bpo::value<float>(&tolerance),
+     "How much more a route may cost than with the default limits, as a fraction of its cost.")
+    ("min-legs,m", bpo::value<size_t>(&min_legs),
+     "How many legs a region needs to have for its limits to be tuned.")
+    ("input_files", bpo::value<std::vector<std::string>>(&input_files)->multitoken());
+  // clang-format on
+
+  bpo::positional_options_description pos_options;
+  pos_options.add("input_files", -1);
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).positional(pos_options).run(),
+               vm);
+    bpo::notify(vm);
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "valhalla_tune_hierarchy_limits " << VALHALLA_VERSION << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  for (const auto& arg : std::vector<std::string>{"config", "input_files"}) {
+    if (vm.count(arg) == 0) {
+      std::cerr << "The <" << arg << "> argument was not provided, but is mandatory\n\n";
+      std::cerr << options << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // the default limits come first, the others from the largest to the smallest
+  std::vector<float> factors{1.f};
+  std::istringstream factors_stream(factors_str);
+  for (std::string factor; std::getline(factors_stream, factor, ',');) {
+    const float value = std::stof(factor);
+    if (!(value > 0) || value > 1) {
+      std::cerr << "Factors have to be in (0, 1]: " << factor << "\n";
+      return EXIT_FAILURE;
+    }
+    if (value < 1) {
+      factors.push_back(value);
+    }
+  }
+  std::sort(factors.begin() + 1, factors.end(), std::greater<float>());
+  factors.erase(std::unique(factors.begin(), factors.end()), factors.end());
+
+  boost::property_tree::ptree config;
+  rapidjson::read_json(config_file_path.string(), config);
+  midgard::logging::Configure({{"type", "std_err"}});
+
+  baldr::GraphReader reader(config.get_child("mjolnir"));
+  loki::loki_worker_t loki_worker(config);
+  thor::BidirectionalAStar astar(config.get_child("thor"));
+  sif::CostFactory factory;
+
+  // route every leg of every request with each of the factors
+  std::vector<leg_t> legs;
+  regions_t regions;
+  size_t requests = 0, failed = 0;
+  for (const auto& file : input_files) {
+    std::ifstream stream(file);
+    if (!stream) {
+      std::cerr << "Could not open " << file << "\n";
+      return EXIT_FAILURE;
+    }
+    for (std::string line; std::getline(stream, line);) {
+      if (line.find_first_not_of(" \t\r") == std::string::npos) {
+        continue;
+      }
+      ++requests;
+      try {
+        Api api;
+        ParseApi(line, Options::route, api);
+        loki_worker.route(api);
+        const auto& options = api.options();
+        sif::TravelMode mode;
+        auto mode_costing = factory.CreateModeCosting(options, mode);
+        const auto costing = Costing_Enum_Name(options.costing());
+        for (int i = 0; i + 1 < options.locations_size(); ++i) {
+          const auto& origin = options.locations(i);
+          const auto& destination = options.locations(i + 1);
+          leg_t leg{costing,
+                    sif::HierarchyLimitsTable::Region({origin.ll().lng(), origin.ll().lat()}),
+                    sif::HierarchyLimitsTable::Region(
+                        {destination.ll().lng(), destination.ll().lat()}),
+                    {}};
+          float best = -1;
+          for (const auto factor : factors) {
+            auto result = route(astar, reader, options, mode_costing, mode, origin, destination,
+                                leg.origin_region, leg.destination_region, factor);
+            if (factor == 1.f) {
+              best = result.first;
+            }
+            const bool good = best >= 0 && result.first >= 0 &&
+                              result.first <= best * (1 + tolerance);
+            leg.labels.push_back(good ? std::max<uint64_t>(result.second, 1) : 0);
+          }
+          if (best < 0) {
+            continue;
+          }
+          for (const auto region : {leg.origin_region, leg.destination_region}) {
+            auto& indices = regions[{costing, region}];
+            if (indices.empty() || indices.back() != legs.size()) {
+              indices.push_back(legs.size());
+            }
+          }
+          legs.emplace_back(std::move(leg));
+        }
+      } catch (const std::exception& e) {
+        LOG_WARN(file + " request " + std::to_string(requests) + " failed: " + e.what());
+        ++failed;
+      }
+    }
+  }
+
+  // each region keeps the smallest factor that was good for all of its legs
+  sif::HierarchyLimitsTable table;
+  std::map<std::pair<std::string, uint32_t>, size_t> chosen;
+  for (const auto& region : regions) {
+    size_t best = 0;
+    if (region.second.size() >= min_legs) {
+      for (size_t f = 1; f < factors.size(); ++f) {
+        const bool good =
+            std::all_of(region.second.cbegin(), region.second.cend(),
+                        [&legs, f](size_t leg) { return legs[leg].labels[f] != 0; });
+        if (good) {
+          best = f;
+        }
+      }
+    }
+    chosen[region.first] = best;
+    if (best != 0) {
+      table.Set(region.first.first, region.first.second, factors[best]);
+    }
+  }
+
+  // how much less the legs expand with the limits they would get from the table
+  uint64_t default_labels = 0, tuned_labels = 0;
+  for (const auto& leg : legs) {
+    const size_t f = std::min(chosen[{leg.costing, leg.origin_region}],
+                              chosen[{leg.costing, leg.destination_region}]);
+    default_labels += leg.labels.front();
+    tuned_labels += leg.labels[f];
+  }
+  LOG_INFO("Routed " + std::to_string(legs.size()) + " legs of " + std::to_string(requests) +
+           " requests, " + std::to_string(failed) + " failed");
+  LOG_INFO("Tuned " + std::to_string(std::count_if(chosen.cbegin(), chosen.cend(),
+                                                   [](const auto& c) { return c.second != 0; })) +
+           " of " + std::to_string(chosen.size()) + " regions, the legs make " +
+           std::to_string(tuned_labels) + " labels instead of " + std::to_string(default_labels));
+
+  if (output_file.empty()) {
+    std::cout << table.ToJson() << std::endl;
+  } else {
+    std::ofstream output(output_file);
+    output << table.ToJson() << std::endl;
+    if (!output) {
+      std::cerr << "Could not write " << output_file << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -1,9 +1,39 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "baldr/compression_utils.h"
 #include "baldr/datetime.h"
 #include "baldr/graphconstants.h"
+#include "baldr/graphreader.h"
 #include "baldr/location.h"
 #include "midgard/encoded.h"
 #include "midgard/logging.h"
@@ -88,9 +118,9 @@ const std::unordered_map<unsigned, std::string> HTTP_STATUS_CODES{
 
 // from valhalla error code to http status code
 const std::unordered_map<unsigned, unsigned> ERROR_TO_STATUS{
-    {100, 400}, {101, 405}, {102, 503}, {106, 404}, {107, 501},
+    {100, 400}, {101, 405}, {102, 503}, {103, 400}, {104, 504}, {105, 503}, {106, 404}, {107, 501},
 
-    {110, 400}, {111, 400}, {112, 400}, {113, 400}, {114, 400},
+    {110, 400}, {111, 400}, {112, 400}, {113, 400}, {114, 400}, {115, 400},
 
     {120, 400}, {121, 400}, {122, 400}, {123, 400}, {124, 400}, {125, 400}, {126, 400}, {127, 400},
 
@@ -102,6 +132,7 @@ const std::unordered_map<unsigned, unsigned> ERROR_TO_STATUS{
     {158, 400}, {159, 400},
 
     {160, 400}, {161, 400}, {162, 400}, {163, 400}, {164, 400}, {165, 400}, {166, 400}, {167, 400},
+    {168, 400},
 
     {170, 400}, {171, 400}, {172, 400},
 
@@ -143,6 +174,8 @@ const std::unordered_map<unsigned, std::string> OSRM_ERRORS_CODES{
     {100, R"({"code":"InvalidUrl","message":"URL string is invalid."})"},
     {101, R"({"code":"InvalidUrl","message":"URL string is invalid."})"},
     {102, R"({"code":"ServiceUnavailable","message":"The service is shutting down."})"},
+    {104, R"({"code":"Timeout","message":"The request took longer than its deadline."})"},
+    {105, R"({"code":"ServiceUnavailable","message":"The service is too busy."})"},
     {106, R"({"code":"InvalidService","message":"Service name is invalid."})"},
     {107, R"({"code":"InvalidService","message":"Service name is invalid."})"},
     {110, R"({"code":"InvalidOptions","message":"Options are invalid."})"},
@@ -293,17 +326,75 @@ const std::unordered_map<unsigned, std::string> OSRM_ERRORS_CODES{
 
     {599, R"({"code":"InvalidUrl","message":"URL string is invalid."})"}};
 
-rapidjson::Document from_string(const std::string& json, const valhalla_exception_t& e) {
-  rapidjson::Document d;
-  if (json.empty()) {
-    d.SetObject();
-    return d;
+// Keeps the memory it takes to parse the json of a request around between the requests of a
+// thread. The strings are parsed in place in a copy of the request and all of the values are
+// allocated out of a pool, so the document of a typical request needs no allocations at all. Only
+// one can be alive per thread at a time
+class request_document_t {
+public:
+  request_document_t(const char* json, size_t size)
+      : allocator(pool().data(), pool().size()), document(&allocator) {
+    if (size == 0) {
+      document.SetObject();
+      return;
+    }
+    auto& buffer = insitu();
+    buffer.assign(json, size);
+    document.ParseInsitu(&buffer[0]);
+    if (document.HasParseError()) {
+      throw valhalla_exception_t{100};
+    }
+  }
+  rapidjson::Document& operator*() {
+    return document;
+  }
+
+protected:
+  static constexpr size_t kPoolSize = 64 * 1024;
+  static std::vector<char>& pool() {
+    thread_local std::vector<char> pool(kPoolSize);
+    return pool;
   }
-  d.Parse(json.c_str());
-  if (d.HasParseError()) {
-    throw e;
+  static std::string& insitu() {
+    thread_local std::string insitu;
+    return insitu;
+  }
+
+  rapidjson::MemoryPoolAllocator<> allocator;
+  rapidjson::Document document;
+};
+
+constexpr uint32_t MAX_HEIGHT_PRECISION = 2;
+
+// The largest first block of the arena of a request, requests needing more get further blocks
+constexpr size_t kMaxArenaBlockSize = 16 * 1024 * 1024;
+
+// Makes a message in the arena of another, when it has one, so that swapping the two moves rather
+// than deep copies them. Without an arena the message is owned by the returned pointer
+template <typename message_t>
+std::unique_ptr<message_t, void (*)(message_t*)>
+arena_local(const google::protobuf::MessageLite& other) {
+  auto* arena = other.GetArena();
+  void (*deleter)(message_t*) = [](message_t* message) { delete message; };
+  if (arena) {
+    deleter = [](message_t*) {};
+  }
+  return {google::protobuf::Arena::CreateMessage<message_t>(arena), deleter};
+}
+
+// Only the height action knows how to answer in binary and only the actions which make a trip, a
+// matrix or isochrones know how to answer with the Api as pbf
+bool format_allowed(Options::Format format, Options::Action action) {
+  switch (format) {
+    case Options::binary:
+      return action == Options::height;
+    case Options::pbf:
+      return action == Options::route || action == Options::optimized_route ||
+             action == Options::trace_route || action == Options::trace_attributes ||
+             action == Options::sources_to_targets || action == Options::isochrone;
+    default:
+      return true;
   }
-  return d;
 }
 
 void add_date_to_locations(Options& options,
@@ -628,6 +719,116 @@ void parse_contours(const rapidjson::Document& doc,
   }
 }
 
+// Grabs the coordinate of the tile from the tile object or from the top level, where the query
+// parameters end up as strings
+boost::optional<uint32_t> get_tile_coordinate(const rapidjson::Document& doc, const char* name) {
+  for (const auto& prefix : {"/tile/", "/"}) {
+    const auto* value = rapidjson::Pointer((std::string(prefix) + name).c_str()).Get(doc);
+    if (!value) {
+      continue;
+    }
+    if (value->IsUint()) {
+      return value->GetUint();
+    }
+    if (value->IsString()) {
+      try {
+        size_t pos = 0;
+        auto coordinate = std::stoul(value->GetString(), &pos);
+        if (pos == value->GetStringLength() && coordinate <= std::numeric_limits<uint32_t>::max()) {
+          return static_cast<uint32_t>(coordinate);
+        }
+      } catch (...) {}
+    }
+    throw valhalla_exception_t{115};
+  }
+  return boost::none;
+}
+
+void parse_tile(const rapidjson::Document& doc, Options& options) {
+  auto z = get_tile_coordinate(doc, "z");
+  auto x = get_tile_coordinate(doc, "x");
+  auto y = get_tile_coordinate(doc, "y");
+  // the zoom must leave room for the column and row in a 64 bit key
+  if (!z || !x || !y || *z > 24 || *x >= (1u << *z) || *y >= (1u << *z)) {
+    throw valhalla_exception_t{115};
+  }
+  auto* tile = options.mutable_tile_xyz();
+  tile->set_z(*z);
+  tile->set_x(*x);
+  tile->set_y(*y);
+}
+
+// Decodes the encoded polyline of the request into its shape
+void decode_shape(Options& options) {
+  // Set the precision to use when decoding the polyline. For height actions (only)
+  // either polyline6 (default) or polyline5 are supported. All other actions only
+  // support polyline6 inputs at this time.
+  double precision = 1e-6;
+  if (options.action() == Options::height) {
+    precision = options.shape_format() == valhalla::polyline5 ? 1e-5 : 1e-6;
+  }
+
+  auto decoded =
+      midgard::decode<std::vector<midgard::PointLL>>(options.encoded_polyline(), precision);
+  for (const auto& ll : decoded) {
+    auto* sll = options.mutable_shape()->Add();
+    sll->mutable_ll()->set_lat(ll.lat());
+    sll->mutable_ll()->set_lng(ll.lng());
+    // set type to via by default
+    sll->set_type(valhalla::Location::kVia);
+  }
+  // first and last always get type break
+  if (options.shape_size()) {
+    options.mutable_shape(0)->set_type(valhalla::Location::kBreak);
+    options.mutable_shape(options.shape_size() - 1)->set_type(valhalla::Location::kBreak);
+  }
+  // add the date time
+  add_date_to_locations(options, *options.mutable_shape());
+}
+
+// Disables the time dependent edge speed/flow data sources of all the costings
+void disable_time_dependence(Options& options) {
+  for (auto& costing : *options.mutable_costing_options()) {
+    costing.set_flow_mask(
+        static_cast<uint8_t>(costing.flow_mask()) &
+        ~(valhalla::baldr::kPredictedFlowMask | valhalla::baldr::kCurrentFlowMask));
+  }
+}
+
+// Makes sure the date time type has a valid value and that the request can be time dependent
+void check_date_time(Options& options) {
+  if (options.has_date_time_type()) {
+    // check the value exists for depart at and arrive by
+    if (!options.has_date_time()) {
+      if (options.date_time_type() == Options::depart_at)
+        throw valhalla_exception_t{160};
+      else if (options.date_time_type() == Options::arrive_by)
+        throw valhalla_exception_t{161};
+      else if (options.date_time_type() == Options::invariant)
+        throw valhalla_exception_t{165};
+    }
+    // check the value is sane
+    if (options.date_time() != "current" && !baldr::DateTime::is_iso_valid(options.date_time()))
+      throw valhalla_exception_t{162};
+  } // not specified but you want transit, then we default to current
+  else if (options.has_costing() &&
+           (options.costing() == multimodal || options.costing() == transit)) {
+    options.set_date_time_type(Options::current);
+    options.set_date_time("current");
+  }
+
+  // failure scenarios with respect to time dependence
+  if (options.has_date_time_type()) {
+    if (options.date_time_type() == Options::arrive_by ||
+        options.date_time_type() == Options::invariant) {
+      if (options.costing() == multimodal || options.costing() == transit)
+        throw valhalla_exception_t{141};
+      if (options.action() == Options::isochrone)
+        throw valhalla_exception_t{142};
+    }
+  }
+}
+
 void from_json(rapidjson::Document& doc, Options& options) {
   // TODO: stop doing this after a sufficient amount of time has passed
   // move anything nested in deprecated directions_options up to the top level
@@ -646,7 +847,8 @@ void from_json(rapidjson::Document& doc, Options& options) {
 
   auto fmt = rapidjson::get_optional<std::string>(doc, "/format");
   Options::Format format;
-  if (fmt && Options_Format_Enum_Parse(*fmt, &format)) {
+  if (fmt && Options_Format_Enum_Parse(*fmt, &format) &&
+      format_allowed(format, options.action())) {
     options.set_format(format);
   }
 
@@ -655,8 +857,9 @@ void from_json(rapidjson::Document& doc, Options& options) {
     options.set_id(*id);
   }
 
+  // there is no wrapping a pbf in a javascript callback
   auto jsonp = rapidjson::get_optional<std::string>(doc, "/jsonp");
-  if (jsonp) {
+  if (jsonp && options.format() != Options::pbf && options.action() != Options::tile) {
     options.set_jsonp(*jsonp);
   }
 
@@ -694,39 +897,15 @@ void from_json(rapidjson::Document& doc, Options& options) {
     if (v >= Options::DateTimeType_ARRAYSIZE)
       throw valhalla_exception_t{163};
     options.set_date_time_type(static_cast<Options::DateTimeType>(v));
-    // check the value exists for depart at and arrive by
+    // the value of current is implied
     auto date_time_value = v != Options::current
                                ? rapidjson::get_optional<std::string>(doc, "/date_time/value")
                                : std::string("current");
-    if (!date_time_value) {
-      if (v == Options::depart_at)
-        throw valhalla_exception_t{160};
-      else if (v == Options::arrive_by)
-        throw valhalla_exception_t{161};
-      else if (v == Options::invariant)
-        throw valhalla_exception_t{165};
-    }
-    // check the value is sane
-    if (*date_time_value != "current" && !baldr::DateTime::is_iso_valid(*date_time_value))
-      throw valhalla_exception_t{162};
-    options.set_date_time(*date_time_value);
-  } // not specified but you want transit, then we default to current
-  else if (options.has_costing() &&
-           (options.costing() == multimodal || options.costing() == transit)) {
-    options.set_date_time_type(Options::current);
-    options.set_date_time("current");
-  }
-
-  // failure scenarios with respect to time dependence
-  if (options.has_date_time_type()) {
-    if (options.date_time_type() == Options::arrive_by ||
-        options.date_time_type() == Options::invariant) {
-      if (options.costing() == multimodal || options.costing() == transit)
-        throw valhalla_exception_t{141};
-      if (options.action() == Options::isochrone)
-        throw valhalla_exception_t{142};
+    if (date_time_value) {
+      options.set_date_time(*date_time_value);
     }
   }
+  check_date_time(options);
 
   // Set the output precision for shape/geometry (polyline encoding). Defaults to polyline6
   // This also controls the input precision for encoded_polyline in height action
@@ -793,30 +972,7 @@ void from_json(rapidjson::Document& doc, Options& options) {
   auto encoded_polyline = rapidjson::get_optional<std::string>(doc, "/encoded_polyline");
   if (encoded_polyline) {
     options.set_encoded_polyline(*encoded_polyline);
-
-    // Set the precision to use when decoding the polyline. For height actions (only)
-    // either polyline6 (default) or polyline5 are supported. All other actions only
-    // support polyline6 inputs at this time.
-    double precision = 1e-6;
-    if (options.action() == Options::height) {
-      precision = options.shape_format() == valhalla::polyline5 ? 1e-5 : 1e-6;
-    }
-
-    auto decoded = midgard::decode<std::vector<midgard::PointLL>>(*encoded_polyline, precision);
-    for (const auto& ll : decoded) {
-      auto* sll = options.mutable_shape()->Add();
-      sll->mutable_ll()->set_lat(ll.lat());
-      sll->mutable_ll()->set_lng(ll.lng());
-      // set type to via by default
-      sll->set_type(valhalla::Location::kVia);
-    }
-    // first and last always get type break
-    if (options.shape_size()) {
-      options.mutable_shape(0)->set_type(valhalla::Location::kBreak);
-      options.mutable_shape(options.shape_size() - 1)->set_type(valhalla::Location::kBreak);
-    }
-    // add the date time
-    add_date_to_locations(options, *options.mutable_shape());
+    decode_shape(options);
   } // fall back from encoded polyline to array of locations
   else {
     parse_locations(doc, options, "shape", 134, ignore_closures);
@@ -881,7 +1037,6 @@ void from_json(rapidjson::Document& doc, Options& options) {
 
   // Elevation service options
   options.set_range(rapidjson::get(doc, "/range", false));
-  constexpr uint32_t MAX_HEIGHT_PRECISION = 2;
   auto height_precision = rapidjson::get_optional<unsigned int>(doc, "/height_precision");
   if (height_precision && *height_precision <= MAX_HEIGHT_PRECISION) {
     options.set_height_precision(*height_precision);
@@ -889,6 +1044,23 @@ void from_json(rapidjson::Document& doc, Options& options) {
 
   options.set_verbose(rapidjson::get(doc, "/verbose", false));
 
+  // whether trace_attributes writes an array per attribute rather than an object per edge
+  options.set_columnar(rapidjson::get(doc, "/columnar", false));
+
+  // whether a status dumps the spans the workers traced
+  options.set_trace_events(rapidjson::get(doc, "/trace_events", false));
+
+  // how long the request may take before the service gives up on it
+  auto timeout = rapidjson::get_optional<unsigned int>(doc, "/timeout");
+  if (timeout) {
+    options.set_timeout(*timeout);
+  }
+
+  // which tile to render, either as an object or as the z, x and y query parameters
+  if (options.action() == Options::tile) {
+    parse_tile(doc, options);
+  }
+
   // try the string directly, some strings are keywords so add an underscore
   Costing costing;
   if (valhalla::Costing_Enum_Parse(costing_str, &costing)) {
@@ -946,11 +1118,7 @@ void from_json(rapidjson::Document& doc, Options& options) {
 
   // if not a time dependent route/mapmatch disable time dependent edge speed/flow data sources
   if (!options.has_date_time_type() && (options.shape_size() == 0 || options.shape(0).time() == -1)) {
-    for (auto& costing : *options.mutable_costing_options()) {
-      costing.set_flow_mask(
-          static_cast<uint8_t>(costing.flow_mask()) &
-          ~(valhalla::baldr::kPredictedFlowMask | valhalla::baldr::kCurrentFlowMask));
-    }
+    disable_time_dependence(options);
   }
 
   // get some parameters
@@ -986,6 +1154,12 @@ void from_json(rapidjson::Document& doc, Options& options) {
     options.set_show_locations(*show_locations);
   }
 
+  // if specified, get the partition boolean in there
+  auto partition = rapidjson::get_optional<bool>(doc, "/partition");
+  if (partition) {
+    options.set_partition(*partition);
+  }
+
   // if specified, get the shape_match in there
   auto shape_match_str = rapidjson::get_optional<std::string>(doc, "/shape_match");
   ShapeMatch shape_match;
@@ -1075,6 +1249,155 @@ void from_json(rapidjson::Document& doc, Options& options) {
                 {valhalla::Options_Format_Enum_Name(options.format()), allocator}, allocator);
 }
 
+// Fills out the costing options with the defaults of their costing for anything not set on them
+void default_costing_options(CostingOptions& costing_options) {
+  static const rapidjson::Document empty = []() {
+    rapidjson::Document empty;
+    empty.SetObject();
+    return empty;
+  }();
+  auto defaults = arena_local<CostingOptions>(costing_options);
+  sif::ParseCostingOptions(empty, "/costing_options", defaults.get(), costing_options.costing());
+  defaults->MergeFrom(costing_options);
+  costing_options.Swap(defaults.get());
+}
+
+// Gives the locations of a pbf request the same indices, types and search filters that parsing
+// them out of json would have
+void check_locations(Options& options,
+                     google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+                     unsigned location_parse_error_code,
+                     const boost::optional<bool>& ignore_closures) {
+  bool had_date_time = false;
+  bool exclude_closures_disabled = false;
+  for (int i = 0; i < locations.size(); ++i) {
+    auto& location = *locations.Mutable(i);
+    location.set_original_index(i);
+    if (!location.ll().has_lat() || !location.ll().has_lng() || location.ll().lat() < -90.0 ||
+        location.ll().lat() > 90.0) {
+      throw valhalla_exception_t{location_parse_error_code};
+    }
+    location.mutable_ll()->set_lng(
+        midgard::circular_range_clamp<double>(location.ll().lng(), -180, 180));
+
+    // trace attributes does not support legs or breaks at discontinuities
+    if (options.action() == Options::trace_attributes ||
+        (options.action() == Options::trace_route && !location.has_type())) {
+      location.set_type(valhalla::Location::kVia);
+    }
+    had_date_time = had_date_time || location.has_date_time();
+
+    // ignore_closures takes precedence over the search filter
+    if (ignore_closures) {
+      if (location.search_filter().has_exclude_closures()) {
+        throw valhalla_exception_t{143};
+      }
+      location.mutable_search_filter()->set_exclude_closures(!*ignore_closures);
+    }
+    exclude_closures_disabled =
+        exclude_closures_disabled || !location.search_filter().exclude_closures();
+  }
+
+  // first and last locations get the default type of break no matter what
+  if (locations.size()) {
+    locations.Mutable(0)->set_type(valhalla::Location::kBreak);
+    locations.Mutable(locations.size() - 1)->set_type(valhalla::Location::kBreak);
+  }
+
+  // push the date time information down into the locations
+  if (!had_date_time) {
+    add_date_to_locations(options, locations);
+  }
+
+  // let closed roads through the costing so that loki can filter them per location
+  if (exclude_closures_disabled) {
+    for (auto& costing : *options.mutable_costing_options()) {
+      costing.set_filter_closures(false);
+    }
+  }
+}
+
+// A request which came as an Api protobuf has nothing to parse, but most of what from_json does
+// besides parsing still has to happen so that the rest of the pipeline can count on the same things
+void from_pbf(Options& options) {
+  if (!format_allowed(options.format(), options.action())) {
+    options.clear_format();
+  }
+  if (options.format() == Options::pbf) {
+    options.clear_jsonp();
+  }
+  if (options.has_language() &&
+      odin::get_locales().find(options.language()) == odin::get_locales().end()) {
+    options.clear_language();
+  }
+  if (!options.has_costing()) {
+    options.set_costing(Costing::none_);
+  }
+  check_date_time(options);
+
+  // every costing gets its options, defaulted where the request didnt say otherwise
+  boost::optional<bool> ignore_closures;
+  google::protobuf::RepeatedPtrField<CostingOptions> costing_options;
+  for (int i = 0; i < Costing_ARRAYSIZE; ++i) {
+    costing_options.Add()->set_costing(static_cast<Costing>(i));
+  }
+  for (const auto& requested : options.costing_options()) {
+    if (requested.has_costing() && requested.costing() < Costing_ARRAYSIZE) {
+      costing_options.Mutable(requested.costing())->MergeFrom(requested);
+      if (requested.costing() == options.costing() && requested.has_ignore_closures() &&
+          options.costing() != multimodal) {
+        ignore_closures = requested.ignore_closures();
+      }
+    }
+  }
+  for (int i = 0; i < Costing_ARRAYSIZE; ++i) {
+    // deprecated costings still need their place in the array
+    if (!valhalla::Costing_Enum_Name(static_cast<Costing>(i)).empty()) {
+      default_costing_options(*costing_options.Mutable(i));
+    } else {
+      costing_options.Mutable(i)->Clear();
+    }
+  }
+  options.mutable_costing_options()->Swap(&costing_options);
+  for (auto& recosting : *options.mutable_recostings()) {
+    if (!recosting.has_name() || !recosting.has_costing()) {
+      throw valhalla_exception_t{127};
+    }
+    default_costing_options(recosting);
+  }
+
+  // the locations of every kind
+  if (options.has_encoded_polyline() && options.shape_size() == 0) {
+    decode_shape(options);
+  }
+  check_locations(options, *options.mutable_shape(), 134, ignore_closures);
+  check_locations(options, *options.mutable_trace(), 135, ignore_closures);
+  check_locations(options, *options.mutable_locations(), 130, ignore_closures);
+  check_locations(options, *options.mutable_sources(), 131, ignore_closures);
+  check_locations(options, *options.mutable_targets(), 132, ignore_closures);
+  check_locations(options, *options.mutable_exclude_locations(), 133, ignore_closures);
+  if (options.use_timestamps() &&
+      std::none_of(options.shape().begin(), options.shape().end(),
+                   [](const valhalla::Location& s) { return s.has_time(); })) {
+    throw valhalla_exception_t{159};
+  }
+  if (!options.has_date_time_type() &&
+      (options.shape_size() == 0 || options.shape(0).time() == -1)) {
+    disable_time_dependence(options);
+  }
+
+  // the same bounds json puts on values
+  if (options.has_height_precision() && options.height_precision() > MAX_HEIGHT_PRECISION) {
+    options.clear_height_precision();
+  }
+  if (options.has_denoise()) {
+    options.set_denoise(std::max(std::min(options.denoise(), 1.f), 0.f));
+  }
+  if (options.locations_size() > 2) {
+    options.set_alternates(0);
+  }
+}
+
 } // namespace
 
 namespace valhalla {
@@ -1092,9 +1415,18 @@ valhalla_exception_t::valhalla_exception_t(unsigned code, const boost::optional<
 
 void ParseApi(const std::string& request, Options::Action action, valhalla::Api& api) {
   api.Clear();
-  auto document = from_string(request, valhalla_exception_t{100});
+  auto _ = measure_scope_time(api, "ParseApi");
+  request_document_t document(request.data(), request.size());
   api.mutable_options()->set_action(action);
-  from_json(document, *api.mutable_options());
+  from_json(*document, *api.mutable_options());
+}
+
+void ParseApi(valhalla::Api& api) {
+  auto options = arena_local<Options>(api);
+  options->Swap(api.mutable_options());
+  api.Clear();
+  api.mutable_options()->Swap(options.get());
+  from_pbf(*api.mutable_options());
 }
 
 std::string jsonify_error(const valhalla_exception_t& exception, const Api& request) {
@@ -1126,29 +1458,44 @@ std::string jsonify_error(const valhalla_exception_t& exception, const Api& requ
 #ifdef HAVE_HTTP
 void ParseApi(const http_request_t& request, valhalla::Api& api) {
   api.Clear();
+  auto _ = measure_scope_time(api, "ParseApi");
 
   // block all but get and post
   if (request.method != method_t::POST && request.method != method_t::GET) {
     throw valhalla_exception_t{101};
   };
 
-  rapidjson::Document document;
-  auto& allocator = document.GetAllocator();
-  // parse the input
-  const auto& json = request.query.find("json");
-  if (json != request.query.end() && json->second.size() && json->second.front().size()) {
-    document.Parse(json->second.front().c_str());
-    // no json parameter, check the body
-  } else if (!request.body.empty()) {
-    document.Parse(request.body.c_str());
-    // no json at all
-  } else {
-    document.SetObject();
+  // the body is already the request so there is no json to parse at all
+  auto content_type = std::find_if(request.headers.cbegin(), request.headers.cend(),
+                                   [](const headers_t::value_type& header) {
+                                     return boost::iequals(header.first, "Content-Type");
+                                   });
+  if (content_type != request.headers.cend() &&
+      boost::istarts_with(content_type->second, worker::PBF_MIME.second)) {
+    // only the options of it are a request, the rest is for the workers to fill out
+    auto requested = arena_local<Api>(api);
+    if (!requested->ParseFromString(request.body)) {
+      throw valhalla_exception_t{103};
+    }
+    auto& options = *api.mutable_options();
+    options.Swap(requested->mutable_options());
+    Options::Action action;
+    if (!request.path.empty() && Options_Action_Enum_Parse(request.path.substr(1), &action)) {
+      options.set_action(action);
+    }
+    from_pbf(options);
+    return;
   }
-  // if parsing failed
-  if (document.HasParseError()) {
-    throw valhalla_exception_t{100};
-  };
+
+  // parse the input, the json parameter wins over the body
+  const auto& json = request.query.find("json");
+  const auto& input = json != request.query.end() && json->second.size() &&
+                              json->second.front().size()
+                          ? json->second.front()
+                          : request.body;
+  request_document_t parsed(input.data(), input.size());
+  auto& document = *parsed;
+  auto& allocator = document.GetAllocator();
 
   // throw the query params into the rapidjson doc
   for (const auto& kv : request.query) {
@@ -1177,14 +1524,43 @@ void ParseApi(const http_request_t& request, valhalla::Api& api) {
   Options::Action action;
   if (!request.path.empty() && Options_Action_Enum_Parse(request.path.substr(1), &action)) {
     options.set_action(action);
+  } else if (boost::algorithm::starts_with(request.path, "/tile/")) {
+    // map clients ask for /tile/{z}/{x}/{y} maybe with an extension on the end
+    options.set_action(Options::tile);
+    std::vector<std::string> zxy;
+    auto path = request.path.substr(6, request.path.find('.') - 6);
+    boost::algorithm::split(zxy, path, boost::algorithm::is_any_of("/"));
+    if (zxy.size() != 3) {
+      throw valhalla_exception_t{115};
+    }
+    const char* names[] = {"z", "x", "y"};
+    for (size_t i = 0; i < zxy.size(); ++i) {
+      document.RemoveMember(names[i]);
+      rapidjson::Value name{names[i], allocator}, value{zxy[i], allocator};
+      document.AddMember(name, value, allocator);
+    }
   }
 
   // parse out the options
   from_json(document, options);
+
+  // a proxy in front of us can tell us how long it will wait for the request
+  if (!options.has_timeout()) {
+    auto timeout = std::find_if(request.headers.cbegin(), request.headers.cend(),
+                                [](const headers_t::value_type& header) {
+                                  return boost::iequals(header.first, "X-Request-Timeout");
+                                });
+    if (timeout != request.headers.cend()) {
+      try {
+        options.set_timeout(std::stoul(timeout->second));
+      } catch (...) { throw valhalla_exception_t{100, "Invalid X-Request-Timeout header"}; }
+    }
+  }
 }
 
 const headers_t::value_type CORS{"Access-Control-Allow-Origin", "*"};
 const headers_t::value_type ATTACHMENT{"Content-Disposition", "attachment; filename=route.gpx"};
+const headers_t::value_type GZIPPED{"Content-Encoding", "gzip"};
 
 worker_t::result_t jsonify_error(const valhalla_exception_t& exception,
                                  http_request_info_t& request_info,
@@ -1200,40 +1576,79 @@ worker_t::result_t jsonify_error(const valhalla_exception_t& exception,
   return result;
 }
 
+worker_t::result_t to_redirect(const std::string& url,
+                               const http_request_t& http_request,
+                               http_request_info_t& request_info) {
+  // the query was decoded when the request was parsed so it is encoded again
+  auto encode = [](const std::string& text) {
+    std::string encoded;
+    for (unsigned char c : text) {
+      if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+        encoded.push_back(c);
+      } else {
+        static const char* hex = "0123456789ABCDEF";
+        encoded.push_back('%');
+        encoded.push_back(hex[c >> 4]);
+        encoded.push_back(hex[c & 15]);
+      }
+    }
+    return encoded;
+  };
+  std::string location = url + http_request.path;
+  char separator = '?';
+  for (const auto& kv : http_request.query) {
+    for (const auto& value : kv.second) {
+      location += separator + encode(kv.first) + '=' + encode(value);
+      separator = '&';
+    }
+  }
+
+  worker_t::result_t result{false, std::list<std::string>(), ""};
+  http_response_t response(307, "Temporary Redirect", "",
+                           headers_t{CORS, {"Location", location}});
+  response.from_info(request_info);
+  result.messages.emplace_back(response.to_string());
+  return result;
+}
+
 worker_t::result_t to_response(const std::string& data,
                                http_request_info_t& request_info,
                                const Api& request,
                                const worker::content_type& mime_type,
-                               const bool as_attachment) {
+                               const bool as_attachment,
+                               const bool gzipped) {
 
   worker_t::result_t result{false, std::list<std::string>(), ""};
+  std::string jsonp;
+  headers_t headers{CORS, mime_type};
   if (request.options().has_jsonp()) {
-    std::ostringstream stream;
-    stream << request.options().jsonp() << '(';
-    stream << data;
-    stream << ')';
-
-    headers_t headers{CORS, worker::JS_MIME};
-    if (as_attachment)
-      headers.insert(ATTACHMENT);
-
-    http_response_t response(200, "OK", stream.str(), headers);
-    response.from_info(request_info);
-    result.messages.emplace_back(response.to_string());
-  } else {
-    headers_t headers{CORS, mime_type};
-    if (as_attachment)
-      headers.insert(ATTACHMENT);
-    http_response_t response(200, "OK", data, headers);
-    response.from_info(request_info);
-    result.messages.emplace_back(response.to_string());
+    jsonp.reserve(request.options().jsonp().size() + data.size() + 2);
+    jsonp.append(request.options().jsonp()).append(1, '(').append(data).append(1, ')');
+    headers = headers_t{CORS, worker::JS_MIME};
+  }
+  const auto& body = request.options().has_jsonp() ? jsonp : data;
+
+  if (as_attachment)
+    headers.insert(ATTACHMENT);
+
+  // an already compressed response is sent as is, others if the request negotiated a codec
+  std::string compressed;
+  bool compress = !gzipped && response_compressor_t::compress(request, body, compressed);
+  if (gzipped && !request.options().has_jsonp()) {
+    headers.insert(GZIPPED);
+  } else if (compress) {
+    headers.insert({"Content-Encoding", request.info().content_encoding()});
+    headers.insert({"Vary", "Accept-Encoding"});
   }
+  http_response_t response(200, "OK", compress ? compressed : body, headers);
+  response.from_info(request_info);
+  result.messages.emplace_back(response.to_string());
   return result;
 }
 
 #endif
 
-service_worker_t::service_worker_t() : interrupt(nullptr) {
+service_worker_t::service_worker_t() : interrupt(nullptr), request_timeout(0), arena_block_size(0) {
 }
 service_worker_t::~service_worker_t() {
 }
@@ -1241,4 +1656,876 @@ void service_worker_t::set_interrupt(const std::function<void()>* interrupt_func
   interrupt = interrupt_function;
 }
 
+void service_worker_t::set_deadline_interrupt(Api& request,
+                                              const std::function<void()>* interrupt_function) {
+  auto now = []() -> uint64_t {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+  };
+
+  // the first stage to see the request starts the clock on it
+  auto& info = *request.mutable_info();
+  if (!info.has_deadline()) {
+    uint64_t timeout = request.options().timeout();
+    if (request_timeout > 0 && (timeout == 0 || timeout > request_timeout)) {
+      timeout = request_timeout;
+    }
+    if (timeout > 0) {
+      info.set_deadline(now() + timeout);
+    }
+  }
+  if (!info.has_deadline()) {
+    set_interrupt(interrupt_function);
+    return;
+  }
+
+  // the searches call this every so often so checking the clock here is cheap enough
+  const auto deadline = info.deadline();
+  deadline_interrupt = [interrupt_function, deadline, now]() {
+    if (interrupt_function) {
+      (*interrupt_function)();
+    }
+    if (now() > deadline) {
+      throw valhalla_exception_t{104};
+    }
+  };
+  // a request that waited past its deadline in a queue is not worth starting on
+  deadline_interrupt();
+  set_interrupt(&deadline_interrupt);
+}
+
+Api& service_worker_t::arena_request() {
+  // the block has to outlive the arena using it so the arena goes first
+  size_t wanted = 0;
+  if (arena) {
+    wanted = std::min<size_t>(arena->SpaceAllocated(), kMaxArenaBlockSize);
+    arena.reset();
+  }
+  if (wanted > arena_block_size) {
+    arena_block.reset(new char[wanted]);
+    arena_block_size = wanted;
+  }
+  google::protobuf::ArenaOptions options;
+  options.initial_block = arena_block.get();
+  options.initial_block_size = arena_block_size;
+  arena.reset(new google::protobuf::Arena(options));
+  return *google::protobuf::Arena::CreateMessage<Api>(arena.get());
+}
+
+admission_t::ticket_t service_worker_t::admit(Api& request, const std::string& prefix) {
+  // the status has to answer even when the service is busy, thats when it matters most
+  if (!admission || request.options().action() == Options::status) {
+    return admission_t::ticket_t();
+  }
+  return admission->admit(request, prefix);
+}
+
+admission_t::ticket_t::~ticket_t() {
+  if (admission) {
+    admission->release(action);
+  }
+}
+
+admission_t::admission_t(const boost::property_tree::ptree& config)
+    : max_concurrent(config.get<size_t>("max_concurrent", 0)),
+      max_wait(config.get<uint32_t>("max_wait", 1000)), actions(Options::Action_ARRAYSIZE),
+      running(0), arrivals(0) {
+  auto action_configs = config.get_child_optional("actions");
+  if (!action_configs) {
+    return;
+  }
+  for (const auto& kv : *action_configs) {
+    Options::Action action;
+    if (!Options_Action_Enum_Parse(kv.first, &action)) {
+      throw std::runtime_error("Unknown action " + kv.first + " in the admission service limits");
+    }
+    actions[action].max_concurrent = kv.second.get<size_t>("max_concurrent", 0);
+    actions[action].max_queued = kv.second.get<size_t>("max_queued", 0);
+    actions[action].priority = kv.second.get<int>("priority", 0);
+  }
+}
+
+bool admission_t::fits(const action_t& action) const {
+  return (max_concurrent == 0 || running < max_concurrent) &&
+         (action.max_concurrent == 0 || action.running < action.max_concurrent);
+}
+
+admission_t::ticket_t admission_t::admit(Api& request, const std::string& prefix) {
+  const auto action_id = request.options().action();
+  auto& action = actions[action_id];
+  std::unique_lock<std::mutex> guard(lock);
+
+  // nobody is waiting and there is room so it can go right away
+  if (waiters.empty() && fits(action)) {
+    ++running;
+    ++action.running;
+    ++action.admitted;
+    return {this, action_id};
+  }
+
+  // a full queue is not going to get any shorter by waiting in it
+  if (action.max_queued > 0 && action.waiting >= action.max_queued) {
+    ++action.rejected;
+    throw valhalla_exception_t{105};
+  }
+
+  // wait no longer than we are allowed to or than the request has left
+  const auto start = std::chrono::steady_clock::now();
+  auto until = start + std::chrono::milliseconds(max_wait);
+  bool deadline = false;
+  if (request.info().has_deadline()) {
+    const int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::system_clock::now().time_since_epoch())
+                            .count();
+    const auto left = static_cast<int64_t>(request.info().deadline()) - now;
+    if (left < static_cast<int64_t>(max_wait)) {
+      until = start + std::chrono::milliseconds(std::max<int64_t>(left, 0));
+      deadline = true;
+    }
+  }
+
+  // its our turn once we are the first waiter that fits in the limits
+  const auto waiter = waiters.insert({action.priority, arrivals++, action_id}).first;
+  ++action.waiting;
+  const bool admitted = freed.wait_until(guard, until, [this, &waiter]() {
+    for (const auto& other : waiters) {
+      if (fits(actions[other.action])) {
+        return other.order == waiter->order;
+      }
+    }
+    return false;
+  });
+  waiters.erase(waiter);
+  --action.waiting;
+  const double waited = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+  action.wait_total += waited;
+  action.wait_max = std::max(action.wait_max, waited);
+
+  // either way the next one in line may fit now
+  freed.notify_all();
+  if (!admitted) {
+    ++action.rejected;
+    throw valhalla_exception_t{deadline ? 104u : 105u};
+  }
+  ++running;
+  ++action.running;
+  ++action.admitted;
+  guard.unlock();
+
+  auto* stat = request.mutable_info()->mutable_statistics()->Add();
+  stat->set_name(prefix + "admission_wait");
+  stat->set_value(waited);
+  return {this, action_id};
+}
+
+void admission_t::release(Options::Action action) {
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    --running;
+    --actions[action].running;
+  }
+  freed.notify_all();
+}
+
+void admission_t::statistics(const std::string& prefix, Api& api) const {
+  auto add = [&api, &prefix](const std::string& name, double value) {
+    auto* stat = api.mutable_info()->mutable_statistics()->Add();
+    stat->set_name(prefix + "admission_" + name);
+    stat->set_value(value);
+  };
+
+  std::lock_guard<std::mutex> guard(lock);
+  add("running", running);
+  add("waiting", waiters.size());
+  for (size_t i = 0; i < actions.size(); ++i) {
+    const auto& action = actions[i];
+    const auto seen = action.admitted + action.rejected;
+    if (seen == 0 && action.max_concurrent == 0) {
+      continue;
+    }
+    const auto& name = Options_Action_Enum_Name(static_cast<Options::Action>(i));
+    add(name + "_running", action.running);
+    add(name + "_waiting", action.waiting);
+    add(name + "_admitted", action.admitted);
+    add(name + "_rejected", action.rejected);
+    add(name + "_wait_mean", seen ? action.wait_total / seen : 0.);
+    add(name + "_wait_max", action.wait_max);
+  }
+}
+
+std::shared_ptr<admission_t> admission_t::shared(const boost::property_tree::ptree& config,
+                                                 const std::string& stage) {
+  // without a single limit there is nothing to keep track of
+  auto admission_config = config.get_child_optional("service_limits.admission");
+  if (!admission_config) {
+    return nullptr;
+  }
+  bool limited = admission_config->get<size_t>("max_concurrent", 0) > 0;
+  auto action_configs = admission_config->get_child_optional("actions");
+  if (action_configs) {
+    for (const auto& kv : *action_configs) {
+      limited = limited || kv.second.get<size_t>("max_concurrent", 0) > 0;
+    }
+  }
+  if (!limited) {
+    return nullptr;
+  }
+
+  // the first worker of the stage to want it makes it
+  static std::mutex admissions_lock;
+  static std::unordered_map<std::string, std::shared_ptr<admission_t>> admissions;
+  std::lock_guard<std::mutex> guard(admissions_lock);
+  auto& admission = admissions[stage];
+  if (!admission) {
+    admission = std::make_shared<admission_t>(*admission_config);
+  }
+  return admission;
+}
+
+response_cache_t::response_cache_t(size_t capacity, uint32_t ttl, uint32_t precision)
+    : ttl(ttl), scale(std::pow(10., std::min(precision, 7u))), entries(capacity) {
+}
+
+std::string response_cache_t::key(const Api& request) const {
+  // only the json of routes and matrices is cached, the other formats hand back the whole request
+  // or are attachments
+  const auto& options = request.options();
+  if ((options.action() != Options::route && options.action() != Options::sources_to_targets) ||
+      (options.format() != Options::json && options.format() != Options::osrm)) {
+    return "";
+  }
+
+  // leaving now is leaving at another time a moment later, only fixed times have one response
+  if (options.has_date_time_type() && options.date_time_type() == Options::current) {
+    return "";
+  }
+  for (const auto* locations : {&options.locations(), &options.sources(), &options.targets()}) {
+    for (const auto& location : *locations) {
+      if (location.date_time() == "current") {
+        return "";
+      }
+    }
+  }
+
+  // jsonp is wrapped around the response when it is sent and the rest doesnt change what it is
+  Options canonical(options);
+  canonical.clear_jsonp();
+  canonical.clear_do_not_track();
+  canonical.clear_timeout();
+  canonical.clear_trace_events();
+  auto round = [this](google::protobuf::RepeatedPtrField<valhalla::Location>& locations) {
+    for (auto& location : locations) {
+      auto* ll = location.mutable_ll();
+      ll->set_lat(std::round(ll->lat() * scale) / scale);
+      ll->set_lng(std::round(ll->lng() * scale) / scale);
+    }
+  };
+  round(*canonical.mutable_locations());
+  round(*canonical.mutable_sources());
+  round(*canonical.mutable_targets());
+
+  // the options of the costings which arent used dont matter, the ones combining costings use
+  // the options of those as well
+  if (options.costing() != Costing::multimodal && options.costing() != Costing::bikeshare) {
+    for (auto& costing_options : *canonical.mutable_costing_options()) {
+      if (costing_options.costing() != options.costing()) {
+        const auto costing = costing_options.costing();
+        costing_options.Clear();
+        costing_options.set_costing(costing);
+      }
+    }
+  }
+  return canonical.SerializeAsString();
+}
+
+bool response_cache_t::find(Api& request, baldr::GraphReader& reader, std::string& response) {
+  auto key = this->key(request);
+  if (key.empty()) {
+    return false;
+  }
+  std::shared_ptr<const entry_t> entry;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    entries.find(key, entry);
+  }
+
+  // it has to be young enough and made from the tiles and the traffic we have now
+  bool fresh = entry && (!ttl || std::chrono::steady_clock::now() - entry->cached <=
+                                     std::chrono::seconds(ttl));
+  fresh = fresh && entry->reader_generation == shared_graph_reader_generation();
+  for (size_t i = 0; fresh && i < entry->tags.size(); ++i) {
+    fresh = stamp(reader, std::get<0>(entry->tags[i])) == entry->tags[i];
+  }
+  if (fresh) {
+    response = entry->response;
+    return true;
+  }
+
+  // the stage making the response caches it under this key
+  request.mutable_info()->set_response_cache_key(std::move(key));
+  return false;
+}
+
+std::tuple<uint64_t, uint32_t, uint64_t> response_cache_t::stamp(baldr::GraphReader& reader,
+                                                                 uint64_t tile) {
+  const baldr::GraphId tile_id(tile);
+  auto graph_tile = reader.GetGraphTile(tile_id);
+  const uint32_t traffic = graph_tile ? graph_tile->get_traffic_tile().generation() : 0;
+  // an updated incident tile is a new one
+  return std::make_tuple(tile, traffic, incidents_generation(tile, reader.GetIncidentTile(tile_id)));
+}
+
+uint64_t
+response_cache_t::incidents_generation(uint64_t tile,
+                                       const std::shared_ptr<const IncidentsTile>& incidents) {
+  if (!incidents) {
+    return 0;
+  }
+  // the incident tiles are those of the process, so are their generations. the weak pointer only
+  // locks to the tile it was made from, never to one allocated where it was after it was freed
+  static std::mutex generations_lock;
+  static std::unordered_map<uint64_t, std::pair<std::weak_ptr<const IncidentsTile>, uint64_t>>
+      generations;
+  static uint64_t last_generation = 0;
+  std::lock_guard<std::mutex> guard(generations_lock);
+  auto& generation = generations[tile];
+  if (generation.first.lock() != incidents) {
+    generation = std::make_pair(incidents, ++last_generation);
+  }
+  return generation.second;
+}
+
+void response_cache_t::tag(Api& request, baldr::GraphReader& reader) {
+  if (!request.info().has_response_cache_key()) {
+    return;
+  }
+
+  // the tiles of the edges of the routes and of the edges the locations were found on
+  std::vector<uint64_t> tiles;
+  for (const auto& route : request.trip().routes()) {
+    for (const auto& leg : route.legs()) {
+      for (const auto& node : leg.node()) {
+        if (node.has_edge() && node.edge().has_id()) {
+          tiles.push_back(baldr::GraphId(node.edge().id()).Tile_Base());
+        }
+      }
+    }
+  }
+  const auto& options = request.options();
+  for (const auto* locations : {&options.locations(), &options.sources(), &options.targets()}) {
+    for (const auto& location : *locations) {
+      for (const auto& edge : location.path_edges()) {
+        tiles.push_back(baldr::GraphId(edge.graph_id()).Tile_Base());
+      }
+    }
+  }
+  std::sort(tiles.begin(), tiles.end());
+  tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+
+  auto* tags = request.mutable_info()->mutable_response_cache_tags();
+  tags->Clear();
+  for (auto tile : tiles) {
+    const auto state = stamp(reader, tile);
+    auto* tag = tags->Add();
+    tag->set_tile(tile);
+    tag->set_traffic(std::get<1>(state));
+    tag->set_incidents(std::get<2>(state));
+  }
+}
+
+void response_cache_t::insert(const Api& request, const std::string& response) {
+  const auto& info = request.info();
+  if (!info.has_response_cache_key()) {
+    return;
+  }
+  auto entry = std::make_shared<entry_t>();
+  entry->response = response;
+  entry->cached = std::chrono::steady_clock::now();
+  entry->reader_generation = shared_graph_reader_generation();
+  entry->tags.reserve(info.response_cache_tags_size());
+  for (const auto& tag : info.response_cache_tags()) {
+    entry->tags.emplace_back(tag.tile(), tag.traffic(), tag.incidents());
+  }
+  std::lock_guard<std::mutex> guard(lock);
+  entries.insert(info.response_cache_key(), entry);
+}
+
+std::shared_ptr<response_cache_t>
+response_cache_t::shared(const boost::property_tree::ptree& config) {
+  const auto capacity = config.get<size_t>("httpd.service.response_cache_size", 0);
+  if (!capacity) {
+    return nullptr;
+  }
+
+  // the same request has another response on other tiles so each set of tiles gets its own cache
+  const auto tiles = config.get<std::string>("mjolnir.tile_extract", "") + '|' +
+                     config.get<std::string>("mjolnir.tile_dir", "");
+  static std::mutex caches_lock;
+  static std::unordered_map<std::string, std::shared_ptr<response_cache_t>> caches;
+  std::lock_guard<std::mutex> guard(caches_lock);
+  auto& cache = caches[tiles];
+  if (!cache) {
+    cache = std::make_shared<response_cache_t>(
+        capacity, config.get<uint32_t>("httpd.service.response_cache_ttl", 300),
+        config.get<uint32_t>("httpd.service.response_cache_precision", 5));
+  }
+  return cache;
+}
+
+region_router_t::region_router_t(const boost::property_tree::ptree& config)
+    : own_region(config.get<std::string>("region", "")), own(nullptr),
+      planet_url(config.get<std::string>("planet_url", "")) {
+  auto region_configs = config.get_child_optional("regions");
+  for (const auto& kv : region_configs ? *region_configs : boost::property_tree::ptree{}) {
+    std::vector<double> bbox;
+    for (const auto& coordinate : kv.second.get_child("bbox")) {
+      bbox.push_back(coordinate.second.get_value<double>());
+    }
+    if (bbox.size() != 4) {
+      throw std::runtime_error("The bbox of a region is min lon, min lat, max lon and max lat");
+    }
+    regions.push_back({kv.second.get<std::string>("name"), kv.second.get<std::string>("url"),
+                       {bbox[0], bbox[1], bbox[2], bbox[3]}});
+  }
+  std::sort(regions.begin(), regions.end(), [](const region_t& a, const region_t& b) {
+    return a.bbox.Width() * a.bbox.Height() < b.bbox.Width() * b.bbox.Height();
+  });
+  for (const auto& region : regions) {
+    if (region.name == own_region) {
+      own = &region;
+    }
+  }
+  if (!own_region.empty() && !own) {
+    throw std::runtime_error("The region " + own_region + " of this node is not configured");
+  }
+}
+
+const std::string* region_router_t::route(const Options& options) const {
+  // the box around everything the request has to find in the graph
+  midgard::AABB2<midgard::PointLL> bbox;
+  bool found = false;
+  for (const auto* locations : {&options.locations(), &options.sources(), &options.targets(),
+                                &options.shape(), &options.trace()}) {
+    for (const auto& location : *locations) {
+      const midgard::PointLL ll(location.ll().lng(), location.ll().lat());
+      if (!found) {
+        bbox = {ll, ll};
+        found = true;
+      } else {
+        bbox.Expand(ll);
+      }
+    }
+  }
+
+  // the requests without locations are about this node
+  if (!found || (own && own->bbox.Contains(bbox))) {
+    return nullptr;
+  }
+  for (const auto& region : regions) {
+    if (&region != own && region.bbox.Contains(bbox)) {
+      return &region.url;
+    }
+  }
+  return planet_url.empty() ? nullptr : &planet_url;
+}
+
+std::shared_ptr<region_router_t> region_router_t::make(const boost::property_tree::ptree& config) {
+  auto service = config.get_child_optional("httpd.service");
+  if (!service || service->get_child("regions", {}).empty()) {
+    return nullptr;
+  }
+  return std::make_shared<region_router_t>(*service);
+}
+
+namespace {
+// deflates the data in one go into a buffer as big as it can get, with a gzip or a zlib wrapper
+bool zlib_compress(const std::string& data, int level, bool gzip, std::string& compressed) {
+  auto src = [&data](z_stream& s) {
+    s.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    s.avail_in = static_cast<uInt>(data.size());
+    return Z_FINISH;
+  };
+  compressed.clear();
+  auto dst = [&compressed](z_stream& s) {
+    // whats left over once the stream is done
+    if (s.avail_out > 0) {
+      compressed.resize(s.total_out);
+      return;
+    }
+    // the bound is enough the first time, but we double it if it ever isnt
+    auto size = compressed.size();
+    compressed.resize(size ? size * 2 : deflateBound(&s, s.avail_in));
+    s.next_out = reinterpret_cast<Bytef*>(&compressed[size]);
+    s.avail_out = static_cast<uInt>(compressed.size() - size);
+  };
+  return baldr::deflate(src, dst, level, gzip);
+}
+
+#ifdef HAVE_ZSTD
+bool zstd_compress(const std::string& data, int level, std::string& compressed) {
+  compressed.resize(ZSTD_compressBound(data.size()));
+  auto size = ZSTD_compress(&compressed[0], compressed.size(), data.data(), data.size(), level);
+  if (ZSTD_isError(size)) {
+    return false;
+  }
+  compressed.resize(size);
+  return true;
+}
+#endif
+
+#ifdef HAVE_BROTLI
+bool brotli_compress(const std::string& data, int level, std::string& compressed) {
+  size_t size = BrotliEncoderMaxCompressedSize(data.size());
+  if (size == 0) {
+    return false;
+  }
+  compressed.resize(size);
+  if (!BrotliEncoderCompress(level, BROTLI_DEFAULT_WINDOW, BROTLI_DEFAULT_MODE, data.size(),
+                             reinterpret_cast<const uint8_t*>(data.data()), &size,
+                             reinterpret_cast<uint8_t*>(&compressed[0]))) {
+    return false;
+  }
+  compressed.resize(size);
+  return true;
+}
+#endif
+
+// the codecs by name along with their default levels, the fast end of each
+std::unordered_map<std::string, std::pair<response_compressor_t::codec_t, int>>&
+registered_codecs() {
+  static std::unordered_map<std::string, std::pair<response_compressor_t::codec_t, int>> codecs{
+      {"gzip",
+       {[](const std::string& data, int level, std::string& compressed) {
+          return zlib_compress(data, level, true, compressed);
+        },
+        1}},
+      {"deflate",
+       {[](const std::string& data, int level, std::string& compressed) {
+          return zlib_compress(data, level, false, compressed);
+        },
+        1}},
+#ifdef HAVE_ZSTD
+      {"zstd", {zstd_compress, 3}},
+#endif
+#ifdef HAVE_BROTLI
+      {"br", {brotli_compress, 4}},
+#endif
+  };
+  return codecs;
+}
+} // namespace
+
+response_compressor_t::response_compressor_t(const boost::property_tree::ptree& config)
+    : min_size(config.get<uint32_t>("compression_min_size", 1024)) {
+  auto codec_configs = config.get_child_optional("compression_codecs");
+  for (const auto& kv : codec_configs ? *codec_configs : boost::property_tree::ptree{}) {
+    auto name = boost::algorithm::to_lower_copy(kv.second.get_value<std::string>());
+    auto codec = registered_codecs().find(name);
+    if (codec == registered_codecs().cend()) {
+      throw std::runtime_error("The compression codec " + name + " is not available");
+    }
+    codecs.emplace_back(name, config.get<int>("compression_levels." + name, codec->second.second));
+  }
+}
+
+void response_compressor_t::negotiate(const std::string& accept_encoding, Api& request) const {
+  // the quality values of the codings the client accepts, those without one have 1
+  std::unordered_map<std::string, float> accepted;
+  std::vector<std::string> codings;
+  boost::algorithm::split(codings, accept_encoding, boost::algorithm::is_any_of(","));
+  for (const auto& coding : codings) {
+    std::vector<std::string> parts;
+    boost::algorithm::split(parts, coding, boost::algorithm::is_any_of(";"));
+    auto name = boost::algorithm::to_lower_copy(boost::algorithm::trim_copy(parts.front()));
+    if (name.empty()) {
+      continue;
+    }
+    float quality = 1.f;
+    for (size_t i = 1; i < parts.size(); ++i) {
+      auto parameter = boost::algorithm::trim_copy(parts[i]);
+      if (parameter.size() > 2 && (parameter[0] == 'q' || parameter[0] == 'Q') &&
+          parameter[1] == '=') {
+        try {
+          quality = std::stof(parameter.substr(2));
+        } catch (...) { quality = 0.f; }
+      }
+    }
+    accepted[name] = quality;
+  }
+
+  // the wildcard stands for every codec the client didnt name
+  auto wildcard = accepted.find("*");
+  const std::pair<std::string, int>* best = nullptr;
+  float best_quality = 0.f;
+  for (const auto& codec : codecs) {
+    auto found = accepted.find(codec.first);
+    float quality = found != accepted.cend()
+                        ? found->second
+                        : (wildcard != accepted.cend() ? wildcard->second : 0.f);
+    if (quality > best_quality) {
+      best = &codec;
+      best_quality = quality;
+    }
+  }
+  if (!best) {
+    return;
+  }
+
+  auto& info = *request.mutable_info();
+  info.set_content_encoding(best->first);
+  info.set_compression_level(best->second);
+  info.set_compression_min_size(min_size);
+}
+
+#ifdef HAVE_HTTP
+void response_compressor_t::negotiate(const http_request_t& http_request, Api& request) const {
+  auto accept_encoding = std::find_if(http_request.headers.cbegin(), http_request.headers.cend(),
+                                      [](const headers_t::value_type& header) {
+                                        return boost::iequals(header.first, "Accept-Encoding");
+                                      });
+  if (accept_encoding != http_request.headers.cend()) {
+    negotiate(accept_encoding->second, request);
+  }
+}
+#endif
+
+bool response_compressor_t::compress(const Api& request,
+                                     const std::string& response,
+                                     std::string& compressed) {
+  const auto& info = request.info();
+  if (!info.has_content_encoding() || response.size() < info.compression_min_size()) {
+    return false;
+  }
+  return compress(info.content_encoding(), info.compression_level(), response, compressed);
+}
+
+bool response_compressor_t::compress(const std::string& codec,
+                                     int level,
+                                     const std::string& data,
+                                     std::string& compressed) {
+  auto found = registered_codecs().find(codec);
+  return found != registered_codecs().cend() && found->second.first(data, level, compressed);
+}
+
+void response_compressor_t::add_codec(const std::string& name, codec_t codec, int default_level) {
+  registered_codecs()[boost::algorithm::to_lower_copy(name)] = {std::move(codec), default_level};
+}
+
+std::shared_ptr<response_compressor_t>
+response_compressor_t::make(const boost::property_tree::ptree& config) {
+  auto service = config.get_child_optional("httpd.service");
+  if (!service || service->get_child("compression_codecs", {}).empty()) {
+    return nullptr;
+  }
+  return std::make_shared<response_compressor_t>(*service);
+}
+
+namespace {
+// the readers every worker of the process shares, one per NUMA node the workers are pinned to, and
+// how many times they were replaced
+struct shared_reader_t {
+  std::mutex lock;
+  std::unordered_map<size_t, std::shared_ptr<baldr::GraphReader>> readers;
+  std::atomic<uint64_t> generation{0};
+};
+shared_reader_t& shared_reader() {
+  static shared_reader_t shared;
+  return shared;
+}
+
+// the NUMA node the thread is pinned to, threads which arent pinned share the reader of node 0
+thread_local size_t pinned_numa_node = 0;
+
+// the cpus of a cpulist like 0-3,8,10-11
+std::vector<int> parse_cpu_list(const std::string& list) {
+  std::vector<int> cpus;
+  std::vector<std::string> ranges;
+  boost::algorithm::split(ranges, list, boost::algorithm::is_any_of(","));
+  for (const auto& range : ranges) {
+    if (range.empty() || !std::isdigit(range.front())) {
+      continue;
+    }
+    const auto dash = range.find('-');
+    const int first = std::stoi(range.substr(0, dash));
+    const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+} // namespace
+
+std::vector<std::vector<int>> numa_nodes() {
+  std::vector<std::vector<int>> nodes;
+  for (size_t node = 0;; ++node) {
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    if (!file || !std::getline(file, list)) {
+      break;
+    }
+    nodes.push_back(parse_cpu_list(list));
+  }
+  return nodes;
+}
+
+bool pin_to_numa_node(size_t node) {
+#ifdef __linux__
+  const auto nodes = numa_nodes();
+  if (node >= nodes.size() || nodes[node].empty()) {
+    return false;
+  }
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  for (auto cpu : nodes[node]) {
+    CPU_SET(cpu, &cpus);
+  }
+  if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+    return false;
+  }
+  pinned_numa_node = node;
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::shared_ptr<baldr::GraphReader> shared_graph_reader(const boost::property_tree::ptree& config) {
+  if (!config.get<bool>("mjolnir.thread_safe_reader", false)) {
+    return nullptr;
+  }
+  // the first worker of the node to want it makes it
+  auto& shared = shared_reader();
+  std::lock_guard<std::mutex> lock(shared.lock);
+  auto& reader = shared.readers[pinned_numa_node];
+  if (!reader) {
+    reader = std::make_shared<baldr::GraphReader>(config.get_child("mjolnir"));
+  }
+  return reader;
+}
+
+bool reload_shared_graph_reader(const boost::property_tree::ptree& config) {
+  if (!config.get<bool>("mjolnir.thread_safe_reader", false)) {
+    return false;
+  }
+  auto& shared = shared_reader();
+  std::vector<size_t> nodes;
+  {
+    std::lock_guard<std::mutex> lock(shared.lock);
+    for (const auto& reader : shared.readers) {
+      nodes.push_back(reader.first);
+    }
+  }
+  if (nodes.empty()) {
+    nodes.push_back(pinned_numa_node);
+  }
+
+  // the new readers get their tiles while the old ones keep answering requests, each on a thread
+  // of its node so that its tiles are in the memory of the node
+  const auto warm_file = config.get<std::string>("mjolnir.tile_warm_file", "");
+  const auto warm_tiles = warm_file.empty() ? std::vector<baldr::GraphId>{}
+                                            : baldr::GraphReader::ReadTileUsage(warm_file);
+  std::vector<std::shared_ptr<baldr::GraphReader>> readers(nodes.size());
+  std::vector<std::exception_ptr> errors(nodes.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    threads.emplace_back([&, i]() {
+      try {
+        if (nodes.size() > 1 || nodes[i] != 0) {
+          pin_to_numa_node(nodes[i]);
+        }
+        readers[i] = std::make_shared<baldr::GraphReader>(config.get_child("mjolnir"));
+        if (!warm_tiles.empty()) {
+          readers[i]->Warm(warm_tiles, config.get<size_t>("mjolnir.tile_warm_threads", 1));
+        }
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  // the workers pick them up between requests, the old ones go with the last of them
+  {
+    std::lock_guard<std::mutex> lock(shared.lock);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      shared.readers[nodes[i]] = std::move(readers[i]);
+    }
+  }
+  const auto generation = ++shared.generation;
+  LOG_INFO("Reloaded the shared graph reader, generation " + std::to_string(generation));
+  return true;
+}
+
+uint64_t shared_graph_reader_generation() {
+  return shared_reader().generation.load();
+}
+
+midgard::scoped_timer<>
+measure_scope_tiles(const baldr::GraphReader& reader, const std::string& prefix, Api& api) {
+  // every lookup is counted by where the tile came from, the ones not in the cache were loaded
+  auto counts = [&reader]() {
+    const auto& stats = reader.GetTileStats();
+    std::pair<uint64_t, uint64_t> lookups_loads{0, 0};
+    for (size_t i = 0; i < baldr::tile_stats_t::kSourceCount; ++i) {
+      const auto count = stats.tiles[i].load(std::memory_order_relaxed);
+      lookups_loads.first += count;
+      if (i != baldr::tile_stats_t::kCache && i != baldr::tile_stats_t::kNotFound) {
+        lookups_loads.second += count;
+      }
+    }
+    return lookups_loads;
+  };
+  const auto before = counts();
+  return midgard::scoped_timer<>(
+      [&api, prefix, before, counts](const midgard::scoped_timer<>::duration_t&) {
+        const auto after = counts();
+        auto* stat = api.mutable_info()->mutable_statistics()->Add();
+        stat->set_name(prefix + "tile_lookups");
+        stat->set_value(after.first - before.first);
+        stat = api.mutable_info()->mutable_statistics()->Add();
+        stat->set_name(prefix + "tile_loads");
+        stat->set_value(after.second - before.second);
+      });
+}
+
+void tile_statistics(const baldr::GraphReader& reader, const std::string& prefix, Api& api) {
+  auto add = [&api, &prefix](const std::string& name, double value) {
+    auto* stat = api.mutable_info()->mutable_statistics()->Add();
+    stat->set_name(prefix + name);
+    stat->set_value(value);
+  };
+
+  const auto& stats = reader.GetTileStats();
+  uint64_t total = 0;
+  for (size_t i = 0; i < baldr::tile_stats_t::kSourceCount; ++i) {
+    const auto source = static_cast<baldr::tile_stats_t::source_t>(i);
+    const auto count = stats.tiles[i].load(std::memory_order_relaxed);
+    total += count;
+    add(std::string("tiles_") + baldr::tile_stats_t::name(source), count);
+  }
+  const auto hits = stats.tiles[baldr::tile_stats_t::kCache].load(std::memory_order_relaxed);
+  add("tile_cache_hit_rate", total ? static_cast<double>(hits) / total : 0.);
+  add("tile_cache_evictions", reader.CacheEvictions());
+  add("tile_bytes_loaded", stats.bytes_loaded.load(std::memory_order_relaxed));
+
+  // the bins are named by their upper bound, the last one has none
+  for (size_t i = 0; i < baldr::tile_stats_t::kLatencyBins; ++i) {
+    const auto name = i + 1 < baldr::tile_stats_t::kLatencyBins
+                          ? "tile_load_latency_lt_" + std::to_string(2ull << i) + "us"
+                          : "tile_load_latency_ge_" + std::to_string(1ull << i) + "us";
+    add(name, stats.load_latency[i].load(std::memory_order_relaxed));
+  }
+}
+
 } // namespace valhalla
@@ -4,6 +4,7 @@
 #include <string>
 
 #include "tyr/actor.h"
+#include "worker.h"
 
 #include "test.h"
 
@@ -52,6 +53,14 @@ TEST(Actor, Basic) {
   auto status_json = actor.status("");
   ASSERT_EQ(status_json, "{}");
 
+  // asking for the trace events makes the status a chrome trace, which has spans when enabled
+  auto trace = test::json_to_pt(actor.status(R"({"trace_events":true})"));
+  ASSERT_EQ(trace.count("traceEvents"), 1);
+  EXPECT_EQ(trace.get<std::string>("displayTimeUnit"), "ms");
+#ifdef ENABLE_TRACING
+  EXPECT_FALSE(trace.get_child("traceEvents").empty());
+#endif
+
   // TODO: test the rest of them
 }
 
@@ -73,6 +82,57 @@ TEST(Actor, TraceAttributes) {
   EXPECT_THROW(actor.trace_attributes(request, &interrupt), test_exception_t);
 }
 
+TEST(Actor, Batch) {
+  auto config = conf;
+  config.put("thor.batch_threads", 3);
+  tyr::actor_t actor(config, true);
+  std::vector<std::string> requests{
+      R"({"locations":[{"lat":40.546115,"lon":-76.385076},{"lat":40.544232,"lon":-76.385752}],
+        "costing":"auto"})",
+      R"({"locations":[{"lat":40.544232,"lon":-76.385752},{"lat":40.546115,"lon":-76.385076}],
+        "costing":"auto"})",
+      R"({"locations":[],"costing":"auto"})",
+      R"({"locations":[{"lat":40.546115,"lon":-76.385076},{"lat":40.544232,"lon":-76.385752}],
+        "costing":"pedestrian"})",
+  };
+  std::vector<std::string> expected;
+  for (size_t i = 0; i < requests.size(); ++i) {
+    expected.emplace_back(i == 2 ? "" : actor.route(requests[i]));
+  }
+
+  // the same as one at a time and the bad one doesnt spoil the others
+  auto results = actor.batch(requests, Options::route);
+  ASSERT_EQ(results.size(), requests.size());
+  for (size_t i = 0; i < requests.size(); ++i) {
+    EXPECT_EQ(results[i].response, expected[i]) << i;
+    EXPECT_EQ(static_cast<bool>(results[i].error), i == 2) << i;
+    EXPECT_GT(results[i].milliseconds, 0) << i;
+  }
+  EXPECT_THROW(std::rethrow_exception(results[2].error), valhalla_exception_t);
+
+  // protobufs need no parsing and get the response filled in
+  std::vector<Api> apis(2);
+  for (auto& api : apis) {
+    auto& options = *api.mutable_options();
+    options.set_action(Options::route);
+    options.set_costing(Costing::auto_);
+    for (const auto& ll : {std::make_pair(-76.385076, 40.546115),
+                           std::make_pair(-76.385752, 40.544232)}) {
+      auto* location = options.add_locations();
+      location->mutable_ll()->set_lng(ll.first);
+      location->mutable_ll()->set_lat(ll.second);
+    }
+  }
+  auto api_results = actor.batch(apis);
+  ASSERT_EQ(api_results.size(), apis.size());
+  for (size_t i = 0; i < apis.size(); ++i) {
+    EXPECT_FALSE(api_results[i].error) << i;
+    EXPECT_EQ(apis[i].trip().routes_size(), 1) << i;
+    EXPECT_EQ(apis[i].directions().routes_size(), 1) << i;
+    EXPECT_NE(api_results[i].response.find("Tulpehocken"), std::string::npos) << i;
+  }
+}
+
 // TODO: test the rest of them
 
 } // namespace
@@ -0,0 +1,185 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <unordered_map>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include "worker.h"
+
+#include "test.h"
+
+using namespace valhalla;
+
+namespace {
+
+Api request(Options::Action action) {
+  Api api;
+  api.mutable_options()->set_action(action);
+  return api;
+}
+
+std::unordered_map<std::string, double> statistics(const admission_t& admission) {
+  Api api;
+  admission.statistics("test::", api);
+  std::unordered_map<std::string, double> stats;
+  for (const auto& stat : api.info().statistics()) {
+    stats[stat.name()] = stat.value();
+  }
+  return stats;
+}
+
+unsigned error_code(admission_t& admission, Options::Action action) {
+  try {
+    auto api = request(action);
+    admission.admit(api, "test::");
+  } catch (const valhalla_exception_t& e) { return e.code; }
+  return 0;
+}
+
+// waits until the given number of requests are waiting for a slot
+void wait_for_waiters(const admission_t& admission, double waiters) {
+  while (statistics(admission)["test::admission_waiting"] != waiters) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+TEST(Admission, NothingToDoWithoutLimits) {
+  boost::property_tree::ptree config;
+  EXPECT_EQ(admission_t::shared(config, "test"), nullptr);
+  config.put("service_limits.admission.max_wait", 10);
+  config.put("service_limits.admission.actions.route.priority", 1);
+  EXPECT_EQ(admission_t::shared(config, "test"), nullptr);
+  config.put("service_limits.admission.actions.route.max_concurrent", 1);
+  auto admission = admission_t::shared(config, "test");
+  ASSERT_NE(admission, nullptr);
+  EXPECT_EQ(admission, admission_t::shared(config, "test"));
+  EXPECT_NE(admission, admission_t::shared(config, "other"));
+}
+
+TEST(Admission, UnknownAction) {
+  boost::property_tree::ptree config;
+  config.put("actions.teleport.max_concurrent", 1);
+  EXPECT_THROW(admission_t{config}, std::runtime_error);
+}
+
+TEST(Admission, LimitsEachAction) {
+  boost::property_tree::ptree config;
+  config.put("max_wait", 0);
+  config.put("actions.sources_to_targets.max_concurrent", 1);
+  admission_t admission(config);
+
+  auto matrix = request(Options::sources_to_targets);
+  {
+    auto ticket = admission.admit(matrix, "test::");
+    // another matrix has to wait but the other actions dont
+    EXPECT_EQ(error_code(admission, Options::sources_to_targets), 105);
+    EXPECT_EQ(error_code(admission, Options::route), 0);
+    EXPECT_EQ(statistics(admission)["test::admission_sources_to_targets_running"], 1);
+  }
+  // the slot is given back with the ticket
+  EXPECT_EQ(error_code(admission, Options::sources_to_targets), 0);
+
+  auto stats = statistics(admission);
+  EXPECT_EQ(stats["test::admission_running"], 0);
+  EXPECT_EQ(stats["test::admission_sources_to_targets_admitted"], 2);
+  EXPECT_EQ(stats["test::admission_sources_to_targets_rejected"], 1);
+  EXPECT_EQ(stats["test::admission_route_admitted"], 1);
+  EXPECT_EQ(stats.count("test::admission_locate_admitted"), 0);
+}
+
+TEST(Admission, WaitsForASlot) {
+  boost::property_tree::ptree config;
+  config.put("max_wait", 60000);
+  config.put("actions.isochrone.max_concurrent", 1);
+  admission_t admission(config);
+
+  auto first = request(Options::isochrone);
+  std::unique_ptr<admission_t::ticket_t> ticket(
+      new admission_t::ticket_t(admission.admit(first, "test::")));
+  auto second = request(Options::isochrone);
+  std::thread waiter([&admission, &second]() { admission.admit(second, "test::"); });
+  wait_for_waiters(admission, 1);
+  ticket.reset();
+  waiter.join();
+
+  // the one that waited says so
+  ASSERT_EQ(second.info().statistics_size(), 1);
+  EXPECT_EQ(second.info().statistics(0).name(), "test::admission_wait");
+  EXPECT_GT(second.info().statistics(0).value(), 0);
+  EXPECT_GT(statistics(admission)["test::admission_isochrone_wait_max"], 0);
+}
+
+TEST(Admission, FullQueueTurnsAway) {
+  boost::property_tree::ptree config;
+  config.put("max_wait", 60000);
+  config.put("actions.isochrone.max_concurrent", 1);
+  config.put("actions.isochrone.max_queued", 1);
+  admission_t admission(config);
+
+  auto first = request(Options::isochrone);
+  std::unique_ptr<admission_t::ticket_t> ticket(
+      new admission_t::ticket_t(admission.admit(first, "test::")));
+  std::thread waiter([&admission]() { EXPECT_EQ(error_code(admission, Options::isochrone), 0); });
+  wait_for_waiters(admission, 1);
+  EXPECT_EQ(error_code(admission, Options::isochrone), 105);
+  ticket.reset();
+  waiter.join();
+}
+
+TEST(Admission, DeadlineCutsTheWaitShort) {
+  boost::property_tree::ptree config;
+  config.put("max_wait", 60000);
+  config.put("actions.isochrone.max_concurrent", 1);
+  admission_t admission(config);
+
+  auto first = request(Options::isochrone);
+  auto ticket = admission.admit(first, "test::");
+  auto second = request(Options::isochrone);
+  second.mutable_info()->set_deadline(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                          std::chrono::system_clock::now().time_since_epoch())
+                                          .count() +
+                                      10);
+  try {
+    admission.admit(second, "test::");
+    FAIL() << "Expected the request to run out of time";
+  } catch (const valhalla_exception_t& e) { EXPECT_EQ(e.code, 104); }
+}
+
+TEST(Admission, HigherPriorityGoesFirst) {
+  boost::property_tree::ptree config;
+  config.put("max_concurrent", 1);
+  config.put("max_wait", 60000);
+  config.put("actions.locate.priority", 2);
+  admission_t admission(config);
+
+  auto first = request(Options::sources_to_targets);
+  std::unique_ptr<admission_t::ticket_t> ticket(
+      new admission_t::ticket_t(admission.admit(first, "test::")));
+
+  // the matrix gets in line before the locate does
+  std::atomic<int> order{0};
+  int matrix_order = 0, locate_order = 0;
+  auto wait = [&admission, &order](Options::Action action, int& admitted_order) {
+    auto api = request(action);
+    auto ticket = admission.admit(api, "test::");
+    admitted_order = ++order;
+  };
+  std::thread matrix(wait, Options::sources_to_targets, std::ref(matrix_order));
+  wait_for_waiters(admission, 1);
+  std::thread locate(wait, Options::locate, std::ref(locate_order));
+  wait_for_waiters(admission, 2);
+
+  ticket.reset();
+  matrix.join();
+  locate.join();
+  EXPECT_EQ(locate_order, 1);
+  EXPECT_EQ(matrix_order, 2);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -21,7 +21,9 @@
 #include "mjolnir/util.h"
 #include "odin/directionsbuilder.h"
 #include "odin/worker.h"
+#include "sif/autocost.h"
 #include "sif/costconstants.h"
+#include "sif/costkernel.h"
 #include "sif/dynamiccost.h"
 #include "sif/pedestriancost.h"
 #include "thor/attributes_controller.h"
@@ -1506,6 +1508,30 @@ TEST(ComplexRestriction, WalkVias) {
   }
 }
 
+TEST(BDEdgeLabel, PackedOpposingEdge) {
+  // the opposing edge id is split across the spare bits of the base and its padding
+  DirectedEdge edge;
+  for (const auto& opp_id : {GraphId(1234, 2, 567), GraphId(), GraphId(0, 0, 0),
+                             GraphId(vb::kMaxGraphTileId, 2, vb::kMaxGraphId)}) {
+    for (bool pruning : {true, false}) {
+      vs::BDEdgeLabel label(7, GraphId(5, 1, 3), opp_id, &edge, vs::Cost{1, 2}, 3, 4,
+                            vs::TravelMode::kDrive, vs::Cost{5, 6}, pruning, false, false,
+                            sif::InternalTurn::kNoTurn, 3, 5);
+      EXPECT_EQ(label.opp_edgeid(), opp_id);
+      EXPECT_EQ(label.not_thru_pruning(), pruning);
+      EXPECT_EQ(label.edgeid(), GraphId(5, 1, 3));
+      EXPECT_EQ(label.restriction_idx(), 3);
+      EXPECT_EQ(label.path_id(), 5);
+      label.Update(8, vs::Cost{9, 10}, 11, vs::Cost{12, 13}, 14, 15);
+      EXPECT_EQ(label.opp_edgeid(), opp_id);
+      EXPECT_EQ(label.not_thru_pruning(), pruning);
+    }
+  }
+#ifndef _MSC_VER
+  EXPECT_EQ(sizeof(vs::BDEdgeLabel), 56);
+#endif
+}
+
 TEST(Astar, BiDirTrivial) {
   // Normally the service does not allow a trivial path with bidirectional astar because it has some
   // problems with those (oneways that make you go around the block to get to where you started?).
@@ -1560,6 +1586,48 @@ TEST(Astar, BiDirTrivial) {
   EXPECT_LT(path.front().elapsed_cost.secs, 1);
 }
 
+// A costing derived from AutoCost is not exactly an AutoCost so the search calls it virtually
+class DerivedAutoCost : public vs::AutoCost {
+public:
+  using vs::AutoCost::AutoCost;
+};
+
+TEST(BiDiAstar, CostKernelMatchesVirtualCalls) {
+  boost::property_tree::ptree conf;
+  conf.put("tile_dir", "test/data/utrecht_tiles");
+  vb::GraphReader graph_reader(conf);
+
+  Options options;
+  create_costing_options(options, Costing::auto_);
+  vs::TravelMode mode;
+  auto mode_costing = vs::CostFactory().CreateModeCosting(options, mode);
+  auto virtual_costing = mode_costing;
+  virtual_costing[int(mode)] = std::make_shared<DerivedAutoCost>(
+      options.costing_options(static_cast<int>(Costing::auto_)));
+  ASSERT_TRUE(vs::CostKernel<vs::AutoCost>::Matches(*mode_costing[int(mode)]));
+  ASSERT_FALSE(vs::CostKernel<vs::AutoCost>::Matches(*virtual_costing[int(mode)]));
+
+  std::vector<vb::Location> locations{vb::Location(midgard::PointLL{5.115873, 52.099247}),
+                                      vb::Location(midgard::PointLL{5.114576, 52.101841})};
+  auto pbf_locations = ToPBFLocations(locations, graph_reader, mode_costing[int(mode)]);
+
+  vt::BidirectionalAStar astar;
+  const auto expected =
+      astar.GetBestPath(pbf_locations[0], pbf_locations[1], graph_reader, virtual_costing, mode)
+          .front();
+  astar.Clear();
+  const auto path =
+      astar.GetBestPath(pbf_locations[0], pbf_locations[1], graph_reader, mode_costing, mode)
+          .front();
+
+  ASSERT_FALSE(path.empty());
+  ASSERT_EQ(path.size(), expected.size());
+  for (size_t i = 0; i < path.size(); ++i) {
+    EXPECT_EQ(path[i].edgeid, expected[i].edgeid);
+    EXPECT_EQ(path[i].elapsed_cost.cost, expected[i].elapsed_cost.cost);
+  }
+}
+
 TEST(BiDiAstar, test_recost_path) {
   const std::string ascii_map = R"(
            X-----------Y
@@ -1674,6 +1742,29 @@ TEST(BiDiAstar, test_recost_path) {
   }
 }
 
+TEST(AStarHeuristic, DistancesOfEndNodesMatchOneAtATime) {
+  auto reader = get_graph_reader(test_dir);
+  auto tile = reader->GetGraphTile(tile_id);
+  ASSERT_NE(tile, nullptr);
+
+  vt::AStarHeuristic heuristic;
+  heuristic.Init(node_locations["b"], 1.f);
+  float dists[vb::kMaxEdgesPerNode];
+  for (uint32_t n = 0; n < tile->header()->nodecount(); ++n) {
+    const auto* node = tile->node(n);
+    const auto* edges = tile->directededge(node->edge_index());
+    heuristic.GetDistances(*tile, edges, node->edge_count(), dists);
+    for (uint32_t i = 0; i < node->edge_count(); ++i) {
+      if (edges[i].leaves_tile()) {
+        EXPECT_EQ(dists[i], vt::AStarHeuristic::kUnknownDistance);
+        continue;
+      }
+      float dist = heuristic.GetDistance(tile->get_node_ll(edges[i].endnode()));
+      EXPECT_NEAR(dists[i], dist, 0.01f + dist * 1e-5f);
+    }
+  }
+}
+
 class AstarTestEnv : public ::testing::Environment {
 public:
   void SetUp() override {
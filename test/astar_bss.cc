@@ -2,6 +2,7 @@
 
 #include "loki/worker.h"
 #include "odin/worker.h"
+#include "thor/bss_stations.h"
 #include "thor/worker.h"
 
 #include <boost/optional.hpp>
@@ -336,3 +337,19 @@ TEST(AstarBss, test_BSSConnections_on_Pedestrian_and_Bicycle) {
       "e~le|A_ldoCyD~IoAtCkArC]z@kBpEeAsAdArAjBqE\\{@jAsCad@ai@yAgBo@iCuF_Ua@_B[uAyQgz@i@cCwAt@mg@bXyt@b`@yCvAyBqH{EgLiCvEoD|G{\\`r@wFqHoPqTy@gAyAkBe@o@i@q@{D_CeB{@wCfC{XfVt@jCjA~Dn@xB?lBcA|BV\\f@r@wBlE";
   test_request(request, expected_travel_modes, expected_route, expected_bss_maneuver, expected_shape);
 }
+
+TEST(AstarBss, test_Closest_Station) {
+  GraphReader reader(conf.get_child("mjolnir"));
+  vt::BssStations stations;
+
+  // the station of the previous test is right where it was built
+  EXPECT_LT(stations.Distance(reader, {2.3622890, 48.8690345}), 5.0f);
+  auto distance = stations.Distance(reader, {2.362034, 48.864218});
+  EXPECT_GT(distance, 5.0f);
+  EXPECT_LT(distance, vt::kMaxStationAccess);
+
+  // nowhere near the tiles
+  EXPECT_EQ(stations.Distance(reader, {0.0, 0.0}), vt::kMaxStationAccess);
+  vt::BssStations closer(100.0f);
+  EXPECT_LE(closer.Distance(reader, {2.362034, 48.864218}), 100.0f);
+}
@@ -30,3 +30,27 @@ assert('legs' in route['trip'] and len(route['trip']['legs']) > 0)
 assert('maneuvers' in route['trip']['legs'][0] and len(route['trip']['legs'][0]['maneuvers']) > 0)
 assert('instruction' in route['trip']['legs'][0]['maneuvers'][0])
 assert(has_cyrillic(route['trip']['legs'][0]['maneuvers'][0]['instruction']))
+
+# a pool answers the same from many threads at once
+pool = valhalla.ActorPool(2)
+pooled = json.loads(pool.Route(query))
+assert(pooled['trip']['summary']['length'] == route['trip']['summary']['length'])
+batch = [json.loads(r) for r in pool.Batch('route', [query] * 4)]
+assert(len(batch) == 4)
+assert(all(r['trip']['summary']['length'] == route['trip']['summary']['length'] for r in batch))
+try:
+    pool.Batch('teleport', [query])
+    assert(False)
+except RuntimeError:
+    pass
+
+# the matrix as numpy arrays of sources by targets has the same times and distances as the json
+matrix_query = '{"sources":[{"lat":52.08813,"lon":5.03231},{"lat":52.09987,"lon":5.14913}],"targets":[{"lat":52.09987,"lon":5.14913},{"lat":52.07012,"lon":5.10612},{"lat":52.08813,"lon":5.03231}],"costing":"auto"}'
+matrix = json.loads(actor.Matrix(matrix_query))
+for arrays in [actor.MatrixArrays(matrix_query), pool.MatrixArrays(matrix_query)]:
+    assert(arrays['times'].shape == (2, 3) and arrays['distances'].shape == (2, 3))
+    assert(len(arrays['unreachable']) == 0)
+    for i, row in enumerate(matrix['sources_to_targets']):
+        for j, cell in enumerate(row):
+            assert(arrays['times'][i][j] == cell['time'])
+            assert(abs(arrays['distances'][i][j] - cell['distance']) < 0.001)
@@ -1,6 +1,7 @@
 
 #include <cstdint>
 #include <string>
+#include <thread>
 
 #include "baldr/datetime.h"
 #include "baldr/graphconstants.h"
@@ -221,6 +222,34 @@ TEST(DateTime, TestGetDaysFromPivotDate) {
   TryGetDaysFromPivotDate("2015-05-06T08:00", 490);
 }
 
+TEST(DateTime, FastFormattedDate) {
+  // what the date library alone makes of the strings
+  auto slow = [](const std::string& date_time, date::local_seconds& tp) {
+    std::istringstream in{date_time};
+    if (date_time.find('T') != std::string::npos)
+      in >> date::parse("%FT%R", tp);
+    else if (date_time.find('-') != std::string::npos)
+      in >> date::parse("%F", tp);
+    else
+      in.setstate(std::ios::failbit);
+    return !in.fail();
+  };
+
+  for (const std::string date_time :
+       {"2015-05-06T08:00", "2015-05-06", "2016-02-29T23:59", "2000-01-01T00:00", "1999-12-31",
+        "2015-5-6T08:00", "2015-05-06T8:00", "2015-05-06T08:00:30", "2015-05-06 08:00",
+        "2015-02-30T08:00", "2015-13-06T08:00", "2015-05-06T24:00", "2015-05-06T08:60",
+        "2015-05-06T0a:00", "Tuesday", ""}) {
+    date::local_seconds expected;
+    if (slow(date_time, expected)) {
+      EXPECT_EQ(DateTime::get_formatted_date(date_time, true), expected) << date_time;
+    } else {
+      EXPECT_THROW(DateTime::get_formatted_date(date_time, true), std::invalid_argument)
+          << date_time;
+    }
+  }
+}
+
 TEST(DateTime, TestDOW) {
   TryGetDOW("2014-01-01T07:01", kWednesday);
   TryGetDOW("2014-01-02T15:00", kThursday);
@@ -701,6 +730,38 @@ TEST(DateTime, DiffCaching) {
   EXPECT_GE(cache.size(), test_cases.size());
 }
 
+TEST(DateTime, SharedOffsets) {
+  const auto& tzdb = DateTime::get_tz_db();
+  EXPECT_EQ(DateTime::utc_offset(1586660072, nullptr), 0);
+
+  // every few hours across dst changes, jumping far enough that the windows have to move
+  auto check = [&tzdb](const std::string& zone) {
+    const auto* tz = tzdb.from_index(tzdb.to_index(zone));
+    ASSERT_NE(tz, nullptr) << zone;
+    for (uint64_t start : {946684800ull, 1586660072ull, 4102444800ull, 1586660072ull}) {
+      for (uint64_t seconds = start; seconds < start + 3 * 366 * 86400; seconds += 5 * 3600 + 7) {
+        const auto info = tz->get_info(date::sys_seconds(std::chrono::seconds(seconds)));
+        ASSERT_EQ(DateTime::utc_offset(seconds, tz), info.offset.count()) << zone << " " << seconds;
+      }
+    }
+  };
+
+  // and from a few threads at once since the tables are shared
+  std::vector<std::thread> threads;
+  for (const auto* zone : {"America/New_York", "Europe/Berlin", "Australia/Sydney", "Etc/UTC",
+                           "Asia/Kolkata", "America/Sao_Paulo"}) {
+    threads.emplace_back(check, zone);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // without a cache the differences come from the shared tables
+  EXPECT_EQ(DateTime::timezone_diff(1586660072, tzdb.from_index(110), tzdb.from_index(94)),
+            DateTime::utc_offset(1586660072, tzdb.from_index(94)) -
+                DateTime::utc_offset(1586660072, tzdb.from_index(110)));
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
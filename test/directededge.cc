@@ -1,5 +1,6 @@
 
 #include "baldr/directededge.h"
+#include "baldr/routingedge.h"
 
 #include "test.h"
 
@@ -57,6 +58,43 @@ TEST(DirectedEdge, TestWriteRead) {
   EXPECT_FALSE(directededge.name_consistency(6)) << "overwrite test failed";
 }
 
+TEST(DirectedEdge, TestRoutingEdge) {
+  // The routing edge has to read back what the directed edge has, at the limits of each field
+  DirectedEdge edge;
+  edge.set_endnode(GraphId(123456, 2, 87654));
+  edge.set_restrictions(0xff);
+  edge.set_opp_index(kMaxEdgesPerNode);
+  edge.set_leaves_tile(true);
+  edge.set_not_thru(true);
+  edge.set_forwardaccess(kAllAccess);
+  edge.set_reverseaccess(kAutoAccess);
+  edge.set_length(kMaxEdgeLength);
+  edge.set_speed(kMaxSpeedKph);
+  edge.set_shortcut(1 << 6);
+  edge.set_superseded(1 << 6);
+  edge.set_dest_only(true);
+  edge.set_classification(RoadClass::kServiceOther);
+  edge.set_use(Use::kFerry);
+
+  RoutingEdge routing(edge);
+  EXPECT_EQ(routing.endnode(), edge.endnode());
+  EXPECT_EQ(routing.restrictions(), edge.restrictions());
+  EXPECT_EQ(routing.opp_index(), edge.opp_index());
+  EXPECT_EQ(routing.leaves_tile(), edge.leaves_tile());
+  EXPECT_EQ(routing.is_shortcut(), edge.is_shortcut());
+  EXPECT_EQ(routing.not_thru(), edge.not_thru());
+  EXPECT_EQ(routing.forwardaccess(), edge.forwardaccess());
+  EXPECT_EQ(routing.reverseaccess(), edge.reverseaccess());
+  EXPECT_EQ(routing.length(), edge.length());
+  EXPECT_EQ(routing.speed(), edge.speed());
+  EXPECT_EQ(routing.shortcut(), edge.shortcut());
+  EXPECT_EQ(routing.superseded(), edge.superseded());
+  EXPECT_EQ(routing.destonly(), edge.destonly());
+  EXPECT_EQ(routing.classification(), edge.classification());
+  EXPECT_EQ(routing.use(), edge.use());
+  EXPECT_EQ(sizeof(RoutingEdge), kDirectedEdgeExpectedSize / 2);
+}
+
 TEST(DirectedEdge, TestMaxSlope) {
   // Test setting max slope and reading back values
   DirectedEdge edge;
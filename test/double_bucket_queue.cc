@@ -23,6 +23,14 @@ struct simple_label {
   }
 };
 
+// costs in fixed point, tenths of the costs of the simple label
+struct fixed_point_label {
+  uint32_t c;
+  uint32_t sortcost() const {
+    return c;
+  }
+};
+
 void TryAddRemove(const std::vector<uint32_t>& costs, const std::vector<uint32_t>& expectedorder) {
   std::vector<simple_label> edgelabels;
 
@@ -101,10 +109,11 @@ TEST(DoubleBucketQueue, RC4FloatPrecisionErrors) {
    }
 */
 
-void TryRemove(DoubleBucketQueue<simple_label>& dbqueue,
+template <typename label_t>
+void TryRemove(DoubleBucketQueue<label_t>& dbqueue,
                size_t num_to_remove,
-               const std::vector<simple_label>& costs) {
-  auto previous_cost = -std::numeric_limits<float>::infinity();
+               const std::vector<label_t>& costs) {
+  auto previous_cost = std::numeric_limits<decltype(costs.front().sortcost())>::lowest();
   for (size_t i = 0; i < num_to_remove; ++i) {
     const auto top = dbqueue.pop();
     EXPECT_NE(top, baldr::kInvalidLabel)
@@ -120,8 +129,9 @@ void TryRemove(DoubleBucketQueue<simple_label>& dbqueue,
   }
 }
 
-void TrySimulation(DoubleBucketQueue<simple_label>& dbqueue,
-                   std::vector<simple_label>& costs,
+template <typename label_t>
+void TrySimulation(DoubleBucketQueue<label_t>& dbqueue,
+                   std::vector<label_t>& costs,
                    size_t loop_count,
                    size_t expansion_size,
                    size_t max_increment_cost) {
@@ -129,7 +139,7 @@ void TrySimulation(DoubleBucketQueue<simple_label>& dbqueue,
   std::unordered_set<uint32_t> addedLabels;
 
   const uint32_t idx = costs.size();
-  costs.push_back({10.f});
+  costs.push_back({10});
   dbqueue.add(idx);
   std::random_device rd;
   std::mt19937 gen(rd());
@@ -147,7 +157,8 @@ void TrySimulation(DoubleBucketQueue<simple_label>& dbqueue,
     addedLabels.erase(key);
 
     for (size_t i = 0; i < expansion_size; i++) {
-      const auto newcost = std::floor(min_cost + 1 + test::rand01(gen) * max_increment_cost);
+      const auto newcost = static_cast<decltype(min_cost)>(
+          std::floor(min_cost + 1 + test::rand01(gen) * max_increment_cost));
       if (i % 2 == 0 && !addedLabels.empty()) {
         // Decrease cost
         const auto idx = *std::next(addedLabels.begin(), test::rand01(gen) * (addedLabels.size()));
@@ -203,6 +214,87 @@ TEST(DoubleBucketQueue, TestSimulation) {
   }
 }
 
+TEST(DoubleBucketQueue, TestCoarseOverflow) {
+  // a tiny range so that most costs start out in the coarse overflow buckets
+  {
+    std::vector<simple_label> costs;
+    DoubleBucketQueue<simple_label> dbqueue(0, 10, 1, &costs, 100);
+    TrySimulation(dbqueue, costs, 1000, 10, 1000);
+  }
+
+  {
+    std::vector<simple_label> costs;
+    DoubleBucketQueue<simple_label> dbqueue(0, 10, 1, &costs, 4);
+    TrySimulation(dbqueue, costs, 333, 60, 100);
+  }
+
+  // costs far beyond the coarse buckets still come out in order
+  std::vector<simple_label> edgelabels;
+  DoubleBucketQueue<simple_label> adjlist(0, 10, 1, &edgelabels, 16);
+  std::vector<float> costs = {67, 325, 25, 466, 1000, 100005, 758, 167, 258, 16442, 278, 111111000};
+  for (uint32_t i = 0; i < costs.size(); ++i) {
+    edgelabels.push_back({costs[i]});
+    adjlist.add(i);
+  }
+  std::sort(costs.begin(), costs.end());
+  for (auto expected : costs) {
+    auto label = adjlist.pop();
+    ASSERT_NE(label, baldr::kInvalidLabel);
+    EXPECT_EQ(edgelabels[label].sortcost(), expected);
+  }
+  EXPECT_EQ(adjlist.pop(), baldr::kInvalidLabel);
+  // all but the first few costs had to be moved down into the low level buckets
+  EXPECT_GE(adjlist.resorts(), costs.size() - 3);
+
+  // reusing it without coarse buckets starts over from the initial range
+  adjlist.clear();
+  adjlist.reuse(0, 10, 1, &edgelabels);
+  EXPECT_EQ(adjlist.resorts(), 0);
+  edgelabels.push_back({3});
+  adjlist.add(edgelabels.size() - 1);
+  EXPECT_EQ(adjlist.pop(), edgelabels.size() - 1);
+  EXPECT_EQ(adjlist.resorts(), 0);
+}
+
+TEST(DoubleBucketQueue, TestFixedPoint) {
+  std::vector<fixed_point_label> edgelabels;
+  EXPECT_THROW(DoubleBucketQueue<fixed_point_label> adjlist(0, 10000, 3, &edgelabels),
+               runtime_error)
+      << "Bucket sizes which are not a power of 2 are not caught";
+
+  // the same order as floating point costs, costs above the range included
+  std::vector<uint32_t> costs = {67,  325, 25,  466,   1000, 100005,
+                                 758, 167, 258, 16442, 278,  1320209856};
+  DoubleBucketQueue<fixed_point_label> adjlist(0, 10000, 4, &edgelabels);
+  for (uint32_t i = 0; i < costs.size(); ++i) {
+    edgelabels.push_back({costs[i]});
+    adjlist.add(i);
+  }
+  adjlist.decrease(5, 20);
+  edgelabels[5] = {20};
+  std::vector<uint32_t> expected = costs;
+  expected[5] = 20;
+  std::sort(expected.begin(), expected.end());
+  for (auto cost : expected) {
+    auto label = adjlist.pop();
+    ASSERT_NE(label, baldr::kInvalidLabel);
+    EXPECT_EQ(edgelabels[label].sortcost(), cost);
+  }
+  EXPECT_EQ(adjlist.pop(), baldr::kInvalidLabel);
+
+  {
+    std::vector<fixed_point_label> costs;
+    DoubleBucketQueue<fixed_point_label> dbqueue(0, 1024, 1, &costs);
+    TrySimulation(dbqueue, costs, 1000, 10, 1000);
+  }
+
+  {
+    std::vector<fixed_point_label> costs;
+    DoubleBucketQueue<fixed_point_label> dbqueue(0, 16, 1, &costs, 16);
+    TrySimulation(dbqueue, costs, 333, 60, 100);
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
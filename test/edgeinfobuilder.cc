@@ -100,6 +100,119 @@ TEST(EdgeInfoBuilder, TestWriteRead) {
   }
 }
 
+TEST(EdgeInfoBuilder, Elevation) {
+  EdgeInfoBuilder eibuilder;
+  eibuilder.set_wayid(6472927700900931484);
+  std::vector<PointLL> shape{{-76.3002, 40.0433}, {-76.3036, 40.043}, {-76.304, 40.05}};
+  eibuilder.set_shape(shape);
+
+  // without elevation nothing is stored for it
+  auto size = eibuilder.SizeOf();
+  EXPECT_TRUE(EdgeInfo(ToFileAndBack(eibuilder).get(), nullptr, 0).elevation().empty());
+
+  // big and small steps as well as what is out of range, which is clamped
+  std::vector<float> elevation{12.34f, 12.3f, 812.f, -9000.f, 9000.f};
+  eibuilder.set_elevation(elevation);
+  EXPECT_GT(eibuilder.SizeOf(), size);
+  boost::shared_array<char> memblock = ToFileAndBack(eibuilder);
+  EdgeInfo ei(memblock.get(), nullptr, 0);
+  EXPECT_TRUE(ei.has_elevation());
+  EXPECT_EQ(ei.wayid(), 6472927700900931484);
+  EXPECT_EQ(ei.shape().size(), shape.size());
+  auto decoded = ei.elevation();
+  ASSERT_EQ(decoded.size(), elevation.size());
+  EXPECT_NEAR(decoded[0], 12.3f, 1e-3);
+  EXPECT_NEAR(decoded[1], 12.3f, 1e-3);
+  EXPECT_NEAR(decoded[2], 812.f, 1e-3);
+  EXPECT_NEAR(decoded[3], kMinElevation, 1e-3);
+  EXPECT_NEAR(decoded[4], kMaxElevation, 1e-2);
+}
+
+TEST(EdgeInfoBuilder, SharedShapeCache) {
+  EdgeInfoBuilder eibuilder;
+  eibuilder.set_wayid(1234);
+  std::vector<PointLL> shape{{-76.3002, 40.0433}, {-76.3036, 40.043}, {-76.304, 40.05}};
+  eibuilder.set_shape(shape);
+  boost::shared_array<char> memblock = ToFileAndBack(eibuilder);
+
+  // every edge info of the same offset gets the same decoded shape out of the cache
+  EdgeShapeCache cache(4096);
+  EdgeInfo first(memblock.get(), nullptr, 0, &cache, 42);
+  EdgeInfo second(memblock.get(), nullptr, 0, &cache, 42);
+  ASSERT_EQ(first.shape().size(), shape.size());
+  EXPECT_EQ(&first.shape(), &second.shape());
+  for (size_t i = 0; i < shape.size(); ++i) {
+    EXPECT_TRUE(shape[i].ApproximatelyEqual(first.shape()[i])) << "index " << i;
+  }
+  EXPECT_GT(cache.size(), shape.size() * sizeof(PointLL));
+  EXPECT_LE(cache.size(), cache.max_size());
+
+  // it never grows past its bound, but what is handed out stays valid
+  const auto one = cache.size();
+  for (uint32_t offset = 0; offset < 1000; ++offset) {
+    EdgeInfo(memblock.get(), nullptr, 0, &cache, offset).shape();
+    EXPECT_LE(cache.size(), cache.max_size());
+  }
+  EXPECT_EQ(first.shape().size(), shape.size());
+
+  // shapes that could never fit are decoded but not kept
+  EdgeShapeCache tiny(one - 1);
+  EdgeInfo uncached(memblock.get(), nullptr, 0, &tiny, 42);
+  EXPECT_EQ(uncached.shape().size(), shape.size());
+  EXPECT_EQ(tiny.size(), 0);
+}
+
+TEST(EdgeInfoBuilder, NameViews) {
+  EdgeInfoBuilder eibuilder;
+  eibuilder.set_wayid(6472927700900931484);
+  std::vector<PointLL> shape{{-76.3002, 40.0433}, {-76.3036, 40.043}};
+  eibuilder.set_shape(shape);
+  std::vector<float> elevation{12.3f, 15.f};
+  eibuilder.set_elevation(elevation);
+
+  // a regular name, a tagged tunnel name and a route number, the last one isnt terminated
+  const char text_list[] = "Main Street\0"
+                           "1Main Tunnel\0"
+                           "A1";
+  std::vector<NameInfo> name_info_list{{0}, {12}, {25}};
+  name_info_list[1].tagged_ = true;
+  name_info_list[2].is_route_num_ = true;
+  eibuilder.set_name_info_list(name_info_list);
+  boost::shared_array<char> memblock = ToFileAndBack(eibuilder);
+  EdgeInfo ei(memblock.get(), text_list, sizeof(text_list) - 1);
+
+  // the views point into the text list itself
+  EXPECT_EQ(ei.GetName(0), "Main Street");
+  EXPECT_EQ(ei.GetName(0).data(), text_list);
+  EXPECT_EQ(ei.GetName(1), "1Main Tunnel");
+  EXPECT_EQ(ei.GetName(2), "A1");
+  EXPECT_THROW(ei.GetName(3), std::runtime_error);
+
+  auto views = ei.GetNameViews();
+  ASSERT_EQ(views.size(), 2);
+  EXPECT_EQ(views[0], "Main Street");
+  EXPECT_EQ(views[1], "A1");
+  auto tagged_views = ei.GetNameViews(true);
+  ASSERT_EQ(tagged_views.size(), 1);
+  EXPECT_EQ(tagged_views[0], "1Main Tunnel");
+
+  // the copies are made from the same text
+  EXPECT_EQ(ei.GetNames(), (std::vector<std::string>{"Main Street", "A1"}));
+  EXPECT_EQ(ei.GetNames(true), (std::vector<std::string>{"1Main Tunnel"}));
+  auto names_and_types = ei.GetNamesAndTypes(true);
+  ASSERT_EQ(names_and_types.size(), 3);
+  EXPECT_EQ(names_and_types[1], std::make_pair(std::string("Main Tunnel"), false));
+  EXPECT_EQ(names_and_types[2], std::make_pair(std::string("A1"), true));
+  auto tagged_names_and_types = ei.GetTaggedNamesAndTypes();
+  ASSERT_EQ(tagged_names_and_types.size(), 1);
+  EXPECT_EQ(tagged_names_and_types[0].first, "Main Tunnel");
+  EXPECT_EQ(tagged_names_and_types[0].second, 1);
+
+  // what follows the shape is still found when it is asked for
+  EXPECT_EQ(ei.wayid(), 6472927700900931484);
+  EXPECT_EQ(ei.elevation().size(), elevation.size());
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -66,6 +66,49 @@ TEST(EdgeStatus, TestStatus) {
   TryGet(edgestatus, GraphId(555, 3, 1), EdgeSet::kUnreachedOrReset);
 }
 
+TEST(EdgeStatus, ManyTilesAndReuse) {
+  EdgeStatus edgestatus;
+
+  GraphTileHeader header;
+  header.set_directededgecount(100);
+  test_tile* tt = new test_tile;
+  tt->header_ = &header;
+  graph_tile_ptr tile{tt};
+
+  // enough tiles and paths to make the table grow a few times
+  for (int pass = 0; pass < 2; ++pass) {
+    for (uint32_t tile_id = 0; tile_id < 500; ++tile_id) {
+      for (uint8_t path_id = 0; path_id < 3; ++path_id) {
+        edgestatus.Set(GraphId(tile_id, 2, tile_id % 100), EdgeSet::kTemporary, tile_id, tile,
+                       path_id);
+      }
+      edgestatus.Update(GraphId(tile_id, 2, tile_id % 100), EdgeSet::kPermanent, 1);
+    }
+    for (uint32_t tile_id = 0; tile_id < 500; ++tile_id) {
+      GraphId edgeid(tile_id, 2, tile_id % 100);
+      EXPECT_EQ(edgestatus.Get(edgeid, 0).set(), EdgeSet::kTemporary);
+      EXPECT_EQ(edgestatus.Get(edgeid, 0).index(), tile_id);
+      EXPECT_EQ(edgestatus.Get(edgeid, 1).set(), EdgeSet::kPermanent);
+      EXPECT_EQ(edgestatus.Get(edgeid, 3).set(), EdgeSet::kUnreachedOrReset);
+      // the arrays reused after a clear have to come back reset
+      EXPECT_EQ(edgestatus.Get(GraphId(tile_id, 2, (tile_id + 1) % 100)).set(),
+                EdgeSet::kUnreachedOrReset);
+    }
+    EXPECT_THROW(edgestatus.Update(GraphId(501, 2, 0), EdgeSet::kPermanent), std::runtime_error);
+    // one array per tile and path
+    EXPECT_EQ(edgestatus.size(), 1500);
+    edgestatus.clear();
+    EXPECT_EQ(edgestatus.size(), 0);
+    TryGet(edgestatus, GraphId(7, 2, 7), EdgeSet::kUnreachedOrReset);
+  }
+
+  // moving hands over the statuses
+  edgestatus.Set(GraphId(1, 2, 1), EdgeSet::kPermanent, 1, tile);
+  EdgeStatus moved(std::move(edgestatus));
+  TryGet(moved, GraphId(1, 2, 1), EdgeSet::kPermanent);
+  TryGet(edgestatus, GraphId(1, 2, 1), EdgeSet::kUnreachedOrReset);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
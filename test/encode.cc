@@ -620,6 +620,113 @@ TEST(Encode, VarInt) {
                   {58.26482, -169.02219}});
 }
 
+// Offsets right around the sizes where the encodings need another character or byte
+const container_t kBoundaryPoints = {{0, 0},          {0.000031, -0.000032}, {0.000094, -0.000096},
+                                     {0.008286, 0.0},  {0.000094, 0.008288},  {-1.0, 1.0},
+                                     {-1.000063, 1.0}, {179.999999, -89.0},   {-179.999999, 89.0}};
+
+TEST(Encode, DecodeInto) {
+  for (bool varint : {false, true}) {
+    auto encoded = varint ? encode7(kBoundaryPoints) : encode(kBoundaryPoints);
+    auto expected = varint ? decode7<container_t>(encoded) : decode<container_t>(encoded);
+    assert_approx_equal(expected, kBoundaryPoints);
+
+    // whatever was in the buffer before is replaced
+    container_t points{{1, 2}, {3, 4}};
+    if (varint) {
+      decode7_into(encoded.data(), encoded.size(), points);
+    } else {
+      decode_into(encoded.data(), encoded.size(), points);
+    }
+    EXPECT_EQ(points, expected);
+  }
+}
+
+// A box of doubles which is all the bounding box decoder needs
+struct box_t {
+  box_t() = default;
+  box_t(double minx, double miny, double maxx, double maxy)
+      : minx(minx), miny(miny), maxx(maxx), maxy(maxy) {
+  }
+  double minx = 0, miny = 0, maxx = 0, maxy = 0;
+};
+
+TEST(Encode, DecodeBoundingBox) {
+  for (bool varint : {false, true}) {
+    auto encoded = varint ? encode7(kBoundaryPoints) : encode(kBoundaryPoints);
+    auto box = varint ? decode_bbox<box_t, Shape7Decoder<std::pair<double, double>>>(encoded.data(),
+                                                                                    encoded.size())
+                      : decode_bbox<box_t>(encoded.data(), encoded.size());
+    EXPECT_NEAR(box.minx, -179.999999, 1e-6);
+    EXPECT_NEAR(box.miny, -89.0, 1e-6);
+    EXPECT_NEAR(box.maxx, 179.999999, 1e-6);
+    EXPECT_NEAR(box.maxy, 89.0, 1e-6);
+  }
+
+  auto box = decode_bbox<box_t>("", 0);
+  EXPECT_EQ(box.minx, 0);
+  EXPECT_EQ(box.maxy, 0);
+}
+
+TEST(Encode, DecodeEndpoints) {
+  for (bool varint : {false, true}) {
+    auto encoded = varint ? encode7(kBoundaryPoints) : encode(kBoundaryPoints);
+    auto decoded = varint ? decode7<container_t>(encoded) : decode<container_t>(encoded);
+    auto endpoints =
+        varint ? decode7_endpoints<std::pair<double, double>>(encoded.data(), encoded.size())
+               : decode_endpoints<std::pair<double, double>>(encoded.data(), encoded.size());
+    EXPECT_EQ(endpoints.first, decoded.front());
+    EXPECT_EQ(endpoints.second, decoded.back());
+
+    // a single point is both the first and the last point
+    using point_t = std::pair<double, double>;
+    encoded = varint ? encode7(container_t{{5.1, 52.1}}) : encode(container_t{{5.1, 52.1}});
+    endpoints = varint ? decode7_endpoints<point_t>(encoded.data(), encoded.size())
+                       : decode_endpoints<point_t>(encoded.data(), encoded.size());
+    EXPECT_EQ(endpoints.first, endpoints.second);
+    EXPECT_NEAR(endpoints.first.second, 52.1, 1e-6);
+  }
+}
+
+TEST(Encode, SpliceEncoded) {
+  // the legs of a route, each starts where the one before it ended
+  const std::vector<container_t> legs = {{{5.1, 52.1}, {5.2, 52.15}, {5.25, 52.2}},
+                                         {{5.25, 52.2}, {5.3, 52.1}},
+                                         {{5.3, 52.1}},
+                                         {{5.3, 52.1}, {-70.5, -30.25}, {5.3, 52.1}}};
+  container_t joined;
+  std::vector<std::string> encoded;
+  for (const auto& leg : legs) {
+    const auto first = joined.empty() ? leg.cbegin() : std::next(leg.cbegin());
+    joined.insert(joined.end(), first, leg.cend());
+    encoded.push_back(encode(leg));
+  }
+  std::vector<const std::string*> shapes;
+  for (const auto& shape : encoded) {
+    shapes.push_back(&shape);
+  }
+  EXPECT_EQ(splice_encoded(shapes), encode(joined));
+
+  // a leg which does not quite start where the one before ended is rebased on the end of that one
+  const container_t off = {{5.25001, 52.20002}, {5.4, 52.3}, {5.5, 52.3}};
+  const auto encoded_off = encode(off);
+  shapes = {&encoded.front(), &encoded_off};
+  joined = legs.front();
+  joined.insert(joined.end(), std::next(off.cbegin()), off.cend());
+  EXPECT_EQ(splice_encoded(shapes), encode(joined));
+
+  EXPECT_EQ(splice_encoded({}), "");
+  EXPECT_EQ(splice_encoded({&encoded.front()}), encoded.front());
+}
+
+TEST(Encode, Truncated) {
+  // the last offset is cut off in the middle so there is no end to it
+  auto encoded = encode7(kBoundaryPoints);
+  EXPECT_THROW(decode7<container_t>(encoded.substr(0, encoded.size() - 1)), std::runtime_error);
+  encoded = encode(kBoundaryPoints);
+  EXPECT_THROW(decode<container_t>(encoded.substr(0, encoded.size() - 1)), std::runtime_error);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
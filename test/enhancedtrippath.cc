@@ -145,6 +145,32 @@ TEST(EnhancedTripPathCalculateRightLeftIntersectingEdgeCounts, SharpLeftRightLef
                                               IntersectingEdgeCounts(5, 0, 0, 0, 1, 1, 0, 0));
 }
 
+TEST(EnhancedTripPathEdges, MadeOncePerIndex) {
+  TripLeg leg;
+  for (uint32_t heading : {10, 20, 30}) {
+    leg.add_node()->mutable_edge()->set_begin_heading(heading);
+  }
+  leg.add_node();
+  EnhancedTripLeg etl(leg);
+
+  // the same index always gives back the same edge, from whichever side it is asked for
+  EXPECT_EQ(etl.GetCurrEdge(1), etl.GetCurrEdge(1));
+  EXPECT_EQ(etl.GetNextEdge(0), etl.GetCurrEdge(1));
+  EXPECT_EQ(etl.GetPrevEdge(2), etl.GetCurrEdge(1));
+  EXPECT_EQ(etl.GetCurrEdge(1)->begin_heading(), 20);
+  EXPECT_EQ(etl.GetEnhancedNode(2), etl.GetEnhancedNode(2));
+
+  // there is no edge past the last node or before the first
+  EXPECT_EQ(etl.GetCurrEdge(3), nullptr);
+  EXPECT_EQ(etl.GetPrevEdge(0), nullptr);
+
+  // the leg growing does not move the ones already handed out
+  auto* edge = etl.GetCurrEdge(2);
+  leg.add_node();
+  EXPECT_EQ(etl.GetCurrEdge(2), edge);
+  EXPECT_NE(etl.GetCurrEdge(3), nullptr);
+}
+
 TEST(EnhancedTripPathDefaultTurnLaneState, True) {
   TripLeg_Edge edge;
   edge.add_turn_lanes()->set_directions_mask(kTurnLaneLeft);
@@ -1,3 +1,6 @@
+#include "baldr/directededge.h"
+#include "baldr/graphconstants.h"
+#include "baldr/nodeinfo.h"
 #include "proto/options.pb.h"
 #include "sif/autocost.h"
 #include "sif/bicyclecost.h"
@@ -5,6 +8,8 @@
 #include "sif/pedestriancost.h"
 
 #include "test.h"
+#include <typeinfo>
+#include <vector>
 
 using namespace std;
 using namespace valhalla;
@@ -27,6 +32,59 @@ TEST(Factory, Register) {
   EXPECT_THROW(factory.Create(CostingOptions{}), std::runtime_error);
 }
 
+TEST(Factory, CachedCostingsAreFreshCopies) {
+  Options options;
+  const rapidjson::Document doc;
+  sif::ParseCostingOptions(doc, "/costing_options", options);
+  options.set_costing(Costing::auto_);
+  CostFactory factory;
+  factory.set_cache_size(2);
+
+  // whatever a request changes on its costing the next one with the same options starts over
+  auto first = factory.Create(options);
+  first->set_pass(1);
+  first->set_allow_destination_only(false);
+  first->RelaxHierarchyLimits(16.f, 4.f);
+  auto second = factory.Create(options);
+  EXPECT_NE(first, second);
+  EXPECT_EQ(typeid(*second), typeid(*first));
+  EXPECT_EQ(second->pass(), 0);
+  EXPECT_EQ(second->GetHierarchyLimits()[1].max_up_transitions, kDefaultMaxUpTransitions[1]);
+  EXPECT_NE(first->GetHierarchyLimits()[1].max_up_transitions, kDefaultMaxUpTransitions[1]);
+
+  // other options make other costings, more of them than are kept still work
+  for (const auto costing : {Costing::bicycle, Costing::pedestrian, Costing::truck}) {
+    options.set_costing(costing);
+    auto cost = factory.Create(options);
+    EXPECT_EQ(typeid(*cost), typeid(*CostFactory().Create(options)));
+    EXPECT_EQ(typeid(*factory.Create(options)), typeid(*cost));
+  }
+}
+
+TEST(Factory, AllowedMask) {
+  auto car = CostFactory().Create(Costing::auto_);
+
+  // more edges than one word of the mask holds, with every combination of access and shortcuts
+  std::vector<baldr::DirectedEdge> edges(baldr::kMaxEdgesPerNode);
+  for (uint32_t i = 0; i < edges.size(); ++i) {
+    edges[i].set_forwardaccess(i % 2 ? baldr::kAutoAccess : baldr::kPedestrianAccess);
+    edges[i].set_reverseaccess(i % 3 ? baldr::kAutoAccess : baldr::kBicycleAccess);
+    edges[i].set_shortcut(i % 5 == 0);
+  }
+  for (const bool forward : {true, false}) {
+    for (const bool shortcuts : {true, false}) {
+      const auto mask = car->AllowedMask(edges.data(), edges.size(), forward, shortcuts);
+      for (uint32_t i = 0; i < edges.size(); ++i) {
+        const auto access = forward ? edges[i].forwardaccess() : edges[i].reverseaccess();
+        const bool pass = (access & car->access_mode()) && (shortcuts || !edges[i].is_shortcut());
+        EXPECT_EQ(mask.test(i), pass) << i << " " << forward << " " << shortcuts;
+      }
+    }
+  }
+  // only the edges of the node count
+  EXPECT_FALSE(car->AllowedMask(edges.data(), 1, true).test(1));
+}
+
 // TODO: add many more tests!
 
 } // namespace
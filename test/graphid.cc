@@ -2,6 +2,8 @@
 #include "baldr/graphid.h"
 #include "midgard/point2.h"
 
+#include <unordered_set>
+
 #include "test.h"
 
 using namespace std;
@@ -131,6 +133,18 @@ TEST(GraphId, TestOpEqualTo) {
   TryOpEqualTo(GraphId(5, 1, 50), GraphId(5, 1, 50));
 }
 
+TEST(GraphId, TestHasher) {
+  // the ids of one tile have to spread over the low bits which pick the slot of a flat table
+  GraphIdHasher hasher;
+  std::unordered_set<size_t> slots;
+  for (uint32_t id = 0; id < 1024; ++id) {
+    slots.insert(hasher(GraphId(12345, 2, id)) & 1023);
+  }
+  EXPECT_GT(slots.size(), 512u);
+  EXPECT_EQ(hasher(GraphId(12345, 2, 7)), hasher(GraphId(12345, 2, 7)));
+  EXPECT_NE(hasher(GraphId(12345, 2, 7)), hasher(GraphId(12345, 2, 8)));
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -2,11 +2,17 @@
 
 #include "baldr/connectivity_map.h"
 #include "baldr/graphreader.h"
+#include "baldr/tilegetter.h"
 #include "baldr/tilehierarchy.h"
 #include "filesystem.h"
+#include "mjolnir/graphtilebuilder.h"
 
+#include <atomic>
 #include <fcntl.h>
+#include <fstream>
+#include <thread>
 
+#include "microtar.h"
 #include "test.h"
 
 using namespace valhalla::baldr;
@@ -697,6 +703,34 @@ TEST(CacheLruHard, TrimBasic) {
   EXPECT_TRUE(cache.Contains(tile2_id));
 }
 
+TEST(CacheLruHard, EvictionFreesPutSize) {
+  // the size a tile is put with is not necessarily its end offset (eg. memory mapped tiles with
+  // traffic) so eviction must free what was accounted for at insertion
+  TileCacheLRU cache(500, TileCacheLRU::MemoryLimitControl::HARD);
+
+  GraphId tile1_id(1000, 1, 0);
+  cache.Put(tile1_id, graph_tile_ptr{new TestGraphTile(tile1_id, 1000)}, 100);
+
+  GraphId tile2_id(300, 2, 0);
+  cache.Put(tile2_id, graph_tile_ptr{new TestGraphTile(tile2_id, 10)}, 300);
+  EXPECT_TRUE(cache.Contains(tile1_id));
+  EXPECT_TRUE(cache.Contains(tile2_id));
+
+  // only tile1 has to go to fit this one
+  GraphId tile3_id(1, 1, 0);
+  cache.Put(tile3_id, graph_tile_ptr{new TestGraphTile(tile3_id, 10)}, 200);
+  EXPECT_FALSE(cache.Contains(tile1_id));
+  EXPECT_TRUE(cache.Contains(tile2_id));
+  EXPECT_TRUE(cache.Contains(tile3_id));
+  EXPECT_FALSE(cache.OverCommitted());
+
+  // overwriting frees the old put size as well
+  cache.Put(tile2_id, graph_tile_ptr{new TestGraphTile(tile2_id, 10)}, 250);
+  EXPECT_TRUE(cache.Contains(tile2_id));
+  EXPECT_TRUE(cache.Contains(tile3_id));
+  EXPECT_FALSE(cache.OverCommitted());
+}
+
 TEST(CacheLruSoft, InsertBecomeOvercommittedTrim) {
   TileCacheLRU cache(2000, TileCacheLRU::MemoryLimitControl::SOFT);
 
@@ -880,6 +914,509 @@ TEST(CacheLruSoft, TrimOnExactlyFullCache) {
   CheckGraphTile(cache.Get(tile2_id), tile2_id, tile2_size);
 }
 
+TEST(ShardedCache, Basic) {
+  ShardedTileCache cache(4000, 4);
+  EXPECT_EQ(cache.ShardCount(), 4);
+
+  std::vector<GraphId> ids;
+  for (uint32_t i = 0; i < 16; ++i) {
+    ids.emplace_back(i * 7, i % 3, 0);
+    auto tile = cache.Put(ids.back(), graph_tile_ptr{new TestGraphTile(ids.back(), 100)}, 100);
+    CheckGraphTile(tile, ids.back(), 100);
+  }
+  for (const auto& id : ids) {
+    EXPECT_TRUE(cache.Contains(id));
+    CheckGraphTile(cache.Get(id), id, 100);
+  }
+  EXPECT_FALSE(cache.Contains(GraphId(1000, 2, 0)));
+  EXPECT_EQ(cache.Get(GraphId(1000, 2, 0)), nullptr);
+
+  // copies share the shards
+  ShardedTileCache copy(cache);
+  CheckGraphTile(copy.Get(ids.front()), ids.front(), 100);
+  copy.Clear();
+  for (const auto& id : ids) {
+    EXPECT_FALSE(cache.Contains(id));
+  }
+}
+
+TEST(ShardedCache, OverCommittedShardsTrim) {
+  // any over committed shard makes the whole cache over committed
+  ShardedTileCache cache(400, 2);
+  EXPECT_FALSE(cache.OverCommitted());
+  GraphId id(1, 2, 0);
+  cache.Put(id, graph_tile_ptr{new TestGraphTile(id, 300)}, 300);
+  EXPECT_TRUE(cache.OverCommitted());
+  cache.Trim();
+  EXPECT_FALSE(cache.OverCommitted());
+  EXPECT_FALSE(cache.Contains(id));
+}
+
+TEST(ShardedCache, ConcurrentAccess) {
+  ShardedTileCache cache(1000000, 8, true, TileCacheLRU::MemoryLimitControl::HARD);
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&cache, t]() {
+      // each thread has its own tiles so the ref counts are never shared
+      for (uint32_t i = 0; i < 1000; ++i) {
+        GraphId id(t * 1000 + i % 100, 2, 0);
+        if (!cache.Contains(id))
+          cache.Put(id, graph_tile_ptr{new TestGraphTile(id, 10)}, 10);
+        EXPECT_NE(cache.Get(id), nullptr);
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  for (uint32_t t = 0; t < 4; ++t)
+    for (uint32_t i = 0; i < 100; ++i)
+      CheckGraphTile(cache.Get(GraphId(t * 1000 + i, 2, 0)), GraphId(t * 1000 + i, 2, 0), 10);
+}
+
+TEST(TieredCache, LocalTilesDontEvictPinnedLevels) {
+  // levels 0 and 1 are pinned with room for two tiles, the rest holds two tiles
+  TieredTileCache cache(std::make_unique<TileCacheLRU>(200, TileCacheLRU::MemoryLimitControl::HARD),
+                        {0, 1}, 200, false);
+  GraphId highway(1, 0, 0), arterial(2, 1, 0);
+  cache.Put(highway, graph_tile_ptr{new TestGraphTile(highway, 100)}, 100);
+  cache.Put(arterial, graph_tile_ptr{new TestGraphTile(arterial, 100)}, 100);
+  EXPECT_EQ(cache.PinnedSize(), 200);
+
+  // lots of local tiles only ever evict each other
+  for (uint32_t i = 0; i < 10; ++i) {
+    GraphId local(i, 2, 0);
+    cache.Put(local, graph_tile_ptr{new TestGraphTile(local, 100)}, 100);
+    EXPECT_FALSE(cache.OverCommitted());
+  }
+  CheckGraphTile(cache.Get(highway), highway, 100);
+  CheckGraphTile(cache.Get(arterial), arterial, 100);
+  EXPECT_TRUE(cache.Contains(GraphId(9, 2, 0)));
+  EXPECT_FALSE(cache.Contains(GraphId(0, 2, 0)));
+  EXPECT_EQ(cache.Evictions(), 8);
+
+  // a full pinned tier sends the tiles of its levels to the rest
+  GraphId another(3, 0, 0);
+  cache.Put(another, graph_tile_ptr{new TestGraphTile(another, 100)}, 100);
+  EXPECT_EQ(cache.PinnedSize(), 200);
+  CheckGraphTile(cache.Get(another), another, 100);
+
+  // trimming leaves the pinned tiles alone, clearing doesnt
+  cache.Trim();
+  EXPECT_TRUE(cache.Contains(highway));
+  cache.Clear();
+  EXPECT_FALSE(cache.Contains(highway));
+  EXPECT_FALSE(cache.Contains(another));
+  EXPECT_EQ(cache.PinnedSize(), 0);
+}
+
+TEST(TieredCache, CopiesSharePinnedTier) {
+  TieredTileCache cache(std::make_unique<SimpleTileCache>(1000), {0}, 1000, true);
+  TieredTileCache copy(cache, std::make_unique<SimpleTileCache>(1000));
+  GraphId highway(1, 0, 0), local(1, 2, 0);
+  cache.Put(highway, graph_tile_ptr{new TestGraphTile(highway, 100)}, 100);
+  cache.Put(local, graph_tile_ptr{new TestGraphTile(local, 100)}, 100);
+  CheckGraphTile(copy.Get(highway), highway, 100);
+  EXPECT_FALSE(copy.Contains(local));
+}
+
+TEST(TieredCache, Factory) {
+  boost::property_tree::ptree pt;
+  pt.put("use_lru_mem_cache", true);
+  pt.put("max_cache_size", 1000);
+  boost::property_tree::ptree levels, level;
+  level.put_value(0);
+  levels.push_back({"", level});
+  pt.add_child("pinned_cache_levels", levels);
+  pt.put("pinned_cache_size", 500);
+  std::unique_ptr<TileCache> cache(TileCacheFactory::createTileCache(pt));
+  auto* tiered = dynamic_cast<TieredTileCache*>(cache.get());
+  ASSERT_NE(tiered, nullptr);
+  GraphId highway(1, 0, 0);
+  tiered->Put(highway, graph_tile_ptr{new TestGraphTile(highway, 100)}, 100);
+  EXPECT_EQ(tiered->PinnedSize(), 100);
+
+  // without pinned levels its the cache it always was
+  pt.erase("pinned_cache_levels");
+  cache.reset(TileCacheFactory::createTileCache(pt));
+  EXPECT_NE(dynamic_cast<TileCacheLRU*>(cache.get()), nullptr);
+}
+
+struct TestTileExtract : public GraphReader {
+  using GraphReader::tile_extract_t;
+};
+using index_entry_t = TestTileExtract::tile_extract_t::index_entry_t;
+
+// writes a tar whose first member is an index followed by the tiles the index points to
+void write_indexed_extract(const std::string& tar_file,
+                           const std::vector<std::pair<GraphId, std::string>>& tiles,
+                           uint64_t offset_adjustment = 0,
+                           size_t appended_members = 0) {
+  mtar_t tar;
+  ASSERT_EQ(mtar_open(&tar, tar_file.c_str(), "w"), MTAR_ESUCCESS);
+
+  // every member is a header block followed by its data rounded up to whole blocks
+  auto blocks = [](size_t size) { return (size + 511) / 512 * 512; };
+  std::vector<index_entry_t> index;
+  uint64_t offset = 512 + blocks(sizeof(index_entry_t) * tiles.size());
+  for (const auto& tile : tiles) {
+    index.push_back({offset + 512 + offset_adjustment, static_cast<uint32_t>(tile.first.value),
+                     static_cast<uint32_t>(tile.second.size())});
+    offset += 512 + blocks(tile.second.size());
+  }
+  const auto index_size = static_cast<unsigned>(sizeof(index_entry_t) * index.size());
+  mtar_write_file_header(&tar, TestTileExtract::tile_extract_t::kIndexFileName, index_size);
+  mtar_write_data(&tar, index.data(), index_size);
+
+  // the names are not tile paths so the only way to find them is through the index
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    const auto name = "not_a_tile_" + std::to_string(i);
+    mtar_write_file_header(&tar, name.c_str(), tiles[i].second.size());
+    mtar_write_data(&tar, tiles[i].second.data(), tiles[i].second.size());
+  }
+
+  // stuff that was added to the archive after the index was made
+  for (size_t i = 0; i < appended_members; ++i) {
+    const auto name = "appended_" + std::to_string(i);
+    mtar_write_file_header(&tar, name.c_str(), name.size());
+    mtar_write_data(&tar, name.data(), name.size());
+  }
+  mtar_finalize(&tar);
+  mtar_close(&tar);
+}
+
+TEST(TileExtract, IndexMember) {
+  const std::string tar_file = "test/data/indexed_extract.tar";
+  filesystem::create_directories("test/data");
+  GraphId tile_a(818660, 2, 0), tile_b(3196, 0, 0), tile_c(50000, 1, 0);
+  write_indexed_extract(tar_file, {{tile_b, "tile b"}, {tile_c, "the c tile"}, {tile_a, "a"}});
+
+  boost::property_tree::ptree pt;
+  pt.put("tile_extract", tar_file);
+  TestTileExtract::tile_extract_t extract(pt);
+  ASSERT_EQ(extract.tiles.size(), 3);
+
+  for (const auto& expected : std::vector<std::pair<GraphId, std::string>>{{tile_a, "a"},
+                                                                            {tile_b, "tile b"},
+                                                                            {tile_c, "the c tile"}}) {
+    const auto* location = extract.tiles.find(expected.first);
+    ASSERT_NE(location, nullptr);
+    EXPECT_EQ(std::string(location->first, location->second), expected.second);
+  }
+  EXPECT_EQ(extract.tiles.find(GraphId(1, 2, 0)), nullptr);
+
+  // with a usable index nothing but the index is read from the archive
+  EXPECT_EQ(extract.archive->contents.size(), 1);
+
+  // the index is kept sorted
+  EXPECT_TRUE(std::is_sorted(extract.tiles.begin(), extract.tiles.end(),
+                             [](const auto& a, const auto& b) { return a.first < b.first; }));
+}
+
+TEST(TileExtract, StaleIndexMember) {
+  const std::string tar_file = "test/data/stale_indexed_extract.tar";
+  filesystem::create_directories("test/data");
+  // an index that points past the end of the archive cant be trusted
+  write_indexed_extract(tar_file, {{GraphId(3196, 0, 0), "tile"}}, 1 << 20);
+
+  boost::property_tree::ptree pt;
+  pt.put("tile_extract", tar_file);
+  TestTileExtract::tile_extract_t extract(pt);
+  // so we fall back to file names, none of which are tiles
+  EXPECT_TRUE(extract.tiles.empty());
+  EXPECT_EQ(extract.archive->contents.size(), 2);
+}
+
+TEST(TileExtract, AppendedToIndexedArchive) {
+  const std::string tar_file = "test/data/appended_indexed_extract.tar";
+  filesystem::create_directories("test/data");
+  // the index doesnt know about anything added to the archive after it was written, even a single
+  // small member that takes less room than the padding at the end of an archive
+  for (size_t appended : {1, 30}) {
+    write_indexed_extract(tar_file, {{GraphId(3196, 0, 0), "tile"}}, 0, appended);
+
+    boost::property_tree::ptree pt;
+    pt.put("tile_extract", tar_file);
+    TestTileExtract::tile_extract_t extract(pt);
+    // so the whole archive has to be looked at
+    EXPECT_TRUE(extract.tiles.empty()) << appended;
+    EXPECT_EQ(extract.archive->contents.size(), appended + 2);
+  }
+}
+
+TEST(SharedTileDir, PublishAndMap) {
+  const std::string tile_dir = "test/data/shared_tile_dir_src";
+  const std::string shared_dir = "test/data/shared_tile_dir";
+  filesystem::remove_all(tile_dir);
+  filesystem::remove_all(shared_dir);
+  GraphId tile_id(3196, 0, 0);
+  valhalla::mjolnir::GraphTileBuilder(tile_dir, tile_id, false).StoreTileData();
+
+  boost::property_tree::ptree pt;
+  pt.put("tile_dir", tile_dir);
+  pt.put("shared_tile_dir", shared_dir);
+  const auto shared_file =
+      shared_dir + filesystem::path::preferred_separator + GraphTile::FileSuffix(tile_id);
+
+  // the first reader to load the tile publishes it
+  {
+    auto reader = test::make_clean_graphreader(pt);
+    auto tile = reader->GetGraphTile(tile_id);
+    ASSERT_NE(tile, nullptr);
+    EXPECT_EQ(tile->id(), tile_id);
+    EXPECT_TRUE(filesystem::exists(shared_file));
+  }
+
+  // so any other reader can map it even when its gone from the tile dir
+  filesystem::remove_all(tile_dir);
+  auto reader = test::make_clean_graphreader(pt);
+  auto tile = reader->GetGraphTile(tile_id);
+  ASSERT_NE(tile, nullptr);
+  EXPECT_EQ(tile->id(), tile_id);
+  EXPECT_EQ(reader->GetGraphTile(GraphId(3197, 0, 0)), nullptr);
+}
+
+TEST(Prefetch, LoadsInBackground) {
+  const std::string tile_dir = "test/data/prefetch_tile_dir";
+  filesystem::remove_all(tile_dir);
+  GraphId tile_a(3196, 0, 0), tile_b(3197, 0, 0), missing(3198, 0, 0);
+  valhalla::mjolnir::GraphTileBuilder(tile_dir, tile_a, false).StoreTileData();
+  valhalla::mjolnir::GraphTileBuilder(tile_dir, tile_b, false).StoreTileData();
+
+  boost::property_tree::ptree pt;
+  pt.put("tile_dir", tile_dir);
+  pt.put("tile_prefetch_threads", 2);
+  auto reader = test::make_clean_graphreader(pt);
+  reader->Prefetch(std::vector<GraphId>{tile_a, tile_b, missing, tile_a});
+
+  // whether they are finished or not the tiles we get back are the ones we asked for
+  for (const auto& id : {tile_b, tile_a}) {
+    auto tile = reader->GetGraphTile(id);
+    ASSERT_NE(tile, nullptr);
+    EXPECT_EQ(tile->id(), id);
+  }
+  EXPECT_EQ(reader->GetGraphTile(missing), nullptr);
+
+  // prefetching what is already cached is a no-op and tearing down with requests in flight is ok
+  reader->Prefetch(tile_a);
+  reader->Prefetch(GraphId(4000, 0, 0));
+}
+
+TEST(TileUsage, WarmFromUsage) {
+  const std::string tile_dir = "test/data/tile_usage_dir";
+  const std::string usage_file = "test/data/tile_usage.txt";
+  filesystem::remove_all(tile_dir);
+  filesystem::remove(usage_file);
+  GraphId tile_a(3196, 0, 0), tile_b(3197, 0, 0), missing(3198, 0, 0);
+  valhalla::mjolnir::GraphTileBuilder(tile_dir, tile_a, false).StoreTileData();
+  valhalla::mjolnir::GraphTileBuilder(tile_dir, tile_b, false).StoreTileData();
+
+  boost::property_tree::ptree pt;
+  pt.put("tile_dir", tile_dir);
+  pt.put("tile_usage_file", usage_file);
+  // two readers count until they are torn down and their counts add up
+  for (int i = 0; i < 2; ++i) {
+    auto reader = test::make_clean_graphreader(pt);
+    reader->GetGraphTile(tile_b);
+    reader->GetGraphTile(GraphId(tile_a.tileid(), 0, 5));
+    reader->GetGraphTile(tile_a);
+  }
+  EXPECT_EQ(GraphReader::ReadTileUsage(usage_file), (std::vector<GraphId>{tile_a, tile_b}));
+  EXPECT_TRUE(GraphReader::ReadTileUsage("test/data/no_such_usage").empty());
+
+  // once warmed the tiles come from the cache even if they are gone from disk
+  pt.erase("tile_usage_file");
+  auto reader = test::make_clean_graphreader(pt);
+  EXPECT_EQ(reader->Warm({tile_a, missing, tile_b}, 2), 2u);
+  filesystem::remove_all(tile_dir);
+  for (const auto& id : {tile_a, tile_b}) {
+    auto tile = reader->GetGraphTile(id);
+    ASSERT_NE(tile, nullptr);
+    EXPECT_EQ(tile->id(), id);
+  }
+}
+
+TEST(TileUsage, WarmIsNotUsage) {
+  const std::string tar_file = "test/data/tile_usage_extract.tar";
+  const std::string usage_file = "test/data/tile_usage_warm.txt";
+  filesystem::create_directories("test/data");
+  filesystem::remove(usage_file);
+  GraphId tile_id(3196, 0, 0);
+  write_indexed_extract(tar_file, {{tile_id, "tile"}});
+
+  // warming the cache from the extract doesnt count the tiles as asked for
+  boost::property_tree::ptree pt;
+  pt.put("tile_extract", tar_file);
+  pt.put("tile_usage_file", usage_file);
+  {
+    auto reader = test::make_clean_graphreader(pt);
+    reader->Warm({tile_id}, 1);
+  }
+  EXPECT_TRUE(GraphReader::ReadTileUsage(usage_file).empty());
+
+  // while asking for them does
+  {
+    auto reader = test::make_clean_graphreader(pt);
+    reader->GetGraphTile(tile_id);
+  }
+  EXPECT_EQ(GraphReader::ReadTileUsage(usage_file), std::vector<GraphId>{tile_id});
+}
+
+TEST(TileStats, CountsSources) {
+  const std::string tile_dir = "test/data/tile_stats_dir";
+  filesystem::remove_all(tile_dir);
+  GraphId tile_id(3196, 0, 0), missing(3198, 0, 0);
+  valhalla::mjolnir::GraphTileBuilder(tile_dir, tile_id, false).StoreTileData();
+
+  boost::property_tree::ptree pt;
+  pt.put("tile_dir", tile_dir);
+  auto reader = test::make_clean_graphreader(pt);
+  ASSERT_NE(reader->GetGraphTile(tile_id), nullptr);
+  ASSERT_NE(reader->GetGraphTile(GraphId(tile_id.tileid(), 0, 3)), nullptr);
+  EXPECT_EQ(reader->GetGraphTile(missing), nullptr);
+
+  const auto& stats = reader->GetTileStats();
+  EXPECT_EQ(stats.tiles[tile_stats_t::kDisk].load(), 1u);
+  EXPECT_EQ(stats.tiles[tile_stats_t::kCache].load(), 1u);
+  EXPECT_EQ(stats.tiles[tile_stats_t::kNotFound].load(), 1u);
+  EXPECT_EQ(stats.tiles[tile_stats_t::kUrl].load(), 0u);
+  EXPECT_GT(stats.bytes_loaded.load(), 0u);
+  uint64_t loads = 0;
+  for (const auto& bin : stats.load_latency)
+    loads += bin;
+  EXPECT_EQ(loads, 1u);
+
+  // dropping the cache counts as evicting everything in it
+  EXPECT_EQ(reader->CacheEvictions(), 0u);
+  reader->Clear();
+  EXPECT_EQ(reader->CacheEvictions(), 1u);
+  ASSERT_NE(reader->GetGraphTile(tile_id), nullptr);
+  EXPECT_EQ(stats.tiles[tile_stats_t::kDisk].load(), 2u);
+}
+
+TEST(TileStats, PerThreadWhenThreadSafe) {
+  const std::string tile_dir = "test/data/tile_stats_thread_safe_dir";
+  filesystem::remove_all(tile_dir);
+  GraphId tile_id(3196, 0, 0), missing(3198, 0, 0);
+  valhalla::mjolnir::GraphTileBuilder(tile_dir, tile_id, false).StoreTileData();
+
+  // prefetching is left to readers with only one thread
+  boost::property_tree::ptree pt;
+  pt.put("tile_dir", tile_dir);
+  pt.put("thread_safe_reader", true);
+  pt.put("tile_prefetch_threads", 2);
+  auto reader = test::make_clean_graphreader(pt);
+  ASSERT_TRUE(reader->ThreadSafe());
+  reader->Prefetch(missing);
+  auto tile = reader->GetGraphTile(tile_id);
+  ASSERT_NE(tile, nullptr);
+
+  // another thread gets the same tile from the cache and counts that on its own
+  std::thread([&]() {
+    EXPECT_EQ(reader->GetGraphTile(tile_id), tile);
+    EXPECT_EQ(reader->GetGraphTile(missing), nullptr);
+    const auto& stats = reader->GetTileStats();
+    EXPECT_EQ(stats.tiles[tile_stats_t::kCache].load(), 1u);
+    EXPECT_EQ(stats.tiles[tile_stats_t::kNotFound].load(), 1u);
+    EXPECT_EQ(stats.tiles[tile_stats_t::kDisk].load(), 0u);
+  }).join();
+
+  const auto& stats = reader->GetTileStats();
+  EXPECT_EQ(stats.tiles[tile_stats_t::kDisk].load(), 1u);
+  EXPECT_EQ(stats.tiles[tile_stats_t::kCache].load(), 0u);
+  EXPECT_EQ(stats.tiles[tile_stats_t::kNotFound].load(), 0u);
+}
+
+// Serves the tiles of a directory as if they came from a slow server and counts the requests
+struct counting_tile_getter_t : public tile_getter_t {
+  counting_tile_getter_t(const std::string& tile_dir, std::atomic<size_t>& requests)
+      : tile_dir(tile_dir), requests(requests) {
+  }
+  response_t get(const std::string& url) override {
+    ++requests;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    response_t response;
+    std::ifstream file(tile_dir + url.substr(url.find('/')), std::ios::binary);
+    if (file) {
+      response.bytes_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+      response.status_ = status_code_t::SUCCESS;
+    }
+    return response;
+  }
+  std::string tile_dir;
+  std::atomic<size_t>& requests;
+};
+
+TEST(TileUrl, ConcurrentMissesFetchOnce) {
+  const std::string tile_dir = "test/data/tile_url_coalesce_dir";
+  filesystem::remove_all(tile_dir);
+  GraphId tile_id(3196, 0, 0);
+  valhalla::mjolnir::GraphTileBuilder(tile_dir, tile_id, false).StoreTileData();
+
+  // readers of their own all miss the same tile at once
+  boost::property_tree::ptree pt;
+  pt.put("tile_url", std::string("coalesce/") + GraphTile::kTilePathPattern);
+  std::atomic<size_t> requests(0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&]() {
+      GraphReader reader(pt, std::make_unique<counting_tile_getter_t>(tile_dir, requests));
+      auto tile = reader.GetGraphTile(tile_id);
+      ASSERT_NE(tile, nullptr);
+      EXPECT_EQ(tile->id(), tile_id);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(requests.load(), 1u);
+
+  // once its fetched the next miss asks for it again
+  GraphReader reader(pt, std::make_unique<counting_tile_getter_t>(tile_dir, requests));
+  ASSERT_NE(reader.GetGraphTile(tile_id), nullptr);
+  EXPECT_EQ(requests.load(), 2u);
+}
+
+TEST(TileUrl, NotFoundExpires) {
+  const std::string tile_dir = "test/data/tile_url_not_found_dir";
+  filesystem::remove_all(tile_dir);
+  GraphId missing(3198, 0, 0);
+
+  // without a ttl its never asked for again
+  boost::property_tree::ptree pt;
+  pt.put("tile_url", std::string("not_found/") + GraphTile::kTilePathPattern);
+  std::atomic<size_t> requests(0);
+  {
+    GraphReader reader(pt, std::make_unique<counting_tile_getter_t>(tile_dir, requests));
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ(reader.GetGraphTile(missing), nullptr);
+    }
+    EXPECT_EQ(requests.load(), 1u);
+  }
+
+  // with one its asked for again once the ttl is up and found if its there by then
+  pt.put("tile_url_not_found_ttl", 1);
+  GraphReader reader(pt, std::make_unique<counting_tile_getter_t>(tile_dir, requests));
+  EXPECT_EQ(reader.GetGraphTile(missing), nullptr);
+  EXPECT_EQ(reader.GetGraphTile(missing), nullptr);
+  EXPECT_EQ(requests.load(), 2u);
+  valhalla::mjolnir::GraphTileBuilder(tile_dir, missing, false).StoreTileData();
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  auto tile = reader.GetGraphTile(missing);
+  ASSERT_NE(tile, nullptr);
+  EXPECT_EQ(tile->id(), missing);
+  EXPECT_EQ(requests.load(), 3u);
+}
+
+TEST(CacheLruHard, EvictionsCounted) {
+  TileCacheLRU cache(3, TileCacheLRU::MemoryLimitControl::HARD);
+  for (uint32_t i = 0; i < 5; ++i) {
+    cache.Put(GraphId(i, 0, 0), nullptr, 1);
+  }
+  EXPECT_EQ(cache.Evictions(), 2u);
+  cache.Clear();
+  EXPECT_EQ(cache.Evictions(), 5u);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -120,6 +120,10 @@ TEST(GraphTileBuilder, TestDuplicateEdgeInfo) {
 
   test.StoreTileData();
   test_graph_tile_builder test2(test_dir, GraphId(0, 2, 0), false);
+  // the whole tile is written out in one go, the header in front and nothing past its end
+  std::ifstream file(test_dir + "/" + GraphTile::FileSuffix(GraphId(0, 2, 0)),
+                     std::ios::binary | std::ios::ate);
+  EXPECT_EQ(static_cast<uint32_t>(file.tellg()), test2.header()->end_offset());
   auto ei = test2.edgeinfo(&test2.directededge(0));
   EXPECT_NEAR(ei.mean_elevation(), 555.0f, kElevationBinSize);
   EXPECT_EQ(ei.speed_limit(), 120);
@@ -168,6 +172,67 @@ TEST(GraphTileBuilder, TestDuplicateEdgeInfo) {
   }
 }
 
+TEST(GraphTileBuilder, TestSetElevation) {
+  // a tile of three edges with their own edge infos
+  std::string test_dir = "test/data/builder_tiles_elevation";
+  GraphId tile_id(0, 2, 0);
+  std::vector<std::vector<PointLL>> shapes{{{0, 0}, {0.001, 0.001}, {0.002, 0.001}},
+                                           {{0.002, 0.001}, {0.003, 0.002}},
+                                           {{0.003, 0.002}, {0.004, 0.002}, {0.005, 0.003}}};
+  {
+    test_graph_tile_builder builder(test_dir, tile_id, false);
+    for (uint32_t i = 0; i < shapes.size(); ++i) {
+      bool added = false;
+      auto offset = builder.AddEdgeInfo(i, GraphId(0, 2, i), GraphId(0, 2, i + 1), 1234 + i, 555,
+                                        0, 120, shapes[i], {"weg " + std::to_string(i)}, {}, 0,
+                                        added);
+      builder.directededges().emplace_back();
+      builder.directededges().back().set_edgeinfo_offset(offset);
+    }
+    builder.StoreTileData();
+  }
+
+  // give the first two elevation, which moves the edge infos after them
+  std::vector<std::vector<double>> elevations{{100, 101.5, 99.2}, {99.2, 120.04}};
+  {
+    test_graph_tile_builder builder(test_dir, tile_id, true);
+    for (uint32_t i = 0; i < elevations.size(); ++i) {
+      builder.set_elevation(builder.directededge(i).edgeinfo_offset(), elevations[i]);
+    }
+    builder.StoreTileData();
+  }
+
+  test_graph_tile_builder tile(test_dir, tile_id, false);
+  for (uint32_t i = 0; i < shapes.size(); ++i) {
+    auto ei = tile.edgeinfo(&tile.directededge(i));
+    EXPECT_EQ(ei.wayid(), 1234 + i);
+    ASSERT_EQ(ei.GetNames().size(), 1);
+    EXPECT_EQ(ei.GetNames().front(), "weg " + std::to_string(i));
+    ASSERT_EQ(ei.shape().size(), shapes[i].size());
+    auto elevation = ei.elevation();
+    if (i < elevations.size()) {
+      EXPECT_TRUE(ei.has_elevation());
+      ASSERT_EQ(elevation.size(), elevations[i].size());
+      for (size_t j = 0; j < elevation.size(); ++j) {
+        EXPECT_NEAR(elevation[j], elevations[i][j], kShapeElevationPrecision / 2 + 1e-3);
+      }
+    } else {
+      EXPECT_FALSE(ei.has_elevation());
+      EXPECT_TRUE(elevation.empty());
+    }
+  }
+
+  // and it survives the tile being deserialized and stored again
+  {
+    test_graph_tile_builder builder(test_dir, tile_id, true);
+    builder.StoreTileData();
+  }
+  test_graph_tile_builder again(test_dir, tile_id, false);
+  EXPECT_EQ(again.edgeinfo(&again.directededge(1)).encoded_elevation(),
+            tile.edgeinfo(&tile.directededge(1)).encoded_elevation());
+  EXPECT_EQ(again.edgeinfo(&again.directededge(2)).GetNames().front(), "weg 2");
+}
+
 TEST(GraphTileBuilder, TestAddBins) {
 
   // if you update the tile format you must regenerate test tiles. after your tile format change,
@@ -245,6 +310,59 @@ TEST(GraphTileBuilder, TestAddBins) {
   }
 }
 
+TEST(GraphTileBuilder, TestAddBinCells) {
+  GraphId id(744881, 2, 0);
+  auto t = GraphTile::Create(VALHALLA_SOURCE_DIR "test/data/bin_tiles/no_bin", id);
+  ASSERT_TRUE(t && t->header()) << "Couldn't load test tile";
+  ASSERT_GT(t->header()->directededgecount(), 0);
+  for (size_t i = 0; i < kBinCount; ++i)
+    EXPECT_EQ(t->GetBinCellDepth(i), 0) << "Tiles without cells have none";
+
+  // fill the bin of the start of an edge of the tile and another bin with an edge of another tile
+  auto shape = t->edgeinfo(t->directededge(0)).shape();
+  size_t dense = 0;
+  while (!t->BinBoundingBox(dense).Contains(shape.front()))
+    ++dense;
+  auto other = (dense + 1) % kBinCount;
+  std::array<std::vector<GraphId>, kBinCount> bins;
+  bins[dense].assign(kBinCellThreshold + 1, GraphId(744881, 2, 0));
+  bins[other].assign(kBinCellThreshold * 16, GraphId(744885, 2, 0));
+  std::string bin_dir = "test/data/bin_tiles/bin_cells";
+  GraphTileBuilder::AddBins(bin_dir, t, bins);
+
+  // the bins are split as deep as they need
+  auto b = GraphTile::Create(bin_dir, id);
+  EXPECT_EQ(b->GetBinCellDepth(dense), 1);
+  EXPECT_EQ(b->GetBinCellDepth(other), 2);
+  for (size_t i = 0; i < kBinCount; ++i) {
+    if (i != dense && i != other)
+      EXPECT_EQ(b->GetBinCellDepth(i), 0);
+  }
+  auto count = bins[dense].size() + bins[other].size();
+  auto cell_count = b->GetBin(dense).size() + b->GetBin(other).size();
+  auto increase = count * sizeof(GraphId) + kBinCellDepthsSize + cell_count * sizeof(uint64_t);
+  assert_tile_equalish(*t, *b, increase, bins, "Adding cells broke the tile");
+
+  // an edge is in the cells it touches and the edges of other tiles in all of them
+  ASSERT_EQ(b->GetBinCells(dense).size(), b->GetBin(dense).size());
+  ASSERT_EQ(b->GetBinCells(other).size(), b->GetBin(other).size());
+  auto start = GraphTile::BinCellMask(b->BinBoundingBox(dense), 1, {shape.front(), shape.front()});
+  for (auto cells : b->GetBinCells(dense)) {
+    EXPECT_EQ(cells & ~uint64_t(0xf), 0);
+    EXPECT_TRUE(cells & start);
+  }
+  for (auto cells : b->GetBinCells(other))
+    EXPECT_EQ(cells, 0xffff);
+
+  // the cells are redone rather than appended to when the bins are added to again
+  GraphTileBuilder::AddBins(bin_dir, b, {});
+  auto c = GraphTile::Create(bin_dir, id);
+  EXPECT_EQ(c->header()->end_offset(), b->header()->end_offset());
+  EXPECT_EQ(c->header()->bin_cells_offset(), b->header()->bin_cells_offset());
+  EXPECT_EQ(c->GetBinCellDepth(other), 2);
+  assert_tile_equalish(*t, *c, increase, bins, "Adding no bins broke the cells");
+}
+
 struct fake_tile : public GraphTile {
 public:
   fake_tile(const std::string& plyenc_shape) {
@@ -1,5 +1,8 @@
 // -*- mode: c++ -*-
 
+#include <algorithm>
+#include <vector>
+
 #include "midgard/linesegment2.h"
 #include "midgard/pointll.h"
 
@@ -68,6 +71,53 @@ TEST(GridRangeQuery, TestQuery) {
   EXPECT_NE(items.find(0), items.end()) << "query should get item 0";
 }
 
+TEST(GridRangeQuery, TestPackedQuery) {
+  const BoundingBox bbox(0, 0, 100, 100);
+  meili::GridRangeQuery<int, midgard::PointLL> grid(bbox, 1.f, 1.f);
+  grid.AddLineSegment(0, LineSegment({2.5, 3.5}, {10, 3.5}));
+  grid.AddLineSegment(1, LineSegment({-10, -10}, {110, 110}));
+  grid.AddLineSegment(2, LineSegment({50.5, 0.5}, {50.5, 99.5}));
+  grid.AddLineSegment(3, LineSegment({99.5, 0.5}, {0.5, 60.5}));
+
+  const meili::PackedGridRangeQuery<int, midgard::PointLL> packed(grid);
+  EXPECT_EQ(packed.ncols(), grid.ncols());
+  EXPECT_EQ(packed.nrows(), grid.nrows());
+  for (const auto& range : {BoundingBox(2, 2, 5, 5), BoundingBox(10, 10, 20, 20),
+                            BoundingBox(2, 3, 2.5, 3.5), BoundingBox(45, 20, 55, 80),
+                            BoundingBox(-20, -20, 120, 120), BoundingBox(70, 90, 80, 95)}) {
+    EXPECT_EQ(packed.Query(range), grid.Query(range))
+        << range.minx() << "," << range.miny() << "," << range.maxx() << "," << range.maxy();
+  }
+}
+
+TEST(GridRangeQuery, TestVisit) {
+  const BoundingBox bbox(0, 0, 100, 100);
+  meili::GridRangeQuery<int, midgard::PointLL> grid(bbox, 1.f, 1.f);
+  grid.AddLineSegment(0, LineSegment({2.5, 3.5}, {10, 3.5}));
+  grid.AddLineSegment(1, LineSegment({-10, -10}, {110, 110}));
+  grid.AddLineSegment(2, LineSegment({50.5, 0.5}, {50.5, 99.5}));
+  const meili::PackedGridRangeQuery<int, midgard::PointLL> packed(grid);
+
+  // the visits are once per square so an item can come up more than once
+  std::vector<int> visited;
+  grid.Visit(BoundingBox(2, 2, 5, 5), [&visited](int item) { visited.push_back(item); });
+  EXPECT_GT(std::count(visited.cbegin(), visited.cend(), 0), 1);
+  EXPECT_EQ(std::count(visited.cbegin(), visited.cend(), 2), 0);
+  EXPECT_GT(std::count(visited.cbegin(), visited.cend(), 1), 1);
+
+  for (const auto& range : {BoundingBox(2, 2, 5, 5), BoundingBox(10, 10, 20, 20),
+                            BoundingBox(45, 20, 55, 80), BoundingBox(-20, -20, 120, 120)}) {
+    std::vector<int> unpacked, packed_items;
+    grid.Visit(range, [&unpacked](int item) { unpacked.push_back(item); });
+    packed.Visit(range, [&packed_items](int item) { packed_items.push_back(item); });
+    std::sort(unpacked.begin(), unpacked.end());
+    std::sort(packed_items.begin(), packed_items.end());
+    EXPECT_EQ(unpacked, packed_items);
+    const auto items = grid.Query(range);
+    EXPECT_EQ(std::unordered_set<int>(unpacked.cbegin(), unpacked.cend()), items);
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -78,6 +78,80 @@ TEST(GriddedData, Basic) {
   */
 }
 
+TEST(GriddedData, Threads) {
+  // a few overlapping blobs so that the contours cross the bands of rows in many places
+  GriddedData<1> g({-7, -7, 7, 7}, 0.1f, {std::numeric_limits<float>::max()});
+  const std::vector<PointLL> centers{{-3, -2}, {2, 3}, {1, -4}, {-4, 4}};
+  for (int tile_id = 0; tile_id < g.nrows() * g.ncolumns(); ++tile_id) {
+    auto b = g.Base(tile_id);
+    for (const auto& center : centers) {
+      g.SetIfLessThan(tile_id, {center.Distance(b)});
+    }
+  }
+
+  for (bool rings_only : {true, false}) {
+    std::vector<GriddedData<1>::contour_interval_t> iso_markers{
+        {0, 100000, "dist", ""}, {0, 250000, "dist", ""}, {0, 400000, "dist", ""}};
+    auto serial = g.GenerateContours(iso_markers, rings_only, 0.f, 0.f);
+    auto threaded = g.GenerateContours(iso_markers, rings_only, 0.f, 0.f, 4);
+
+    // the bands are joined back into the same lines, only the rings may start somewhere else
+    ASSERT_EQ(serial.size(), threaded.size());
+    for (size_t i = 0; i < serial.size(); ++i) {
+      ASSERT_EQ(serial[i].size(), threaded[i].size()) << "contour " << i;
+      auto expected = serial[i].cbegin();
+      for (const auto& feature : threaded[i]) {
+        ASSERT_EQ(feature.size(), expected->size());
+        auto expected_line = expected->cbegin();
+        for (const auto& line : feature) {
+          EXPECT_EQ(line.size(), expected_line->size());
+          EXPECT_NEAR(polygon_area(line), polygon_area(*expected_line), 1e-6);
+          ++expected_line;
+        }
+        ++expected;
+      }
+    }
+  }
+}
+
+TEST(GriddedData, Metrics) {
+  // only a corner of the grid is reached and the second metric grows the other way around
+  GriddedData<2> g({-7, -7, 7, 7}, 0.1f,
+                   {std::numeric_limits<float>::max(), std::numeric_limits<float>::max()});
+  const PointLL center(-5, -5);
+  for (int tile_id = 0; tile_id < g.nrows() * g.ncolumns(); ++tile_id) {
+    auto d = center.Distance(g.Base(tile_id));
+    if (d < 400000) {
+      g.SetIfLessThan(tile_id, {d, 400000 - d});
+    }
+  }
+
+  // tracing the contours of both metrics together gets the same lines as tracing them one by one
+  std::vector<GriddedData<2>::contour_interval_t> iso_markers{
+      {0, 100000, "dist", ""}, {1, 150000, "rest", ""}, {0, 300000, "dist", ""},
+      {1, 50000, "rest", ""},  {0, 200000, "dist", ""},
+  };
+  auto together = g.GenerateContours(iso_markers, false, 0.f, 0.f);
+  ASSERT_EQ(together.size(), iso_markers.size());
+  for (size_t i = 0; i < iso_markers.size(); ++i) {
+    std::vector<GriddedData<2>::contour_interval_t> iso_marker{iso_markers[i]};
+    auto alone = g.GenerateContours(iso_marker, false, 0.f, 0.f);
+    ASSERT_EQ(alone.size(), 1);
+    ASSERT_EQ(alone.front().size(), together[i].size()) << "contour " << i;
+    ASSERT_FALSE(together[i].front().empty()) << "contour " << i;
+    auto expected = alone.front().cbegin();
+    for (const auto& feature : together[i]) {
+      ASSERT_EQ(feature.size(), expected->size());
+      auto expected_line = expected->cbegin();
+      for (const auto& line : feature) {
+        EXPECT_EQ(line, *expected_line);
+        ++expected_line;
+      }
+      ++expected;
+    }
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
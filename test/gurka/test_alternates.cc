@@ -75,4 +75,38 @@ TEST(Alternates, test_long_route) {
   // ~40 min longer
   EXPECT_EQ(paths[2], std::vector<std::string>({"AB", "BGHC", "CD"}))
       << "Wrong second alternative route";
-}
\ No newline at end of file
+}
+TEST(Alternates, test_no_duplicates) {
+  const std::string ascii_map = R"(
+               E---------F
+               |         |
+       A-------B---------C-------D
+               |         |
+               |         |
+               G---------H
+    )";
+
+  const gurka::ways ways = {
+      {"AB", {{"highway", "primary"}, {"maxspeed", "60"}}},
+      {"BC", {{"highway", "primary"}, {"maxspeed", "60"}}},
+      {"CD", {{"highway", "primary"}, {"maxspeed", "60"}}},
+
+      {"BGHC", {{"highway", "primary"}, {"maxspeed", "60"}}},
+      {"BEFC", {{"highway", "primary"}, {"maxspeed", "60"}}},
+  };
+
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 1000);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/alternates_no_duplicates");
+
+  // many connections lie along each of the paths but every path is only formed once
+  auto result =
+      gurka::do_action(valhalla::Options::route, map, {"A", "D"}, "auto", {{"/alternates", "5"}});
+  const auto paths = gurka::detail::get_paths(result);
+
+  ASSERT_EQ(paths.size(), 3) << "Unexpected number of routes";
+  EXPECT_EQ(paths[0], std::vector<std::string>({"AB", "BC", "CD"})) << "Wrong shortest route";
+  EXPECT_EQ(paths[1], std::vector<std::string>({"AB", "BEFC", "CD"}))
+      << "Wrong first alternative route";
+  EXPECT_EQ(paths[2], std::vector<std::string>({"AB", "BGHC", "CD"}))
+      << "Wrong second alternative route";
+}
@@ -215,6 +215,62 @@ TEST_F(AvoidTest, TestAvoidShortcutsTruck) {
   ASSERT_EQ(found_shortcuts, 2);
 }
 
+TEST_F(AvoidTest, TestAvoidPolygonAroundEdge) {
+  valhalla::Options options;
+  options.set_costing(valhalla::Costing::auto_);
+  auto* co = options.add_costing_options();
+  co->set_costing(valhalla::Costing::auto_);
+
+  // a box around EF which doesn't touch its end points so only the shape is inside of it
+  auto e = avoid_map.nodes["E"];
+  auto f = avoid_map.nodes["F"];
+  auto* rings = options.mutable_exclude_polygons();
+  auto* ring = rings->Add();
+  for (const auto& coord : {vm::PointLL{e.lng() + 0.00005, e.lat() - 0.0001},
+                            vm::PointLL{e.lng() + 0.00005, e.lat() + 0.0001},
+                            vm::PointLL{f.lng() - 0.00005, f.lat() + 0.0001},
+                            vm::PointLL{f.lng() - 0.00005, f.lat() - 0.0001}}) {
+    auto* ll = ring->add_coords();
+    ll->set_lat(coord.lat());
+    ll->set_lng(coord.lng());
+  }
+
+  const auto costing = valhalla::sif::CostFactory{}.Create(*co);
+  GraphReader reader(avoid_map.config.get_child("mjolnir"));
+  auto avoid_edges = vl::edges_in_rings(*rings, reader, costing, 10000);
+  EXPECT_TRUE(std::is_sorted(avoid_edges.begin(), avoid_edges.end()));
+
+  auto ef = std::get<0>(gurka::findEdgeByNodes(reader, avoid_map.nodes, "E", "F"));
+  auto fe = std::get<0>(gurka::findEdgeByNodes(reader, avoid_map.nodes, "F", "E"));
+  EXPECT_TRUE(std::binary_search(avoid_edges.begin(), avoid_edges.end(), ef));
+  EXPECT_TRUE(std::binary_search(avoid_edges.begin(), avoid_edges.end(), fe));
+  auto de = std::get<0>(gurka::findEdgeByNodes(reader, avoid_map.nodes, "D", "E"));
+  EXPECT_FALSE(std::binary_search(avoid_edges.begin(), avoid_edges.end(), de));
+}
+
+TEST_F(AvoidTest, TestUserAvoidEdges) {
+  GraphReader reader(avoid_map.config.get_child("mjolnir"));
+  auto ef = std::get<0>(gurka::findEdgeByNodes(reader, avoid_map.nodes, "E", "F"));
+  auto fe = std::get<0>(gurka::findEdgeByNodes(reader, avoid_map.nodes, "F", "E"));
+  auto ab = std::get<0>(gurka::findEdgeByNodes(reader, avoid_map.nodes, "A", "B"));
+
+  auto costing = valhalla::sif::CostFactory{}.Create(valhalla::Costing::auto_);
+  EXPECT_FALSE(costing->IsUserAvoidEdge(ef));
+  costing->AddUserAvoidEdges({{ef, 0.5f}, {ab, 0.f}});
+  EXPECT_TRUE(costing->IsUserAvoidEdge(ef));
+  EXPECT_TRUE(costing->IsUserAvoidEdge(ab));
+  EXPECT_FALSE(costing->IsUserAvoidEdge(fe));
+  // same id in another tile or level
+  EXPECT_FALSE(costing->IsUserAvoidEdge({ef.tileid() + 1, ef.level(), ef.id()}));
+  EXPECT_FALSE(costing->IsUserAvoidEdge({ef.tileid(), ef.level(), ef.id() + 64}));
+
+  EXPECT_TRUE(costing->AvoidAsOriginEdge(ef, 0.25f));
+  EXPECT_FALSE(costing->AvoidAsOriginEdge(ef, 0.75f));
+  EXPECT_TRUE(costing->AvoidAsDestinationEdge(ef, 0.75f));
+  EXPECT_FALSE(costing->AvoidAsDestinationEdge(ef, 0.25f));
+  EXPECT_FALSE(costing->AvoidAsOriginEdge(fe, 0.f));
+}
+
 TEST_P(AvoidTest, TestAvoidLocation) {
   // avoid the location on "High road"
   std::vector<vm::PointLL> avoid_locs{avoid_map.nodes["x"]};
@@ -285,3 +285,46 @@ TEST(AdminTest, TestBuildAdminFromPBF) {
     EXPECT_EQ(X_admin.country_text(), "Japan");
   }
 }
+
+TEST(AdminTest, TestAdminIndexMatchesDb) {
+  const std::string workdir = "test/data/admin_index";
+  if (!filesystem::exists(workdir)) {
+    bool created = filesystem::create_directories(workdir);
+    EXPECT_TRUE(created);
+  }
+
+  valhalla::gurka::map admin_map = BuildPBF(workdir);
+  boost::property_tree::ptree& pt = admin_map.config;
+  pt.put("mjolnir.tile_dir", workdir + "/tiles");
+  pt.put("mjolnir.admin", workdir + "/admin.sqlite");
+  std::vector<std::string> input_files = {workdir + "/map.pbf"};
+  BuildAdminFromPBF(pt.get_child("mjolnir"), input_files);
+
+  // the index and the queries against the db should find the same admins for every node
+  sqlite3* db_handle = GetDBHandle(pt.get<std::string>("mjolnir.admin"));
+  ASSERT_NE(db_handle, nullptr);
+  AdminIndex index(db_handle);
+  EXPECT_EQ(index.size(), 6);
+
+  const auto& tiling = TileHierarchy::levels().back().tiles;
+  for (const auto& node : admin_map.nodes) {
+    auto id = TileHierarchy::GetGraphId(node.second, TileHierarchy::levels().back().level);
+    auto bounds = tiling.TileBounds(id.tileid());
+
+    GraphTileBuilder db_tile(workdir + "/tiles", id, false);
+    std::unordered_map<uint32_t, bool> db_dor, db_names;
+    auto db_polys = GetAdminInfo(db_handle, db_dor, db_names, bounds, db_tile);
+
+    GraphTileBuilder index_tile(workdir + "/tiles", id, false);
+    std::unordered_map<uint32_t, bool> index_dor, index_names;
+    auto index_polys = index.GetAdminInfo(index_dor, index_names, bounds, index_tile);
+
+    EXPECT_EQ(index_polys.size(), db_polys.size());
+    EXPECT_EQ(index_dor, db_dor);
+    EXPECT_EQ(index_names, db_names);
+    EXPECT_EQ(GetMultiPolyId(index_polys, node.second, index_tile),
+              GetMultiPolyId(db_polys, node.second, db_tile))
+        << "node " << node.first;
+  }
+  sqlite3_close(db_handle);
+}
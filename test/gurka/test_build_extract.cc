@@ -0,0 +1,83 @@
+#include "gurka.h"
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include "baldr/graphreader.h"
+#include "midgard/sequence.h"
+#include "mjolnir/extractbuilder.h"
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C
+    |    |    |
+    D----E----F
+)";
+
+const gurka::ways ways = {
+    {"ABC", {{"highway", "primary"}}},
+    {"DEF", {{"highway", "residential"}}},
+    {"AD", {{"highway", "residential"}}},
+    {"BE", {{"highway", "residential"}}},
+    {"CF", {{"highway", "residential"}}},
+};
+
+} // namespace
+
+TEST(BuildExtract, TilesAreIndexedAndPageAligned) {
+  const std::string workdir = "test/data/build_extract";
+  auto map = gurka::buildtiles(gurka::detail::map_to_coordinates(ascii_map, 100), ways, {}, {},
+                               workdir, {{"mjolnir.tile_extract", workdir + "/tiles.tar"}});
+  mjolnir::ExtractBuilder::Build(map.config);
+
+  // the index is the first member and every tile begins on a page
+  midgard::tar archive(map.config.get<std::string>("mjolnir.tile_extract"));
+  ASSERT_NE(archive.contents.find("index.bin"), archive.contents.cend());
+  EXPECT_EQ(archive.corrupt_blocks, 0);
+  size_t tile_count = 0;
+  for (const auto& member : archive.contents) {
+    if (member.first.find(".gph") != std::string::npos) {
+      EXPECT_EQ((member.second.first - archive.mm.get()) % 4096, 0) << member.first;
+      ++tile_count;
+    }
+  }
+
+  // the extract has the same tiles as the tile dir
+  auto dir_config = map.config.get_child("mjolnir");
+  dir_config.erase("tile_extract");
+  auto tar_config = map.config.get_child("mjolnir");
+  tar_config.put("tile_dir", workdir + "/does_not_exist");
+  auto dir_reader = test::make_clean_graphreader(dir_config);
+  auto tar_reader = test::make_clean_graphreader(tar_config);
+  auto tile_ids = dir_reader->GetTileSet();
+  ASSERT_FALSE(tile_ids.empty());
+  EXPECT_EQ(tile_ids.size(), tile_count);
+  for (const auto& tile_id : tile_ids) {
+    auto dir_tile = dir_reader->GetGraphTile(tile_id);
+    auto tar_tile = tar_reader->GetGraphTile(tile_id);
+    ASSERT_TRUE(dir_tile && tar_tile) << tile_id;
+    ASSERT_EQ(dir_tile->header()->end_offset(), tar_tile->header()->end_offset());
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(dir_tile->header()),
+                          dir_tile->header()->end_offset()),
+              std::string(reinterpret_cast<const char*>(tar_tile->header()),
+                          tar_tile->header()->end_offset()))
+        << tile_id;
+  }
+}
+
+TEST(BuildExtract, RemovesTilesWhenAsked) {
+  const std::string workdir = "test/data/build_extract_remove";
+  auto map = gurka::buildtiles(gurka::detail::map_to_coordinates(ascii_map, 100), ways, {}, {},
+                               workdir,
+                               {{"mjolnir.tile_extract", workdir + "/tiles.tar"},
+                                {"mjolnir.tile_extract_remove_tiles", "true"}});
+  mjolnir::ExtractBuilder::Build(map.config);
+
+  auto dir_config = map.config.get_child("mjolnir");
+  dir_config.erase("tile_extract");
+  EXPECT_TRUE(test::make_clean_graphreader(dir_config)->GetTileSet().empty());
+  auto tar_reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  EXPECT_FALSE(tar_reader->GetTileSet().empty());
+}
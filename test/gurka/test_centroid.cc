@@ -23,3 +23,39 @@ TEST(centroid, minimal) {
   ASSERT_NEAR(map.nodes["1"].lat(), api.trip().routes(0).legs(0).location(1).ll().lat(), 0.0000001);
   ASSERT_NEAR(map.nodes["1"].lng(), api.trip().routes(0).legs(0).location(1).ll().lng(), 0.0000001);
 }
+
+TEST(centroid, parallel_searches) {
+  // the short spoke is where its cheapest for everyone to meet
+  const std::string ascii_map = R"(
+    A------------X------B
+                 |
+                 C
+  )";
+  const gurka::ways ways = {
+      {"AX", {{"highway", "residential"}}},
+      {"XB", {{"highway", "residential"}}},
+      {"XC", {{"highway", "residential"}}},
+  };
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 50);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/gurka_centroid_parallel");
+  const std::vector<std::string> waypoints{"A", "B", "C"};
+  auto single = gurka::do_action(Options::centroid, map, waypoints, "pedestrian");
+
+  // a search per location on the threads meets in the same place
+  auto threaded = map;
+  threaded.config.put("thor.matrix_threads", 3);
+  auto parallel = gurka::do_action(Options::centroid, threaded, waypoints, "pedestrian");
+  const int count = waypoints.size();
+  ASSERT_EQ(single.trip().routes_size(), count);
+  ASSERT_EQ(parallel.trip().routes_size(), count);
+  const auto& centroid = single.trip().routes(0).legs(0).location(1).ll();
+  EXPECT_NEAR(centroid.lat(), (map.nodes["X"].lat() + map.nodes["C"].lat()) / 2, 0.0001);
+  EXPECT_NEAR(centroid.lng(), map.nodes["X"].lng(), 0.0001);
+  for (int i = 0; i < count; ++i) {
+    const auto& leg = parallel.trip().routes(i).legs(0);
+    const auto& single_leg = single.trip().routes(i).legs(0);
+    EXPECT_EQ(leg.location(1).ll().lat(), centroid.lat());
+    EXPECT_EQ(leg.location(1).ll().lng(), centroid.lng());
+    EXPECT_EQ(leg.shape(), single_leg.shape());
+  }
+}
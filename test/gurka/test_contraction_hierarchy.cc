@@ -0,0 +1,81 @@
+#include "gurka.h"
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C----D
+         |    |
+         E----F
+)";
+
+const gurka::ways ways = {
+    {"AB", {{"highway", "primary"}}},  {"BC", {{"highway", "primary"}}},
+    {"CD", {{"highway", "primary"}}},  {"BE", {{"highway", "residential"}}},
+    {"EF", {{"highway", "residential"}}}, {"FC", {{"highway", "residential"}}},
+};
+
+gurka::map build(const std::string& name,
+                 const gurka::relations& relations = {},
+                 const std::string& use = "true") {
+  const std::string workdir = "test/data/contraction_hierarchy_" + name;
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  return gurka::buildtiles(layout, ways, {}, relations, workdir,
+                           {{"mjolnir.concurrency", "1"},
+                            {"mjolnir.contraction_hierarchy", workdir + "/contraction.bin"},
+                            {"thor.contraction_hierarchy", use}});
+}
+
+} // namespace
+
+TEST(ContractionHierarchy, DefaultAuto) {
+  auto map = build("default");
+  auto result = gurka::do_action(valhalla::Options::route, map, {"A", "D"}, "auto");
+  gurka::assert::raw::expect_path(result, {"AB", "BC", "CD"});
+  EXPECT_EQ(result.trip().routes(0).legs(0).algorithms(0), "contraction_hierarchy");
+
+  result = gurka::do_action(valhalla::Options::route, map, {"D", "E"}, "auto");
+  gurka::assert::raw::expect_path(result, {"CD", "BC", "BE"});
+  EXPECT_EQ(result.trip().routes(0).legs(0).algorithms(0), "contraction_hierarchy");
+}
+
+TEST(ContractionHierarchy, OffByDefault) {
+  // the overlay leaves out turn costs so it is only used when it is asked for
+  auto map = build("off", {}, "false");
+  map.config.get_child("thor").erase("contraction_hierarchy");
+  auto result = gurka::do_action(valhalla::Options::route, map, {"A", "D"}, "auto");
+  gurka::assert::raw::expect_path(result, {"AB", "BC", "CD"});
+  EXPECT_EQ(result.trip().routes(0).legs(0).algorithms(0), "bidirectional_a*");
+}
+
+TEST(ContractionHierarchy, CustomCostingFallsBack) {
+  auto map = build("custom");
+  auto result = gurka::do_action(valhalla::Options::route, map, {"A", "D"}, "auto",
+                                 {{"/costing_options/auto/use_highways", "0.1"}});
+  gurka::assert::raw::expect_path(result, {"AB", "BC", "CD"});
+  EXPECT_EQ(result.trip().routes(0).legs(0).algorithms(0), "bidirectional_a*");
+
+  result = gurka::do_action(valhalla::Options::route, map, {"A", "D"}, "pedestrian");
+  EXPECT_NE(result.trip().routes(0).legs(0).algorithms(0), "contraction_hierarchy");
+}
+
+TEST(ContractionHierarchy, RestrictionFallsBack) {
+  // the overlay doesnt know about the restriction so its path has to be thrown away
+  const gurka::relations relations = {
+      {{
+           {gurka::way_member, "AB", "from"},
+           {gurka::way_member, "BC", "to"},
+           {gurka::node_member, "B", "via"},
+       },
+       {
+           {"type", "restriction"},
+           {"restriction", "no_straight_on"},
+       }},
+  };
+  auto map = build("restriction", relations);
+  auto result = gurka::do_action(valhalla::Options::route, map, {"A", "D"}, "auto");
+  gurka::assert::raw::expect_path(result, {"AB", "BE", "EF", "FC", "CD"});
+  EXPECT_EQ(result.trip().routes(0).legs(0).algorithms(0), "bidirectional_a*");
+}
@@ -0,0 +1,80 @@
+#include "gurka.h"
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include "tyr/actor.h"
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C
+         |
+         D
+)";
+
+const gurka::ways ways = {
+    {"ABC", {{"highway", "primary"}, {"name", "Main Street"}}},
+    {"BD", {{"highway", "residential"}, {"name", "Side Street"}}},
+};
+
+class DirectionsNone : public ::testing::Test {
+protected:
+  static gurka::map map;
+  static void SetUpTestSuite() {
+    map = gurka::buildtiles(gurka::detail::map_to_coordinates(ascii_map, 100), ways, {}, {},
+                            "test/data/directions_none");
+  }
+
+  Api route(const std::string& directions_type, const std::string& extra = "") {
+    auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+    tyr::actor_t actor(map.config, *reader, true);
+    Api api;
+    actor.route(R"({"costing":"auto","directions_type":")" + directions_type +
+                    R"(","locations":[{"lon":)" + std::to_string(map.nodes.at("A").lng()) +
+                    R"(,"lat":)" + std::to_string(map.nodes.at("A").lat()) + R"(},{"lon":)" +
+                    std::to_string(map.nodes.at("D").lng()) + R"(,"lat":)" +
+                    std::to_string(map.nodes.at("D").lat()) + "}]" + extra + "}",
+                nullptr, &api);
+    return api;
+  }
+};
+gurka::map DirectionsNone::map = {};
+
+} // namespace
+
+TEST_F(DirectionsNone, SkipsWhatOnlyGuidanceUses) {
+  auto full = route("maneuvers");
+  auto lean = route("none");
+  const auto& full_leg = full.trip().routes(0).legs(0);
+  const auto& lean_leg = lean.trip().routes(0).legs(0);
+  ASSERT_EQ(full_leg.node_size(), lean_leg.node_size());
+
+  // the intersection at B and the names are only there for the maneuvers
+  EXPECT_GT(full_leg.node(1).intersecting_edge_size(), 0);
+  for (int i = 0; i < lean_leg.node_size(); ++i) {
+    EXPECT_EQ(lean_leg.node(i).intersecting_edge_size(), 0);
+    if (lean_leg.node(i).has_edge()) {
+      EXPECT_GT(full_leg.node(i).edge().name_size(), 0);
+      EXPECT_EQ(lean_leg.node(i).edge().name_size(), 0);
+      EXPECT_EQ(lean_leg.node(i).edge().length_km(), full_leg.node(i).edge().length_km());
+      EXPECT_EQ(lean_leg.node(i).edge().speed(), full_leg.node(i).edge().speed());
+    }
+  }
+  EXPECT_EQ(lean_leg.shape(), full_leg.shape());
+
+  // the summary is the same either way
+  const auto& full_summary = full.directions().routes(0).legs(0).summary();
+  const auto& lean_summary = lean.directions().routes(0).legs(0).summary();
+  EXPECT_EQ(lean_summary.time(), full_summary.time());
+  EXPECT_EQ(lean_summary.length(), full_summary.length());
+  EXPECT_EQ(lean.directions().routes(0).legs(0).maneuver_size(), 0);
+}
+
+TEST_F(DirectionsNone, FiltersCanStillAskForThem) {
+  auto lean = route("none", R"(,"filters":{"attributes":["edge.names"],"action":"include"})");
+  const auto& leg = lean.trip().routes(0).legs(0);
+  EXPECT_GT(leg.node(0).edge().name_size(), 0);
+  EXPECT_EQ(leg.node(1).intersecting_edge_size(), 0);
+}
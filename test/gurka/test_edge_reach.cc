@@ -0,0 +1,122 @@
+#include "gurka.h"
+#include <gtest/gtest.h>
+
+#include "baldr/edgereach.h"
+#include "loki/reach.h"
+#include "mjolnir/reachbuilder.h"
+#include "proto_conversions.h"
+#include "sif/costfactory.h"
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C----D
+    |    |    |    |
+    E----F----G----H
+
+    I----J
+)";
+
+const gurka::ways ways = {
+    {"AB", {{"highway", "primary"}}},     {"BC", {{"highway", "primary"}}},
+    {"CD", {{"highway", "primary"}}},     {"EF", {{"highway", "residential"}}},
+    {"FG", {{"highway", "residential"}}}, {"GH", {{"highway", "residential"}}},
+    {"AE", {{"highway", "residential"}}}, {"BF", {{"highway", "footway"}}},
+    {"CG", {{"highway", "residential"}}}, {"DH", {{"highway", "residential"}, {"oneway", "yes"}}},
+    {"IJ", {{"highway", "residential"}}},
+};
+
+gurka::map build(const std::string& name, const std::string& cap) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  const std::string workdir = "test/data/edge_reach_" + name;
+  auto map = gurka::buildtiles(layout, ways, {}, {}, workdir,
+                               {{"mjolnir.edge_reach", workdir + "/edge_reach.bin"},
+                                {"mjolnir.edge_reach_cap", cap}});
+  mjolnir::ReachBuilder::Build(map.config);
+  return map;
+}
+
+sif::cost_ptr_t default_costing(const Costing costing) {
+  rapidjson::Document doc;
+  doc.SetObject();
+  CostingOptions options;
+  sif::ParseCostingOptions(doc, "/costing_options/" + Costing_Enum_Name(costing), &options, costing);
+  return sif::CostFactory().Create(options);
+}
+
+} // namespace
+
+TEST(EdgeReach, NeverMoreThanLiveReach) {
+  auto map = build("live", "100");
+  baldr::EdgeReach edge_reach(map.config.get<std::string>("mjolnir.edge_reach"));
+  ASSERT_EQ(edge_reach.cap(), 100);
+  ASSERT_EQ(edge_reach.costings().size(), 4);
+
+  baldr::GraphReader reader(map.config.get_child("mjolnir"));
+  loki::Reach reach_finder;
+  size_t edges = 0;
+  for (const auto& tile_id : reader.GetTileSet()) {
+    auto tile = reader.GetGraphTile(tile_id);
+    for (auto edge_id = tile_id; edge_id.id() < tile->header()->directededgecount(); ++edge_id) {
+      ASSERT_NE(edge_reach.reach(edge_id, 0), nullptr);
+      for (const auto costing : edge_reach.costings()) {
+        auto index = edge_reach.costing_index(costing);
+        const auto* stored = edge_reach.reach(edge_id, index);
+        auto live = reach_finder(tile->directededge(edge_id), edge_id, edge_reach.cap(), reader,
+                                 default_costing(static_cast<Costing>(costing)));
+        EXPECT_LE(stored->outbound, live.outbound) << edge_id << " " << int(costing);
+        EXPECT_LE(stored->inbound, live.inbound) << edge_id << " " << int(costing);
+      }
+      ++edges;
+    }
+  }
+  EXPECT_EQ(edges, edge_reach.edge_count());
+
+  // the island has two nodes, the rest of the graph eight
+  auto island = std::get<0>(gurka::findEdgeByNodes(reader, map.nodes, "I", "J"));
+  const auto* reach = edge_reach.reach(island, edge_reach.costing_index(Costing::auto_));
+  EXPECT_EQ(reach->outbound, 2);
+  EXPECT_EQ(reach->inbound, 2);
+  auto street = std::get<0>(gurka::findEdgeByNodes(reader, map.nodes, "A", "B"));
+  reach = edge_reach.reach(street, edge_reach.costing_index(Costing::pedestrian));
+  EXPECT_EQ(reach->outbound, 8);
+  EXPECT_EQ(reach->inbound, 8);
+}
+
+TEST(EdgeReach, SameReachWithTheTable) {
+  auto map = build("lookup", "4");
+  baldr::EdgeReach edge_reach(map.config.get<std::string>("mjolnir.edge_reach"));
+  baldr::GraphReader reader(map.config.get_child("mjolnir"));
+  auto costing = default_costing(Costing::auto_);
+
+  loki::Reach live, looked_up;
+  looked_up.set_precomputed(&edge_reach, edge_reach.costing_index(Costing::auto_));
+  // below the cap the table answers, above it the expansion does
+  for (const uint32_t max_reach : {1, 4, 50}) {
+    for (const auto& nodes : std::vector<std::pair<std::string, std::string>>{{"A", "B"},
+                                                                              {"D", "H"},
+                                                                              {"H", "D"},
+                                                                              {"I", "J"}}) {
+      auto edge = gurka::findEdgeByNodes(reader, map.nodes, nodes.first, nodes.second);
+      auto expected = live(std::get<1>(edge), std::get<0>(edge), max_reach, reader, costing);
+      auto reach = looked_up(std::get<1>(edge), std::get<0>(edge), max_reach, reader, costing);
+      EXPECT_EQ(reach.outbound, expected.outbound) << nodes.first << nodes.second << max_reach;
+      EXPECT_EQ(reach.inbound, expected.inbound) << nodes.first << nodes.second << max_reach;
+    }
+  }
+}
+
+TEST(EdgeReach, RouteWithTheTable) {
+  auto map = build("route", "100");
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto plain = gurka::buildtiles(layout, ways, {}, {}, "test/data/edge_reach_plain");
+  for (const auto& costing : {"auto", "pedestrian", "bicycle"}) {
+    auto expected = gurka::do_action(Options::route, plain, {"A", "H"}, costing);
+    auto result = gurka::do_action(Options::route, map, {"A", "H"}, costing);
+    EXPECT_EQ(result.directions().routes(0).legs(0).summary().length(),
+              expected.directions().routes(0).legs(0).summary().length())
+        << costing;
+  }
+}
@@ -0,0 +1,131 @@
+#include "gurka.h"
+#include <gtest/gtest.h>
+
+#include "baldr/graphcomponents.h"
+#include "loki/worker.h"
+#include "mjolnir/componentbuilder.h"
+
+using namespace valhalla;
+
+namespace {
+
+// the footway is the only way between the two islands of roads
+const std::string ascii_map = R"(
+    A----B----C----D----E
+              |
+              F
+
+    G----H
+)";
+
+const gurka::ways ways = {
+    {"ABC", {{"highway", "primary"}}},
+    {"CF", {{"highway", "residential"}, {"oneway", "yes"}}},
+    {"CDE", {{"highway", "footway"}}},
+    {"GH", {{"highway", "residential"}}},
+};
+
+std::string location(const gurka::map& map, const std::string& node) {
+  return R"({"lon":)" + std::to_string(map.nodes.at(node).lng()) + R"(,"lat":)" +
+         std::to_string(map.nodes.at(node).lat()) + "}";
+}
+
+class GraphComponents : public ::testing::Test {
+protected:
+  static gurka::map map;
+  static void SetUpTestSuite() {
+    const std::string workdir = "test/data/graph_components";
+    map = gurka::buildtiles(gurka::detail::map_to_coordinates(ascii_map, 100), ways, {}, {},
+                            workdir,
+                            {{"mjolnir.graph_components", workdir + "/graph_components.bin"}});
+    mjolnir::ComponentBuilder::Build(map.config);
+  }
+
+  uint32_t component(baldr::GraphReader& reader,
+                     const baldr::GraphComponents& components,
+                     const std::string& from,
+                     const std::string& to,
+                     const uint32_t mode) {
+    const auto edge_id = std::get<0>(gurka::findEdgeByNodes(reader, map.nodes, from, to));
+    return components.component(edge_id, components.mode_index(mode));
+  }
+
+  void route(const std::string& costing,
+             const std::string& from,
+             const std::string& to,
+             const std::string& options = "") {
+    loki::loki_worker_t worker(map.config);
+    Api request;
+    ParseApi(R"({"costing":")" + costing + R"(","locations":[)" + location(map, from) + "," +
+                 location(map, to) + "]" + options + "}",
+             Options::route, request);
+    worker.route(request);
+  }
+
+  void matrix(const std::vector<std::string>& sources, const std::vector<std::string>& targets) {
+    auto to_json = [](const std::vector<std::string>& nodes) {
+      std::string json;
+      for (const auto& node : nodes) {
+        json += (json.empty() ? "" : ",") + location(map, node);
+      }
+      return "[" + json + "]";
+    };
+    loki::loki_worker_t worker(map.config);
+    Api request;
+    ParseApi(R"({"costing":"auto","sources":)" + to_json(sources) + R"(,"targets":)" +
+                 to_json(targets) + "}",
+             Options::sources_to_targets, request);
+    worker.matrix(request);
+  }
+};
+gurka::map GraphComponents::map = {};
+
+} // namespace
+
+TEST_F(GraphComponents, ComponentsOfTheModes) {
+  baldr::GraphComponents components(map.config.get<std::string>("mjolnir.graph_components"));
+  baldr::GraphReader reader(map.config.get_child("mjolnir"));
+  ASSERT_GT(components.edge_count(), 0);
+  EXPECT_EQ(components.mode_index(baldr::kTaxiAccess), -1);
+
+  // the oneway connects both of its nodes and the footway none of them for a car
+  const auto auto_ab = component(reader, components, "A", "B", baldr::kAutoAccess);
+  EXPECT_EQ(component(reader, components, "B", "C", baldr::kAutoAccess), auto_ab);
+  EXPECT_EQ(component(reader, components, "C", "F", baldr::kAutoAccess), auto_ab);
+  EXPECT_EQ(component(reader, components, "F", "C", baldr::kAutoAccess), auto_ab);
+  EXPECT_EQ(component(reader, components, "C", "D", baldr::kAutoAccess),
+            baldr::GraphComponents::kNoComponent);
+  EXPECT_NE(component(reader, components, "G", "H", baldr::kAutoAccess), auto_ab);
+
+  // a pedestrian can walk from A to E but not to G
+  const auto pedestrian_ab = component(reader, components, "A", "B", baldr::kPedestrianAccess);
+  EXPECT_EQ(component(reader, components, "D", "E", baldr::kPedestrianAccess), pedestrian_ab);
+  EXPECT_NE(component(reader, components, "G", "H", baldr::kPedestrianAccess), pedestrian_ab);
+}
+
+TEST_F(GraphComponents, RejectsUnconnectedRoutes) {
+  try {
+    route("auto", "A", "G");
+    FAIL() << "Expected valhalla_exception_t.";
+  } catch (const valhalla_exception_t& err) { EXPECT_EQ(err.code, 170); }
+  try {
+    route("pedestrian", "E", "H");
+    FAIL() << "Expected valhalla_exception_t.";
+  } catch (const valhalla_exception_t& err) { EXPECT_EQ(err.code, 170); }
+
+  // connected along the oneway and over the footway
+  EXPECT_NO_THROW(route("auto", "A", "F"));
+  EXPECT_NO_THROW(route("pedestrian", "A", "E"));
+  // the components say nothing about a costing which ignores the access of the edges
+  EXPECT_NO_THROW(route("auto", "A", "G", R"(,"costing_options":{"auto":{"ignore_access":true}})"));
+}
+
+TEST_F(GraphComponents, RejectsUnconnectedMatrices) {
+  try {
+    matrix({"A"}, {"G", "H"});
+    FAIL() << "Expected valhalla_exception_t.";
+  } catch (const valhalla_exception_t& err) { EXPECT_EQ(err.code, 170); }
+
+  // one connected pair is enough for the matrix
+  EXPECT_NO_THROW(matrix({"A", "G"}, {"H"}));
+}
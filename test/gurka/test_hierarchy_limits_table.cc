@@ -0,0 +1,79 @@
+#include "filesystem.h"
+#include "gurka.h"
+#include "sif/hierarchylimits.h"
+
+#include <fstream>
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C----D
+         |    |
+         E----F
+)";
+
+const gurka::ways ways = {
+    {"AB", {{"highway", "primary"}}},     {"BC", {{"highway", "primary"}}},
+    {"CD", {{"highway", "primary"}}},     {"BE", {{"highway", "residential"}}},
+    {"EF", {{"highway", "residential"}}}, {"CF", {{"highway", "residential"}}},
+};
+
+} // namespace
+
+TEST(HierarchyLimitsTable, WriteAndRead) {
+  const midgard::PointLL a{5.1, 52.1}, b{-73.9, 40.7};
+  sif::HierarchyLimitsTable table;
+  EXPECT_TRUE(table.empty());
+  EXPECT_EQ(table.Factor("auto", a, b), 1.f);
+
+  table.Set("auto", sif::HierarchyLimitsTable::Region(a), 0.25f);
+  EXPECT_FALSE(table.empty());
+  // the larger factor of the two regions wins and unknown regions keep the defaults
+  EXPECT_EQ(table.Factor("auto", a, a), 0.25f);
+  EXPECT_EQ(table.Factor("auto", a, b), 1.f);
+  EXPECT_EQ(table.Factor("bicycle", a, a), 1.f);
+
+  table.Set("auto", sif::HierarchyLimitsTable::Region(b), 0.5f);
+  EXPECT_EQ(table.Factor("auto", a, b), 0.5f);
+
+  filesystem::create_directories("test/data/hierarchy_limits_table_io");
+  const std::string path = "test/data/hierarchy_limits_table_io/table.json";
+  {
+    std::ofstream file(path);
+    file << table.ToJson();
+  }
+  sif::HierarchyLimitsTable loaded(path);
+  EXPECT_EQ(loaded.ToJson(), table.ToJson());
+  EXPECT_EQ(loaded.Factor("auto", a, a), 0.25f);
+  EXPECT_EQ(loaded.Factor("auto", b, b), 0.5f);
+
+  {
+    std::ofstream file(path);
+    file << R"({"auto":{"1":0}})";
+  }
+  EXPECT_THROW(sif::HierarchyLimitsTable{path}, std::runtime_error);
+}
+
+TEST(HierarchyLimitsTable, RoutesWithTheTable) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/hierarchy_limits_table");
+  auto expected = gurka::do_action(valhalla::Options::route, map, {"A", "F"}, "auto");
+
+  // the map is tiny so even the smallest limits find the same route
+  sif::HierarchyLimitsTable table;
+  table.Set("auto", sif::HierarchyLimitsTable::Region(layout.at("A")), 0.1f);
+  const std::string path = "test/data/hierarchy_limits_table/table.json";
+  {
+    std::ofstream file(path);
+    file << table.ToJson();
+  }
+  auto tuned = gurka::buildtiles(layout, ways, {}, {}, "test/data/hierarchy_limits_table_tuned",
+                                 {{"thor.hierarchy_limits_table", path}});
+  auto result = gurka::do_action(valhalla::Options::route, tuned, {"A", "F"}, "auto");
+  gurka::assert::raw::expect_path(result, {"AB", "BC", "CF"});
+  EXPECT_EQ(result.directions().routes(0).legs(0).summary().length(),
+            expected.directions().routes(0).legs(0).summary().length());
+}
@@ -0,0 +1,85 @@
+#include "gurka.h"
+#include <gtest/gtest.h>
+
+#include "baldr/graphreader.h"
+#include "baldr/landmarks.h"
+
+using namespace valhalla;
+using namespace valhalla::baldr;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C
+         |    |
+    D----E    |
+    |         |
+    F---------G
+)";
+
+const gurka::ways ways = {
+    {"AB", {{"highway", "primary"}}},     {"BC", {{"highway", "primary"}}},
+    {"CG", {{"highway", "residential"}}}, {"BE", {{"highway", "residential"}}},
+    {"DE", {{"highway", "residential"}}}, {"DF", {{"highway", "residential"}}},
+    {"FG", {{"highway", "residential"}}},
+};
+
+gurka::map build(const std::string& name) {
+  const std::string workdir = "test/data/landmarks_" + name;
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  return gurka::buildtiles(layout, ways, {}, {}, workdir,
+                           {{"mjolnir.concurrency", "1"},
+                            {"mjolnir.landmarks", workdir + "/landmarks.bin"},
+                            {"mjolnir.landmark_count", "3"}});
+}
+
+} // namespace
+
+TEST(Landmarks, DistancesAreLowerBounds) {
+  auto map = build("bounds");
+  Landmarks landmarks(map.config.get<std::string>("mjolnir.landmarks"));
+  ASSERT_EQ(landmarks.landmark_count(), 3);
+
+  // every landmark is at distance 0 from itself and no edge is shorter than the difference of the
+  // distances of its ends
+  GraphReader reader(map.config.get_child("mjolnir"));
+  for (uint32_t l = 0; l < landmarks.landmark_count(); ++l) {
+    auto index = landmarks.node_index(landmarks.landmark(l));
+    ASSERT_NE(index, Landmarks::kInvalidNode);
+    EXPECT_EQ(landmarks.distances(index)[l], 0);
+  }
+  for (const auto& tile_id : reader.GetTileSet()) {
+    auto tile = reader.GetGraphTile(tile_id);
+    for (uint32_t i = 0; i < tile->header()->nodecount(); ++i) {
+      GraphId node(tile_id.tileid(), tile_id.level(), i);
+      auto from = landmarks.node_index(node);
+      ASSERT_NE(from, Landmarks::kInvalidNode);
+      for (const auto& edge : tile->GetDirectedEdges(tile->node(i))) {
+        auto to = landmarks.node_index(edge.endnode());
+        ASSERT_NE(to, Landmarks::kInvalidNode);
+        for (uint32_t l = 0; l < landmarks.landmark_count(); ++l) {
+          int64_t a = landmarks.distances(from)[l], b = landmarks.distances(to)[l];
+          EXPECT_LE(std::abs(a - b), edge.length());
+        }
+      }
+    }
+  }
+}
+
+TEST(Landmarks, TimeDependentRoutes) {
+  auto map = build("routes");
+  for (const auto& type : {"1", "2"}) {
+    auto result = gurka::do_action(valhalla::Options::route, map, {"A", "G"}, "auto",
+                                   {{"/date_time/type", type},
+                                    {"/date_time/value", "2021-04-02T06:30"}});
+    gurka::assert::raw::expect_path(result, {"AB", "BC", "CG"});
+    EXPECT_EQ(result.trip().routes(0).legs(0).algorithms(0),
+              type == std::string("1") ? "time_dependent_forward_a*"
+                                       : "time_dependent_reverse_a*");
+
+    result = gurka::do_action(valhalla::Options::route, map, {"F", "B"}, "pedestrian",
+                              {{"/date_time/type", type},
+                               {"/date_time/value", "2021-04-02T06:30"}});
+    gurka::assert::raw::expect_path(result, {"DF", "DE", "BE"});
+  }
+}
@@ -0,0 +1,75 @@
+#include "gurka.h"
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <thread>
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C----D
+         |    |
+         E----F
+)";
+
+const gurka::ways ways = {
+    {"AB", {{"highway", "primary"}}},     {"BC", {{"highway", "primary"}}},
+    {"CD", {{"highway", "primary"}}},     {"BE", {{"highway", "residential"}}},
+    {"EF", {{"highway", "residential"}}}, {"CF", {{"highway", "residential"}}},
+};
+
+const gurka::relations relations = {
+    {{
+         {gurka::way_member, "AB", "from"},
+         {gurka::way_member, "BC", "via"},
+         {gurka::way_member, "CF", "to"},
+     },
+     {
+         {"type", "restriction"},
+         {"restriction", "no_right_turn"},
+     }},
+};
+
+} // namespace
+
+TEST(LazyTileSections, MadeOnFirstUseFromAnyThread) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, relations, "test/data/lazy_tile_sections");
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+
+  size_t restricted = 0;
+  for (const auto& tile_id : reader->GetTileSet()) {
+    auto tile = reader->GetGraphTile(tile_id);
+    const uint32_t count = tile->header()->directededgecount();
+
+    // many threads asking at once all see the same routing edges and restrictions
+    std::vector<std::vector<size_t>> seen(4);
+    std::vector<std::thread> threads;
+    for (auto& restrictions : seen) {
+      threads.emplace_back([&tile, &restrictions, &tile_id, count]() {
+        for (uint32_t i = 0; i < count; ++i) {
+          baldr::GraphId edge_id(tile_id.tileid(), tile_id.level(), i);
+          restrictions.push_back(tile->GetRestrictions(true, edge_id, baldr::kAllAccess).size() +
+                                 tile->GetRestrictions(false, edge_id, baldr::kAllAccess).size());
+          EXPECT_EQ(tile->routing_edge(i)->endnode(), tile->directededge(i)->endnode());
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (const auto& restrictions : seen) {
+      EXPECT_EQ(restrictions, seen.front());
+    }
+    for (const auto r : seen.front()) {
+      restricted += r;
+    }
+  }
+  EXPECT_GT(restricted, 0);
+
+  // and the routes still obey it
+  auto result = gurka::do_action(valhalla::Options::route, map, {"A", "F"}, "auto");
+  gurka::assert::raw::expect_path(result, {"AB", "BE", "EF"});
+}
@@ -106,3 +106,63 @@ TEST(locate, basic_properties) {
     }
   }
 }
+
+TEST(locate, batch_same_as_single) {
+  const std::string ascii_map = R"(
+    A-1--B--2-C
+    |    |    |
+    3    4    5
+    |    |    |
+    D-6--E--7-F)";
+  const gurka::ways ways = {
+      {"ABC", {{"highway", "primary"}}}, {"DEF", {{"highway", "residential"}}},
+      {"AD", {{"highway", "residential"}}}, {"BE", {{"highway", "residential"}}},
+      {"CF", {{"highway", "residential"}}},
+  };
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  // batches of two so the locations are split over a few of them
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/gurka_locate_batch",
+                               {{"service_limits.locate.max_locations", "2"}});
+
+  std::vector<std::string> lines;
+  std::string locations;
+  for (const auto& node : {"1", "2", "3", "4", "5", "6", "7"}) {
+    lines.push_back(R"({"lon":)" + std::to_string(map.nodes[node].lng()) + R"(,"lat":)" +
+                    std::to_string(map.nodes[node].lat()) + "}");
+    locations += (locations.empty() ? "" : ",") + lines.back();
+  }
+
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  valhalla::tyr::actor_t actor(map.config, *reader, true);
+  const std::string options = R"({"costing":"auto","verbose":true})";
+  rapidjson::Document expected;
+  expected.Parse(
+      actor.locate(R"({"costing":"auto","verbose":true,"locations":[)" + locations + "]}"));
+  ASSERT_FALSE(expected.HasParseError());
+  ASSERT_EQ(expected.GetArray().Size(), lines.size());
+
+  // blank lines are skipped, every other one gets a line of its own
+  std::string input;
+  for (const auto& line : lines) {
+    input += line + "\n\n";
+  }
+  std::istringstream stream(input);
+  std::string output;
+  std::function<void(const std::string&)> write = [&output](const std::string& piece) {
+    output += piece;
+  };
+  EXPECT_EQ(actor.locate_batch(options, stream, write), lines.size());
+
+  std::istringstream results(output);
+  std::string line;
+  size_t i = 0;
+  while (std::getline(results, line)) {
+    ASSERT_LT(i, lines.size());
+    rapidjson::Document result;
+    result.Parse(line);
+    ASSERT_FALSE(result.HasParseError()) << line;
+    EXPECT_EQ(rapidjson::to_string(result), rapidjson::to_string(expected.GetArray()[i])) << i;
+    ++i;
+  }
+  EXPECT_EQ(i, lines.size());
+}
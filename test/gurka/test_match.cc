@@ -1,8 +1,10 @@
 #include "gurka.h"
+#include "meili/map_matcher_factory.h"
 #include "midgard/encoded.h"
 #include "midgard/util.h"
 #include "test.h"
 #include <gtest/gtest.h>
+#include <iomanip>
 
 using namespace valhalla;
 
@@ -343,3 +345,200 @@ TEST(MapMatchRoute, IgnoreRestrictions) {
                                  {{"/costing_options/auto/ignore_restrictions", "1"}});
   gurka::assert::raw::expect_path(result, {"AB", "BC"});
 }
+
+TEST(MapMatch, OnlineSameAsOffline) {
+  const std::string ascii_map = R"(
+    A--1-2--B--3-4--C
+                    5
+                    |
+                    6
+    F--9-8--E--7----D
+     )";
+
+  const gurka::ways ways = {
+      {"ABC", {{"highway", "primary"}}},
+      {"CD", {{"highway", "primary"}}},
+      {"DEF", {{"highway", "primary"}}},
+  };
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 50);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/online_match");
+
+  std::vector<meili::Measurement> measurements;
+  for (const auto& name : {"1", "2", "3", "4", "5", "6", "7", "8", "9"}) {
+    measurements.emplace_back(layout.at(name), 5, 50);
+  }
+
+  meili::MapMatcherFactory factory(map.config);
+  std::unique_ptr<meili::MapMatcher> matcher(factory.Create(Costing::auto_));
+  const auto offline = matcher->OfflineMatch(measurements).front().results;
+  matcher->Clear();
+
+  // feed the measurements a couple at a time with a short lag so some are forced out early
+  std::vector<meili::MatchResult> online;
+  for (size_t i = 0; i < measurements.size(); i += 2) {
+    std::vector<meili::Measurement> some(measurements.begin() + i,
+                                         measurements.begin() + std::min(i + 2, measurements.size()));
+    auto results = matcher->OnlineMatch(some, 3);
+    online.insert(online.end(), results.begin(), results.end());
+  }
+  // the states of the results which are out already are gone
+  ASSERT_FALSE(online.empty());
+  EXPECT_GT(matcher->state_container().forgotten_time(), 0);
+  EXPECT_TRUE(matcher->state_container().column(0).empty());
+  auto rest = matcher->FinishOnlineMatch();
+  online.insert(online.end(), rest.begin(), rest.end());
+
+  ASSERT_EQ(online.size(), offline.size());
+  for (size_t i = 0; i < online.size(); ++i) {
+    EXPECT_EQ(online[i].edgeid, offline[i].edgeid) << i;
+    EXPECT_NEAR(online[i].distance_along, offline[i].distance_along, 1e-5) << i;
+  }
+}
+
+TEST(MapMatch, AdaptiveInterpolation) {
+  const std::string ascii_map = R"(
+    A--------------------B
+                         |
+                         |
+                         |
+                         |
+                         C
+     )";
+
+  const gurka::ways ways = {{"AB", {{"highway", "primary"}}}, {"BC", {{"highway", "primary"}}}};
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 10);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/adaptive_interpolation");
+
+  // a measurement every 12 meters and second, just past the interpolation distance
+  std::vector<meili::Measurement> measurements;
+  double time = 0;
+  for (const auto& segment : {std::make_pair("A", "B"), std::make_pair("B", "C")}) {
+    const auto& from = layout.at(segment.first);
+    const auto& to = layout.at(segment.second);
+    const auto length = from.Distance(to);
+    for (double along = 0; along < length; along += 12, ++time) {
+      measurements.emplace_back(from.PointAlongSegment(to, along / length), 5, 50, time);
+    }
+  }
+  measurements.emplace_back(layout.at("C"), 5, 50, time);
+
+  auto match = [&](float adaptive_distance) {
+    auto config = map.config;
+    config.put<float>("meili.default.adaptive_interpolation_distance", adaptive_distance);
+    meili::MapMatcherFactory factory(config);
+    std::unique_ptr<meili::MapMatcher> matcher(factory.Create(Costing::auto_));
+    return matcher->OfflineMatch(measurements).front().results;
+  };
+  const auto every = match(0);
+  const auto adaptive = match(100);
+
+  // the straight stretches are interpolated but every measurement lands on the same edge
+  auto matched = [](const std::vector<meili::MatchResult>& results) {
+    return std::count_if(results.cbegin(), results.cend(),
+                         [](const meili::MatchResult& result) { return result.HasState(); });
+  };
+  EXPECT_LT(matched(adaptive), matched(every) / 2);
+  ASSERT_EQ(adaptive.size(), every.size());
+  for (size_t i = 0; i < adaptive.size(); ++i) {
+    EXPECT_EQ(adaptive[i].edgeid, every[i].edgeid) << i;
+  }
+}
+
+TEST(MapMatch, TransitionCache) {
+  const std::string ascii_map = R"(
+    A--1-2--B--3-4--C
+                    5
+                    |
+                    6
+    F--9-8--E--7----D
+     )";
+
+  const gurka::ways ways = {
+      {"ABC", {{"highway", "primary"}}},
+      {"CD", {{"highway", "primary"}}},
+      {"DEF", {{"highway", "primary"}}},
+  };
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 50);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/transition_cache");
+
+  // the same trace twice, the second time a meter off so the candidates are a bit further along
+  std::vector<meili::Measurement> measurements, shifted;
+  for (const auto& name : {"1", "2", "3", "4", "5", "6", "7", "8", "9"}) {
+    measurements.emplace_back(layout.at(name), 5, 50);
+    const auto& p = layout.at(name);
+    shifted.emplace_back(midgard::PointLL(p.lng() + 0.00001, p.lat() - 0.00001), 5, 50);
+  }
+
+  auto uncached_config = map.config;
+  uncached_config.put<size_t>("meili.transition_cache.size", 0);
+  meili::MapMatcherFactory uncached_factory(uncached_config);
+  meili::MapMatcherFactory factory(map.config);
+  for (const auto* trace : {&measurements, &measurements, &shifted}) {
+    std::unique_ptr<meili::MapMatcher> uncached_matcher(uncached_factory.Create(Costing::auto_));
+    const auto expected = uncached_matcher->OfflineMatch(*trace).front();
+    std::unique_ptr<meili::MapMatcher> matcher(factory.Create(Costing::auto_));
+    const auto matched = matcher->OfflineMatch(*trace).front();
+
+    ASSERT_EQ(matched.results.size(), expected.results.size());
+    for (size_t i = 0; i < matched.results.size(); ++i) {
+      EXPECT_EQ(matched.results[i].edgeid, expected.results[i].edgeid) << i;
+      EXPECT_NEAR(matched.results[i].distance_along, expected.results[i].distance_along, 1e-5) << i;
+    }
+    ASSERT_EQ(matched.segments.size(), expected.segments.size());
+    for (size_t i = 0; i < matched.segments.size(); ++i) {
+      EXPECT_EQ(matched.segments[i].edgeid, expected.segments[i].edgeid) << i;
+      EXPECT_NEAR(matched.segments[i].source, expected.segments[i].source, 1e-5) << i;
+      EXPECT_NEAR(matched.segments[i].target, expected.segments[i].target, 1e-5) << i;
+    }
+    EXPECT_NEAR(matched.score, expected.score, 1e-3);
+  }
+
+  // the traces after the first one did not route between the candidates again
+  EXPECT_EQ(uncached_factory.transitioncache().size(), 0);
+  EXPECT_GT(factory.transitioncache().size(), 0);
+  EXPECT_GT(factory.transitioncache().hits(), 0);
+}
+
+TEST(EdgeWalk, DenseRouteShape) {
+  const std::string ascii_map = R"(
+    A-------B-------C
+            |
+            D----E--F--G
+  )";
+
+  const gurka::ways ways = {{"AB", {{"highway", "primary"}}},   {"BC", {{"highway", "primary"}}},
+                            {"BD", {{"highway", "secondary"}}}, {"DE", {{"highway", "primary"}}},
+                            {"EF", {{"highway", "primary"}}},   {"FG", {{"highway", "primary"}}}};
+
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/edge_walk_dense_shape");
+
+  auto edge_names = [](const valhalla::Api& result) {
+    std::vector<std::string> names;
+    for (const auto& node : result.trip().routes(0).legs(0).node()) {
+      if (node.has_edge()) {
+        names.push_back(node.edge().name(0).value());
+      }
+    }
+    return names;
+  };
+
+  // walk the shape of a route with a point every meter so the long edges have plenty of points
+  auto route = gurka::do_action(valhalla::Options::route, map, {"A", "G"}, "auto");
+  auto shape = midgard::resample_spherical_polyline(
+      midgard::decode<std::vector<midgard::PointLL>>(route.trip().routes(0).legs(0).shape()), 1,
+      true);
+  ASSERT_GT(shape.size(), 2000u);
+  std::stringstream request;
+  request << std::setprecision(9) << R"({"costing":"auto","shape_match":"edge_walk","shape":[)";
+  for (const auto& point : shape) {
+    request << (&point == &shape.front() ? "" : ",") << R"({"lat":)" << point.lat() << R"(,"lon":)"
+            << point.lng() << "}";
+  }
+  request << "]}";
+  auto walked = gurka::do_action(valhalla::Options::trace_route, map, request.str());
+
+  gurka::assert::raw::expect_path(walked, {"AB", "BD", "DE", "EF", "FG"});
+  EXPECT_EQ(edge_names(walked), edge_names(route));
+  gurka::assert::raw::expect_path_length(walked, 2.1, 0.01);
+}
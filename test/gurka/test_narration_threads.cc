@@ -0,0 +1,77 @@
+#include "gurka.h"
+#include <gtest/gtest.h>
+
+#include "odin/directionsworkers.h"
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C----D
+    |    |    |    |
+    E----F----G----H
+    |    |    |    |
+    I----J----K----L
+)";
+
+const gurka::ways ways = {
+    {"ABCD", {{"highway", "primary"}, {"name", "North Street"}}},
+    {"EFGH", {{"highway", "residential"}, {"name", "Middle Street"}}},
+    {"IJKL", {{"highway", "secondary"}, {"name", "South Street"}}},
+    {"AEI", {{"highway", "residential"}, {"name", "First Avenue"}}},
+    {"BFJ", {{"highway", "residential"}, {"name", "Second Avenue"}}},
+    {"CGK", {{"highway", "residential"}, {"name", "Third Avenue"}}},
+    {"DHL", {{"highway", "residential"}, {"name", "Fourth Avenue"}}},
+};
+
+} // namespace
+
+TEST(NarrationThreads, SameDirectionsAsOneThread) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/narration_threads");
+  auto threaded = map;
+  threaded.config.put("odin.narration_threads", 3);
+
+  const std::vector<std::string> waypoints{"A", "L", "E", "D", "J", "C", "I"};
+  for (const auto& format : {"json", "osrm"}) {
+    auto expected = gurka::do_action(Options::route, map, waypoints, "auto", {{"/format", format}});
+    auto result =
+        gurka::do_action(Options::route, threaded, waypoints, "auto", {{"/format", format}});
+    ASSERT_EQ(result.directions().routes(0).legs_size(), waypoints.size() - 1);
+    EXPECT_EQ(result.directions().SerializeAsString(), expected.directions().SerializeAsString())
+        << format;
+  }
+
+  // the legs of alternates are spread over the threads as well
+  auto expected = gurka::do_action(Options::route, map, {"A", "L"}, "auto", {{"/alternates", "2"}});
+  auto result =
+      gurka::do_action(Options::route, threaded, {"A", "L"}, "auto", {{"/alternates", "2"}});
+  EXPECT_EQ(result.directions().routes_size(), expected.directions().routes_size());
+  EXPECT_EQ(result.directions().SerializeAsString(), expected.directions().SerializeAsString());
+}
+
+TEST(NarrationThreads, EveryLegOnceAndFirstErrorRethrown) {
+  odin::DirectionsWorkers workers(3);
+  EXPECT_EQ(workers.size(), 4);
+
+  // the workers are reused from run to run
+  for (uint32_t count : {0, 1, 5, 100}) {
+    std::vector<std::atomic<uint32_t>> taken(count);
+    workers.Run(count, [&taken](uint32_t i) { ++taken[i]; });
+    for (const auto& t : taken) {
+      EXPECT_EQ(t.load(), 1);
+    }
+  }
+
+  EXPECT_THROW(workers.Run(10,
+                           [](uint32_t i) {
+                             if (i == 3) {
+                               throw std::runtime_error("leg 3");
+                             }
+                           }),
+               std::runtime_error);
+  std::atomic<uint32_t> total{0};
+  workers.Run(10, [&total](uint32_t i) { total += i; });
+  EXPECT_EQ(total.load(), 45);
+}
@@ -0,0 +1,78 @@
+#include "gurka.h"
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include "tyr/actor.h"
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C
+         |
+         D
+)";
+
+const gurka::ways ways = {
+    {"ABC", {{"highway", "primary"}, {"name", "Main Street"}}},
+    {"BD", {{"highway", "residential"}, {"name", "Side Street"}}},
+};
+
+class NarrativeByFormat : public ::testing::Test {
+protected:
+  static gurka::map map;
+  static void SetUpTestSuite() {
+    map = gurka::buildtiles(gurka::detail::map_to_coordinates(ascii_map, 100), ways, {}, {},
+                            "test/data/narrative_by_format");
+  }
+
+  Api route(const std::string& format) {
+    auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+    tyr::actor_t actor(map.config, *reader, true);
+    Api api;
+    actor.route(R"({"costing":"auto","format":")" + format + R"(","locations":[{"lon":)" +
+                    std::to_string(map.nodes.at("A").lng()) + R"(,"lat":)" +
+                    std::to_string(map.nodes.at("A").lat()) + R"(},{"lon":)" +
+                    std::to_string(map.nodes.at("D").lng()) + R"(,"lat":)" +
+                    std::to_string(map.nodes.at("D").lat()) + "}]}",
+                nullptr, &api);
+    return api;
+  }
+};
+gurka::map NarrativeByFormat::map = {};
+
+} // namespace
+
+TEST_F(NarrativeByFormat, JsonHasEverything) {
+  auto api = route("json");
+  const auto& maneuvers = api.directions().routes(0).legs(0).maneuver();
+  ASSERT_EQ(maneuvers.size(), 3);
+  for (const auto& maneuver : maneuvers) {
+    EXPECT_FALSE(maneuver.text_instruction().empty());
+    EXPECT_FALSE(maneuver.verbal_pre_transition_instruction().empty());
+  }
+}
+
+TEST_F(NarrativeByFormat, OsrmOnlyHasText) {
+  auto api = route("osrm");
+  const auto& maneuvers = api.directions().routes(0).legs(0).maneuver();
+  ASSERT_EQ(maneuvers.size(), 3);
+  for (const auto& maneuver : maneuvers) {
+    EXPECT_FALSE(maneuver.text_instruction().empty());
+    EXPECT_FALSE(maneuver.has_verbal_transition_alert_instruction());
+    EXPECT_FALSE(maneuver.has_verbal_pre_transition_instruction());
+    EXPECT_FALSE(maneuver.has_verbal_post_transition_instruction());
+    EXPECT_FALSE(maneuver.has_verbal_succinct_transition_instruction());
+  }
+}
+
+TEST_F(NarrativeByFormat, GpxHasNoNarrative) {
+  auto api = route("gpx");
+  const auto& maneuvers = api.directions().routes(0).legs(0).maneuver();
+  ASSERT_EQ(maneuvers.size(), 3);
+  for (const auto& maneuver : maneuvers) {
+    EXPECT_TRUE(maneuver.text_instruction().empty());
+    EXPECT_FALSE(maneuver.has_verbal_pre_transition_instruction());
+  }
+}
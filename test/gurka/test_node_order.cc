@@ -0,0 +1,100 @@
+#include "gurka.h"
+#include <gtest/gtest.h>
+
+#include "mjolnir/graphreorderer.h"
+
+#include <numeric>
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C----D
+    |    |    |    |
+    E----F----G----H
+    |    |    |    |
+    I----J----K----L
+)";
+
+const gurka::ways ways = {
+    {"AB", {{"highway", "primary"}}},     {"BC", {{"highway", "primary"}}},
+    {"CD", {{"highway", "primary"}}},     {"EF", {{"highway", "residential"}}},
+    {"FG", {{"highway", "residential"}}}, {"GH", {{"highway", "residential"}}},
+    {"IJ", {{"highway", "secondary"}}},   {"JK", {{"highway", "secondary"}}},
+    {"KL", {{"highway", "secondary"}}},   {"AE", {{"highway", "residential"}}},
+    {"EI", {{"highway", "residential"}, {"oneway", "yes"}}},
+    {"BF", {{"highway", "residential"}}}, {"FJ", {{"highway", "residential"}}},
+    {"CG", {{"highway", "residential"}}}, {"GK", {{"highway", "residential"}}},
+    {"DH", {{"highway", "residential"}}}, {"HL", {{"highway", "residential"}}},
+};
+
+// The edges of the route by name and the length of the route
+std::pair<std::vector<std::string>, float> route(const valhalla::Api& result) {
+  std::vector<std::string> names;
+  for (const auto& node : result.trip().routes(0).legs(0).node()) {
+    if (node.has_edge()) {
+      names.push_back(node.edge().name(0).value());
+    }
+  }
+  return {names, result.directions().routes(0).legs(0).summary().length()};
+}
+
+// Where the edges leaving a node end
+std::vector<std::pair<double, double>>
+neighbors(const gurka::map& map, const gurka::nodelayout& layout, const std::string& name) {
+  baldr::GraphReader reader(map.config.get_child("mjolnir"));
+  auto node_id = gurka::findNode(reader, layout, name);
+  auto tile = reader.GetGraphTile(node_id);
+  std::vector<std::pair<double, double>> ends;
+  for (const auto& edge : tile->GetDirectedEdges(node_id)) {
+    auto end_tile = reader.GetGraphTile(edge.endnode());
+    auto ll = end_tile->node(edge.endnode())->latlng(end_tile->header()->base_ll());
+    ends.emplace_back(ll.lng(), ll.lat());
+  }
+  std::sort(ends.begin(), ends.end());
+  return ends;
+}
+
+} // namespace
+
+TEST(NodeOrder, SameRoutesInEveryOrder) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/node_order_none");
+
+  const std::vector<std::vector<std::string>> requests{{"A", "L"}, {"E", "D"}, {"I", "C"},
+                                                       {"L", "A"}, {"J", "H"}};
+  for (const auto& node_order : {"hilbert", "bfs"}) {
+    auto reordered = gurka::buildtiles(layout, ways, {}, {},
+                                       std::string("test/data/node_order_") + node_order,
+                                       {{"mjolnir.node_order", node_order}});
+    for (const auto& waypoints : requests) {
+      for (const auto& costing : {"auto", "pedestrian"}) {
+        auto expected = gurka::do_action(valhalla::Options::route, map, waypoints, costing);
+        auto result = gurka::do_action(valhalla::Options::route, reordered, waypoints, costing);
+        EXPECT_EQ(route(result), route(expected))
+            << node_order << " " << costing << " " << waypoints.front() << waypoints.back();
+      }
+    }
+
+    // the same edges leave every node, only the ids of the nodes changed
+    for (const auto& name : {"A", "F", "L"}) {
+      EXPECT_EQ(neighbors(reordered, layout, name), neighbors(map, layout, name)) << name;
+    }
+  }
+}
+
+TEST(NodeOrder, BreadthFirstVisitsNeighborsTogether) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/node_order_bfs_neighbors",
+                               {{"mjolnir.node_order", "bfs"}});
+  baldr::GraphReader reader(map.config.get_child("mjolnir"));
+  for (const auto& tile_id : reader.GetTileSet(baldr::TileHierarchy::levels().back().level)) {
+    auto tile = reader.GetGraphTile(tile_id);
+    // once ordered breadth first the order is breadth first already
+    auto order = mjolnir::GraphReorderer::NodeOrder(tile, "bfs");
+    std::vector<uint32_t> identity(order.size());
+    std::iota(identity.begin(), identity.end(), 0);
+    EXPECT_EQ(order, identity);
+  }
+}
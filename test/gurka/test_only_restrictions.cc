@@ -135,3 +135,72 @@ TEST(OnlyRestrictions, ManyNeighbours) {
     }
   }
 }
+
+TEST(OnlyRestrictions, TileIndex) {
+  const std::string ascii_map = R"(
+           1   3--5
+           |   |
+  A----B---C---D---E-----F
+           |   |
+           2   4
+)";
+
+  const gurka::ways ways = {
+      {"AB", {{"highway", "primary"}}}, {"BC", {{"highway", "primary"}}},
+      {"CD", {{"highway", "primary"}}}, {"DE", {{"highway", "primary"}}},
+      {"EF", {{"highway", "primary"}}}, {"C1", {{"highway", "primary"}}},
+      {"C2", {{"highway", "primary"}}}, {"D3", {{"highway", "primary"}}},
+      {"D4", {{"highway", "primary"}}}, {"35", {{"highway", "primary"}}},
+  };
+
+  // restrictions onto and from several edges so that the index has more than one edge to tell apart
+  const gurka::relations relations = {
+      {{
+           {gurka::way_member, "BC", "from"},
+           {gurka::way_member, "CD", "via"},
+           {gurka::way_member, "DE", "to"},
+       },
+       {
+           {"type", "restriction"},
+           {"restriction", "only_straight_on"},
+       }},
+      {{
+           {gurka::way_member, "DE", "from"},
+           {gurka::way_member, "CD", "via"},
+           {gurka::way_member, "C1", "to"},
+       },
+       {
+           {"type", "restriction"},
+           {"restriction", "only_right_turn"},
+       }},
+  };
+
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map =
+      gurka::buildtiles(layout, ways, {}, relations, "test/data/only_restrictions_tile_index",
+                        {{"mjolnir.concurrency", "1"}});
+
+  // every edge has to find exactly the restrictions it ends (or starts), in the order of the tile
+  baldr::GraphReader reader(map.config.get_child("mjolnir"));
+  size_t found = 0;
+  for (const auto& tile_id : reader.GetTileSet()) {
+    auto tile = reader.GetGraphTile(tile_id);
+    for (uint32_t i = 0; i < tile->header()->directededgecount(); ++i) {
+      const auto edge_id = tile_id + i;
+      const auto* edge = tile->directededge(i);
+      for (const bool forward : {true, false}) {
+        const auto restrictions = tile->GetRestrictions(forward, edge_id, baldr::kAllAccess);
+        const auto modes = forward ? edge->end_restriction() : edge->start_restriction();
+        EXPECT_EQ(restrictions.empty(), modes == 0) << std::to_string(edge_id);
+        for (size_t r = 0; r < restrictions.size(); ++r) {
+          EXPECT_EQ(forward ? restrictions[r]->to_graphid() : restrictions[r]->from_graphid(),
+                    edge_id);
+          EXPECT_TRUE(r == 0 || restrictions[r - 1] < restrictions[r]);
+        }
+        EXPECT_TRUE(tile->GetRestrictions(forward, edge_id, baldr::kPedestrianAccess).empty());
+        found += restrictions.size();
+      }
+    }
+  }
+  EXPECT_GT(found, 0u);
+}
@@ -0,0 +1,78 @@
+#include "gurka.h"
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C----D
+    |    |    |    |
+    E----F----G----H
+    |    |    |    |
+    I----J----K----L
+)";
+
+const gurka::ways ways = {
+    {"AB", {{"highway", "primary"}}},     {"BC", {{"highway", "primary"}}},
+    {"CD", {{"highway", "primary"}}},     {"EF", {{"highway", "residential"}}},
+    {"FG", {{"highway", "residential"}}}, {"GH", {{"highway", "residential"}}},
+    {"IJ", {{"highway", "secondary"}}},   {"JK", {{"highway", "secondary"}}},
+    {"KL", {{"highway", "secondary"}}},   {"AE", {{"highway", "residential"}}},
+    {"EI", {{"highway", "residential"}, {"oneway", "yes"}}},
+    {"BF", {{"highway", "residential"}}}, {"FJ", {{"highway", "residential"}}},
+    {"CG", {{"highway", "residential"}}}, {"GK", {{"highway", "residential"}}},
+    {"DH", {{"highway", "residential"}}}, {"HL", {{"highway", "residential"}}},
+};
+
+// The edges of the route by name and the length of the route
+std::pair<std::vector<std::string>, float> route(const valhalla::Api& result) {
+  std::vector<std::string> names;
+  for (const auto& node : result.trip().routes(0).legs(0).node()) {
+    if (node.has_edge()) {
+      names.push_back(node.edge().name(0).value());
+    }
+  }
+  return {names, result.directions().routes(0).legs(0).summary().length()};
+}
+
+} // namespace
+
+TEST(OpposingEdgeIds, StoredIdsMatchTheEndNodes) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/opposing_edge_ids",
+                               {{"mjolnir.opposing_edge_ids", "true"}});
+
+  baldr::GraphReader reader(map.config.get_child("mjolnir"));
+  size_t checked = 0;
+  for (const auto& tile_id : reader.GetTileSet()) {
+    auto tile = reader.GetGraphTile(tile_id);
+    EXPECT_TRUE(tile->header()->has_ext_directededge());
+    for (uint32_t i = 0; i < tile->header()->directededgecount(); ++i) {
+      const auto* edge = tile->directededge(i);
+      auto end_tile = reader.GetGraphTile(edge->endnode());
+      ASSERT_TRUE(end_tile);
+      EXPECT_EQ(tile->GetOpposingEdgeId(edge, *end_tile), end_tile->GetOpposingEdgeId(edge));
+      ++checked;
+    }
+  }
+  EXPECT_GT(checked, 0);
+}
+
+TEST(OpposingEdgeIds, SameRoutes) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/opposing_edge_ids_none");
+  auto stored = gurka::buildtiles(layout, ways, {}, {}, "test/data/opposing_edge_ids_stored",
+                                  {{"mjolnir.opposing_edge_ids", "true"}});
+
+  const std::vector<std::vector<std::string>> requests{{"A", "L"}, {"E", "D"}, {"I", "C"},
+                                                       {"L", "A"}, {"J", "H"}};
+  for (const auto& waypoints : requests) {
+    for (const auto& costing : {"auto", "pedestrian"}) {
+      auto expected = gurka::do_action(valhalla::Options::route, map, waypoints, costing);
+      auto result = gurka::do_action(valhalla::Options::route, stored, waypoints, costing);
+      EXPECT_EQ(route(result), route(expected))
+          << costing << " " << waypoints.front() << waypoints.back();
+    }
+  }
+}
@@ -0,0 +1,75 @@
+#include "gurka.h"
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include "tyr/actor.h"
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A-----B-----C
+    |     |     |
+    D-----E-----F
+    |     |     |
+    G-----H-----I
+)";
+
+const gurka::ways ways = {
+    {"ABC", {{"highway", "residential"}}}, {"DEF", {{"highway", "residential"}}},
+    {"GHI", {{"highway", "residential"}}}, {"ADG", {{"highway", "residential"}}},
+    {"BEH", {{"highway", "residential"}}}, {"CFI", {{"highway", "residential"}}},
+};
+
+class OptimizedRouteCache : public ::testing::Test {
+protected:
+  static gurka::map map;
+  static void SetUpTestSuite() {
+    map = gurka::buildtiles(gurka::detail::map_to_coordinates(ascii_map, 100), ways, {}, {},
+                            "test/data/optimized_route_cache");
+  }
+
+  std::string request(const std::string& stops) {
+    std::string locations;
+    for (const auto& stop : stops) {
+      const auto& ll = map.nodes.at(std::string(1, stop));
+      locations += (locations.empty() ? "" : ",") + std::string(R"({"lon":)") +
+                   std::to_string(ll.lng()) + R"(,"lat":)" + std::to_string(ll.lat()) + "}";
+    }
+    return R"({"costing":"auto","locations":[)" + locations + "]}";
+  }
+
+  // the order the stops were put in and how long the whole route takes
+  std::pair<std::vector<std::pair<double, double>>, double> optimize(tyr::actor_t& actor,
+                                                                      const std::string& stops) {
+    Api api;
+    actor.optimized_route(request(stops), nullptr, &api);
+    std::vector<std::pair<double, double>> order;
+    for (const auto& location : api.options().locations()) {
+      order.emplace_back(location.ll().lng(), location.ll().lat());
+    }
+    double time = 0;
+    for (const auto& leg : api.directions().routes(0).legs()) {
+      time += leg.summary().time();
+    }
+    return {order, time};
+  }
+};
+gurka::map OptimizedRouteCache::map = {};
+
+} // namespace
+
+TEST_F(OptimizedRouteCache, AddingAStopMatchesTheFullMatrix) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  tyr::actor_t uncached(map.config, *reader, true);
+
+  auto config = map.config;
+  config.put("thor.optimizer_matrix_cache_size", 100);
+  tyr::actor_t cached(config, *reader, true);
+
+  // the second request only adds a stop, the third has the same stops again
+  for (const auto& stops : {"AIFG", "AIFCG", "AIFCG", "ACG"}) {
+    EXPECT_EQ(optimize(cached, stops), optimize(uncached, stops)) << stops;
+  }
+}
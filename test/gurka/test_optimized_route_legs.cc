@@ -0,0 +1,124 @@
+#include "gurka.h"
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include "tyr/actor.h"
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A-------B---C
+    |       |   |
+    |       |   |
+    D---E---F---G
+        |       |
+        H-------I
+)";
+
+const gurka::ways ways = {
+    {"AB", {{"highway", "primary"}}},     {"BC", {{"highway", "primary"}}},
+    {"DE", {{"highway", "residential"}}}, {"EF", {{"highway", "residential"}}},
+    {"FG", {{"highway", "secondary"}}},   {"HI", {{"highway", "tertiary"}}},
+    {"AD", {{"highway", "residential"}}}, {"BF", {{"highway", "residential"}}},
+    {"CG", {{"highway", "primary"}}},     {"EH", {{"highway", "residential"}}},
+    {"GI", {{"highway", "secondary"}}},
+};
+
+class OptimizedRouteLegs : public ::testing::Test {
+protected:
+  static gurka::map map;
+  static void SetUpTestSuite() {
+    map = gurka::buildtiles(gurka::detail::map_to_coordinates(ascii_map, 100), ways, {}, {},
+                            "test/data/optimized_route_legs");
+  }
+
+  std::string request(const std::vector<std::pair<double, double>>& lls,
+                      const std::string& type = "break") {
+    std::string locations;
+    for (size_t i = 0; i < lls.size(); ++i) {
+      const bool end = i == 0 || i + 1 == lls.size();
+      locations += (locations.empty() ? "" : ",") + std::string(R"({"lon":)") +
+                   std::to_string(lls[i].first) + R"(,"lat":)" + std::to_string(lls[i].second) +
+                   R"(,"type":")" + (end ? "break" : type) + R"("})";
+    }
+    return R"({"costing":"auto","locations":[)" + locations + "]}";
+  }
+
+  std::vector<std::pair<double, double>> lls(const std::string& stops) {
+    std::vector<std::pair<double, double>> result;
+    for (const auto& stop : stops) {
+      const auto& ll = map.nodes.at(std::string(1, stop));
+      result.emplace_back(ll.lng(), ll.lat());
+    }
+    return result;
+  }
+
+  // the edges and the time of each leg along with the algorithms which found them
+  struct legs_t {
+    std::vector<std::vector<uint64_t>> edges;
+    std::vector<double> times;
+    std::vector<std::string> algorithms;
+  };
+  legs_t legs(const Api& api) {
+    legs_t result;
+    for (const auto& leg : api.trip().routes(0).legs()) {
+      result.edges.emplace_back();
+      for (const auto& node : leg.node()) {
+        if (node.has_edge()) {
+          result.edges.back().push_back(node.edge().id());
+        }
+      }
+      result.algorithms.insert(result.algorithms.end(), leg.algorithms().begin(),
+                               leg.algorithms().end());
+    }
+    for (const auto& leg : api.directions().routes(0).legs()) {
+      result.times.push_back(leg.summary().time());
+    }
+    return result;
+  }
+};
+gurka::map OptimizedRouteLegs::map = {};
+
+} // namespace
+
+TEST_F(OptimizedRouteLegs, LegsComeFromTheMatrix) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  tyr::actor_t actor(map.config, *reader, true);
+
+  // none of the stops are next to each other, those legs are trivial for the path algorithms
+  for (const auto& stops : {"AIC", "CHD", "AGH"}) {
+    Api optimized;
+    actor.optimized_route(request(lls(stops)), nullptr, &optimized);
+    std::vector<std::pair<double, double>> order;
+    for (const auto& location : optimized.options().locations()) {
+      order.emplace_back(location.ll().lng(), location.ll().lat());
+    }
+
+    // the legs are formed from the matrix which means they are the same as routing them again
+    Api routed;
+    actor.route(request(order), nullptr, &routed);
+    auto expected = legs(routed);
+    auto result = legs(optimized);
+    EXPECT_EQ(result.edges, expected.edges) << stops;
+    ASSERT_EQ(result.times.size(), expected.times.size()) << stops;
+    for (size_t i = 0; i < result.times.size(); ++i) {
+      EXPECT_NEAR(result.times[i], expected.times[i], 1) << stops << " leg " << i;
+    }
+    EXPECT_EQ(result.algorithms, std::vector<std::string>(order.size() - 1, "cost_matrix"))
+        << stops;
+  }
+}
+
+TEST_F(OptimizedRouteLegs, ThroughLocationsAreSearchedFor) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  tyr::actor_t actor(map.config, *reader, true);
+
+  // the matrix doesnt have to keep going on the same edge at a through location
+  Api optimized;
+  actor.optimized_route(request(lls("AGHEC"), "through"), nullptr, &optimized);
+  for (const auto& algorithm : legs(optimized).algorithms) {
+    EXPECT_NE(algorithm, "cost_matrix");
+  }
+}
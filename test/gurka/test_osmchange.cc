@@ -0,0 +1,57 @@
+#include "gurka.h"
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "baldr/tilehierarchy.h"
+#include "mjolnir/osmchange.h"
+
+using namespace valhalla;
+
+TEST(OSMChange, AffectedTiles) {
+  // far enough apart that every node is in a tile of its own on every level
+  const std::string ascii_map = R"(A-----------B-----------C)";
+  const gurka::ways ways = {{"AB", {{"highway", "primary"}, {"osm_id", "100"}}},
+                            {"BC", {{"highway", "primary"}, {"osm_id", "101"}}}};
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 10000);
+  const std::string workdir = "test/data/gurka_osmchange";
+  auto map = gurka::buildtiles(layout, ways, {}, {}, workdir);
+
+  // a new node half way between B and C and a change to the tags of AB
+  const auto created = layout.at("B").PointAlongSegment(layout.at("C"), 0.5);
+  const std::string osc_file = workdir + "/change.osc";
+  {
+    std::ofstream osc(osc_file);
+    osc << R"(<?xml version="1.0" encoding="UTF-8"?>)" << "\n"
+        << R"(<osmChange version="0.6" generator="test">)" << "\n"
+        << "<create>\n"
+        << R"(  <node id="500" version="1" lat=")" << std::to_string(created.lat()) << R"(" lon=")"
+        << std::to_string(created.lng()) << R"("/>)" << "\n"
+        << "</create>\n"
+        << "<modify>\n"
+        << R"(  <way id="100" version="2">)" << "\n"
+        << R"(    <nd ref="0"/>)" << "\n"
+        << R"(    <nd ref="1"/>)" << "\n"
+        << R"(    <tag k="highway" v="secondary"/>)" << "\n"
+        << R"(    <tag k="note" v="a > b"/>)" << "\n"
+        << "  </way>\n"
+        << "</modify>\n"
+        << "</osmChange>\n";
+  }
+
+  auto change = mjolnir::OSMChange::Read(osc_file);
+  EXPECT_EQ(change.nodes.size(), 1);
+  EXPECT_EQ(change.node_ids, (std::unordered_set<uint64_t>{0, 1, 500}));
+  EXPECT_EQ(change.way_ids, (std::unordered_set<uint64_t>{100}));
+
+  const auto tile_dir = map.config.get<std::string>("mjolnir.tile_dir");
+  auto tiles = change.AffectedTiles(tile_dir + "/ways.bin", tile_dir + "/way_nodes.bin");
+  std::set<baldr::GraphId> expected;
+  for (const auto& level : baldr::TileHierarchy::levels()) {
+    for (const auto& ll : {layout.at("A"), layout.at("B"), created}) {
+      expected.insert(baldr::TileHierarchy::GetGraphId(ll, level.level));
+    }
+  }
+  EXPECT_EQ(tiles, expected);
+  EXPECT_EQ(tiles.count(baldr::TileHierarchy::GetGraphId(layout.at("C"), 2)), 0);
+}
@@ -0,0 +1,60 @@
+#include "gurka.h"
+#include <gtest/gtest.h>
+
+#include "loki/search.h"
+#include "sif/costfactory.h"
+
+using namespace valhalla;
+
+namespace {
+
+// big enough to cover a few tiles so the locations are split between the threads
+const std::string ascii_map = R"(
+    A------B------C------D
+    |      |      |      |
+    E------F------G------H
+    |      |      |      |
+    I------J------K------L
+)";
+
+const gurka::ways ways = {
+    {"ABCD", {{"highway", "primary"}}},     {"EFGH", {{"highway", "residential"}}},
+    {"IJKL", {{"highway", "residential"}}}, {"AEI", {{"highway", "residential"}}},
+    {"BFJ", {{"highway", "residential"}}},  {"CGK", {{"highway", "residential"}}},
+    {"DHL", {{"highway", "residential"}, {"oneway", "yes"}}},
+};
+
+} // namespace
+
+TEST(ParallelSearch, SameAsSerial) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 2000);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/parallel_search");
+  auto costing = sif::CostFactory().Create(Costing::auto_);
+
+  std::vector<baldr::Location> locations;
+  for (const auto& node : layout) {
+    for (double offset : {0., 0.001, -0.002, 0.005}) {
+      baldr::Location location({node.second.lng() + offset, node.second.lat() - offset / 2},
+                               baldr::Location::StopType::BREAK, 10, 5);
+      locations.push_back(location);
+    }
+  }
+
+  baldr::GraphReader reader(map.config.get_child("mjolnir"));
+  auto expected = loki::Search(locations, reader, costing);
+  ASSERT_EQ(expected.size(), locations.size());
+
+  std::vector<std::unique_ptr<baldr::GraphReader>> owned;
+  std::vector<baldr::GraphReader*> readers;
+  for (size_t i = 0; i < 4; ++i) {
+    owned.emplace_back(new baldr::GraphReader(map.config.get_child("mjolnir")));
+    readers.push_back(owned.back().get());
+  }
+  auto results = loki::Search(locations, readers, costing);
+  ASSERT_EQ(results.size(), expected.size());
+  for (const auto& location : locations) {
+    ASSERT_NE(results.find(location), results.cend());
+    EXPECT_EQ(results.at(location), expected.at(location))
+        << location.latlng_.lng() << "," << location.latlng_.lat();
+  }
+}
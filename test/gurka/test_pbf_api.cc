@@ -0,0 +1,138 @@
+#include "gurka.h"
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include "tyr/actor.h"
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C
+    |    |    |
+    D----E----F
+)";
+
+const gurka::ways ways = {
+    {"ABC", {{"highway", "primary"}}},
+    {"DEF", {{"highway", "residential"}}},
+    {"AD", {{"highway", "residential"}}},
+    {"BE", {{"highway", "residential"}}},
+    {"CF", {{"highway", "residential"}}},
+};
+
+std::string location(const gurka::map& map, const std::string& node) {
+  return R"({"lon":)" + std::to_string(map.nodes.at(node).lng()) + R"(,"lat":)" +
+         std::to_string(map.nodes.at(node).lat()) + "}";
+}
+
+class PbfApi : public ::testing::Test {
+protected:
+  static gurka::map map;
+  static void SetUpTestSuite() {
+    map = gurka::buildtiles(gurka::detail::map_to_coordinates(ascii_map, 100), ways, {}, {},
+                            "test/data/pbf_api");
+  }
+};
+gurka::map PbfApi::map = {};
+
+} // namespace
+
+TEST_F(PbfApi, Route) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  tyr::actor_t actor(map.config, *reader, true);
+  const auto request = R"({"costing":"auto","locations":[)" + location(map, "A") + "," +
+                       location(map, "F") + "]";
+  Api json_api;
+  actor.route(request + "}", nullptr, &json_api);
+
+  // the response is the api with the trip and the directions
+  Api pbf_api;
+  ASSERT_TRUE(pbf_api.ParseFromString(actor.route(request + R"(,"format":"pbf"})")));
+  EXPECT_EQ(pbf_api.options().format(), Options::pbf);
+  ASSERT_EQ(pbf_api.trip().routes_size(), 1);
+  ASSERT_EQ(pbf_api.directions().routes_size(), 1);
+  EXPECT_EQ(pbf_api.directions().routes(0).legs(0).shape(),
+            json_api.directions().routes(0).legs(0).shape());
+  EXPECT_EQ(pbf_api.directions().routes(0).legs(0).summary().time(),
+            json_api.directions().routes(0).legs(0).summary().time());
+}
+
+TEST_F(PbfApi, Matrix) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  tyr::actor_t actor(map.config, *reader, true);
+  const auto request = R"({"costing":"auto","sources":[)" + location(map, "A") + "," +
+                       location(map, "F") + R"(],"targets":[)" + location(map, "C") + "," +
+                       location(map, "D") + "," + location(map, "E") + "]";
+  rapidjson::Document json;
+  json.Parse(actor.matrix(request + "}"));
+  ASSERT_FALSE(json.HasParseError());
+
+  // the pairs are row ordered just like the json is
+  Api pbf_api;
+  ASSERT_TRUE(pbf_api.ParseFromString(actor.matrix(request + R"(,"format":"pbf"})")));
+  const auto& matrix = pbf_api.matrix();
+  ASSERT_EQ(matrix.times_size(), 6);
+  ASSERT_EQ(matrix.distances_size(), 6);
+  EXPECT_EQ(matrix.unreachable_size(), 0);
+  EXPECT_EQ(matrix.algorithm(), json["algorithm"].GetString());
+  EXPECT_EQ(pbf_api.options().sources_size(), 2);
+  EXPECT_EQ(pbf_api.options().targets_size(), 3);
+  const auto& rows = json["sources_to_targets"];
+  for (int source = 0; source < 2; ++source) {
+    for (int target = 0; target < 3; ++target) {
+      const auto& pair = rows[source][target];
+      EXPECT_EQ(matrix.times(source * 3 + target), pair["time"].GetUint64());
+      EXPECT_NEAR(matrix.distances(source * 3 + target), pair["distance"].GetDouble(), .001);
+    }
+  }
+}
+
+TEST_F(PbfApi, Isochrone) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  tyr::actor_t actor(map.config, *reader, true);
+  const auto request = R"({"costing":"auto","polygons":true,"contours":[{"time":1,)"
+                       R"("color":"ff0000"}],"locations":[)" +
+                       location(map, "B") + "]";
+  rapidjson::Document json;
+  json.Parse(actor.isochrone(request + "}"));
+  ASSERT_FALSE(json.HasParseError());
+
+  Api pbf_api;
+  ASSERT_TRUE(pbf_api.ParseFromString(actor.isochrone(request + R"(,"format":"pbf"})")));
+  const auto& isochrone = pbf_api.isochrone();
+  EXPECT_TRUE(isochrone.polygons());
+  ASSERT_EQ(isochrone.contours_size(), 1);
+  const auto& contour = isochrone.contours(0);
+  EXPECT_EQ(contour.metric(), "time");
+  EXPECT_EQ(contour.value(), 1.f);
+  EXPECT_EQ(contour.color(), "ff0000");
+  ASSERT_GT(contour.features_size(), 0);
+
+  // decoding the deltas gives back the same rings the geojson has
+  const auto& rings = json["features"][0]["geometry"]["coordinates"];
+  const auto& geometries = contour.features(0).geometries();
+  ASSERT_EQ(geometries.size(), rings.Size());
+  for (int i = 0; i < geometries.size(); ++i) {
+    const auto& coords = geometries.Get(i).coords();
+    ASSERT_EQ(coords.size(), rings[i].Size() * 2);
+    int32_t lng = 0, lat = 0;
+    for (int j = 0; j < coords.size(); j += 2) {
+      lng += coords.Get(j);
+      lat += coords.Get(j + 1);
+      EXPECT_NEAR(lng * 1e-6, rings[i][j / 2][0].GetDouble(), 1e-6);
+      EXPECT_NEAR(lat * 1e-6, rings[i][j / 2][1].GetDouble(), 1e-6);
+    }
+  }
+}
+
+TEST_F(PbfApi, OnlyForActionsWithAnApiResponse) {
+  // the other actions keep answering in json
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  tyr::actor_t actor(map.config, *reader, true);
+  rapidjson::Document json;
+  json.Parse(actor.locate(R"({"costing":"auto","format":"pbf","locations":[)" +
+                          location(map, "A") + "]}"));
+  EXPECT_FALSE(json.HasParseError());
+}
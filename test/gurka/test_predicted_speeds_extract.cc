@@ -0,0 +1,130 @@
+#include "gurka.h"
+#include "test.h"
+
+#include <functional>
+#include <gtest/gtest.h>
+#include <microtar.h>
+
+using namespace valhalla;
+using namespace valhalla::baldr;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C
+         |
+         D
+)";
+
+const gurka::ways ways = {
+    {"AB", {{"highway", "primary"}}},
+    {"BC", {{"highway", "primary"}}},
+    {"BD", {{"highway", "residential"}}},
+};
+
+// A profile with the same speed all week
+std::array<int16_t, kCoefficientCount> constant_profile(float kph) {
+  std::vector<float> speeds(kBucketsPerWeek, kph);
+  return compress_speed_buckets(speeds.data());
+}
+
+// Writes the extract with a sidecar for each tile holding the profiles it is given for the tile
+void write_extract(const gurka::map& map,
+                   const std::string& path,
+                   const std::function<speed_profiles_t(const GraphTile&)>& profiles_of) {
+  mtar_t tar;
+  ASSERT_EQ(mtar_open(&tar, path.c_str(), "w"), MTAR_ESUCCESS);
+  GraphReader reader(map.config.get_child("mjolnir"));
+  for (const auto& tile_id : reader.GetTileSet()) {
+    auto tile = reader.GetGraphTile(tile_id);
+    auto sidecar = serialize_predicted_speed_tile(tile_id, tile->header()->directededgecount(),
+                                                  profiles_of(*tile));
+    auto name = GraphTile::FileSuffix(tile_id);
+    ASSERT_EQ(mtar_write_file_header(&tar, name.c_str(), sidecar.size()), MTAR_ESUCCESS);
+    ASSERT_EQ(mtar_write_data(&tar, sidecar.data(), sidecar.size()), MTAR_ESUCCESS);
+  }
+  mtar_finalize(&tar);
+  mtar_close(&tar);
+}
+
+} // namespace
+
+TEST(PredictedSpeedsExtract, SpeedsComeFromTheSidecar) {
+  const std::string tile_dir = "test/data/predicted_speeds_extract";
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, tile_dir);
+
+  // only the edge from A to B gets a profile
+  auto AB = gurka::findEdgeByNodes(*test::make_clean_graphreader(map.config.get_child("mjolnir")),
+                                   layout, "A", "B");
+  const auto edge_id = std::get<0>(AB);
+  write_extract(map, tile_dir + "/predicted.tar", [&edge_id](const GraphTile& tile) {
+    speed_profiles_t profiles;
+    if (tile.id() == edge_id.Tile_Base()) {
+      profiles.emplace(edge_id.id(), constant_profile(42));
+    }
+    return profiles;
+  });
+
+  // without the extract the tiles have no predicted speeds at all
+  auto plain = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  auto tile = plain->GetGraphTile(edge_id);
+  EXPECT_FALSE(tile->HasPredictedSpeed(tile->directededge(edge_id)));
+
+  map.config.put("mjolnir.predicted_speeds_extract", tile_dir + "/predicted.tar");
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  tile = reader->GetGraphTile(edge_id);
+  const auto* edge = tile->directededge(edge_id);
+  ASSERT_TRUE(tile->HasPredictedSpeed(edge));
+  uint8_t sources;
+  for (uint32_t seconds : {0u, 3600u, 3 * midgard::kSecondsPerDay + 12345u}) {
+    EXPECT_NEAR(tile->GetSpeed(edge, kPredictedFlowMask, seconds, false, &sources), 42, 1);
+    EXPECT_EQ(sources, kPredictedFlowMask);
+  }
+
+  // the other edges have no profile
+  for (uint32_t i = 0; i < tile->header()->directededgecount(); ++i) {
+    if (i != edge_id.id()) {
+      EXPECT_FALSE(tile->HasPredictedSpeed(tile->directededge(i)));
+      tile->GetSpeed(tile->directededge(i), kPredictedFlowMask, 3600, false, &sources);
+      EXPECT_FALSE(sources & kPredictedFlowMask);
+    }
+  }
+}
+
+TEST(PredictedSpeedsExtract, MismatchedSidecarIsIgnored) {
+  const std::string tile_dir = "test/data/predicted_speeds_extract_mismatch";
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, tile_dir);
+
+  // a sidecar built for a tile with one edge less
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  auto tile = reader->GetGraphTile(*reader->GetTileSet().begin());
+  speed_profiles_t profiles{{0, constant_profile(42)}};
+  struct memory_t : GraphMemory {
+    explicit memory_t(std::string bytes) : bytes(std::move(bytes)) {
+      data = &this->bytes[0];
+      size = this->bytes.size();
+    }
+    std::string bytes;
+  };
+  auto sidecar = serialize_predicted_speed_tile(tile->id(), tile->header()->directededgecount() - 1,
+                                                profiles);
+  EXPECT_FALSE(tile->BindPredictedSpeeds(std::make_unique<memory_t>(sidecar)));
+  EXPECT_FALSE(tile->HasPredictedSpeed(tile->directededge(0)));
+
+  // or one whose edge points past the end of the profiles
+  sidecar = serialize_predicted_speed_tile(tile->id(), tile->header()->directededgecount(), profiles);
+  auto* offsets = reinterpret_cast<uint32_t*>(&sidecar[sizeof(PredictedSpeedTileHeader)]);
+  offsets[0] = 1;
+  EXPECT_FALSE(tile->BindPredictedSpeeds(std::make_unique<memory_t>(sidecar)));
+  EXPECT_FALSE(tile->HasPredictedSpeed(tile->directededge(0)));
+
+  // while the same sidecar pointing at its profile is fine
+  offsets[0] = 0;
+  EXPECT_TRUE(tile->BindPredictedSpeeds(std::make_unique<memory_t>(sidecar)));
+  EXPECT_TRUE(tile->HasPredictedSpeed(tile->directededge(0)));
+
+  // profiles for edges the tile doesnt have cant be serialized at all
+  EXPECT_THROW(serialize_predicted_speed_tile(tile->id(), 0, profiles), std::runtime_error);
+}
@@ -141,6 +141,32 @@ TEST_F(TestReach, ReachWithNoClosures) {
   EXPECT_EQ(reach.outbound, 9);
 }
 
+TEST_F(TestReach, ExactReachOnlyExpandsTheAskedDirections) {
+  // exposes the exact expansion which is only used when the conservative one falls short
+  struct ExactReach : public loki::Reach {
+    using loki::Reach::exact;
+  };
+
+  sif::CostFactory factory;
+  CostingOptions co;
+  co.set_costing(valhalla::auto_);
+  co.set_flow_mask(kDefaultFlowMask);
+  co.set_filter_closures(false);
+  auto costing = factory.Create(co);
+  auto edge = gurka::findEdgeByNodes(*reader, closure_map.nodes, "A", "B");
+
+  ExactReach reach_checker;
+  auto outbound = reach_checker.exact(std::get<1>(edge), std::get<0>(edge), 50, *reader, costing,
+                                      kOutbound);
+  EXPECT_EQ(outbound.outbound, 9);
+  EXPECT_EQ(outbound.inbound, 0);
+
+  auto inbound = reach_checker.exact(std::get<1>(edge), std::get<0>(edge), 50, *reader, costing,
+                                     kInbound);
+  EXPECT_EQ(inbound.outbound, 0);
+  EXPECT_EQ(inbound.inbound, 9);
+}
+
 TEST_F(TestReach, ReachWithClosures) {
   LiveTrafficCustomize close_edge = [](baldr::GraphReader& reader, baldr::TrafficTile& tile,
                                        uint32_t index, baldr::TrafficSpeed* current) -> void {
@@ -370,6 +370,83 @@ TEST(recosting, throwing) {
   EXPECT_EQ(called, false);
 }
 
+TEST(recosting, many_costings) {
+  const std::string ascii_map = R"(A--1--B-2-3-C
+                                         |
+                                         |
+                                         4
+                                         |
+                                         |
+                                         D--6--E--7--F)";
+  const gurka::ways ways = {
+      {"A1B23C", {{"highway", "residential"}}},
+      {"D6E7F", {{"highway", "residential"}}},
+      {"B4D", {{"highway", "pedestrian"}}},
+  };
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 10);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/gurka_recost", build_config);
+  auto reader = std::make_shared<baldr::GraphReader>(map.config.get_child("mjolnir"));
+
+  // the only path goes through the pedestrian only edge
+  auto api = gurka::do_action(valhalla::Options::route, map, {"A", "F"}, "pedestrian", {}, reader);
+  std::vector<baldr::GraphId> path;
+  for (const auto& node : api.trip().routes(0).legs(0).node()) {
+    if (node.has_edge()) {
+      path.emplace_back(node.edge().id());
+    }
+  }
+  ASSERT_GT(path.size(), 2);
+  auto edge_cb = [&path](size_t& i) {
+    return [&path, &i]() { return i < path.size() ? path[i++] : baldr::GraphId{}; };
+  };
+
+  // the car cannot take this path but the others are evaluated all the way
+  std::vector<sif::cost_ptr_t> costings{sif::CostFactory().Create(Costing::pedestrian),
+                                        sif::CostFactory().Create(Costing::auto_),
+                                        sif::CostFactory().Create(Costing::none_)};
+  std::vector<const sif::DynamicCost*> costing_ptrs;
+  for (const auto& costing : costings) {
+    costing_ptrs.push_back(costing.get());
+  }
+  size_t i = 0;
+  std::vector<std::vector<sif::EdgeLabel>> labels(costings.size());
+  auto recosted =
+      sif::recost_forward(*reader, costing_ptrs, edge_cb(i),
+                          [&labels](size_t costing, const sif::EdgeLabel& label) {
+                            labels[costing].push_back(label);
+                          },
+                          0.25f, 0.75f);
+  EXPECT_EQ(recosted, (std::vector<bool>{true, false, true}));
+  EXPECT_LT(labels[1].size(), path.size());
+
+  // they are the same as recosting the path once for each costing
+  for (size_t c : {0, 2}) {
+    ASSERT_EQ(labels[c].size(), path.size());
+    i = 0;
+    size_t label_index = 0;
+    sif::recost_forward(*reader, *costings[c], edge_cb(i),
+                        [&](const sif::EdgeLabel& label) {
+                          const auto& other = labels[c][label_index++];
+                          EXPECT_EQ(label.edgeid(), other.edgeid());
+                          EXPECT_EQ(label.cost().cost, other.cost().cost);
+                          EXPECT_EQ(label.cost().secs, other.cost().secs);
+                          EXPECT_EQ(label.transition_cost().secs, other.transition_cost().secs);
+                          EXPECT_EQ(label.path_distance(), other.path_distance());
+                        },
+                        0.25f, 0.75f);
+    EXPECT_EQ(label_index, path.size());
+  }
+
+  // the percentages are still checked and an empty path has nothing to recost
+  i = 0;
+  EXPECT_THROW(sif::recost_forward(*reader, costing_ptrs, edge_cb(i),
+                                   [](size_t, const sif::EdgeLabel&) {}, -1.f),
+               std::logic_error);
+  recosted = sif::recost_forward(*reader, costing_ptrs, []() { return baldr::GraphId{}; },
+                                 [](size_t, const sif::EdgeLabel&) { FAIL(); });
+  EXPECT_EQ(recosted, std::vector<bool>(costings.size(), true));
+}
+
 TEST(recosting, error_request) {
   auto config = test::make_config("foo_bar", {});
   auto reader = std::make_shared<baldr::GraphReader>(config.get_child("mjolnir"));
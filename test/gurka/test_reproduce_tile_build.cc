@@ -87,14 +87,18 @@ void assert_tile_equalish(const GraphTile& a, const GraphTile& b) {
 // 1. build tiles with the same input twice
 // 2. check that the same tile sets are generated
 struct ReproducibleBuild : ::testing::Test {
-  void BuildTiles(const std::string& ascii_map, const gurka::ways& ways, const double gridsize) {
-    const auto build_tiles = [&](const std::string& dir) -> gurka::map {
+  void BuildTiles(const std::string& ascii_map,
+                  const gurka::ways& ways,
+                  const double gridsize,
+                  const std::unordered_map<std::string, std::string>& second_options = {}) {
+    const auto build_tiles = [&](const std::string& dir,
+                                 const std::unordered_map<std::string, std::string>& options) {
       const gurka::nodelayout layout = gurka::detail::map_to_coordinates(ascii_map, gridsize);
       const std::string workdir = "test/data/gurka_reproduce_tile_build/" + dir;
-      return gurka::buildtiles(layout, ways, {}, {}, workdir, {});
+      return gurka::buildtiles(layout, ways, {}, {}, workdir, options);
     };
-    const gurka::map first_map = build_tiles("1");
-    const gurka::map second_map = build_tiles("2");
+    const gurka::map first_map = build_tiles("1", {{"mjolnir.parse_concurrency", "1"}});
+    const gurka::map second_map = build_tiles("2", second_options);
 
     baldr::GraphReader first_reader(first_map.config.get_child("mjolnir"));
     baldr::GraphReader second_reader(second_map.config.get_child("mjolnir"));
@@ -155,3 +159,20 @@ TEST_F(ReproducibleBuild, BigGridSize) {
                             {"EH", {{"highway", "path"}}}};
   BuildTiles(ascii_map, ways, 100000);
 }
+
+TEST_F(ReproducibleBuild, ParallelParse) {
+  const std::string ascii_map = R"(
+    A----B----C
+    |    |    |
+    D----E----F
+    |    |    |
+    G----H----I)";
+
+  const gurka::ways ways = {{"ABC", {{"highway", "primary"}}},
+                            {"DEF", {{"highway", "residential"}, {"name", "Main"}}},
+                            {"GHI", {{"highway", "residential"}, {"oneway", "yes"}}},
+                            {"ADG", {{"highway", "secondary"}}},
+                            {"BEH", {{"highway", "residential"}, {"access", "private"}}},
+                            {"CFI", {{"highway", "tertiary"}}}};
+  BuildTiles(ascii_map, ways, 10000, {{"mjolnir.parse_concurrency", "4"}});
+}
@@ -0,0 +1,107 @@
+#include "gurka.h"
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include "loki/worker.h"
+#include "tyr/actor.h"
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C
+         |
+         D
+)";
+
+const gurka::ways ways = {
+    {"ABC", {{"highway", "primary"}}},
+    {"BD", {{"highway", "residential"}}},
+};
+
+std::string location(const gurka::map& map, const std::string& node) {
+  return R"({"lon":)" + std::to_string(map.nodes.at(node).lng()) + R"(,"lat":)" +
+         std::to_string(map.nodes.at(node).lat()) + "}";
+}
+
+// the statistics of a json response by their names
+std::unordered_map<std::string, double> statistics(const std::string& json) {
+  rapidjson::Document response;
+  response.Parse(json);
+  EXPECT_FALSE(response.HasParseError());
+  std::unordered_map<std::string, double> stats;
+  if (response.HasMember("statistics")) {
+    for (const auto& stat : response["statistics"].GetObject()) {
+      stats[stat.name.GetString()] = stat.value.GetDouble();
+    }
+  }
+  return stats;
+}
+
+class RequestStatistics : public ::testing::Test {
+protected:
+  static gurka::map map;
+  static void SetUpTestSuite() {
+    map = gurka::buildtiles(gurka::detail::map_to_coordinates(ascii_map, 100), ways, {}, {},
+                            "test/data/request_statistics");
+  }
+};
+gurka::map RequestStatistics::map = {};
+
+} // namespace
+
+TEST_F(RequestStatistics, Route) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  tyr::actor_t actor(map.config, *reader, true);
+  const auto request = R"({"costing":"auto","locations":[)" + location(map, "A") + "," +
+                       location(map, "D") + "]";
+
+  // each stage of the request is timed
+  auto stats = statistics(actor.route(request + R"(,"verbose":true})"));
+  for (const auto& stage : {"ParseApi", "loki_worker_t::search", "thor_worker_t::search",
+                            "thor::TripLegBuilder", "odin_worker_t::narrate"}) {
+    ASSERT_EQ(stats.count(stage), 1) << stage;
+    EXPECT_GE(stats[stage], 0) << stage;
+  }
+  EXPECT_GT(stats["loki_worker_t::search_edges"], 0);
+  EXPECT_GT(stats["thor_worker_t::search_labels"], 0);
+  EXPECT_GT(stats["thor_worker_t::search_status_tiles"], 0);
+  EXPECT_EQ(stats.count("thor_worker_t::search_queue_resorts"), 1);
+  EXPECT_EQ(stats.count("thor_worker_t::search_up_transitions"), 1);
+  EXPECT_GT(stats["thor_worker_t::route_tile_lookups"], 0);
+
+  // but only verbose responses have them
+  EXPECT_TRUE(statistics(actor.route(request + "}")).empty());
+}
+
+TEST_F(RequestStatistics, Matrix) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  tyr::actor_t actor(map.config, *reader, true);
+  const auto request = R"({"costing":"auto","verbose":true,"sources":[)" + location(map, "A") +
+                       R"(],"targets":[)" + location(map, "C") + "," + location(map, "D") + "]}";
+
+  auto stats = statistics(actor.matrix(request));
+  EXPECT_EQ(stats.count("ParseApi"), 1);
+  EXPECT_EQ(stats.count("loki_worker_t::search"), 1);
+  EXPECT_GT(stats["loki_worker_t::search_edges"], 0);
+}
+
+TEST_F(RequestStatistics, StatusExtractResidency) {
+  loki::loki_worker_t loki_worker(map.config);
+  auto has_residency = [&loki_worker](const std::string& json) {
+    Api request;
+    ParseApi(json, Options::status, request);
+    loki_worker.status(request);
+    for (const auto& stat : request.info().statistics()) {
+      if (stat.name().find("tile_extract_resident_level_") != std::string::npos) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  // the pages of the extract are only walked when the statistics are shown
+  EXPECT_FALSE(has_residency("{}"));
+  EXPECT_TRUE(has_residency(R"({"verbose":true})"));
+}
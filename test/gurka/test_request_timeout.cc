@@ -0,0 +1,81 @@
+#include "gurka.h"
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "tyr/actor.h"
+#include "worker.h"
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C
+    |    |    |
+    D----E----F
+)";
+
+const gurka::ways ways = {
+    {"ABC", {{"highway", "primary"}}},
+    {"DEF", {{"highway", "residential"}}},
+    {"AD", {{"highway", "residential"}}},
+    {"BE", {{"highway", "residential"}}},
+    {"CF", {{"highway", "residential"}}},
+};
+
+// an interrupt that never gives up on its own but makes sure some time passes
+const std::function<void()> slow_interrupt = []() {
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+};
+
+class RequestTimeout : public ::testing::Test {
+protected:
+  static gurka::map map;
+  static void SetUpTestSuite() {
+    map = gurka::buildtiles(gurka::detail::map_to_coordinates(ascii_map, 100), ways, {}, {},
+                            "test/data/request_timeout");
+  }
+
+  std::string request(const std::string& extra = "") {
+    return R"({"costing":"auto",)" + extra + R"("locations":[{"lon":)" +
+           std::to_string(map.nodes.at("A").lng()) + R"(,"lat":)" +
+           std::to_string(map.nodes.at("A").lat()) + R"(},{"lon":)" +
+           std::to_string(map.nodes.at("F").lng()) + R"(,"lat":)" +
+           std::to_string(map.nodes.at("F").lat()) + "}]}";
+  }
+
+  static unsigned error_code(tyr::actor_t& actor, const std::string& request) {
+    try {
+      actor.route(request, &slow_interrupt);
+    } catch (const valhalla_exception_t& e) { return e.code; }
+    return 0;
+  }
+};
+gurka::map RequestTimeout::map = {};
+
+} // namespace
+
+TEST_F(RequestTimeout, NoTimeoutNoLimit) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  tyr::actor_t actor(map.config, *reader, true);
+  EXPECT_EQ(error_code(actor, request()), 0);
+}
+
+TEST_F(RequestTimeout, RequestAsksForTimeout) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  tyr::actor_t actor(map.config, *reader, true);
+  EXPECT_EQ(error_code(actor, request(R"("timeout":1,)")), 104);
+  EXPECT_EQ(error_code(actor, request(R"("timeout":60000,)")), 0);
+}
+
+TEST_F(RequestTimeout, ServiceLimitCapsTimeout) {
+  auto config = map.config;
+  config.put("service_limits.request_timeout", 1);
+  auto reader = test::make_clean_graphreader(config.get_child("mjolnir"));
+  tyr::actor_t actor(config, *reader, true);
+  EXPECT_EQ(error_code(actor, request()), 104);
+  EXPECT_EQ(error_code(actor, request(R"("timeout":60000,)")), 104);
+}
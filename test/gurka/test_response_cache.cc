@@ -0,0 +1,163 @@
+#include "gurka.h"
+#include "proto/incidents.pb.h"
+#include "test.h"
+#include "tyr/actor.h"
+#include "worker.h"
+
+#include <boost/format.hpp>
+#include <cmath>
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C
+         |    |
+         D----E)";
+
+const gurka::ways ways = {{"AB", {{"highway", "primary"}, {"maxspeed", "10"}}},
+                          {"BC", {{"highway", "primary"}, {"maxspeed", "10"}}},
+                          {"BD", {{"highway", "primary"}, {"maxspeed", "10"}}},
+                          {"CE", {{"highway", "primary"}, {"maxspeed", "10"}}},
+                          {"DE", {{"highway", "primary"}, {"maxspeed", "10"}}}};
+
+gurka::map make_map(const std::string& tile_dir, bool cached) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, tile_dir,
+                               {{"mjolnir.traffic_extract", tile_dir + "/traffic.tar"}});
+  if (cached) {
+    map.config.put("httpd.service.response_cache_size", 16);
+  }
+  test::build_live_traffic_data(map.config);
+  return map;
+}
+
+// the cache tells coordinates apart by 5 decimals, nudging one which is already rounded to them by
+// less than half of the last one doesnt change which request it is
+double rounded(double coordinate) {
+  return std::round(coordinate * 1e5) / 1e5;
+}
+
+// a route from A to C where A is moved north by the nudge in degrees
+std::string route_request(const gurka::map& map, double nudge) {
+  const auto& a = map.nodes.at("A");
+  const auto& c = map.nodes.at("C");
+  return (boost::format(R"({"locations":[{"lat":%.7f,"lon":%.7f},{"lat":%.7f,"lon":%.7f}],)"
+                        R"("costing":"auto"})") %
+          (rounded(a.lat()) + nudge) % a.lng() % c.lat() % c.lng())
+      .str();
+}
+
+double route_time(const std::string& json) {
+  rapidjson::Document response;
+  response.Parse(json.c_str());
+  return rapidjson::Pointer("/trip/summary/time").Get(response)->GetDouble();
+}
+
+} // namespace
+
+TEST(ResponseCache, RoundedCoordinatesHitTheCache) {
+  // without the cache a slightly different location comes back as it was asked for
+  auto uncached_map = make_map("test/data/response_cache_uncached", false);
+  tyr::actor_t uncached(uncached_map.config);
+  EXPECT_NE(uncached.route(route_request(uncached_map, 0)),
+            uncached.route(route_request(uncached_map, 2e-6)));
+
+  // with it the difference is rounded away and the first response is handed back
+  auto map = make_map("test/data/response_cache_rounding", true);
+  tyr::actor_t actor(map.config);
+  const auto response = actor.route(route_request(map, 0));
+  EXPECT_EQ(actor.route(route_request(map, 2e-6)), response);
+  EXPECT_NE(actor.route(route_request(map, 1e-4)), response);
+
+  // the caller wanting the whole request back gets it worked out again
+  Api api;
+  EXPECT_NE(actor.route(route_request(map, 2e-6), nullptr, &api), response);
+  EXPECT_TRUE(api.trip().routes_size());
+}
+
+TEST(ResponseCache, MatrixHitsTheCache) {
+  auto map = make_map("test/data/response_cache_matrix", true);
+  tyr::actor_t actor(map.config);
+  auto request = [&map](double nudge) {
+    const auto& a = map.nodes.at("A");
+    const auto& e = map.nodes.at("E");
+    return (boost::format(R"({"sources":[{"lat":%.7f,"lon":%.7f}],)"
+                          R"("targets":[{"lat":%.7f,"lon":%.7f}],"costing":"auto"})") %
+            (rounded(a.lat()) + nudge) % a.lng() % e.lat() % e.lng())
+        .str();
+  };
+  const auto response = actor.matrix(request(0));
+  EXPECT_EQ(actor.matrix(request(2e-6)), response);
+  EXPECT_NE(actor.matrix(request(1e-4)), response);
+}
+
+TEST(ResponseCache, TrafficUpdatesInvalidate) {
+  auto map = make_map("test/data/response_cache_traffic", true);
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  tyr::actor_t actor(map.config, *reader);
+  const auto request = route_request(map, 0);
+  const auto before = actor.route(request);
+
+  // every edge slows down to 4 km/h and the tiles get a new generation like the updater gives them
+  test::customize_live_traffic_data(map.config, [](baldr::GraphReader&, baldr::TrafficTile& tile,
+                                                   int index, baldr::TrafficSpeed* current) {
+    current->breakpoint1 = 255;
+    current->overall_encoded_speed = 4 >> 1;
+    current->encoded_speed1 = 4 >> 1;
+    if (index == 0) {
+      tile.header->generation = tile.header->generation + 2;
+    }
+  });
+  const auto after = actor.route(request);
+  EXPECT_NE(after, before);
+  EXPECT_GT(route_time(after), route_time(before));
+
+  // and the new response is cached in turn
+  EXPECT_EQ(actor.route(request), after);
+}
+
+TEST(ResponseCache, TimeDependentKeys) {
+  response_cache_t cache(16, 0, 5);
+  Api request;
+  auto& options = *request.mutable_options();
+  options.set_action(Options::route);
+  options.set_format(Options::json);
+  options.add_locations()->mutable_ll()->set_lat(1);
+  options.add_locations()->mutable_ll()->set_lat(2);
+  EXPECT_FALSE(cache.key(request).empty());
+
+  // a fixed time is cached with the time in the key
+  options.set_date_time_type(Options::depart_at);
+  options.set_date_time("2021-06-01T08:00");
+  const auto fixed = cache.key(request);
+  EXPECT_FALSE(fixed.empty());
+  options.set_date_time("2021-06-01T09:00");
+  EXPECT_NE(cache.key(request), fixed);
+
+  // but now is never the same
+  options.set_date_time_type(Options::current);
+  EXPECT_TRUE(cache.key(request).empty());
+  options.set_date_time_type(Options::depart_at);
+  options.mutable_locations(1)->set_date_time("current");
+  EXPECT_TRUE(cache.key(request).empty());
+}
+
+TEST(ResponseCache, IncidentsGenerations) {
+  const uint64_t tile = baldr::GraphId(3196, 0, 0);
+  EXPECT_EQ(response_cache_t::incidents_generation(tile, nullptr), 0);
+
+  auto incidents = std::make_shared<const IncidentsTile>();
+  const auto generation = response_cache_t::incidents_generation(tile, incidents);
+  EXPECT_NE(generation, 0);
+  EXPECT_EQ(response_cache_t::incidents_generation(tile, incidents), generation);
+
+  // a new tile is another generation even if it gets the memory of the old one
+  incidents.reset();
+  for (int i = 0; i < 4; ++i) {
+    auto updated = std::make_shared<const IncidentsTile>();
+    EXPECT_NE(response_cache_t::incidents_generation(tile, updated), generation);
+  }
+}
@@ -433,6 +433,33 @@ TEST_F(AlgorithmTest, Bidir) {
   }
 }
 
+// with bidirectional_timedep only the trivial time dependent routes use a unidirectional search
+TEST_F(AlgorithmTest, BidirTimeDependent) {
+  auto bidir_map = map;
+  bidir_map.config.put("thor.bidirectional_timedep", true);
+
+  for (const auto* type : {"1", "2"}) {
+    auto api = gurka::do_action(valhalla::Options::route, bidir_map, {"4", "0"}, "auto",
+                                {{"/date_time/type", type},
+                                 {"/date_time/value", "2020-10-30T09:00"},
+                                 {"/costing_options/auto/speed_types/0", "predicted"}});
+    EXPECT_EQ(api.trip().routes(0).legs(0).algorithms(0), "bidirectional_a*");
+    EXPECT_EQ(speed_from_edge(api), historical) << "date_time type " << type;
+  }
+
+  {
+    auto api = gurka::do_action(valhalla::Options::route, bidir_map, {"8", "A"}, "auto",
+                                {{"/date_time/type", "1"}, {"/date_time/value", "2020-10-30T09:00"}});
+    EXPECT_EQ(api.trip().routes(0).legs(0).algorithms(0), "time_dependent_forward_a*");
+  }
+
+  {
+    auto api = gurka::do_action(valhalla::Options::route, bidir_map, {"9", "7"}, "auto",
+                                {{"/date_time/type", "2"}, {"/date_time/value", "2020-10-30T09:00"}});
+    EXPECT_EQ(api.trip().routes(0).legs(0).algorithms(0), "time_dependent_reverse_a*");
+  }
+}
+
 /*************************************************************/
 TEST(Standalone, LegWeightRegression) {
 
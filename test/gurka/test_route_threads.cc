@@ -0,0 +1,66 @@
+#include "gurka.h"
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C----D
+    |    |    |    |
+    E----F----G----H
+    |    |    |    |
+    I----J----K----L
+)";
+
+const gurka::ways ways = {
+    {"AB", {{"highway", "primary"}}},     {"BC", {{"highway", "primary"}}},
+    {"CD", {{"highway", "primary"}}},     {"EF", {{"highway", "residential"}}},
+    {"FG", {{"highway", "residential"}}}, {"GH", {{"highway", "residential"}}},
+    {"IJ", {{"highway", "secondary"}}},   {"JK", {{"highway", "secondary"}}},
+    {"KL", {{"highway", "secondary"}}},   {"AE", {{"highway", "residential"}}},
+    {"EI", {{"highway", "residential"}}}, {"BF", {{"highway", "residential"}}},
+    {"FJ", {{"highway", "residential"}}}, {"CG", {{"highway", "residential"}}},
+    {"GK", {{"highway", "residential"}}}, {"DH", {{"highway", "residential"}}},
+    {"HL", {{"highway", "residential"}}},
+};
+
+// The legs of the route as the names of their edges and the algorithms which found them
+std::vector<std::string> legs(const valhalla::Api& result) {
+  std::vector<std::string> legs;
+  for (const auto& leg : result.trip().routes(0).legs()) {
+    std::string names;
+    for (const auto& node : leg.node()) {
+      if (node.has_edge()) {
+        names += node.edge().name(0).value() + " ";
+      }
+    }
+    for (const auto& algorithm : leg.algorithms()) {
+      names += algorithm + " ";
+    }
+    legs.push_back(names);
+  }
+  return legs;
+}
+
+} // namespace
+
+TEST(RouteThreads, SameLegsAsOneThread) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/route_threads");
+  auto threaded = map;
+  threaded.config.put("thor.route_threads", 3);
+
+  const std::vector<std::string> waypoints{"A", "L", "E", "D", "J", "C", "I"};
+  for (const auto& stop_type : {"break", "through", "via"}) {
+    for (const auto& costing : {"auto", "pedestrian", "bicycle"}) {
+      auto expected = gurka::do_action(valhalla::Options::route, map, waypoints, costing, {}, {},
+                                       nullptr, stop_type);
+      auto result = gurka::do_action(valhalla::Options::route, threaded, waypoints, costing, {},
+                                     {}, nullptr, stop_type);
+      EXPECT_EQ(legs(result), legs(expected)) << stop_type << " " << costing;
+      EXPECT_EQ(result.trip().routes(0).legs_size(),
+                stop_type == std::string("break") ? waypoints.size() - 1 : 1);
+    }
+  }
+}
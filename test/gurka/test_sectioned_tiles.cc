@@ -0,0 +1,160 @@
+#include "gurka.h"
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C----D
+    |    |    |
+    E----F----G----H
+)";
+
+const gurka::ways ways = {
+    {"AB", {{"highway", "primary"}, {"name", "Alpha"}}},
+    {"BC", {{"highway", "primary"}, {"name", "Alpha"}}},
+    {"CD", {{"highway", "primary"}, {"name", "Beta"}}},
+    {"EF", {{"highway", "residential"}, {"name", "Gamma"}}},
+    {"FG", {{"highway", "residential"}, {"name", "Gamma"}}},
+    {"GH", {{"highway", "residential"}, {"name", "Delta"}}},
+    {"AE", {{"highway", "residential"}, {"name", "Epsilon"}}},
+    {"BF", {{"highway", "residential"}, {"name", "Zeta"}}},
+    {"CG", {{"highway", "residential"}, {"name", "Eta"}}},
+};
+
+std::vector<char> read_tile(const std::string& tile_dir, const baldr::GraphId& tile_id) {
+  std::ifstream file(tile_dir + filesystem::path::preferred_separator +
+                         baldr::GraphTile::FileSuffix(tile_id),
+                     std::ios::in | std::ios::binary | std::ios::ate);
+  std::vector<char> data(file.tellg());
+  file.seekg(0, std::ios::beg);
+  file.read(data.data(), data.size());
+  return data;
+}
+
+std::vector<std::string> names(const valhalla::Api& result) {
+  std::vector<std::string> names;
+  for (const auto& node : result.trip().routes(0).legs(0).node()) {
+    if (node.has_edge()) {
+      names.push_back(node.edge().name(0).value());
+    }
+  }
+  return names;
+}
+
+} // namespace
+
+TEST(SectionedTiles, SameTileAfterLazyInflate) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/sectioned_tiles");
+  const auto tile_dir = map.config.get<std::string>("mjolnir.tile_dir");
+
+  baldr::GraphReader reader(map.config.get_child("mjolnir"));
+  for (const auto& tile_id : reader.GetTileSet()) {
+    auto data = read_tile(tile_dir, tile_id);
+    auto sectioned = baldr::GraphTile::CompressSections(data);
+    ASSERT_TRUE(baldr::GraphTile::IsSectioned(sectioned));
+    ASSERT_FALSE(baldr::GraphTile::IsSectioned(data));
+
+    auto plain = baldr::GraphTile::Create(tile_id, std::move(data));
+    auto lazy = baldr::GraphTile::Create(tile_id, std::move(sectioned));
+    ASSERT_TRUE(lazy);
+    ASSERT_EQ(lazy->header()->directededgecount(), plain->header()->directededgecount());
+    ASSERT_EQ(lazy->header()->nodecount(), plain->header()->nodecount());
+
+    for (auto edge_id = tile_id; edge_id.id() < plain->header()->directededgecount(); ++edge_id) {
+      const auto* edge = plain->directededge(edge_id);
+      const auto* lazy_edge = lazy->directededge(edge_id);
+      EXPECT_EQ(lazy_edge->endnode(), edge->endnode());
+      EXPECT_EQ(lazy_edge->length(), edge->length());
+
+      auto info = plain->edgeinfo(edge);
+      auto lazy_info = lazy->edgeinfo(lazy_edge);
+      EXPECT_EQ(lazy_info.wayid(), info.wayid());
+      EXPECT_EQ(lazy_info.encoded_shape(), info.encoded_shape());
+      EXPECT_EQ(lazy_info.GetNames(), info.GetNames());
+    }
+  }
+}
+
+TEST(SectionedTiles, RouteOnSectionedTiles) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/sectioned_tiles_route");
+  const auto tile_dir = map.config.get<std::string>("mjolnir.tile_dir");
+
+  // write every tile as a sectioned tile in a directory of its own
+  auto sectioned_map = map;
+  const auto sectioned_dir = tile_dir + "_sectioned";
+  sectioned_map.config.put("mjolnir.tile_dir", sectioned_dir);
+  baldr::GraphReader reader(map.config.get_child("mjolnir"));
+  for (const auto& tile_id : reader.GetTileSet()) {
+    baldr::GraphTile::SaveTileToFile(baldr::GraphTile::CompressSections(read_tile(tile_dir, tile_id)),
+                                     sectioned_dir + filesystem::path::preferred_separator +
+                                         baldr::GraphTile::FileSuffix(tile_id,
+                                                                      baldr::SUFFIX_SECTIONED));
+  }
+
+  // the tiles are there even though there are only sectioned ones
+  baldr::GraphReader sectioned_reader(sectioned_map.config.get_child("mjolnir"));
+  for (const auto& tile_id : reader.GetTileSet()) {
+    EXPECT_TRUE(sectioned_reader.DoesTileExist(tile_id));
+  }
+
+  auto expected = gurka::do_action(valhalla::Options::route, map, {"A", "H"}, "auto");
+  auto result = gurka::do_action(valhalla::Options::route, sectioned_map, {"A", "H"}, "auto");
+  EXPECT_EQ(names(result), names(expected));
+  EXPECT_FALSE(names(result).empty());
+}
+
+TEST(SectionedTiles, SharedTileDir) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/sectioned_tiles_shared");
+  const auto tile_dir = map.config.get<std::string>("mjolnir.tile_dir");
+
+  // only sectioned tiles to load from
+  const auto sectioned_dir = tile_dir + "_sectioned";
+  const auto shared_dir = tile_dir + "_shared";
+  filesystem::remove_all(sectioned_dir);
+  filesystem::remove_all(shared_dir);
+  baldr::GraphReader plain_reader(map.config.get_child("mjolnir"));
+  const auto tile_ids = plain_reader.GetTileSet();
+  for (const auto& tile_id : tile_ids) {
+    baldr::GraphTile::SaveTileToFile(baldr::GraphTile::CompressSections(read_tile(tile_dir, tile_id)),
+                                     sectioned_dir + filesystem::path::preferred_separator +
+                                         baldr::GraphTile::FileSuffix(tile_id,
+                                                                      baldr::SUFFIX_SECTIONED));
+  }
+
+  auto config = map.config.get_child("mjolnir");
+  config.put("tile_dir", sectioned_dir);
+  config.put("shared_tile_dir", shared_dir);
+  auto check_names = [&](baldr::GraphReader& reader) {
+    for (const auto& tile_id : tile_ids) {
+      auto plain = plain_reader.GetGraphTile(tile_id);
+      auto shared = reader.GetGraphTile(tile_id);
+      ASSERT_TRUE(shared);
+      for (auto edge_id = tile_id; edge_id.id() < plain->header()->directededgecount(); ++edge_id) {
+        EXPECT_EQ(shared->edgeinfo(shared->directededge(edge_id)).GetNames(),
+                  plain->edgeinfo(plain->directededge(edge_id)).GetNames());
+      }
+    }
+  };
+
+  // the reader loading the sectioned tiles publishes them with their names
+  {
+    baldr::GraphReader reader(config);
+    check_names(reader);
+    for (const auto& tile_id : tile_ids) {
+      EXPECT_TRUE(filesystem::exists(shared_dir + filesystem::path::preferred_separator +
+                                     baldr::GraphTile::FileSuffix(tile_id)));
+    }
+  }
+
+  // and the others map them with their names too
+  filesystem::remove_all(sectioned_dir);
+  baldr::GraphReader reader(config);
+  check_names(reader);
+}
@@ -0,0 +1,79 @@
+#include "gurka.h"
+#include <gtest/gtest.h>
+
+#include "baldr/segmentindex.h"
+#include "loki/search.h"
+#include "mjolnir/segmentindexbuilder.h"
+#include "sif/costfactory.h"
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C----D----E
+    |    |    |    |    |
+    F----G----H----I----J
+    |    |    |    |    |
+    K----L----M----N----O
+
+    P----Q
+)";
+
+const gurka::ways ways = {
+    {"ABCDE", {{"highway", "primary"}}},     {"FGHIJ", {{"highway", "residential"}}},
+    {"KLMNO", {{"highway", "residential"}}}, {"AFK", {{"highway", "residential"}}},
+    {"BGL", {{"highway", "footway"}}},       {"CHM", {{"highway", "residential"}}},
+    {"DIN", {{"highway", "residential"}}},   {"EJO", {{"highway", "residential"}, {"oneway", "yes"}}},
+    {"PQ", {{"highway", "residential"}}},
+};
+
+std::string to_string(const baldr::PathLocation& location) {
+  std::vector<std::string> edges;
+  for (const auto& edge : location.edges) {
+    edges.push_back(std::to_string(edge.id.value) + " " + std::to_string(edge.percent_along) + " " +
+                    std::to_string(edge.distance));
+  }
+  std::sort(edges.begin(), edges.end());
+  std::string result;
+  for (const auto& edge : edges) {
+    result += edge + "\n";
+  }
+  return result;
+}
+
+} // namespace
+
+TEST(SegmentIndex, SameCandidatesWithTheIndex) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 50);
+  const std::string workdir = "test/data/segment_index";
+  auto map = gurka::buildtiles(layout, ways, {}, {}, workdir,
+                               {{"mjolnir.segment_index", workdir + "/segment_index.bin"}});
+  mjolnir::SegmentIndexBuilder::Build(map.config);
+  baldr::SegmentIndex index(map.config.get<std::string>("mjolnir.segment_index"));
+  ASSERT_GT(index.edge_count(), 0);
+
+  baldr::GraphReader reader(map.config.get_child("mjolnir"));
+  auto costing = sif::CostFactory().Create(Costing::auto_);
+
+  // around the nodes, between them and off the side of the roads
+  std::vector<baldr::Location> locations;
+  for (const auto& node : layout) {
+    for (const auto& offset : std::vector<std::pair<double, double>>{{0, 0},
+                                                                     {0.0001, 0.00005},
+                                                                     {-0.0002, 0.0001},
+                                                                     {0.00015, -0.0003}}) {
+      baldr::Location location({node.second.lng() + offset.first, node.second.lat() + offset.second});
+      location.radius_ = 30;
+      locations.push_back(location);
+    }
+  }
+  auto expected = loki::Search(locations, reader, costing);
+  auto results = loki::Search(locations, reader, costing, nullptr, 0, nullptr, &index);
+  ASSERT_EQ(results.size(), expected.size());
+  for (const auto& location : locations) {
+    ASSERT_NE(results.find(location), results.cend());
+    EXPECT_EQ(to_string(results.find(location)->second), to_string(expected.find(location)->second))
+        << location.latlng_.lng() << "," << location.latlng_.lat();
+  }
+}
@@ -105,6 +105,46 @@ TEST(TimeTracking, make) {
   }
 }
 
+TEST(TimeTracking, make_many) {
+  const std::string ascii_map = R"(A----B)";
+  const gurka::ways ways = {{"AB", {{"highway", "trunk"}}}};
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/gurka_time_tracking_make_many",
+                               {{"mjolnir.timezone", "/path/to/timezone.sqlite"}});
+  baldr::GraphReader reader(map.config.get_child("mjolnir"));
+
+  auto costing = sif::CostFactory().Create(Costing::none_);
+  auto found = loki::Search({baldr::Location(map.nodes.begin()->second)}, reader, costing);
+  Location location;
+  baldr::PathLocation::toPBF(found.begin()->second, &location, reader);
+
+  google::protobuf::RepeatedPtrField<Location> locations;
+  for (const auto* date_time : {"2020-04-01T12:34", "", "current", "2020-04-01T12:34", "current",
+                                "2020-04-02T12:34"}) {
+    auto* added = locations.Add();
+    added->CopyFrom(location);
+    if (*date_time)
+      added->set_date_time(date_time);
+  }
+
+  // every location gets what it would have on its own, apart from the current ones which could
+  // be made in another minute
+  auto infos = baldr::TimeInfo::make(locations, reader);
+  ASSERT_EQ(infos.size(), locations.size());
+  for (int i : {0, 1, 3, 5}) {
+    auto copy = locations.Get(i);
+    ASSERT_EQ(infos[i], baldr::TimeInfo::make(copy, reader)) << i;
+  }
+  EXPECT_FALSE(infos[1].valid);
+  EXPECT_EQ(infos[0], infos[3]);
+  EXPECT_FALSE(infos[0] == infos[5]);
+
+  // and the current ones are all made concrete with the same time
+  EXPECT_NE(locations.Get(2).date_time(), "current");
+  EXPECT_EQ(locations.Get(2).date_time(), locations.Get(4).date_time());
+  EXPECT_EQ(infos[2], infos[4]);
+}
+
 TEST(TimeTracking, forward) {
   // once without tz cache and once with
   for (auto* cache : std::vector<baldr::DateTime::tz_sys_info_cache_t*>{
@@ -72,3 +72,136 @@ TEST(Standalone, ShoulderAttributes) {
   EXPECT_TRUE(edges[1].HasMember("shoulder"));
   EXPECT_FALSE(edges[1]["shoulder"].GetBool());
 }
+
+TEST(Standalone, BatchSameAsOneAtATime) {
+  const std::string ascii_map = R"(
+    A-1--B--2-C
+    |    |    |
+    3    4    5
+    |    |    |
+    D-6--E--7-F)";
+  const gurka::ways ways = {
+      {"ABC", {{"highway", "primary"}}}, {"DEF", {{"highway", "residential"}}},
+      {"AD", {{"highway", "residential"}}}, {"BE", {{"highway", "residential"}}},
+      {"CF", {{"highway", "residential"}}},
+  };
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/trace_attributes_batch",
+                               {{"thor.trace_threads", "3"}});
+
+  const auto point = [&map](const std::string& name) {
+    return R"({"lon":)" + std::to_string(map.nodes[name].lng()) + R"(,"lat":)" +
+           std::to_string(map.nodes[name].lat()) + "}";
+  };
+  std::vector<std::string> requests;
+  for (const auto& trace : std::vector<std::vector<std::string>>{{"1", "2", "5"},
+                                                                 {"3", "6", "7"},
+                                                                 {"2", "4", "6"},
+                                                                 {"1", "4", "7", "5"},
+                                                                 {"6", "3", "1"}}) {
+    std::string shape;
+    for (const auto& name : trace) {
+      shape += (shape.empty() ? "" : ",") + point(name);
+    }
+    requests.push_back(R"({"costing":"auto","shape_match":"map_snap","shape":[)" + shape + "]}");
+  }
+
+  valhalla::tyr::actor_t actor(map.config, true);
+  std::vector<std::string> expected;
+  for (const auto& request : requests) {
+    expected.push_back(actor.trace_attributes(request));
+  }
+  auto results = actor.trace_batch(requests, Options::trace_attributes);
+  EXPECT_EQ(results, expected);
+
+  // a bad request fails the batch once the others are done
+  requests.push_back(R"({"costing":"auto","shape_match":"map_snap","shape":[]})");
+  EXPECT_THROW(actor.trace_batch(requests, Options::trace_attributes), valhalla_exception_t);
+}
+
+TEST(Standalone, ColumnarSameAsRows) {
+  const std::string ascii_map = R"(
+    A-1--B--2-C
+    |    |    |
+    3    4    5
+    |    |    |
+    D-6--E--7-F)";
+  const gurka::ways ways = {
+      {"ABC", {{"highway", "primary"}, {"name", "Main"}}},
+      {"DEF", {{"highway", "residential"}}},
+      {"AD", {{"highway", "residential"}}},
+      {"BE", {{"highway", "residential"}, {"maxspeed", "30"}}},
+      {"CF", {{"highway", "residential"}}},
+  };
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/trace_attributes_columnar");
+
+  std::string shape;
+  for (const auto& name : {"1", "4", "7", "5"}) {
+    shape += std::string(shape.empty() ? "" : ",") + R"({"lon":)" +
+             std::to_string(map.nodes[name].lng()) + R"(,"lat":)" +
+             std::to_string(map.nodes[name].lat()) + "}";
+  }
+  const std::string request =
+      R"({"costing":"auto","shape_match":"map_snap","shape":[)" + shape + "]";
+
+  valhalla::tyr::actor_t actor(map.config, true);
+  rapidjson::Document rows, columns;
+  rows.Parse(actor.trace_attributes(request + "}").c_str());
+  columns.Parse(actor.trace_attributes(request + R"(,"columnar":true})").c_str());
+  ASSERT_FALSE(rows.HasParseError());
+  ASSERT_FALSE(columns.HasParseError());
+
+  // the numbers are rounded a bit differently by the two writers
+  const auto expect_same = [](const rapidjson::Value& row, const rapidjson::Value& column,
+                              const std::string& what) {
+    if (row.IsNumber()) {
+      ASSERT_TRUE(column.IsNumber()) << what;
+      EXPECT_NEAR(row.GetDouble(), column.GetDouble(), 1e-3) << what;
+    } else {
+      EXPECT_TRUE(row == column) << what;
+    }
+  };
+
+  // every attribute of every edge is at the index of the edge in the array of the attribute
+  const auto& edges = rows["edges"];
+  const auto& edge_columns = columns["edges"];
+  ASSERT_EQ(edge_columns["count"].GetUint64(), edges.Size());
+  ASSERT_GT(edges.Size(), 1);
+  for (rapidjson::SizeType i = 0; i < edges.Size(); ++i) {
+    for (const auto& member : edges[i].GetObject()) {
+      const std::string name = member.name.GetString();
+      if (name == "end_node") {
+        for (const auto& node_member : member.value.GetObject()) {
+          const std::string node_name = node_member.name.GetString();
+          ASSERT_TRUE(edge_columns["end_node"].HasMember(node_name.c_str())) << node_name;
+          expect_same(node_member.value, edge_columns["end_node"][node_name.c_str()][i],
+                      node_name + " " + std::to_string(i));
+        }
+        continue;
+      }
+      ASSERT_TRUE(edge_columns.HasMember(name.c_str())) << name;
+      ASSERT_EQ(edge_columns[name.c_str()].Size(), edges.Size()) << name;
+      expect_same(member.value, edge_columns[name.c_str()][i], name + " " + std::to_string(i));
+    }
+  }
+
+  // and so is every attribute of every matched point
+  const auto& points = rows["matched_points"];
+  const auto& point_columns = columns["matched_points"];
+  for (rapidjson::SizeType i = 0; i < points.Size(); ++i) {
+    for (const auto& member : points[i].GetObject()) {
+      const std::string name = member.name.GetString();
+      ASSERT_TRUE(point_columns.HasMember(name.c_str())) << name;
+      ASSERT_EQ(point_columns[name.c_str()].Size(), points.Size()) << name;
+      expect_same(member.value, point_columns[name.c_str()][i], name + " " + std::to_string(i));
+    }
+  }
+  EXPECT_EQ(std::string(rows["shape"].GetString()), columns["shape"].GetString());
+
+  // the binary answer is the api with the matched path
+  Api api;
+  ASSERT_TRUE(api.ParseFromString(actor.trace_attributes(request + R"(,"format":"pbf"})")));
+  ASSERT_EQ(api.trip().routes_size(), 1);
+  EXPECT_EQ(api.trip().routes(0).legs(0).shape(), rows["shape"].GetString());
+}
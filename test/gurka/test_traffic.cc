@@ -3,10 +3,12 @@
 
 #include "baldr/graphreader.h"
 #include "baldr/traffictile.h"
+#include "mjolnir/trafficupdater.h"
 
 #include <boost/property_tree/ptree.hpp>
 
 #include <cmath>
+#include <fstream>
 #include <sstream>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -1018,3 +1020,57 @@ TEST_F(WaypointsOnClosuresTest, IgnoreDepartPointAtClosure) {
     gurka::assert::raw::expect_path(result, {"BC", "AB"});
   }
 }
+
+TEST(Traffic, UpdaterWritesFeed) {
+  const std::string ascii_map = R"(
+    A----B----C
+         |    |
+         D----E)";
+
+  const gurka::ways ways = {{"AB", {{"highway", "primary"}, {"maxspeed", "10"}}},
+                            {"BC", {{"highway", "primary"}, {"maxspeed", "10"}}},
+                            {"BD", {{"highway", "primary"}, {"maxspeed", "10"}}},
+                            {"CE", {{"highway", "primary"}, {"maxspeed", "10"}}},
+                            {"DE", {{"highway", "primary"}, {"maxspeed", "10"}}}};
+
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  std::string tile_dir = "test/data/traffic_updater";
+  auto map = gurka::buildtiles(layout, ways, {}, {}, tile_dir);
+  map.config.put("mjolnir.traffic_extract", tile_dir + "/traffic.tar");
+  test::build_live_traffic_data(map.config);
+
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  auto BD = gurka::findEdge(*reader, map.nodes, "BD", "D");
+  auto AB = gurka::findEdge(*reader, map.nodes, "AB", "B");
+  auto tile = reader->GetGraphTile(std::get<0>(BD));
+  ASSERT_EQ(tile->get_traffic_tile().generation(), 0);
+  ASSERT_FALSE(tile->trafficspeed(std::get<1>(BD)).speed_valid());
+
+  // close BD, the second record of an edge wins and records of missing tiles are skipped
+  const baldr::TrafficSpeed open{24 >> 1, 24 >> 1, 0, 0, 255, 0, 1, 0, 0, false};
+  const baldr::TrafficSpeed closed{0, 0, 0, 0, 255, 0, baldr::MAX_CONGESTION_VAL, 0, 0, false};
+  std::vector<mjolnir::TrafficRecord> feed{
+      {std::get<0>(BD).value, open},
+      {std::get<0>(AB).value, open},
+      {baldr::GraphId(std::get<0>(BD).tileid() + 1, 2, 0).value, open},
+      {std::get<0>(BD).value, closed},
+  };
+  const std::string feed_file = tile_dir + "/feed.bin";
+  std::ofstream(feed_file, std::ios::binary)
+      .write(reinterpret_cast<const char*>(feed.data()), feed.size() * sizeof(feed.front()));
+
+  mjolnir::TrafficUpdater updater(map.config.get<std::string>("mjolnir.traffic_extract"));
+  auto records = mjolnir::TrafficUpdater::ReadFeed(feed_file);
+  ASSERT_EQ(records.size(), feed.size());
+  EXPECT_EQ(updater.Update(records, 1234), 2);
+
+  // the reader sees the update without being reloaded and can tell the tile changed
+  EXPECT_EQ(tile->get_traffic_tile().generation(), 2);
+  EXPECT_EQ(static_cast<uint64_t>(tile->get_traffic_tile().header->last_update), 1234);
+  EXPECT_TRUE(tile->trafficspeed(std::get<1>(BD)).closed());
+  EXPECT_EQ(tile->trafficspeed(std::get<1>(AB)).get_overall_speed(), 24);
+
+  auto result = gurka::do_action(valhalla::Options::route, map, {"B", "D"}, "auto",
+                                 {{"/date_time/type", "0"}}, reader);
+  gurka::assert::raw::expect_path(result, {"BC", "CE", "DE"});
+}
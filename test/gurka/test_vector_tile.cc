@@ -0,0 +1,165 @@
+#include "gurka.h"
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include "baldr/compression_utils.h"
+#include "proto/vector_tile.pb.h"
+#include "tyr/actor.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C
+    |    |    |
+    D----E----F
+)";
+
+const gurka::ways ways = {
+    {"ABC", {{"highway", "primary"}, {"name", "Main Street"}}},
+    {"DEF", {{"highway", "residential"}}},
+    {"AD", {{"highway", "residential"}}},
+    {"BE", {{"highway", "residential"}}},
+    {"CF", {{"highway", "residential"}}},
+};
+
+std::string gunzip(const std::string& compressed) {
+  std::string inflated;
+  auto src = [&compressed](z_stream& s) {
+    s.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+    s.avail_in = static_cast<unsigned int>(compressed.size());
+  };
+  auto dst = [&inflated](z_stream& s) {
+    auto size = inflated.size();
+    if (s.total_out < size) {
+      inflated.resize(s.total_out);
+    } else {
+      inflated.resize(size + 4096);
+      s.next_out = reinterpret_cast<Bytef*>(&inflated[size]);
+      s.avail_out = 4096;
+    }
+    return Z_NO_FLUSH;
+  };
+  EXPECT_TRUE(baldr::inflate(src, dst));
+  return inflated;
+}
+
+const mvt::Tile::Layer* find_layer(const mvt::Tile& tile, const std::string& name) {
+  for (const auto& layer : tile.layers()) {
+    if (layer.name() == name) {
+      return &layer;
+    }
+  }
+  return nullptr;
+}
+
+// the values of a key over all the features of the layer
+std::vector<mvt::Tile::Value> values(const mvt::Tile::Layer& layer, const std::string& key) {
+  std::vector<mvt::Tile::Value> found;
+  for (const auto& feature : layer.features()) {
+    for (int i = 0; i + 1 < feature.tags_size(); i += 2) {
+      if (layer.keys(feature.tags(i)) == key) {
+        found.push_back(layer.values(feature.tags(i + 1)));
+      }
+    }
+  }
+  return found;
+}
+
+class VectorTile : public ::testing::Test {
+protected:
+  static gurka::map map;
+  static void SetUpTestSuite() {
+    map = gurka::buildtiles(gurka::detail::map_to_coordinates(ascii_map, 100, {5.1, 52.1}), ways,
+                            {}, {}, "test/data/vector_tile", {{"loki.tile_cache_size", "16"}});
+  }
+
+  // the tile at the zoom which the node is in
+  std::string request(const std::string& node, uint32_t z) {
+    const auto& ll = map.nodes.at(node);
+    const double tiles = 1u << z;
+    const double lat = ll.lat() * M_PI / 180.;
+    auto x = static_cast<uint32_t>((ll.lng() + 180.) / 360. * tiles);
+    auto y = static_cast<uint32_t>((1. - std::log(std::tan(lat) + 1. / std::cos(lat)) / M_PI) / 2. *
+                                   tiles);
+    return R"({"tile":{"z":)" + std::to_string(z) + R"(,"x":)" + std::to_string(x) + R"(,"y":)" +
+           std::to_string(y) + "}}";
+  }
+};
+gurka::map VectorTile::map = {};
+
+} // namespace
+
+TEST_F(VectorTile, EdgesAndNodes) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  tyr::actor_t actor(map.config, *reader, true);
+  mvt::Tile tile;
+  ASSERT_TRUE(tile.ParseFromString(gunzip(actor.tile(request("B", 13)))));
+
+  const auto* edges = find_layer(tile, "edges");
+  ASSERT_NE(edges, nullptr);
+  EXPECT_EQ(edges->version(), 2);
+  EXPECT_EQ(edges->extent(), 4096);
+  // both directions of all the edges
+  EXPECT_EQ(edges->features_size(), 14);
+  for (const auto& feature : edges->features()) {
+    EXPECT_EQ(feature.type(), mvt::Tile::LINESTRING);
+    ASSERT_GE(feature.geometry_size(), 6);
+    EXPECT_EQ(feature.geometry(0), 1u | (1u << 3));
+    EXPECT_EQ(feature.geometry(3) & 0x7, 2u);
+  }
+  auto classes = values(*edges, "road_class");
+  ASSERT_EQ(classes.size(), 14);
+  EXPECT_EQ(std::count_if(classes.cbegin(), classes.cend(),
+                          [](const mvt::Tile::Value& v) { return v.string_value() == "primary"; }),
+            4);
+  auto names = values(*edges, "name");
+  ASSERT_EQ(names.size(), 4);
+  for (const auto& name : names) {
+    EXPECT_EQ(name.string_value(), "Main Street");
+  }
+  EXPECT_EQ(values(*edges, "speed").size(), 14);
+  EXPECT_TRUE(values(*edges, "closed").empty());
+
+  const auto* nodes = find_layer(tile, "nodes");
+  ASSERT_NE(nodes, nullptr);
+  // the nodes where the levels meet are on both of them
+  EXPECT_GE(nodes->features_size(), 6);
+  EXPECT_EQ(values(*nodes, "traffic_signal").size(), nodes->features_size());
+  for (const auto& feature : nodes->features()) {
+    EXPECT_EQ(feature.type(), mvt::Tile::POINT);
+    EXPECT_EQ(feature.geometry_size(), 3);
+  }
+}
+
+TEST_F(VectorTile, LocalEdgesOnlyWhenZoomedIn) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  tyr::actor_t actor(map.config, *reader, true);
+  mvt::Tile tile;
+  ASSERT_TRUE(tile.ParseFromString(gunzip(actor.tile(request("B", 11)))));
+  const auto* edges = find_layer(tile, "edges");
+  ASSERT_NE(edges, nullptr);
+  for (const auto& road_class : values(*edges, "road_class")) {
+    EXPECT_EQ(road_class.string_value(), "primary");
+  }
+}
+
+TEST_F(VectorTile, CachedTilesAreTheSame) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  tyr::actor_t actor(map.config, *reader, true);
+  auto first = actor.tile(request("E", 14));
+  EXPECT_EQ(actor.tile(request("E", 14)), first);
+}
+
+TEST_F(VectorTile, BadTiles) {
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  tyr::actor_t actor(map.config, *reader, true);
+  EXPECT_THROW(actor.tile(request("B", 7)), valhalla_exception_t);
+  EXPECT_THROW(actor.tile(R"({"tile":{"z":2,"x":4,"y":0}})"), valhalla_exception_t);
+  EXPECT_THROW(actor.tile(R"({"z":14,"x":"a","y":"1"})"), valhalla_exception_t);
+  EXPECT_THROW(actor.tile("{}"), valhalla_exception_t);
+}
@@ -221,6 +221,72 @@ TEST(HttpTiles, test_graphreader_multiple_threads) {
   test_graphreader_tile_download(8, 2, 4);
 }
 
+TEST(HttpTiles, test_batch_download) {
+  using namespace baldr;
+
+  TestTileDownloadData params;
+  const auto non_existent_tile_id = params.get_nonexistent_tile_id();
+  curl_tile_getter_t tile_getter(1, "", params.is_gzipped_tile);
+
+  // ask for every tile a few times over so some of them are in flight together
+  std::vector<GraphId> tile_ids;
+  std::vector<std::string> tile_uris;
+  for (size_t tile_i = 0; tile_i < 3 * params.test_tile_ids.size(); ++tile_i) {
+    auto test_tile_index = tile_i % params.test_tile_names.size();
+    tile_ids.push_back(params.test_tile_ids[test_tile_index]);
+    tile_uris.push_back(params.tile_url_base + params.test_tile_names[test_tile_index] +
+                        params.request_params);
+  }
+
+  // twice so the second batch goes over the connections the first one left open
+  for (int pass = 0; pass < 2; ++pass) {
+    auto results = tile_getter.get(tile_uris);
+    ASSERT_EQ(results.size(), tile_uris.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+      if (tile_ids[i] == non_existent_tile_id) {
+        EXPECT_EQ(results[i].status_, tile_getter_t::status_code_t::FAILURE);
+        continue;
+      }
+      ASSERT_EQ(results[i].status_, tile_getter_t::status_code_t::SUCCESS);
+      auto tile = GraphTile::Create(GraphId(), std::move(results[i].bytes_));
+      ASSERT_TRUE(tile);
+      EXPECT_EQ(tile->id(), tile_ids[i]);
+    }
+  }
+
+  // and the same when they are turned into tiles
+  auto tiles = GraphTile::CacheTileURLs(params.full_tile_url_pattern, tile_ids, &tile_getter, "");
+  ASSERT_EQ(tiles.size(), tile_ids.size());
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    if (tile_ids[i] == non_existent_tile_id) {
+      EXPECT_FALSE(tiles[i]) << "Expected no tile";
+    } else {
+      ASSERT_TRUE(tiles[i]);
+      EXPECT_EQ(tiles[i]->id(), tile_ids[i]);
+    }
+  }
+}
+
+TEST(HttpTiles, test_batch_interrupt) {
+  using namespace baldr;
+
+  TestTileDownloadData params;
+  curl_tile_getter_t tile_getter(1, "", params.is_gzipped_tile);
+  const curl_tile_getter_t::interrupt_t interrupt = [] { throw std::runtime_error("Interrupt"); };
+  tile_getter.set_interrupt(&interrupt);
+  std::vector<std::string> tile_uris;
+  for (const auto& tile_name : params.test_tile_names) {
+    tile_uris.push_back(params.tile_url_base + tile_name + params.request_params);
+  }
+  EXPECT_THROW(tile_getter.get(tile_uris), std::runtime_error);
+
+  // the curler is still good for the next batch
+  tile_getter.set_interrupt(nullptr);
+  auto results = tile_getter.get(tile_uris);
+  ASSERT_EQ(results.size(), tile_uris.size());
+  EXPECT_EQ(results.front().status_, tile_getter_t::status_code_t::SUCCESS);
+}
+
 TEST(HttpTiles, test_interrupt) {
   using namespace baldr;
 
@@ -74,6 +74,26 @@ TEST_F(incident_loading, read_tile) {
     f << t.SerializeAsString();
   }
   ASSERT_TRUE(testable_singleton::read_tile(filename)) << " should return valid tile";
+
+  // locations out of order get sorted by edge
+  for (uint32_t edge_index : {7, 3, 7, 0}) {
+    loc = t.mutable_locations()->Add();
+    loc->set_edge_index(edge_index);
+    loc->set_metadata_index(edge_index);
+  }
+  {
+    std::ofstream f(filename, std::ofstream::out | std::ofstream::trunc);
+    f << t.SerializeAsString();
+  }
+  auto tile = testable_singleton::read_tile(filename);
+  ASSERT_TRUE(tile) << " should return valid tile";
+  ASSERT_EQ(tile->locations_size(), 5) << " should have all the locations";
+  for (int i = 1; i < tile->locations_size(); ++i) {
+    EXPECT_LE(tile->locations(i - 1).edge_index(), tile->locations(i).edge_index())
+        << " locations should be sorted by edge index";
+    EXPECT_EQ(tile->locations(i).edge_index(), tile->locations(i).metadata_index())
+        << " locations should be kept intact";
+  }
 }
 
 TEST_F(incident_loading, update_tile) {
@@ -232,6 +232,115 @@ TEST(Isochrones, LongEdge) {
   EXPECT_EQ(within(point_type(interpolated.x(), interpolated.y()), polygon), true);
 }
 
+TEST(Isochrones, Cache) {
+  auto cached_config = config;
+  cached_config.put("thor.isochrone_cache_size", 2);
+  loki_worker_t loki_worker(config);
+  thor_worker_t thor_worker(config);
+  thor_worker_t cached_worker(cached_config);
+
+  auto isochrone = [&loki_worker](thor_worker_t& worker, const std::string& request_json) {
+    Api request;
+    ParseApi(request_json, Options::isochrone, request);
+    loki_worker.isochrones(request);
+    auto response = worker.isochrones(request);
+    loki_worker.cleanup();
+    worker.cleanup();
+    return response;
+  };
+
+  // the same request again is served from the cache with the same response
+  const std::string request =
+      R"({"locations":[{"lat":52.078937,"lon":5.115321}],"costing":"bicycle","contours":[{"time":15}]})";
+  const auto expected = isochrone(thor_worker, request);
+  EXPECT_EQ(isochrone(cached_worker, request), expected);
+  EXPECT_EQ(isochrone(cached_worker, request), expected);
+
+  // smaller contours from the same location only trace the cached grid again
+  const std::string smaller =
+      R"({"locations":[{"lat":52.078937,"lon":5.115321}],"costing":"bicycle","contours":[{"time":10}],"polygons":true})";
+  try_isochrone(loki_worker, cached_worker, smaller, isochrone(thor_worker, smaller));
+
+  // another costing is never served from the grid of the first
+  const std::string other =
+      R"({"locations":[{"lat":52.078937,"lon":5.115321}],"costing":"pedestrian","contours":[{"time":15}]})";
+  EXPECT_EQ(isochrone(cached_worker, other), isochrone(thor_worker, other));
+}
+
+TEST(Isochrones, Partition) {
+  const std::string ascii_map = R"(
+      a-b-c-d-e
+    )";
+
+  const gurka::ways ways = {
+      {"abcde", {{"highway", "primary"}}},
+  };
+
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 250);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/isochrones/partition");
+  map.config.put("service_limits.isochrone.max_locations", 2);
+  loki_worker_t loki_worker(map.config);
+  thor_worker_t thor_worker(map.config);
+
+  // the polygons of the response and the location each of them is the part of
+  auto isochrone = [&](bool partition) {
+    const auto& a = map.nodes["a"];
+    const auto& e = map.nodes["e"];
+    const auto request_json =
+        R"({"locations":[{"lat":)" + std::to_string(a.lat()) + R"(,"lon":)" +
+        std::to_string(a.lng()) + R"(},{"lat":)" + std::to_string(e.lat()) + R"(,"lon":)" +
+        std::to_string(e.lng()) + R"(}],"costing":"pedestrian","contours":[{"time":15}],)" +
+        R"("polygons":true,"partition":)" + (partition ? "true" : "false") + "}";
+    Api request;
+    ParseApi(request_json, Options::isochrone, request);
+    loki_worker.isochrones(request);
+    rapidjson::Document response;
+    response.Parse(thor_worker.isochrones(request));
+    loki_worker.cleanup();
+    thor_worker.cleanup();
+
+    std::vector<std::pair<int, polygon_type>> polygons;
+    for (const auto& feature : rp("/features").Get(response)->GetArray()) {
+      polygon_type polygon;
+      for (const auto& coord : feature["geometry"]["coordinates"][0].GetArray()) {
+        boost::geometry::append(polygon.outer(),
+                                point_type(coord[0].GetDouble(), coord[1].GetDouble()));
+      }
+      const auto& properties = feature["properties"];
+      polygons.emplace_back(properties.HasMember("location_index")
+                                ? properties["location_index"].GetInt()
+                                : -1,
+                            polygon);
+    }
+    return polygons;
+  };
+  auto within_polygon = [&map](const std::string& node, const polygon_type& polygon) {
+    return within(point_type(map.nodes[node].lng(), map.nodes[node].lat()), polygon);
+  };
+
+  // both locations reach the middle so together they make one polygon
+  auto united = isochrone(false);
+  ASSERT_EQ(united.size(), 1);
+  EXPECT_EQ(united[0].first, -1);
+  for (const auto& node : {"a", "b", "c", "d", "e"}) {
+    EXPECT_TRUE(within_polygon(node, united[0].second)) << node;
+  }
+
+  // with the partition each of them gets the half closest to it out of the same expansion
+  auto parts = isochrone(true);
+  ASSERT_EQ(parts.size(), 2);
+  EXPECT_EQ(parts[0].first, 0);
+  EXPECT_EQ(parts[1].first, 1);
+  for (const auto& node : {"a", "b"}) {
+    EXPECT_TRUE(within_polygon(node, parts[0].second)) << node;
+    EXPECT_FALSE(within_polygon(node, parts[1].second)) << node;
+  }
+  for (const auto& node : {"d", "e"}) {
+    EXPECT_FALSE(within_polygon(node, parts[0].second)) << node;
+    EXPECT_TRUE(within_polygon(node, parts[1].second)) << node;
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -2,6 +2,7 @@
 #include "baldr/rapidjson_utils.h"
 
 #include <cstdint>
+#include <limits>
 
 #include "test.h"
 
@@ -74,6 +75,36 @@ TEST(JSON, Serialize) {
   EXPECT_EQ(res, ans) << "Wrong json";
 }
 
+TEST(JSON, SerializeToStringMatchesStream) {
+  using namespace std;
+  using namespace valhalla::baldr;
+  auto json = json::map(
+      {{"escaped_string", string("\"\t\r\n\\/\a\x1f\xc3\xa9")},
+       {"max", numeric_limits<uint64_t>::max()},
+       {"min", numeric_limits<int64_t>::min()},
+       {"fixed", json::array({json::fixed_t{40.744377, 3}, json::fixed_t{-0.0004, 3},
+                              json::fixed_t{2.5, 0}, json::fixed_t{1e300, 2},
+                              json::fixed_t{numeric_limits<double>::infinity(), 1}})},
+       {"float", json::array({json::float_t{1. / 3}, json::float_t{1e-20}, json::float_t{100},
+                              json::float_t{numeric_limits<double>::quiet_NaN()}})},
+       {"nested", json::map({{"empty_map", json::map({})},
+                             {"empty_array", json::array({})},
+                             {"null_map", json::MapPtr()},
+                             {"null_array", json::ArrayPtr()}})},
+       {"raw", json::RawJSON{"[1,2,3]"}},
+       {"true", true},
+       {"null", nullptr}});
+
+  stringstream stream;
+  stream << *json;
+  EXPECT_EQ(json::serialize(*json), stream.str());
+
+  auto array = json::array({json, uint64_t(7), string("x")});
+  stream.str("");
+  stream << *array;
+  EXPECT_EQ(json::serialize(*array, 0), stream.str());
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
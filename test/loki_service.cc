@@ -22,6 +22,18 @@ using namespace prime_server;
 
 namespace {
 
+// a route request sent as a protobuf instead of as json
+std::string pbf_route(const std::vector<double>& lats) {
+  Api api;
+  for (auto lat : lats) {
+    auto* ll = api.mutable_options()->add_locations()->mutable_ll();
+    ll->set_lat(lat);
+    ll->set_lng(0);
+  }
+  return api.SerializeAsString();
+}
+const headers_t pbf_headers{{"Content-Type", "application/x-protobuf"}};
+
 const std::vector<http_request_t> valhalla_requests{
     http_request_t(GET, "/status"),
     http_request_t(OPTIONS, "/route"),
@@ -99,6 +111,9 @@ const std::vector<http_request_t> valhalla_requests{
         R"({"shape":[{"lat":37.8077440,"lon":-122.4197010},{"lat":37.8077440,"lon":-122.4197560},{"lat":37.8077450,"lon":-122.4198180}],"shape_match":"map_snap","best_paths":5,"costing":"pedestrian","directions_options":{"units":"miles"}})"),
     http_request_t(POST, "/trace_attributes", R"({"encoded_polyline":
         "mx{ilAdxcupCdJm@v|@rG|n@dEz_AlUng@fMnDlAt}@zTdmAtZvx@`Rr_@~IlUnI`HtDjVnSdOhW|On^|JvXl^dmApGzUjGfYzAtOT~SUdYsFtmAmK~zBkAh`ArAdd@vDng@dEb\\nHvb@bQpp@~IjVbj@ngAjV`q@bL~g@nDjVpVbnBdAfCpeA`yL~CpRnCn]`C~g@l@zUGfx@m@x_AgCxiBe@xl@e@re@yBviCeAvkAe@vaBzArd@jFhb@|ZzgBjEjVzFtZxC`RlEdYz@~I~DxWtTxtA`Gn]fEjV~BzV^dDpBfY\\dZ?fNgDx~BrA~q@xB|^fIp{@lK~|@|T`oBbF|h@re@d_E|EtYvMrdAvCzUxMhaAnStwAnNls@xLjj@tlBr{HxQlt@lEr[jB`\\Gvl@oNjrCaCvm@|@vb@rAl_@~B|]pHvx@j`@lzC|Ez_@~Htn@|DrFzPlhAzFn^zApp@xGziA","shape_match":"map_snap","best_paths":3,"costing":"auto","directions_options":{"units":"miles"}})"),
+    http_request_t(POST, "/route", "{", {}, pbf_headers),
+    http_request_t(POST, "/route", pbf_route({90}), {}, pbf_headers),
+    http_request_t(POST, "/route", pbf_route({-270, 90}), {}, pbf_headers),
 };
 
 const std::vector<std::pair<uint16_t, std::string>> valhalla_responses{
@@ -182,7 +197,13 @@ const std::vector<std::pair<uint16_t, std::string>> valhalla_responses{
     {400,
      R"({"error_code":158,"error":"Input trace option is out of bounds:(5). The best_paths upper limit is 4","status_code":400,"status":"Bad Request"})"},
     {400,
-     R"({"error_code":153,"error":"Too many shape points:(102). The best paths shape limit is 100","status_code":400,"status":"Bad Request"})"}};
+     R"({"error_code":153,"error":"Too many shape points:(102). The best paths shape limit is 100","status_code":400,"status":"Bad Request"})"},
+    {400,
+     R"({"error_code":103,"error":"Failed to parse pbf request","status_code":400,"status":"Bad Request"})"},
+    {400,
+     R"({"error_code":120,"error":"Insufficient number of locations provided","status_code":400,"status":"Bad Request"})"},
+    {400,
+     R"({"error_code":130,"error":"Failed to parse location","status_code":400,"status":"Bad Request"})"}};
 
 const std::vector<http_request_t> osrm_requests{
     http_request_t(GET, R"(/status?json={"format":"osrm"})"),
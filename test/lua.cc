@@ -1,6 +1,8 @@
 #include "test.h"
 
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "mjolnir/graph_lua_proc.h"
 #include "mjolnir/luatagtransform.h"
@@ -103,6 +105,37 @@ TEST(Lua, NumberDoublePeriod) {
   // ... but that the results aren't completely empty
   ASSERT_TRUE(results.size() > 0);
 }
+TEST(Lua, CachedTransform) {
+  // the cache is smaller than the tag sets to check it is emptied when it fills up
+  const std::string script(lua_graph_lua, lua_graph_lua + lua_graph_lua_len);
+  mjolnir::LuaTagTransform lua(script);
+  mjolnir::LuaTagTransform cached(script, 4, {"name", "name:", "ref", "unsigned_ref"});
+
+  const std::vector<std::pair<mjolnir::OSMType, mjolnir::Tags>> elements = {
+      {mjolnir::OSMType::kWay, {{"highway", "primary"}, {"name", "Main Street"}}},
+      {mjolnir::OSMType::kWay, {{"highway", "primary"}, {"name", "Side Street"}}},
+      {mjolnir::OSMType::kWay,
+       {{"highway", "primary"}, {"name", "Main Street"}, {"name:en", "Main Street"}}},
+      // the script copies the unsigned_ref into the ref of a way without any names
+      {mjolnir::OSMType::kWay, {{"highway", "motorway"}, {"unsigned_ref", "A 1"}}},
+      {mjolnir::OSMType::kWay, {{"highway", "motorway"}, {"unsigned_ref", "A 2"}}},
+      {mjolnir::OSMType::kWay, {{"highway", "tertiary"}, {"maxheight", "2.0"}}},
+      {mjolnir::OSMType::kWay, {{"highway", "tertiary"}, {"maxheight", "2.5"}}},
+      // a named node is a named junction
+      {mjolnir::OSMType::kNode, {{"highway", "traffic_signals"}, {"name", "Neude"}}},
+      {mjolnir::OSMType::kNode, {{"highway", "traffic_signals"}}},
+      // a value which looks like a placeholder skips the cache
+      {mjolnir::OSMType::kWay, {{"highway", "primary"}, {"name", "\x01name"}}},
+      {mjolnir::OSMType::kRelation,
+       {{"type", "restriction"}, {"restriction", "no_left_turn"}, {"name", "Turn"}}},
+  };
+  for (int pass = 0; pass < 2; ++pass) {
+    for (const auto& element : elements) {
+      EXPECT_EQ(lua.Transform(element.first, 1, element.second),
+                cached.Transform(element.first, 1, element.second));
+    }
+  }
+}
 } // namespace
 
 // TODO: sweet jesus add more tests of this class!
@@ -60,6 +60,8 @@ TEST(MapmatchConfig, check_read_all_params) {
   const auto& routing = config.routing;
   EXPECT_EQ(routing.interpolation_distance_meters, 5.f);
   EXPECT_FALSE(routing.is_interpolation_distance_customizable);
+  EXPECT_EQ(routing.adaptive_interpolation_distance_meters, 0.f);
+  EXPECT_EQ(routing.adaptive_interpolation_seconds, 5.f);
 }
 
 TEST(MapmatchConfig, validate_candidate_search_params) {
@@ -122,6 +124,14 @@ TEST(MapmatchConfig, validate_routing_params) {
   auto pt = fake_config;
   pt.put<float>("default.interpolation_distance", -1.f);
   EXPECT_THROW(config.Read(pt), std::exception);
+
+  pt = fake_config;
+  pt.put<float>("default.adaptive_interpolation_distance", -1.f);
+  EXPECT_THROW(config.Read(pt), std::exception);
+
+  pt = fake_config;
+  pt.put<float>("default.adaptive_interpolation_seconds", 0.f);
+  EXPECT_THROW(config.Read(pt), std::exception);
 }
 
 } // namespace
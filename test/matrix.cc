@@ -1,15 +1,22 @@
 #include "test.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
 
+#include "baldr/rapidjson_utils.h"
 #include "loki/worker.h"
 #include "midgard/logging.h"
+#include "sif/costfactory.h"
 #include "sif/dynamiccost.h"
+#include "thor/bucketmatrix.h"
 #include "thor/costmatrix.h"
+#include "thor/matrix_common.h"
+#include "thor/matrix_selector.h"
 #include "thor/timedistancematrix.h"
 #include "thor/worker.h"
+#include "tyr/actor.h"
 
 using namespace valhalla;
 using namespace valhalla::thor;
@@ -256,6 +263,353 @@ TEST(Matrix, test_matrix) {
   }
 }
 
+TEST(Matrix, test_matrix_reuse) {
+  loki_worker_t loki_worker(config);
+
+  Api request;
+  ParseApi(test_request, Options::sources_to_targets, request);
+  loki_worker.matrix(request);
+  adjust_scores(*request.mutable_options());
+
+  GraphReader reader(config.get_child("mjolnir"));
+
+  sif::mode_costing_t mode_costing;
+  mode_costing[0] = CreateSimpleCost(
+      request.options().costing_options(static_cast<int>(request.options().costing())));
+
+  // keep the buffers of fewer locations than we have to make sure both reused and fresh ones work
+  boost::property_tree::ptree thor_config;
+  thor_config.put("max_reserved_locations_count", 2);
+  thor_config.put("max_reserved_labels_count", 1000);
+  CostMatrix cost_matrix(thor_config);
+  for (int pass = 0; pass < 3; ++pass) {
+    std::vector<TimeDistance> results =
+        cost_matrix.SourceToTarget(request.options().sources(), request.options().targets(), reader,
+                                   mode_costing, TravelMode::kDrive, 400000.0);
+    ASSERT_EQ(results.size(), matrix_answers.size());
+    for (uint32_t i = 0; i < results.size(); ++i) {
+      EXPECT_NEAR(results[i].dist, matrix_answers[i].dist, kThreshold)
+          << "pass " << pass << " result " << i << "'s distance is not close enough";
+      EXPECT_NEAR(results[i].time, matrix_answers[i].time, kThreshold)
+          << "pass " << pass << " result " << i << "'s time is not close enough";
+    }
+  }
+}
+
+TEST(Matrix, test_matrix_waves) {
+  loki_worker_t loki_worker(config);
+
+  Api request;
+  ParseApi(test_request, Options::sources_to_targets, request);
+  loki_worker.matrix(request);
+  adjust_scores(*request.mutable_options());
+
+  GraphReader reader(config.get_child("mjolnir"));
+
+  sif::mode_costing_t mode_costing;
+  mode_costing[0] = CreateSimpleCost(
+      request.options().costing_options(static_cast<int>(request.options().costing())));
+
+  // waves which split the locations evenly, unevenly and into single pairs all fill the same cells
+  for (uint32_t wave_size : {1, 2, 3}) {
+    boost::property_tree::ptree thor_config;
+    thor_config.put("max_active_locations", wave_size);
+    CostMatrix cost_matrix(thor_config);
+    std::vector<TimeDistance> results =
+        cost_matrix.SourceToTarget(request.options().sources(), request.options().targets(), reader,
+                                   mode_costing, TravelMode::kDrive, 400000.0);
+    ASSERT_EQ(results.size(), matrix_answers.size());
+    for (uint32_t i = 0; i < results.size(); ++i) {
+      EXPECT_NEAR(results[i].dist, matrix_answers[i].dist, kThreshold)
+          << "waves of " << wave_size << " result " << i << "'s distance is not close enough";
+      EXPECT_NEAR(results[i].time, matrix_answers[i].time, kThreshold)
+          << "waves of " << wave_size << " result " << i << "'s time is not close enough";
+    }
+    EXPECT_GT(cost_matrix.Stats().labels, 0u);
+  }
+}
+
+TEST(Matrix, test_matrix_duplicate_locations) {
+  loki_worker_t loki_worker(config);
+
+  Api request;
+  ParseApi(test_request, Options::sources_to_targets, request);
+  loki_worker.matrix(request);
+  adjust_scores(*request.mutable_options());
+
+  GraphReader reader(config.get_child("mjolnir"));
+
+  sif::mode_costing_t mode_costing;
+  mode_costing[0] = CreateSimpleCost(
+      request.options().costing_options(static_cast<int>(request.options().costing())));
+
+  CostMatrix unique_matrix;
+  unique_matrix.SourceToTarget(request.options().sources(), request.options().targets(), reader,
+                               mode_costing, TravelMode::kDrive, 400000.0);
+
+  // every source a second time, nudged so it isn't at the same coordinates but on the same spot
+  // of the same edges
+  google::protobuf::RepeatedPtrField<valhalla::Location> sources;
+  for (const auto& source : request.options().sources()) {
+    *sources.Add() = source;
+    *sources.Add() = source;
+    sources.rbegin()->mutable_ll()->set_lat(source.ll().lat() + 1e-7);
+  }
+  CostMatrix cost_matrix;
+  std::vector<TimeDistance> results =
+      cost_matrix.SourceToTarget(sources, request.options().targets(), reader, mode_costing,
+                                 TravelMode::kDrive, 400000.0);
+  const auto target_count = request.options().targets_size();
+  ASSERT_EQ(results.size(), matrix_answers.size() * 2);
+  for (uint32_t i = 0; i < results.size(); ++i) {
+    const auto& answer = matrix_answers[i / target_count / 2 * target_count + i % target_count];
+    EXPECT_NEAR(results[i].dist, answer.dist, kThreshold) << "result " << i;
+    EXPECT_NEAR(results[i].time, answer.time, kThreshold) << "result " << i;
+  }
+
+  // and the duplicates were not searched from again
+  EXPECT_EQ(cost_matrix.Stats().labels, unique_matrix.Stats().labels);
+}
+
+TEST(Matrix, test_bucket_matrix) {
+  loki_worker_t loki_worker(config);
+
+  Api request;
+  ParseApi(test_request, Options::sources_to_targets, request);
+  loki_worker.matrix(request);
+  adjust_scores(*request.mutable_options());
+
+  GraphReader reader(config.get_child("mjolnir"));
+
+  sif::mode_costing_t mode_costing;
+  mode_costing[0] = CreateSimpleCost(
+      request.options().costing_options(static_cast<int>(request.options().costing())));
+
+  // run it on a couple of threads as well since the searches of a direction are independent
+  for (uint32_t threads : {1, 2}) {
+    std::shared_ptr<MatrixWorkers> workers;
+    if (threads > 1) {
+      workers = std::make_shared<MatrixWorkers>(threads - 1, config.get_child("mjolnir"));
+    }
+    BucketMatrix bucket_matrix({}, workers);
+    std::vector<TimeDistance> results =
+        bucket_matrix.SourceToTarget(request.options().sources(), request.options().targets(),
+                                     reader, mode_costing, TravelMode::kDrive, 400000.0);
+    ASSERT_EQ(results.size(), matrix_answers.size());
+    for (uint32_t i = 0; i < results.size(); ++i) {
+      EXPECT_NEAR(results[i].dist, matrix_answers[i].dist, kThreshold)
+          << threads << " threads result " << i << "'s distance is not close enough";
+      EXPECT_NEAR(results[i].time, matrix_answers[i].time, kThreshold)
+          << threads << " threads result " << i << "'s time is not close enough";
+    }
+  }
+}
+
+TEST(Matrix, test_matrix_threads) {
+  loki_worker_t loki_worker(config);
+
+  Api request;
+  ParseApi(test_request, Options::sources_to_targets, request);
+  loki_worker.matrix(request);
+  adjust_scores(*request.mutable_options());
+
+  GraphReader reader(config.get_child("mjolnir"));
+
+  sif::mode_costing_t mode_costing;
+  mode_costing[0] = CreateSimpleCost(
+      request.options().costing_options(static_cast<int>(request.options().costing())));
+
+  CostMatrix serial_matrix;
+  auto expected =
+      serial_matrix.SourceToTarget(request.options().sources(), request.options().targets(), reader,
+                                   mode_costing, TravelMode::kDrive, 400000.0);
+  TimeDistanceMatrix serial_timedist_matrix;
+  auto expected_timedist =
+      serial_timedist_matrix.SourceToTarget(request.options().sources(),
+                                            request.options().targets(), reader, mode_costing,
+                                            TravelMode::kDrive, 400000.0);
+
+  // the parallel searches have to find exactly what the serial ones do, with both matrices
+  // sharing the same threads like they do in the thor worker
+  auto workers = std::make_shared<MatrixWorkers>(2, config.get_child("mjolnir"));
+  CostMatrix cost_matrix({}, workers);
+  TimeDistanceMatrix timedist_matrix(workers);
+  for (int pass = 0; pass < 2; ++pass) {
+    auto results = cost_matrix.SourceToTarget(request.options().sources(),
+                                              request.options().targets(), reader, mode_costing,
+                                              TravelMode::kDrive, 400000.0);
+    ASSERT_EQ(results.size(), expected.size());
+    for (uint32_t i = 0; i < results.size(); ++i) {
+      EXPECT_EQ(results[i].dist, expected[i].dist) << "pass " << pass << " result " << i;
+      EXPECT_EQ(results[i].time, expected[i].time) << "pass " << pass << " result " << i;
+    }
+
+    results = timedist_matrix.SourceToTarget(request.options().sources(),
+                                             request.options().targets(), reader, mode_costing,
+                                             TravelMode::kDrive, 400000.0);
+    ASSERT_EQ(results.size(), expected_timedist.size());
+    for (uint32_t i = 0; i < results.size(); ++i) {
+      EXPECT_EQ(results[i].dist, expected_timedist[i].dist) << "pass " << pass << " result " << i;
+      EXPECT_EQ(results[i].time, expected_timedist[i].time) << "pass " << pass << " result " << i;
+    }
+  }
+}
+
+TEST(Matrix, test_matrix_edge_cost_cache) {
+  loki_worker_t loki_worker(config);
+
+  Api request;
+  ParseApi(test_request, Options::sources_to_targets, request);
+  loki_worker.matrix(request);
+  adjust_scores(*request.mutable_options());
+
+  GraphReader reader(config.get_child("mjolnir"));
+
+  sif::mode_costing_t mode_costing;
+  mode_costing[0] = CreateSimpleCost(
+      request.options().costing_options(static_cast<int>(request.options().costing())));
+
+  CostMatrix uncached_matrix;
+  auto expected =
+      uncached_matrix.SourceToTarget(request.options().sources(), request.options().targets(),
+                                     reader, mode_costing, TravelMode::kDrive, 400000.0);
+
+  // the cached costs have to be the ones the costing computes, on every thread and every request
+  boost::property_tree::ptree thor_config;
+  thor_config.put("cache_edge_costs", true);
+  for (uint32_t threads : {1, 3}) {
+    std::shared_ptr<MatrixWorkers> workers;
+    if (threads > 1) {
+      workers = std::make_shared<MatrixWorkers>(threads - 1, config.get_child("mjolnir"));
+    }
+    CostMatrix cost_matrix(thor_config, workers);
+    for (int pass = 0; pass < 2; ++pass) {
+      auto results = cost_matrix.SourceToTarget(request.options().sources(),
+                                                request.options().targets(), reader, mode_costing,
+                                                TravelMode::kDrive, 400000.0);
+      ASSERT_EQ(results.size(), expected.size());
+      for (uint32_t i = 0; i < results.size(); ++i) {
+        EXPECT_EQ(results[i].dist, expected[i].dist) << threads << " threads result " << i;
+        EXPECT_EQ(results[i].time, expected[i].time) << threads << " threads result " << i;
+      }
+    }
+  }
+}
+
+TEST(Matrix, test_matrix_edge_cost_cache_options) {
+  loki_worker_t loki_worker(config);
+
+  Api request;
+  ParseApi(test_request, Options::sources_to_targets, request);
+  loki_worker.matrix(request);
+  adjust_scores(*request.mutable_options());
+
+  GraphReader reader(config.get_child("mjolnir"));
+  CostFactory factory;
+  auto options = request.options().costing_options(static_cast<int>(request.options().costing()));
+  auto slow_options = options;
+  slow_options.set_top_speed(10);
+
+  auto matrix = [&](CostMatrix& cost_matrix, const CostingOptions& costing_options) {
+    sif::mode_costing_t mode_costing;
+    mode_costing[static_cast<uint32_t>(TravelMode::kDrive)] = factory.Create(costing_options);
+    return cost_matrix.SourceToTarget(request.options().sources(), request.options().targets(),
+                                      reader, mode_costing, TravelMode::kDrive, 400000.0);
+  };
+  CostMatrix uncached_matrix;
+  const auto expected = matrix(uncached_matrix, options);
+  const auto expected_slow = matrix(uncached_matrix, slow_options);
+  ASSERT_TRUE(std::any_of(expected.begin(), expected.end(), [&](const TimeDistance& td) {
+    return td.time != expected_slow[&td - expected.data()].time;
+  }));
+
+  // the costs outlive a matrix, the next one with other options must not get them
+  boost::property_tree::ptree thor_config;
+  thor_config.put("cache_edge_costs", true);
+  CostMatrix cost_matrix(thor_config);
+  for (const auto* costing_options : {&options, &options, &slow_options, &options}) {
+    const auto& want = costing_options == &options ? expected : expected_slow;
+    const auto results = matrix(cost_matrix, *costing_options);
+    ASSERT_EQ(results.size(), want.size());
+    for (uint32_t i = 0; i < results.size(); ++i) {
+      EXPECT_EQ(results[i].dist, want[i].dist) << "result " << i;
+      EXPECT_EQ(results[i].time, want[i].time) << "result " << i;
+    }
+  }
+}
+
+TEST(Matrix, test_matrix_streaming) {
+  // the pieces have to add up to the json the matrix would have been in one go, both for the
+  // one to many rows on threads and for the algorithms which only know the rows at the end
+  for (const auto* algorithm : {"timedistancematrix", "costmatrix"}) {
+    auto streaming_config = config;
+    streaming_config.put("thor.source_to_target_algorithm", algorithm);
+    streaming_config.put("thor.matrix_threads", 2);
+    actor_t actor(streaming_config, true);
+    const auto expected = actor.matrix(test_request);
+
+    std::vector<std::string> pieces;
+    const std::function<void(const std::string&)> write = [&pieces](const std::string& piece) {
+      pieces.push_back(piece);
+    };
+    EXPECT_EQ(actor.matrix(test_request, nullptr, nullptr, &write), "");
+    // the head, a row per source and the tail
+    EXPECT_EQ(pieces.size(), 6) << algorithm;
+
+    std::string streamed;
+    for (const auto& piece : pieces) {
+      streamed += piece;
+    }
+    rapidjson::Document expected_json, streamed_json;
+    expected_json.Parse(expected.c_str());
+    streamed_json.Parse(streamed.c_str());
+    ASSERT_FALSE(streamed_json.HasParseError()) << streamed;
+    EXPECT_TRUE(expected_json == streamed_json) << algorithm << " " << streamed;
+  }
+}
+
+google::protobuf::RepeatedPtrField<valhalla::Location>
+locations_around(const uint32_t count, const double spread) {
+  google::protobuf::RepeatedPtrField<valhalla::Location> locations;
+  for (uint32_t i = 0; i < count; ++i) {
+    auto* ll = locations.Add()->mutable_ll();
+    ll->set_lng(-76.6 + spread * i / count);
+    ll->set_lat(40.3 + spread * i / count);
+  }
+  return locations;
+}
+
+TEST(Matrix, test_select_algorithm) {
+  MatrixSelector selector;
+
+  // one to many is a single search for timedistancematrix but a search per location otherwise
+  auto one = locations_around(1, 0.01);
+  auto many = locations_around(20, 0.05);
+  auto estimate = selector.Select(one, many, TravelMode::kPedestrian, 200000.0f);
+  EXPECT_EQ(estimate.algorithm, MatrixAlgorithm::kTimeDistanceMatrix);
+  EXPECT_GT(estimate.cost, 0.0f);
+
+  // long drives only grow along the highways with the hierarchy limits of costmatrix
+  auto far = locations_around(10, 1.0);
+  estimate = selector.Select(far, far, TravelMode::kDrive, 400000.0f);
+  EXPECT_EQ(estimate.algorithm, MatrixAlgorithm::kCostMatrix);
+  EXPECT_EQ(estimate.cost,
+            selector.Estimate(MatrixAlgorithm::kCostMatrix, far, far, TravelMode::kDrive, 400000.0f));
+
+  // the bidirectional algorithms dont do transit
+  estimate = selector.Select(far, far, TravelMode::kPublicTransit, 400000.0f);
+  EXPECT_EQ(estimate.algorithm, MatrixAlgorithm::kTimeDistanceMatrix);
+
+  // a cheaper search makes a difference once calibrated and bucketmatrix is only picked when
+  // it has coefficients of its own
+  boost::property_tree::ptree thor_config;
+  thor_config.put("matrix_cost_model.bucketmatrix.search", 1.0f);
+  thor_config.put("matrix_cost_model.bucketmatrix.expansion", 0.1f);
+  estimate = MatrixSelector(thor_config).Select(far, far, TravelMode::kDrive, 400000.0f);
+  EXPECT_EQ(estimate.algorithm, MatrixAlgorithm::kBucketMatrix);
+  EXPECT_EQ(to_string(estimate.algorithm), "bucketmatrix");
+}
+
 // TODO: it was commented before. Why?
 TEST(Matrix, DISABLED_test_matrix_osrm) {
   loki_worker_t loki_worker(config);
@@ -1338,6 +1338,46 @@ TEST(NarrativeDictionary, test_en_US_approach_verbal_alert) {
   validate(us_customary_lengths, kExpectedUsCustomaryLengths);
 }
 
+TEST(NarrativeDictionary, test_en_US_phrase_templates) {
+  const NarrativeDictionary& dictionary = GetNarrativeDictionary("en-US");
+
+  // Every phrase is compiled and formats back to itself without any values
+  for (const auto& phrase : dictionary.start_subset.phrases) {
+    EXPECT_EQ(dictionary.start_subset.phrase(std::stoul(phrase.first)).Format({}), phrase.second);
+  }
+
+  // "2": "Head <CARDINAL_DIRECTION> on <BEGIN_STREET_NAMES>. Continue on <STREET_NAMES>."
+  const std::string north = "north", begin = "Main Street", street = "Broadway";
+  EXPECT_EQ(dictionary.start_subset.phrase(2).Format({{kCardinalDirectionTag, north},
+                                                      {kStreetNamesTag, street},
+                                                      {kBeginStreetNamesTag, begin}}),
+            "Head north on Main Street. Continue on Broadway.");
+
+  // Missing phrases throw just like the phrases do
+  EXPECT_THROW(dictionary.start_subset.phrase(3), std::out_of_range);
+  EXPECT_THROW(dictionary.start_subset.phrase(100), std::out_of_range);
+}
+
+TEST(NarrativeTemplate, test_format) {
+  const std::string value = "<STREET_NAMES> & <LENGTH>";
+  const std::string empty;
+
+  // Values are not searched for tags and tags without values are kept
+  NarrativeTemplate tagged("Turn onto <STREET_NAMES> for <LENGTH><NOT A TAG><>>");
+  EXPECT_EQ(tagged.Format({{kStreetNamesTag, value}}),
+            "Turn onto <STREET_NAMES> & <LENGTH> for <LENGTH><NOT A TAG><>>");
+  EXPECT_EQ(tagged.Format({{kStreetNamesTag, empty}, {kLengthTag, empty}}),
+            "Turn onto  for <NOT A TAG><>>");
+
+  // Repeated tags all get the value
+  NarrativeTemplate repeated("<LENGTH> then <LENGTH>");
+  EXPECT_EQ(repeated.Format({{kLengthTag, value}}),
+            "<STREET_NAMES> & <LENGTH> then <STREET_NAMES> & <LENGTH>");
+
+  EXPECT_EQ(NarrativeTemplate("").Format({{kLengthTag, value}}), "");
+  EXPECT_EQ(NarrativeTemplate("<LENGTH").Format({{kLengthTag, value}}), "<LENGTH");
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
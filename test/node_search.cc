@@ -3,6 +3,7 @@
 
 #include "baldr/rapidjson_utils.h"
 #include <boost/property_tree/ptree.hpp>
+#include <set>
 #include <unordered_set>
 
 #include "baldr/graphid.h"
@@ -414,6 +415,44 @@ TEST(Search, test_opposite_in_another_tile) {
   EXPECT_EQ(nodes.size(), 1) << "Expecting to find one node";
 }
 
+TEST(Search, test_bulk_same_as_single) {
+  // make the config file
+  std::stringstream json;
+  json << "{ \"tile_dir\": \"" << test_tile_dir << "\" }";
+  boost::property_tree::ptree conf;
+  rapidjson::read_json(json, conf);
+
+  vb::GraphReader reader(conf);
+  // the boxes of the tests above, some which overlap each other, one across the tile boundary and
+  // one without anything in it
+  std::vector<vm::AABB2<vm::PointLL>> boxes{{{-0.0025, -0.0025}, {0.0025, 0.0025}},
+                                            {{0.0, 0.0}, {0.0051, 0.0051}},
+                                            {{0.0, 0.250}, {0.001, 0.253}},
+                                            {{0.5, 0.5}, {0.51, 0.51}},
+                                            {{0.001, 0.001}, {0.03, 0.02}},
+                                            {{0.2, 0.2}, {0.3, 0.3}},
+                                            {{-1.0, -1.0}, {-0.9, -0.9}}};
+
+  auto nodes = valhalla::loki::nodes_in_bboxes(boxes, reader);
+  auto edges = valhalla::loki::edges_in_bboxes(boxes, reader);
+  ASSERT_EQ(nodes.size(), boxes.size());
+  ASSERT_EQ(edges.size(), boxes.size());
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    auto expected_nodes = valhalla::loki::nodes_in_bbox(boxes[i], reader);
+    std::set<vb::GraphId> expected(expected_nodes.begin(), expected_nodes.end());
+    std::set<vb::GraphId> found(nodes.begin(i), nodes.end(i));
+    EXPECT_EQ(found.size(), size_t(nodes.end(i) - nodes.begin(i))) << "Duplicate nodes in box " << i;
+    EXPECT_EQ(found, expected) << "Different nodes in box " << i;
+
+    auto expected_edges = valhalla::loki::edges_in_bbox(boxes[i], reader);
+    expected = std::set<vb::GraphId>(expected_edges.begin(), expected_edges.end());
+    found = std::set<vb::GraphId>(edges.begin(i), edges.end(i));
+    EXPECT_EQ(found.size(), size_t(edges.end(i) - edges.begin(i))) << "Duplicate edges in box " << i;
+    EXPECT_EQ(found, expected) << "Different edges in box " << i;
+  }
+  EXPECT_EQ(nodes.begin(6), nodes.end(6));
+}
+
 // Setup and tearown will be called only once for the entire suite
 class Env : public ::testing::Environment {
 public:
@@ -2,6 +2,8 @@
 #include <cstdint>
 
 #include <algorithm>
+#include <list>
+#include <random>
 #include <vector>
 
 #include "midgard/point2.h"
@@ -313,6 +315,32 @@ void TryClippedPolyline(Polyline2<Point2>& pl, const AABB2<Point2>& a) {
   EXPECT_EQ(pl2.pts().at(1), Point2(50.0f, 50.0f));
 }
 
+TEST(Polyline2, TestGeneralizeVectorMatchesList) {
+  // the vectors are simplified in place and the lists one range at a time, both keep the same
+  std::mt19937 gen(0);
+  std::normal_distribution<double> step(0, 0.0003);
+  for (int shape = 0; shape < 50; ++shape) {
+    std::vector<PointLL> vector{{5.1, 52.1}};
+    for (size_t i = 0; i < 500 + shape * 20; ++i) {
+      const auto& last = vector.back();
+      vector.emplace_back(last.lng() + 0.0001 + step(gen), last.lat() + step(gen));
+      // repeated points tie on their distance to the line
+      if (i % 13 == 0) {
+        vector.push_back(vector.back());
+      }
+    }
+    std::unordered_set<size_t> exclusions;
+    for (size_t i = 0; shape % 2 && i < 5; ++i) {
+      exclusions.insert(gen() % (vector.size() + 5));
+    }
+    std::list<PointLL> list(vector.cbegin(), vector.cend());
+    const double epsilon = 1 + shape % 5 * 5;
+    Polyline2<PointLL>::Generalize(vector, epsilon, exclusions);
+    Polyline2<PointLL>::Generalize(list, epsilon, exclusions);
+    EXPECT_EQ(vector, std::vector<PointLL>(list.cbegin(), list.cend())) << "shape " << shape;
+  }
+}
+
 TEST(Polyline2, TestClippedPolyline) {
   std::vector<Point2> pts = {Point2(25.0f, 25.0f), Point2(50.0f, 50.0f), Point2(25.0f, 75.0f),
                              Point2(50.0f, 100.0f)};
@@ -254,6 +254,22 @@ TEST(PredictedSpeeds, test_compress_decompress_accuracy) {
   EXPECT_LE(max_diff, 2.f) << "Low decompression accuracy"; // <= 2 KPH
 }
 
+TEST(PredictedSpeeds, test_decompress_matches_dct) {
+  // the decoding sums the terms in a different order than the textbook dct-iii, make sure it only
+  // differs from it by float rounding
+  std::array<int16_t, kCoefficientCount> coefficients;
+  for (uint32_t i = 0; i < kCoefficientCount; ++i)
+    coefficients[i] = static_cast<int16_t>((i * 7919) % 401) - 200;
+
+  for (uint32_t bucket = 0; bucket < kBucketsPerWeek; ++bucket) {
+    double expected = coefficients[0] / sqrt(2.0);
+    for (uint32_t c = 1; c < kCoefficientCount; ++c)
+      expected += coefficients[c] * cos(M_PI / kBucketsPerWeek * (bucket + 0.5) * c);
+    expected *= sqrt(2.0 / kBucketsPerWeek);
+    EXPECT_NEAR(decompress_speed_bucket(coefficients.data(), bucket), expected, 1e-2) << bucket;
+  }
+}
+
 struct EncoderDecoderTest : public ::testing::Test {
   EncoderDecoderTest() {
     // fill in coefficients
@@ -131,6 +131,51 @@ TEST(RecoverShortcut, test_recover_shortcut_edges_cache) {
   recover(true);
 }
 
+TEST(RecoverShortcut, test_recover_shortcut_cache_fills_lazily) {
+  // expose what got cached
+  struct inspectable_recovery : public testable_recovery {
+    using testable_recovery::testable_recovery;
+    size_t tile_count() const {
+      return tiles.size();
+    }
+    size_t shortcut_count() const {
+      return shortcuts.size();
+    }
+  };
+
+  GraphReader graphreader(conf.get_child("mjolnir"));
+  inspectable_recovery recovery{&graphreader};
+  EXPECT_EQ(recovery.tile_count(), 0);
+
+  // find a shortcut to ask for
+  GraphId shortcut_id;
+  for (const auto tileid : graphreader.GetTileSet(0)) {
+    auto tile = graphreader.GetGraphTile(tileid);
+    for (size_t j = 0; j < tile->header()->directededgecount() && !shortcut_id.Is_Valid(); ++j) {
+      if (tile->directededge(j)->is_shortcut()) {
+        shortcut_id = tileid;
+        shortcut_id.set_id(j);
+      }
+    }
+    if (shortcut_id.Is_Valid())
+      break;
+  }
+  ASSERT_TRUE(shortcut_id.Is_Valid());
+
+  // only the tile of the shortcut is recovered and it gives the same as recovering on the fly
+  testable_recovery uncached{nullptr};
+  auto edges = recovery.get(shortcut_id, graphreader);
+  EXPECT_EQ(edges, uncached.get(shortcut_id, graphreader));
+  EXPECT_EQ(recovery.tile_count(), 1);
+  const auto shortcut_count = recovery.shortcut_count();
+  EXPECT_GT(shortcut_count, 0);
+
+  // asking again is answered from the cache
+  EXPECT_EQ(recovery.get(shortcut_id, graphreader), edges);
+  EXPECT_EQ(recovery.tile_count(), 1);
+  EXPECT_EQ(recovery.shortcut_count(), shortcut_count);
+}
+
 int main(int argc, char* argv[]) {
   // valhalla::midgard::logging::Configure({{"type", ""}});
   testing::InitGoogleTest(&argc, argv);
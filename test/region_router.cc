@@ -0,0 +1,100 @@
+#include <string>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include "worker.h"
+
+#include "test.h"
+
+using namespace valhalla;
+
+namespace {
+
+boost::property_tree::ptree region(const std::string& name,
+                                   const std::string& url,
+                                   const std::vector<double>& bbox) {
+  boost::property_tree::ptree pt;
+  pt.put("name", name);
+  pt.put("url", url);
+  boost::property_tree::ptree coordinates;
+  for (auto c : bbox) {
+    boost::property_tree::ptree coordinate;
+    coordinate.put_value(c);
+    coordinates.push_back({"", coordinate});
+  }
+  pt.add_child("bbox", coordinates);
+  return pt;
+}
+
+// a country inside of a continent
+boost::property_tree::ptree config(const std::string& own_region, const std::string& planet_url) {
+  boost::property_tree::ptree regions;
+  regions.push_back({"", region("europe", "http://europe", {-25, 34, 45, 72})});
+  regions.push_back({"", region("netherlands", "http://netherlands", {3, 50.7, 7.3, 53.6})});
+  boost::property_tree::ptree pt;
+  pt.add_child("httpd.service.regions", regions);
+  pt.put("httpd.service.region", own_region);
+  pt.put("httpd.service.planet_url", planet_url);
+  return pt;
+}
+
+Options options(const std::vector<std::pair<double, double>>& lls) {
+  Options options;
+  for (const auto& ll : lls) {
+    auto* location = options.mutable_locations()->Add()->mutable_ll();
+    location->set_lng(ll.first);
+    location->set_lat(ll.second);
+  }
+  return options;
+}
+
+const std::pair<double, double> amsterdam{4.9, 52.37}, utrecht{5.12, 52.09}, paris{2.35, 48.86},
+    new_york{-74, 40.7};
+
+std::string route(const region_router_t& router, const Options& options) {
+  const auto* url = router.route(options);
+  return url ? *url : "here";
+}
+
+} // namespace
+
+TEST(RegionRouter, NotConfigured) {
+  EXPECT_EQ(region_router_t::make(boost::property_tree::ptree{}), nullptr);
+  boost::property_tree::ptree empty;
+  empty.add_child("httpd.service.regions", boost::property_tree::ptree{});
+  EXPECT_EQ(region_router_t::make(empty), nullptr);
+}
+
+TEST(RegionRouter, RegionalNode) {
+  auto router = region_router_t::make(config("netherlands", "http://planet"));
+  ASSERT_NE(router, nullptr);
+  EXPECT_EQ(router->region(), "netherlands");
+
+  // its own requests stay, the others go to the smallest region covering them or the planet
+  EXPECT_EQ(route(*router, options({amsterdam, utrecht})), "here");
+  EXPECT_EQ(route(*router, options({amsterdam, paris})), "http://europe");
+  EXPECT_EQ(route(*router, options({amsterdam, new_york})), "http://planet");
+
+  // sources and targets count as well
+  auto matrix = options({});
+  *matrix.mutable_sources() = options({amsterdam}).locations();
+  *matrix.mutable_targets() = options({paris}).locations();
+  EXPECT_EQ(route(*router, matrix), "http://europe");
+
+  // requests without locations are about the node itself
+  EXPECT_EQ(route(*router, options({})), "here");
+}
+
+TEST(RegionRouter, PlanetNode) {
+  // the planet sends what fits in a region there and answers the rest itself
+  auto router = region_router_t::make(config("", ""));
+  ASSERT_NE(router, nullptr);
+  EXPECT_EQ(router->region(), "");
+  EXPECT_EQ(route(*router, options({amsterdam, utrecht})), "http://netherlands");
+  EXPECT_EQ(route(*router, options({paris})), "http://europe");
+  EXPECT_EQ(route(*router, options({amsterdam, new_york})), "here");
+}
+
+TEST(RegionRouter, UnknownOwnRegion) {
+  EXPECT_THROW(region_router_t::make(config("belgium", "")), std::runtime_error);
+}
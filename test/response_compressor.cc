@@ -0,0 +1,133 @@
+#include <string>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include "baldr/compression_utils.h"
+#include "worker.h"
+
+#include "test.h"
+
+using namespace valhalla;
+
+namespace {
+
+boost::property_tree::ptree config(const std::vector<std::string>& codecs, uint32_t min_size = 16) {
+  boost::property_tree::ptree list;
+  for (const auto& codec : codecs) {
+    boost::property_tree::ptree name;
+    name.put_value(codec);
+    list.push_back({"", name});
+  }
+  boost::property_tree::ptree pt;
+  pt.add_child("httpd.service.compression_codecs", list);
+  pt.put("httpd.service.compression_min_size", min_size);
+  return pt;
+}
+
+std::string negotiate(const response_compressor_t& compressor, const std::string& accept_encoding) {
+  Api request;
+  compressor.negotiate(accept_encoding, request);
+  return request.info().content_encoding();
+}
+
+std::string inflate(const std::string& compressed) {
+  auto src = [&compressed](z_stream& s) {
+    s.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+    s.avail_in = static_cast<uInt>(compressed.size());
+  };
+  std::string inflated;
+  auto dst = [&inflated](z_stream& s) {
+    // if the whole buffer wasn't used we are done
+    auto size = inflated.size();
+    if (s.total_out < size) {
+      inflated.resize(s.total_out);
+    } else {
+      inflated.resize(size + 1024);
+      s.next_out = reinterpret_cast<Bytef*>(&inflated[size]);
+      s.avail_out = 1024;
+    }
+    return Z_NO_FLUSH;
+  };
+  EXPECT_TRUE(baldr::inflate(src, dst));
+  return inflated;
+}
+
+} // namespace
+
+TEST(ResponseCompressor, NotConfigured) {
+  EXPECT_EQ(response_compressor_t::make(boost::property_tree::ptree{}), nullptr);
+  EXPECT_EQ(response_compressor_t::make(config({})), nullptr);
+}
+
+TEST(ResponseCompressor, UnknownCodec) {
+  EXPECT_THROW(response_compressor_t::make(config({"gzip", "lzma"})), std::runtime_error);
+}
+
+TEST(ResponseCompressor, Negotiate) {
+  auto compressor = response_compressor_t::make(config({"gzip", "deflate"}));
+  ASSERT_NE(compressor, nullptr);
+
+  // ties go to the codec configured first, otherwise the client decides
+  EXPECT_EQ(negotiate(*compressor, "deflate, gzip"), "gzip");
+  EXPECT_EQ(negotiate(*compressor, "gzip;q=0.5, deflate"), "deflate");
+  EXPECT_EQ(negotiate(*compressor, " GZIP ; q=0.8 , br"), "gzip");
+  EXPECT_EQ(negotiate(*compressor, "gzip;q=0, deflate;q=0.1"), "deflate");
+
+  // the wildcard covers the codecs the client didnt name
+  EXPECT_EQ(negotiate(*compressor, "*"), "gzip");
+  EXPECT_EQ(negotiate(*compressor, "gzip;q=0, *;q=0.5"), "deflate");
+
+  // without any codec the client accepts nothing is compressed
+  EXPECT_EQ(negotiate(*compressor, ""), "");
+  EXPECT_EQ(negotiate(*compressor, "identity"), "");
+  EXPECT_EQ(negotiate(*compressor, "br, gzip;q=0, deflate;q=0"), "");
+}
+
+TEST(ResponseCompressor, Compress) {
+  auto pt = config({"deflate", "gzip"}, 64);
+  pt.put("httpd.service.compression_levels.gzip", 9);
+  auto compressor = response_compressor_t::make(pt);
+  ASSERT_NE(compressor, nullptr);
+
+  Api request;
+  compressor->negotiate("gzip", request);
+  EXPECT_EQ(request.info().content_encoding(), "gzip");
+  EXPECT_EQ(request.info().compression_level(), 9);
+  EXPECT_EQ(request.info().compression_min_size(), 64u);
+
+  // small responses arent worth it
+  std::string compressed;
+  EXPECT_FALSE(response_compressor_t::compress(request, "{}", compressed));
+
+  std::string response;
+  for (int i = 0; i < 1000; ++i) {
+    response += R"({"time":)" + std::to_string(i) + R"(,"distance":)" + std::to_string(i * 3) + "},";
+  }
+  ASSERT_TRUE(response_compressor_t::compress(request, response, compressed));
+  EXPECT_LT(compressed.size(), response.size());
+  EXPECT_EQ(inflate(compressed), response);
+
+  // deflate has the zlib wrapper which inflates the same way
+  ASSERT_TRUE(response_compressor_t::compress("deflate", 1, response, compressed));
+  EXPECT_EQ(inflate(compressed), response);
+
+  // and a request without a codec is sent as is
+  EXPECT_FALSE(response_compressor_t::compress(Api{}, response, compressed));
+}
+
+TEST(ResponseCompressor, AddCodec) {
+  auto reverse = [](const std::string& data, int level, std::string& compressed) {
+    compressed.assign(data.rbegin(), data.rend());
+    compressed += std::to_string(level);
+    return true;
+  };
+  response_compressor_t::add_codec("reverse", reverse, 7);
+  auto compressor = response_compressor_t::make(config({"reverse", "gzip"}, 0));
+  ASSERT_NE(compressor, nullptr);
+
+  Api request;
+  compressor->negotiate("gzip, reverse", request);
+  std::string compressed;
+  ASSERT_TRUE(response_compressor_t::compress(request, "abc", compressed));
+  EXPECT_EQ(compressed, "cba7");
+}
@@ -8,6 +8,7 @@
 #include <cmath>
 #include <fstream>
 #include <list>
+#include <thread>
 
 #include "test.h"
 
@@ -103,6 +104,93 @@ TEST(Sample, getgz) {
   _get("test/data/samplegz");
 };
 
+TEST(Sample, blocked) {
+  EXPECT_FALSE(skadi::sample::convert("test/data/this_is_not_a_tile.hgt", "test/data/blah.hgt.blk"));
+  ASSERT_TRUE(skadi::sample::convert("test/data/samplegz/N40/N40W077.hgt.gz",
+                                     "test/data/sampleblk/N40/N40W077.hgt.blk"));
+  std::ifstream file("test/data/sampleblk/N40/N40W077.hgt.blk", std::ios::binary | std::ios::ate);
+  EXPECT_LT(file.tellg(), 3601 * 3601 * 2) << "Blocked tile should be smaller than the raw one";
+  _get("test/data/sampleblk");
+
+  // exactly the same values as the raw tile all over the tile
+  skadi::sample raw("test/data/sample");
+  skadi::sample blocked("test/data/sampleblk");
+  std::vector<std::pair<double, double>> postings;
+  for (double lat = 40.0; lat < 41.0; lat += 0.0173) {
+    for (double lon = -77.0; lon < -76.0; lon += 0.0191) {
+      postings.emplace_back(lon, lat);
+    }
+  }
+  postings.emplace_back(-76.0000001, 40.0000001);
+  EXPECT_EQ(raw.get_all(postings), blocked.get_all(postings));
+  EXPECT_GT(blocked.cache_blocks(), 0);
+  EXPECT_EQ(blocked.cache_size(), 0);
+}
+
+TEST(Sample, unzipped_cache) {
+  // at least one tile is kept no matter how small the cache is
+  EXPECT_EQ(skadi::sample("test/data/samplegz", 0).cache_capacity(), 1);
+  EXPECT_EQ(skadi::sample("test/data/samplegz", 3 * 3601 * 3601 * 2).cache_capacity(), 3);
+
+  // the tile is only unzipped the first time and reused for the rest of the postings in it
+  skadi::sample s("test/data/samplegz", 0);
+  EXPECT_NEAR(490, s.get(std::make_pair(-76.503915, 40.678783)), 1.0);
+  EXPECT_EQ(s.cache_size(), 1);
+  EXPECT_EQ(s.cache_misses(), 1);
+  EXPECT_EQ(s.cache_hits(), 0);
+  EXPECT_NEAR(134, s.get(std::make_pair(-76.9, 40.0)), 1.0);
+  EXPECT_EQ(s.cache_hits(), 1);
+  std::vector<std::pair<double, double>> postings(100, {-76.537011, 40.723872});
+  s.get_all(postings);
+  EXPECT_EQ(s.cache_hits(), 2);
+  EXPECT_EQ(s.cache_misses(), 1);
+
+  // raw tiles dont go through the cache at all
+  skadi::sample raw("test/data/sample");
+  raw.get(std::make_pair(-76.503915, 40.678783));
+  EXPECT_EQ(raw.cache_hits() + raw.cache_misses(), 0);
+}
+
+TEST(Sample, get_all_across_tiles) {
+  // a line zig zagging between a tile with data and one without
+  skadi::sample s("test/data/samplegz");
+  std::vector<std::pair<double, double>> postings;
+  for (int i = 0; i < 20; ++i) {
+    postings.emplace_back(i % 2 ? -77.01 : -76.9, 40.0 + i * 0.01);
+  }
+  auto heights = s.get_all(postings);
+  ASSERT_EQ(heights.size(), postings.size());
+
+  // the tile was only looked up once and the values are in the order of the postings
+  EXPECT_EQ(s.cache_misses(), 1);
+  EXPECT_EQ(s.cache_hits(), 0);
+  for (size_t i = 0; i < postings.size(); ++i) {
+    EXPECT_EQ(heights[i], s.get(postings[i])) << i;
+    EXPECT_EQ(heights[i] == skadi::sample::get_no_data_value(), i % 2 == 1) << i;
+  }
+}
+
+TEST(Sample, unzipped_cache_threads) {
+  // many threads sharing a sample all see the same heights
+  skadi::sample s("test/data/samplegz", 0);
+  std::vector<std::thread> threads;
+  std::vector<double> heights(8);
+  for (size_t i = 0; i < heights.size(); ++i) {
+    threads.emplace_back([&s, &heights, i]() {
+      for (int j = 0; j < 10; ++j) {
+        heights[i] = s.get(std::make_pair(-76.503915, 40.678783));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto height : heights) {
+    EXPECT_NEAR(490, height, 1.0);
+  }
+  EXPECT_EQ(s.cache_size(), 1);
+}
+
 struct testable_sample_t : public skadi::sample {
   testable_sample_t(const std::string& dir) : sample(dir) {
     {
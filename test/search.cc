@@ -1,4 +1,5 @@
 #include "loki/search.h"
+#include "loki/search_cache.h"
 #include <cstdint>
 
 #include <boost/property_tree/ptree.hpp>
@@ -455,6 +456,90 @@ TEST(Search, test_search_cutoff) {
   search(x, 2, 0);
 }
 
+TEST(Search, test_search_cache) {
+  boost::property_tree::ptree conf;
+  conf.put("tile_dir", tile_dir);
+  valhalla::baldr::GraphReader reader(conf);
+  const auto costing = create_costing();
+
+  PointLL ob(b.second.first - .001f, b.second.second - .01f);
+  Location location(ob, Location::StopType::BREAK, 4, 4, 0);
+  const auto expected = Search({location}, reader, costing).at(location);
+
+  SearchCache cache(100, 100);
+  auto first = Search({location}, reader, costing, nullptr, 0, &cache).at(location);
+  EXPECT_EQ(cache.locations().hits(), 0);
+  EXPECT_EQ(cache.locations().size(), 1);
+  EXPECT_GT(cache.reaches().size(), 0);
+  EXPECT_EQ(first, expected);
+
+  // a location a few millimeters away is the same one for the cache but keeps its own coordinates
+  Location nearby(location);
+  nearby.latlng_.set_x(ob.lng() + 1e-8);
+  auto second = Search({nearby}, reader, costing, nullptr, 0, &cache).at(nearby);
+  EXPECT_EQ(cache.locations().hits(), 1);
+  EXPECT_EQ(second.latlng_, nearby.latlng_);
+  EXPECT_TRUE(second.shares_edges(expected));
+
+  // another costing does not share the results
+  cache.set_costing(1);
+  Search({location}, reader, costing, nullptr, 0, &cache);
+  EXPECT_EQ(cache.locations().hits(), 1);
+  EXPECT_EQ(cache.locations().size(), 2);
+}
+
+TEST(Search, test_search_stats) {
+  boost::property_tree::ptree conf;
+  conf.put("tile_dir", tile_dir);
+  valhalla::baldr::GraphReader reader(conf);
+  const auto costing = create_costing();
+
+  // right next to the edges there is nothing to skip
+  PointLL ob(b.second.first - .001f, b.second.second - .01f);
+  SearchStats stats;
+  Search({{ob, Location::StopType::BREAK, 0, 0, 0}}, reader, costing, nullptr, 0, nullptr, nullptr,
+         &stats);
+  EXPECT_GT(stats.bins, 0);
+  EXPECT_GT(stats.edges, 0);
+  EXPECT_EQ(stats.missing_bins, 0);
+
+  // from a degree away the search goes through the bins of tiles which are not there, only the
+  // first bin of each of them asks the reader
+  auto t = c.second;
+  t.first -= 1;
+  t.second -= 1;
+  Location x(t);
+  x.search_cutoff_ = t.Distance(c.second) + 1;
+  SearchStats far;
+  const auto results = Search({x}, reader, costing, nullptr, 0, nullptr, nullptr, &far);
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_GT(far.missing_bins, 0);
+  EXPECT_GT(far.edges, 0);
+
+  // the stats add up over searches
+  auto total = stats;
+  total += far;
+  EXPECT_EQ(total.bins, stats.bins + far.bins);
+  EXPECT_EQ(total.missing_bins, far.missing_bins);
+}
+
+TEST(Search, test_lru_cache) {
+  lru_cache_t<int, int> cache(2);
+  int value = 0;
+  cache.insert(1, 10);
+  cache.insert(2, 20);
+  EXPECT_TRUE(cache.find(1, value));
+  EXPECT_EQ(value, 10);
+  // 2 was used least recently so it makes room for 3
+  cache.insert(3, 30);
+  EXPECT_FALSE(cache.find(2, value));
+  EXPECT_TRUE(cache.find(3, value));
+  EXPECT_TRUE(cache.find(1, value));
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.hits(), 3);
+  EXPECT_EQ(cache.misses(), 1);
+}
+
 } // namespace
 
 // Setup and tearown will be called only once for the entire suite121
@@ -70,6 +70,59 @@ TEST(Sequence, Iterator) {
   EXPECT_EQ(i.position(), 0) << "Pre-decrement operator wasn't right";
 }
 
+TEST(Sequence, MemMapResidency) {
+  // a few pages which are all touched once written
+  const size_t count = 1 << 16;
+  {
+    mem_map<osm_node> nodes;
+    nodes.create("resident.nd", count);
+    for (size_t i = 0; i < count; ++i)
+      nodes.get()[i] = {i, 0.f, 0.f, 0};
+    EXPECT_GE(nodes.resident(0, count), count * sizeof(osm_node));
+  }
+
+  mem_map<osm_node> nodes;
+  nodes.map_readonly("resident.nd", count);
+  EXPECT_TRUE(nodes.advise(0, count, MADV_WILLNEED));
+  EXPECT_TRUE(nodes.advise(count / 2, 1, MADV_RANDOM));
+  // nothing to do past the end of the map
+  EXPECT_FALSE(nodes.advise(count, 1, MADV_RANDOM));
+  EXPECT_FALSE(nodes.lock(count, 1));
+  EXPECT_EQ(nodes.resident(count, 1), 0);
+  // a range in the middle is widened to the pages it touches
+  EXPECT_GE(nodes.resident(count / 2, 1), sizeof(osm_node));
+}
+
+TEST(Sequence, ExternalSort) {
+  // lots of equal keys so that the order of the values shows whether the sort was stable
+  std::vector<std::pair<uint32_t, uint32_t>> expected;
+  for (uint32_t i = 0; i < 100000; ++i)
+    expected.emplace_back((i * 7919) % 1013, i);
+  auto less_than = [](const std::pair<uint32_t, uint32_t>& a,
+                      const std::pair<uint32_t, uint32_t>& b) { return a.first < b.first; };
+
+  std::vector<std::vector<std::pair<uint32_t, uint32_t>>> sorted;
+  for (size_t buffer_size : {200000, 100000, 33333, 4096}) {
+    for (size_t threads : {1, 3, 8}) {
+      {
+        sequence<std::pair<uint32_t, uint32_t>> pairs("pairs.nd", true);
+        for (const auto& pair : expected)
+          pairs.push_back(pair);
+        pairs.sort(less_than, buffer_size, threads);
+      }
+      sequence<std::pair<uint32_t, uint32_t>> pairs("pairs.nd", false);
+      sorted.emplace_back(pairs.begin(), pairs.end());
+      EXPECT_FALSE(filesystem::exists("pairs.nd.runs.tmp"));
+    }
+  }
+
+  std::stable_sort(expected.begin(), expected.end(), less_than);
+  for (const auto& result : sorted) {
+    ASSERT_EQ(result.size(), expected.size());
+    EXPECT_TRUE(std::equal(result.begin(), result.end(), expected.begin()));
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
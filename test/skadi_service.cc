@@ -73,8 +73,30 @@ const std::vector<http_request_t> requests{
         "IxaIcF~|@cBngJiMjj@_I`HwXlJuO^kKj@gJkAeaBy`AgNoHwDkAeELwD|@uDfC_i@bq@mOjUaCvDqBrEcAbGWbG|@"
         "jVd@rPkAbGsAfDqBvCaIrFsP~RoNjWajBlnD{OtZoNfXyBtE{B~HyAtEsFhL_DvDsGrF_I`HwDpGoH|T_"
         "IzLaMzKuOrFqfAbPwCl@_h@fN}OnI\"}"),
+    http_request_t(POST,
+                   "/height",
+                   "{\"format\":\"binary\",\"range\":true,\"shape\":[{\"lat\":40.712431, "
+                   "\"lon\":-76.504916},{\"lat\":40.712275, \"lon\":-76.605259},{\"lat\":40.712122, "
+                   "\"lon\":-76.805694},{\"lat\":40.722431, \"lon\":-76.884916},{\"lat\":40.812275, "
+                   "\"lon\":-76.905259},{\"lat\":40.912122, \"lon\":-76.965694}]}"),
 };
 
+// little endian int16 heights followed by uint32 ranges
+std::string binary_response(const std::vector<int16_t>& heights,
+                            const std::vector<uint32_t>& ranges) {
+  std::string binary;
+  for (const auto height : heights) {
+    binary.push_back(static_cast<char>(height & 0xFF));
+    binary.push_back(static_cast<char>((height >> 8) & 0xFF));
+  }
+  for (const auto range : ranges) {
+    for (int i = 0; i < 4; ++i) {
+      binary.push_back(static_cast<char>((range >> (i * 8)) & 0xFF));
+    }
+  }
+  return binary;
+}
+
 const std::vector<std::string> responses{
     std::string(
         "{\"shape\":[{\"lat\":40.712431,\"lon\":-76.504916},{\"lat\":40.712275,\"lon\":-76.605259},"
@@ -153,6 +175,7 @@ const std::vector<std::string> responses{
         "320,322,323,324,328,359,445,452,463,463,448,405,393,336,329,326,316,311,309,308,289,291,"
         "292,292,291,289,278,279,279,280,281,281,280,281,281,282,282,282,280,276,251,248,247,246,"
         "244,243,240,239,239,238,239,241,241,239,236,221,221,225,224]}"),
+    binary_response({307, 272, 204, 204, 180, 198}, {0, 8467, 25380, 32162, 42309, 54533}),
 };
 
 const auto config =
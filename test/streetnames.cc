@@ -108,6 +108,30 @@ TEST(Streetnames, TestGetNonRouteNumbers) {
                         StreetNames({{"Sheridan Circle", false}}));
 }
 
+TEST(Streetnames, TestInterned) {
+  // the names made with the same interner share the strings of equal names
+  StreetNameInterner interner;
+  StreetNames lhs({{"Hershey Road", false}, {"PA 743 North", true}}, &interner);
+  StreetNames rhs({{"Fishburn Road", false}, {"PA 743 North", true}}, &interner);
+  EXPECT_EQ(lhs.back()->shared_value(), rhs.back()->shared_value());
+  EXPECT_NE(lhs.front()->shared_value(), rhs.front()->shared_value());
+  EXPECT_EQ(*lhs.back(), *rhs.back());
+
+  // and so do the lists made from them
+  auto common = lhs.FindCommonStreetNames(rhs);
+  ASSERT_EQ(common->size(), 1);
+  EXPECT_EQ(common->front()->shared_value(), lhs.back()->shared_value());
+  EXPECT_EQ(lhs.clone()->front()->shared_value(), lhs.front()->shared_value());
+  EXPECT_EQ(lhs.GetRouteNumbers()->front()->shared_value(), lhs.back()->shared_value());
+
+  // names which arent interned are still compared by their strings
+  StreetNames other({{"PA 743 North", true}});
+  EXPECT_NE(other.front()->shared_value(), lhs.back()->shared_value());
+  EXPECT_EQ(*other.front(), *lhs.back());
+  EXPECT_EQ(lhs.FindCommonStreetNames(other)->ToString(), "PA 743 North");
+  EXPECT_FALSE(*other.front() == StreetName("PA 743 North", false));
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
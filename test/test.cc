@@ -139,7 +139,8 @@ boost::property_tree::ptree make_config(const std::string& path_prefix,
           "transit_available",
           "expansion",
           "centroid",
-          "status"
+          "status",
+          "tile"
         ],
         "logging": {
           "color": false,
@@ -1,9 +1,11 @@
 #include "test.h"
 
+#include "loki/worker.h"
 #include "midgard/logging.h"
 #include "thor/attributes_controller.h"
 #include "thor/worker.h"
 #include "tyr/actor.h"
+#include <set>
 #include <thread>
 #include <unistd.h>
 
@@ -117,6 +119,100 @@ TEST(ThorWorker, test_linear_references) {
   }
 }
 
+TEST(ThorWorker, test_arena_request) {
+  loki::loki_worker_t loki_worker(conf);
+  thor_worker_t thor_worker(conf);
+  uint32_t length = 0;
+  for (int i = 0; i < 3; ++i) {
+    // each request frees the one before it, the first block of the arena grows to fit them
+    auto& request = thor_worker.arena_request();
+    ASSERT_NE(request.GetArena(), nullptr);
+    EXPECT_FALSE(request.has_trip());
+    ParseApi(R"({"costing":"auto","locations":[
+          {"lat":52.09110,"lon":5.09806},
+          {"lat":52.09098,"lon":5.09679}]})",
+             Options::route, request);
+    loki_worker.route(request);
+    thor_worker.route(request);
+    ASSERT_EQ(request.trip().routes_size(), 1);
+    ASSERT_EQ(request.trip().routes(0).legs_size(), 1);
+    const auto& leg = request.trip().routes(0).legs(0);
+    EXPECT_GT(leg.node_size(), 1);
+    if (i > 0) {
+      EXPECT_EQ(leg.shape().size(), length);
+    }
+    length = leg.shape().size();
+    loki_worker.cleanup();
+    thor_worker.cleanup();
+  }
+}
+
+TEST(ThorWorker, test_reload_shared_graph_reader) {
+  // without a shared reader there is nothing to reload
+  EXPECT_FALSE(reload_shared_graph_reader(conf));
+
+  auto config = conf;
+  config.put("mjolnir.thread_safe_reader", true);
+  auto before = shared_graph_reader(config);
+  ASSERT_NE(before, nullptr);
+  const auto generation = shared_graph_reader_generation();
+  reloading_worker_t<thor_worker_t> worker(
+      [&config]() { return new thor_worker_t(config, shared_graph_reader(config)); });
+  EXPECT_EQ(&worker.latest(), &worker.current());
+  EXPECT_GT(before.use_count(), 1);
+
+  // the worker lets go of the old reader the next time it is asked for
+  ASSERT_TRUE(reload_shared_graph_reader(config));
+  EXPECT_EQ(shared_graph_reader_generation(), generation + 1);
+  auto after = shared_graph_reader(config);
+  EXPECT_NE(after, before);
+  auto& latest = worker.latest();
+  EXPECT_EQ(before.use_count(), 1);
+  EXPECT_GT(after.use_count(), 1);
+  EXPECT_EQ(&latest, &worker.latest());
+}
+
+TEST(ThorWorker, test_reload_failure_keeps_old_worker) {
+  auto config = conf;
+  config.put("mjolnir.thread_safe_reader", true);
+  ASSERT_NE(shared_graph_reader(config), nullptr);
+  bool fail = false;
+  reloading_worker_t<int> worker([&fail]() -> int* {
+    if (fail) {
+      throw std::runtime_error("bad extract");
+    }
+    return new int(shared_graph_reader_generation());
+  });
+  auto* old = &worker.latest();
+
+  // the worker that cant be made again doesnt take the old one with it
+  fail = true;
+  ASSERT_TRUE(reload_shared_graph_reader(config));
+  EXPECT_EQ(&worker.latest(), old);
+  EXPECT_EQ(&worker.current(), old);
+
+  // and it is made once it can be
+  fail = false;
+  EXPECT_EQ(worker.latest(), static_cast<int>(shared_graph_reader_generation()));
+}
+
+TEST(ThorWorker, test_numa_nodes) {
+  // every cpu is on one node at most
+  const auto nodes = numa_nodes();
+  std::set<int> cpus;
+  for (const auto& node : nodes) {
+    for (auto cpu : node) {
+      EXPECT_TRUE(cpus.insert(cpu).second);
+    }
+  }
+  EXPECT_FALSE(pin_to_numa_node(nodes.size()));
+#ifdef __linux__
+  if (!nodes.empty()) {
+    std::thread([]() { EXPECT_TRUE(pin_to_numa_node(0)); }).join();
+  }
+#endif
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
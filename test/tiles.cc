@@ -123,6 +123,13 @@ TEST(Tiles, TileList) {
   AABB2<PointLL> bbox4(PointLL(-76.489998f, 40.509998f), PointLL(-76.480003f, 40.520000f));
   tilelist = tiles.TileList(bbox4);
   EXPECT_EQ(tilelist.size(), 1) << "Wrong number of tiles found in TileList";
+
+  // Filling in a list gets the same tiles and drops what was in it before
+  std::vector<int32_t> reused(5, -1);
+  for (const auto& box : {bbox, bbox2, bbox3, bbox4}) {
+    tiles.TileList(box, reused);
+    EXPECT_EQ(reused, tiles.TileList(box)) << "Filled in TileList does not match";
+  }
 }
 
 using intersect_t = std::unordered_map<int32_t, std::unordered_set<unsigned short>>;
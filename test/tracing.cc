@@ -0,0 +1,69 @@
+#include "midgard/tracing.h"
+
+#include <thread>
+
+#include "test.h"
+
+using namespace valhalla::midgard;
+
+namespace {
+
+// the events of a dump
+rapidjson::Document events() {
+  rapidjson::Document doc;
+  doc.Parse(tracing::dump());
+  EXPECT_FALSE(doc.HasParseError());
+  EXPECT_TRUE(doc.IsArray());
+  return doc;
+}
+
+TEST(Tracing, SpansOfEachThread) {
+  tracing::clear();
+  { tracing::span_t span("outer"); }
+  std::thread([]() { tracing::span_t span("other thread"); }).join();
+
+  auto doc = events();
+  ASSERT_EQ(doc.Size(), 2);
+  EXPECT_STREQ(doc[0]["name"].GetString(), "outer");
+  EXPECT_STREQ(doc[0]["ph"].GetString(), "X");
+  EXPECT_GE(doc[0]["dur"].GetDouble(), 0);
+  EXPECT_STREQ(doc[1]["name"].GetString(), "other thread");
+  EXPECT_NE(doc[0]["tid"].GetInt(), doc[1]["tid"].GetInt());
+  EXPECT_EQ(doc[0]["pid"].GetInt(), doc[1]["pid"].GetInt());
+
+  tracing::clear();
+  EXPECT_EQ(events().Size(), 0);
+}
+
+TEST(Tracing, RingKeepsTheNewest) {
+  tracing::clear();
+  for (size_t i = 0; i < tracing::kRingSize; ++i) {
+    tracing::record("old", i, i + 1);
+  }
+  tracing::record("new", tracing::kRingSize, tracing::kRingSize + 1);
+
+  // the oldest span was overwritten and the rest come out in the order they were recorded
+  auto doc = events();
+  ASSERT_EQ(doc.Size(), tracing::kRingSize);
+  EXPECT_DOUBLE_EQ(doc[0]["ts"].GetDouble(), 0.001);
+  EXPECT_STREQ(doc[doc.Size() - 1]["name"].GetString(), "new");
+  tracing::clear();
+}
+
+TEST(Tracing, MacroOnlyWhenEnabled) {
+  tracing::clear();
+  { VALHALLA_TRACE_SPAN("macro"); }
+#ifdef ENABLE_TRACING
+  EXPECT_EQ(events().Size(), 1);
+#else
+  EXPECT_EQ(events().Size(), 0);
+#endif
+  tracing::clear();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,126 @@
+#include "thor/transit_timetable.h"
+
+#include "baldr/graphconstants.h"
+#include "baldr/graphtile.h"
+#include "baldr/transitschedule.h"
+#include "filesystem.h"
+#include "mjolnir/graphtilebuilder.h"
+
+#include "test.h"
+
+#include <memory>
+
+using namespace valhalla;
+using namespace valhalla::baldr;
+
+namespace {
+
+const std::string tile_dir = "test/data/transit_timetable";
+const GraphId tile_id(756425, 3, 0);
+
+// A line with a fixed departure on every day, one on no day, one without wheelchair access and
+// a frequency based one every 5 minutes. Another line leaves before all of them
+graph_tile_ptr make_tile() {
+  filesystem::remove_all(tile_dir);
+  mjolnir::GraphTileBuilder builder(tile_dir, tile_id, false);
+  builder.AddTransitSchedule(TransitSchedule(~0ULL, kAllDaysOfWeek, 60));
+  builder.AddTransitSchedule(TransitSchedule(0ULL, 0, 60));
+  builder.AddTransitDeparture(TransitDeparture(1, 10, 0, 0, 0, 3600, 60, 0, true, true));
+  builder.AddTransitDeparture(TransitDeparture(1, 11, 0, 0, 0, 3000, 60, 1, true, true));
+  builder.AddTransitDeparture(TransitDeparture(1, 12, 0, 0, 0, 7200, 60, 0, false, true));
+  builder.AddTransitDeparture(TransitDeparture(1, 13, 0, 0, 0, 4000, 5000, 300, 60, 0, true, true));
+  builder.AddTransitDeparture(TransitDeparture(2, 20, 0, 0, 0, 100, 60, 0, true, true));
+  builder.StoreTileData();
+  return GraphTile::Create(tile_dir, tile_id);
+}
+
+TEST(TransitTimetable, LineDepartures) {
+  auto tile = make_tile();
+  ASSERT_TRUE(tile);
+  EXPECT_EQ(tile->GetLineDepartures(1).size(), 4);
+  EXPECT_EQ(tile->GetLineDepartures(2).size(), 1);
+  EXPECT_EQ(tile->GetLineDepartures(3).size(), 0);
+  for (const auto& departure : tile->GetLineDepartures(1)) {
+    EXPECT_EQ(departure.lineid(), 1);
+  }
+}
+
+TEST(TransitTimetable, NextDeparture) {
+  auto tile = make_tile();
+  ASSERT_TRUE(tile);
+  thor::TransitTimetable timetable;
+  timetable.Reset(0, kMonday, false, false, false);
+
+  // the departure which doesnt run on the day is skipped
+  auto departure = timetable.GetNextDeparture(tile, 1, 0);
+  ASSERT_NE(departure, nullptr);
+  EXPECT_EQ(departure->tripid(), 10);
+  EXPECT_EQ(departure->departure_time(), 3600);
+
+  // the frequency based departures are each of their times
+  departure = timetable.GetNextDeparture(tile, 1, 3601);
+  ASSERT_NE(departure, nullptr);
+  EXPECT_EQ(departure->tripid(), 13);
+  EXPECT_EQ(departure->departure_time(), 4000);
+  departure = timetable.GetNextDeparture(tile, 1, 4601);
+  ASSERT_NE(departure, nullptr);
+  EXPECT_EQ(departure->departure_time(), 4900);
+
+  departure = timetable.GetNextDeparture(tile, 1, 4901);
+  ASSERT_NE(departure, nullptr);
+  EXPECT_EQ(departure->tripid(), 12);
+  EXPECT_EQ(timetable.GetNextDeparture(tile, 1, 7201), nullptr);
+  EXPECT_EQ(timetable.GetNextDeparture(tile, 2, 0)->tripid(), 20);
+  EXPECT_EQ(timetable.GetNextDeparture(tile, 3, 0), nullptr);
+
+  // the same as the tile finds
+  for (uint32_t time : {0, 3601, 4601, 4901}) {
+    std::unique_ptr<const TransitDeparture> frequency_departure;
+    auto expected = tile->GetNextDeparture(1, time, 0, kMonday, false, false, false);
+    if (expected->type() == kFrequencySchedule) {
+      frequency_departure.reset(expected);
+    }
+    departure = timetable.GetNextDeparture(tile, 1, time);
+    EXPECT_EQ(departure->tripid(), expected->tripid()) << time;
+    EXPECT_EQ(departure->departure_time(), expected->departure_time()) << time;
+  }
+}
+
+TEST(TransitTimetable, TileNextDeparture) {
+  auto tile = make_tile();
+  ASSERT_TRUE(tile);
+
+  // the fixed departure after the frequency based ones end
+  auto departure = tile->GetNextDeparture(1, 4901, 0, kMonday, false, false, false);
+  ASSERT_NE(departure, nullptr);
+  EXPECT_EQ(departure->tripid(), 12);
+  EXPECT_EQ(tile->GetNextDeparture(1, 4901, 0, kMonday, false, true, false), nullptr);
+  EXPECT_EQ(tile->GetNextDeparture(1, 7201, 0, kMonday, false, false, false), nullptr);
+  EXPECT_EQ(tile->GetNextDeparture(3, 0, 0, kMonday, false, false, false), nullptr);
+
+  // the frequency based departure leaves before the next fixed one
+  std::unique_ptr<const TransitDeparture> frequency_departure(
+      tile->GetNextDeparture(1, 3601, 0, kMonday, false, false, false));
+  ASSERT_NE(frequency_departure, nullptr);
+  EXPECT_EQ(frequency_departure->tripid(), 13);
+  EXPECT_EQ(frequency_departure->departure_time(), 4000);
+}
+
+TEST(TransitTimetable, Wheelchair) {
+  auto tile = make_tile();
+  ASSERT_TRUE(tile);
+  thor::TransitTimetable timetable;
+  timetable.Reset(0, kMonday, false, true, false);
+  EXPECT_EQ(timetable.GetNextDeparture(tile, 1, 4901), nullptr);
+
+  // a new day forgets the lines of the last one
+  timetable.Reset(0, kMonday, false, false, false);
+  ASSERT_NE(timetable.GetNextDeparture(tile, 1, 4901), nullptr);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -45,6 +45,29 @@ TEST(UniqueNames, TestAddAndIndex) {
   EXPECT_EQ(names.name(index6), "I-95 N");
 }
 
+TEST(UniqueNames, Grow) {
+  // enough names to rehash the table a few times
+  UniqueNames names;
+  std::vector<uint32_t> indexes;
+  for (int i = 0; i < 10000; ++i) {
+    indexes.push_back(names.index("Street " + std::to_string(i)));
+  }
+  EXPECT_EQ(names.Size(), 10000);
+  for (int i = 0; i < 10000; ++i) {
+    EXPECT_EQ(names.index("Street " + std::to_string(i)), indexes[i]);
+    EXPECT_EQ(names.name(indexes[i]), "Street " + std::to_string(i));
+  }
+
+  // the blank name is always first and anything out of range is blank too
+  EXPECT_EQ(names.index(""), 0);
+  EXPECT_EQ(names.name(0), "");
+  EXPECT_EQ(names.name(10001), "");
+
+  // a prefix of another name is its own name
+  EXPECT_NE(names.index("Street 1"), names.index("Street 10"));
+  EXPECT_EQ(names.Size(), 10000);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -764,6 +764,44 @@ TEST(UtilMidgard, PolygonArea) {
   }
 }
 
+TEST(UtilMidgard, ProjectOntoShape) {
+  std::mt19937 generator(17);
+  std::uniform_real_distribution<double> offset(-0.01, 0.01);
+  const PointLL center(-76.3, 40.1);
+  for (size_t count : {0, 1, 2, 3, 15, 16, 17, 33, 100}) {
+    // a wiggly shape with a repeated point and a location near it
+    std::vector<PointLL> shape;
+    for (size_t i = 0; i < count; ++i) {
+      shape.emplace_back(center.lng() + offset(generator), center.lat() + offset(generator));
+      if (i == count / 2)
+        shape.push_back(shape.back());
+    }
+    PointLL location(center.lng() + offset(generator), center.lat() + offset(generator));
+    projector_t projector(location);
+
+    // the same as one segment at a time
+    PointLL expected_point;
+    double expected_sq_distance = std::numeric_limits<double>::max();
+    size_t expected_segment = 0;
+    for (size_t i = 0; i + 1 < shape.size(); ++i) {
+      auto point = projector(shape[i], shape[i + 1]);
+      auto sq_distance = projector.approx.DistanceSquared(point);
+      if (sq_distance < expected_sq_distance) {
+        expected_point = point;
+        expected_sq_distance = sq_distance;
+        expected_segment = i;
+      }
+    }
+
+    PointLL point;
+    double sq_distance;
+    auto segment = projector.closest(shape.data(), shape.size(), point, sq_distance);
+    EXPECT_EQ(segment, expected_segment) << count;
+    EXPECT_EQ(sq_distance, expected_sq_distance) << count;
+    EXPECT_EQ(point, expected_point) << count;
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
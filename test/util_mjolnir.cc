@@ -5,8 +5,10 @@
 #include <boost/property_tree/ptree.hpp>
 
 #include "baldr/graphid.h"
+#include "baldr/graphtile.h"
 #include "baldr/rapidjson_utils.h"
 #include "filesystem.h"
+#include "mjolnir/sortedmultimap.h"
 #include "mjolnir/util.h"
 
 #include "test.h"
@@ -23,6 +25,7 @@ namespace {
 using boost::property_tree::ptree;
 using valhalla::baldr::GraphId;
 using valhalla::mjolnir::build_tile_set;
+using valhalla::mjolnir::SortedMultiMap;
 using valhalla::mjolnir::TileManifest;
 using namespace valhalla;
 using namespace valhalla::midgard;
@@ -93,6 +96,61 @@ TEST(UtilMjolnir, TileManifestLogToFile) {
   EXPECT_EQ(read.tileset[GraphId{5970554}], manifest.tileset[GraphId{5970554}]);
 }
 
+TEST(UtilMjolnir, SortedMultiMap) {
+  SortedMultiMap<uint64_t, int> map;
+  for (int i = 0; i < 10; ++i) {
+    map.insert({static_cast<uint64_t>(i % 3 * 2), i});
+  }
+
+  // cant search it before its sorted
+  EXPECT_THROW(map.equal_range(2), std::logic_error);
+  map.sort();
+
+  // missing keys give an empty range at the end
+  for (uint64_t key : {1, 3, 7}) {
+    auto range = map.equal_range(key);
+    EXPECT_EQ(range.first, map.end());
+    EXPECT_EQ(range.second, map.end());
+  }
+
+  // the values of a key are in the order they were inserted
+  std::vector<int> values;
+  auto range = map.equal_range(2);
+  for (auto it = range.first; it != range.second; ++it) {
+    values.push_back(it->second);
+  }
+  EXPECT_EQ(values, (std::vector<int>{1, 4, 7}));
+  EXPECT_EQ(std::distance(map.equal_range(0).first, map.equal_range(0).second), 4);
+  EXPECT_EQ(map.size(), 10);
+
+  // adding in order keeps it sorted
+  map.insert({4, 10});
+  EXPECT_EQ(std::distance(map.equal_range(4).first, map.equal_range(4).second), 4);
+}
+
+TEST(UtilMjolnir, SortByTileSize) {
+  const std::string tile_dir(VALHALLA_BINARY_DIR "test/data/sort_by_tile_size");
+  filesystem::remove_all(tile_dir);
+  const std::vector<std::pair<GraphId, size_t>> tiles = {{GraphId{5970538}, 10},
+                                                         {GraphId{5970546}, 30},
+                                                         {GraphId{5970554}, 10},
+                                                         {GraphId{5970562}, 20}};
+  for (const auto& tile : tiles) {
+    auto file = tile_dir + filesystem::path::preferred_separator +
+                baldr::GraphTile::FileSuffix(tile.first);
+    filesystem::create_directories(filesystem::path(file).parent_path());
+    std::ofstream(file, std::ios::binary) << std::string(tile.second, 'x');
+  }
+
+  // the biggest first, the ones of the same size and the missing ones keep their order
+  std::deque<GraphId> queue{GraphId{5970570}, GraphId{5970554}, GraphId{5970538},
+                            GraphId{5970562}, GraphId{5970546}};
+  mjolnir::sort_by_tile_size(tile_dir, queue);
+  EXPECT_EQ(queue, (std::deque<GraphId>{GraphId{5970546}, GraphId{5970562}, GraphId{5970554},
+                                        GraphId{5970538}, GraphId{5970570}}));
+  filesystem::remove_all(tile_dir);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
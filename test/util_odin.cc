@@ -15,6 +15,12 @@ TEST(UtilOdin, test_get_locales) {
   const auto& init = get_locales();
   EXPECT_GE(init.size(), 1) << "Should be at least one parsable test json file";
   EXPECT_NE(init.find("en-US"), init.cend()) << "Should find 'en-US' locales file";
+
+  // aliases are known without parsing anything and share the dictionary of their locale
+  ASSERT_NE(init.find("en"), init.cend()) << "Should find the 'en' alias";
+  EXPECT_EQ(init.at("en").language_tag(), "en-US");
+  EXPECT_EQ(&*init.at("en"), &*init.at("en-US"));
+  EXPECT_EQ(init.at("en")->GetLanguageTag(), "en-US");
 }
 
 void try_get_formatted_time(const std::string& date_time,
@@ -237,6 +237,32 @@ void test_viterbi_search(const std::vector<Column>& columns) {
   }
 }
 
+TEST(ViterbiSearch, TestForget) {
+  // every tenth column has one state so the best path has to go through it
+  auto counts = generate_column_counts(200, std::uniform_int_distribution<size_t>(1, 20));
+  for (size_t i = 0; i < counts.size(); i += 10) {
+    counts[i] = 1;
+  }
+  const auto& columns = generate_columns(std::uniform_int_distribution<int>(0, 50),
+                                         std::uniform_int_distribution<int>(0, 100), counts);
+
+  SimpleViterbiSearch expected(columns);
+  SimpleViterbiSearch vs(columns);
+  for (StateId::Time time = 0; time < columns.size(); time++) {
+    const auto& winner = vs.SearchWinner(time);
+    const auto& expected_winner = expected.SearchWinner(time);
+    ASSERT_EQ(winner, expected_winner) << time;
+    ASSERT_EQ(vs.AccumulatedCost(winner), expected.AccumulatedCost(expected_winner)) << time;
+    // nothing before a column with one state can change the path after it
+    if (columns[time].size() == 1 && time > 0) {
+      vs.Forget(time);
+      EXPECT_FALSE(vs.HasStateId(StateId(time - 1, 0)));
+      EXPECT_TRUE(vs.HasStateId(StateId(time, 0)));
+      EXPECT_LT(vs.AccumulatedCost(StateId(time - 1, 0)), 0.);
+    }
+  }
+}
+
 TEST(ViterbiSearch, TestViterbiSearch) {
   // small case for visualization
   {
@@ -0,0 +1,140 @@
+#ifndef VALHALLA_BALDR_CONTRACTIONHIERARCHY_H_
+#define VALHALLA_BALDR_CONTRACTIONHIERARCHY_H_
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/midgard/util.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * A contraction hierarchy overlay over the routing graph. Every node of the graph gets a rank and
+ * the arcs, original directed edges, hierarchy transitions and the shortcuts added while
+ * contracting the nodes in rank order, are split into those leading up in rank, which a forward
+ * search follows, and those coming down in rank, which a backward search follows in reverse.
+ * Because of that both searches only ever go up which keeps them tiny even for long routes.
+ *
+ * The overlay only captures a single static metric, the one it was built with, and it does not
+ * know about turn costs or restrictions so it is up to the user to validate the unpacked path.
+ */
+class ContractionHierarchy {
+public:
+  static constexpr uint32_t kInvalidNode = std::numeric_limits<uint32_t>::max();
+  static constexpr uint32_t kInvalidArc = std::numeric_limits<uint32_t>::max();
+
+  // An arc is either an original directed edge, a transition between hierarchy levels, which doesnt
+  // have an edge, or a shortcut over the arcs first and second
+  struct arc_t {
+    uint64_t edgeid;
+    uint32_t from;
+    uint32_t to;
+    float cost;
+    uint32_t first;
+    uint32_t second;
+    uint32_t spare;
+
+    bool is_shortcut() const {
+      return first != kInvalidArc;
+    }
+  };
+
+  ContractionHierarchy() = default;
+
+  /**
+   * Builds the overlay from contracted arcs.
+   * @param nodes  the graph nodes sorted by their id
+   * @param arcs   the arcs between the nodes, including the shortcuts
+   * @param rank   the order in which each of the nodes was contracted
+   */
+  ContractionHierarchy(std::vector<GraphId>&& nodes,
+                       std::vector<arc_t>&& arcs,
+                       const std::vector<uint32_t>& rank);
+
+  /**
+   * Loads the overlay from a file written by Save.
+   * @param file  the path to the file
+   */
+  explicit ContractionHierarchy(const std::string& file);
+
+  /**
+   * Writes the overlay to a file.
+   * @param file  the path to the file
+   */
+  void Save(const std::string& file) const;
+
+  /**
+   * Get the index of a graph node within the overlay.
+   * @param node  the graph node
+   * @return the index of the node or kInvalidNode if the overlay does not have it
+   */
+  uint32_t node_index(const GraphId& node) const;
+
+  /**
+   * Get the graph node at an index.
+   * @param index  the index of the node
+   * @return the graph node
+   */
+  const GraphId& node(const uint32_t index) const {
+    return nodes_[index];
+  }
+
+  /**
+   * Get an arc.
+   * @param index  the index of the arc
+   * @return the arc
+   */
+  const arc_t& arc(const uint32_t index) const {
+    return arcs_[index];
+  }
+
+  /**
+   * Get the arcs leaving a node towards higher ranked nodes.
+   * @param index  the index of the node
+   * @return the indices of the arcs
+   */
+  midgard::iterable_t<const uint32_t> upward(const uint32_t index) const {
+    return {up_arcs_.data() + up_index_[index], up_arcs_.data() + up_index_[index + 1]};
+  }
+
+  /**
+   * Get the arcs entering a node from higher ranked nodes.
+   * @param index  the index of the node
+   * @return the indices of the arcs
+   */
+  midgard::iterable_t<const uint32_t> downward(const uint32_t index) const {
+    return {down_arcs_.data() + down_index_[index], down_arcs_.data() + down_index_[index + 1]};
+  }
+
+  /**
+   * Appends the directed edges an arc stands for, in order, to a list.
+   * @param index  the index of the arc
+   * @param edges  the list to append the directed edges to
+   */
+  void Unpack(const uint32_t index, std::vector<GraphId>& edges) const;
+
+  size_t node_count() const {
+    return nodes_.size();
+  }
+
+  size_t arc_count() const {
+    return arcs_.size();
+  }
+
+protected:
+  std::vector<GraphId> nodes_;
+  std::vector<arc_t> arcs_;
+  std::vector<uint32_t> up_index_;
+  std::vector<uint32_t> up_arcs_;
+  std::vector<uint32_t> down_index_;
+  std::vector<uint32_t> down_arcs_;
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_CONTRACTIONHIERARCHY_H_
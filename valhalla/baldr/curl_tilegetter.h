@@ -39,6 +39,21 @@ public:
     return result;
   }
 
+  std::vector<response_t> get(const std::vector<std::string>& urls) override {
+    scoped_curler_t curler(curlers_);
+    std::vector<long> http_codes;
+    auto tile_data = curler.get()(urls, http_codes, gzipped_, interrupt_);
+    std::vector<response_t> results(urls.size());
+    for (size_t i = 0; i < urls.size(); ++i) {
+      if (http_codes[i] == 200) {
+        results[i].bytes_ = std::move(tile_data[i]);
+        results[i].status_ = tile_getter_t::status_code_t::SUCCESS;
+      }
+    }
+
+    return results;
+  }
+
   bool gzipped() const override {
     return gzipped_;
   }
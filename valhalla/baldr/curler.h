@@ -35,6 +35,22 @@ struct curler_t {
                                bool gzipped,
                                const interrupt_t* interrupt) const;
 
+  /**
+   * Fetch many urls at once and return the bytes that we got for each of them. The transfers share
+   * connections which stay open between calls, over http/2 they are multiplexed on just one.
+   * Unlike fetching a single url a failed transfer doesnt throw, it just has no http code
+   *
+   * @param  urls               the urls to fetch
+   * @param  http_codes         the codes we got back when fetching, 0 if the transfer failed
+   * @param  gzipped            whether to request for gzip compressed data
+   * @param  interrupt          throws if the requests should be interrupted
+   * @return the bytes we fetched in the same order as the urls
+   */
+  std::vector<std::vector<char>> operator()(const std::vector<std::string>& urls,
+                                            std::vector<long>& http_codes,
+                                            bool gzipped,
+                                            const interrupt_t* interrupt) const;
+
   /**
    * Allow only moves and forbid copies. We don't want
    * several curlers to share the same state to completely exclude
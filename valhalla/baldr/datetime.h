@@ -82,13 +82,25 @@ std::string iso_date_time(const date::time_zone* time_zone);
  */
 uint64_t seconds_since_epoch(const std::string& date_time, const date::time_zone* time_zone);
 
+/**
+ * Get the offset of a timezone from UTC at a point in time. The offsets come from tables of the
+ * transitions of each timezone which are shared by every thread in the process. A table covers a
+ * window of a couple of years around the time it was made for and is made again around any time
+ * which falls outside of it, so apart from that a lookup never asks the tz database.
+ * @param   seconds       seconds since epoch
+ * @param   time_zone     timezone
+ * @return Returns the offset in seconds, 0 if there is no timezone.
+ */
+int utc_offset(const uint64_t seconds, const date::time_zone* time_zone);
+
 /**
  * Get the difference between two timezones using the current time (seconds from epoch
  * so that DST can be take into account).
  * @param   seconds       seconds since epoch
  * @param   origin_tz     timezone for origin
  * @param   dest_tz       timezone for dest
- * @param   cache         a cache for timezone sys_info lookup (since its expensive)
+ * @param   cache         a cache for timezone sys_info lookup, without one the offsets come from
+ *                        the tables shared by the whole process, see utc_offset
  * @return Returns the seconds difference between the 2 timezones.
  */
 using tz_sys_info_cache_t = std::unordered_map<const date::time_zone*, std::vector<date::sys_info>>;
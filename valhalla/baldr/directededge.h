@@ -1160,13 +1160,32 @@ protected:
 
 /**
  * Extended directed edge attribution. This structure provides the ability to add extra
- * attribution per directed edge without breaking backward compatibility. For now this structure
- * is unused.
+ * attribution per directed edge without breaking backward compatibility.
  */
 class DirectedEdgeExt {
+public:
+  DirectedEdgeExt() : opp_edge_id_(kInvalidGraphId), spare0_(0) {
+  }
+
+  /**
+   * Gets the id of the opposing directed edge, saves looking at the end node of the edge
+   * @return  Returns the opposing edge id, invalid if it was not stored
+   */
+  GraphId opp_edge_id() const {
+    return GraphId(opp_edge_id_);
+  }
+
+  /**
+   * Sets the id of the opposing directed edge
+   * @param  opp_edge_id  the opposing edge id
+   */
+  void set_opp_edge_id(const GraphId& opp_edge_id) {
+    opp_edge_id_ = opp_edge_id.value;
+  }
 
 protected:
-  uint64_t spare0_ : 64;
+  uint64_t opp_edge_id_ : 46; // GraphId of the opposing directed edge
+  uint64_t spare0_ : 18;
 };
 
 } // namespace baldr
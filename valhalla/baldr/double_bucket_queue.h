@@ -3,6 +3,8 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <type_traits>
+#include <utility>
 #include <valhalla/baldr/graphconstants.h>
 #include <valhalla/midgard/util.h>
 #include <vector>
@@ -20,14 +22,33 @@ using buckets_t = std::vector<bucket_t>;
  * reduced memory use. Costs outside the current bucket "range" get placed
  * into the overflow bucket and are moved into the low-level buckets as
  * needed. Each bucket stores label indexes into external data.
+ *
+ * Optionally the overflow can be split into a number of coarse buckets, each
+ * as wide as the whole low-level range, in front of the final overflow bucket.
+ * Once the low-level buckets run dry only the next coarse bucket is moved into
+ * them, rather than scanning the entire overflow each time, which is what makes
+ * long searches whose costs cover many multiples of the range stall.
+ *
+ * The sort costs are those of the labels. When they are integers, fixed point costs in some unit
+ * of the labels' choosing, all of the bucket arithmetic is done in integers as well: the bucket
+ * size has to be a power of 2 so a cost finds its bucket with a shift, and equal costs always
+ * land in the same bucket.
  */
-template <typename label_t> class DoubleBucketQueue final {
+template <typename label_t,
+          typename sortcost_t = std::decay_t<decltype(std::declval<const label_t&>().sortcost())>>
+class DoubleBucketQueue final {
+  static constexpr bool kFixedPoint = std::is_integral<sortcost_t>::value;
+  // Floating point costs keep the low level range in floats and where it starts in a double,
+  // fixed point costs keep all of them in 64 bit integers
+  using cost_t = std::conditional_t<kFixedPoint, int64_t, float>;
+  using offset_t = std::conditional_t<kFixedPoint, int64_t, double>;
+
 public:
   /**
    * Default c-tor creates empty object that needs to be initialized with `reuse` method
    */
   DoubleBucketQueue() {
-    reuse(0.f, 1.f, 1, nullptr);
+    reuse(0, 1, 1, nullptr);
   }
 
   /**
@@ -40,12 +61,15 @@ public:
    * @param bucketsize Bucket size (range of costs within same bucket).
    *                   Must be an integer value.
    * @param labelcontainer  Container of labels with sortcosts.
+   * @param overflowcount   Number of coarse buckets to split the overflow into,
+   *                        0 keeps a single overflow bucket.
    */
-  DoubleBucketQueue(const float mincost,
-                    const float range,
+  DoubleBucketQueue(const sortcost_t mincost,
+                    const sortcost_t range,
                     const uint32_t bucketsize,
-                    const std::vector<label_t>* labelcontainer) {
-    reuse(mincost, range, bucketsize, labelcontainer);
+                    const std::vector<label_t>* labelcontainer,
+                    const uint32_t overflowcount = 0) {
+    reuse(mincost, range, bucketsize, labelcontainer, overflowcount);
   }
 
   DoubleBucketQueue(DoubleBucketQueue&&) = default;
@@ -60,21 +84,29 @@ public:
    *                   bucket sorting.
    * @param range      Cost range for low-level buckets.
    * @param bucketsize Bucket size (range of costs within same bucket).
-   *                   Must be an integer value.
+   *                   Must be an integer value, a power of 2 for fixed point costs.
    * @param labelcontainer  Container of labels with sortcosts.
+   * @param overflowcount   Number of coarse buckets to split the overflow into,
+   *                        0 keeps a single overflow bucket.
    */
-  void reuse(const float mincost,
-             const float range,
+  void reuse(const sortcost_t mincost,
+             const sortcost_t range,
              const uint32_t bucketsize,
-             const std::vector<label_t>* labelcontainer) {
+             const std::vector<label_t>* labelcontainer,
+             const uint32_t overflowcount = 0) {
     labelcontainer_ = labelcontainer;
     // We need at least a bucketsize of 1 or more
     if (bucketsize < 1) {
       throw std::runtime_error("Bucketsize must be 1 or greater");
     }
 
+    // Fixed point costs find their bucket with a shift
+    if (kFixedPoint && (bucketsize & (bucketsize - 1))) {
+      throw std::runtime_error("Bucketsize must be a power of 2 for fixed point costs");
+    }
+
     // We need at least a bucketrange of something larger than 0
-    if (range <= 0.f) {
+    if (range <= 0) {
       throw std::runtime_error("Bucketrange must be greater than 0");
     }
 
@@ -83,8 +115,12 @@ public:
     currentcost_ = (c - (c % bucketsize));
     mincost_ = currentcost_;
     bucketrange_ = range;
-    bucketsize_ = static_cast<float>(bucketsize);
-    inv_ = 1.0f / bucketsize_;
+    bucketsize_ = static_cast<cost_t>(bucketsize);
+    inv_ = 1.0f / bucketsize;
+    shift_ = 0;
+    while ((uint64_t(1) << shift_) < bucketsize) {
+      ++shift_;
+    }
 
     // Set the maximum cost (above this goes into the overflow bucket)
     maxcost_ = mincost_ + bucketrange_;
@@ -95,6 +131,12 @@ public:
 
     // Set the current bucket to the lowest cost low level bucket
     currentbucket_ = buckets_.begin();
+
+    // The coarse overflow buckets start where the low level ones end
+    coarsebuckets_.resize(overflowcount);
+    coarsecost_ = maxcost_;
+    currentcoarse_ = 0;
+    resorts_ = 0;
   }
 
   /**
@@ -104,6 +146,9 @@ public:
   void clear() {
     // Empty the overflow bucket and each bucket
     overflowbucket_.clear();
+    for (; currentcoarse_ < coarsebuckets_.size(); ++currentcoarse_) {
+      coarsebuckets_[currentcoarse_].clear();
+    }
     while (currentbucket_ != buckets_.end()) {
       currentbucket_->clear();
       currentbucket_++;
@@ -112,6 +157,7 @@ public:
     // Reset current bucket and cost
     currentcost_ = mincost_;
     currentbucket_ = buckets_.begin();
+    currentcoarse_ = 0;
   }
 
   /**
@@ -132,7 +178,7 @@ public:
    * @param  label        Label index to reorder.
    * @param  newcost      New sort cost.
    */
-  void decrease(const uint32_t label, const float newcost) {
+  void decrease(const uint32_t label, const sortcost_t newcost) {
     // Get the buckets of the previous and new costs. Nothing needs to be done
     // if old cost and the new cost are in the same buckets.
     bucket_t& prevbucket = get_bucket((*labelcontainer_)[label].sortcost());
@@ -150,21 +196,24 @@ public:
    *          kInvalidLabel if the buckets are empty.
    */
   uint32_t pop() {
-    if (empty()) {
-      // No labels found in the low-level buckets.
+    // No labels found in the low-level buckets.
+    while (empty()) {
+      // Move the next non empty coarse bucket into the low level buckets
+      if (empty_coarse()) {
+        continue;
+      }
       if (overflowbucket_.empty()) {
         // Return an invalid label if no labels are in the overflow buckets.
         // Reset currentbucket to the last bucket - in case another access of
         // adjacency list is done.
         --currentbucket_;
         return baldr::kInvalidLabel;
-      } else {
-        // Move labels from the overflow bucket to the low level buckets.
-        // Return invalid label if still empty.
-        empty_overflow();
-        if (empty()) {
-          return baldr::kInvalidLabel;
-        }
+      }
+      // Move labels from the overflow bucket to the low level buckets.
+      // Return invalid label if still empty.
+      empty_overflow();
+      if (empty() && !empty_coarse()) {
+        return baldr::kInvalidLabel;
       }
     }
 
@@ -174,13 +223,23 @@ public:
     return label;
   }
 
+  /**
+   * How many times labels were moved out of the overflow or a coarse bucket into the low level
+   * buckets since the last reuse, which is how often a search outgrew the range of the buckets.
+   * @return  Returns the number of moves.
+   */
+  uint32_t resorts() const {
+    return resorts_;
+  }
+
 private:
-  float bucketrange_; // Total range of costs in lower level buckets
-  float bucketsize_;  // Bucket size (range of costs in same bucket)
-  float inv_;         // 1/bucketsize (so we can avoid division)
-  double mincost_;    // Minimum cost within the low level buckets
-  float maxcost_;     // Above this goes into overflow bucket
-  float currentcost_; // Current cost
+  cost_t bucketrange_;  // Total range of costs in lower level buckets
+  cost_t bucketsize_;   // Bucket size (range of costs in same bucket)
+  float inv_;           // 1/bucketsize (so we can avoid division)
+  uint32_t shift_;      // log2 of the bucketsize (so fixed point costs avoid division)
+  offset_t mincost_;    // Minimum cost within the low level buckets
+  cost_t maxcost_;      // Above this goes into overflow bucket
+  cost_t currentcost_;  // Current cost
 
   // Low level buckets
   buckets_t buckets_;
@@ -191,19 +250,70 @@ private:
   // Overflow bucket
   bucket_t overflowbucket_;
 
+  // Coarse overflow buckets, each bucketrange_ wide starting at coarsecost_, the ones before
+  // currentcoarse_ have already been moved into the low level buckets
+  buckets_t coarsebuckets_;
+  offset_t coarsecost_;
+  size_t currentcoarse_;
+
   // Access to a container of labels to get cost given the label index.
   const std::vector<label_t>* labelcontainer_;
 
+  // Times labels were moved into the low level buckets
+  uint32_t resorts_ = 0;
+
   /**
    * Returns the bucket given the cost.
    * @param  cost  Cost.
    * @return Returns the bucket that the cost lies within.
    */
-  bucket_t& get_bucket(const float cost) {
+  bucket_t& get_bucket(const sortcost_t cost) {
     return (cost < currentcost_)
                ? *currentbucket_
-               : (cost < maxcost_) ? buckets_[static_cast<uint32_t>((cost - mincost_) * inv_)]
-                                   : overflowbucket_;
+               : (cost < maxcost_) ? buckets_[bucket_index(cost)] : get_overflow_bucket(cost);
+  }
+
+  /**
+   * Returns the index of the low-level bucket of a cost within their range.
+   * @param  cost  Cost.
+   * @return Returns the index of the bucket that the cost lies within.
+   */
+  uint32_t bucket_index(const sortcost_t cost) const {
+    return bucket_index(static_cast<offset_t>(cost) - mincost_,
+                        std::integral_constant<bool, kFixedPoint>{});
+  }
+  uint32_t bucket_index(const double offset, std::false_type) const {
+    return static_cast<uint32_t>(offset * inv_);
+  }
+  uint32_t bucket_index(const int64_t offset, std::true_type) const {
+    return static_cast<uint32_t>(offset >> shift_);
+  }
+
+  /**
+   * How many whole ranges the offset of a cost covers, rounding down.
+   */
+  static double floor_div(const double offset, const float range) {
+    return std::floor(offset / range);
+  }
+  static int64_t floor_div(const int64_t offset, const int64_t range) {
+    return offset / range - (offset % range < 0);
+  }
+
+  /**
+   * Returns the overflow bucket given a cost above the low-level buckets.
+   * @param  cost  Cost.
+   * @return Returns the coarse bucket the cost lies within or the overflow bucket.
+   */
+  bucket_t& get_overflow_bucket(const sortcost_t cost) {
+    if (coarsebuckets_.empty()) {
+      return overflowbucket_;
+    }
+    // the low level buckets cover the coarse bucket before currentcoarse_ so clamp to the current
+    const offset_t offset = static_cast<offset_t>(cost) - coarsecost_;
+    const size_t index =
+        std::max(offset > 0 ? static_cast<size_t>(offset / bucketrange_) : size_t(0),
+                 currentcoarse_);
+    return index < coarsebuckets_.size() ? coarsebuckets_[index] : overflowbucket_;
   }
 
   /**
@@ -224,6 +334,7 @@ private:
    * low level buckets.
    */
   void empty_overflow() {
+    ++resorts_;
     // Get the minimum label so we can figure out where the new range should be
     auto itr =
         std::min_element(overflowbucket_.begin(), overflowbucket_.end(),
@@ -235,8 +346,8 @@ private:
     if (itr != overflowbucket_.end()) {
 
       // Adjust cost range so smallest element is in the buckets_
-      float min = (*labelcontainer_)[*itr].sortcost();
-      mincost_ += (std::floor((min - mincost_) / bucketrange_)) * bucketrange_;
+      sortcost_t min = (*labelcontainer_)[*itr].sortcost();
+      mincost_ += floor_div(static_cast<offset_t>(min) - mincost_, bucketrange_) * bucketrange_;
 
       // Avoid precision issues
       if (mincost_ > min) {
@@ -246,12 +357,21 @@ private:
       }
       maxcost_ = mincost_ + bucketrange_;
 
+      // The coarse buckets now start where the low level buckets end
+      coarsecost_ = maxcost_;
+      currentcoarse_ = 0;
+
       // Move elements within the range from overflow to buckets
       auto minLabelsIt =
           std::remove_if(overflowbucket_.begin(), overflowbucket_.end(), [this](const auto label) {
-            float cost = (*labelcontainer_)[label].sortcost();
+            sortcost_t cost = (*labelcontainer_)[label].sortcost();
             if (cost < maxcost_) {
-              buckets_[static_cast<uint32_t>((cost - mincost_) * inv_)].push_back(label);
+              buckets_[bucket_index(cost)].push_back(label);
+              return true;
+            }
+            auto& bucket = get_overflow_bucket(cost);
+            if (&bucket != &overflowbucket_) {
+              bucket.push_back(label);
               return true;
             }
             return false;
@@ -264,6 +384,37 @@ private:
     currentcost_ = mincost_;
     currentbucket_ = buckets_.begin();
   }
+
+  /**
+   * Moves the next non empty coarse bucket into the low level buckets.
+   * @return  Returns false if all of the coarse buckets were empty.
+   */
+  bool empty_coarse() {
+    while (currentcoarse_ < coarsebuckets_.size() && coarsebuckets_[currentcoarse_].empty()) {
+      ++currentcoarse_;
+    }
+    if (currentcoarse_ == coarsebuckets_.size()) {
+      return false;
+    }
+
+    ++resorts_;
+
+    // The low level buckets now cover exactly this coarse bucket
+    mincost_ = coarsecost_ + currentcoarse_ * bucketrange_;
+    maxcost_ = mincost_ + bucketrange_;
+    currentcost_ = mincost_;
+    currentbucket_ = buckets_.begin();
+
+    // Go through get_bucket so that decrease finds the labels where we put them, even if
+    // precision issues put a cost on the wrong side of the boundary
+    auto coarse = std::move(coarsebuckets_[currentcoarse_++]);
+    for (const auto label : coarse) {
+      get_bucket((*labelcontainer_)[label].sortcost()).push_back(label);
+    }
+    coarse.clear();
+    coarsebuckets_[currentcoarse_ - 1] = std::move(coarse);
+    return true;
+  }
 };
 
 } // namespace baldr
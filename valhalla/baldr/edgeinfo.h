@@ -3,12 +3,18 @@
 
 #include <cstdint>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <ostream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include <boost/utility/string_view.hpp>
+
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/json.h>
+#include <valhalla/midgard/aabb2.h>
 #include <valhalla/midgard/encoded.h>
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/midgard/util.h>
@@ -26,6 +32,10 @@ constexpr float kElevationBinSize = 2.0f;
 constexpr float kMinElevation = -500.0f;
 constexpr float kMaxElevation = kMinElevation + (kElevationBinSize * kMaxStoredElevation);
 
+// The elevations of the shape points are stored in decimeters, the first one above kMinElevation
+// and every one after it as the offset from the one before so that most fit in a single byte
+constexpr float kShapeElevationPrecision = 0.1f;
+
 // Name information. Information about names added to the names list within
 // the tile. A name can have a textual representation followed by optional
 // fields that provide additional information about the name.
@@ -54,9 +64,53 @@ struct NameInfo {
   }
 };
 
+/**
+ * The decoded shapes of the edges of a tile kept by the offset of their edge info, so that the
+ * shapes of popular edges are only decoded once no matter how many times they are asked for. It
+ * never keeps more than max_size bytes of points and it is simply emptied when a shape doesnt fit
+ * anymore. It is thread safe since the tiles are shared between the readers of all threads.
+ */
+class EdgeShapeCache {
+public:
+  using shape_ptr = std::shared_ptr<const std::vector<midgard::PointLL>>;
+
+  /**
+   * @param  max_size  The most bytes of shapes to keep, its what the tile is charged for the cache
+   */
+  explicit EdgeShapeCache(const size_t max_size);
+
+  /**
+   * Get the decoded shape of an edge info, decoding it if it isnt cached yet.
+   * @param  offset   Offset of the edge info within the tile, the key of its shape
+   * @param  encoded  The varint encoded shape
+   * @param  size     Bytes of encoded shape
+   * @return  Returns the shape, which stays valid after it is dropped from the cache.
+   */
+  shape_ptr Get(const uint32_t offset, const char* encoded, const size_t size);
+
+  /**
+   * Get the most bytes of shapes the cache keeps.
+   */
+  size_t max_size() const {
+    return max_size_;
+  }
+
+  /**
+   * Get the bytes of the shapes in the cache right now.
+   */
+  size_t size() const;
+
+protected:
+  mutable std::mutex mutex_;
+  std::unordered_map<uint32_t, shape_ptr> shapes_;
+  size_t size_;
+  const size_t max_size_;
+};
+
 /**
  * Edge information not required in shortest path algorithm and is
- * common among the 2 directions.
+ * common among the 2 directions. It is a view of the memory of the tile, only the fixed size
+ * part is copied and the rest is read when it is asked for.
  */
 class EdgeInfo {
 public:
@@ -71,8 +125,14 @@ public:
    * @param  ptr  Pointer to a bit of memory that has the info for this edge
    * @param  names_list  Pointer to the start of the text/names list.
    * @param  names_list_length  Length (bytes) of the text/names list.
+   * @param  shape_cache  Optional cache of the decoded shapes of the tile the edge info is in
+   * @param  offset  Offset of the edge info within the tile, the key for the shape cache
    */
-  EdgeInfo(char* ptr, const char* names_list, const size_t names_list_length);
+  EdgeInfo(char* ptr,
+           const char* names_list,
+           const size_t names_list_length,
+           EdgeShapeCache* shape_cache = nullptr,
+           const uint32_t offset = 0);
 
   /**
    * Destructor
@@ -84,8 +144,11 @@ public:
    * @return  Returns the OSM way Id.
    */
   uint64_t wayid() const {
-    return (static_cast<uint64_t>(extended_wayid3_) << 56) |
-           (static_cast<uint64_t>(extended_wayid2_) << 48) |
+    // the optional last 2 bytes of a 64bit wayid follow the shape
+    const auto* extended_wayid = reinterpret_cast<const uint8_t*>(extra_);
+    const uint64_t extended_wayid2 = ei_.extended_wayid_size_ > 0 ? extended_wayid[0] : 0;
+    const uint64_t extended_wayid3 = ei_.extended_wayid_size_ > 1 ? extended_wayid[1] : 0;
+    return (extended_wayid3 << 56) | (extended_wayid2 << 48) |
            (static_cast<uint64_t>(ei_.extended_wayid1_) << 40) |
            (static_cast<uint64_t>(ei_.extended_wayid0_) << 32) | static_cast<uint64_t>(ei_.wayid_);
   }
@@ -98,6 +161,20 @@ public:
     return kMinElevation + (ei_.mean_elevation_ * kElevationBinSize);
   }
 
+  /**
+   * Does the edge info have the elevations of its shape points.
+   * @return  Returns true if the elevation of each shape point is stored.
+   */
+  bool has_elevation() const {
+    return ei_.has_elevation_;
+  }
+
+  /**
+   * Get the elevation of each shape point, in the order of the shape and not of the edge.
+   * @return  Returns the elevations in meters relative to sea level, empty if they arent stored.
+   */
+  std::vector<float> elevation() const;
+
   /**
    * Get the bike network mask for this directed edge.
    * @return  Returns the bike network mask for this directed edge.
@@ -137,6 +214,22 @@ public:
    */
   NameInfo GetNameInfo(uint8_t index) const;
 
+  /**
+   * Get the text of the name for the specified name index without copying it out of the text
+   * list of the tile. Tagged names start with their tag type.
+   * @param  index  Index into the name list.
+   * @return  Returns the name, valid as long as the tile is.
+   */
+  boost::string_view GetName(uint8_t index) const;
+
+  /**
+   * Get the names for an edge without copying them out of the text list of the tile.
+   * @param  only_tagged_names  Bool indicating whether or not to return only the tagged names
+   *
+   * @return   Returns a list (vector) of names, valid as long as the tile is.
+   */
+  std::vector<boost::string_view> GetNameViews(bool only_tagged_names = false) const;
+
   /**
    * Convenience method to get the names for an edge
    * @param  only_tagged_names  Bool indicating whether or not to return only the tagged names
@@ -166,7 +259,7 @@ public:
   uint16_t GetTypes() const;
 
   /**
-   * Get the shape of the edge.
+   * Get the shape of the edge. It is shared with the shape cache of the tile if it has one.
    * @return  Returns the the list of lat,lng points describing the
    *          shape of the edge.
    */
@@ -176,12 +269,24 @@ public:
     return midgard::Shape7Decoder<midgard::PointLL>(encoded_shape_, ei_.encoded_shape_size_);
   }
 
+  /**
+   * Get the bounding box of the shape of the edge without making its points.
+   * @return  Returns the bounding box of the shape.
+   */
+  midgard::AABB2<midgard::PointLL> shape_bounding_box() const;
+
   /**
    * Returns the encoded shape string.
    * @return  Returns the encoded shape string.
    */
   std::string encoded_shape() const;
 
+  /**
+   * Returns the encoded elevations of the shape points.
+   * @return  Returns the varint encoded elevations, empty if they arent stored.
+   */
+  std::string encoded_elevation() const;
+
   /**
    * Returns json representing this object
    * @return json object
@@ -204,7 +309,8 @@ public:
     uint32_t encoded_shape_size_ : 16; // How many bytes long the encoded shape is
     uint32_t extended_wayid1_ : 8;     // Next next byte of the way id
     uint32_t extended_wayid_size_ : 2; // How many more bytes the way id is stored in
-    uint32_t spare0_ : 2;              // not used
+    uint32_t has_elevation_ : 1;       // Are the elevations of the shape points stored
+    uint32_t spare0_ : 1;              // not used
   };
 
 protected:
@@ -217,18 +323,29 @@ protected:
   // The encoded shape of the edge
   const char* encoded_shape_;
 
-  // Where we optionally keep the last 2 bytes of a 64bit wayid
-  uint8_t extended_wayid2_;
-  uint8_t extended_wayid3_;
+  // What follows the shape, the optional last 2 bytes of a 64bit wayid and then the optional
+  // size and varint encoded elevations of the shape points
+  const char* extra_;
 
   // Lng, lat shape of the edge
   mutable std::vector<midgard::PointLL> shape_;
 
+  // Where the shape comes from instead when the tile caches its decoded shapes
+  EdgeShapeCache* shape_cache_;
+  uint32_t offset_;
+  mutable EdgeShapeCache::shape_ptr cached_shape_;
+
   // The list of names within the tile
   const char* names_list_;
 
   // The size of the names list
   size_t names_list_length_;
+
+  // Get the text at an offset in the names list, what is the caller for the error if its outside
+  boost::string_view GetText(const uint32_t offset, const char* what) const;
+
+  // Get the varint encoded elevations of the shape points, empty if they arent stored
+  boost::string_view GetEncodedElevation() const;
 };
 
 } // namespace baldr
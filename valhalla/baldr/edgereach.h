@@ -0,0 +1,120 @@
+#ifndef VALHALLA_BALDR_EDGEREACH_H_
+#define VALHALLA_BALDR_EDGEREACH_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * The conservative inbound and outbound reach of every edge of the routing graph for a few
+ * costings with their default options, so that loki does not have to run a reach expansion for
+ * each candidate edge of each request. The reach of an edge is the number of nodes the expansion
+ * of loki::Reach settles from it up to a cap, not counting the nodes of the other levels twice.
+ * Only the road levels are covered and the edges of a tile are stored contiguously so an edge is
+ * found from its tile. Live traffic closures are not part of the table.
+ *
+ * The reaches belong to the tiles they were computed from and have to be rebuilt with them.
+ */
+class EdgeReach {
+public:
+  // Where the edges of a tile start within the reaches and how many of them there are
+  struct tile_t {
+    uint64_t tile;
+    uint32_t offset;
+    uint32_t edge_count;
+  };
+
+  // The reach of an edge for one costing, at most the cap
+  struct reach_t {
+    uint8_t outbound;
+    uint8_t inbound;
+  };
+
+  EdgeReach() = default;
+
+  /**
+   * Builds the table from the reaches of every edge for each of the costings.
+   * @param cap       the largest reach the expansions looked for
+   * @param costings  the valhalla::Costing of each column of the table
+   * @param tiles     the tiles sorted by their id, their offsets count edges
+   * @param reaches   for every edge the reach for each of the costings
+   */
+  EdgeReach(uint8_t cap,
+            std::vector<uint8_t>&& costings,
+            std::vector<tile_t>&& tiles,
+            std::vector<reach_t>&& reaches);
+
+  /**
+   * Loads the table from a file written by Save.
+   * @param file  the path to the file
+   */
+  explicit EdgeReach(const std::string& file);
+
+  /**
+   * Writes the table to a file.
+   * @param file  the path to the file
+   */
+  void Save(const std::string& file) const;
+
+  /**
+   * Get the column of a costing within the table.
+   * @param costing  the valhalla::Costing
+   * @return the column or -1 if the table does not have the costing
+   */
+  int costing_index(const uint8_t costing) const {
+    for (size_t i = 0; i < costings_.size(); ++i) {
+      if (costings_[i] == costing) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  /**
+   * Get the reach of an edge for a costing.
+   * @param edge           the directed edge
+   * @param costing_index  the column of the costing
+   * @return the reach of the edge or nullptr if the table does not have the edge
+   */
+  const reach_t* reach(const GraphId& edge, const size_t costing_index) const {
+    auto found = tile_index_.find(edge.Tile_Base().value);
+    if (found == tile_index_.cend() || edge.id() >= tiles_[found->second].edge_count) {
+      return nullptr;
+    }
+    const size_t index = static_cast<size_t>(tiles_[found->second].offset) + edge.id();
+    return reaches_.data() + index * costings_.size() + costing_index;
+  }
+
+  uint8_t cap() const {
+    return cap_;
+  }
+
+  const std::vector<uint8_t>& costings() const {
+    return costings_;
+  }
+
+  size_t edge_count() const {
+    return costings_.empty() ? 0 : reaches_.size() / costings_.size();
+  }
+
+protected:
+  uint8_t cap_{};
+  std::vector<uint8_t> costings_;
+  std::vector<tile_t> tiles_;
+  std::vector<reach_t> reaches_;
+  std::unordered_map<uint64_t, uint32_t> tile_index_;
+
+  // fills in the lookup of the tiles
+  void IndexTiles();
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_EDGEREACH_H_
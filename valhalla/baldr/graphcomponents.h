@@ -0,0 +1,113 @@
+#ifndef VALHALLA_BALDR_GRAPHCOMPONENTS_H_
+#define VALHALLA_BALDR_GRAPHCOMPONENTS_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * The connected component of every edge of the routing graph for a few access modes, so that
+ * loki can reject the locations of a request which no path can connect before any search runs.
+ * An edge is in the component of the nodes it connects if the mode has access to it in either
+ * direction, so the components are the weakly connected ones of the graph without turn
+ * restrictions, node access or oneways. They can only put more of the graph together than a
+ * route could, two edges in different components never have a route between them for a costing
+ * of the mode. Only the road levels are covered and the edges of a tile are stored contiguously
+ * so an edge is found from its tile.
+ *
+ * The components belong to the tiles they were computed from and have to be rebuilt with them.
+ */
+class GraphComponents {
+public:
+  // The component of an edge which the mode has no access to
+  static constexpr uint32_t kNoComponent = UINT32_MAX;
+
+  // Where the edges of a tile start within the components and how many of them there are
+  struct tile_t {
+    uint64_t tile;
+    uint32_t offset;
+    uint32_t edge_count;
+  };
+
+  GraphComponents() = default;
+
+  /**
+   * Builds the table from the components of every edge for each of the access modes.
+   * @param modes       the access mask of each column of the table
+   * @param tiles       the tiles sorted by their id, their offsets count edges
+   * @param components  for every edge the component for each of the modes
+   */
+  GraphComponents(std::vector<uint16_t>&& modes,
+                  std::vector<tile_t>&& tiles,
+                  std::vector<uint32_t>&& components);
+
+  /**
+   * Loads the table from a file written by Save.
+   * @param file  the path to the file
+   */
+  explicit GraphComponents(const std::string& file);
+
+  /**
+   * Writes the table to a file.
+   * @param file  the path to the file
+   */
+  void Save(const std::string& file) const;
+
+  /**
+   * Get the column of an access mode within the table.
+   * @param mode  the access mask of a costing
+   * @return the column or -1 if the table does not have the mode
+   */
+  int mode_index(const uint32_t mode) const {
+    for (size_t i = 0; i < modes_.size(); ++i) {
+      if (modes_[i] == mode) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  /**
+   * Get the component of an edge for an access mode.
+   * @param edge        the directed edge
+   * @param mode_index  the column of the mode
+   * @return the component or kNoComponent if the table does not have the edge or the mode has
+   *         no access to it
+   */
+  uint32_t component(const GraphId& edge, const size_t mode_index) const {
+    auto found = tile_index_.find(edge.Tile_Base().value);
+    if (found == tile_index_.cend() || edge.id() >= tiles_[found->second].edge_count) {
+      return kNoComponent;
+    }
+    const size_t index = static_cast<size_t>(tiles_[found->second].offset) + edge.id();
+    return components_[index * modes_.size() + mode_index];
+  }
+
+  const std::vector<uint16_t>& modes() const {
+    return modes_;
+  }
+
+  size_t edge_count() const {
+    return modes_.empty() ? 0 : components_.size() / modes_.size();
+  }
+
+protected:
+  std::vector<uint16_t> modes_;
+  std::vector<tile_t> tiles_;
+  std::vector<uint32_t> components_;
+  std::unordered_map<uint64_t, uint32_t> tile_index_;
+
+  // fills in the lookup of the tiles
+  void IndexTiles();
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_GRAPHCOMPONENTS_H_
@@ -217,6 +217,25 @@ public:
   friend std::ostream& operator<<(std::ostream& os, const GraphId& id);
 };
 
+/**
+ * Hash of a GraphId which mixes all of the bits of its value. Ids of the same tile only differ in
+ * their highest bits and std::hash is the identity on the value, which is fine for the prime
+ * number of buckets of the std containers but clusters in open addressing tables whose capacity
+ * is a power of 2. Use this one with those.
+ */
+struct GraphIdHasher {
+  std::size_t operator()(const GraphId& id) const {
+    // the finalizer of murmur3
+    uint64_t h = id.value;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return static_cast<std::size_t>(h);
+  }
+};
+
 } // namespace baldr
 } // namespace valhalla
 
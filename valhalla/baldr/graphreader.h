@@ -1,11 +1,17 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include <boost/property_tree/ptree.hpp>
 
@@ -91,6 +97,12 @@ public:
    *  Some implementations may simply clear the entire cache
    */
   virtual void Trim() = 0;
+
+  /**
+   * How many tiles were dropped from the cache, be it to make room or by clearing it
+   * @return the number of evicted tiles
+   */
+  virtual size_t Evictions() const = 0;
 };
 
 /**
@@ -150,6 +162,14 @@ public:
    */
   void Trim() override;
 
+  /**
+   * How many tiles were dropped from the cache, be it to make room or by clearing it
+   * @return the number of evicted tiles
+   */
+  size_t Evictions() const override {
+    return evictions_;
+  }
+
 protected:
   inline uint32_t get_offset(const GraphId& graphid) const {
     return graphid.level() < 4 ? index_offsets_[graphid.level()] + graphid.tileid()
@@ -174,6 +194,8 @@ protected:
 
   // The max cache size in bytes
   size_t max_cache_size_;
+  // The number of tiles dropped from the cache
+  size_t evictions_;
 };
 
 /**
@@ -233,6 +255,14 @@ public:
    */
   void Trim() override;
 
+  /**
+   * How many tiles were dropped from the cache, be it to make room or by clearing it
+   * @return the number of evicted tiles
+   */
+  size_t Evictions() const override {
+    return evictions_;
+  }
+
 protected:
   // The actual cached GraphTile objects
   std::unordered_map<uint64_t, graph_tile_ptr> cache_;
@@ -242,6 +272,8 @@ protected:
 
   // The max cache size in bytes
   size_t max_cache_size_;
+  // The number of tiles dropped from the cache
+  size_t evictions_;
 };
 
 /**
@@ -308,12 +340,23 @@ public:
    */
   void Trim() override;
 
+  /**
+   * How many tiles were dropped from the cache, be it to make room or by clearing it
+   * @return the number of evicted tiles
+   */
+  size_t Evictions() const override {
+    return evictions_;
+  }
+
 protected:
   struct KeyValue {
-    KeyValue(GraphId id_, graph_tile_ptr tile_) : id(id_), tile(std::move(tile_)) {
+    KeyValue(GraphId id_, graph_tile_ptr tile_, size_t size_)
+        : id(id_), tile(std::move(tile_)), size(size_) {
     }
     GraphId id;
     graph_tile_ptr tile;
+    // the size the tile was put into the cache with, this is what is freed on eviction
+    size_t size;
   };
   using KeyValueIter = std::list<KeyValue>::iterator;
 
@@ -350,6 +393,8 @@ protected:
 
   // The max cache size in bytes
   size_t max_cache_size_;
+  // The number of tiles dropped from the cache
+  size_t evictions_;
 };
 
 /**
@@ -409,11 +454,221 @@ public:
    */
   void Trim() override;
 
+  /**
+   * How many tiles were dropped from the cache, be it to make room or by clearing it
+   * @return the number of evicted tiles
+   */
+  size_t Evictions() const override;
+
 private:
   TileCache& cache_;
   std::mutex& mutex_ref_;
 };
 
+/**
+ * Tile cache which spreads its tiles over a number of independently locked shards so that concurrent
+ * readers only contend with each other when they are after tiles in the same shard.
+ * Copies share the same shards so many readers can use one cache.
+ * It is thread-safe, though sharing tiles across threads also requires
+ * ENABLE_THREAD_SAFE_TILE_REF_COUNT.
+ */
+class ShardedTileCache : public TileCache {
+public:
+  /**
+   * Constructor.
+   * @param max_size     maximum size of the cache, each shard gets an equal portion of it
+   * @param shard_count  number of shards to spread the tiles over
+   * @param lru          whether or not each shard should be an lru cache
+   * @param mem_control  strategy the lru shards will use to control their memory
+   */
+  ShardedTileCache(size_t max_size,
+                   size_t shard_count,
+                   bool lru = false,
+                   TileCacheLRU::MemoryLimitControl mem_control =
+                       TileCacheLRU::MemoryLimitControl::SOFT);
+
+  /**
+   * Reserves enough cache to hold (max_cache_size / tile_size) items.
+   * @param tile_size appeoximate size of one tile
+   */
+  void Reserve(size_t tile_size) override;
+
+  /**
+   * Checks if tile exists in the cache.
+   * @param graphid  the graphid of the tile
+   * @return true if tile exists in the cache
+   */
+  bool Contains(const GraphId& graphid) const override;
+
+  /**
+   * Puts a copy of a tile of into the cache.
+   * @param graphid  the graphid of the tile
+   * @param tile the graph tile
+   * @param size size of the tile in memory
+   */
+  graph_tile_ptr Put(const GraphId& graphid, graph_tile_ptr tile, size_t size) override;
+
+  /**
+   * Get a pointer to a graph tile object given a GraphId.
+   * @param graphid  the graphid of the tile
+   * @return GraphTile* a pointer to the graph tile
+   */
+  graph_tile_ptr Get(const GraphId& graphid) const override;
+
+  /**
+   * Lets you know if the cache is too large.
+   * @return true if the cache is over committed with respect to the limit
+   */
+  bool OverCommitted() const override;
+
+  /**
+   * Clears the cache.
+   */
+  void Clear() override;
+
+  /**
+   *  Does its best to reduce the cache size to remove overcommitted state.
+   *  Only the shards that are over committed are trimmed
+   */
+  void Trim() override;
+
+  /**
+   * How many tiles were dropped from the cache, be it to make room or by clearing it
+   * @return the number of evicted tiles
+   */
+  size_t Evictions() const override;
+
+  /**
+   * Returns the number of shards the tiles are spread over
+   */
+  size_t ShardCount() const {
+    return shards_->size();
+  }
+
+protected:
+  struct shard_t {
+    std::unique_ptr<TileCache> cache;
+    mutable std::mutex mutex;
+  };
+
+  // pick the shard by mixing the tile id and level, neighbouring tiles land in different shards
+  shard_t& shard(const GraphId& graphid) const {
+    const uint64_t key = graphid.Tile_Base();
+    return *(*shards_)[(key * 0x9E3779B97F4A7C15ull >> 32) % shards_->size()];
+  }
+
+  std::shared_ptr<std::vector<std::unique_ptr<shard_t>>> shards_;
+};
+
+/**
+ * Tile cache with a pinned tier for the tiles of some hierarchy levels, usually the highway and
+ * arterial levels almost every long route touches, and another cache for the rest. The pinned
+ * tier has a memory budget of its own and never evicts, only clearing the cache drops its tiles,
+ * so big requests on the local level cant push them out. Once the pinned tier is full the tiles of
+ * its levels go to the rest like all the others. Copies share the pinned tier.
+ * It is thread-safe if the cache of the rest is and the pinned tier is synchronized.
+ */
+class TieredTileCache : public TileCache {
+public:
+  /**
+   * Constructor.
+   * @param rest          the cache of the tiles which arent pinned
+   * @param levels        the hierarchy levels whose tiles are pinned
+   * @param max_size      maximum size of the pinned tier
+   * @param synchronized  whether the pinned tier is locked so it can be shared between threads
+   */
+  TieredTileCache(std::unique_ptr<TileCache>&& rest,
+                  const std::vector<uint32_t>& levels,
+                  size_t max_size,
+                  bool synchronized);
+
+  /**
+   * Constructor sharing the pinned tier of another cache.
+   * @param other  the cache whose pinned tier to share
+   * @param rest   the cache of the tiles which arent pinned
+   */
+  TieredTileCache(const TieredTileCache& other, std::unique_ptr<TileCache>&& rest);
+
+  /**
+   * Reserves enough cache to hold (max_cache_size / tile_size) items.
+   * @param tile_size appeoximate size of one tile
+   */
+  void Reserve(size_t tile_size) override;
+
+  /**
+   * Checks if tile exists in the cache.
+   * @param graphid  the graphid of the tile
+   * @return true if tile exists in the cache
+   */
+  bool Contains(const GraphId& graphid) const override;
+
+  /**
+   * Puts a copy of a tile of into the cache.
+   * @param graphid  the graphid of the tile
+   * @param tile the graph tile
+   * @param size size of the tile in memory
+   */
+  graph_tile_ptr Put(const GraphId& graphid, graph_tile_ptr tile, size_t size) override;
+
+  /**
+   * Get a pointer to a graph tile object given a GraphId.
+   * @param graphid  the graphid of the tile
+   * @return GraphTile* a pointer to the graph tile
+   */
+  graph_tile_ptr Get(const GraphId& graphid) const override;
+
+  /**
+   * Lets you know if the cache is too large, the pinned tier never is.
+   * @return true if the cache is over committed with respect to the limit
+   */
+  bool OverCommitted() const override;
+
+  /**
+   * Clears both tiers of the cache.
+   */
+  void Clear() override;
+
+  /**
+   *  Does its best to reduce the cache size to remove overcommitted state.
+   *  Only the rest is trimmed, the pinned tiles stay
+   */
+  void Trim() override;
+
+  /**
+   * How many tiles were dropped from the cache, be it to make room or by clearing it
+   * @return the number of evicted tiles
+   */
+  size_t Evictions() const override;
+
+  /**
+   * Returns how many bytes of tiles are in the pinned tier
+   */
+  size_t PinnedSize() const;
+
+protected:
+  struct pinned_t {
+    std::unordered_map<uint64_t, graph_tile_ptr> tiles;
+    uint32_t levels = 0; // a bit per pinned hierarchy level
+    size_t size = 0;
+    size_t max_size = 0;
+    size_t evictions = 0;
+    bool synchronized = false;
+    mutable std::mutex mutex;
+  };
+
+  bool pinned(const GraphId& graphid) const {
+    return graphid.level() < 32 && (pinned_->levels & (1u << graphid.level()));
+  }
+
+  std::unique_lock<std::mutex> lock() const {
+    return pinned_->synchronized ? std::unique_lock<std::mutex>(pinned_->mutex)
+                                 : std::unique_lock<std::mutex>();
+  }
+
+  std::shared_ptr<pinned_t> pinned_;
+  std::unique_ptr<TileCache> rest_;
+};
+
 /**
  * Creates tile caches.
  */
@@ -428,6 +683,32 @@ public:
   static TileCache* createTileCache(const boost::property_tree::ptree& pt);
 };
 
+/**
+ * Counters of where a reader found the tiles it was asked for and how long loading them took. They
+ * are atomic so the threads loading tiles in the background can count too and so that they can be
+ * read from any thread without locking
+ */
+struct tile_stats_t {
+  // where a tile was found
+  enum source_t : uint8_t { kCache = 0, kExtract, kShared, kDisk, kUrl, kNotFound, kSourceCount };
+  // load latencies are binned by powers of two microseconds, the last bin holds all slower ones
+  static constexpr size_t kLatencyBins = 20;
+
+  std::array<std::atomic<uint64_t>, kSourceCount> tiles{};
+  std::array<std::atomic<uint64_t>, kLatencyBins> load_latency{};
+  std::atomic<uint64_t> bytes_loaded{0};
+
+  void count(source_t source) {
+    tiles[source].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // counts a tile that was loaded from somewhere other than the cache
+  void loaded(source_t source, size_t bytes, std::chrono::steady_clock::duration elapsed);
+
+  // the name of the source for metrics
+  static const char* name(source_t source);
+};
+
 /**
  * Class that manages access to GraphTiles.
  * Uses TileCache to keep a cache of tiles.
@@ -443,7 +724,7 @@ public:
   explicit GraphReader(const boost::property_tree::ptree& pt,
                        std::unique_ptr<tile_getter_t>&& tile_getter = nullptr);
 
-  virtual ~GraphReader() = default;
+  virtual ~GraphReader();
 
   virtual void SetInterrupt(const tile_getter_t::interrupt_t* interrupt) {
     if (tile_getter_) {
@@ -476,6 +757,54 @@ public:
     return !tile || tile->id() != graphid.Tile_Base() ? tile = GetGraphTile(graphid) : tile;
   }
 
+  /**
+   * Starts loading the tiles in the background so that asking for them later does not have to wait
+   * on the disk or the network. Tiles already cached or already being loaded are skipped, as is
+   * everything when tile_prefetch_threads is not configured.
+   * @param graphids  the graphids of the tiles to load
+   */
+  void Prefetch(const std::vector<GraphId>& graphids) {
+    if (prefetcher_) {
+      for (const auto& graphid : graphids) {
+        Prefetch(graphid);
+      }
+    }
+  }
+
+  /**
+   * Starts loading the tile in the background so that asking for it later does not have to wait
+   * @param graphid  the graphid of the tile to load
+   */
+  void Prefetch(const GraphId& graphid) {
+    if (prefetcher_) {
+      PrefetchTile(graphid);
+    }
+  }
+
+  /**
+   * Loads the tiles on a number of threads and then adds them to the cache in order until it is
+   * full, so that the most used tiles can be loaded before taking any requests. The pages of
+   * extracts are faulted in rather than read. Tiles which dont exist are skipped.
+   * @param graphids      the graphids of the tiles to load, the most important first
+   * @param thread_count  how many threads to load tiles on
+   * @return how many of the tiles were added to the cache
+   */
+  size_t Warm(const std::vector<GraphId>& graphids, size_t thread_count = 1);
+
+  /**
+   * Reads the tile usage that readers configured with tile_usage_file append to the file. Counts
+   * of the same tile from different readers are added up
+   * @param file_name  the file the usage was written to
+   * @return the tiles ordered from the most to the least used
+   */
+  static std::vector<GraphId> ReadTileUsage(const std::string& file_name);
+
+  /**
+   * Appends how often each tile was asked for since the last time to the tile_usage_file. This
+   * happens periodically while counting and when the reader is destroyed.
+   */
+  void FlushTileUsage();
+
   /**
    * Get a pointer to a graph tile object given a PointLL and a Level
    * @param pointll  the lat,lng that the tile covers
@@ -502,6 +831,7 @@ public:
    */
   virtual void Clear() {
     cache_->Clear();
+    ClearIncidentIndices();
   }
 
   /**
@@ -510,6 +840,33 @@ public:
    */
   virtual void Trim() {
     cache_->Trim();
+    ClearIncidentIndices();
+  }
+
+  /**
+   * How many tiles were dropped from the cache, a quickly growing number means the cache is too
+   * small for the traffic and keeps loading the same tiles over again
+   * @return the number of evicted tiles
+   */
+  size_t CacheEvictions() const {
+    return cache_->Evictions();
+  }
+
+  /**
+   * Where the tiles this reader was asked for were found and how long loading them took. A thread
+   * safe reader keeps separate counters for every thread that uses it
+   * @return the counters of this reader or of the calling thread, they keep counting while the
+   *         reader is used
+   */
+  const tile_stats_t& GetTileStats() const {
+    return thread_safe_ ? ThreadTileStats() : tile_stats_;
+  }
+
+  /**
+   * Whether many threads can use this reader at once, see thread_safe_reader
+   */
+  bool ThreadSafe() const {
+    return thread_safe_;
   }
 
   /**
@@ -865,6 +1222,23 @@ public:
    */
   std::unordered_set<GraphId> GetTileSet(const uint8_t level) const;
 
+  /**
+   * How many bytes of the tiles of a level of the tile extract are resident in memory
+   * @param  level  the hierarchy level
+   * @return the resident bytes, 0 if there is no tile extract or no tiles on the level
+   */
+  size_t GetExtractResidentBytes(const uint8_t level) const {
+    return tile_extract_->resident_bytes(level);
+  }
+
+  /**
+   * Tells this reader apart from the others made in the process.
+   * @return the id of the reader
+   */
+  uint64_t id() const {
+    return id_;
+  }
+
   /**
    * Returns the tile directory.
    * @return  Returns the tile directory.
@@ -910,30 +1284,198 @@ protected:
   // (Tar) extract of tiles - the contents are empty if not being used
   struct tile_extract_t {
     tile_extract_t(const boost::property_tree::ptree& pt);
-    // TODO: dont remove constness, and actually make graphtile read only?
-    std::unordered_map<uint64_t, std::pair<char*, size_t>> tiles;
-    std::unordered_map<uint64_t, std::pair<char*, size_t>> traffic_tiles;
+
+    // valhalla_build_extract and the extract stage of the tile build write an index of the tiles
+    // as the first member of an archive so that we dont have to parse every file name to know
+    // which tile it is. the index is a packed array of these entries sorted by tile id
+    struct index_entry_t {
+      uint64_t offset;  // byte offset of the tile data from the beginning of the archive
+      uint32_t tile_id; // the level and tile id of the tile (ie graph id with no id)
+      uint32_t size;    // the size of the tile data in bytes
+    };
+    static constexpr char kIndexFileName[] = "index.bin";
+
+    /**
+     * A flat index of the tiles inside of an archive. The entries are kept in contiguous
+     * memory sorted by graph id so that finding a tile is a binary search rather than
+     * hashing into a node based map
+     */
+    class tile_index_t {
+    public:
+      // TODO: dont remove constness, and actually make graphtile read only?
+      using location_t = std::pair<char*, size_t>;
+      using value_type = std::pair<uint64_t, location_t>;
+      using const_iterator = std::vector<value_type>::const_iterator;
+
+      tile_index_t() = default;
+
+      /**
+       * Indexes the tiles in the archive either using the index member, if the archive has one and
+       * it agrees with the archive, or by parsing every file name in the archive as a tile id. If
+       * the archive was only partially loaded and the index is unusable the whole archive will be
+       * traversed
+       * @param archive  the archive whose tiles we want to index
+       */
+      explicit tile_index_t(midgard::tar& archive);
+
+      /**
+       * Finds the location of a tile in the archive
+       * @param id  the graph id of the tile
+       * @return the location of the tile or nullptr if its not in the archive
+       */
+      const location_t* find(uint64_t id) const {
+        auto entry = std::lower_bound(entries_.cbegin(), entries_.cend(), id,
+                                      [](const value_type& e, uint64_t id) { return e.first < id; });
+        return entry != entries_.cend() && entry->first == id ? &entry->second : nullptr;
+      }
+
+      bool empty() const {
+        return entries_.empty();
+      }
+      size_t size() const {
+        return entries_.size();
+      }
+      const_iterator begin() const {
+        return entries_.cbegin();
+      }
+      const_iterator end() const {
+        return entries_.cend();
+      }
+
+    protected:
+      // sorts the entries so they can be searched, of any duplicates the last one added wins just
+      // like it would if you extracted the archive to disk
+      void finalize();
+
+      std::vector<value_type> entries_;
+    };
+
+    /**
+     * Applies the tuning of the mapping of the archive from the config to the range of the
+     * archive the tiles of each level span: the advice, transparent huge pages and locking the
+     * levels which should never be faulted in again
+     * @param pt  the config of the reader
+     */
+    void tune_mapping(const boost::property_tree::ptree& pt);
+
+    /**
+     * How many bytes of the tiles of a level are resident in memory
+     * @param level  the hierarchy level
+     * @return the resident bytes of the pages the tiles of the level span
+     */
+    size_t resident_bytes(uint8_t level) const;
+
+    tile_index_t tiles;
+    tile_index_t traffic_tiles;
+    tile_index_t predicted_tiles;
     std::shared_ptr<midgard::tar> archive;
     std::shared_ptr<midgard::tar> traffic_archive;
+    std::shared_ptr<midgard::tar> predicted_archive;
+
+    // the byte range of the archive the tiles of each level span, empty for levels without tiles
+    std::vector<std::pair<uint64_t, uint64_t>> level_spans;
   };
   std::shared_ptr<const tile_extract_t> tile_extract_;
   static std::shared_ptr<const GraphReader::tile_extract_t>
   get_extract_instance(const boost::property_tree::ptree& pt);
 
+  // Gets a tile from the cache, the extract or wherever LoadTile finds it, without counting it as
+  // used for the usage file
+  graph_tile_ptr FindTile(const GraphId& base);
+
+  // Loads a tile from the shared tile dir, the tile dir or the tile url without touching the cache
+  graph_tile_ptr LoadTile(const GraphId& base);
+
+  // Loads many tiles like LoadTile, the ones which have to come from the tile url are all
+  // requested at once. The tiles are in the same order as the ids, nullptr for ones not found
+  std::vector<graph_tile_ptr> LoadTiles(const std::vector<GraphId>& bases);
+
+  // Queues a tile to be loaded by the prefetching threads
+  void PrefetchTile(const GraphId& graphid);
+
+  // Counts that the tile was asked for, every so often the counts are flushed to the usage file
+  void CountTileUsage(const GraphId& base);
+
+  // Puts a freshly loaded tile in the cache, with its shape cache and predicted speeds sidecar if
+  // there are to be any
+  graph_tile_ptr CacheTile(const GraphId& base, graph_tile_ptr&& tile);
+
+  // Writes out the tile usage, the lock if it holds one is let go of before writing to the file
+  void FlushTileUsage(std::unique_lock<std::mutex> shared);
+
+  // Forgets the incident indices, the next incidents of each tile index them again
+  void ClearIncidentIndices();
+
+  // The counters where tiles found are counted, those of the calling thread if it is thread safe
+  tile_stats_t& stats() {
+    return thread_safe_ ? ThreadTileStats() : tile_stats_;
+  }
+  tile_stats_t& ThreadTileStats() const;
+
   // Information about where the tiles are kept
   const std::string tile_dir_;
 
+  // Where decompressed tiles are published so every process on the host can mmap the same copy
+  const std::string shared_tile_dir_;
+
   // Stuff for getting at remote tiles
   std::unique_ptr<tile_getter_t> tile_getter_;
   const size_t max_concurrent_users_;
   const std::string tile_url_;
 
+  // Tiles the tile url didnt have and until when we wont ask for them again, once there are too
+  // many of them the ones we learned of first are forgotten first
+  bool NotFound(const GraphId& base);
+  void RememberNotFound(const GraphId& base);
+  const std::chrono::seconds not_found_ttl_;
   std::mutex _404s_lock;
-  std::unordered_set<GraphId> _404s;
+  std::unordered_map<GraphId, std::chrono::steady_clock::time_point> _404s;
+  std::deque<std::pair<GraphId, std::chrono::steady_clock::time_point>> _404s_order;
 
   std::unique_ptr<TileCache> cache_;
 
+  // The most bytes of decoded edge shapes each tile keeps, they are charged to the tile cache
+  const size_t tile_shape_cache_size_;
+
   bool enable_incidents_;
+
+  // Where the locations of each edge are in an incident tile. The locations are sorted by edge index
+  // so each edge with incidents has one contiguous range of them, the start of the range for the edge
+  // at edges[i] is offsets[i] and its end is offsets[i + 1]
+  struct incident_index_t {
+    std::shared_ptr<const IncidentsTile> tile;
+    std::vector<uint32_t> edges;
+    std::vector<int> offsets;
+  };
+  // Built the first time we look at each version of an incident tile, so that finding the incidents
+  // of an edge is a search over a flat array rather than over the protobuf locations
+  std::unordered_map<GraphId, incident_index_t> incident_indices_;
+
+  // Where tiles were found, the prefetching threads count here too
+  tile_stats_t tile_stats_;
+
+  // How often each tile was asked for, counted only when there is a file to write the counts to
+  const std::string tile_usage_file_;
+  std::unordered_map<GraphId, uint64_t> tile_usage_;
+  uint64_t tile_usage_count_;
+  std::chrono::steady_clock::time_point tile_usage_flushed_;
+
+  // Whether the reader is shared by threads, then the cache is one that is safe to share and the
+  // bookkeeping that isnt is locked
+  const bool thread_safe_;
+  mutable std::mutex shared_lock_;
+
+  // Tells readers apart, for the threads remembering whose counters they last used among others
+  const uint64_t id_;
+  static uint64_t next_reader_id();
+
+  // The counters of each thread using a thread safe reader
+  mutable std::unordered_map<std::thread::id, std::unique_ptr<tile_stats_t>> thread_stats_;
+
+  // Background threads loading tiles ahead of when they are needed, the threads call LoadTiles so
+  // this has to be last to be the first thing torn down
+  class tile_prefetcher_t;
+  std::unique_ptr<tile_prefetcher_t> prefetcher_;
 };
 
 // Given the Location relation, return the full metadata
@@ -16,6 +16,7 @@
 #include <valhalla/baldr/nodeinfo.h>
 #include <valhalla/baldr/nodetransition.h>
 #include <valhalla/baldr/predictedspeeds.h>
+#include <valhalla/baldr/routingedge.h>
 #include <valhalla/baldr/sign.h>
 #include <valhalla/baldr/signinfo.h>
 #include <valhalla/baldr/traffictile.h>
@@ -32,15 +33,19 @@
 
 #include <valhalla/filesystem.h>
 
+#include <array>
 #include <cstdint>
 #include <iterator>
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace valhalla {
 namespace baldr {
 
 const std::string SUFFIX_NON_COMPRESSED = ".gph";
 const std::string SUFFIX_COMPRESSED = ".gph.gz";
+const std::string SUFFIX_SECTIONED = ".gph.sec";
 
 class tile_getter_t;
 /**
@@ -97,6 +102,20 @@ public:
                                      tile_getter_t* tile_getter,
                                      const std::string& cache_location);
 
+  /**
+   * Constructs many tiles given a url for the tiles, they are all requested at once so a getter
+   * which can have several requests in flight doesnt wait on each tile in turn
+   * @param  tile_url URL of tiles
+   * @param  graphids Tile Ids
+   * @param  tile_getter object that will handle tile downloading
+   * @param  cache_location where to save the tiles to on disk, empty to not save them
+   * @return the tiles in the same order as the ids, nullptr for the ones we couldnt get
+   */
+  static std::vector<graph_tile_ptr> CacheTileURLs(const std::string& tile_url,
+                                                   const std::vector<GraphId>& graphids,
+                                                   tile_getter_t* tile_getter,
+                                                   const std::string& cache_location);
+
   /**
    * Construct a tile given a url for the tile using curl
    * @param  tile_data graph tile raw bytes
@@ -104,6 +123,24 @@ public:
    */
   static void SaveTileToFile(const std::vector<char>& tile_data, const std::string& disk_location);
 
+  /**
+   * Compresses the bytes of a tile as a sectioned tile. The nodes, edges and everything else
+   * the path algorithms read are compressed apart from the edge info, the text list and the lane
+   * connectivity, which are only inflated once something asks for the names, shapes, signs, admins
+   * or lanes of the tile. Routes which never look at those never pay to inflate them.
+   * @param  tile   the uncompressed bytes of the tile
+   * @param  level  what zlib compression level to use
+   * @return the bytes of the sectioned tile
+   */
+  static std::vector<char> CompressSections(const std::vector<char>& tile, int level = 9);
+
+  /**
+   * Whether the bytes are those of a sectioned tile made by CompressSections
+   * @param  data  the bytes to check
+   * @return true if the bytes start like a sectioned tile
+   */
+  static bool IsSectioned(const std::vector<char>& data);
+
   /**
    * Destructor
    */
@@ -149,6 +186,43 @@ public:
     return header_;
   }
 
+  /**
+   * Gets the approximate number of bytes this tile keeps in memory. This includes the tile data,
+   * whether it was read onto the heap or is memory mapped, any traffic data attached to the tile
+   * and the side structures decoded from the tile when it was initialized. A shape cache is charged
+   * for the most it may keep.
+   * @return  Returns the memory footprint of the tile in bytes.
+   */
+  size_t GetMemoryFootprint() const;
+
+  /**
+   * Keeps the decoded shapes of the edges of this tile, up to the given bytes of them, so that the
+   * shape of an edge info is only decoded once. It must be called before the tile is shared between
+   * threads and it cant be undone.
+   * @param  max_size  The most bytes of decoded shapes to keep.
+   */
+  void CacheShapes(const size_t max_size) const;
+
+  /**
+   * Reads the predicted speeds of this tile from a sidecar tile instead of from the tile itself,
+   * see PredictedSpeedTileHeader. Only the speed profiles come from the sidecar, edges it has no
+   * profile for have no predicted speed. It must be called before the tile is shared between
+   * threads and it cant be undone.
+   * @param  memory  The sidecar tile.
+   * @return false (leaving the tile as it was) if the sidecar does not belong to this tile
+   */
+  bool BindPredictedSpeeds(std::unique_ptr<const GraphMemory>&& memory) const;
+
+  /**
+   * Whether the directed edge has a predicted speed profile, either in the tile or in the bound
+   * sidecar tile.
+   * @param  de  Directed edge of this tile.
+   */
+  bool HasPredictedSpeed(const DirectedEdge* de) const {
+    return predicted_memory_ ? predictedspeeds_.has_speed(de - directededges_)
+                             : de->has_predicted_speed();
+  }
+
   /**
    * Get a pointer to a node.
    * @return  Returns a pointer to the node.
@@ -221,6 +295,22 @@ public:
         " directededgecount= " + std::to_string(header_->directededgecount()));
   }
 
+  /**
+   * Get a pointer to the routing attributes of an edge, the edges of a node are contiguous.
+   * @param  idx  Index of the directed edge within the current tile.
+   * @return  Returns a pointer to the routing edge.
+   */
+  const RoutingEdge* routing_edge(const size_t idx) const {
+    BindRoutingEdges();
+    if (idx < routing_edges_.size()) {
+      return &routing_edges_[idx];
+    }
+    throw std::runtime_error(
+        "GraphTile RoutingEdge index out of bounds: " + std::to_string(header_->graphid().tileid()) +
+        "," + std::to_string(header_->graphid().level()) + "," + std::to_string(idx) +
+        " directededgecount= " + std::to_string(header_->directededgecount()));
+  }
+
   /**
    * Get an iterable set of directed edges from a node in this tile
    * @param  node  Node from which the edges leave
@@ -256,6 +346,23 @@ public:
     return {endnode.tileid(), endnode.level(), node(endnode.id())->edge_index() + edge->opp_index()};
   }
 
+  /**
+   * Convenience method to get opposing edge Id given a directed edge of this tile. When the tile
+   * stores the opposing edge ids it is read from the edge's extended attributes, otherwise from
+   * the end node of the edge.
+   * @param  edge      Directed edge in this tile.
+   * @param  end_tile  The tile of the end node of the directed edge.
+   * @return Returns the GraphId of the opposing directed edge.
+   */
+  GraphId GetOpposingEdgeId(const DirectedEdge* edge, const GraphTile& end_tile) const {
+    if (ext_directededges_) {
+      auto opp_edge_id = ext_directededges_[edge - directededges_].opp_edge_id();
+      if (opp_edge_id.Is_Valid())
+        return opp_edge_id;
+    }
+    return end_tile.GetOpposingEdgeId(edge);
+  }
+
   /**
    * Get a pointer to a node transition.
    * @param  idx  Index of the directed edge within the current tile.
@@ -324,6 +431,17 @@ public:
    */
   EdgeInfo edgeinfo(const DirectedEdge* edge) const;
 
+  /**
+   * Makes sure the edge info, the text list and the lane connectivity are there to be read. Only
+   * sectioned tiles have anything to do, once and thread safe, the others are always inflated.
+   * Anything copying the memory of the tile as a whole has to call it first.
+   */
+  void ReadColdSections() const {
+    if (cold_sections_) {
+      InflateColdSections();
+    }
+  }
+
   /**
    * Get the complex restrictions in the forward or reverse order.
    * @param   forward - do we want the restrictions in reverse order?
@@ -395,7 +513,9 @@ public:
 
   /**
    * Get the next departure given the directed edge Id and the current
-   * time (seconds from midnight). TODO - what if crosses midnight?
+   * time (seconds from midnight). The fixed schedule departures of the line are binary searched
+   * for the first one at or after the time, the earliest of it and the next departure of each of
+   * the frequency based ones is returned. TODO - what if crosses midnight?
    * @param   lineid            Transit Line Id
    * @param   current_time      Current time (seconds from midnight).
    * @param   day               Days since the tile creation date.
@@ -433,6 +553,14 @@ public:
    */
   std::unordered_map<uint32_t, TransitDeparture*> GetTransitDepartures() const;
 
+  /**
+   * Get all of the departures along a transit line, whatever their schedule.
+   * @param   lineid  Transit Line Id
+   * @return  Returns the departures of the line, the fixed schedule ones sorted by departure time
+   *          followed by the frequency based ones sorted by their start time.
+   */
+  midgard::iterable_t<const TransitDeparture> GetLineDepartures(const uint32_t lineid) const;
+
   /**
    * Get the stop onestop Ids in this tile.
    * @return  Returns a map of transit stops with onestop Ids as the key and
@@ -503,6 +631,54 @@ public:
    */
   midgard::iterable_t<GraphId> GetBin(size_t index) const;
 
+  /**
+   * Get how many times a bin is split into quarters. The cells of the bin are a grid of 2^depth
+   * by 2^depth squares numbered row major starting from the bin's south west corner
+   * @param  index the bin's index in the row major array
+   * @return the depth of the bin's quadtree, 0 when the bin isnt split into cells
+   */
+  uint32_t GetBinCellDepth(size_t index) const {
+    return bin_cell_depths_ ? bin_cell_depths_[index] : 0;
+  }
+
+  /**
+   * Get the cells the edges of a bin touch as bit masks in the same order as the edges of GetBin.
+   * Edges which leave the bin or live in another tile touch all of the cells
+   * @param  index the bin's index in the row major array
+   * @return iterable container of the edges' cell masks, empty when the bin isnt split into cells
+   */
+  midgard::iterable_t<const uint64_t> GetBinCells(size_t index) const;
+
+  /**
+   * Get the bounding box of a bin of this tile
+   * @param  index the bin's index in the row major array
+   * @return the bounding box of the bin
+   */
+  midgard::AABB2<midgard::PointLL> BinBoundingBox(size_t index) const;
+
+  /**
+   * Get the cells of a bin which a box touches
+   * @param  bin_box  the bounding box of the bin
+   * @param  depth    the depth of the bin's quadtree
+   * @param  box      the box to find the cells of
+   * @return the bit mask of the touched cells, 0 when the box misses the bin
+   */
+  static uint64_t BinCellMask(const midgard::AABB2<midgard::PointLL>& bin_box,
+                              uint32_t depth,
+                              const midgard::AABB2<midgard::PointLL>& box);
+
+  /**
+   * Get the bounding box of a cell of a bin
+   * @param  bin_box  the bounding box of the bin
+   * @param  depth    the depth of the bin's quadtree
+   * @param  cell     the cell's index in the row major grid of cells
+   * @return the bounding box of the cell
+   */
+  static midgard::AABB2<midgard::PointLL>
+  BinCellBoundingBox(const midgard::AABB2<midgard::PointLL>& bin_box,
+                     uint32_t depth,
+                     uint32_t cell);
+
   /**
    * Get lane connections ending on this edge.
    * @param  idx  GraphId of the directed edge.
@@ -574,7 +750,7 @@ public:
     // use predicted speed if a time was passed in, the predicted speed layer was requested, and if
     // the edge has predicted speed
     auto invalid_time = seconds == kInvalidSecondsOfWeek;
-    if (!invalid_time && (flow_mask & kPredictedFlowMask) && de->has_predicted_speed()) {
+    if (!invalid_time && (flow_mask & kPredictedFlowMask) && HasPredictedSpeed(de)) {
       seconds %= midgard::kSecondsPerWeek;
       uint32_t idx = de - directededges_;
       float speed = predictedspeeds_.speed(idx, seconds);
@@ -640,7 +816,11 @@ public:
    */
   std::vector<uint16_t> turnlanes(const uint32_t idx) const {
     uint32_t offset = turnlanes_offset(idx);
-    return (offset > 0) ? TurnLanes::lanemasks(textlist_ + offset) : std::vector<uint16_t>();
+    if (offset == 0) {
+      return {};
+    }
+    ReadColdSections();
+    return TurnLanes::lanemasks(textlist_ + offset);
   }
 
   /**
@@ -688,6 +868,10 @@ protected:
   // List of directed edges. Fixed size structure indexed by Id within the tile.
   DirectedEdge* directededges_{};
 
+  // The routing attributes of the directed edges, made the first time they are asked for so that
+  // loading a tile doesnt have to touch all of its edges
+  mutable std::vector<RoutingEdge> routing_edges_;
+
   // Extended directed edge records. For expansion. These are indexed by the same
   // Id as the directed edge.
   DirectedEdgeExt* ext_directededges_{};
@@ -699,6 +883,10 @@ protected:
   // sorted by departure time)
   TransitDeparture* departures_{};
 
+  // Where the departures of each line start, one more than there are lines so the departures of
+  // line i are from line_departures_[i] up to line_departures_[i + 1]. Made when the tile is loaded
+  std::vector<uint32_t> line_departures_;
+
   // Transit stops (indexed by stop index within the tile)
   TransitStop* transit_stops_{};
 
@@ -733,6 +921,29 @@ protected:
   // Size of the complex restrictions in the reverse direction
   std::size_t complex_restriction_reverse_size_{};
 
+  // The edge each complex restriction is found by, the one it ends on for the forward ones and
+  // the one it starts on for the reverse ones, and its offset. Sorted by edge, and by offset for
+  // the same edge, so the restrictions of an edge are found without walking all of them. Made
+  // the first time the restrictions of the direction are asked for
+  mutable std::vector<std::pair<uint64_t, uint32_t>> complex_restriction_forward_index_;
+  mutable std::vector<std::pair<uint64_t, uint32_t>> complex_restriction_reverse_index_;
+
+  // What is made from the memory of the tile once something needs it rather than when the tile is
+  // loaded, once and thread safe. Shared so that the tile stays movable
+  struct LazySections;
+  std::shared_ptr<LazySections> lazy_sections_;
+
+  /**
+   * Makes the routing attributes of the directed edges if they arent yet.
+   */
+  void BindRoutingEdges() const;
+
+  /**
+   * Indexes the complex restrictions of a direction if they arent yet.
+   * @param  forward  which direction
+   */
+  void BindRestrictions(const bool forward) const;
+
   // List of edge info structures. Since edgeinfo is not fixed size we
   // use offsets in directed edges.
   char* edgeinfo_{};
@@ -740,6 +951,9 @@ protected:
   // Size of the edgeinfo data
   std::size_t edgeinfo_size_{};
 
+  // The decoded shapes of the edge infos, if they are to be kept
+  mutable std::unique_ptr<EdgeShapeCache> shape_cache_;
+
   // Street names as sets of null-terminated char arrays. Edge info has
   // offsets into this array.
   char* textlist_{};
@@ -751,14 +965,28 @@ protected:
   // indices in the tile header.
   GraphId* edge_bins_{};
 
+  // The depth of the quadtree of each bin and the cells the edges of the split bins touch, the
+  // offsets say where each bin's edges start in the cells
+  const uint8_t* bin_cell_depths_{};
+  const uint64_t* bin_cells_{};
+  std::array<uint32_t, kBinCount> bin_cell_offsets_{};
+
   // Lane connectivity data.
   LaneConnectivity* lane_connectivity_{};
 
   // Number of bytes in lane connectivity data.
   std::size_t lane_connectivity_size_{};
 
-  // Predicted speeds
-  PredictedSpeeds predictedspeeds_;
+  // The compressed edge info, text list and lane connectivity of a sectioned tile, they are
+  // inflated into the memory of the tile the first time anything reads them
+  struct ColdSections;
+  std::shared_ptr<ColdSections> cold_sections_;
+
+  void InflateColdSections() const;
+
+  // Predicted speeds, they point into the sidecar tile when one is bound
+  mutable PredictedSpeeds predictedspeeds_;
+  mutable std::unique_ptr<const GraphMemory> predicted_memory_;
 
   // Map of stop one stops in this tile.
   std::unordered_map<std::string, GraphId> stop_one_stops;
@@ -828,6 +1056,16 @@ protected:
    *         the uncompressed data, or nullptr
    */
   static graph_tile_ptr DecompressTile(const GraphId& graphid, const std::vector<char>& compressed);
+
+  /** Inflates the sections a tile is always read through and keeps the others for later
+   * @param  graphid         the id of the tile
+   * @param  sectioned       the bytes of the sectioned tile
+   * @param  traffic_memory  the live traffic of the tile if any
+   * @return a pointer to a graphtile if the sections could be inflated, or nullptr
+   */
+  static graph_tile_ptr DecompressSections(const GraphId& graphid,
+                                           std::vector<char>&& sectioned,
+                                           std::unique_ptr<const GraphMemory>&& traffic_memory);
 };
 
 } // namespace baldr
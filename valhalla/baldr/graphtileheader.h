@@ -17,7 +17,7 @@ namespace baldr {
 // something to the tile simply subtract one from this number and add it
 // just before the empty_slots_ array below. NOTE that it can ONLY be an
 // offset in bytes and NOT a bitfield or union or anything of that sort
-constexpr size_t kEmptySlots = 11;
+constexpr size_t kEmptySlots = 10;
 
 // Maximum size of the version string (stored as a fixed size
 // character array so the GraphTileHeader size remains fixed).
@@ -36,6 +36,14 @@ constexpr uint32_t kMaxSigns = 16777215;
 constexpr size_t kBinsDim = 5;
 constexpr size_t kBinCount = kBinsDim * kBinsDim;
 
+// Bins with more edges than this are split into a quadtree of cells, each level of the tree
+// holding a quarter of the edges of the one above until the cells are at most this full. The
+// cells of an edge are kept as a bit mask so the tree can be no deeper than 8x8 cells
+constexpr size_t kBinCellThreshold = 128;
+constexpr uint32_t kMaxBinCellDepth = 3;
+// The bin cells start with the depth of each bin's quadtree, padded to keep the masks aligned
+constexpr size_t kBinCellDepthsSize = 32;
+
 /**
  * Summary information about the graph tile. Includes version
  * information and offsets to the various types of data.
@@ -573,6 +581,22 @@ public:
     predictedspeeds_offset_ = offset;
   }
 
+  /**
+   * Gets the offset to the cells of the edges in the bins which are split into them
+   * @return  Returns the offset (bytes) to the bin cells or 0 if the tile has none
+   */
+  uint32_t bin_cells_offset() const {
+    return bin_cells_offset_;
+  }
+
+  /**
+   * Sets the offset to the cells of the edges in the bins which are split into them
+   * @param offset Offset to the bin cells within the tile, 0 when there are none
+   */
+  void set_bin_cells_offset(const uint32_t offset) {
+    bin_cells_offset_ = offset;
+  }
+
   /**
    * Get the offset to the end of the tile
    * @return the number of bytes in the tile, unless the last slot is used
@@ -687,6 +711,9 @@ protected:
   // GraphTile data size in bytes
   uint32_t tile_size_;
 
+  // Offset to the cells of the edges of the dense bins, they sit right after the bins
+  uint32_t bin_cells_offset_;
+
   // Marks the end of this version of the tile with the rest of the slots
   // being available for growth. If you want to use one of the empty slots,
   // simply add a uint32_t some_offset_; just above empty_slots_ and decrease
@@ -5,6 +5,7 @@
 #include <cinttypes>
 #include <cmath>
 #include <cstddef>
+#include <cstdio>
 #include <iomanip>
 #include <list>
 #include <memory>
@@ -223,11 +224,171 @@ inline std::ostream& operator<<(std::ostream& stream, const Jarray& json) {
 }
 
 inline MapPtr map(std::initializer_list<Jmap::value_type> list) {
-  return MapPtr(new Jmap(list));
+  return std::make_shared<Jmap>(list);
 }
 
 inline ArrayPtr array(std::initializer_list<Jarray::value_type> list) {
-  return ArrayPtr(new Jarray(list));
+  return std::make_shared<Jarray>(list);
+}
+
+inline void serialize(std::string& out, const Jmap& json);
+inline void serialize(std::string& out, const Jarray& json);
+
+// how we serialize the different primitives straight onto the end of a string. this writes the
+// exact same bytes as the ostream operators above without going through a stream per value
+class StringVisitor : public boost::static_visitor<void> {
+public:
+  StringVisitor(std::string& s) : string_(s) {
+  }
+
+  void operator()(const std::string& value) const {
+    string_.push_back('"');
+    for (const auto& c : value) {
+      switch (c) {
+        case '\\':
+          string_ += "\\\\";
+          break;
+        case '"':
+          string_ += "\\\"";
+          break;
+        case '/':
+          string_ += "\\/";
+          break;
+        case '\b':
+          string_ += "\\b";
+          break;
+        case '\f':
+          string_ += "\\f";
+          break;
+        case '\n':
+          string_ += "\\n";
+          break;
+        case '\r':
+          string_ += "\\r";
+          break;
+        case '\t':
+          string_ += "\\t";
+          break;
+        default:
+          if (c >= 0 && c < 32) {
+            char hex[8];
+            snprintf(hex, sizeof(hex), "\\u%04X", static_cast<int>(c));
+            string_ += hex;
+          } else {
+            string_.push_back(c);
+          }
+          break;
+      }
+    }
+    string_.push_back('"');
+  }
+  void operator()(uint64_t value) const {
+    string_ += std::to_string(value);
+  }
+  void operator()(int64_t value) const {
+    string_ += std::to_string(value);
+  }
+  // streams format long doubles with printf so we do the same
+  void operator()(fixed_t value) const {
+    number("%.*Lf", value.precision, value.value);
+  }
+  void operator()(float_t value) const {
+    number("%.*Lg", 6, value.value);
+  }
+  void operator()(bool value) const {
+    string_ += value ? "true" : "false";
+  }
+  void operator()(std::nullptr_t) const {
+    string_ += "null";
+  }
+
+  void operator()(const RawJSON& value) const {
+    string_ += value.data;
+  }
+
+  template <class Nullable> void operator()(const Nullable& value) const {
+    if (value) {
+      serialize(string_, *value);
+    } else {
+      this->operator()(nullptr);
+    }
+  }
+
+private:
+  void number(const char* format, size_t precision, long double value) const {
+    bool finite = std::isfinite(value);
+    if (!finite) {
+      string_.push_back('"');
+    }
+    char buffer[64];
+    int length = snprintf(buffer, sizeof(buffer), format, static_cast<int>(precision), value);
+    if (length >= static_cast<int>(sizeof(buffer))) {
+      // only huge fixed point values end up here
+      std::string big(length + 1, '\0');
+      snprintf(&big[0], big.size(), format, static_cast<int>(precision), value);
+      big.pop_back();
+      string_ += big;
+    } else if (length > 0) {
+      string_.append(buffer, length);
+    }
+    if (!finite) {
+      string_.push_back('"');
+    }
+  }
+
+  std::string& string_;
+};
+
+inline void serialize(std::string& out, const Jmap& json) {
+  StringVisitor visitor(out);
+  out.push_back('{');
+  bool seprator = false;
+  for (const auto& key_value : json) {
+    if (seprator) {
+      out.push_back(',');
+    }
+    seprator = true;
+    out.push_back('"');
+    out += key_value.first;
+    out += "\":";
+    key_value.second.apply_visitor(visitor);
+  }
+  out.push_back('}');
+}
+
+inline void serialize(std::string& out, const Jarray& json) {
+  StringVisitor visitor(out);
+  out.push_back('[');
+  bool seprator = false;
+  for (const auto& element : json) {
+    if (seprator) {
+      out.push_back(',');
+    }
+    seprator = true;
+    element.apply_visitor(visitor);
+  }
+  out.push_back(']');
+}
+
+/**
+ * Serializes the json into a string without the DOM ever touching a stream. Produces the same
+ * text as streaming it with operator<<
+ * @param json         the json to serialize
+ * @param reservation  how many bytes to reserve up front for the output
+ * @return the json text
+ */
+inline std::string serialize(const Jmap& json, size_t reservation = 4096) {
+  std::string out;
+  out.reserve(reservation);
+  serialize(out, json);
+  return out;
+}
+
+inline std::string serialize(const Jarray& json, size_t reservation = 4096) {
+  std::string out;
+  out.reserve(reservation);
+  serialize(out, json);
+  return out;
 }
 
 } // namespace json
@@ -0,0 +1,113 @@
+#ifndef VALHALLA_BALDR_LANDMARKS_H_
+#define VALHALLA_BALDR_LANDMARKS_H_
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * The distances from a small set of landmark nodes to every node of the routing graph, for the
+ * landmark (ALT) lower bounds of the a* heuristic. The distances are the shortest path lengths in
+ * meters along all of the edges in both directions, regardless of access, so by the triangle
+ * inequality |d(L, t) - d(L, v)| never overestimates the length of any path from v to t, whatever
+ * the costing. Only the road levels are covered and the nodes of a tile are stored contiguously
+ * so a node is found from its tile.
+ *
+ * The distances belong to the tiles they were computed from and have to be rebuilt with them.
+ */
+class Landmarks {
+public:
+  static constexpr uint32_t kInvalidNode = std::numeric_limits<uint32_t>::max();
+  static constexpr uint32_t kUnreached = std::numeric_limits<uint32_t>::max();
+
+  // Where the nodes of a tile start within the distances and how many of them there are
+  struct tile_t {
+    uint64_t tile;
+    uint32_t offset;
+    uint32_t node_count;
+  };
+
+  Landmarks() = default;
+
+  /**
+   * Builds the table from the distances of every node to every landmark.
+   * @param tiles      the tiles sorted by their id, their offsets count nodes
+   * @param landmarks  the landmark nodes
+   * @param distances  for every node the distance to each of the landmarks
+   */
+  Landmarks(std::vector<tile_t>&& tiles,
+            std::vector<GraphId>&& landmarks,
+            std::vector<uint32_t>&& distances);
+
+  /**
+   * Loads the table from a file written by Save.
+   * @param file  the path to the file
+   */
+  explicit Landmarks(const std::string& file);
+
+  /**
+   * Writes the table to a file.
+   * @param file  the path to the file
+   */
+  void Save(const std::string& file) const;
+
+  /**
+   * Get the index of a graph node within the table.
+   * @param node  the graph node
+   * @return the index of the node or kInvalidNode if the table does not have it
+   */
+  uint32_t node_index(const GraphId& node) const {
+    auto found = tile_index_.find(node.Tile_Base().value);
+    if (found == tile_index_.cend() || node.id() >= tiles_[found->second].node_count) {
+      return kInvalidNode;
+    }
+    return tiles_[found->second].offset + node.id();
+  }
+
+  /**
+   * Get the distances of a node to each of the landmarks.
+   * @param index  the index of the node
+   * @return landmark_count distances in meters, kUnreached where a landmark cannot reach the node
+   */
+  const uint32_t* distances(const uint32_t index) const {
+    return distances_.data() + static_cast<size_t>(index) * landmarks_.size();
+  }
+
+  /**
+   * Get a landmark.
+   * @param index  the index of the landmark
+   * @return the landmark node
+   */
+  const GraphId& landmark(const uint32_t index) const {
+    return landmarks_[index];
+  }
+
+  size_t landmark_count() const {
+    return landmarks_.size();
+  }
+
+  size_t node_count() const {
+    return landmarks_.empty() ? 0 : distances_.size() / landmarks_.size();
+  }
+
+protected:
+  std::vector<tile_t> tiles_;
+  std::vector<GraphId> landmarks_;
+  std::vector<uint32_t> distances_;
+  std::unordered_map<uint64_t, uint32_t> tile_index_;
+
+  // fills in the lookup of the tiles
+  void IndexTiles();
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_LANDMARKS_H_
@@ -2,6 +2,10 @@
 #define VALHALLA_BALDR_PREDICTEDSPEEDS_H_
 
 #include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
 #include <valhalla/midgard/util.h>
 
 namespace valhalla {
@@ -18,6 +22,27 @@ constexpr uint32_t kCoefficientCount = 200;
 // encoded by two bytes in an array of uint8_t's.
 constexpr uint32_t kDecodedSpeedSize = 2 * kCoefficientCount;
 
+// The version of the predicted speed sidecar tile format
+constexpr uint32_t kPredictedSpeedTileVersion = 1;
+
+// The profile offset of the directed edges of a sidecar tile that have no predicted speeds
+constexpr uint32_t kNoPredictedSpeed = std::numeric_limits<uint32_t>::max();
+
+/**
+ * Predicted speeds can be kept out of the graph tiles in a sidecar extract (a tar of one sidecar
+ * tile per graph tile, see mjolnir.predicted_speeds_extract) so they can be refreshed without
+ * rebuilding the graph. A sidecar tile is this header followed by the offset into the profiles of
+ * every directed edge of the graph tile (kNoPredictedSpeed when it has no profile) and then by the
+ * profiles, kCoefficientCount compressed speeds each.
+ */
+struct PredictedSpeedTileHeader {
+  uint64_t tile_id;
+  uint32_t version;
+  uint32_t directed_edge_count;
+  uint32_t profile_count;
+  uint32_t spare;
+};
+
 /**
  * Compress speed buckets by truncating its DCT-II transform.
  * @param speeds    Array of speed values for each bucket (must be 2016 values).
@@ -47,6 +72,18 @@ std::string encode_compressed_speeds(const int16_t* coefficients);
  */
 std::array<int16_t, kCoefficientCount> decode_compressed_speeds(const std::string& encoded);
 
+/**
+ * Serialize the predicted speed sidecar tile of a graph tile.
+ * @param tile_id              Id of the graph tile.
+ * @param directed_edge_count  Number of directed edges in the graph tile.
+ * @param profiles             Compressed speed profile of each directed edge index that has one.
+ * @return  The bytes of the sidecar tile. Throws if an edge index is out of range.
+ */
+using speed_profiles_t = std::map<uint32_t, std::array<int16_t, kCoefficientCount>>;
+std::string serialize_predicted_speed_tile(uint64_t tile_id,
+                                           uint32_t directed_edge_count,
+                                           const speed_profiles_t& profiles);
+
 /**
  * Class to access predicted speed information within a tile.
  */
@@ -90,6 +127,15 @@ public:
     return decompress_speed_bucket(coefficients, seconds_of_week / kSpeedBucketSizeSeconds);
   }
 
+  /**
+   * Whether the edge has a speed profile. Only the offsets of a sidecar tile mark the edges without
+   * one, the offsets within a GraphTile rely on DirectedEdge::has_predicted_speed instead.
+   * @param  idx  Directed edge index.
+   */
+  bool has_speed(const uint32_t idx) const {
+    return offset_[idx] != kNoPredictedSpeed;
+  }
+
 protected:
   const uint32_t* offset_;  // Offset into the array of compressed speed profiles
                             // for each directed edge
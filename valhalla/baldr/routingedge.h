@@ -0,0 +1,130 @@
+#ifndef VALHALLA_BALDR_ROUTINGEDGE_H_
+#define VALHALLA_BALDR_ROUTINGEDGE_H_
+
+#include <cstdint>
+#include <valhalla/baldr/directededge.h>
+#include <valhalla/baldr/graphconstants.h>
+#include <valhalla/baldr/graphid.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * The attributes of a directed edge the path algorithms look at for every edge they expand,
+ * before they know whether they take the edge at all. Half the size of a DirectedEdge so that
+ * walking the outbound edges of a node touches half the cache lines, the full DirectedEdge is
+ * only needed for the edges which pass.
+ *
+ * A tile makes the routing edges from its directed edges when it is loaded so they never
+ * disagree, whichever stages of the tile building changed the directed edges last.
+ */
+class RoutingEdge {
+public:
+  RoutingEdge() = default;
+
+  /**
+   * Constructor.
+   * @param  edge  The directed edge with all of its attributes.
+   */
+  explicit RoutingEdge(const DirectedEdge& edge)
+      : endnode_(edge.endnode().value), restrictions_(edge.restrictions()),
+        opp_index_(edge.opp_index()), leaves_tile_(edge.leaves_tile()),
+        is_shortcut_(edge.is_shortcut()), not_thru_(edge.not_thru()),
+        forwardaccess_(edge.forwardaccess()), reverseaccess_(edge.reverseaccess()),
+        length_(edge.length()), speed_(edge.speed()), shortcut_(edge.shortcut()),
+        dest_only_(edge.destonly()), superseded_(edge.superseded()),
+        classification_(static_cast<uint32_t>(edge.classification())),
+        use_(static_cast<uint32_t>(edge.use())), spare_(0) {
+  }
+
+  GraphId endnode() const {
+    return GraphId(endnode_);
+  }
+
+  uint32_t restrictions() const {
+    return restrictions_;
+  }
+
+  uint32_t opp_index() const {
+    return opp_index_;
+  }
+
+  bool leaves_tile() const {
+    return leaves_tile_;
+  }
+
+  bool is_shortcut() const {
+    return is_shortcut_;
+  }
+
+  bool not_thru() const {
+    return not_thru_;
+  }
+
+  uint32_t forwardaccess() const {
+    return forwardaccess_;
+  }
+
+  uint32_t reverseaccess() const {
+    return reverseaccess_;
+  }
+
+  uint32_t length() const {
+    return length_;
+  }
+
+  uint32_t speed() const {
+    return speed_;
+  }
+
+  uint32_t shortcut() const {
+    return shortcut_;
+  }
+
+  bool destonly() const {
+    return dest_only_;
+  }
+
+  uint32_t superseded() const {
+    return superseded_;
+  }
+
+  RoadClass classification() const {
+    return static_cast<RoadClass>(classification_);
+  }
+
+  Use use() const {
+    return static_cast<Use>(use_);
+  }
+
+protected:
+  // 1st 8-byte word
+  uint64_t endnode_ : 46;
+  uint64_t restrictions_ : 8;
+  uint64_t opp_index_ : 7;
+  uint64_t leaves_tile_ : 1;
+  uint64_t is_shortcut_ : 1;
+  uint64_t not_thru_ : 1;
+
+  // 2nd 8-byte word
+  uint64_t forwardaccess_ : 12;
+  uint64_t reverseaccess_ : 12;
+  uint64_t length_ : 24;
+  uint64_t speed_ : 8;
+  uint64_t shortcut_ : 7;
+  uint64_t dest_only_ : 1;
+
+  // 3rd 8-byte word
+  uint64_t superseded_ : 7;
+  uint64_t classification_ : 3;
+  uint64_t use_ : 6;
+  uint64_t spare_ : 48;
+};
+
+static_assert(sizeof(RoutingEdge) * 2 == sizeof(DirectedEdge),
+              "A routing edge should take half the space of a directed edge");
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_ROUTINGEDGE_H_
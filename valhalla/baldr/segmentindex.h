@@ -0,0 +1,159 @@
+#ifndef VALHALLA_BALDR_SEGMENTINDEX_H_
+#define VALHALLA_BALDR_SEGMENTINDEX_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/midgard/encoded.h>
+#include <valhalla/midgard/pointll.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * A packed hilbert r-tree over the shapes of the edges of each bin of the graph, so that loki can
+ * skip the edges of a bin which are too far from a location and project onto the rest without
+ * decoding their shapes. The edges of a bin are sorted along a hilbert curve through the centers
+ * of their bounding boxes and grouped into nodes of kNodeSize edges with the box around them all.
+ * Coordinates are stored as the integers of the encoded shapes so the points of the index are the
+ * very points of the decoded shapes. The boxes are padded by one unit so that a projection onto a
+ * segment never lands outside of them because of rounding.
+ *
+ * The index belongs to the tiles it was built from and has to be rebuilt with them.
+ */
+class SegmentIndex {
+public:
+  static constexpr uint32_t kNodeSize = 16;
+
+  // a point in the units of the encoded shapes
+  struct point_t {
+    int32_t lng;
+    int32_t lat;
+
+    midgard::PointLL ll() const {
+      return {double(lng) * DECODE_PRECISION, double(lat) * DECODE_PRECISION};
+    }
+  };
+
+  struct box_t {
+    point_t min;
+    point_t max;
+
+    /**
+     * The point of the box which is closest to the given point, the distance to it is a lower
+     * bound of the distance to anything inside of the box.
+     * @param ll  the point
+     * @return the closest point of the box
+     */
+    midgard::PointLL closest(const midgard::PointLL& ll) const {
+      auto lower = min.ll();
+      auto upper = max.ll();
+      return {std::min(std::max(ll.lng(), lower.lng()), upper.lng()),
+              std::min(std::max(ll.lat(), lower.lat()), upper.lat())};
+    }
+  };
+
+  // Where the nodes of a bin start and how many of them there are
+  struct bin_t {
+    uint64_t tile;
+    uint32_t bin;
+    uint32_t node_offset;
+    uint32_t node_count;
+    uint32_t spare;
+  };
+
+  // Where the edges of a node start and how many of them there are
+  struct node_t {
+    box_t box;
+    uint32_t edge_offset;
+    uint32_t edge_count;
+  };
+
+  // Where the shape of an edge starts and how many points it has
+  struct edge_t {
+    uint64_t edge_id;
+    box_t box;
+    uint32_t point_offset;
+    uint32_t point_count;
+  };
+
+  SegmentIndex() = default;
+
+  /**
+   * Builds the index from its parts.
+   * @param bins    the bins sorted by tile and bin
+   * @param nodes   the nodes of the bins
+   * @param edges   the edges of the nodes
+   * @param points  the shapes of the edges
+   */
+  SegmentIndex(std::vector<bin_t>&& bins,
+               std::vector<node_t>&& nodes,
+               std::vector<edge_t>&& edges,
+               std::vector<point_t>&& points);
+
+  /**
+   * Loads the index from a file written by Save.
+   * @param file  the path to the file
+   */
+  explicit SegmentIndex(const std::string& file);
+
+  /**
+   * Writes the index to a file.
+   * @param file  the path to the file
+   */
+  void Save(const std::string& file) const;
+
+  /**
+   * Get a bin of the index.
+   * @param tile  the tile of the bin
+   * @param bin   the index of the bin within the tile
+   * @return the bin or nullptr if the index does not have it
+   */
+  const bin_t* bin(const GraphId& tile, const uint32_t bin) const {
+    auto found = bin_index_.find(key(tile.Tile_Base().value, bin));
+    return found == bin_index_.cend() ? nullptr : &bins_[found->second];
+  }
+
+  const node_t& node(const uint32_t index) const {
+    return nodes_[index];
+  }
+
+  const edge_t& edge(const uint32_t index) const {
+    return edges_[index];
+  }
+
+  const point_t* points(const edge_t& edge) const {
+    return points_.data() + edge.point_offset;
+  }
+
+  size_t edge_count() const {
+    return edges_.size();
+  }
+
+  size_t node_count() const {
+    return nodes_.size();
+  }
+
+protected:
+  std::vector<bin_t> bins_;
+  std::vector<node_t> nodes_;
+  std::vector<edge_t> edges_;
+  std::vector<point_t> points_;
+  std::unordered_map<uint64_t, uint32_t> bin_index_;
+
+  static uint64_t key(const uint64_t tile, const uint32_t bin) {
+    return (tile << 8) | bin;
+  }
+
+  // fills in the lookup of the bins
+  void IndexBins();
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_SEGMENTINDEX_H_
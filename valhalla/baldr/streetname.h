@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 namespace valhalla {
 namespace baldr {
@@ -16,10 +17,23 @@ public:
    */
   StreetName(const std::string& value, const bool is_route_number);
 
+  /**
+   * Constructor sharing the string of another street name.
+   * @param  value  Street name string, usually from a StreetNameInterner.
+   * @param  is_route_number   boolean indicating if street name is a reference route number.
+   */
+  StreetName(std::shared_ptr<const std::string> value, const bool is_route_number);
+
   virtual ~StreetName();
 
   const std::string& value() const;
 
+  /**
+   * Returns the string of the street name to share with copies of it.
+   * @return the shared street name string.
+   */
+  const std::shared_ptr<const std::string>& shared_value() const;
+
   /**
    * Returns true if street name is a reference route number such as: I 81 South or US 322 West.
    * @return true if street name is a reference route number such as: I 81 South or US 322 West.
@@ -43,10 +57,28 @@ public:
   virtual bool HasSameBaseName(const StreetName& rhs) const;
 
 protected:
-  std::string value_;
+  std::shared_ptr<const std::string> value_;
   bool is_route_number_;
 };
 
+/**
+ * Keeps a single copy of each street name string so that all of the street names made with it
+ * share that string. Equal interned names then have the same pointer and are told apart without
+ * comparing their characters. It isnt thread safe, make one for every set of names to build.
+ */
+class StreetNameInterner {
+public:
+  /**
+   * Get the shared copy of the street name string, making it the first time it is asked for.
+   * @param  value  Street name string.
+   * @return the shared street name string.
+   */
+  std::shared_ptr<const std::string> Intern(const std::string& value);
+
+protected:
+  std::unordered_map<std::string, std::shared_ptr<const std::string>> values_;
+};
+
 } // namespace baldr
 } // namespace valhalla
 
@@ -19,6 +19,13 @@ public:
    */
   StreetNameUs(const std::string& value, const bool is_route_number);
 
+  /**
+   * Constructor sharing the string of another street name.
+   * @param  value  Street name string, usually from a StreetNameInterner.
+   * @param  is_route_number   boolean indicating if street name is a reference route number.
+   */
+  StreetNameUs(std::shared_ptr<const std::string> value, const bool is_route_number);
+
   std::string GetPreDir() const override;
 
   std::string GetPostDir() const override;
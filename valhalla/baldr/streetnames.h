@@ -17,7 +17,13 @@ class StreetNames : public std::list<std::unique_ptr<StreetName>> {
 public:
   StreetNames();
 
-  StreetNames(const std::vector<std::pair<std::string, bool>>& names);
+  /**
+   * Constructor.
+   * @param  names     Street name strings and whether they are route numbers.
+   * @param  interner  Optionally shares the strings with the other names made with it.
+   */
+  StreetNames(const std::vector<std::pair<std::string, bool>>& names,
+              StreetNameInterner* interner = nullptr);
 
   virtual ~StreetNames();
 
@@ -15,7 +15,8 @@ public:
   StreetNamesFactory() = delete;
 
   static std::unique_ptr<StreetNames> Create(const std::string& country_code,
-                                             const std::vector<std::pair<std::string, bool>>& names);
+                                             const std::vector<std::pair<std::string, bool>>& names,
+                                             StreetNameInterner* interner = nullptr);
 };
 
 } // namespace baldr
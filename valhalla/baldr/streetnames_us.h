@@ -14,7 +14,8 @@ class StreetNamesUs : public StreetNames {
 public:
   StreetNamesUs();
 
-  StreetNamesUs(const std::vector<std::pair<std::string, bool>>& names);
+  StreetNamesUs(const std::vector<std::pair<std::string, bool>>& names,
+                StreetNameInterner* interner = nullptr);
 
   ~StreetNamesUs();
 
@@ -36,6 +36,20 @@ public:
    * */
   virtual response_t get(const std::string& url) = 0;
 
+  /**
+   * Makes requests to all of the urls and returns their responses in the same order. Getters
+   * which can have several requests in flight at once should override this, by default they are
+   * made one after the other
+   */
+  virtual std::vector<response_t> get(const std::vector<std::string>& urls) {
+    std::vector<response_t> responses;
+    responses.reserve(urls.size());
+    for (const auto& url : urls) {
+      responses.emplace_back(get(url));
+    }
+    return responses;
+  }
+
   /**
    * Whether tiles are with .gz extension.
    */
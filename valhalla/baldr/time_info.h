@@ -1,6 +1,10 @@
 #pragma once
 
 #include <chrono>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <valhalla/baldr/datetime.h>
 #include <valhalla/baldr/graphconstants.h>
@@ -38,7 +42,7 @@ struct TimeInfo {
   // the sign bit for seconds_from_now
   uint64_t negative_seconds_from_now : 1;
 
-  // a timezone offset cache because doing the offset math is expensive
+  // a timezone offset cache, without one the offsets come from the tables shared by the process
   baldr::DateTime::tz_sys_info_cache_t* tz_cache;
 
   /**
@@ -59,7 +63,8 @@ struct TimeInfo {
    *
    * @param location                 location for which to initialize the TimeInfo
    * @param reader                   used to get timezone information from the graph
-   * @param tz_cache                 non-owning pointer to timezone info cache
+   * @param tz_cache                 non-owning pointer to timezone info cache, the shared offset
+   *                                 tables of DateTime::utc_offset are used when it is null
    * @param default_timezone_index   used when no timezone information is available
    * @return the initialized TimeInfo
    */
@@ -72,6 +77,61 @@ struct TimeInfo {
     if (!location.has_date_time())
       return TimeInfo::invalid();
 
+    // return the time info based on this location information
+    return make(*location.mutable_date_time(), timezone(location, reader), tz_cache,
+                default_timezone_index);
+  }
+
+  /**
+   * Helper function to initialize the objects of many locations at once, like the locations of an
+   * expansion or a matrix. Locations which have the same date time in the same timezone share
+   * one TimeInfo, so the date time is only parsed and converted once for all of them.
+   *
+   * @param locations                locations for which to initialize the TimeInfos
+   * @param reader                   used to get timezone information from the graph
+   * @param tz_cache                 non-owning pointer to timezone info cache, the shared offset
+   *                                 tables of DateTime::utc_offset are used when it is null
+   * @param default_timezone_index   used when no timezone information is available
+   * @return the initialized TimeInfos in the order of the locations
+   */
+  static std::vector<TimeInfo>
+  make(google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+       baldr::GraphReader& reader,
+       baldr::DateTime::tz_sys_info_cache_t* tz_cache = nullptr,
+       int default_timezone_index = baldr::DateTime::get_tz_db().to_index("Etc/UTC")) {
+    // the time info of each date time and timezone along with what its date time turned into
+    std::map<std::pair<std::string, int>, std::pair<TimeInfo, std::string>> made;
+    std::vector<TimeInfo> infos;
+    infos.reserve(locations.size());
+    for (auto& location : locations) {
+      if (!location.has_date_time()) {
+        infos.push_back(TimeInfo::invalid());
+        continue;
+      }
+      auto key = std::make_pair(location.date_time(), timezone(location, reader));
+      auto found = made.find(key);
+      if (found == made.cend()) {
+        const auto info =
+            make(*location.mutable_date_time(), key.second, tz_cache, default_timezone_index);
+        found = made.emplace(std::move(key), std::make_pair(info, location.date_time())).first;
+      } else {
+        // the date time may have been made concrete, ie 'current' is replaced with now
+        location.set_date_time(found->second.second);
+      }
+      infos.push_back(found->second.first);
+    }
+    return infos;
+  }
+
+  /**
+   * Finds the timezone of a location from the first of its edge candidates whose end node has
+   * one.
+   *
+   * @param location  the location whose timezone is wanted
+   * @param reader    used to get timezone information from the graph
+   * @return the timezone index or 0 if none of the candidates had one
+   */
+  static int timezone(const valhalla::Location& location, baldr::GraphReader& reader) {
     // Find the first edge whose end node has a valid timezone index and keep it
     int timezone_index = 0;
     for (const auto& pe : location.path_edges()) {
@@ -81,9 +141,7 @@ struct TimeInfo {
       if (timezone_index != 0)
         break;
     }
-
-    // return the time info based on this location information
-    return make(*location.mutable_date_time(), timezone_index, tz_cache, default_timezone_index);
+    return timezone_index;
   }
 
   /**
@@ -97,7 +155,8 @@ struct TimeInfo {
    * @param date_time               string representing the time from which to make this time info
    *                                if the string is 'current' it will be replaced with the now time
    * @param timezone_index          the timezone index at which to make this time info, 0 if unknown
-   * @param tz_cache                timezone info cache used when crossing timezones while tracking
+   * @param tz_cache                timezone info cache used when crossing timezones while tracking,
+   *                                the shared offset tables of DateTime::utc_offset when null
    * @param default_timezone_index  the index to use when the timezone index is 0 or unknown
    * @return the initialized TimeInfo
    */
@@ -187,7 +187,7 @@ struct TrafficTileHeader {
   uint64_t last_update; // seconds since epoch
   uint32_t directed_edge_count;
   uint32_t traffic_tile_version;
-  uint32_t spare2;
+  uint32_t generation; // bumped before and after every update, odd while one is being written
   uint32_t spare3;
 };
 
@@ -257,6 +257,17 @@ public:
     return *(speeds + directed_edge_offset);
   }
 
+  /**
+   * The number of times the speeds of this tile have been updated, times two. The updater bumps it
+   * before and after writing so it is odd while an update is in progress. Readers remember it to
+   * find out which tiles changed since they last looked, and if it is the same before and after
+   * reading a number of speeds they all came from the same update.
+   * @return the generation of the tile or 0 if there is no tile
+   */
+  uint32_t generation() const {
+    return header == nullptr ? 0 : header->generation;
+  }
+
   // Returns true if this tile is valid or not
   bool operator()() const {
     return header != nullptr;
@@ -27,6 +27,51 @@ std::vector<baldr::GraphId> nodes_in_bbox(const midgard::AABB2<midgard::PointLL>
 std::vector<baldr::GraphId> edges_in_bbox(const midgard::AABB2<midgard::PointLL>& bbox,
                                           baldr::GraphReader& reader);
 
+/**
+ * The results of a query for many bounding boxes at once, flattened into one array. The ids found
+ * in box i are ids[offsets[i]] up to ids[offsets[i + 1]], sorted by level, tile and id.
+ */
+struct bbox_results_t {
+  std::vector<size_t> offsets;
+  std::vector<baldr::GraphId> ids;
+
+  size_t size() const {
+    return offsets.empty() ? 0 : offsets.size() - 1;
+  }
+
+  const baldr::GraphId* begin(const size_t box) const {
+    return ids.data() + offsets[box];
+  }
+
+  const baldr::GraphId* end(const size_t box) const {
+    return ids.data() + offsets[box + 1];
+  }
+};
+
+/**
+ * Find nodes within each of the given bounding boxes in the route network. Gives the same nodes
+ * as calling nodes_in_bbox for every box but visits every bin and loads every tile only once no
+ * matter how many of the boxes share it.
+ *
+ * @param  bboxes  bounding boxes in which to look for nodes.
+ * @param  reader  graph reader object to use for loading tiles.
+ * @return the nodes in each of the bounding boxes.
+ */
+bbox_results_t nodes_in_bboxes(const std::vector<midgard::AABB2<midgard::PointLL>>& bboxes,
+                               baldr::GraphReader& reader);
+
+/**
+ * Find edges that intersect each of the given bounding boxes in the route network. Gives the same
+ * edges as calling edges_in_bbox for every box but visits every bin and loads every tile only once
+ * no matter how many of the boxes share it.
+ *
+ * @param  bboxes  bounding boxes in which to look for edges.
+ * @param  reader  graph reader object to use for loading tiles.
+ * @return the edges which intersect each of the bounding boxes.
+ */
+bbox_results_t edges_in_bboxes(const std::vector<midgard::AABB2<midgard::PointLL>>& bboxes,
+                               baldr::GraphReader& reader);
+
 } // namespace loki
 } // namespace valhalla
 
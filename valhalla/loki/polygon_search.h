@@ -9,13 +9,15 @@ namespace valhalla {
 namespace loki {
 
 /**
- * Finds all edge IDs which are intersected by the ring
+ * Finds all edge IDs which are intersected by the ring. Only the edges in the bins crossed by the
+ * rings are looked at and only those of the bins on the boundary of a ring need its exact geometry.
  *
  * @param rings The (optionally closed) rings to intersect edges with
  * @param reader GraphReader instance
+ * @return the sorted edge IDs
  *
  */
-std::unordered_set<valhalla::baldr::GraphId>
+std::vector<valhalla::baldr::GraphId>
 edges_in_rings(const google::protobuf::RepeatedPtrField<valhalla::Options_Ring>& rings,
                baldr::GraphReader& reader,
                const std::shared_ptr<sif::DynamicCost>& costing,
@@ -2,6 +2,7 @@
 #include <cstdint>
 
 #include <valhalla/baldr/directededge.h>
+#include <valhalla/baldr/edgereach.h>
 #include <valhalla/loki/search.h>
 #include <valhalla/thor/dijkstras.h>
 
@@ -55,6 +56,18 @@ public:
                             const std::shared_ptr<sif::DynamicCost>& costing,
                             uint8_t direction = kInbound | kOutbound);
 
+  /**
+   * Looks up the reach of the edges in a precomputed table first, only the directions which do
+   * not make the maximum reach in it are expanded. The table has to be for the very costing the
+   * reach is asked for, so for requests which keep the default options of one of its costings
+   * @param precomputed    the table or nullptr to always expand
+   * @param costing_index  the column of the costing in the table
+   */
+  void set_precomputed(const baldr::EdgeReach* precomputed, size_t costing_index) {
+    precomputed_ = precomputed;
+    precomputed_index_ = costing_index;
+  }
+
 protected:
   // the main method above will do a conservative reach estimate stopping the expansion at any
   // edges which the costing could decide to skip (because of restrictions and possibly more?)
@@ -100,6 +113,8 @@ protected:
   std::unordered_set<uint64_t> queue_, done_;
   uint32_t max_reach_{};
   size_t transitions_{};
+  const baldr::EdgeReach* precomputed_{};
+  size_t precomputed_index_{};
 };
 
 } // namespace loki
@@ -3,9 +3,11 @@
 
 #include <cstdint>
 #include <valhalla/baldr/directededge.h>
+#include <valhalla/baldr/edgereach.h>
 #include <valhalla/baldr/graphreader.h>
 #include <valhalla/baldr/location.h>
 #include <valhalla/baldr/pathlocation.h>
+#include <valhalla/baldr/segmentindex.h>
 #include <valhalla/sif/dynamiccost.h>
 
 #include <functional>
@@ -13,6 +15,29 @@
 namespace valhalla {
 namespace loki {
 
+class SearchCache;
+
+/**
+ * How much work searches did, summed over all of their locations so that the searches which
+ * have to go far to find anything show up
+ */
+struct SearchStats {
+  uint64_t bins = 0;         // bins whose edges were looked at
+  uint64_t edges = 0;        // edges which the locations were projected onto
+  uint64_t reach_checks = 0; // reach expansions which were run rather than found
+  uint64_t missing_bins = 0; // bins skipped without a tile lookup since their tile doesn't exist
+  double reach_ms = 0;       // milliseconds spent in the reach expansions
+
+  SearchStats& operator+=(const SearchStats& other) {
+    bins += other.bins;
+    edges += other.edges;
+    reach_checks += other.reach_checks;
+    missing_bins += other.missing_bins;
+    reach_ms += other.reach_ms;
+    return *this;
+  }
+};
+
 /**
  * Find an location within the route network given an input location
  * same tiled route data and a search strategy
@@ -22,13 +47,44 @@ namespace loki {
  * proper cache
  * @param costing        a costing object by which we can determine which portions of the graph are
  *                       accessable and therefor potential candidates
+ * @param precomputed_reach  the reach of the edges for the costing if the request keeps the
+ *                           defaults of a costing of the table, nullptr to expand for every edge
+ * @param reach_index        the column of the costing in the precomputed reach
+ * @param cache              the reach and correlations of earlier searches, nullptr to not cache
+ * @param segment_index      the index of the shapes of the edges of the bins, nullptr to look at
+ *                           every edge of a bin
+ * @param stats              where to add how much work the search did, nullptr to not count it
  * @return pathLocations the correlated data with in the tile that matches the inputs. If a
  * projection is not found, it will not have any entry in the returned value.
  */
 std::unordered_map<baldr::Location, baldr::PathLocation>
 Search(const std::vector<baldr::Location>& locations,
        baldr::GraphReader& reader,
-       const std::shared_ptr<sif::DynamicCost>& costing);
+       const std::shared_ptr<sif::DynamicCost>& costing,
+       const baldr::EdgeReach* precomputed_reach = nullptr,
+       size_t reach_index = 0,
+       SearchCache* cache = nullptr,
+       const baldr::SegmentIndex* segment_index = nullptr,
+       SearchStats* stats = nullptr);
+
+/**
+ * Same as above but splits the locations into one part per reader and searches the parts at once,
+ * the first one on the calling thread and the others on threads of their own. The locations in
+ * the same tile go into the same part so they still share the bins they search. Each reader is
+ * only used by the thread searching its part and only that first thread uses the reaches of the
+ * cache, the correlated locations are looked up and remembered on the calling thread.
+ *
+ * @param readers  the readers to search the parts with, at least one
+ */
+std::unordered_map<baldr::Location, baldr::PathLocation>
+Search(const std::vector<baldr::Location>& locations,
+       const std::vector<baldr::GraphReader*>& readers,
+       const std::shared_ptr<sif::DynamicCost>& costing,
+       const baldr::EdgeReach* precomputed_reach = nullptr,
+       size_t reach_index = 0,
+       SearchCache* cache = nullptr,
+       const baldr::SegmentIndex* segment_index = nullptr,
+       SearchStats* stats = nullptr);
 
 } // namespace loki
 } // namespace valhalla
@@ -0,0 +1,122 @@
+#ifndef VALHALLA_LOKI_SEARCH_CACHE_H_
+#define VALHALLA_LOKI_SEARCH_CACHE_H_
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/location.h>
+#include <valhalla/baldr/pathlocation.h>
+#include <valhalla/loki/reach.h>
+#include <valhalla/midgard/lru_cache.h>
+
+namespace valhalla {
+namespace loki {
+
+using midgard::lru_cache_t;
+
+/**
+ * Remembers the reach of edges and the correlated locations across requests, popular places are
+ * searched for over and over again with the same costing. Both are keyed by a hash of the costing
+ * options of the request so requests with other options never share results. The cached results
+ * do not change with live traffic until they are evicted.
+ */
+class SearchCache {
+public:
+  /**
+   * @param reach_capacity     how many reaches of edges to remember, 0 to not cache them
+   * @param location_capacity  how many correlated locations to remember, 0 to not cache them
+   */
+  SearchCache(size_t reach_capacity, size_t location_capacity);
+
+  /**
+   * Sets the costing the following searches use.
+   * @param costing_hash  the hash of the costing options
+   */
+  void set_costing(const uint64_t costing_hash) {
+    costing_hash_ = costing_hash;
+  }
+
+  /**
+   * Finds the reach of an edge for the current costing.
+   * @param edge_id    the edge
+   * @param max_reach  the reach which was checked for
+   * @param reach      set to the reach of the edge if it is cached
+   * @return true if it is cached
+   */
+  bool find_reach(const baldr::GraphId& edge_id, const uint32_t max_reach, directed_reach& reach) {
+    return reach_capacity() && reaches_.find(reach_key_t{edge_id, costing_hash_, max_reach}, reach);
+  }
+
+  void insert_reach(const baldr::GraphId& edge_id,
+                    const uint32_t max_reach,
+                    const directed_reach& reach) {
+    reaches_.insert(reach_key_t{edge_id, costing_hash_, max_reach}, reach);
+  }
+
+  /**
+   * Finds the correlation of a location for the current costing, the coordinates of the location
+   * are rounded to about ten centimeters so the ones of the result are put back to those asked for
+   * @param location    the location to correlate
+   * @param correlated  set to the correlated location if it is cached
+   * @return true if it is cached
+   */
+  bool find_location(const baldr::Location& location, baldr::PathLocation& correlated);
+
+  void insert_location(const baldr::Location& location, const baldr::PathLocation& correlated);
+
+  size_t reach_capacity() const {
+    return reaches_.capacity();
+  }
+
+  size_t location_capacity() const {
+    return locations_.capacity();
+  }
+
+  // the reach of an edge for a costing checked up to a limit
+  struct reach_key_t {
+    baldr::GraphId edge_id;
+    uint64_t costing_hash;
+    uint32_t max_reach;
+
+    bool operator==(const reach_key_t& other) const {
+      return edge_id == other.edge_id && costing_hash == other.costing_hash &&
+             max_reach == other.max_reach;
+    }
+  };
+
+  struct reach_key_hash_t {
+    size_t operator()(const reach_key_t& key) const {
+      return key.edge_id.value ^ (key.costing_hash * 31) ^
+             (static_cast<uint64_t>(key.max_reach) << 46);
+    }
+  };
+
+  using reach_cache_t = lru_cache_t<reach_key_t, directed_reach, reach_key_hash_t>;
+  using location_cache_t = lru_cache_t<std::string, baldr::PathLocation>;
+
+  const reach_cache_t& reaches() const {
+    return reaches_;
+  }
+
+  const location_cache_t& locations() const {
+    return locations_;
+  }
+
+protected:
+  // the key of the search parameters of a location
+  std::string location_key(const baldr::Location& location) const;
+
+  uint64_t costing_hash_{};
+  reach_cache_t reaches_;
+  location_cache_t locations_;
+};
+
+} // namespace loki
+} // namespace valhalla
+
+#endif // VALHALLA_LOKI_SEARCH_CACHE_H_
@@ -0,0 +1,72 @@
+#ifndef VALHALLA_LOKI_TILE_CACHE_H_
+#define VALHALLA_LOKI_TILE_CACHE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <valhalla/midgard/lru_cache.h>
+#include <valhalla/proto/options.pb.h>
+
+namespace valhalla {
+namespace loki {
+
+/**
+ * Remembers the gzipped vector tiles rendered for the tile action so that a map panning around
+ * an area does not render and compress the same tiles over and over again. The tiles show live
+ * traffic so they are only handed back for a while after they were rendered.
+ */
+class TileCache {
+public:
+  /**
+   * @param capacity  how many tiles to remember, 0 to not cache them
+   * @param ttl       how many seconds a tile is good for, 0 to keep it until it is evicted
+   */
+  TileCache(size_t capacity, uint32_t ttl) : ttl_(ttl), tiles_(capacity) {
+  }
+
+  /**
+   * Finds a tile which is not too old to hand back.
+   * @param tile   the zoom, column and row of the tile
+   * @param bytes  set to the gzipped tile if it is cached
+   * @return true if it is cached
+   */
+  bool find(const Options::Tile& tile, std::shared_ptr<const std::string>& bytes) {
+    entry_t entry;
+    if (!tiles_.find(key(tile), entry) ||
+        (ttl_ && std::chrono::steady_clock::now() - entry.rendered > std::chrono::seconds(ttl_))) {
+      return false;
+    }
+    bytes = entry.bytes;
+    return true;
+  }
+
+  void insert(const Options::Tile& tile, const std::shared_ptr<const std::string>& bytes) {
+    tiles_.insert(key(tile), entry_t{bytes, std::chrono::steady_clock::now()});
+  }
+
+  size_t capacity() const {
+    return tiles_.capacity();
+  }
+
+protected:
+  // the zoom is at most 24 so the column and row each fit in 24 bits
+  static uint64_t key(const Options::Tile& tile) {
+    return (static_cast<uint64_t>(tile.z()) << 48) | (static_cast<uint64_t>(tile.x()) << 24) |
+           tile.y();
+  }
+
+  struct entry_t {
+    std::shared_ptr<const std::string> bytes;
+    std::chrono::steady_clock::time_point rendered;
+  };
+
+  uint32_t ttl_;
+  midgard::lru_cache_t<uint64_t, entry_t> tiles_;
+};
+
+} // namespace loki
+} // namespace valhalla
+
+#endif // VALHALLA_LOKI_TILE_CACHE_H_
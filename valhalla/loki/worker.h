@@ -7,10 +7,16 @@
 #include <boost/property_tree/ptree.hpp>
 
 #include <valhalla/baldr/connectivity_map.h>
+#include <valhalla/baldr/edgereach.h>
+#include <valhalla/baldr/graphcomponents.h>
 #include <valhalla/baldr/graphreader.h>
 #include <valhalla/baldr/location.h>
 #include <valhalla/baldr/pathlocation.h>
 #include <valhalla/baldr/rapidjson_utils.h>
+#include <valhalla/baldr/segmentindex.h>
+#include <valhalla/loki/search.h>
+#include <valhalla/loki/search_cache.h>
+#include <valhalla/loki/tile_cache.h>
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/proto/options.pb.h>
 #include <valhalla/sif/costfactory.h>
@@ -36,14 +42,19 @@ public:
 #endif
   virtual void cleanup() override;
 
-  std::string locate(Api& request);
+  // with a writer each location is handed to it as a line of its own and an empty string is returned
+  std::string locate(Api& request, const std::function<void(const std::string&)>* write = nullptr);
   void route(Api& request);
   void matrix(Api& request);
   void isochrones(Api& request);
   void trace(Api& request);
   std::string height(Api& request);
   std::string transit_available(Api& request);
+  // the gzipped mapbox vector tile of the edges and nodes in the tile of the request
+  std::string tile(Api& request);
   void status(Api& request) const;
+  // throws if the request has no action or one that this service isnt configured to answer
+  void check_action(const Api& request) const;
 
   void set_interrupt(const std::function<void()>* interrupt) override;
 
@@ -62,12 +73,45 @@ protected:
   void init_trace(Api& request);
   std::vector<midgard::PointLL> init_height(Api& request);
   void init_transit_available(Api& request);
+  // correlates the locations with all the overlays and caches of the worker, in parallel if there
+  // are enough of them, and adds how long it took and how much work it was to the statistics of
+  // the request
+  std::unordered_map<baldr::Location, baldr::PathLocation>
+  search(const std::vector<baldr::Location>& locations, Api& request);
+  // the sorted components of the graph of the candidate edges of a location for the costing of
+  // the request, empty if the components are not known for the costing or for any of the edges
+  std::vector<uint32_t> components(const baldr::PathLocation& location) const;
 
   boost::property_tree::ptree config;
   sif::CostFactory factory;
   sif::cost_ptr_t costing;
   std::shared_ptr<baldr::GraphReader> reader;
   std::shared_ptr<baldr::connectivity_map_t> connectivity_map;
+  // the precomputed reach of the edges and the column of it for each default costing options
+  std::shared_ptr<const baldr::EdgeReach> edge_reach;
+  std::unordered_map<std::string, size_t> edge_reach_defaults;
+  // the precomputed reach if the costing of the request is in it
+  const baldr::EdgeReach* precomputed_reach;
+  size_t reach_index;
+  // the index of the shapes of the edges of every bin
+  std::shared_ptr<const baldr::SegmentIndex> segment_index;
+  // the connected components of the graph and the column of them for the costing of the request
+  std::shared_ptr<const baldr::GraphComponents> graph_components;
+  int component_index;
+  // the reach of edges and correlated locations of earlier requests
+  std::shared_ptr<SearchCache> search_cache;
+  // the vector tiles rendered for earlier requests and the lowest zoom they are rendered at
+  std::shared_ptr<TileCache> tile_cache;
+  uint32_t tile_min_zoom;
+  // which nodes answer the requests outside of the region of this one, if the cluster is split
+  std::shared_ptr<region_router_t> region_router;
+  // what the responses are compressed with for the clients accepting it, if anything
+  std::shared_ptr<response_compressor_t> response_compressor;
+  // the readers of the other threads of a parallel search and how many locations it takes for one
+  std::vector<std::shared_ptr<baldr::GraphReader>> search_readers;
+  size_t parallel_search_locations;
+  // how much work the searches of this worker did so far
+  SearchStats search_stats;
   std::unordered_set<Options::Action> actions;
   std::string action_str;
   std::unordered_map<std::string, size_t> max_locations;
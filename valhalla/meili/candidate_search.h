@@ -4,6 +4,8 @@
 
 #include <algorithm>
 #include <cmath>
+#include <memory>
+#include <mutex>
 #include <tuple>
 
 #include <boost/property_tree/ptree.hpp>
@@ -15,6 +17,7 @@
 #include <valhalla/baldr/pathlocation.h>
 #include <valhalla/midgard/distanceapproximator.h>
 #include <valhalla/midgard/linesegment2.h>
+#include <valhalla/midgard/lru_cache.h>
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/midgard/tiles.h>
 #include <valhalla/sif/dynamiccost.h>
@@ -34,11 +37,24 @@ public:
                                                  const sif::cost_ptr_t& costing = nullptr) const = 0;
 };
 
+// How many grids of bins a candidate query keeps by default
+constexpr size_t kDefaultGridCacheSize = 100240;
+
 class CandidateGridQuery final : public CandidateQuery {
 public:
   using grid_t = GridRangeQuery<baldr::GraphId, midgard::PointLL>;
-
-  CandidateGridQuery(baldr::GraphReader& reader, float cell_width, float cell_height);
+  using packed_grid_t = PackedGridRangeQuery<baldr::GraphId, midgard::PointLL>;
+
+  /**
+   * @param reader       a graph reader for tile access
+   * @param cell_width   the width of the cells of the grids
+   * @param cell_height  the height of the cells of the grids
+   * @param cache_size   how many grids of bins to keep, the least recently used are evicted
+   */
+  CandidateGridQuery(baldr::GraphReader& reader,
+                     float cell_width,
+                     float cell_height,
+                     size_t cache_size = kDefaultGridCacheSize);
 
   ~CandidateGridQuery() override;
 
@@ -58,28 +74,68 @@ public:
     }
 
     const auto range = midgard::ExpandMeters(location, std::sqrt(sq_search_radius));
-    const auto edgeids = RangeQuery(range);
+    const auto& edgeids = RangeQuery(range);
 
     return collector.WithinSquaredDistance(location, stop_type, sq_search_radius, edgeids.begin(),
                                            edgeids.end(), costing);
   }
 
-  std::unordered_map<baldr::GraphId, grid_t>::size_type size() const {
-    return grid_cache_.size();
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(grid_cache_->lock);
+    return grid_cache_->grids.size();
+  }
+
+  // How many lookups of the grids found the grid they were looking for
+  size_t hits() const {
+    std::lock_guard<std::mutex> lock(grid_cache_->lock);
+    return grid_cache_->grids.hits();
+  }
+
+  // How many lookups of the grids had to index the bin
+  size_t misses() const {
+    std::lock_guard<std::mutex> lock(grid_cache_->lock);
+    return grid_cache_->grids.misses();
   }
 
   void Clear() {
-    grid_cache_.clear();
+    std::lock_guard<std::mutex> lock(grid_cache_->lock);
+    grid_cache_->grids.clear();
   }
 
-private:
-  // Get a grid for a specified bin within a tile. Tile support for
-  // graph tiles and bins is provided to go between bin Ids and tile Ids.
-  const grid_t* GetGrid(const int32_t bin_id,
-                        const midgard::Tiles<midgard::PointLL>& tiles,
-                        const midgard::Tiles<midgard::PointLL>& bins) const;
+  /**
+   * Use the grids of another query from now on, so that queries on several threads only index a
+   * bin once. A grid never changes once its built and the queries hold on to the ones they read
+   * so evicting or clearing the shared grids while another thread is querying is safe.
+   * @param other  the query whose grids to share
+   */
+  void ShareGrids(const CandidateGridQuery& other) {
+    grid_cache_ = other.grid_cache_;
+  }
 
-  std::unordered_set<baldr::GraphId> RangeQuery(const midgard::AABB2<midgard::PointLL>& range) const;
+private:
+  // The grids of the bins indexed so far, possibly shared by the queries of several threads
+  struct grid_cache_t {
+    explicit grid_cache_t(size_t capacity) : grids(capacity) {
+    }
+    std::mutex lock;
+    midgard::lru_cache_t<int64_t, std::shared_ptr<const packed_grid_t>> grids;
+  };
+
+  // Get the grids of a specified bin within a tile which cover the range. That is the grid of the
+  // whole bin unless the tile splits the bin into cells, then it is the grid of each of the cells
+  // the range touches. Tile support for graph tiles and bins is provided to go between bin Ids and
+  // tile Ids.
+  void GetGrids(const int32_t bin_id,
+                const midgard::AABB2<midgard::PointLL>& range,
+                const midgard::Tiles<midgard::PointLL>& tiles,
+                const midgard::Tiles<midgard::PointLL>& bins) const;
+
+  // Get the cached grid of a bin or a cell of it
+  std::shared_ptr<const packed_grid_t> CachedGrid(const int64_t key) const;
+
+  // Get the edges of the grids within the range, each of them once and in ascending order. The
+  // result lives in a buffer of the query which is reused by the next call.
+  const std::vector<baldr::GraphId>& RangeQuery(const midgard::AABB2<midgard::PointLL>& range) const;
 
   uint32_t bin_level_;
 
@@ -87,7 +143,13 @@ private:
   float cell_height_;
 
   // Grid cache - cached per "bin" within a graph tile
-  mutable std::unordered_map<int32_t, grid_t> grid_cache_;
+  std::shared_ptr<grid_cache_t> grid_cache_;
+
+  // Scratch space of the range queries, kept around so that a query does not allocate once they
+  // have grown big enough. This is why a query must not be used by several threads at once
+  mutable std::vector<int32_t> bin_list_;
+  mutable std::vector<baldr::GraphId> range_edges_;
+  mutable std::vector<std::shared_ptr<const packed_grid_t>> range_grids_;
 
   baldr::GraphReader& reader_;
 };
@@ -42,6 +42,10 @@ struct Config {
     float turn_penalty_factor = 200.f;
     // define if 'turn_penalty_factor' option can be reassigned with user request
     bool is_turn_penalty_factor_customizable = true;
+    // how many paths between candidates the matchers of a factory share, 0 turns the cache off
+    size_t cache_size = 16384;
+    // how many buckets the percentages along the edges of the candidates are rounded to
+    uint32_t cache_percent_buckets = 64;
 
     void Read(const boost::property_tree::ptree& params);
   };
@@ -62,6 +66,15 @@ struct Config {
     float interpolation_distance_meters = 10.f;
     // define if 'interpolation_distance' option can be reassigned with user request
     bool is_interpolation_distance_customizable = false;
+    // the farthest (meters) a measurement past the interpolation distance may still be interpolated
+    // on straight stretches of sparse roads, at most the interpolation distance turns this off
+    float adaptive_interpolation_distance_meters = 0.f;
+    // how many seconds of travel at the speed of the trace may be interpolated adaptively
+    float adaptive_interpolation_seconds = 5.f;
+    // the largest change of heading (degrees) from the last match which is still a straight stretch
+    float adaptive_interpolation_heading_change = 30.f;
+    // matches with more candidates than this are in dense roads where every measurement is matched
+    size_t adaptive_interpolation_max_candidates = 4;
 
     void Read(const boost::property_tree::ptree& params);
   };
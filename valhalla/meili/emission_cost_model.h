@@ -1,7 +1,9 @@
 #ifndef MMP_EMISSION_COST_MODEL_H_
 #define MMP_EMISSION_COST_MODEL_H_
 
+#include <algorithm>
 #include <functional>
+#include <vector>
 
 #include <valhalla/meili/config.h>
 #include <valhalla/meili/state.h>
@@ -34,8 +36,46 @@ public:
     return sq_distance * inv_double_sq_sigma_z_;
   }
 
+  // given the *squared* great circle distances between a measurement and its candidates,
+  // write the emission costs of the candidates. It is a plain loop over the arrays so that the
+  // compiler can vectorize it
+  void CalculateEmissionCosts(const float* sq_distances, size_t count, float* costs) const {
+    for (size_t i = 0; i < count; ++i) {
+      costs[i] = sq_distances[i] * inv_double_sq_sigma_z_;
+    }
+  }
+
+  // The costs of a column are computed all at once the first time one of them is needed
   float operator()(const StateId& stateid) const {
-    return CalculateEmissionCost(container_.state(stateid).candidate().edges.front().distance);
+    const auto time = stateid.time();
+    const auto& column = container_.column(time);
+    if (costs_.size() <= time) {
+      costs_.resize(time + 1);
+    }
+    auto& costs = costs_[time];
+    if (costs.size() != column.size()) {
+      sq_distances_.clear();
+      for (const auto& state : column) {
+        sq_distances_.push_back(state.candidate().edges.front().distance);
+      }
+      costs.resize(column.size());
+      CalculateEmissionCosts(sq_distances_.data(), sq_distances_.size(), costs.data());
+    }
+    return costs[stateid.id()];
+  }
+
+  // Forget the costs of the measurements
+  void Clear() {
+    costs_.clear();
+    forgotten_time_ = 0;
+  }
+
+  // Forget the costs of the columns before the time
+  void Forget(const StateId::Time& time) {
+    const auto end = std::min(time, static_cast<StateId::Time>(costs_.size()));
+    for (; forgotten_time_ < end; ++forgotten_time_) {
+      std::vector<float>().swap(costs_[forgotten_time_]);
+    }
   }
 
 private:
@@ -43,6 +83,11 @@ private:
 
   float sigma_z_;
   double inv_double_sq_sigma_z_; // equals to 1.f / (sigma_z_ * sigma_z_ * 2.f)
+
+  // The emission costs of the states by time and id and the distances of a column to compute them
+  mutable std::vector<std::vector<float>> costs_;
+  mutable std::vector<float> sq_distances_;
+  StateId::Time forgotten_time_{0};
 };
 } // namespace meili
 } // namespace valhalla
@@ -2,6 +2,8 @@
 #ifndef MMP_GRID_RANGE_QUERY_H_
 #define MMP_GRID_RANGE_QUERY_H_
 
+#include <algorithm>
+#include <cstdint>
 #include <stdexcept>
 #include <string>
 #include <tuple>
@@ -76,6 +78,27 @@ public:
 #endif
   }
 
+  // The indices (col + row * ncols) of the squares which have items, in ascending order
+  std::vector<unsigned> Squares() const {
+    std::vector<unsigned> squares;
+#ifdef GRID_USE_VECTOR
+    for (unsigned square = 0; square < items_.size(); ++square) {
+      if (!items_[square].empty()) {
+        squares.push_back(square);
+      }
+    }
+#else
+    squares.reserve(items_.size());
+    for (const auto& square : items_) {
+      if (!square.second.empty()) {
+        squares.push_back(square.first);
+      }
+    }
+    std::sort(squares.begin(), squares.end());
+#endif
+    return squares;
+  }
+
   void AddLineSegment(const item_t& item, const coord_t& origin, const coord_t& dest) {
     for (const auto& square : grid_.Traverse(origin, dest)) {
       ItemsInSquare(square.first, square.second).push_back(item);
@@ -87,8 +110,14 @@ public:
     AddLineSegment(item, segment.a(), segment.b());
   }
 
-  // Query all items that intersects with the range
-  std::unordered_set<item_t> Query(const midgard::AABB2<coord_t>& range) const {
+  /**
+   * Visit all items of the squares that intersect with the range without allocating anything. An
+   * item in more than one of the squares is visited once for each of them.
+   * @param range  the range to query
+   * @param visit  called with each item
+   */
+  template <typename visitor_t>
+  void Visit(const midgard::AABB2<coord_t>& range, const visitor_t& visit) const {
     int mincol, minrow, maxcol, maxrow;
     std::tie(mincol, minrow) = grid_.SquareAtPoint(range.minpt());
     std::tie(maxcol, maxrow) = grid_.SquareAtPoint(range.maxpt());
@@ -99,15 +128,19 @@ public:
     minrow = std::max(0, std::min(minrow, nrows_ - 1));
     maxrow = std::max(0, std::min(maxrow, nrows_ - 1));
 
-    std::unordered_set<item_t> items;
-
     for (int row = minrow; row <= maxrow; ++row) {
       for (int col = mincol; col <= maxcol; ++col) {
-        const auto& squared_items = GetItemsInSquare(col, row);
-        items.insert(squared_items.begin(), squared_items.end());
+        for (const auto& item : GetItemsInSquare(col, row)) {
+          visit(item);
+        }
       }
     }
+  }
 
+  // Query all items that intersects with the range
+  std::unordered_set<item_t> Query(const midgard::AABB2<coord_t>& range) const {
+    std::unordered_set<item_t> items;
+    Visit(range, [&items](const item_t& item) { items.insert(item); });
     return items;
   }
 
@@ -137,6 +170,97 @@ private:
 #endif
 };
 
+/**
+ * A GridRangeQuery which is done being built with its squares packed into flat arrays: the indices
+ * of the squares which have items in ascending order, where the items of each of them start and
+ * the items one square after the other. It takes a fraction of the memory of the vectors and the
+ * squares of a row of a range are next to each other.
+ */
+template <typename item_t, typename coord_t> class PackedGridRangeQuery {
+public:
+  explicit PackedGridRangeQuery(const GridRangeQuery<item_t, coord_t>& grid)
+      : ncols_(grid.ncols()), nrows_(grid.nrows()),
+        grid_(grid.bbox().minx(),
+              grid.bbox().miny(),
+              grid.square_width(),
+              grid.square_height(),
+              ncols_,
+              nrows_) {
+    const auto squares = grid.Squares();
+    squares_.reserve(squares.size());
+    offsets_.reserve(squares.size() + 1);
+    offsets_.push_back(0);
+    for (const auto square : squares) {
+      const auto& items = grid.GetItemsInSquare(square % ncols_, square / ncols_);
+      squares_.push_back(square);
+      items_.insert(items_.end(), items.cbegin(), items.cend());
+      offsets_.push_back(items_.size());
+    }
+  }
+
+  int nrows() const {
+    return nrows_;
+  }
+
+  int ncols() const {
+    return ncols_;
+  }
+
+  // How many items there are in all the squares
+  size_t size() const {
+    return items_.size();
+  }
+
+  /**
+   * Visit all items of the squares that intersect with the range without allocating anything. An
+   * item in more than one of the squares is visited once for each of them.
+   * @param range  the range to query
+   * @param visit  called with each item
+   */
+  template <typename visitor_t>
+  void Visit(const midgard::AABB2<coord_t>& range, const visitor_t& visit) const {
+    int mincol, minrow, maxcol, maxrow;
+    std::tie(mincol, minrow) = grid_.SquareAtPoint(range.minpt());
+    std::tie(maxcol, maxrow) = grid_.SquareAtPoint(range.maxpt());
+
+    // Normalize
+    mincol = std::max(0, std::min(mincol, ncols_ - 1));
+    maxcol = std::max(0, std::min(maxcol, ncols_ - 1));
+    minrow = std::max(0, std::min(minrow, nrows_ - 1));
+    maxrow = std::max(0, std::min(maxrow, nrows_ - 1));
+
+    for (int row = minrow; row <= maxrow; ++row) {
+      const unsigned last = maxcol + row * ncols_;
+      auto square = std::lower_bound(squares_.cbegin(), squares_.cend(), mincol + row * ncols_);
+      for (; square != squares_.cend() && *square <= last; ++square) {
+        const auto index = square - squares_.cbegin();
+        for (auto i = offsets_[index]; i < offsets_[index + 1]; ++i) {
+          visit(items_[i]);
+        }
+      }
+    }
+  }
+
+  // Add all items that intersect with the range to the set
+  void Query(const midgard::AABB2<coord_t>& range, std::unordered_set<item_t>& items) const {
+    Visit(range, [&items](const item_t& item) { items.insert(item); });
+  }
+
+  // Query all items that intersects with the range
+  std::unordered_set<item_t> Query(const midgard::AABB2<coord_t>& range) const {
+    std::unordered_set<item_t> items;
+    Query(range, items);
+    return items;
+  }
+
+private:
+  int ncols_, nrows_;
+  GridTraversal<coord_t> grid_;
+  std::vector<unsigned> squares_;
+  std::vector<uint32_t> offsets_;
+  std::vector<item_t> items_;
+};
+
 } // namespace meili
 } // namespace valhalla
 #endif // MMP_GRID_RANGE_QUERY_H_
@@ -21,6 +21,21 @@
 namespace valhalla {
 namespace meili {
 
+// How many matched measurements an online match result may wait behind the latest one
+constexpr uint32_t kDefaultOnlineMaxLag = 10;
+
+// How many seconds the phases of map matching took, summed up over the matches of a matcher
+struct MatchTimings {
+  // finding the candidates of the measurements
+  double candidate_search = 0;
+  // routing between the candidates of consecutive measurements
+  double routing = 0;
+  // searching for the best paths, without the routing it asks for
+  double viterbi = 0;
+  // forming the match results, interpolating the measurements and the edge segments
+  double results = 0;
+};
+
 // A facade that connects everything
 class MapMatcher final {
 public:
@@ -69,6 +84,49 @@ public:
   std::vector<MatchResults> OfflineMatch(const std::vector<Measurement>& measurements,
                                          uint32_t k = 1);
 
+  /**
+   * Matches a stream of measurements a few at a time. The search is kept between the calls so a
+   * call only pays for the measurements it appends instead of matching the whole window again. A
+   * result is final once the best paths to all the states which are still cheaper than the best
+   * path to the latest measurement go through the same state, or once it falls more than max_lag
+   * matched measurements behind the latest one. The states, labels and routes of the times
+   * before the returned results are freed, only the measurements and a state id per time stay
+   * around, so arbitrarily long traces can be matched in a window of max_lag measurements.
+   * @param measurements  the measurements following the ones of the previous calls
+   * @param max_lag       how many matched measurements a result may wait for before it is forced
+   * @return the results which became final with this call, in order
+   */
+  std::vector<MatchResult> OnlineMatch(const std::vector<Measurement>& measurements,
+                                       uint32_t max_lag = kDefaultOnlineMaxLag);
+
+  /**
+   * Ends the stream of OnlineMatch, the last measurement is matched like it is in OfflineMatch.
+   * @return the results which OnlineMatch did not return yet, along the best path to the end
+   */
+  std::vector<MatchResult> FinishOnlineMatch();
+
+  // How long the phases of the matches took since the matcher was made or its timings were reset
+  MatchTimings timings() const {
+    auto timings = timings_;
+    timings.routing = transition_cost_model_.routing_seconds();
+    return timings;
+  }
+
+  void ResetTimings() {
+    timings_ = {};
+    transition_cost_model_.ResetTimings();
+  }
+
+  /**
+   * Reuse the paths between candidates of a cache and keep the ones found in it, see
+   * TransitionCostModel::set_cache
+   * @param cache        the cache, usually the one of the factory of the matcher
+   * @param costing_key  a hash of the costing, its options and the turn penalty factor
+   */
+  void set_transition_cache(std::shared_ptr<TransitionCache> cache, uint64_t costing_key) {
+    transition_cost_model_.set_cache(std::move(cache), costing_key);
+  }
+
   /**
    * Set a callback that will throw when the map-matching should be aborted
    * @param interrupt_callback  the function to periodically call to see if we should abort
@@ -84,9 +142,27 @@ private:
 
   StateId::Time AppendMeasurement(const Measurement& measurement, const float sq_max_search_radius);
 
+  /**
+   * Whether a measurement is interpolated into the route instead of being matched. Measurements
+   * within the interpolation distance of the last match always are, past it they are as long as
+   * the adaptive interpolation distance allows for the speed and heading of the trace and the
+   * roads around the last match are not dense.
+   * @param time         the time of the last match
+   * @param measurement  the measurement after it
+   */
+  bool Interpolates(const StateId::Time time, const Measurement& measurement) const;
+
   void RemoveRedundancies(const std::vector<StateId>& result,
                           const std::vector<MatchResult>& results);
 
+  void AppendOnlineMeasurement(const Measurement& measurement, bool always_match);
+
+  void TraceOnlinePath(StateId::Time last);
+
+  StateId::Time OnlineFinalTime(StateId::Time last) const;
+
+  std::vector<MatchResult> EmitOnlineResults(StateId::Time end);
+
   Config config_;
 
   baldr::GraphReader& graphreader_;
@@ -109,6 +185,20 @@ private:
   EmissionCostModel emission_cost_model_;
 
   TransitionCostModel transition_cost_model_;
+
+  // The times of the phases but the routing which the transition cost model keeps track of
+  MatchTimings timings_;
+
+  // The results of the times before this were returned by OnlineMatch
+  StateId::Time online_emitted_;
+
+  // The best path of the stream, final up to online_emitted_
+  std::vector<StateId> online_path_;
+
+  // The measurements of the stream which are interpolated after the state at a time
+  std::unordered_map<StateId::Time, std::vector<Measurement>> online_interpolated_;
+
+  double online_interpolated_epoch_time_;
 };
 
 /**
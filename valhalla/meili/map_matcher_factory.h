@@ -14,6 +14,7 @@
 #include <valhalla/meili/candidate_search.h>
 #include <valhalla/meili/config.h>
 #include <valhalla/meili/map_matcher.h>
+#include <valhalla/meili/transition_cache.h>
 
 namespace valhalla {
 namespace meili {
@@ -33,6 +34,14 @@ public:
     return *candidatequery_;
   }
 
+  const CandidateGridQuery& candidategridquery() const {
+    return *candidatequery_;
+  }
+
+  const TransitionCache& transitioncache() const {
+    return *transition_cache_;
+  }
+
   MapMatcher* Create(const Options& options);
 
   MapMatcher* Create(const Costing costing) {
@@ -45,6 +54,16 @@ public:
 
   void ClearFullCache();
 
+  // Use the candidate grids of another factory, see CandidateGridQuery::ShareGrids
+  void ShareCandidateGrids(const MapMatcherFactory& other) {
+    candidatequery_->ShareGrids(*other.candidatequery_);
+  }
+
+  // Use the paths between candidates of another factory, see TransitionCache
+  void ShareTransitionCache(const MapMatcherFactory& other) {
+    transition_cache_ = other.transition_cache_;
+  }
+
   void ClearCache();
 
 private:
@@ -59,6 +78,9 @@ private:
   sif::CostFactory cost_factory_;
 
   std::shared_ptr<CandidateGridQuery> candidatequery_;
+
+  // The paths between candidates found by the matchers, possibly shared with other factories
+  std::shared_ptr<TransitionCache> transition_cache_;
 };
 
 } // namespace meili
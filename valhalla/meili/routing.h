@@ -134,6 +134,25 @@ public:
     nodeid_ = id;
   }
 
+  /**
+   * Reuse the label of a path found before, see TransitionCache. Its ends move to the given source
+   * and target and its costs change by the cost of the difference.
+   * @param predecessor  the index of the label before it in the label set it goes into
+   * @param source       the new source distance (0-1)
+   * @param target       the new target distance (0-1)
+   * @param shift        how much the cost up to the end of the label changes
+   */
+  void Reuse(const uint32_t predecessor,
+             const float source,
+             const float target,
+             const sif::Cost& shift) {
+    predecessor_ = predecessor;
+    source_ = source;
+    target_ = target;
+    cost_ += shift;
+    sortcost_ = cost_.cost;
+  }
+
 private:
   // Must be mutually exclusive, i.e. nodeid.Is_Valid() XOR dest != kInvalidDestination
   baldr::GraphId nodeid_;
@@ -232,6 +251,15 @@ public:
            const sif::TravelMode mode,
            int restriction_idx);
 
+  /**
+   * Add a label without queueing it, used to put together a path found before.
+   * @return  Returns the index of the label in the label set.
+   */
+  uint32_t append(const Label& label) {
+    labels_.push_back(label);
+    return labels_.size() - 1;
+  }
+
   /**
    * Get the next label from the priority queue. Marks the popped label
    * as permanent (best path found).
@@ -272,6 +300,32 @@ private:
 
 using labelset_ptr_t = std::shared_ptr<LabelSet>;
 
+/**
+ * The nodes and edges a range of destinations are at. It only depends on the destinations so the
+ * searches from all the states of one column into the next column can share it rather than each
+ * of them looking up where the same candidates are again.
+ */
+struct DestinationIndex {
+  DestinationIndex() = default;
+
+  /**
+   * Indexes the destinations in [first, last).
+   * @param reader        a graph reader for tile access
+   * @param destinations  the locations of the destinations
+   * @param first         the index of the first destination to index
+   * @param last          one past the index of the last destination to index
+   */
+  DestinationIndex(baldr::GraphReader& reader,
+                   const std::vector<baldr::PathLocation>& destinations,
+                   uint16_t first,
+                   uint16_t last);
+
+  std::unordered_map<baldr::GraphId, std::vector<uint16_t>> node_dests;
+  std::unordered_map<baldr::GraphId, std::vector<uint16_t>> edge_dests;
+  // how many of the destinations are along an edge rather than at a node
+  uint16_t edge_dest_count = 0;
+};
+
 /**
  * Find the shortest paths between an origin and a set of destinations.
  * @param reader            a graph reader for tile access
@@ -304,6 +358,25 @@ find_shortest_path(baldr::GraphReader& reader,
                    const float max_dist,
                    const float max_time);
 
+/**
+ * Same as above but with the index of all the destinations other than the origin already built,
+ * so that the searches into the same destinations only look them up once.
+ * @param index  where the destinations other than the origin are
+ */
+std::unordered_map<uint16_t, uint32_t>
+find_shortest_path(baldr::GraphReader& reader,
+                   const std::vector<baldr::PathLocation>& destinations,
+                   uint16_t origin_idx,
+                   const DestinationIndex& index,
+                   labelset_ptr_t labelset,
+                   const midgard::DistanceApproximator<midgard::PointLL>& approximator,
+                   const float search_radius,
+                   sif::cost_ptr_t costing,
+                   const Label* edgelabel,
+                   const float turn_cost_table[181],
+                   const float max_dist,
+                   const float max_time);
+
 // Route path iterator. Methods to assist recovering route paths from Labels.
 class RoutePathIterator : public std::iterator<std::forward_iterator_tag, const Label> {
 public:
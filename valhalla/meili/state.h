@@ -98,6 +98,23 @@ public:
     measurements_.clear();
     leave_times_.clear();
     columns_.clear();
+    forgotten_time_ = 0;
+  }
+
+  /**
+   * Free the states of the columns before a time, their columns stay around but are empty. The
+   * measurements are kept since they are small and the results of the forgotten times need them.
+   * @param time  the earliest time whose states are kept
+   */
+  void Forget(const StateId::Time& time) {
+    for (; forgotten_time_ < std::min(time, size()); ++forgotten_time_) {
+      Column().swap(columns_[forgotten_time_]);
+    }
+  }
+
+  // The states before this time have been forgotten
+  StateId::Time forgotten_time() const {
+    return forgotten_time_;
   }
 
   const State& state(const StateId& stateid) const {
@@ -194,6 +211,8 @@ private:
   std::vector<double> leave_times_;
 
   std::vector<Column> columns_;
+
+  StateId::Time forgotten_time_{0};
 };
 
 } // namespace meili
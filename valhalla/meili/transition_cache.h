@@ -0,0 +1,114 @@
+// -*- mode: c++ -*-
+#ifndef MMP_TRANSITION_CACHE_H_
+#define MMP_TRANSITION_CACHE_H_
+#include <cstdint>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/pathlocation.h>
+#include <valhalla/meili/routing.h>
+#include <valhalla/midgard/lru_cache.h>
+
+namespace valhalla {
+namespace meili {
+
+// How many paths between candidates a matcher factory keeps by default
+constexpr size_t kDefaultTransitionCacheSize = 16384;
+
+// How many buckets the percentages along the edges of the candidates are rounded to by default
+constexpr uint32_t kDefaultTransitionPercentBuckets = 64;
+
+/**
+ * The paths found between pairs of candidates of consecutive measurements, so that traces along
+ * the same roads, usually those of different requests, only route between nearby candidates once.
+ * A path is kept under the costing, the edge its origin was reached on and the edges of both of the
+ * candidates, with where along them the candidates are rounded to a bucket. Only paths which were
+ * found are kept since whether there is one depends on the limits of the search.
+ */
+class TransitionCache {
+public:
+  struct key_t {
+    // the costing, its options and the turn penalty factor
+    uint64_t costing;
+    // the edge the origin was reached on, the turn costs and u-turns off of the origin depend on it
+    baldr::GraphId predecessor;
+    // the candidates, see candidate_key
+    uint64_t source;
+    uint64_t target;
+
+    bool operator==(const key_t& other) const {
+      return costing == other.costing && predecessor == other.predecessor &&
+             source == other.source && target == other.target;
+    }
+  };
+
+  struct key_hasher_t {
+    size_t operator()(const key_t& key) const;
+  };
+
+  // The labels of a path, from the origin label the search started from to the one it found
+  using path_t = std::shared_ptr<const std::vector<Label>>;
+
+  /**
+   * @param capacity         how many paths to keep, the least recently used are evicted
+   * @param percent_buckets  how many buckets the percentages along the edges are rounded to
+   */
+  explicit TransitionCache(size_t capacity = kDefaultTransitionCacheSize,
+                           uint32_t percent_buckets = kDefaultTransitionPercentBuckets);
+
+  /**
+   * Hashes the edges of a candidate, where along them it is rounded to a bucket and whether it is
+   * at one of their nodes.
+   * @param candidate  the candidate
+   * @return the part of the key for the candidate
+   */
+  uint64_t candidate_key(const baldr::PathLocation& candidate) const;
+
+  bool find(const key_t& key, path_t& path) {
+    std::lock_guard<std::mutex> lock(lock_);
+    return paths_.find(key, path);
+  }
+
+  void insert(const key_t& key, path_t path) {
+    std::lock_guard<std::mutex> lock(lock_);
+    paths_.insert(key, path);
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return paths_.size();
+  }
+
+  size_t capacity() const {
+    return paths_.capacity();
+  }
+
+  // How many lookups found a path
+  size_t hits() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return paths_.hits();
+  }
+
+  // How many lookups did not find a path
+  size_t misses() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return paths_.misses();
+  }
+
+  void Clear() {
+    std::lock_guard<std::mutex> lock(lock_);
+    paths_.clear();
+  }
+
+private:
+  uint32_t percent_buckets_;
+  mutable std::mutex lock_;
+  midgard::lru_cache_t<key_t, path_t, key_hasher_t> paths_;
+};
+
+} // namespace meili
+} // namespace valhalla
+#endif // MMP_TRANSITION_CACHE_H_
@@ -2,12 +2,15 @@
 #define MMP_TRANSITION_COST_MODEL_H_
 
 #include <functional>
+#include <unordered_map>
+#include <vector>
 
 #include <valhalla/baldr/graphreader.h>
 #include <valhalla/meili/config.h>
 #include <valhalla/meili/measurement.h>
 #include <valhalla/meili/state.h>
 #include <valhalla/meili/topk_search.h>
+#include <valhalla/meili/transition_cache.h>
 #include <valhalla/meili/viterbi_search.h>
 #include <valhalla/sif/dynamiccost.h>
 
@@ -51,9 +54,78 @@ public:
 
   float operator()(const StateId& lhs, const StateId& rhs) const;
 
+  // Forget the cached destinations, the columns they came from are gone
+  void Clear() {
+    columns_.clear();
+    distance_times_ = {kInvalidTime, kInvalidTime};
+  }
+
+  // How many seconds the routes between the states took so far
+  double routing_seconds() const {
+    return routing_seconds_;
+  }
+
+  void ResetTimings() {
+    routing_seconds_ = 0;
+  }
+
+  /**
+   * Reuse the paths between candidates which are in a cache, usually one shared by all the matchers
+   * of a factory, and keep the paths found by the searches in it.
+   * @param cache        the cache or nullptr to always search
+   * @param costing_key  a hash of the costing, its options and the turn penalty factor
+   */
+  void set_cache(std::shared_ptr<TransitionCache> cache, uint64_t costing_key) {
+    cache_ = std::move(cache);
+    costing_key_ = costing_key;
+    columns_.clear();
+  }
+
+  // Forget the cached destinations of the columns before the time
+  void Forget(const StateId::Time& time) {
+    for (auto it = columns_.begin(); it != columns_.end();) {
+      it = it->first < time ? columns_.erase(it) : std::next(it);
+    }
+  }
+
 private:
   void UpdateRoute(const StateId& lhs, const StateId& rhs) const;
 
+  // The candidates of a column behind a slot for the origin and where they are on the graph. The
+  // routes from every state of the column before go to the same ones, the search visits the columns
+  // out of order so we keep them all until the trace is cleared
+  struct column_t {
+    std::vector<baldr::PathLocation> locations;
+    DestinationIndex index;
+    // the parts of the keys of the transition cache for the candidates, when there is a cache
+    std::vector<uint64_t> keys;
+  };
+
+  /**
+   * Routes from a state to all the states of the next column with the paths of the cache, when it
+   * has one to every one of them.
+   * @return whether the cache had all the paths, the route of the state is only set if it did
+   */
+  bool RouteFromCache(const State& left,
+                      const column_t& column,
+                      const std::vector<StateId>& stateids,
+                      const Label* edgelabel,
+                      float max_route_distance,
+                      float max_route_time) const;
+
+  // Keep the paths a search from a state found to the states of the next column in the cache
+  void CacheRoutes(const State& left,
+                   const column_t& column,
+                   const Label* edgelabel,
+                   const std::unordered_map<uint16_t, uint32_t>& results,
+                   const LabelSet& labelset) const;
+
+  // The cost of a percentage of an edge, false if the edge is not in the graph
+  bool PartialCost(const sif::cost_ptr_t& costing,
+                   const baldr::GraphId& edgeid,
+                   float percent,
+                   sif::Cost& cost) const;
+
   float ClockDistance(const StateId::Time& lhs, const StateId::Time& rhs) const {
     double clk_dist = -1.0;
 
@@ -93,6 +165,19 @@ private:
   float turn_cost_table_[181];
 
   bool match_on_restrictions_{false};
+
+  mutable std::unordered_map<StateId::Time, column_t> columns_;
+
+  // The distances between the measurements of the two times the last transition was between, the
+  // search asks for the transitions of all the pairs of states of two columns in a row
+  mutable std::pair<StateId::Time, StateId::Time> distance_times_{kInvalidTime, kInvalidTime};
+  mutable float great_circle_distance_{0.f};
+  mutable float clock_distance_{0.f};
+
+  mutable double routing_seconds_{0};
+
+  std::shared_ptr<TransitionCache> cache_;
+  uint64_t costing_key_{0};
 };
 
 } // namespace meili
@@ -89,6 +89,14 @@ public:
    * @return true if it's removed
    */
   virtual bool RemoveStateId(const StateId& stateid);
+  /**
+   * Free what the search keeps of the states before a time once their part of the path is final.
+   * The search goes on from the states at and after it as if there was nothing before them, their
+   * winners are still known but the labels of the forgotten states are gone.
+   *
+   * @param time  the earliest time to keep
+   */
+  virtual void Forget(StateId::Time time);
   virtual StateId SearchWinner(StateId::Time time) = 0;
   virtual StateId Predecessor(const StateId& stateid) const = 0;
   virtual double AccumulatedCost(const StateId& stateid) const = 0;
@@ -114,6 +122,8 @@ protected:
 
   std::vector<std::vector<StateId>> states_by_time;
   std::vector<StateId> winner_by_time;
+  // the states before this time have been forgotten
+  StateId::Time forgotten_time_{0};
 
 private:
   std::unordered_set<StateId> added_states_;
@@ -161,6 +171,7 @@ public:
   void ClearSearch() override;
   bool AddStateId(const StateId& stateid) override;
   bool RemoveStateId(const StateId& stateid) override;
+  void Forget(StateId::Time time) override;
   StateId SearchWinner(StateId::Time time) override;
   StateId Predecessor(const StateId& stateid) const override;
   double AccumulatedCost(const StateId& stateid) const override;
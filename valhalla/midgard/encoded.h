@@ -1,9 +1,12 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 // we store 6 digits of precision in the tiles, changing to 7 digits is a breaking change
@@ -32,9 +35,24 @@ public:
     lon = next(lon);
     return Point(double(lon) * prec, double(lat) * prec);
   }
+  // moves past the next point without making it, the fixed point coordinates are still kept
+  void skip() noexcept(false) {
+    lat = next(lat);
+    lon = next(lon);
+  }
   bool empty() const {
     return begin == end;
   }
+  // the fixed point coordinates of the last point popped or skipped
+  int32_t fixed_lon() const {
+    return lon;
+  }
+  int32_t fixed_lat() const {
+    return lat;
+  }
+  double precision() const {
+    return prec;
+  }
 
 private:
   const char* begin;
@@ -44,17 +62,29 @@ private:
   double prec;
 
   int32_t next(const int32_t previous) noexcept(false) {
-    int32_t byte, shift = 0, result = 0;
-    do {
-      if (empty()) {
-        throw std::runtime_error("Bad encoded polyline");
-      }
-      // take the least significant 7 bits shifted into place
-      byte = int32_t(*begin++);
-      result |= (byte & 0x7f) << shift;
-      shift += 7;
-      // if the most significant bit is set there is more to this number
-    } while (byte & 0x80);
+    // the offsets between the points of dense shape mostly fit in 1 or 2 bytes so those dont loop
+    int32_t result;
+    const auto* bytes = reinterpret_cast<const uint8_t*>(begin);
+    if (begin != end && bytes[0] < 0x80) {
+      result = bytes[0];
+      begin += 1;
+    } else if (end - begin >= 2 && bytes[1] < 0x80) {
+      result = (bytes[0] & 0x7f) | (int32_t(bytes[1]) << 7);
+      begin += 2;
+    } else {
+      int32_t byte, shift = 0;
+      result = 0;
+      do {
+        if (empty()) {
+          throw std::runtime_error("Bad encoded polyline");
+        }
+        // take the least significant 7 bits shifted into place
+        byte = int32_t(*begin++);
+        result |= (byte & 0x7f) << shift;
+        shift += 7;
+        // if the most significant bit is set there is more to this number
+      } while (byte & 0x80);
+    }
     // handle the bit flipping and add to previous since its an offset
     return previous + ((result & 1 ? ~result : result) >> 1);
   }
@@ -70,9 +100,28 @@ public:
     lon = next(lon);
     return Point(double(lon) * prec, double(lat) * prec);
   }
+  // moves past the next point without making it, the fixed point coordinates are still kept
+  void skip() noexcept(false) {
+    lat = next(lat);
+    lon = next(lon);
+  }
   bool empty() const {
     return begin == end;
   }
+  // the fixed point coordinates of the last point popped or skipped
+  int32_t fixed_lon() const {
+    return lon;
+  }
+  int32_t fixed_lat() const {
+    return lat;
+  }
+  double precision() const {
+    return prec;
+  }
+  // where the encoding of the next point starts
+  const char* position() const {
+    return begin;
+  }
 
 private:
   const char* begin;
@@ -82,18 +131,24 @@ private:
   double prec;
 
   int32_t next(const int32_t previous) noexcept(false) {
-    // grab each 5 bits and mask it in where it belongs using the shift
+    // small offsets fit in a single character so those dont loop
     int byte, shift = 0, result = 0;
-    do {
-      if (empty()) {
-        throw std::runtime_error("Bad encoded polyline");
-      }
-      // take the least significant 5 bits shifted into place
-      byte = int32_t(*begin++) - 63;
-      result |= (byte & 0x1f) << shift;
-      shift += 5;
-      // if the most significant bit is set there is more to this number
-    } while (byte >= 0x20);
+    if (begin != end && (byte = int32_t(*begin) - 63) >= 0 && byte < 0x20) {
+      ++begin;
+      result = byte;
+    } else {
+      // grab each 5 bits and mask it in where it belongs using the shift
+      do {
+        if (empty()) {
+          throw std::runtime_error("Bad encoded polyline");
+        }
+        // take the least significant 5 bits shifted into place
+        byte = int32_t(*begin++) - 63;
+        result |= (byte & 0x1f) << shift;
+        shift += 5;
+        // if the most significant bit is set there is more to this number
+      } while (byte >= 0x20);
+    }
     // handle the bit flipping and add to previous since its an offset
     return previous + (result & 1 ? ~(result >> 1) : (result >> 1));
   }
@@ -157,6 +212,97 @@ container_t decode7(const std::string& encoded, const double precision = DECODE_
   return decode7<container_t>(encoded.c_str(), encoded.length(), precision);
 }
 
+/**
+ * Polyline decode into a vector the caller keeps around so that its memory can be reused from one
+ * shape to the next. Whatever was in the vector before is replaced
+ *
+ * @param encoded    the encoded points
+ * @param length     the number of bytes of encoded points
+ * @param points     where to put the decoded points
+ * @param precision  decoding precision (1/encoding precision)
+ */
+template <class Point, class ShapeDecoder = Shape5Decoder<Point>>
+void decode_into(const char* encoded,
+                 size_t length,
+                 std::vector<Point>& points,
+                 const double precision = DECODE_PRECISION) {
+  ShapeDecoder shape(encoded, length, precision);
+  points.clear();
+  points.reserve(length / 4);
+  while (!shape.empty()) {
+    points.emplace_back(shape.pop());
+  }
+}
+
+template <class Point>
+void decode7_into(const char* encoded,
+                  size_t length,
+                  std::vector<Point>& points,
+                  const double precision = DECODE_PRECISION) {
+  decode_into<Point, Shape7Decoder<Point>>(encoded, length, points, precision);
+}
+
+/**
+ * Polyline decode only the bounding box of the points. The coordinates are compared as the fixed
+ * point integers they are encoded as so no points are made along the way
+ *
+ * @param encoded    the encoded points
+ * @param length     the number of bytes of encoded points
+ * @param precision  decoding precision (1/encoding precision)
+ * @return the box of the points, constructed from its min x, min y, max x and max y, or a
+ *         default constructed box if there are no points
+ */
+template <class box_t, class ShapeDecoder = Shape5Decoder<std::pair<double, double>>>
+box_t decode_bbox(const char* encoded, size_t length, const double precision = DECODE_PRECISION) {
+  ShapeDecoder shape(encoded, length, precision);
+  if (shape.empty()) {
+    return box_t{};
+  }
+  shape.skip();
+  int32_t min_lon = shape.fixed_lon(), max_lon = min_lon;
+  int32_t min_lat = shape.fixed_lat(), max_lat = min_lat;
+  while (!shape.empty()) {
+    shape.skip();
+    min_lon = std::min(min_lon, shape.fixed_lon());
+    max_lon = std::max(max_lon, shape.fixed_lon());
+    min_lat = std::min(min_lat, shape.fixed_lat());
+    max_lat = std::max(max_lat, shape.fixed_lat());
+  }
+  return box_t(min_lon * precision, min_lat * precision, max_lon * precision, max_lat * precision);
+}
+
+template <class box_t>
+box_t decode7_bbox(const char* encoded, size_t length, const double precision = DECODE_PRECISION) {
+  return decode_bbox<box_t, Shape7Decoder<std::pair<double, double>>>(encoded, length, precision);
+}
+
+/**
+ * Polyline decode only the first and the last point. The points in between still have to be read
+ * since they are offsets but they are only summed up
+ *
+ * @param encoded    the encoded points
+ * @param length     the number of bytes of encoded points, there must be at least one point
+ * @param precision  decoding precision (1/encoding precision)
+ * @return the first and the last point, which are the same if there is only one
+ */
+template <class Point, class ShapeDecoder = Shape5Decoder<Point>>
+std::pair<Point, Point>
+decode_endpoints(const char* encoded, size_t length, const double precision = DECODE_PRECISION) {
+  ShapeDecoder shape(encoded, length, precision);
+  Point first = shape.pop();
+  while (!shape.empty()) {
+    shape.skip();
+  }
+  return std::make_pair(first, Point(double(shape.fixed_lon()) * precision,
+                                     double(shape.fixed_lat()) * precision));
+}
+
+template <class Point>
+std::pair<Point, Point>
+decode7_endpoints(const char* encoded, size_t length, const double precision = DECODE_PRECISION) {
+  return decode_endpoints<Point, Shape7Decoder<Point>>(encoded, length, precision);
+}
+
 /**
  * Polyline encode a container of points into a string suitable for web use
  * Note: newer versions of this algorithm allow one to specify a zoom level
@@ -166,46 +312,89 @@ container_t decode7(const std::string& encoded, const double precision = DECODE_
  * @param precision Precision of the encoded polyline. Defaults to 6 digit precision.
  * @return string   the encoded container of points
  */
-template <class container_t>
-std::string encode(const container_t& points, const int precision = ENCODE_PRECISION) {
+namespace detail {
+
+// The most characters a 32 bit offset takes in 5 and in 7 bit chunks
+constexpr size_t kMaxEncodedChars5 = 7;
+constexpr size_t kMaxEncodedChars7 = 5;
+
+// Turns an integer into an encoded string of 5 bit chunks written at out, returns one past the
+// last character written
+inline char* serialize5(int number, char* out) {
+  // move the bits left 1 position and flip all the bits if it was a negative number
+  uint32_t bits = static_cast<uint32_t>(number) << 1;
+  bits = number < 0 ? ~bits : bits;
+  // write 5 bit chunks of the number
+  while (bits >= 0x20) {
+    *out++ = static_cast<char>((0x20 | (bits & 0x1f)) + 63);
+    bits >>= 5;
+  }
+  // write the last chunk
+  *out++ = static_cast<char>(bits + 63);
+  return out;
+}
+
+// Turns an integer into a varint of 7 bit chunks written at out, returns one past the last byte
+// written
+inline char* serialize7(int number, char* out) {
+  // get the sign bit down on the least significant end to
+  // make the most significant bits mostly zeros
+  uint32_t bits = static_cast<uint32_t>(number) << 1;
+  bits = number < 0 ? ~bits : bits;
+  // we take 7 bits of this at a time
+  while (bits > 0x7f) {
+    // marking the most significant bit means there are more pieces to come
+    *out++ = static_cast<char>(0x80 | (bits & 0x7f));
+    bits >>= 7;
+  }
+  // write the last chunk
+  *out++ = static_cast<char>(bits & 0x7f);
+  return out;
+}
+
+// Offset encodes the points straight into the memory of the output, which is sized for the
+// longest encoding there can be and cut down to what was written at the end
+template <class container_t, size_t max_chars, char* (*serialize)(int, char*)>
+std::string encode_points(const container_t& points, const int precision) {
   // a place to keep the output
-  std::string output;
-  // unless the shape is very course you should probably only need about 3 bytes
-  // per coord, which is 6 bytes with 2 coords, so we overshoot to 8 just in case
-  output.reserve(points.size() * 8);
-
-  // handy lambda to turn an integer into an encoded string
-  auto serialize = [&output](int number) {
-    // move the bits left 1 position and flip all the bits if it was a negative number
-    number = number < 0 ? ~(static_cast<unsigned int>(number) << 1) : (number << 1);
-    // write 5 bit chunks of the number
-    while (number >= 0x20) {
-      int nextValue = (0x20 | (number & 0x1f)) + 63;
-      output.push_back(static_cast<char>(nextValue));
-      number >>= 5;
-    }
-    // write the last chunk
-    number += 63;
-    output.push_back(static_cast<char>(number));
-  };
+  std::string output(points.size() * 2 * max_chars, '\0');
+  char* out = &output[0];
 
   // this is an offset encoding so we remember the last point we saw
   int last_lon = 0, last_lat = 0;
   // for each point
   for (const auto& p : points) {
-    // shift the decimal point 5 places to the right and truncate
+    // shift the decimal point x places to the right and truncate
     int lon = static_cast<int>(round(static_cast<double>(p.first) * precision));
     int lat = static_cast<int>(round(static_cast<double>(p.second) * precision));
     // encode each coordinate, lat first for some reason
-    serialize(lat - last_lat);
-    serialize(lon - last_lon);
+    out = serialize(lat - last_lat, out);
+    out = serialize(lon - last_lon, out);
     // remember the last one we encountered
     last_lon = lon;
     last_lat = lat;
   }
+  output.resize(out - output.data());
   return output;
 }
 
+} // namespace detail
+
+/**
+ * Polyline encode a container of points into a string suitable for web use
+ * Note: newer versions of this algorithm allow one to specify a zoom level
+ * which allows displaying simplified versions of the encoded linestring
+ *
+ * @param points    the list of points to encode
+ * @param precision Precision of the encoded polyline. Defaults to 6 digit precision.
+ * @return string   the encoded container of points
+ */
+template <class container_t>
+std::string encode(const container_t& points, const int precision = ENCODE_PRECISION) {
+  return detail::encode_points<container_t, detail::kMaxEncodedChars5, detail::serialize5>(
+      points, precision);
+}
+
 /**
  * Varint encode a container of points into a string
  *
@@ -214,43 +403,60 @@ std::string encode(const container_t& points, const int precision = ENCODE_PRECI
  */
 template <class container_t>
 std::string encode7(const container_t& points, const int precision = ENCODE_PRECISION) {
-  // a place to keep the output
-  std::string output;
-  // unless the shape is very course you should probably only need about 3 bytes
-  // per coord, which is 6 bytes with 2 coords, so we overshoot to 8 just in case
-  output.reserve(points.size() * 8);
-
-  // handy lambda to turn an integer into an encoded string
-  auto serialize = [&output](int number) {
-    // get the sign bit down on the least significant end to
-    // make the most significant bits mostly zeros
-    number = number < 0 ? ~(static_cast<unsigned int>(number) << 1) : number << 1;
-    // we take 7 bits of this at a time
-    while (number > 0x7f) {
-      // marking the most significant bit means there are more pieces to come
-      int nextValue = (0x80 | (number & 0x7f));
-      output.push_back(static_cast<char>(nextValue));
-      number >>= 7;
+  return detail::encode_points<container_t, detail::kMaxEncodedChars7, detail::serialize7>(
+      points, precision);
+}
+
+/**
+ * Polyline encoded shapes joined into one as if all of their points were encoded together, where
+ * each shape after the first starts at the point the one before it ended at and so that point is
+ * only in the result once. The first point of each of those shapes is dropped and the offset of
+ * its second point is made relative to the last point of the shape before it, the rest of its
+ * offsets are copied as they are. Nothing is decoded into points, the offsets are only summed up
+ * to know where each shape ends.
+ *
+ * @param shapes  the encoded shapes, all encoded with the same precision
+ * @return the encoded joined shape
+ */
+inline std::string splice_encoded(const std::vector<const std::string*>& shapes) {
+  size_t length = 0;
+  for (const auto* shape : shapes) {
+    length += shape->size();
+  }
+  std::string spliced;
+  spliced.reserve(length);
+
+  // the fixed point coordinates of the last point of the spliced shape
+  int32_t last_lat = 0, last_lon = 0;
+  for (const auto* shape : shapes) {
+    Shape5Decoder<std::pair<double, double>> decoder(shape->data(), shape->size());
+    if (decoder.empty()) {
+      continue;
     }
-    // write the last chunk
-    output.push_back(static_cast<char>(number & 0x7f));
-  };
+    const char* rest = shape->data();
+    if (!spliced.empty()) {
+      // the first point is the last one of the shape before so the second one is rebased on that
+      decoder.skip();
+      if (decoder.empty()) {
+        continue;
+      }
+      decoder.skip();
+      char offsets[2 * detail::kMaxEncodedChars5];
+      char* out = detail::serialize5(decoder.fixed_lat() - last_lat, offsets);
+      out = detail::serialize5(decoder.fixed_lon() - last_lon, out);
+      spliced.append(offsets, out);
+      rest = decoder.position();
+    }
+    spliced.append(rest, shape->data() + shape->size());
 
-  // this is an offset encoding so we remember the last point we saw
-  int last_lon = 0, last_lat = 0;
-  // for each point
-  for (const auto& p : points) {
-    // shift the decimal point x places to the right and truncate
-    int lon = static_cast<int>(round(static_cast<double>(p.first) * precision));
-    int lat = static_cast<int>(round(static_cast<double>(p.second) * precision));
-    // encode each coordinate, lat first for some reason
-    serialize(lat - last_lat);
-    serialize(lon - last_lon);
-    // remember the last one we encountered
-    last_lon = lon;
-    last_lat = lat;
+    // sum up the rest of the offsets to where this shape ends
+    while (!decoder.empty()) {
+      decoder.skip();
+    }
+    last_lat = decoder.fixed_lat();
+    last_lon = decoder.fixed_lon();
   }
-  return output;
+  return spliced;
 }
 
 } // namespace midgard
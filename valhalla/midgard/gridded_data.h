@@ -3,10 +3,15 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <exception>
 #include <functional>
 #include <limits>
 #include <list>
 #include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/midgard/polyline2.h>
 #include <valhalla/midgard/tiles.h>
@@ -61,6 +66,26 @@ public:
     }
   }
 
+  /**
+   * Get the value at a specified tile Id. Verifies that the tile is valid.
+   * @param  tile_id  Tile Id to get the value of.
+   * @return the value, or the max value for tiles outside of the grid
+   */
+  inline const value_type& Value(const int tile_id) const {
+    return tile_id >= 0 && tile_id < data_.size() ? data_[tile_id] : max_value_;
+  }
+
+  /**
+   * Reset the value at a specified tile Id to the max value so no contour reaches the tile.
+   * Verifies that the tile is valid.
+   * @param  tile_id  Tile Id to reset.
+   */
+  inline void Unset(const int tile_id) {
+    if (tile_id >= 0 && tile_id < data_.size()) {
+      data_[tile_id] = max_value_;
+    }
+  }
+
   using contour_t = std::list<PointLL>;
   using feature_t = std::list<contour_t>;
   using contours_t = std::vector<std::list<feature_t>>;
@@ -83,16 +108,159 @@ public:
    * @param generalize           Generalization factor in meters. A special value
    *                             kOptimalGeneralization will let the method choose
    *                             an optimal generalization factor based on grid size.
+   * @param thread_count         number of threads, counting the calling one, to trace
+   *                             the contours on. each contour is split into bands of
+   *                             rows which are traced on their own and joined afterwards
    *
    * @return contour line geometries with the larger intervals first (for rendering purposes)
    */
   contours_t GenerateContours(std::vector<contour_interval_t>& intervals,
                               const bool rings_only = false,
                               const float denoise = 1.f,
-                              const float generalize = 200.f) const {
+                              const float generalize = 200.f,
+                              const uint32_t thread_count = 1) const {
     // sort the contours first on the metric index then on the values with the bigger contours first
     std::sort(intervals.begin(), intervals.end(), std::greater<>());
 
+    // the outer rim is skipped since its out of bounds, a single band traces the grid exactly like
+    // it always has and more of them than threads balance out contours which bunch up in places
+    const int rows = std::max(this->nrows_ - 2, 0);
+    const int band_count = thread_count > 1 ? std::max(std::min<int>(thread_count * 2, rows), 1) : 1;
+
+    // the contours of a metric are all traced in the same sweep over the cells of a band
+    std::vector<std::pair<size_t, size_t>> metrics;
+    for (size_t i = 0; i < intervals.size(); ++i) {
+      if (metrics.empty() || std::get<0>(intervals[i]) != std::get<0>(intervals[i - 1])) {
+        metrics.emplace_back(i, i);
+      }
+      ++metrics.back().second;
+    }
+    std::vector<std::vector<span_t>> spans(metrics.size());
+    RunJobs(metrics.size(), thread_count, [&](const size_t i) {
+      spans[i] = ReachedSpans(std::get<0>(intervals[metrics[i].first]));
+    });
+
+    std::vector<feature_t> bands(intervals.size() * band_count);
+    RunJobs(metrics.size() * band_count, thread_count, [&](const size_t job) {
+      const int band = job % band_count;
+      const auto& metric = metrics[job / band_count];
+      std::vector<feature_t*> contours;
+      for (size_t i = metric.first; i < metric.second; ++i) {
+        contours.push_back(&bands[i * band_count + band]);
+      }
+      TraceContours(intervals, metric.first, metric.second, spans[job / band_count],
+                    1 + rows * band / band_count, 1 + rows * (band + 1) / band_count, contours);
+    });
+
+    // If the generalization value equals kOptimalGeneralization then set
+    // the generalization factor to 1/4 of the grid size
+    float gen_factor = generalize;
+    if (generalize == kOptimalGeneralization) {
+      gen_factor = this->tilesize_ * 0.25f * kMetersPerDegreeLat;
+    }
+
+    // we need something to hold each iso-line
+    contours_t contours(intervals.size(), std::list<feature_t>{feature_t{}});
+    RunJobs(contours.size(), thread_count, [&](const size_t i) {
+      for (int band = 0; band < band_count; ++band) {
+        JoinBand(bands[i * band_count + band], contours[i].front());
+      }
+      CleanContour(contours[i], rings_only, denoise, gen_factor);
+    });
+
+    return contours;
+  }
+
+protected:
+  // and something to find the iso-lines quickly
+  using contour_lookup_t = std::map<PointLL, typename feature_t::iterator>;
+  // the first and last columns of a row whose values were set, first > last if none of them were
+  using span_t = std::pair<int, int>;
+
+  /**
+   * Finds which columns of each row have been reached for a metric. A cell whose corners were all
+   * left at the max value cannot have any contour go through it so these let the tracing skip the
+   * parts of the grid the expansion never got to without looking at their cells.
+   * @param metric_index  which metric to look at
+   * @return the span of reached columns of each row
+   */
+  std::vector<span_t> ReachedSpans(const size_t metric_index) const {
+    std::vector<span_t> spans(this->nrows_, span_t{this->ncolumns_, -1});
+    const auto max_value = max_value_[metric_index];
+    for (int row = 0; row < this->nrows_; ++row) {
+      const auto* first = &data_[this->TileId(0, row)];
+      auto& span = spans[row];
+      for (int col = 0; col < this->ncolumns_; ++col) {
+        if (first[col][metric_index] < max_value) {
+          span.first = col;
+          break;
+        }
+      }
+      for (int col = this->ncolumns_ - 1; col >= span.first; --col) {
+        if (first[col][metric_index] < max_value) {
+          span.second = col;
+          break;
+        }
+      }
+    }
+    return spans;
+  }
+
+  /**
+   * Runs the jobs on up to thread_count threads, the calling thread being one of them, and
+   * rethrows the first exception any of them threw.
+   */
+  static void
+  RunJobs(const size_t count, const uint32_t thread_count, const std::function<void(size_t)>& job) {
+    std::atomic<size_t> next(0);
+    std::exception_ptr error;
+    std::mutex mutex;
+    auto work = [&]() {
+      for (auto i = next++; i < count; i = next++) {
+        try {
+          job(i);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!error) {
+            error = std::current_exception();
+          }
+          next = count;
+        }
+      }
+    };
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < std::min<size_t>(thread_count, count); ++t) {
+      threads.emplace_back(work);
+    }
+    work();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  /**
+   * Traces the lines of the contours of one metric through the cells of a band of rows. Each cell
+   * is read once for all of the contours and only the contours whose values are within the range
+   * of the cell are traced through it.
+   * @param intervals  the contours sorted by metric and then by descending value
+   * @param first      index of the first contour of the metric
+   * @param last       index past the last contour of the metric
+   * @param spans      the reached columns of each row for the metric
+   * @param row_begin  first row of the band
+   * @param row_end    row past the last row of the band
+   * @param contours   one for each contour of the metric, gets its lines. rings are closed and
+   *                   lines which leave the band are open
+   */
+  void TraceContours(const std::vector<contour_interval_t>& intervals,
+                     const size_t first,
+                     const size_t last,
+                     const std::vector<span_t>& spans,
+                     const int row_begin,
+                     const int row_end,
+                     const std::vector<feature_t*>& contours) const {
     // Values at tile corners and center (0 element is center)
     int sh[5];
     typename PointLL::first_type s[5]; // Values at the tile corners and center
@@ -189,227 +357,296 @@ public:
         },
     };
 
-    // which metrics do we need contours for
-    auto _ = std::make_pair(intervals.cbegin(), intervals.cend());
-    std::vector<decltype(_)> metrics{std::move(_)};
-    for (auto interval = intervals.cbegin(); interval != intervals.cend(); ++interval) {
-      if (std::get<0>(*interval) != std::get<0>(*metrics.back().first)) {
-        metrics.back().second = interval;
-        metrics.emplace_back(interval, intervals.cend());
+    const size_t metric_index = std::get<0>(intervals[first]);
+    const auto highest = std::get<1>(intervals[first]);
+    const auto lowest = std::get<1>(intervals[last - 1]);
+
+    // store begins and ends of the segments separately not to loose segment orientation
+    std::vector<contour_lookup_t> begin_lookups(last - first), end_lookups(last - first);
+
+    // the corner values of the cells of a row in a contiguous layout so that the range of each
+    // cell is found in plain loops the compiler can vectorize
+    std::vector<float> lower, upper, cell_min, cell_max;
+
+    // For each cell of the band
+    for (int row = row_begin; row < row_end; ++row) {
+      // only the cells with a reached corner can have a contour go through them
+      const auto& below = spans[row];
+      const auto& above = spans[row + 1];
+      const int col_begin = std::max(std::min(below.first, above.first) - 1, 1);
+      const int col_end = std::min(std::max(below.second, above.second) + 1, this->ncolumns_ - 1);
+      if (col_begin >= col_end) {
+        continue;
       }
-    }
 
-    // we need something to hold each iso-line
-    contours_t contours(intervals.size(), std::list<feature_t>{feature_t{}});
+      const int width = col_end - col_begin;
+      lower.resize(width + 1);
+      upper.resize(width + 1);
+      cell_min.resize(width);
+      cell_max.resize(width);
+      const auto* lower_row = &data_[this->TileId(col_begin, row)];
+      const auto* upper_row = lower_row + this->ncolumns_;
+      for (int i = 0; i <= width; ++i) {
+        lower[i] = lower_row[i][metric_index];
+        upper[i] = upper_row[i][metric_index];
+      }
+      for (int i = 0; i < width; ++i) {
+        cell_min[i] = std::min(std::min(lower[i], lower[i + 1]), std::min(upper[i], upper[i + 1]));
+        cell_max[i] = std::max(std::max(lower[i], lower[i + 1]), std::max(upper[i], upper[i + 1]));
+      }
 
-    // and something to find them quickly
-    using contour_lookup_t = std::map<PointLL, typename feature_t::iterator>;
-    // store begins and ends of the segments separately not to loose segment orientation
-    std::vector<contour_lookup_t> begin_lookups(intervals.size());
-    std::vector<contour_lookup_t> end_lookups(intervals.size());
-    // TODO: preallocate the lookups for each interval
-
-    // For each metric we tracked
-    for (const auto& metric : metrics) {
-      size_t metric_index = std::get<0>(*metric.first);
-
-      // For each cell, skipping the outer rim since its out of bounds
-      for (int row = 1; row < this->nrows_ - 1; ++row) {
-        for (int col = 1; col < this->ncolumns_ - 1; ++col) {
-          int tileid = this->TileId(col, row);
-          auto cell1 = data_[tileid][metric_index];
-          auto cell2 = data_[tileid + this->ncolumns_][metric_index];     // TileId(col,   row+1)];
-          auto cell3 = data_[tileid + 1][metric_index];                   // TileId(col+1, row)];
-          auto cell4 = data_[tileid + this->ncolumns_ + 1][metric_index]; // TileId(col+1, row+1)];
-          auto dmin = std::min(std::min(cell1, cell2), std::min(cell3, cell4));
-          auto dmax = std::max(std::max(cell1, cell2), std::max(cell3, cell4));
-
-          // Continue if outside the range of contour values for this metric_index
-          if (dmax < std::get<1>(*std::prev(metric.second)) || dmin > std::get<1>(*metric.first)) {
+      for (int i = 0; i < width; ++i) {
+        // we skip this cell if none of the contours would intersect it
+        const auto dmin = cell_min[i];
+        const auto dmax = cell_max[i];
+        if (highest < dmin || lowest > dmax) {
+          continue;
+        }
+
+        const int tileid = this->TileId(col_begin + i, row);
+        for (int m = 1; m <= 4; ++m) {
+          tile_corners[m] = this->Base(tileid + tile_inc[m - 1]);
+        }
+        tile_corners[0] = this->Center(tileid);
+
+        for (size_t k = first; k < last; ++k) {
+          // we skip this contour if its value would not intersect the cell
+          const auto contour_value = std::get<1>(intervals[k]);
+          if (contour_value < dmin || contour_value > dmax) {
             continue;
           }
-
-          // For each requested contour value
-          for (size_t i = 0; i < intervals.size(); ++i) {
-            // some setup to process this contour
-            auto& begin_lookup = begin_lookups[i];
-            auto& end_lookup = end_lookups[i];
-            auto& contour = contours[i];
-            auto contour_value = std::get<1>(intervals[i]);
-
-            // we skip this contour if its interested in a different metric_index or its value
-            // would not intersect this cell
-            if (std::get<0>(intervals[i]) != metric_index || contour_value < dmin ||
-                contour_value > dmax) {
+          auto& begin_lookup = begin_lookups[k - first];
+          auto& end_lookup = end_lookups[k - first];
+          auto& contour = *contours[k - first];
+
+          for (int m = 4; m > 0; m--) {
+            int newtileid = tileid + tile_inc[m - 1];
+            // Make sure the tile corner value is not set to the max_value
+            // (messes up the intersect method). Set a value slightly above
+            // the contour (e.g. 1 minute higher).
+            // TODO - the value 1 is a bit of a hack.
+            float nd = data_[newtileid][metric_index];
+            s[m] = nd < max_value_[metric_index] ? nd - contour_value : 1.0f;
+            sh[m] = (s[m] > 0.0f) - (s[m] < 0.0f); // pos = 1, neg = -1, 0 = 0
+          }
+          s[0] = 0.25 * (s[1] + s[2] + s[3] + s[4]);
+          sh[0] = (s[0] > 0.0f) - (s[0] < 0.0f); // pos = 1, neg = -1, 0 = 0
+
+          /*
+           Note: at this stage the relative heights of the corners and the
+           centre are in the h array, and the corresponding coordinates are
+           in the xh and yh arrays. The centre of the box is indexed by 0
+           and the 4 corners by 1 to 4 as shown below.
+           Each triangle is then indexed by the parameter m, and the 3
+           vertices of each triangle are indexed by parameters m1,m2,and m3.
+           It is assumed that the centre of the box is always vertex 2
+           though this is important only when all 3 vertices lie exactly on
+           the same contour level, in which case only the side of the box
+           is drawn.
+              vertex 4 +-------------------+ vertex 3
+                       | \               / |
+                       |   \    m-3    /   |
+                       |     \       /     |
+                       |       \   /       |
+                       |  m=2    X   m=2   |       the centre is vertex 0
+                       |       /   \       |
+                       |     /       \     |
+                       |   /    m=1    \   |
+                       | /               \ |
+              vertex 1 +-------------------+ vertex 2
+          */
+
+          // Scan each triangle in the box
+          for (int m = 1; m <= 4; m++) {
+            // figure out which intersection we need to do
+            m1 = m;
+            m2 = 0;
+            m3 = (m != 4) ? m + 1 : 1;
+            int case_index = case_table[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1];
+            bool swap_points = swap_table[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1];
+
+            // there is no intersection of this triangle
+            if (case_index == 0) {
               continue;
             }
 
-            for (int m = 4; m > 0; m--) {
-              int newtileid = tileid + tile_inc[m - 1];
-              // Make sure the tile corner value is not set to the max_value
-              // (messes up the intersect method). Set a value slightly above
-              // the contour (e.g. 1 minute higher).
-              // TODO - the value 1 is a bit of a hack.
-              float nd = data_[newtileid][metric_index];
-              s[m] = nd < max_value_[metric_index] ? nd - contour_value : 1.0f;
-              tile_corners[m] = this->Base(newtileid);
-              sh[m] = (s[m] > 0.0f) - (s[m] < 0.0f); // pos = 1, neg = -1, 0 = 0
-            }
-            s[0] = 0.25 * (s[1] + s[2] + s[3] + s[4]);
-            tile_corners[0] = this->Center(tileid);
-            sh[0] = (s[0] > 0.0f) - (s[0] < 0.0f); // pos = 1, neg = -1, 0 = 0
-
-            /*
-             Note: at this stage the relative heights of the corners and the
-             centre are in the h array, and the corresponding coordinates are
-             in the xh and yh arrays. The centre of the box is indexed by 0
-             and the 4 corners by 1 to 4 as shown below.
-             Each triangle is then indexed by the parameter m, and the 3
-             vertices of each triangle are indexed by parameters m1,m2,and m3.
-             It is assumed that the centre of the box is always vertex 2
-             though this is important only when all 3 vertices lie exactly on
-             the same contour level, in which case only the side of the box
-             is drawn.
-                vertex 4 +-------------------+ vertex 3
-                         | \               / |
-                         |   \    m-3    /   |
-                         |     \       /     |
-                         |       \   /       |
-                         |  m=2    X   m=2   |       the centre is vertex 0
-                         |       /   \       |
-                         |     /       \     |
-                         |   /    m=1    \   |
-                         | /               \ |
-                vertex 1 +-------------------+ vertex 2
-            */
-
-            // Scan each triangle in the box
-            for (int m = 1; m <= 4; m++) {
-              // figure out which intersection we need to do
-              m1 = m;
-              m2 = 0;
-              m3 = (m != 4) ? m + 1 : 1;
-              int case_index = case_table[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1];
-              bool swap_points = swap_table[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1];
-
-              // there is no intersection of this triangle
-              if (case_index == 0) {
-                continue;
-              }
+            // do the intersection, assigns to pt1 and pt2 inside lambdas defined above
+            cases[case_index]();
 
-              // do the intersection, assigns to pt1 and pt2 inside lambdas defined above
-              cases[case_index]();
+            // this isnt a segment..
+            if (from_pt == to_pt) {
+              continue;
+            }
+            if (swap_points) {
+              std::swap(from_pt, to_pt);
+            }
 
-              // this isnt a segment..
-              if (from_pt == to_pt) {
+            // see if we have anything to connect this segment to
+            typename contour_lookup_t::iterator end_lookup_it = end_lookup.find(from_pt);
+            typename contour_lookup_t::iterator begin_lookup_it = begin_lookup.find(to_pt);
+
+            if (end_lookup_it != end_lookup.end() && begin_lookup_it != begin_lookup.end()) {
+              // we want to merge two records
+              //   first_segment                               second_segment
+              // (... ------> from_pt) + (from_pt, to_pt) + (to_pt ------> ...)
+              auto first_segment = end_lookup_it->second;
+              auto second_segment = begin_lookup_it->second;
+              end_lookup.erase(end_lookup_it);
+              begin_lookup.erase(begin_lookup_it);
+
+              // this segment is now a ring
+              if (first_segment == second_segment) {
+                first_segment->push_back(first_segment->front());
                 continue;
               }
-              if (swap_points) {
-                std::swap(from_pt, to_pt);
-              }
 
-              // see if we have anything to connect this segment to
-              typename contour_lookup_t::iterator end_lookup_it = end_lookup.find(from_pt);
-              typename contour_lookup_t::iterator begin_lookup_it = begin_lookup.find(to_pt);
-
-              if (end_lookup_it != end_lookup.end() && begin_lookup_it != begin_lookup.end()) {
-                // we want to merge two records
-                //   first_segment                               second_segment
-                // (... ------> from_pt) + (from_pt, to_pt) + (to_pt ------> ...)
-                auto first_segment = end_lookup_it->second;
-                auto second_segment = begin_lookup_it->second;
-                end_lookup.erase(end_lookup_it);
-                begin_lookup.erase(begin_lookup_it);
-
-                // this segment is now a ring
-                if (first_segment == second_segment) {
-                  first_segment->push_back(first_segment->front());
-                  continue;
-                }
-
-                end_lookup[second_segment->back()] = first_segment;
-                first_segment->splice(first_segment->end(), *second_segment);
-                contour.front().erase(second_segment);
-              } else if (end_lookup_it != end_lookup.end()) {
-                // (... ------> from_pt) + (from_pt, to_pt)
-                end_lookup_it->second->push_back(to_pt);
-                end_lookup.emplace(to_pt, end_lookup_it->second);
-                end_lookup.erase(end_lookup_it);
-              } else if (begin_lookup_it != begin_lookup.end()) {
-                // (from_pt, to_pt) + (to_pt ------> ...)
-                begin_lookup_it->second->push_front(from_pt);
-                begin_lookup.emplace(from_pt, begin_lookup_it->second);
-                begin_lookup.erase(begin_lookup_it);
-              } else {
-                // this is an orphan segment for now
-                contour.front().push_front(contour_t{from_pt, to_pt});
-                begin_lookup.emplace(from_pt, contour.front().begin());
-                end_lookup.emplace(to_pt, contour.front().begin());
-              }
+              end_lookup[second_segment->back()] = first_segment;
+              first_segment->splice(first_segment->end(), *second_segment);
+              contour.erase(second_segment);
+            } else if (end_lookup_it != end_lookup.end()) {
+              // (... ------> from_pt) + (from_pt, to_pt)
+              end_lookup_it->second->push_back(to_pt);
+              end_lookup.emplace(to_pt, end_lookup_it->second);
+              end_lookup.erase(end_lookup_it);
+            } else if (begin_lookup_it != begin_lookup.end()) {
+              // (from_pt, to_pt) + (to_pt ------> ...)
+              begin_lookup_it->second->push_front(from_pt);
+              begin_lookup.emplace(from_pt, begin_lookup_it->second);
+              begin_lookup.erase(begin_lookup_it);
+            } else {
+              // this is an orphan segment for now
+              contour.push_front(contour_t{from_pt, to_pt});
+              begin_lookup.emplace(from_pt, contour.begin());
+              end_lookup.emplace(to_pt, contour.begin());
             }
-          } // Each contour
-        }   // Each tile col
-      }     // Each tile row
-    }       // Each dimension of the grid
+          }
+        } // Each contour
+      }   // Each tile col
+    }     // Each tile row
+  }
 
-    // If the generalization value equals kOptimalGeneralization then set
-    // the generalization factor to 1/4 of the grid size
-    float gen_factor = generalize;
-    if (generalize == kOptimalGeneralization) {
-      gen_factor = this->tilesize_ * 0.25f * kMetersPerDegreeLat;
+  /**
+   * Appends the lines a band traced to the ones of the bands before it, joining up the open lines
+   * which continue from one band into the next.
+   * @param band     lines of the band, they are moved out of it
+   * @param contour  lines of the bands so far
+   */
+  void JoinBand(feature_t& band, feature_t& contour) const {
+    contour_lookup_t begin_lookup, end_lookup;
+    for (auto line = contour.begin(); line != contour.end(); ++line) {
+      if (line->front() != line->back()) {
+        begin_lookup.emplace(line->front(), line);
+        end_lookup.emplace(line->back(), line);
+      }
     }
 
-    // some info about the area the image covers
-    auto c = this->TileBounds().Center();
-    auto h = this->tilesize_ / 2;
-    // for each contour
-    for (auto& collection : contours) {
-      auto& contour = collection.front();
-      // they only wanted rings
-      if (rings_only) {
-        contour.remove_if([](const contour_t& line) { return line.front() != line.back(); });
+    while (!band.empty()) {
+      auto line = band.begin();
+      const auto from_pt = line->front();
+      const auto to_pt = line->back();
+      // rings are done
+      if (from_pt == to_pt) {
+        contour.splice(contour.end(), band, line);
+        continue;
       }
-      // sort them by area (maybe length would be sufficient?) biggest first
-      std::unordered_map<const contour_t*, typename PointLL::first_type> cache(contour.size());
-      std::for_each(contour.cbegin(), contour.cend(),
-                    [&cache](const contour_t& c) { cache[&c] = polygon_area(c); });
-      contour.sort([&cache](const contour_t& a, const contour_t& b) {
-        return std::abs(cache[&a]) > std::abs(cache[&b]);
-      });
 
-      // they only want the most significant ones!
-      if (denoise > 0.f) {
-        contour.remove_if([&cache, &contour, denoise](const contour_t& c) {
-          return std::abs(cache[&c] / cache[&contour.front()]) < denoise;
-        });
-      }
-      // clean up the lines
-      for (auto& line : contour) {
-        if (gen_factor > 0.f) {
-          Polyline2<PointLL>::Generalize(line, gen_factor, {}, /* avoid_self_intersections */ true);
-        }
-        // sampling the bottom left corner means everything is skewed, so unskew it
-        for (auto& coord : line) {
-          coord.first += h;
-          coord.second += h;
+      // the same cases as joining a segment to the lines, the shared end points are only kept once
+      auto end_lookup_it = end_lookup.find(from_pt);
+      auto begin_lookup_it = begin_lookup.find(to_pt);
+      if (end_lookup_it != end_lookup.end() && begin_lookup_it != begin_lookup.end()) {
+        auto first_segment = end_lookup_it->second;
+        auto second_segment = begin_lookup_it->second;
+        end_lookup.erase(end_lookup_it);
+        begin_lookup.erase(begin_lookup_it);
+        line->pop_front();
+        if (first_segment == second_segment) {
+          first_segment->splice(first_segment->end(), *line);
+          band.erase(line);
+          continue;
         }
+        line->pop_back();
+        first_segment->splice(first_segment->end(), *line);
+        band.erase(line);
+        end_lookup[second_segment->back()] = first_segment;
+        first_segment->splice(first_segment->end(), *second_segment);
+        contour.erase(second_segment);
+      } else if (end_lookup_it != end_lookup.end()) {
+        auto first_segment = end_lookup_it->second;
+        end_lookup.erase(end_lookup_it);
+        line->pop_front();
+        first_segment->splice(first_segment->end(), *line);
+        band.erase(line);
+        end_lookup.emplace(to_pt, first_segment);
+      } else if (begin_lookup_it != begin_lookup.end()) {
+        auto second_segment = begin_lookup_it->second;
+        begin_lookup.erase(begin_lookup_it);
+        line->pop_back();
+        second_segment->splice(second_segment->begin(), *line);
+        band.erase(line);
+        begin_lookup.emplace(from_pt, second_segment);
+      } else {
+        contour.splice(contour.begin(), band, line);
+        begin_lookup.emplace(from_pt, contour.begin());
+        end_lookup.emplace(to_pt, contour.begin());
       }
-      // remove points and lines
-      contour.remove_if([](const contour_t& line) { return line.size() < 4; });
+    }
+  }
 
-      // if they just wanted linestrings we need only one per feature
-      if (!rings_only) {
-        for (auto& linestring : contour) {
-          collection.push_back({std::move(linestring)});
-        }
-        collection.pop_front();
+  /**
+   * Sorts, denoises and generalizes the lines of a contour.
+   * @param collection  the contour, split into one feature per line unless rings_only
+   * @param rings_only  only keep the rings
+   * @param denoise     see GenerateContours
+   * @param gen_factor  generalization factor in meters
+   */
+  void CleanContour(std::list<feature_t>& collection,
+                    const bool rings_only,
+                    const float denoise,
+                    const float gen_factor) const {
+    // some info about the area the image covers
+    auto h = this->tilesize_ / 2;
+    auto& contour = collection.front();
+    // they only wanted rings
+    if (rings_only) {
+      contour.remove_if([](const contour_t& line) { return line.front() != line.back(); });
+    }
+    // sort them by area (maybe length would be sufficient?) biggest first
+    std::unordered_map<const contour_t*, typename PointLL::first_type> cache(contour.size());
+    std::for_each(contour.cbegin(), contour.cend(),
+                  [&cache](const contour_t& c) { cache[&c] = polygon_area(c); });
+    contour.sort([&cache](const contour_t& a, const contour_t& b) {
+      return std::abs(cache[&a]) > std::abs(cache[&b]);
+    });
+
+    // they only want the most significant ones!
+    if (denoise > 0.f) {
+      contour.remove_if([&cache, &contour, denoise](const contour_t& c) {
+        return std::abs(cache[&c] / cache[&contour.front()]) < denoise;
+      });
+    }
+    // clean up the lines
+    for (auto& line : contour) {
+      if (gen_factor > 0.f) {
+        Polyline2<PointLL>::Generalize(line, gen_factor, {}, /* avoid_self_intersections */ true);
+      }
+      // sampling the bottom left corner means everything is skewed, so unskew it
+      for (auto& coord : line) {
+        coord.first += h;
+        coord.second += h;
       }
     }
+    // remove points and lines
+    contour.remove_if([](const contour_t& line) { return line.size() < 4; });
 
-    return contours;
+    // if they just wanted linestrings we need only one per feature
+    if (!rings_only) {
+      for (auto& linestring : contour) {
+        collection.push_back({std::move(linestring)});
+      }
+      collection.pop_front();
+    }
   }
 
-protected:
   value_type max_value_;         // Maximum value stored in the tile
   std::vector<value_type> data_; // Data value within each tile
 };
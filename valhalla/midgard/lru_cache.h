@@ -0,0 +1,98 @@
+#ifndef VALHALLA_MIDGARD_LRU_CACHE_H_
+#define VALHALLA_MIDGARD_LRU_CACHE_H_
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * A map of at most a fixed number of entries which evicts the least recently used entry to make
+ * room for a new one. Counts how many lookups found their entry.
+ */
+template <typename key_t, typename value_t, typename hash_t = std::hash<key_t>> class lru_cache_t {
+public:
+  explicit lru_cache_t(const size_t capacity) : capacity_(capacity) {
+    index_.reserve(capacity);
+  }
+
+  /**
+   * Finds an entry and marks it as the most recently used one.
+   * @param key    the key of the entry
+   * @param value  set to the value of the entry if there is one
+   * @return true if there is an entry
+   */
+  bool find(const key_t& key, value_t& value) {
+    auto found = index_.find(key);
+    if (found == index_.end()) {
+      ++misses_;
+      return false;
+    }
+    entries_.splice(entries_.begin(), entries_, found->second);
+    value = found->second->second;
+    ++hits_;
+    return true;
+  }
+
+  /**
+   * Adds or replaces an entry, evicting the least recently used one if the cache is full.
+   * @param key    the key of the entry
+   * @param value  the value of the entry
+   */
+  void insert(const key_t& key, const value_t& value) {
+    if (capacity_ == 0) {
+      return;
+    }
+    auto found = index_.find(key);
+    if (found != index_.end()) {
+      found->second->second = value;
+      entries_.splice(entries_.begin(), entries_, found->second);
+      return;
+    }
+    if (entries_.size() == capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+    entries_.emplace_front(key, value);
+    index_.emplace(key, entries_.begin());
+  }
+
+  // Forgets all the entries but not the counts of the lookups
+  void clear() {
+    entries_.clear();
+    index_.clear();
+  }
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  size_t hits() const {
+    return hits_;
+  }
+
+  size_t misses() const {
+    return misses_;
+  }
+
+protected:
+  using entry_t = std::pair<key_t, value_t>;
+  size_t capacity_;
+  std::list<entry_t> entries_;
+  std::unordered_map<key_t, typename std::list<entry_t>::iterator, hash_t> index_;
+  size_t hits_{};
+  size_t misses_{};
+};
+
+} // namespace midgard
+} // namespace valhalla
+
+#endif // VALHALLA_MIDGARD_LRU_CACHE_H_
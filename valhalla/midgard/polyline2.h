@@ -97,9 +97,7 @@ public:
   uint32_t Generalize(const typename coord_t::value_type t,
                       const std::unordered_set<size_t>& indices = {},
                       bool avoid_self_intersection = false) {
-    // Create a vector for the output shape. Recursively call Douglass-Peucker
-    // method to generalize the polyline. Square the error tolerance to avoid
-    // sqrts.
+    // Generalize the points in place with the Douglas-Peucker method
     Generalize(pts_, t, indices, avoid_self_intersection);
     return pts_.size();
   }
@@ -115,15 +113,15 @@ public:
   Polyline2 GeneralizedPolyline(const typename coord_t::value_type t,
                                 const std::unordered_set<size_t>& indices = {},
                                 bool avoid_self_intersection = false) {
-    // Recursively call Douglass-Peucker method to generalize the polyline.
-    // Square the error tolerance to avoid sqrts.
+    // Generalize a copy of the points with the Douglas-Peucker method
     Polyline2 generalized(pts_);
     generalized.Generalize(t, indices, avoid_self_intersection);
     return generalized;
   }
 
   /**
-   * Generalize the given list of points
+   * Generalize the given list of points. A vector is simplified in place in linear memory without
+   * recursion, every other container one range of points at a time.
    *
    * @param polyline    the list of points
    * @param epsilon     the tolerance used in removing points
@@ -16,6 +16,7 @@
 #include <queue>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
@@ -171,7 +172,8 @@ public:
   void map(const std::string& new_file_name,
            size_t new_count,
            int advice = POSIX_MADV_NORMAL,
-           bool readonly = false) {
+           bool readonly = false,
+           int flags = 0) {
     // just in case there was already something
     unmap();
 
@@ -187,7 +189,7 @@ public:
         throw std::runtime_error(new_file_name + "(open): " + strerror(errno));
       }
       ptr = mmap(nullptr, new_count * sizeof(T), (readonly ? PROT_READ : PROT_READ | PROT_WRITE),
-                 MAP_SHARED, fd, 0);
+                 MAP_SHARED | flags, fd, 0);
       if (ptr == MAP_FAILED) {
         throw std::runtime_error(new_file_name + "(mmap): " + strerror(errno));
       }
@@ -207,9 +209,56 @@ public:
   }
 
   // reset to another file or another size with readonly permissions
-  void
-  map_readonly(const std::string& new_file_name, size_t new_count, int advice = POSIX_MADV_NORMAL) {
-    map(new_file_name, new_count, advice, true /* readonly */);
+  void map_readonly(const std::string& new_file_name,
+                    size_t new_count,
+                    int advice = POSIX_MADV_NORMAL,
+                    int flags = 0) {
+    map(new_file_name, new_count, advice, true /* readonly */, flags);
+  }
+
+  // give the kernel advice about a range of elements, the range is widened to whole pages
+  bool advise(size_t offset, size_t length, int advice) const {
+#if defined(_WIN32)
+    return false;
+#else
+    size_t begin, end;
+    if (!pages(offset, length, begin, end))
+      return false;
+    return madvise(static_cast<char*>(ptr) + begin, end - begin, advice) == 0;
+#endif
+  }
+
+  // keep a range of elements resident, the range is widened to whole pages
+  bool lock(size_t offset, size_t length) const {
+#if defined(_WIN32)
+    return false;
+#else
+    size_t begin, end;
+    if (!pages(offset, length, begin, end))
+      return false;
+    return mlock(static_cast<char*>(ptr) + begin, end - begin) == 0;
+#endif
+  }
+
+  // how many bytes of the pages of a range of elements are resident in memory
+  size_t resident(size_t offset, size_t length) const {
+#if defined(_WIN32)
+    return 0;
+#else
+    size_t begin, end;
+    if (!pages(offset, length, begin, end))
+      return 0;
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+#if defined(__APPLE__)
+    std::vector<char> in_core((end - begin) / page_size);
+#else
+    std::vector<unsigned char> in_core((end - begin) / page_size);
+#endif
+    if (mincore(static_cast<char*>(ptr) + begin, end - begin, in_core.data()) != 0)
+      return 0;
+    return std::count_if(in_core.begin(), in_core.end(), [](unsigned char c) { return c & 1; }) *
+           page_size;
+#endif
   }
 
   // drop the map
@@ -257,6 +306,19 @@ protected:
   void* ptr;
   size_t count;
   std::string file_name;
+
+#if !defined(_WIN32)
+  // the byte range of the pages covering a range of elements, false if there are none
+  bool pages(size_t offset, size_t length, size_t& begin, size_t& end) const {
+    if (!ptr || offset >= count || length == 0)
+      return false;
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    begin = offset * sizeof(T) / page_size * page_size;
+    end = std::min(offset + length, count) * sizeof(T);
+    end = (end + page_size - 1) / page_size * page_size;
+    return true;
+  }
+#endif
 };
 
 template <class T> class sequence {
@@ -325,65 +387,100 @@ public:
     return npos;
   }
 
-  // sort the file based on the predicate, and outputs to output_seq
+  // sort the file based on the predicate
   //
-  // Strategy is to first sort sub-ranges of length buffer_size in place.
-  // These should all fit in memory. Then, merge the sub-ranges into the
-  // output sequence via priority queue.
+  // Strategy is to first read runs of length buffer_size into memory, sort them with the given
+  // number of threads and write them to a temporary file. Then the runs are merged back into this
+  // file via priority queue, reading each of them through its own large sequential buffer. The sort
+  // is stable so the output depends neither on the buffer size nor on the number of threads. Note
+  // that sorting a run or a range in memory needs up to as much memory again as temporary space.
   void sort(const std::function<bool(const T&, const T&)>& predicate,
-            size_t buffer_size = 1024 * 1024 * 512 / sizeof(T)) {
+            size_t buffer_size = 1024 * 1024 * 512 / sizeof(T),
+            size_t threads = 1) {
     flush();
     // if no elements we are done
     if (memmap.size() == 0) {
       return;
     }
+    buffer_size = std::max(buffer_size, static_cast<size_t>(1));
 
     // If there wont be any merging we may as well take the simple approach
-    if (buffer_size > memmap.size() + write_buffer.size()) {
-      std::sort(static_cast<T*>(memmap), static_cast<T*>(memmap) + memmap.size(), predicate);
+    if (buffer_size > memmap.size()) {
+      sort_range(static_cast<T*>(memmap), static_cast<T*>(memmap) + memmap.size(), predicate,
+                 threads);
       return;
     }
 
-    auto tmp_path = filesystem::path(file_name).replace_filename(
-        filesystem::path(file_name).filename().string() + ".tmp");
+    // Sort the runs, reading and writing them sequentially rather than through the memory map
+    auto runs_path = filesystem::path(file_name).replace_filename(
+        filesystem::path(file_name).filename().string() + ".runs.tmp");
+    const size_t count = memmap.size();
+    std::vector<std::pair<size_t, size_t>> runs;
     {
-      // we need a temporary sequence to merge the sorted subsections into
-      sequence<T> output_seq(tmp_path.string(), true);
+      std::ifstream in(file_name, std::ios::binary);
+      std::ofstream out(runs_path.string(), std::ios::binary | std::ios::trunc);
+      std::vector<storage_t> storage(std::min(buffer_size, count));
+      T* run = static_cast<T*>(static_cast<void*>(storage.data()));
+      for (size_t i = 0; i < count; i += buffer_size) {
+        size_t run_size = std::min(buffer_size, count - i);
+        in.read(static_cast<char*>(static_cast<void*>(run)), run_size * sizeof(T));
+        sort_range(run, run + run_size, predicate, threads);
+        out.write(static_cast<const char*>(static_cast<const void*>(run)), run_size * sizeof(T));
+        runs.emplace_back(i, i + run_size);
+      }
+      if (!in || !out) {
+        throw std::runtime_error("sequence: " + runs_path.string() + ": failed to write runs");
+      }
+    }
+
+    // Forget about this file for a second so we can write the merged runs over it
+    file.reset();
+    memmap.unmap();
+
+    {
+      // the memory is split between the input buffers of the runs and the output buffer
+      const size_t io_size = std::max(buffer_size / (runs.size() + 1), static_cast<size_t>(1));
+      std::vector<run_reader> readers;
+      readers.reserve(runs.size());
+      for (const auto& run : runs) {
+        readers.emplace_back(runs_path.string(), run.first, run.second, io_size);
+      }
 
       // Comparator needs to be inverted for pq to provide constant time *smallest* lookup
-      // Pq keeps track of element and its index.
-      auto cmp = [&predicate](const std::pair<T, int>& a, std::pair<T, int>& b) {
-        return predicate(b.first, a.first);
+      // Pq keeps track of element and the run its from, ties go to the earlier run
+      auto cmp = [&predicate](const std::pair<T, size_t>& a, const std::pair<T, size_t>& b) {
+        return predicate(b.first, a.first) || (!predicate(a.first, b.first) && a.second > b.second);
       };
-      std::priority_queue<std::pair<T, int>, std::vector<std::pair<T, int>>, decltype(cmp)> pq(cmp);
-
-      // Sort the subsections
-      for (size_t i = 0; i < memmap.size(); i += buffer_size) {
-        std::sort(static_cast<T*>(memmap) + i,
-                  static_cast<T*>(memmap) + std::min(memmap.size(), i + buffer_size), predicate);
-        pq.emplace(*at(i), i);
+      std::priority_queue<std::pair<T, size_t>, std::vector<std::pair<T, size_t>>, decltype(cmp)>
+          pq(cmp);
+      for (size_t i = 0; i < readers.size(); ++i) {
+        pq.emplace(readers[i].next(), i);
       }
 
       // Perform the merge
+      std::ofstream out(file_name, std::ios::binary | std::ios::in | std::ios::out);
+      std::vector<T> output;
+      output.reserve(io_size);
       while (!pq.empty()) {
         auto tmp = pq.top();
         pq.pop();
-        output_seq.push_back(tmp.first);
-        size_t new_idx = tmp.second + 1;
-        if (new_idx % buffer_size != 0 && new_idx < memmap.size()) {
-          pq.emplace(*at(new_idx), new_idx);
+        output.push_back(tmp.first);
+        if (output.size() == io_size) {
+          out.write(static_cast<const char*>(static_cast<const void*>(output.data())),
+                    output.size() * sizeof(T));
+          output.clear();
+        }
+        if (!readers[tmp.second].done()) {
+          pq.emplace(readers[tmp.second].next(), tmp.second);
         }
       }
-      output_seq.flush();
+      out.write(static_cast<const char*>(static_cast<const void*>(output.data())),
+                output.size() * sizeof(T));
+      if (!out) {
+        throw std::runtime_error("sequence: " + file_name + ": failed to write merged runs");
+      }
     }
-
-    // Forget about this file for a second so we can swap in the temp file
-    file.reset();
-    memmap.unmap();
-
-    // Move the sorted result back into place
-    filesystem::remove(file_name);
-    filesystem::rename(tmp_path, file_name);
+    filesystem::remove(runs_path);
 
     // Reload the sequence
     sequence<T> reloaded(file_name, false);
@@ -590,6 +687,85 @@ protected:
   std::string file_name;
   std::vector<T> write_buffer;
   mem_map<T> memmap;
+
+  // uninitialized memory for elements, they need not be default constructible
+  using storage_t = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+  // reads a sorted run of the temporary file of a sort through a buffer
+  struct run_reader {
+    run_reader(const std::string& file_name, size_t begin, size_t end, size_t buffer_size)
+        : in(new std::ifstream(file_name, std::ios::binary)), remaining(end - begin),
+          storage(buffer_size), size(0), position(0) {
+      in->seekg(begin * sizeof(T));
+    }
+
+    bool done() const {
+      return remaining == 0 && position == size;
+    }
+
+    T next() {
+      T* buffer = static_cast<T*>(static_cast<void*>(storage.data()));
+      if (position == size) {
+        size = std::min(storage.size(), remaining);
+        in->read(static_cast<char*>(static_cast<void*>(buffer)), size * sizeof(T));
+        if (!*in) {
+          throw std::runtime_error("sequence: failed to read a sorted run");
+        }
+        remaining -= size;
+        position = 0;
+      }
+      return buffer[position++];
+    }
+
+    std::unique_ptr<std::ifstream> in;
+    size_t remaining;
+    std::vector<storage_t> storage;
+    size_t size;
+    size_t position;
+  };
+
+  // stable sorts a range in memory, each thread sorts a part of it and then neighbouring parts are
+  // merged in parallel until there is only one left
+  static void sort_range(T* begin,
+                         T* end,
+                         const std::function<bool(const T&, const T&)>& predicate,
+                         size_t threads) {
+    // not worth starting threads for small ranges
+    const size_t count = end - begin;
+    const size_t parts = std::max(std::min(threads, count / 16384), static_cast<size_t>(1));
+    std::vector<T*> bounds;
+    for (size_t i = 0; i < parts; ++i) {
+      bounds.push_back(begin + count * i / parts);
+    }
+    bounds.push_back(end);
+
+    // do a job per part or pair of parts on its own thread
+    auto in_parallel = [](size_t jobs, const std::function<void(size_t)>& job) {
+      std::vector<std::thread> workers;
+      for (size_t i = 1; i < jobs; ++i) {
+        workers.emplace_back(job, i);
+      }
+      job(0);
+      for (auto& worker : workers) {
+        worker.join();
+      }
+    };
+
+    in_parallel(parts, [&](size_t i) { std::stable_sort(bounds[i], bounds[i + 1], predicate); });
+    while (bounds.size() > 2) {
+      in_parallel((bounds.size() - 1) / 2, [&](size_t i) {
+        std::inplace_merge(bounds[i * 2], bounds[i * 2 + 1], bounds[i * 2 + 2], predicate);
+      });
+      std::vector<T*> merged;
+      for (size_t i = 0; i < bounds.size(); i += 2) {
+        merged.push_back(bounds[i]);
+      }
+      if (bounds.size() % 2 == 0) {
+        merged.push_back(bounds.back());
+      }
+      bounds.swap(merged);
+    }
+  }
 };
 
 struct tar {
@@ -657,8 +833,23 @@ struct tar {
     }
   };
 
-  tar(const std::string& tar_file, bool regular_files_only = true)
-      : tar_file(tar_file), corrupt_blocks(0) {
+  /**
+   * Maps the archive and records the location of its members
+   * @param tar_file            the archive to load
+   * @param regular_files_only  whether or not to only record regular files
+   * @param index_member        if the first member of the archive has this name, only that member
+   *                            is recorded and the rest of the archive is left untouched. this
+   *                            allows archives that carry an index of their own to load without
+   *                            reading every header. use traverse() if the index turns out to
+   *                            be unusable
+   * @param map_flags           extra flags to map the archive with, like MAP_POPULATE
+   */
+  tar(const std::string& tar_file,
+      bool regular_files_only = true,
+      const std::string& index_member = "",
+      int map_flags = 0)
+      : tar_file(tar_file), corrupt_blocks(0), regular_files_only(regular_files_only),
+        traversed(false) {
     // get the file size
     struct stat s;
     if (stat(tar_file.c_str(), &s))
@@ -671,7 +862,35 @@ struct tar {
     }
 
     // map the file
-    mm.map_readonly(tar_file, s.st_size);
+    mm.map_readonly(tar_file, s.st_size, POSIX_MADV_NORMAL, map_flags);
+
+    // if the first member is the index thats all we need
+    if (!index_member.empty()) {
+      const header_t* h = static_cast<const header_t*>(static_cast<const void*>(mm.get()));
+      if (h->verify() && std::string(h->name, strnlen(h->name, sizeof(h->name))) == index_member) {
+        auto size = h->get_file_size();
+        if (sizeof(header_t) + size <= mm.size()) {
+          contents.emplace(std::piecewise_construct, std::forward_as_tuple(index_member),
+                           std::forward_as_tuple(mm.get() + sizeof(header_t), size));
+          return;
+        }
+      }
+    }
+
+    // otherwise we have to look at everything
+    traverse();
+  }
+
+  /**
+   * Records every member of the archive by walking all of its headers. This is a noop if the
+   * archive has already been traversed
+   */
+  void traverse() {
+    if (traversed)
+      return;
+    traversed = true;
+    contents.clear();
+    corrupt_blocks = 0;
 
     // determine opposite of preferred path separator (needed to update OS-specific path separator)
     const char opp_sep = filesystem::path::preferred_separator == '/' ? '\\' : '/';
@@ -710,6 +929,9 @@ struct tar {
   using entry_location_t = std::pair<const char*, size_t>;
   std::unordered_map<entry_name_t, entry_location_t> contents;
   size_t corrupt_blocks;
+  bool regular_files_only;
+  // whether or not contents has every member of the archive or just the index
+  bool traversed;
 };
 
 } // namespace midgard
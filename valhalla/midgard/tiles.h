@@ -343,6 +343,13 @@ public:
    */
   std::vector<int32_t> TileList(const AABB2<coord_t>& boundingbox) const;
 
+  /**
+   * Same as above but fills in the list of the caller so that it can be reused between calls.
+   * @param  boundingbox  Bounding box
+   * @param  tilelist     Cleared and filled with the tiles within or intersecting the bounding box
+   */
+  void TileList(const AABB2<coord_t>& boundingbox, std::vector<int32_t>& tilelist) const;
+
   /**
    * Get the list of tiles that lie within the specified ellipse. The method finds the tile
    * at the ellipse center. It successively finds neighbors and checks if they are inside or
@@ -0,0 +1,84 @@
+#ifndef VALHALLA_MIDGARD_TRACING_H_
+#define VALHALLA_MIDGARD_TRACING_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * Spans of time spent in the hot functions of the workers, kept in a ring buffer per thread so a
+ * running service can be profiled without attaching anything to it. The rings are dumped as the
+ * events of the Chrome trace format which Perfetto and chrome://tracing open.
+ *
+ * Spans are only recorded when built with ENABLE_TRACING, otherwise VALHALLA_TRACE_SPAN expands to
+ * nothing and the functions which do get called cost nothing.
+ */
+namespace tracing {
+
+// How many spans each thread keeps, the oldest are overwritten once the ring is full
+constexpr size_t kRingSize = 65536;
+
+/**
+ * Nanoseconds on the clock the spans are timed with.
+ */
+inline uint64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * Keeps a finished span in the ring of the calling thread.
+ * @param name   what was spanned, a string literal that needs no escaping in json
+ * @param begin  when it began in nanoseconds from now()
+ * @param end    when it ended in nanoseconds from now()
+ */
+void record(const char* name, uint64_t begin, uint64_t end);
+
+/**
+ * Gets the spans of all of the threads which recorded any.
+ * @return a json array of complete events, in microseconds like the Chrome trace format wants
+ */
+std::string dump();
+
+/**
+ * Forgets the spans of all of the threads.
+ */
+void clear();
+
+/**
+ * Spans the time until it goes out of scope.
+ */
+class span_t {
+public:
+  explicit span_t(const char* name) : name_(name), begin_(now()) {
+  }
+  ~span_t() {
+    record(name_, begin_, now());
+  }
+
+  span_t(const span_t&) = delete;
+  span_t& operator=(const span_t&) = delete;
+
+protected:
+  const char* name_;
+  uint64_t begin_;
+};
+
+} // namespace tracing
+} // namespace midgard
+} // namespace valhalla
+
+#ifdef ENABLE_TRACING
+#define VALHALLA_TRACE_CONCAT_(a, b) a##b
+#define VALHALLA_TRACE_CONCAT(a, b) VALHALLA_TRACE_CONCAT_(a, b)
+#define VALHALLA_TRACE_SPAN(name)                                                                  \
+  ::valhalla::midgard::tracing::span_t VALHALLA_TRACE_CONCAT(trace_span_, __LINE__)(name)
+#else
+#define VALHALLA_TRACE_SPAN(name)
+#endif
+
+#endif // VALHALLA_MIDGARD_TRACING_H_
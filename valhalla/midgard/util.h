@@ -621,6 +621,19 @@ struct projector_t {
     return {u.first + bx * scale, u.second + by * scale};
   }
 
+  /**
+   * Finds the closest projection onto the segments of a shape, segment i goes from points[i] to
+   * points[i + 1]. The segments are projected in blocks without branches so that the compiler can
+   * vectorize them, the result is exactly the one of projecting onto the segments one at a time
+   * and keeping the first closest one.
+   * @param points       the points of the shape
+   * @param count        how many points there are
+   * @param point        set to the closest projection
+   * @param sq_distance  set to the squared distance to it, the max double if there are no segments
+   * @return the index of the segment of the closest projection
+   */
+  size_t closest(const PointLL* points, size_t count, PointLL& point, double& sq_distance) const;
+
   // critical data
   double lon_scale;
   double lat;
@@ -673,6 +686,16 @@ inline uint16_t to_big_endian(uint16_t val) {
   return (val << 8) | (val >> 8);
 }
 
+/**
+ * The distance along a hilbert curve over a square grid to a cell of the grid, cells which are
+ * close along the curve are close in the grid too.
+ * @param x     the column of the cell
+ * @param y     the row of the cell
+ * @param side  the number of cells on a side of the grid, a power of two
+ * @return the distance along the curve
+ */
+uint64_t hilbert_index(uint32_t x, uint32_t y, const uint32_t side);
+
 template <class T> inline void hash_combine(std::size_t& seed, const T& v) {
   std::hash<T> hasher;
   seed ^= hasher(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
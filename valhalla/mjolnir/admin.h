@@ -2,14 +2,18 @@
 #define VALHALLA_MJOLNIR_ADMIN_H_
 
 #include <boost/geometry.hpp>
+#include <boost/geometry/geometries/box.hpp>
 #include <boost/geometry/geometries/point_xy.hpp>
 #include <boost/geometry/geometries/polygon.hpp>
 #include <boost/geometry/io/wkt/wkt.hpp>
+#include <boost/geometry/index/rtree.hpp>
 #include <boost/geometry/multi/geometries/multi_polygon.hpp>
 
 #include <cstdint>
 #include <sqlite3.h>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include <valhalla/baldr/graphconstants.h>
 #include <valhalla/midgard/aabb2.h>
 #include <valhalla/midgard/pointll.h>
@@ -25,6 +29,7 @@ namespace mjolnir {
 typedef boost::geometry::model::d2::point_xy<double> point_type;
 typedef boost::geometry::model::polygon<point_type> polygon_type;
 typedef boost::geometry::model::multi_polygon<polygon_type> multi_polygon_type;
+typedef boost::geometry::model::box<point_type> box_type;
 
 /**
  * Get the dbhandle of a sqlite db.  Used for timezones and admins DBs.
@@ -93,6 +98,105 @@ GetAdminInfo(sqlite3* db_handle,
              const AABB2<PointLL>& aabb,
              GraphTileBuilder& tilebuilder);
 
+/**
+ * Every polygon of an admin or time zone db held in memory with an rtree over their bounding boxes.
+ * Once built its only read so all of the graph builder threads can share one without locking or
+ * going back to sqlite for every tile. The polygons are clipped to the tile they are asked for so
+ * that the point in polygon tests for the nodes of the tile only see the part inside of it.
+ */
+class PolygonIndex {
+public:
+  /**
+   * Get the polygons which intersect the bounding box of a tile.
+   * @param  aabb  bb of the tile
+   * @return the indexes of the polygons, in the order they were added, and the polygons clipped
+   *         to a slightly larger box so that nodes on the edge of the tile are still covered
+   */
+  std::vector<std::pair<uint32_t, multi_polygon_type>> Clip(const AABB2<PointLL>& aabb) const;
+
+  /**
+   * @return the number of polygons
+   */
+  size_t size() const {
+    return polygons_.size();
+  }
+
+protected:
+  // Adds a polygon (given as wkt) to the index, returns false if its empty
+  bool Add(const std::string& wkt);
+
+  // Builds the rtree once all polygons are added
+  void Finish();
+
+  std::vector<multi_polygon_type> polygons_;
+  // whether each polygon is valid, invalid ones arent clipped since the overlay cant handle them
+  std::vector<bool> valid_;
+  boost::geometry::index::rtree<std::pair<box_type, uint32_t>, boost::geometry::index::rstar<16>>
+      rtree_;
+};
+
+/**
+ * The admin polygons of the states and countries of an admin db.
+ */
+class AdminIndex : public PolygonIndex {
+public:
+  /**
+   * Reads all of the admins from the db
+   * @param  db_handle  sqlite3 db handle
+   */
+  explicit AdminIndex(sqlite3* db_handle);
+
+  /**
+   * Get the admin polys that intersect with the tile bounding box, the same as the GetAdminInfo
+   * query on the db would.
+   * @param  drive_on_right   unordered map that indicates if a country drives on right side of the
+   * road
+   * @param  allow_intersection_names   unordered map that indicates if we call out intersections
+   * names for this country
+   * @param  aabb             bb of the tile
+   * @param  tilebuilder      Graph tile builder
+   */
+  std::unordered_multimap<uint32_t, multi_polygon_type>
+  GetAdminInfo(std::unordered_map<uint32_t, bool>& drive_on_right,
+               std::unordered_map<uint32_t, bool>& allow_intersection_names,
+               const AABB2<PointLL>& aabb,
+               GraphTileBuilder& tilebuilder) const;
+
+protected:
+  struct admin_t {
+    std::string country_name;
+    std::string state_name;
+    std::string country_iso;
+    std::string state_iso;
+    bool drive_on_right;
+    bool allow_intersection_names;
+  };
+  std::vector<admin_t> admins_;
+};
+
+/**
+ * The time zone polygons of a time zone db.
+ */
+class TimeZoneIndex : public PolygonIndex {
+public:
+  /**
+   * Reads all of the time zones from the db
+   * @param  db_handle  sqlite3 db handle
+   */
+  explicit TimeZoneIndex(sqlite3* db_handle);
+
+  /**
+   * Get the timezone polys that intersect with the tile bounding box, the same as the GetTimeZones
+   * query on the db would.
+   * @param  aabb         bb of the tile
+   */
+  std::unordered_multimap<uint32_t, multi_polygon_type>
+  GetTimeZones(const AABB2<PointLL>& aabb) const;
+
+protected:
+  std::vector<uint32_t> timezones_;
+};
+
 /**
  * Get all the country access records from the db and save them to a map.
  * @param  db_handle    sqlite3 db handle
@@ -0,0 +1,25 @@
+#ifndef VALHALLA_MJOLNIR_COMPONENTBUILDER_H
+#define VALHALLA_MJOLNIR_COMPONENTBUILDER_H
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Class used to compute the connected component of every edge for the auto, truck, bicycle and
+ * pedestrian access modes so that loki can reject locations which no route can connect.
+ */
+class ComponentBuilder {
+public:
+  /**
+   * Computes the components of all edges and writes them to mjolnir.graph_components. Has to run
+   * after every stage that changes the edges or their access.
+   */
+  static void Build(const boost::property_tree::ptree& pt);
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_COMPONENTBUILDER_H
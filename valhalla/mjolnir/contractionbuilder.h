@@ -0,0 +1,23 @@
+#ifndef VALHALLA_MJOLNIR_CONTRACTIONBUILDER_H
+#define VALHALLA_MJOLNIR_CONTRACTIONBUILDER_H
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Class used to build a contraction hierarchy overlay over the tiles for the default auto costing.
+ */
+class ContractionBuilder {
+public:
+  /**
+   * Contracts the graph and writes the overlay to mjolnir.contraction_hierarchy.
+   */
+  static void Build(const boost::property_tree::ptree& pt);
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_CONTRACTIONBUILDER_H
@@ -90,6 +90,19 @@ public:
    */
   void set_encoded_shape(const std::string& encoded_shape);
 
+  /**
+   * Set the elevation of each shape point.
+   * @param  elevation  Elevations in meters, in the order of the shape points.
+   */
+  template <class elevation_container_t>
+  void set_elevation(const elevation_container_t& elevation);
+
+  /**
+   * Set the encoded elevations of the shape points.
+   * @param  encoded_elevation  Encoded elevations, empty if there arent any.
+   */
+  void set_encoded_elevation(const std::string& encoded_elevation);
+
   /**
    * Get the size of this edge info (without padding).
    * @return  Returns the size in bytes of this object.
@@ -117,6 +130,9 @@ protected:
   // Lat,lng shape of the edge
   std::string encoded_shape_;
 
+  // Elevations of the shape points
+  std::string encoded_elevation_;
+
   friend std::ostream& operator<<(std::ostream& os, const EdgeInfoBuilder& id);
 };
 
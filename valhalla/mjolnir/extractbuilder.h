@@ -0,0 +1,28 @@
+#ifndef VALHALLA_MJOLNIR_EXTRACTBUILDER_H
+#define VALHALLA_MJOLNIR_EXTRACTBUILDER_H
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Class used to stream the tiles of the tile directory into a tile extract without a separate
+ * pass of valhalla_build_extract. The extract starts with the same index of the tiles that
+ * valhalla_build_extract writes and the data of every tile begins on a page boundary.
+ */
+class ExtractBuilder {
+public:
+  /**
+   * Writes all the tiles in mjolnir.tile_dir to mjolnir.tile_extract. When
+   * mjolnir.tile_extract_remove_tiles is set every tile file is removed as soon as it has been
+   * copied so that the tiles only ever take up the space of the extract and the tiles left to
+   * copy. Has to run after every stage that changes the tiles.
+   */
+  static void Build(const boost::property_tree::ptree& pt);
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_EXTRACTBUILDER_H
@@ -0,0 +1,43 @@
+#ifndef VALHALLA_MJOLNIR_GRAPHREORDERER_H
+#define VALHALLA_MJOLNIR_GRAPHREORDERER_H
+
+#include <boost/property_tree/ptree.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <valhalla/baldr/graphtile.h>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Class used to renumber the nodes and edges within each tile so that nodes which are close in the
+ * graph are close in memory too. Nodes are built in the order of the OSM data, so the nodes an
+ * expansion reaches one after another are often far apart within a tile and every one of them
+ * costs another cache miss.
+ */
+class GraphReorderer {
+public:
+  /**
+   * Renumber the nodes of all tiles in place in the order mjolnir.node_order names, "hilbert"
+   * along a hilbert curve over the tile or "bfs" breadth first along the edges within the tile.
+   * Does nothing for any other order.
+   * @param pt Configuration file
+   */
+  static void Reorder(const boost::property_tree::ptree& pt);
+
+  /**
+   * Get the order to put the nodes of a tile in.
+   * @param  tile        The tile to order
+   * @param  node_order  "hilbert" or "bfs"
+   * @return the old index of the node to put at each new index
+   */
+  static std::vector<uint32_t> NodeOrder(const baldr::graph_tile_ptr& tile,
+                                         const std::string& node_order);
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_GRAPHREORDERER_H
@@ -7,6 +7,7 @@
 #include <fstream>
 #include <iostream>
 #include <list>
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -60,10 +61,10 @@ public:
 
   /**
    * Output the tile to file. Stores as binary data.
-   * @param  graphid  GraphID to store.
-   * @param  hierarchy  Gives info about number of tiles per level
+   * @param  suffix  Appended to the file name of the tile, lets the tile be written next to the
+   *                 one it will replace while the old one is still being read
    */
-  void StoreTileData();
+  void StoreTileData(const std::string& suffix = "");
 
   /**
    * Update a graph tile with new nodes and directed edges. Assumes no new
@@ -72,8 +73,22 @@ public:
    * information.
    * @param nodes Updated list of nodes
    * @param directededges Updated list of edges.
+   * @param directededges_ext Extended attributes of the edges replacing the ones of the tile, if
+   *                          empty the tile keeps what it has
    */
-  void Update(const std::vector<NodeInfo>& nodes, const std::vector<DirectedEdge>& directededges);
+  void Update(const std::vector<NodeInfo>& nodes,
+              const std::vector<DirectedEdge>& directededges,
+              const std::vector<DirectedEdgeExt>& directededges_ext = {});
+
+  /**
+   * Renumber the nodes of a deserialized tile. The directed edges and transitions of a node move
+   * along with it and keep their order, so local edge indexes and opposing indexes stay valid.
+   * Access restrictions, signs, turn lanes and lane connectivity follow their edges or nodes. The
+   * end nodes of the edges are not changed, the caller has to remap them in every tile.
+   * Tiles with complex restrictions cannot be reordered, they are built after the reordering.
+   * @param  order  The old index of the node to put at each new index.
+   */
+  void ReorderNodes(const std::vector<uint32_t>& order);
 
   /**
    * Get the current list of node builders.
@@ -270,6 +285,15 @@ public:
    */
   void set_mean_elevation(const uint32_t offset, const float elev);
 
+  /**
+   * Set the elevations of the shape points to the EdgeInfo given the edge info offset. This
+   * requires a serialized tile builder. The edge infos after it move when its size changes, the
+   * directed edges are pointed at where they moved to when the tile is stored.
+   * @param offset Edge info offset.
+   * @param elevation Elevation of each shape point in meters, in the order of the shape.
+   */
+  void set_elevation(const uint32_t offset, const std::vector<double>& elevation);
+
   /**
    * Add a name to the text list.
    * @param  name  Name/text to add.
@@ -393,7 +417,8 @@ public:
 
   /**
    * Adds to the bins the tile already has, only modifies the header to reflect the new counts
-   * and the bins themselves, everything else is copied directly without ever looking at it
+   * and the bins themselves, everything else is copied directly without ever looking at it.
+   * Bins which end up with more than kBinCellThreshold edges are split into cells as well
    * @param tile_dir   Base tile directory
    * @param tile       the tile that needs the bins added
    * @param more_bins  the extra bin data to append to the tile
@@ -402,6 +427,20 @@ public:
                       const graph_tile_ptr& tile,
                       const std::array<std::vector<GraphId>, kBinCount>& more_bins);
 
+  /**
+   * Finds the cells of a bin which each of the bin's edges touch
+   * @param tile       the tile of the bin
+   * @param bin_index  the index of the bin within the tile
+   * @param depth      the depth of the bin's quadtree
+   * @param bin        the edges of the bin
+   * @param cells      the cell masks of the edges are appended to it
+   */
+  static void BinCells(const graph_tile_ptr& tile,
+                       size_t bin_index,
+                       uint32_t depth,
+                       const std::vector<GraphId>& bin,
+                       std::vector<uint64_t>& cells);
+
   /**
    * Get the turn lane builder at the specified index.
    * @param  idx  Index of the turn lane builder.
@@ -442,7 +481,8 @@ public:
   /**
    * Updates a tile with predictive speed data. Also updates directed edges with
    * free flow and constrained flow speeds and the predicted traffic flag. The
-   * predicted traffic is written after turn lane data.
+   * predicted traffic is written after turn lane data. The tile is replaced at once so it is
+   * either updated or left as it was.
    * @param  directededges  Updated directed edge information.
    */
   void UpdatePredictedSpeeds(const std::vector<DirectedEdge>& directededges);
@@ -535,6 +575,9 @@ protected:
   std::unordered_map<edge_tuple, size_t, EdgeTupleHasher> edge_offset_map_;
   std::unordered_map<uint32_t, EdgeInfoBuilder*> edgeinfo_offset_map_;
 
+  // How much the deserialized edge infos grew at their offsets since they were read
+  std::map<uint32_t, int64_t> edgeinfo_resizes_;
+
   // The edgeinfo list
   std::list<EdgeInfoBuilder> edgeinfo_list_;
 
@@ -0,0 +1,23 @@
+#ifndef VALHALLA_MJOLNIR_LANDMARKBUILDER_H
+#define VALHALLA_MJOLNIR_LANDMARKBUILDER_H
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Class used to pick landmarks in the tiles and compute the distances of every node to them.
+ */
+class LandmarkBuilder {
+public:
+  /**
+   * Picks mjolnir.landmark_count landmarks and writes their distances to mjolnir.landmarks.
+   */
+  static void Build(const boost::property_tree::ptree& pt);
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_LANDMARKBUILDER_H
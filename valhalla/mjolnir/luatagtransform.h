@@ -11,6 +11,7 @@ extern "C" {
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace valhalla {
 namespace mjolnir {
@@ -18,21 +19,40 @@ namespace mjolnir {
 using Tags = std::unordered_map<std::string, std::string>;
 
 /**
+ * Runs the tags of the osm elements through the functions of a lua script. Elements with the same
+ * tags get the same tags back so the results are kept in a bounded cache, keyed on the type and
+ * the sorted tags of an element, and most elements dont call into lua at all
  */
 class LuaTagTransform {
 public:
   /**
    * Constructor
-   * @param lua   the string containing the lua code
+   * @param lua           the string containing the lua code
+   * @param cache_size    the most tag sets to keep the results of, 0 for none
+   * @param passthrough   keys of tags whose values the script only copies through or checks for
+   *                      at all, a key ending in ':' stands for every key it starts. Only whether
+   *                      elements have these tags goes into the cache key so elements which only
+   *                      differ in their names still share their results
    */
-  LuaTagTransform(const std::string& lua);
+  LuaTagTransform(const std::string& lua,
+                  size_t cache_size = 0,
+                  const std::vector<std::string>& passthrough = {});
 
   ~LuaTagTransform();
 
   Tags Transform(OSMType type, uint64_t osmid, const Tags& tags);
 
 protected:
+  // calls the function of the script for the type of element
+  Tags Call(OSMType type, uint64_t osmid, const Tags& tags);
+
+  // whether the value of the tag with the key is only copied through by the script
+  bool IsPassthrough(const std::string& key) const;
+
   lua_State* state_;
+  size_t cache_size_;
+  std::vector<std::string> passthrough_;
+  std::unordered_map<std::string, Tags> cache_;
 };
 
 } // namespace mjolnir
@@ -0,0 +1,53 @@
+#ifndef VALHALLA_MJOLNIR_OSMCHANGE_H
+#define VALHALLA_MJOLNIR_OSMCHANGE_H
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/midgard/pointll.h>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * The parts of an osmChange (osc) file which matter to the graph, that is which nodes and ways were
+ * created, modified or deleted. Its used to find the tiles a diff touches so that only those have
+ * to be looked at, published or compared after the tiles are rebuilt.
+ */
+struct OSMChange {
+  // where the created and modified nodes are now
+  std::unordered_map<uint64_t, midgard::PointLL> nodes;
+  // every node that was created, modified or deleted and every node of a changed way
+  std::unordered_set<uint64_t> node_ids;
+  // every way that was created, modified or deleted and every way member of a changed relation
+  std::unordered_set<uint64_t> way_ids;
+
+  /**
+   * Reads the nodes, ways and relations of an uncompressed osc file.
+   * @param osc_file  the path to the file
+   * @return the changes
+   */
+  static OSMChange Read(const std::string& osc_file);
+
+  /**
+   * Finds the tiles which the changes touch. Those are the tiles of the local level with nodes of
+   * changed ways or changed nodes, where they were before and where they are now, and the tiles of
+   * the levels above which cover them since the hierarchy and the shortcuts are built from them.
+   * The places the nodes were at come from the intermediate files of the previous build, which
+   * are only there if it stopped before the cleanup stage.
+   * @param ways_file       the ways.bin of the previous build
+   * @param way_nodes_file  the way_nodes.bin of the previous build, sorted by way
+   * @return the tiles of every level the changes touch
+   */
+  std::set<baldr::GraphId> AffectedTiles(const std::string& ways_file,
+                                         const std::string& way_nodes_file) const;
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_OSMCHANGE_H
@@ -5,6 +5,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -12,6 +13,7 @@
 #include <valhalla/mjolnir/osmnode.h>
 #include <valhalla/mjolnir/osmrestriction.h>
 #include <valhalla/mjolnir/osmway.h>
+#include <valhalla/mjolnir/sortedmultimap.h>
 #include <valhalla/mjolnir/uniquenames.h>
 
 namespace valhalla {
@@ -42,12 +44,13 @@ struct OSMLaneConnectivity {
   uint32_t from_lanes_index; // Index to string in UniqueNames
 };
 
-// Data types used within OSMData
-using RestrictionsMultiMap = std::unordered_multimap<uint64_t, OSMRestriction>;
+// Data types used within OSMData. The multimaps are filled while parsing and have to be sorted
+// (see OSMData::sort) before they are searched
+using RestrictionsMultiMap = SortedMultiMap<uint64_t, OSMRestriction>;
 using ViaSet = std::unordered_set<uint64_t>;
-using AccessRestrictionsMultiMap = std::unordered_multimap<uint64_t, OSMAccessRestriction>;
-using BikeMultiMap = std::unordered_multimap<uint64_t, OSMBike>;
-using OSMLaneConnectivityMultiMap = std::unordered_multimap<uint64_t, OSMLaneConnectivity>;
+using AccessRestrictionsMultiMap = SortedMultiMap<uint64_t, OSMAccessRestriction>;
+using BikeMultiMap = SortedMultiMap<uint64_t, OSMBike>;
+using OSMLaneConnectivityMultiMap = SortedMultiMap<uint64_t, OSMLaneConnectivity>;
 
 // OSMString map uses the way Id as the key and the name index into UniqueNames as the value
 using OSMStringMap = std::unordered_map<uint64_t, uint32_t>;
@@ -75,6 +78,12 @@ struct OSMData {
    */
   bool read_from_unique_names_file(const std::string& tile_dir);
 
+  /**
+   * Sort the multimaps so they can be searched. Done at the end of parsing and after reading them
+   * from the temporary files.
+   */
+  void sort();
+
   /**
    * add the direction information to the forward or reverse map for relations.
    */
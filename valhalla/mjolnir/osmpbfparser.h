@@ -81,8 +81,12 @@ struct Callback {
 class Parser {
 public:
   Parser() = delete;
-  // parse the pbf file for the things you are interested in
-  static void parse(std::ifstream& file, const Interest interest, Callback& callback);
+  // parse the pbf file for the things you are interested in, with more than one thread the blobs
+  // are decompressed and decoded in parallel but the callbacks still happen in the order of the file
+  static void parse(std::ifstream& file,
+                    const Interest interest,
+                    Callback& callback,
+                    const unsigned int threads = 1);
   // clean up protobuf library level memory, this will make protobuf unusable after its called
   static void free();
 };
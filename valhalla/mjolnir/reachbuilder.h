@@ -0,0 +1,25 @@
+#ifndef VALHALLA_MJOLNIR_REACHBUILDER_H
+#define VALHALLA_MJOLNIR_REACHBUILDER_H
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Class used to compute the reach of every edge for the default auto, truck, bicycle and
+ * pedestrian costings so that loki can look it up instead of expanding from each candidate edge.
+ */
+class ReachBuilder {
+public:
+  /**
+   * Computes the reach of all edges up to mjolnir.edge_reach_cap and writes it to
+   * mjolnir.edge_reach. Has to run after the validator as it needs the opposing edges.
+   */
+  static void Build(const boost::property_tree::ptree& pt);
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_REACHBUILDER_H
@@ -0,0 +1,25 @@
+#ifndef VALHALLA_MJOLNIR_SEGMENTINDEXBUILDER_H
+#define VALHALLA_MJOLNIR_SEGMENTINDEXBUILDER_H
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Class used to build a packed hilbert r-tree over the shapes of the edges of every bin so that
+ * loki can skip the edges which are too far from a location without decoding their shapes.
+ */
+class SegmentIndexBuilder {
+public:
+  /**
+   * Indexes the shapes of the edges of all bins and writes the index to mjolnir.segment_index.
+   * Has to run after every stage that changes the tiles.
+   */
+  static void Build(const boost::property_tree::ptree& pt);
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_SEGMENTINDEXBUILDER_H
@@ -0,0 +1,98 @@
+#ifndef VALHALLA_MJOLNIR_SORTEDMULTIMAP_H
+#define VALHALLA_MJOLNIR_SORTEDMULTIMAP_H
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * A multimap kept as one flat vector of key value pairs. Values are appended while parsing and the
+ * whole thing is sorted by key once afterwards so that lookups are binary searches. Compared to an
+ * unordered_multimap this saves the node allocation, the next pointer and the bucket array of every
+ * entry, which adds up to more than the entries themselves for the small values stored in OSMData.
+ * Entries with the same key keep the order they were inserted in.
+ */
+template <class key_t, class value_t> class SortedMultiMap {
+public:
+  using value_type = std::pair<key_t, value_t>;
+  using container_t = std::vector<value_type>;
+  using iterator = typename container_t::iterator;
+  using const_iterator = typename container_t::const_iterator;
+
+  /**
+   * Adds an entry. The map has to be sorted again before it can be searched.
+   * @param  entry  the key and the value
+   */
+  void insert(const value_type& entry) {
+    sorted_ = sorted_ && (entries_.empty() || !(entry.first < entries_.back().first));
+    entries_.push_back(entry);
+  }
+
+  /**
+   * Sorts the entries by key so they can be searched, does nothing if they already are. Since the
+   * map is searched by many threads at once this has to happen before the search starts.
+   */
+  void sort() {
+    if (!sorted_) {
+      std::stable_sort(entries_.begin(), entries_.end(),
+                       [](const value_type& a, const value_type& b) { return a.first < b.first; });
+      sorted_ = true;
+    }
+    entries_.shrink_to_fit();
+  }
+
+  /**
+   * Finds the entries with the given key.
+   * @param  key  the key to look for
+   * @return the range of entries with the key, both are end() if there are none
+   */
+  std::pair<const_iterator, const_iterator> equal_range(const key_t& key) const {
+    if (!sorted_) {
+      throw std::logic_error("SortedMultiMap must be sorted before it is searched");
+    }
+    auto lower = std::lower_bound(entries_.cbegin(), entries_.cend(), key,
+                                  [](const value_type& a, const key_t& k) { return a.first < k; });
+    if (lower == entries_.cend() || key < lower->first) {
+      return std::make_pair(entries_.cend(), entries_.cend());
+    }
+    auto upper = std::upper_bound(lower, entries_.cend(), key,
+                                  [](const key_t& k, const value_type& a) { return k < a.first; });
+    return std::make_pair(lower, upper);
+  }
+
+  const_iterator begin() const {
+    return entries_.cbegin();
+  }
+  const_iterator end() const {
+    return entries_.cend();
+  }
+  const_iterator cbegin() const {
+    return entries_.cbegin();
+  }
+  const_iterator cend() const {
+    return entries_.cend();
+  }
+  size_t size() const {
+    return entries_.size();
+  }
+  bool empty() const {
+    return entries_.empty();
+  }
+  void clear() {
+    entries_.clear();
+    sorted_ = true;
+  }
+
+protected:
+  container_t entries_;
+  bool sorted_ = true;
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_SORTEDMULTIMAP_H
@@ -0,0 +1,76 @@
+#ifndef VALHALLA_MJOLNIR_TRAFFICUPDATER_H
+#define VALHALLA_MJOLNIR_TRAFFICUPDATER_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <valhalla/baldr/traffictile.h>
+#include <valhalla/midgard/sequence.h>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * One entry of a live traffic feed. A feed file is just these records back to back in the byte
+ * order of the machine, 16 bytes each, so it can be produced by anything that can pack a graph id
+ * and the speeds, breakpoints and congestion of a baldr::TrafficSpeed into two 64 bit integers.
+ */
+struct TrafficRecord {
+  uint64_t edge_id;          // the graph id of the directed edge
+  baldr::TrafficSpeed speed; // its new live speed
+};
+static_assert(sizeof(TrafficRecord) == 16, "TrafficRecord type size different than expected");
+
+/**
+ * Writes live speeds into the traffic extract in place while it is mapped by the readers of the
+ * tiles. Every speed is a single 64 bit store so a reader never sees half of one. To let readers
+ * know which tiles changed, the generation of a tile header is made odd before any of its speeds
+ * are written and even again, along with its last update, once they all are. Readers never block
+ * and the updater never waits on them.
+ */
+class TrafficUpdater {
+public:
+  /**
+   * Maps the traffic extract for writing and finds the traffic tiles in it.
+   * @param traffic_extract  the path to the traffic tar
+   */
+  explicit TrafficUpdater(const std::string& traffic_extract);
+
+  /**
+   * Reads a feed file.
+   * @param feed_file  the path to the file
+   * @return its records in the order they were in the file
+   */
+  static std::vector<TrafficRecord> ReadFeed(const std::string& feed_file);
+
+  /**
+   * Writes the records into their tiles. Records of tiles or edges that are not in the extract are
+   * skipped and if an edge is in the records more than once the last one wins.
+   * @param records    the records to apply, they are sorted by edge in place
+   * @param timestamp  the seconds since epoch to set as the last update of the changed tiles
+   * @return the number of records written
+   */
+  size_t Update(std::vector<TrafficRecord>& records, uint64_t timestamp);
+
+  /**
+   * The number of traffic tiles in the extract.
+   */
+  size_t tile_count() const {
+    return tiles_.size();
+  }
+
+protected:
+  // the traffic tile header of a tile or nullptr if the extract doesnt have the tile
+  volatile baldr::TrafficTileHeader* find(uint64_t tile_id) const;
+
+  midgard::mem_map<char> mm_;
+  // the traffic tile headers sorted by tile id
+  std::vector<std::pair<uint64_t, volatile baldr::TrafficTileHeader*>> tiles_;
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_TRAFFICUPDATER_H
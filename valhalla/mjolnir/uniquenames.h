@@ -4,16 +4,15 @@
 #include <algorithm>
 #include <cstdint>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 namespace valhalla {
 namespace mjolnir {
 
-using NamesMap = std::unordered_map<std::string, uint32_t>;
-
 /**
- * Class to hold a list of unique names and indexes to them.
+ * Class to hold a list of unique names and indexes to them. The names are stored back to back in
+ * one arena and found again through an open addressing hash table of indexes so that a name costs
+ * its characters plus 12-16 bytes instead of a string, a hash node and an iterator.
  */
 class UniqueNames {
 public:
@@ -32,18 +31,23 @@ public:
    * @return  Returns an index into the unique list of names.
    */
   uint32_t index(const std::string& name) {
-    // Find the name in the map. If it is there return the index.
-    auto it = names_.find(name);
-    if (it != names_.end()) {
-      return it->second;
-    } else {
-      // Not in the map, add index and update
-      it = names_.insert(it, NamesMap::value_type(name, 0));
-      indexes_.push_back(it);
-      uint32_t index = indexes_.size() - 1;
-      it->second = index;
-      return index;
+    // Keep the table at most half full so the probe sequences stay short
+    if ((count() + 1) * 2 > slots_.size()) {
+      rehash(std::max<size_t>(slots_.size() * 2, 1024));
+    }
+
+    // Find the name in the table. If it is there return the index.
+    size_t slot = find(name);
+    if (slots_[slot] != 0) {
+      return slots_[slot] - 1;
     }
+
+    // Not in the table, add it to the arena and update
+    uint32_t index = count();
+    arena_.append(name);
+    offsets_.push_back(arena_.size());
+    slots_[slot] = index + 1;
+    return index;
   }
 
   /**
@@ -51,16 +55,20 @@ public:
    * @param  index  Index into the unique name list.
    * @return  Returns the name
    */
-  const std::string& name(const uint32_t index) const {
-    return (index < (uint32_t)indexes_.size()) ? indexes_[index]->first : indexes_[0]->first;
+  std::string name(const uint32_t index) const {
+    if (index >= count()) {
+      return {};
+    }
+    return arena_.substr(offsets_[index], offsets_[index + 1] - offsets_[index]);
   }
 
   /**
    * Clear the names and indexes.
    */
   void Clear() {
-    names_.clear();
-    indexes_.clear();
+    std::string().swap(arena_);
+    std::vector<uint64_t>{0}.swap(offsets_);
+    std::vector<uint32_t>().swap(slots_);
   }
 
   /**
@@ -69,16 +77,61 @@ public:
    * @return  Returns the number of unique names.
    */
   size_t Size() const {
-    return names_.size() - 1;
+    return count() - 1;
   }
 
 protected:
-  // Map of names to indexes
-  NamesMap names_;
+  // Number of names in the arena
+  size_t count() const {
+    return offsets_.size() - 1;
+  }
+
+  // FNV-1a
+  static size_t hash(const char* str, size_t len) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < len; ++i) {
+      h = (h ^ static_cast<unsigned char>(str[i])) * 1099511628211ull;
+    }
+    return static_cast<size_t>(h);
+  }
+
+  // The slot the name is in or the empty slot where it would go
+  size_t find(const std::string& name) const {
+    size_t mask = slots_.size() - 1;
+    for (size_t slot = hash(name.data(), name.size()) & mask;; slot = (slot + 1) & mask) {
+      auto index = slots_[slot];
+      if (index == 0) {
+        return slot;
+      }
+      --index;
+      auto length = offsets_[index + 1] - offsets_[index];
+      if (length == name.size() && arena_.compare(offsets_[index], length, name) == 0) {
+        return slot;
+      }
+    }
+  }
+
+  // Rebuild the table with the given (power of 2) number of slots
+  void rehash(size_t size) {
+    std::vector<uint32_t>(size, 0).swap(slots_);
+    size_t mask = size - 1;
+    for (uint32_t index = 0; index < count(); ++index) {
+      auto slot = hash(arena_.data() + offsets_[index], offsets_[index + 1] - offsets_[index]) & mask;
+      while (slots_[slot] != 0) {
+        slot = (slot + 1) & mask;
+      }
+      slots_[slot] = index + 1;
+    }
+  }
+
+  // All of the names back to back
+  std::string arena_;
+
+  // Where each name starts in the arena, the last one is where the next name will start
+  std::vector<uint64_t> offsets_{0};
 
-  // List of entries into the map
-  using nameiter = NamesMap::iterator;
-  std::vector<nameiter> indexes_;
+  // Open addressing table of index + 1 of the names, 0 for empty slots
+  std::vector<uint32_t> slots_;
 };
 
 } // namespace mjolnir
@@ -2,9 +2,11 @@
 #define VALHALLA_MJOLNIR_UTIL_H_
 
 #include <boost/property_tree/ptree.hpp>
+#include <deque>
 #include <list>
 #include <map>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -14,6 +16,7 @@
 #include <valhalla/baldr/rapidjson_utils.h>
 #include <valhalla/midgard/logging.h>
 #include <valhalla/midgard/pointll.h>
+#include <valhalla/midgard/sequence.h>
 
 namespace valhalla {
 namespace mjolnir {
@@ -35,10 +38,17 @@ enum class BuildStage : int8_t {
   kBss = 9,
   kHierarchy = 10,
   kShortcuts = 11,
-  kRestrictions = 12,
-  kElevation = 13,
-  kValidate = 14,
-  kCleanup = 15
+  kReorder = 12,
+  kContraction = 13,
+  kLandmarks = 14,
+  kRestrictions = 15,
+  kElevation = 16,
+  kValidate = 17,
+  kReach = 18,
+  kSegmentIndex = 19,
+  kComponents = 20,
+  kExtract = 21,
+  kCleanup = 22
 };
 
 // Convert string to BuildStage
@@ -56,9 +66,16 @@ inline BuildStage string_to_buildstage(const std::string& s) {
        {"bss", BuildStage::kBss},
        {"hierarchy", BuildStage::kHierarchy},
        {"shortcuts", BuildStage::kShortcuts},
+       {"reorder", BuildStage::kReorder},
+       {"contraction", BuildStage::kContraction},
+       {"landmarks", BuildStage::kLandmarks},
        {"restrictions", BuildStage::kRestrictions},
        {"elevation", BuildStage::kElevation},
        {"validate", BuildStage::kValidate},
+       {"reach", BuildStage::kReach},
+       {"segmentindex", BuildStage::kSegmentIndex},
+       {"components", BuildStage::kComponents},
+       {"extract", BuildStage::kExtract},
        {"cleanup", BuildStage::kCleanup}};
 
   auto i = stringToBuildStage.find(s);
@@ -80,9 +97,16 @@ inline std::string to_string(BuildStage stg) {
        {static_cast<int8_t>(BuildStage::kBss), "bss"},
        {static_cast<int8_t>(BuildStage::kHierarchy), "hierarchy"},
        {static_cast<int8_t>(BuildStage::kShortcuts), "shortcuts"},
+       {static_cast<int8_t>(BuildStage::kReorder), "reorder"},
+       {static_cast<int8_t>(BuildStage::kContraction), "contraction"},
+       {static_cast<int8_t>(BuildStage::kLandmarks), "landmarks"},
        {static_cast<int8_t>(BuildStage::kRestrictions), "restrictions"},
        {static_cast<int8_t>(BuildStage::kElevation), "elevation"},
        {static_cast<int8_t>(BuildStage::kValidate), "validate"},
+       {static_cast<int8_t>(BuildStage::kReach), "reach"},
+       {static_cast<int8_t>(BuildStage::kSegmentIndex), "segmentindex"},
+       {static_cast<int8_t>(BuildStage::kComponents), "components"},
+       {static_cast<int8_t>(BuildStage::kExtract), "extract"},
        {static_cast<int8_t>(BuildStage::kCleanup), "cleanup"}};
 
   auto i = BuildStageStrings.find(static_cast<int8_t>(stg));
@@ -128,6 +152,45 @@ uint32_t compute_curvature(const std::list<midgard::PointLL>& shape);
  */
 bool load_spatialite(sqlite3* db_handle);
 
+/**
+ * Orders tiles so that the biggest ones, by the size of their files, come first. Threads pulling
+ * the tiles off of a shared queue then finish at about the same time instead of one of them
+ * drawing a dense tile at the very end. Tiles of the same size keep their order.
+ * @param tile_dir  the directory the tiles are in
+ * @param tiles     the tiles to order
+ */
+void sort_by_tile_size(const std::string& tile_dir, std::deque<baldr::GraphId>& tiles);
+
+/**
+ * Sorts one of the intermediate files of the tile build. Runs of the file as big as the sort_memory
+ * bytes of the config are sorted in memory by concurrency threads and then merged.
+ * @param config     the mjolnir config
+ * @param items      the file to sort
+ * @param predicate  the order to sort it in
+ */
+template <typename T, typename predicate_t>
+void sort_sequence(const ptree& config, midgard::sequence<T>& items, const predicate_t& predicate) {
+  const auto bytes = config.get<size_t>("sort_memory", 1024 * 1024 * 512);
+  const auto threads = config.get<unsigned int>("concurrency", std::thread::hardware_concurrency());
+  items.sort(predicate, std::max(bytes / sizeof(T), static_cast<size_t>(1)),
+             std::max(threads, 1u));
+}
+
+/**
+ * Adds the cpu time the thread spent while this was alive to the busy times of the build stage that
+ * is running, which build_tile_set writes to its profile of the build. The worker threads of the
+ * build stages make one of these first thing so that how evenly their work was spread shows up.
+ */
+struct thread_busy_time_t {
+  thread_busy_time_t();
+  ~thread_busy_time_t();
+  thread_busy_time_t(const thread_busy_time_t&) = delete;
+  thread_busy_time_t& operator=(const thread_busy_time_t&) = delete;
+
+private:
+  double start_;
+};
+
 /**
  * Build an entire valhalla tileset give a config file and some input pbfs. The
  * tile building process is split into stages. This method allows either the entire
@@ -138,6 +201,8 @@ bool load_spatialite(sqlite3* db_handle);
  * @param end_stage     End stage of the pipeline to run
  * @param release_osmpbf_memory Free PBF parsing libs after use.  Saves RAM, but makes libprotobuf
  * unusable afterwards.  Set to false if you need to perform protobuf operations after building tiles.
+ * The wall time, cpu time, peak memory, bytes read and written and thread busy times of each stage
+ * are written as json to mjolnir.build_profile, by default build_profile.json in the tile_dir.
  * @return Returns true if no errors occur, false if an error occurs.
  */
 bool build_tile_set(const ptree& config,
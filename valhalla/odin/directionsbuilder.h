@@ -3,6 +3,7 @@
 
 #include <list>
 
+#include <valhalla/odin/directionsworkers.h>
 #include <valhalla/odin/enhancedtrippath.h>
 #include <valhalla/odin/maneuver.h>
 #include <valhalla/proto/api.pb.h>
@@ -25,10 +26,21 @@ public:
    *
    * @param api   the protobuf object containing the request, the path and a place
    *              to store the resulting directions
+   * @param workers optional threads to build the directions of the legs on when there are
+   *                several, the directions are the same and in the same order either way
    */
-  static void Build(Api& api);
+  static void Build(Api& api, DirectionsWorkers* workers = nullptr);
 
 protected:
+  /**
+   * Builds the maneuvers, the narrative and the directions of one leg of a route.
+   * @param options          The directions options
+   * @param trip_path        The leg to build the directions of
+   * @param trip_directions  Where to put the directions of the leg
+   */
+  static void
+  BuildLeg(const Options& options, TripLeg& trip_path, DirectionsLeg& trip_directions);
+
   /**
    * Update the heading of ~0 length edges.
    *
@@ -0,0 +1,71 @@
+#ifndef VALHALLA_ODIN_DIRECTIONSWORKERS_H_
+#define VALHALLA_ODIN_DIRECTIONSWORKERS_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace valhalla {
+namespace odin {
+
+/**
+ * Threads which, along with the calling thread, take the legs of a response one at a time to
+ * build their directions. The legs dont depend on each other and every leg writes to its own
+ * directions so the results are the same, and in the same order, as when they are built one after
+ * the other. A worker only narrates one request at a time so it keeps one set of these threads.
+ */
+class DirectionsWorkers {
+public:
+  // Builds the directions of the leg with the given index
+  using step_t = std::function<void(uint32_t)>;
+
+  /**
+   * Starts the threads.
+   * @param  thread_count   Number of threads besides the calling one.
+   */
+  explicit DirectionsWorkers(const uint32_t thread_count);
+  ~DirectionsWorkers();
+
+  /**
+   * Runs the step for every leg and returns when all of them are done. The first exception thrown
+   * by the step is rethrown here.
+   * @param  count  Number of legs.
+   * @param  step   The step to run.
+   */
+  void Run(const uint32_t count, const step_t& step);
+
+  /**
+   * Number of thread slots, including the one of the calling thread.
+   */
+  uint32_t size() const {
+    return threads_.size() + 1;
+  }
+
+protected:
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  bool stop_ = false;
+
+  // the step being run, the next leg to take and the threads still working on it
+  const step_t* step_ = nullptr;
+  uint32_t count_ = 0;
+  uint64_t generation_ = 0;
+  std::atomic<uint32_t> next_{0};
+  uint32_t busy_ = 0;
+  std::exception_ptr error_;
+
+  void Take();
+  void Work();
+};
+
+} // namespace odin
+} // namespace valhalla
+
+#endif // VALHALLA_ODIN_DIRECTIONSWORKERS_H_
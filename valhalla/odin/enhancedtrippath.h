@@ -89,13 +89,16 @@ public:
     return trip_path_.bbox();
   }
 
-  std::unique_ptr<EnhancedTripLeg_Node> GetEnhancedNode(const int node_index);
+  // The nodes and edges are owned by the leg and made at most once per index no matter how often
+  // they are asked for, the returned pointers are valid for as long as the leg is
 
-  std::unique_ptr<EnhancedTripLeg_Edge> GetPrevEdge(const int node_index, int delta = 1);
+  EnhancedTripLeg_Node* GetEnhancedNode(const int node_index);
 
-  std::unique_ptr<EnhancedTripLeg_Edge> GetCurrEdge(const int node_index) const;
+  EnhancedTripLeg_Edge* GetPrevEdge(const int node_index, int delta = 1);
 
-  std::unique_ptr<EnhancedTripLeg_Edge> GetNextEdge(const int node_index, int delta = 1) const;
+  EnhancedTripLeg_Edge* GetCurrEdge(const int node_index) const;
+
+  EnhancedTripLeg_Edge* GetNextEdge(const int node_index, int delta = 1) const;
 
   bool IsValidNodeIndex(int node_index) const;
 
@@ -118,7 +121,12 @@ public:
   float GetLength(const Options::Units& units);
 
 protected:
+  EnhancedTripLeg_Edge* GetEdge(int node_index) const;
+
   TripLeg& trip_path_;
+  // Indexed by node, filled in on first use
+  mutable std::vector<std::unique_ptr<EnhancedTripLeg_Node>> nodes_;
+  mutable std::vector<std::unique_ptr<EnhancedTripLeg_Edge>> edges_;
 };
 
 class EnhancedTripLeg_Edge {
@@ -232,7 +232,7 @@ protected:
    *
    * @param maneuver The maneuver at the intersection.
    */
-  uint16_t GetExpectedTurnLaneDirection(std::unique_ptr<EnhancedTripLeg_Edge>& turn_lane_edge,
+  uint16_t GetExpectedTurnLaneDirection(EnhancedTripLeg_Edge* turn_lane_edge,
                                         const Maneuver& maneuver) const;
 
   /**
@@ -319,8 +319,19 @@ protected:
    */
   void CollapseMergeManeuvers(std::list<Maneuver>& maneuvers);
 
+  /**
+   * Returns the street names of the edge, the same names share one string across the leg so they
+   * are compared by pointer while the maneuvers are built.
+   *
+   * @param node_index The index of the node the edge begins at, for its country.
+   * @param edge The edge to get the street names of.
+   */
+  std::unique_ptr<StreetNames> GetStreetNames(uint32_t node_index,
+                                              const EnhancedTripLeg_Edge& edge) const;
+
   const Options& options_;
   EnhancedTripLeg* trip_path_;
+  mutable StreetNameInterner interned_street_names_;
 };
 
 } // namespace odin
@@ -1,6 +1,8 @@
 #ifndef VALHALLA_ODIN_NARRATIVE_DICTIONARY_H_
 #define VALHALLA_ODIN_NARRATIVE_DICTIONARY_H_
 
+#include <cstdint>
+#include <initializer_list>
 #include <locale>
 #include <string>
 #include <unordered_map>
@@ -157,8 +159,59 @@ constexpr auto kTransitPlatformCountLabelTag = "<TRANSIT_STOP_COUNT_LABEL>";
 namespace valhalla {
 namespace odin {
 
+/**
+ * A phrase split up at its tags when the dictionary is loaded so that forming an instruction is a
+ * single pass over the phrase rather than a search and replace over the whole string per tag.
+ */
+class NarrativeTemplate {
+public:
+  struct TagValue {
+    const char* tag;
+    const std::string& value;
+  };
+
+  NarrativeTemplate() = default;
+  explicit NarrativeTemplate(const std::string& phrase);
+
+  /**
+   * Returns the phrase with its tags replaced by the given values. Tags that are not given a
+   * value are left as they are, values are never searched for tags themselves.
+   *
+   * @param  values  the tags and their values
+   * @return the formatted phrase
+   */
+  std::string Format(std::initializer_list<TagValue> values) const;
+
+  /**
+   * Returns true if this template was made from a phrase.
+   */
+  bool defined() const {
+    return defined_;
+  }
+
+protected:
+  // A run of text or a tag within the phrase
+  struct piece_t {
+    uint32_t offset;
+    uint32_t size;
+    bool is_tag;
+  };
+
+  std::string phrase_;
+  std::vector<piece_t> pieces_;
+  bool defined_ = false;
+};
+
 struct PhraseSet {
   std::unordered_map<std::string, std::string> phrases;
+  // The phrases compiled into templates indexed by their numeric key
+  std::vector<NarrativeTemplate> templates;
+
+  /**
+   * Returns the template of the phrase with the given key.
+   * Throws std::out_of_range if there is no such phrase.
+   */
+  const NarrativeTemplate& phrase(size_t id) const;
 };
 
 struct StartSubset : PhraseSet {
@@ -30,7 +30,14 @@ public:
   NarrativeBuilder(const NarrativeBuilder&) = default;
   NarrativeBuilder& operator=(const NarrativeBuilder&) = default;
 
-  void Build(std::list<Maneuver>& maneuvers);
+  /**
+   * Forms the instructions of the maneuvers.
+   *
+   * @param maneuvers The maneuvers to form the instructions of.
+   * @param verbal    Whether to form the verbal instructions as well, which is most of the work
+   *                  and not worth it when they will not be serialized.
+   */
+  void Build(std::list<Maneuver>& maneuvers, bool verbal = true);
 
   // A few of the form instruction methods need to be public to enable updates based on length
 
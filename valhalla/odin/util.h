@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <locale>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -53,9 +54,29 @@ std::string get_localized_time(const std::string& date_time, const std::locale&
  */
 std::string get_localized_date(const std::string& date_time, const std::locale& locale);
 
-using locales_singleton_t = std::unordered_map<std::string, std::shared_ptr<NarrativeDictionary>>;
 /**
- * Returns locale strings mapped to NarrativeDictionaries containing parsed narrative information
+ * A NarrativeDictionary that is only parsed out of its embedded json the first time it is used.
+ * Copies share the dictionary, so a locale and all of its aliases load it at most once.
+ */
+class lazy_narrative_dictionary_t {
+public:
+  lazy_narrative_dictionary_t(const std::string& language_tag, const char* json, size_t size);
+
+  const std::string& language_tag() const;
+  const NarrativeDictionary& operator*() const;
+  const NarrativeDictionary* operator->() const {
+    return &**this;
+  }
+
+protected:
+  struct dictionary_t;
+  std::shared_ptr<dictionary_t> dictionary_;
+};
+
+using locales_singleton_t = std::unordered_map<std::string, lazy_narrative_dictionary_t>;
+/**
+ * Returns locale strings mapped to NarrativeDictionaries containing parsed narrative information.
+ * The map itself is cheap, each dictionary is only parsed the first time its language is used
  *
  * @return the map of locales to NarrativeDictionaries
  */
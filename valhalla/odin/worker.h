@@ -1,6 +1,9 @@
 #ifndef __VALHALLA_ODIN_SERVICE_H__
 #define __VALHALLA_ODIN_SERVICE_H__
 
+#include <memory>
+
+#include <valhalla/odin/directionsworkers.h>
 #include <valhalla/proto/api.pb.h>
 #include <valhalla/worker.h>
 
@@ -24,6 +27,10 @@ public:
 
   void narrate(Api& request) const;
   void status(Api& request) const;
+
+protected:
+  // The threads the legs of a response are narrated on when there is more than one
+  std::unique_ptr<DirectionsWorkers> directions_workers;
 };
 } // namespace odin
 } // namespace valhalla
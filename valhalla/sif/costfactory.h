@@ -4,6 +4,9 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
 
 #include <valhalla/baldr/rapidjson_utils.h>
 #include <valhalla/proto/options.pb.h>
@@ -57,6 +60,7 @@ public:
   void Register(const Costing costing, factory_function_t function) {
     factory_funcs_.erase(costing);
     factory_funcs_.emplace(costing, function);
+    prototypes_.clear();
   }
 
   /**
@@ -103,8 +107,39 @@ public:
       auto costing_str = Costing_Enum_Name(options.costing());
       throw std::runtime_error("No costing method found for '" + costing_str + "'");
     }
-    // create the cost using the function pointer
-    return itr->second(options);
+    if (cache_size_ == 0) {
+      // create the cost using the function pointer
+      return itr->second(options);
+    }
+
+    // the same options make the same costing so we copy the one we made the first time, the copy
+    // starts over with whatever a previous request changed (pass, hierarchy limits etc)
+    auto key = options.SerializeAsString();
+    auto cached = prototypes_.find(key);
+    if (cached != prototypes_.end()) {
+      return cached->second->Clone();
+    }
+    auto prototype = itr->second(options);
+    auto cost = prototype->Clone();
+    // a costing which cannot be copied, or would be copied as its base class, isnt kept
+    if (!cost || typeid(*cost) != typeid(*prototype)) {
+      return prototype;
+    }
+    if (prototypes_.size() >= cache_size_) {
+      prototypes_.clear();
+    }
+    prototypes_.emplace(std::move(key), std::move(prototype));
+    return cost;
+  }
+
+  /**
+   * Keep the costings made for up to this many distinct costing options so that requests with the
+   * same options get a copy rather than parsing them again. Zero, the default, keeps none.
+   * @param size  the most costing options to keep a costing for
+   */
+  void set_cache_size(const size_t size) {
+    cache_size_ = size;
+    prototypes_.clear();
   }
 
   mode_costing_t CreateModeCosting(const Options& options, TravelMode& mode) {
@@ -129,6 +164,9 @@ public:
 
 private:
   std::map<const Costing, factory_function_t> factory_funcs_;
+  size_t cache_size_ = 0;
+  // the costings by their serialized options, they are never handed out only copied
+  mutable std::unordered_map<std::string, cost_ptr_t> prototypes_;
 };
 
 } // namespace sif
@@ -0,0 +1,173 @@
+#ifndef VALHALLA_SIF_COSTKERNEL_H_
+#define VALHALLA_SIF_COSTKERNEL_H_
+
+#include <cstdint>
+#include <typeinfo>
+
+#include <valhalla/baldr/directededge.h>
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphtile.h>
+#include <valhalla/baldr/nodeinfo.h>
+#include <valhalla/sif/dynamiccost.h>
+#include <valhalla/sif/edgelabel.h>
+
+namespace valhalla {
+namespace sif {
+
+/**
+ * The costing methods a path algorithm calls for every edge it relaxes, called on a costing whose
+ * type is known to be exactly cost_t. The calls name the methods of cost_t so they arent
+ * dispatched virtually and whatever cost_t defines in its header is inlined into the search.
+ * A search is instantiated on the kernel of each costing which declares itself in a header and
+ * on CostKernel<DynamicCost>, which calls the methods virtually, for all of the others.
+ *
+ * A kernel only refers to the costing, it is made for every expansion from a node.
+ */
+template <typename cost_t> class CostKernel {
+public:
+  explicit CostKernel(const DynamicCost& costing) : costing_(static_cast<const cost_t&>(costing)) {
+  }
+
+  /**
+   * Whether the costing is exactly of the type of this kernel, the kernels of derived costings
+   * would skip their overrides.
+   * @param  costing  The costing of the request.
+   */
+  static bool Matches(const DynamicCost& costing) {
+    return typeid(costing) == typeid(cost_t);
+  }
+
+  bool Allowed(const baldr::NodeInfo* node) const {
+    return costing_.cost_t::Allowed(node);
+  }
+
+  bool Allowed(const baldr::DirectedEdge* edge,
+               const bool is_dest,
+               const EdgeLabel& pred,
+               const graph_tile_ptr& tile,
+               const baldr::GraphId& edgeid,
+               const uint64_t current_time,
+               const uint32_t tz_index,
+               uint8_t& restriction_idx) const {
+    return costing_.cost_t::Allowed(edge, is_dest, pred, tile, edgeid, current_time, tz_index,
+                                    restriction_idx);
+  }
+
+  bool AllowedReverse(const baldr::DirectedEdge* edge,
+                      const EdgeLabel& pred,
+                      const baldr::DirectedEdge* opp_edge,
+                      const graph_tile_ptr& tile,
+                      const baldr::GraphId& opp_edgeid,
+                      const uint64_t current_time,
+                      const uint32_t tz_index,
+                      uint8_t& restriction_idx) const {
+    return costing_.cost_t::AllowedReverse(edge, pred, opp_edge, tile, opp_edgeid, current_time,
+                                           tz_index, restriction_idx);
+  }
+
+  Cost EdgeCost(const baldr::DirectedEdge* edge,
+                const graph_tile_ptr& tile,
+                const uint32_t seconds,
+                uint8_t& flow_sources) const {
+    return costing_.cost_t::EdgeCost(edge, tile, seconds, flow_sources);
+  }
+
+  Cost TransitionCost(const baldr::DirectedEdge* edge,
+                      const baldr::NodeInfo* node,
+                      const EdgeLabel& pred) const {
+    return costing_.cost_t::TransitionCost(edge, node, pred);
+  }
+
+  Cost TransitionCostReverse(const uint32_t idx,
+                             const baldr::NodeInfo* node,
+                             const baldr::DirectedEdge* opp_edge,
+                             const baldr::DirectedEdge* opp_pred_edge,
+                             const bool has_measured_speed,
+                             const InternalTurn internal_turn) const {
+    return costing_.cost_t::TransitionCostReverse(idx, node, opp_edge, opp_pred_edge,
+                                                  has_measured_speed, internal_turn);
+  }
+
+  bool IsClosed(const baldr::DirectedEdge* edge, const graph_tile_ptr& tile) const {
+    return costing_.cost_t::IsClosed(edge, tile);
+  }
+
+protected:
+  const cost_t& costing_;
+};
+
+/**
+ * The kernel of the costings whose type isnt known, every call is dispatched virtually.
+ */
+template <> class CostKernel<DynamicCost> {
+public:
+  explicit CostKernel(const DynamicCost& costing) : costing_(costing) {
+  }
+
+  static bool Matches(const DynamicCost&) {
+    return true;
+  }
+
+  bool Allowed(const baldr::NodeInfo* node) const {
+    return costing_.Allowed(node);
+  }
+
+  bool Allowed(const baldr::DirectedEdge* edge,
+               const bool is_dest,
+               const EdgeLabel& pred,
+               const graph_tile_ptr& tile,
+               const baldr::GraphId& edgeid,
+               const uint64_t current_time,
+               const uint32_t tz_index,
+               uint8_t& restriction_idx) const {
+    return costing_.Allowed(edge, is_dest, pred, tile, edgeid, current_time, tz_index,
+                            restriction_idx);
+  }
+
+  bool AllowedReverse(const baldr::DirectedEdge* edge,
+                      const EdgeLabel& pred,
+                      const baldr::DirectedEdge* opp_edge,
+                      const graph_tile_ptr& tile,
+                      const baldr::GraphId& opp_edgeid,
+                      const uint64_t current_time,
+                      const uint32_t tz_index,
+                      uint8_t& restriction_idx) const {
+    return costing_.AllowedReverse(edge, pred, opp_edge, tile, opp_edgeid, current_time, tz_index,
+                                   restriction_idx);
+  }
+
+  Cost EdgeCost(const baldr::DirectedEdge* edge,
+                const graph_tile_ptr& tile,
+                const uint32_t seconds,
+                uint8_t& flow_sources) const {
+    return costing_.EdgeCost(edge, tile, seconds, flow_sources);
+  }
+
+  Cost TransitionCost(const baldr::DirectedEdge* edge,
+                      const baldr::NodeInfo* node,
+                      const EdgeLabel& pred) const {
+    return costing_.TransitionCost(edge, node, pred);
+  }
+
+  Cost TransitionCostReverse(const uint32_t idx,
+                             const baldr::NodeInfo* node,
+                             const baldr::DirectedEdge* opp_edge,
+                             const baldr::DirectedEdge* opp_pred_edge,
+                             const bool has_measured_speed,
+                             const InternalTurn internal_turn) const {
+    return costing_.TransitionCostReverse(idx, node, opp_edge, opp_pred_edge, has_measured_speed,
+                                          internal_turn);
+  }
+
+  bool IsClosed(const baldr::DirectedEdge* edge, const graph_tile_ptr& tile) const {
+    return costing_.IsClosed(edge, tile);
+  }
+
+protected:
+  const DynamicCost& costing_;
+};
+
+} // namespace sif
+} // namespace valhalla
+
+#endif // VALHALLA_SIF_COSTKERNEL_H_
@@ -20,8 +20,10 @@
 #include <valhalla/sif/hierarchylimits.h>
 #include <valhalla/thor/edgestatus.h>
 
+#include <algorithm>
 #include <memory>
 #include <rapidjson/document.h>
+#include <string>
 #include <unordered_map>
 
 using namespace valhalla::midgard;
@@ -46,6 +48,18 @@ constexpr float kMaxFerryPenalty = 6.0f * midgard::kSecPerHour; // 6 hours
 constexpr float kTCUnfavorablePencilPointUturn = 15.f;
 constexpr float kTCUnfavorableUturn = 600.f;
 
+/**
+ * One bit for each of the outbound edges of a node, in the order the node lists them.
+ */
+struct EdgeMask {
+  uint64_t words[2] = {0, 0};
+
+  bool test(const uint32_t index) const {
+    return (words[index >> 6] >> (index & 63)) & 1;
+  }
+};
+static_assert(baldr::kMaxEdgesPerNode <= 128, "EdgeMask needs a bit for every edge of a node");
+
 /**
  * Mask values used in the allowed function by loki::reach to control how conservative
  * the decision should be. By default allowed methods will not disallow start/end/simple
@@ -87,9 +101,15 @@ public:
 
   virtual ~DynamicCost();
 
-  DynamicCost(const DynamicCost&) = delete;
   DynamicCost& operator=(const DynamicCost&) = delete;
 
+  /**
+   * Copy the costing as it was constructed. The copy is only as good as the state a request leaves
+   * behind, so the CostFactory only clones costings it never handed out.
+   * @return  Returns the copy or nullptr if the costing cannot be copied.
+   */
+  virtual std::shared_ptr<DynamicCost> Clone() const;
+
   /**
    * Does the costing method allow multiple passes (with relaxed
    * hierarchy limits).
@@ -145,6 +165,43 @@ public:
     return access_mask_;
   }
 
+  /**
+   * The serialized options the costing was made from. Costings made from the same options cost
+   * every edge the same, so what was computed with one can be reused with the other.
+   * @return the serialized costing options
+   */
+  const std::string& options_key() const {
+    return options_key_;
+  }
+
+  /**
+   * Checks the first thing a path algorithm checks for every outbound edge of a node, before it
+   * asks the costing whether the edge is allowed, for all of them at once: whether the edge has
+   * access for the mode of this costing in the direction of the search and, unless they are
+   * wanted, whether it isnt a shortcut. The edges of a node are contiguous so the fields are
+   * decoded in one loop without branches which the compiler can vectorize.
+   * @param  edges      The first outbound edge of the node, a DirectedEdge or a RoutingEdge.
+   * @param  count      The number of outbound edges of the node.
+   * @param  forward    Whether to check the forward access rather than the reverse access.
+   * @param  shortcuts  Whether shortcuts are wanted.
+   * @return  Returns the mask of the edges which pass.
+   */
+  template <typename edge_t>
+  EdgeMask AllowedMask(const edge_t* edges,
+                       const uint32_t count,
+                       const bool forward,
+                       const bool shortcuts = false) const {
+    const uint32_t mode = access_mode();
+    EdgeMask mask;
+    for (uint32_t i = 0; i < count; ++i) {
+      const auto& edge = edges[i];
+      const uint64_t pass = (((forward ? edge.forwardaccess() : edge.reverseaccess()) & mode) != 0) &
+                            (shortcuts | !edge.is_shortcut());
+      mask.words[i >> 6] |= pass << (i & 63);
+    }
+    return mask;
+  }
+
   /**
    * Checks if access is allowed for the provided directed edge.
    * This is generally based on mode of travel and the access modes
@@ -756,8 +813,17 @@ public:
    *         false otherwise.
    */
   bool IsUserAvoidEdge(const baldr::GraphId& edgeid) const {
-    return (user_exclude_edges_.size() != 0 &&
-            user_exclude_edges_.find(edgeid) != user_exclude_edges_.end());
+    if (exclude_tiles_.empty()) {
+      return false;
+    }
+    auto tile = std::lower_bound(exclude_tiles_.cbegin(), exclude_tiles_.cend(),
+                                 edgeid.Tile_Base().value);
+    if (tile == exclude_tiles_.cend() || *tile != edgeid.Tile_Base().value) {
+      return false;
+    }
+    const auto& bits = exclude_bits_[tile - exclude_tiles_.cbegin()];
+    const uint64_t id = edgeid.id();
+    return (id >> 6) < bits.size() && (bits[id >> 6] & (uint64_t(1) << (id & 63)));
   }
 
   /**
@@ -770,6 +836,9 @@ public:
    *         false otherwise.
    */
   bool AvoidAsOriginEdge(const baldr::GraphId& edgeid, const float percent_along) const {
+    if (!IsUserAvoidEdge(edgeid)) {
+      return false;
+    }
     auto avoid = user_exclude_edges_.find(edgeid);
     return (avoid != user_exclude_edges_.end() && avoid->second >= percent_along);
   }
@@ -784,6 +853,9 @@ public:
    *         false otherwise.
    */
   bool AvoidAsDestinationEdge(const baldr::GraphId& edgeid, const float percent_along) const {
+    if (!IsUserAvoidEdge(edgeid)) {
+      return false;
+    }
     auto avoid = user_exclude_edges_.find(edgeid);
     return (avoid != user_exclude_edges_.end() && avoid->second <= percent_along);
   }
@@ -808,6 +880,9 @@ public:
   }
 
 protected:
+  // Only for the clones of derived costings
+  DynamicCost(const DynamicCost&) = default;
+
   /**
    * Calculate `track` costs based on tracks preference.
    * @param use_tracks value of tracks preference in range [0; 1]
@@ -845,6 +920,18 @@ protected:
   // User specified edges to avoid with percent along (for avoiding PathEdges of locations)
   std::unordered_map<baldr::GraphId, float> user_exclude_edges_;
 
+  // The same edges as a bitset over the directed edge ids of each tile which has any of them, the
+  // tiles are sorted so the expansion only pays for a bit test on the edges of those tiles
+  std::vector<uint64_t> exclude_tiles_;
+  std::vector<std::vector<uint64_t>> exclude_bits_;
+
+  /**
+   * Adds an edge to the user specified avoid list.
+   * @param  edgeid         Directed edge Id.
+   * @param  percent_along  Percent along the edge of the avoided location.
+   */
+  void AddUserAvoidEdge(const baldr::GraphId& edgeid, const float percent_along);
+
   // Weighting to apply to ferry edges
   float ferry_factor_, rail_ferry_factor_;
   float track_factor_;         // Avoid tracks factor.
@@ -886,6 +973,9 @@ protected:
 
   // Should we penalize uturns on short internal edges?
   bool penalize_uturns_;
+
+  // The serialized options the costing was made from
+  std::string options_key_;
   /**
    * Get the base transition costs (and ferry factor) from the costing options.
    * @param costing_options Protocol buffer of costing options.
@@ -0,0 +1,113 @@
+#ifndef VALHALLA_SIF_EDGECOSTCACHE_H_
+#define VALHALLA_SIF_EDGECOSTCACHE_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/directededge.h>
+#include <valhalla/baldr/graphconstants.h>
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphtile.h>
+#include <valhalla/sif/dynamiccost.h>
+
+namespace valhalla {
+namespace sif {
+
+/**
+ * The edge costs a search has computed so far, per tile in arrays indexed by the id of the edge.
+ * Searches which cost the same edges over and over at the same time of day, like the many
+ * searches of a matrix, look them up here instead of resolving the speed and the factors of the
+ * edge again. The costs belong to the options of one costing, one time and one graph, so they
+ * outlive the searches and are only dropped when any of those changes.
+ *
+ * Edges of tiles with live traffic are never kept when the costing uses live traffic, their speeds
+ * change under the cache, and with such a costing no costs outlive a reset. A cache is not thread
+ * safe, each thread of a search keeps its own.
+ */
+class EdgeCostCache {
+public:
+  EdgeCostCache()
+      : costing_(nullptr), seconds_(baldr::kInvalidSecondsOfWeek), live_(false), graph_(0) {
+  }
+
+  /**
+   * Keep the costs of a costing at a time from now on. The costs computed so far are kept when
+   * they were computed for the same costing options, time and graph, otherwise they are dropped.
+   * @param  costing  the costing of the search, it has to outlive its use of the cache
+   * @param  seconds  the time of week the search costs every edge at
+   * @param  graph    the id of the graph reader the search gets its tiles from
+   */
+  void Reset(const DynamicCost* costing, const uint32_t seconds, const uint64_t graph);
+
+  /**
+   * Drop the costs and the memory they took.
+   */
+  void Clear();
+
+  /**
+   * Get the cost to traverse an edge at the time the cache was reset for.
+   * @param  edgeid        the id of the edge
+   * @param  edge          the edge
+   * @param  tile          the tile passed to the EdgeCost of the costing
+   * @param  flow_sources  the speed sources the cost came from
+   * @return the cost and time (seconds)
+   */
+  Cost EdgeCost(const baldr::GraphId& edgeid,
+                const baldr::DirectedEdge* edge,
+                const graph_tile_ptr& tile,
+                uint8_t& flow_sources) {
+    if (live_ && tile->get_traffic_tile()()) {
+      return costing_->EdgeCost(edge, tile, seconds_, flow_sources);
+    }
+    auto& costs = tile_costs(edgeid);
+    const auto index = edgeid.id();
+    if (index >= costs.secs.size()) {
+      costs.resize(index + 1);
+    }
+    if (costs.secs[index] < 0.f) {
+      auto cost = costing_->EdgeCost(edge, tile, seconds_, costs.flow_sources[index]);
+      costs.cost[index] = cost.cost;
+      costs.secs[index] = cost.secs;
+    }
+    flow_sources = costs.flow_sources[index];
+    return {costs.cost[index], costs.secs[index]};
+  }
+
+protected:
+  // The costs of the edges of a tile, a negative time marks the ones not computed yet
+  struct tile_costs_t {
+    std::vector<float> cost;
+    std::vector<float> secs;
+    std::vector<uint8_t> flow_sources;
+
+    void resize(const size_t count);
+  };
+
+  const DynamicCost* costing_;
+  uint32_t seconds_;
+  bool live_;
+  // what the costs were computed for, they are kept as long as this stays the same
+  std::string options_key_;
+  uint64_t graph_;
+  std::unordered_map<uint64_t, tile_costs_t> tiles_;
+
+  // the tile looked up last, searches mostly stay within a tile
+  uint64_t last_tile_ = baldr::kInvalidGraphId;
+  tile_costs_t* last_costs_ = nullptr;
+
+  tile_costs_t& tile_costs(const baldr::GraphId& edgeid) {
+    const auto tile = edgeid.Tile_Base().value;
+    if (tile != last_tile_) {
+      last_tile_ = tile;
+      last_costs_ = &tiles_[tile];
+    }
+    return *last_costs_;
+  }
+};
+
+} // namespace sif
+} // namespace valhalla
+
+#endif // VALHALLA_SIF_EDGECOSTCACHE_H_
@@ -31,8 +31,9 @@ public:
         edgeid_(baldr::kInvalidGraphId), opp_index_(0), opp_local_idx_(0), mode_(0),
         endnode_(baldr::kInvalidGraphId), use_(0), classification_(0), shortcut_(0), dest_only_(0),
         origin_(0), toll_(0), not_thru_(0), deadend_(0), on_complex_rest_(0), closure_pruning_(0),
-        has_measured_speed_(0), path_id_(0), restriction_idx_(0), internal_turn_(0), cost_(0, 0),
-        sortcost_(0), distance_(0), transition_cost_(0, 0) {
+        has_measured_speed_(0), path_id_(0), restriction_idx_(0), internal_turn_(0),
+        not_thru_pruning_(0), extra_bits_(0), cost_(0, 0), sortcost_(0), distance_(0),
+        transition_cost_(0, 0) {
     assert(path_id_ <= baldr::kMaxMultiPathId);
   }
 
@@ -81,7 +82,8 @@ public:
                          edge->end_restriction()),
         closure_pruning_(closure_pruning), has_measured_speed_(has_measured_speed), path_id_(path_id),
         restriction_idx_(restriction_idx), internal_turn_(static_cast<uint8_t>(internal_turn)),
-        cost_(cost), sortcost_(sortcost), distance_(dist), transition_cost_(transition_cost) {
+        not_thru_pruning_(0), extra_bits_(0), cost_(cost), sortcost_(sortcost), distance_(dist),
+        transition_cost_(transition_cost) {
     assert(path_id_ <= baldr::kMaxMultiPathId);
   }
 
@@ -445,7 +447,11 @@ protected:
   uint32_t restriction_idx_ : 8;
   // internal_turn_ Did we make an turn on a short internal edge.
   uint32_t internal_turn_ : 2;
-  uint32_t spare : 15;
+  // not_thru_pruning_ Is not thru pruning enabled? Only the bidirectional labels use it
+  uint32_t not_thru_pruning_ : 1;
+  // extra_bits_ Left for derived labels to pack their fields into, the bidirectional labels keep
+  // the top of their opposing edge id here so the rest of it fits in the padding after this class
+  uint32_t extra_bits_ : 14;
 
   Cost cost_;      // Cost and elapsed time along the path.
   float sortcost_; // Sort cost - includes A* heuristic.
@@ -517,7 +523,9 @@ public:
                   has_measured_speed,
                   internal_turn,
                   path_id),
-        opp_edgeid_(oppedgeid), not_thru_pruning_(not_thru_pruning) {
+        opp_edgeid_low_(0) {
+    set_opp_edgeid(oppedgeid);
+    not_thru_pruning_ = not_thru_pruning;
   }
 
   /**
@@ -569,7 +577,9 @@ public:
                   has_measured_speed,
                   internal_turn,
                   path_id),
-        opp_edgeid_(oppedgeid), not_thru_pruning_(not_thru_pruning) {
+        opp_edgeid_low_(0) {
+    set_opp_edgeid(oppedgeid);
+    not_thru_pruning_ = not_thru_pruning;
   }
 
   /**
@@ -616,8 +626,8 @@ public:
                   has_measured_speed,
                   internal_turn,
                   path_id),
-        not_thru_pruning_(!edge->not_thru()) {
-    opp_edgeid_ = {};
+        opp_edgeid_low_(0) {
+    not_thru_pruning_ = !edge->not_thru();
   }
 
   /**
@@ -670,7 +680,7 @@ public:
    * @return  Returns the GraphId of the opposing directed edge.
    */
   baldr::GraphId opp_edgeid() const {
-    return baldr::GraphId(opp_edgeid_);
+    return baldr::GraphId(static_cast<uint64_t>(extra_bits_) << 32 | opp_edgeid_low_);
   }
 
   /**
@@ -682,14 +692,22 @@ public:
   }
 
 protected:
-  // Graph Id of the opposing edge.
-  // not_thru_pruning_: Is not thru pruning enabled?
-  uint64_t opp_edgeid_ : 63; // Could be 46 (to provide more spare)
-  // TODO: Move not_thru_prunin to the base class - EdgeLabel so that we can
-  // consolidate all pruning related properties at 1 place
-  uint64_t not_thru_pruning_ : 1;
+  void set_opp_edgeid(const baldr::GraphId& oppedgeid) {
+    opp_edgeid_low_ = static_cast<uint32_t>(oppedgeid.value);
+    extra_bits_ = static_cast<uint32_t>(oppedgeid.value >> 32);
+  }
+
+  // The low 32 bits of the Graph Id of the opposing edge, the top 14 are in the extra bits of the
+  // base. Split like this the id takes the padding at the end of the base and the label is 56
+  // bytes rather than 64, so more of them share the cache lines the searches walk over
+  uint32_t opp_edgeid_low_;
 };
 
+#ifndef _MSC_VER
+// msvc does not place members of derived classes in the tail padding of their base
+static_assert(sizeof(BDEdgeLabel) == sizeof(EdgeLabel), "BDEdgeLabel should fit in EdgeLabel");
+#endif
+
 /**
  * EdgeLabel used for multi-modal A* path algorithm.
  */
@@ -2,7 +2,12 @@
 #define VALHALLA_SIF_HIERARCHYLIMITS_H_
 
 #include <boost/property_tree/ptree.hpp>
+#include <cstdint>
 #include <limits>
+#include <string>
+#include <unordered_map>
+
+#include <valhalla/midgard/pointll.h>
 
 // Default hierarchy transitions. Note that this corresponds to a 3 level
 // strategy: highway, arterial, local. Any changes to this will require
@@ -92,6 +97,65 @@ struct HierarchyLimits {
   }
 };
 
+/**
+ * Factors to scale the hierarchy limits of the routes of a costing by where they start and end.
+ * They are learned offline from logged requests by valhalla_tune_hierarchy_limits, which keeps
+ * the smallest factor whose routes were as good as with the default limits. A region is a tile of
+ * the highway level and the table is json like {"auto":{"2403":0.5,"2404":0.25}}. The costings and
+ * regions which are not in it keep the default limits.
+ */
+class HierarchyLimitsTable {
+public:
+  HierarchyLimitsTable() = default;
+
+  /**
+   * Loads the table from its json file.
+   * @param  path  the file, throws if it cant be read or parsed
+   */
+  explicit HierarchyLimitsTable(const std::string& path);
+
+  /**
+   * Sets the factor of a costing in a region.
+   * @param  costing  the name of the costing like auto
+   * @param  region   the highway level tile
+   * @param  factor   what to scale the limits by
+   */
+  void Set(const std::string& costing, const uint32_t region, const float factor) {
+    factors_[costing][region] = factor;
+  }
+
+  /**
+   * The factor for a route of the costing between two points. A route needs the limits of the
+   * more generous of the regions it starts and ends in so that is the larger factor of the two.
+   * @param  costing  the name of the costing like auto
+   * @param  a        where the route starts
+   * @param  b        where the route ends
+   * @return the factor or 1 if neither region is known
+   */
+  float
+  Factor(const std::string& costing, const midgard::PointLL& a, const midgard::PointLL& b) const;
+
+  /**
+   * Writes the table as json.
+   * @return the json, which the constructor can load again
+   */
+  std::string ToJson() const;
+
+  /**
+   * The region of a point, the tile of the highway level it is in.
+   * @param  ll  the point
+   * @return the tile id
+   */
+  static uint32_t Region(const midgard::PointLL& ll);
+
+  bool empty() const {
+    return factors_.empty();
+  }
+
+private:
+  std::unordered_map<std::string, std::unordered_map<uint32_t, float>> factors_;
+};
+
 } // namespace sif
 } // namespace valhalla
 
@@ -3,16 +3,24 @@
 
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <valhalla/midgard/lru_cache.h>
 #include <valhalla/midgard/sequence.h>
 
 namespace valhalla {
 namespace skadi {
 
+// how much memory a decompressed tile takes
+constexpr size_t kUnzippedTileBytes = 3601 * 3601 * sizeof(int16_t);
+
+// by default keep up to 4 decompressed tiles (~100MB) around
+constexpr size_t kDefaultUnzippedCacheBytes = 4 * kUnzippedTileBytes;
+
 class sample {
 public:
   // non-default-constructable and non-copyable
@@ -25,8 +33,10 @@ public:
   /**
    * Constructor
    * @param data_source  directory name of the datasource from which to sample
+   * @param cache_bytes  how many bytes of decompressed tiles to keep around, at least one tile
+   *                     is always kept
    */
-  sample(const std::string& data_source);
+  sample(const std::string& data_source, size_t cache_bytes = kDefaultUnzippedCacheBytes);
 
   /**
    * Get a single sample from the datasource
@@ -45,7 +55,46 @@ public:
    */
   static double get_no_data_value();
 
+  /**
+   * Converts an hgt tile into the blocked format (.hgt.blk). Its pixels are native endian and
+   * grouped into square blocks which are compressed on their own behind an index of the blocks,
+   * so that sampling only inflates the blocks it touches and never has to swap bytes. Blocks
+   * which don't get any smaller are stored as they are and read straight out of the file.
+   * @param hgt      the file name of the raw or gzipped hgt tile
+   * @param blocked  the file name to write the blocked tile to
+   * @param level    the zlib compression level of the blocks
+   * @return false if the hgt tile could not be read
+   */
+  static bool convert(const std::string& hgt, const std::string& blocked, int level = 1);
+
+  /**
+   * @return how many decompressed tiles can be kept around at once
+   */
+  size_t cache_capacity() const;
+
+  /**
+   * @return how many decompressed tiles are currently kept around
+   */
+  size_t cache_size() const;
+
+  /**
+   * @return how many decompressed blocks of blocked tiles are currently kept around
+   */
+  size_t cache_blocks() const;
+
+  /**
+   * @return how many times a compressed tile or block was found already decompressed
+   */
+  size_t cache_hits() const;
+
+  /**
+   * @return how many times a compressed tile or block had to be decompressed
+   */
+  size_t cache_misses() const;
+
 protected:
+  // keeps the data alive for as long as someone is reading it, an empty owner for raw tiles
+  using tile_data_t = std::shared_ptr<const int16_t>;
   /**
    * @return A tile index value from a coordinate
    */
@@ -56,13 +105,24 @@ protected:
    */
   static std::string get_hgt_file_name(uint16_t index);
 
+  enum class format_t { UNKNOWN = 0, GZIP = 1, RAW = 3, BLOCKED = 4 };
+
   /**
-   * @param  index  the index of the data tile being requested
+   * @param  index   the index of the data tile being requested
+   * @param  format  set to the format of the tile, blocked tiles have to be read with block()
    * @return the array of data or nullptr if there was none
    */
-  const int16_t* source(uint16_t index) const;
+  tile_data_t source(uint16_t index, format_t& format) const;
+
+  /**
+   * @param  index  the index of a blocked data tile which source() found
+   * @param  block  the index of the block within the tile
+   * @return the native endian pixels of the block or nullptr if it was corrupt
+   */
+  tile_data_t block(uint16_t index, uint32_t block) const;
 
-  enum class format_t { UNKNOWN = 0, GZIP = 1, RAW = 3 };
+  // reads the pixels of a tile whatever its format
+  struct pixels_t;
   /**
    * maps a new source, used at start up and called periodically
    * for lazily loaded sources
@@ -76,9 +136,17 @@ protected:
   // using memory maps
   mutable std::vector<std::pair<format_t, midgard::mem_map<char>>> mapped_cache;
 
-  // TODO: make an LRU
-  using unzipped_t = std::pair<int16_t, std::vector<int16_t>>;
-  mutable unzipped_t unzipped_cache;
+  // the most recently used decompressed tiles, the lock also guards the lazy mapping of tiles
+  struct unzipped_t {
+    unzipped_t(size_t tile_capacity, size_t block_capacity)
+        : tiles(tile_capacity), blocks(block_capacity) {
+    }
+    std::mutex lock;
+    midgard::lru_cache_t<uint16_t, std::shared_ptr<const std::vector<int16_t>>> tiles;
+    midgard::lru_cache_t<uint32_t, std::shared_ptr<const std::vector<int16_t>>> blocks;
+  };
+  // behind a pointer so that the sample stays movable
+  std::unique_ptr<unzipped_t> unzipped_cache;
 
   std::string data_source;
 };
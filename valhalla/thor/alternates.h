@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 #include "thor/bidirectional_astar.h"
@@ -10,9 +11,25 @@ float get_max_sharing(const valhalla::Location& origin, const valhalla::Location
 
 void filter_alternates_by_stretch(std::vector<CandidateConnection>& connections);
 
-bool validate_alternate_by_sharing(std::vector<std::unordered_set<baldr::GraphId>>& shared_edgeids,
-                                   const std::vector<std::vector<PathInfo>>& paths,
-                                   const std::vector<PathInfo>& candidate_path,
+/**
+ * Adds the edges of a chosen path to the sorted edge lists that candidates are checked against.
+ * @param shared_edgeids  one sorted list of edge ids per chosen path
+ * @param path_edges      the edges of the chosen path with all shortcuts recovered
+ */
+void add_shared_edges(std::vector<std::vector<uint64_t>>& shared_edgeids,
+                      const std::vector<baldr::GraphId>& path_edges);
+
+/**
+ * Checks that a candidate does not share too much of its length with any of the chosen paths.
+ * @param shared_edgeids     one sorted list of edge ids per chosen path
+ * @param candidate_edges    the edges of the candidate with all shortcuts recovered
+ * @param candidate_lengths  how much of each of the edges the candidate covers
+ * @param at_most_shared     the largest fraction of the candidate allowed on a chosen path
+ * @return true if the candidate is a viable alternate
+ */
+bool validate_alternate_by_sharing(const std::vector<std::vector<uint64_t>>& shared_edgeids,
+                                   const std::vector<baldr::GraphId>& candidate_edges,
+                                   const std::vector<float>& candidate_lengths,
                                    float at_most_shared);
 
 bool validate_alternate_by_local_optimality(const std::vector<PathInfo>& candidate_path);
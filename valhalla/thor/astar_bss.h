@@ -15,6 +15,7 @@
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/sif/hierarchylimits.h>
 #include <valhalla/thor/astarheuristic.h>
+#include <valhalla/thor/bss_stations.h>
 #include <valhalla/thor/edgestatus.h>
 #include <valhalla/thor/pathalgorithm.h>
 #include <valhalla/thor/pathinfo.h>
@@ -71,6 +72,14 @@ public:
    */
   virtual void Clear() override;
 
+  SearchStats Stats() const override {
+    SearchStats stats;
+    stats.labels = edgelabels_.size();
+    stats.queue_resorts = adjacencylist_.resorts();
+    stats.status_tiles = pedestrian_edgestatus_.size() + bicycle_edgestatus_.size();
+    return stats;
+  }
+
   /**
    * Set a maximum label count. The path algorithm terminates if this
    * is exceeded.
@@ -89,6 +98,12 @@ protected:
   AStarHeuristic pedestrian_astarheuristic_;
   AStarHeuristic bicycle_astarheuristic_;
 
+  // Bike share stations around the destination, the distance from it to the closest one and the
+  // extra cost per meter of walking that distance rather than riding it
+  BssStations stations_;
+  float station_distance_;
+  float bicycle_walk_factor_;
+
   // Current costing mode
   std::shared_ptr<sif::DynamicCost> pedestrian_costing_;
   std::shared_ptr<sif::DynamicCost> bicycle_costing_;
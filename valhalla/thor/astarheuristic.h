@@ -1,6 +1,13 @@
 #ifndef VALHALLA_THOR_ASTARHEURISTIC_H_
 #define VALHALLA_THOR_ASTARHEURISTIC_H_
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphtile.h>
+#include <valhalla/baldr/landmarks.h>
 #include <valhalla/midgard/distanceapproximator.h>
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/midgard/util.h>
@@ -10,10 +17,15 @@ namespace thor {
 
 /**
  * Class to calculate A* cost heuristics based on distances of nodes from
- * a destination within the shortest path computation.
+ * a destination within the shortest path computation. With landmarks the
+ * distance is the larger of the straight line and the landmark lower bound
+ * of the path length to the nodes the destination is reached through.
  */
 class AStarHeuristic {
 public:
+  // The distance of end nodes GetDistances could not find, those in other tiles
+  static constexpr float kUnknownDistance = -1.0f;
+
   /**
    * Constructor.
    */
@@ -32,6 +44,8 @@ public:
    */
   void Init(const midgard::PointLL& ll, const float factor) {
     distapprox_.SetTestPoint(ll);
+    dest_ = ll;
+    m_per_lng_degree_ = distapprox_.GetLngScale() * midgard::kMetersPerDegreeLat;
     costfactor_ = factor;
   }
 
@@ -44,6 +58,43 @@ public:
     return sqrtf(distapprox_.DistanceSquared(ll));
   }
 
+  /**
+   * Get the distances to the destination of the end nodes of the edges leaving a node in one
+   * go rather than one edge at a time. The end nodes are taken relative to the destination in
+   * separate arrays of latitudes and longitudes so the distances of several of them are found
+   * at once, in single precision which is plenty for the offsets. Edges that leave the tile
+   * have their end node in another tile and get kUnknownDistance.
+   * @param  tile   The tile the edges are in.
+   * @param  edges  The first of the edges.
+   * @param  count  How many edges, at most baldr::kMaxEdgesPerNode.
+   * @param  dists  Set to the distances (meters) to the destination, one per edge.
+   */
+  void GetDistances(const baldr::GraphTile& tile,
+                    const baldr::DirectedEdge* edges,
+                    const uint32_t count,
+                    float* dists) const {
+    float dlat[baldr::kMaxEdgesPerNode];
+    float dlng[baldr::kMaxEdgesPerNode];
+    for (uint32_t i = 0; i < count; ++i) {
+      if (edges[i].leaves_tile()) {
+        dlat[i] = dlng[i] = 0.0f;
+        continue;
+      }
+      const auto ll = tile.get_node_ll(edges[i].endnode());
+      dlat[i] = static_cast<float>(ll.lat() - dest_.lat());
+      dlng[i] = static_cast<float>(ll.lng() - dest_.lng());
+    }
+    constexpr float m_per_lat_degree = midgard::kMetersPerDegreeLat;
+    for (uint32_t i = 0; i < count; ++i) {
+      const float y = dlat[i] * m_per_lat_degree;
+      const float x = dlng[i] * m_per_lng_degree_;
+      dists[i] = sqrtf(y * y + x * x);
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+      dists[i] = edges[i].leaves_tile() ? kUnknownDistance : dists[i];
+    }
+  }
+
   /**
    * Get the A* heuristic given the distance to the destination.
    * @param   distance  Distance (meters) to the destination.
@@ -77,10 +128,101 @@ public:
     return dist * costfactor_;
   }
 
+  /**
+   * Set the landmark distances to tighten the heuristic with.
+   * @param  landmarks  The landmark distances, none to only use the straight line.
+   */
+  void SetLandmarks(const std::shared_ptr<const baldr::Landmarks>& landmarks) {
+    landmarks_ = landmarks;
+    targets_.clear();
+  }
+
+  /**
+   * Sets the nodes a path has to pass through to get to the destination, the
+   * ends of its edges, for the landmark lower bounds.
+   * @param  nodes  The graph nodes around the destination.
+   */
+  void InitLandmarks(const std::vector<baldr::GraphId>& nodes) {
+    targets_.clear();
+    if (!landmarks_) {
+      return;
+    }
+    for (const auto& node : nodes) {
+      auto index = landmarks_->node_index(node);
+      // Without bounds to all of them only the straight line is safe
+      if (index == baldr::Landmarks::kInvalidNode) {
+        targets_.clear();
+        return;
+      }
+      targets_.push_back(landmarks_->distances(index));
+    }
+  }
+
+  /**
+   * Get the A* heuristic given the lat,lng and graph node. Also return the
+   * straight line distance via an argument.
+   * @param   ll    Lat,lng
+   * @param   node  The graph node at the lat,lng.
+   * @param   dist  Distance (meters) to the destination.
+   * @return  Returns an estimate of the cost to the destination.
+   *          For A* shortest path this MUST UNDERESTIMATE the true cost.
+   */
+  float Get(const midgard::PointLL& ll, const baldr::GraphId& node, float& dist) const {
+    dist = sqrtf(distapprox_.DistanceSquared(ll));
+    return std::max(dist, GetLandmarkDistance(node)) * costfactor_;
+  }
+
+  /**
+   * Get the A* heuristic given the distance to the destination of a graph node.
+   * @param   dist  Distance (meters) to the destination.
+   * @param   node  The graph node.
+   * @return  Returns an estimate of the cost to the destination.
+   *          For A* shortest path this MUST UNDERESTIMATE the true cost.
+   */
+  float Get(const float dist, const baldr::GraphId& node) const {
+    return std::max(dist, GetLandmarkDistance(node)) * costfactor_;
+  }
+
+  /**
+   * Get the landmark lower bound of the path length from a node to the
+   * destination, the smallest of the bounds to the destination nodes which
+   * are the largest difference of the distances of them and the node to a
+   * landmark.
+   * @param   node  The graph node.
+   * @return  Returns the lower bound in meters, 0 without landmarks.
+   */
+  float GetLandmarkDistance(const baldr::GraphId& node) const {
+    if (targets_.empty()) {
+      return 0.0f;
+    }
+    auto index = landmarks_->node_index(node);
+    if (index == baldr::Landmarks::kInvalidNode) {
+      return 0.0f;
+    }
+    const uint32_t* from = landmarks_->distances(index);
+    const size_t count = landmarks_->landmark_count();
+    uint32_t bound = baldr::Landmarks::kUnreached;
+    for (const uint32_t* to : targets_) {
+      uint32_t target_bound = 0;
+      for (size_t i = 0; i < count; ++i) {
+        if (from[i] != baldr::Landmarks::kUnreached && to[i] != baldr::Landmarks::kUnreached) {
+          target_bound = std::max(target_bound, from[i] > to[i] ? from[i] - to[i] : to[i] - from[i]);
+        }
+      }
+      bound = std::min(bound, target_bound);
+    }
+    return static_cast<float>(bound);
+  }
+
 private:
   midgard::DistanceApproximator<midgard::PointLL> distapprox_; // Distance approximation
+  midgard::PointLL dest_;                                      // The destination
+  float m_per_lng_degree_ = 0.0f; // Meters per degree of longitude at the destination
   float costfactor_; // Cost factor - ensures the cost estimate
                      // underestimates the true cost.
+
+  std::shared_ptr<const baldr::Landmarks> landmarks_; // Landmark distances, if any
+  std::vector<const uint32_t*> targets_; // Landmark distances of the destination nodes
 };
 
 } // namespace thor
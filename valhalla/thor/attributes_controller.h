@@ -141,12 +141,15 @@ const std::string kShapeAttributesLength = "shape_attributes.length";
 const std::string kShapeAttributesSpeed = "shape_attributes.speed";
 const std::string kShapeAttributesSpeedLimit = "shape_attributes.speed_limit";
 const std::string kShapeAttributesClosure = "shape_attributes.closure";
+const std::string kShapeAttributesElevation = "shape_attributes.elevation";
 
 // Categories
 const std::string kNodeCategory = "node.";
 const std::string kAdminCategory = "admin.";
 const std::string kMatchedCategory = "matched.";
 const std::string kShapeAttributesCategory = "shape_attributes.";
+const std::string kEdgeSignCategory = "edge.sign.";
+const std::string kNodeIntersectingEdgeCategory = "node.intersecting_edge.";
 
 /**
  * Trip path controller for attributes
@@ -168,6 +171,12 @@ struct AttributesController {
    */
   void disable_all();
 
+  /**
+   * Disable the attributes which only go into making maneuvers and their instructions, for the
+   * requests which do not want any directions made from the trip.
+   */
+  void disable_guidance();
+
   /**
    * Returns true if any category attribute is enabled, false otherwise.
    */
@@ -11,6 +11,7 @@
 #include <valhalla/baldr/double_bucket_queue.h>
 #include <valhalla/baldr/time_info.h>
 #include <valhalla/proto/api.pb.h>
+#include <valhalla/sif/costkernel.h>
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/sif/hierarchylimits.h>
 #include <valhalla/thor/astarheuristic.h>
@@ -84,6 +85,25 @@ public:
    */
   void Clear() override;
 
+  /**
+   * Sets the table of factors to scale the hierarchy limits of the first pass by, which is
+   * otherwise loaded from the hierarchy_limits_table file of the config if there is one.
+   * @param table  the table or nullptr to keep the default limits
+   */
+  void set_hierarchy_limits_table(const std::shared_ptr<const sif::HierarchyLimitsTable>& table) {
+    hierarchy_limits_table_ = table;
+  }
+
+  SearchStats Stats() const override {
+    SearchStats stats;
+    stats.labels = edgelabels_forward_.size() + edgelabels_reverse_.size();
+    stats.queue_resorts = adjacencylist_forward_.resorts() + adjacencylist_reverse_.resorts();
+    stats.status_tiles = edgestatus_forward_.size() + edgestatus_reverse_.size();
+    stats.up_transitions =
+        up_transitions(hierarchy_limits_forward_) + up_transitions(hierarchy_limits_reverse_);
+    return stats;
+  }
+
 protected:
   // Access mode used by the costing method
   uint32_t access_mode_;
@@ -97,9 +117,21 @@ protected:
   // Current costing mode
   std::shared_ptr<sif::DynamicCost> costing_;
 
+  // The expansions in each direction, instantiated for the costing of the request
+  using expand_t = bool (BidirectionalAStar::*)(baldr::GraphReader&,
+                                                const baldr::GraphId&,
+                                                sif::BDEdgeLabel&,
+                                                const uint32_t,
+                                                const baldr::DirectedEdge*,
+                                                const baldr::TimeInfo&,
+                                                const bool);
+  expand_t expand_forward_;
+  expand_t expand_reverse_;
+
   // Hierarchy limits
   std::vector<sif::HierarchyLimits> hierarchy_limits_forward_;
   std::vector<sif::HierarchyLimits> hierarchy_limits_reverse_;
+  std::shared_ptr<const sif::HierarchyLimitsTable> hierarchy_limits_table_;
 
   // A* heuristic
   float cost_diff_;
@@ -111,6 +143,9 @@ protected:
   std::vector<sif::BDEdgeLabel> edgelabels_reverse_;
   uint32_t max_reserved_labels_count_;
 
+  // Number of coarse buckets the adjacency lists split their overflow into
+  uint32_t overflow_bucket_count_;
+
   // Adjacency list - approximate double bucket sort
   baldr::DoubleBucketQueue<sif::BDEdgeLabel> adjacencylist_forward_;
   baldr::DoubleBucketQueue<sif::BDEdgeLabel> adjacencylist_reverse_;
@@ -133,6 +168,10 @@ protected:
   // edge)
   bool pruning_disabled_at_origin_, pruning_disabled_at_destination_;
 
+  // Whether the time of the forward or of the reverse search is only a guess made from the time
+  // at the other end. Such a time picks the predicted speeds but is not trusted with restrictions
+  bool forward_time_estimated_, reverse_time_estimated_;
+
   /**
    * Initialize the A* heuristic and adjacency lists for both the forward
    * and reverse search.
@@ -151,8 +190,12 @@ protected:
    * @param time_info          time tracking information about the start of the route
    * @param invariant          static date_time, dont offset the time as the path lengthens
    * @return returns true if the expansion continued from this node
+   *
+   * kernel_t is the sif::CostKernel the edges are relaxed with, of the exact type of the costing
+   * when the request has one of the costings declared in their headers.
    */
-  template <const ExpansionType expansion_direction>
+  template <const ExpansionType expansion_direction,
+            typename kernel_t = sif::CostKernel<sif::DynamicCost>>
   bool Expand(baldr::GraphReader& graphreader,
               const baldr::GraphId& node,
               sif::BDEdgeLabel& pred,
@@ -171,8 +214,9 @@ protected:
   // connect the forward and reverse paths. In that case we return false to allow uturns only if this
   // edge is a not-thru edge that will be pruned.
   //
-  template <const ExpansionType expansion_direction>
+  template <const ExpansionType expansion_direction, typename kernel_t>
   inline bool ExpandInner(baldr::GraphReader& graphreader,
+                          const kernel_t& costing,
                           const sif::BDEdgeLabel& pred,
                           const baldr::DirectedEdge* opp_pred_edge,
                           const baldr::NodeInfo* nodeinfo,
@@ -180,7 +224,8 @@ protected:
                           const EdgeMetadata& meta,
                           uint32_t& shortcuts,
                           const graph_tile_ptr& tile,
-                          const baldr::TimeInfo& time_info);
+                          const baldr::TimeInfo& time_info,
+                          const float end_node_dist);
   /**
    * Add edges at the origin to the forward adjacency list.
    * @param graphreader  Graph tile reader.
@@ -241,6 +286,19 @@ protected:
                                               const baldr::TimeInfo& time_info,
                                               const bool invariant);
 
+  /**
+   * Marks the forward labels of the plateau a connection lies on, the stretch of its path along
+   * which the forward and the reverse search trees agree. Every other connection on the plateau
+   * forms exactly the same path so only the first of them has to be formed.
+   * @param   fwd_idx      Index of the forward label of the connection.
+   * @param   rev_idx      Index of the reverse label of the connection.
+   * @param   on_plateau   Per forward label whether it is on a plateau already seen.
+   * @return  Returns the number of edges on the plateau.
+   */
+  uint32_t MarkPlateau(const uint32_t fwd_idx,
+                       const uint32_t rev_idx,
+                       std::vector<bool>& on_plateau) const;
+
   /**
    * Modify default (optimized for unidirectional search) hierarchy limits.
    */
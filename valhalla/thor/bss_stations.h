@@ -0,0 +1,65 @@
+#ifndef VALHALLA_THOR_BSS_STATIONS_H_
+#define VALHALLA_THOR_BSS_STATIONS_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/midgard/pointll.h>
+
+namespace valhalla {
+namespace thor {
+
+// How far from a location to look for the bike share stations closest to it
+constexpr float kMaxStationAccess = 2000.0f; // meters
+
+/**
+ * The bike share stations around the locations of a bike share search. Any path which rides a
+ * bike to a location has to return the bike at a station and walk the rest of the way, so the
+ * distance from the location to its closest station is a lower bound on the walking at the end
+ * of such a path. The searches use it to tighten the estimates of their bicycle labels and to
+ * drop bicycle labels which could not get to any location within the cost threshold.
+ *
+ * The stations of a local tile are collected the first time a location near it is looked at so
+ * the locations of a matrix only scan the nodes of each tile once.
+ */
+class BssStations {
+public:
+  /**
+   * @param  max_distance  How far to look for stations
+   */
+  explicit BssStations(const float max_distance = kMaxStationAccess)
+      : max_distance_(max_distance) {
+  }
+
+  /**
+   * Forget the stations found so far.
+   */
+  void Clear() {
+    stations_.clear();
+  }
+
+  /**
+   * Get the distance from a location to its closest bike share station.
+   * @param  graphreader  Graph tile reader
+   * @param  ll           Lat,lng of the location
+   * @return the distance in meters, the maximum distance if no station is closer than that
+   */
+  float Distance(baldr::GraphReader& graphreader, const midgard::PointLL& ll);
+
+protected:
+  /**
+   * Get the stations of a local tile, collecting them if the tile was not looked at yet.
+   */
+  const std::vector<midgard::PointLL>& Stations(baldr::GraphReader& graphreader,
+                                                 const uint32_t tileid);
+
+  float max_distance_;
+  std::unordered_map<uint32_t, std::vector<midgard::PointLL>> stations_;
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_BSS_STATIONS_H_
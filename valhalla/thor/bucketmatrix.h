@@ -0,0 +1,89 @@
+#ifndef VALHALLA_THOR_BUCKETMATRIX_H_
+#define VALHALLA_THOR_BUCKETMATRIX_H_
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/proto/tripcommon.pb.h>
+#include <valhalla/sif/dynamiccost.h>
+#include <valhalla/thor/costmatrix.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Class to compute cost (cost + time + distance) matrices among locations using the
+ * bucket based many to many approach from Knopp et al, "Computing Many-to-Many Shortest Paths
+ * Using Highway Hierarchies". The backward search of every target runs first, leaving the target
+ * in a bucket on every edge it reaches, and the forward search of every source then only has to
+ * look in the buckets of the edges it settles. The searches are the hierarchy limited expansions
+ * of CostMatrix but as neither direction has to wait on the other each one stops as soon as it
+ * cannot improve any of its connections anymore rather than after a number of iterations.
+ */
+class BucketMatrix : public CostMatrix {
+public:
+  /**
+   * Constructor.
+   * @param  config   Thor configuration, see CostMatrix.
+   * @param  workers  Threads to run the searches on, if any.
+   */
+  explicit BucketMatrix(const boost::property_tree::ptree& config = {},
+                        const std::shared_ptr<MatrixWorkers>& workers = {});
+
+  /**
+   * Forms a time distance matrix from the set of source locations
+   * to the set of target locations.
+   * @param  source_location_list  List of source/origin locations.
+   * @param  target_location_list  List of target/destination locations.
+   * @param  graphreader           Graph reader for accessing routing graph.
+   * @param  mode_costing          Costing methods.
+   * @param  mode                  Travel mode to use.
+   * @param  max_matrix_distance   Maximum arc-length distance for current mode.
+   * @return time/distance from origin index to all other locations
+   */
+  std::vector<TimeDistance>
+  SourceToTarget(const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+                 const google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+                 baldr::GraphReader& graphreader,
+                 const sif::mode_costing_t& mode_costing,
+                 const sif::TravelMode mode,
+                 const float max_matrix_distance);
+
+  /**
+   * Clear the temporary information generated during time+distance
+   * matrix construction.
+   */
+  void Clear();
+
+protected:
+  // The sources whose forward search starts on an edge keyed by the opposing edge, which is what
+  // the backward searches reach, along with the cost of their start on it
+  std::unordered_map<uint64_t, std::vector<std::pair<uint32_t, float>>> origin_edges_;
+
+  /**
+   * Runs the backward search of a target until reaching the origin edges of all sources bounds
+   * the cost of the connections it can still be part of.
+   * @param  index        Index of the target location.
+   * @param  graphreader  Graph reader for accessing routing graph.
+   */
+  void BackwardSearchToBound(const uint32_t index, baldr::GraphReader& graphreader);
+
+  /**
+   * Runs the forward search of a source until it has a connection to every target which none of
+   * the edges it has yet to settle could improve on.
+   * @param  index        Index of the source location.
+   * @param  graphreader  Graph reader for accessing routing graph.
+   */
+  void ForwardSearchToBound(const uint32_t index, baldr::GraphReader& graphreader);
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_BUCKETMATRIX_H_
@@ -10,6 +10,7 @@
 #include <valhalla/sif/costconstants.h>
 #include <valhalla/sif/dynamiccost.h>
 #include <valhalla/thor/dijkstras.h>
+#include <valhalla/thor/matrix_common.h>
 #include <valhalla/thor/pathinfo.h>
 
 namespace valhalla {
@@ -80,6 +81,8 @@ template <> struct hash<valhalla::thor::PathIntersection> {
 namespace valhalla {
 namespace thor {
 
+class CentroidSearch;
+
 /**
  * TODO: explain this better and more accurately, the claim about minimum isnt quite accurate
  * A best first (dijkstras) path algorithm which given a set of locations, will find the set of paths
@@ -91,6 +94,13 @@ namespace thor {
  */
 class Centroid : public thor::Dijkstras {
 public:
+  /**
+   * @param workers  threads to run the searches of the locations on at the same time, or null to
+   *                 run a single search tracking all of the locations
+   */
+  explicit Centroid(const std::shared_ptr<MatrixWorkers>& workers = {});
+  virtual ~Centroid();
+
   /**
    * Returns a path for each location to a common intersection point (centroid) of all locations paths
    * such that each path is the shortest path to that common intersection point
@@ -170,6 +180,26 @@ protected:
             baldr::GraphReader& reader,
             valhalla::Location& centroid) const;
 
+  /**
+   * Runs a search from each location on the worker threads. The searches share a table of the
+   * edges they settled and each one stops once its costs are beyond the cheapest edge all of them
+   * have reached, which is the edge the single search tracking all of the locations would find.
+   *
+   * @param expansion_type  forward or reverse
+   * @param api             The locations from which the path finding originates
+   * @param reader          Graph reader of the calling thread
+   * @param costings        Per mode costing objects
+   * @param mode            The mode specifying which costing to use
+   * @param centroid        The location where all paths meet
+   * @return The list of paths, one per location, to the centroid
+   */
+  std::vector<std::vector<PathInfo>> ExpandInParallel(const ExpansionType& expansion_type,
+                                                      valhalla::Api& api,
+                                                      baldr::GraphReader& reader,
+                                                      const sif::mode_costing_t& costings,
+                                                      const sif::TravelMode mode,
+                                                      valhalla::Location& centroid);
+
   // the key is the edge id and the value is the label indices for each location
   // we store both directions of the edge to avoid strange uturns at the centroid
   std::unordered_set<PathIntersection> intersections_;
@@ -180,6 +210,10 @@ protected:
 
   // number of paths we are tracking
   uint8_t location_count_;
+
+  // the threads and the searches of the locations when they run in parallel
+  std::shared_ptr<MatrixWorkers> workers_;
+  std::vector<std::unique_ptr<CentroidSearch>> searches_;
 };
 
 } // namespace thor
@@ -0,0 +1,170 @@
+#ifndef VALHALLA_THOR_CONTRACTION_QUERY_H_
+#define VALHALLA_THOR_CONTRACTION_QUERY_H_
+
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <valhalla/baldr/contractionhierarchy.h>
+#include <valhalla/proto/api.pb.h>
+#include <valhalla/sif/edgelabel.h>
+#include <valhalla/thor/pathalgorithm.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Routes over the contraction hierarchy overlay built by mjolnir for default auto costing. Both
+ * searches only go up in rank so even long routes settle very few nodes. The unpacked path is
+ * checked and costed with the real costing afterwards and when it breaks a restriction no path is
+ * returned so that the caller can fall back to one of the other algorithms.
+ */
+class ContractionQuery : public PathAlgorithm {
+public:
+  /**
+   * Constructor.
+   * @param config A config object of key, value pairs
+   */
+  explicit ContractionQuery(const boost::property_tree::ptree& config = {});
+
+  /**
+   * Destructor
+   */
+  virtual ~ContractionQuery();
+
+  /**
+   * Sets the overlay to route over, shared between the workers.
+   * @param hierarchy  the contraction hierarchy, can be empty
+   */
+  void set_hierarchy(const std::shared_ptr<const baldr::ContractionHierarchy>& hierarchy) {
+    hierarchy_ = hierarchy;
+  }
+
+  /**
+   * Whether the overlay can answer a route, which requires default auto costing that doesnt depend
+   * on time.
+   * @param  costing  the costing of the request
+   * @param  origin   Origin location
+   * @param  dest     Destination location
+   * @param  options  the request options
+   * @return true if the overlay was built for this request
+   */
+  bool Supports(const std::string& costing,
+                const valhalla::Location& origin,
+                const valhalla::Location& dest,
+                const Options& options) const;
+
+  /**
+   * Form path between and origin and destination location using
+   * the supplied mode and costing method.
+   * @param  origin  Origin location
+   * @param  dest    Destination location
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  mode_costing  An array of costing methods, one per TravelMode.
+   * @param  mode     Travel mode from the origin.
+   * @return Returns the path edges (and elapsed time/modes at end of
+   *          each edge) or nothing if the path broke a restriction.
+   */
+  std::vector<std::vector<PathInfo>>
+  GetBestPath(valhalla::Location& origin,
+              valhalla::Location& dest,
+              baldr::GraphReader& graphreader,
+              const sif::mode_costing_t& mode_costing,
+              const sif::TravelMode mode,
+              const Options& options = Options::default_instance()) override;
+
+  /**
+   * Returns the name of the algorithm
+   * @return the name of the algorithm
+   */
+  virtual const char* name() const override {
+    return "contraction_hierarchy";
+  }
+
+  /**
+   * Clear the temporary information generated during path construction.
+   */
+  void Clear() override;
+
+  SearchStats Stats() const override {
+    SearchStats stats;
+    stats.labels = forward_.labels.size() + backward_.labels.size();
+    return stats;
+  }
+
+protected:
+  // Cost to reach a node, the arc it was reached by and the path edge the search started from
+  struct label_t {
+    float cost;
+    uint32_t arc;
+    uint32_t seed;
+  };
+
+  // One direction of the search
+  struct search_t {
+    using entry_t = std::pair<float, uint32_t>;
+    std::unordered_map<uint32_t, label_t> labels;
+    std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> queue;
+
+    void clear() {
+      labels.clear();
+      queue = decltype(queue){};
+    }
+  };
+
+  std::shared_ptr<const baldr::ContractionHierarchy> hierarchy_;
+  sif::cost_ptr_t costing_;
+  sif::TravelMode mode_;
+
+  // Serialized default auto costing options, with and without an empty options object
+  std::vector<std::string> default_options_;
+
+  search_t forward_;
+  search_t backward_;
+
+  // The path being checked, each label chaining to the previous one
+  std::vector<baldr::GraphId> edges_;
+  std::vector<sif::EdgeLabel> edgelabels_;
+
+  /**
+   * Seeds one direction of the search from the ends of the location edges.
+   * @param  location     the location
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  forward      whether it is the origin
+   * @param  search       the direction to seed
+   */
+  void Seed(const valhalla::Location& location,
+            baldr::GraphReader& graphreader,
+            const bool forward,
+            search_t& search);
+
+  /**
+   * Settles the next node of one direction of the search.
+   * @param  forward  whether it is the forward search
+   * @param  best     the cheapest meeting so far, updated if this finds a cheaper one
+   * @param  meet     the node of the cheapest meeting
+   */
+  void Expand(const bool forward, float& best, uint32_t& meet);
+
+  /**
+   * Checks the unpacked path with the costing and turns it into path infos.
+   * @param  origin       Origin location
+   * @param  dest         Destination location
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @return the path or nothing if the costing does not allow it
+   */
+  std::vector<PathInfo> FormPath(const valhalla::Location& origin,
+                                 const valhalla::Location& dest,
+                                 baldr::GraphReader& graphreader);
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_CONTRACTION_QUERY_H_
@@ -2,23 +2,31 @@
 #define VALHALLA_THOR_COSTMATRIX_H_
 
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
 #include <utility>
 #include <vector>
 
+#include <boost/property_tree/ptree.hpp>
+
 #include <valhalla/baldr/double_bucket_queue.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphreader.h>
 #include <valhalla/proto/tripcommon.pb.h>
 #include <valhalla/sif/dynamiccost.h>
+#include <valhalla/sif/edgecostcache.h>
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/thor/edgestatus.h>
+#include <valhalla/thor/pathinfo.h>
+#include <valhalla/thor/search_stats.h>
 
 namespace valhalla {
 namespace thor {
 
+class MatrixWorkers;
+
 // These cost thresholds are in addition to the distance thresholds. If either forward or reverse
 // costs exceed the threshold the search is terminated.
 constexpr float kCostThresholdAutoDivisor =
@@ -41,6 +49,9 @@ struct TimeDistance {
   }
 };
 
+// Receives the time distances from a source to all of the targets
+using row_callback_t = std::function<void(uint32_t source, const TimeDistance* row)>;
+
 /**
  * Status of a location. Tracks remaining locations to be found
  * and a threshold or iterations. When threshold goes to 0 expansion
@@ -48,9 +59,10 @@ struct TimeDistance {
  */
 struct LocationStatus {
   int threshold;
+  float cost_bound; // The search stops once its cost exceeds this
   std::set<uint32_t> remaining_locations;
 
-  LocationStatus(const int t) : threshold(t) {
+  LocationStatus(const int t) : threshold(t), cost_bound(kMaxCost) {
   }
 };
 
@@ -90,13 +102,26 @@ public:
   /**
    * Default constructor. Most internal values are set when a query is made so
    * the constructor mainly just sets some internals to a default empty value.
+   * @param  config   Thor configuration, max_reserved_labels_count is split between
+   *                  the max_reserved_locations_count locations whose search
+   *                  buffers are kept between requests. With cache_edge_costs the
+   *                  searches share the edge costs they computed, and keep them
+   *                  for the next requests with the same costing options. With
+   *                  max_active_locations the matrix is made in waves of at most
+   *                  that many sources and targets so that only their searches
+   *                  are in memory at once.
+   * @param  workers  Threads to advance the searches of the locations on, if any.
    */
-  CostMatrix();
+  explicit CostMatrix(const boost::property_tree::ptree& config = {},
+                      const std::shared_ptr<MatrixWorkers>& workers = {});
   ~CostMatrix();
 
   /**
    * Forms a time distance matrix from the set of source locations
-   * to the set of target locations.
+   * to the set of target locations. If there are more sources or targets than
+   * max_active_locations the matrix is filled in block by block, each block
+   * from searches of only its own sources and targets. Locations correlated to
+   * the same edges at the same places are only searched from once.
    * @param  source_location_list  List of source/origin locations.
    * @param  target_location_list  List of target/destination locations.
    * @param  graphreader           Graph reader for accessing routing graph.
@@ -113,13 +138,50 @@ public:
                  const sif::TravelMode mode,
                  const float max_matrix_distance);
 
+  /**
+   * Forms the path of the best connection the last matrix found from one of its sources to one of
+   * its targets out of the labels its searches left behind, so that a route between them does not
+   * have to search again. The searches are only kept when the matrix was made in a single wave.
+   * Connections on a single edge are left to the path algorithms which handle those trivially.
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  origin       The source location, for the percent along its edge the path starts at.
+   * @param  destination  The target location, for the percent along its edge the path ends at.
+   * @param  source       Index of the source in the source locations of the matrix.
+   * @param  target       Index of the target in the target locations of the matrix.
+   * @return the recosted path or an empty one if it could not be formed from the searches
+   */
+  std::vector<PathInfo> FormPath(baldr::GraphReader& graphreader,
+                                 const valhalla::Location& origin,
+                                 const valhalla::Location& destination,
+                                 const uint32_t source,
+                                 const uint32_t target);
+
   /**
    * Clear the temporary information generated during time+distance
-   * matrix construction.
+   * matrix construction. The cached edge costs are kept.
    */
   void Clear();
 
+  /**
+   * How much work the searches of the last matrix did together, the labels they made, the tiles
+   * of their edge statuses and so on.
+   * @return the counts until the next Clear
+   */
+  SearchStats Stats() const;
+
+  /**
+   * Sets the functor which will be called every so often while the searches expand so that a
+   * request can be given up on.
+   * @param  interrupt  the function to be called which should throw, or nullptr for none
+   */
+  void set_interrupt(const std::function<void()>* interrupt) {
+    interrupt_ = interrupt;
+  }
+
 protected:
+  // Called every so often during the searches, it throws to stop them
+  const std::function<void()>* interrupt_;
+
   // Access mode used by the costing method
   uint32_t access_mode_;
 
@@ -129,6 +191,16 @@ protected:
   // Current costing mode
   std::shared_ptr<sif::DynamicCost> costing_;
 
+  // Number of locations whose labels, queues and edge status are kept between
+  // requests and the most labels each of them keeps
+  uint32_t max_reserved_locations_count_;
+  uint32_t max_reserved_labels_count_;
+
+  // Most sources and most targets searched at once, 0 to search all of them together, and the
+  // work of the waves already done
+  uint32_t max_active_locations_;
+  SearchStats wave_stats_;
+
   // Number of source and target locations that can be expanded
   uint32_t source_count_;
   uint32_t remaining_sources_;
@@ -159,6 +231,28 @@ protected:
   // List of best connections found so far
   std::vector<BestCandidate> best_connection_;
 
+  // For each source and target location of the matrix the index of the one searched for in its
+  // place, locations at the same spots share a search
+  std::vector<uint32_t> source_indices_;
+  std::vector<uint32_t> target_indices_;
+
+  // A connection found (or a search exhausted) while the searches run in parallel. The status of
+  // the locations is shared between them so these are applied in order once all searches advanced
+  struct StatusUpdate {
+    uint32_t source;
+    uint32_t target;
+    int threshold;
+  };
+  std::vector<std::vector<StatusUpdate>> source_updates_;
+  std::vector<std::vector<StatusUpdate>> target_updates_;
+
+  // Edges reached by each backward search since the target map was last updated
+  std::vector<std::vector<baldr::GraphId>> target_reached_;
+
+  // The edge costs computed by the searches on each thread, if they are kept
+  bool cache_edge_costs_;
+  std::vector<sif::EdgeCostCache> edge_costs_;
+
   /**
    * Get the cost threshold based on the current mode and the max arc-length distance
    * for that mode.
@@ -166,6 +260,43 @@ protected:
    */
   float GetCostThreshold(const float max_matrix_distance);
 
+  /**
+   * Clears the searches of the locations, keeping their buffers, but not the work of the
+   * waves already done.
+   */
+  void ClearSearches();
+
+  /**
+   * Sums up the work of the searches of the current wave of locations.
+   * @return the counts of the searches in memory
+   */
+  SearchStats SearchesStats() const;
+
+  /**
+   * Forms the time distance matrix of the locations, in waves of up to max_active_locations of
+   * them when it is set.
+   * @param  source_location_list  List of source/origin locations.
+   * @param  target_location_list  List of target/destination locations.
+   * @param  graphreader           Graph reader for accessing routing graph.
+   * @return time/distance from origin index to all other locations
+   */
+  std::vector<TimeDistance>
+  SearchWaves(const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+              const google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+              baldr::GraphReader& graphreader);
+
+  /**
+   * Forms the time distance matrix of a wave of locations by searching from all of them at once.
+   * @param  source_location_list  List of source/origin locations.
+   * @param  target_location_list  List of target/destination locations.
+   * @param  graphreader           Graph reader for accessing routing graph.
+   * @return time/distance from origin index to all other locations
+   */
+  std::vector<TimeDistance>
+  SearchWave(const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+             const google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+             baldr::GraphReader& graphreader);
+
   /**
    * Form the initial time distance matrix given the sources
    * and destinations.
@@ -180,8 +311,12 @@ protected:
    * @param  index        Index of the source location.
    * @param  n            Iteration counter.
    * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  edge_costs   Edge costs of the thread if they are kept.
    */
-  void ForwardSearch(const uint32_t index, const uint32_t n, baldr::GraphReader& graphreader);
+  void ForwardSearch(const uint32_t index,
+                     const uint32_t n,
+                     baldr::GraphReader& graphreader,
+                     sif::EdgeCostCache* edge_costs);
 
   /**
    * Check if the edge on the forward search connects to a reached edge
@@ -192,19 +327,48 @@ protected:
    */
   void CheckForwardConnections(const uint32_t source, const sif::BDEdgeLabel& pred, const uint32_t n);
 
+  /**
+   * Queue a status update for when a connection is found.
+   * @param  updates  Updates of the location whose search found the connection
+   * @param  source   Source index
+   * @param  target   Target index
+   */
+  void QueueStatus(std::vector<StatusUpdate>& updates, const uint32_t source, const uint32_t target);
+
   /**
    * Update status when a connection is found.
-   * @param  source  Source index
+   * @param  update  The connection and the threshold to continue the search with
+   */
+  void UpdateStatus(const StatusUpdate& update);
+
+  /**
+   * Adds the edges the backward search of a target reached since the last call to the
+   * target map so that the forward searches can find them.
    * @param  target  Target index
    */
-  void UpdateStatus(const uint32_t source, const uint32_t target);
+  void AddTargetEdges(const uint32_t target);
+
+  /**
+   * Runs a step of the search of each location, on the worker threads if there are any.
+   * @param  count        Number of locations
+   * @param  graphreader  Graph reader of the calling thread.
+   * @param  step         Advances the search of a location with the given reader and the edge
+   *                      costs of the thread.
+   */
+  void RunSearches(
+      const uint32_t count,
+      baldr::GraphReader& graphreader,
+      const std::function<void(uint32_t, baldr::GraphReader&, sif::EdgeCostCache*)>& step);
 
   /**
    * Iterate the backward search from the target/destination location.
    * @param  index        Index of the target location.
    * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  edge_costs   Edge costs of the thread if they are kept.
    */
-  void BackwardSearch(const uint32_t index, baldr::GraphReader& graphreader);
+  void BackwardSearch(const uint32_t index,
+                      baldr::GraphReader& graphreader,
+                      sif::EdgeCostCache* edge_costs);
 
   /**
    * Sets the source/origin locations. Search expands forward from these
@@ -253,6 +417,9 @@ private:
 
   // Mark each target edge with a list of target indexes that have reached it
   std::unique_ptr<TargetMap> targets_;
+
+  // Threads, each with their own graph reader, helping with the searches
+  std::shared_ptr<MatrixWorkers> workers_;
 };
 
 } // namespace thor
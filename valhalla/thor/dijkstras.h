@@ -2,6 +2,7 @@
 #define VALHALLA_THOR_Dijkstras_H_
 
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <unordered_map>
@@ -14,10 +15,12 @@
 #include <valhalla/baldr/location.h>
 #include <valhalla/baldr/time_info.h>
 #include <valhalla/proto/tripcommon.pb.h>
+#include <valhalla/sif/costkernel.h>
 #include <valhalla/sif/dynamiccost.h>
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/thor/edgestatus.h>
 #include <valhalla/thor/pathalgorithm.h>
+#include <valhalla/thor/search_stats.h>
 
 namespace valhalla {
 namespace thor {
@@ -50,6 +53,15 @@ public:
    */
   virtual void Clear();
 
+  /**
+   * Sets the functor which will be called every so often during the expansion so that the caller
+   * can abort it.
+   * @param  interrupt  the function to be called which should throw, or nullptr for none
+   */
+  void set_interrupt(const std::function<void()>* interrupt) {
+    interrupt_ = interrupt;
+  }
+
   /**
    * Compute the best first graph traversal from a list locations
    * @param expansion_type  What type of expansion should be run
@@ -64,6 +76,20 @@ public:
               const sif::mode_costing_t& costings,
               const sif::TravelMode mode);
 
+  /**
+   * How much work the last expansion did, the labels it made, the tiles of its edge statuses and
+   * so on.
+   * @return the counts until the next Clear
+   */
+  SearchStats Stats() const {
+    SearchStats stats;
+    stats.labels = bdedgelabels_.size() + mmedgelabels_.size();
+    stats.queue_resorts = adjacencylist_.resorts() + mmadjacencylist_.resorts();
+    stats.status_tiles = edgestatus_.size();
+    stats.up_transitions = up_transitions_;
+    return stats;
+  }
+
 protected:
   /**
    * Compute the best first graph traversal from a list of origin locations
@@ -137,14 +163,21 @@ protected:
   // Edge status. Mark edges that are in adjacency list or settled.
   EdgeStatus edgestatus_;
 
-  // when doing timezone differencing a timezone cache speeds up the computation
-  baldr::DateTime::tz_sys_info_cache_t tz_cache_;
+  // Transitions up the hierarchy the expansion took
+  uint64_t up_transitions_ = 0;
 
   // when expanding should we treat each location as its own individual path to track concurrently but
   // separately from the other paths
   bool multipath_;
 
-  // TODO: add an interrupt here so that the caller can abort the main loop externally
+  // when expanding should we track which location the path of each label started from. unlike
+  // multipath the locations share the one expansion so each edge is reached from the closest one
+  bool track_origins_;
+  std::vector<uint32_t> label_origins_; // the location of each label when tracking origins
+  uint32_t expanding_origin_;           // the location of the label whose end node is expanded
+
+  // called every so often during the expansion, it throws to abort the main loop
+  const std::function<void()>* interrupt_;
 
   /**
    * Initialization prior to computing the graph expansion
@@ -178,8 +211,11 @@ protected:
    * @param pred_idx Index in the edge label list of the predecessor edge.
    * @param from_transition Boolean indicating if this expansion is from a transition edge.
    * @param time_info Tracks time offset as the expansion progresses
+   *
+   * kernel_t is the sif::CostKernel the edges are relaxed with, see BidirectionalAStar::Expand.
    */
-  template <const ExpansionType expansion_direction>
+  template <const ExpansionType expansion_direction,
+            typename kernel_t = sif::CostKernel<sif::DynamicCost>>
   void ExpandInner(baldr::GraphReader& graphreader,
                    const baldr::GraphId& node,
                    const typename decltype(Dijkstras::bdedgelabels_)::value_type& pred,
@@ -1,6 +1,8 @@
 #pragma once
 
-#include <unordered_map>
+#include <algorithm>
+#include <vector>
+
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphtile.h>
 
@@ -48,6 +50,10 @@ struct EdgeStatusInfo {
  * edges within arrays for each tile. This allows the path algorithms to get
  * a pointer to the first edge status and iterate that pointer over sequential
  * edges. This reduces the number of map lookups.
+ *
+ * The arrays are found through a small open addressing table of tile slots and
+ * are kept in a pool when cleared so that the next search reuses them rather
+ * than going back to the allocator for every tile it touches.
  */
 class EdgeStatus {
 public:
@@ -60,25 +66,48 @@ public:
   // forbid copying
   EdgeStatus(const EdgeStatus&) = delete;
   EdgeStatus& operator=(const EdgeStatus&) = delete;
-  EdgeStatus(EdgeStatus&&) = default;
-  EdgeStatus& operator=(EdgeStatus&&) = default;
+
+  EdgeStatus(EdgeStatus&& other) {
+    *this = std::move(other);
+  }
+
+  EdgeStatus& operator=(EdgeStatus&& other) {
+    if (this != &other) {
+      release();
+      slots_ = std::move(other.slots_);
+      size_ = other.size_;
+      pool_ = std::move(other.pool_);
+      pooled_ = other.pooled_;
+      other.slots_.clear();
+      other.size_ = 0;
+      other.pool_.clear();
+      other.pooled_ = 0;
+    }
+    return *this;
+  }
 
   /**
    * Destructor. Delete any allocated EdgeStatusInfo arrays.
    */
   ~EdgeStatus() {
-    clear();
+    release();
   }
 
   /**
-   * Clear the EdgeStatusInfo arrays and the edge status map.
+   * Clear the edge status of every tile. The arrays are returned to the pool,
+   * up to a limit, so they can be reused.
    */
   void clear() {
-    // Delete any allocated arrays for tiles within the map.
-    for (auto& iter : edgestatus_) {
-      delete[] iter.second;
+    if (size_ == 0) {
+      return;
+    }
+    for (auto& slot : slots_) {
+      if (slot.statuses) {
+        recycle(slot);
+        slot = {};
+      }
     }
-    edgestatus_.clear();
+    size_ = 0;
   }
 
   /**
@@ -95,17 +124,7 @@ public:
            const uint32_t index,
            const graph_tile_ptr& tile,
            const uint8_t path_id = 0) {
-    assert(path_id <= baldr::kMaxMultiPathId);
-    auto p = edgestatus_.find(edgeid.tile_value() | SHIFT_path_id(path_id));
-    if (p != edgestatus_.end()) {
-      p->second[edgeid.id()] = {set, index};
-    } else {
-      // Tile is not in the map. Add an array of EdgeStatusInfo, sized to
-      // the number of directed edges in the specified tile.
-      auto inserted = edgestatus_.emplace(edgeid.tile_value() | SHIFT_path_id(path_id),
-                                          new EdgeStatusInfo[tile->header()->directededgecount()]);
-      inserted.first->second[edgeid.id()] = {set, index};
-    }
+    *GetPtr(edgeid, tile, path_id) = {set, index};
   }
 
   /**
@@ -118,9 +137,9 @@ public:
    */
   void Update(const baldr::GraphId& edgeid, const EdgeSet set, const uint8_t path_id = 0) {
     assert(path_id <= baldr::kMaxMultiPathId);
-    const auto p = edgestatus_.find(edgeid.tile_value() | SHIFT_path_id(path_id));
-    if (p != edgestatus_.end()) {
-      p->second[edgeid.id()].set_ = static_cast<uint32_t>(set);
+    auto* statuses = find(edgeid.tile_value() | SHIFT_path_id(path_id));
+    if (statuses) {
+      statuses[edgeid.id()].set_ = static_cast<uint32_t>(set);
     } else {
       throw std::runtime_error("EdgeStatus Update on edge not previously set");
     }
@@ -135,8 +154,8 @@ public:
    */
   EdgeStatusInfo Get(const baldr::GraphId& edgeid, const uint8_t path_id = 0) const {
     assert(path_id <= baldr::kMaxMultiPathId);
-    const auto p = edgestatus_.find(edgeid.tile_value() | SHIFT_path_id(path_id));
-    return (p == edgestatus_.end()) ? EdgeStatusInfo() : p->second[edgeid.id()];
+    const auto* statuses = find(edgeid.tile_value() | SHIFT_path_id(path_id));
+    return statuses ? statuses[edgeid.id()] : EdgeStatusInfo();
   }
 
   /**
@@ -152,23 +171,127 @@ public:
   EdgeStatusInfo*
   GetPtr(const baldr::GraphId& edgeid, const graph_tile_ptr& tile, const uint8_t path_id = 0) {
     assert(path_id <= baldr::kMaxMultiPathId);
-    const auto p = edgestatus_.find(edgeid.tile_value() | SHIFT_path_id(path_id));
-    if (p != edgestatus_.end()) {
-      return &p->second[edgeid.id()];
-    } else {
-      // Tile is not in the map. Add an array of EdgeStatusInfo, sized to
+    const uint32_t key = edgeid.tile_value() | SHIFT_path_id(path_id);
+    auto* statuses = find(key);
+    if (!statuses) {
+      // Tile is not in the table. Add an array of EdgeStatusInfo, sized to
       // the number of directed edges in the specified tile.
-      auto inserted = edgestatus_.emplace(edgeid.tile_value() | SHIFT_path_id(path_id),
-                                          new EdgeStatusInfo[tile->header()->directededgecount()]);
-      return &(inserted.first->second)[edgeid.id()];
+      statuses = insert(key, tile->header()->directededgecount());
+    }
+    return &statuses[edgeid.id()];
+  }
+
+  /**
+   * Get the number of tiles, per path id, which have edge statuses.
+   * @return  Returns the number of arrays in use since the last clear.
+   */
+  size_t size() const {
+    return size_;
+  }
+
+protected:
+  // Arrays are allocated in power of 2 sizes so that pooled ones fit other tiles
+  static constexpr uint32_t kSizeClasses = 32;
+  // Most EdgeStatusInfos kept around in the pool after a clear, 16 megs worth
+  static constexpr size_t kMaxPooled = 4194304;
+
+  // A tile slot in the table, which is empty when it has no statuses
+  struct slot_t {
+    uint32_t key;
+    uint32_t size_class;
+    EdgeStatusInfo* statuses;
+  };
+
+  size_t slot_index(const uint32_t key) const {
+    uint32_t hash = key * 0x9E3779B1u;
+    return (hash ^ (hash >> 16)) & (slots_.size() - 1);
+  }
+
+  EdgeStatusInfo* find(const uint32_t key) const {
+    if (slots_.empty()) {
+      return nullptr;
+    }
+    // linear probing until we find the tile or an empty slot
+    for (size_t i = slot_index(key);; i = (i + 1) & (slots_.size() - 1)) {
+      const auto& slot = slots_[i];
+      if (!slot.statuses || slot.key == key) {
+        return slot.statuses;
+      }
+    }
+  }
+
+  EdgeStatusInfo* insert(const uint32_t key, const uint32_t count) {
+    // keep the table at most half full so probing stays short
+    if ((size_ + 1) * 2 > slots_.size()) {
+      std::vector<slot_t> old(std::max<size_t>(slots_.size() * 2, 64), slot_t{});
+      old.swap(slots_);
+      for (const auto& slot : old) {
+        if (slot.statuses) {
+          place(slot);
+        }
+      }
+    }
+
+    // grab an array big enough from the pool or allocate one
+    uint32_t size_class = 0;
+    while ((1u << size_class) < count) {
+      ++size_class;
+    }
+    EdgeStatusInfo* statuses;
+    if (!pool_.empty() && !pool_[size_class].empty()) {
+      statuses = pool_[size_class].back();
+      pool_[size_class].pop_back();
+      pooled_ -= 1u << size_class;
+      std::fill(statuses, statuses + count, EdgeStatusInfo());
+    } else {
+      statuses = new EdgeStatusInfo[1u << size_class];
+    }
+    place({key, size_class, statuses});
+    ++size_;
+    return statuses;
+  }
+
+  void place(const slot_t& slot) {
+    size_t i = slot_index(slot.key);
+    while (slots_[i].statuses) {
+      i = (i + 1) & (slots_.size() - 1);
+    }
+    slots_[i] = slot;
+  }
+
+  void recycle(const slot_t& slot) {
+    const size_t count = 1u << slot.size_class;
+    if (pooled_ + count <= kMaxPooled) {
+      if (pool_.empty()) {
+        pool_.resize(kSizeClasses);
+      }
+      pool_[slot.size_class].push_back(slot.statuses);
+      pooled_ += count;
+    } else {
+      delete[] slot.statuses;
     }
   }
 
-private:
-  // Edge status - keys are the tile Ids (level and tile Id) and the
-  // values are dynamically allocated arrays of EdgeStatusInfo (sized
+  void release() {
+    clear();
+    for (auto& pooled : pool_) {
+      for (auto* statuses : pooled) {
+        delete[] statuses;
+      }
+      pooled.clear();
+    }
+    pooled_ = 0;
+  }
+
+  // Table of tile slots - keys are the tile Ids (level and tile Id) and path
+  // id, the values are dynamically allocated arrays of EdgeStatusInfo (sized
   // based on the directed edge count within the tile).
-  std::unordered_map<uint32_t, EdgeStatusInfo*> edgestatus_;
+  std::vector<slot_t> slots_;
+  size_t size_ = 0;
+
+  // Arrays of EdgeStatusInfo from cleared tiles by size class, waiting to be reused
+  std::vector<std::vector<EdgeStatusInfo*>> pool_;
+  size_t pooled_ = 0;
 };
 
 } // namespace thor
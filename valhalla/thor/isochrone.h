@@ -2,8 +2,10 @@
 #define VALHALLA_THOR_ISOCHRONE_H_
 
 #include <cstdint>
+#include <list>
 #include <map>
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -31,7 +33,8 @@ class Isochrone : public Dijkstras {
 public:
   /**
    * Constructor.
-   * @param config A config object of key, value pairs
+   * @param config A config object of key, value pairs, isochrone_cache_size is the number of
+   *               grids kept for later requests from the same locations with the same costing
    */
   explicit Isochrone(const boost::property_tree::ptree& config = {});
 
@@ -45,14 +48,18 @@ public:
    * Compute an isochrone grid. This creates and populates a lat,lon grid with
    * time taken to reach each grid point. This gridded data is then contoured
    * so it can be output as polygons. Multiple locations are allowed as the
-   * origins - within some reasonable distance from each other.
+   * origins - within some reasonable distance from each other. They are all expanded from at
+   * once so the grid has the time from the closest one and, when the options ask for partition,
+   * which one it was for each cell.
    *
    * @param expansion_type  Which type of expansion to do, forward/reverse/mulitmodal
    * @param api             The request response containing the locations to seed the expansion
    * @param reader          Graph reader to provide access to graph primitives
    * @param costings        Per mode costing objects
    * @param mode            The mode specifying which costing to use
-   * @return                The 2d grid each marked with the minimum time to reach it
+   * @return                The 2d grid each marked with the minimum time to reach it. With the
+   *                        cache on this can be the grid of an earlier request whose contours
+   *                        went at least as far, as long as it has the same resolution
    */
   std::shared_ptr<const midgard::GriddedData<2>> Expand(const ExpansionType& expansion_type,
                                                         valhalla::Api& api,
@@ -60,6 +67,18 @@ public:
                                                         const sif::mode_costing_t& costings,
                                                         const sif::TravelMode mode);
 
+  /**
+   * The part of the grid the last call to Expand returned which the given location reached first,
+   * the other cells are left unreached so the contours of the part stay within it. Without the
+   * partition of grid cells the whole grid is the part of every location.
+   *
+   * @param grid            The grid Expand returned
+   * @param location_index  Which of the locations to get the part of
+   * @return                The grid with only the cells of the location marked
+   */
+  midgard::GriddedData<2> Partition(const midgard::GriddedData<2>& grid,
+                                    const uint32_t location_index) const;
+
 protected:
   // when we expand up to a node we color the cells of the grid that the edge that ends at the
   // node touches
@@ -81,17 +100,49 @@ protected:
   float shape_interval_; // Interval along shape to mark time
   float max_seconds_;
   float max_meters_;
+  float max_distance_; // How far from the locations the isotile reaches, in meters
+  float grid_size_;
+  midgard::GriddedData<2>::value_type max_values_; // Minutes and kilometers of unreached cells
   std::shared_ptr<midgard::GriddedData<2>> isotile_;
+  // which location reached each cell of the isotile first, only set when it is partitioned
+  std::shared_ptr<std::vector<uint32_t>> cell_origins_;
+  size_t origin_metric_; // the metric the cells are given to the location with the least of by
+
+  // A grid kept for requests which only differ in their contours and output options
+  struct cached_isotile_t {
+    std::string key;
+    float grid_size;
+    float max_seconds;
+    float max_meters;
+    std::shared_ptr<const midgard::GriddedData<2>> isotile;
+    std::shared_ptr<std::vector<uint32_t>> cell_origins;
+  };
+  size_t cache_size_;
+  std::list<cached_isotile_t> cache_; // most recently used first
 
   /**
-   * Constructs the isotile - 2-D gridded data containing the time
-   * to get to each lat,lng tile.
+   * What the expansion of the request depends on, everything but the contours and how they
+   * are output.
+   * @param expansion_type  Which type of expansion to do
+   * @param api             The request
+   */
+  static std::string CacheKey(const ExpansionType& expansion_type, const valhalla::Api& api);
+
+  /**
+   * Sets how far to expand and the resolution of the isotile, everything a cached isotile is
+   * looked up by, without making the isotile itself.
    * @param  multimodal  True if the route type is multimodal.
    * @param  api         Request information
-   * @param  locations   List of origin locations.
    * @param  mode        Travel mode
    */
-  void ConstructIsoTile(const bool multimodal, const valhalla::Api& api, const sif::TravelMode mode);
+  void SetLimits(const bool multimodal, const valhalla::Api& api, const sif::TravelMode mode);
+
+  /**
+   * Constructs the isotile - 2-D gridded data containing the time
+   * to get to each lat,lng tile - with the limits SetLimits set.
+   * @param  api         Request information
+   */
+  void ConstructIsoTile(const valhalla::Api& api);
 
   /**
    * Updates the isotile using the edge information from the predecessor edge
@@ -118,6 +169,14 @@ protected:
                                  const midgard::PointLL& to,
                                  float seconds,
                                  float meters);
+
+  /**
+   * Sets the value of a cell of the isotile if it is less than what it has, with the partition a
+   * cell whose metric gets less is given to the location being expanded from
+   * @param tile_id  The cell
+   * @param value    Minutes and kilometers to reach it
+   */
+  void SetIfLessThan(const int tile_id, const midgard::GriddedData<2>::value_type& value);
 };
 
 } // namespace thor
@@ -0,0 +1,103 @@
+#ifndef VALHALLA_THOR_MATRIX_CACHE_H_
+#define VALHALLA_THOR_MATRIX_CACHE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+#include <valhalla/midgard/lru_cache.h>
+#include <valhalla/proto/options.pb.h>
+#include <valhalla/thor/costmatrix.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Remembers the times and distances between pairs of locations that optimized_route found with
+ * its matrix so that a client re-optimizing after adding a stop to the previous request only has
+ * the row and column of the new stop computed. Pairs are keyed by the edges the locations were
+ * correlated to, the costing options and the bucket the date and time of the request falls in.
+ */
+class MatrixCache {
+public:
+  /**
+   * @param capacity        how many pairs of locations to remember, 0 to not cache them
+   * @param bucket_minutes  requests whose dates and times are in the same bucket of this many
+   *                        minutes share their pairs
+   */
+  MatrixCache(size_t capacity, uint32_t bucket_minutes)
+      : bucket_minutes_(std::max(bucket_minutes, 1u)), pairs_(capacity) {
+  }
+
+  /**
+   * The part of the keys which is the same for all of the pairs of a request.
+   * @param options  the options of the request
+   * @return the costing options and the bucket of the date and time
+   */
+  std::string context(const Options& options) const {
+    std::string key = std::to_string(static_cast<int>(options.costing())) + ':' +
+                      std::to_string(static_cast<int>(options.date_time_type())) + ':';
+    // YYYY-MM-DDThh:mm with the minutes rounded down to the bucket
+    const auto& date_time =
+        options.locations_size() && !options.locations(0).date_time().empty()
+            ? options.locations(0).date_time()
+            : options.date_time();
+    if (date_time.size() >= 16) {
+      auto minutes = std::stoi(date_time.substr(11, 2)) * 60 + std::stoi(date_time.substr(14, 2));
+      key += date_time.substr(0, 10) + ':' + std::to_string(minutes / bucket_minutes_);
+    }
+    key += ':' + options.costing_options(static_cast<int>(options.costing())).SerializeAsString();
+    return key;
+  }
+
+  /**
+   * The part of the keys which is the same for all of the pairs a location is in.
+   * @param location  the location after it was correlated to the graph
+   * @return the edges and where along them the location is
+   */
+  static std::string location(const valhalla::Location& location) {
+    std::string key;
+    for (const auto& edge : location.path_edges()) {
+      key += std::to_string(edge.graph_id()) + ',' + std::to_string(edge.percent_along()) + ',' +
+             std::to_string(edge.begin_node()) + std::to_string(edge.end_node()) + ';';
+    }
+    return key;
+  }
+
+  bool find(const std::string& context,
+            const std::string& from,
+            const std::string& to,
+            TimeDistance& time_distance) {
+    return pairs_.find(key(context, from, to), time_distance);
+  }
+
+  void insert(const std::string& context,
+              const std::string& from,
+              const std::string& to,
+              const TimeDistance& time_distance) {
+    pairs_.insert(key(context, from, to), time_distance);
+  }
+
+  size_t capacity() const {
+    return pairs_.capacity();
+  }
+
+  size_t hits() const {
+    return pairs_.hits();
+  }
+
+protected:
+  // the locations end in a ; so only the destination has to be told apart from the origin
+  static std::string
+  key(const std::string& context, const std::string& from, const std::string& to) {
+    return from + '>' + to + context;
+  }
+
+  uint32_t bucket_minutes_;
+  midgard::lru_cache_t<std::string, TimeDistance> pairs_;
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_MATRIX_CACHE_H_
@@ -1,13 +1,21 @@
 #ifndef VALHALLA_THOR_MATRIX_COMMON_H_
 #define VALHALLA_THOR_MATRIX_COMMON_H_
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <exception>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <boost/property_tree/ptree.hpp>
+
 #include <valhalla/baldr/double_bucket_queue.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphreader.h>
@@ -40,6 +48,65 @@ struct Destination {
   }
 };
 
+/**
+ * Threads which, along with the calling thread, take the locations of a matrix one at a time to
+ * run a step of their searches. Each thread has its own graph reader and is identified by a slot,
+ * 0 being the calling thread, so that per thread search state can be kept by the caller. The
+ * matrix algorithms of a worker share one set of threads so it can only run one matrix at a time.
+ */
+class MatrixWorkers {
+public:
+  // Runs the step for a location in the given thread slot with the reader of that thread
+  using step_t = std::function<void(uint32_t, uint32_t, baldr::GraphReader&)>;
+
+  /**
+   * Starts the threads.
+   * @param  thread_count   Number of threads besides the calling one.
+   * @param  reader_config  Mjolnir configuration for the graph readers of the threads.
+   */
+  MatrixWorkers(const uint32_t thread_count, const boost::property_tree::ptree& reader_config);
+  ~MatrixWorkers();
+
+  /**
+   * Runs the step for every location and returns when all of them are done. Exceptions thrown by
+   * the step are rethrown here.
+   * @param  count        Number of locations.
+   * @param  graphreader  Graph reader of the calling thread.
+   * @param  step         The step to run.
+   */
+  void Run(const uint32_t count, baldr::GraphReader& graphreader, const step_t& step);
+
+  /**
+   * Number of thread slots, including the one of the calling thread.
+   */
+  uint32_t size() const {
+    return threads_.size() + 1;
+  }
+
+  /**
+   * Trims the caches of the readers of the threads when they get too big.
+   */
+  void Trim();
+
+protected:
+  std::vector<std::unique_ptr<baldr::GraphReader>> readers_;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+
+  // the step being run, the next location to take and the threads still working on it
+  const step_t* step_ = nullptr;
+  uint32_t count_ = 0;
+  std::atomic<uint64_t> generation_{0};
+  std::atomic<uint32_t> next_{0};
+  std::atomic<uint32_t> busy_{0};
+  std::exception_ptr error_;
+
+  void Take(const uint32_t slot, baldr::GraphReader& graphreader);
+  void Work(const uint32_t slot, baldr::GraphReader& graphreader);
+};
+
 } // namespace thor
 } // namespace valhalla
 
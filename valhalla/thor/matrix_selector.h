@@ -0,0 +1,109 @@
+#ifndef VALHALLA_THOR_MATRIX_SELECTOR_H_
+#define VALHALLA_THOR_MATRIX_SELECTOR_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <valhalla/proto/tripcommon.pb.h>
+#include <valhalla/sif/dynamiccost.h>
+
+namespace valhalla {
+namespace thor {
+
+// The matrix algorithms the selector can pick from
+enum class MatrixAlgorithm : uint8_t {
+  kCostMatrix = 0,
+  kTimeDistanceMatrix = 1,
+  kBucketMatrix = 2,
+  kTimeDistanceBSSMatrix = 3
+};
+
+/**
+ * Name of the algorithm as used in the configuration and the response.
+ * @param  algorithm  The matrix algorithm.
+ */
+const std::string& to_string(const MatrixAlgorithm algorithm);
+
+// The algorithm picked for a request and how long it is expected to take
+struct MatrixEstimate {
+  MatrixAlgorithm algorithm;
+  float cost; // estimated milliseconds
+};
+
+/**
+ * Picks the matrix algorithm expected to be the fastest for a request by estimating the work of
+ * each of them from the number of locations, the area they spread over and the travel mode.
+ *
+ * A search which has to reach locations up to a distance r away settles the edges of an area of
+ * about r^2, except for the drive modes of CostMatrix and BucketMatrix whose hierarchy limits only
+ * let the search grow along the highways beyond hierarchy_radius. TimeDistanceMatrix runs one such
+ * search per location of the smaller side, reaching across the whole bounding box, whereas the
+ * bidirectional algorithms run one per location which only reaches about half of the way. Every
+ * algorithm then has a cost per search, per unit of expansion and per source target pair, in
+ * milliseconds, which are meant to be calibrated against the matrix timings of a deployment.
+ */
+class MatrixSelector {
+public:
+  /**
+   * Constructor.
+   * @param  config  Thor configuration, the coefficients are read from its matrix_cost_model.
+   *                 BucketMatrix is only a candidate when it has coefficients configured.
+   */
+  explicit MatrixSelector(const boost::property_tree::ptree& config = {});
+
+  /**
+   * Estimates the cost of running the algorithm for the locations.
+   * @param  algorithm            The matrix algorithm.
+   * @param  sources              Source locations.
+   * @param  targets              Target locations.
+   * @param  mode                 Travel mode of the request.
+   * @param  max_matrix_distance  Maximum distance the searches go for the costing.
+   * @return estimated milliseconds
+   */
+  float Estimate(const MatrixAlgorithm algorithm,
+                 const google::protobuf::RepeatedPtrField<valhalla::Location>& sources,
+                 const google::protobuf::RepeatedPtrField<valhalla::Location>& targets,
+                 const sif::TravelMode mode,
+                 const float max_matrix_distance) const;
+
+  /**
+   * Picks the candidate with the lowest estimate for the locations. Transit only has
+   * TimeDistanceMatrix as a candidate since the bidirectional algorithms dont support it.
+   * @param  sources              Source locations.
+   * @param  targets              Target locations.
+   * @param  mode                 Travel mode of the request.
+   * @param  max_matrix_distance  Maximum distance the searches go for the costing.
+   * @return the picked algorithm and its estimate
+   */
+  MatrixEstimate Select(const google::protobuf::RepeatedPtrField<valhalla::Location>& sources,
+                        const google::protobuf::RepeatedPtrField<valhalla::Location>& targets,
+                        const sif::TravelMode mode,
+                        const float max_matrix_distance) const;
+
+protected:
+  // The coefficients of an algorithm
+  struct Coefficients {
+    float search;    // per search
+    float expansion; // per square kilometer of expansion
+    float pair;      // per source target pair
+  };
+
+  // Distance past which the hierarchy limits keep the drive searches to the highways
+  float hierarchy_radius_;
+
+  // The coefficients of each algorithm, the ones which arent configured use those of the
+  // algorithm they search like
+  std::unordered_map<uint8_t, Coefficients> coefficients_;
+
+  // The algorithms Select picks from
+  std::vector<MatrixAlgorithm> candidates_;
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_MATRIX_SELECTOR_H_
@@ -20,6 +20,7 @@
 #include <valhalla/thor/edgestatus.h>
 #include <valhalla/thor/pathalgorithm.h>
 #include <valhalla/thor/pathinfo.h>
+#include <valhalla/thor/transit_timetable.h>
 
 namespace valhalla {
 namespace thor {
@@ -73,6 +74,15 @@ public:
    */
   void Clear() override;
 
+  SearchStats Stats() const override {
+    SearchStats stats;
+    stats.labels = edgelabels_.size();
+    stats.queue_resorts = adjacencylist_.resorts();
+    stats.status_tiles = edgestatus_.size();
+    stats.up_transitions = up_transitions(hierarchy_limits_);
+    return stats;
+  }
+
 protected:
   // Current walking distance.
   uint32_t walking_distance_;
@@ -93,6 +103,9 @@ protected:
   std::unordered_map<std::string, uint32_t> operators_;
   std::unordered_set<uint32_t> processed_tiles_;
 
+  // The departures of the lines the search took on the day it travels
+  TransitTimetable timetable_;
+
   // Hierarchy limits.
   std::vector<sif::HierarchyLimits> hierarchy_limits_;
 
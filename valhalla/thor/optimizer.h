@@ -3,7 +3,9 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <random>
+#include <string>
 #include <vector>
 
 namespace valhalla {
@@ -23,6 +25,19 @@ constexpr float kCoolingRate = 0.93f;
 //            a start and end location.
 enum AlterationType { kRotate, kReverse };
 
+// Longest run of consecutive locations the local search moves elsewhere in the tour at once
+constexpr uint32_t kMaxOrOptSegment = 3;
+
+// Which method orders the locations
+enum class OptimizerAlgorithm { kAnnealing, kLocalSearch };
+
+/**
+ * Parses the name of an optimizer algorithm, annealing or local_search.
+ * @param  name  Name of the algorithm.
+ * @return Returns the algorithm, throws if there is none by that name.
+ */
+OptimizerAlgorithm ParseOptimizerAlgorithm(const std::string& name);
+
 // Simple structure with 3 values describing a possible tour alteration
 struct TourAlteration {
   uint32_t start;     // Index of 1st location
@@ -49,6 +64,26 @@ public:
    */
   std::vector<uint32_t> Solve(const uint32_t count, const std::vector<float>& costs);
 
+  // Runs the function for each of the given number of restarts and returns when all are done, the
+  // restarts do not depend on each other so they can be run on other threads
+  using restart_runner_t = std::function<void(uint32_t, const std::function<void(uint32_t)>&)>;
+
+  /**
+   * Optimize the tour with 2-opt and or-opt local search instead of annealing. The first start is
+   * the nearest neighbor tour and the others are random ones, each restart has its own random
+   * numbers seeded by its index so the result is the same no matter how the restarts are run.
+   * The first location (origin) and last location (destination) remain fixed in the tour.
+   * @param  count     Number of locations.
+   * @param  costs     2-D cost matrix.
+   * @param  restarts  Number of starting tours to search from.
+   * @param  run       Runs the restarts, each one after the other if there is none.
+   * @return Returns the least costly of the tours the restarts ended up with.
+   */
+  std::vector<uint32_t> SolveLocalSearch(const uint32_t count,
+                                         const std::vector<float>& costs,
+                                         const uint32_t restarts,
+                                         const restart_runner_t& run = {});
+
   /**
    * Seed the random number generator. This is used by tests to create a
    * repeatable sequence.
@@ -108,6 +143,14 @@ protected:
    */
   float TourCost(const std::vector<float>& costs, const std::vector<uint32_t>& tour) const;
 
+  /**
+   * Improves the tour with the best 2-opt or or-opt move until none of them makes it any cheaper.
+   * Reversals are costed in both directions since the costs need not be symmetric.
+   * @param  costs  2-D cost matrix.
+   * @param  tour   Tour to improve in place.
+   */
+  void LocalSearch(const std::vector<float>& costs, std::vector<uint32_t>& tour) const;
+
   // ------------------------ Convenience methods (inline) ---------------- //
 
   /**
@@ -14,6 +14,7 @@
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/thor/edgestatus.h>
 #include <valhalla/thor/pathinfo.h>
+#include <valhalla/thor/search_stats.h>
 
 namespace valhalla {
 namespace thor {
@@ -75,6 +76,14 @@ public:
    */
   virtual void Clear() = 0;
 
+  /**
+   * How much work the last search did, the labels it made, the tiles of its edge statuses etc.
+   * @return the counts until the next Clear
+   */
+  virtual SearchStats Stats() const {
+    return {};
+  }
+
   /**
    * Set a callback that will throw when the path computation should be aborted
    * @param interrupt_callback  the function to periodically call to see if
@@ -140,9 +149,6 @@ protected:
   // for tracking the expansion of the algorithm visually
   expansion_callback_t expansion_callback_;
 
-  // when doing timezone differencing a timezone cache speeds up the computation
-  baldr::DateTime::tz_sys_info_cache_t tz_cache_;
-
   /**
    * Check for path completion along the same edge. Edge ID in question
    * is along both an origin and destination and origin shows up at the
@@ -0,0 +1,69 @@
+#ifndef VALHALLA_THOR_SEARCH_STATS_H_
+#define VALHALLA_THOR_SEARCH_STATS_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <valhalla/proto/api.pb.h>
+#include <valhalla/sif/hierarchylimits.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * How much work a search did, which is what makes a request slow when its path is not long. The
+ * counts come from what the algorithms keep anyway, the labels they made, the tiles of their edge
+ * statuses and the up transitions of their hierarchy limits, so asking for them is cheap and does
+ * not slow the search itself down.
+ */
+struct SearchStats {
+  uint64_t labels = 0;         // edge labels made
+  uint64_t queue_resorts = 0;  // times the adjacency lists moved labels out of their overflow
+  uint64_t status_tiles = 0;   // tiles the edge statuses were allocated for
+  uint64_t up_transitions = 0; // transitions taken up the hierarchy
+
+  SearchStats& operator+=(const SearchStats& other) {
+    labels += other.labels;
+    queue_resorts += other.queue_resorts;
+    status_tiles += other.status_tiles;
+    up_transitions += other.up_transitions;
+    return *this;
+  }
+
+  /**
+   * Adds the counts to the statistics of a request.
+   * @param prefix  what to put in front of the name of each count
+   * @param api     the request
+   */
+  void AddTo(const std::string& prefix, Api& api) const {
+    auto* statistics = api.mutable_info()->mutable_statistics();
+    for (const auto& count : {std::make_pair("labels", labels),
+                              std::make_pair("queue_resorts", queue_resorts),
+                              std::make_pair("status_tiles", status_tiles),
+                              std::make_pair("up_transitions", up_transitions)}) {
+      auto* stat = statistics->Add();
+      stat->set_name(prefix + count.first);
+      stat->set_value(count.second);
+    }
+  }
+};
+
+/**
+ * Sums the transitions taken up from each level of the hierarchy.
+ * @param limits  the hierarchy limits of a search, one per level
+ * @return the number of up transitions
+ */
+inline uint64_t up_transitions(const std::vector<sif::HierarchyLimits>& limits) {
+  uint64_t count = 0;
+  for (const auto& limit : limits) {
+    count += limit.up_transition_count;
+  }
+  return count;
+}
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_SEARCH_STATS_H_
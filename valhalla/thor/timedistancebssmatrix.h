@@ -15,6 +15,7 @@
 #include <valhalla/sif/dynamiccost.h>
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/thor/astarheuristic.h>
+#include <valhalla/thor/bss_stations.h>
 #include <valhalla/thor/costmatrix.h>
 #include <valhalla/thor/edgestatus.h>
 #include <valhalla/thor/matrix_common.h>
@@ -124,6 +125,11 @@ protected:
   // The cost threshold being used for the currently executing query
   float current_cost_threshold_;
 
+  // Bike share stations around the locations, they are kept over the one to many searches of a
+  // matrix, and the least cost of walking from one of them to a location
+  BssStations stations_;
+  float station_walk_cost_;
+
   // A* heuristic
   AStarHeuristic pedestrian_astarheuristic_;
   AStarHeuristic bicycle_astarheuristic_;
@@ -200,6 +206,14 @@ protected:
    */
   float GetCostThreshold(const float max_matrix_distance) const;
 
+  /**
+   * Get the least cost of walking to one of the locations from the closest bike share station.
+   * @param  graphreader   Graph reader for accessing routing graph.
+   * @param  locations     The locations the search has to get to.
+   */
+  float GetStationWalkCost(baldr::GraphReader& graphreader,
+                           const google::protobuf::RepeatedPtrField<valhalla::Location>& locations);
+
   /**
    * Sets the origin for a many to one time+distance matrix computation.
    * @param  graphreader   Graph reader for accessing routing graph.
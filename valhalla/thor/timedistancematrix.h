@@ -28,8 +28,10 @@ public:
   /**
    * Default constructor. Most internal values are set when a query is made so
    * the constructor mainly just sets some internals to a default empty value.
+   * @param  workers  Threads to run the searches of SourceToTarget on, if any.
    */
-  TimeDistanceMatrix();
+  explicit TimeDistanceMatrix(const std::shared_ptr<MatrixWorkers>& workers = {});
+  ~TimeDistanceMatrix();
 
   /**
    * One to many time and distance cost matrix. Computes time and distance
@@ -88,13 +90,17 @@ public:
 
   /**
    * Forms a time distance matrix from the set of source locations
-   * to the set of target locations.
+   * to the set of target locations. The destinations are set up once and
+   * the one to many (or many to one) searches share them.
    * @param  source_location_list  List of source/origin locations.
    * @param  target_location_list  List of target/destination locations.
    * @param  graphreader           Graph reader for accessing routing graph.
    * @param  mode_costing          Costing methods.
    * @param  mode                  Travel mode to use.
    * @param  max_matrix_distance   Maximum arc-length distance for current mode.
+   * @param  on_row                If set, gets the rows in order instead of them being returned.
+   *                               With one to many searches a row is handed over as soon as it
+   *                               and the ones before it are done, possibly on a matrix thread.
    * @return time/distance from origin index to all other locations
    */
   std::vector<TimeDistance>
@@ -103,7 +109,8 @@ public:
                  baldr::GraphReader& graphreader,
                  const sif::mode_costing_t& mode_costing,
                  const sif::TravelMode mode,
-                 const float max_matrix_distance);
+                 const float max_matrix_distance,
+                 const row_callback_t& on_row = {});
 
   /**
    * Clear the temporary information generated during time+distance
@@ -127,7 +134,8 @@ protected:
 
   // List of edges that have potential destinations. Each "marked" edge
   // has a vector of indexes into the destinations vector
-  std::unordered_map<uint64_t, std::vector<uint32_t>> dest_edges_;
+  class DestEdges;
+  std::unique_ptr<DestEdges> dest_edges_;
 
   // Vector of edge labels (requires access by index).
   std::vector<sif::EdgeLabel> edgelabels_;
@@ -142,6 +150,40 @@ protected:
 
   sif::TravelMode mode_;
 
+  // The labels, adjacency list and edge status of the searches of each thread of SourceToTarget
+  // and the threads other than the calling one
+  std::vector<std::unique_ptr<TimeDistanceMatrix>> searches_;
+  std::shared_ptr<MatrixWorkers> workers_;
+
+  /**
+   * Runs the one to many search from the origin to the destinations that are already set.
+   * @param  origin       Location of the origin.
+   * @param  locations    List of locations.
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @return time/distance from origin index to all other locations
+   */
+  std::vector<TimeDistance>
+  SearchOneToMany(const valhalla::Location& origin,
+                  const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+                  baldr::GraphReader& graphreader);
+
+  /**
+   * Runs the many to one search from the destination to the locations that are already set.
+   * @param  dest         Location of the destination.
+   * @param  locations    List of locations.
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @return time/distance to the destination index from all other locations
+   */
+  std::vector<TimeDistance>
+  SearchManyToOne(const valhalla::Location& dest,
+                  const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+                  baldr::GraphReader& graphreader);
+
+  /**
+   * Clear the labels, adjacency list and edge status of the last search.
+   */
+  void ClearSearch();
+
   /**
    * Expand from the node along the forward search path. Immediately expands
    * from the end node of any transition edge (so no transition edges are added
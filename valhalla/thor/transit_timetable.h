@@ -0,0 +1,73 @@
+#ifndef VALHALLA_THOR_TRANSIT_TIMETABLE_H_
+#define VALHALLA_THOR_TRANSIT_TIMETABLE_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphtile.h>
+#include <valhalla/baldr/transitdeparture.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * The departures of the transit lines a search touches on the day it travels. The first time a
+ * line is looked at its departures which run that day, and have the access the costing needs, are
+ * copied out of the tile and the frequency based ones are expanded into each of their departures.
+ * After that finding the next departure along the line is a binary search rather than a scan over
+ * every departure of the line checking its schedule.
+ */
+class TransitTimetable {
+public:
+  /**
+   * Forget the lines of the previous day and set the day to find the departures of.
+   * @param  day               Days since the tile creation date
+   * @param  dow               Day of week (see graphconstants.h)
+   * @param  date_before_tile  Is the date before the tile creation date?
+   * @param  wheelchair        Only keep departures with wheelchair access
+   * @param  bicycle           Only keep departures with bicycle access
+   */
+  void Reset(const uint32_t day,
+             const uint32_t dow,
+             const bool date_before_tile,
+             const bool wheelchair,
+             const bool bicycle);
+
+  /**
+   * Forget the lines and the day.
+   */
+  void Clear() {
+    lines_.clear();
+  }
+
+  /**
+   * Get the next departure along a line, the same one GraphTile::GetNextDeparture finds.
+   * @param  tile          The transit tile of the line
+   * @param  lineid        Transit Line Id
+   * @param  current_time  Current time (seconds from midnight)
+   * @return the departure or nullptr if there are none left that day. It stays valid until the
+   *         timetable is reset or cleared.
+   */
+  const baldr::TransitDeparture* GetNextDeparture(const baldr::graph_tile_ptr& tile,
+                                                  const uint32_t lineid,
+                                                  const uint32_t current_time);
+
+protected:
+  // The departures of a line on the day, sorted by departure time
+  const std::vector<baldr::TransitDeparture>& Line(const baldr::graph_tile_ptr& tile,
+                                                   const uint32_t lineid);
+
+  uint32_t day_ = 0;
+  uint32_t dow_ = 0;
+  bool date_before_tile_ = false;
+  bool wheelchair_ = false;
+  bool bicycle_ = false;
+  std::unordered_map<baldr::GraphId, std::vector<baldr::TransitDeparture>> lines_;
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_TRANSIT_TIMETABLE_H_
@@ -61,6 +61,15 @@ public:
    */
   void Clear() override;
 
+  SearchStats Stats() const override {
+    SearchStats stats;
+    stats.labels = edgelabels_.size();
+    stats.queue_resorts = adjacencylist_.resorts();
+    stats.status_tiles = edgestatus_.size();
+    stats.up_transitions = up_transitions(hierarchy_limits_);
+    return stats;
+  }
+
   /**
    * Returns the name of the algorithm
    * @return the name of the algorithm
@@ -82,6 +91,14 @@ public:
     max_label_count_ = max_count;
   }
 
+  /**
+   * Set the landmark distances the A* heuristic is tightened with.
+   * @param  landmarks  The landmark distances, none to only use the straight line distance.
+   */
+  void set_landmarks(const std::shared_ptr<const baldr::Landmarks>& landmarks) {
+    astarheuristic_.SetLandmarks(landmarks);
+  }
+
 protected:
   /**
    * Initializes the hierarchy limits, A* heuristic, and adjacency list.
@@ -123,7 +140,8 @@ protected:
                           const graph_tile_ptr& tile,
                           const baldr::TimeInfo& time_info,
                           const valhalla::Location& destination,
-                          std::pair<int32_t, float>& best_path);
+                          std::pair<int32_t, float>& best_path,
+                          float end_node_dist);
 
   /**
    * Modify hierarchy limits based on distance between origin and destination
@@ -156,6 +174,14 @@ protected:
    */
   uint32_t SetDestination(baldr::GraphReader& graphreader, const valhalla::Location& dest);
 
+  /**
+   * Set the nodes at both ends of the destination edge(s) as the targets of the landmark
+   * lower bounds of the A* heuristic.
+   * @param   graphreader  Graph tile reader.
+   * @param   dest         Location information of the destination.
+   */
+  void InitLandmarks(baldr::GraphReader& graphreader, const valhalla::Location& dest);
+
   /**
    * Form the path from the adjacency list. Recovers the path from the
    * destination backwards towards the origin (using predecessor information)
@@ -192,6 +218,9 @@ protected:
   // Access mode used by the costing method
   uint32_t access_mode_;
 
+  // Number of coarse buckets the adjacency list splits its overflow into
+  uint32_t overflow_bucket_count_;
+
   // Adjacency list - approximate double bucket sort
   baldr::DoubleBucketQueue<sif::BDEdgeLabel> adjacencylist_;
 };
@@ -2,6 +2,7 @@
 #define __VALHALLA_THOR_SERVICE_H__
 
 #include <cstdint>
+#include <memory>
 #include <tuple>
 #include <vector>
 
@@ -21,9 +22,18 @@
 #include <valhalla/thor/astar_bss.h>
 #include <valhalla/thor/attributes_controller.h>
 #include <valhalla/thor/bidirectional_astar.h>
+#include <valhalla/thor/bucketmatrix.h>
 #include <valhalla/thor/centroid.h>
+#include <valhalla/thor/contraction_query.h>
+#include <valhalla/thor/costmatrix.h>
 #include <valhalla/thor/isochrone.h>
+#include <valhalla/thor/matrix_cache.h>
+#include <valhalla/thor/matrix_common.h>
+#include <valhalla/thor/matrix_selector.h>
 #include <valhalla/thor/multimodal.h>
+#include <valhalla/thor/optimizer.h>
+#include <valhalla/thor/timedistancebssmatrix.h>
+#include <valhalla/thor/timedistancematrix.h>
 #include <valhalla/thor/triplegbuilder.h>
 #include <valhalla/thor/unidirectional_astar.h>
 #include <valhalla/tyr/actor.h>
@@ -38,7 +48,12 @@ void run_service(const boost::property_tree::ptree& config);
 
 class thor_worker_t : public service_worker_t {
 public:
-  enum SOURCE_TO_TARGET_ALGORITHM { SELECT_OPTIMAL = 0, COST_MATRIX = 1, TIME_DISTANCE_MATRIX = 2 };
+  enum SOURCE_TO_TARGET_ALGORITHM {
+    SELECT_OPTIMAL = 0,
+    COST_MATRIX = 1,
+    TIME_DISTANCE_MATRIX = 2,
+    BUCKET_MATRIX = 3
+  };
   thor_worker_t(const boost::property_tree::ptree& config,
                 const std::shared_ptr<baldr::GraphReader>& graph_reader = {});
   virtual ~thor_worker_t();
@@ -56,7 +71,9 @@ public:
                                  const baldr::GraphId& out_edge);
 
   void route(Api& request);
-  std::string matrix(Api& request);
+  // with a writer the json is handed to it a row at a time, as soon as the rows are known, and
+  // nothing is returned
+  std::string matrix(Api& request, const std::function<void(const std::string&)>* write = nullptr);
   void optimized_route(Api& request);
   std::string isochrones(Api& request);
   void trace_route(Api& request);
@@ -65,10 +82,44 @@ public:
   void centroid(Api& request);
   void status(Api& request) const;
 
+  // share the map matching candidate grids and paths between candidates of another worker so
+  // workers on different threads only index each bin and route between each candidates once
+  void share_matcher_caches(const thor_worker_t& other) {
+    matcher_factory.ShareCandidateGrids(other.matcher_factory);
+    matcher_factory.ShareTransitionCache(other.matcher_factory);
+  }
+
   void set_interrupt(const std::function<void()>* interrupt) override;
 
 protected:
-  std::vector<std::vector<thor::PathInfo>> get_path(PathAlgorithm* path_algorithm,
+  // The path algorithms, graph reader and costing the legs of a route are found with, either the
+  // worker's own or those of one of its route threads
+  struct leg_search_t {
+    baldr::GraphReader& reader;
+    sif::mode_costing_t& mode_costing;
+    TimeDepForward& timedep_forward;
+    BidirectionalAStar& bidir_astar;
+    ContractionQuery& contraction_query;
+  };
+
+  // The path algorithms of a route thread, the other ones are never used for legs found on threads
+  struct leg_algorithms_t {
+    explicit leg_algorithms_t(const boost::property_tree::ptree& config)
+        : timedep_forward(config), bidir_astar(config), contraction_query(config) {
+    }
+    TimeDepForward timedep_forward;
+    BidirectionalAStar bidir_astar;
+    ContractionQuery contraction_query;
+  };
+
+  // The paths of a leg found ahead of time and the name of the algorithm which found them
+  struct found_leg_t {
+    std::vector<std::vector<thor::PathInfo>> paths;
+    std::string algorithm;
+  };
+
+  std::vector<std::vector<thor::PathInfo>> get_path(const leg_search_t& search,
+                                                    PathAlgorithm*& path_algorithm,
                                                     Location& origin,
                                                     Location& destination,
                                                     const std::string& costing,
@@ -78,6 +129,28 @@ protected:
                                           const Location& origin,
                                           const Location& destination,
                                           const Options& options);
+  thor::PathAlgorithm* get_time_invariant_path_algorithm(const leg_search_t& search,
+                                                         const std::string& routetype,
+                                                         const Location& origin,
+                                                         const Location& destination,
+                                                         const Options& options);
+  /**
+   * Finds the legs of a depart at route on the route threads when the route can be split into
+   * runs of legs which dont depend on each other, a run ending at every location which isnt a
+   * through location. Nothing is found, and the legs are left to be found one after the other,
+   * when times have to be carried from leg to leg, when the route has a single leg or when any
+   * leg fails or needs a second pass, since those may change the locations the next leg starts
+   * from.
+   * @param locations  The locations of the route, the through locations get the edges their
+   *                   legs were restricted to as if the legs had been found in order
+   * @param costing    The costing of the route
+   * @param options    The request options
+   * @return the paths of every leg or nothing
+   */
+  std::vector<found_leg_t>
+  find_legs(google::protobuf::RepeatedPtrField<Location>& locations,
+            const std::string& costing,
+            const Options& options);
   void route_match(Api& request);
   /**
    * Returns the results of the map match where the first float is the normalized
@@ -88,8 +161,25 @@ protected:
    */
   std::vector<std::tuple<float, float, std::vector<meili::MatchResult>>> map_match(Api& request);
 
+  /**
+   * The matrix between the locations of an optimized route where the pairs of locations an earlier
+   * request had are taken from the cache and only the rows and columns of the others are computed
+   * @param options       the options of the request
+   * @param locations     the correlated locations to order
+   * @param costmatrix    the matrix algorithm to compute the pairs which arent cached with
+   * @param max_distance  the max matrix distance of the costing
+   * @return the time and distance from every location to every location
+   */
+  std::vector<TimeDistance>
+  cached_matrix(const Options& options,
+                const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+                CostMatrix& costmatrix,
+                const float max_distance);
+
   void path_arrive_by(Api& api, const std::string& costing);
-  void path_depart_at(Api& api, const std::string& costing);
+  // legs which were already found, like those of an optimized route, are used instead of searching
+  // for them again, the rest are searched for
+  void path_depart_at(Api& api, const std::string& costing, std::vector<found_leg_t> found = {});
 
   void parse_locations(Api& request);
   void parse_measurements(const Api& request);
@@ -121,12 +211,33 @@ protected:
   MultiModalPathAlgorithm multi_modal_astar;
   TimeDepForward timedep_forward;
   TimeDepReverse timedep_reverse;
+  ContractionQuery contraction_query;
+
+  // The threads independent legs of a route are found on and their path algorithms, the calling
+  // thread uses the ones above
+  std::shared_ptr<MatrixWorkers> route_workers;
+  std::vector<std::unique_ptr<leg_algorithms_t>> leg_algorithms;
+
+  // Matrix algorithms, kept for the life of the worker so their buffers are reused, and the
+  // threads they share to run their searches on
+  std::shared_ptr<MatrixWorkers> matrix_workers;
+  CostMatrix cost_matrix;
+  BucketMatrix bucket_matrix;
+  TimeDistanceMatrix time_distance_matrix;
+  TimeDistanceBSSMatrix time_distance_bss_matrix;
+  MatrixSelector matrix_selector;
 
   Isochrone isochrone_gen;
   std::shared_ptr<meili::MapMatcher> matcher;
   float max_timedep_distance;
+  // Whether time dependent routes use bidirectional A* at any distance
+  bool bidirectional_timedep;
+  uint32_t isochrone_threads;
   std::unordered_map<std::string, float> max_matrix_distance;
   SOURCE_TO_TARGET_ALGORITHM source_to_target_algorithm;
+  OptimizerAlgorithm optimizer_algorithm;
+  uint32_t optimizer_restarts;
+  MatrixCache optimizer_matrix_cache;
   meili::MapMatcherFactory matcher_factory;
   std::shared_ptr<baldr::GraphReader> reader;
   AttributesController controller;
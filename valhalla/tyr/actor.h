@@ -2,8 +2,11 @@
 #define VALHALLA_TYR_ACTOR_H_
 
 #include <boost/property_tree/ptree.hpp>
+#include <exception>
+#include <istream>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include <valhalla/baldr/graphreader.h>
 #include <valhalla/proto/api.pb.h>
@@ -11,6 +14,22 @@
 namespace valhalla {
 namespace tyr {
 
+#ifdef HAVE_HTTP
+// answers the requests of the http server from the loki proxy, running every stage of each request
+// on the same thread rather than handing the request on to the thor and odin proxies
+void run_service(const boost::property_tree::ptree& config);
+#endif
+
+// the outcome of one of the requests of a batch
+struct batch_result_t {
+  // the serialized response, empty if the request failed
+  std::string response;
+  // why the request failed, if it did
+  std::exception_ptr error;
+  // how long the request took from parsing it to serializing its response
+  double milliseconds = 0;
+};
+
 class actor_t {
 public:
   actor_t(const boost::property_tree::ptree& config, bool auto_cleanup = false);
@@ -24,9 +43,20 @@ public:
   std::string locate(const std::string& request_str,
                      const std::function<void()>* interrupt = nullptr,
                      Api* api = nullptr);
+  // locates newline delimited json locations with the options of the request, at most
+  // service_limits.locate.max_locations of them at a time. every location is handed to the writer
+  // as a line of its own as soon as its batch is done so the memory doesnt grow with the input,
+  // a failure can come after some of them were written. returns how many locations there were
+  size_t locate_batch(const std::string& request_str,
+                      std::istream& locations,
+                      const std::function<void(const std::string&)>& write,
+                      const std::function<void()>* interrupt = nullptr);
+  // with a writer the pieces of the json are handed to it as soon as the rows they contain are
+  // known and an empty string is returned, a failure can come after some of them were written
   std::string matrix(const std::string& request_str,
                      const std::function<void()>* interrupt = nullptr,
-                     Api* api = nullptr);
+                     Api* api = nullptr,
+                     const std::function<void(const std::string&)>* write = nullptr);
   std::string optimized_route(const std::string& request_str,
                               const std::function<void()>* interrupt = nullptr,
                               Api* api = nullptr);
@@ -39,12 +69,35 @@ public:
   std::string trace_attributes(const std::string& request_str,
                                const std::function<void()>* interrupt = nullptr,
                                Api* api = nullptr);
+  // matches many trace_route or trace_attributes requests at once, each is taken by the next free
+  // one of thor.trace_threads threads. the extra threads have workers and graph readers of their
+  // own but share the candidate grids of the map matching. returns the json of each request in the
+  // order of the requests, the first failure is rethrown once all of the requests are done
+  std::vector<std::string> trace_batch(const std::vector<std::string>& requests,
+                                       Options::Action action,
+                                       const std::function<void()>* interrupt = nullptr);
+  // answers many requests of any kind at once, each is taken by the next free one of
+  // thor.batch_threads threads with workers of their own. the workers share the graph reader if it
+  // is thread safe and otherwise have their own. the results are in the order of the requests and
+  // a failing request doesnt keep the others from being answered
+  std::vector<batch_result_t> batch(const std::vector<std::string>& requests,
+                                    Options::Action action,
+                                    const std::function<void()>* interrupt = nullptr);
+  // the same for requests which are already Api protobufs with their action set in the options, so
+  // there is no json to parse. each Api is filled out in place the same as the api argument of the
+  // single request methods would be
+  std::vector<batch_result_t> batch(std::vector<Api>& requests,
+                                    const std::function<void()>* interrupt = nullptr);
   std::string height(const std::string& request_str,
                      const std::function<void()>* interrupt = nullptr,
                      Api* api = nullptr);
   std::string transit_available(const std::string& request_str,
                                 const std::function<void()>* interrupt = nullptr,
                                 Api* api = nullptr);
+  // the gzipped mapbox vector tile of the graph for the z, x and y of the request
+  std::string tile(const std::string& request_str,
+                   const std::function<void()>* interrupt = nullptr,
+                   Api* api = nullptr);
   std::string expansion(const std::string& request_str,
                         const std::function<void()>* interrupt = nullptr,
                         Api* api = nullptr);
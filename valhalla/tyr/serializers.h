@@ -17,6 +17,7 @@
 #include <valhalla/proto/api.pb.h>
 #include <valhalla/thor/attributes_controller.h>
 #include <valhalla/thor/costmatrix.h>
+#include <valhalla/thor/matrix_selector.h>
 #include <valhalla/tyr/actor.h>
 
 namespace valhalla {
@@ -28,23 +29,39 @@ namespace tyr {
 std::string serializeDirections(Api& request);
 
 /**
- * Turn a time distance matrix into json that one can look up location pair results from
+ * Turn a time distance matrix into json that one can look up location pair results from, the
+ * valhalla format also says which algorithm made it and how long it was estimated to take
  */
 std::string serializeMatrix(const Api& request,
                             const std::vector<thor::TimeDistance>& time_distances,
-                            double distance_scale);
+                            double distance_scale,
+                            const thor::MatrixEstimate& estimate);
+
+/**
+ * The same json as serializeMatrix in the valhalla format, in pieces so that each row can be
+ * written out as soon as it is known. The head is followed by the rows in order and the tail.
+ */
+std::string serializeMatrixHead(const Api& request);
+std::string serializeMatrixRow(const Api& request,
+                               const thor::TimeDistance* row,
+                               const uint32_t source_index,
+                               double distance_scale);
+std::string serializeMatrixTail(const Api& request, const thor::MatrixEstimate& estimate);
 
 /**
  * Turn grid data contours into geojson
  *
  * @param grid_contours    the contours generated from the grid
  * @param colors           the #ABC123 hex string color used in geojson fill color
+ * @param location_indices the location each contour is the part of with partition, with every
+ *                         location getting the same intervals in turn. empty without partition
  */
 std::string serializeIsochrones(const Api& request,
                                 std::vector<midgard::GriddedData<2>::contour_interval_t>& intervals,
                                 midgard::GriddedData<2>::contours_t& contours,
                                 bool polygons = true,
-                                bool show_locations = false);
+                                bool show_locations = false,
+                                const std::vector<uint32_t>& location_indices = {});
 
 /**
  * Turn heights and ranges into a height response
@@ -71,6 +88,21 @@ serializeLocate(const Api& request,
                 const std::unordered_map<baldr::Location, baldr::PathLocation>& projections,
                 baldr::GraphReader& reader);
 
+/**
+ * Turn one correlated point on the graph into info about that location, the same object as the
+ * one it gets in the array of serializeLocate
+ *
+ * @param request      The original request
+ * @param location     The input location
+ * @param projections  The correlated locations
+ * @param reader       A graph reader to get at the correlated points info
+ */
+std::string
+serializeLocation(const Api& request,
+                  const baldr::Location& location,
+                  const std::unordered_map<baldr::Location, baldr::PathLocation>& projections,
+                  baldr::GraphReader& reader);
+
 /**
  * Turn a list of locations into a list of locations with a bool that says whether transit tiles are
  * near by
@@ -110,6 +142,11 @@ void route_references(baldr::json::MapPtr& route_json,
 
 void openlr(const valhalla::Api& api, int route_index, rapidjson::writer_wrapper_t& writer);
 
+// the statistics the workers collected about the request so far, the ones of the same name are
+// summed up so that a stage which ran more than once shows how long it took in total
+baldr::json::MapPtr statistics(const valhalla::Api& api);
+void statistics(const valhalla::Api& api, rapidjson::writer_wrapper_t& writer);
+
 } // namespace tyr
 } // namespace valhalla
 
@@ -1,9 +1,25 @@
 #ifndef __VALHALLA_SERVICE_H__
 #define __VALHALLA_SERVICE_H__
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <tuple>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+#include <google/protobuf/arena.h>
 
 #include <valhalla/baldr/json.h>
 #include <valhalla/baldr/rapidjson_utils.h>
+#include <valhalla/midgard/aabb2.h>
+#include <valhalla/midgard/logging.h>
+#include <valhalla/midgard/lru_cache.h>
+#include <valhalla/midgard/pointll.h>
 #include <valhalla/midgard/util.h>
 #include <valhalla/proto/api.pb.h>
 #include <valhalla/valhalla.h>
@@ -14,12 +30,19 @@
 #endif
 
 namespace valhalla {
+class IncidentsTile;
+namespace baldr {
+class GraphReader;
+}
 
 const std::unordered_map<unsigned, std::string> error_codes{
     // loki project 1xx
     {100, "Failed to parse json request"},
     {101, "Try a POST or GET request instead"},
     {102, "The service is shutting down"},
+    {103, "Failed to parse pbf request"},
+    {104, "The request took longer than its deadline"},
+    {105, "The service is too busy for this request, try again later"},
     {106, "Try any of"},
     {107, "Not Implemented"},
 
@@ -28,6 +51,7 @@ const std::unordered_map<unsigned, std::string> error_codes{
     {112, "Insufficiently specified required parameter 'locations' or 'sources & targets'"},
     {113, "Insufficiently specified required parameter 'contours'"},
     {114, "Insufficiently specified required parameter 'shape' or 'encoded_polyline'"},
+    {115, "Insufficiently specified required parameter 'tile'"},
 
     {120, "Insufficient number of locations provided"},
     {121, "Insufficient number of sources provided"},
@@ -72,6 +96,7 @@ const std::unordered_map<unsigned, std::string> error_codes{
     {165, "Date and time required for destination for date_type of invariant"},
     {166, "Exceeded max distance"},
     {167, "Exceeded maximum circumference for exclude_polygons"},
+    {168, "Tile zoom is below the minimum zoom tiles are rendered at"},
 
     {170, "Locations are in unconnected regions. Go check/edit the map at osm.org"},
     {171, "No suitable edges near location"},
@@ -169,8 +194,441 @@ inline midgard::scoped_timer<> measure_scope_time(Api& api, const std::string& s
   });
 }
 
+/**
+ * Counts the tiles the reader looks up for as long as the returned object lives and adds how many
+ * it looked up and how many of those it had to load to the statistics of the request. The counts
+ * are those of the calling thread if the reader is thread safe
+ * @param reader  the reader whose tiles to count
+ * @param prefix  what to put in front of the name of each statistic
+ * @param api     the request to add the statistics to
+ */
+midgard::scoped_timer<>
+measure_scope_tiles(const baldr::GraphReader& reader, const std::string& prefix, Api& api);
+
+/**
+ * Adds where the tiles of the reader came from, how long loading them took and how many were
+ * evicted from its cache to the statistics of the request
+ * @param reader  the reader whose tiles to report on
+ * @param prefix  what to put in front of the name of each statistic
+ * @param api     the request to add the statistics to
+ */
+void tile_statistics(const baldr::GraphReader& reader, const std::string& prefix, Api& api);
+
+/**
+ * The graph reader every worker of the process shares when mjolnir.thread_safe_reader is on, so
+ * that the tiles are only kept in memory once no matter how many worker threads there are. Threads
+ * pinned to a NUMA node share a reader of the node instead, see pin_to_numa_node
+ * @param config  the config of the service
+ * @return the one reader of the process or nullptr if the workers are to make their own
+ */
+std::shared_ptr<baldr::GraphReader> shared_graph_reader(const boost::property_tree::ptree& config);
+
+/**
+ * The NUMA nodes of the machine along with the cpus of each, from /sys/devices/system/node
+ * @return the cpus of each node, empty where the nodes cant be found out
+ */
+std::vector<std::vector<int>> numa_nodes();
+
+/**
+ * Pins the calling thread to the cpus of a NUMA node, so that the memory it touches first comes
+ * from that node. The workers it makes afterwards get the shared graph reader of the node, which
+ * keeps its cached tiles in the memory of the node
+ * @param node  the index of the node in numa_nodes
+ * @return whether the thread was pinned, only ever on linux
+ */
+bool pin_to_numa_node(size_t node);
+
+/**
+ * Replaces the shared graph reader with a new one, for a new tile extract or traffic extract say,
+ * without restarting the service. The new reader is made and warmed with the tiles of the
+ * mjolnir.tile_warm_file while the old one keeps answering requests, and only then is it handed out
+ * by shared_graph_reader. The old reader is freed once the last worker has let go of it, see
+ * reloading_worker_t. The readers of the NUMA nodes are each made again on a thread of their node
+ * @param config  the config to make the new reader from
+ * @return whether there was a shared reader to replace, false without mjolnir.thread_safe_reader
+ */
+bool reload_shared_graph_reader(const boost::property_tree::ptree& config);
+
+/**
+ * @return how many times the shared graph reader has been replaced by reload_shared_graph_reader
+ */
+uint64_t shared_graph_reader_generation();
+
+/**
+ * The worker of a service thread, made again between requests once the shared graph reader has
+ * been reloaded since it was made. Whatever the worker derived from the tiles is made again along
+ * with it, and dropping the old worker lets go of the old reader
+ */
+template <typename worker_t> class reloading_worker_t {
+public:
+  /**
+   * @param make  makes a worker with the current shared graph reader
+   */
+  explicit reloading_worker_t(const std::function<worker_t*()>& make)
+      : make_(make), generation_(shared_graph_reader_generation()), worker_(make_()) {
+  }
+
+  /**
+   * @return the worker to answer the next request with, made again if the reader was reloaded. If
+   *         the new worker cant be made the old one keeps answering and it is tried again later
+   */
+  worker_t& latest() {
+    const auto generation = shared_graph_reader_generation();
+    if (generation != generation_) {
+      try {
+        std::unique_ptr<worker_t> worker(make_());
+        worker_ = std::move(worker);
+        generation_ = generation;
+      } catch (const std::exception& e) {
+        LOG_ERROR(std::string("Failed to make the worker for the reloaded graph reader: ") +
+                  e.what());
+      }
+    }
+    return *worker_;
+  }
+
+  /**
+   * @return the worker that answered the last request, to clean up after it
+   */
+  worker_t& current() {
+    return *worker_;
+  }
+
+private:
+  std::function<worker_t*()> make_;
+  uint64_t generation_;
+  std::unique_ptr<worker_t> worker_;
+};
+
+/**
+ * Limits how many requests of each action a stage of the service works on at once so that a few
+ * expensive requests cant take up every worker thread of the process. A request over its limits
+ * waits for a slot, the waiting requests of the highest priority action getting the next free one,
+ * and is turned away once the queue of its action is full or it waited for too long. Note that a
+ * waiting request keeps its worker thread so the waits should be short. The limits come from the
+ * service_limits.admission config and are shared by all the workers of the stage in the process.
+ */
+class admission_t {
+public:
+  /**
+   * Holds the slot of an admitted request and gives it back when it goes out of scope
+   */
+  class ticket_t {
+  public:
+    ticket_t() : admission(nullptr) {
+    }
+    ticket_t(ticket_t&& other) : admission(other.admission), action(other.action) {
+      other.admission = nullptr;
+    }
+    ticket_t(const ticket_t&) = delete;
+    ticket_t& operator=(const ticket_t&) = delete;
+    ~ticket_t();
+
+  protected:
+    friend class admission_t;
+    ticket_t(admission_t* admission, Options::Action action)
+        : admission(admission), action(action) {
+    }
+    admission_t* admission;
+    Options::Action action;
+  };
+
+  /**
+   * @param  config  the service_limits.admission config
+   */
+  explicit admission_t(const boost::property_tree::ptree& config);
+
+  /**
+   * Waits until the action of the request may be worked on and adds how long that took to the
+   * statistics of the request. A request which cant be admitted is thrown out with error 105, or
+   * 104 if it ran out of time before its deadline
+   * @param  request  the request to admit
+   * @param  prefix   what to put in front of the name of the wait statistic
+   * @return the ticket holding the slot of the request until it is done
+   */
+  ticket_t admit(Api& request, const std::string& prefix);
+
+  /**
+   * Adds how many requests of each action are running and waiting, how many were admitted and
+   * turned away and how long they waited to the statistics of the request
+   * @param  prefix  what to put in front of the name of each statistic
+   * @param  api     the request to add the statistics to
+   */
+  void statistics(const std::string& prefix, Api& api) const;
+
+  /**
+   * The admission of a stage that every worker of the stage in the process shares
+   * @param  config  the config of the service
+   * @param  stage   the name of the stage the workers are in
+   * @return the admission of the stage or nullptr if no limits are configured
+   */
+  static std::shared_ptr<admission_t> shared(const boost::property_tree::ptree& config,
+                                             const std::string& stage);
+
+protected:
+  struct action_t {
+    size_t max_concurrent = 0; // 0 for no limit
+    size_t max_queued = 0;     // 0 for no limit
+    int priority = 0;          // higher goes first
+    // what happened so far
+    size_t running = 0;
+    size_t waiting = 0;
+    uint64_t admitted = 0;
+    uint64_t rejected = 0;
+    double wait_total = 0;
+    double wait_max = 0;
+  };
+  // a request waiting for a slot, ordered by the priority of its action then by arrival
+  struct waiter_t {
+    int priority;
+    uint64_t order;
+    Options::Action action;
+    bool operator<(const waiter_t& other) const {
+      return priority != other.priority ? priority > other.priority : order < other.order;
+    }
+  };
+
+  // whether a request of the action fits in the limits right now
+  bool fits(const action_t& action) const;
+  // gives back the slot of a finished request
+  void release(Options::Action action);
+
+  size_t max_concurrent; // 0 for no limit
+  uint32_t max_wait;     // milliseconds
+  std::vector<action_t> actions;
+  size_t running;
+  uint64_t arrivals;
+  std::set<waiter_t> waiters;
+  mutable std::mutex lock;
+  std::condition_variable freed;
+};
+
+/**
+ * Remembers the serialized responses of route and matrix requests so that the same request asked
+ * again is answered without working it out again. Requests are the same if their options are once
+ * the coordinates are rounded to the cache precision and the options of the costings they dont use
+ * are left out. A response is only handed back for as long as its ttl and while the traffic and
+ * incident tiles of the graph tiles it depends on are the ones it was made with. For routes those
+ * are the tiles of the edges of the route, for matrices only the tiles of the locations so their
+ * traffic further away only ages out with the ttl. The cache is shared by all the workers of the
+ * process, so it only helps when the stage which looks requests up and the one which makes their
+ * responses run in the same process.
+ */
+class response_cache_t {
+public:
+  /**
+   * @param  capacity   how many responses to remember
+   * @param  ttl        how many seconds a response is good for, 0 to keep it until it is evicted
+   * @param  precision  how many decimals of the coordinates the requests are told apart by
+   */
+  response_cache_t(size_t capacity, uint32_t ttl, uint32_t precision);
+
+  /**
+   * The key the response of the request is cached under, taken from its options as they were
+   * parsed before any stage worked on them
+   * @param  request  the request to get the key of
+   * @return the key or empty if responses of requests like it are not cached
+   */
+  std::string key(const Api& request) const;
+
+  /**
+   * Looks for the response of the request. If it is not cached the key of the request goes into
+   * its info so that the stage making the response can cache it
+   * @param  request   the freshly parsed request
+   * @param  reader    the reader to check the traffic and incidents of the tiles with
+   * @param  response  set to the cached response if there is one
+   * @return true if the response was cached
+   */
+  bool find(Api& request, baldr::GraphReader& reader, std::string& response);
+
+  /**
+   * Adds the tiles the response of the request depends on, along with the state of their traffic
+   * and incidents, to the info of the request. Only requests which got a key from find are tagged
+   * @param  request  the request whose path or locations were found
+   * @param  reader   the reader the request was worked out with
+   */
+  static void tag(Api& request, baldr::GraphReader& reader);
+
+  /**
+   * Remembers the response of the request under the key and with the tags in its info, if it has
+   * a key
+   * @param  request   the request the response is for
+   * @param  response  the serialized response
+   */
+  void insert(const Api& request, const std::string& response);
+
+  /**
+   * The cache every worker of the process which works on the tiles of the config shares
+   * @param  config  the config of the service
+   * @return the cache or nullptr if httpd.service.response_cache_size is 0
+   */
+  static std::shared_ptr<response_cache_t> shared(const boost::property_tree::ptree& config);
+
+  /**
+   * Which incident tile a graph tile has, a new one gets another generation even when it happens
+   * to be allocated where an old one was
+   * @param  tile       the graph tile the incidents are for
+   * @param  incidents  the incident tile it has now
+   * @return the generation of the incident tile, 0 without one
+   */
+  static uint64_t incidents_generation(uint64_t tile,
+                                       const std::shared_ptr<const IncidentsTile>& incidents);
+
+protected:
+  struct entry_t {
+    std::string response;
+    std::chrono::steady_clock::time_point cached;
+    uint64_t reader_generation;
+    std::vector<std::tuple<uint64_t, uint32_t, uint64_t>> tags;
+  };
+
+  // the state of the traffic and incidents of a graph tile
+  static std::tuple<uint64_t, uint32_t, uint64_t> stamp(baldr::GraphReader& reader, uint64_t tile);
+
+  uint32_t ttl;
+  double scale;
+  std::mutex lock;
+  midgard::lru_cache_t<std::string, std::shared_ptr<const entry_t>> entries;
+};
+
+/**
+ * Decides which nodes of a cluster a request goes to when the nodes only have the tiles of a region
+ * rather than those of the whole planet. The regions come from httpd.service.regions, each with a
+ * name, the url of its nodes and the bounding box its requests have to be in, which should leave
+ * some room to the edge of its tiles for the paths to go around. A request stays on this node if
+ * the region of the node, httpd.service.region, covers all of its locations. Otherwise it goes to
+ * the smallest region which does and if none does to httpd.service.planet_url. A node without a
+ * planet url has the planet and answers those itself, so it can also be the one every request
+ * comes to first.
+ */
+class region_router_t {
+public:
+  struct region_t {
+    std::string name;
+    std::string url;
+    midgard::AABB2<midgard::PointLL> bbox;
+  };
+
+  /**
+   * @param  config  the httpd.service config
+   */
+  explicit region_router_t(const boost::property_tree::ptree& config);
+  region_router_t(const region_router_t&) = delete;
+  region_router_t& operator=(const region_router_t&) = delete;
+
+  /**
+   * Finds where the request should be answered from its locations, sources, targets and shape
+   * @param  options  the options of the parsed request
+   * @return the url of the nodes to send the request to or nullptr to answer it here
+   */
+  const std::string* route(const Options& options) const;
+
+  /**
+   * The region of this node
+   * @return the name of the region or empty if the node has the planet
+   */
+  const std::string& region() const {
+    return own_region;
+  }
+
+  /**
+   * Makes the router of the service if it is configured with regions
+   * @param  config  the config of the service
+   * @return the router or nullptr if there are no regions
+   */
+  static std::shared_ptr<region_router_t> make(const boost::property_tree::ptree& config);
+
+protected:
+  // smallest first so a request goes to the one closest to its size
+  std::vector<region_t> regions;
+  std::string own_region;
+  const region_t* own;
+  std::string planet_url;
+};
+
+/**
+ * Compresses the responses of the service so that big ones, matrices and isochrones mostly, dont
+ * have to rely on a proxy in front of the service for it. The codecs come from
+ * httpd.service.compression_codecs in the order they are preferred in. gzip and deflate are always
+ * there, zstd and br when the service was built with them and others can be added with add_codec
+ * before the workers start. The first stage picks the codec the client accepts the most from the
+ * Accept-Encoding header of the request and keeps it, its level and how big a response has to be
+ * for it to pay off in the info of the request, so the stage which makes the response compresses it.
+ */
+class response_compressor_t {
+public:
+  // compresses all of the data at the level into compressed, false if it could not
+  using codec_t = std::function<bool(const std::string& data, int level, std::string& compressed)>;
+
+  /**
+   * @param  config  the httpd.service config
+   */
+  explicit response_compressor_t(const boost::property_tree::ptree& config);
+
+  /**
+   * Picks the codec for the response of the request and puts it into its info. The codec with the
+   * highest quality value in the header wins and ties go to the one configured first. Without any
+   * codec the client accepts the response is not compressed
+   * @param  accept_encoding  the value of the Accept-Encoding header of the request
+   * @param  request          the request to pick the codec for
+   */
+  void negotiate(const std::string& accept_encoding, Api& request) const;
+#ifdef HAVE_HTTP
+  /**
+   * Picks the codec for the response of the request from its Accept-Encoding header, if it has one
+   * @param  http_request  the http request
+   * @param  request       the request parsed from it
+   */
+  void negotiate(const prime_server::http_request_t& http_request, Api& request) const;
+#endif
+
+  /**
+   * Compresses the response of the request if it was given a codec and is big enough for it
+   * @param  request     the request the response is for
+   * @param  response    the serialized response
+   * @param  compressed  set to the compressed response if it was compressed
+   * @return whether the response was compressed
+   */
+  static bool compress(const Api& request, const std::string& response, std::string& compressed);
+
+  /**
+   * Compresses data with a codec
+   * @param  codec       the name of the codec as it is in the Content-Encoding header
+   * @param  level       the level to compress at
+   * @param  data        the data to compress
+   * @param  compressed  set to the compressed data
+   * @return whether there is such a codec and it compressed the data
+   */
+  static bool
+  compress(const std::string& codec, int level, const std::string& data, std::string& compressed);
+
+  /**
+   * Adds a codec or replaces the one with the name. Not thread safe, the codecs should all be
+   * added before any request is worked on
+   * @param  name           the name of the codec as it is in the Accept-Encoding header
+   * @param  codec          the function compressing with it
+   * @param  default_level  the level to use when the config does not have one for the codec
+   */
+  static void add_codec(const std::string& name, codec_t codec, int default_level);
+
+  /**
+   * Makes the compressor of the service if it is configured with any codecs
+   * @param  config  the config of the service
+   * @return the compressor or nullptr if there are no codecs
+   */
+  static std::shared_ptr<response_compressor_t> make(const boost::property_tree::ptree& config);
+
+protected:
+  // the names and levels of the codecs in the order they are preferred in
+  std::vector<std::pair<std::string, int>> codecs;
+  uint32_t min_size;
+};
+
 // TODO: this will go away and Options will be the request object
 void ParseApi(const std::string& json_request, Options::Action action, Api& api);
+// readies a request which was built as an Api protobuf rather than json, only the options of it
+// are kept and they get the same defaults and checks as parsed json would
+void ParseApi(Api& api);
 #ifdef HAVE_HTTP
 void ParseApi(const prime_server::http_request_t& http_request, Api& api);
 #endif
@@ -186,6 +644,9 @@ const content_type JSON_MIME{"Content-type", "application/json;charset=utf-8"};
 const content_type JS_MIME{"Content-type", "application/javascript;charset=utf-8"};
 const content_type XML_MIME{"Content-type", "text/xml;charset=utf-8"};
 const content_type GPX_MIME{"Content-type", "application/gpx+xml;charset=utf-8"};
+const content_type BINARY_MIME{"Content-type", "application/octet-stream"};
+const content_type PBF_MIME{"Content-type", "application/x-protobuf"};
+const content_type MVT_MIME{"Content-type", "application/vnd.mapbox-vector-tile"};
 } // namespace worker
 
 prime_server::worker_t::result_t
@@ -193,7 +654,20 @@ to_response(const std::string& data,
             prime_server::http_request_info_t& request_info,
             const Api& options,
             const worker::content_type& content_type = worker::JSON_MIME,
-            const bool as_attachment = false);
+            const bool as_attachment = false,
+            const bool gzipped = false);
+
+/**
+ * Sends the client to the same path and query on other nodes with a 307, so that it asks them
+ * again with the same method and body
+ * @param  url           the url of the nodes, without a trailing slash
+ * @param  http_request  the request to send elsewhere
+ * @param  request_info  the info of the request
+ * @return the redirect
+ */
+prime_server::worker_t::result_t to_redirect(const std::string& url,
+                                             const prime_server::http_request_t& http_request,
+                                             prime_server::http_request_info_t& request_info);
 #endif
 
 class service_worker_t {
@@ -233,8 +707,48 @@ public:
    */
   virtual void set_interrupt(const std::function<void()>* interrupt);
 
+  /**
+   * Sets the interrupt for the request so that it also throws once the deadline of the request has
+   * passed, right away if it already has. The first stage to see the request gives it its deadline
+   * from the timeout it asked for, capped at the request_timeout of the service. Without either
+   * the interrupt is set as is
+   * @param  request      the request the interrupt is for
+   * @param  interrupt    the function to be called which should throw
+   */
+  void set_deadline_interrupt(Api& request, const std::function<void()>* interrupt);
+
+  /**
+   * Waits for a slot for the request if the workers of the stage are limited in how many requests
+   * of its action they work on at once, see admission_t::admit
+   * @param  request  the request to admit
+   * @param  prefix   what to put in front of the name of the wait statistic
+   * @return the ticket holding the slot of the request until it is done
+   */
+  admission_t::ticket_t admit(Api& request, const std::string& prefix);
+
+  /**
+   * Makes the request to work on next in the arena of the worker, after freeing the previous one
+   * along with all of its messages at once. The arena starts with a block as big as the previous
+   * request needed, up to a limit, so that requests of a similar size dont go to the allocator
+   * @return the empty request, valid until the next call
+   */
+  Api& arena_request();
+
 protected:
   const std::function<void()>* interrupt;
+  // what limits the requests of each action the workers of the stage work on, if anything
+  std::shared_ptr<admission_t> admission;
+  // where the responses of the requests are remembered, if anywhere
+  std::shared_ptr<response_cache_t> response_cache;
+  // the milliseconds a request may take at most, 0 for no limit
+  uint32_t request_timeout;
+  // the interrupt of the current request when it has a deadline
+  std::function<void()> deadline_interrupt;
+  // the first block of the arena of the current request, declared first so it outlives the arena
+  std::unique_ptr<char[]> arena_block;
+  size_t arena_block_size;
+  // the memory of the current request and of every message hanging off of it
+  std::unique_ptr<google::protobuf::Arena> arena;
 };
 } // namespace valhalla
 